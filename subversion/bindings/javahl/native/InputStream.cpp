@@ -26,15 +26,21 @@
 
 #include "InputStream.h"
 #include "JNIUtil.h"
-#include "JNIByteArray.h"
 
 /**
  * Create an InputStream object.
  * @param jthis the Java object to be stored
  */
 InputStream::InputStream(jobject jthis)
+  : m_jthis(jthis), m_is_channel(false)
 {
-  m_jthis = jthis;
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass("java/nio/channels/ReadableByteChannel");
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_is_channel = (jthis != NULL && env->IsInstanceOf(jthis, clazz));
+  env->DeleteLocalRef(clazz);
 }
 
 InputStream::~InputStream()
@@ -76,6 +82,9 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
   // An object of our class is passed in as the baton.
   InputStream *that = static_cast<InputStream *>(baton);
 
+  if (that->m_is_channel)
+    return readChannel(that, buffer, len);
+
   // The method id will not change during the time this library is
   // loaded, so it can be cached.
   static jmethodID mid = 0;
@@ -93,7 +102,7 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
     }
 
   // Allocate a Java byte array to read the data.
-  jbyteArray data = JNIUtil::makeJByteArray(buffer, static_cast<int>(*len));
+  jbyteArray data = env->NewByteArray(static_cast<jsize>(*len));
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
@@ -110,12 +119,6 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
       jread = 0;
     }
 
-  // Put the Java byte array into a helper object to retrieve the
-  // data bytes.
-  JNIByteArray outdata(data, true);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
-
   // Catch when the Java method tells us it read too much data.
   if (jread > (jint) *len)
     jread = 0;
@@ -123,7 +126,10 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
   // In the case of success copy the data back to the Subversion
   // buffer.
   if (jread > 0)
-    memcpy(buffer, outdata.getBytes(), jread);
+    env->GetByteArrayRegion(data, 0, jread, reinterpret_cast<jbyte *>(buffer));
+  env->DeleteLocalRef(data);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
 
   // Copy the number of read bytes back to Subversion.
   *len = jread;
@@ -131,6 +137,49 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+/**
+ * Like read(), but let the ReadableByteChannel write directly into
+ * BUFFER through a direct ByteBuffer instead of copying a byte array.
+ */
+svn_error_t *InputStream::readChannel(InputStream *that, char *buffer,
+                                      apr_size_t *len)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz = env->FindClass("java/nio/channels/ReadableByteChannel");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      mid = env->GetMethodID(clazz, "read", "(Ljava/nio/ByteBuffer;)I");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return SVN_NO_ERROR;
+
+      env->DeleteLocalRef(clazz);
+    }
+
+  jobject data = env->NewDirectByteBuffer(buffer, jlong(*len));
+  if (JNIUtil::isJavaExceptionThrown() || data == NULL)
+    return SVN_NO_ERROR;
+
+  jint jread = env->CallIntMethod(that->m_jthis, mid, data);
+  env->DeleteLocalRef(data);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  // -1 means EOF, just like 0 for Subversion.
+  if (jread < 0 || jread > (jint) *len)
+    jread = 0;
+
+  *len = jread;
+
+  return SVN_NO_ERROR;
+}
+
 /**
  * Implements svn_close_fn_t to close the input stream.
  * @param baton     an InputStream object for the callback
@@ -42,7 +42,14 @@ class InputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+  /**
+   * Whether m_jthis is a java.nio.channels.ReadableByteChannel, which
+   * lets us read directly into Subversion's buffer.
+   */
+  bool m_is_channel;
   static svn_error_t *read(void *baton, char *buffer, apr_size_t *len);
+  static svn_error_t *readChannel(InputStream *that, char *buffer,
+                                  apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
   InputStream(jobject jthis);
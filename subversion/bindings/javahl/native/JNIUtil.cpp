@@ -976,16 +976,9 @@ jbyteArray JNIUtil::makeJByteArray(const void *data, int length)
   if (isJavaExceptionThrown() || ret == NULL)
       return NULL;
 
-  // Access the bytes.
-  jbyte *retdata = env->GetByteArrayElements(ret, NULL);
-  if (isJavaExceptionThrown())
-    return NULL;
-
-  // Copy the bytes.
-  memcpy(retdata, data, length);
-
-  // Release the bytes.
-  env->ReleaseByteArrayElements(ret, retdata, 0);
+  // Copy the bytes without pinning or copying the array's elements.
+  env->SetByteArrayRegion(ret, 0, length,
+                          static_cast<const jbyte *>(data));
   if (isJavaExceptionThrown())
     return NULL;
 
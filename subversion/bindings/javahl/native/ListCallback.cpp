@@ -30,13 +30,26 @@
 #include "JNIUtil.h"
 #include "svn_time.h"
 
+/* Maximum number of entries passed to ListItemBatchCallback.doEntries. */
+#define LIST_BATCH_SIZE 256
+
 /**
  * Create a ListCallback object
  * @param jcallback the Java callback object.
  */
 ListCallback::ListCallback(jobject jcallback)
+  : m_callback(jcallback), m_batched(false),
+    m_dirents(NULL), m_locks(NULL),
+    m_external_parent_urls(NULL), m_external_targets(NULL),
+    m_count(0)
 {
-  m_callback = jcallback;
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/ListItemBatchCallback"));
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batched = (jcallback != NULL && env->IsInstanceOf(jcallback, clazz));
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -46,6 +59,128 @@ ListCallback::~ListCallback()
 {
   // The m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.list method.
+  releaseBatch(JNIUtil::getEnv());
+}
+
+/**
+ * Release the global references to the current batch.
+ */
+void
+ListCallback::releaseBatch(JNIEnv *env)
+{
+  jobjectArray *arrays[] = { &m_dirents, &m_locks,
+                             &m_external_parent_urls, &m_external_targets };
+
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+    if (*arrays[i])
+      {
+        env->DeleteGlobalRef(*arrays[i]);
+        *arrays[i] = NULL;
+      }
+
+  m_count = 0;
+}
+
+/**
+ * Append an entry to the current batch, starting a new one if necessary.
+ * Called from within doList's local frame.
+ */
+svn_error_t *
+ListCallback::addToBatch(JNIEnv *env, jobject jdirentry, jobject jlock,
+                         jstring jexternalParentURL, jstring jexternalTarget)
+{
+  if (m_dirents == NULL)
+    {
+      static const char *const classes[] = {
+        JAVAHL_CLASS("/types/DirEntry"),
+        JAVAHL_CLASS("/types/Lock"),
+        "java/lang/String",
+        "java/lang/String"
+      };
+      jobjectArray *arrays[] = { &m_dirents, &m_locks,
+                                 &m_external_parent_urls,
+                                 &m_external_targets };
+
+      for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+        {
+          jclass clazz = env->FindClass(classes[i]);
+          if (JNIUtil::isJavaExceptionThrown())
+            return SVN_NO_ERROR;
+
+          jobjectArray array = env->NewObjectArray(LIST_BATCH_SIZE, clazz,
+                                                   NULL);
+          if (JNIUtil::isJavaExceptionThrown())
+            return SVN_NO_ERROR;
+
+          *arrays[i] = static_cast<jobjectArray>(env->NewGlobalRef(array));
+          if (JNIUtil::isJavaExceptionThrown())
+            return SVN_NO_ERROR;
+        }
+    }
+
+  // The arrays keep the objects alive beyond our local frame.
+  env->SetObjectArrayElement(m_dirents, m_count, jdirentry);
+  env->SetObjectArrayElement(m_locks, m_count, jlock);
+  env->SetObjectArrayElement(m_external_parent_urls, m_count,
+                             jexternalParentURL);
+  env->SetObjectArrayElement(m_external_targets, m_count, jexternalTarget);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  if (++m_count == LIST_BATCH_SIZE)
+    return flush();
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+ListCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/ListItemBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        return JNIUtil::wrapJavaException();
+
+      mid = env->GetMethodID(clazz, "doEntries",
+                             "("
+                             "[" JAVAHL_ARG("/types/DirEntry;")
+                             "[" JAVAHL_ARG("/types/Lock;")
+                             "[Ljava/lang/String;"
+                             "[Ljava/lang/String;"
+                             "I)V");
+      env->DeleteLocalRef(clazz);
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return JNIUtil::wrapJavaException();
+    }
+
+  // Hand the arrays over to Java; the next entry starts a new batch.
+  jobjectArray jdirents = m_dirents;
+  jobjectArray jlocks = m_locks;
+  jobjectArray jexternalParentURLs = m_external_parent_urls;
+  jobjectArray jexternalTargets = m_external_targets;
+  const int count = m_count;
+  m_dirents = m_locks = m_external_parent_urls = m_external_targets = NULL;
+  m_count = 0;
+
+  env->CallVoidMethod(m_callback, mid, jdirents, jlocks,
+                      jexternalParentURLs, jexternalTargets, jint(count));
+
+  env->DeleteGlobalRef(jdirents);
+  env->DeleteGlobalRef(jlocks);
+  env->DeleteGlobalRef(jexternalParentURLs);
+  env->DeleteGlobalRef(jexternalTargets);
+
+  return JNIUtil::wrapJavaException();
 }
 
 svn_error_t *
@@ -127,6 +262,18 @@ ListCallback::doList(const char *path,
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN(SVN_NO_ERROR);
 
+  if (m_batched)
+    {
+      svn_error_t *err = addToBatch(env, jdirentry, jlock,
+                                    jexternalParentURL, jexternalTarget);
+      if (err)
+        {
+          env->PopLocalFrame(NULL);
+          return err;
+        }
+      POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+    }
+
   // call the Java method
   env->CallVoidMethod(m_callback, mid, jdirentry, jlock, jexternalParentURL, jexternalTarget);
 
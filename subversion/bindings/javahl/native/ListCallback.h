@@ -49,6 +49,12 @@ public:
                                const char *external_target,
                                apr_pool_t *scratch_pool);
 
+  /**
+   * Deliver the entries still batched up for a ListItemBatchCallback.
+   * Must be called after the listing completed successfully.
+   */
+  svn_error_t *flush();
+
 protected:
   svn_error_t *doList(const char *path,
                       const svn_dirent_t *dirent,
@@ -64,6 +70,25 @@ private:
    */
   jobject m_callback;
 
+  /**
+   * Whether m_callback is a ListItemBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * The entries not delivered yet, as global references, and their number.
+   */
+  jobjectArray m_dirents;
+  jobjectArray m_locks;
+  jobjectArray m_external_parent_urls;
+  jobjectArray m_external_targets;
+  int m_count;
+
+  svn_error_t *addToBatch(JNIEnv *env, jobject jdirentry, jobject jlock,
+                          jstring jexternalParentURL,
+                          jstring jexternalTarget);
+  void releaseBatch(JNIEnv *env);
+
   jobject createJavaDirEntry(const char *path,
                              const char *absPath,
                              const svn_dirent_t *dirent);
@@ -32,13 +32,25 @@
 #include "svn_sorts.h"
 #include "svn_compat.h"
 
+/* Maximum number of messages passed to LogMessageBatchCallback.messages. */
+#define LOG_BATCH_SIZE 128
+
 /**
  * Create a LogMessageCallback object
  * @param jcallback the Java callback object.
  */
 LogMessageCallback::LogMessageCallback(jobject jcallback)
+  : m_callback(jcallback), m_batched(false),
+    m_changed_paths(NULL), m_revprops(NULL)
 {
-  m_callback = jcallback;
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz =
+    env->FindClass(JAVAHL_CLASS("/callback/LogMessageBatchCallback"));
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batched = (jcallback != NULL && env->IsInstanceOf(jcallback, clazz));
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -49,6 +61,124 @@ LogMessageCallback::~LogMessageCallback()
   // The m_callback does not need to be destroyed because it is the
   // passed in parameter to the Java SVNClientInterface.logMessages
   // method.
+  releaseBatch(JNIUtil::getEnv());
+}
+
+/**
+ * Release the global references to the current batch.
+ */
+void
+LogMessageCallback::releaseBatch(JNIEnv *env)
+{
+  if (m_changed_paths)
+    env->DeleteGlobalRef(m_changed_paths);
+  if (m_revprops)
+    env->DeleteGlobalRef(m_revprops);
+
+  m_changed_paths = NULL;
+  m_revprops = NULL;
+  m_revisions.clear();
+  m_has_children.clear();
+}
+
+/**
+ * Append a message to the current batch, starting a new one if necessary.
+ * Called from within singleMessage's local frame.
+ */
+svn_error_t *
+LogMessageCallback::addToBatch(JNIEnv *env, jobject jChangedPaths,
+                               svn_revnum_t revision, jobject jrevprops,
+                               svn_boolean_t has_children)
+{
+  if (m_changed_paths == NULL)
+    {
+      jclass clazz = env->FindClass("java/util/Set");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+      jobjectArray array = env->NewObjectArray(LOG_BATCH_SIZE, clazz, NULL);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+      m_changed_paths = static_cast<jobjectArray>(env->NewGlobalRef(array));
+
+      clazz = env->FindClass("java/util/Map");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+      array = env->NewObjectArray(LOG_BATCH_SIZE, clazz, NULL);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+      m_revprops = static_cast<jobjectArray>(env->NewGlobalRef(array));
+
+      m_revisions.reserve(LOG_BATCH_SIZE);
+      m_has_children.reserve(LOG_BATCH_SIZE);
+    }
+
+  // The arrays keep the objects alive beyond our local frame.
+  const jsize index = jsize(m_revisions.size());
+  env->SetObjectArrayElement(m_changed_paths, index, jChangedPaths);
+  env->SetObjectArrayElement(m_revprops, index, jrevprops);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  m_revisions.push_back(jlong(revision));
+  m_has_children.push_back(jboolean(has_children));
+
+  if (m_revisions.size() == LOG_BATCH_SIZE)
+    return flush();
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+LogMessageCallback::flush()
+{
+  if (m_revisions.empty())
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return JNIUtil::wrapJavaException();
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/LogMessageBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+
+      mid = env->GetMethodID(clazz, "messages",
+                             "([Ljava/util/Set;[J[Ljava/util/Map;[ZI)V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+    }
+
+  const jsize count = jsize(m_revisions.size());
+  jlongArray jrevisions = env->NewLongArray(count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+  env->SetLongArrayRegion(jrevisions, 0, count, &m_revisions[0]);
+
+  jbooleanArray jhasChildren = env->NewBooleanArray(count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+  env->SetBooleanArrayRegion(jhasChildren, 0, count, &m_has_children[0]);
+
+  // Hand the arrays over to Java; the next message starts a new batch.
+  jobjectArray jchangedPaths =
+    static_cast<jobjectArray>(env->NewLocalRef(m_changed_paths));
+  jobjectArray jrevprops =
+    static_cast<jobjectArray>(env->NewLocalRef(m_revprops));
+  releaseBatch(env);
+
+  env->CallVoidMethod(m_callback, mid, jchangedPaths, jrevisions,
+                      jrevprops, jhasChildren, jint(count));
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
 svn_error_t *
@@ -119,6 +249,18 @@ LogMessageCallback::singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool)
   if (log_entry->revprops != NULL && apr_hash_count(log_entry->revprops) > 0)
     jrevprops = CreateJ::PropertyMap(log_entry->revprops, pool);
 
+  if (m_batched)
+    {
+      svn_error_t *err = addToBatch(env, jChangedPaths, log_entry->revision,
+                                    jrevprops, log_entry->has_children);
+      if (err)
+        {
+          env->PopLocalFrame(NULL);
+          return err;
+        }
+      POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+    }
+
   env->CallVoidMethod(m_callback,
                       sm_mid,
                       jChangedPaths,
@@ -28,6 +28,7 @@
 #define LOGMESSAGECALLBACK_H
 
 #include <jni.h>
+#include <vector>
 #include "svn_client.h"
 
 /**
@@ -43,6 +44,12 @@ class LogMessageCallback
   static svn_error_t *callback(void *baton,
                                svn_log_entry_t *log_entry,
                                apr_pool_t *pool);
+
+  /**
+   * Deliver the messages still batched up for a LogMessageBatchCallback.
+   * Must be called after the log has been received successfully.
+   */
+  svn_error_t *flush();
  protected:
   svn_error_t *singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool);
 
@@ -51,6 +58,24 @@ class LogMessageCallback
    * This a local reference to the Java object.
    */
   jobject m_callback;
+
+  /**
+   * Whether m_callback is a LogMessageBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * The messages not delivered yet.  The arrays are global references.
+   */
+  jobjectArray m_changed_paths;
+  jobjectArray m_revprops;
+  std::vector<jlong> m_revisions;
+  std::vector<jboolean> m_has_children;
+
+  svn_error_t *addToBatch(JNIEnv *env, jobject jChangedPaths,
+                          svn_revnum_t revision, jobject jrevprops,
+                          svn_boolean_t has_children);
+  void releaseBatch(JNIEnv *env);
 };
 
 #endif  // LOGMESSAGECALLBACK_H
@@ -112,13 +112,30 @@ jint NativeInputStream::read(::Java::Env env,
   if (!dst.data())
     ::Java::NullPointerException(env).raise();
 
+  return read(env, dst.data() + offset, length);
+}
+
+jint NativeInputStream::read_direct(::Java::Env env, jobject jdst,
+                                    jint offset, jint length)
+{
+  char* const data = static_cast<char*>(env.get()->GetDirectBufferAddress(jdst));
+  if (!data)
+    ::Java::NullPointerException(env).raise();
+
+  const jlong capacity = env.get()->GetDirectBufferCapacity(jdst);
+  if (offset < 0 || length < 0 || jlong(offset) + length > capacity)
+    ::Java::IndexOutOfBoundsException(env).raise();
+
+  return read(env, data + offset, length);
+}
+
+jint NativeInputStream::read(::Java::Env env, char* data, jint length)
+{
   apr_size_t len = length;
   if (svn_stream_supports_partial_read(m_stream))
-    SVN_JAVAHL_CHECK(env, svn_stream_read2(m_stream,
-                                           dst.data() + offset, &len));
+    SVN_JAVAHL_CHECK(env, svn_stream_read2(m_stream, data, &len));
   else
-    SVN_JAVAHL_CHECK(env, svn_stream_read_full(m_stream,
-                                               dst.data() + offset, &len));
+    SVN_JAVAHL_CHECK(env, svn_stream_read_full(m_stream, data, &len));
   if (len == 0)
     return -1;                  // EOF
   if (len <= length)
@@ -197,8 +214,28 @@ void NativeOutputStream::write(::Java::Env env,
   if (!src.data())
     ::Java::NullPointerException(env).raise();
 
+  write(env, src.data() + offset, length);
+}
+
+void NativeOutputStream::write_direct(::Java::Env env, jobject jsrc,
+                                      jint offset, jint length)
+{
+  const char* const data =
+    static_cast<const char*>(env.get()->GetDirectBufferAddress(jsrc));
+  if (!data)
+    ::Java::NullPointerException(env).raise();
+
+  const jlong capacity = env.get()->GetDirectBufferCapacity(jsrc);
+  if (offset < 0 || length < 0 || jlong(offset) + length > capacity)
+    ::Java::IndexOutOfBoundsException(env).raise();
+
+  write(env, data + offset, length);
+}
+
+void NativeOutputStream::write(::Java::Env env, const char* data, jint length)
+{
   apr_size_t len = length;
-  SVN_JAVAHL_CHECK(env, svn_stream_write(m_stream, src.data() + offset, &len));
+  SVN_JAVAHL_CHECK(env, svn_stream_write(m_stream, data, &len));
   if (len != length)
     ::Java::IOException(env).raise(_("Write to native stream failed"));
 }
@@ -295,6 +332,19 @@ Java_org_apache_subversion_javahl_types_NativeInputStream_read___3BII(
   return 0;
 }
 
+JNIEXPORT jint JNICALL
+Java_org_apache_subversion_javahl_types_NativeInputStream_readDirect(
+    JNIEnv* jenv, jobject jthis, jobject jdst, jint joffset, jint jlength)
+{
+  SVN_JAVAHL_JNI_TRY(NativeInputStream, readDirect)
+    {
+      SVN_JAVAHL_GET_BOUND_OBJECT(JavaHL::NativeInputStream, self);
+      return self->read_direct(Java::Env(jenv), jdst, joffset, jlength);
+    }
+  SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
+  return 0;
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_apache_subversion_javahl_types_NativeInputStream_skip(
     JNIEnv* jenv, jobject jthis, jlong jcount)
@@ -366,6 +416,18 @@ Java_org_apache_subversion_javahl_types_NativeOutputStream_write___3BII(
   SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
 }
 
+JNIEXPORT void JNICALL
+Java_org_apache_subversion_javahl_types_NativeOutputStream_writeDirect(
+    JNIEnv* jenv, jobject jthis, jobject jsrc, jint joffset, jint jlength)
+{
+  SVN_JAVAHL_JNI_TRY(NativeOutputStream, writeDirect)
+    {
+      SVN_JAVAHL_GET_BOUND_OBJECT(JavaHL::NativeOutputStream, self);
+      self->write_direct(Java::Env(jenv), jsrc, joffset, jlength);
+    }
+  SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
+}
+
 JNIEXPORT void JNICALL
 Java_org_apache_subversion_javahl_types_NativeOutputStream_finalize(
     JNIEnv* jenv, jobject jthis)
@@ -111,6 +111,14 @@ public:
    */
   jint read(::Java::Env env);
 
+private:
+  /**
+   * Read up to @a length bytes into @a data.
+   */
+  jint read(::Java::Env env, char* data, jint length);
+
+public:
+
   /**
    * Implements @c InputStream.read(byte[],int,int).
    */
@@ -118,6 +126,12 @@ public:
             ::Java::ByteArray::MutableContents& dst,
             jint offset, jint length);
 
+  /**
+   * Implements @c NativeInputStream.readDirect(ByteBuffer,int,int),
+   * reading straight into the memory of the direct buffer @a jdst.
+   */
+  jint read_direct(::Java::Env env, jobject jdst, jint offset, jint length);
+
   /**
    * Implements @c InputStream.skip(long).
    */
@@ -192,6 +206,14 @@ public:
    */
   void write(::Java::Env env, jint byte);
 
+private:
+  /**
+   * Write @a length bytes from @a data.
+   */
+  void write(::Java::Env env, const char* data, jint length);
+
+public:
+
   /**
    * Implements @c OutputStream.write(byte[],int,int).
    */
@@ -199,6 +221,12 @@ public:
              const ::Java::ByteArray::Contents& src,
              jint offset, jint length);
 
+  /**
+   * Implements @c NativeOutputStream.writeDirect(ByteBuffer,int,int),
+   * writing straight from the memory of the direct buffer @a jsrc.
+   */
+  void write_direct(::Java::Env env, jobject jsrc, jint offset, jint length);
+
 private:
   virtual void dispose(jobject jthis);
 
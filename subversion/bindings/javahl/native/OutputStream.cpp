@@ -33,8 +33,15 @@
  * @param jthis the Java object to be stored
  */
 OutputStream::OutputStream(jobject jthis)
+  : m_jthis(jthis), m_is_channel(false)
 {
-  m_jthis = jthis;
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass("java/nio/channels/WritableByteChannel");
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_is_channel = (jthis != NULL && env->IsInstanceOf(jthis, clazz));
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -78,6 +85,9 @@ svn_error_t *OutputStream::write(void *baton, const char *buffer,
   // An object of our class is passed in as the baton.
   OutputStream *that = static_cast<OutputStream *>(baton);
 
+  if (that->m_is_channel)
+    return writeChannel(that, buffer, len);
+
   // The method id will not change during the time this library is
   // loaded, so it can be cached.
   static jmethodID mid = 0;
@@ -109,6 +119,54 @@ svn_error_t *OutputStream::write(void *baton, const char *buffer,
   return SVN_NO_ERROR;
 }
 
+/**
+ * Like write(), but hand BUFFER to the WritableByteChannel as a direct
+ * ByteBuffer instead of copying it into a byte array.
+ */
+svn_error_t *OutputStream::writeChannel(OutputStream *that,
+                                        const char *buffer, apr_size_t *len)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz = env->FindClass("java/nio/channels/WritableByteChannel");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      mid = env->GetMethodID(clazz, "write", "(Ljava/nio/ByteBuffer;)I");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return SVN_NO_ERROR;
+
+      env->DeleteLocalRef(clazz);
+    }
+
+  // The channel only reads from the buffer, despite it being writable.
+  jobject data = env->NewDirectByteBuffer(const_cast<char *>(buffer),
+                                          jlong(*len));
+  if (JNIUtil::isJavaExceptionThrown() || data == NULL)
+    return SVN_NO_ERROR;
+
+  // Channels may write less than requested; continue until done.
+  apr_size_t written = 0;
+  while (written < *len)
+    {
+      jint jwritten = env->CallIntMethod(that->m_jthis, mid, data);
+      if (JNIUtil::isJavaExceptionThrown() || jwritten <= 0)
+        break;
+
+      written += jwritten;
+    }
+
+  env->DeleteLocalRef(data);
+  *len = written;
+
+  return SVN_NO_ERROR;
+}
+
 /**
  * Implements svn_close_fn_t to close the output stream.
  * @param baton     an OutputStream object for the callback
@@ -41,8 +41,15 @@ class OutputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+  /**
+   * Whether m_jthis is a java.nio.channels.WritableByteChannel, which
+   * lets us pass Subversion's buffer on without copying it.
+   */
+  bool m_is_channel;
   static svn_error_t *write(void *baton,
                             const char *buffer, apr_size_t *len);
+  static svn_error_t *writeChannel(OutputStream *that, const char *buffer,
+                                   apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
   OutputStream(jobject jthis);
@@ -898,6 +898,7 @@ RemoteSession::getLog(jobject jpaths,
                               revprops,
                               receiver.callback, &receiver,
                               subPool.getPool()),);
+  SVN_JNI_ERR(receiver.flush(),);
 }
 
 jobject
@@ -193,6 +193,7 @@ void SVNClient::list(const char *url, Revision &revision,
                                  ListCallback::callback,
                                  callback,
                                  ctx, subPool.getPool()), );
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 void
@@ -297,6 +298,7 @@ void SVNClient::logMessages(const char *path, Revision &pegRevision,
                                 includeMergedRevisions, revprops,
                                 LogMessageCallback::callback, callback, ctx,
                                 subPool.getPool()), );
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 jlong SVNClient::checkout(const char *moduleName, const char *destPath,
@@ -881,6 +883,7 @@ void SVNClient::getMergeinfoLog(int type, const char *pathOrURL,
                                           revProps.array(subPool),
                                           ctx,
                                           subPool.getPool()), );
+    SVN_JNI_ERR(callback->flush(), );
 
     return;
 }
@@ -128,7 +128,9 @@ public interface ISVNClient
      * @param direntFields    the fields to retrieve
      * @param fetchLocks      whether to fetch lock information
      * @param includeExternals whether to list external items
-     * @param callback        the callback to receive the directory entries
+     * @param callback        the callback to receive the directory entries;
+     *                        implement {@link ListItemBatchCallback} to
+     *                        receive them in batches
      * @since 1.10
      */
     void list(String url, Revision revision, Revision pegRevision,
@@ -227,7 +229,9 @@ public interface ISVNClient
      *                      revision properties
      * @param limit         limit the number of log messages (if 0 or less no
      *                      limit)
-     * @param callback      the object to receive the log messages
+     * @param callback      the object to receive the log messages;
+     *                      implement {@link LogMessageBatchCallback} to
+     *                      receive them in batches
      * @since 1.10
      */
     void logMessages(String path, Revision pegRevision,
@@ -0,0 +1,56 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+import org.apache.subversion.javahl.types.DirEntry;
+import org.apache.subversion.javahl.types.Lock;
+
+/**
+ * A {@link ListItemCallback} that receives the directory entries
+ * returned from the {@link ISVNClient#list} call in batches, which
+ * saves a call from native code per entry.
+ *
+ * If the callback passed to {@link ISVNClient#list} implements this
+ * interface, {@link #doEntries} will be called instead of
+ * {@link ListItemCallback#doEntry}.
+ *
+ * @since 1.10
+ */
+public interface ListItemBatchCallback extends ListItemCallback
+{
+    /**
+     * This method will be called for the next <code>count</code>
+     * directory entries, in the order in which they were found.
+     *
+     * The array elements at the same index describe the same entry,
+     * with the same meaning as the parameters of
+     * {@link ListItemCallback#doEntry}.  The arrays may be longer
+     * than <code>count</code>; they are not reused.
+     */
+    public void doEntries(DirEntry[] dirents, Lock[] locks,
+                          String[] externalParentURLs,
+                          String[] externalTargets,
+                          int count);
+}
@@ -0,0 +1,60 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+import org.apache.subversion.javahl.types.ChangePath;
+
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * A {@link LogMessageCallback} that receives the log messages found by
+ * a {@link ISVNClient#logMessages} call in batches, which saves a call
+ * from native code per message.
+ *
+ * If the callback implements this interface, {@link #messages} will be
+ * called instead of {@link LogMessageCallback#singleMessage}.  The
+ * messages are delivered in the same order, including the terminating
+ * entries of nested lists of merged revisions.
+ *
+ * @since 1.10
+ */
+public interface LogMessageBatchCallback extends LogMessageCallback
+{
+    /**
+     * This method will be called for the next <code>count</code> log
+     * messages.
+     *
+     * The array elements at the same index describe the same message,
+     * with the same meaning as the parameters of
+     * {@link LogMessageCallback#singleMessage}.  The arrays may be
+     * longer than <code>count</code>; they are not reused.
+     */
+    public void messages(Set<ChangePath>[] changedPaths,
+                         long[] revisions,
+                         Map<String, byte[]>[] revprops,
+                         boolean[] hasChildren,
+                         int count);
+}
@@ -27,14 +27,21 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.ReadableByteChannel;
 
 /**
  * Implementation class for {@link InputStream} objects returned from
  * JavaHL methods.
+ * <p>
+ * Since 1.10, this is also a {@link ReadableByteChannel}.  Reading into
+ * a direct {@link ByteBuffer} does not copy the data through a Java
+ * byte array.
  *
  * @since 1.9
  */
 public class NativeInputStream extends InputStream
+    implements ReadableByteChannel
 {
     /**
      * Load the required native library.
@@ -91,6 +98,54 @@ public class NativeInputStream extends InputStream
     @Override
     public native long skip(long count) throws IOException;
 
+    /**
+     * Reads up to <code>dst.remaining()</code> bytes into
+     * <code>dst</code> from the underlying native stream.
+     * @see ReadableByteChannel.read(ByteBuffer)
+     * @since 1.10
+     */
+    public int read(ByteBuffer dst) throws IOException
+    {
+        final int length = dst.remaining();
+        if (length == 0)
+            return 0;
+
+        final int position = dst.position();
+        int count;
+        if (dst.isDirect())
+            count = readDirect(dst, position, length);
+        else if (dst.hasArray())
+            count = read(dst.array(), dst.arrayOffset() + position, length);
+        else
+        {
+            byte[] buffer = new byte[length];
+            count = read(buffer, 0, length);
+            if (count > 0)
+                dst.put(buffer, 0, count);
+            return count;
+        }
+
+        if (count > 0)
+            dst.position(position + count);
+        return count;
+    }
+
+    /**
+     * @see ReadableByteChannel.isOpen()
+     * @since 1.10
+     */
+    public boolean isOpen()
+    {
+        return cppAddr != 0;
+    }
+
+    /**
+     * Reads up to <code>length</code> bytes into the direct buffer
+     * <code>dst</code> at <code>offset</code>, ignoring its position.
+     */
+    private native int readDirect(ByteBuffer dst, int offset, int length)
+        throws IOException;
+
 
     private long cppAddr;
 
@@ -27,14 +27,21 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.WritableByteChannel;
 
 /**
  * Implementation class for {@link OutputStream} objects returned from
  * JavaHL methods.
+ * <p>
+ * Since 1.10, this is also a {@link WritableByteChannel}.  Writing
+ * from a direct {@link ByteBuffer} does not copy the data through a
+ * Java byte array.
  *
  * @since 1.9
  */
 public class NativeOutputStream extends OutputStream
+    implements WritableByteChannel
 {
     /**
      * Load the required native library.
@@ -67,6 +74,51 @@ public class NativeOutputStream extends OutputStream
     @Override
     public native void write(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Writes all of the <code>src.remaining()</code> bytes from
+     * <code>src</code> to the underlying native stream.
+     * @see WritableByteChannel.write(ByteBuffer)
+     * @since 1.10
+     */
+    public int write(ByteBuffer src) throws IOException
+    {
+        final int length = src.remaining();
+        if (length == 0)
+            return 0;
+
+        final int position = src.position();
+        if (src.isDirect())
+            writeDirect(src, position, length);
+        else if (src.hasArray())
+            write(src.array(), src.arrayOffset() + position, length);
+        else
+        {
+            byte[] buffer = new byte[length];
+            src.get(buffer);
+            write(buffer, 0, length);
+            return length;
+        }
+
+        src.position(position + length);
+        return length;
+    }
+
+    /**
+     * @see WritableByteChannel.isOpen()
+     * @since 1.10
+     */
+    public boolean isOpen()
+    {
+        return cppAddr != 0;
+    }
+
+    /**
+     * Writes <code>length</code> bytes from the direct buffer
+     * <code>src</code> at <code>offset</code>, ignoring its position.
+     */
+    private native void writeDirect(ByteBuffer src, int offset, int length)
+        throws IOException;
+
 
     private long cppAddr;
 
@@ -2339,6 +2339,43 @@ public class BasicTests extends SVNTests
         thisTest.getWc().check(entries, "A/mu");
     }
 
+    /**
+     * Test SVNClient.list with a callback that receives batches.
+     * @throws Throwable
+     */
+    public void testBatchedLs() throws Throwable
+    {
+        OneTest thisTest = new OneTest();
+
+        final List<String> paths = new ArrayList<String>();
+        client.list(thisTest.getUrl().toString(), Revision.HEAD,
+                    Revision.HEAD, null, Depth.infinity,
+                    DirEntry.Fields.all, false, false,
+                    new ListItemBatchCallback() {
+                        public void doEntry(DirEntry dirent, Lock lock,
+                                            String externalParentURL,
+                                            String externalTarget)
+                        {
+                            fail("doEntry called on a batch callback");
+                        }
+
+                        public void doEntries(DirEntry[] dirents,
+                                              Lock[] locks,
+                                              String[] externalParentURLs,
+                                              String[] externalTargets,
+                                              int count)
+                        {
+                            assertTrue(count > 0 && count <= dirents.length);
+                            for (int i = 0; i < count; ++i)
+                                paths.add(dirents[i].getPath());
+                        }
+                    });
+
+        // The repository root and all 19 items of the greek tree.
+        assertEquals(20, paths.size());
+        assertTrue(paths.contains("A/D/G/rho"));
+    }
+
     /**
      * Test the basis SVNClient.add functionality with files that
      * should be ignored.
@@ -84,6 +84,7 @@
 %ignore svn_io_read_link;
 %ignore svn_io_temp_dir;
 %ignore svn_io_copy_file;
+%ignore svn_io_copy_file2;
 %ignore svn_io_copy_link;
 %ignore svn_io_copy_dir_recursively;
 %ignore svn_io_make_dir_recursively;
@@ -881,6 +881,7 @@ DECLARE_SWIG_CONSTRUCTOR(info, svn_info_dup)
 DECLARE_SWIG_CONSTRUCTOR(location_segment, svn_location_segment_dup)
 DECLARE_SWIG_CONSTRUCTOR(commit_info, svn_commit_info_dup)
 DECLARE_SWIG_CONSTRUCTOR(wc_notify, svn_wc_dup_notify)
+DECLARE_SWIG_CONSTRUCTOR(dirent, svn_dirent_dup)
 
 static PyObject *convert_log_changed_path(void *value, void *ctx,
                                           PyObject *py_pool)
@@ -3352,6 +3353,41 @@ svn_swig_py_location_segment_receiver_func(svn_location_segment_t *segment,
   return err;
 }
 
+svn_error_t *
+svn_swig_py_repos_dirent_receiver_func(const char *path,
+                                       svn_dirent_t *dirent,
+                                       void *baton,
+                                       apr_pool_t *scratch_pool)
+{
+  PyObject *receiver = baton;
+  PyObject *result;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if ((receiver == NULL) || (receiver == Py_None))
+    return SVN_NO_ERROR;
+
+  svn_swig_py_acquire_py_lock();
+
+  if ((result = PyObject_CallFunction(receiver,
+                                      (char *)"sO&O&",
+                                      path,
+                                      make_ob_dirent, dirent,
+                                      make_ob_pool, scratch_pool)) == NULL)
+    {
+      err = callback_exception_error();
+    }
+  else
+    {
+      if (result != Py_None)
+        err = callback_bad_return_error("Not None");
+      Py_DECREF(result);
+    }
+
+  svn_swig_py_release_py_lock();
+
+  return err;
+}
+
 svn_error_t *svn_swig_py_client_blame_receiver_func(void *baton,
                                                     apr_int64_t line_no,
                                                     svn_revnum_t revision,
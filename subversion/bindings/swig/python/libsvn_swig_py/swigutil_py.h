@@ -385,6 +385,13 @@ svn_swig_py_location_segment_receiver_func(svn_location_segment_t *segment,
                                            void *baton,
                                            apr_pool_t *pool);
 
+/* thunked svn_repos_list() dirent receiver function */
+svn_error_t *
+svn_swig_py_repos_dirent_receiver_func(const char *path,
+                                       svn_dirent_t *dirent,
+                                       void *baton,
+                                       apr_pool_t *scratch_pool);
+
 /* thunked blame receiver function */
 svn_error_t *svn_swig_py_client_blame_receiver_func(void *baton,
                                                     apr_int64_t line_no,
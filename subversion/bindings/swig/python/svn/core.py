@@ -27,6 +27,7 @@ from libsvn.core import *
 import libsvn.core as _libsvncore
 import atexit as _atexit
 import sys
+import threading as _threading
 # __all__ is defined later, since some svn_* functions are implemented below.
 
 
@@ -187,6 +188,121 @@ class Stream:
       svn_stream_close(self._stream)
       self._stream = None
 
+class CallbackIterator:
+  """Turn a Subversion function that reports its results to a callback
+  into an iterator over these results.
+
+  FUNC gets called in a separate thread as FUNC(RECEIVER), where RECEIVER
+  is the callback to pass on to the Subversion function.  Each time the
+  Subversion function invokes the callback, the iterator yields the result
+  of CONVERT applied to the callback's arguments.  If CONVERT is None, the
+  first argument gets yielded.
+
+  The thread running FUNC and the thread iterating never run at the same
+  time: the callback only returns when the next item gets requested.  So,
+  only one item exists at any time, just as if it had been processed
+  within the callback, and all objects passed to FUNC may be used between
+  iterations just as they could be used from within the callback.
+
+  Exceptions raised by FUNC get re-raised by the iterator.  If the
+  iteration gets stopped early, call close() to abort FUNC; this happens
+  automatically when the iterator gets garbage-collected."""
+
+  def __init__(self, func, convert=None):
+    self._func = func
+    self._convert = convert
+    self._cond = _threading.Condition()
+    self._thread = None
+    self._item = None
+    self._has_item = False
+    self._done = False
+    self._closed = False
+    self._error = None
+
+  def __iter__(self):
+    return self
+
+  def __next__(self):
+    self._cond.acquire()
+    try:
+      if self._thread is None:
+        self._thread = _threading.Thread(target=self._run)
+        self._thread.setDaemon(True)
+        self._thread.start()
+      elif self._has_item:
+        # Let the callback return to continue with the next item.
+        self._has_item = False
+        self._item = None
+        self._cond.notify()
+
+      while not self._has_item and not self._done:
+        self._cond.wait()
+
+      if self._has_item:
+        return self._item
+      if self._error is not None:
+        error = self._error
+        self._error = None
+        raise error
+      raise StopIteration
+    finally:
+      self._cond.release()
+
+  # Python <3.0
+  next = __next__
+
+  def close(self):
+    """Stop the iteration and wait for FUNC to return."""
+    self._cond.acquire()
+    try:
+      self._closed = True
+      self._cond.notify()
+      thread = self._thread
+    finally:
+      self._cond.release()
+
+    if thread is not None and thread is not _threading.currentThread():
+      thread.join()
+
+  def __del__(self):
+    self.close()
+
+  def _receiver(self, *args):
+    if self._convert is None:
+      item = args[0]
+    else:
+      item = self._convert(*args)
+
+    self._cond.acquire()
+    try:
+      if not self._closed:
+        self._item = item
+        self._has_item = True
+        self._cond.notify()
+        while self._has_item and not self._closed:
+          self._cond.wait()
+      if self._closed:
+        raise SubversionException("Iteration stopped", SVN_ERR_CANCELLED)
+    finally:
+      self._cond.release()
+
+  def _run(self):
+    error = None
+    try:
+      self._func(self._receiver)
+    except Exception:
+      error = sys.exc_info()[1]
+
+    self._cond.acquire()
+    try:
+      if not self._closed:
+        self._error = error
+      self._has_item = False
+      self._done = True
+      self._cond.notify()
+    finally:
+      self._cond.release()
+
 def secs_from_timestr(svn_datetime, pool=None):
   """Convert a Subversion datetime string into seconds since the Epoch."""
   aprtime = svn_time_from_cstring(svn_datetime, pool)
@@ -322,7 +438,8 @@ def run_app(func, *args, **kw):
 __all__ = filter(lambda s: (s.startswith('svn_')
                             or s.startswith('SVN_')
                             or s.startswith('SVNSYNC_')
-                            or s in ('Pool', 'SubversionException'))
+                            or s in ('Pool', 'SubversionException',
+                                      'CallbackIterator'))
                            and '__' not in s,
                  locals())
 
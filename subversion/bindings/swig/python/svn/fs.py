@@ -42,6 +42,20 @@ except ImportError:
 import svn.core as _svncore
 
 
+def iter_file_contents(root, path, chunk_size=_svncore.SVN_STREAM_CHUNK_SIZE,
+                       pool=None):
+  "Yield the contents of PATH in ROOT in chunks of at most CHUNK_SIZE bytes."
+  stream = _svncore.Stream(file_contents(root, path, pool))
+  try:
+    while True:
+      chunk = stream.read(chunk_size)
+      if not chunk:
+        break
+      yield chunk
+  finally:
+    stream.close()
+
+
 def entries(root, path, pool=None):
   "Call dir_entries returning a dictionary mappings names to IDs."
   e = dir_entries(root, path, pool)
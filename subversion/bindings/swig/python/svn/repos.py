@@ -338,3 +338,25 @@ class ParseFns3:
 
 def make_parse_fns3(parse_fns3, pool=None):
     return svn_swig_py_make_parse_fns3(parse_fns3, pool)
+
+
+def iter_logs(repos, paths, start, end, limit=0, discover_changed_paths=False,
+              strict_node_history=False, include_merged_revisions=False,
+              revprops=None, authz_read_func=None, pool=None):
+  """Yield the svn_log_entry_t objects that get_logs4() reports.
+
+  Each entry is only valid until the next one gets requested."""
+  def _get_logs(receiver):
+    get_logs4(repos, paths, start, end, limit, discover_changed_paths,
+              strict_node_history, include_merged_revisions, revprops,
+              authz_read_func, lambda log_entry, pool: receiver(log_entry),
+              pool)
+  return _svncore.CallbackIterator(_get_logs)
+
+def iter_list(root, path, patterns=None, depth=_svncore.svn_depth_infinity,
+              path_info_only=False, authz_read_func=None, pool=None):
+  """Yield (PATH, DIRENT) tuples for the nodes that list() reports."""
+  def _list(receiver):
+    list(root, path, patterns, depth, path_info_only, authz_read_func,
+         lambda path, dirent, pool: receiver(path, dirent), None, pool)
+  return _svncore.CallbackIterator(_list, lambda path, dirent: (path, dirent))
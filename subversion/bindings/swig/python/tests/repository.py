@@ -252,6 +252,28 @@ class SubversionRepositoryTestCase(unittest.TestCase):
     self.assertEqual(len(logs), 12)
     self.assertEqual(change_count, 19)
 
+  def test_iter_logs(self):
+    """Test iterating over log entries"""
+    revs = [log_entry.revision
+            for log_entry in repos.iter_logs(self.repos, ['/'], self.rev, 0)]
+    self.assertEqual(revs, list(range(self.rev, -1, -1)))
+
+    # Stopping early must not leave the worker thread blocked.
+    logs = repos.iter_logs(self.repos, ['/'], self.rev, 0)
+    self.assertEqual(next(logs).revision, self.rev)
+    logs.close()
+
+  def test_iter_list(self):
+    """Test iterating over directory entries"""
+    root = fs.revision_root(self.fs, self.rev)
+    paths = [path for path, dirent in repos.iter_list(root, '/trunk')]
+    self.assertTrue('/trunk/README.txt' in paths)
+    for path, dirent in repos.iter_list(root, '/trunk', ['README.txt']):
+      self.assertEqual(path, '/trunk/README.txt')
+      self.assertEqual(dirent.kind, core.svn_node_file)
+    contents = b''.join(fs.iter_file_contents(root, '/trunk/README.txt'))
+    self.assertEqual(len(contents), fs.file_length(root, '/trunk/README.txt'))
+
   def test_dir_delta(self):
     """Test scope of dir_delta callbacks"""
     # Run dir_delta
@@ -80,6 +80,15 @@
                   svn_swig_py_location_segment_receiver_func,
                   ,
                   )
+
+%callback_typemap(svn_repos_dirent_receiver_t receiver, void *receiver_baton,
+                  svn_swig_py_repos_dirent_receiver_func,
+                  ,
+                  )
+
+%apply const apr_array_header_t *STRINGLIST {
+  const apr_array_header_t *patterns
+};
 #endif
 
 #ifdef SWIGRUBY
@@ -174,6 +174,35 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t total_entries;
 
+  /** Number of items evicted from the first cache level (L1) that got
+   * promoted to the second level (L2).
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t promotions;
+
+  /** Number of items evicted from L1 that got dropped because they could
+   * not compete for space in L2.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t l1_evictions;
+
+  /** Number of items evicted from L1 that got dropped because their cache
+   * uses #svn_cache__admission_scan_resistant and they had not been
+   * accessed recently enough.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t rejections;
+
+  /** Number of items removed from L2 to make room for other items.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t l2_evictions;
+
+  /** Number of items removed because their index bucket overflowed.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t conflicts;
+
   /** Number of index buckets with the given number of entries.
    * Bucket sizes larger than the array will saturate into the
    * highest array index.
@@ -223,6 +252,44 @@ svn_cache__create_inprocess(svn_cache__t **cache_p,
                             const char *id,
                             apr_pool_t *pool);
 
+/**
+ * Creates a new in-memory cache in @a *cache_p, allocated in @a pool.
+ * Like the cache created by svn_cache__create_inprocess(), it stores
+ * serialized copies of the values, using @a serialize_func and
+ * @a deserialize_func, under keys of length @a klen, which may be
+ * APR_HASH_KEY_STRING.
+ *
+ * The keys are split into @a shards independent sections with their own
+ * locks such that concurrent accesses rarely block each other.  If
+ * @a shards is 0, a default will be used, which is 1 unless
+ * @a thread_safe is set.  Items are evicted individually in least
+ * recently used order as soon as the cache would hold more than
+ * @a max_entries items or more than @a max_size bytes of serialized data.
+ * Either limit may be 0 for "unlimited" but not both.  The limits are
+ * split evenly between the shards and are reported by
+ * svn_cache__get_info().
+ *
+ * If @a thread_safe is true, and APR is compiled with threads, all
+ * accesses to the cache will be protected with per-shard mutexes.
+ * @a id is only used to identify the cache in #svn_cache__info_t.
+ *
+ * It is not safe for @a serialize_func nor @a deserialize_func to
+ * interact with the cache itself.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__create_sharded(svn_cache__t **cache_p,
+                          svn_cache__serialize_func_t serialize_func,
+                          svn_cache__deserialize_func_t deserialize_func,
+                          apr_ssize_t klen,
+                          int shards,
+                          apr_uint64_t max_entries,
+                          apr_uint64_t max_size,
+                          svn_boolean_t thread_safe,
+                          const char *id,
+                          apr_pool_t *pool);
+
 /**
  * Creates a new cache in @a *cache_p, communicating to a memcached
  * process via @a memcache.  The elements in the cache will be indexed
@@ -237,7 +304,13 @@ svn_cache__create_inprocess(svn_cache__t **cache_p,
  * svn_stringbuf_t; if @a serialize_func is NULL, then the data is
  * assumed to be an svn_stringbuf_t.
  *
- * These caches are always thread safe.
+ * If @a near_cache is not NULL, it will be tried before contacting the
+ * memcached servers, receives all items fetched from them and all new
+ * items.  It must have been created with the same @a serialize_func,
+ * @a deserialize_func and @a klen.  svn_cache__get_many() will fetch all
+ * items that @a near_cache does not have in a single batch.
+ *
+ * These caches are thread safe if @a near_cache is NULL or thread safe.
  *
  * These caches do not support svn_cache__iter.
  *
@@ -247,6 +320,7 @@ svn_cache__create_inprocess(svn_cache__t **cache_p,
 svn_error_t *
 svn_cache__create_memcache(svn_cache__t **cache_p,
                            svn_memcache_t *memcache,
+                           svn_cache__t *near_cache,
                            svn_cache__serialize_func_t serialize_func,
                            svn_cache__deserialize_func_t deserialize_func,
                            apr_ssize_t klen,
@@ -260,6 +334,13 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
  * memcached servers; otherwise, sets @a *memcache_p to NULL.  Use
  * @a scratch_pool for temporary allocations.
  *
+ * Keys get distributed over the servers by consistent hashing, i.e. adding
+ * a server to the configuration only moves the keys that it takes over.
+ * Keys of a server that is down temporarily fall through to the next one.
+ * If the SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES option in the
+ * SVN_CACHE_CONFIG_CATEGORY_MEMCACHED section is set, writes will be sent
+ * to the servers by a background thread and may get dropped under load.
+ *
  * If Subversion was not built with apr_memcache_support, then raises
  * SVN_ERR_NO_APR_MEMCACHE if and only if @a config is configured to
  * use memcache.
@@ -292,8 +373,15 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * @a thread_safe may be set to @c FALSE for maximum performance.
  *
  * There is no limit on the number of threads reading a given cache segment
- * concurrently.  Writes, however, need an exclusive lock on the respective
- * segment.  @a allow_blocking_writes controls contention is handled here.
+ * concurrently.  To reduce contention between readers on machines with
+ * many cores, each segment may use @a lock_stripes read-write locks.
+ * Readers will acquire only one of them, selected by their thread ID.
+ * The value will be rounded down to the next power of two and capped at
+ * an implementation specific limit.  0 and 1 both mean a single lock.
+ *
+ * Writes, however, need an exclusive lock on the respective segment,
+ * i.e. on all of its lock stripes.  @a allow_blocking_writes controls
+ * contention is handled here.
  * If set to TRUE, writes will wait until the lock becomes available, i.e.
  * reads should be short.  If set to FALSE, write attempts will be ignored
  * (no data being written to the cache) if some reader or another writer
@@ -306,10 +394,40 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
                                   apr_size_t directory_size,
                                   apr_size_t segment_count,
+                                  apr_size_t lock_stripes,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Same as svn_cache__membuffer_cache_create() but place all cache data and
+ * management structures in a single shared memory region, allocated in
+ * @a result_pool.  Child processes forked after this call will use the
+ * same cache and all data written by any of them remains available to the
+ * others as well as to future children.  Hence, forking servers should
+ * create the cache before forking the first child.
+ *
+ * If @a shm_name is not @c NULL, a named region will be used and any stale
+ * region of that name will be removed first.  Otherwise, the region will
+ * be anonymous.
+ *
+ * All access to the cache segments will be serialized by inter-process
+ * locks that are also thread-safe.  Caches using this membuffer always
+ * store their full keys because prefix indexes would be process-local.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the platform does not support
+ * fork() or shared memory.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         const char *shm_name,
+                                         apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -337,6 +455,26 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 
 /** @} */
 
+/**
+ * Admission policies for #svn_cache__create_membuffer_cache.  They control
+ * which items get promoted from the first cache level (L1) into the
+ * long-lived second level (L2) when they get evicted from L1.
+ *
+ * @since New in 1.10.
+ */
+typedef enum svn_cache__admission_t
+{
+  /** Every item evicted from L1 competes for space in L2 based on its
+   * priority and hit count. */
+  svn_cache__admission_default = 0,
+
+  /** Items that have neither been read while in L1 nor been written to
+   * the cache repeatedly within a recent time window will not be promoted
+   * to L2.  Use this for data that tends to be streamed through the cache
+   * once, e.g. by export or verify, lest it evict more valuable data. */
+  svn_cache__admission_scan_resistant
+} svn_cache__admission_t;
+
 /**
  * Creates a new cache in @a *cache_p, storing the data in a potentially
  * shared @a membuffer object.  The elements in the cache will be indexed
@@ -346,9 +484,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
  * the same memcache object may cache many different kinds of values
  * form multiple caches, @a prefix should be specified to differentiate
  * this cache from other caches.  All entries written through this cache
- * interface will be assigned into the given @a priority class.  @a *cache_p
- * will be allocated in @a result_pool.  @a scratch_pool is used for
- * temporary allocations.
+ * interface will be assigned into the given @a priority class and be
+ * subject to the given @a admission policy.  @a *cache_p will be allocated
+ * in @a result_pool.  @a scratch_pool is used for temporary allocations.
  *
  * If @a deserialize_func is NULL, then the data is returned as an
  * svn_stringbuf_t; if @a serialize_func is NULL, then the data is
@@ -373,11 +511,73 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_ssize_t klen,
                                   const char *prefix,
                                   apr_uint32_t priority,
+                                  svn_cache__admission_t admission,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t short_lived,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/**
+ * Opaque type of a persistent, file-based store for serialized cache
+ * items.  It can back an in-memory cache, see svn_cache__create_persistent.
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_cache__persistent_t svn_cache__persistent_t;
+
+/**
+ * Return the process-global persistent store for the file at @a path in
+ * @a *store_p.  Create the file if it does not exist, yet.  The file will
+ * not grow beyond @a max_size bytes.
+ *
+ * All data in the file is only valid for the given @a tag, e.g. the
+ * repository UUID, as well as for the current platform and Subversion
+ * version.  If any of them does not match, the file contents will be
+ * discarded.  Only immutable data may be stored in a persistent store.
+ *
+ * @a generation identifies the state of the data source, e.g. the
+ * youngest revision of a repository, and must never decrease for the
+ * same @a tag.  If the file has been written for a later generation, the
+ * source has been rolled back and the file contents will be discarded as
+ * well.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__get_persistent_store(svn_cache__persistent_t **store_p,
+                                const char *path,
+                                const char *tag,
+                                apr_uint64_t generation,
+                                apr_uint64_t max_size,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Creates a new cache in @a *cache_p that combines @a memory_cache with
+ * the persistent @a store.  Lookups that miss @a memory_cache will be
+ * tried against @a store and items found there will be put back into
+ * @a memory_cache.  New items will be written to both.
+ *
+ * @a serialize, @a deserialize and @a klen must match the parameters used
+ * to create @a memory_cache; @a prefix must uniquely identify this cache
+ * within @a store.  If @a serialize or @a deserialize are NULL, the items
+ * are assumed to be #svn_stringbuf_t.  Allocations will be made in
+ * @a result_pool.
+ *
+ * Only the in-memory copy of an item can be modified using
+ * svn_cache__set_partial().  These caches do not support svn_cache__iter.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__create_persistent(svn_cache__t **cache_p,
+                             svn_cache__t *memory_cache,
+                             svn_cache__persistent_t *store,
+                             svn_cache__serialize_func_t serialize,
+                             svn_cache__deserialize_func_t deserialize,
+                             apr_ssize_t klen,
+                             const char *prefix,
+                             apr_pool_t *result_pool);
+
 /**
  * Creates a null-cache instance in @a *cache_p, allocated from
  * @a result_pool.  The given @c id is the only data stored in it and can
@@ -418,6 +618,8 @@ svn_cache__is_cachable(svn_cache__t *cache,
                        apr_size_t size);
 
 #define SVN_CACHE_CONFIG_CATEGORY_MEMCACHED_SERVERS "memcached-servers"
+#define SVN_CACHE_CONFIG_CATEGORY_MEMCACHED         "memcached"
+#define SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES        "async-writes"
 
 /**
  * Fetches a value indexed by @a key from @a cache into @a *value,
@@ -491,6 +693,39 @@ svn_cache__iter(svn_boolean_t *completed,
                 void *baton,
                 apr_pool_t *scratch_pool);
 
+/**
+ * Like svn_cache__get() but look up all @a count keys given in @a keys
+ * at once.  For every index I, @a values[I] and @a found[I] will be set
+ * as svn_cache__get() would for @a keys[I].  Individual keys may be NULL.
+ * Both output arrays must provide space for @a count elements.
+ *
+ * This is more efficient than separate svn_cache__get() calls because
+ * implementations may share lock acquisition and other per-call overhead
+ * between the items.  The values are allocated in @a result_pool; use
+ * @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    svn_cache__t *cache,
+                    const void * const *keys,
+                    int count,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_cache__set() but store all @a count items @a values[I] under
+ * their respective @a keys[I] at once.  NULL keys will be ignored.
+ * There is no guarantee that any of the items will actually be cached.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__set_many(svn_cache__t *cache,
+                    const void * const *keys,
+                    void * const *values,
+                    int count,
+                    apr_pool_t *scratch_pool);
+
 /**
  * Similar to svn_cache__get() but will call a specific de-serialization
  * function @a func. @a found will be set depending on whether the @a key
@@ -534,6 +769,17 @@ svn_cache__get_info(svn_cache__t *cache,
                     svn_boolean_t reset,
                     apr_pool_t *result_pool);
 
+/**
+ * Add the number of lookups in @a cache to @a *gets and the number of
+ * those that found the requested entry to @a *hits.  Unlike
+ * svn_cache__get_info(), this only reads the counters of the front-end
+ * and does not access any shared cache data.
+ */
+void
+svn_cache__add_access_counts(apr_uint64_t *gets,
+                             apr_uint64_t *hits,
+                             svn_cache__t *cache);
+
 /**
  * Return the information given in @a info formatted as a multi-line string.
  * If @a access_only has been set, size and fill-level statistics will be
@@ -554,6 +800,51 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Set the number of read-write lock stripes per segment that shall be
+ * used by the process-global membuffer cache to @a lock_stripes.  See
+ * svn_cache__membuffer_cache_create() for details.  The default is 1.
+ *
+ * Like svn_cache_config_set(), this must be called before the global
+ * membuffer cache gets created and is not thread-safe.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_cache__config_set_lock_stripes(apr_size_t lock_stripes);
+
+/**
+ * Return the number of lock stripes per segment as set by
+ * svn_cache__config_set_lock_stripes().
+ *
+ * @since New in 1.10.
+ */
+apr_size_t
+svn_cache__config_get_lock_stripes(void);
+
+/**
+ * If @a shared is set, the global membuffer cache will be created by
+ * svn_cache__membuffer_cache_create_shared() using the region name
+ * @a shm_name, which may be @c NULL.  This must be called before the
+ * first call to svn_cache__get_global_membuffer_cache() and @a shm_name
+ * must remain valid until then.  Pre-forking servers should then call the
+ * latter before forking.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_cache__config_set_shared(svn_boolean_t shared,
+                             const char *shm_name);
+
+/**
+ * Return whether the global membuffer cache shall be put into shared
+ * memory.
+ *
+ * @since New in 1.10.
+ */
+svn_boolean_t
+svn_cache__config_get_shared(void);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
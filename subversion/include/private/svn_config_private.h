@@ -110,6 +110,21 @@ svn_config__parse_stream(svn_stream_t *stream,
                          void *constructor_baton,
                          apr_pool_t *scratch_pool);
 
+/*
+ * Like svn_config__parse_stream(), but parse the LEN bytes of
+ * configuration data at DATA.  DATA must remain valid until this
+ * function returns.
+ *
+ * This saves the overhead of reading the data through a stream and
+ * should be used when the complete configuration is already in memory.
+ */
+svn_error_t *
+svn_config__parse_buffer(const char *data,
+                         apr_size_t len,
+                         svn_config__constructor_t *constructor,
+                         void *constructor_baton,
+                         apr_pool_t *scratch_pool);
+
 /*
  * Write the configuration CFG to STREAM, using SCRATCH_POOL for
  * temporary allocations.
@@ -33,6 +33,7 @@ extern "C" {
     namespace. */
 #define SVN_DAV__MERGEINFO_REPORT "mergeinfo-report"
 #define SVN_DAV__INHERITED_PROPS_REPORT "inherited-props-report"
+#define SVN_DAV__STAT_MANY_REPORT "stat-many-report"
 
 /** Names for XML child elements of the custom HTTP REPORTs understood
     by mod_dav_svn, sans namespace. */
@@ -49,6 +50,7 @@ extern "C" {
 #define SVN_DAV__IPROP_PATH "iprop-path"
 #define SVN_DAV__IPROP_PROPNAME "iprop-propname"
 #define SVN_DAV__IPROP_PROPVAL "iprop-propval"
+#define SVN_DAV__STAT_ENTRY "stat-entry"
 
 /** Names of XML elements attributes and tags for svn_ra_change_rev_prop2()'s
     extension of PROPPATCH.  */
@@ -108,6 +108,32 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Set @a *stream to a delta stream that turns @a source into @a target,
+ * just like svn_txdelta2().  However, matching data is found by splitting
+ * both into content-defined chunks and looking up each target chunk in an
+ * index over the whole @a source.  This is much more effective than the
+ * standard algorithm if data got inserted into or removed from large
+ * binary files.
+ *
+ * @a source will be read completely when the first window is requested.
+ * The windows produced have source views that never slide backwards and
+ * don't skip data, i.e. they may be applied with svn_txdelta_apply() and
+ * sent as svndiff.  Unlike svn_txdelta2(), the source views are not
+ * aligned with the target views.
+ *
+ * If @a calculate_checksum is set, the MD5 of @a target will be available
+ * through svn_txdelta_md5_digest() once the last window has been read.
+ * Allocate the stream and the chunk index in @a pool.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_txdelta__cdc(svn_txdelta_stream_t **stream,
+                 svn_stream_t *source,
+                 svn_stream_t *target,
+                 svn_boolean_t calculate_checksum,
+                 apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -361,6 +361,31 @@ svn_diff__tree_processor_tee_create(const svn_diff_tree_processor_t *processor1,
                                     const svn_diff_tree_processor_t *processor2,
                                     apr_pool_t *result_pool);
 
+/**
+ * Create a new svn_diff_tree_processor_t instance that forwards all calls
+ * to @a processor, in order, from a separate worker thread.  The driver
+ * can thereby fetch the next nodes while @a processor still diffs and
+ * writes the output for the previous ones.
+ *
+ * All arguments are copied before the calls return.  Files get hard
+ * linked where possible, so the driver may remove but must not modify
+ * them in place.  Opening a directory waits for @a processor to catch
+ * up and reports its skip decisions to the driver; files only inherit
+ * the decision of their parent.  Once the root node of the diff is done,
+ * the calls wait for @a processor as well, so that it has seen all
+ * events when the drive completes.  Errors from @a processor are returned
+ * by a later call.
+ *
+ * @a processor must not be used by anybody else while the drive is in
+ * progress.  Without thread support, @a processor is returned as is.
+ *
+ * @since New in 1.10.
+ */
+const svn_diff_tree_processor_t *
+svn_diff__tree_processor_pipeline_create(
+                                const svn_diff_tree_processor_t *processor,
+                                apr_pool_t *result_pool);
+
 
 svn_diff_source_t *
 svn_diff__source_create(svn_revnum_t revision,
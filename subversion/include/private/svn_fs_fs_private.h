@@ -260,6 +260,10 @@ typedef struct svn_fs_fs__stats_t
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
  * Use SCRATCH_POOL for temporary allocations.
+ *
+ * For format 7 repositories, FS may have been opened with
+ * #SVN_FS_CONFIG_FSFS_STATS_JOBS to scan multiple rev / pack files
+ * concurrently.  The results will be the same.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
@@ -68,6 +68,125 @@ svn_fs__access_get_lock_tokens(svn_fs_access_t *access_ctx);
 svn_error_t *
 svn_fs__path_valid(const char *path, apr_pool_t *pool);
 
+/* Report ERR through the warning callback that has been set for FS with
+ * svn_fs_set_warning_func().  ERR will not be cleared.
+ *
+ * This allows for forwarding warnings that have been collected from other
+ * filesystem instances, e.g. ones used by worker threads.
+ */
+void
+svn_fs__warn(svn_fs_t *fs, svn_error_t *err);
+
+/* Flush all revisions that have been committed through FS so far to
+ * disk.  If DEFER is set, do not flush any further commits through FS
+ * until the next call to this function; otherwise, restore the flushing
+ * behavior configured for FS.
+ *
+ * This allows bulk operations to group many commits into a single
+ * durability point.  Return SVN_ERR_UNSUPPORTED_FEATURE if DEFER is set
+ * but the backend of FS does not support deferring flushes.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs__sync(svn_fs_t *fs,
+             svn_boolean_t defer,
+             apr_pool_t *scratch_pool);
+
+/* I/O statistics collected by a filesystem instance while I/O statistics
+ * are enabled for it, see svn_fs__set_io_stats().
+ */
+typedef struct svn_fs__io_stats_t
+{
+  /* Number of items (node revisions, representation headers, delta
+   * windows, changed paths lists) requested from the filesystem. */
+  apr_uint64_t items_read;
+
+  /* Number of bytes read from revision and pack files, including their
+   * indexes. */
+  apr_uint64_t bytes_read;
+
+  /* Number of revision and pack files opened. */
+  apr_uint64_t files_opened;
+
+  /* Number of item index lookups (log-to-phys and phys-to-log). */
+  apr_uint64_t index_lookups;
+
+  /* Number of representations reconstructed from their delta chains. */
+  apr_uint64_t reps_reconstructed;
+
+  /* Sum and maximum of the delta chain lengths of those representations. */
+  apr_uint64_t delta_chain_length;
+  apr_uint64_t max_delta_chain_length;
+
+  /* Time spent reconstructing those representations. */
+  apr_interval_time_t reconstruction_time;
+
+  /* Number of lookups in the filesystem's caches and how many of them
+   * were successful. */
+  apr_uint64_t cache_gets;
+  apr_uint64_t cache_hits;
+} svn_fs__io_stats_t;
+
+/* Enable or disable the collection of I/O statistics for FS, depending
+ * on ENABLED.  If TRACE is not NULL, also write every access to a revision
+ * or pack file of FS to it, using the strace output format understood by
+ * tools/dev/fsfs-access-map.  Failures to write to TRACE are ignored.
+ *
+ * Statistics are disabled by default and cost only a few counter updates
+ * while enabled.  Return SVN_ERR_UNSUPPORTED_FEATURE if ENABLED is set but
+ * the backend of FS does not collect I/O statistics.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs__set_io_stats(svn_fs_t *fs,
+                     svn_boolean_t enabled,
+                     svn_stream_t *trace,
+                     apr_pool_t *scratch_pool);
+
+/* Return the I/O statistics collected by FS in *STATS, allocated in
+ * RESULT_POOL.  If RESET is set, restart counting from 0 afterwards, e.g.
+ * to report the I/O caused by individual requests.  Backends that don't
+ * collect I/O statistics report all counters as 0.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs__get_io_stats(svn_fs__io_stats_t **stats,
+                     svn_fs_t *fs,
+                     svn_boolean_t reset,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool);
+
+/* A byte range within a file, see svn_fs__file_contents_ranges(). */
+typedef struct svn_fs__file_range_t
+{
+  apr_off_t offset;
+  apr_off_t length;
+} svn_fs__file_range_t;
+
+/* If the contents of the file PATH in ROOT are stored verbatim, i.e.
+ * neither compressed nor deltified, in some file on disk, set *FILE_PATH
+ * to the name of that file and *RANGES to the svn_fs__file_range_t *
+ * elements that, concatenated, form the contents.  Set both to NULL if
+ * that is not the case, e.g. for empty files, transaction roots or if
+ * the backend of ROOT does not support this function.
+ *
+ * This allows for sending the contents with zero-copy mechanisms like
+ * sendfile().  The data within the ranges is immutable but the file
+ * itself may be removed when the repository gets packed.  Callers must
+ * then fall back to svn_fs_file_contents().  Note that the data will not
+ * be verified against the file's checksum.
+ *
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs__file_contents_ranges(const char **file_path,
+                             apr_array_header_t **ranges,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 
 
 /** Editors
@@ -85,6 +85,58 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Tell the OS that the @a length bytes starting at @a offset in @a file
+ * will be read soon, allowing it to schedule the I/O in the background.
+ * The data can then be read through the usual APIs with less latency.
+ *
+ * This is a hint only.  It will be a no-op on platforms that don't
+ * support it and any failure will be silently ignored.  It does not
+ * change the file pointer nor user-space buffer contents of @a file.
+ */
+void
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length);
+
+/** Create a hard link at @a to_path that refers to the same file as
+ * @a from_path.  Return @c SVN_ERR_UNSUPPORTED_FEATURE if the platform
+ * does not support hard links.  Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *pool);
+
+/** Opaque type of a file modification watcher.
+ */
+typedef struct svn_io__file_watcher_t svn_io__file_watcher_t;
+
+/** Create a watcher for modifications of the file at @a path, including
+ * its replacement by another file, in @a *watcher.  It will be allocated
+ * in @a result_pool and released when that pool gets cleaned up.
+ *
+ * Set @a *watcher to @c NULL if the platform does not support change
+ * notifications or if the watcher could not be created for any other
+ * reason.  Use @a scratch_pool for temporary allocations.
+ *
+ * @note Change notifications are not available for network file systems.
+ */
+svn_error_t *
+svn_io__file_watcher_create(svn_io__file_watcher_t **watcher,
+                            const char *path,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/** Return @c TRUE if the file watched by @a watcher may have changed since
+ * the last call to this function or since the creation of @a watcher,
+ * and @c FALSE otherwise.  This will never block.
+ *
+ * Calls for the same @a watcher must be serialized.
+ */
+svn_boolean_t
+svn_io__file_watcher_changed(svn_io__file_watcher_t *watcher);
+
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
@@ -135,6 +187,55 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/* Borrow handler for a stream.  Set *DATA to a buffer that holds the
+   next *LEN bytes of the stream, consuming them.  On entry, *LEN is the
+   maximum number of bytes that the caller wants.  *LEN == 0 indicates
+   the end of the stream.  The buffer must remain valid until the next
+   call to any other function on the stream or to the matching
+   svn_stream__return_fn_t.
+
+   If the data can't be lent out at this time, set *DATA to NULL and
+   don't consume anything. */
+typedef svn_error_t *(*svn_stream__borrow_fn_t)(void *baton,
+                                                const char **data,
+                                                apr_size_t *len);
+
+/* Return handler for a stream.  Release the buffer lent out by the last
+   call to the corresponding svn_stream__borrow_fn_t. */
+typedef svn_error_t *(*svn_stream__return_fn_t)(void *baton);
+
+/* Set STREAM's borrow and return functions to BORROW_FN and RETURN_FN,
+   respectively.  RETURN_FN may be NULL if lent buffers need no release. */
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn,
+                       svn_stream__return_fn_t return_fn);
+
+/* Read up to *LEN bytes from STREAM without copying them, if possible.
+   Set *DATA to the data read and *LEN to its actual length.
+
+   If STREAM does not support lending out its buffers, read up to
+   min(*LEN, BUFFER_SIZE) bytes into BUFFER with svn_stream_read_full()
+   and set *DATA to BUFFER.  Otherwise, *DATA is only valid until
+   svn_stream__return() gets called or the next operation on STREAM.
+
+   *LEN == 0 indicates the end of the stream.  When the data was copied
+   into BUFFER, *LEN < BUFFER_SIZE does so as well.
+
+   Call svn_stream__return() once you are done with *DATA.
+ */
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream,
+                   const char **data,
+                   apr_size_t *len,
+                   char *buffer,
+                   apr_size_t buffer_size);
+
+/* Release the data returned by the last svn_stream__borrow() on STREAM.
+ */
+svn_error_t *
+svn_stream__return(svn_stream_t *stream);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
@@ -264,6 +264,37 @@ svn_log__list(const char *path, svn_revnum_t revision,
               apr_array_header_t *patterns, svn_depth_t depth,
               apr_uint32_t dirent_fields, apr_pool_t *pool);
 
+/**
+ * Return a log string for a get-files-batch action.
+ *
+ * @since New in 1.10.
+ */
+const char *
+svn_log__get_files_batch(const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         svn_boolean_t want_contents,
+                         svn_boolean_t want_props,
+                         apr_pool_t *pool);
+
+/**
+ * Return a log string for a stat-many action.
+ *
+ * @since New in 1.10.
+ */
+const char *
+svn_log__stat_many(const apr_array_header_t *paths,
+                   svn_revnum_t rev,
+                   apr_pool_t *pool);
+
+/**
+ * Return a log string for a get-file-annotation action.
+ *
+ * @since New in 1.10.
+ */
+const char *
+svn_log__get_file_annotation(const char *path, svn_revnum_t revision,
+                             apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -287,6 +287,83 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* A parser for many mergeinfo strings, e.g. all the values of a mergeinfo
+   catalog.  All results share the parser's pool, and merge source paths
+   are interned, i.e. every distinct path is stored only once. */
+typedef struct svn_mergeinfo__parser_t svn_mergeinfo__parser_t;
+
+/* Return a new mergeinfo parser whose results will be allocated in
+   RESULT_POOL. */
+svn_mergeinfo__parser_t *
+svn_mergeinfo__parser_create(apr_pool_t *result_pool);
+
+/* Like svn_mergeinfo_parse() but use PARSER and allocate *MERGEINFO in
+   PARSER's result pool.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_mergeinfo__parser_parse(svn_mergeinfo_t *mergeinfo,
+                            svn_mergeinfo__parser_t *parser,
+                            const char *input,
+                            apr_pool_t *scratch_pool);
+
+/* A compact form of a canonical rangelist: an array of svn_merge_range_t
+   stored by value rather than by pointer, sorted, non-overlapping and with
+   adjacent ranges always differing in inheritability.  This avoids one
+   allocation per range, and the set operations below work in a single
+   linear pass over both operands. */
+typedef apr_array_header_t svn_rangelist__compact_t;
+
+/* Return the compact form of RANGELIST, which must describe only forward
+   ranges.  If RANGELIST is not canonical, overlapping ranges are combined
+   as svn_rangelist_merge2() would do.  Allocate the result in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_rangelist__compact_t *
+svn_rangelist__compact(const svn_rangelist_t *rangelist,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Return the canonical rangelist equivalent to COMPACT, allocated in
+   RESULT_POOL. */
+svn_rangelist_t *
+svn_rangelist__expand(const svn_rangelist__compact_t *compact,
+                      apr_pool_t *result_pool);
+
+/* Return the union of the compact rangelists RANGELIST1 and RANGELIST2,
+   allocated in RESULT_POOL.  Like svn_rangelist_merge2(), revisions
+   covered by an inheritable range in either input will be inheritable. */
+svn_rangelist__compact_t *
+svn_rangelist__compact_merge(const svn_rangelist__compact_t *rangelist1,
+                             const svn_rangelist__compact_t *rangelist2,
+                             apr_pool_t *result_pool);
+
+/* Like svn_rangelist_intersect() but for compact rangelists.  Allocate
+   the result in RESULT_POOL. */
+svn_rangelist__compact_t *
+svn_rangelist__compact_intersect(const svn_rangelist__compact_t *rangelist1,
+                                 const svn_rangelist__compact_t *rangelist2,
+                                 svn_boolean_t consider_inheritance,
+                                 apr_pool_t *result_pool);
+
+/* Like svn_rangelist_remove() but for compact rangelists.  Allocate the
+   result in RESULT_POOL. */
+svn_rangelist__compact_t *
+svn_rangelist__compact_remove(const svn_rangelist__compact_t *eraser,
+                              const svn_rangelist__compact_t *whiteboard,
+                              svn_boolean_t consider_inheritance,
+                              apr_pool_t *result_pool);
+
+/* Return a copy of COMPACT with all ranges' inheritability set to
+   INHERITABLE, allocated in RESULT_POOL. */
+svn_rangelist__compact_t *
+svn_rangelist__compact_set_inheritance(const svn_rangelist__compact_t *compact,
+                                       svn_boolean_t inheritable,
+                                       apr_pool_t *result_pool);
+
+/* Return the range in COMPACT that contains REV, or NULL if there is
+   none.  This uses a binary search. */
+const svn_merge_range_t *
+svn_rangelist__compact_find(const svn_rangelist__compact_t *compact,
+                            svn_revnum_t rev);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
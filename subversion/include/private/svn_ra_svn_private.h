@@ -141,6 +141,33 @@ svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn);
 
+/**
+ * Return a connection that appends everything written to it to @a buffer
+ * instead of sending it anywhere.  It uses the same capabilities and
+ * compression settings as @a conn, so the data can later be sent through
+ * @a conn with svn_ra_svn__write_buffer().  Reading from it never yields
+ * any data.  Writing more than @a max_size bytes fails with
+ * #SVN_ERR_RA_SVN_RESPONSE_SIZE; 0 means unlimited.
+ *
+ * The result does not modify @a conn and may be used from another thread
+ * than @a conn.  Allocate it in @a result_pool.
+ */
+svn_ra_svn_conn_t *
+svn_ra_svn__create_buffer_conn(svn_ra_svn_conn_t *conn,
+                               svn_stringbuf_t *buffer,
+                               apr_uint64_t max_size,
+                               apr_pool_t *result_pool);
+
+/**
+ * Send the @a data collected through a connection created with
+ * svn_ra_svn__create_buffer_conn() over @a conn.  The buffer connection
+ * must have been flushed before.  Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_buffer(svn_ra_svn_conn_t *conn,
+                         apr_pool_t *pool,
+                         const svn_stringbuf_t *data);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -220,6 +247,28 @@ svn_error_t *
 svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
                   apr_pool_t *pool);
 
+/** Methods for compressing the whole connection stream, as negotiated by
+ * the #SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4 and
+ * #SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD capabilities.
+ */
+typedef enum svn_ra_svn__compression_t
+{
+  svn_ra_svn__compression_lz4,
+  svn_ra_svn__compression_zstd
+} svn_ra_svn__compression_t;
+
+/** Flush @a conn and send and receive all further data on it as frames
+ * compressed with @a method.  Both sides must switch at the same point
+ * in the protocol.  Every flush produces a frame of its own, so data is
+ * never held back for better compression.
+ *
+ * Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               svn_ra_svn__compression_t method,
+                               apr_pool_t *pool);
+
 /** Write a tuple, using a printf-like interface.
  *
  * The format string @a fmt may contain:
@@ -360,12 +409,31 @@ svn_ra_svn__has_command(svn_boolean_t *has_command,
                         svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool);
 
+/** What svn_ra_svn__handle_command() found out about the command it
+ * handled.
+ */
+typedef struct svn_ra_svn__command_stats_t
+{
+  /** Name of the command as given in the command table.  NULL if no
+   * command from the table has been executed. */
+  const char *cmdname;
+
+  /** Time spent executing the command, not counting the time waiting
+   * for it to arrive. */
+  apr_interval_time_t duration;
+
+  /** Number of bytes received and sent while handling the command. */
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+} svn_ra_svn__command_stats_t;
+
 /** Accept a single command from @a conn and handle them according
  * to @a cmd_hash.  Command handlers will be passed @a conn, @a pool,
  * the parameters of the command, and @a baton.  @a *terminate will be
  * set if either @a error_on_disconnect is FALSE and the connection got
  * closed, or if the command being handled has the "terminate" flag set
- * in the command table.
+ * in the command table.  If @a stats is not NULL, fill it in even if
+ * an error gets returned.
  */
 svn_error_t *
 svn_ra_svn__handle_command(svn_boolean_t *terminate,
@@ -373,6 +441,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
                            void *baton,
                            svn_ra_svn_conn_t *conn,
                            svn_boolean_t error_on_disconnect,
+                           svn_ra_svn__command_stats_t *stats,
                            apr_pool_t *pool);
 
 /** Accept commands over the network and handle them according to @a
@@ -766,7 +835,9 @@ svn_ra_svn__write_cmd_get_file(svn_ra_svn_conn_t *conn,
                                svn_boolean_t stream);
 
 /** Send a "update" command over connection @a conn.
- * Use @a pool for allocations.
+ * Use @a pool for allocations.  If @a text_deltas is FALSE, ask the
+ * server to send empty text deltas; it must have the
+ * #SVN_RA_SVN_CAP_UPDATE_TEXT_DELTAS capability.
  *
  * @see #svn_ra_do_update3 for a description.
  */
@@ -778,7 +849,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry);
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas);
 
 /** Send a "switch" command over connection @a conn.
  * Use @a pool for allocations.
@@ -128,6 +128,58 @@ svn_repos__replay_ev2(svn_fs_root_t *root,
                       void *authz_read_baton,
                       apr_pool_t *scratch_pool);
 
+/**
+ * File name suffix of authz snapshots.  svn_repos_authz_read3() looks for
+ * a snapshot named like the authz file plus this suffix and uses it to
+ * skip the per-user rule filtering, if the snapshot matches the contents
+ * of the authz file.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_REPOS__AUTHZ_SNAPSHOT_SUFFIX ".snapshot"
+
+/**
+ * Compile the path rules in @a authz for all users named in it, for the
+ * anonymous user and for all other authenticated users, and write them
+ * to the snapshot file at @a path.  Rules get compiled for every
+ * repository mentioned in @a authz as well as for all other repositories.
+ *
+ * The snapshot is tied to the exact contents of the authz file (and the
+ * global groups file, if any) that @a authz has been read from with
+ * svn_repos_authz_read3().  It will simply be ignored once those change.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__authz_write_snapshot(svn_authz_t *authz,
+                                const char *path,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Return a new handle to the rules in @a authz, allocated in
+ * @a result_pool.  Unlike @a authz itself, the result may be used in
+ * another thread concurrently with @a authz because the per-user lookup
+ * state is not shared.  @a authz must outlive the result.
+ *
+ * @since New in 1.10.
+ */
+svn_authz_t *
+svn_repos__authz_share(const svn_authz_t *authz,
+                       apr_pool_t *result_pool);
+
+/**
+ * Return the identifier of the rules in @a authz, i.e. a hash over the
+ * contents of the authz and groups files it has been read from.  Authz
+ * objects with equal identifiers grant the same access.  Return @c NULL
+ * if @a authz has not been created by svn_repos_authz_read3().
+ *
+ * @since New in 1.10.
+ */
+const svn_membuf_t *
+svn_repos__authz_id(const svn_authz_t *authz);
+
 /**
  * Non-deprecated alias for svn_repos_get_logs4.
  *
@@ -151,6 +203,107 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
                            void *receiver_baton,
                            apr_pool_t *pool);
 
+/**
+ * Let the update report REPORT_BATON, as returned by
+ * svn_repos_begin_report3(), compute up to JOBS text deltas concurrently.
+ * The editor will still be driven in the usual order and from the thread
+ * calling svn_repos_finish_report() only.  The deltas buffered for the
+ * editor will not exceed MAX_BUFFER bytes in total; 0 selects a default.
+ * Larger deltas will simply be computed on the fly.
+ *
+ * JOBS values below 2 disable concurrent processing, which is also the
+ * default.  Without thread support in APR, this is a no-op.
+ *
+ * This must be called before svn_repos_finish_report().
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos__report_set_delta_jobs(void *report_baton,
+                                 int jobs,
+                                 apr_size_t max_buffer);
+
+/**
+ * Let the post-commit hooks that #SVN_REPOS_HOOK_ASYNC_OPTION makes
+ * asynchronous run in the background of this process from now on.
+ * Otherwise, every commit runs the queued hooks before it returns.
+ *
+ * Only long-running servers should call this, e.g. once at start-up.
+ * Short-lived processes might exit before the queued hooks complete.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__hook_queue_start(apr_pool_t *scratch_pool);
+
+/**
+ * Make a copy of @a plugin the hook plugin used for the library at the
+ * absolute path @a libpath, i.e. repositories whose hooks-env names that
+ * library will call @a plugin instead of loading it.  The baton of
+ * @a plugin must live as long as the process.
+ *
+ * This allows for testing hook plugins without a shared library.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__hook_plugin_register(const char *libpath,
+                                const svn_repos_hook_plugin_t *plugin,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Let the update report REPORT_BATON, as returned by
+ * svn_repos_begin_report3(), send the full contents of changed files as
+ * text delta windows that do not refer to the source, if SEND_FULLTEXTS
+ * is set.  This avoids computing deltas altogether, which pays off when
+ * the editor is local to the repository and bandwidth does not matter.
+ * The editor still receives valid deltas and needs no special support.
+ *
+ * Has no effect if the report does not send text deltas at all.  The
+ * default is FALSE.  This must be called before svn_repos_finish_report().
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos__report_set_send_fulltexts(void *report_baton,
+                                     svn_boolean_t send_fulltexts);
+
+/**
+ * Like svn_repos_list() but walk the sub-trees of the directories
+ * immediately below @a path using up to @a jobs worker threads.
+ * @a receiver and @a authz_read_func will still only be called from the
+ * calling thread.
+ *
+ * If @a ordered is set, the entries will be reported in the same order
+ * as svn_repos_list() does.  Otherwise, a sub-tree may be reported as
+ * soon as it has been listed; an entry will still be reported before
+ * anything below it.
+ *
+ * Concurrent processing requires @a root to be a revision root and
+ * @a depth to be #svn_depth_infinity.  In all other cases, for @a jobs
+ * values below 2 and without thread support in APR, this is the same
+ * as svn_repos_list().
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__list(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                svn_boolean_t path_info_only,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                int jobs,
+                svn_boolean_t ordered,
+                apr_pool_t *scratch_pool);
+
 /**
  * @defgroup svn_config_pool Configuration object pool API
  * @{
@@ -325,6 +478,93 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
                             svn_boolean_t content_length_always,
                             apr_pool_t *scratch_pool);
 
+/* Callback used by svn_repos__dump_fs_ranges() to obtain the output
+ * stream for the revision range START_REV to END_REV.  Set *STREAM to
+ * a writable stream allocated in RESULT_POOL.  It will be closed once
+ * all data of that range has been written to it.  BATON is the caller's
+ * context.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *
+(*svn_repos__dump_stream_func_t)(svn_stream_t **stream,
+                                 void *baton,
+                                 svn_revnum_t start_rev,
+                                 svn_revnum_t end_rev,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/* Like svn_repos_dump_fs4() but split the revisions START_REV to END_REV
+ * into consecutive ranges of RANGE_SIZE revisions each (a non-positive
+ * RANGE_SIZE means "one range for all") and write each range to its own
+ * stream, obtained from STREAM_FUNC with STREAM_BATON.
+ *
+ * Only the stream of the first range receives the dump file header.
+ * Therefore, concatenating all streams in order yields output that is
+ * byte-identical to that of svn_repos_dump_fs4() given the same
+ * parameters.
+ *
+ * If JOBS is larger than 1 and APR supports threads, up to JOBS ranges
+ * will be dumped concurrently into temporary files.  Regardless of JOBS,
+ * STREAM_FUNC, NOTIFY_FUNC and CANCEL_FUNC are only invoked from the
+ * calling thread and ranges get written in revision order.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__dump_fs_ranges(svn_repos_t *repos,
+                          svn_repos__dump_stream_func_t stream_func,
+                          void *stream_baton,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_revnum_t range_size,
+                          int jobs,
+                          svn_boolean_t incremental,
+                          svn_boolean_t use_deltas,
+                          svn_boolean_t include_revprops,
+                          svn_boolean_t include_changes,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
+/* Like svn_repos_load_fs5() but optimized for loading large amounts of
+ * revisions into REPOS.
+ *
+ * The dump stream will be read ahead by a separate thread (if supported)
+ * while the revisions get committed.  Instead of making every single
+ * commit durable, flush them to disk in groups of BATCH_REVS revisions.
+ * If CHECKPOINT_PATH is not NULL, record the latest revision from the
+ * dump stream that has been made durable in that file.  An existing
+ * checkpoint file will be used to resume an interrupted load: all dump
+ * stream revisions up to and including the one recorded will be skipped.
+ * If the repository has been modified since the checkpoint, return
+ * SVN_ERR_REPOS_BAD_ARGS.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__load_fs_bulk(svn_repos_t *repos,
+                        svn_stream_t *dumpstream,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        enum svn_repos_load_uuid uuid_action,
+                        const char *parent_dir,
+                        svn_boolean_t use_pre_commit_hook,
+                        svn_boolean_t use_post_commit_hook,
+                        svn_boolean_t validate_props,
+                        svn_boolean_t ignore_dates,
+                        int batch_revs,
+                        const char *checkpoint_path,
+                        svn_repos_notify_func_t notify_func,
+                        void *notify_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -204,6 +204,28 @@ svn_skel__parse_iprops(apr_array_header_t **iprops,
                        const svn_skel_t *skel,
                        apr_pool_t *result_pool);
 
+/* Like svn_skel__parse_proplist() but parse the `PROPLIST' skel from
+   the LEN bytes at DATA.  The property names and values get allocated
+   in a single copy of DATA in RESULT_POOL instead of individually.
+   Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_skel__parse_proplist_data(apr_hash_t **proplist_p,
+                              const char *data,
+                              apr_size_t len,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Like svn_skel__parse_iprops() but parse the `IPROPS' skel from the
+   LEN bytes at DATA.  Paths, property names and values get allocated
+   in a single copy of DATA in RESULT_POOL instead of individually.
+   Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_skel__parse_iprops_data(apr_array_header_t **iprops,
+                            const char *data,
+                            apr_size_t len,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /* Parse a `PROPLIST' SKEL looking for PROPNAME.  If PROPNAME is found
    then return its value in *PROVAL, allocated in RESULT_POOL. */
 svn_error_t *
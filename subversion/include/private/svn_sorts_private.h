@@ -80,6 +80,28 @@ svn_sort__array(apr_array_header_t *array,
                 int (*comparison_func)(const void *,
                                        const void *));
 
+/* Callback type for svn_sort__array_by_path().  Return the path to sort
+ * the array element at @a element by.
+ */
+typedef const char *(*svn_sort__path_func_t)(const void *element);
+
+/* Sort APR array @a array by the paths that @a path_func returns for its
+ * elements, in the order defined by svn_path_compare_paths().  The order
+ * of elements with equal paths is undefined.
+ *
+ * This uses a radix sort, which is much faster than svn_sort__array()
+ * for large arrays.  Very large arrays get sorted concurrently.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * svn_sort__array() and svn_sort__hash() use this function for large
+ * arrays when sorting with svn_sort_compare_paths() and
+ * svn_sort_compare_items_as_paths(), respectively.
+ */
+void
+svn_sort__array_by_path(apr_array_header_t *array,
+                        svn_sort__path_func_t path_func,
+                        apr_pool_t *scratch_pool);
+
 /* Return the lowest index at which the element @a *key should be inserted into
  * the array @a array, according to the ordering defined by @a compare_func.
  * The array must already be sorted in the ordering defined by @a compare_func.
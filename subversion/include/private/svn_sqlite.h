@@ -129,6 +129,48 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  apr_int32_t timeout,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
+/* Tuning options for svn_sqlite__open2().  A zero-initialized struct
+   gives the same behavior as svn_sqlite__open() with a TIMEOUT of 0. */
+typedef struct svn_sqlite__open_options_t
+{
+  /* Use write-ahead logging instead of a rollback journal.  Readers then
+     don't block writers and vice versa.  This requires shared memory
+     between all connections and will therefore be ignored for databases
+     on network file systems, as far as we can tell, and for read-only
+     connections.  Note that the journal mode is persistent: once a
+     database has been switched to WAL, SQLite versions before 3.7.0 can't
+     open it anymore until a connection without this option switched it
+     back. */
+  svn_boolean_t wal;
+
+  /* Access up to this many bytes of the database file through a memory
+     mapping instead of read() calls.  0 uses the SQLite default, which
+     usually disables memory mapping. */
+  apr_int64_t mmap_size;
+
+  /* Size of the page cache per connection in bytes.  0 uses the SQLite
+     default of about 2 MB. */
+  apr_int64_t cache_size;
+
+  /* Busy timeout in milliseconds, values <= 0 cause a Subversion default
+     to be used. */
+  apr_int32_t busy_timeout;
+
+  /* If set, retry busy databases after short, exponentially growing
+     sleeps instead of relying on SQLite's default busy handler.  The
+     latter sleeps for whole seconds if SQLite has been built without
+     usleep() support and is always coarse for short transactions. */
+  svn_boolean_t busy_backoff;
+} svn_sqlite__open_options_t;
+
+/* Like svn_sqlite__open() but use the tuning OPTIONS, which may be NULL
+   for the defaults, instead of just a busy timeout. */
+svn_error_t *
+svn_sqlite__open2(svn_sqlite__db_t **db, const char *path,
+                  svn_sqlite__mode_t mode, const char * const statements[],
+                  const svn_sqlite__open_options_t *options,
+                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
+
 /* Explicitly close the connection in DB. */
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
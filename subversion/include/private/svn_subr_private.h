@@ -122,6 +122,25 @@ svn_spillbuf__get_filename(const svn_spillbuf_t *buf);
 apr_file_t *
 svn_spillbuf__get_file(const svn_spillbuf_t *buf);
 
+/* Set whether BUF reads spilled content through a memory map of the spill
+   file instead of copying it into memory blocks.  Blocks returned by
+   svn_spillbuf__read() or passed to svn_spillbuf_read_t will then point
+   directly into the map.  They still are at most BLOCKSIZE bytes long.
+
+   This is a no-op if the platform does not support memory maps.  Should
+   mapping fail at runtime, BUF silently falls back to reading the file.  */
+void
+svn_spillbuf__set_read_mapped(svn_spillbuf_t *buf,
+                              svn_boolean_t read_mapped);
+
+/* Return a suggested MAXSIZE for spill buffers that scales with the
+   amount of physical memory of this machine but is at least MIN_SIZE and
+   at most MAX_SIZE.  If the amount of memory cannot be determined, return
+   MIN_SIZE.  */
+apr_size_t
+svn_spillbuf__adaptive_maxsize(apr_size_t min_size,
+                               apr_size_t max_size);
+
 /* Write some data into the spill buffer.  */
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
@@ -212,6 +231,36 @@ svn_spillbuf__reader_write(svn_spillbuf_reader_t *reader,
                            apr_pool_t *scratch_pool);
 
 
+/* Create a spill-buffer and a reader for it, using the same arguments as
+   svn_spillbuf__create_extended().  */
+svn_spillbuf_reader_t *
+svn_spillbuf__reader_create_extended(apr_size_t blocksize,
+                                     apr_size_t maxsize,
+                                     svn_boolean_t delete_on_close,
+                                     svn_boolean_t spill_all_contents,
+                                     const char* dirpath,
+                                     apr_pool_t *result_pool);
+
+
+/* Return all content not yet read from @a reader as a single contiguous
+   buffer in @a *data of @a *len bytes.
+
+   If @a reader has been created with @a spill_all_contents set, its
+   content has been spilled to disk and nothing has been read from it yet,
+   the spill file will be mapped into memory instead of being copied.
+   Otherwise, the data is copied into a buffer allocated in @a result_pool.
+   In both cases, @a *data remains valid until @a result_pool and the
+   pool of @a reader get cleared.
+
+   Afterwards, @a reader must not be read from or written to anymore.  */
+svn_error_t *
+svn_spillbuf__reader_map(const char **data,
+                         apr_size_t *len,
+                         svn_spillbuf_reader_t *reader,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+
 /* Return a stream built on top of a spillbuf.
 
    This stream can be used for reading and writing, but implements the
@@ -295,6 +344,69 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
                                            svn_stream_t *inner_stream,
                                            apr_pool_t *pool);
 
+/**
+ * Context calculating the MD5 and the SHA-1 checksum of the same data
+ * in a single pass over it.
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_checksum__md5_sha1_ctx_t svn_checksum__md5_sha1_ctx_t;
+
+/**
+ * Return a new MD5 + SHA-1 checksum context, allocated in @a result_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(apr_pool_t *result_pool);
+
+/**
+ * Reset @a ctx as if it had just been created.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_checksum__md5_sha1_ctx_reset(svn_checksum__md5_sha1_ctx_t *ctx);
+
+/**
+ * Add the @a len bytes at @a data to both checksums in @a ctx.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len);
+
+/**
+ * Finalize @a ctx and return its checksums in @a *md5_checksum and
+ * @a *sha1_checksum, allocated in @a result_pool.  @a ctx must be reset
+ * before it can be used again.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_checksum__md5_sha1_final(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *result_pool);
+
+/**
+ * Like svn_checksum__wrap_write_stream() but calculate both, the MD5 and
+ * the SHA-1 checksum, in a single pass.  Write them to @a *md5_checksum
+ * and @a *sha1_checksum when the returned stream gets closed.
+ *
+ * The returned stream also supports #svn_stream_reset if @a inner_stream
+ * does.
+ *
+ * @since New in 1.10.
+ */
+svn_stream_t *
+svn_checksum__wrap_write_stream_md5_sha1(svn_checksum_t **md5_checksum,
+                                         svn_checksum_t **sha1_checksum,
+                                         svn_stream_t *inner_stream,
+                                         apr_pool_t *pool);
+
 /**
  * Return a 32 bit FNV-1a checksum for the first @a len bytes in @a input.
  *
@@ -316,6 +428,19 @@ svn__fnv1a_32(const void *input, apr_size_t len);
 apr_uint32_t
 svn__fnv1a_32x4(const void *input, apr_size_t len);
 
+/**
+ * Return a 64 bit hash value for the first @a len bytes in @a input,
+ * using @a seed to select one from a family of hash functions.
+ *
+ * @note This is a fast, non-cryptographic hash function for hash tables
+ *       and cache keys.  Its values depend on the machine's byte order,
+ *       so they must not be stored or transmitted.
+ *
+ * @since New in 1.10.
+ */
+apr_uint64_t
+svn__hash64(const void *input, apr_size_t len, apr_uint64_t seed);
+
 /** @} */
 
 
@@ -380,6 +505,16 @@ svn_hash__get_bool(apr_hash_t *hash,
 apr_hash_t *
 svn_hash__make(apr_pool_t *pool);
 
+/** Like svn_hash__make() but use svn__hash64() as hash function.  This
+ * scales better with long keys and many entries but iterates over the
+ * elements in a different order.  Use it for tables whose iteration
+ * order does not matter.
+ *
+ * @since New in 1.10.
+ */
+apr_hash_t *
+svn_hash__make_fast(apr_pool_t *pool);
+
 /** @} */
 
 /**
@@ -428,6 +563,26 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                      svn_boolean_t incremental,
                      apr_pool_t *pool);
 
+/** Like svn_hash_read2() but parse the serialized hash from the @a len
+ * bytes at @a data instead of a stream.  If @a terminator is #NULL, the
+ * hash ends with @a data.  Otherwise, anything after @a terminator gets
+ * ignored.
+ *
+ * The parsing is done in-place:  The newlines following keys and values
+ * in @a data get replaced with NULs and the keys and #svn_string_t values
+ * added to @a hash point into @a data.  Hence, @a data must remain valid
+ * as long as @a hash is in use.  Only the #svn_string_t structs get
+ * allocated in @a pool.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool);
+
 /** @} */
 
 /** @} */
@@ -591,6 +746,29 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Return TRUE if this build supports Zstandard compression, i.e. if the
+ * two functions below may be used.
+ */
+svn_boolean_t
+svn__zstd_available(void);
+
+/* Same as svn__compress_zlib(), but use Zstandard compression at the
+ * given COMPRESSION_LEVEL.  Return SVN_ERR_UNSUPPORTED_FEATURE if Zstandard
+ * support has not been compiled in.
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level);
+
+/* Same as svn__decompress_zlib(), but use Zstandard compression.  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if Zstandard support has not been compiled in.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit);
+
 /** @} */
 
 /**
@@ -618,12 +796,47 @@ apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools);
 
 /* Clear and release the given root POOL and put it back into POOLS.
- * If that fails, destroy POOL.
+ * POOL goes into the calling thread's cache if that is empty and into
+ * the shared list of unused pools otherwise.  If that fails or the shared
+ * list is full, destroy POOL.
  */
 void
 svn_root_pools__release_pool(apr_pool_t *pool,
                              svn_root_pools__t *pools);
 
+/* Usage statistics of a svn_root_pools__t container. */
+typedef struct svn_root_pools__info_t
+{
+  /* Number of svn_root_pools__acquire_pool() calls. */
+  apr_size_t acquired;
+
+  /* Number of those served from the calling thread's cache. */
+  apr_size_t thread_cache_hits;
+
+  /* Number of those served from the shared list of unused pools. */
+  apr_size_t shared_hits;
+
+  /* Number of released pools that got destroyed because the shared list
+   * was full. */
+  apr_size_t destroyed;
+
+  /* Number of unused pools currently in per-thread caches. */
+  apr_size_t thread_cached;
+
+  /* Number of unused pools currently in the shared list. */
+  apr_size_t shared;
+
+  /* Upper limit of the memory retained by the free lists of all unused
+   * pools, in bytes.  Each pool keeps a small initial block on top. */
+  apr_size_t retained_limit;
+} svn_root_pools__info_t;
+
+/* Return the current usage statistics of POOLS in *INFO.
+ */
+svn_error_t *
+svn_root_pools__get_info(svn_root_pools__info_t *info,
+                         svn_root_pools__t *pools);
+
 /** @} */
 
 /**
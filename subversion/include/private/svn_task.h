@@ -0,0 +1,153 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_task.h
+ * @brief Run independent pieces of work concurrently
+ *
+ * A task set executes the tasks added to it on worker threads and hands
+ * their results back to the thread that owns the set, in the order the
+ * tasks have been added.  Hence, the output stays deterministic while
+ * the processing runs in parallel.
+ *
+ * All task sets share one process-wide pool of worker threads, so the
+ * total number of threads stays bounded no matter how many subsystems
+ * (or nested task sets) are active.  While waiting for results, the
+ * owner of a set executes its pending tasks itself.  Thus, progress is
+ * guaranteed even if all workers are busy, e.g. with tasks that wait
+ * for their own nested task sets.
+ *
+ * Without thread support, or if the thread limit has been set to 0,
+ * all tasks get executed by the owner when they are added.
+ */
+
+#ifndef SVN_TASK_H
+#define SVN_TASK_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Opaque type of a task set. */
+typedef struct svn_task__set_t svn_task__set_t;
+
+/** Callback that does the actual work of a task.  It may run on any
+ * thread, concurrently with other tasks of the same set.
+ *
+ * @a process_baton is the baton given to svn_task__add().  Set
+ * @a *result to the value to pass to the set's output function and
+ * allocate it in @a result_pool.  Use @a scratch_pool for temporary
+ * allocations.  Both pools belong to this task alone.
+ *
+ * Long running tasks should call @a cancel_func with @a cancel_baton
+ * regularly.  It reports cancellation of the task set as well as by
+ * the user.
+ */
+typedef svn_error_t *
+(*svn_task__process_func_t)(void **result,
+                            void *process_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/** Callback that consumes the @a result of a task.  It is called by the
+ * thread that owns the task set, in the order in which the tasks have
+ * been added.  @a output_baton is the baton given to
+ * svn_task__set_create().  @a result and any other allocations in
+ * @a scratch_pool get released after the call returns.
+ */
+typedef svn_error_t *
+(*svn_task__output_func_t)(void *result,
+                           void *output_baton,
+                           apr_pool_t *scratch_pool);
+
+/** Create a task set in @a *set that runs its tasks on up to
+ * @a max_threads worker threads at the same time.  0 means no specific
+ * limit, i.e. the set may use all threads of the process-wide worker
+ * pool.
+ *
+ * The result of each task will be passed to @a output_func with
+ * @a output_baton.  @a output_func may be @c NULL.
+ *
+ * Tasks will be cancelled when @a cancel_func, which may be called from
+ * any thread, returns an error.  @a cancel_func may be @c NULL.
+ *
+ * The task set lives in @a result_pool.  Destroying that pool cancels
+ * all outstanding tasks and waits for those that are already running.
+ * Therefore, it is safe to simply return upon errors.
+ */
+svn_error_t *
+svn_task__set_create(svn_task__set_t **set,
+                     int max_threads,
+                     svn_task__output_func_t output_func,
+                     void *output_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool);
+
+/** Add a task to @a set that calls @a process_func with @a process_baton.
+ * The latter must remain valid until the task has been processed.
+ *
+ * This also passes the results of all tasks that have been completed so
+ * far on to the output function.  To limit the number of results kept
+ * in memory, it may have to wait for some tasks to complete.
+ *
+ * If an earlier task or the output function returned an error, return
+ * that error and cancel all outstanding tasks of @a set.
+ */
+svn_error_t *
+svn_task__add(svn_task__set_t *set,
+              svn_task__process_func_t process_func,
+              void *process_baton);
+
+/** Wait for all tasks of @a set to complete and pass their results on to
+ * the output function.  Return the first error returned by any task or
+ * the output function.  Failures to synchronize with the worker threads
+ * and cancellation get reported as errors as well rather than blocking
+ * the caller.
+ *
+ * After this returns successfully, more tasks may be added to @a set.
+ */
+svn_error_t *
+svn_task__set_finish(svn_task__set_t *set);
+
+/** Limit the process-wide number of worker threads to @a max_threads.
+ * With 0, all tasks will be executed in the threads that add them.
+ * The default is the number of CPU cores.
+ */
+void
+svn_task__set_thread_limit(int max_threads);
+
+/** Return the current process-wide limit for worker threads. */
+int
+svn_task__get_thread_limit(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TASK_H */
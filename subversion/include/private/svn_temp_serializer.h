@@ -48,6 +48,26 @@ struct svn_stringbuf_t;
  */
 #define SVN_TEMP_SERIALIZER__OVERHEAD (sizeof(svn_stringbuf_t) + 1)
 
+/**
+ * Upper limit for the number of bytes that serializing a structure of
+ * @a struct_size bytes adds to the serialization buffer, including
+ * alignment padding.  Together with #SVN_TEMP_SERIALIZER__STRING_SIZE,
+ * this allows for calculating a suggested_buffer_size parameter for
+ * #svn_temp_serializer__init that prevents all buffer re-allocations.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_TEMP_SERIALIZER__STRUCT_SIZE(struct_size) \
+  (APR_ALIGN_DEFAULT(struct_size) + APR_ALIGN_DEFAULT(1))
+
+/**
+ * The number of bytes that serializing the C string @a s adds to the
+ * serialization buffer.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_TEMP_SERIALIZER__STRING_SIZE(s) ((s) ? strlen(s) + 1 : 0)
+
 /**
  * Opaque structure controlling the serialization process and holding the
  * intermediate as well as final results.
@@ -0,0 +1,127 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_trace.h
+ * @brief Lightweight tracing of nested operations across layers
+ *
+ * A span covers one operation, e.g. an RA call, a repos report or an FS
+ * lookup.  It has a name, a start time, a duration and optional
+ * attributes.  Spans started while another one is active on the same
+ * thread are nested within it, so a trace shows where the time of e.g. a
+ * checkout went from RA down to the FS layer.
+ *
+ * Tracing is off until svn_trace__init() has been called.  Until then,
+ * starting a span costs a single flag check.  Finished spans are written
+ * in the Trace Event JSON format, which can be loaded into viewers such
+ * as chrome://tracing or Perfetto.  Multiple processes may append to the
+ * same trace file.
+ *
+ * Defining SVN_DISABLE_TRACING at compile time reduces all span functions
+ * to no-ops.
+ */
+
+#ifndef SVN_TRACE_H
+#define SVN_TRACE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Opaque type of a span.  A @c NULL span is valid and ignored. */
+typedef struct svn_trace__span_t svn_trace__span_t;
+
+/** Enable tracing for the whole process and append all spans finished
+ * from now on to the file at @a path, creating it if necessary.  Tracing
+ * ends when @a pool gets cleaned up.  Calls while tracing is already
+ * enabled are ignored.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if tracing has been disabled at
+ * compile time.
+ */
+svn_error_t *
+svn_trace__init(const char *path,
+                apr_pool_t *pool);
+
+#ifndef SVN_DISABLE_TRACING
+
+/** Return TRUE if spans are currently being recorded. */
+svn_boolean_t
+svn_trace__enabled(void);
+
+/** Start a new span called @a name and return it.  @a name must remain
+ * valid until the span ends, e.g. be a string literal.  Return @c NULL
+ * if tracing is not enabled.
+ */
+svn_trace__span_t *
+svn_trace__begin(const char *name);
+
+/** Add the attribute @a key with the string @a value to @a span.
+ * Attributes that don't fit into the span's buffer get dropped.
+ */
+void
+svn_trace__attr(svn_trace__span_t *span,
+                const char *key,
+                const char *value);
+
+/** Like svn_trace__attr() but for a numerical @a value. */
+void
+svn_trace__attr_int(svn_trace__span_t *span,
+                    const char *key,
+                    apr_int64_t value);
+
+/** End @a span, write it to the trace and release it.  If @a err is not
+ * @c NULL, record its error code in the span.  Return @a err.
+ */
+svn_error_t *
+svn_trace__end(svn_trace__span_t *span,
+               svn_error_t *err);
+
+#else
+
+#define svn_trace__enabled() FALSE
+#define svn_trace__begin(name) ((svn_trace__span_t *)NULL)
+#define svn_trace__attr(span, key, value) ((void)0)
+#define svn_trace__attr_int(span, key, value) ((void)0)
+#define svn_trace__end(span, err) ((void)(span), (err))
+
+#endif
+
+/** Evaluate @a expr, an expression returning an #svn_error_t *, within
+ * a span called @a name and return from the current function if it
+ * failed, like SVN_ERR() does.
+ */
+#define SVN_TRACE__ERR(name, expr)                                       \
+  do {                                                                   \
+    svn_trace__span_t *svn_trace__span = svn_trace__begin(name);         \
+    SVN_ERR(svn_trace__end(svn_trace__span, (expr)));                    \
+  } while (0)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TRACE_H */
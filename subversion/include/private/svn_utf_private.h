@@ -50,6 +50,18 @@ svn_utf__is_valid(const char *src, apr_size_t len);
 svn_boolean_t
 svn_utf__cstring_is_valid(const char *src);
 
+/* Return TRUE if the string SRC of length LEN consists of printable
+ * 7 bit ASCII characters and whitespace only, FALSE otherwise.
+ */
+svn_boolean_t
+svn_utf__is_plain_ascii(const char *src, apr_size_t len);
+
+/* Return a pointer to the first byte in the string SRC of length LEN
+ * that is not a 7 bit ASCII character, or SRC+LEN if there is none.
+ */
+const char *
+svn_utf__first_non_ascii(const char *src, apr_size_t len);
+
 /* Return a pointer to the first character after the last valid UTF-8
  * potentially multi-byte character in the string SRC of length LEN.
  * Validity of bytes from SRC to SRC+LEN-1, inclusively, is checked.
@@ -38,6 +38,7 @@
 #define SVN_WC_PRIVATE_H
 
 #include "svn_types.h"
+#include "svn_diff.h"
 #include "svn_wc.h"
 #include "private/svn_diff_tree.h"
 
@@ -348,6 +349,50 @@ svn_wc__get_wcroot(const char **wcroot_abspath,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool);
 
+/** Watch the working copy containing @a local_abspath for changes on
+ * disk until @a cancel_func returns an error, and return that error.
+ *
+ * While this runs, the working copy keeps a journal of the directories
+ * that changed, which lets svn_wc__walk_status_journaled() skip listing
+ * all other directories.  The first full status walk of the working copy
+ * after the watcher started primes the journal; the journal is discarded
+ * when the watcher stops.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if this is not supported on the
+ * current platform, and #SVN_ERR_WC_LOCKED if the working copy is already
+ * being watched.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__watch_changes(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool);
+
+/** Like svn_wc_walk_status() with @a ignore_text_mods set to FALSE, but
+ * don't read the directories from disk that the change journal of the
+ * working copy reports unchanged (see svn_wc__watch_changes()).
+ *
+ * The journal is only good enough for reporting status; don't use this
+ * to find out what to commit.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__walk_status_journaled(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_boolean_t no_ignore,
+                              const apr_array_header_t *ignore_patterns,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
 /**
  * The following are temporary APIs to aid in the transition from wc-1 to
  * wc-ng.  Use them for new development now, but they may be disappearing
@@ -697,6 +742,99 @@ svn_wc__call_with_write_lock(svn_wc__with_write_lock_func_t func,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/**
+ * Ensure that modifications of files made after this call are detected,
+ * like svn_io_sleep_for_timestamps() does for @a local_abspath, which may
+ * be NULL.
+ *
+ * Instead of sleeping, forget the recorded timestamps in the working
+ * copies opened through @a wc_ctx that such a modification might not
+ * change.  The next status check compares these files by content.
+ * Only sleep if that fails.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_wc__sleep_for_timestamps(svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             apr_pool_t *scratch_pool);
+
+/**
+ * Remove some of the pristine texts that are no longer referenced from the
+ * working copy containing @a local_abspath, and give some free space of its
+ * database back to the filesystem, for a short while at most.  Meant to be
+ * called after operations that leave unreferenced pristines behind, such as
+ * update and commit, so they don't pile up until the next
+ * svn_wc_cleanup4() with @c vacuum_pristines.
+ *
+ * Failing to clean up is not an error for the operation that completed,
+ * so errors are ignored; the next call or cleanup will try again.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_wc__cleanup_pristines_some(svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               apr_pool_t *scratch_pool);
+
+/**
+ * The text deltas of files to be committed.  While one file is being
+ * transmitted, worker threads already read and deltify the files queued
+ * after it, as configured by #SVN_CONFIG_OPTION_COMMIT_JOBS.
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_wc__text_deltas_t svn_wc__text_deltas_t;
+
+/**
+ * Set @a *deltas to a new, empty queue of text deltas for files in the
+ * working copies of @a wc_ctx, allocated in @a result_pool.  Its worker
+ * threads are terminated and untransmitted deltas are discarded when
+ * @a result_pool gets cleaned up.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__text_deltas_create(svn_wc__text_deltas_t **deltas,
+                           svn_wc_context_t *wc_ctx,
+                           apr_pool_t *result_pool);
+
+/**
+ * Queue @a local_abspath in @a deltas, to be transmitted with @a fulltext
+ * as in svn_wc_transmit_text_deltas3().  The file is not read yet.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__text_deltas_queue(svn_wc__text_deltas_t *deltas,
+                          const char *local_abspath,
+                          svn_boolean_t fulltext,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_wc_transmit_text_deltas3(), transmit the text of the file
+ * @a local_abspath queued in @a deltas through @a editor and @a file_baton.
+ * Files must be transmitted in the order they were queued.
+ *
+ * Before transmitting, start preparing the deltas of the files queued
+ * next, so that reading them overlaps with the transmission.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__text_deltas_transmit(const svn_checksum_t **new_text_base_md5_checksum,
+                             const svn_checksum_t **new_text_base_sha1_checksum,
+                             svn_wc__text_deltas_t *deltas,
+                             const char *local_abspath,
+                             const svn_delta_editor_t *editor,
+                             void *file_baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 /** Evaluate the expression @a expr while holding a write lock on
  * @a local_abspath.
  *
@@ -990,7 +1128,11 @@ svn_wc__node_get_md5_from_sha1(const svn_checksum_t **md5_checksum,
 /* Like svn_wc_get_pristine_contents2(), but keyed on the CHECKSUM
    rather than on the local absolute path of the working file.
    WRI_ABSPATH is any versioned path of the working copy in whose
-   pristine database we'll be looking for these contents.  */
+   pristine database we'll be looking for these contents.
+
+   If WRI_ABSPATH is NULL or its pristine store doesn't have the
+   contents, look for them in the content cache configured for
+   WC_CTX, if any.  */
 svn_error_t *
 svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           svn_wc_context_t *wc_ctx,
@@ -2062,6 +2204,36 @@ svn_wc__read_conflict_descriptions2_t(const apr_array_header_t **conflicts,
                                       apr_pool_t *result_pool,
                                       apr_pool_t *scratch_pool);
 
+/* Like svn_wc_merge5(), but if DIFF3 is not NULL, use it as the result
+   of svn_diff_file_diff3_2() over LEFT_ABSPATH, TARGET_ABSPATH and
+   RIGHT_ABSPATH with MERGE_OPTIONS instead of computing it, e.g. because
+   it has been computed ahead on another thread.  DIFF3 only gets used if
+   the text merge compares exactly these files, i.e. if the target needs
+   no detranslation. */
+svn_error_t *
+svn_wc__merge_with_diff3(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                         enum svn_wc_notify_state_t *merge_props_outcome,
+                         svn_wc_context_t *wc_ctx,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const svn_wc_conflict_version_t *left_version,
+                         const svn_wc_conflict_version_t *right_version,
+                         svn_boolean_t dry_run,
+                         const char *diff3_cmd,
+                         const apr_array_header_t *merge_options,
+                         apr_hash_t *original_props,
+                         const apr_array_header_t *prop_diff,
+                         svn_diff_t *diff3,
+                         svn_wc_conflict_resolver_func2_t conflict_func,
+                         void *conflict_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool);
+
 /* Internal version of svn_wc_translated_stream(), accepting a working
    copy context. */
 svn_error_t *
@@ -117,6 +117,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_LEVEL            "serf-log-level"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS       "svn-max-connections"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_ENABLE_HTTP2         "http-enable-http2"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_PROPERTY_CACHE_SIZE  "http-property-cache-size"
 
 
 #define SVN_CONFIG_CATEGORY_CONFIG          "config"
@@ -161,6 +167,16 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_CONFLICT_LOG_CACHE        "conflict-log-cache"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_LOG_CACHE                 "log-cache"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_EXPORT_JOBS               "export-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_EXTERNALS_JOBS            "externals-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_BLAME_JOBS                "blame-jobs"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +187,24 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_CONTENT_CACHE_DIR         "content-cache-dir"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_STATUS_JOBS               "status-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_COMPRESS_PRISTINES        "compress-pristines"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_INSTALL_JOBS              "install-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_COMMIT_JOBS               "commit-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL                "sqlite-wal"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "sqlite-mmap-size"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE         "sqlite-cache-size"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_BUSY_BACKOFF       "busy-backoff"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -235,6 +269,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_DEFAULT_OPTION_STORE_SSL_CLIENT_CERT_PP_PLAINTEXT \
                                                              SVN_CONFIG_ASK
 #define SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS       4
+/** @since New in 1.10. */
+#define SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS        1
 
 /** Read configuration information from the standard sources and merge it
  * into the hash @a *cfg_hash.  If @a config_dir is not NULL it specifies a
@@ -108,6 +108,12 @@ extern "C" {
  * @since New in 1.7.  */
 #define SVN_DAV_YOUNGEST_REV_HEADER "SVN-Youngest-Rev"
 
+/** Sent by mirrors (servers that proxy write requests to a master
+ * repository) with every response from a repository.  The value is the
+ * youngest revision that has been replicated to the mirror so far.
+ * @since New in 1.10.  */
+#define SVN_DAV_MIRROR_YOUNGEST_REV_HEADER "SVN-Mirror-Youngest-Rev"
+
 /** Assuming the OPTIONS was performed against a resource within a
  * Subversion repository, then this header indicates the UUID of the
  * repository.
@@ -413,6 +419,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM\
             SVN_DAV_PROP_NS_DAV "svn/put-result-checksum"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * a stat-many REPORT, i.e. stat several paths in a single request.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_DAV_NS_DAV_SVN_STAT_MANY\
+            SVN_DAV_PROP_NS_DAV "svn/stat-many"
+
 /** @} */
 
 /** @} */
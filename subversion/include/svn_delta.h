@@ -522,7 +522,9 @@ svn_txdelta_apply(svn_stream_t *source,
  *
  * @since New in 1.7.  Since 1.10, @a svndiff_version can be 2 for the
  * svndiff2 format.  @a compression_level is currently ignored if
- * @a svndiff_version is set to 2.
+ * @a svndiff_version is set to 2.  Also since 1.10, @a svndiff_version
+ * can be 3 for the Zstandard-based svndiff3 format, which is meant for
+ * repository storage only and requires a build with Zstandard support.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
@@ -532,6 +534,26 @@ svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
                         int compression_level,
                         apr_pool_t *pool);
 
+/** Like svn_txdelta_to_svndiff3() but compress the windows on up to
+ * @a max_threads worker threads.  The output is identical to what
+ * svn_txdelta_to_svndiff3() would produce.
+ *
+ * Threads are only being used for svndiff versions other than 0 and
+ * once there is more than one window to encode.  If @a max_threads is
+ * less than 2 or APR has no thread support, this is equivalent to
+ * svn_txdelta_to_svndiff3().
+ *
+ * @since New in 1.10.
+ */
+void
+svn_txdelta_to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                void **handler_baton,
+                                svn_stream_t *output,
+                                int svndiff_version,
+                                int compression_level,
+                                int max_threads,
+                                apr_pool_t *pool);
+
 /** Similar to svn_txdelta_to_svndiff3(), but always using the SVN default
  * compression level (#SVN_DELTA_COMPRESSION_LEVEL_DEFAULT).
  *
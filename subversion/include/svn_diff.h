@@ -455,6 +455,26 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** The algorithm used to find the longest common subsequence of lines.
+ *
+ * @since New in 1.10.
+ */
+typedef enum svn_diff_file_algorithm_t
+{
+  /** The O(NP) algorithm by Wu, Manber, Myers and Miller.  It produces a
+   * minimal diff, but can be slow for large files with many similar
+   * lines. */
+  svn_diff_file_algorithm_myers,
+
+  /** Histogram diff: recursively anchor the diff on the least frequent
+   * common lines.  It is usually faster and often more readable than
+   * the minimal diff, but the result is not necessarily minimal.  Blocks
+   * without any sufficiently rare common line are compared with the
+   * minimal algorithm if they are small and treated as changed in their
+   * entirety otherwise, bounding the run time for pathological input. */
+  svn_diff_file_algorithm_histogram
+} svn_diff_file_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +507,21 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm used to match lines between the files.  The default
+   * is @c svn_diff_file_algorithm_myers.
+   *
+   * @since New in 1.10 */
+  svn_diff_file_algorithm_t algorithm;
+
+  /** If not 0, two-way diffs process the inputs in windows such that
+   * they need roughly no more than this many bytes of memory, regardless
+   * of the size of the inputs.  The resulting diff is still correct but
+   * may not be minimal around the window boundaries.  The default is 0,
+   * i.e. unlimited.
+   *
+   * @since New in 1.10 */
+  apr_size_t memory_limit;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +545,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --histogram @since New in 1.10.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
@@ -138,6 +138,7 @@
 #include <apr_tables.h>
 
 #include "svn_types.h"
+#include "svn_string.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -236,6 +237,25 @@ svn_relpath_join(const char *base,
                  const char *component,
                  apr_pool_t *result_pool);
 
+/** Like svn_dirent_join() but append @a component to the canonical
+ * dirent in @a dirent in place.  Reusing @a dirent for many joins
+ * avoids allocating a new result each time.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_dirent__join_append(svn_stringbuf_t *dirent,
+                        const char *component);
+
+/** Like svn_relpath_join() but append @a component to the canonical
+ * relpath in @a relpath in place.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_relpath__join_append(svn_stringbuf_t *relpath,
+                         const char *component);
+
 /** Gets the name of the specified canonicalized @a dirent as it is known
  * within its parent directory. If the @a dirent is root, return "". The
  * returned value will not have slashes in it.
@@ -492,6 +512,26 @@ const char *
 svn_relpath_canonicalize(const char *relpath,
                          apr_pool_t *result_pool);
 
+/** Like svn_dirent_canonicalize() but return @a dirent itself if it is
+ * canonical already.  Only a different result gets allocated in
+ * @a result_pool.
+ *
+ * @since New in 1.10.
+ */
+const char *
+svn_dirent__ensure_canonical(const char *dirent,
+                             apr_pool_t *result_pool);
+
+/** Like svn_relpath_canonicalize() but return @a relpath itself if it is
+ * canonical already.  Only a different result gets allocated in
+ * @a result_pool.
+ *
+ * @since New in 1.10.
+ */
+const char *
+svn_relpath__ensure_canonical(const char *relpath,
+                              apr_pool_t *result_pool);
+
 
 /** Return a new uri like @a uri, but transformed such that some types
  * of uri specification redundancies are removed.
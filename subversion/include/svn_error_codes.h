@@ -1477,6 +1477,16 @@ SVN_ERROR_START
              SVN_ERR_MISC_CATEGORY_START + 46,
              "LZ4 decompression failed")
 
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_COMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 47,
+             "Zstandard compression failed")
+
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_DECOMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 48,
+             "Zstandard decompression failed")
+
   /* command-line client errors */
 
   SVN_ERRDEF(SVN_ERR_CL_ARG_PARSING_ERROR,
@@ -140,6 +140,25 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS      "fsfs-cache-nodeprops"
 
+/** Enable / disable the cache warm-up for a FSFS repository.  If enabled,
+ * FSFS records which node revisions get read most often and periodically
+ * saves that list in the repository.  The first filesystem object opened
+ * for a repository in a process then preloads these nodes into the caches
+ * in a background thread.  Requires thread support.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_CACHE_WARMUP         "fsfs-cache-warmup"
+
+/** Enable / disable preloading the top-level directories of each new
+ * revision committed in this process into the caches of a FSFS
+ * repository.  This happens in a background thread.  Requires thread
+ * support.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT "fsfs-cache-warmup-on-commit"
+
 /** Enable / disable the FSFS format 7 "block read" feature.
  *
  * @since New in 1.9.
@@ -227,6 +246,74 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_NO_FLUSH_TO_DISK          "no-flush-to-disk"
 
+/** Maximum number of FSFS shards to pack concurrently.  The value is
+ * a decimal number.  Values less than 2 mean that shards get packed
+ * one after another.  Only svn_fs_pack2() uses this option.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_PACK_JOBS            "fsfs-pack-jobs"
+
+/** Maximum number of FSFS shards to verify concurrently.  The value is
+ * a decimal number.  Values less than 2 mean that shards get verified
+ * one after another.  Only svn_fs_verify() uses this option.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_VERIFY_JOBS          "fsfs-verify-jobs"
+
+/** Maximum number of FSFS rev / pack files to scan concurrently when
+ * gathering repository statistics.  The value is a decimal number.
+ * Values less than 2 mean that the files get scanned one after another.
+ * Only format 7 repositories support this.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_STATS_JOBS           "fsfs-stats-jobs"
+
+/** Maximum number of FSFS shards to scan concurrently when adding
+ * existing representations to the rep-cache.  The value is a decimal
+ * number.  Values less than 2 mean that the shards get scanned one
+ * after another.  Only svn_fs_build_rep_cache() uses this option and
+ * only format 7 repositories support it.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_BUILD_REP_CACHE_JOBS "fsfs-build-rep-cache-jobs"
+
+/** Maximum number of FSFS revision files to scan concurrently when
+ * recovering the node-id and copy-id counters of old format repositories.
+ * The value is a decimal number.  Values less than 2 mean that the files
+ * get scanned one after another.  Only svn_fs_recover2() uses this option.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_RECOVER_JOBS         "fsfs-recover-jobs"
+
+/** Enable the quick verification mode of FSFS recovery.  Before writing
+ * the new 'current' file, the revisions in the youngest unpacked shard get
+ * checked for readable root nodes and changed-paths lists and, in format 7
+ * repositories, for consistent indexes.  For old format repositories, the
+ * node-id and copy-id counters recorded in 'current' get trusted for the
+ * revisions up to the one it names, such that only younger revisions need
+ * to be scanned.  Only svn_fs_recover2() uses this option.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_QUICK_RECOVER        "fsfs-quick-recover"
+
+/** Number of revisions for which FSFS collects new rep-cache entries in
+ * memory before writing them to the rep-cache database in one go.  The
+ * value is a decimal number.  Values less than 2 mean that the entries
+ * get written after each commit.  This speeds up bulk loads but entries
+ * not written at the time the filesystem object gets closed or the
+ * process terminates will be missing from the rep-cache, reducing the
+ * effectiveness of rep-sharing.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_REP_CACHE_BATCH_REVS "fsfs-rep-cache-batch-revs"
+
 /** @} */
 
 
@@ -375,6 +462,61 @@ svn_fs_open(svn_fs_t **fs_p,
             apr_hash_t *fs_config,
             apr_pool_t *pool);
 
+/**
+ * A read-only handle to a filesystem that many threads may use at the
+ * same time to open views of it.  See svn_fs_open_shared().
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_fs_shared_t svn_fs_shared_t;
+
+/**
+ * Open the Subversion filesystem located in the directory @a path for
+ * use by multiple threads and return the handle in @a *shared_p.
+ * @a fs_config is interpreted as in svn_fs_open2() and applies to all
+ * views opened through the handle.  Allocate the handle in
+ * @a result_pool; it may be closed by clearing or destroying that pool.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * Unlike a filesystem object, the handle itself never changes after
+ * this function returned.  Any number of threads may call
+ * svn_fs_open_view() for it concurrently.
+ *
+ * @note The lifetime of @a fs_config must not be shorter than @a
+ * result_pool's.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_open_shared(svn_fs_shared_t **shared_p,
+                   const char *path,
+                   apr_hash_t *fs_config,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Return in @a *fs_p a new filesystem object for the filesystem behind
+ * @a shared, allocated in @a result_pool.  Use @a scratch_pool for
+ * temporary allocations.
+ *
+ * The result behaves exactly like an object returned by svn_fs_open2()
+ * for the same path and configuration.  In particular, only one thread
+ * may operate on it at once and it may be used for transactions and
+ * commits.  Back-ends that support this take the filesystem format and
+ * configuration from @a shared instead of reading them again, making
+ * this much cheaper than svn_fs_open2().  Others simply open the
+ * filesystem again.
+ *
+ * @note @a shared must remain open while the view is being used.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_open_view(svn_fs_t **fs_p,
+                 svn_fs_shared_t *shared,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
 /** The kind of action being taken by 'upgrade'.
  *
  * @since New in 1.9.
@@ -600,7 +742,9 @@ svn_fs_hotcopy(const char *src_path,
                apr_pool_t *pool);
 
 /** Perform any necessary non-catastrophic recovery on the Subversion
- * filesystem located at @a path.
+ * filesystem located at @a path.  Use the backend-specific configuration
+ * @a fs_config when opening the filesystem.  @a NULL is valid for all
+ * backends.
  *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
@@ -632,8 +776,25 @@ svn_fs_hotcopy(const char *src_path,
  * it's a fine idea to run recovery when the server process starts,
  * before it begins handling any requests.
  *
+ * @see #SVN_FS_CONFIG_FSFS_RECOVER_JOBS
+ * @see #SVN_FS_CONFIG_FSFS_QUICK_RECOVER
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_recover2(const char *path,
+                apr_hash_t *fs_config,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *pool);
+
+/**
+ * Like svn_fs_recover2 but with @a fs_config being set to NULL.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  * @since New in 1.5.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_recover(const char *path,
                svn_cancel_func_t cancel_func,
@@ -1710,6 +1871,24 @@ svn_error_t *
 svn_fs_path_change_get(svn_fs_path_change3_t **change,
                        svn_fs_path_change_iterator_t *iterator);
 
+/**
+ * Restrict @a iterator to the changes at or below @a path, i.e. have
+ * svn_fs_path_change_get() skip all others.  @a path must be a canonical
+ * fspath and remain valid as long as @a iterator is being used.
+ *
+ * Call this before the first call to svn_fs_path_change_get().
+ * Back-ends that keep an index over their changed paths lists will jump
+ * directly to the first matching change and stop once the last one has
+ * been reported, i.e. without reading the rest of the list.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_path_change_seek(svn_fs_path_change_iterator_t *iterator,
+                        const char *path,
+                        apr_pool_t *scratch_pool);
+
 
 /** Determine what has changed under a @a root.
  *
@@ -1769,6 +1948,28 @@ svn_fs_paths_changed(apr_hash_t **changed_paths_p,
                      svn_fs_root_t *root,
                      apr_pool_t *pool);
 
+/** Set @a *changed to #FALSE if it is known that no revision from
+ * @a start to @a end (inclusive) in @a fs changed @a path, any of its
+ * parents or anything below @a path.  Otherwise, set it to #TRUE.
+ * @a start may be larger than @a end.
+ *
+ * A #FALSE result implies that @a path has no history within that range,
+ * so callers such as 'svn log' may skip walking it.  A #TRUE result may be
+ * a false positive if the backend can't tell cheaply.  @a path need not
+ * exist in any of the revisions.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_subtree_changed(svn_boolean_t *changed,
+                       svn_fs_t *fs,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       apr_pool_t *scratch_pool);
+
 /** @} */
 
 
@@ -2844,6 +3045,44 @@ svn_fs_revision_proplist2(apr_hash_t **table_p,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/** The type of a callback function that receives the revision property
+ * lists for svn_fs_revision_proplist_range().  @a proplist is the entire
+ * property list of @a revision, as described for
+ * svn_fs_revision_proplist2().  @a proplist is allocated in
+ * @a scratch_pool, which will be cleared after the callback returns.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *
+(*svn_fs_revision_proplist_receiver_t)(void *baton,
+                                       svn_revnum_t revision,
+                                       apr_hash_t *proplist,
+                                       apr_pool_t *scratch_pool);
+
+/** Invoke @a receiver with @a receiver_baton for the property lists of
+ * all revisions from @a start to @a end (inclusive) in filesystem @a fs.
+ * If @a start is larger than @a end, report the revisions in descending
+ * order.  Otherwise, report them in ascending order.
+ *
+ * This is equivalent to calling svn_fs_revision_proplist2() for each
+ * revision in the range but may be much faster.  In particular in
+ * packed repositories, it reads each revprop pack only once.
+ *
+ * @a refresh has the same meaning as for svn_fs_revision_proplist2()
+ * and applies to the whole range.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_revision_proplist_range(svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_boolean_t refresh,
+                               svn_fs_revision_proplist_receiver_t receiver,
+                               void *receiver_baton,
+                               apr_pool_t *scratch_pool);
+
 /** Like svn_fs_revision_proplist2 but using @a pool for @a scratch_pool as
  * well as @a result_pool and setting @a refresh to #TRUE.
  *
@@ -3302,10 +3541,30 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
 
 /**
  * Possibly update the filesystem located in the directory @a path
- * to use disk space more efficiently.
+ * to use disk space more efficiently.  Use the backend-specific
+ * configuration @a fs_config when opening the filesystem.  @a NULL is
+ * valid for all backends.
  *
+ * @see #SVN_FS_CONFIG_FSFS_PACK_JOBS
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Like svn_fs_pack2 but with @a fs_config being set to NULL.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  * @since New in 1.6.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
@@ -3396,6 +3655,36 @@ svn_error_t *
 svn_fs_verify_root(svn_fs_root_t *root,
                    apr_pool_t *scratch_pool);
 
+/**
+ * Add the representations created in revisions @a start_rev to
+ * @a end_rev of the Subversion filesystem @a fs to the filesystem's
+ * rep-cache, unless they are already there.  Later commits may then
+ * share them.  This is useful for repositories that have been created
+ * with rep-sharing disabled or that lost their rep-cache.
+ *
+ * After processing a revision, call @a notify_func with
+ * @a notify_baton, if not @c NULL.  The revisions will be reported in
+ * ascending order.  If not @c NULL, call @a cancel_func with
+ * @a cancel_baton from time to time.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the filesystem does not
+ * support rep-sharing or has it disabled.
+ *
+ * @see #SVN_FS_CONFIG_FSFS_BUILD_REP_CACHE_JOBS
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_build_rep_cache(svn_fs_t *fs,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       svn_fs_progress_notify_func_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool);
+
 /** @} */
 
 /**
@@ -341,12 +341,60 @@ svn_io_temp_dir(const char **dir,
                 apr_pool_t *pool);
 
 
+/** Flags for svn_io_copy_file2().
+ *
+ * @defgroup svn_io_copy_file_flags Flags for svn_io_copy_file2()
+ * @{
+ */
+
+/** Set the permissions of the copy to match those of the source.
+ * @since New in 1.10. */
+#define SVN_IO_COPY_FILE_PERMS 0x0001
+
+/** Allow the copy to share its data blocks with the source on file
+ * systems that support this (reflinks / clones).  Subsequent changes to
+ * either file will not affect the other, but both will be affected by
+ * damage to the underlying storage.
+ * @since New in 1.10. */
+#define SVN_IO_COPY_FILE_CLONE 0x0002
+
+/** @} */
+
 /** Copy @a src to @a dst atomically, in a "byte-for-byte" manner.
  * Overwrite @a dst if it exists, else create it.  Both @a src and @a dst
- * are utf8-encoded filenames.  If @a copy_perms is TRUE, set @a dst's
- * permissions to match those of @a src.
+ * are utf8-encoded filenames.  @a flags is a combination of the
+ * @ref svn_io_copy_file_flags.
+ *
+ * Where the platform supports it, e.g. through copy_file_range() or
+ * sendfile(), the contents will be transferred by the operating system
+ * without passing them through user space buffers.  If @a flags contains
+ * #SVN_IO_COPY_FILE_CLONE, @a dst may also become a clone of @a src
+ * (FICLONE on Linux, clonefile() on Mac OS X).
+ *
+ * If @a cloned is not @c NULL, set @a *cloned to @c TRUE if @a dst is
+ * such a clone.  Its contents are then guaranteed to be identical to
+ * those of @a src without any data having been read or written, so
+ * callers may skip verifying them.  Otherwise, set @a *cloned to
+ * @c FALSE.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
  */
 svn_error_t *
+svn_io_copy_file2(const char *src,
+                  const char *dst,
+                  apr_int32_t flags,
+                  svn_boolean_t *cloned,
+                  apr_pool_t *scratch_pool);
+
+/** Similar to svn_io_copy_file2() but without support for cloning.
+ * @a copy_perms set corresponds to #SVN_IO_COPY_FILE_PERMS.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
+ */
+SVN_DEPRECATED
+svn_error_t *
 svn_io_copy_file(const char *src,
                  const char *dst,
                  svn_boolean_t copy_perms,
@@ -380,9 +428,9 @@ svn_io_copy_link(const char *src,
 
 /** Recursively copy directory @a src into @a dst_parent, as a new entry named
  * @a dst_basename.  If @a dst_basename already exists in @a dst_parent,
- * return error.  @a copy_perms will be passed through to svn_io_copy_file()
- * when any files are copied.  @a src, @a dst_parent, and @a dst_basename are
- * all utf8-encoded.
+ * return error.  @a copy_perms will be passed through to svn_io_copy_file2()
+ * as #SVN_IO_COPY_FILE_PERMS when any files are copied.  @a src,
+ * @a dst_parent, and @a dst_basename are all utf8-encoded.
  *
  * If @a cancel_func is non-NULL, invoke it with @a cancel_baton at
  * various points during the operation.  If it returns any error
@@ -1187,6 +1187,100 @@ svn_ra_list(svn_ra_session_t *session,
             void *receiver_baton,
             apr_pool_t *scratch_pool);
 
+/**
+ * Callback type to be used with svn_ra_get_files_batch().  It will be
+ * invoked once for every requested path, in the order of the request.
+ *
+ * @a path is the requested path, @a revision the revision it has been
+ * fetched from and @a kind its node kind.  If @a kind is
+ * @c svn_node_none, the path does not exist and @a props and @a dirents
+ * will be @c NULL.  Otherwise, @a props contains the node's properties
+ * if they have been requested and is @c NULL else.  For directories,
+ * @a dirents maps entry names to <tt>svn_dirent_t *</tt> if contents
+ * have been requested and is @c NULL for files.
+ *
+ * For files whose contents have been requested, the receiver may set
+ * @a *contents to a stream that the file's contents will be written to.
+ * That stream will be closed once all contents have been written.
+ * Setting @a *contents to @c NULL skips the contents.  For all other
+ * nodes, @a contents is @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations and gets cleared after the contents
+ * of the file have been written.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra_fetch_receiver_t)(void *baton,
+                                                const char *path,
+                                                svn_revnum_t revision,
+                                                svn_node_kind_t kind,
+                                                apr_hash_t *props,
+                                                apr_hash_t *dirents,
+                                                svn_stream_t **contents,
+                                                apr_pool_t *scratch_pool);
+
+/**
+ * Fetch all @a paths (<tt>const char *</tt>, relative to the URL in
+ * @a session) in @a revision and invoke @a receiver with @a receiver_baton
+ * for each of them, in order.  If @a revision is @c SVN_INVALID_REVNUM,
+ * use the HEAD revision at the time of the call for all paths.
+ *
+ * This is equivalent to calling svn_ra_check_path() followed by
+ * svn_ra_get_file() or svn_ra_get_dir2() for every path, but servers
+ * with the #SVN_RA_CAPABILITY_GET_FILES_BATCH capability will receive
+ * all requests at once and stream the responses back, saving a network
+ * round-trip per path.  For all other servers, this function falls back
+ * to individual requests.
+ *
+ * If @a want_props is set, report the nodes' properties.  If
+ * @a want_contents is set, report the contents of files and the entries
+ * of directories.  @a dirent_fields selects the fields to fill in for
+ * directory entries, see svn_ra_get_dir2().
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_get_files_batch(svn_ra_session_t *session,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       svn_boolean_t want_props,
+                       svn_boolean_t want_contents,
+                       apr_uint32_t dirent_fields,
+                       svn_ra_fetch_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+
+/**
+ * Stat all @a paths (<tt>const char *</tt>, relative to the URL in
+ * @a session) in @a revision.  Set @a *dirents to a hash mapping each of
+ * the @a paths that exist in @a revision to an #svn_dirent_t describing
+ * it.  Paths that do not exist are not contained in @a *dirents.  If
+ * @a revision is @c SVN_INVALID_REVNUM, use the HEAD revision at the time
+ * of the call for all paths.
+ *
+ * This is equivalent to calling svn_ra_stat() for every path, but servers
+ * with the #SVN_RA_CAPABILITY_STAT_MANY capability will answer all of
+ * them in a single request.  For all other servers, this function falls
+ * back to individual requests.  Use svn_ra_stat_many() instead of
+ * multiple svn_ra_check_path() calls, too: the node kind is part of the
+ * #svn_dirent_t.
+ *
+ * Allocate @a *dirents in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
 /**
  * Set @a *catalog to a mergeinfo catalog for the paths in @a paths.
  * If no mergeinfo is available, set @a *catalog to @c NULL.  The
@@ -1890,6 +1984,52 @@ svn_ra_get_file_revs(svn_ra_session_t *session,
                      void *handler_baton,
                      apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_ra_get_file_annotation().  It will be
+ * invoked for every line of the file, in order.
+ *
+ * @a line_no is the zero-based number of the line, @a revision is the
+ * revision in which the line was last changed and @a line contains the
+ * line's contents including its end-of-line marker, if any.  @a baton is
+ * the user-provided receiver baton.  @a scratch_pool may be used for
+ * temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra_annotate_receiver_t)(
+  void *baton,
+  apr_int64_t line_no,
+  svn_revnum_t revision,
+  const svn_string_t *line,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Let the server annotate the file at @a path in @a revision, i.e. find
+ * the revision that last changed each of its lines, and invoke @a receiver
+ * with @a receiver_baton for each line.  This is equivalent to a blame
+ * over the file's full history, without merge tracking and without
+ * ignoring whitespace or eol style changes, but only the final result
+ * gets transmitted.  Servers may cache these results.
+ *
+ * @a path is interpreted relative to the URL in @a session.  If @a
+ * revision is @c SVN_INVALID_REVNUM, use the HEAD revision.
+ *
+ * If the server does not have the #SVN_RA_CAPABILITY_FILE_ANNOTATION
+ * capability, return #SVN_ERR_UNSUPPORTED_FEATURE.  Callers can then
+ * fall back to svn_ra_get_file_revs2().
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_get_file_annotation(svn_ra_session_t *session,
+                           const char *path,
+                           svn_revnum_t revision,
+                           svn_ra_annotate_receiver_t receiver,
+                           void *receiver_baton,
+                           apr_pool_t *scratch_pool);
+
 /**
  * Lock each path in @a path_revs, which is a hash whose keys are the
  * paths to be locked, and whose values are the corresponding base
@@ -2240,6 +2380,30 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to annotate files, see
+ * svn_ra_get_file_annotation().
+ *
+ * @since New in 1.10.
+ */
+#define SVN_RA_CAPABILITY_FILE_ANNOTATION "file-annotation"
+
+/**
+ * The capability of a server to fetch many files and directories in one
+ * request, see svn_ra_get_files_batch().
+ *
+ * @since New in 1.10.
+ */
+#define SVN_RA_CAPABILITY_GET_FILES_BATCH "get-files-batch"
+
+/**
+ * The capability of a server to stat many paths in one request, see
+ * svn_ra_stat_many().
+ *
+ * @since New in 1.10.
+ */
+#define SVN_RA_CAPABILITY_STAT_MANY "stat-many"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
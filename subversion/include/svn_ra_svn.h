@@ -51,6 +51,8 @@ extern "C" {
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
+#define SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4 "compressed-stream-lz4"
+#define SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD "compressed-stream-zstd"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
 /* maps to SVN_RA_CAPABILITY_MERGEINFO: */
@@ -71,6 +73,14 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* maps to SVN_RA_CAPABILITY_FILE_ANNOTATION */
+#define SVN_RA_SVN_CAP_FILE_ANNOTATION "file-annotation"
+/* maps to SVN_RA_CAPABILITY_GET_FILES_BATCH */
+#define SVN_RA_SVN_CAP_GET_FILES_BATCH "get-files-batch"
+/* maps to SVN_RA_CAPABILITY_STAT_MANY */
+#define SVN_RA_SVN_CAP_STAT_MANY "stat-many"
+/* the update command accepts the text-deltas flag */
+#define SVN_RA_SVN_CAP_UPDATE_TEXT_DELTAS "update-text-deltas"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
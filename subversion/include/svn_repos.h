@@ -712,6 +712,10 @@ svn_repos_hotcopy(const char *src_path,
  * Possibly update the repository, @a repos, to use a more efficient
  * filesystem representation.  Use @a pool for allocations.
  *
+ * The filesystem configuration that @a repos has been opened with will
+ * be used for the pack operation as well, e.g. to pack multiple FSFS
+ * shards in parallel.  (Since 1.10)
+ *
  * @since New in 1.7.
  */
 svn_error_t *
@@ -740,8 +744,9 @@ svn_repos_fs_pack(svn_repos_t *repos,
 
 /**
  * Run database recovery procedures on the repository at @a path,
- * returning the database to a consistent state.  Use @a pool for all
- * allocation.
+ * returning the database to a consistent state.  Pass the
+ * backend-specific configuration @a fs_config, which may be @c NULL,
+ * to svn_fs_recover2().  Use @a pool for all allocation.
  *
  * Acquires an exclusive lock on the repository, recovers the
  * database, and releases the lock.  If an exclusive lock can't be
@@ -763,8 +768,25 @@ svn_repos_fs_pack(svn_repos_t *repos,
  * by a single threaded process, or by a multi-threaded process when
  * no other threads are accessing the repository.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_recover5(const char *path,
+                   apr_hash_t *fs_config,
+                   svn_boolean_t nonblocking,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void * cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_recover5(), but with @a fs_config set to @c NULL.
+ *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_recover4(const char *path,
                    svn_boolean_t nonblocking,
@@ -980,6 +1002,120 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
                        const char *hooks_env_path,
                        apr_pool_t *scratch_pool);
 
+/** The option in the hook environment configuration file (see
+ * svn_repos_hooks_setenv()) that names a hook plugin library.  Like
+ * environment variables, it may be set for individual hooks or in the
+ * default section.  Relative paths are relative to the repository's
+ * hook directory.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_REPOS_HOOK_PLUGIN_OPTION "SVN_HOOK_PLUGIN"
+
+/** The option in the hook environment configuration file (see
+ * svn_repos_hooks_setenv()) that makes the post-commit hook run
+ * asynchronously if set to "yes" in the [post-commit] or the default
+ * section.
+ *
+ * Commits then queue the hook run in the repository's db directory and
+ * run the queued hooks in revision order, retrying failed hooks a few
+ * times.  Long-running servers run the queue in the background, so that
+ * commits return without waiting for the hook; all other processes run
+ * it before the commit returns.  The queue survives process restarts;
+ * whatever a server did not get to before it exited gets run after the
+ * next commit to the repository.  Hooks that keep failing are kept in
+ * the queue directory with a ".failed" suffix for inspection and are not
+ * retried.
+ *
+ * Hook failures are never reported to the committing client.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_REPOS_HOOK_ASYNC_OPTION "SVN_HOOK_ASYNC"
+
+/** The name of the #svn_repos_hook_plugin_init_t function that a hook
+ * plugin library must export.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_REPOS_HOOK_PLUGIN_INIT "svn_repos_hook_plugin_init"
+
+/** Hook implementations provided by a hook plugin library.
+ *
+ * Unlike hook scripts, plugins run inside the server process and get
+ * direct access to the repository.  Each function pointer may be
+ * @c NULL if the plugin does not implement that hook.  A plugin hook
+ * is being called before the hook script of the same name, if any.
+ * Returning an error has the same effect as a hook script returning a
+ * non-zero exit code.
+ *
+ * The functions may be called concurrently from multiple threads, each
+ * with its own @a repos instance.  @a baton is the #baton member of
+ * this structure.  @a scratch_pool is for temporary allocations.
+ *
+ * @note Fields may be added to the end of this structure in future
+ * versions.  Therefore, plugins must not allocate this structure
+ * themselves but fill in the one given to their init function.
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_repos_hook_plugin_t
+{
+  /** Like the start-commit hook script. */
+  svn_error_t *(*start_commit)(svn_repos_t *repos,
+                               const char *user,
+                               const apr_array_header_t *capabilities,
+                               const char *txn_name,
+                               void *baton,
+                               apr_pool_t *scratch_pool);
+
+  /** Like the pre-commit hook script.  @a txn is the transaction about
+   * to be committed.  @a lock_tokens maps the lock tokens supplied by
+   * the client to their paths; it may be @c NULL. */
+  svn_error_t *(*pre_commit)(svn_repos_t *repos,
+                             svn_fs_txn_t *txn,
+                             apr_hash_t *lock_tokens,
+                             void *baton,
+                             apr_pool_t *scratch_pool);
+
+  /** Like the post-commit hook script. */
+  svn_error_t *(*post_commit)(svn_repos_t *repos,
+                              svn_revnum_t rev,
+                              const char *txn_name,
+                              void *baton,
+                              apr_pool_t *scratch_pool);
+
+  /** Like the pre-lock hook script.  Set @a *token to the lock token to
+   * use or to @c NULL to let the filesystem generate one.  Allocate it
+   * in @a result_pool. */
+  svn_error_t *(*pre_lock)(const char **token,
+                           svn_repos_t *repos,
+                           const char *path,
+                           const char *username,
+                           const char *comment,
+                           svn_boolean_t steal_lock,
+                           void *baton,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+  /** Plugin-specific data passed to the functions above. */
+  void *baton;
+} svn_repos_hook_plugin_t;
+
+/** The function exported by hook plugin libraries as
+ * #SVN_REPOS_HOOK_PLUGIN_INIT.  It is called once per process and
+ * library, with all members of @a plugin set to @c NULL.  Fill in
+ * @a plugin and allocate any data that must live as long as the process
+ * in @a pool.  @a loader_version is the version of the loading
+ * libsvn_repos.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_repos_hook_plugin_init_t)(
+  svn_repos_hook_plugin_t *plugin,
+  const svn_version_t *loader_version,
+  apr_pool_t *pool);
+
 /** @} */
 
 /* ---------------------------------------------------------------*/
@@ -2439,6 +2575,60 @@ svn_repos_get_file_revs(svn_repos_t *repos,
                         void *handler_baton,
                         apr_pool_t *pool);
 
+/**
+ * Callback type for use with svn_repos_get_file_annotation().  It will be
+ * invoked for every line of the file, in order.
+ *
+ * @a line_no is the zero-based number of the line, @a revision is the
+ * revision in which the line was last changed and @a line contains the
+ * line's contents including its end-of-line marker, if any.  @a baton is
+ * the user-provided receiver baton.  @a scratch_pool may be used for
+ * temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_repos_annotate_receiver_t)(
+  void *baton,
+  apr_int64_t line_no,
+  svn_revnum_t revision,
+  const svn_string_t *line,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Annotate each line of the file @a path in @a repos as seen in @a
+ * revision with the revision that last changed it and invoke @a receiver
+ * with @a receiver_baton for each line.
+ *
+ * The history of @a path, including copies, is followed back to its
+ * origin.  If optional @a authz_read_func is non-NULL, then use it
+ * (along with optional @a authz_read_baton) to check the readability of
+ * each step in the history.  Like svn_repos_get_file_revs2(), stop at
+ * the first unreadable step, so it will appear as if @a path had been
+ * added without history after it.
+ *
+ * Unless @a authz_read_func is given, the line-to-revision maps computed
+ * along the way are kept in the process-global cache, keyed by the node's
+ * path and revision, so that later calls only need to process the history
+ * added since then.  Lines
+ * are compared exactly, i.e. without ignoring whitespace or eol styles.
+ *
+ * If @a cancel_func is not @c NULL, it will be called with @a cancel_baton
+ * as usual.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_get_file_annotation(svn_repos_t *repos,
+                              const char *path,
+                              svn_revnum_t revision,
+                              svn_repos_authz_func_t authz_read_func,
+                              void *authz_read_baton,
+                              svn_repos_annotate_receiver_t receiver,
+                              void *receiver_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
 
 /* ---------------------------------------------------------------*/
 
@@ -3155,6 +3345,13 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * file context reconstruction and verification.  For FSFS format 7+ and
  * FSX, this allows for a very fast check against external corruption.
  *
+ * If @a jobs is larger than 1, verify up to @a jobs revisions concurrently
+ * using separate filesystem instances and let the backend check multiple
+ * shards concurrently as well (see #SVN_FS_CONFIG_FSFS_VERIFY_JOBS).  All
+ * notifications and calls to @a verify_callback still happen in the
+ * calling thread and in revision order.  @a cancel_func will only be
+ * called from the calling thread as well.
+ *
  * If @a verify_callback is not @c NULL, call it with @a verify_baton upon
  * receiving an FS-specific structure failure or a revision verification
  * failure.  Set @c revision callback argument to #SVN_INVALID_REVNUM or
@@ -3203,8 +3400,30 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -4140,6 +4359,32 @@ svn_repos_authz_check_access(svn_authz_t *authz,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool);
 
+/**
+ * Like svn_repos_authz_check_access() but check the @a required_access
+ * of @a user for all @a paths (const char *) at once.  Set the
+ * corresponding elements of @a access_granted, which must provide room
+ * for at least @a paths->nelts entries.
+ *
+ * The rules get filtered for @a user only once.  Paths that lie within
+ * the parent directory of the path checked before them continue from the
+ * state left behind by that lookup instead of starting again at the
+ * repository root.  Hence, the children of a directory as well as lists
+ * of paths sorted with svn_sort_compare_paths() will be checked much
+ * faster than through individual calls.
+ *
+ * Elements of @a paths may be NULL, see svn_repos_authz_check_access().
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_authz_check_access_many(svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  svn_boolean_t *access_granted,
+                                  apr_pool_t *pool);
+
 
 
 /** Revision Access Levels
@@ -26,6 +26,7 @@
 #include "client.h"
 
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_subst.h"
 #include "svn_string.h"
 #include "svn_error.h"
@@ -37,6 +38,7 @@
 #include "svn_hash.h"
 #include "svn_sorts.h"
 
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -52,19 +54,36 @@ struct rev
   const char *path;      /* the absolute repository path */
 };
 
-/* One chunk of blame */
+/* One chunk of blame.
+
+   While the blame information is being collected, the chunks of a chain
+   form a treap ordered by position: the position of a chunk is implied
+   by the total LENGTH of all chunks before it, so that finding, splitting
+   and shifting take O(log n) time instead of walking the whole chain.
+   Once all revisions have been processed, blame_chain_linearize() turns
+   the tree into a linked list with explicit START offsets. */
 struct blame
 {
   const struct rev *rev;    /* the responsible revision */
   apr_off_t start;          /* the starting diff-token (line) */
   struct blame *next;       /* the next chunk */
+
+  /* Tree links and data, used before linearization only. */
+  struct blame *left;       /* chunks before this one */
+  struct blame *right;      /* chunks after this one */
+  apr_off_t length;         /* number of tokens in this chunk */
+  apr_off_t size;           /* number of tokens in this subtree */
+  apr_uint32_t priority;    /* treap heap priority */
 };
 
 /* A chain of blame chunks */
 struct blame_chain
 {
+  struct blame *root;       /* tree of bounded blame chunks */
+  struct blame *tail;       /* the last chunk, extending up to EOF */
   struct blame *blame;      /* linked list of blame chunks */
   struct blame *avail;      /* linked list of free blame chunks */
+  apr_uint32_t seed;        /* state of the priority generator */
   struct apr_pool_t *pool;  /* Allocate members from this pool. */
 };
 
@@ -74,6 +93,19 @@ struct diff_baton {
   const struct rev *rev;
 };
 
+/* A temporary file holding the contents of one revision.  It is removed
+   once the last reference to it has been released.  References are only
+   taken and released on the main thread. */
+typedef struct blame_file_t
+{
+  /* Private pool of this file, removing it on cleanup. */
+  apr_pool_t *pool;
+  const char *path;
+  int refcount;
+} blame_file_t;
+
+typedef struct blame_differ_t blame_differ_t;
+
 /* The baton used for a file revision. Lives the entire operation */
 struct file_rev_baton {
   svn_revnum_t start_rev, end_rev;
@@ -81,8 +113,8 @@ struct file_rev_baton {
   const char *target;
   svn_client_ctx_t *ctx;
   const svn_diff_file_options_t *diff_options;
-  /* name of file containing the previous revision of the file */
-  const char *last_filename;
+  /* file containing the previous revision of the file */
+  blame_file_t *last_file;
   struct rev *last_rev;   /* the rev of the last modification */
   struct blame_chain *chain;      /* the original blame chain. */
   const char *repos_root_url;    /* To construct a url */
@@ -93,11 +125,11 @@ struct file_rev_baton {
   /* These are used for tracking merged revisions. */
   svn_boolean_t include_merged_revisions;
   struct blame_chain *merged_chain;  /* the merged blame chain. */
-  /* name of file containing the previous merged revision of the file */
-  const char *last_original_filename;
-  /* pools for files which may need to persist for more than one rev. */
-  apr_pool_t *filepool;
-  apr_pool_t *prevfilepool;
+  /* file containing the previous merged revision of the file */
+  blame_file_t *last_original_file;
+
+  /* Computes the diffs between revisions concurrently. */
+  blame_differ_t *differ;
 
   svn_boolean_t check_mime_type;
 
@@ -115,7 +147,7 @@ struct delta_baton {
   void *wrapped_baton;
   struct file_rev_baton *file_rev_baton;
   svn_stream_t *source_stream;  /* the delta source */
-  const char *filename;
+  blame_file_t *file;           /* the delta target */
   svn_boolean_t is_merged_revision;
   struct rev *rev;     /* the rev struct for the current revision */
 };
@@ -141,6 +173,17 @@ blame_create(struct blame_chain *chain,
   blame->rev = rev;
   blame->start = start;
   blame->next = NULL;
+  blame->left = NULL;
+  blame->right = NULL;
+  blame->length = 0;
+  blame->size = 0;
+
+  /* xorshift32 is good enough to keep the tree balanced. */
+  chain->seed ^= chain->seed << 13;
+  chain->seed ^= chain->seed >> 17;
+  chain->seed ^= chain->seed << 5;
+  blame->priority = chain->seed;
+
   return blame;
 }
 
@@ -153,31 +196,149 @@ blame_destroy(struct blame_chain *chain,
   chain->avail = blame;
 }
 
-/* Return the blame chunk that contains token OFF, starting the search at
-   BLAME. */
+/* Return the number of tokens in the tree BLAME. */
+#define BLAME_SIZE(blame) ((blame) ? (blame)->size : 0)
+
+/* Recalculate the SIZE of BLAME from its children. */
+static void
+blame_update(struct blame *blame)
+{
+  blame->size = BLAME_SIZE(blame->left) + blame->length
+              + BLAME_SIZE(blame->right);
+}
+
+/* Return a new chunk of LENGTH tokens associated with REV, to be inserted
+   into a tree of CHAIN. */
 static struct blame *
-blame_find(struct blame *blame, apr_off_t off)
+blame_create_chunk(struct blame_chain *chain,
+                   const struct rev *rev,
+                   apr_off_t length)
+{
+  struct blame *blame = blame_create(chain, rev, 0);
+  blame->length = length;
+  blame->size = length;
+
+  return blame;
+}
+
+/* Destroy all chunks in the tree BLAME. */
+static void
+blame_destroy_tree(struct blame_chain *chain,
+                   struct blame *blame)
 {
-  struct blame *prev = NULL;
   while (blame)
     {
-      if (blame->start > off) break;
-      prev = blame;
-      blame = blame->next;
+      struct blame *right = blame->right;
+      blame_destroy_tree(chain, blame->left);
+      blame_destroy(chain, blame);
+      blame = right;
     }
-  return prev;
 }
 
-/* Shift the start-point of BLAME and all subsequence blame-chunks
-   by ADJUST tokens */
+/* Split the tree BLAME such that *LEFT contains its first POS tokens and
+   *RIGHT the remainder.  A chunk that straddles POS gets split in two. */
 static void
-blame_adjust(struct blame *blame, apr_off_t adjust)
+blame_split(struct blame_chain *chain,
+            struct blame *blame,
+            apr_off_t pos,
+            struct blame **left,
+            struct blame **right)
 {
-  while (blame)
+  apr_off_t left_size;
+
+  if (!blame)
+    {
+      *left = *right = NULL;
+      return;
+    }
+
+  left_size = BLAME_SIZE(blame->left);
+  if (pos <= left_size)
+    {
+      blame_split(chain, blame->left, pos, left, &blame->left);
+      blame_update(blame);
+      *right = blame;
+    }
+  else if (pos >= left_size + blame->length)
+    {
+      blame_split(chain, blame->right, pos - left_size - blame->length,
+                  &blame->right, right);
+      blame_update(blame);
+      *left = blame;
+    }
+  else
+    {
+      /* The second half inherits the priority, which keeps the heap
+         property for the subtree that it takes over. */
+      struct blame *rest = blame_create_chunk(chain, blame->rev,
+                                              left_size + blame->length
+                                              - pos);
+      rest->priority = blame->priority;
+      rest->right = blame->right;
+      blame->right = NULL;
+      blame->length = pos - left_size;
+
+      blame_update(blame);
+      blame_update(rest);
+      *left = blame;
+      *right = rest;
+    }
+}
+
+/* Return the concatenation of the trees LEFT and RIGHT. */
+static struct blame *
+blame_merge(struct blame *left,
+            struct blame *right)
+{
+  if (!left)
+    return right;
+  if (!right)
+    return left;
+
+  if (left->priority >= right->priority)
+    {
+      left->right = blame_merge(left->right, right);
+      blame_update(left);
+      return left;
+    }
+  else
+    {
+      right->left = blame_merge(left, right->left);
+      blame_update(right);
+      return right;
+    }
+}
+
+/* Return the concatenation of the trees LEFT and RIGHT.  If the chunks
+   that meet at the seam are associated with the same revision, combine
+   them into one. */
+static struct blame *
+blame_join(struct blame_chain *chain,
+           struct blame *left,
+           struct blame *right)
+{
+  struct blame *last = left;
+  struct blame *first = right;
+
+  while (last && last->right)
+    last = last->right;
+  while (first && first->left)
+    first = first->left;
+
+  if (last && first && last->rev == first->rev)
     {
-      blame->start += adjust;
-      blame = blame->next;
+      struct blame *walk;
+      apr_off_t length = first->length;
+
+      blame_split(chain, right, length, &first, &right);
+      blame_destroy_tree(chain, first);
+
+      for (walk = left; walk; walk = walk->right)
+        walk->size += length;
+      last->length += length;
     }
+
+  return blame_merge(left, right);
 }
 
 /* Delete the blame associated with the region from token START to
@@ -187,37 +348,17 @@ blame_delete_range(struct blame_chain *chain,
                    apr_off_t start,
                    apr_off_t length)
 {
-  struct blame *first = blame_find(chain->blame, start);
-  struct blame *last = blame_find(chain->blame, start + length);
-  struct blame *tail = last->next;
+  struct blame *head, *middle, *tail;
+  apr_off_t size = BLAME_SIZE(chain->root);
 
-  if (first != last)
-    {
-      struct blame *walk = first->next;
-      while (walk != last)
-        {
-          struct blame *next = walk->next;
-          blame_destroy(chain, walk);
-          walk = next;
-        }
-      first->next = last;
-      last->start = start;
-      if (first->start == start)
-        {
-          *first = *last;
-          blame_destroy(chain, last);
-          last = first;
-        }
-    }
-
-  if (tail && tail->start == last->start + length)
-    {
-      *last = *tail;
-      blame_destroy(chain, tail);
-      tail = last->next;
-    }
+  /* Deletions from the unbounded tail chunk don't change anything. */
+  if (start >= size)
+    return SVN_NO_ERROR;
 
-  blame_adjust(tail, -length);
+  blame_split(chain, chain->root, start, &head, &tail);
+  blame_split(chain, tail, MIN(length, size - start), &middle, &tail);
+  blame_destroy_tree(chain, middle);
+  chain->root = blame_join(chain, head, tail);
 
   return SVN_NO_ERROR;
 }
@@ -230,29 +371,61 @@ blame_insert_range(struct blame_chain *chain,
                    apr_off_t start,
                    apr_off_t length)
 {
-  struct blame *head = chain->blame;
-  struct blame *point = blame_find(head, start);
-  struct blame *insert;
+  struct blame *head, *tail;
+  apr_off_t size = BLAME_SIZE(chain->root);
+
+  /* Inserting into the unbounded tail chunk splits it. */
+  if (start > size)
+    chain->root = blame_merge(chain->root,
+                              blame_create_chunk(chain, chain->tail->rev,
+                                                 start - size));
+
+  blame_split(chain, chain->root, start, &head, &tail);
+  chain->root = blame_merge(blame_merge(head,
+                                        blame_create_chunk(chain, rev,
+                                                           length)),
+                            tail);
+
+  return SVN_NO_ERROR;
+}
 
-  if (point->start == start)
+/* Append the chunks of the tree BLAME to the list at **NEXT_P, setting
+   their START offsets from *START onwards.  Update both. */
+static void
+blame_link(struct blame *blame,
+           struct blame ***next_p,
+           apr_off_t *start)
+{
+  while (blame)
     {
-      insert = blame_create(chain, point->rev, point->start + length);
-      point->rev = rev;
-      insert->next = point->next;
-      point->next = insert;
+      blame_link(blame->left, next_p, start);
+
+      blame->start = *start;
+      *start += blame->length;
+      **next_p = blame;
+      *next_p = &blame->next;
+
+      blame = blame->right;
     }
-  else
+}
+
+/* Convert the tree of CHAIN into the linked list CHAIN->BLAME.  No
+   further changes may be made through the tree afterwards. */
+static void
+blame_chain_linearize(struct blame_chain *chain)
+{
+  struct blame **next_p = &chain->blame;
+  apr_off_t start = 0;
+
+  blame_link(chain->root, &next_p, &start);
+  chain->root = NULL;
+
+  if (chain->tail)
     {
-      struct blame *middle;
-      middle = blame_create(chain, rev, start);
-      insert = blame_create(chain, point->rev, start + length);
-      middle->next = insert;
-      insert->next = point->next;
-      point->next = middle;
+      chain->tail->start = start;
+      chain->tail->next = NULL;
     }
-  blame_adjust(insert->next, length);
-
-  return SVN_NO_ERROR;
+  *next_p = chain->tail;
 }
 
 /* Callback for diff between subsequent revisions */
@@ -297,8 +470,8 @@ add_file_blame(const char *last_file,
 {
   if (!last_file)
     {
-      SVN_ERR_ASSERT(chain->blame == NULL);
-      chain->blame = blame_create(chain, rev, 0);
+      SVN_ERR_ASSERT(chain->tail == NULL);
+      chain->tail = blame_create(chain, rev, 0);
     }
   else
     {
@@ -318,7 +491,249 @@ add_file_blame(const char *last_file,
   return SVN_NO_ERROR;
 }
 
+
+/*** Diffing revisions on worker threads. ***/
+
+/* Default and maximum number of threads diffing revisions. */
+#define BLAME_DEFAULT_JOBS 4
+#define BLAME_MAX_JOBS 64
+
+/* Set *FILE to a new, empty temporary file with a single reference owned
+   by the caller and *STREAM to a stream writing to it.  Allocate the file's private pool
+   in PARENT_POOL. */
+static svn_error_t *
+blame_file_create(blame_file_t **file,
+                  svn_stream_t **stream,
+                  apr_pool_t *parent_pool)
+{
+  apr_pool_t *pool = svn_pool_create(parent_pool);
+  blame_file_t *bf = apr_pcalloc(pool, sizeof(*bf));
+
+  bf->pool = pool;
+  bf->refcount = 1;
+  SVN_ERR(svn_stream_open_unique(stream, &bf->path, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  *file = bf;
+
+  return SVN_NO_ERROR;
+}
+
+/* Take a reference to FILE and return it. */
+static blame_file_t *
+blame_file_ref(blame_file_t *file)
+{
+  file->refcount++;
+  return file;
+}
+
+/* Release a reference to FILE, which may be NULL, and remove the file
+   if that was the last one. */
+static void
+blame_file_release(blame_file_t *file)
+{
+  if (file && --file->refcount == 0)
+    svn_pool_destroy(file->pool);
+}
+
+/* The diff between two revisions, computed by diff_task() and added to
+   the blame chain by merge_diff(). */
+typedef struct blame_diff_job_t
+{
+  /* Attribute the differences between LAST_FILE and CUR_FILE to REV in
+     CHAIN.  If LAST_FILE is NULL, REV is responsible for all of CUR_FILE.
+     The job holds a reference to both files. */
+  blame_file_t *last_file;
+  blame_file_t *cur_file;
+  struct blame_chain *chain;
+  struct rev *rev;
+
+  /* The result of diff_task(). */
+  svn_diff_t *diff;
+
+  blame_differ_t *differ;
+} blame_diff_job_t;
+
+/* Diffs being computed on worker threads.  Their results are merged into
+   the blame chains in the order they were queued, on the main thread. */
+struct blame_differ_t
+{
+  /* Holds SET and the jobs.  It gets destroyed before the revision files
+     get removed, see cleanup_blame_differ(). */
+  apr_pool_t *pool;
+
+  /* NULL if the diffs are computed on the main thread. */
+  svn_task__set_t *set;
+
+  const svn_diff_file_options_t *diff_options;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Implements svn_task__process_func_t.  Compute the diff of the
+   blame_diff_job_t in PROCESS_BATON, if any, and return the job in
+   *RESULT.  This does not touch the blame chain and may run on any
+   thread. */
+static svn_error_t *
+diff_task(void **result,
+          void *process_baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  blame_diff_job_t *job = process_baton;
+
+  if (job->last_file)
+    SVN_ERR(svn_diff_file_diff_2(&job->diff, job->last_file->path,
+                                 job->cur_file->path,
+                                 job->differ->diff_options, result_pool));
+
+  *result = job;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Add the blame information computed
+   for the blame_diff_job_t in RESULT to its chain and release the job's
+   file references. */
+static svn_error_t *
+merge_diff(void *result,
+           void *output_baton,
+           apr_pool_t *scratch_pool)
+{
+  blame_diff_job_t *job = result;
+  blame_differ_t *differ = output_baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!job->last_file)
+    {
+      SVN_ERR_ASSERT(job->chain->tail == NULL);
+      job->chain->tail = blame_create(job->chain, job->rev, 0);
+    }
+  else
+    {
+      struct diff_baton diff_baton;
+
+      diff_baton.chain = job->chain;
+      diff_baton.rev = job->rev;
+
+      err = svn_diff_output2(job->diff, &diff_baton, &output_fns,
+                             differ->cancel_func, differ->cancel_baton);
+    }
+
+  blame_file_release(job->last_file);
+  blame_file_release(job->cur_file);
+
+  return svn_error_trace(err);
+}
+
+/* Merge the outstanding diffs of DIFFER into their blame chains.  Return
+   the error of the first failed job, if any. */
+static svn_error_t *
+release_diffs(blame_differ_t *differ)
+{
+  if (differ->set)
+    SVN_ERR(svn_task__set_finish(differ->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the diff between LAST_FILE and CUR_FILE on DIFFER, to attribute
+   the changes to REV in CHAIN.  LAST_FILE may be NULL in which case blame
+   is added for every line of CUR_FILE.  Return the error of an earlier
+   job that failed. */
+static svn_error_t *
+queue_diff_job(blame_differ_t *differ,
+               struct blame_chain *chain,
+               struct rev *rev,
+               blame_file_t *last_file,
+               blame_file_t *cur_file)
+{
+  blame_diff_job_t *job;
+  apr_pool_t *pool;
+  void *result;
+
+  job = apr_pcalloc(differ->pool, sizeof(*job));
+  job->last_file = last_file ? blame_file_ref(last_file) : NULL;
+  job->cur_file = blame_file_ref(cur_file);
+  job->chain = chain;
+  job->rev = rev;
+  job->differ = differ;
+
+  if (differ->set)
+    return svn_error_trace(svn_task__add(differ->set, diff_task, job));
+
+  pool = svn_pool_create(differ->pool);
+  SVN_ERR(diff_task(&result, job, differ->cancel_func, differ->cancel_baton,
+                    pool, pool));
+  SVN_ERR(merge_diff(result, differ, pool));
+  svn_pool_destroy(pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool pre-cleanup function cancelling the outstanding jobs of the
+   blame_differ_t in DATA.  This must run before the revision files get
+   removed together with their parent pool. */
+static apr_status_t
+cleanup_blame_differ(void *data)
+{
+  blame_differ_t *differ = data;
+
+  svn_pool_destroy(differ->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *DIFFER to a new differ comparing revisions with DIFF_OPTIONS,
+   using as many threads as configured in CTX.  Its outstanding jobs will
+   be cancelled when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+start_blame_differ(blame_differ_t **differ,
+                   const svn_diff_file_options_t *diff_options,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *result_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  blame_differ_t *bd;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_BLAME_JOBS,
+                             BLAME_DEFAULT_JOBS);
+  if (err || jobs < 1 || jobs > BLAME_MAX_JOBS)
+    {
+      svn_error_clear(err);
+      jobs = BLAME_DEFAULT_JOBS;
+    }
+
+  bd = apr_pcalloc(result_pool, sizeof(*bd));
+  bd->pool = svn_pool_create(result_pool);
+  bd->diff_options = diff_options;
+  bd->cancel_func = ctx->cancel_func;
+  bd->cancel_baton = ctx->cancel_baton;
+
+  /* Sub-pools get destroyed in reverse order of creation, i.e. the later
+     revision files would go before the task set. */
+  apr_pool_pre_cleanup_register(result_pool, bd, cleanup_blame_differ);
+
+  if (jobs > 1)
+    SVN_ERR(svn_task__set_create(&bd->set, (int)jobs, merge_diff, bd,
+                                 ctx->cancel_func, ctx->cancel_baton,
+                                 bd->pool));
+
+  *differ = bd;
+
+  return SVN_NO_ERROR;
+}
+
 /* Record the blame information for the revision in BATON->file_rev_baton.
+   The diffs against the previous revisions get queued on the differ,
+   such that the next revision can be received while they are being
+   computed.
  */
 static svn_error_t *
 update_blame(void *baton)
@@ -342,40 +757,28 @@ update_blame(void *baton)
     chain = frb->chain;
 
   /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+  SVN_ERR(queue_diff_job(frb->differ, chain, dbaton->rev,
+                         frb->last_file, dbaton->file));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
      line of history. */
   if (frb->include_merged_revisions && ! dbaton->is_merged_revision)
     {
-      apr_pool_t *tmppool;
-
-      SVN_ERR(add_file_blame(frb->last_original_filename,
-                             dbaton->filename, frb->chain, dbaton->rev,
-                             frb->diff_options,
-                             frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                             frb->currpool));
-
-      /* This filename could be around for a while, potentially, so
-         use the longer lifetime pool, and switch it with the previous one*/
-      svn_pool_clear(frb->prevfilepool);
-      tmppool = frb->filepool;
-      frb->filepool = frb->prevfilepool;
-      frb->prevfilepool = tmppool;
+      SVN_ERR(queue_diff_job(frb->differ, frb->chain, dbaton->rev,
+                             frb->last_original_file, dbaton->file));
 
-      frb->last_original_filename = apr_pstrdup(frb->filepool,
-                                                dbaton->filename);
+      /* This file could be around for a while, potentially, so keep a
+         reference to it. */
+      blame_file_release(frb->last_original_file);
+      frb->last_original_file = blame_file_ref(dbaton->file);
     }
 
   /* Prepare for next revision. */
 
-  /* Remember the file name so we can diff it with the next revision. */
-  frb->last_filename = dbaton->filename;
+  /* Remember the file so we can diff it with the next revision. */
+  blame_file_release(frb->last_file);
+  frb->last_file = dbaton->file;
 
   /* Switch pools. */
   {
@@ -436,7 +839,6 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   svn_stream_t *last_stream;
   svn_stream_t *cur_stream;
   struct delta_baton *delta_baton;
-  apr_pool_t *filepool;
 
   /* Clear the current pool. */
   svn_pool_clear(frb->currpool);
@@ -484,9 +886,7 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   /* If there were no content changes and no (potential) merges, we couldn't
      care less about this revision now.  Note that we checked the mime type
      above, so things work if the user just changes the mime type in a commit.
-     Also note that we don't switch the pools in this case.  This is important,
-     since the tempfile will be removed by the pool and we need the tempfile
-     from the last revision with content changes. */
+     Also note that we don't switch the pools in this case. */
   if (!content_delta_handler
       && (!frb->include_merged_revisions || merged_revision))
     return SVN_NO_ERROR;
@@ -495,22 +895,19 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   delta_baton = apr_pcalloc(frb->currpool, sizeof(*delta_baton));
 
   /* Prepare the text delta window handler. */
-  if (frb->last_filename)
-    SVN_ERR(svn_stream_open_readonly(&delta_baton->source_stream, frb->last_filename,
+  if (frb->last_file)
+    SVN_ERR(svn_stream_open_readonly(&delta_baton->source_stream,
+                                     frb->last_file->path,
                                      frb->currpool, pool));
   else
     /* Means empty stream below. */
     delta_baton->source_stream = NULL;
   last_stream = svn_stream_disown(delta_baton->source_stream, pool);
 
-  if (frb->include_merged_revisions && !merged_revision)
-    filepool = frb->filepool;
-  else
-    filepool = frb->currpool;
-
-  SVN_ERR(svn_stream_open_unique(&cur_stream, &delta_baton->filename, NULL,
-                                 svn_io_file_del_on_pool_cleanup,
-                                 filepool, filepool));
+  /* The file lives until the diffs against it have been merged and
+     the next revision has been received.  update_blame() passes our
+     reference on to FRB->LAST_FILE. */
+  SVN_ERR(blame_file_create(&delta_baton->file, &cur_stream, frb->mainpool));
 
   /* Wrap the window handler with our own. */
   delta_baton->file_rev_baton = frb;
@@ -549,7 +946,7 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
     {
       /* We shouldn't get more than one revision outside the
          specified range (unless we alsoe receive merged revisions) */
-      SVN_ERR_ASSERT((frb->last_filename == NULL)
+      SVN_ERR_ASSERT((frb->last_file == NULL)
                      || frb->include_merged_revisions);
 
       /* The file existed before start_rev; generate no blame info for
@@ -676,6 +1073,7 @@ svn_client_blame5(const char *target,
   svn_stream_t *last_stream;
   svn_stream_t *stream;
   const char *target_abspath_or_url;
+  const char *last_filename;
 
   if (start->kind == svn_opt_revision_unspecified
       || end->kind == svn_opt_revision_unspecified)
@@ -773,18 +1171,24 @@ svn_client_blame5(const char *target,
   frb.ctx = ctx;
   frb.diff_options = diff_options;
   frb.include_merged_revisions = include_merged_revisions;
-  frb.last_filename = NULL;
+  frb.last_file = NULL;
   frb.last_rev = NULL;
-  frb.last_original_filename = NULL;
+  frb.last_original_file = NULL;
   frb.chain = apr_palloc(pool, sizeof(*frb.chain));
+  frb.chain->root = NULL;
+  frb.chain->tail = NULL;
   frb.chain->blame = NULL;
   frb.chain->avail = NULL;
+  frb.chain->seed = 2463534242U;
   frb.chain->pool = pool;
   if (include_merged_revisions)
     {
       frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
+      frb.merged_chain->root = NULL;
+      frb.merged_chain->tail = NULL;
       frb.merged_chain->blame = NULL;
       frb.merged_chain->avail = NULL;
+      frb.merged_chain->seed = 2463534242U;
       frb.merged_chain->pool = pool;
     }
   frb.backwards = (frb.start_rev > frb.end_rev);
@@ -800,11 +1204,11 @@ svn_client_blame5(const char *target,
      the lifetime of the pool provided by get_file_revs. */
   frb.lastpool = svn_pool_create(pool);
   frb.currpool = svn_pool_create(pool);
-  if (include_merged_revisions)
-    {
-      frb.filepool = svn_pool_create(pool);
-      frb.prevfilepool = svn_pool_create(pool);
-    }
+
+  /* Revisions get diffed on worker threads while the next ones are
+     being received.  Only merging the diffs into the blame chains
+     happens on this thread. */
+  SVN_ERR(start_blame_differ(&frb.differ, diff_options, ctx, pool));
 
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
@@ -817,6 +1221,10 @@ svn_client_blame5(const char *target,
                                 include_merged_revisions,
                                 file_rev_handler, &frb, pool));
 
+  /* Merge the diffs that are still outstanding. */
+  SVN_ERR(release_diffs(frb.differ));
+  last_filename = frb.last_file ? frb.last_file->path : NULL;
+
   if (end->kind == svn_opt_revision_working)
     {
       /* If the local file is modified we have to call the handler on the
@@ -869,24 +1277,24 @@ svn_client_blame5(const char *target,
           SVN_ERR(svn_stream_copy3(wcfile, tempfile, ctx->cancel_func,
                                    ctx->cancel_baton, pool));
 
-          SVN_ERR(add_file_blame(frb.last_filename, temppath, frb.chain, NULL,
+          SVN_ERR(add_file_blame(last_filename, temppath, frb.chain, NULL,
                                  frb.diff_options,
                                  ctx->cancel_func, ctx->cancel_baton, pool));
 
-          frb.last_filename = temppath;
+          last_filename = temppath;
         }
     }
 
   /* Report the blame to the caller. */
 
   /* The callback has to have been called at least once. */
-  SVN_ERR_ASSERT(frb.last_filename != NULL);
+  SVN_ERR_ASSERT(last_filename != NULL);
 
   /* Create a pool for the iteration below. */
   iterpool = svn_pool_create(pool);
 
   /* Open the last file and get a stream. */
-  SVN_ERR(svn_stream_open_readonly(&last_stream, frb.last_filename,
+  SVN_ERR(svn_stream_open_readonly(&last_stream, last_filename,
                                    pool, pool));
   stream = svn_subst_stream_translated(last_stream,
                                        "\n", TRUE, NULL, FALSE, pool);
@@ -900,12 +1308,16 @@ svn_client_blame5(const char *target,
          semanticly a copy, and we want to use the revision on the branch as
          the most recently changed revision.  ### Is this really what we want
          to do here?  Do the sematics of copy change? */
-      if (!frb.chain->blame)
-        frb.chain->blame = blame_create(frb.chain, frb.last_rev, 0);
+      if (!frb.chain->tail)
+        frb.chain->tail = blame_create(frb.chain, frb.last_rev, 0);
 
+      blame_chain_linearize(frb.chain);
+      blame_chain_linearize(frb.merged_chain);
       normalize_blames(frb.chain, frb.merged_chain, pool);
       walk_merged = frb.merged_chain->blame;
     }
+  else
+    blame_chain_linearize(frb.chain);
 
   /* Process each blame item. */
   for (walk = frb.chain->blame; walk; walk = walk->next)
@@ -965,11 +1377,8 @@ svn_client_blame5(const char *target,
 
   svn_pool_destroy(frb.lastpool);
   svn_pool_destroy(frb.currpool);
-  if (include_merged_revisions)
-    {
-      svn_pool_destroy(frb.filepool);
-      svn_pool_destroy(frb.prevfilepool);
-    }
+  blame_file_release(frb.last_file);
+  blame_file_release(frb.last_original_file);
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
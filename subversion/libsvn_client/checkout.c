@@ -223,7 +223,7 @@ svn_client_checkout3(svn_revnum_t *result_rev,
                                       NULL /* ra_session */,
                                       ctx, pool);
   if (sleep_here)
-    svn_io_sleep_for_timestamps(local_abspath, pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, pool);
 
   return svn_error_trace(err);
 }
@@ -86,7 +86,7 @@ do_cleanup(const char *local_abspath,
                           scratch_pool));
 
   if (fix_timestamps)
-    svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
 
   if (remove_unversioned_items || remove_ignored_items || include_externals)
     {
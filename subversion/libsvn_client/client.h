@@ -40,6 +40,7 @@
 #include "private/svn_client_private.h"
 #include "private/svn_diff_tree.h"
 #include "private/svn_editor.h"
+#include "private/svn_skel.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +64,18 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* Changed-path logs and moves found while describing tree conflicts,
+     shared by all conflicts described with this context (see
+     conflicts.c).  Keys are const char *, values are allocated in the
+     hash table's pool. */
+  apr_hash_t *conflict_logs;
+
+  /* Location histories fetched by svn_client__repos_location_segments()
+     while caching is enabled (see svn_client__cache_location_segments()),
+     NULL otherwise.  Keys are URLs, values are arrays of histories that
+     contain the respective URL, allocated in the hash table's pool. */
+  apr_hash_t *location_segments;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -169,7 +182,9 @@ svn_client__repos_location(svn_client__pathrev_t **op_loc_p,
    RA_SESSION is an RA session open to the repository of URL; it may be
    temporarily reparented within this function.
 
-   CTX is the client context baton.
+   CTX is the client context baton.  If it caches location segments,
+   answer the request from a previously fetched history of the same node
+   where possible.
 
    Use POOL for all allocations.  */
 svn_error_t *
@@ -182,6 +197,18 @@ svn_client__repos_location_segments(apr_array_header_t **segments,
                                     svn_client_ctx_t *ctx,
                                     apr_pool_t *pool);
 
+/* Make svn_client__repos_location_segments() cache the histories it
+   fetches with CTX until POOL gets cleared.  Requests for any part of
+   a cached history, at any peg revision within it, will then be served
+   without contacting the server.  Do nothing if CTX already caches
+   location segments.
+
+   Merges trace the history of the same nodes over and over again, so
+   they enable this for their duration.  */
+void
+svn_client__cache_location_segments(svn_client_ctx_t *ctx,
+                                    apr_pool_t *pool);
+
 
 /* Find the common ancestor of two locations in a repository.
    Ancestry is determined by the 'copy-from' relationship and the normal
@@ -682,6 +709,104 @@ svn_client__get_diff_editor2(const svn_delta_editor_t **editor,
 /* ---------------------------------------------------------------- */
 
 
+/*** Spooled edits ***/
+
+/* An editor drive recorded for replaying it later. */
+typedef struct svn_client__spooled_edit_t svn_client__spooled_edit_t;
+
+/* Set *EDITOR and *EDIT_BATON to an editor that records the drive made
+   through it in *EDIT.  Text deltas are spooled to a temporary file that
+   is removed when RESULT_POOL gets cleaned up.
+
+   Everything is allocated in RESULT_POOL, so the drive may happen on
+   another thread than the replay if RESULT_POOL is used by that thread
+   only until the drive is finished. */
+svn_error_t *
+svn_client__get_spool_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             svn_client__spooled_edit_t **edit,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Return TRUE if the drive recorded in EDIT has been closed. */
+svn_boolean_t
+svn_client__spooled_edit_complete(const svn_client__spooled_edit_t *edit);
+
+/* Drive EDITOR and EDIT_BATON exactly like the complete drive recorded
+   in EDIT.  Call CANCEL_FUNC with CANCEL_BATON before each editor call. */
+svn_error_t *
+svn_client__replay_spooled_edit(const svn_client__spooled_edit_t *edit,
+                                const svn_delta_editor_t *editor,
+                                void *edit_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool);
+
+/* ---------------------------------------------------------------- */
+
+
+/*** Log cache ***/
+
+/* Return a skel describing CHANGED_PATHS, a changed paths hash as in
+   svn_log_entry_t, allocated in RESULT_POOL.  CHANGED_PATHS may be NULL. */
+svn_skel_t *
+svn_client__unparse_changed_paths(apr_hash_t *changed_paths,
+                                  apr_pool_t *result_pool);
+
+/* Parse SKEL written by svn_client__unparse_changed_paths() into
+   *CHANGED_PATHS, allocated in RESULT_POOL.  Return SVN_ERR_MALFORMED_FILE
+   if SKEL can't be parsed. */
+svn_error_t *
+svn_client__parse_changed_paths(apr_hash_t **changed_paths,
+                                const svn_skel_t *skel,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* A local store of the paths changed in the revisions of one repository,
+   see log_cache.c. */
+typedef struct svn_client__log_cache_t svn_client__log_cache_t;
+
+/* Set *CACHE to the log cache of the repository with REPOS_UUID, or to
+   NULL if the log cache is disabled in the configuration of CTX. */
+svn_error_t *
+svn_client__log_cache_open(svn_client__log_cache_t **cache,
+                           const char *repos_uuid,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Set *CONTAINS to TRUE if CACHE holds the paths changed in REVISION and
+   has them stored for a revision with the svn:date DATE, which may be
+   NULL. */
+svn_error_t *
+svn_client__log_cache_contains(svn_boolean_t *contains,
+                               svn_client__log_cache_t *cache,
+                               svn_revnum_t revision,
+                               const svn_string_t *date,
+                               apr_pool_t *scratch_pool);
+
+/* Set *CHANGED_PATHS to the paths changed in REVISION as stored in CACHE,
+   allocated in RESULT_POOL, or to NULL if CACHE doesn't hold them. */
+svn_error_t *
+svn_client__log_cache_get(apr_hash_t **changed_paths,
+                          svn_client__log_cache_t *cache,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Store CHANGED_PATHS as the paths changed in REVISION, committed at the
+   svn:date DATE, in CACHE.  DATE may be NULL.  If they can't be written
+   to disk, keep them in memory as long as CACHE lives. */
+svn_error_t *
+svn_client__log_cache_set(svn_client__log_cache_t *cache,
+                          svn_revnum_t revision,
+                          const svn_string_t *date,
+                          apr_hash_t *changed_paths,
+                          apr_pool_t *scratch_pool);
+
+/* ---------------------------------------------------------------- */
+
+
 /*** Editor for diff summary ***/
 
 /* Set *DIFF_PROCESSOR to a diff processor that will report a diff summary
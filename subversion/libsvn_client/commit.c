@@ -938,6 +938,16 @@ svn_client_commit6(const apr_array_header_t *targets,
 
       if (bump_err)
         goto cleanup;
+
+      /* Drop some of the pristines this commit made obsolete */
+      for (i = 0; i < locks_obtained->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          svn_wc__cleanup_pristines_some(ctx->wc_ctx,
+                                         APR_ARRAY_IDX(locks_obtained, i,
+                                                       const char *),
+                                         iterpool);
+        }
     }
 
  cleanup:
@@ -955,7 +965,7 @@ svn_client_commit6(const apr_array_header_t *targets,
           sleep_abspath = base_abspath;
         }
 
-      svn_io_sleep_for_timestamps(sleep_abspath, pool);
+      svn_wc__sleep_for_timestamps(ctx->wc_ctx, sleep_abspath, pool);
     }
 
   /* Abort the commit if it is still in progress. */
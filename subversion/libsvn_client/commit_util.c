@@ -1379,16 +1379,14 @@ svn_client__get_copy_committables(svn_client__committables_t **committables,
 }
 
 
-/* A svn_sort__array()/qsort()-compatible sort routine for sorting
-   an array of svn_client_commit_item_t *'s by their URL member. */
-static int
-sort_commit_item_urls(const void *a, const void *b)
+/* A svn_sort__path_func_t for sorting an array of
+   svn_client_commit_item_t *'s by their URL member. */
+static const char *
+commit_item_url(const void *element)
 {
-  const svn_client_commit_item3_t *item1
-    = *((const svn_client_commit_item3_t * const *) a);
-  const svn_client_commit_item3_t *item2
-    = *((const svn_client_commit_item3_t * const *) b);
-  return svn_path_compare_paths(item1->url, item2->url);
+  const svn_client_commit_item3_t *item
+    = *((const svn_client_commit_item3_t * const *) element);
+  return item->url;
 }
 
 
@@ -1406,7 +1404,11 @@ svn_client__condense_commit_items(const char **base_url,
   SVN_ERR_ASSERT(ci && ci->nelts);
 
   /* Sort our commit items by their URLs. */
-  svn_sort__array(ci, sort_commit_item_urls);
+  {
+    apr_pool_t *scratch_pool = svn_pool_create(pool);
+    svn_sort__array_by_path(ci, commit_item_url, scratch_pool);
+    svn_pool_destroy(scratch_pool);
+  }
 
   /* Loop through the URLs, finding the longest usable ancestor common
      to all of them, and making sure there are no duplicate URLs.  */
@@ -1849,6 +1851,8 @@ svn_client__do_commit(const char *base_url,
   apr_hash_t *items_hash = apr_hash_make(scratch_pool);
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
+  apr_array_header_t *sorted_mods;
+  svn_wc__text_deltas_t *text_deltas;
   int i;
   struct item_commit_baton cb_baton;
   apr_array_header_t *paths =
@@ -1883,16 +1887,38 @@ svn_client__do_commit(const char *base_url,
   SVN_ERR(svn_delta_path_driver2(editor, edit_baton, paths, TRUE,
                                  do_item_commit, &cb_baton, scratch_pool));
 
-  /* Transmit outstanding text deltas. */
+  /* Queue the outstanding text deltas, so that the next files can be
+     read while the earlier ones are being sent. */
+  SVN_ERR(svn_wc__text_deltas_create(&text_deltas, ctx->wc_ctx,
+                                     scratch_pool));
+  sorted_mods = apr_array_make(scratch_pool, apr_hash_count(file_mods),
+                               sizeof(struct file_mod_t *));
   for (hi = apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
     {
       struct file_mod_t *mod = apr_hash_this_val(hi);
       const svn_client_commit_item3_t *item = mod->item;
+      svn_boolean_t fulltext = FALSE;
+
+      /* If the node has no history, transmit full text */
+      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
+        fulltext = TRUE;
+
+      SVN_ERR(svn_wc__text_deltas_queue(text_deltas, item->path, fulltext,
+                                        iterpool));
+      APR_ARRAY_PUSH(sorted_mods, struct file_mod_t *) = mod;
+    }
+
+  /* Transmit outstanding text deltas. */
+  for (i = 0; i < sorted_mods->nelts; i++)
+    {
+      struct file_mod_t *mod = APR_ARRAY_IDX(sorted_mods, i,
+                                             struct file_mod_t *);
+      const svn_client_commit_item3_t *item = mod->item;
       const svn_checksum_t *new_text_base_md5_checksum;
       const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -1912,15 +1938,10 @@ svn_client__do_commit(const char *base_url,
           ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
         }
 
-      /* If the node has no history, transmit full text */
-      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
-
-      err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
+      err = svn_wc__text_deltas_transmit(&new_text_base_md5_checksum,
                                          &new_text_base_sha1_checksum,
-                                         ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
+                                         text_deltas, item->path,
+                                         editor, mod->file_baton,
                                          result_pool, iterpool);
 
       if (err)
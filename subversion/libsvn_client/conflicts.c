@@ -30,8 +30,11 @@
 #include "svn_types.h"
 #include "svn_wc.h"
 #include "svn_client.h"
+#include "svn_checksum.h"
+#include "svn_config.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
 #include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_props.h"
@@ -1531,6 +1534,10 @@ struct find_moves_baton
 
   /* Extra RA session that can be used to make additional requests. */
   svn_ra_session_t *extra_ra_session;
+
+  /* If not NULL, find_moves() appends a copy of each log entry it receives,
+   * allocated in RESULT_POOL, to this array. */
+  apr_array_header_t *log_entries;
 };
 
 /* Implements svn_log_entry_receiver_t. */
@@ -1556,6 +1563,10 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
       b->ctx->notify_func2(b->ctx->notify_baton2, notify, scratch_pool);
     }
 
+  if (b->log_entries)
+    APR_ARRAY_PUSH(b->log_entries, svn_log_entry_t *) =
+      svn_log_entry_dup(log_entry, b->result_pool);
+
   /* No paths were changed in this revision.  Nothing to do. */
   if (! log_entry->changed_paths2)
     return SVN_NO_ERROR;
@@ -1613,11 +1624,343 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
+/* The changed-path log of a path over a revision range and the moves
+ * found in it.  These are cached in the client context so that all tree
+ * conflicts described with the same context, e.g. all conflicts raised by
+ * one merge, share them. */
+struct conflict_log_t
+{
+  /* The log entries (svn_log_entry_t *) in the order they were received
+   * from svn_ra_get_log2(). */
+  apr_array_header_t *log_entries;
+
+  /* See struct find_moves_baton. */
+  apr_hash_t *moves_table;
+};
+
+/* Set *PATH to the file caching the changed-path log identified by KEY on
+ * disk, or to NULL if the on-disk cache is disabled in the configuration
+ * of CTX or the user's configuration area can't be determined. */
+static svn_error_t *
+get_conflict_log_cache_path(const char **path,
+                            const char *key,
+                            svn_client_ctx_t *ctx,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  svn_boolean_t enabled;
+  const char *config_dir;
+  const char *cache_dir;
+  svn_checksum_t *checksum;
+
+  *path = NULL;
+
+  SVN_ERR(svn_config_get_bool(cfg, &enabled, SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_CONFLICT_LOG_CACHE, FALSE));
+  if (!enabled)
+    return SVN_NO_ERROR;
+
+  /* Honour --config-dir like the auth cache does. */
+  config_dir = ctx->auth_baton
+               ? svn_auth_get_parameter(ctx->auth_baton,
+                                        SVN_AUTH_PARAM_CONFIG_DIR)
+               : NULL;
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          "conflict-logs", scratch_pool));
+  if (cache_dir == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, key, strlen(key),
+                       scratch_pool));
+  *path = svn_dirent_join(cache_dir,
+                          svn_checksum_to_cstring_display(checksum,
+                                                          scratch_pool),
+                          result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the revision property NAME of LOG_ENTRY to ENTRY_SKEL, as an empty
+ * list if LOG_ENTRY doesn't have it. */
+static void
+prepend_cached_revprop(svn_skel_t *entry_skel,
+                       const svn_log_entry_t *log_entry,
+                       const char *name,
+                       apr_pool_t *result_pool)
+{
+  const svn_string_t *value = NULL;
+
+  if (log_entry->revprops)
+    value = svn_hash_gets(log_entry->revprops, name);
+  if (value)
+    svn_skel__prepend(svn_skel__mem_atom(value->data, value->len,
+                                         result_pool),
+                      entry_skel);
+  else
+    svn_skel__prepend(svn_skel__make_empty_list(result_pool), entry_skel);
+}
+
+/* Write LOG_ENTRIES to the on-disk cache file PATH.
+ *
+ * Each log entry is stored as a skel (REV AUTHOR DATE CHANGES) where AUTHOR
+ * and DATE are empty lists if the revision doesn't have them, and CHANGES
+ * is written by svn_client__unparse_changed_paths(). */
+static svn_error_t *
+write_cached_log(const char *path,
+                 const apr_array_header_t *log_entries,
+                 apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_stringbuf_t *buf;
+  int i;
+
+  for (i = log_entries->nelts - 1; i >= 0; i--)
+    {
+      const svn_log_entry_t *log_entry
+        = APR_ARRAY_IDX(log_entries, i, const svn_log_entry_t *);
+      svn_skel_t *entry_skel = svn_skel__make_empty_list(scratch_pool);
+
+      svn_skel__prepend(svn_client__unparse_changed_paths(
+                          log_entry->changed_paths2, scratch_pool),
+                        entry_skel);
+      prepend_cached_revprop(entry_skel, log_entry, SVN_PROP_REVISION_DATE,
+                             scratch_pool);
+      prepend_cached_revprop(entry_skel, log_entry, SVN_PROP_REVISION_AUTHOR,
+                             scratch_pool);
+      svn_skel__prepend_int(log_entry->revision, entry_skel, scratch_pool);
+      svn_skel__prepend(entry_skel, skel);
+    }
+
+  buf = svn_skel__unparse(skel, scratch_pool);
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(path, scratch_pool),
+                                      scratch_pool));
+  return svn_error_trace(svn_io_write_atomic2(path, buf->data, buf->len,
+                                              NULL, FALSE, scratch_pool));
+}
+
+/* Return an error about the malformed conflict log cache file PATH. */
+static svn_error_t *
+malformed_cached_log_error(const char *path,
+                           apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                           _("Malformed log cache file '%s'"),
+                           svn_dirent_local_style(path, scratch_pool));
+}
+
+/* Parse the log entry stored as ENTRY_SKEL in the on-disk cache file PATH
+ * (see write_cached_log()) into *LOG_ENTRY, allocated in RESULT_POOL. */
+static svn_error_t *
+parse_cached_log_entry(svn_log_entry_t **log_entry,
+                       const svn_skel_t *entry_skel,
+                       const char *path,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_log_entry_t *entry = svn_log_entry_create(result_pool);
+  const svn_skel_t *author_skel;
+  const svn_skel_t *date_skel;
+  apr_int64_t rev;
+
+  if (svn_skel__list_length(entry_skel) != 4
+      || !entry_skel->children->is_atom)
+    return svn_error_trace(malformed_cached_log_error(path, scratch_pool));
+
+  SVN_ERR(svn_skel__parse_int(&rev, entry_skel->children, scratch_pool));
+  entry->revision = (svn_revnum_t)rev;
+
+  entry->revprops = apr_hash_make(result_pool);
+  author_skel = entry_skel->children->next;
+  if (author_skel->is_atom)
+    svn_hash_sets(entry->revprops, SVN_PROP_REVISION_AUTHOR,
+                  svn_string_ncreate(author_skel->data, author_skel->len,
+                                     result_pool));
+  date_skel = author_skel->next;
+  if (date_skel->is_atom)
+    svn_hash_sets(entry->revprops, SVN_PROP_REVISION_DATE,
+                  svn_string_ncreate(date_skel->data, date_skel->len,
+                                     result_pool));
+
+  SVN_ERR(svn_client__parse_changed_paths(&entry->changed_paths2,
+                                          date_skel->next,
+                                          result_pool, scratch_pool));
+  entry->changed_paths = entry->changed_paths2;
+
+  *log_entry = entry;
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOG_ENTRIES to the log entries (svn_log_entry_t *) stored in the
+ * on-disk cache file PATH by write_cached_log(), allocated in RESULT_POOL.
+ * Set *LOG_ENTRIES to NULL if PATH does not exist or can't be parsed. */
+static svn_error_t *
+read_cached_log(apr_array_header_t **log_entries,
+                const char *path,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf;
+  svn_skel_t *skel;
+  const svn_skel_t *entry_skel;
+  apr_array_header_t *entries;
+  svn_error_t *err;
+
+  *log_entries = NULL;
+
+  err = svn_stringbuf_from_file2(&buf, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  skel = svn_skel__parse(buf->data, buf->len, scratch_pool);
+  if (skel == NULL || skel->is_atom)
+    return svn_error_trace(malformed_cached_log_error(path, scratch_pool));
+
+  entries = apr_array_make(result_pool, svn_skel__list_length(skel),
+                           sizeof(svn_log_entry_t *));
+  for (entry_skel = skel->children;
+       entry_skel != NULL;
+       entry_skel = entry_skel->next)
+    {
+      svn_log_entry_t *log_entry;
+
+      SVN_ERR(parse_cached_log_entry(&log_entry, entry_skel, path,
+                                     result_pool, scratch_pool));
+      APR_ARRAY_PUSH(entries, svn_log_entry_t *) = log_entry;
+    }
+
+  *log_entries = entries;
+  return SVN_NO_ERROR;
+}
+
+/* Baton for validate_cached_log_entry(). */
+struct validate_cached_log_baton
+{
+  /* The log entries read from the on-disk cache. */
+  apr_array_header_t *log_entries;
+
+  /* Index of the cached entry matching the next one received. */
+  int next;
+
+  /* Cleared as soon as the received log differs from the cached one. */
+  svn_boolean_t valid;
+
+  /* Pool of LOG_ENTRIES. */
+  apr_pool_t *result_pool;
+};
+
+/* Implements svn_log_entry_receiver_t.  Compare LOG_ENTRY to the next
+ * cached entry in the struct validate_cached_log_baton BATON and copy its
+ * current author into the cached entry. */
+static svn_error_t *
+validate_cached_log_entry(void *baton,
+                          svn_log_entry_t *log_entry,
+                          apr_pool_t *scratch_pool)
+{
+  struct validate_cached_log_baton *b = baton;
+  svn_log_entry_t *cached_entry;
+  const svn_string_t *date = NULL;
+  const svn_string_t *cached_date;
+  const svn_string_t *author = NULL;
+
+  if (!b->valid)
+    return SVN_NO_ERROR;
+
+  if (b->next >= b->log_entries->nelts)
+    {
+      b->valid = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  cached_entry = APR_ARRAY_IDX(b->log_entries, b->next, svn_log_entry_t *);
+  b->next++;
+
+  /* A repository replaced by one with the same UUID, e.g. by loading a
+   * dump file, shows as different revisions or commit times. */
+  if (log_entry->revprops)
+    {
+      date = svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_DATE);
+      author = svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_AUTHOR);
+    }
+  cached_date = svn_hash_gets(cached_entry->revprops, SVN_PROP_REVISION_DATE);
+  if (cached_entry->revision != log_entry->revision
+      || (date == NULL) != (cached_date == NULL)
+      || (date && !svn_string_compare(date, cached_date)))
+    {
+      b->valid = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* The author may have been changed since the log was cached. */
+  svn_hash_sets(cached_entry->revprops, SVN_PROP_REVISION_AUTHOR,
+                author ? svn_string_dup(author, b->result_pool) : NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check the LOG_ENTRIES read from the on-disk cache against the log of the
+ * URL of RA_SESSION from START_REV to END_REV and set *VALID accordingly.
+ * Update the authors in LOG_ENTRIES, which are allocated in RESULT_POOL, to
+ * the current ones.  This log request does not ask for changed paths and
+ * is much cheaper than the one it replaces. */
+static svn_error_t *
+validate_cached_log(svn_boolean_t *valid,
+                    apr_array_header_t *log_entries,
+                    svn_ra_session_t *ra_session,
+                    svn_revnum_t start_rev,
+                    svn_revnum_t end_rev,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  struct validate_cached_log_baton b;
+  apr_array_header_t *paths;
+  apr_array_header_t *revprops;
+
+  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  revprops = apr_array_make(scratch_pool, 2, sizeof(const char *));
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_DATE;
+
+  b.log_entries = log_entries;
+  b.next = 0;
+  b.valid = TRUE;
+  b.result_pool = result_pool;
+
+  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
+                          0, /* no limit */
+                          FALSE, /* no changed paths */
+                          FALSE, /* need to traverse copies */
+                          FALSE, /* no need for merged revisions */
+                          revprops,
+                          validate_cached_log_entry, &b,
+                          scratch_pool));
+
+  *valid = b.valid && b.next == log_entries->nelts;
+  return SVN_NO_ERROR;
+}
+
 /* Find all moves which occured in repository history starting at
  * REPOS_RELPATH@START_REV until END_REV (where START_REV > END_REV).
- * Return results in *MOVES_TABLE (see struct find_moves_baton for details). */
+ * Return results in *MOVES_TABLE (see struct find_moves_baton for details),
+ * and the changed-path log of REPOS_RELPATH over this revision range, which
+ * includes the author of each revision, in *LOG_ENTRIES (see struct
+ * conflict_log_t).
+ *
+ * The results are cached in CTX and must not be modified by the caller.
+ * If enabled in the configuration of CTX, the log is also cached on disk.
+ * A log read from disk is validated with a cheap log request first, which
+ * also refreshes the authors of its revisions. */
 static svn_error_t *
 find_moves_in_revision_range(struct apr_hash_t **moves_table,
+                             apr_array_header_t **log_entries,
                              const char *repos_relpath,
                              const char *repos_root_url,
                              const char *repos_uuid,
@@ -1625,18 +1968,31 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
                              svn_revnum_t start_rev,
                              svn_revnum_t end_rev,
                              svn_client_ctx_t *ctx,
-                             apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool)
 {
+  apr_hash_t *conflict_logs = svn_client__get_private_ctx(ctx)->conflict_logs;
+  apr_pool_t *cache_pool = apr_hash_pool_get(conflict_logs);
+  struct conflict_log_t *log;
+  const char *key;
+  const char *cache_path;
   svn_ra_session_t *ra_session;
   const char *url;
   const char *corrected_url;
-  apr_array_header_t *paths;
-  apr_array_header_t *revprops;
   struct find_moves_baton b = { 0 };
+  svn_error_t *err;
 
   SVN_ERR_ASSERT(start_rev > end_rev);
 
+  key = apr_psprintf(scratch_pool, "%s:%ld:%ld:%s", repos_uuid,
+                     start_rev, end_rev, repos_relpath);
+  log = svn_hash_gets(conflict_logs, key);
+  if (log)
+    {
+      *moves_table = log->moves_table;
+      *log_entries = log->log_entries;
+      return SVN_NO_ERROR;
+    }
+
   url = svn_path_url_add_component2(repos_root_url, repos_relpath,
                                     scratch_pool);
   SVN_ERR(svn_client__open_ra_session_internal(&ra_session, &corrected_url,
@@ -1644,32 +2000,98 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
                                                ctx, scratch_pool,
                                                scratch_pool));
 
-  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(paths, const char *) = "";
-
-  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+  /* Everything cached lives as long as CTX. */
+  log = apr_pcalloc(cache_pool, sizeof(*log));
 
   b.repos_root_url = repos_root_url;
   b.repos_uuid = repos_uuid;
   b.ctx = ctx;
   b.victim_abspath = victim_abspath;
-  b.moves_table = apr_hash_make(result_pool);
+  b.moves_table = apr_hash_make(cache_pool);
   b.moved_paths = apr_hash_make(scratch_pool);
-  b.result_pool = result_pool;
+  b.result_pool = cache_pool;
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                          0, /* no limit */
-                          TRUE, /* need the changed paths list */
-                          FALSE, /* need to traverse copies */
-                          FALSE, /* no need for merged revisions */
-                          revprops,
-                          find_moves, &b,
-                          scratch_pool));
+  SVN_ERR(get_conflict_log_cache_path(&cache_path, key, ctx,
+                                      scratch_pool, scratch_pool));
+  if (cache_path)
+    {
+      /* A damaged cache file is as good as none. */
+      err = read_cached_log(&log->log_entries, cache_path, cache_pool,
+                            scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          log->log_entries = NULL;
+        }
+
+      if (log->log_entries)
+        {
+          svn_boolean_t valid;
+
+          SVN_ERR(validate_cached_log(&valid, log->log_entries, ra_session,
+                                      start_rev, end_rev, cache_pool,
+                                      scratch_pool));
+          if (!valid)
+            log->log_entries = NULL;
+        }
+    }
+
+  if (log->log_entries)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < log->log_entries->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+
+          if (ctx->cancel_func)
+            SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+          SVN_ERR(find_moves(&b, APR_ARRAY_IDX(log->log_entries, i,
+                                               svn_log_entry_t *),
+                             iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      apr_array_header_t *paths;
+      apr_array_header_t *revprops;
+
+      paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+      APR_ARRAY_PUSH(paths, const char *) = "";
+
+      revprops = apr_array_make(scratch_pool, 2, sizeof(const char *));
+      APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+      APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_DATE;
 
-  *moves_table = b.moves_table;
+      log->log_entries = apr_array_make(cache_pool, 0,
+                                        sizeof(svn_log_entry_t *));
+      b.log_entries = log->log_entries;
+
+      SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
+                              0, /* no limit */
+                              TRUE, /* need the changed paths list */
+                              FALSE, /* need to traverse copies */
+                              FALSE, /* no need for merged revisions */
+                              revprops,
+                              find_moves, &b,
+                              scratch_pool));
+
+      /* Failing to write the cache only costs time later. */
+      if (cache_path)
+        svn_error_clear(write_cached_log(cache_path, log->log_entries,
+                                         scratch_pool));
+    }
+
+  log->moves_table = b.moves_table;
+  svn_hash_sets(conflict_logs, apr_pstrdup(cache_pool, key), log);
+
+  *moves_table = log->moves_table;
+  *log_entries = log->log_entries;
 
   return SVN_NO_ERROR;
 }
@@ -1903,6 +2325,12 @@ find_operative_moves(apr_array_header_t **moves,
                                           deleted_repos_relpath);
       if (relpath && relpath[0] != '\0')
         move = new_path_adjusted_move(move, relpath, result_pool);
+      else
+        {
+          /* MOVES_TABLE is shared with other conflicts; don't let
+           * trace_moved_node() modify it. */
+          move = apr_pmemdup(result_pool, move, sizeof(*move));
+        }
       APR_ARRAY_PUSH(*moves, struct repos_move_info *) = move;
     }
 
@@ -1960,14 +2388,15 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
   svn_ra_session_t *ra_session;
   const char *url;
   const char *corrected_url;
-  apr_array_header_t *paths;
-  apr_array_header_t *revprops;
   const char *repos_root_url;
   const char *repos_uuid;
   struct find_deleted_rev_baton b = { 0 };
   const char *victim_abspath;
   svn_error_t *err;
   apr_hash_t *moves_table;
+  apr_array_header_t *log_entries;
+  apr_pool_t *iterpool;
+  int i;
 
   SVN_ERR_ASSERT(start_rev > end_rev);
 
@@ -1976,10 +2405,11 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
                                              scratch_pool));
   victim_abspath = svn_client_conflict_get_local_abspath(conflict);
 
-  SVN_ERR(find_moves_in_revision_range(&moves_table, parent_repos_relpath,
+  SVN_ERR(find_moves_in_revision_range(&moves_table, &log_entries,
+                                       parent_repos_relpath,
                                        repos_root_url, repos_uuid,
                                        victim_abspath, start_rev, end_rev,
-                                       ctx, result_pool, scratch_pool));
+                                       ctx, scratch_pool));
 
   url = svn_path_url_add_component2(repos_root_url, parent_repos_relpath,
                                     scratch_pool);
@@ -1988,12 +2418,6 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
                                                ctx, scratch_pool,
                                                scratch_pool));
 
-  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(paths, const char *) = "";
-
-  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
-
   b.victim_abspath = victim_abspath;
   b.deleted_repos_relpath = svn_relpath_join(parent_repos_relpath,
                                              deleted_basename, scratch_pool);
@@ -2009,14 +2433,18 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  err = svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                        0, /* no limit */
-                        TRUE, /* need the changed paths list */
-                        FALSE, /* need to traverse copies */
-                        FALSE, /* no need for merged revisions */
-                        revprops,
-                        find_deleted_rev, &b,
-                        scratch_pool);
+  /* Scan the log the moves were found in, rather than asking the
+   * repository for the same log again. */
+  err = SVN_NO_ERROR;
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < log_entries->nelts && !err; i++)
+    {
+      svn_pool_clear(iterpool);
+      err = find_deleted_rev(&b, APR_ARRAY_IDX(log_entries, i,
+                                               svn_log_entry_t *),
+                             iterpool);
+    }
+  svn_pool_destroy(iterpool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_CEASE_INVOCATION &&
@@ -2037,7 +2465,7 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
       if (move)
         {
           *deleted_rev = move->rev;
-          *deleted_rev_author = move->rev_author;
+          *deleted_rev_author = apr_pstrdup(result_pool, move->rev_author);
           *replacing_node_kind = b.replacing_node_kind;
           SVN_ERR(find_operative_moves(moves, moves_table,
                                        b.deleted_repos_relpath,
@@ -5579,7 +6007,7 @@ resolve_text_conflict(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   conflict->resolution_text = option_id;
@@ -5623,7 +6051,7 @@ resolve_prop_conflict(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (propname[0] == '\0')
@@ -5804,7 +6232,7 @@ resolve_update_moved_away_node(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   conflict->resolution_tree = svn_client_conflict_option_get_id(option);
@@ -6124,7 +6552,7 @@ unlock_wc:
                                  svn_wc__release_write_lock(ctx->wc_ctx,
                                                             lock_abspath,
                                                             scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
   
   if (ctx->notify_func2)
@@ -6256,7 +6684,7 @@ resolve_merge_incoming_added_file_text_merge(
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -6460,7 +6888,7 @@ unlock_wc:
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   SVN_ERR(svn_stream_close(incoming_new_stream));
@@ -6844,7 +7272,8 @@ diff_file_added(const char *relpath,
   propsarray = svn_prop_hash_to_array(right_props, scratch_pool);
   SVN_ERR(svn_categorize_props(propsarray, NULL, NULL, &regular_props,
                                scratch_pool));
-  SVN_ERR(svn_io_copy_file(right_file, local_abspath, FALSE, scratch_pool));
+  SVN_ERR(svn_io_copy_file2(right_file, local_abspath, 0, NULL,
+                            scratch_pool));
   SVN_ERR(svn_wc_add_from_disk3(b->ctx->wc_ctx, local_abspath,
                                 svn_prop_array_to_hash(regular_props,
                                                        scratch_pool),
@@ -7048,7 +7477,7 @@ resolve_merge_incoming_added_dir_merge(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -7331,7 +7760,7 @@ unlock_wc:
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -7877,7 +8306,7 @@ resolve_incoming_move_file_text_merge(svn_client_conflict_option_t *option,
                       NULL, NULL, /* conflict func/baton */
                       NULL, NULL, /* don't allow user to cancel here */
                       scratch_pool);
-  svn_io_sleep_for_timestamps(moved_to_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, moved_to_abspath, scratch_pool);
   if (err)
     goto unlock_wc;
 
@@ -8298,7 +8727,8 @@ resolve_local_move_file_merge(svn_client_conflict_option_t *option,
                       NULL, NULL, /* conflict func/baton */
                       NULL, NULL, /* don't allow user to cancel here */
                       scratch_pool);
-  svn_io_sleep_for_timestamps(details->moved_to_abspath, scratch_pool);
+  svn_wc__sleep_for_timestamps(ctx->wc_ctx, details->moved_to_abspath,
+                               scratch_pool);
   if (err)
     return svn_error_compose_create(err,
                                     svn_wc__release_write_lock(ctx->wc_ctx,
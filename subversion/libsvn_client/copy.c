@@ -3194,7 +3194,7 @@ svn_client_copy7(const apr_array_header_t *sources,
 
   /* Sleep if required.  DST_PATH is not a URL in these cases. */
   if (timestamp_sleep)
-    svn_io_sleep_for_timestamps(dst_path, subpool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, dst_path, subpool);
 
   svn_pool_destroy(subpool);
   return svn_error_trace(err);
@@ -3292,7 +3292,7 @@ svn_client_move7(const apr_array_header_t *src_paths,
 
   /* Sleep if required.  DST_PATH is not a URL in these cases. */
   if (timestamp_sleep)
-    svn_io_sleep_for_timestamps(dst_path, subpool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, dst_path, subpool);
 
   svn_pool_destroy(subpool);
   return svn_error_trace(err);
@@ -106,6 +106,7 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   private_ctx->magic_null = 0;
   private_ctx->magic_id = CLIENT_CTX_MAGIC;
+  private_ctx->conflict_logs = apr_hash_make(pool);
 
   public_ctx->notify_func2 = call_notify_func;
   public_ctx->notify_baton2 = public_ctx;
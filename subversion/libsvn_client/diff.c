@@ -1914,6 +1914,12 @@ diff_repos_repos(const char **root_relpath,
   const char *target2;
   svn_ra_session_t *ra_session;
 
+  /* Let the diff driver produce its output while the editor fetches the
+     contents of the next files. */
+  if (ddi && text_deltas)
+    diff_processor = svn_diff__tree_processor_pipeline_create(diff_processor,
+                                                              scratch_pool);
+
   /* Prepare info for the repos repos diff. */
   SVN_ERR(diff_prepare_repos_repos(&url1, &url2, &rev1, &rev2,
                                    &anchor1, &anchor2, &target1, &target2,
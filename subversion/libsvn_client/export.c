@@ -31,6 +31,7 @@
 #include <apr_md5.h>
 #include "svn_types.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
@@ -45,6 +46,8 @@
 #include "svn_private_config.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #ifndef ENABLE_EV2_IMPL
@@ -134,6 +137,279 @@ append_basename_if_dir(const char **appendable_dirent_p,
   return SVN_NO_ERROR;
 }
 
+/*** Writing exported files. ***/
+
+/* Default and maximum number of threads writing exported files. */
+#define EXPORT_DEFAULT_JOBS 4
+#define EXPORT_MAX_JOBS 64
+
+typedef struct export_writer_t export_writer_t;
+
+/* The writing of one exported file, see write_exported_file(). */
+typedef struct export_job_t
+{
+  /* Private pool of this job.  It is a root pool because the source
+     stream gets used by a task.  Everything below is allocated in it. */
+  apr_pool_t *pool;
+
+  /* Write the contents of SOURCE, or else of the temporary file
+     FROM_ABSPATH, to TO_ABSPATH.  FROM_ABSPATH will be removed. */
+  svn_stream_t *source;
+  const char *from_abspath;
+  const char *to_abspath;
+
+  /* How to translate the contents.  No translation is done if neither
+     EOL nor KEYWORDS is set. */
+  const char *eol;
+  svn_boolean_t repair;
+  apr_hash_t *keywords;
+  svn_boolean_t expand;
+
+  /* Whether to make the file executable, and its time unless 0. */
+  svn_boolean_t executable;
+  apr_time_t date;
+} export_job_t;
+
+/* Exported files being written concurrently.  Files are notified in the
+   order they were queued, by the thread that queued them. */
+struct export_writer_t
+{
+  /* Runs export_task() for the jobs.  NULL if the files are written
+     right away. */
+  svn_task__set_t *set;
+
+  /* Don't queue more jobs while this many have not been notified yet. */
+  int max_pending;
+
+  /* The jobs not released yet in queue order (export_job_t *). */
+  apr_array_header_t *jobs;
+
+  svn_wc_notify_func2_t notify_func;
+  void *notify_baton;
+};
+
+/* Write the file described by JOB.  Its temporary files are created next
+   to the target, which gets replaced atomically. */
+static svn_error_t *
+write_exported_file(export_job_t *job,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stream_t *source = job->source;
+  svn_stream_t *dst_stream;
+  const char *dst_tmp;
+  svn_error_t *err;
+
+  /* Untranslated temporary files can be moved into place as they are. */
+  if (job->from_abspath && !job->eol && !job->keywords)
+    {
+      dst_tmp = job->from_abspath;
+    }
+  else
+    {
+      if (!source)
+        SVN_ERR(svn_stream_open_readonly(&source, job->from_abspath,
+                                         scratch_pool, scratch_pool));
+
+      SVN_ERR(svn_stream_open_unique(&dst_stream, &dst_tmp,
+                                     svn_dirent_dirname(job->to_abspath,
+                                                        scratch_pool),
+                                     svn_io_file_del_none,
+                                     scratch_pool, scratch_pool));
+
+      /* Writing through a translated stream is more efficient than
+         reading through one. */
+      if (job->eol || job->keywords)
+        dst_stream = svn_subst_stream_translated(dst_stream, job->eol,
+                                                 job->repair, job->keywords,
+                                                 job->expand, scratch_pool);
+
+      /* The cancellation callback may not be thread-safe; the main thread
+         checks it between files. */
+      err = svn_stream_copy3(source, dst_stream, NULL, NULL, scratch_pool);
+      if (!err && job->from_abspath)
+        err = svn_io_remove_file2(job->from_abspath, FALSE, scratch_pool);
+      if (err)
+        return svn_error_compose_create(err,
+                                        svn_io_remove_file2(dst_tmp, TRUE,
+                                                            scratch_pool));
+    }
+
+  err = SVN_NO_ERROR;
+  if (job->executable)
+    err = svn_io_set_file_executable(dst_tmp, TRUE, FALSE, scratch_pool);
+
+  if (!err && job->date)
+    err = svn_io_set_file_affected_time(job->date, dst_tmp, scratch_pool);
+
+  /* Now that DST_TMP is complete, do the atomic rename. */
+  if (!err)
+    err = svn_io_file_rename2(dst_tmp, job->to_abspath, FALSE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(dst_tmp, TRUE,
+                                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Write the file described by the
+   export_job_t in PROCESS_BATON and return the job in *RESULT. */
+static svn_error_t *
+export_task(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  export_job_t *job = process_baton;
+
+  SVN_ERR(write_exported_file(job, scratch_pool));
+
+  *result = job;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Notify the completion of the
+   export_job_t in RESULT, which must be the first job of the
+   export_writer_t in OUTPUT_BATON, and release it. */
+static svn_error_t *
+notify_export(void *result,
+              void *output_baton,
+              apr_pool_t *scratch_pool)
+{
+  export_writer_t *writer = output_baton;
+  export_job_t *job = result;
+
+  SVN_ERR_ASSERT(APR_ARRAY_IDX(writer->jobs, 0, export_job_t *) == job);
+
+  if (writer->notify_func)
+    {
+      svn_wc_notify_t *notify
+        = svn_wc_create_notify(apr_pstrdup(scratch_pool, job->to_abspath),
+                               svn_wc_notify_update_add, scratch_pool);
+
+      notify->kind = svn_node_file;
+      writer->notify_func(writer->notify_baton, notify, scratch_pool);
+    }
+
+  svn_sort__array_delete(writer->jobs, 0, 1);
+  svn_pool_destroy(job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for all jobs queued on WRITER and notify them in queue order.
+   Return the error of the first failed job, if any; no later jobs are
+   notified then. */
+static svn_error_t *
+release_exports(export_writer_t *writer)
+{
+  if (writer->set)
+    SVN_ERR(svn_task__set_finish(writer->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new job for WRITER that writes the file TO_ABSPATH. */
+static export_job_t *
+create_export_job(export_writer_t *writer,
+                  const char *to_abspath)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  export_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->pool = pool;
+  job->to_abspath = apr_pstrdup(pool, to_abspath);
+
+  return job;
+}
+
+/* Queue JOB, created by create_export_job(), on WRITER, which takes over
+   its ownership.  Return the error of an earlier job that failed. */
+static svn_error_t *
+queue_export_job(export_writer_t *writer,
+                 export_job_t *job,
+                 apr_pool_t *scratch_pool)
+{
+  APR_ARRAY_PUSH(writer->jobs, export_job_t *) = job;
+
+  if (writer->set)
+    {
+      /* Limit the number of open source streams. */
+      if (writer->jobs->nelts > writer->max_pending)
+        SVN_ERR(svn_task__set_finish(writer->set));
+
+      return svn_error_trace(svn_task__add(writer->set, export_task, job));
+    }
+
+  SVN_ERR(write_exported_file(job, scratch_pool));
+
+  return svn_error_trace(notify_export(job, writer, scratch_pool));
+}
+
+/* Pool cleanup function releasing all jobs of the export_writer_t in
+   DATA that have not been notified.  Its task set is gone by then. */
+static apr_status_t
+cleanup_export_writer(void *data)
+{
+  export_writer_t *writer = data;
+  int i;
+
+  for (i = 0; i < writer->jobs->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(writer->jobs, i, export_job_t *)->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *WRITER to a new export writer using as many threads as configured
+   in CTX and notifying through CTX.  Outstanding jobs will be cancelled
+   and released when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+start_export_writer(export_writer_t **writer,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *result_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  export_writer_t *ew;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_EXPORT_JOBS,
+                             EXPORT_DEFAULT_JOBS);
+  if (err || jobs < 1 || jobs > EXPORT_MAX_JOBS)
+    {
+      svn_error_clear(err);
+      jobs = EXPORT_DEFAULT_JOBS;
+    }
+
+  ew = apr_pcalloc(result_pool, sizeof(*ew));
+  ew->max_pending = 2 * (int)jobs;
+  ew->jobs = apr_array_make(result_pool, ew->max_pending + 1,
+                            sizeof(export_job_t *));
+  ew->notify_func = ctx->notify_func2;
+  ew->notify_baton = ctx->notify_baton2;
+
+  /* The set lives in a sub-pool, which gets destroyed before the cleanup
+     functions of RESULT_POOL run.  Thus, no task will be using the jobs
+     when cleanup_export_writer() releases them.  The cancellation
+     callback may not be thread-safe; the callers check it between
+     files. */
+  if (jobs > 1)
+    SVN_ERR(svn_task__set_create(&ew->set, (int)jobs, notify_export, ew,
+                                 NULL, NULL, svn_pool_create(result_pool)));
+
+  apr_pool_cleanup_register(result_pool, ew, cleanup_export_writer,
+                            apr_pool_cleanup_null);
+  *writer = ew;
+
+  return SVN_NO_ERROR;
+}
+
 /* Make an unversioned copy of the versioned file at FROM_ABSPATH.  Copy it
  * to the destination path TO_ABSPATH.
  *
@@ -171,27 +447,162 @@ struct export_info_baton
   void *notify_baton;
   const char *origin_abspath;
   svn_boolean_t exported;
+  export_writer_t *writer;
 };
 
-/* Export a file or directory. Implements svn_wc_status_func4_t */
+/* Prepare JOB for exporting the versioned file LOCAL_ABSPATH with STATUS
+   as described for export_node().  Set *QUEUE to TRUE if JOB should be
+   queued, or to FALSE if there is nothing to write or the file has already
+   been written as a special file.  Use SCRATCH_POOL for temporary
+   allocations. */
 static svn_error_t *
-export_node(void *baton,
-            const char *local_abspath,
-            const svn_wc_status3_t *status,
-            apr_pool_t *scratch_pool)
+prepare_file_export(svn_boolean_t *queue,
+                    export_job_t *job,
+                    struct export_info_baton *eib,
+                    const char *local_abspath,
+                    const svn_wc_status3_t *status,
+                    apr_pool_t *scratch_pool)
 {
-  struct export_info_baton *eib = baton;
   svn_wc_context_t *wc_ctx = eib->wc_ctx;
-  apr_hash_t *kw = NULL;
   svn_subst_eol_style_t style;
   apr_hash_t *props;
   svn_string_t *eol_style, *keywords, *executable, *special;
-  const char *eol = NULL;
   svn_boolean_t local_mod = FALSE;
-  apr_time_t tm;
-  svn_stream_t *source;
   svn_stream_t *dst_stream;
-  const char *dst_tmp;
+
+  *queue = FALSE;
+
+  if (eib->revision->kind != svn_opt_revision_working)
+    {
+      /* Only export 'added' files when the revision is WORKING. This is not
+         WORKING, so skip the 'added' files, since they didn't exist
+         in the BASE revision and don't have an associated text-base.
+
+         'replaced' files are technically the same as 'added' files.
+         ### TODO: Handle replaced nodes properly.
+         ###       svn_opt_revision_base refers to the "new"
+         ###       base of the node. That means, if a node is locally
+         ###       replaced, export skips this node, as if it was locally
+         ###       added, because svn_opt_revision_base refers to the base
+         ###       of the added node, not to the node that was deleted.
+         ###       In contrast, when the node is copied-here or moved-here,
+         ###       the copy/move source's content will be exported.
+         ###       It is currently not possible to export the revert-base
+         ###       when a node is locally replaced. We need a new
+         ###       svn_opt_revision_ enum value for proper distinction
+         ###       between revert-base and commit-base.
+
+         Copied-/moved-here nodes have a base, so export both added and
+         replaced files when they involve a copy-/move-here.
+
+         We get all this for free from evaluating SOURCE == NULL:
+       */
+      SVN_ERR(svn_wc_get_pristine_contents2(&job->source, wc_ctx,
+                                            local_abspath,
+                                            job->pool, scratch_pool));
+      if (job->source == NULL)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_wc_get_pristine_props(&props, wc_ctx, local_abspath,
+                                        scratch_pool, scratch_pool));
+    }
+  else
+    {
+      /* ### hmm. this isn't always a specialfile. this will simply open
+         ### the file readonly if it is a regular file. */
+      SVN_ERR(svn_subst_read_specialfile(&job->source, local_abspath,
+                                         job->pool, scratch_pool));
+
+      SVN_ERR(svn_wc_prop_list2(&props, wc_ctx, local_abspath, scratch_pool,
+                                scratch_pool));
+      if (status->node_status != svn_wc_status_normal)
+        local_mod = TRUE;
+    }
+
+  /* We can early-exit if we're creating a special file. */
+  special = svn_hash_gets(props, SVN_PROP_SPECIAL);
+  if (special != NULL)
+    {
+      /* Create the destination as a special file, and copy the source
+         details into the destination stream. */
+      /* ### And forget the notification */
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream, job->to_abspath,
+                                           scratch_pool, scratch_pool));
+      return svn_error_trace(
+        svn_stream_copy3(job->source, dst_stream, NULL, NULL, scratch_pool));
+    }
+
+
+  eol_style = svn_hash_gets(props, SVN_PROP_EOL_STYLE);
+  keywords = svn_hash_gets(props, SVN_PROP_KEYWORDS);
+  executable = svn_hash_gets(props, SVN_PROP_EXECUTABLE);
+
+  if (eol_style)
+    SVN_ERR(get_eol_style(&style, &job->eol, eol_style->data,
+                          eib->native_eol));
+
+  if (local_mod)
+    {
+      /* Use the modified time from the working copy of
+         the file */
+      SVN_ERR(svn_io_file_affected_time(&job->date, local_abspath,
+                                        scratch_pool));
+    }
+  else
+    {
+      job->date = status->changed_date;
+    }
+
+  if (keywords)
+    {
+      svn_revnum_t changed_rev = status->changed_rev;
+      const char *suffix;
+      const char *url = svn_path_url_add_component2(status->repos_root_url,
+                                                    status->repos_relpath,
+                                                    scratch_pool);
+      const char *author = status->changed_author;
+      if (local_mod)
+        {
+          /* For locally modified files, we'll append an 'M'
+             to the revision number, and set the author to
+             "(local)" since we can't always determine the
+             current user's username */
+          suffix = "M";
+          author = _("(local)");
+        }
+      else
+        {
+          suffix = "";
+        }
+
+      SVN_ERR(svn_subst_build_keywords3(&job->keywords, keywords->data,
+                                        apr_psprintf(scratch_pool, "%ld%s",
+                                                     changed_rev, suffix),
+                                        url, status->repos_root_url,
+                                        job->date, author, job->pool));
+
+      /* Don't translate for keywords that don't exist. */
+      if (apr_hash_count(job->keywords) == 0)
+        job->keywords = NULL;
+    }
+
+  job->expand = ! eib->ignore_keywords;
+  job->executable = (executable != NULL);
+  *queue = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Export a file or directory. Implements svn_wc_status_func4_t */
+static svn_error_t *
+export_node(void *baton,
+            const char *local_abspath,
+            const svn_wc_status3_t *status,
+            apr_pool_t *scratch_pool)
+{
+  struct export_info_baton *eib = baton;
+  export_job_t *job;
+  svn_boolean_t queue;
   svn_error_t *err;
 
   const char *to_abspath = svn_dirent_join(
@@ -294,155 +705,16 @@ export_node(void *baton,
                                                         scratch_pool));
     }
 
-  if (eib->revision->kind != svn_opt_revision_working)
+  job = create_export_job(eib->writer, to_abspath);
+  err = prepare_file_export(&queue, job, eib, local_abspath, status,
+                            scratch_pool);
+  if (err || !queue)
     {
-      /* Only export 'added' files when the revision is WORKING. This is not
-         WORKING, so skip the 'added' files, since they didn't exist
-         in the BASE revision and don't have an associated text-base.
-
-         'replaced' files are technically the same as 'added' files.
-         ### TODO: Handle replaced nodes properly.
-         ###       svn_opt_revision_base refers to the "new"
-         ###       base of the node. That means, if a node is locally
-         ###       replaced, export skips this node, as if it was locally
-         ###       added, because svn_opt_revision_base refers to the base
-         ###       of the added node, not to the node that was deleted.
-         ###       In contrast, when the node is copied-here or moved-here,
-         ###       the copy/move source's content will be exported.
-         ###       It is currently not possible to export the revert-base
-         ###       when a node is locally replaced. We need a new
-         ###       svn_opt_revision_ enum value for proper distinction
-         ###       between revert-base and commit-base.
-
-         Copied-/moved-here nodes have a base, so export both added and
-         replaced files when they involve a copy-/move-here.
-
-         We get all this for free from evaluating SOURCE == NULL:
-       */
-      SVN_ERR(svn_wc_get_pristine_contents2(&source, wc_ctx, local_abspath,
-                                            scratch_pool, scratch_pool));
-      if (source == NULL)
-        return SVN_NO_ERROR;
-
-      SVN_ERR(svn_wc_get_pristine_props(&props, wc_ctx, local_abspath,
-                                        scratch_pool, scratch_pool));
-    }
-  else
-    {
-      /* ### hmm. this isn't always a specialfile. this will simply open
-         ### the file readonly if it is a regular file. */
-      SVN_ERR(svn_subst_read_specialfile(&source, local_abspath, scratch_pool,
-                                         scratch_pool));
-
-      SVN_ERR(svn_wc_prop_list2(&props, wc_ctx, local_abspath, scratch_pool,
-                                scratch_pool));
-      if (status->node_status != svn_wc_status_normal)
-        local_mod = TRUE;
+      svn_pool_destroy(job->pool);
+      return svn_error_trace(err);
     }
 
-  /* We can early-exit if we're creating a special file. */
-  special = svn_hash_gets(props, SVN_PROP_SPECIAL);
-  if (special != NULL)
-    {
-      /* Create the destination as a special file, and copy the source
-         details into the destination stream. */
-      /* ### And forget the notification */
-      SVN_ERR(svn_subst_create_specialfile(&dst_stream, to_abspath,
-                                           scratch_pool, scratch_pool));
-      return svn_error_trace(
-        svn_stream_copy3(source, dst_stream, NULL, NULL, scratch_pool));
-    }
-
-
-  eol_style = svn_hash_gets(props, SVN_PROP_EOL_STYLE);
-  keywords = svn_hash_gets(props, SVN_PROP_KEYWORDS);
-  executable = svn_hash_gets(props, SVN_PROP_EXECUTABLE);
-
-  if (eol_style)
-    SVN_ERR(get_eol_style(&style, &eol, eol_style->data, eib->native_eol));
-
-  if (local_mod)
-    {
-      /* Use the modified time from the working copy of
-         the file */
-      SVN_ERR(svn_io_file_affected_time(&tm, local_abspath, scratch_pool));
-    }
-  else
-    {
-      tm = status->changed_date;
-    }
-
-  if (keywords)
-    {
-      svn_revnum_t changed_rev = status->changed_rev;
-      const char *suffix;
-      const char *url = svn_path_url_add_component2(status->repos_root_url,
-                                                    status->repos_relpath,
-                                                    scratch_pool);
-      const char *author = status->changed_author;
-      if (local_mod)
-        {
-          /* For locally modified files, we'll append an 'M'
-             to the revision number, and set the author to
-             "(local)" since we can't always determine the
-             current user's username */
-          suffix = "M";
-          author = _("(local)");
-        }
-      else
-        {
-          suffix = "";
-        }
-
-      SVN_ERR(svn_subst_build_keywords3(&kw, keywords->data,
-                                        apr_psprintf(scratch_pool, "%ld%s",
-                                                     changed_rev, suffix),
-                                        url, status->repos_root_url, tm,
-                                        author, scratch_pool));
-    }
-
-  /* For atomicity, we translate to a tmp file and then rename the tmp file
-     over the real destination. */
-  SVN_ERR(svn_stream_open_unique(&dst_stream, &dst_tmp,
-                                 svn_dirent_dirname(to_abspath, scratch_pool),
-                                 svn_io_file_del_none, scratch_pool,
-                                 scratch_pool));
-
-  /* If some translation is needed, then wrap the output stream (this is
-     more efficient than wrapping the input). */
-  if (eol || (kw && (apr_hash_count(kw) > 0)))
-    dst_stream = svn_subst_stream_translated(dst_stream,
-                                             eol,
-                                             FALSE /* repair */,
-                                             kw,
-                                             ! eib->ignore_keywords /* expand */,
-                                             scratch_pool);
-
-  /* ###: use cancel func/baton in place of NULL/NULL below. */
-  err = svn_stream_copy3(source, dst_stream, NULL, NULL, scratch_pool);
-
-  if (!err && executable)
-    err = svn_io_set_file_executable(dst_tmp, TRUE, FALSE, scratch_pool);
-
-  if (!err)
-    err = svn_io_set_file_affected_time(tm, dst_tmp, scratch_pool);
-
-  if (err)
-    return svn_error_compose_create(err, svn_io_remove_file2(dst_tmp, FALSE,
-                                                             scratch_pool));
-
-  /* Now that dst_tmp contains the translated data, do the atomic rename. */
-  SVN_ERR(svn_io_file_rename2(dst_tmp, to_abspath, FALSE, scratch_pool));
-
-  if (eib->notify_func)
-    {
-      svn_wc_notify_t *notify = svn_wc_create_notify(to_abspath,
-                                      svn_wc_notify_update_add, scratch_pool);
-      notify->kind = svn_node_file;
-      (eib->notify_func)(eib->notify_baton, notify, scratch_pool);
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(queue_export_job(eib->writer, job, scratch_pool));
 }
 
 /* Abstraction of open_root.
@@ -511,6 +783,9 @@ struct edit_baton
   void *cancel_baton;
   svn_wc_notify_func2_t notify_func;
   void *notify_baton;
+
+  /* Writes the translated files; not used by the Ev2 implementation. */
+  export_writer_t *writer;
 };
 
 
@@ -785,6 +1060,50 @@ change_dir_prop(void *dir_baton,
 }
 
 
+/* Queue writing the file of FB, whose contents are in its temporary file,
+   on the export writer. */
+static svn_error_t *
+queue_file_export(struct file_baton *fb,
+                  apr_pool_t *scratch_pool)
+{
+  struct edit_baton *eb = fb->edit_baton;
+  export_job_t *job = create_export_job(eb->writer, fb->path);
+  svn_subst_eol_style_t style;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  job->from_abspath = apr_pstrdup(job->pool, fb->tmppath);
+  job->expand = TRUE;
+  job->executable = (fb->executable_val != NULL);
+  job->date = fb->date;
+
+  if (fb->eol_style_val)
+    {
+      err = get_eol_style(&style, &job->eol, fb->eol_style_val->data,
+                          eb->native_eol);
+      job->repair = TRUE;
+    }
+
+  if (!err && fb->keywords_val)
+    {
+      err = svn_subst_build_keywords3(&job->keywords, fb->keywords_val->data,
+                                      fb->revision, fb->url,
+                                      fb->repos_root_url, fb->date,
+                                      fb->author, job->pool);
+
+      /* Don't translate for keywords that don't exist. */
+      if (!err && apr_hash_count(job->keywords) == 0)
+        job->keywords = NULL;
+    }
+
+  if (err)
+    {
+      svn_pool_destroy(job->pool);
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(queue_export_job(eb->writer, job, scratch_pool));
+}
+
 /* Move the tmpfile to file, and send feedback. */
 static svn_error_t *
 close_file(void *file_baton,
@@ -795,6 +1114,10 @@ close_file(void *file_baton,
   struct edit_baton *eb = fb->edit_baton;
   svn_checksum_t *text_checksum;
   svn_checksum_t *actual_checksum;
+  svn_subst_eol_style_t style;
+  const char *eol = NULL;
+  svn_boolean_t repair = FALSE;
+  apr_hash_t *final_kw = NULL;
 
   /* Was a txdelta even sent? */
   if (! fb->tmppath)
@@ -814,46 +1137,38 @@ close_file(void *file_baton,
                                      _("Checksum mismatch for '%s'"),
                                      svn_dirent_local_style(fb->path, pool));
 
-  if ((! fb->eol_style_val) && (! fb->keywords_val) && (! fb->special))
+  /* Regular files are written and notified by the export writer. */
+  if (! fb->special)
+    return svn_error_trace(queue_file_export(fb, pool));
+
+  /* Keep the notifications in order. */
+  SVN_ERR(release_exports(eb->writer));
+
+  if (fb->eol_style_val)
     {
-      SVN_ERR(svn_io_file_rename2(fb->tmppath, fb->path, FALSE, pool));
+      SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
+                            eb->native_eol));
+      repair = TRUE;
     }
-  else
-    {
-      svn_subst_eol_style_t style;
-      const char *eol = NULL;
-      svn_boolean_t repair = FALSE;
-      apr_hash_t *final_kw = NULL;
-
-      if (fb->eol_style_val)
-        {
-          SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
-                                eb->native_eol));
-          repair = TRUE;
-        }
 
-      if (fb->keywords_val)
-        SVN_ERR(svn_subst_build_keywords3(&final_kw, fb->keywords_val->data,
-                                          fb->revision, fb->url,
-                                          fb->repos_root_url, fb->date,
-                                          fb->author, pool));
+  if (fb->keywords_val)
+    SVN_ERR(svn_subst_build_keywords3(&final_kw, fb->keywords_val->data,
+                                      fb->revision, fb->url,
+                                      fb->repos_root_url, fb->date,
+                                      fb->author, pool));
 
-      SVN_ERR(svn_subst_copy_and_translate4(fb->tmppath, fb->path,
-                                            eol, repair, final_kw,
-                                            TRUE, /* expand */
-                                            fb->special,
-                                            eb->cancel_func, eb->cancel_baton,
-                                            pool));
+  SVN_ERR(svn_subst_copy_and_translate4(fb->tmppath, fb->path,
+                                        eol, repair, final_kw,
+                                        TRUE, /* expand */
+                                        TRUE, /* special */
+                                        eb->cancel_func, eb->cancel_baton,
+                                        pool));
 
-      SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
-    }
+  SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
 
   if (fb->executable_val)
     SVN_ERR(svn_io_set_file_executable(fb->path, TRUE, FALSE, pool));
 
-  if (fb->date && (! fb->special))
-    SVN_ERR(svn_io_set_file_affected_time(fb->date, fb->path, pool));
-
   if (fb->edit_baton->notify_func)
     {
       svn_wc_notify_t *notify = svn_wc_create_notify(fb->path,
@@ -1332,6 +1647,9 @@ export_directory(const char *from_url,
 
   SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
 
+  /* Wait for the files still being written. */
+  SVN_ERR(release_exports(eb->writer));
+
   /* Special case: Due to our sly export/checkout method of updating an
    * empty directory, no target will have been created if the exported
    * item is itself an empty directory (export_editor->open_root never
@@ -1424,14 +1742,18 @@ svn_client_export5(svn_revnum_t *result_rev,
       eb->cancel_baton = ctx->cancel_baton;
       eb->notify_func = ctx->notify_func2;
       eb->notify_baton = ctx->notify_baton2;
+      SVN_ERR(start_export_writer(&eb->writer, ctx, pool));
 
       SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, pool));
 
       if (kind == svn_node_file)
         {
           if (!ENABLE_EV2_IMPL)
-            SVN_ERR(export_file(from_url, to_path, eb, loc, ra_session,
-                                overwrite, pool));
+            {
+              SVN_ERR(export_file(from_url, to_path, eb, loc, ra_session,
+                                  overwrite, pool));
+              SVN_ERR(release_exports(eb->writer));
+            }
           else
             SVN_ERR(export_file_ev2(from_url, to_path, eb, loc,
                                     ra_session, overwrite, pool));
@@ -1514,6 +1836,7 @@ svn_client_export5(svn_revnum_t *result_rev,
       eib.notify_baton = ctx->notify_baton2;
       eib.origin_abspath = from_path_or_url;
       eib.exported = FALSE;
+      SVN_ERR(start_export_writer(&eib.writer, ctx, pool));
 
       SVN_ERR(svn_wc_walk_status(ctx->wc_ctx, from_path_or_url, depth,
                                  TRUE /* get_all */,
@@ -1524,6 +1847,9 @@ svn_client_export5(svn_revnum_t *result_rev,
                                  ctx->cancel_func, ctx->cancel_baton,
                                  pool));
 
+      /* Wait for the files still being written. */
+      SVN_ERR(release_exports(eib.writer));
+
       if (!eib.exported)
         return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
                                  _("The node '%s' was not found."),
@@ -41,6 +41,8 @@
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 
@@ -745,86 +747,442 @@ handle_external_item_removal(const svn_client_ctx_t *ctx,
   return svn_error_trace(err);
 }
 
-static svn_error_t *
-handle_external_item_change(svn_client_ctx_t *ctx,
-                            const char *repos_root_url,
-                            const char *parent_dir_abspath,
-                            const char *parent_dir_url,
-                            const char *local_abspath,
-                            const char *old_defining_abspath,
-                            const svn_wc_external_item2_t *new_item,
-                            svn_ra_session_t *ra_session,
-                            svn_boolean_t *timestamp_sleep,
-                            apr_pool_t *scratch_pool)
+/* Default and maximum number of threads resolving externals. */
+#define EXTERNALS_DEFAULT_JOBS 4
+#define EXTERNALS_MAX_JOBS 64
+
+/* An RA session used for resolving and updating externals. */
+typedef struct external_session_t
 {
-  svn_client__pathrev_t *new_loc;
+  svn_ra_session_t *ra_session;
+  const char *repos_root_url;
+
+  /* Root pool of RA_SESSION, or NULL if it belongs to our caller. */
+  apr_pool_t *pool;
+} external_session_t;
+
+typedef struct externals_resolver_t externals_resolver_t;
+
+/* A new or changed external definition, see handle_externals_change(). */
+typedef struct external_change_t
+{
+  /* The directory defining the external, and its URL. */
+  const char *parent_dir_abspath;
+  const char *parent_dir_url;
+
+  /* The target of the external, and the directory that defined it
+     before, if any. */
+  const char *local_abspath;
+  const char *old_defining_abspath;
+
+  const svn_wc_external_item2_t *new_item;
+
+  /* The absolute URL given by NEW_ITEM. */
   const char *new_url;
+
+  /* Private pool of the results below, other than SESSION.  It is a root
+     pool because the results get allocated by a task. */
+  apr_pool_t *pool;
+
+  /* The session pointing to the external, its location and node kind, or
+     the error finding them.  Valid once DONE has been set. */
+  external_session_t *session;
+  svn_client__pathrev_t *new_loc;
   svn_node_kind_t ext_kind;
+  svn_error_t *err;
+  svn_boolean_t done;
 
-  SVN_ERR_ASSERT(repos_root_url && parent_dir_url);
-  SVN_ERR_ASSERT(new_item != NULL);
+  externals_resolver_t *resolver;
+} external_change_t;
 
-  /* Don't bother to check status, since we'll get that for free by
-     attempting to retrieve the hash values anyway.  */
+/* Finds the locations of externals concurrently, so that the network
+   round trips for many externals overlap.  The working copy is only
+   changed by the main thread, one external after the other in the order
+   of their definitions, so their notifications don't get mixed up. */
+struct externals_resolver_t
+{
+  /* Root pool holding the thread-related objects below. */
+  apr_pool_t *pool;
 
-  /* When creating the absolute URL, use the pool and not the
-     iterpool, since the hash table values outlive the iterpool and
-     any pointers they have should also outlive the iterpool.  */
+  svn_client_ctx_t *ctx;
 
-  SVN_ERR(svn_wc__resolve_relative_external_url(&new_url,
-                                                new_item, repos_root_url,
-                                                parent_dir_url,
-                                                scratch_pool, scratch_pool));
+  /* Don't resolve more than this many changes ahead of the one being
+     applied. */
+  int max_running;
+
+  /* Runs resolve_change_task() for the changes.  NULL if the changes are
+     resolved on the main thread. */
+  svn_task__set_t *set;
+
+  /* Protects the session lists. */
+  svn_mutex__t *mutex;
+
+  /* CTX->auth_baton is not thread-safe, so sessions are opened one at a
+     time while holding this. */
+  svn_mutex__t *open_mutex;
+
+  /* The sessions not used by any change (external_session_t *), and all
+     sessions opened by us. */
+  apr_array_header_t *idle_sessions;
+  apr_array_header_t *sessions;
+
+  /* All changes to handle (external_change_t *).  Their results are
+     released by the main thread once applied. */
+  apr_array_header_t *changes;
+};
 
-  /* Determine if the external is a file or directory. */
-  /* Get the RA connection, if needed. */
-  if (ra_session)
+/* Set *SESSION to an idle session of RESOLVER into the repository of URL,
+   or to NULL if there is none.  The caller must release it. */
+static svn_error_t *
+take_idle_session(external_session_t **session,
+                  externals_resolver_t *resolver,
+                  const char *url,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+
+  *session = NULL;
+
+  SVN_ERR(svn_mutex__lock(resolver->mutex));
+  for (i = resolver->idle_sessions->nelts - 1; i >= 0; i--)
     {
-      svn_error_t *err = svn_ra_reparent(ra_session, new_url, scratch_pool);
+      external_session_t *idle
+        = APR_ARRAY_IDX(resolver->idle_sessions, i, external_session_t *);
 
-      if (err)
+      if (svn_uri_skip_ancestor(idle->repos_root_url, url, scratch_pool))
         {
-          if (err->apr_err == SVN_ERR_RA_ILLEGAL_URL)
-            {
-              svn_error_clear(err);
-              ra_session = NULL;
-            }
-          else
-            return svn_error_trace(err);
+          *session = idle;
+          APR_ARRAY_IDX(resolver->idle_sessions, i, external_session_t *)
+            = APR_ARRAY_IDX(resolver->idle_sessions,
+                            resolver->idle_sessions->nelts - 1,
+                            external_session_t *);
+          apr_array_pop(resolver->idle_sessions);
+          break;
         }
-      else
+    }
+
+  return svn_error_trace(svn_mutex__unlock(resolver->mutex, SVN_NO_ERROR));
+}
+
+/* Make SESSION of RESOLVER available to other changes. */
+static svn_error_t *
+release_session(externals_resolver_t *resolver,
+                external_session_t *session)
+{
+  SVN_ERR(svn_mutex__lock(resolver->mutex));
+  APR_ARRAY_PUSH(resolver->idle_sessions, external_session_t *) = session;
+
+  return svn_error_trace(svn_mutex__unlock(resolver->mutex, SVN_NO_ERROR));
+}
+
+/* Set *SESSION to a new session of RESOLVER opened to URL and *CORRECTED_URL
+   to the URL it was opened to after following redirects, allocated in
+   RESULT_POOL.  The caller must release the session. */
+static svn_error_t *
+open_session(external_session_t **session,
+             const char **corrected_url,
+             externals_resolver_t *resolver,
+             const char *url,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  external_session_t *es = apr_pcalloc(pool, sizeof(*es));
+  svn_error_t *err;
+
+  es->pool = pool;
+
+  err = svn_mutex__lock(resolver->open_mutex);
+  if (!err)
+    err = svn_mutex__unlock(resolver->open_mutex,
+                            svn_client__open_ra_session_internal(
+                              &es->ra_session, corrected_url, url,
+                              NULL, NULL, FALSE, FALSE, resolver->ctx,
+                              pool, scratch_pool));
+
+  if (!err)
+    err = svn_ra_get_repos_root2(es->ra_session, &es->repos_root_url, pool);
+
+  if (!err)
+    err = svn_mutex__lock(resolver->mutex);
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  APR_ARRAY_PUSH(resolver->sessions, external_session_t *) = es;
+  SVN_ERR(svn_mutex__unlock(resolver->mutex, SVN_NO_ERROR));
+
+  *corrected_url = *corrected_url ? apr_pstrdup(result_pool, *corrected_url)
+                                  : url;
+  *session = es;
+
+  return SVN_NO_ERROR;
+}
+
+/* Find the session, location and node kind of CHANGE using RESOLVER.
+   May run on a worker thread. */
+static svn_error_t *
+resolve_external_change(external_change_t *change,
+                        externals_resolver_t *resolver)
+{
+  const svn_wc_external_item2_t *new_item = change->new_item;
+  const char *url = change->new_url;
+  apr_pool_t *pool = change->pool;
+
+  /* Reuse a session into the same repository, if possible. */
+  SVN_ERR(take_idle_session(&change->session, resolver, url, pool));
+  if (change->session)
+    {
+      svn_error_t *err = svn_ra_reparent(change->session->ra_session, url,
+                                         pool);
+
+      if (err)
         {
-          SVN_ERR(svn_client__resolve_rev_and_url(&new_loc,
-                                                  ra_session, new_url,
-                                                  &(new_item->peg_revision),
-                                                  &(new_item->revision), ctx,
-                                                  scratch_pool));
+          if (err->apr_err != SVN_ERR_RA_ILLEGAL_URL)
+            return svn_error_trace(err);
 
-          SVN_ERR(svn_ra_reparent(ra_session, new_loc->url, scratch_pool));
+          svn_error_clear(err);
+          SVN_ERR(release_session(resolver, change->session));
+          change->session = NULL;
         }
     }
 
-  if (!ra_session)
-    SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &new_loc,
-                                              new_url, NULL,
-                                              &(new_item->peg_revision),
-                                              &(new_item->revision), ctx,
-                                              scratch_pool));
+  if (!change->session)
+    SVN_ERR(open_session(&change->session, &url, resolver, url, pool, pool));
 
-  SVN_ERR(svn_ra_check_path(ra_session, "", new_loc->rev, &ext_kind,
-                            scratch_pool));
+  SVN_ERR(svn_client__resolve_rev_and_url(&change->new_loc,
+                                          change->session->ra_session, url,
+                                          &new_item->peg_revision,
+                                          &new_item->revision,
+                                          resolver->ctx, pool));
+  SVN_ERR(svn_ra_reparent(change->session->ra_session, change->new_loc->url,
+                          pool));
+
+  SVN_ERR(svn_ra_check_path(change->session->ra_session, "",
+                            change->new_loc->rev, &change->ext_kind, pool));
 
-  if (svn_node_none == ext_kind)
+  if (svn_node_none == change->ext_kind)
     return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
                              _("URL '%s' at revision %ld doesn't exist"),
-                             new_loc->url, new_loc->rev);
+                             change->new_loc->url, change->new_loc->rev);
 
-  if (svn_node_dir != ext_kind && svn_node_file != ext_kind)
+  if (svn_node_dir != change->ext_kind && svn_node_file != change->ext_kind)
     return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
                              _("URL '%s' at revision %ld is not a file "
                                "or a directory"),
-                             new_loc->url, new_loc->rev);
+                             change->new_loc->url, change->new_loc->rev);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Resolve the external_change_t
+   in PROCESS_BATON and return it in *RESULT.  The change belongs to this
+   task until its result has been delivered, so failures get recorded in
+   the change and reported when it gets applied. */
+static svn_error_t *
+resolve_change_task(void **result,
+                    void *process_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  external_change_t *change = process_baton;
+
+  change->err = resolve_external_change(change, change->resolver);
+
+  *result = change;
+  return SVN_NO_ERROR;
+}
 
+/* Implements svn_task__output_func_t.  Mark the external_change_t in
+   RESULT as resolved. */
+static svn_error_t *
+deliver_change(void *result,
+               void *output_baton,
+               apr_pool_t *scratch_pool)
+{
+  external_change_t *change = result;
+
+  change->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Start resolving CHANGE with RESOLVER. */
+static svn_error_t *
+queue_resolution(externals_resolver_t *resolver,
+                 external_change_t *change)
+{
+  /* Changes with invalid definitions are done already. */
+  if (change->done)
+    return SVN_NO_ERROR;
+
+  change->pool = svn_pool_create(NULL);
+  change->resolver = resolver;
+
+  if (resolver->set)
+    return svn_error_trace(svn_task__add(resolver->set, resolve_change_task,
+                                         change));
+
+  change->err = resolve_external_change(change, resolver);
+  change->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until RESOLVER is done with CHANGE. */
+static svn_error_t *
+wait_for_resolution(externals_resolver_t *resolver,
+                    external_change_t *change)
+{
+  /* This waits for all queued changes but there are at most MAX_RUNNING
+     of them. */
+  if (!change->done)
+    SVN_ERR(svn_task__set_finish(resolver->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the session and the results of the resolved CHANGE. */
+static svn_error_t *
+release_change(externals_resolver_t *resolver,
+               external_change_t *change)
+{
+  if (change->session)
+    SVN_ERR(release_session(resolver, change->session));
+  change->session = NULL;
+
+  svn_error_clear(change->err);
+  change->err = SVN_NO_ERROR;
+  if (change->pool)
+    svn_pool_destroy(change->pool);
+  change->pool = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function releasing the unapplied changes and the sessions
+   of the externals_resolver_t in DATA.  Its task set is gone by then. */
+static apr_status_t
+cleanup_externals_resolver(void *data)
+{
+  externals_resolver_t *resolver = data;
+  int i;
+
+  for (i = 0; i < resolver->changes->nelts; i++)
+    {
+      external_change_t *change = APR_ARRAY_IDX(resolver->changes, i,
+                                                external_change_t *);
+
+      svn_error_clear(change->err);
+      if (change->pool)
+        svn_pool_destroy(change->pool);
+    }
+
+  for (i = 0; i < resolver->sessions->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(resolver->sessions, i,
+                                   external_session_t *)->pool);
+
+  svn_pool_destroy(resolver->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *RESOLVER to a new resolver for CHANGES, using as many threads as
+   configured in CTX.  RA_SESSION, if not NULL, may be used for changes in
+   its repository.  The resolver is terminated when RESULT_POOL gets
+   cleaned up. */
+static svn_error_t *
+start_externals_resolver(externals_resolver_t **resolver,
+                         apr_array_header_t *changes,
+                         svn_ra_session_t *ra_session,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *result_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_pool_t *pool;
+  externals_resolver_t *er;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_EXTERNALS_JOBS,
+                             EXTERNALS_DEFAULT_JOBS);
+  if (err || jobs < 1 || jobs > EXTERNALS_MAX_JOBS)
+    {
+      svn_error_clear(err);
+      jobs = EXTERNALS_DEFAULT_JOBS;
+    }
+
+  /* There is nothing to overlap for a single change. */
+  if (changes->nelts < 2)
+    jobs = 1;
+
+  pool = svn_pool_create(NULL);
+  er = apr_pcalloc(pool, sizeof(*er));
+  er->pool = pool;
+  er->ctx = ctx;
+  er->changes = changes;
+  er->idle_sessions = apr_array_make(pool, 4, sizeof(external_session_t *));
+  er->sessions = apr_array_make(pool, 4, sizeof(external_session_t *));
+
+  /* When resolving on the main thread, resolve each change just before
+     applying it, so that its session may be reused by the next one. */
+  er->max_running = (jobs > 1) ? 2 * (int)jobs : 1;
+
+  err = svn_mutex__init(&er->mutex, jobs > 1, pool);
+  if (!err)
+    err = svn_mutex__init(&er->open_mutex, jobs > 1, pool);
+  if (!err && ra_session)
+    {
+      external_session_t *es = apr_pcalloc(pool, sizeof(*es));
+
+      es->ra_session = ra_session;
+      err = svn_ra_get_repos_root2(ra_session, &es->repos_root_url, pool);
+      APR_ARRAY_PUSH(er->idle_sessions, external_session_t *) = es;
+    }
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  apr_pool_cleanup_register(result_pool, er, cleanup_externals_resolver,
+                            apr_pool_cleanup_null);
+
+  /* The set lives in a sub-pool, which gets destroyed before the cleanup
+     functions of RESULT_POOL run.  Thus, no task will be using the changes
+     and sessions when cleanup_externals_resolver() releases them. */
+  if (jobs > 1)
+    SVN_ERR(svn_task__set_create(&er->set, (int)jobs, deliver_change, er,
+                                 NULL, NULL, svn_pool_create(result_pool)));
+
+  *resolver = er;
+
+  return SVN_NO_ERROR;
+}
+
+/* Check out, update or switch the external described by the resolved
+   CHANGE in the working copy. */
+static svn_error_t *
+handle_external_item_change(svn_client_ctx_t *ctx,
+                            const char *repos_root_url,
+                            const external_change_t *change,
+                            svn_boolean_t *timestamp_sleep,
+                            apr_pool_t *scratch_pool)
+{
+  const char *parent_dir_abspath = change->parent_dir_abspath;
+  const char *local_abspath = change->local_abspath;
+  const svn_wc_external_item2_t *new_item = change->new_item;
+  svn_ra_session_t *ra_session = change->session->ra_session;
+  svn_client__pathrev_t *new_loc = change->new_loc;
+  const char *new_url = change->new_url;
 
   /* Not protecting against recursive externals.  Detecting them in
      the global case is hard, and it should be pretty obvious to a
@@ -841,7 +1199,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
          scratch_pool);
     }
 
-  if (! old_defining_abspath)
+  if (! change->old_defining_abspath)
     {
       /* The target dir might have multiple components.  Guarantee the path
          leading down to the last component. */
@@ -850,7 +1208,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                           scratch_pool));
     }
 
-  switch (ext_kind)
+  switch (change->ext_kind)
     {
       case svn_node_dir:
         SVN_ERR(switch_dir_external(local_abspath, new_loc->url,
@@ -958,25 +1316,25 @@ wrap_external_error(const svn_client_ctx_t *ctx,
   return err;
 }
 
+/* Add the externals defined by NEW_DESC_TEXT on LOCAL_ABSPATH to CHANGES
+   as external_change_t *, allocated in RESULT_POOL.  Remove them from
+   OLD_EXTERNALS. */
 static svn_error_t *
-handle_externals_change(svn_client_ctx_t *ctx,
+handle_externals_change(apr_array_header_t *changes,
+                        svn_client_ctx_t *ctx,
                         const char *repos_root_url,
-                        svn_boolean_t *timestamp_sleep,
                         const char *local_abspath,
                         const char *new_desc_text,
                         apr_hash_t *old_externals,
                         svn_depth_t ambient_depth,
                         svn_depth_t requested_depth,
-                        svn_ra_session_t *ra_session,
+                        apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
   int i;
-  apr_pool_t *iterpool;
   const char *url;
 
-  iterpool = svn_pool_create(scratch_pool);
-
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
   /* Bag out if the depth here is too shallow for externals action. */
@@ -989,32 +1347,27 @@ handle_externals_change(svn_client_ctx_t *ctx,
   if (new_desc_text)
     SVN_ERR(svn_wc_parse_externals_description3(&new_desc, local_abspath,
                                                 new_desc_text,
-                                                FALSE, scratch_pool));
+                                                FALSE, result_pool));
   else
     new_desc = NULL;
 
   SVN_ERR(svn_wc__node_get_url(&url, ctx->wc_ctx, local_abspath,
-                               scratch_pool, iterpool));
+                               result_pool, scratch_pool));
 
   SVN_ERR_ASSERT(url);
 
   for (i = 0; new_desc && (i < new_desc->nelts); i++)
     {
-      const char *old_defining_abspath;
+      external_change_t *change;
       svn_wc_external_item2_t *new_item;
       const char *target_abspath;
       svn_boolean_t under_root;
 
       new_item = APR_ARRAY_IDX(new_desc, i, svn_wc_external_item2_t *);
 
-      svn_pool_clear(iterpool);
-
-      if (ctx->cancel_func)
-        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
-
       SVN_ERR(svn_dirent_is_under_root(&under_root, &target_abspath,
                                        local_abspath, new_item->target_dir,
-                                       iterpool));
+                                       result_pool));
 
       if (! under_root)
         {
@@ -1023,30 +1376,94 @@ handle_externals_change(svn_client_ctx_t *ctx,
                     _("Path '%s' is not in the working copy"),
                     svn_dirent_local_style(
                         svn_dirent_join(local_abspath, new_item->target_dir,
-                                        iterpool),
-                        iterpool));
+                                        scratch_pool),
+                        scratch_pool));
         }
 
-      old_defining_abspath = svn_hash_gets(old_externals, target_abspath);
+      change = apr_pcalloc(result_pool, sizeof(*change));
+      change->parent_dir_abspath = local_abspath;
+      change->parent_dir_url = url;
+      change->local_abspath = target_abspath;
+      change->old_defining_abspath = svn_hash_gets(old_externals,
+                                                   target_abspath);
+      change->new_item = new_item;
+
+      /* A definition we can't make sense of fails without any network
+         access. */
+      change->err = svn_wc__resolve_relative_external_url(
+                                                &change->new_url,
+                                                new_item, repos_root_url,
+                                                url, result_pool,
+                                                scratch_pool);
+      change->done = (change->err != SVN_NO_ERROR);
 
-      SVN_ERR(wrap_external_error(
-                      ctx, target_abspath,
-                      handle_external_item_change(ctx,
-                                                  repos_root_url,
-                                                  local_abspath, url,
-                                                  target_abspath,
-                                                  old_defining_abspath,
-                                                  new_item, ra_session,
-                                                  timestamp_sleep,
-                                                  iterpool),
-                      iterpool));
+      APR_ARRAY_PUSH(changes, external_change_t *) = change;
 
-      /* And remove already processed items from the to-remove hash */
-      if (old_defining_abspath)
+      /* And remove the items to handle from the to-remove hash */
+      if (change->old_defining_abspath)
         svn_hash_sets(old_externals, target_abspath, NULL);
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Handle the external_change_t * in CHANGES in order, as described for
+   svn_client__handle_externals().  Resolve the locations of the externals
+   ahead of their use, on as many worker threads as configured in CTX. */
+static svn_error_t *
+handle_external_changes(apr_array_header_t *changes,
+                        const char *repos_root_url,
+                        svn_boolean_t *timestamp_sleep,
+                        svn_ra_session_t *ra_session,
+                        svn_client_ctx_t *ctx,
+                        apr_pool_t *scratch_pool)
+{
+  externals_resolver_t *resolver;
+  apr_pool_t *resolver_pool;
+  apr_pool_t *iterpool;
+  int queued = 0;
+  int i;
+
+  if (changes->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Terminates the resolver and closes its sessions when destroyed. */
+  resolver_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(start_externals_resolver(&resolver, changes, ra_session, ctx,
+                                   resolver_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      external_change_t *change = APR_ARRAY_IDX(changes, i,
+                                                external_change_t *);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      while (queued < changes->nelts && queued - i < resolver->max_running)
+        SVN_ERR(queue_resolution(resolver,
+                                 APR_ARRAY_IDX(changes, queued++,
+                                               external_change_t *)));
+
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      SVN_ERR(wait_for_resolution(resolver, change));
+
+      err = change->err;
+      change->err = SVN_NO_ERROR;
+      if (!err)
+        err = handle_external_item_change(ctx, repos_root_url, change,
+                                          timestamp_sleep, iterpool);
+
+      err = svn_error_compose_create(err, release_change(resolver, change));
+      SVN_ERR(wrap_external_error(ctx, change->local_abspath, err,
+                                  iterpool));
+    }
+
   svn_pool_destroy(iterpool);
+  svn_pool_destroy(resolver_pool);
 
   return SVN_NO_ERROR;
 }
@@ -1064,11 +1481,16 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                              apr_pool_t *scratch_pool)
 {
   apr_hash_t *old_external_defs;
+  apr_array_header_t *changes;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
 
   SVN_ERR_ASSERT(repos_root_url);
 
+  changes = apr_array_make(scratch_pool, apr_hash_count(externals_new),
+                           sizeof(external_change_t *));
+
   iterpool = svn_pool_create(scratch_pool);
 
   SVN_ERR(svn_wc__externals_defined_below(&old_external_defs,
@@ -1105,13 +1527,21 @@ svn_client__handle_externals(apr_hash_t *externals_new,
             }
         }
 
-      SVN_ERR(handle_externals_change(ctx, repos_root_url, timestamp_sleep,
-                                      local_abspath,
-                                      desc_text, old_external_defs,
-                                      ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+      err = handle_externals_change(changes, ctx, repos_root_url,
+                                    local_abspath,
+                                    desc_text, old_external_defs,
+                                    ambient_depth, requested_depth,
+                                    scratch_pool, iterpool);
+      if (err)
+        break;
     }
 
+  /* Handle what we found, even if a definition was invalid. */
+  SVN_ERR(svn_error_compose_create(
+            handle_external_changes(changes, repos_root_url, timestamp_sleep,
+                                    ra_session, ctx, scratch_pool),
+            err));
+
   /* Remove the remaining externals */
   for (hi = apr_hash_first(scratch_pool, old_external_defs);
        hi;
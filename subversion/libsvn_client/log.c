@@ -40,6 +40,7 @@
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
 #include <assert.h>
@@ -299,6 +300,268 @@ limit_receiver(void *baton, svn_log_entry_t *log_entry, apr_pool_t *pool)
   return rb->receiver(rb->baton, log_entry, pool);
 }
 
+/* Return the svn:date of LOG_ENTRY or NULL if it has none. */
+static const svn_string_t *
+log_entry_date(const svn_log_entry_t *log_entry)
+{
+  return log_entry->revprops
+         ? svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_DATE)
+         : NULL;
+}
+
+/* Baton for uncached_revs_receiver(). */
+typedef struct uncached_revs_baton_t
+{
+  svn_client__log_cache_t *cache;
+
+  /* The revisions (svn_revnum_t) not held by CACHE, possibly repeated. */
+  apr_array_header_t *revisions;
+} uncached_revs_baton_t;
+
+/* Implements svn_log_entry_receiver_t, collecting the revisions missing
+   from a log cache. */
+static svn_error_t *
+uncached_revs_receiver(void *baton, svn_log_entry_t *log_entry,
+                       apr_pool_t *pool)
+{
+  uncached_revs_baton_t *b = baton;
+  svn_boolean_t contains;
+
+  if (log_entry->revision == SVN_INVALID_REVNUM)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_client__log_cache_contains(&contains, b->cache,
+                                         log_entry->revision,
+                                         log_entry_date(log_entry), pool));
+  if (!contains)
+    APR_ARRAY_PUSH(b->revisions, svn_revnum_t) = log_entry->revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for fill_cache_receiver(). */
+typedef struct fill_cache_baton_t
+{
+  svn_client__log_cache_t *cache;
+
+  /* The number of revisions stored in CACHE. */
+  svn_revnum_t count;
+} fill_cache_baton_t;
+
+/* Implements svn_log_entry_receiver_t, storing the changed paths of each
+   revision in a log cache. */
+static svn_error_t *
+fill_cache_receiver(void *baton, svn_log_entry_t *log_entry,
+                    apr_pool_t *pool)
+{
+  fill_cache_baton_t *b = baton;
+
+  if (log_entry->revision == SVN_INVALID_REVNUM)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_client__log_cache_set(b->cache, log_entry->revision,
+                                    log_entry_date(log_entry),
+                                    log_entry->changed_paths2, pool));
+  b->count++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for cached_changes_receiver(). */
+typedef struct cached_changes_baton_t
+{
+  svn_client__log_cache_t *cache;
+  svn_log_entry_receiver_t receiver;
+  void *baton;
+} cached_changes_baton_t;
+
+/* Implements svn_log_entry_receiver_t, adding the changed paths held by
+   a log cache to each log entry. */
+static svn_error_t *
+cached_changes_receiver(void *baton, svn_log_entry_t *log_entry,
+                        apr_pool_t *pool)
+{
+  cached_changes_baton_t *b = baton;
+
+  if (log_entry->revision != SVN_INVALID_REVNUM)
+    {
+      SVN_ERR(svn_client__log_cache_get(&log_entry->changed_paths2, b->cache,
+                                        log_entry->revision, pool, pool));
+      if (log_entry->changed_paths2 == NULL)
+        return svn_error_createf(SVN_ERR_INCOMPLETE_DATA, NULL,
+                                 _("Changed paths of revision %ld are "
+                                   "missing from the log cache"),
+                                 log_entry->revision);
+      log_entry->changed_paths = log_entry->changed_paths2;
+    }
+
+  return b->receiver(b->baton, log_entry, pool);
+}
+
+/* Store the paths changed in REVISIONS, an array of svn_revnum_t sorted
+   from youngest to oldest, in CACHE.  RA_SESSION is an open session
+   pointing to the repository root.
+
+   Set *COMPLETE to FALSE if this failed for any of the revisions. */
+static svn_error_t *
+fill_log_cache(svn_boolean_t *complete,
+               svn_client__log_cache_t *cache,
+               svn_ra_session_t *ra_session,
+               const apr_array_header_t *revisions,
+               apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths;
+  apr_array_header_t *revprops;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i = 0;
+
+  *complete = FALSE;
+
+  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_DATE;
+
+  while (i < revisions->nelts)
+    {
+      svn_revnum_t youngest = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_revnum_t oldest = youngest;
+      fill_cache_baton_t fb;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Get runs of consecutive revisions with a single request. */
+      for (i++; i < revisions->nelts; i++)
+        {
+          svn_revnum_t rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+
+          if (rev == oldest)
+            continue;
+          else if (rev != oldest - 1)
+            break;
+
+          oldest = rev;
+        }
+
+      fb.cache = cache;
+      fb.count = 0;
+      err = svn_ra_get_log2(ra_session, paths, youngest, oldest,
+                            0, /* no limit */
+                            TRUE, /* discover_changed_paths */
+                            TRUE, /* strict_node_history */
+                            FALSE, /* include_merged_revisions */
+                            revprops,
+                            fill_cache_receiver, &fb,
+                            iterpool);
+
+      /* E.g. the root may not be readable. */
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+
+      if (fb.count != youngest - oldest + 1)
+        {
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  *complete = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_get_log2() with DISCOVER_CHANGED_PATHS set, but take the
+   changed paths from CACHE after storing those missing from it.
+
+   The other arguments are as for svn_ra_get_log2(), REPOS_ROOT_URL is
+   the root of RA_SESSION's repository.
+
+   The revisions the log consists of are found first, with their commit
+   times only, then the changed paths missing from CACHE or cached for a
+   different commit time are fetched from the repository root, and
+   finally the log is retrieved with all revision properties but without
+   changed paths.  Revision properties are never taken from CACHE.
+
+   Set *HANDLED to TRUE on success.  Set it to FALSE without calling
+   RECEIVER if CACHE can't be filled. */
+static svn_error_t *
+get_log_with_cache(svn_boolean_t *handled,
+                   svn_client__log_cache_t *cache,
+                   svn_ra_session_t *ra_session,
+                   const char *repos_root_url,
+                   const apr_array_header_t *paths,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   int limit,
+                   svn_boolean_t strict_node_history,
+                   svn_boolean_t include_merged_revisions,
+                   const apr_array_header_t *revprops,
+                   svn_log_entry_receiver_t receiver,
+                   void *receiver_baton,
+                   apr_pool_t *scratch_pool)
+{
+  uncached_revs_baton_t ub;
+  cached_changes_baton_t cb;
+  apr_array_header_t *date_revprops;
+  svn_error_t *err;
+
+  *handled = FALSE;
+
+  date_revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(date_revprops, const char *) = SVN_PROP_REVISION_DATE;
+
+  ub.cache = cache;
+  ub.revisions = apr_array_make(scratch_pool, 0, sizeof(svn_revnum_t));
+  err = svn_ra_get_log2(ra_session, paths, start, end, limit,
+                        FALSE, /* discover_changed_paths */
+                        strict_node_history, include_merged_revisions,
+                        date_revprops,
+                        uncached_revs_receiver, &ub,
+                        scratch_pool);
+  if (err)
+    {
+      /* The plain request will report this. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (ub.revisions->nelts)
+    {
+      const char *old_session_url;
+      svn_boolean_t complete;
+
+      svn_sort__array(ub.revisions, svn_sort_compare_revisions);
+
+      SVN_ERR(svn_client__ensure_ra_session_url(&old_session_url, ra_session,
+                                                repos_root_url,
+                                                scratch_pool));
+      SVN_ERR(fill_log_cache(&complete, cache, ra_session, ub.revisions,
+                             scratch_pool));
+      SVN_ERR(svn_ra_reparent(ra_session, old_session_url, scratch_pool));
+
+      if (!complete)
+        return SVN_NO_ERROR;
+    }
+
+  cb.cache = cache;
+  cb.receiver = receiver;
+  cb.baton = receiver_baton;
+  SVN_ERR(svn_ra_get_log2(ra_session, paths, start, end, limit,
+                          FALSE, /* discover_changed_paths */
+                          strict_node_history, include_merged_revisions,
+                          revprops,
+                          cached_changes_receiver, &cb,
+                          scratch_pool));
+
+  *handled = TRUE;
+  return SVN_NO_ERROR;
+}
+
 /* Resolve the URLs or WC path in TARGETS as per the svn_client_log5 API.
 
    The limitations on TARGETS specified by svn_client_log5 are enforced here.
@@ -658,11 +921,23 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
   pre_15_receiver_baton_t rb = {0};
   apr_pool_t *iterpool;
   svn_boolean_t has_log_revprops;
+  svn_client__log_cache_t *log_cache = NULL;
 
   SVN_ERR(svn_ra_has_capability(ra_session, &has_log_revprops,
                                 SVN_RA_CAPABILITY_LOG_REVPROPS,
                                 scratch_pool));
 
+  /* Only servers returning revprops with the log are worth the extra
+     requests the log cache needs to find the revisions. */
+  if (discover_changed_paths && has_log_revprops)
+    {
+      const char *repos_uuid;
+
+      SVN_ERR(svn_ra_get_uuid2(ra_session, &repos_uuid, scratch_pool));
+      SVN_ERR(svn_client__log_cache_open(&log_cache, repos_uuid, ctx,
+                                         scratch_pool, scratch_pool));
+    }
+
   if (!has_log_revprops)
     {
       /* See above pre-1.5 notes. */
@@ -733,6 +1008,7 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
       const apr_array_header_t *passed_receiver_revprops;
       svn_location_segment_t **matching_segment;
       svn_revnum_t younger_rev;
+      svn_boolean_t handled = FALSE;
 
       svn_pool_clear(iterpool);
 
@@ -806,18 +1082,29 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
           passed_receiver_baton = &lb;
         }
 
-      SVN_ERR(svn_ra_get_log2(ra_session,
-                              paths,
-                              range->range_start,
-                              range->range_end,
-                              limit,
-                              discover_changed_paths,
-                              strict_node_history,
-                              include_merged_revisions,
-                              passed_receiver_revprops,
-                              passed_receiver,
-                              passed_receiver_baton,
-                              iterpool));
+      if (log_cache)
+        SVN_ERR(get_log_with_cache(&handled, log_cache, ra_session,
+                                   actual_loc->repos_root_url, paths,
+                                   range->range_start, range->range_end,
+                                   limit, strict_node_history,
+                                   include_merged_revisions,
+                                   passed_receiver_revprops,
+                                   passed_receiver, passed_receiver_baton,
+                                   iterpool));
+
+      if (!handled)
+        SVN_ERR(svn_ra_get_log2(ra_session,
+                                paths,
+                                range->range_start,
+                                range->range_end,
+                                limit,
+                                discover_changed_paths,
+                                strict_node_history,
+                                include_merged_revisions,
+                                passed_receiver_revprops,
+                                passed_receiver,
+                                passed_receiver_baton,
+                                iterpool));
 
       if (limit && revision_ranges->nelts > 1)
         {
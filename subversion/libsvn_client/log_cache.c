@@ -0,0 +1,391 @@
+/*
+ * log_cache.c -- Keep changed-path lists of revisions on disk
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The paths changed in a revision never change, so they can be kept
+ * locally once fetched.  The log cache keeps one small file per revision
+ * in the user's configuration area:
+ *
+ *   log-cache/REPOS-UUID/SHARD/REVISION
+ *
+ * where SHARD is REVISION / SVN_CLIENT__LOG_CACHE_SHARD_SIZE.  Each file
+ * holds a skel (DATE CHANGES) where DATE is the svn:date of the revision,
+ * or an empty list if it has none, and CHANGES is the skel written by
+ * svn_client__unparse_changed_paths().  The date tells a cached revision
+ * from a different one with the same number, e.g. after the repository
+ * has been reloaded with its old UUID.  */
+
+#include <string.h>
+
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "client.h"
+
+/* Number of revisions per directory of the log cache. */
+#define SVN_CLIENT__LOG_CACHE_SHARD_SIZE 1000
+
+struct svn_client__log_cache_t
+{
+  /* The directory holding the shards of one repository. */
+  const char *repos_dir;
+
+  /* Revisions that could not be written to disk, mapping svn_revnum_t
+     to the unparsed skel as svn_stringbuf_t *.  Allocated in POOL. */
+  apr_hash_t *unwritten;
+  apr_pool_t *pool;
+};
+
+svn_skel_t *
+svn_client__unparse_changed_paths(apr_hash_t *changed_paths,
+                                  apr_pool_t *result_pool)
+{
+  svn_skel_t *changes_skel = svn_skel__make_empty_list(result_pool);
+  apr_hash_index_t *hi;
+
+  if (changed_paths == NULL)
+    return changes_skel;
+
+  for (hi = apr_hash_first(result_pool, changed_paths);
+       hi != NULL;
+       hi = apr_hash_next(hi))
+    {
+      const char *changed_path = apr_hash_this_key(hi);
+      const svn_log_changed_path2_t *log_item = apr_hash_this_val(hi);
+      svn_skel_t *change_skel = svn_skel__make_empty_list(result_pool);
+      const char *word;
+
+      if (log_item->copyfrom_path)
+        {
+          svn_skel__prepend_int(log_item->copyfrom_rev, change_skel,
+                                result_pool);
+          svn_skel__prepend_str(log_item->copyfrom_path, change_skel,
+                                result_pool);
+        }
+
+      word = svn_tristate__to_word(log_item->props_modified);
+      svn_skel__prepend_str(word ? word : "unknown", change_skel,
+                            result_pool);
+      word = svn_tristate__to_word(log_item->text_modified);
+      svn_skel__prepend_str(word ? word : "unknown", change_skel,
+                            result_pool);
+      svn_skel__prepend_str(svn_node_kind_to_word(log_item->node_kind),
+                            change_skel, result_pool);
+      svn_skel__prepend(svn_skel__mem_atom(&log_item->action, 1,
+                                           result_pool),
+                        change_skel);
+      svn_skel__prepend_str(changed_path, change_skel, result_pool);
+
+      svn_skel__prepend(change_skel, changes_skel);
+    }
+
+  return changes_skel;
+}
+
+/* Return a copy of the atom SKEL as C string, allocated in RESULT_POOL. */
+static const char *
+atom_to_cstring(const svn_skel_t *skel,
+                apr_pool_t *result_pool)
+{
+  return apr_pstrmemdup(result_pool, skel->data, skel->len);
+}
+
+svn_error_t *
+svn_client__parse_changed_paths(apr_hash_t **changed_paths,
+                                const svn_skel_t *skel,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *change_skel;
+
+  if (skel->is_atom)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Malformed changed paths list"));
+
+  *changed_paths = apr_hash_make(result_pool);
+  for (change_skel = skel->children;
+       change_skel != NULL;
+       change_skel = change_skel->next)
+    {
+      svn_log_changed_path2_t *log_item;
+      const svn_skel_t *elt;
+      int len = svn_skel__list_length(change_skel);
+      int i;
+
+      if (len != 5 && len != 7)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Malformed changed path"));
+      for (elt = change_skel->children; elt; elt = elt->next)
+        if (!elt->is_atom)
+          return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                  _("Malformed changed path"));
+
+      elt = change_skel->children;
+      log_item = svn_log_changed_path2_create(result_pool);
+      svn_hash_sets(*changed_paths, atom_to_cstring(elt, result_pool),
+                    log_item);
+
+      elt = elt->next;
+      if (elt->len != 1)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Malformed changed path"));
+      log_item->action = elt->data[0];
+
+      elt = elt->next;
+      log_item->node_kind
+        = svn_node_kind_from_word(atom_to_cstring(elt, scratch_pool));
+
+      for (i = 0; i < 2; i++)
+        {
+          svn_tristate_t modified;
+
+          elt = elt->next;
+          modified
+            = svn_tristate__from_word(atom_to_cstring(elt, scratch_pool));
+          if (i == 0)
+            log_item->text_modified = modified;
+          else
+            log_item->props_modified = modified;
+        }
+
+      if (len == 7)
+        {
+          apr_int64_t copyfrom_rev;
+
+          elt = elt->next;
+          log_item->copyfrom_path = atom_to_cstring(elt, result_pool);
+          SVN_ERR(svn_skel__parse_int(&copyfrom_rev, elt->next,
+                                      scratch_pool));
+          log_item->copyfrom_rev = (svn_revnum_t)copyfrom_rev;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_open(svn_client__log_cache_t **cache,
+                           const char *repos_uuid,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  svn_boolean_t enabled;
+  const char *config_dir;
+  const char *cache_dir;
+
+  *cache = NULL;
+
+  SVN_ERR(svn_config_get_bool(cfg, &enabled, SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_LOG_CACHE, FALSE));
+  if (!enabled)
+    return SVN_NO_ERROR;
+
+  /* Honour --config-dir like the auth cache does. */
+  config_dir = ctx->auth_baton
+               ? svn_auth_get_parameter(ctx->auth_baton,
+                                        SVN_AUTH_PARAM_CONFIG_DIR)
+               : NULL;
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          "log-cache", scratch_pool));
+  if (cache_dir == NULL)
+    return SVN_NO_ERROR;
+
+  *cache = apr_pcalloc(result_pool, sizeof(**cache));
+  (*cache)->repos_dir = svn_dirent_join(cache_dir, repos_uuid, result_pool);
+  (*cache)->unwritten = apr_hash_make(result_pool);
+  (*cache)->pool = result_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the path of the file caching REVISION in CACHE. */
+static const char *
+revision_path(const svn_client__log_cache_t *cache,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool)
+{
+  return svn_dirent_join_many(result_pool, cache->repos_dir,
+                              apr_psprintf(result_pool, "%ld",
+                                           revision
+                                           / SVN_CLIENT__LOG_CACHE_SHARD_SIZE),
+                              apr_psprintf(result_pool, "%ld", revision),
+                              SVN_VA_NULL);
+}
+
+/* Return the skel stored for a revision committed at DATE, which may be
+   NULL, that changed CHANGED_PATHS.  Allocate it in RESULT_POOL. */
+static svn_skel_t *
+unparse_revision(const svn_string_t *date,
+                 apr_hash_t *changed_paths,
+                 apr_pool_t *result_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(result_pool);
+
+  svn_skel__prepend(svn_client__unparse_changed_paths(changed_paths,
+                                                      result_pool),
+                    skel);
+  if (date)
+    svn_skel__prepend(svn_skel__mem_atom(date->data, date->len, result_pool),
+                      skel);
+  else
+    svn_skel__prepend(svn_skel__make_empty_list(result_pool), skel);
+
+  return skel;
+}
+
+/* Set *SKEL to the skel stored for REVISION in CACHE, or to NULL if there
+   is none or it is damaged.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+read_revision(svn_skel_t **skel,
+              svn_client__log_cache_t *cache,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buf = apr_hash_get(cache->unwritten, &revision,
+                                      sizeof(revision));
+  svn_error_t *err;
+
+  *skel = NULL;
+
+  if (buf == NULL)
+    {
+      err = svn_stringbuf_from_file2(&buf, revision_path(cache, revision,
+                                                         result_pool),
+                                     result_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+    }
+
+  /* A damaged file, including one written before the commit time was
+     stored, is as good as none. */
+  *skel = svn_skel__parse(buf->data, buf->len, result_pool);
+  if (*skel && svn_skel__list_length(*skel) != 2)
+    *skel = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_get(apr_hash_t **changed_paths,
+                          svn_client__log_cache_t *cache,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel;
+  svn_error_t *err;
+
+  *changed_paths = NULL;
+
+  SVN_ERR(read_revision(&skel, cache, revision, scratch_pool));
+  if (skel == NULL)
+    return SVN_NO_ERROR;
+
+  err = svn_client__parse_changed_paths(changed_paths, skel->children->next,
+                                        result_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *changed_paths = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_contains(svn_boolean_t *contains,
+                               svn_client__log_cache_t *cache,
+                               svn_revnum_t revision,
+                               const svn_string_t *date,
+                               apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel;
+  const svn_skel_t *date_skel;
+
+  SVN_ERR(read_revision(&skel, cache, revision, scratch_pool));
+  if (skel == NULL)
+    {
+      *contains = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* A repository replaced by one with the same UUID, e.g. by loading a
+     dump file, shows as different commit times. */
+  date_skel = skel->children;
+  if (date == NULL)
+    *contains = !date_skel->is_atom;
+  else
+    *contains = date_skel->is_atom
+                && date_skel->len == date->len
+                && !memcmp(date_skel->data, date->data, date->len);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_set(svn_client__log_cache_t *cache,
+                          svn_revnum_t revision,
+                          const svn_string_t *date,
+                          apr_hash_t *changed_paths,
+                          apr_pool_t *scratch_pool)
+{
+  const char *path = revision_path(cache, revision, scratch_pool);
+  svn_stringbuf_t *buf;
+  svn_error_t *err;
+
+  buf = svn_skel__unparse(unparse_revision(date, changed_paths,
+                                           scratch_pool),
+                          scratch_pool);
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(path, scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io_write_atomic2(path, buf->data, buf->len, NULL, FALSE,
+                               scratch_pool);
+
+  /* Keep what we can't store for the rest of this operation. */
+  if (err)
+    {
+      svn_revnum_t *key = apr_pmemdup(cache->pool, &revision,
+                                      sizeof(revision));
+
+      svn_error_clear(err);
+      apr_hash_set(cache->unwritten, key, sizeof(*key),
+                   svn_stringbuf_dup(buf, cache->pool));
+    }
+  else
+    apr_hash_set(cache->unwritten, &revision, sizeof(revision), NULL);
+
+  return SVN_NO_ERROR;
+}
@@ -31,6 +31,8 @@
 #include <apr_strings.h>
 #include <apr_tables.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 #include "svn_types.h"
 #include "svn_hash.h"
 #include "svn_wc.h"
@@ -55,10 +57,13 @@
 #include "mergeinfo.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_io_private.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -331,6 +336,11 @@ typedef struct merge_cmd_baton_t {
     const apr_array_header_t *nodes_with_mergeinfo;
   } notify_begin;
 
+  /* Text merges of the current editor drive whose diff3 is being computed
+     concurrently, see queue_text_merge().  NULL if file texts get merged
+     synchronously. */
+  struct text_merges_t *text_merges;
+
 } merge_cmd_baton_t;
 
 
@@ -1993,6 +2003,407 @@ merge_file_opened(void **new_file_baton,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of text merges queued in a text_merges_t, in flight or
+   not applied yet. */
+#define MAX_PENDING_TEXT_MERGES 64
+
+/* A text merge whose diff3 gets computed by a task while the editor drive
+   continues.  The merges get applied to the working copy strictly in the
+   order of the merge_file_changed() calls. */
+typedef struct text_merge_t
+{
+  /* The merge target and the arguments to pass to
+     svn_wc__merge_with_diff3() for it. */
+  const char *local_abspath;
+  const char *left_file;
+  const char *right_file;
+  const char *left_label;
+  const char *right_label;
+  const char *target_label;
+  const svn_wc_conflict_version_t *left;
+  const svn_wc_conflict_version_t *right;
+  apr_hash_t *left_props;
+  apr_array_header_t *prop_changes;
+  const apr_array_header_t *merge_options;
+
+  /* The diff3 of LEFT_FILE, LOCAL_ABSPATH and RIGHT_FILE.  Set by the task
+     unless it failed, in which case the WC code computes it itself. */
+  svn_diff_t *diff3;
+
+  /* Root pool owned by the merge, so that its task may allocate in it. */
+  apr_pool_t *pool;
+
+  struct text_merge_t *next;
+} text_merge_t;
+
+/* The concurrent text merges of one merge editor drive. */
+struct text_merges_t
+{
+  merge_cmd_baton_t *merge_b;
+
+  /* Root pool holding the task set. */
+  apr_pool_t *task_pool;
+  svn_task__set_t *set;
+
+  /* FIFO of merges that have been queued but not applied yet, i.e. in the
+     order in which the set delivers them. */
+  text_merge_t *pending_first;
+  text_merge_t *pending_last;
+
+  /* Number of merges in the FIFO. */
+  int outstanding;
+};
+
+/* Merge the text and the PROP_CHANGES of the file LOCAL_ABSPATH as
+   merge_file_changed() does, passing DIFF3, if not NULL, on to
+   svn_wc__merge_with_diff3().  Record and notify the outcome. */
+static svn_error_t *
+merge_text(merge_cmd_baton_t *merge_b,
+           const char *local_abspath,
+           const char *left_file,
+           const char *right_file,
+           const char *left_label,
+           const char *right_label,
+           const char *target_label,
+           const svn_wc_conflict_version_t *left,
+           const svn_wc_conflict_version_t *right,
+           apr_hash_t *left_props,
+           const apr_array_header_t *prop_changes,
+           svn_diff_t *diff3,
+           apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = merge_b->ctx;
+  svn_boolean_t has_local_mods;
+  enum svn_wc_merge_outcome_t content_outcome;
+  svn_wc_notify_state_t text_state;
+  svn_wc_notify_state_t property_state = svn_wc_notify_state_unchanged;
+
+  SVN_ERR(svn_wc_text_modified_p2(&has_local_mods, ctx->wc_ctx,
+                                  local_abspath, FALSE, scratch_pool));
+
+  /* Do property merge and text merge in one step so that keyword expansion
+     takes into account the new property values. */
+  SVN_ERR(svn_wc__merge_with_diff3(&content_outcome, &property_state,
+                                   ctx->wc_ctx,
+                                   left_file, right_file, local_abspath,
+                                   left_label, right_label, target_label,
+                                   left, right,
+                                   merge_b->dry_run, merge_b->diff3_cmd,
+                                   merge_b->merge_options,
+                                   left_props, prop_changes, diff3,
+                                   NULL, NULL,
+                                   ctx->cancel_func,
+                                   ctx->cancel_baton,
+                                   scratch_pool));
+
+  if (content_outcome == svn_wc_merge_conflict
+      || property_state == svn_wc_notify_state_conflicted)
+    {
+      alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
+                           merge_b->pool);
+    }
+
+  if (content_outcome == svn_wc_merge_conflict)
+    text_state = svn_wc_notify_state_conflicted;
+  else if (has_local_mods
+           && content_outcome != svn_wc_merge_unchanged)
+    text_state = svn_wc_notify_state_merged;
+  else if (content_outcome == svn_wc_merge_merged)
+    text_state = svn_wc_notify_state_changed;
+  else if (content_outcome == svn_wc_merge_no_merge)
+    text_state = svn_wc_notify_state_missing;
+  else /* merge_outcome == svn_wc_merge_unchanged */
+    text_state = svn_wc_notify_state_unchanged;
+
+  if (text_state == svn_wc_notify_state_conflicted
+      || text_state == svn_wc_notify_state_merged
+      || text_state == svn_wc_notify_state_changed
+      || property_state == svn_wc_notify_state_conflicted
+      || property_state == svn_wc_notify_state_merged
+      || property_state == svn_wc_notify_state_changed)
+    {
+      SVN_ERR(record_update_update(merge_b, local_abspath, svn_node_file,
+                                   text_state, property_state,
+                                   scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if neither LEFT_PROPS nor PROP_CHANGES make the WC code
+   treat a file as binary or translate it before merging, i.e. if a diff3
+   of the untranslated files is worth computing in advance. */
+static svn_boolean_t
+is_plain_text_merge(apr_hash_t *left_props,
+                    const apr_array_header_t *prop_changes)
+{
+  static const char *const translating_props[] =
+    {
+      SVN_PROP_EOL_STYLE, SVN_PROP_KEYWORDS, SVN_PROP_SPECIAL, NULL
+    };
+  const svn_string_t *mime_type;
+  int i, j;
+
+  mime_type = svn_hash_gets(left_props, SVN_PROP_MIME_TYPE);
+  if (mime_type && svn_mime_type_is_binary(mime_type->data))
+    return FALSE;
+
+  for (i = 0; translating_props[i]; i++)
+    if (svn_hash_gets(left_props, translating_props[i]))
+      return FALSE;
+
+  for (j = 0; j < prop_changes->nelts; j++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(prop_changes, j, svn_prop_t);
+
+      if (!strcmp(prop->name, SVN_PROP_MIME_TYPE))
+        return FALSE;
+
+      for (i = 0; translating_props[i]; i++)
+        if (!strcmp(prop->name, translating_props[i]))
+          return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Set *COPY_ABSPATH to a new temporary file with the contents of FILE
+   that lives as long as RESULT_POOL.  Use SCRATCH_POOL for temporary
+   allocations.
+
+   The driver removes its files as soon as the callback returns but never
+   modifies them in place, so we rather create a hard link than an actual
+   copy. */
+static svn_error_t *
+dup_merge_file(const char **copy_abspath,
+               const char *file,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  SVN_ERR(svn_io_open_unique_file3(NULL, copy_abspath, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, scratch_pool));
+
+  /* Different file systems etc. are no errors; we copy the file then. */
+  SVN_ERR(svn_io_remove_file2(*copy_abspath, FALSE, scratch_pool));
+  err = svn_io__file_link(file, *copy_abspath, scratch_pool);
+  if (!err)
+    return SVN_NO_ERROR;
+
+  svn_error_clear(err);
+  return svn_error_trace(svn_io_copy_file(file, *copy_abspath, FALSE,
+                                          scratch_pool));
+}
+
+/* Implements svn_task__process_func_t.  Compute the diff3 of the
+   text_merge_t in PROCESS_BATON and return the merge in *RESULT. */
+static svn_error_t *
+text_merge_task(void **result,
+                void *process_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  text_merge_t *tm = process_baton;
+  svn_diff_file_options_t *options
+    = svn_diff_file_options_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (tm->merge_options)
+    err = svn_diff_file_options_parse(options, tm->merge_options,
+                                      scratch_pool);
+
+  /* Nothing is lost if this fails: the WC code then runs the diff3 itself
+     and reports the error in the context of the merge. */
+  if (!err)
+    err = svn_diff_file_diff3_2(&tm->diff3, tm->left_file,
+                                tm->local_abspath, tm->right_file,
+                                options, tm->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      tm->diff3 = NULL;
+    }
+
+  *result = tm;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Apply and destroy the text_merge_t
+   in RESULT, which must be the oldest merge of the text_merges_t in
+   OUTPUT_BATON. */
+static svn_error_t *
+apply_text_merge(void *result,
+                 void *output_baton,
+                 apr_pool_t *scratch_pool)
+{
+  text_merge_t *tm = result;
+  struct text_merges_t *tms = output_baton;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(tm == tms->pending_first);
+
+  tms->pending_first = tm->next;
+  if (!tms->pending_first)
+    tms->pending_last = NULL;
+  tms->outstanding--;
+
+  err = merge_text(tms->merge_b, tm->local_abspath,
+                   tm->left_file, tm->right_file,
+                   tm->left_label, tm->right_label, tm->target_label,
+                   tm->left, tm->right, tm->left_props, tm->prop_changes,
+                   tm->diff3, scratch_pool);
+  svn_pool_destroy(tm->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Queue the text merge described by the arguments, which are as for
+   merge_text(), in MERGE_B->TEXT_MERGES. */
+static svn_error_t *
+queue_text_merge(merge_cmd_baton_t *merge_b,
+                 const char *local_abspath,
+                 const char *left_file,
+                 const char *right_file,
+                 const char *left_label,
+                 const char *right_label,
+                 const char *target_label,
+                 const svn_wc_conflict_version_t *left,
+                 const svn_wc_conflict_version_t *right,
+                 apr_hash_t *left_props,
+                 const apr_array_header_t *prop_changes,
+                 apr_pool_t *scratch_pool)
+{
+  struct text_merges_t *tms = merge_b->text_merges;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  text_merge_t *tm = apr_pcalloc(pool, sizeof(*tm));
+  svn_error_t *err;
+
+  tm->pool = pool;
+  err = dup_merge_file(&tm->left_file, left_file, pool, scratch_pool);
+  if (!err)
+    err = dup_merge_file(&tm->right_file, right_file, pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  tm->local_abspath = apr_pstrdup(pool, local_abspath);
+  tm->left_label = apr_pstrdup(pool, left_label);
+  tm->right_label = apr_pstrdup(pool, right_label);
+  tm->target_label = apr_pstrdup(pool, target_label);
+  tm->left = svn_wc_conflict_version_dup(left, pool);
+  tm->right = svn_wc_conflict_version_dup(right, pool);
+  tm->left_props = svn_prop_hash_dup(left_props, pool);
+  tm->prop_changes = svn_prop_array_dup(prop_changes, pool);
+  tm->merge_options = merge_b->merge_options;
+
+  if (tms->pending_last)
+    tms->pending_last->next = tm;
+  else
+    tms->pending_first = tm;
+  tms->pending_last = tm;
+  tms->outstanding++;
+
+  /* This may already apply completed merges, including this one. */
+  SVN_ERR(svn_task__add(tms->set, text_merge_task, tm));
+
+  /* This waits for all queued merges but there are at most MAX of them. */
+  if (tms->outstanding >= MAX_PENDING_TEXT_MERGES)
+    SVN_ERR(svn_task__set_finish(tms->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply all text merges queued in MERGE_B, if any.  Processor callbacks
+   that touch the working copy call this first, so that they see the same
+   state as with synchronous text merges. */
+static svn_error_t *
+flush_text_merges(merge_cmd_baton_t *merge_b)
+{
+  if (merge_b->text_merges && merge_b->text_merges->outstanding)
+    SVN_ERR(svn_task__set_finish(merge_b->text_merges->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function for the text_merges_t in DATA.  Terminates the
+   tasks, releases all merges not applied yet and detaches DATA from its
+   merge baton. */
+static apr_status_t
+text_merges_cleanup(void *data)
+{
+  struct text_merges_t *tms = data;
+  text_merge_t *tm;
+
+  /* This cancels the queued tasks and waits for those in flight. */
+  svn_pool_destroy(tms->task_pool);
+
+  for (tm = tms->pending_first; tm; )
+    {
+      text_merge_t *next = tm->next;
+      svn_pool_destroy(tm->pool);
+      tm = next;
+    }
+
+  /* A later drive may have started its own merges already. */
+  if (tms->merge_b->text_merges == tms)
+    tms->merge_b->text_merges = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Let merge_file_changed() compute the diff3 of file texts concurrently
+   for the duration of the editor drive using POOL, if there are worker
+   threads and the internal diff3 gets used at all. */
+static svn_error_t *
+start_text_merges(merge_cmd_baton_t *merge_b,
+                  apr_pool_t *pool)
+{
+  struct text_merges_t *tms;
+
+  if (svn_task__get_thread_limit() == 0
+      || merge_b->record_only
+      || merge_b->diff3_cmd)
+    return SVN_NO_ERROR;
+
+  tms = apr_pcalloc(pool, sizeof(*tms));
+  tms->merge_b = merge_b;
+  tms->task_pool = svn_pool_create(NULL);
+  apr_pool_cleanup_register(pool, tms, text_merges_cleanup,
+                            apr_pool_cleanup_null);
+  merge_b->text_merges = tms;
+
+  return svn_error_trace(svn_task__set_create(&tms->set,
+                                              svn_task__get_thread_limit(),
+                                              apply_text_merge, tms,
+                                              merge_b->ctx->cancel_func,
+                                              merge_b->ctx->cancel_baton,
+                                              tms->task_pool));
+}
+
+/* Apply the text merges queued in MERGE_B and stop the concurrent text
+   merging started with start_text_merges() on POOL. */
+static svn_error_t *
+finish_text_merges(merge_cmd_baton_t *merge_b,
+                   apr_pool_t *pool)
+{
+  struct text_merges_t *tms = merge_b->text_merges;
+  svn_error_t *err;
+
+  if (!tms)
+    return SVN_NO_ERROR;
+
+  err = svn_task__set_finish(tms->set);
+  apr_pool_cleanup_run(pool, tms, text_merges_cleanup);
+
+  return svn_error_trace(err);
+}
+
 /* An svn_diff_tree_processor_t function.
  *
  * Called after merge_file_opened() when a node receives only text and/or
@@ -2024,11 +2435,19 @@ merge_file_changed(const char *relpath,
   const svn_wc_conflict_version_t *right;
   svn_wc_notify_state_t text_state;
   svn_wc_notify_state_t property_state;
+  svn_boolean_t queue_text;
 
   SVN_ERR_ASSERT(local_abspath && svn_dirent_is_absolute(local_abspath));
   SVN_ERR_ASSERT(!left_file || svn_dirent_is_absolute(left_file));
   SVN_ERR_ASSERT(!right_file || svn_dirent_is_absolute(right_file));
 
+  /* Plain text merges get queued.  Everything else has to wait for the
+     merges queued before. */
+  queue_text = (merge_b->text_merges && left_file
+                && is_plain_text_merge(left_props, prop_changes));
+  if (!queue_text)
+    SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
 
   if (fb->shadowed)
@@ -2046,7 +2465,7 @@ merge_file_changed(const char *relpath,
     }
 
   /* This callback is essentially no more than a wrapper around
-     svn_wc_merge5().  Thank goodness that all the
+     svn_wc__merge_with_diff3().  Thank goodness that all the
      diff-editor-mechanisms are doing the hard work of getting the
      fulltexts! */
 
@@ -2086,8 +2505,6 @@ merge_file_changed(const char *relpath,
     }
   else if (left_file)
     {
-      svn_boolean_t has_local_mods;
-      enum svn_wc_merge_outcome_t content_outcome;
       const char *target_label;
       const char *left_label;
       const char *right_label;
@@ -2119,41 +2536,20 @@ merge_file_changed(const char *relpath,
                                  right_source->revision,
                                  *path_ext ? "." : "", path_ext);
 
-      SVN_ERR(svn_wc_text_modified_p2(&has_local_mods, ctx->wc_ctx,
-                                      local_abspath, FALSE, scratch_pool));
-
-      /* Do property merge and text merge in one step so that keyword expansion
-         takes into account the new property values. */
-      SVN_ERR(svn_wc_merge5(&content_outcome, &property_state, ctx->wc_ctx,
-                            left_file, right_file, local_abspath,
-                            left_label, right_label, target_label,
-                            left, right,
-                            merge_b->dry_run, merge_b->diff3_cmd,
-                            merge_b->merge_options,
-                            left_props, prop_changes,
-                            NULL, NULL,
-                            ctx->cancel_func,
-                            ctx->cancel_baton,
-                            scratch_pool));
-
-      if (content_outcome == svn_wc_merge_conflict
-          || property_state == svn_wc_notify_state_conflicted)
-        {
-          alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
-                               merge_b->pool);
-        }
+      if (queue_text)
+        return svn_error_trace(queue_text_merge(merge_b, local_abspath,
+                                                left_file, right_file,
+                                                left_label, right_label,
+                                                target_label, left, right,
+                                                left_props, prop_changes,
+                                                scratch_pool));
 
-      if (content_outcome == svn_wc_merge_conflict)
-        text_state = svn_wc_notify_state_conflicted;
-      else if (has_local_mods
-               && content_outcome != svn_wc_merge_unchanged)
-        text_state = svn_wc_notify_state_merged;
-      else if (content_outcome == svn_wc_merge_merged)
-        text_state = svn_wc_notify_state_changed;
-      else if (content_outcome == svn_wc_merge_no_merge)
-        text_state = svn_wc_notify_state_missing;
-      else /* merge_outcome == svn_wc_merge_unchanged */
-        text_state = svn_wc_notify_state_unchanged;
+      return svn_error_trace(merge_text(merge_b, local_abspath,
+                                        left_file, right_file,
+                                        left_label, right_label,
+                                        target_label, left, right,
+                                        left_props, prop_changes, NULL,
+                                        scratch_pool));
     }
 
   if (text_state == svn_wc_notify_state_conflicted
@@ -2198,6 +2594,8 @@ merge_file_added(const char *relpath,
   apr_hash_t *pristine_props;
   apr_hash_t *new_props;
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
@@ -2438,6 +2836,8 @@ merge_file_deleted(const char *relpath,
                                               relpath, scratch_pool);
   svn_boolean_t same;
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
 
   if (fb->shadowed)
@@ -2556,6 +2956,8 @@ merge_dir_opened(void **new_dir_baton,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   db = apr_pcalloc(result_pool, sizeof(*db));
   db->pool = result_pool;
   db->tree_conflict_reason = CONFLICT_REASON_NONE;
@@ -2953,6 +3355,8 @@ merge_dir_changed(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
@@ -3039,6 +3443,8 @@ merge_dir_added(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   /* For consistency; usually a no-op from _dir_added() */
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
@@ -3208,6 +3614,8 @@ merge_dir_deleted(const char *relpath,
   svn_boolean_t same;
   apr_hash_t *working_props;
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
 
@@ -3376,6 +3784,8 @@ merge_dir_closed(const char *relpath,
   merge_cmd_baton_t *merge_b = processor->baton;
   struct merge_dir_baton_t *db = dir_baton;
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   return SVN_NO_ERROR;
@@ -3406,6 +3816,8 @@ merge_node_absent(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b));
+
   SVN_ERR(record_skip(merge_b, local_abspath, svn_node_unknown,
                       svn_wc_notify_skip, svn_wc_notify_state_missing,
                       db, scratch_pool));
@@ -5609,6 +6021,515 @@ remove_children_with_deleted_mergeinfo(merge_cmd_baton_t *merge_b,
     }
 }
 
+/* One subtree described separately to the reporter of a merge editor
+   drive, see describe_merge_report(). */
+typedef struct merge_report_path_t
+{
+  /* Path relative to the merge target. */
+  const char *relpath;
+
+  /* The revision reported for it. */
+  svn_revnum_t revision;
+} merge_report_path_t;
+
+/* Everything a merge editor drive asks from the repository. */
+typedef struct merge_report_t
+{
+  /* The diff is requested between these locations. */
+  const char *url1;
+  svn_revnum_t rev1;
+  const char *url2;
+  svn_revnum_t rev2;
+  svn_depth_t depth;
+  svn_boolean_t ignore_ancestry;
+
+  /* The revision reported for the merge target itself. */
+  svn_revnum_t target_start;
+
+  /* Subtrees reported with different revisions, as merge_report_path_t,
+     in depth-first order. */
+  apr_array_header_t *subtrees;
+} merge_report_t;
+
+/* Helper for drive_merge_report_editor().
+
+   Set *REPORT to the description of the editor drive merging SOURCE into
+   TARGET_ABSPATH and its subtrees in CHILDREN_WITH_MERGEINFO, allocated
+   in RESULT_POOL.  The arguments are as for drive_merge_report_editor(),
+   which see. */
+static svn_error_t *
+describe_merge_report(merge_report_t **report,
+                      const char *target_abspath,
+                      const merge_source_t *source,
+                      const apr_array_header_t *children_with_mergeinfo,
+                      svn_depth_t depth,
+                      merge_cmd_baton_t *merge_b,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  merge_report_t *r = apr_pcalloc(result_pool, sizeof(*r));
+  svn_revnum_t target_start;
+  svn_boolean_t honor_mergeinfo = HONOR_MERGEINFO(merge_b);
+  svn_boolean_t is_rollback = source->loc1->rev > source->loc2->rev;
+
+  r->url1 = apr_pstrdup(result_pool, source->loc1->url);
+  r->rev1 = source->loc1->rev;
+  r->url2 = apr_pstrdup(result_pool, source->loc2->url);
+  r->rev2 = source->loc2->rev;
+  r->depth = depth;
+  r->ignore_ancestry = merge_b->diff_ignore_ancestry;
+  r->subtrees = apr_array_make(result_pool, 0, sizeof(merge_report_path_t));
+
+  /* Start with a safe default starting revision for the editor and the
+     merge target. */
+  target_start = source->loc1->rev;
+
+  /* If we are honoring mergeinfo the starting revision for the merge target
+     might not be SOURCE->rev1, in fact the merge target might not need *any*
+     part of SOURCE merged -- Instead some subtree of the target
+     needs SOURCE -- So get the right starting revision for the
+     target. */
+  if (honor_mergeinfo)
+    {
+      svn_client__merge_path_t *child;
+
+      /* CHILDREN_WITH_MERGEINFO must always exist if we are honoring
+         mergeinfo and must have at least one element (describing the
+         merge target). */
+      SVN_ERR_ASSERT(children_with_mergeinfo);
+      SVN_ERR_ASSERT(children_with_mergeinfo->nelts);
+
+      /* Get the merge target's svn_client__merge_path_t, which is always
+         the first in the array due to depth first sorting requirement,
+         see 'THE CHILDREN_WITH_MERGEINFO ARRAY'. */
+      child = APR_ARRAY_IDX(children_with_mergeinfo, 0,
+                            svn_client__merge_path_t *);
+      SVN_ERR_ASSERT(child);
+      if (child->remaining_ranges->nelts == 0)
+        {
+          /* The merge target doesn't need anything merged. */
+          target_start = source->loc2->rev;
+        }
+      else
+        {
+          /* The merge target has remaining revisions to merge.  These
+             ranges may fully or partially overlap the range described
+             by SOURCE->rev1:rev2 or may not intersect that range at
+             all. */
+          svn_merge_range_t *range =
+            APR_ARRAY_IDX(child->remaining_ranges, 0,
+                          svn_merge_range_t *);
+          if ((!is_rollback && range->start > source->loc2->rev)
+              || (is_rollback && range->start < source->loc2->rev))
+            {
+              /* Merge target's first remaining range doesn't intersect. */
+              target_start = source->loc2->rev;
+            }
+          else
+            {
+              /* Merge target's first remaining range partially or
+                 fully overlaps. */
+              target_start = range->start;
+            }
+        }
+    }
+  r->target_start = target_start;
+
+  if (honor_mergeinfo && children_with_mergeinfo)
+    {
+      /* Describe children with mergeinfo overlapping this merge
+         operation such that no repeated diff is retrieved for them from
+         the repository. */
+      int i;
+
+      /* Start with CHILDREN_WITH_MERGEINFO[1], CHILDREN_WITH_MERGEINFO[0]
+         is always the merge target (TARGET_ABSPATH). */
+      for (i = 1; i < children_with_mergeinfo->nelts; i++)
+        {
+          svn_merge_range_t *range;
+          merge_report_path_t *path;
+          const char *child_repos_path;
+          const svn_client__merge_path_t *parent;
+          const svn_client__merge_path_t *child =
+            APR_ARRAY_IDX(children_with_mergeinfo, i,
+                          svn_client__merge_path_t *);
+
+          SVN_ERR_ASSERT(child);
+          if (child->absent)
+            continue;
+
+          /* Find this child's nearest wc ancestor with mergeinfo. */
+          parent = find_nearest_ancestor(children_with_mergeinfo,
+                                         FALSE, child->abspath);
+
+          /* If a subtree needs the same range applied as its nearest parent
+             with mergeinfo or neither the subtree nor this parent need
+             SOURCE->rev1:rev2 merged, then we don't need to describe the
+             subtree separately.  In the latter case this could break the
+             editor if child->abspath didn't exist at SOURCE->rev2 and we
+             attempt to describe it via a reporter set_path call. */
+          if (child->remaining_ranges->nelts)
+            {
+              range = APR_ARRAY_IDX(child->remaining_ranges, 0,
+                                    svn_merge_range_t *);
+              if ((!is_rollback && range->start > source->loc2->rev)
+                  || (is_rollback && range->start < source->loc2->rev))
+                {
+                  /* This child's first remaining range comes after the range
+                     we are currently merging, so skip it. We expect to get
+                     to it in a subsequent call to this function. */
+                  continue;
+                }
+              else if (parent->remaining_ranges->nelts)
+                {
+                   svn_merge_range_t *parent_range =
+                    APR_ARRAY_IDX(parent->remaining_ranges, 0,
+                                  svn_merge_range_t *);
+                   svn_merge_range_t *child_range =
+                    APR_ARRAY_IDX(child->remaining_ranges, 0,
+                                  svn_merge_range_t *);
+                  if (parent_range->start == child_range->start)
+                    continue; /* Subtree needs same range as parent. */
+                }
+            }
+          else /* child->remaining_ranges->nelts == 0*/
+            {
+              /* If both the subtree and its parent need no ranges applied
+                 consider that as the "same ranges" and don't describe
+                 the subtree. */
+              if (parent->remaining_ranges->nelts == 0)
+                continue;
+            }
+
+          /* Ok, we really need to describe this subtree as it needs different
+             ranges applied than its nearest working copy parent. */
+          child_repos_path = svn_dirent_is_child(target_abspath,
+                                                 child->abspath,
+                                                 result_pool);
+          /* This loop is only processing subtrees, so CHILD->ABSPATH
+             better be a proper child of the merge target. */
+          SVN_ERR_ASSERT(child_repos_path);
+
+          path = apr_array_push(r->subtrees);
+          path->relpath = child_repos_path;
+
+          if ((child->remaining_ranges->nelts == 0)
+              || (is_rollback && (range->start < source->loc2->rev))
+              || (!is_rollback && (range->start > source->loc2->rev)))
+            {
+              /* Nothing to merge to this child.  We'll claim we have
+                 it up to date so the server doesn't send us
+                 anything. */
+              path->revision = source->loc2->rev;
+            }
+          else
+            {
+              path->revision = range->start;
+            }
+        }
+    }
+
+  *report = r;
+  return SVN_NO_ERROR;
+}
+
+/* Describe REPORT to REPORTER and REPORT_BATON and finish the report. */
+static svn_error_t *
+send_merge_report(const svn_ra_reporter3_t *reporter,
+                  void *report_baton,
+                  const merge_report_t *report,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(reporter->set_path(report_baton, "", report->target_start,
+                             report->depth, FALSE, NULL, scratch_pool));
+
+  for (i = 0; i < report->subtrees->nelts; i++)
+    {
+      const merge_report_path_t *path
+        = &APR_ARRAY_IDX(report->subtrees, i, merge_report_path_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(reporter->set_path(report_baton, path->relpath, path->revision,
+                                 report->depth, FALSE, NULL, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(reporter->finish_report(report_baton,
+                                                 scratch_pool));
+}
+
+/* Return TRUE if the editor drives for the reports A and B would be the
+   same. */
+static svn_boolean_t
+merge_reports_equal(const merge_report_t *a,
+                    const merge_report_t *b)
+{
+  int i;
+
+  if (strcmp(a->url1, b->url1) || a->rev1 != b->rev1
+      || strcmp(a->url2, b->url2) || a->rev2 != b->rev2
+      || a->depth != b->depth || a->ignore_ancestry != b->ignore_ancestry
+      || a->target_start != b->target_start
+      || a->subtrees->nelts != b->subtrees->nelts)
+    return FALSE;
+
+  for (i = 0; i < a->subtrees->nelts; i++)
+    {
+      const merge_report_path_t *path_a
+        = &APR_ARRAY_IDX(a->subtrees, i, merge_report_path_t);
+      const merge_report_path_t *path_b
+        = &APR_ARRAY_IDX(b->subtrees, i, merge_report_path_t);
+
+      if (strcmp(path_a->relpath, path_b->relpath)
+          || path_a->revision != path_b->revision)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Editor drives of do_mergeinfo_aware_dir_merge() fetched ahead on
+   another RA session, see start_merge_prefetch(). */
+typedef struct merge_prefetch_t merge_prefetch_t;
+
+#if APR_HAS_THREADS
+
+/* Fetch at most this many editor drives ahead of the one being merged. */
+#define MERGE_PREFETCH_AHEAD 2
+
+/* One editor drive expected to be needed by the merge. */
+typedef struct prefetched_drive_t
+{
+  /* The predicted report. */
+  const merge_report_t *report;
+
+  /* The recorded drive and its root pool, once fetched. */
+  apr_pool_t *pool;
+  svn_client__spooled_edit_t *edit;
+  svn_error_t *err;
+
+  /* Set once the fetching thread is done with this drive. */
+  svn_boolean_t done;
+} prefetched_drive_t;
+
+struct merge_prefetch_t
+{
+  /* Root pool holding the objects shared with the fetching thread. */
+  apr_pool_t *pool;
+
+  /* Used only by the fetching thread once that is running. */
+  svn_ra_session_t *ra_session;
+
+  apr_thread_t *thread;
+
+  /* Protect the members below.  COND is signaled whenever one of them
+     changes. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* The drives to fetch as prefetched_drive_t *, in order. */
+  apr_array_header_t *drives;
+
+  /* Index of the next drive the merge will ask for. */
+  int next_use;
+
+  /* Set when the remaining drives are not wanted anymore. */
+  svn_boolean_t stop;
+};
+
+/* Implements svn_cancel_func_t, interrupting the fetch of the
+   merge_prefetch_t in BATON once it has been stopped. */
+static svn_error_t *
+prefetch_cancel_func(void *baton)
+{
+  merge_prefetch_t *prefetch = baton;
+  svn_boolean_t stop;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  stop = prefetch->stop;
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, SVN_NO_ERROR));
+
+  if (stop)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the editor drive for DRIVE->REPORT from PREFETCH's RA session.
+   Runs on the fetching thread. */
+static svn_error_t *
+fetch_merge_drive(prefetched_drive_t *drive,
+                  merge_prefetch_t *prefetch)
+{
+  const merge_report_t *report = drive->report;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  /* Objects used from multiple threads must live in a thread-safe pool. */
+  drive->pool = svn_pool_create(NULL);
+
+  SVN_ERR(svn_client__get_spool_editor(&editor, &edit_baton, &drive->edit,
+                                       drive->pool, drive->pool));
+  SVN_ERR(svn_delta_get_cancellation_editor(prefetch_cancel_func, prefetch,
+                                            editor, edit_baton,
+                                            &editor, &edit_baton,
+                                            drive->pool));
+
+  SVN_ERR(svn_ra_reparent(prefetch->ra_session, report->url1, drive->pool));
+  SVN_ERR(svn_ra_do_diff3(prefetch->ra_session,
+                          &reporter, &report_baton, report->rev2,
+                          "", report->depth, report->ignore_ancestry,
+                          TRUE,  /* text_deltas */
+                          report->url2, editor, edit_baton,
+                          drive->pool));
+
+  return svn_error_trace(send_merge_report(reporter, report_baton, report,
+                                           drive->pool));
+}
+
+/* Thread function fetching the drives of the merge_prefetch_t in DATA
+   in order, staying at most MERGE_PREFETCH_AHEAD drives ahead. */
+static void * APR_THREAD_FUNC
+merge_prefetch_thread(apr_thread_t *tid,
+                      void *data)
+{
+  merge_prefetch_t *prefetch = data;
+  apr_thread_mutex_t *mutex = svn_mutex__get(prefetch->mutex);
+  svn_boolean_t failed = FALSE;
+  int i;
+
+  for (i = 0; i < prefetch->drives->nelts; i++)
+    {
+      prefetched_drive_t *drive = APR_ARRAY_IDX(prefetch->drives, i,
+                                                prefetched_drive_t *);
+      svn_boolean_t skip;
+
+      /* If locking fails, the main thread will fail as well.  There is no
+         way to tell it what the problem was. */
+      apr_thread_mutex_lock(mutex);
+      while (i - prefetch->next_use >= MERGE_PREFETCH_AHEAD
+             && !prefetch->stop)
+        apr_thread_cond_wait(prefetch->cond, mutex);
+      skip = prefetch->stop || failed;
+      apr_thread_mutex_unlock(mutex);
+
+      /* After a failure, the merge will report any problems itself. */
+      if (!skip)
+        {
+          drive->err = fetch_merge_drive(drive, prefetch);
+          failed = (drive->err != SVN_NO_ERROR);
+        }
+
+      apr_thread_mutex_lock(mutex);
+      drive->done = TRUE;
+      apr_thread_cond_broadcast(prefetch->cond);
+      apr_thread_mutex_unlock(mutex);
+    }
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Pool cleanup function for the merge_prefetch_t in DATA.  Stops and
+   terminates its thread and releases the drives not used. */
+static apr_status_t
+merge_prefetch_cleanup(void *data)
+{
+  merge_prefetch_t *prefetch = data;
+  apr_status_t retval;
+  int i;
+
+  apr_thread_mutex_lock(svn_mutex__get(prefetch->mutex));
+  prefetch->stop = TRUE;
+  apr_thread_cond_broadcast(prefetch->cond);
+  apr_thread_mutex_unlock(svn_mutex__get(prefetch->mutex));
+
+  apr_thread_join(&retval, prefetch->thread);
+
+  for (i = prefetch->next_use; i < prefetch->drives->nelts; i++)
+    {
+      prefetched_drive_t *drive = APR_ARRAY_IDX(prefetch->drives, i,
+                                                prefetched_drive_t *);
+
+      svn_error_clear(drive->err);
+      if (drive->pool)
+        svn_pool_destroy(drive->pool);
+    }
+
+  svn_pool_destroy(prefetch->pool);
+
+  return APR_SUCCESS;
+}
+
+/* If PREFETCH has fetched the editor drive described by REPORT, set
+   *DRIVE to it.  The caller must destroy its pool.  Otherwise, set *DRIVE
+   to NULL, and if REPORT isn't the next drive expected, stop fetching. */
+static svn_error_t *
+take_prefetched_drive(prefetched_drive_t **drive,
+                      merge_prefetch_t *prefetch,
+                      const merge_report_t *report)
+{
+  apr_thread_mutex_t *mutex = svn_mutex__get(prefetch->mutex);
+  prefetched_drive_t *next = NULL;
+  apr_status_t status;
+
+  *drive = NULL;
+
+  status = apr_thread_mutex_lock(mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock mutex"));
+
+  if (!prefetch->stop && prefetch->next_use < prefetch->drives->nelts)
+    {
+      next = APR_ARRAY_IDX(prefetch->drives, prefetch->next_use,
+                           prefetched_drive_t *);
+
+      /* The merge may take a different course than predicted, e.g. when
+         subtrees gain or lose mergeinfo. */
+      if (merge_reports_equal(next->report, report))
+        {
+          while (!next->done && !status)
+            status = apr_thread_cond_wait(prefetch->cond, mutex);
+        }
+      else
+        {
+          next = NULL;
+          prefetch->stop = TRUE;
+        }
+    }
+
+  if (next && !status)
+    prefetch->next_use++;
+
+  apr_thread_cond_broadcast(prefetch->cond);
+  apr_thread_mutex_unlock(mutex);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  if (next)
+    {
+      if (!next->err && svn_client__spooled_edit_complete(next->edit))
+        *drive = next;
+      else
+        {
+          svn_error_clear(next->err);
+          next->err = SVN_NO_ERROR;
+          if (next->pool)
+            svn_pool_destroy(next->pool);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Helper for do_directory_merge().
 
    Set up the diff editor report to merge the SOURCE diff
@@ -5675,78 +6596,31 @@ remove_children_with_deleted_mergeinfo(merge_cmd_baton_t *merge_b,
    historical ancestor of SOURCE->loc2, or vice-versa (see
    `MERGEINFO MERGE SOURCE NORMALIZATION' for more requirements around
    SOURCE in this case).
+
+   If PREFETCH is not NULL and has fetched this editor drive in advance,
+   replay that drive instead of asking the repository again.
 */
 static svn_error_t *
-drive_merge_report_editor(const char *target_abspath,
-                          const merge_source_t *source,
-                          const apr_array_header_t *children_with_mergeinfo,
-                          const svn_diff_tree_processor_t *processor,
-                          svn_depth_t depth,
-                          merge_cmd_baton_t *merge_b,
-                          apr_pool_t *scratch_pool)
-{
-  const svn_ra_reporter3_t *reporter;
-  const svn_delta_editor_t *diff_editor;
-  void *diff_edit_baton;
-  void *report_baton;
-  svn_revnum_t target_start;
-  svn_boolean_t honor_mergeinfo = HONOR_MERGEINFO(merge_b);
-  const char *old_sess1_url, *old_sess2_url;
-  svn_boolean_t is_rollback = source->loc1->rev > source->loc2->rev;
-
-  /* Start with a safe default starting revision for the editor and the
-     merge target. */
-  target_start = source->loc1->rev;
-
-  /* If we are honoring mergeinfo the starting revision for the merge target
-     might not be SOURCE->rev1, in fact the merge target might not need *any*
-     part of SOURCE merged -- Instead some subtree of the target
-     needs SOURCE -- So get the right starting revision for the
-     target. */
-  if (honor_mergeinfo)
-    {
-      svn_client__merge_path_t *child;
-
-      /* CHILDREN_WITH_MERGEINFO must always exist if we are honoring
-         mergeinfo and must have at least one element (describing the
-         merge target). */
-      SVN_ERR_ASSERT(children_with_mergeinfo);
-      SVN_ERR_ASSERT(children_with_mergeinfo->nelts);
+drive_merge_report_editor(const char *target_abspath,
+                          const merge_source_t *source,
+                          const apr_array_header_t *children_with_mergeinfo,
+                          const svn_diff_tree_processor_t *processor,
+                          svn_depth_t depth,
+                          merge_prefetch_t *prefetch,
+                          merge_cmd_baton_t *merge_b,
+                          apr_pool_t *scratch_pool)
+{
+  const svn_ra_reporter3_t *reporter;
+  const svn_delta_editor_t *diff_editor;
+  void *diff_edit_baton;
+  void *report_baton;
+  merge_report_t *report;
+  svn_boolean_t replayed = FALSE;
+  const char *old_sess1_url, *old_sess2_url;
 
-      /* Get the merge target's svn_client__merge_path_t, which is always
-         the first in the array due to depth first sorting requirement,
-         see 'THE CHILDREN_WITH_MERGEINFO ARRAY'. */
-      child = APR_ARRAY_IDX(children_with_mergeinfo, 0,
-                            svn_client__merge_path_t *);
-      SVN_ERR_ASSERT(child);
-      if (child->remaining_ranges->nelts == 0)
-        {
-          /* The merge target doesn't need anything merged. */
-          target_start = source->loc2->rev;
-        }
-      else
-        {
-          /* The merge target has remaining revisions to merge.  These
-             ranges may fully or partially overlap the range described
-             by SOURCE->rev1:rev2 or may not intersect that range at
-             all. */
-          svn_merge_range_t *range =
-            APR_ARRAY_IDX(child->remaining_ranges, 0,
-                          svn_merge_range_t *);
-          if ((!is_rollback && range->start > source->loc2->rev)
-              || (is_rollback && range->start < source->loc2->rev))
-            {
-              /* Merge target's first remaining range doesn't intersect. */
-              target_start = source->loc2->rev;
-            }
-          else
-            {
-              /* Merge target's first remaining range partially or
-                 fully overlaps. */
-              target_start = range->start;
-            }
-        }
-    }
+  SVN_ERR(describe_merge_report(&report, target_abspath, source,
+                                children_with_mergeinfo, depth, merge_b,
+                                scratch_pool, scratch_pool));
 
   SVN_ERR(svn_client__ensure_ra_session_url(&old_sess1_url,
                                             merge_b->ra_session1,
@@ -5768,114 +6642,47 @@ drive_merge_report_editor(const char *target_abspath,
                                        merge_b->ctx->cancel_func,
                                        merge_b->ctx->cancel_baton,
                                        scratch_pool));
-  SVN_ERR(svn_ra_do_diff3(merge_b->ra_session1,
-                          &reporter, &report_baton, source->loc2->rev,
-                          "", depth, merge_b->diff_ignore_ancestry,
-                          TRUE,  /* text_deltas */
-                          source->loc2->url, diff_editor, diff_edit_baton,
-                          scratch_pool));
 
-  /* Drive the reporter. */
-  SVN_ERR(reporter->set_path(report_baton, "", target_start, depth,
-                             FALSE, NULL, scratch_pool));
-  if (honor_mergeinfo && children_with_mergeinfo)
+  SVN_ERR(start_text_merges(merge_b, scratch_pool));
+
+#if APR_HAS_THREADS
+  /* Use the drive fetched in the background, if there is one. */
+  if (prefetch)
     {
-      /* Describe children with mergeinfo overlapping this merge
-         operation such that no repeated diff is retrieved for them from
-         the repository. */
-      int i;
-      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      prefetched_drive_t *drive;
 
-      /* Start with CHILDREN_WITH_MERGEINFO[1], CHILDREN_WITH_MERGEINFO[0]
-         is always the merge target (TARGET_ABSPATH). */
-      for (i = 1; i < children_with_mergeinfo->nelts; i++)
+      SVN_ERR(take_prefetched_drive(&drive, prefetch, report));
+      if (drive)
         {
-          svn_merge_range_t *range;
-          const char *child_repos_path;
-          const svn_client__merge_path_t *parent;
-          const svn_client__merge_path_t *child =
-            APR_ARRAY_IDX(children_with_mergeinfo, i,
-                          svn_client__merge_path_t *);
-
-          SVN_ERR_ASSERT(child);
-          if (child->absent)
-            continue;
-
-          svn_pool_clear(iterpool);
-
-          /* Find this child's nearest wc ancestor with mergeinfo. */
-          parent = find_nearest_ancestor(children_with_mergeinfo,
-                                         FALSE, child->abspath);
+          svn_error_t *err;
 
-          /* If a subtree needs the same range applied as its nearest parent
-             with mergeinfo or neither the subtree nor this parent need
-             SOURCE->rev1:rev2 merged, then we don't need to describe the
-             subtree separately.  In the latter case this could break the
-             editor if child->abspath didn't exist at SOURCE->rev2 and we
-             attempt to describe it via a reporter set_path call. */
-          if (child->remaining_ranges->nelts)
-            {
-              range = APR_ARRAY_IDX(child->remaining_ranges, 0,
-                                    svn_merge_range_t *);
-              if ((!is_rollback && range->start > source->loc2->rev)
-                  || (is_rollback && range->start < source->loc2->rev))
-                {
-                  /* This child's first remaining range comes after the range
-                     we are currently merging, so skip it. We expect to get
-                     to it in a subsequent call to this function. */
-                  continue;
-                }
-              else if (parent->remaining_ranges->nelts)
-                {
-                   svn_merge_range_t *parent_range =
-                    APR_ARRAY_IDX(parent->remaining_ranges, 0,
-                                  svn_merge_range_t *);
-                   svn_merge_range_t *child_range =
-                    APR_ARRAY_IDX(child->remaining_ranges, 0,
-                                  svn_merge_range_t *);
-                  if (parent_range->start == child_range->start)
-                    continue; /* Subtree needs same range as parent. */
-                }
-            }
-          else /* child->remaining_ranges->nelts == 0*/
-            {
-              /* If both the subtree and its parent need no ranges applied
-                 consider that as the "same ranges" and don't describe
-                 the subtree. */
-              if (parent->remaining_ranges->nelts == 0)
-                continue;
-            }
+          err = svn_client__replay_spooled_edit(drive->edit,
+                                                diff_editor, diff_edit_baton,
+                                                merge_b->ctx->cancel_func,
+                                                merge_b->ctx->cancel_baton,
+                                                scratch_pool);
+          svn_pool_destroy(drive->pool);
+          SVN_ERR(err);
+          replayed = TRUE;
+        }
+    }
+#endif
 
-          /* Ok, we really need to describe this subtree as it needs different
-             ranges applied than its nearest working copy parent. */
-          child_repos_path = svn_dirent_is_child(target_abspath,
-                                                 child->abspath,
-                                                 iterpool);
-          /* This loop is only processing subtrees, so CHILD->ABSPATH
-             better be a proper child of the merge target. */
-          SVN_ERR_ASSERT(child_repos_path);
+  if (!replayed)
+    {
+      SVN_ERR(svn_ra_do_diff3(merge_b->ra_session1,
+                              &reporter, &report_baton, source->loc2->rev,
+                              "", depth, merge_b->diff_ignore_ancestry,
+                              TRUE,  /* text_deltas */
+                              source->loc2->url, diff_editor, diff_edit_baton,
+                              scratch_pool));
 
-          if ((child->remaining_ranges->nelts == 0)
-              || (is_rollback && (range->start < source->loc2->rev))
-              || (!is_rollback && (range->start > source->loc2->rev)))
-            {
-              /* Nothing to merge to this child.  We'll claim we have
-                 it up to date so the server doesn't send us
-                 anything. */
-              SVN_ERR(reporter->set_path(report_baton, child_repos_path,
-                                         source->loc2->rev, depth, FALSE,
-                                         NULL, iterpool));
-            }
-          else
-            {
-              SVN_ERR(reporter->set_path(report_baton, child_repos_path,
-                                         range->start, depth, FALSE,
-                                         NULL, iterpool));
-            }
-        }
-      svn_pool_destroy(iterpool);
+      /* Drive the reporter. */
+      SVN_ERR(send_merge_report(reporter, report_baton, report,
+                                scratch_pool));
     }
-  SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+
+  SVN_ERR(finish_text_merges(merge_b, scratch_pool));
 
   /* Point the merge baton's RA sessions back where they were. */
   SVN_ERR(svn_ra_reparent(merge_b->ra_session1, old_sess1_url, scratch_pool));
@@ -8035,7 +8842,7 @@ do_mergeinfo_unaware_dir_merge(single_range_conflict_report_t **conflict_report,
                  svn_client__merge_path_t *) = item;
   SVN_ERR(drive_merge_report_editor(target_dir_wcpath,
                                     source,
-                                    NULL, processor, depth,
+                                    NULL, processor, depth, NULL,
                                     merge_b, scratch_pool));
   if (is_path_conflicted_by_merge(merge_b))
     {
@@ -9128,15 +9935,14 @@ remove_noop_subtree_ranges(const merge_source_t *source,
   if (!subtree_gap_ranges->nelts)
     return SVN_NO_ERROR;
 
-  /* Create a rangelist describing every range required across all subtrees. */
-  iterpool = svn_pool_create(scratch_pool);
+  /* Create a rangelist describing every range required across all subtrees.
+     Rather than merging the subtrees' rangelists one by one, collect all
+     their ranges and combine them in one go. */
   for (i = 1; i < children_with_mergeinfo->nelts; i++)
     {
       svn_client__merge_path_t *child =
         APR_ARRAY_IDX(children_with_mergeinfo, i, svn_client__merge_path_t *);
 
-      svn_pool_clear(iterpool);
-
       /* CHILD->REMAINING_RANGES will be NULL if child is absent. */
       if (child->remaining_ranges && child->remaining_ranges->nelts)
         {
@@ -9150,11 +9956,15 @@ remove_noop_subtree_ranges(const merge_source_t *source,
           else
             longest_common_subtree_ancestor = child->abspath;
 
-          SVN_ERR(svn_rangelist_merge2(subtree_remaining_ranges,
-                                       child->remaining_ranges,
-                                       scratch_pool, iterpool));
+          apr_array_cat(subtree_remaining_ranges, child->remaining_ranges);
         }
     }
+
+  iterpool = svn_pool_create(scratch_pool);
+  subtree_remaining_ranges = svn_rangelist__expand(
+                               svn_rangelist__compact(subtree_remaining_ranges,
+                                                      iterpool, iterpool),
+                               scratch_pool);
   svn_pool_destroy(iterpool);
 
   /* It's possible that none of the subtrees had any remaining ranges. */
@@ -9259,6 +10069,232 @@ remove_noop_subtree_ranges(const merge_source_t *source,
   return SVN_NO_ERROR;
 }
 
+/* Helper for do_mergeinfo_aware_dir_merge().
+
+   Return END_REV, the end of the next editor drive starting at START_REV,
+   limited such that the drive doesn't start the merge target
+   TARGET_MERGE_PATH in the middle of its first remaining range.
+
+   Issue #3324: Stop editor abuse!  Don't call drive_merge_report_editor()
+   in such a way that we request an editor with
+   svn_client__get_diff_editor() for some rev X, then call
+   svn_ra_do_diff3() for some revision Y, and then call
+   reporter->set_path(PATH=="") to set the root revision for the editor
+   drive to revision Z where (X != Z && X < Z < Y).  This is bogus because
+   the server will send us the diff between X:Y but the client is expecting
+   the diff between Y:Z.  See issue #3324 for full details on the problems
+   this can cause. */
+static svn_revnum_t
+limit_drive_end_rev(svn_revnum_t start_rev,
+                    svn_revnum_t end_rev,
+                    const svn_client__merge_path_t *target_merge_path,
+                    svn_boolean_t is_rollback)
+{
+  svn_merge_range_t *first_target_range
+    = (target_merge_path->remaining_ranges->nelts == 0 ? NULL
+       : APR_ARRAY_IDX(target_merge_path->remaining_ranges, 0,
+                       svn_merge_range_t *));
+
+  if (first_target_range
+      && start_rev != first_target_range->start)
+    {
+      if (is_rollback)
+        {
+          if (end_rev < first_target_range->start)
+            end_rev = first_target_range->start;
+        }
+      else
+        {
+          if (end_rev > first_target_range->start)
+            end_rev = first_target_range->start;
+        }
+    }
+
+  return end_rev;
+}
+
+#if APR_HAS_THREADS
+/* Helper for start_merge_prefetch().
+
+   Set *REPORTS to the descriptions (const merge_report_t *) of the editor
+   drives do_mergeinfo_aware_dir_merge() will perform after the first one
+   to merge SOURCE into MERGE_B->target, if it merges without conflicts and
+   no subtree gains or loses mergeinfo.  START_REV and END_REV are the
+   bounds of the first drive.  The other arguments are as for
+   do_mergeinfo_aware_dir_merge().
+
+   CHILDREN_WITH_MERGEINFO is not modified.  Allocate *REPORTS in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+predict_merge_reports(apr_array_header_t **reports,
+                      const merge_source_t *source,
+                      const apr_array_header_t *children_with_mergeinfo,
+                      svn_revnum_t start_rev,
+                      svn_revnum_t end_rev,
+                      svn_depth_t depth,
+                      svn_boolean_t is_rollback,
+                      merge_cmd_baton_t *merge_b,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *children;
+  svn_client__merge_path_t *target_merge_path;
+  svn_boolean_t first = TRUE;
+  int i;
+
+  *reports = apr_array_make(result_pool, 0, sizeof(merge_report_t *));
+
+  /* Simulate the drives on copies of the remaining ranges. */
+  children = apr_array_make(scratch_pool, children_with_mergeinfo->nelts,
+                            sizeof(svn_client__merge_path_t *));
+  for (i = 0; i < children_with_mergeinfo->nelts; i++)
+    {
+      const svn_client__merge_path_t *child
+        = APR_ARRAY_IDX(children_with_mergeinfo, i,
+                        svn_client__merge_path_t *);
+      svn_client__merge_path_t *copy = NULL;
+
+      if (child)
+        {
+          copy = apr_pmemdup(scratch_pool, child, sizeof(*child));
+          if (child->remaining_ranges)
+            copy->remaining_ranges = svn_rangelist_dup(child->remaining_ranges,
+                                                       scratch_pool);
+        }
+
+      APR_ARRAY_PUSH(children, svn_client__merge_path_t *) = copy;
+    }
+  target_merge_path = APR_ARRAY_IDX(children, 0, svn_client__merge_path_t *);
+
+  while (end_rev != SVN_INVALID_REVNUM)
+    {
+      end_rev = limit_drive_end_rev(start_rev, end_rev, target_merge_path,
+                                    is_rollback);
+
+      slice_remaining_ranges(children, is_rollback, end_rev, scratch_pool);
+
+      /* The merge drives the first one itself right away. */
+      if (!first)
+        {
+          merge_source_t *real_source;
+          merge_report_t *report;
+
+          real_source = subrange_source(source, start_rev, end_rev,
+                                        scratch_pool);
+          SVN_ERR(describe_merge_report(&report, merge_b->target->abspath,
+                                        real_source, children, depth,
+                                        merge_b, result_pool,
+                                        scratch_pool));
+          APR_ARRAY_PUSH(*reports, merge_report_t *) = report;
+        }
+      first = FALSE;
+
+      remove_first_range_from_remaining_ranges(end_rev, children,
+                                               scratch_pool);
+
+      start_rev = get_most_inclusive_rev(children, is_rollback, TRUE);
+      end_rev = get_most_inclusive_rev(children, is_rollback, FALSE);
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif /* APR_HAS_THREADS */
+
+/* Helper for do_mergeinfo_aware_dir_merge().
+
+   Set *PREFETCH to a new merge_prefetch_t fetching the editor drives
+   following the first one, which merges START_REV:END_REV, on another RA
+   session while the merge applies the previous ones.  Set *PREFETCH to
+   NULL if there is nothing to fetch ahead, or if that is not possible.
+   The other arguments are as for predict_merge_reports().
+
+   The fetching stops when RESULT_POOL is cleared.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+start_merge_prefetch(merge_prefetch_t **prefetch,
+                     const merge_source_t *source,
+                     const apr_array_header_t *children_with_mergeinfo,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_depth_t depth,
+                     svn_boolean_t is_rollback,
+                     merge_cmd_baton_t *merge_b,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  merge_prefetch_t *mp;
+  apr_array_header_t *reports;
+  apr_pool_t *pool;
+  apr_status_t status;
+  svn_error_t *err;
+  int i;
+
+  *prefetch = NULL;
+
+  /* Objects used from multiple threads must live in a thread-safe pool. */
+  pool = svn_pool_create(NULL);
+  mp = apr_pcalloc(pool, sizeof(*mp));
+  mp->pool = pool;
+
+  err = predict_merge_reports(&reports, source, children_with_mergeinfo,
+                              start_rev, end_rev, depth, is_rollback,
+                              merge_b, pool, scratch_pool);
+  if (!err && reports->nelts == 0)
+    {
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  if (!err)
+    err = svn_client__open_ra_session_internal(&mp->ra_session, NULL,
+                                               source->loc1->url, NULL, NULL,
+                                               FALSE, FALSE, merge_b->ctx,
+                                               pool, scratch_pool);
+  if (!err)
+    err = svn_mutex__init(&mp->mutex, TRUE, pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  status = apr_thread_cond_create(&mp->cond, pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, _("Can't create condition variable"));
+    }
+
+  mp->drives = apr_array_make(pool, reports->nelts,
+                              sizeof(prefetched_drive_t *));
+  for (i = 0; i < reports->nelts; i++)
+    {
+      prefetched_drive_t *drive = apr_pcalloc(pool, sizeof(*drive));
+
+      drive->report = APR_ARRAY_IDX(reports, i, const merge_report_t *);
+      APR_ARRAY_PUSH(mp->drives, prefetched_drive_t *) = drive;
+    }
+
+  status = apr_thread_create(&mp->thread, NULL, merge_prefetch_thread, mp,
+                             pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  apr_pool_cleanup_register(result_pool, mp, merge_prefetch_cleanup,
+                            apr_pool_cleanup_null);
+
+  *prefetch = mp;
+#else
+  *prefetch = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Perform a merge of changes in SOURCE to the working copy path
    TARGET_ABSPATH. Both URLs in SOURCE, and TARGET_ABSPATH all represent
    directories -- for the single file case, the caller should use
@@ -9414,6 +10450,10 @@ do_mergeinfo_aware_dir_merge(svn_mergeinfo_catalog_t result_catalog,
            svn_revnum_t end_rev =
              get_most_inclusive_rev(children_with_mergeinfo,
                                     is_rollback, FALSE);
+          merge_prefetch_t *prefetch;
+          apr_pool_t *prefetch_pool;
+          svn_boolean_t first_drive = TRUE;
+          svn_error_t *err;
 
           /* While END_REV is valid, do the following:
 
@@ -9442,38 +10482,27 @@ do_mergeinfo_aware_dir_merge(svn_mergeinfo_catalog_t result_catalog,
              6. Lather, rinse, repeat.
           */
 
+          /* Fetch the later drives from the repository while the
+             earlier ones are being applied to the working copy. */
+          prefetch_pool = svn_pool_create(scratch_pool);
+          err = start_merge_prefetch(&prefetch, source,
+                                     children_with_mergeinfo,
+                                     start_rev, end_rev, depth, is_rollback,
+                                     merge_b, prefetch_pool, iterpool);
+          if (err)
+            {
+              /* Not fatal, just slower. */
+              svn_error_clear(err);
+              prefetch = NULL;
+            }
+
           while (end_rev != SVN_INVALID_REVNUM)
             {
               merge_source_t *real_source;
-              svn_merge_range_t *first_target_range
-                = (target_merge_path->remaining_ranges->nelts == 0 ? NULL
-                   : APR_ARRAY_IDX(target_merge_path->remaining_ranges, 0,
-                                   svn_merge_range_t *));
-
-              /* Issue #3324: Stop editor abuse!  Don't call
-                 drive_merge_report_editor() in such a way that we request an
-                 editor with svn_client__get_diff_editor() for some rev X,
-                 then call svn_ra_do_diff3() for some revision Y, and then
-                 call reporter->set_path(PATH=="") to set the root revision
-                 for the editor drive to revision Z where
-                 (X != Z && X < Z < Y).  This is bogus because the server will
-                 send us the diff between X:Y but the client is expecting the
-                 diff between Y:Z.  See issue #3324 for full details on the
-                 problems this can cause. */
-              if (first_target_range
-                  && start_rev != first_target_range->start)
-                {
-                  if (is_rollback)
-                    {
-                      if (end_rev < first_target_range->start)
-                        end_rev = first_target_range->start;
-                    }
-                  else
-                    {
-                      if (end_rev > first_target_range->start)
-                        end_rev = first_target_range->start;
-                    }
-                }
+
+              /* Issue #3324: Stop editor abuse! */
+              end_rev = limit_drive_end_rev(start_rev, end_rev,
+                                            target_merge_path, is_rollback);
 
               svn_pool_clear(iterpool);
 
@@ -9490,8 +10519,10 @@ do_mergeinfo_aware_dir_merge(svn_mergeinfo_catalog_t result_catalog,
                 children_with_mergeinfo,
                 processor,
                 depth,
+                first_drive ? NULL : prefetch,
                 merge_b,
                 iterpool));
+              first_drive = FALSE;
 
               /* If any paths picked up explicit mergeinfo as a result of
                  the merge we need to make sure any mergeinfo those paths
@@ -9540,6 +10571,9 @@ do_mergeinfo_aware_dir_merge(svn_mergeinfo_catalog_t result_catalog,
                 get_most_inclusive_rev(children_with_mergeinfo,
                                        is_rollback, FALSE);
             }
+
+          /* Stop fetching drives that weren't needed. */
+          svn_pool_destroy(prefetch_pool);
         }
       svn_pool_destroy(iterpool);
     }
@@ -9557,6 +10591,7 @@ do_mergeinfo_aware_dir_merge(svn_mergeinfo_catalog_t result_catalog,
                                             NULL,
                                             processor,
                                             depth,
+                                            NULL,
                                             merge_b,
                                             scratch_pool));
         }
@@ -10573,7 +11608,8 @@ svn_client__merge_locked(svn_client__conflict_report_t **conflict_report,
           svn_pool_destroy(sesspool);
 
           if (use_sleep)
-            svn_io_sleep_for_timestamps(target->abspath, scratch_pool);
+            svn_wc__sleep_for_timestamps(ctx->wc_ctx, target->abspath,
+                                         scratch_pool);
 
           SVN_ERR(err);
           return SVN_NO_ERROR;
@@ -10598,7 +11634,7 @@ svn_client__merge_locked(svn_client__conflict_report_t **conflict_report,
   svn_pool_destroy(sesspool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target->abspath, scratch_pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, target->abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -10665,6 +11701,9 @@ svn_client_merge5(const char *source1,
   SVN_ERR(get_target_and_lock_abspath(&target_abspath, &lock_abspath,
                                       target_wcpath, ctx, pool));
 
+  /* Trace the history of each node only once per merge. */
+  svn_client__cache_location_segments(ctx, pool);
+
   if (!dry_run)
     SVN_WC__CALL_WITH_WRITE_LOCK(
       svn_client__merge_locked(&conflict_report,
@@ -11769,7 +12808,7 @@ merge_reintegrate_locked(svn_client__conflict_report_t **conflict_report,
                                                result_pool, scratch_pool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -11790,6 +12829,9 @@ svn_client_merge_reintegrate(const char *source_path_or_url,
   SVN_ERR(get_target_and_lock_abspath(&target_abspath, &lock_abspath,
                                       target_wcpath, ctx, pool));
 
+  /* Trace the history of each node only once per merge. */
+  svn_client__cache_location_segments(ctx, pool);
+
   if (!dry_run)
     SVN_WC__CALL_WITH_WRITE_LOCK(
       merge_reintegrate_locked(&conflict_report,
@@ -11893,7 +12935,7 @@ merge_peg_locked(svn_client__conflict_report_t **conflict_report,
   svn_pool_destroy(sesspool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -11959,6 +13001,9 @@ svn_client_merge_peg5(const char *source_path_or_url,
   SVN_ERR(get_target_and_lock_abspath(&target_abspath, &lock_abspath,
                                       target_wcpath, ctx, pool));
 
+  /* Trace the history of each node only once per merge. */
+  svn_client__cache_location_segments(ctx, pool);
+
   /* Do an automatic merge if no revision ranges are specified. */
   if (ranges_to_merge == NULL)
     {
@@ -12821,7 +13866,7 @@ do_automatic_merge_locked(svn_client__conflict_report_t **conflict_report,
     }
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
 
@@ -1256,10 +1256,10 @@ struct filter_log_entry_baton_t
      TARGET_MERGEINFO_CATALOG. */
   apr_array_header_t *depth_first_catalog_index;
 
-  /* A rangelist describing all the revisions potentially merged or
+  /* A compact rangelist describing all the revisions potentially merged or
      potentially eligible for merging (see FILTERING_MERGED) based on
      the target's explicit or inherited mergeinfo. */
-  const svn_rangelist_t *rangelist;
+  const svn_rangelist__compact_t *rangelist;
 
   /* The wrapped svn_log_entry_receiver_t callback and baton which
      filter_log_entry_with_rangelist() is acting as a filter for. */
@@ -1291,7 +1291,8 @@ filter_log_entry_with_rangelist(void *baton,
                                 apr_pool_t *pool)
 {
   struct filter_log_entry_baton_t *fleb = baton;
-  svn_rangelist_t *intersection, *this_rangelist;
+  svn_rangelist_t *intersection;
+  const svn_merge_range_t *range;
 
   if (fleb->ctx->cancel_func)
     SVN_ERR(fleb->ctx->cancel_func(fleb->ctx->cancel_baton));
@@ -1300,27 +1301,16 @@ filter_log_entry_with_rangelist(void *baton,
   if (log_entry->revision == 0)
     return SVN_NO_ERROR;
 
-  this_rangelist = svn_rangelist__initialize(log_entry->revision - 1,
-                                             log_entry->revision,
-                                             TRUE, pool);
-
-  /* Don't consider inheritance yet, see if LOG_ENTRY->REVISION is
-     fully or partially represented in BATON->RANGELIST. */
-  SVN_ERR(svn_rangelist_intersect(&intersection, fleb->rangelist,
-                                  this_rangelist, FALSE, pool));
-  if (! (intersection && intersection->nelts))
+  /* See if LOG_ENTRY->REVISION is fully or partially represented in
+     BATON->RANGELIST. */
+  range = svn_rangelist__compact_find(fleb->rangelist, log_entry->revision);
+  if (! range)
     return SVN_NO_ERROR;
 
-  SVN_ERR_ASSERT(intersection->nelts == 1);
-
   /* Ok, we know LOG_ENTRY->REVISION is represented in BATON->RANGELIST,
      but is it only partially represented, i.e. is the corresponding range in
-     BATON->RANGELIST non-inheritable?  Ask for the same intersection as
-     above but consider inheritance this time, if the intersection is empty
-     we know the range in BATON->RANGELIST is non-inheritable. */
-  SVN_ERR(svn_rangelist_intersect(&intersection, fleb->rangelist,
-                                  this_rangelist, TRUE, pool));
-  log_entry->non_inheritable = !intersection->nelts;
+     BATON->RANGELIST non-inheritable? */
+  log_entry->non_inheritable = !range->inheritable;
 
   /* If the paths changed by LOG_ENTRY->REVISION are provided we can determine
      if LOG_ENTRY->REVISION, while only partially represented in
@@ -1546,7 +1536,8 @@ logs_for_mergeinfo_rangelist(const char *source_url,
                    svn_sort_compare_items_as_paths,
                    scratch_pool);
   fleb.target_fspath = target_fspath;
-  fleb.rangelist = rangelist;
+  fleb.rangelist = svn_rangelist__compact(rangelist, scratch_pool,
+                                          scratch_pool);
   fleb.log_receiver = log_receiver;
   fleb.log_receiver_baton = log_receiver_baton;
   fleb.ctx = ctx;
@@ -2048,34 +2039,48 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
      logs_for_mergeinfo_rangelist). */
   if (master_inheritable_rangelist->nelts)
     {
+      /* With many subtrees and long rangelists, this loop dominates.  So,
+         operate on compact rangelists and convert back afterwards. */
+      svn_rangelist__compact_t *master_inheritable
+        = svn_rangelist__compact(master_inheritable_rangelist, scratch_pool,
+                                 scratch_pool);
+      svn_rangelist__compact_t *master_noninheritable
+        = svn_rangelist__compact(master_noninheritable_rangelist,
+                                 scratch_pool, scratch_pool);
+
       for (hi = apr_hash_first(scratch_pool, inheritable_subtree_merges);
            hi;
            hi = apr_hash_next(hi))
         {
-          svn_rangelist_t *deleted_rangelist;
-          svn_rangelist_t *added_rangelist;
+          svn_rangelist__compact_t *deleted;
           svn_rangelist_t *subtree_merged_rangelist = apr_hash_this_val(hi);
 
           svn_pool_clear(iterpool);
 
-          SVN_ERR(svn_rangelist_diff(&deleted_rangelist, &added_rangelist,
-                                     master_inheritable_rangelist,
-                                     subtree_merged_rangelist, TRUE,
-                                     iterpool));
+          /* The revisions fully merged to the target but not to this
+             subtree. */
+          deleted = svn_rangelist__compact_remove(
+                      svn_rangelist__compact(subtree_merged_rangelist,
+                                             iterpool, iterpool),
+                      master_inheritable, TRUE, iterpool);
 
-          if (deleted_rangelist->nelts)
+          if (deleted->nelts)
             {
-              svn_rangelist__set_inheritance(deleted_rangelist, FALSE);
-              SVN_ERR(svn_rangelist_merge2(master_noninheritable_rangelist,
-                                           deleted_rangelist,
-                                           scratch_pool, iterpool));
-              SVN_ERR(svn_rangelist_remove(&master_inheritable_rangelist,
-                                           deleted_rangelist,
-                                           master_inheritable_rangelist,
-                                           FALSE,
-                                           scratch_pool));
+              deleted = svn_rangelist__compact_set_inheritance(deleted, FALSE,
+                                                               iterpool);
+              master_noninheritable
+                = svn_rangelist__compact_merge(master_noninheritable, deleted,
+                                               scratch_pool);
+              master_inheritable
+                = svn_rangelist__compact_remove(deleted, master_inheritable,
+                                                FALSE, scratch_pool);
             }
         }
+
+      master_inheritable_rangelist
+        = svn_rangelist__expand(master_inheritable, scratch_pool);
+      master_noninheritable_rangelist
+        = svn_rangelist__expand(master_noninheritable, scratch_pool);
     }
 
   if (finding_merged)
@@ -56,6 +56,8 @@ typedef struct mtcc_op_t
   mtcc_kind_t kind;                 /* editor operation */
 
   apr_array_header_t *children;     /* List of mtcc_op_t * */
+  apr_hash_t *children_by_name;     /* name -> last mtcc_op_t * with that
+                                       name in CHILDREN */
 
   const char *src_relpath;              /* For ADD_DIR, ADD_FILE */
   svn_revnum_t src_rev;                 /* For ADD_DIR, ADD_FILE */
@@ -89,8 +91,23 @@ struct svn_client__mtcc_t
   svn_client_ctx_t *ctx;
 
   mtcc_op_t *root_op;
+
+  /* Kinds of nodes in the repository looked up so far, mapping
+     "REV/DIR_RELPATH" to mtcc_origin_dir_t * for their parent directory. */
+  apr_hash_t *origin_dirs;
 };
 
+/* After this many lookups of nodes in the same repository directory, list
+   the directory once instead of asking for every node separately. */
+#define MTCC_LIST_THRESHOLD 16
+
+/* What we know about the nodes in one directory of one revision */
+typedef struct mtcc_origin_dir_t
+{
+  int lookups;          /* Number of nodes looked up with svn_ra_check_path */
+  apr_hash_t *dirents;  /* name -> svn_dirent_t *, once listed, or NULL */
+} mtcc_origin_dir_t;
+
 static mtcc_op_t *
 mtcc_op_create(const char *name,
                svn_boolean_t add,
@@ -108,13 +125,40 @@ mtcc_op_create(const char *name,
     op->kind = directory ? OP_OPEN_DIR : OP_OPEN_FILE;
 
   if (directory)
-    op->children = apr_array_make(result_pool, 4, sizeof(mtcc_op_t *));
+    {
+      op->children = apr_array_make(result_pool, 4, sizeof(mtcc_op_t *));
+      op->children_by_name = apr_hash_make(result_pool);
+    }
 
   op->src_rev = SVN_INVALID_REVNUM;
 
   return op;
 }
 
+/* Append CHILD to the children of the directory operation OP */
+static void
+mtcc_op_add_child(mtcc_op_t *op,
+                  mtcc_op_t *child)
+{
+  APR_ARRAY_PUSH(op->children, mtcc_op_t *) = child;
+  svn_hash_sets(op->children_by_name, child->name, child);
+}
+
+/* Return the last child of OP named NAME, or NULL if there is none.
+
+   There is at most one child per name that is not a delete, and it always
+   comes after any deletes of that name (a replacement), so the last child
+   is the one a search from the end of the list would find. */
+static mtcc_op_t *
+mtcc_op_get_child(const mtcc_op_t *op,
+                  const char *name)
+{
+  if (!op->children_by_name)
+    return NULL;
+
+  return svn_hash_gets(op->children_by_name, name);
+}
+
 static svn_error_t *
 mtcc_op_find(mtcc_op_t **op,
              svn_boolean_t *created,
@@ -128,7 +172,7 @@ mtcc_op_find(mtcc_op_t **op,
 {
   const char *name;
   const char *child;
-  int i;
+  mtcc_op_t *cop;
 
   assert(svn_relpath_is_canonical(relpath));
   if (created)
@@ -168,20 +212,14 @@ mtcc_op_find(mtcc_op_t **op,
                                  name, base_op->name);
     }
 
-  for (i = base_op->children->nelts-1; i >= 0 ; i--)
-    {
-      mtcc_op_t *cop;
+  cop = mtcc_op_get_child(base_op, name);
 
-      cop = APR_ARRAY_IDX(base_op->children, i, mtcc_op_t *);
-
-      if (! strcmp(cop->name, name)
-          && (find_deletes || cop->kind != OP_DELETE))
-        {
-          return svn_error_trace(
-                        mtcc_op_find(op, created, child ? child : "", cop,
-                                     find_existing, find_deletes, create_file,
-                                     result_pool, scratch_pool));
-        }
+  if (cop && (find_deletes || cop->kind != OP_DELETE))
+    {
+      return svn_error_trace(
+                    mtcc_op_find(op, created, child ? child : "", cop,
+                                 find_existing, find_deletes, create_file,
+                                 result_pool, scratch_pool));
     }
 
   if (!created)
@@ -190,25 +228,21 @@ mtcc_op_find(mtcc_op_t **op,
       return SVN_NO_ERROR;
     }
 
-  {
-    mtcc_op_t *cop;
-
-    cop = mtcc_op_create(name, FALSE, child || !create_file, result_pool);
+  cop = mtcc_op_create(name, FALSE, child || !create_file, result_pool);
 
-    APR_ARRAY_PUSH(base_op->children, mtcc_op_t *) = cop;
+  mtcc_op_add_child(base_op, cop);
 
-    if (!child)
-      {
-        *op = cop;
-        *created = TRUE;
-        return SVN_NO_ERROR;
-      }
+  if (!child)
+    {
+      *op = cop;
+      *created = TRUE;
+      return SVN_NO_ERROR;
+    }
 
-    return svn_error_trace(
-                mtcc_op_find(op, created, child, cop, find_existing,
-                             find_deletes, create_file,
-                             result_pool, scratch_pool));
-  }
+  return svn_error_trace(
+              mtcc_op_find(op, created, child, cop, find_existing,
+                           find_deletes, create_file,
+                           result_pool, scratch_pool));
 }
 
 /* Gets the original repository location of RELPATH, checking things
@@ -224,6 +258,8 @@ get_origin(svn_boolean_t *done,
 {
   const char *child;
   const char *name;
+  mtcc_op_t *cop;
+
   if (SVN_PATH_IS_EMPTY(relpath))
     {
       if (op->kind == OP_ADD_DIR || op->kind == OP_ADD_FILE)
@@ -244,34 +280,22 @@ get_origin(svn_boolean_t *done,
   else
     name = relpath;
 
-  if (op->children && op->children->nelts)
-    {
-      int i;
+  cop = mtcc_op_get_child(op, name);
 
-      for (i = op->children->nelts-1; i >= 0; i--)
+  if (cop)
+    {
+      if (cop->kind == OP_DELETE)
         {
-           mtcc_op_t *cop;
-
-           cop = APR_ARRAY_IDX(op->children, i, mtcc_op_t *);
-
-           if (! strcmp(cop->name, name))
-            {
-              if (cop->kind == OP_DELETE)
-                {
-                  *done = TRUE;
-                  return SVN_NO_ERROR;
-                }
-
-              SVN_ERR(get_origin(done, origin_relpath, rev,
-                                 cop, child ? child : "",
-                                 result_pool, scratch_pool));
+          *done = TRUE;
+          return SVN_NO_ERROR;
+        }
 
-              if (*origin_relpath || *done)
-                return SVN_NO_ERROR;
+      SVN_ERR(get_origin(done, origin_relpath, rev,
+                         cop, child ? child : "",
+                         result_pool, scratch_pool));
 
-              break;
-            }
-        }
+      if (*origin_relpath || *done)
+        return SVN_NO_ERROR;
     }
 
   if (op->kind == OP_ADD_DIR || op->kind == OP_ADD_FILE)
@@ -341,6 +365,7 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
   (*mtcc)->root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc_pool);
 
   (*mtcc)->ctx = ctx;
+  (*mtcc)->origin_dirs = apr_hash_make(mtcc_pool);
 
   SVN_ERR(svn_client_open_ra_session2(&(*mtcc)->ra_session, anchor_url,
                                       NULL /* wri_abspath */, ctx,
@@ -427,7 +452,7 @@ mtcc_reparent(const char *new_anchor_url,
 
       root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc->pool);
 
-      APR_ARRAY_PUSH(root_op->children, mtcc_op_t *) = mtcc->root_op;
+      mtcc_op_add_child(root_op, mtcc->root_op);
 
       mtcc->root_op = root_op;
     }
@@ -435,6 +460,69 @@ mtcc_reparent(const char *new_anchor_url,
   return SVN_NO_ERROR;
 }
 
+/* Set *KIND to the kind of ORIGIN_RELPATH in ORIGIN_REV in the repository.
+
+   As nodes in a revision never change, remember what we find.  When many
+   nodes of the same directory are looked up, as when adding lots of files
+   to one directory, list the directory once and answer from that. */
+static svn_error_t *
+mtcc_get_origin_kind(svn_node_kind_t *kind,
+                     const char *origin_relpath,
+                     svn_revnum_t origin_rev,
+                     svn_client__mtcc_t *mtcc,
+                     apr_pool_t *scratch_pool)
+{
+  const char *dir_relpath;
+  const char *name;
+  const char *key;
+  mtcc_origin_dir_t *dir;
+  svn_dirent_t *dirent;
+
+  if (SVN_PATH_IS_EMPTY(origin_relpath))
+    return svn_error_trace(svn_ra_check_path(mtcc->ra_session, "",
+                                             origin_rev, kind,
+                                             scratch_pool));
+
+  svn_relpath_split(&dir_relpath, &name, origin_relpath, scratch_pool);
+  key = apr_psprintf(scratch_pool, "%ld/%s", origin_rev, dir_relpath);
+
+  dir = svn_hash_gets(mtcc->origin_dirs, key);
+  if (!dir)
+    {
+      dir = apr_pcalloc(mtcc->pool, sizeof(*dir));
+      svn_hash_sets(mtcc->origin_dirs, apr_pstrdup(mtcc->pool, key), dir);
+    }
+
+  if (!dir->dirents && ++dir->lookups <= MTCC_LIST_THRESHOLD)
+    return svn_error_trace(svn_ra_check_path(mtcc->ra_session,
+                                             origin_relpath, origin_rev,
+                                             kind, scratch_pool));
+
+  if (!dir->dirents)
+    {
+      svn_error_t *err;
+
+      err = svn_ra_get_dir2(mtcc->ra_session, &dir->dirents, NULL, NULL,
+                            dir_relpath, origin_rev, SVN_DIRENT_KIND,
+                            mtcc->pool);
+
+      /* Nothing exists below something that is not a directory */
+      if (err && (err->apr_err == SVN_ERR_FS_NOT_FOUND
+                  || err->apr_err == SVN_ERR_FS_NOT_DIRECTORY))
+        {
+          svn_error_clear(err);
+          dir->dirents = apr_hash_make(mtcc->pool);
+        }
+      else
+        SVN_ERR(err);
+    }
+
+  dirent = svn_hash_gets(dir->dirents, name);
+  *kind = dirent ? dirent->kind : svn_node_none;
+
+  return SVN_NO_ERROR;
+}
+
 /* Check if it is safe to create a new node at NEW_RELPATH. Return a proper
    error if it is not */
 static svn_error_t *
@@ -541,8 +629,8 @@ svn_client__mtcc_add_copy(const char *src_relpath,
   SVN_ERR(mtcc_verify_create(mtcc, dst_relpath, scratch_pool));
 
   /* Subversion requires the kind of a copy */
-  SVN_ERR(svn_ra_check_path(mtcc->ra_session, src_relpath, revision, &kind,
-                            scratch_pool));
+  SVN_ERR(mtcc_get_origin_kind(&kind, src_relpath, revision, mtcc,
+                               scratch_pool));
 
   if (kind != svn_node_dir && kind != svn_node_file)
     {
@@ -656,6 +744,7 @@ mtcc_add_delete(const char *relpath,
 
   op->kind = OP_DELETE;
   op->children = NULL;
+  op->children_by_name = NULL;
   op->prop_mods = NULL;
 
   return SVN_NO_ERROR;
@@ -1009,6 +1098,7 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
         {
           mtcc->root_op->kind = OP_OPEN_FILE;
           mtcc->root_op->children = NULL;
+          mtcc->root_op->children_by_name = NULL;
         }
       return SVN_NO_ERROR;
     }
@@ -1025,8 +1115,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       if (!origin_relpath)
         *kind = svn_node_none;
       else
-        SVN_ERR(svn_ra_check_path(mtcc->ra_session, origin_relpath,
-                                  origin_rev, kind, scratch_pool));
+        SVN_ERR(mtcc_get_origin_kind(kind, origin_relpath, origin_rev,
+                                     mtcc, scratch_pool));
 
       if (op && *kind == svn_node_dir)
         {
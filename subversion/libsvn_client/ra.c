@@ -257,12 +257,8 @@ get_wc_contents(void *baton,
 {
   callback_baton_t *cb = baton;
 
-  if (! cb->wcroot_abspath)
-    {
-      *contents = NULL;
-      return SVN_NO_ERROR;
-    }
-
+  /* Even without a working copy, e.g. during a checkout, the contents
+     may be available from the content cache. */
   return svn_error_trace(
              svn_wc__get_pristine_contents_by_checksum(contents,
                                                        cb->ctx->wc_ctx,
@@ -619,6 +615,167 @@ compare_segments(const void *a, const void *b)
   return (a_seg->range_start < b_seg->range_start) ? -1 : 1;
 }
 
+/* A location history in the cache of svn_client__repos_location_segments().
+ */
+typedef struct cached_history_t
+{
+  /* The location segments, sorted oldest to youngest. */
+  apr_array_header_t *segments;
+
+  /* The END_REVISION of the request that fetched SEGMENTS, i.e. the
+     history is complete down to this revision. */
+  svn_revnum_t oldest_rev;
+} cached_history_t;
+
+/* Pool cleanup handler disabling the location segments cache of the
+   svn_client__private_ctx_t in BATON. */
+static apr_status_t
+uncache_location_segments(void *baton)
+{
+  svn_client__private_ctx_t *private_ctx = baton;
+
+  private_ctx->location_segments = NULL;
+  return APR_SUCCESS;
+}
+
+void
+svn_client__cache_location_segments(svn_client_ctx_t *ctx,
+                                    apr_pool_t *pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+
+  if (private_ctx->location_segments)
+    return;
+
+  private_ctx->location_segments = apr_hash_make(pool);
+  apr_pool_cleanup_register(pool, private_ctx, uncache_location_segments,
+                            apr_pool_cleanup_null);
+}
+
+/* Set *SEGMENTS to the location segments of URL@PEG_REVISION between
+ * START_REVISION and END_REVISION as found in CACHE, or to NULL if CACHE
+ * does not contain that part of the node's history.  REPOS_RELPATH is
+ * the repository-relative path of URL.  The revisions must be valid with
+ * END_REVISION <= START_REVISION <= PEG_REVISION.
+ *
+ * Allocate *SEGMENTS in RESULT_POOL.
+ */
+static void
+find_cached_segments(apr_array_header_t **segments,
+                     apr_hash_t *cache,
+                     const char *url,
+                     const char *repos_relpath,
+                     svn_revnum_t peg_revision,
+                     svn_revnum_t start_revision,
+                     svn_revnum_t end_revision,
+                     apr_pool_t *result_pool)
+{
+  apr_array_header_t *histories = svn_hash_gets(cache, url);
+  int i, j;
+
+  *segments = NULL;
+  if (! histories)
+    return;
+
+  for (i = 0; i < histories->nelts; i++)
+    {
+      const cached_history_t *history
+        = APR_ARRAY_IDX(histories, i, const cached_history_t *);
+      const svn_location_segment_t *peg_segment = NULL;
+
+      if (history->oldest_rev > end_revision)
+        continue;
+
+      for (j = 0; j < history->segments->nelts; j++)
+        {
+          const svn_location_segment_t *segment
+            = APR_ARRAY_IDX(history->segments, j,
+                            const svn_location_segment_t *);
+
+          if (segment->range_start <= peg_revision
+              && peg_revision <= segment->range_end)
+            {
+              peg_segment = segment;
+              break;
+            }
+        }
+
+      /* If the history occupies URL at PEG_REVISION, URL@PEG_REVISION is
+         the same node and its history is the part older than that. */
+      if (! peg_segment || ! peg_segment->path
+          || strcmp(peg_segment->path, repos_relpath) != 0)
+        continue;
+
+      *segments = apr_array_make(result_pool, history->segments->nelts,
+                                 sizeof(svn_location_segment_t *));
+      for (j = 0; j < history->segments->nelts; j++)
+        {
+          svn_location_segment_t *segment
+            = APR_ARRAY_IDX(history->segments, j, svn_location_segment_t *);
+
+          if (segment->range_end < end_revision
+              || segment->range_start > start_revision)
+            continue;
+
+          segment = svn_location_segment_dup(segment, result_pool);
+          segment->range_start = MAX(segment->range_start, end_revision);
+          segment->range_end = MIN(segment->range_end, start_revision);
+          APR_ARRAY_PUSH(*segments, svn_location_segment_t *) = segment;
+        }
+
+      return;
+    }
+}
+
+/* Add the sorted location SEGMENTS, which are complete down to
+ * END_REVISION, to CACHE.  REPOS_ROOT_URL is the root URL of the
+ * repository they belong to.
+ */
+static void
+cache_segments(apr_hash_t *cache,
+               const apr_array_header_t *segments,
+               svn_revnum_t end_revision,
+               const char *repos_root_url)
+{
+  apr_pool_t *cache_pool = apr_hash_pool_get(cache);
+  cached_history_t *history = apr_palloc(cache_pool, sizeof(*history));
+  int i;
+
+  history->segments = apr_array_make(cache_pool, segments->nelts,
+                                     sizeof(svn_location_segment_t *));
+  history->oldest_rev = end_revision;
+
+  for (i = 0; i < segments->nelts; i++)
+    {
+      svn_location_segment_t *segment
+        = svn_location_segment_dup(APR_ARRAY_IDX(segments, i,
+                                                 svn_location_segment_t *),
+                                   cache_pool);
+      const char *url;
+      apr_array_header_t *histories;
+
+      APR_ARRAY_PUSH(history->segments, svn_location_segment_t *) = segment;
+      if (! segment->path)
+        continue;
+
+      /* Index the history by every URL it occupies. */
+      url = svn_path_url_add_component2(repos_root_url, segment->path,
+                                        cache_pool);
+      histories = svn_hash_gets(cache, url);
+      if (! histories)
+        {
+          histories = apr_array_make(cache_pool, 1,
+                                     sizeof(cached_history_t *));
+          svn_hash_sets(cache, url, histories);
+        }
+      else if (APR_ARRAY_IDX(histories, histories->nelts - 1,
+                             cached_history_t *) == history)
+        continue;
+
+      APR_ARRAY_PUSH(histories, cached_history_t *) = history;
+    }
+}
+
 svn_error_t *
 svn_client__repos_location_segments(apr_array_header_t **segments,
                                     svn_ra_session_t *ra_session,
@@ -631,8 +788,39 @@ svn_client__repos_location_segments(apr_array_header_t **segments,
 {
   struct gls_receiver_baton_t gls_receiver_baton;
   const char *old_session_url;
+  const char *repos_root_url = NULL;
+  apr_hash_t *cache = svn_client__get_private_ctx(ctx)->location_segments;
   svn_error_t *err;
 
+  /* Only requests for a fixed peg revision have a well-defined answer
+     that we may cache. */
+  if (cache && SVN_IS_VALID_REVNUM(peg_revision))
+    {
+      if (! SVN_IS_VALID_REVNUM(start_revision))
+        start_revision = peg_revision;
+      if (! SVN_IS_VALID_REVNUM(end_revision))
+        end_revision = 0;
+    }
+  else
+    cache = NULL;
+
+  if (cache && end_revision <= start_revision
+      && start_revision <= peg_revision)
+    {
+      const char *repos_relpath;
+
+      SVN_ERR(svn_ra_get_repos_root2(ra_session, &repos_root_url, pool));
+      repos_relpath = svn_uri_skip_ancestor(repos_root_url, url, pool);
+      if (repos_relpath)
+        {
+          find_cached_segments(segments, cache, url, repos_relpath,
+                               peg_revision, start_revision, end_revision,
+                               pool);
+          if (*segments)
+            return SVN_NO_ERROR;
+        }
+    }
+
   *segments = apr_array_make(pool, 8, sizeof(svn_location_segment_t *));
   gls_receiver_baton.segments = *segments;
   gls_receiver_baton.ctx = ctx;
@@ -646,6 +834,10 @@ svn_client__repos_location_segments(apr_array_header_t **segments,
   SVN_ERR(svn_error_compose_create(
             err, svn_ra_reparent(ra_session, old_session_url, pool)));
   svn_sort__array(*segments, compare_segments);
+
+  if (cache && repos_root_url)
+    cache_segments(cache, *segments, end_revision, repos_root_url);
+
   return SVN_NO_ERROR;
 }
 
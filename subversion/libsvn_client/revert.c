@@ -208,7 +208,7 @@ svn_client_revert3(const apr_array_header_t *paths,
     if (paths->nelts == 1)
       sleep_path = APR_ARRAY_IDX(paths, 0, const char *);
 
-    svn_io_sleep_for_timestamps(sleep_path, iterpool);
+    svn_wc__sleep_for_timestamps(ctx->wc_ctx, sleep_path, iterpool);
   }
 
   svn_pool_destroy(iterpool);
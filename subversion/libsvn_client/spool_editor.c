@@ -0,0 +1,632 @@
+/*
+ * spool_editor.c -- Record an editor drive and replay it later
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The spool editor lets an edit drive be received from the repository
+ * before its consumer is ready for it, e.g. on another thread.  The tree
+ * operations are kept in memory while the text deltas are written to a
+ * temporary file in svndiff format.  */
+
+#include <string.h>
+
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "client.h"
+
+
+/* The kinds of recorded editor calls. */
+typedef enum spooled_op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_window,
+  op_textdelta_end,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file,
+  op_close_edit,
+  op_abort_edit
+} spooled_op_kind_t;
+
+/* One recorded editor call. */
+typedef struct spooled_op_t
+{
+  spooled_op_kind_t kind;
+
+  /* The baton the call was made on and the baton it returned, as indexes
+     into the baton table of the replay.  -1 if not applicable. */
+  int baton;
+  int new_baton;
+
+  /* Path or property name, and further arguments if applicable. */
+  const char *name;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const svn_string_t *value;
+  const char *checksum;
+} spooled_op_t;
+
+struct svn_client__spooled_edit_t
+{
+  apr_pool_t *pool;
+
+  /* The recorded calls as spooled_op_t, in order. */
+  apr_array_header_t *ops;
+
+  /* Number of batons handed out. */
+  int batons;
+
+  /* The svndiff data of all text deltas, one document per
+     op_apply_textdelta, written in the order of the op_window calls. */
+  apr_file_t *spool;
+  svn_stream_t *spool_stream;
+
+  /* Has the edit been closed? */
+  svn_boolean_t closed;
+};
+
+/* The baton of a recorded directory or file. */
+typedef struct node_baton_t
+{
+  svn_client__spooled_edit_t *edit;
+  int id;
+} node_baton_t;
+
+/* Baton for recording the windows of one text delta. */
+typedef struct window_baton_t
+{
+  svn_client__spooled_edit_t *edit;
+  int id;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+} window_baton_t;
+
+/* Append a new op of KIND on the baton with ID to EDIT and return it. */
+static spooled_op_t *
+push_op(svn_client__spooled_edit_t *edit,
+        spooled_op_kind_t kind,
+        int id)
+{
+  spooled_op_t *op = apr_array_push(edit->ops);
+
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+  op->baton = id;
+  op->new_baton = -1;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Return a new baton for EDIT and record its id in OP. */
+static node_baton_t *
+make_baton(svn_client__spooled_edit_t *edit,
+           spooled_op_t *op)
+{
+  node_baton_t *nb = apr_palloc(edit->pool, sizeof(*nb));
+
+  nb->edit = edit;
+  nb->id = edit->batons++;
+  op->new_baton = nb->id;
+
+  return nb;
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  svn_client__spooled_edit_t *edit = edit_baton;
+
+  push_op(edit, op_set_target_revision, -1)->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *result_pool,
+          void **root_baton)
+{
+  svn_client__spooled_edit_t *edit = edit_baton;
+  spooled_op_t *op = push_op(edit, op_open_root, -1);
+
+  op->revision = base_revision;
+  *root_baton = make_baton(edit, op);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *scratch_pool)
+{
+  node_baton_t *pb = parent_baton;
+  spooled_op_t *op = push_op(pb->edit, op_delete_entry, pb->id);
+
+  op->name = apr_pstrdup(pb->edit->pool, path);
+  op->revision = revision;
+  return SVN_NO_ERROR;
+}
+
+/* Record an add or open call of KIND for PATH below PARENT_BATON and set
+   *CHILD_BATON to the baton of the new node. */
+static svn_error_t *
+add_or_open(spooled_op_kind_t kind,
+            const char *path,
+            void *parent_baton,
+            const char *copyfrom_path,
+            svn_revnum_t revision,
+            void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  svn_client__spooled_edit_t *edit = pb->edit;
+  spooled_op_t *op = push_op(edit, kind, pb->id);
+
+  op->name = apr_pstrdup(edit->pool, path);
+  op->copyfrom_path = copyfrom_path ? apr_pstrdup(edit->pool, copyfrom_path)
+                                    : NULL;
+  op->revision = revision;
+  *child_baton = make_baton(edit, op);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *result_pool,
+              void **child_baton)
+{
+  return svn_error_trace(add_or_open(op_add_directory, path, parent_baton,
+                                     copyfrom_path, copyfrom_revision,
+                                     child_baton));
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *result_pool,
+               void **child_baton)
+{
+  return svn_error_trace(add_or_open(op_open_directory, path, parent_baton,
+                                     NULL, base_revision, child_baton));
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *result_pool,
+         void **file_baton)
+{
+  return svn_error_trace(add_or_open(op_add_file, path, parent_baton,
+                                     copyfrom_path, copyfrom_revision,
+                                     file_baton));
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *result_pool,
+          void **file_baton)
+{
+  return svn_error_trace(add_or_open(op_open_file, path, parent_baton,
+                                     NULL, base_revision, file_baton));
+}
+
+/* Record a property change of KIND on BATON. */
+static svn_error_t *
+change_prop(spooled_op_kind_t kind,
+            void *baton,
+            const char *name,
+            const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  spooled_op_t *op = push_op(nb->edit, kind, nb->id);
+
+  op->name = apr_pstrdup(nb->edit->pool, name);
+  op->value = value ? svn_string_dup(value, nb->edit->pool) : NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(change_prop(op_change_dir_prop, dir_baton,
+                                     name, value));
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(change_prop(op_change_file_prop, file_baton,
+                                     name, value));
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *scratch_pool)
+{
+  node_baton_t *db = dir_baton;
+
+  push_op(db->edit, op_close_directory, db->id);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *scratch_pool)
+{
+  node_baton_t *fb = file_baton;
+  spooled_op_t *op = push_op(fb->edit, op_close_file, fb->id);
+
+  op->checksum = text_checksum ? apr_pstrdup(fb->edit->pool, text_checksum)
+                               : NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Record an absent node of KIND below PARENT_BATON. */
+static svn_error_t *
+absent_node(spooled_op_kind_t kind,
+            const char *path,
+            void *parent_baton)
+{
+  node_baton_t *pb = parent_baton;
+
+  push_op(pb->edit, kind, pb->id)->name = apr_pstrdup(pb->edit->pool, path);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(absent_node(op_absent_directory, path,
+                                     parent_baton));
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(absent_node(op_absent_file, path, parent_baton));
+}
+
+/* Implements svn_txdelta_window_handler_t, recording the position of
+   the window of one text delta among the other calls. */
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window,
+               void *baton)
+{
+  window_baton_t *wb = baton;
+
+  push_op(wb->edit, window ? op_window : op_textdelta_end, wb->id);
+  return svn_error_trace(wb->handler(window, wb->handler_baton));
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *result_pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  svn_client__spooled_edit_t *edit = fb->edit;
+  spooled_op_t *op = push_op(edit, op_apply_textdelta, fb->id);
+  window_baton_t *wb = apr_palloc(result_pool, sizeof(*wb));
+
+  op->checksum = base_checksum ? apr_pstrdup(edit->pool, base_checksum)
+                               : NULL;
+
+  wb->edit = edit;
+  wb->id = fb->id;
+
+  /* The spool is read back soon, so don't waste time on compression.
+     Each delta closes its own disowned view of the spool.  The svndiff
+     header is written along with the first window, or with the end of
+     the delta if there are no windows. */
+  svn_txdelta_to_svndiff3(&wb->handler, &wb->handler_baton,
+                          svn_stream_disown(edit->spool_stream, result_pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, result_pool);
+
+  *handler = window_handler;
+  *handler_baton = wb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *scratch_pool)
+{
+  svn_client__spooled_edit_t *edit = edit_baton;
+
+  push_op(edit, op_close_edit, -1);
+  edit->closed = TRUE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *scratch_pool)
+{
+  svn_client__spooled_edit_t *edit = edit_baton;
+
+  push_op(edit, op_abort_edit, -1);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__get_spool_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             svn_client__spooled_edit_t **edit,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_delta_editor_t *spool_editor = svn_delta_default_editor(result_pool);
+  svn_client__spooled_edit_t *eb = apr_pcalloc(result_pool, sizeof(*eb));
+
+  eb->pool = result_pool;
+  eb->ops = apr_array_make(result_pool, 64, sizeof(spooled_op_t));
+  SVN_ERR(svn_io_open_unique_file3(&eb->spool, NULL, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, scratch_pool));
+  eb->spool_stream = svn_stream_from_aprfile2(eb->spool, TRUE, result_pool);
+
+  spool_editor->set_target_revision = set_target_revision;
+  spool_editor->open_root = open_root;
+  spool_editor->delete_entry = delete_entry;
+  spool_editor->add_directory = add_directory;
+  spool_editor->open_directory = open_directory;
+  spool_editor->change_dir_prop = change_dir_prop;
+  spool_editor->close_directory = close_directory;
+  spool_editor->absent_directory = absent_directory;
+  spool_editor->add_file = add_file;
+  spool_editor->open_file = open_file;
+  spool_editor->apply_textdelta = apply_textdelta;
+  spool_editor->change_file_prop = change_file_prop;
+  spool_editor->close_file = close_file;
+  spool_editor->absent_file = absent_file;
+  spool_editor->close_edit = close_edit;
+  spool_editor->abort_edit = abort_edit;
+
+  *editor = spool_editor;
+  *edit_baton = eb;
+  *edit = eb;
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_client__spooled_edit_complete(const svn_client__spooled_edit_t *edit)
+{
+  return edit->closed;
+}
+
+/* The state of the text delta of one file during a replay. */
+typedef struct replay_delta_t
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_boolean_t header_read;
+} replay_delta_t;
+
+/* Read the next window of DELTA from SPOOL into *WINDOW, allocated in
+   RESULT_POOL.  Set *WINDOW to NULL if END is set. */
+static svn_error_t *
+read_spooled_window(svn_txdelta_window_t **window,
+                    replay_delta_t *delta,
+                    svn_boolean_t end,
+                    svn_stream_t *spool,
+                    apr_pool_t *result_pool)
+{
+  if (!delta->header_read)
+    {
+      char header[4];
+      apr_size_t len = sizeof(header);
+
+      SVN_ERR(svn_stream_read_full(spool, header, &len));
+      if (len != sizeof(header))
+        return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                                _("Unexpected end of svndiff input"));
+      delta->header_read = TRUE;
+    }
+
+  if (end)
+    *window = NULL;
+  else
+    SVN_ERR(svn_txdelta_read_svndiff_window(window, spool, 0, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__replay_spooled_edit(const svn_client__spooled_edit_t *edit,
+                                const svn_delta_editor_t *editor,
+                                void *edit_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool)
+{
+  void **batons = apr_pcalloc(scratch_pool, edit->batons * sizeof(*batons));
+  apr_pool_t **pools = apr_pcalloc(scratch_pool,
+                                   edit->batons * sizeof(*pools));
+  replay_delta_t *deltas = apr_pcalloc(scratch_pool,
+                                       edit->batons * sizeof(*deltas));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stream_t *spool;
+  apr_off_t offset = 0;
+  int i;
+
+  SVN_ERR_ASSERT(edit->closed);
+
+  SVN_ERR(svn_io_file_seek(edit->spool, APR_SET, &offset, scratch_pool));
+  spool = svn_stream_from_aprfile2(edit->spool, TRUE, scratch_pool);
+
+  for (i = 0; i < edit->ops->nelts; i++)
+    {
+      const spooled_op_t *op = &APR_ARRAY_IDX(edit->ops, i, spooled_op_t);
+      void *baton = (op->baton >= 0) ? batons[op->baton] : NULL;
+      apr_pool_t *parent_pool = (op->baton >= 0) ? pools[op->baton]
+                                                 : scratch_pool;
+      apr_pool_t *node_pool = NULL;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (op->new_baton >= 0)
+        {
+          node_pool = svn_pool_create(parent_pool);
+          pools[op->new_baton] = node_pool;
+        }
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, node_pool,
+                                      &batons[op->new_baton]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->name, op->revision, baton,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->name, baton, op->copyfrom_path,
+                                          op->revision, node_pool,
+                                          &batons[op->new_baton]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->name, baton, op->revision,
+                                           node_pool,
+                                           &batons[op->new_baton]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(baton, op->name, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(baton, iterpool));
+            svn_pool_destroy(pools[op->baton]);
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->name, baton, iterpool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->name, baton, op->copyfrom_path,
+                                     op->revision, node_pool,
+                                     &batons[op->new_baton]));
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->name, baton, op->revision,
+                                      node_pool, &batons[op->new_baton]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(baton, op->checksum,
+                                            pools[op->baton],
+                                            &deltas[op->baton].handler,
+                                            &deltas[op->baton].handler_baton));
+            break;
+
+          case op_window:
+          case op_textdelta_end:
+            {
+              replay_delta_t *delta = &deltas[op->baton];
+              svn_txdelta_window_t *window;
+
+              SVN_ERR(read_spooled_window(&window, delta,
+                                          op->kind == op_textdelta_end,
+                                          spool, iterpool));
+              SVN_ERR(delta->handler(window, delta->handler_baton));
+              break;
+            }
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(baton, op->name, op->value,
+                                             iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(baton, op->checksum, iterpool));
+            svn_pool_destroy(pools[op->baton]);
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->name, baton, iterpool));
+            break;
+
+          case op_close_edit:
+            SVN_ERR(editor->close_edit(edit_baton, iterpool));
+            break;
+
+          case op_abort_edit:
+            SVN_ERR(editor->abort_edit(edit_baton, iterpool));
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -660,6 +660,10 @@ svn_client__update_internal(svn_revnum_t *result_rev,
       err = svn_client__resolve_conflicts(NULL, conflicted_paths, ctx, pool);
     }
 
+  /* Drop some of the pristines this update made obsolete */
+  if (! err)
+    svn_wc__cleanup_pristines_some(ctx->wc_ctx, lockroot_abspath, pool);
+
  cleanup:
   err = svn_error_compose_create(
             err,
@@ -776,7 +780,7 @@ svn_client_update4(apr_array_header_t **result_revs,
       else
         wcroot_abspath = NULL;
 
-      svn_io_sleep_for_timestamps(wcroot_abspath, pool);
+      svn_wc__sleep_for_timestamps(ctx->wc_ctx, wcroot_abspath, pool);
     }
 
   return svn_error_trace(err);
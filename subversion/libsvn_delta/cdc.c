@@ -0,0 +1,496 @@
+/*
+ * cdc.c:  content-defined chunking delta generator
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include <apr_hash.h>
+
+#include "svn_delta.h"
+#include "svn_checksum.h"
+#include "svn_pools.h"
+
+#include "private/svn_delta_private.h"
+#include "delta.h"
+
+/* The standard text delta compares each target window with the source
+ * data at the same offset only.  Once data has been inserted or removed
+ * from a large file, all following windows will miss their matches.
+ *
+ * Here, we split source and target into chunks whose boundaries depend
+ * on the local content only (a rolling "gear" hash over the last 64 bytes
+ * of data), index all source chunks by their SHA1 and look up every target
+ * chunk in that index.  Since an insertion or deletion only affects the
+ * chunks around it, all other chunks will be found again.
+ *
+ * The result is a sequence of standard svndiff windows.  Receivers read
+ * the source strictly sequentially, so every window's source view must
+ * start within or right after the previous one and must not end before
+ * it.  Matches violating these rules are simply sent as new data.
+ */
+
+/* Chunks never get shorter than this, except at the end of the data. */
+#define CDC_MIN_CHUNK 2048
+
+/* Chunks never get longer than this.  Must not exceed
+   SVN_DELTA_WINDOW_SIZE. */
+#define CDC_MAX_CHUNK 16384
+
+/* A chunk ends where all hash bits selected by this mask are 0.  13 bits
+   result in an average chunk length of about 8kB plus CDC_MIN_CHUNK. */
+#define CDC_BOUNDARY_MASK APR_UINT64_C(0xfff8000000000000)
+
+/* Size of the buffer used while indexing the source. */
+#define CDC_SOURCE_BLOCK (16 * SVN_DELTA_WINDOW_SIZE)
+
+/* Upper limit to the number of chunks within a single delta window. */
+#define CDC_MAX_WINDOW_CHUNKS (SVN_DELTA_WINDOW_SIZE / CDC_MIN_CHUNK + 1)
+
+/* All source locations of a chunk with a given content. */
+typedef struct chunk_locations_t
+{
+  /* Length of the chunk in bytes. */
+  apr_size_t len;
+
+  /* Offsets of the chunk in the source (svn_filesize_t), ascending. */
+  apr_array_header_t *offsets;
+} chunk_locations_t;
+
+/* Target chunk within the current delta window. */
+typedef struct target_chunk_t
+{
+  /* Position and length within the target buffer. */
+  apr_size_t start;
+  apr_size_t len;
+
+  /* If TRUE, the same content can be found at OFFSET in the source. */
+  svn_boolean_t matched;
+  svn_filesize_t offset;
+} target_chunk_t;
+
+/* Delta stream baton. */
+typedef struct cdc_baton_t
+{
+  /* These are copied from parameters passed to svn_txdelta__cdc. */
+  svn_stream_t *source;
+  svn_stream_t *target;
+
+  /* Rolling hash lookup table. */
+  apr_uint64_t gear[256];
+
+  /* Maps SHA1 digests to chunk_locations_t *.  NULL until the source has
+     been read. */
+  apr_hash_t *index;
+
+  /* Total length of the source. */
+  svn_filesize_t source_len;
+
+  /* Source view of the last window that had one. */
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len;
+
+  /* Target data that has not been sent yet. */
+  char *buf;
+  apr_size_t buf_len;
+  svn_boolean_t target_eof;
+
+  /* TRUE if there are more data in the pool. */
+  svn_boolean_t more;
+
+  svn_checksum_ctx_t *context;  /* If not NULL, the context for computing
+                                   the checksum. */
+  svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
+
+  /* For the index and the results (e.g. checksum). */
+  apr_pool_t *pool;
+} cdc_baton_t;
+
+/* Fill TABLE with pseudo-random values for the rolling hash.  Chunk
+   boundaries are not part of the svndiff data, so the values only need
+   to be consistent within the same delta stream. */
+static void
+init_gear_table(apr_uint64_t table[256])
+{
+  apr_uint64_t state = 0;
+  int i;
+
+  /* splitmix64 */
+  for (i = 0; i < 256; ++i)
+    {
+      apr_uint64_t z = (state += APR_UINT64_C(0x9e3779b97f4a7c15));
+      z = (z ^ (z >> 30)) * APR_UINT64_C(0xbf58476d1ce4e5b9);
+      z = (z ^ (z >> 27)) * APR_UINT64_C(0x94d049bb133111eb);
+      table[i] = z ^ (z >> 31);
+    }
+}
+
+/* Return the length of the chunk starting at DATA with LEN bytes being
+   available, using the hash table GEAR.  If no boundary can be found,
+   return the smaller of LEN and CDC_MAX_CHUNK. */
+static apr_size_t
+chunk_length(const apr_uint64_t *gear,
+             const char *data,
+             apr_size_t len)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  apr_uint64_t hash = 0;
+  apr_size_t i;
+
+  if (len > CDC_MAX_CHUNK)
+    len = CDC_MAX_CHUNK;
+  if (len <= CDC_MIN_CHUNK)
+    return len;
+
+  /* Bytes older than 64 positions have been shifted out of the hash, so
+     we don't need to look at them. */
+  for (i = CDC_MIN_CHUNK - 64; i < len; ++i)
+    {
+      hash = (hash << 1) + gear[p[i]];
+      if (i + 1 >= CDC_MIN_CHUNK && (hash & CDC_BOUNDARY_MASK) == 0)
+        return i + 1;
+    }
+
+  return len;
+}
+
+/* Add the source chunk DATA of LEN bytes found at OFFSET to the index in
+   B.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_chunk(cdc_baton_t *b,
+          const char *data,
+          apr_size_t len,
+          svn_filesize_t offset,
+          apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *checksum;
+  chunk_locations_t *locations;
+  apr_size_t digest_size;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, data, len,
+                       scratch_pool));
+  digest_size = svn_checksum_size(checksum);
+
+  locations = apr_hash_get(b->index, checksum->digest, digest_size);
+  if (locations == NULL)
+    {
+      locations = apr_palloc(b->pool, sizeof(*locations));
+      locations->len = len;
+      locations->offsets = apr_array_make(b->pool, 1, sizeof(svn_filesize_t));
+      apr_hash_set(b->index,
+                   apr_pmemdup(b->pool, checksum->digest, digest_size),
+                   digest_size, locations);
+    }
+
+  APR_ARRAY_PUSH(locations->offsets, svn_filesize_t) = offset;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the whole source of B and fill its chunk index.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+build_index(cdc_baton_t *b,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  char *buf = apr_palloc(scratch_pool, CDC_SOURCE_BLOCK);
+  apr_size_t buf_len = 0;
+  svn_boolean_t eof = FALSE;
+
+  b->index = apr_hash_make(b->pool);
+  b->source_len = 0;
+
+  while (!eof || buf_len > 0)
+    {
+      apr_size_t pos = 0;
+
+      if (!eof)
+        {
+          apr_size_t len = CDC_SOURCE_BLOCK - buf_len;
+          SVN_ERR(svn_stream_read_full(b->source, buf + buf_len, &len));
+          eof = len < CDC_SOURCE_BLOCK - buf_len;
+          buf_len += len;
+        }
+
+      svn_pool_clear(iterpool);
+
+      /* Chunks must not depend on how the source got split into blocks.
+         So, keep incomplete chunks for the next iteration. */
+      while (eof ? pos < buf_len : buf_len - pos >= CDC_MAX_CHUNK)
+        {
+          apr_size_t len = chunk_length(b->gear, buf + pos, buf_len - pos);
+          SVN_ERR(add_chunk(b, buf + pos, len, b->source_len + pos,
+                            iterpool));
+          pos += len;
+        }
+
+      memmove(buf, buf + pos, buf_len - pos);
+      buf_len -= pos;
+      b->source_len += pos;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the target chunk CHUNK in DATA in the index of B.  Prefer the
+   first source location at or after MIN_OFFSET.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+find_match(target_chunk_t *chunk,
+           cdc_baton_t *b,
+           const char *data,
+           svn_filesize_t min_offset,
+           apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *checksum;
+  chunk_locations_t *locations;
+  int lower, upper;
+
+  chunk->matched = FALSE;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, data + chunk->start,
+                       chunk->len, scratch_pool));
+  locations = apr_hash_get(b->index, checksum->digest,
+                           svn_checksum_size(checksum));
+  if (locations == NULL || locations->len != chunk->len)
+    return SVN_NO_ERROR;
+
+  /* Binary search for the first offset >= MIN_OFFSET. */
+  lower = 0;
+  upper = locations->offsets->nelts;
+  while (lower < upper)
+    {
+      int mid = lower + (upper - lower) / 2;
+      if (APR_ARRAY_IDX(locations->offsets, mid, svn_filesize_t)
+          < min_offset)
+        lower = mid + 1;
+      else
+        upper = mid;
+    }
+
+  /* Sources behind the current view can't be used anymore. */
+  if (lower < locations->offsets->nelts)
+    {
+      chunk->matched = TRUE;
+      chunk->offset = APR_ARRAY_IDX(locations->offsets, lower,
+                                    svn_filesize_t);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of bytes in the COUNT CHUNKS that could be copied
+   from a source view of SVN_DELTA_WINDOW_SIZE bytes at OFFSET. */
+static apr_size_t
+matched_bytes(const target_chunk_t *chunks,
+              int count,
+              svn_filesize_t offset)
+{
+  apr_size_t result = 0;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    if (   chunks[i].matched
+        && chunks[i].offset >= offset
+        && chunks[i].offset + chunks[i].len <= offset + SVN_DELTA_WINDOW_SIZE)
+      result += chunks[i].len;
+
+  return result;
+}
+
+/* Implements svn_txdelta_next_window_fn_t. */
+static svn_error_t *
+cdc_next_window(svn_txdelta_window_t **window,
+                void *baton,
+                apr_pool_t *pool)
+{
+  cdc_baton_t *b = baton;
+  target_chunk_t chunks[CDC_MAX_WINDOW_CHUNKS];
+  svn_txdelta__ops_baton_t build_baton = { 0 };
+  svn_filesize_t min_offset = b->sview_offset;
+  svn_filesize_t max_offset = b->sview_offset + b->sview_len;
+  svn_filesize_t offset;
+  apr_size_t len;
+  apr_size_t best;
+  svn_boolean_t source_ahead = FALSE;
+  int count = 0;
+  int i;
+
+  /* Index the whole source before sending the first window. */
+  if (b->index == NULL)
+    {
+      apr_pool_t *subpool = svn_pool_create(pool);
+      SVN_ERR(build_index(b, subpool));
+      svn_pool_destroy(subpool);
+    }
+
+  /* Top up the target buffer. */
+  if (!b->target_eof)
+    {
+      len = 2 * SVN_DELTA_WINDOW_SIZE - b->buf_len;
+      SVN_ERR(svn_stream_read_full(b->target, b->buf + b->buf_len, &len));
+      b->target_eof = len < 2 * SVN_DELTA_WINDOW_SIZE - b->buf_len;
+      b->buf_len += len;
+    }
+
+  if (b->buf_len == 0)
+    {
+      /* No target data?  We're done; return the final window. */
+      if (b->context != NULL)
+        SVN_ERR(svn_checksum_final(&b->checksum, b->context, b->pool));
+
+      *window = NULL;
+      b->more = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Collect the chunks for this window.  Unless at EOF, the buffer
+     contains at least SVN_DELTA_WINDOW_SIZE + CDC_MAX_CHUNK bytes, i.e.
+     all chunk boundaries found here are final. */
+  len = 0;
+  while (len < b->buf_len && count < CDC_MAX_WINDOW_CHUNKS)
+    {
+      target_chunk_t *chunk = &chunks[count];
+
+      chunk->start = len;
+      chunk->len = chunk_length(b->gear, b->buf + len, b->buf_len - len);
+      if (len + chunk->len > SVN_DELTA_WINDOW_SIZE)
+        break;
+
+      SVN_ERR(find_match(chunk, b, b->buf, min_offset, pool));
+
+      /* If the source is too far ahead to be reached by this window,
+         end it here and let the next one slide its source view further. */
+      source_ahead = chunk->matched
+                  && (  chunk->offset + chunk->len
+                      > max_offset + SVN_DELTA_WINDOW_SIZE);
+      if (source_ahead && count > 0)
+        break;
+
+      ++count;
+      len += chunk->len;
+
+      if (source_ahead)
+        break;
+    }
+
+  /* Find the source view that allows for the most copies.  It must
+     start within or right at the end of the previous view. */
+  offset = max_offset;
+  best = matched_bytes(chunks, count, offset);
+  for (i = 0; i < count; ++i)
+    if (chunks[i].matched)
+      {
+        svn_filesize_t candidate = chunks[i].offset;
+        apr_size_t matched;
+
+        if (candidate < min_offset)
+          candidate = min_offset;
+        if (candidate > max_offset)
+          candidate = max_offset;
+
+        matched = matched_bytes(chunks, count, candidate);
+        if (matched > best || (matched == best && candidate > offset))
+          {
+            offset = candidate;
+            best = matched;
+          }
+      }
+
+  /* Construct the window. */
+  build_baton.new_data = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < count; ++i)
+    if (   best > 0
+        && chunks[i].matched
+        && chunks[i].offset >= offset
+        && chunks[i].offset + chunks[i].len <= offset + SVN_DELTA_WINDOW_SIZE)
+      svn_txdelta__insert_op(&build_baton, svn_txdelta_source,
+                             (apr_size_t)(chunks[i].offset - offset),
+                             chunks[i].len, NULL, pool);
+    else
+      svn_txdelta__insert_op(&build_baton, svn_txdelta_new, 0,
+                             chunks[i].len, b->buf + chunks[i].start, pool);
+
+  *window = svn_txdelta__make_window(&build_baton, pool);
+  (*window)->tview_len = len;
+
+  /* Slide the source view forward if we use it or need to catch up with
+     a match further ahead.  Otherwise, don't touch it at all. */
+  if ((best > 0 || source_ahead) && offset < b->source_len)
+    {
+      b->sview_offset = offset;
+      b->sview_len = b->source_len - offset > SVN_DELTA_WINDOW_SIZE
+                   ? SVN_DELTA_WINDOW_SIZE
+                   : (apr_size_t)(b->source_len - offset);
+      (*window)->sview_len = b->sview_len;
+    }
+
+  (*window)->sview_offset = b->sview_offset;
+
+  if (b->context != NULL)
+    SVN_ERR(svn_checksum_update(b->context, b->buf, len));
+
+  memmove(b->buf, b->buf + len, b->buf_len - len);
+  b->buf_len -= len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t. */
+static const unsigned char *
+cdc_md5_digest(void *baton)
+{
+  cdc_baton_t *b = baton;
+
+  /* If there are more windows for this stream, the digest has not yet
+     been calculated.  */
+  if (b->more || b->checksum == NULL)
+    return NULL;
+
+  return b->checksum->digest;
+}
+
+void
+svn_txdelta__cdc(svn_txdelta_stream_t **stream,
+                 svn_stream_t *source,
+                 svn_stream_t *target,
+                 svn_boolean_t calculate_checksum,
+                 apr_pool_t *pool)
+{
+  cdc_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+
+  b->source = source;
+  b->target = target;
+  b->more = TRUE;
+  b->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  b->context = calculate_checksum
+             ? svn_checksum_ctx_create(svn_checksum_md5, pool)
+             : NULL;
+  b->pool = pool;
+  init_gear_table(b->gear);
+
+  *stream = svn_txdelta_stream_create(b, cdc_next_window, cdc_md5_digest,
+                                      pool);
+}
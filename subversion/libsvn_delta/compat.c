@@ -118,6 +118,10 @@ struct ev2_edit_baton
 
   apr_hash_t *changes;  /* REPOS_RELPATH -> struct change_node  */
 
+  /* REPOS_RELPATH -> apr_array_header_t * of the basenames of all
+     immediate children with an entry in CHANGES.  */
+  apr_hash_t *children;
+
   apr_array_header_t *path_order;
   int paths_processed;
 
@@ -157,7 +161,11 @@ struct ev2_file_baton
   struct ev2_edit_baton *eb;
   const char *path;
   svn_revnum_t base_revision;
-  const char *delta_base;
+
+  /* The node to use as delta base, if any.  We only fetch its contents
+     once a delta window actually refers to them.  */
+  const char *delta_base_relpath;
+  svn_revnum_t delta_base_rev;
 };
 
 enum restructure_action_t
@@ -217,6 +225,25 @@ locate_change(struct ev2_edit_baton *eb,
   relpath = apr_pstrdup(eb->edit_pool, relpath);
   APR_ARRAY_PUSH(eb->path_order, const char *) = relpath;
 
+  /* Index the new node by its parent, so that we don't have to scan all
+     changes when adding a directory.  */
+  if (*relpath)
+    {
+      const char *parent_relpath;
+      const char *name;
+      apr_array_header_t *children;
+
+      svn_relpath_split(&parent_relpath, &name, relpath, eb->edit_pool);
+      children = svn_hash_gets(eb->children, parent_relpath);
+      if (children == NULL)
+        {
+          children = apr_array_make(eb->edit_pool, 1, sizeof(const char *));
+          svn_hash_sets(eb->children, parent_relpath, children);
+        }
+
+      APR_ARRAY_PUSH(children, const char *) = name;
+    }
+
   /* Return an empty change. Callers will tweak as needed.  */
   change = apr_pcalloc(eb->edit_pool, sizeof(*change));
   change->changing = SVN_INVALID_REVNUM;
@@ -285,31 +312,15 @@ apply_propedit(struct ev2_edit_baton *eb,
 
 /* Find all the paths which are immediate children of PATH and return their
    basenames in a list. */
-static apr_array_header_t *
+static const apr_array_header_t *
 get_children(struct ev2_edit_baton *eb,
              const char *path,
              apr_pool_t *pool)
 {
-  apr_array_header_t *children = apr_array_make(pool, 1, sizeof(const char *));
-  apr_hash_index_t *hi;
+  const apr_array_header_t *children = svn_hash_gets(eb->children, path);
 
-  for (hi = apr_hash_first(pool, eb->changes); hi; hi = apr_hash_next(hi))
-    {
-      const char *repos_relpath = apr_hash_this_key(hi);
-      const char *child;
-
-      /* Find potential children. */
-      child = svn_relpath_skip_ancestor(path, repos_relpath);
-      if (!child || !*child)
-        continue;
-
-      /* If we have a path separator, it's a deep child, so just ignore it.
-         ### Is there an API we should be using for this? */
-      if (strchr(child, '/') != NULL)
-        continue;
-
-      APR_ARRAY_PUSH(children, const char *) = child;
-    }
+  if (children == NULL)
+    children = apr_array_make(pool, 0, sizeof(const char *));
 
   return children;
 }
@@ -358,9 +369,11 @@ process_actions(struct ev2_edit_baton *eb,
 
       if (change->contents_abspath)
         {
-          /* ### the checksum might be in CHANGE->CHECKSUM  */
-          SVN_ERR(svn_io_file_checksum2(&checksum, change->contents_abspath,
-                                        svn_checksum_sha1, scratch_pool));
+          /* The checksum has been calculated while writing the file. */
+          checksum = change->checksum;
+          if (checksum == NULL)
+            SVN_ERR(svn_io_file_checksum2(&checksum, change->contents_abspath,
+                                          svn_checksum_sha1, scratch_pool));
           SVN_ERR(svn_stream_open_readonly(&contents, change->contents_abspath,
                                            scratch_pool, scratch_pool));
         }
@@ -710,8 +723,8 @@ ev2_add_file(const char *path,
 
   if (!copyfrom_path)
     {
-      /* Don't bother fetching the base, as in an add we don't have a base. */
-      fb->delta_base = NULL;
+      /* In an add we don't have a base. */
+      fb->delta_base_relpath = NULL;
     }
   else
     {
@@ -721,11 +734,8 @@ ev2_add_file(const char *path,
                                                    fb->eb->edit_pool);
       change->copyfrom_rev = copyfrom_revision;
 
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      change->copyfrom_path,
-                                      change->copyfrom_rev,
-                                      result_pool, scratch_pool));
+      fb->delta_base_relpath = change->copyfrom_path;
+      fb->delta_base_rev = change->copyfrom_rev;
     }
 
   return SVN_NO_ERROR;
@@ -753,21 +763,15 @@ ev2_open_file(const char *path,
       /* We're in a copied directory, so the delta base is going to be
          based up on the copy source. */
       const char *name = svn_relpath_basename(relpath, scratch_pool);
-      const char *copyfrom_relpath = svn_relpath_join(pb->copyfrom_relpath,
-                                                      name,
-                                                      scratch_pool);
-
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      copyfrom_relpath, pb->copyfrom_rev,
-                                      result_pool, scratch_pool));
+
+      fb->delta_base_relpath = svn_relpath_join(pb->copyfrom_relpath, name,
+                                                result_pool);
+      fb->delta_base_rev = pb->copyfrom_rev;
     }
   else
     {
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      relpath, base_revision,
-                                      result_pool, scratch_pool));
+      fb->delta_base_relpath = fb->path;
+      fb->delta_base_rev = base_revision;
     }
 
   *file_baton = fb;
@@ -801,12 +805,25 @@ window_handler(svn_txdelta_window_t *window, void *baton)
   return svn_error_trace(err);
 }
 
-/* Lazy-open handler for getting a read-only stream of the delta base. */
+/* Lazy-open handler for getting a read-only stream of the delta base.
+   BATON is the struct ev2_file_baton.  Fetching the base may be expensive,
+   so we only get here if a delta window actually refers to it. */
 static svn_error_t *
 open_delta_base(svn_stream_t **stream, void *baton,
                 apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
-  const char *const delta_base = baton;
+  struct ev2_file_baton *fb = baton;
+  const char *delta_base;
+
+  SVN_ERR(fb->eb->fetch_base_func(&delta_base, fb->eb->fetch_base_baton,
+                                  fb->delta_base_relpath, fb->delta_base_rev,
+                                  result_pool, scratch_pool));
+  if (! delta_base)
+    {
+      *stream = svn_stream_empty(result_pool);
+      return SVN_NO_ERROR;
+    }
+
   return svn_stream_open_readonly(stream, delta_base,
                                   result_pool, scratch_pool);
 }
@@ -843,16 +860,18 @@ ev2_apply_textdelta(void *file_baton,
                  || change->changing == fb->base_revision);
   change->changing = fb->base_revision;
 
-  if (! fb->delta_base)
+  if (! fb->delta_base_relpath)
     hb->source = svn_stream_empty(handler_pool);
   else
-    hb->source = svn_stream_lazyopen_create(open_delta_base,
-                                            (char*)fb->delta_base,
+    hb->source = svn_stream_lazyopen_create(open_delta_base, fb,
                                             FALSE, handler_pool);
 
   change->contents_changed = TRUE;
   target = svn_stream_lazyopen_create(open_delta_target, change,
                                       FALSE, fb->eb->edit_pool);
+  target = svn_stream_checksummed2(target, NULL, &change->checksum,
+                                   svn_checksum_sha1, FALSE,
+                                   fb->eb->edit_pool);
 
   svn_txdelta_apply(hb->source, target,
                     NULL, NULL,
@@ -1006,6 +1025,7 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
 
   eb->editor = editor;
   eb->changes = apr_hash_make(pool);
+  eb->children = apr_hash_make(pool);
   eb->path_order = apr_array_make(pool, 1, sizeof(const char *));
   eb->edit_pool = pool;
   eb->found_abs_paths = found_abs_paths;
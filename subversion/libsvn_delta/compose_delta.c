@@ -163,7 +163,10 @@ create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
    NDX. HINT is an arbitrary positin within NDX and doesn't even need
    to be valid. To effectively speed up the search, use the last result
    as hint because most lookups come as a sequence of decreasing values
-   for OFFSET and they concentrate on the lower end of the array. */
+   for OFFSET and they concentrate on the lower end of the array.
+   Consecutive source copies in the second window, OTOH, tend to
+   continue right after the op of the previous lookup, so we check the
+   op following HINT as well before falling back to binary search. */
 
 static apr_size_t
 search_offset_index(const offset_index_t *ndx,
@@ -188,6 +191,8 @@ search_offset_index(const offset_index_t *ndx,
         hi = hint;
       else if (offset < ndx->offs[hint+1])
         return hint;
+      else if (hint + 1 < hi && offset < ndx->offs[hint+2])
+        return hint+1;
       else
         lo = hint+1;
     }
@@ -632,9 +637,12 @@ build_range_list(apr_size_t offset, apr_size_t limit, range_index_t *ndx)
    represented by BUILD_BATON. HINT is a position in the instructions
    array that helps finding the position for OFFSET. A safe default
    is 0. Use NDX to find the instructions in WINDOW. Allocate space
-   in BUILD_BATON from POOL. */
+   in BUILD_BATON from POOL.
 
-static void
+   Return the index of the first op in WINDOW that starts at or after
+   LIMIT, which is a good hint for the next range to copy. */
+
+static apr_size_t
 copy_source_ops(apr_size_t offset, apr_size_t limit,
                 apr_size_t target_offset,
                 apr_size_t hint,
@@ -752,6 +760,8 @@ copy_source_ops(apr_size_t offset, apr_size_t limit,
       /* Adjust the target offset for the next op in the list. */
       target_offset += op->length - fix_offset - fix_limit;
     }
+
+  return op_ndx;
 }
 
 
@@ -771,6 +781,7 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
   offset_index_t *offset_index = create_offset_index(window_A, subpool);
   range_index_t *range_index = create_range_index(subpool);
   apr_size_t target_offset = 0;
+  apr_size_t hint = 0;
   int i;
 
   /* Read the description of the delta composition algorithm in
@@ -813,9 +824,9 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
                                        range->limit - range->offset,
                                        NULL, pool);
               else
-                copy_source_ops(range->offset, range->limit, tgt_off, 0,
-                                &build_baton, window_A, offset_index,
-                                pool);
+                hint = copy_source_ops(range->offset, range->limit, tgt_off,
+                                       hint, &build_baton, window_A,
+                                       offset_index, pool);
 
               tgt_off += range->limit - range->offset;
             }
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <string.h>
+
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "delta.h"
@@ -35,17 +36,21 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_task.h"
 
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -198,7 +203,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions, compression_level));
+      instructions = compressed_instructions;
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +230,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data, window->new_data->len,
+                                 compressed, compression_level));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -245,6 +266,32 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
+/* Write the window encoded by encode_window() as HEADER, INSTRUCTIONS and
+   NEWDATA to OUTPUT. */
+static svn_error_t *
+write_encoded_window(svn_stream_t *output,
+                     const svn_stringbuf_t *header,
+                     const svn_stringbuf_t *instructions,
+                     const svn_string_t *newdata)
+{
+  apr_size_t len;
+
+  len = header->len;
+  SVN_ERR(svn_stream_write(output, header->data, &len));
+  if (instructions->len > 0)
+    {
+      len = instructions->len;
+      SVN_ERR(svn_stream_write(output, instructions->data, &len));
+    }
+  if (newdata->len > 0)
+    {
+      len = newdata->len;
+      SVN_ERR(svn_stream_write(output, newdata->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Note: When changing things here, check the related comment in
    the svn_txdelta_to_svndiff_stream() function.  */
 static svn_error_t *
@@ -286,20 +333,8 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                         eb->scratch_pool));
 
   /* Write out the window.  */
-  len = header->len;
-  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
-  if (instructions->len > 0)
-    {
-      len = instructions->len;
-      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
-    }
-  if (newdata->len > 0)
-    {
-      len = newdata->len;
-      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(write_encoded_window(eb->output, header,
+                                              instructions, newdata));
 }
 
 void
@@ -345,6 +380,183 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
 }
 
 
+/* ----- Parallel text delta to svndiff ----- */
+
+/* One delta window to be encoded by encode_task(). */
+typedef struct encoder_task_t
+{
+  /* Private pool of this window, a sub-pool of the encoder's WINDOWS_POOL.
+     Released after the encoded window has been written. */
+  apr_pool_t *pool;
+
+  /* Copy of the window to encode, allocated in POOL. */
+  svn_txdelta_window_t *window;
+
+  /* The encoder that this window belongs to. */
+  struct parallel_encoder_baton *eb;
+} encoder_task_t;
+
+/* The result of encode_task(), as produced by encode_window(). */
+typedef struct encoded_window_t
+{
+  encoder_task_t *task;
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+} encoded_window_t;
+
+/* Baton for parallel_window_handler. */
+struct parallel_encoder_baton
+{
+  /* Output stream, svndiff version etc. as used by the serial encoder.
+     Windows get encoded through it until we actually need threads. */
+  struct encoder_baton *serial;
+
+  /* Maximum number of threads. */
+  int max_threads;
+
+  /* The pool that the encoder was allocated in. */
+  apr_pool_t *pool;
+
+  /* Parent of the window pools.  It must outlive SET, so it is created
+     before SET_POOL.  NULL until we decided to go parallel. */
+  apr_pool_t *windows_pool;
+
+  /* Encodes the windows and writes them in order.  Lives in SET_POOL. */
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+};
+
+/* Implements svn_task__process_func_t.  Encode the window of the
+   encoder_task_t in PROCESS_BATON and return it as encoded_window_t in
+   *RESULT. */
+static svn_error_t *
+encode_task(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  encoder_task_t *task = process_baton;
+  struct parallel_encoder_baton *eb = task->eb;
+  encoded_window_t *encoded = apr_pcalloc(result_pool, sizeof(*encoded));
+
+  encoded->task = task;
+  SVN_ERR(encode_window(&encoded->instructions, &encoded->header,
+                        &encoded->newdata, task->window,
+                        eb->serial->version, eb->serial->compression_level,
+                        result_pool));
+
+  *result = encoded;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Write the encoded_window_t in
+   RESULT to the output of the parallel_encoder_baton in OUTPUT_BATON and
+   release the window. */
+static svn_error_t *
+write_encoded_task(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  encoded_window_t *encoded = result;
+  struct parallel_encoder_baton *eb = output_baton;
+
+  SVN_ERR(write_encoded_window(eb->serial->output, encoded->header,
+                               encoded->instructions, encoded->newdata));
+  svn_pool_destroy(encoded->task->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Create the task set for EB. */
+static svn_error_t *
+start_tasks(struct parallel_encoder_baton *eb)
+{
+  /* Sub-pools get destroyed in reverse order of creation, so the task set
+     will be gone before the windows that its tasks read. */
+  eb->windows_pool = svn_pool_create(eb->pool);
+  eb->set_pool = svn_pool_create(eb->pool);
+
+  return svn_error_trace(svn_task__set_create(&eb->set, eb->max_threads,
+                                              write_encoded_task, eb,
+                                              NULL, NULL, eb->set_pool));
+}
+
+/* Implements svn_txdelta_window_handler_t for the parallel encoder. */
+static svn_error_t *
+parallel_window_handler(svn_txdelta_window_t *window,
+                        void *baton)
+{
+  struct parallel_encoder_baton *eb = baton;
+  encoder_task_t *task;
+  apr_pool_t *pool;
+
+  if (window == NULL)
+    {
+      /* Write all remaining windows in order and let the serial encoder
+         finalize the stream. */
+      if (eb->set)
+        {
+          SVN_ERR(svn_task__set_finish(eb->set));
+          svn_pool_destroy(eb->set_pool);
+          svn_pool_destroy(eb->windows_pool);
+          eb->set = NULL;
+        }
+
+      return svn_error_trace(window_handler(NULL, eb->serial));
+    }
+
+  /* Most representations consist of a single window.  Don't spin up any
+     tasks for them. */
+  if (!eb->serial->header_done)
+    return svn_error_trace(window_handler(window, eb->serial));
+
+  if (!eb->set)
+    SVN_ERR(start_tasks(eb));
+
+  /* WINDOW is only valid during this call. */
+  pool = svn_pool_create(eb->windows_pool);
+  task = apr_pcalloc(pool, sizeof(*task));
+  task->pool = pool;
+  task->window = svn_txdelta_window_dup(window, pool);
+  task->eb = eb;
+
+  return svn_error_trace(svn_task__add(eb->set, encode_task, task));
+}
+
+void
+svn_txdelta_to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                void **handler_baton,
+                                svn_stream_t *output,
+                                int svndiff_version,
+                                int compression_level,
+                                int max_threads,
+                                apr_pool_t *pool)
+{
+  struct parallel_encoder_baton *eb;
+
+  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
+                          compression_level, pool);
+
+  /* svndiff0 does not compress anything, i.e. there is nothing worth
+     parallelizing. */
+  if (   max_threads <= 1
+      || svndiff_version == 0
+      || svn_task__get_thread_limit() == 0)
+    return;
+
+  eb = apr_pcalloc(pool, sizeof(*eb));
+  eb->serial = *handler_baton;
+  eb->max_threads = max_threads;
+  eb->pool = pool;
+
+  *handler = parallel_window_handler;
+  *handler_baton = eb;
+}
+
+
 /* ----- svndiff to text delta ----- */
 
 /* An svndiff parser object.  */
@@ -565,7 +777,23 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                   SVN_DELTA_WINDOW_SIZE));
+      SVN_ERR(svn__decompress_zstd(data, insend - data, instout,
+                                   MAX_INSTRUCTION_SECTION_LEN));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
@@ -653,6 +881,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
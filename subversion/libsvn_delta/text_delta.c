@@ -714,11 +714,69 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
   *tlen = tpos;
 }
 
+/* If the target view of WINDOW is a single contiguous block of either
+ * its new data or of its source view SBUF, return a pointer to it.
+ * Return NULL, if the instructions must be executed to get the target
+ * view.  This is the case for windows that mix different kinds of
+ * instructions.
+ *
+ * Windows of added files consist of new data only and unchanged parts
+ * of large files become single source copies.  Neither needs to be
+ * copied into a target buffer before being written.  */
+static const char *
+direct_target_view(const svn_txdelta_window_t *window,
+                   const char *sbuf)
+{
+  const svn_txdelta_op_t *op;
+  apr_size_t start, end, limit;
+  const char *base;
+
+  if (window->num_ops == 0)
+    return NULL;
+
+  op = window->ops;
+  switch (op->action_code)
+    {
+    case svn_txdelta_new:
+      base = window->new_data->data;
+      limit = window->new_data->len;
+      break;
+
+    case svn_txdelta_source:
+      base = sbuf;
+      limit = window->sview_len;
+      break;
+
+    default:
+      return NULL;
+    }
+
+  /* All instructions must continue where the previous one ended. */
+  start = op->offset;
+  end = start;
+  for (; op < window->ops + window->num_ops; op++)
+    {
+      if (op->action_code != window->ops[0].action_code || op->offset != end)
+        return NULL;
+
+      end += op->length;
+    }
+
+  if (   base == NULL
+      || end < start
+      || end > limit
+      || end - start != window->tview_len)
+    return NULL;
+
+  return base + start;
+}
+
 /* Apply WINDOW to the streams given by APPL.  */
 static svn_error_t *
 apply_window(svn_txdelta_window_t *window, void *baton)
 {
   struct apply_baton *ab = (struct apply_baton *) baton;
+  const char *data;
   apr_size_t len;
 
   if (window == NULL)
@@ -748,9 +806,6 @@ apply_window(svn_txdelta_window_t *window, void *baton)
                      && (window->sview_offset + window->sview_len
                          >= ab->sbuf_offset + ab->sbuf_len)));
 
-  /* Make sure there's enough room in the target buffer.  */
-  SVN_ERR(size_buffer(&ab->tbuf, &ab->tbuf_size, window->tview_len, ab->pool));
-
   /* Prepare the source buffer for reading from the input stream.  */
   if (window->sview_offset != ab->sbuf_offset
       || window->sview_len > ab->sbuf_size)
@@ -788,18 +843,27 @@ apply_window(svn_txdelta_window_t *window, void *baton)
     }
 
   /* Apply the window instructions to the source view to generate
-     the target view.  */
+     the target view, unless we can use the data as is.  */
   len = window->tview_len;
-  svn_txdelta_apply_instructions(window, ab->sbuf, ab->tbuf, &len);
-  SVN_ERR_ASSERT(len == window->tview_len);
+  data = direct_target_view(window, ab->sbuf);
+  if (data == NULL)
+    {
+      /* Make sure there's enough room in the target buffer.  */
+      SVN_ERR(size_buffer(&ab->tbuf, &ab->tbuf_size, window->tview_len,
+                          ab->pool));
+
+      svn_txdelta_apply_instructions(window, ab->sbuf, ab->tbuf, &len);
+      SVN_ERR_ASSERT(len == window->tview_len);
+      data = ab->tbuf;
+    }
 
   /* Write out the output. */
 
   /* Just update the context here. */
   if (ab->result_digest)
-    SVN_ERR(svn_checksum_update(ab->md5_context, ab->tbuf, len));
+    SVN_ERR(svn_checksum_update(ab->md5_context, data, len));
 
-  return svn_stream_write(ab->target, ab->tbuf, &len);
+  return svn_stream_write(ab->target, data, &len);
 }
 
 
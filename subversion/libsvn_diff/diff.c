@@ -22,13 +22,17 @@
  */
 
 
+#include <string.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
+#include <apr_tables.h>
 
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_diff.h"
+#include "svn_sorts.h"
 #include "svn_types.h"
 
 #include "diff.h"
@@ -125,11 +129,300 @@ svn_diff__diff(svn_diff__lcs_t *lcs,
 }
 
 
-svn_error_t *
-svn_diff_diff_2(svn_diff_t **diff,
+/* Rough upper bound for the memory needed per line and datasource when
+ * diffing in windows: the position, the token, its tree slot and the
+ * LCS state. */
+#define WINDOW_BYTES_PER_LINE 256
+
+/* Minimum number of lines per datasource in a window. */
+#define MIN_WINDOW_LINES 1024
+
+/* A token that has been read from a datasource but not been committed
+ * to the diff yet. */
+typedef struct window_token_t
+{
+  void *token;
+  apr_uint32_t hash;
+} window_token_t;
+
+/* Return a new LCS element of LENGTH lines starting at OFFSET0 and
+ * OFFSET1, respectively, followed by NEXT.  Allocate it in POOL. */
+static svn_diff__lcs_t *
+make_lcs(svn_diff__lcs_t *next,
+         apr_off_t offset0,
+         apr_off_t offset1,
+         apr_off_t length,
+         apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs = apr_palloc(pool, sizeof(*lcs));
+
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = offset0;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = offset1;
+  lcs->length = length;
+  lcs->refcount = 1;
+  lcs->next = next;
+
+  return lcs;
+}
+
+/* Convert LCS, which starts at ORIGINAL_START and MODIFIED_START, into
+ * hunks allocated in POOL and append them at *DIFF_REF.  Merge the first
+ * new hunk into *LAST_HUNK if both are of the same type.  Update *DIFF_REF
+ * and *LAST_HUNK to point to the new end of the list.
+ */
+static void
+append_hunks(svn_diff_t ***diff_ref,
+             svn_diff_t **last_hunk,
+             svn_diff__lcs_t *lcs,
+             apr_off_t original_start,
+             apr_off_t modified_start,
+             apr_pool_t *pool)
+{
+  svn_diff_t *hunks = svn_diff__diff(lcs, original_start, modified_start,
+                                     TRUE, pool);
+
+  if (hunks && *last_hunk && hunks->type == (*last_hunk)->type)
+    {
+      (*last_hunk)->original_length += hunks->original_length;
+      (*last_hunk)->modified_length += hunks->modified_length;
+      hunks = hunks->next;
+    }
+
+  **diff_ref = hunks;
+  while (**diff_ref)
+    {
+      *last_hunk = **diff_ref;
+      *diff_ref = &(**diff_ref)->next;
+    }
+}
+
+/* Implement svn_diff__diff_2() for large inputs: never hold more than
+ * WINDOW_LINES lines of each datasource in memory.
+ *
+ * Read up to WINDOW_LINES tokens from both datasources, compute their LCS
+ * and commit the hunks up to the end of the last common chunk.  Carry the
+ * remaining tokens over into the next window.  If that would commit less
+ * than a quarter of a window, commit both windows in full instead to
+ * guarantee progress.  The result is a valid diff but may not be
+ * minimal across window boundaries.
+ */
+static svn_error_t *
+diff_2_windowed(svn_diff_t **diff,
+                apr_off_t window_lines,
+                svn_diff_file_algorithm_t algorithm,
                 void *diff_baton,
                 const svn_diff_fns2_t *vtable,
                 apr_pool_t *pool)
+{
+  svn_diff_datasource_e datasource[] = {svn_diff_datasource_original,
+                                        svn_diff_datasource_modified};
+  svn_diff_fns2_t window_vtable = *vtable;
+  apr_array_header_t *pending[2];
+  svn_boolean_t at_eof[2] = { FALSE, FALSE };
+  apr_off_t start[2];
+  apr_off_t prefix_lines = 0;
+  apr_off_t suffix_lines = 0;
+  svn_diff_t **diff_ref = diff;
+  svn_diff_t *last_hunk = NULL;
+  apr_pool_t *iterpool;
+  svn_boolean_t done = FALSE;
+  int i;
+
+  /* Tokens that are still pending must not be discarded when an equal
+   * token gets inserted into the window's tree.  We discard them
+   * ourselves once they have been committed. */
+  window_vtable.token_discard = NULL;
+
+  *diff = NULL;
+
+  SVN_ERR(vtable->datasources_open(diff_baton, &prefix_lines, &suffix_lines,
+                                   datasource, 2));
+
+  if (prefix_lines)
+    append_hunks(&diff_ref, &last_hunk,
+                 make_lcs(make_lcs(NULL, prefix_lines + 1, prefix_lines + 1,
+                                   0, pool),
+                          1, 1, prefix_lines, pool),
+                 1, 1, pool);
+
+  for (i = 0; i < 2; i++)
+    {
+      pending[i] = apr_array_make(pool, (int)window_lines,
+                                  sizeof(window_token_t));
+      start[i] = prefix_lines + 1;
+    }
+
+  iterpool = svn_pool_create(pool);
+  while (!done)
+    {
+      svn_diff__tree_t *tree;
+      svn_diff__position_t *position_list[2];
+      svn_diff__token_index_t *token_counts[2];
+      svn_diff__token_index_t num_tokens;
+      svn_diff__lcs_t *lcs;
+      svn_diff__lcs_t *sync = NULL;
+      apr_off_t end[2];
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      /* Top up the windows. */
+      for (i = 0; i < 2; i++)
+        while (!at_eof[i] && pending[i]->nelts < window_lines)
+          {
+            window_token_t *window_token;
+            apr_uint32_t hash = 0;
+            void *token = NULL;
+
+            SVN_ERR(vtable->datasource_get_next_token(&hash, &token,
+                                                      diff_baton,
+                                                      datasource[i]));
+            if (token == NULL)
+              {
+                at_eof[i] = TRUE;
+                SVN_ERR(vtable->datasource_close(diff_baton, datasource[i]));
+                break;
+              }
+
+            window_token = apr_array_push(pending[i]);
+            window_token->token = token;
+            window_token->hash = hash;
+          }
+
+      done = at_eof[0] && at_eof[1];
+      for (i = 0; i < 2; i++)
+        end[i] = start[i] + pending[i]->nelts;
+
+      if (pending[0]->nelts == 0 || pending[1]->nelts == 0)
+        {
+          /* Nothing to match: everything up to EOF or the end of the
+           * non-empty window is a modification. */
+          lcs = make_lcs(NULL, end[0], end[1], 0, iterpool);
+          if (done && suffix_lines)
+            {
+              lcs->position[0]->offset += suffix_lines;
+              lcs->position[1]->offset += suffix_lines;
+              lcs = make_lcs(lcs, end[0], end[1], suffix_lines, iterpool);
+            }
+        }
+      else
+        {
+          /* Build position rings for the window. */
+          svn_diff__tree_create(&tree, iterpool);
+          for (i = 0; i < 2; i++)
+            {
+              svn_diff__position_t *positions
+                = apr_palloc(iterpool,
+                             pending[i]->nelts * sizeof(*positions));
+
+              for (k = 0; k < pending[i]->nelts; k++)
+                {
+                  window_token_t *window_token
+                    = &APR_ARRAY_IDX(pending[i], k, window_token_t);
+
+                  SVN_ERR(svn_diff__get_token_index(&positions[k].token_index,
+                                                    tree, diff_baton,
+                                                    &window_vtable,
+                                                    window_token->hash,
+                                                    window_token->token));
+                  positions[k].offset = start[i] + k;
+                  positions[k].next = &positions[(k + 1) % pending[i]->nelts];
+                }
+
+              position_list[i] = &positions[pending[i]->nelts - 1];
+            }
+
+          num_tokens = svn_diff__get_node_count(tree);
+          for (i = 0; i < 2; i++)
+            token_counts[i] = svn_diff__get_token_counts(position_list[i],
+                                                         num_tokens,
+                                                         iterpool);
+
+          lcs = svn_diff__lcs(position_list[0], position_list[1],
+                              token_counts[0], token_counts[1], num_tokens,
+                              0, done ? suffix_lines : 0, algorithm,
+                              iterpool);
+
+          /* Commit up to the end of the last common chunk. */
+          if (!done)
+            {
+              svn_diff__lcs_t *chunk;
+
+              for (chunk = lcs; chunk->length > 0; chunk = chunk->next)
+                sync = chunk;
+
+              for (i = 0; i < 2; i++)
+                {
+                  svn_diff__position_t *positions = position_list[i]->next;
+                  apr_off_t window_end = end[i];
+
+                  end[i] = sync ? sync->position[i]->offset + sync->length
+                                : start[i];
+
+                  /* Lines that do not occur in the other window at all
+                   * cannot match anything there.  Commit them, too. */
+                  while (end[i] < window_end
+                         && token_counts[1 - i][
+                              positions[end[i] - start[i]].token_index] == 0)
+                    end[i]++;
+                }
+
+              if ((end[0] - start[0]) + (end[1] - start[1])
+                  < window_lines / 4)
+                {
+                  /* Too little progress; commit the windows in full. */
+                  end[0] = start[0] + pending[0]->nelts;
+                  end[1] = start[1] + pending[1]->nelts;
+                }
+              else if (sync)
+                {
+                  sync->next = make_lcs(NULL, end[0], end[1], 0, iterpool);
+                }
+              else
+                {
+                  lcs = make_lcs(NULL, end[0], end[1], 0, iterpool);
+                }
+            }
+        }
+
+      append_hunks(&diff_ref, &last_hunk, lcs, start[0], start[1], pool);
+
+      /* Release the committed tokens and move on. */
+      for (i = 0; i < 2; i++)
+        {
+          int committed = (int)(end[i] - start[i]);
+
+          if (vtable->token_discard != NULL)
+            for (k = 0; k < committed; k++)
+              vtable->token_discard(diff_baton,
+                                    APR_ARRAY_IDX(pending[i], k,
+                                                  window_token_t).token);
+
+          memmove(pending[i]->elts,
+                  pending[i]->elts + committed * sizeof(window_token_t),
+                  (pending[i]->nelts - committed) * sizeof(window_token_t));
+          pending[i]->nelts -= committed;
+          start[i] = end[i];
+        }
+    }
+
+  if (vtable->token_discard_all != NULL)
+    vtable->token_discard_all(diff_baton);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 svn_diff_file_algorithm_t algorithm,
+                 apr_size_t memory_limit,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
   svn_diff__position_t *position_list[2];
@@ -143,6 +436,17 @@ svn_diff_diff_2(svn_diff_t **diff,
   apr_off_t prefix_lines = 0;
   apr_off_t suffix_lines = 0;
 
+  if (memory_limit)
+    {
+      apr_off_t window_lines = memory_limit / (2 * WINDOW_BYTES_PER_LINE);
+
+      return svn_error_trace(diff_2_windowed(diff,
+                                             MAX(window_lines,
+                                                 MIN_WINDOW_LINES),
+                                             algorithm, diff_baton, vtable,
+                                             pool));
+    }
+
   *diff = NULL;
 
   subpool = svn_pool_create(pool);
@@ -187,7 +491,7 @@ svn_diff_diff_2(svn_diff_t **diff,
   /* Get the lcs */
   lcs = svn_diff__lcs(position_list[0], position_list[1], token_counts[0],
                       token_counts[1], num_tokens, prefix_lines,
-                      suffix_lines, subpool);
+                      suffix_lines, algorithm, subpool);
 
   /* Produce the diff */
   *diff = svn_diff__diff(lcs, 1, 1, TRUE, pool);
@@ -197,3 +501,13 @@ svn_diff_diff_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff_2(svn_diff_t **diff,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff_2(diff, svn_diff_file_algorithm_myers,
+                                          0, diff_baton, vtable, pool));
+}
@@ -101,6 +101,8 @@ typedef enum svn_diff__normalize_state_t
  * equal and be excluded from the comparison process. Similarly, SUFFIX_LINES
  * at the end of both sequences will be skipped.
  *
+ * ALGORITHM selects the matching strategy.
+ *
  * The resulting lcs structure will be the return value of this function.
  * Allocations will be made from POOL.
  */
@@ -112,8 +114,51 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__token_index_t num_tokens, /* length of count arrays */
               apr_off_t prefix_lines,
               apr_off_t suffix_lines,
+              svn_diff_file_algorithm_t algorithm,
               apr_pool_t *pool);
 
+/*
+ * Calculate the common subsequence between the non-empty rings
+ * POSITION_LIST1 and POSITION_LIST2 using histogram diff.  NUM_TOKENS
+ * is one more than the highest token index in either ring.
+ *
+ * Return the chain of common chunks in ascending order, followed by TAIL.
+ * Allocations will be made from POOL.
+ */
+svn_diff__lcs_t *
+svn_diff__histogram_lcs(svn_diff__position_t *position_list1,
+                        svn_diff__position_t *position_list2,
+                        svn_diff__token_index_t num_tokens,
+                        svn_diff__lcs_t *tail,
+                        apr_pool_t *pool);
+
+/* Like svn_diff_diff_2(), but use ALGORITHM to match the datasources.
+ * If MEMORY_LIMIT is not 0, process the datasources in windows such that
+ * the memory used stays roughly below MEMORY_LIMIT bytes. */
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 svn_diff_file_algorithm_t algorithm,
+                 apr_size_t memory_limit,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool);
+
+/* Like svn_diff_diff3_2(), but use ALGORITHM to match the datasources. */
+svn_error_t *
+svn_diff__diff3(svn_diff_t **diff,
+                svn_diff_file_algorithm_t algorithm,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool);
+
+/* Like svn_diff_diff4_2(), but use ALGORITHM to match the datasources. */
+svn_error_t *
+svn_diff__diff4(svn_diff_t **diff,
+                svn_diff_file_algorithm_t algorithm,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool);
+
 
 /*
  * Returns number of tokens in a tree
@@ -128,6 +173,20 @@ void
 svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool);
 
 
+/*
+ * Insert TOKEN with HASH, which has already been read from a datasource,
+ * into TREE and return its index in *TOKEN_INDEX.  If TREE already
+ * contains an equal token, that one will be replaced by TOKEN and passed
+ * to VTABLE->token_discard unless that is NULL.
+ */
+svn_error_t *
+svn_diff__get_token_index(svn_diff__token_index_t *token_index,
+                          svn_diff__tree_t *tree,
+                          void *diff_baton,
+                          const svn_diff_fns2_t *vtable,
+                          apr_uint32_t hash,
+                          void *token);
+
 /*
  * Get all tokens from a datasource.  Return the
  * last item in the (circular) list.
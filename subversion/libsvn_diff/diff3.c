@@ -182,7 +182,8 @@ svn_diff__resolve_conflict(svn_diff_t *hunk,
                                                subpool);
 
   *lcs_ref = svn_diff__lcs(position[0], position[1], token_counts[0],
-                           token_counts[1], num_tokens, 0, 0, subpool);
+                           token_counts[1], num_tokens, 0, 0,
+                           svn_diff_file_algorithm_myers, subpool);
 
   /* Fix up the EOF lcs element in case one of
    * the two sequences was NULL.
@@ -248,10 +249,11 @@ svn_diff__resolve_conflict(svn_diff_t *hunk,
 
 
 svn_error_t *
-svn_diff_diff3_2(svn_diff_t **diff,
-                 void *diff_baton,
-                 const svn_diff_fns2_t *vtable,
-                 apr_pool_t *pool)
+svn_diff__diff3(svn_diff_t **diff,
+                svn_diff_file_algorithm_t algorithm,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
   svn_diff__position_t *position_list[3];
@@ -317,10 +319,10 @@ svn_diff_diff3_2(svn_diff_t **diff,
   /* Get the lcs for original-modified and original-latest */
   lcs_om = svn_diff__lcs(position_list[0], position_list[1], token_counts[0],
                          token_counts[1], num_tokens, prefix_lines,
-                         suffix_lines, subpool);
+                         suffix_lines, algorithm, subpool);
   lcs_ol = svn_diff__lcs(position_list[0], position_list[2], token_counts[0],
                          token_counts[2], num_tokens, prefix_lines,
-                         suffix_lines, subpool);
+                         suffix_lines, algorithm, subpool);
 
   /* Produce a merged diff */
   {
@@ -530,3 +532,13 @@ svn_diff_diff3_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff3_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff3(diff, svn_diff_file_algorithm_myers,
+                                         diff_baton, vtable, pool));
+}
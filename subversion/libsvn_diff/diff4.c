@@ -166,10 +166,11 @@ adjust_diff(svn_diff_t *diff, svn_diff_t *adjust)
 }
 
 svn_error_t *
-svn_diff_diff4_2(svn_diff_t **diff,
-                 void *diff_baton,
-                 const svn_diff_fns2_t *vtable,
-                 apr_pool_t *pool)
+svn_diff__diff4(svn_diff_t **diff,
+                svn_diff_file_algorithm_t algorithm,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
   svn_diff__position_t *position_list[4];
@@ -251,7 +252,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_ol = svn_diff__lcs(position_list[0], position_list[2],
                          token_counts[0], token_counts[2],
                          num_tokens, prefix_lines,
-                         suffix_lines, subpool3);
+                         suffix_lines, algorithm, subpool3);
   diff_ol = svn_diff__diff(lcs_ol, 1, 1, TRUE, pool);
 
   svn_pool_clear(subpool3);
@@ -275,7 +276,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_adjust = svn_diff__lcs(position_list[3], position_list[2],
                              token_counts[3], token_counts[2],
                              num_tokens, prefix_lines,
-                             suffix_lines, subpool3);
+                             suffix_lines, algorithm, subpool3);
   diff_adjust = svn_diff__diff(lcs_adjust, 1, 1, FALSE, subpool3);
   adjust_diff(diff_ol, diff_adjust);
 
@@ -287,7 +288,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_adjust = svn_diff__lcs(position_list[1], position_list[3],
                              token_counts[1], token_counts[3],
                              num_tokens, prefix_lines,
-                             suffix_lines, subpool3);
+                             suffix_lines, algorithm, subpool3);
   diff_adjust = svn_diff__diff(lcs_adjust, 1, 1, FALSE, subpool3);
   adjust_diff(diff_ol, diff_adjust);
 
@@ -312,3 +313,13 @@ svn_diff_diff4_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff4_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff4(diff, svn_diff_file_algorithm_myers,
+                                         diff_baton, vtable, pool));
+}
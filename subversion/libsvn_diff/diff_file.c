@@ -1181,6 +1181,7 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_HISTOGRAM 257
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1194,7 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1292,6 +1294,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case SVN_DIFF__OPT_IGNORE_EOL_STYLE:
           options->ignore_eol_style = TRUE;
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->algorithm = svn_diff_file_algorithm_histogram;
+          break;
         case 'p':
           options->show_c_function = TRUE;
           break;
@@ -1326,7 +1331,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, options->algorithm, options->memory_limit,
+                           &baton, &svn_diff__file_vtable, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1354,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3(diff, options->algorithm, &baton,
+                        &svn_diff__file_vtable, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1372,7 +1379,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4(diff, options->algorithm, &baton,
+                        &svn_diff__file_vtable, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -24,6 +24,9 @@
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include <assert.h>
 
@@ -34,7 +37,9 @@
 #include "svn_props.h"
 #include "svn_types.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_diff_tree.h"
+#include "private/svn_io_private.h"
 #include "svn_private_config.h"
 
 typedef struct tree_processor_t
@@ -1694,6 +1699,904 @@ svn_diff__tree_processor_tee_create(const svn_diff_tree_processor_t *processor1,
   return tee;
 }
 
+/* The pipeline processor.
+ *
+ * All events are recorded in order and forwarded to the wrapped processor
+ * by a single worker thread, while the driver continues with the next
+ * nodes.  Everything an event refers to is copied, as the driver may
+ * release it as soon as the callback returns.  Files get hard linked
+ * where possible.
+ *
+ * Opening a directory waits for the worker to catch up, so that the
+ * wrapped processor's skip decisions can be passed on to the driver.
+ */
+
+#if APR_HAS_THREADS
+
+/* The maximum number of events queued for the worker before the driver
+ * has to wait for it to catch up. */
+#define PIPELINE_MAX_QUEUED 64
+
+/* The kinds of events recorded by the pipeline processor. */
+typedef enum pipeline_event_kind_t
+{
+  pipeline_event_dir_opened,
+  pipeline_event_dir_added,
+  pipeline_event_dir_deleted,
+  pipeline_event_dir_changed,
+  pipeline_event_dir_closed,
+  pipeline_event_file_opened,
+  pipeline_event_file_added,
+  pipeline_event_file_deleted,
+  pipeline_event_file_changed,
+  pipeline_event_file_closed,
+  pipeline_event_node_absent
+} pipeline_event_kind_t;
+
+/* Node baton of the pipeline processor. */
+struct pipeline_node_baton_t
+{
+  /* The pool holding this baton, its opened event and everything the
+   * wrapped processor allocates for the node.  Destroyed by the worker
+   * once it has forwarded the node's last event. */
+  apr_pool_t *pool;
+
+  /* The parent directory's baton, or NULL for the root of the diff. */
+  struct pipeline_node_baton_t *parent;
+
+  /* The wrapped processor's baton and skip flags for this node.  Only
+   * accessed by the worker. */
+  void *baton;
+  svn_boolean_t skip;
+  svn_boolean_t skip_children;
+};
+
+/* One recorded event.  The names of the fields follow file_changed();
+ * for the added events, LEFT_FILE and LEFT_PROPS hold the copyfrom data. */
+struct pipeline_event_t
+{
+  pipeline_event_kind_t kind;
+
+  /* The pool holding this event, or NULL for opened events, which live
+   * in NODE->POOL. */
+  apr_pool_t *pool;
+
+  /* The node this event applies to.  For node_absent(), the parent
+   * directory, which may be NULL. */
+  struct pipeline_node_baton_t *node;
+
+  /* Position of this event in the queue, counting from 1. */
+  apr_int64_t seq;
+
+  const char *relpath;
+  const svn_diff_source_t *left_source;
+  const svn_diff_source_t *right_source;
+  const svn_diff_source_t *copyfrom_source;
+  const char *left_file;
+  const char *right_file;
+  apr_hash_t *left_props;
+  apr_hash_t *right_props;
+  const apr_array_header_t *prop_changes;
+  svn_boolean_t file_modified;
+
+  /* The next event in the queue. */
+  struct pipeline_event_t *next;
+};
+
+/* Baton for the pipeline processor. */
+struct pipeline_baton_t
+{
+  /* The wrapped processor. */
+  const svn_diff_tree_processor_t *processor;
+
+  /* Root pool of a thread-safe allocator.  Node and event pools are
+   * created below it by the driver and destroyed by the worker. */
+  apr_pool_t *root_pool;
+
+  /* Scratch pool of the worker. */
+  apr_pool_t *scratch_pool;
+
+  /* The worker thread, or NULL if events are forwarded in-line. */
+  apr_thread_t *thread;
+
+  /* Set once the worker has terminated because it could not synchronize
+   * with the driver.  WORKER_STATUS tells why. */
+  volatile svn_atomic_t worker_failed;
+  apr_status_t worker_status;
+
+  /* Protects all of the following members.  COND is signalled whenever
+   * any of them changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* The queued events, oldest first. */
+  struct pipeline_event_t *head;
+  struct pipeline_event_t *tail;
+  int queued;
+
+  /* Number of events queued and completely forwarded so far. */
+  apr_int64_t pushed;
+  apr_int64_t forwarded;
+
+  /* Set when the processor is being destroyed. */
+  svn_boolean_t shutdown;
+
+  /* TRUE once the wrapped processor has returned an error.  All later
+   * events are discarded. */
+  svn_boolean_t failed;
+
+  /* The error returned by the wrapped processor, until it is passed on
+   * to the driver. */
+  svn_error_t *err;
+};
+
+/* Return TRUE if events of kind KIND are the last event for their node. */
+static svn_boolean_t
+pipeline_is_last_event(pipeline_event_kind_t kind)
+{
+  return kind != pipeline_event_dir_opened
+      && kind != pipeline_event_file_opened
+      && kind != pipeline_event_node_absent;
+}
+
+/* Forward EVENT to the wrapped processor of PB, unless DISCARD is TRUE,
+ * and release the event's resources.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+pipeline_forward(struct pipeline_baton_t *pb,
+                 struct pipeline_event_t *event,
+                 svn_boolean_t discard,
+                 apr_pool_t *scratch_pool)
+{
+  const svn_diff_tree_processor_t *p = pb->processor;
+  struct pipeline_node_baton_t *nb = event->node;
+  struct pipeline_node_baton_t *parent = nb ? nb->parent : NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (discard)
+    ;
+  else if (event->kind == pipeline_event_dir_opened
+           || event->kind == pipeline_event_file_opened)
+    {
+      if (parent && parent->skip_children)
+        {
+          nb->skip = TRUE;
+          nb->skip_children = TRUE;
+        }
+      else if (event->kind == pipeline_event_dir_opened)
+        err = p->dir_opened(&nb->baton, &nb->skip, &nb->skip_children,
+                            event->relpath, event->left_source,
+                            event->right_source, event->copyfrom_source,
+                            parent ? parent->baton : NULL, p,
+                            nb->pool, scratch_pool);
+      else
+        err = p->file_opened(&nb->baton, &nb->skip,
+                             event->relpath, event->left_source,
+                             event->right_source, event->copyfrom_source,
+                             parent ? parent->baton : NULL, p,
+                             nb->pool, scratch_pool);
+    }
+  else if (event->kind == pipeline_event_node_absent)
+    {
+      if (!nb || !nb->skip_children)
+        err = p->node_absent(event->relpath, nb ? nb->baton : NULL, p,
+                             scratch_pool);
+    }
+  else if (!nb->skip)
+    {
+      switch (event->kind)
+        {
+          case pipeline_event_dir_added:
+            err = p->dir_added(event->relpath, event->copyfrom_source,
+                               event->right_source, event->left_props,
+                               event->right_props, nb->baton, p,
+                               scratch_pool);
+            break;
+          case pipeline_event_dir_deleted:
+            err = p->dir_deleted(event->relpath, event->left_source,
+                                 event->left_props, nb->baton, p,
+                                 scratch_pool);
+            break;
+          case pipeline_event_dir_changed:
+            err = p->dir_changed(event->relpath, event->left_source,
+                                 event->right_source, event->left_props,
+                                 event->right_props, event->prop_changes,
+                                 nb->baton, p, scratch_pool);
+            break;
+          case pipeline_event_dir_closed:
+            err = p->dir_closed(event->relpath, event->left_source,
+                                event->right_source, nb->baton, p,
+                                scratch_pool);
+            break;
+          case pipeline_event_file_added:
+            err = p->file_added(event->relpath, event->copyfrom_source,
+                                event->right_source, event->left_file,
+                                event->right_file, event->left_props,
+                                event->right_props, nb->baton, p,
+                                scratch_pool);
+            break;
+          case pipeline_event_file_deleted:
+            err = p->file_deleted(event->relpath, event->left_source,
+                                  event->left_file, event->left_props,
+                                  nb->baton, p, scratch_pool);
+            break;
+          case pipeline_event_file_changed:
+            err = p->file_changed(event->relpath, event->left_source,
+                                  event->right_source, event->left_file,
+                                  event->right_file, event->left_props,
+                                  event->right_props, event->file_modified,
+                                  event->prop_changes, nb->baton, p,
+                                  scratch_pool);
+            break;
+          case pipeline_event_file_closed:
+            err = p->file_closed(event->relpath, event->left_source,
+                                 event->right_source, nb->baton, p,
+                                 scratch_pool);
+            break;
+          default:
+            SVN_ERR_MALFUNCTION_NO_RETURN();
+        }
+    }
+
+  /* Removes the copied files as well. */
+  if (event->pool)
+    svn_pool_destroy(event->pool);
+  if (pipeline_is_last_event(event->kind))
+    svn_pool_destroy(nb->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Terminate the worker of PB because of the synchronization failure
+ * STATUS.  The worker should hold the mutex, so that the driver cannot
+ * miss the wake-up call. */
+static void
+pipeline_worker_fail(struct pipeline_baton_t *pb,
+                     apr_status_t status)
+{
+  pb->worker_status = status;
+  svn_atomic_set(&pb->worker_failed, TRUE);
+  apr_thread_cond_broadcast(pb->cond);
+}
+
+/* Implements the apr_thread_start_t interface.  Forward the events queued
+ * in the struct pipeline_baton_t DATA until the processor is destroyed. */
+static void * APR_THREAD_FUNC
+pipeline_worker(apr_thread_t *thread, void *data)
+{
+  struct pipeline_baton_t *pb = data;
+  apr_status_t status;
+  svn_boolean_t locked;
+
+  status = apr_thread_mutex_lock(pb->mutex);
+  locked = (status == APR_SUCCESS);
+
+  while (status == APR_SUCCESS)
+    {
+      struct pipeline_event_t *event;
+      apr_int64_t seq;
+      svn_boolean_t discard;
+      svn_error_t *err;
+
+      while (!pb->head && !pb->shutdown && status == APR_SUCCESS)
+        status = apr_thread_cond_wait(pb->cond, pb->mutex);
+
+      event = pb->head;
+      if (status || !event)
+        break;
+
+      pb->head = event->next;
+      if (!pb->head)
+        pb->tail = NULL;
+      pb->queued--;
+      seq = event->seq;
+      discard = pb->failed || pb->shutdown;
+
+      status = apr_thread_cond_broadcast(pb->cond);
+      if (status == APR_SUCCESS)
+        {
+          status = apr_thread_mutex_unlock(pb->mutex);
+          locked = (status != APR_SUCCESS);
+        }
+
+      /* Release the event even if we can't forward it anymore. */
+      err = pipeline_forward(pb, event, discard || status, pb->scratch_pool);
+      svn_pool_clear(pb->scratch_pool);
+      if (status)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      status = apr_thread_mutex_lock(pb->mutex);
+      locked = (status == APR_SUCCESS);
+      if (status)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      if (err)
+        {
+          pb->failed = TRUE;
+          pb->err = err;
+        }
+      pb->forwarded = seq;
+      status = apr_thread_cond_broadcast(pb->cond);
+    }
+
+  if (status)
+    pipeline_worker_fail(pb, status);
+  if (locked)
+    apr_thread_mutex_unlock(pb->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop the worker of the struct pipeline_baton_t DATA, if any, discarding
+ * all events that it has not forwarded yet, and release all resources. */
+static apr_status_t
+pipeline_cleanup(void *data)
+{
+  struct pipeline_baton_t *pb = data;
+
+  if (pb->thread)
+    {
+      apr_status_t status;
+
+      /* If locking fails, the worker has most likely terminated already.
+       * Tell it to stop anyway rather than leaving it behind with our
+       * pools being destroyed. */
+      status = apr_thread_mutex_lock(pb->mutex);
+      pb->shutdown = TRUE;
+      apr_thread_cond_broadcast(pb->cond);
+      if (status == APR_SUCCESS)
+        apr_thread_mutex_unlock(pb->mutex);
+
+      apr_thread_join(&status, pb->thread);
+    }
+
+  svn_error_clear(pb->err);
+  svn_pool_destroy(pb->root_pool);
+
+  return APR_SUCCESS;
+}
+
+/* Wait for the worker of PB to signal a change, with the mutex being
+ * held.  Return an error if that is not possible. */
+static svn_error_t *
+pipeline_wait(struct pipeline_baton_t *pb)
+{
+  apr_status_t status;
+
+  if (svn_atomic_read(&pb->worker_failed))
+    return svn_error_wrap_apr(pb->worker_status,
+                              _("Diff pipeline worker failed"));
+
+  status = apr_thread_cond_wait(pb->cond, pb->mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand EVENT, which was allocated by the driver, to the worker of PB.  If
+ * WAIT is TRUE, return only after the worker has forwarded EVENT and thus
+ * all earlier events.  Return the first error of the wrapped processor
+ * that has not been returned before. */
+static svn_error_t *
+pipeline_push(struct pipeline_baton_t *pb,
+              struct pipeline_event_t *event,
+              svn_boolean_t wait)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+
+  if (pb->thread)
+    {
+      status = apr_thread_mutex_lock(pb->mutex);
+      if (status)
+        {
+          svn_error_clear(pipeline_forward(pb, event, TRUE,
+                                           pb->scratch_pool));
+          return svn_error_wrap_apr(status, _("Can't lock mutex"));
+        }
+
+      while (pb->queued >= PIPELINE_MAX_QUEUED && !err)
+        err = pipeline_wait(pb);
+
+      if (err)
+        {
+          svn_error_clear(pipeline_forward(pb, event, TRUE,
+                                           pb->scratch_pool));
+        }
+      else
+        {
+          if (pb->tail)
+            pb->tail->next = event;
+          else
+            pb->head = event;
+          pb->tail = event;
+          pb->queued++;
+          event->seq = ++pb->pushed;
+
+          status = apr_thread_cond_broadcast(pb->cond);
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't broadcast condition variable"));
+        }
+
+      if (!err && wait)
+        {
+          apr_int64_t seq = event->seq;
+
+          /* EVENT may be gone once it has been forwarded. */
+          while (pb->forwarded < seq && !err)
+            err = pipeline_wait(pb);
+        }
+
+      if (!err)
+        {
+          err = pb->err;
+          pb->err = NULL;
+        }
+
+      status = apr_thread_mutex_unlock(pb->mutex);
+      if (status && !err)
+        err = svn_error_wrap_apr(status, _("Can't unlock mutex"));
+
+      return svn_error_trace(err);
+    }
+
+  err = pipeline_forward(pb, event, pb->failed, pb->scratch_pool);
+  svn_pool_clear(pb->scratch_pool);
+  if (err)
+    pb->failed = TRUE;
+
+  return svn_error_trace(err);
+}
+
+/* Return a copy of SOURCE, which may be NULL, allocated in RESULT_POOL. */
+static const svn_diff_source_t *
+pipeline_dup_source(const svn_diff_source_t *source,
+                    apr_pool_t *result_pool)
+{
+  svn_diff_source_t *src;
+
+  if (!source)
+    return NULL;
+
+  src = apr_pmemdup(result_pool, source, sizeof(*src));
+  src->repos_relpath = apr_pstrdup(result_pool, source->repos_relpath);
+  src->moved_from_relpath = apr_pstrdup(result_pool,
+                                        source->moved_from_relpath);
+
+  return src;
+}
+
+/* Return a copy of PROPS, which may be NULL, allocated in RESULT_POOL. */
+static apr_hash_t *
+pipeline_dup_props(const apr_hash_t *props,
+                   apr_pool_t *result_pool)
+{
+  return props ? svn_prop_hash_dup(props, result_pool) : NULL;
+}
+
+/* Set *COPY_ABSPATH to a temporary copy of FILE, which may be NULL, that
+ * will be removed when RESULT_POOL is destroyed.  If the events of PB are
+ * forwarded in-line, just return FILE.  Use SCRATCH_POOL for temporary
+ * allocations.
+ *
+ * The driver waits for this, so we rather create a hard link than an
+ * actual copy.  FILE is usually a temporary file of the driver that gets
+ * removed but never modified in place, i.e. the link keeps its contents
+ * alive. */
+static svn_error_t *
+pipeline_dup_file(const char **copy_abspath,
+                  const struct pipeline_baton_t *pb,
+                  const char *file,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  if (!file || !pb->thread)
+    {
+      *copy_abspath = file;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_open_unique_file3(NULL, copy_abspath, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, scratch_pool));
+
+  /* Different file systems etc. are no errors; we copy the file then. */
+  SVN_ERR(svn_io_remove_file2(*copy_abspath, FALSE, scratch_pool));
+  err = svn_io__file_link(file, *copy_abspath, scratch_pool);
+  if (!err)
+    return SVN_NO_ERROR;
+
+  svn_error_clear(err);
+  return svn_error_trace(svn_io_copy_file(file, *copy_abspath, FALSE,
+                                          scratch_pool));
+}
+
+/* Return a new event of KIND for RELPATH on node NB, allocated in its own
+ * pool below the root pool of PB. */
+static struct pipeline_event_t *
+pipeline_event_create(struct pipeline_baton_t *pb,
+                      pipeline_event_kind_t kind,
+                      const char *relpath,
+                      struct pipeline_node_baton_t *nb)
+{
+  apr_pool_t *pool = svn_pool_create(pb->root_pool);
+  struct pipeline_event_t *event = apr_pcalloc(pool, sizeof(*event));
+
+  event->kind = kind;
+  event->pool = pool;
+  event->node = nb;
+  event->relpath = apr_pstrdup(pool, relpath);
+
+  return event;
+}
+
+/* Common guts of pipeline_dir_opened() and pipeline_file_opened().
+ * SKIP_CHILDREN is NULL for files. */
+static svn_error_t *
+pipeline_node_opened(void **new_baton,
+                     svn_boolean_t *skip,
+                     svn_boolean_t *skip_children,
+                     pipeline_event_kind_t kind,
+                     const char *relpath,
+                     const svn_diff_source_t *left_source,
+                     const svn_diff_source_t *right_source,
+                     const svn_diff_source_t *copyfrom_source,
+                     void *parent_dir_baton,
+                     const svn_diff_tree_processor_t *processor)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  apr_pool_t *pool = svn_pool_create(pb->root_pool);
+  struct pipeline_node_baton_t *nb = apr_pcalloc(pool, sizeof(*nb));
+  struct pipeline_event_t *event = apr_pcalloc(pool, sizeof(*event));
+
+  nb->pool = pool;
+  nb->parent = parent_dir_baton;
+
+  event->kind = kind;
+  event->node = nb;
+  event->relpath = apr_pstrdup(pool, relpath);
+  event->left_source = pipeline_dup_source(left_source, pool);
+  event->right_source = pipeline_dup_source(right_source, pool);
+  event->copyfrom_source = pipeline_dup_source(copyfrom_source, pool);
+
+  *new_baton = nb;
+
+  /* Files are far too frequent to wait for the wrapped processor.  They
+   * only inherit the skip decision of their parent, which is final by
+   * now.  The driver has to report everything else. */
+  if (!skip_children)
+    {
+      struct pipeline_node_baton_t *parent = nb->parent;
+
+      *skip = (parent && parent->skip_children);
+      return svn_error_trace(pipeline_push(pb, event, FALSE));
+    }
+
+  /* The worker does not touch NB after forwarding this event, before
+   * the driver reports the next event for the node.  Nodes skipped by the
+   * driver stay around until the processor gets destroyed because we
+   * won't see their last event. */
+  SVN_ERR(pipeline_push(pb, event, TRUE));
+  *skip = nb->skip;
+  *skip_children = nb->skip_children;
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand the last EVENT for its node to the worker of PB.  Once the root of
+ * the diff is done, wait for the worker to catch up, so that the wrapped
+ * processor has seen all events when the drive ends. */
+static svn_error_t *
+pipeline_push_last(struct pipeline_baton_t *pb,
+                   struct pipeline_event_t *event)
+{
+  return svn_error_trace(pipeline_push(pb, event,
+                                       event->node->parent == NULL));
+}
+
+static svn_error_t *
+pipeline_dir_opened(void **new_dir_baton,
+                    svn_boolean_t *skip,
+                    svn_boolean_t *skip_children,
+                    const char *relpath,
+                    const svn_diff_source_t *left_source,
+                    const svn_diff_source_t *right_source,
+                    const svn_diff_source_t *copyfrom_source,
+                    void *parent_dir_baton,
+                    const svn_diff_tree_processor_t *processor,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(pipeline_node_opened(new_dir_baton, skip,
+                                              skip_children,
+                                              pipeline_event_dir_opened,
+                                              relpath, left_source,
+                                              right_source, copyfrom_source,
+                                              parent_dir_baton, processor));
+}
+
+static svn_error_t *
+pipeline_dir_added(const char *relpath,
+                   const svn_diff_source_t *copyfrom_source,
+                   const svn_diff_source_t *right_source,
+                   /*const*/ apr_hash_t *copyfrom_props,
+                   /*const*/ apr_hash_t *right_props,
+                   void *dir_baton,
+                   const svn_diff_tree_processor_t *processor,
+                   apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_dir_added, relpath, dir_baton);
+
+  event->copyfrom_source = pipeline_dup_source(copyfrom_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+  event->left_props = pipeline_dup_props(copyfrom_props, event->pool);
+  event->right_props = pipeline_dup_props(right_props, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_dir_deleted(const char *relpath,
+                     const svn_diff_source_t *left_source,
+                     /*const*/ apr_hash_t *left_props,
+                     void *dir_baton,
+                     const svn_diff_tree_processor_t *processor,
+                     apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_dir_deleted, relpath, dir_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  event->left_props = pipeline_dup_props(left_props, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_dir_changed(const char *relpath,
+                     const svn_diff_source_t *left_source,
+                     const svn_diff_source_t *right_source,
+                     /*const*/ apr_hash_t *left_props,
+                     /*const*/ apr_hash_t *right_props,
+                     const apr_array_header_t *prop_changes,
+                     void *dir_baton,
+                     const svn_diff_tree_processor_t *processor,
+                     apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_dir_changed, relpath, dir_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+  event->left_props = pipeline_dup_props(left_props, event->pool);
+  event->right_props = pipeline_dup_props(right_props, event->pool);
+  if (prop_changes)
+    event->prop_changes = svn_prop_array_dup(prop_changes, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_dir_closed(const char *relpath,
+                    const svn_diff_source_t *left_source,
+                    const svn_diff_source_t *right_source,
+                    void *dir_baton,
+                    const svn_diff_tree_processor_t *processor,
+                    apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_dir_closed, relpath, dir_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_file_opened(void **new_file_baton,
+                     svn_boolean_t *skip,
+                     const char *relpath,
+                     const svn_diff_source_t *left_source,
+                     const svn_diff_source_t *right_source,
+                     const svn_diff_source_t *copyfrom_source,
+                     void *dir_baton,
+                     const svn_diff_tree_processor_t *processor,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(pipeline_node_opened(new_file_baton, skip, NULL,
+                                              pipeline_event_file_opened,
+                                              relpath, left_source,
+                                              right_source, copyfrom_source,
+                                              dir_baton, processor));
+}
+
+static svn_error_t *
+pipeline_file_added(const char *relpath,
+                    const svn_diff_source_t *copyfrom_source,
+                    const svn_diff_source_t *right_source,
+                    const char *copyfrom_file,
+                    const char *right_file,
+                    /*const*/ apr_hash_t *copyfrom_props,
+                    /*const*/ apr_hash_t *right_props,
+                    void *file_baton,
+                    const svn_diff_tree_processor_t *processor,
+                    apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_file_added, relpath, file_baton);
+
+  event->copyfrom_source = pipeline_dup_source(copyfrom_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+  SVN_ERR(pipeline_dup_file(&event->left_file, pb, copyfrom_file,
+                            event->pool, scratch_pool));
+  SVN_ERR(pipeline_dup_file(&event->right_file, pb, right_file,
+                            event->pool, scratch_pool));
+  event->left_props = pipeline_dup_props(copyfrom_props, event->pool);
+  event->right_props = pipeline_dup_props(right_props, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_file_deleted(const char *relpath,
+                      const svn_diff_source_t *left_source,
+                      const char *left_file,
+                      /*const*/ apr_hash_t *left_props,
+                      void *file_baton,
+                      const svn_diff_tree_processor_t *processor,
+                      apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_file_deleted, relpath, file_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  SVN_ERR(pipeline_dup_file(&event->left_file, pb, left_file,
+                            event->pool, scratch_pool));
+  event->left_props = pipeline_dup_props(left_props, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_file_changed(const char *relpath,
+                      const svn_diff_source_t *left_source,
+                      const svn_diff_source_t *right_source,
+                      const char *left_file,
+                      const char *right_file,
+                      /*const*/ apr_hash_t *left_props,
+                      /*const*/ apr_hash_t *right_props,
+                      svn_boolean_t file_modified,
+                      const apr_array_header_t *prop_changes,
+                      void *file_baton,
+                      const svn_diff_tree_processor_t *processor,
+                      apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_file_changed, relpath, file_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+  SVN_ERR(pipeline_dup_file(&event->left_file, pb, left_file,
+                            event->pool, scratch_pool));
+  SVN_ERR(pipeline_dup_file(&event->right_file, pb, right_file,
+                            event->pool, scratch_pool));
+  event->left_props = pipeline_dup_props(left_props, event->pool);
+  event->right_props = pipeline_dup_props(right_props, event->pool);
+  event->file_modified = file_modified;
+  if (prop_changes)
+    event->prop_changes = svn_prop_array_dup(prop_changes, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_file_closed(const char *relpath,
+                     const svn_diff_source_t *left_source,
+                     const svn_diff_source_t *right_source,
+                     void *file_baton,
+                     const svn_diff_tree_processor_t *processor,
+                     apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_file_closed, relpath, file_baton);
+
+  event->left_source = pipeline_dup_source(left_source, event->pool);
+  event->right_source = pipeline_dup_source(right_source, event->pool);
+
+  return svn_error_trace(pipeline_push_last(pb, event));
+}
+
+static svn_error_t *
+pipeline_node_absent(const char *relpath,
+                     void *dir_baton,
+                     const svn_diff_tree_processor_t *processor,
+                     apr_pool_t *scratch_pool)
+{
+  struct pipeline_baton_t *pb = processor->baton;
+  struct pipeline_event_t *event
+    = pipeline_event_create(pb, pipeline_event_node_absent, relpath, dir_baton);
+
+  return svn_error_trace(pipeline_push(pb, event, FALSE));
+}
+
+#endif /* APR_HAS_THREADS */
+
+const svn_diff_tree_processor_t *
+svn_diff__tree_processor_pipeline_create(
+                                const svn_diff_tree_processor_t *processor,
+                                apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  struct pipeline_baton_t *pb;
+  svn_diff_tree_processor_t *pipeline;
+  apr_pool_t *root_pool;
+  apr_status_t status;
+
+  root_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  pb = apr_pcalloc(result_pool, sizeof(*pb));
+  pb->processor = processor;
+  pb->root_pool = root_pool;
+  pb->scratch_pool = svn_pool_create(root_pool);
+
+  status = apr_thread_mutex_create(&pb->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   root_pool);
+  if (status == APR_SUCCESS)
+    status = apr_thread_cond_create(&pb->cond, root_pool);
+  if (status == APR_SUCCESS)
+    status = apr_thread_create(&pb->thread, NULL, pipeline_worker, pb,
+                               svn_pool_create(root_pool));
+
+  /* If we can't start the worker, forward all events in-line. */
+  if (status != APR_SUCCESS)
+    pb->thread = NULL;
+
+  apr_pool_cleanup_register(result_pool, pb, pipeline_cleanup,
+                            apr_pool_cleanup_null);
+
+  pipeline = svn_diff__tree_processor_create(pb, result_pool);
+
+  pipeline->dir_opened   = pipeline_dir_opened;
+  pipeline->dir_added    = pipeline_dir_added;
+  pipeline->dir_deleted  = pipeline_dir_deleted;
+  pipeline->dir_changed  = pipeline_dir_changed;
+  pipeline->dir_closed   = pipeline_dir_closed;
+  pipeline->file_opened  = pipeline_file_opened;
+  pipeline->file_added   = pipeline_file_added;
+  pipeline->file_deleted = pipeline_file_deleted;
+  pipeline->file_changed = pipeline_file_changed;
+  pipeline->file_closed  = pipeline_file_closed;
+  pipeline->node_absent  = pipeline_node_absent;
+
+  return pipeline;
+#else
+  /* Without threads there is nothing to overlap. */
+  return processor;
+#endif
+}
+
 svn_diff_source_t *
 svn_diff__source_create(svn_revnum_t revision,
                         apr_pool_t *result_pool)
@@ -0,0 +1,461 @@
+/*
+ * histogram.c :  routines for creating an lcs using histogram diff
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <apr.h>
+#include <apr_pools.h>
+#include <apr_tables.h>
+
+#include "svn_pools.h"
+
+#include "diff.h"
+
+
+/*
+ * Histogram diff is an extension of patience diff.  Within a region of
+ * both sources, count how often each token occurs in the first source.
+ * Then pick the common token with the lowest count as an anchor, extend
+ * it to the longest matching run around it and recurse into the parts
+ * before and after that run.  Unlike the O(NP) algorithm in lcs.c, the
+ * run time does not depend on the number of differences, and frequent
+ * lines such as blank lines or closing braces never get to determine the
+ * shape of the diff.
+ *
+ * Regions in which every common token occurs more than MAX_CHAIN_LENGTH
+ * times are passed on to the minimal algorithm if they are small.  For
+ * larger ones, we still split at the least frequent common token but
+ * only look at MAX_CHAIN_LENGTH of its occurrences.  Finally, the total
+ * effort spent searching for anchors is limited to MAX_WORK_PER_TOKEN
+ * steps per input token.  Once that is used up, remaining large regions
+ * are reported as changed in their entirety.  That keeps pathological
+ * inputs, e.g. files consisting of few distinct lines, from taking
+ * quadratic time.
+ */
+
+/* Only tokens occurring at most this often in the first source's part
+ * of a region make good anchors.  It also limits the number of
+ * occurrences we look at per token. */
+#define MAX_CHAIN_LENGTH 64
+
+/* Regions without a good anchor that have no more than this many tokens
+ * in total will be compared using the minimal O(NP) algorithm. */
+#define MAX_FALLBACK_TOKENS 4096
+
+/* Search effort allowed per input token. */
+#define MAX_WORK_PER_TOKEN 256
+
+/* A region [START, END) in both sources, given as indexes into the
+ * histogram_t position arrays.  If COMMON_LENGTH is not 0, this is
+ * not a region to compare but a matching chunk of that length at START
+ * to be added to the output. */
+typedef struct region_t
+{
+  apr_off_t start[2];
+  apr_off_t end[2];
+  apr_off_t common_length;
+} region_t;
+
+/* Working data of svn_diff__histogram_lcs(). */
+typedef struct histogram_t
+{
+  /* All positions of both sources, in order. */
+  svn_diff__position_t **positions[2];
+
+  /* Number of occurrences of each token within the region currently
+   * analyzed in the first source.  All 0 outside of find_anchor(). */
+  svn_diff__token_index_t *token_count;
+
+  /* Index of the last occurrence of each token in the region.  Only valid
+   * if the respective TOKEN_COUNT is not 0. */
+  apr_off_t *last_occurrence;
+
+  /* For each position in the first source, the index of the previous
+   * occurrence of the same token within the region or -1. */
+  apr_off_t *prev_occurrence;
+
+  /* Maps token indexes to the dense local indexes used when passing a
+   * region to the minimal algorithm.  -1 for unmapped tokens. */
+  svn_diff__token_index_t *local_index;
+
+  /* Output chain and its end. */
+  svn_diff__lcs_t *lcs;
+  svn_diff__lcs_t **lcs_ref;
+
+  /* Search effort spent so far and the limit for it. */
+  apr_uint64_t work;
+  apr_uint64_t max_work;
+
+  /* Output allocations. */
+  apr_pool_t *pool;
+
+  /* Temporary allocations of compare_minimal(). */
+  apr_pool_t *iterpool;
+} histogram_t;
+
+/* Token index at position INDEX in source SOURCE of histogram H. */
+#define TOKEN(h, source, index) ((h)->positions[source][index]->token_index)
+
+
+/* Add a common chunk of LENGTH tokens starting at START0 and START1,
+ * respectively, to the output of H.
+ */
+static void
+append_common(histogram_t *h,
+              apr_off_t start0,
+              apr_off_t start1,
+              apr_off_t length)
+{
+  svn_diff__lcs_t *lcs = apr_palloc(h->pool, sizeof(*lcs));
+
+  lcs->position[0] = h->positions[0][start0];
+  lcs->position[1] = h->positions[1][start1];
+  lcs->length = length;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  *h->lcs_ref = lcs;
+  h->lcs_ref = &lcs->next;
+}
+
+/* Find the longest common run around the least frequent common token in
+ * REGION of H and return it in *ANCHOR.  Return the lowest number of
+ * occurrences in the first source of any token in that run, or 0 if
+ * no anchor has been found.
+ */
+static svn_diff__token_index_t
+find_anchor(region_t *anchor,
+            histogram_t *h,
+            const region_t *region)
+{
+  svn_diff__token_index_t best_count = 0;
+  apr_off_t i;
+  apr_off_t j;
+
+  anchor->common_length = 0;
+  if (h->work >= h->max_work)
+    return 0;
+
+  h->work += region->end[0] - region->start[0];
+
+  /* Build the histogram of the first source. */
+  for (i = region->start[0]; i < region->end[0]; i++)
+    {
+      svn_diff__token_index_t token = TOKEN(h, 0, i);
+
+      h->prev_occurrence[i] = h->token_count[token]
+                            ? h->last_occurrence[token]
+                            : -1;
+      h->last_occurrence[token] = i;
+      h->token_count[token]++;
+    }
+
+  /* Find the match with the lowest occurrence count in the second. */
+  j = region->start[1];
+  while (j < region->end[1] && h->work < h->max_work)
+    {
+      svn_diff__token_index_t token = TOKEN(h, 1, j);
+      svn_diff__token_index_t count = h->token_count[token];
+      apr_off_t next_j = j + 1;
+      int chain_length;
+
+      if (count == 0 || (best_count && count > best_count))
+        {
+          j = next_j;
+          continue;
+        }
+
+      for (i = h->last_occurrence[token], chain_length = 0;
+           i >= 0 && chain_length < MAX_CHAIN_LENGTH;
+           i = h->prev_occurrence[i], chain_length++)
+        {
+          apr_off_t start0 = i;
+          apr_off_t start1 = j;
+          apr_off_t end0 = i + 1;
+          apr_off_t end1 = j + 1;
+          svn_diff__token_index_t min_count = count;
+
+          while (start0 > region->start[0] && start1 > region->start[1]
+                 && TOKEN(h, 0, start0 - 1) == TOKEN(h, 1, start1 - 1))
+            {
+              start0--;
+              start1--;
+              if (h->token_count[TOKEN(h, 0, start0)] < min_count)
+                min_count = h->token_count[TOKEN(h, 0, start0)];
+            }
+
+          while (end0 < region->end[0] && end1 < region->end[1]
+                 && TOKEN(h, 0, end0) == TOKEN(h, 1, end1))
+            {
+              if (h->token_count[TOKEN(h, 0, end0)] < min_count)
+                min_count = h->token_count[TOKEN(h, 0, end0)];
+              end0++;
+              end1++;
+            }
+
+          h->work += end0 - start0;
+          if (best_count == 0 || min_count < best_count
+              || end0 - start0 > anchor->common_length)
+            {
+              anchor->start[0] = start0;
+              anchor->start[1] = start1;
+              anchor->end[0] = end0;
+              anchor->end[1] = end1;
+              anchor->common_length = end0 - start0;
+              best_count = min_count;
+            }
+
+          /* Positions within this run would only find it again. */
+          if (end1 > next_j)
+            next_j = end1;
+        }
+
+      j = next_j;
+    }
+
+  /* Reset the histogram for the next caller. */
+  for (i = region->start[0]; i < region->end[0]; i++)
+    h->token_count[TOKEN(h, 0, i)] = 0;
+
+  return best_count;
+}
+
+/* Compare REGION of H using the minimal algorithm and append the common
+ * chunks found to the output.
+ */
+static void
+compare_minimal(histogram_t *h,
+                const region_t *region)
+{
+  svn_diff__position_t *ring[2];
+  svn_diff__token_index_t *token_counts[2];
+  svn_diff__token_index_t num_tokens = 0;
+  apr_off_t length[2];
+  svn_diff__lcs_t *lcs;
+  apr_off_t i;
+  int n;
+
+  length[0] = region->end[0] - region->start[0];
+  length[1] = region->end[1] - region->start[1];
+
+  /* Copy the region into private rings with dense token indexes, such
+   * that svn_diff__lcs() does not need to know about the whole files. */
+  for (n = 0; n < 2; n++)
+    {
+      ring[n] = apr_palloc(h->iterpool, length[n] * sizeof(*ring[n]));
+      for (i = 0; i < length[n]; i++)
+        {
+          svn_diff__position_t *position
+            = h->positions[n][region->start[n] + i];
+          svn_diff__token_index_t *local
+            = &h->local_index[position->token_index];
+
+          if (*local < 0)
+            *local = num_tokens++;
+
+          ring[n][i].token_index = *local;
+          ring[n][i].offset = position->offset;
+          ring[n][i].next = &ring[n][(i + 1) % length[n]];
+        }
+    }
+
+  for (n = 0; n < 2; n++)
+    {
+      for (i = 0; i < length[n]; i++)
+        h->local_index[TOKEN(h, n, region->start[n] + i)] = -1;
+
+      token_counts[n] = svn_diff__get_token_counts(&ring[n][length[n] - 1],
+                                                   num_tokens, h->iterpool);
+    }
+
+  lcs = svn_diff__lcs(&ring[0][length[0] - 1], &ring[1][length[1] - 1],
+                      token_counts[0], token_counts[1], num_tokens, 0, 0,
+                      svn_diff_file_algorithm_myers, h->iterpool);
+
+  /* Map the result back to our positions.  Offsets are consecutive. */
+  for (; lcs; lcs = lcs->next)
+    if (lcs->length > 0)
+      append_common(h,
+                    region->start[0]
+                      + (lcs->position[0]->offset - ring[0][0].offset),
+                    region->start[1]
+                      + (lcs->position[1]->offset - ring[1][0].offset),
+                    lcs->length);
+
+  svn_pool_clear(h->iterpool);
+}
+
+
+svn_diff__lcs_t *
+svn_diff__histogram_lcs(svn_diff__position_t *position_list1,
+                        svn_diff__position_t *position_list2,
+                        svn_diff__token_index_t num_tokens,
+                        svn_diff__lcs_t *tail,
+                        apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_diff__position_t *position_list[2];
+  apr_array_header_t *stack;
+  histogram_t h;
+  region_t region;
+  svn_diff__token_index_t token_index;
+  apr_off_t i;
+  int n;
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  h.lcs = NULL;
+  h.lcs_ref = &h.lcs;
+  h.pool = pool;
+  h.iterpool = svn_pool_create(scratch_pool);
+  h.work = 0;
+
+  /* Convert the rings into arrays for random access. */
+  for (n = 0; n < 2; n++)
+    {
+      svn_diff__position_t *position = position_list[n]->next;
+      apr_off_t length = position_list[n]->offset - position->offset + 1;
+
+      h.positions[n] = apr_palloc(scratch_pool,
+                                  length * sizeof(*h.positions[n]));
+      for (i = 0; i < length; i++)
+        {
+          h.positions[n][i] = position;
+          position = position->next;
+        }
+
+      region.start[n] = 0;
+      region.end[n] = length;
+    }
+
+  h.max_work = (apr_uint64_t)(region.end[0] + region.end[1])
+             * MAX_WORK_PER_TOKEN;
+
+  h.token_count = apr_pcalloc(scratch_pool,
+                              num_tokens * sizeof(*h.token_count));
+  h.last_occurrence = apr_palloc(scratch_pool,
+                                 num_tokens * sizeof(*h.last_occurrence));
+  h.prev_occurrence = apr_palloc(scratch_pool,
+                                 region.end[0] * sizeof(*h.prev_occurrence));
+  h.local_index = apr_palloc(scratch_pool,
+                             num_tokens * sizeof(*h.local_index));
+  for (token_index = 0; token_index < num_tokens; token_index++)
+    h.local_index[token_index] = -1;
+
+  /* Process the regions depth-first, left to right, using an explicit
+   * stack.  Recursion depth would otherwise be linear in the file size
+   * in the worst case. */
+  region.common_length = 0;
+  stack = apr_array_make(scratch_pool, 16, sizeof(region_t));
+  APR_ARRAY_PUSH(stack, region_t) = region;
+
+  while (stack->nelts > 0)
+    {
+      region_t anchor;
+      svn_diff__token_index_t anchor_count;
+      svn_boolean_t small;
+
+      region = *(region_t *)apr_array_pop(stack);
+      if (region.common_length)
+        {
+          append_common(&h, region.start[0], region.start[1],
+                        region.common_length);
+          continue;
+        }
+
+      /* Strip the common prefix of the region. */
+      for (i = 0;
+           region.start[0] + i < region.end[0]
+           && region.start[1] + i < region.end[1]
+           && TOKEN(&h, 0, region.start[0] + i)
+              == TOKEN(&h, 1, region.start[1] + i);
+           i++)
+        ;
+
+      if (i)
+        {
+          append_common(&h, region.start[0], region.start[1], i);
+          region.start[0] += i;
+          region.start[1] += i;
+        }
+
+      /* Strip the common suffix.  It will be output after the rest. */
+      for (i = 0;
+           region.end[0] - i > region.start[0]
+           && region.end[1] - i > region.start[1]
+           && TOKEN(&h, 0, region.end[0] - i - 1)
+              == TOKEN(&h, 1, region.end[1] - i - 1);
+           i++)
+        ;
+
+      if (i)
+        {
+          region.end[0] -= i;
+          region.end[1] -= i;
+
+          anchor.start[0] = region.end[0];
+          anchor.start[1] = region.end[1];
+          anchor.common_length = i;
+          APR_ARRAY_PUSH(stack, region_t) = anchor;
+        }
+
+      if (   region.start[0] == region.end[0]
+          || region.start[1] == region.end[1])
+        continue;
+
+      /* Prefer the minimal diff for small regions without good anchors. */
+      small = (region.end[0] - region.start[0])
+              + (region.end[1] - region.start[1]) <= MAX_FALLBACK_TOKENS;
+      anchor_count = find_anchor(&anchor, &h, &region);
+
+      if (anchor_count > 0 && (anchor_count <= MAX_CHAIN_LENGTH || !small))
+        {
+          region_t part;
+
+          /* Push in reverse order of output. */
+          part.start[0] = anchor.end[0];
+          part.start[1] = anchor.end[1];
+          part.end[0] = region.end[0];
+          part.end[1] = region.end[1];
+          part.common_length = 0;
+          APR_ARRAY_PUSH(stack, region_t) = part;
+
+          APR_ARRAY_PUSH(stack, region_t) = anchor;
+
+          part.start[0] = region.start[0];
+          part.start[1] = region.start[1];
+          part.end[0] = anchor.start[0];
+          part.end[1] = anchor.start[1];
+          APR_ARRAY_PUSH(stack, region_t) = part;
+        }
+      else if (small)
+        {
+          compare_minimal(&h, &region);
+        }
+    }
+
+  *h.lcs_ref = tail;
+  svn_pool_destroy(scratch_pool);
+
+  return h.lcs;
+}
@@ -236,6 +236,7 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__token_index_t num_tokens,
               apr_off_t prefix_lines,
               apr_off_t suffix_lines,
+              svn_diff_file_algorithm_t algorithm,
               apr_pool_t *pool)
 {
   apr_off_t length[2];
@@ -279,6 +280,23 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
       return lcs;
     }
 
+  if (algorithm == svn_diff_file_algorithm_histogram)
+    {
+      if (suffix_lines)
+        lcs = prepend_lcs(lcs, suffix_lines,
+                          lcs->position[0]->offset - suffix_lines,
+                          lcs->position[1]->offset - suffix_lines,
+                          pool);
+
+      lcs = svn_diff__histogram_lcs(position_list1, position_list2,
+                                    num_tokens, lcs, pool);
+
+      if (prefix_lines)
+        lcs = prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+
+      return lcs;
+    }
+
   unique_count[1] = unique_count[0] = 0;
   for (token_index = 0; token_index < num_tokens; token_index++)
     {
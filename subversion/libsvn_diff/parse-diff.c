@@ -25,6 +25,8 @@
 #include <stddef.h>
 #include <string.h>
 
+#include <apr_mmap.h>
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_error.h"
@@ -62,12 +64,28 @@ struct svn_diff__hunk_range {
   apr_off_t current;
 };
 
+/* The text of a patch file.  All reads are positional, so any number of
+ * hunks may read from the same source without disturbing each other. */
+typedef struct patch_source_t
+{
+  /* APR file handle to the patch file.  May be NULL if DATA is set.
+   * Both are NULL once the patch file has been closed. */
+  apr_file_t *apr_file;
+
+  /* The whole contents of the patch file if they are available in
+   * memory, e.g. because the file has been mapped.  NULL otherwise. */
+  const char *data;
+
+  /* The size of the patch file in bytes. */
+  apr_off_t size;
+} patch_source_t;
+
 struct svn_diff_hunk_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The patch file this hunk came from. */
+  const patch_source_t *source;
 
   /* Ranges used to keep track of this hunk's texts positions within
    * the patch file. */
@@ -99,20 +117,126 @@ struct svn_diff_binary_patch_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The patch file this hunk came from. */
+  const patch_source_t *source;
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t src_start;
   apr_off_t src_end;
   svn_filesize_t src_filesize; /* Expanded/final size */
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t dst_start;
   apr_off_t dst_end;
   svn_filesize_t dst_filesize; /* Expanded/final size */
 };
 
+/* Read a line from SOURCE, starting at the byte offset *POS, and set *POS
+ * to the offset following the line and its EOL.  At most MAX_LEN bytes
+ * are read.  All other parameters are as in svn_io_file_readline(), whose
+ * behaviour this function matches exactly. */
+static svn_error_t *
+source_readline(const patch_source_t *source,
+                apr_off_t *pos,
+                svn_stringbuf_t **stringbuf,
+                const char **eol,
+                svn_boolean_t *eof,
+                apr_size_t max_len,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *start;
+  apr_size_t available;
+  apr_size_t len;
+  const char *eol_str = NULL;
+  apr_size_t eol_len = 0;
+
+  if (! source->data && ! source->apr_file)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("The patch file has already been closed"));
+
+  if (! source->data)
+    {
+      SVN_ERR(svn_io_file_seek(source->apr_file, APR_SET, pos,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_readline(source->apr_file, stringbuf, eol, eof,
+                                   max_len, result_pool, scratch_pool));
+      SVN_ERR(svn_io_file_get_offset(pos, source->apr_file, scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Fast path: scan the data in memory. */
+  start = source->data + *pos;
+  available = (*pos < source->size) ? (apr_size_t)(source->size - *pos) : 0;
+  if (available > max_len)
+    available = max_len;
+
+  for (len = 0; len < available; len++)
+    if (start[len] == '\n' || start[len] == '\r')
+      break;
+
+  if (len < available)
+    {
+      eol_len = 1;
+      if (start[len] == '\n')
+        eol_str = "\n";
+      else if (len + 1 < available && start[len + 1] == '\n')
+        {
+          eol_str = "\r\n";
+          eol_len = 2;
+        }
+      else
+        eol_str = "\r";
+    }
+
+  *stringbuf = svn_stringbuf_ncreate(start, len, result_pool);
+  *pos += len + eol_len;
+
+  if (eol)
+    *eol = eol_str;
+  if (eof)
+    *eof = (eol_str == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read up to *LEN bytes from SOURCE at byte offset POS into BUFFER and set
+ * *LEN to the number of bytes actually read.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+source_read(const patch_source_t *source,
+            apr_off_t pos,
+            char *buffer,
+            apr_size_t *len,
+            apr_pool_t *scratch_pool)
+{
+  if (! source->data && ! source->apr_file)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("The patch file has already been closed"));
+
+  if (! source->data)
+    {
+      svn_boolean_t eof;
+
+      SVN_ERR(svn_io_file_seek(source->apr_file, APR_SET, &pos,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(source->apr_file, buffer, *len, len,
+                                     &eof, scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  if (pos >= source->size)
+    *len = 0;
+  else if (*len > source->size - pos)
+    *len = (apr_size_t)(source->size - pos);
+
+  memcpy(buffer, source->data + pos, *len);
+
+  return SVN_NO_ERROR;
+}
+
 /* Common guts of svn_diff_hunk__create_adds_single_line() and
  * svn_diff_hunk__create_deletes_single_line().
  *
@@ -131,11 +255,12 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   const apr_size_t header_len = strlen(hunk_header[add]);
   const apr_size_t len = strlen(line);
   const apr_size_t end = header_len + (1 + len); /* The +1 is for the \n. */
-  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(end + 1, scratch_pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(end + 1, result_pool);
+  patch_source_t *source = apr_pcalloc(result_pool, sizeof(*source));
 
   hunk->patch = patch;
 
-  /* hunk->apr_file is created below. */
+  /* hunk->source is created below. */
 
   hunk->diff_text_range.start = header_len;
   hunk->diff_text_range.current = header_len;
@@ -180,7 +305,7 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   hunk->leading_context = 0;
   hunk->trailing_context = 0;
 
-  /* Create APR_FILE and put just a hunk in it (without a diff header).
+  /* Put just a hunk into an in-memory source (without a diff header).
    * Save the offset of the last byte of the diff line. */
   svn_stringbuf_appendbytes(buf, hunk_header[add], header_len);
   svn_stringbuf_appendbyte(buf, add ? '+' : '-');
@@ -190,14 +315,9 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
 
   hunk->diff_text_range.end = buf->len;
 
-  SVN_ERR(svn_io_open_unique_file3(&hunk->apr_file, NULL /* filename */,
-                                   NULL /* system tempdir */,
-                                   svn_io_file_del_on_pool_cleanup,
-                                   result_pool, scratch_pool));
-  SVN_ERR(svn_io_file_write_full(hunk->apr_file,
-                                 buf->data, buf->len,
-                                 NULL, scratch_pool));
-  /* No need to seek. */
+  source->data = buf->data;
+  source->size = buf->len;
+  hunk->source = source;
 
   *hunk_out = hunk;
   return SVN_NO_ERROR;
@@ -298,7 +418,7 @@ svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk)
 /* Baton for the base85 stream implementation */
 struct base85_baton_t
 {
-  apr_file_t *file;
+  const patch_source_t *source;
   apr_pool_t *iterpool;
   char buffer[52];        /* Bytes on current line */
   apr_off_t next_pos;     /* Start position of next line */
@@ -347,17 +467,10 @@ read_handler_base85(void *baton, char *buffer, apr_size_t *len)
 
       if (b85b->next_pos >= b85b->end_pos)
         break; /* At EOF */
-      SVN_ERR(svn_io_file_seek(b85b->file, APR_SET, &b85b->next_pos,
-                               iterpool));
-      SVN_ERR(svn_io_file_readline(b85b->file, &line, NULL, &at_eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
+      SVN_ERR(source_readline(b85b->source, &b85b->next_pos, &line, NULL,
+                              &at_eof, APR_SIZE_MAX, iterpool, iterpool));
       if (at_eof)
         b85b->next_pos = b85b->end_pos;
-      else
-        {
-          SVN_ERR(svn_io_file_get_offset(&b85b->next_pos, b85b->file,
-                                         iterpool));
-        }
 
       if (line->len && line->data[0] >= 'A' && line->data[0] <= 'Z')
         b85b->buf_size = line->data[0] - 'A' + 1;
@@ -397,7 +510,7 @@ close_handler_base85(void *baton)
    The current implementation might assume that both start_pos and end_pos
    are located at line boundaries. */
 static svn_stream_t *
-get_base85_data_stream(apr_file_t *file,
+get_base85_data_stream(const patch_source_t *source,
                        apr_off_t start_pos,
                        apr_off_t end_pos,
                        apr_pool_t *result_pool)
@@ -405,7 +518,7 @@ get_base85_data_stream(apr_file_t *file,
   struct base85_baton_t *b85b = apr_pcalloc(result_pool, sizeof(*b85b));
   svn_stream_t *base85s = svn_stream_create(b85b, result_pool);
 
-  b85b->file = file;
+  b85b->source = source;
   b85b->iterpool = svn_pool_create(result_pool);
   b85b->next_pos = start_pos;
   b85b->end_pos = end_pos;
@@ -479,7 +592,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
                                          apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->src_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->src_start,
                                            bpatch->src_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -494,7 +607,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
                                        apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->dst_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->dst_start,
                                            bpatch->dst_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -638,7 +751,7 @@ parse_hunk_header(const char *header, svn_diff_hunk_t *hunk,
 }
 
 /* Read a line of original or modified hunk text from the specified
- * RANGE within FILE. FILE is expected to contain unidiff text.
+ * RANGE within SOURCE. SOURCE is expected to contain unidiff text.
  * Leading unidiff symbols ('+', '-', and ' ') are removed from the line,
  * Any lines commencing with the VERBOTEN character are discarded.
  * VERBOTEN should be '+' or '-', depending on which form of hunk text
@@ -649,7 +762,7 @@ parse_hunk_header(const char *header, svn_diff_hunk_t *hunk,
  * and svn_diff_hunk_readline_modified_text().
  */
 static svn_error_t *
-hunk_readline_original_or_modified(apr_file_t *file,
+hunk_readline_original_or_modified(const patch_source_t *source,
                                    struct svn_diff__hunk_range *range,
                                    svn_stringbuf_t **stringbuf,
                                    const char **eol,
@@ -661,7 +774,6 @@ hunk_readline_original_or_modified(apr_file_t *file,
 {
   apr_size_t max_len;
   svn_boolean_t filtered;
-  apr_off_t pos;
   svn_stringbuf_t *str;
   const char *eol_p;
   apr_pool_t *last_pool;
@@ -678,9 +790,6 @@ hunk_readline_original_or_modified(apr_file_t *file,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &range->current, scratch_pool));
-
   /* It's not ITERPOOL because we use data allocated in LAST_POOL out
      of the loop. */
   last_pool = svn_pool_create(scratch_pool);
@@ -689,9 +798,8 @@ hunk_readline_original_or_modified(apr_file_t *file,
       svn_pool_clear(last_pool);
 
       max_len = range->end - range->current;
-      SVN_ERR(svn_io_file_readline(file, &str, eol, eof, max_len,
-                                   last_pool, last_pool));
-      SVN_ERR(svn_io_file_get_offset(&range->current, file, last_pool));
+      SVN_ERR(source_readline(source, &range->current, &str, eol, eof,
+                              max_len, last_pool, last_pool));
       filtered = (str->data[0] == verboten || str->data[0] == '\\');
     }
   while (filtered && ! *eof);
@@ -725,19 +833,15 @@ hunk_readline_original_or_modified(apr_file_t *file,
         {
           apr_off_t start = 0;
 
-          SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
-
-          SVN_ERR(svn_io_file_readline(file, &str, eol, NULL, APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(source_readline(source, &start, &str, eol, NULL,
+                                  APR_SIZE_MAX, scratch_pool, scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
         }
 
       *eof = FALSE;
-      /* Fall through to seek back to the right location */
     }
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, scratch_pool));
 
   svn_pool_destroy(last_pool);
   return SVN_NO_ERROR;
@@ -752,7 +856,7 @@ svn_diff_hunk_readline_original_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->modified_text_range :
                                          &hunk->original_text_range,
@@ -773,7 +877,7 @@ svn_diff_hunk_readline_modified_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->original_text_range :
                                          &hunk->modified_text_range,
@@ -795,7 +899,6 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
 {
   svn_stringbuf_t *line;
   apr_size_t max_len;
-  apr_off_t pos;
   const char *eol_p;
 
   if (!eol)
@@ -810,15 +913,10 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, hunk->apr_file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET,
-                           &hunk->diff_text_range.current, scratch_pool));
   max_len = hunk->diff_text_range.end - hunk->diff_text_range.current;
-  SVN_ERR(svn_io_file_readline(hunk->apr_file, &line, eol, eof, max_len,
-                               result_pool,
-                   scratch_pool));
-  SVN_ERR(svn_io_file_get_offset(&hunk->diff_text_range.current,
-                                 hunk->apr_file, scratch_pool));
+  SVN_ERR(source_readline(hunk->source, &hunk->diff_text_range.current,
+                          &line, eol, eof, max_len,
+                          result_pool, scratch_pool));
 
   if (*eof && !*eol && *line->data)
     {
@@ -834,24 +932,16 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
           apr_off_t start = 0;
           svn_stringbuf_t *str;
 
-          SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &start,
-                                   scratch_pool));
-
-          SVN_ERR(svn_io_file_readline(hunk->apr_file, &str, eol, NULL,
-                                       APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(source_readline(hunk->source, &start, &str, eol, NULL,
+                                  APR_SIZE_MAX, scratch_pool, scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
         }
 
       *eof = FALSE;
-
-      /* Fall through to seek back to the right location */
     }
 
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &pos, scratch_pool));
-
   if (hunk->patch->reverse)
     {
       if (line->data[0] == '+')
@@ -1028,8 +1118,9 @@ parse_mergeinfo(svn_boolean_t *found_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-/* Return the next *HUNK from a PATCH in APR_FILE.
- * If no hunk can be found, set *HUNK to NULL.
+/* Return the next *HUNK from a PATCH in SOURCE, starting the search at
+ * byte offset *POS.  Set *POS to the offset at which parsing should
+ * continue.  If no hunk can be found, set *HUNK to NULL.
  * Set IS_PROPERTY to TRUE if we have a property hunk. If the returned HUNK
  * is the first belonging to a certain property, then PROP_NAME and
  * PROP_OPERATION will be set too. If we have a text hunk, PROP_NAME will be
@@ -1042,7 +1133,8 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                 const char **prop_name,
                 svn_diff_operation_kind_t *prop_operation,
                 svn_patch_t *patch,
-                apr_file_t *apr_file,
+                const patch_source_t *source,
+                apr_off_t *pos_p,
                 svn_boolean_t ignore_whitespace,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
@@ -1077,7 +1169,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   *prop_name = NULL;
   *is_property = FALSE;
 
-  if (apr_file_eof(apr_file) == APR_EOF)
+  if (*pos_p >= source->size)
     {
       /* No more hunks here. */
       *hunk = NULL;
@@ -1093,8 +1185,8 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   modified_end = 0;
   *hunk = apr_pcalloc(result_pool, sizeof(**hunk));
 
-  /* Get current seek position. */
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
+  /* Start at the given position. */
+  pos = *pos_p;
 
   /* Start out assuming noise. */
   last_line_type = noise_line;
@@ -1107,11 +1199,8 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
 
       /* Remember the current line's offset, and read the line. */
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                                   iterpool, iterpool));
-
-      /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      SVN_ERR(source_readline(source, &pos, &line, NULL, &eof, APR_SIZE_MAX,
+                              iterpool, iterpool));
 
       /* Lines starting with a backslash indicate a missing EOL:
        * "\ No newline at end of file" or "end of property". */
@@ -1128,10 +1217,8 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                * has no trailing EOL. Snip off trailing EOL which is part
                * of the patch file but not part of the hunk text. */
               off = last_line - 2;
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &off, iterpool));
               len = sizeof(eolbuf);
-              SVN_ERR(svn_io_file_read_full2(apr_file, eolbuf, len, &len,
-                                             &eof, iterpool));
+              SVN_ERR(source_read(source, off, eolbuf, &len, iterpool));
               if (eolbuf[0] == '\r' && eolbuf[1] == '\n')
                 hunk_text_end = last_line - 2;
               else if (eolbuf[1] == '\n' || eolbuf[1] == '\r')
@@ -1151,7 +1238,6 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                     modified_end = hunk_text_end;
                 }
 
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &pos, iterpool));
               /* Set for the type and context by using != the other type */
               if (last_line_type != modified_line)
                 original_no_final_eol = TRUE;
@@ -1350,7 +1436,9 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
     /* Rewind to the start of the line just read, so subsequent calls
      * to this function or svn_diff_parse_next_patch() don't end
      * up skipping the line -- it may contain a patch or hunk header. */
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
+    *pos_p = last_line;
+  else
+    *pos_p = pos;
 
   if (hunk_seen && start < end)
     {
@@ -1370,7 +1458,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
         }
 
       (*hunk)->patch = patch;
-      (*hunk)->apr_file = apr_file;
+      (*hunk)->source = source;
       (*hunk)->leading_context = leading_context;
       (*hunk)->trailing_context = trailing_context;
       (*hunk)->diff_text_range.start = start;
@@ -1909,8 +1997,13 @@ add_property_hunk(svn_patch_t *patch, const char *prop_name,
 
 struct svn_patch_file_t
 {
-  /* The APR file handle to the patch file. */
-  apr_file_t *apr_file;
+  /* The patch file and, if possible, its contents mapped into memory. */
+  patch_source_t source;
+
+#if APR_HAS_MMAP
+  /* The mmap context for SOURCE.DATA, or NULL if it is not mapped. */
+  apr_mmap_t *mm;
+#endif
 
   /* The file offset at which the next patch is expected. */
   apr_off_t next_patch_offset;
@@ -1922,26 +2015,48 @@ svn_diff_open_patch_file(svn_patch_file_t **patch_file,
                          apr_pool_t *result_pool)
 {
   svn_patch_file_t *p;
+  svn_filesize_t size;
 
-  p = apr_palloc(result_pool, sizeof(*p));
-  SVN_ERR(svn_io_file_open(&p->apr_file, local_abspath,
+  p = apr_pcalloc(result_pool, sizeof(*p));
+  SVN_ERR(svn_io_file_open(&p->source.apr_file, local_abspath,
                            APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
                            result_pool));
+  SVN_ERR(svn_io_file_size_get(&size, p->source.apr_file, result_pool));
+  p->source.size = size;
+
+#if APR_HAS_MMAP
+  /* Large patches are parsed and applied line by line, several times
+   * over.  Scanning them in memory is much faster than reading them
+   * byte by byte through the file handle.  If mapping fails, we simply
+   * fall back to reading the file. */
+  if (size > APR_MMAP_THRESHOLD && size <= APR_SIZE_MAX)
+    {
+      apr_status_t rv = apr_mmap_create(&p->mm, p->source.apr_file, 0,
+                                        (apr_size_t)size, APR_MMAP_READ,
+                                        result_pool);
+      if (rv == APR_SUCCESS)
+        p->source.data = p->mm->mm;
+      else
+        p->mm = NULL;
+    }
+#endif
+
   p->next_patch_offset = 0;
   *patch_file = p;
 
   return SVN_NO_ERROR;
 }
 
-/* Parse hunks from APR_FILE and store them in PATCH->HUNKS.
+/* Parse hunks from SOURCE, starting at byte offset *POS, and store them
+ * in PATCH->HUNKS.  Set *POS to the offset following the last hunk.
  * Parsing stops if no valid next hunk can be found.
  * If IGNORE_WHITESPACE is TRUE, lines without
  * leading spaces will be treated as context lines.
  * Allocate results in RESULT_POOL.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
-            svn_boolean_t ignore_whitespace,
+parse_hunks(svn_patch_t *patch, const patch_source_t *source,
+            apr_off_t *pos, svn_boolean_t ignore_whitespace,
             apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
   svn_diff_hunk_t *hunk;
@@ -1961,8 +2076,8 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
       svn_pool_clear(iterpool);
 
       SVN_ERR(parse_next_hunk(&hunk, &is_property, &prop_name, &prop_operation,
-                              patch, apr_file, ignore_whitespace, result_pool,
-                              iterpool));
+                              patch, source, pos, ignore_whitespace,
+                              result_pool, iterpool));
 
       if (hunk && is_property)
         {
@@ -1993,9 +2108,15 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
   return SVN_NO_ERROR;
 }
 
+/* Parse a git binary patch from SOURCE, starting at byte offset *POS_P,
+ * and store it in PATCH->BINARY_PATCH.  Set *POS_P to the offset at which
+ * parsing should continue.  If REVERSE is TRUE, swap the source and
+ * destination of the binary patch.
+ * Allocate results in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
-                   svn_boolean_t reverse,
+parse_binary_patch(svn_patch_t *patch, const patch_source_t *source,
+                   apr_off_t *pos_p, svn_boolean_t reverse,
                    apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
@@ -2006,20 +2127,17 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   svn_boolean_t in_blob = FALSE;
   svn_boolean_t in_src = FALSE;
 
-  bpatch->apr_file = apr_file;
+  bpatch->source = source;
 
   patch->prop_patches = apr_hash_make(result_pool);
 
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
+  pos = *pos_p;
 
   while (!eof)
     {
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                               iterpool, iterpool));
-
-      /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      SVN_ERR(source_readline(source, &pos, &line, NULL, &eof, APR_SIZE_MAX,
+                              iterpool, iterpool));
 
       if (in_blob)
         {
@@ -2086,9 +2204,12 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   if (!eof)
     /* Rewind to the start of the line just read, so subsequent calls
      * don't end up skipping the line. It may contain a patch or hunk header.*/
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
-  else if (in_src
-           && ((bpatch->src_end > bpatch->src_start) || !bpatch->src_filesize))
+    *pos_p = last_line;
+  else
+    *pos_p = pos;
+
+  if (eof && in_src
+      && ((bpatch->src_end > bpatch->src_start) || !bpatch->src_filesize))
     {
       patch->binary_patch = bpatch; /* SUCCESS */
     }
@@ -2167,7 +2288,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
   svn_patch_t *patch;
   enum parse_state state = state_start;
 
-  if (apr_file_eof(patch_file->apr_file) == APR_EOF)
+  if (patch_file->next_patch_offset >= patch_file->source.size)
     {
       /* No more patches here. */
       *patch_p = NULL;
@@ -2181,7 +2302,6 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
   patch->new_symlink_bit = svn_tristate_unknown;
 
   pos = patch_file->next_patch_offset;
-  SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &pos, scratch_pool));
 
   iterpool = svn_pool_create(scratch_pool);
   do
@@ -2194,15 +2314,8 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
 
       /* Remember the current line's offset, and read the line. */
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(patch_file->apr_file, &line, NULL, &eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
-
-      if (! eof)
-        {
-          /* Update line offset for next iteration. */
-          SVN_ERR(svn_io_file_get_offset(&pos, patch_file->apr_file,
-                                         iterpool));
-        }
+      SVN_ERR(source_readline(&patch_file->source, &pos, &line, NULL, &eof,
+                              APR_SIZE_MAX, iterpool, iterpool));
 
       /* Run the state machine. */
       for (i = 0; i < (sizeof(transitions) / sizeof(transitions[0])); i++)
@@ -2232,8 +2345,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            * Rewind to the start of the line just read, so subsequent calls
            * to this function don't end up skipping the line -- it may
            * contain a patch. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          pos = last_line;
           break;
         }
       else if (state == state_git_tree_seen
@@ -2248,8 +2360,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            *
            * Rewind to the start of the line just read - it may be a new
            * header that begins there. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          pos = last_line;
           state = state_start;
         }
 
@@ -2303,19 +2414,18 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
     {
       if (state == state_binary_patch_found)
         {
-          SVN_ERR(parse_binary_patch(patch, patch_file->apr_file, reverse,
-                                     result_pool, iterpool));
+          SVN_ERR(parse_binary_patch(patch, &patch_file->source, &pos,
+                                     reverse, result_pool, iterpool));
           /* And fall through in property parsing */
         }
 
-      SVN_ERR(parse_hunks(patch, patch_file->apr_file, ignore_whitespace,
-                          result_pool, iterpool));
+      SVN_ERR(parse_hunks(patch, &patch_file->source, &pos,
+                          ignore_whitespace, result_pool, iterpool));
     }
 
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_io_file_get_offset(&patch_file->next_patch_offset,
-                                 patch_file->apr_file, scratch_pool));
+  patch_file->next_patch_offset = pos;
 
   if (patch && patch->hunks)
     {
@@ -2334,6 +2444,29 @@ svn_error_t *
 svn_diff_close_patch_file(svn_patch_file_t *patch_file,
                           apr_pool_t *scratch_pool)
 {
-  return svn_error_trace(svn_io_file_close(patch_file->apr_file,
-                                           scratch_pool));
+  apr_file_t *apr_file = patch_file->source.apr_file;
+#if APR_HAS_MMAP
+  apr_mmap_t *mm = patch_file->mm;
+#endif
+
+  /* Hunks keep referring to our source.  Make sure they can't reach the
+   * mapping or the file handle anymore before we release them. */
+  patch_file->source.data = NULL;
+  patch_file->source.apr_file = NULL;
+
+#if APR_HAS_MMAP
+  patch_file->mm = NULL;
+  if (mm)
+    {
+      apr_status_t rv = apr_mmap_delete(mm);
+
+      if (rv != APR_SUCCESS)
+        return svn_error_compose_create(
+                 svn_error_wrap_apr(rv, _("Failed to delete mmap of patch "
+                                          "file")),
+                 svn_io_file_close(apr_file, scratch_pool));
+    }
+#endif
+
+  return svn_error_trace(svn_io_file_close(apr_file, scratch_pool));
 }
@@ -34,25 +34,29 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of slots in the token hash table is 2^SVN_DIFF__HASH_BITS.
+ * The table doubles whenever it becomes half full.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__HASH_BITS 7
+#define SVN_DIFF__HASH_SIZE (1u << SVN_DIFF__HASH_BITS)
 
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
   svn_diff__token_index_t index;
   void                   *token;
 };
 
+/* An open-addressing hash table with linear probing.  Slots with a NULL
+ * TOKEN are empty.  Keeping all nodes in one contiguous array avoids a
+ * pointer chase (and a likely cache miss) per tree level when looking up
+ * lines that occur many times.
+ */
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
+  svn_diff__node_t       *slots;
+  apr_uint32_t            capacity;
+  apr_uint32_t            shift;
   apr_pool_t             *pool;
   svn_diff__token_index_t node_count;
 };
@@ -77,6 +81,48 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
+  (*tree)->capacity = SVN_DIFF__HASH_SIZE;
+  (*tree)->shift = 32 - SVN_DIFF__HASH_BITS;
+  (*tree)->slots = apr_pcalloc(pool, SVN_DIFF__HASH_SIZE
+                                     * sizeof(*(*tree)->slots));
+}
+
+/* Return the home slot for HASH in TREE.  The token hashes are adler32
+ * checksums whose low bits are poorly distributed for short lines, so
+ * use multiplicative (Fibonacci) hashing to pick the top bits instead.
+ */
+static APR_INLINE apr_uint32_t
+home_slot(const svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  return (apr_uint32_t)(hash * 2654435761u) >> tree->shift;
+}
+
+/* Double the number of slots in TREE and re-insert all nodes.  No token
+ * comparisons are necessary since all nodes are known to be distinct.
+ */
+static void
+grow_tree(svn_diff__tree_t *tree)
+{
+  svn_diff__node_t *old_slots = tree->slots;
+  apr_uint32_t old_capacity = tree->capacity;
+  apr_uint32_t mask;
+  apr_uint32_t i;
+
+  tree->capacity *= 2;
+  tree->shift--;
+  tree->slots = apr_pcalloc(tree->pool,
+                            tree->capacity * sizeof(*tree->slots));
+  mask = tree->capacity - 1;
+
+  for (i = 0; i < old_capacity; i++)
+    if (old_slots[i].token)
+      {
+        apr_uint32_t slot = home_slot(tree, old_slots[i].hash);
+        while (tree->slots[slot].token)
+          slot = (slot + 1) & mask;
+
+        tree->slots[slot] = old_slots[i];
+      }
 }
 
 
@@ -86,57 +132,67 @@ tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
+  svn_diff__node_t *slot_node;
+  apr_uint32_t mask;
+  apr_uint32_t slot;
   int rv;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep the load factor at or below 1/2 so probe sequences stay short. */
+  if ((apr_uint32_t)tree->node_count >= tree->capacity / 2)
+    grow_tree(tree);
 
-  while (*node_ref != NULL)
-    {
-      parent = *node_ref;
+  mask = tree->capacity - 1;
+  slot = home_slot(tree, hash);
 
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+  for (slot_node = &tree->slots[slot];
+       slot_node->token != NULL;
+       slot = (slot + 1) & mask, slot_node = &tree->slots[slot])
+    {
+      if (slot_node->hash != hash)
+        continue;
 
+      SVN_ERR(vtable->token_compare(diff_baton, slot_node->token, token,
+                                    &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, slot_node->token);
 
-          parent->token = token;
-          *node = parent;
+          slot_node->token = token;
+          *node = slot_node;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  /* Fill the empty slot */
+  slot_node->hash = hash;
+  slot_node->token = token;
+  slot_node->index = tree->node_count++;
+
+  *node = slot_node;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_diff__get_token_index(svn_diff__token_index_t *token_index,
+                          svn_diff__tree_t *tree,
+                          void *diff_baton,
+                          const svn_diff_fns2_t *vtable,
+                          apr_uint32_t hash,
+                          void *token)
+{
+  svn_diff__node_t *node;
 
-  *node = *node_ref = new_node;
+  SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+  *token_index = node->index;
 
   return SVN_NO_ERROR;
 }
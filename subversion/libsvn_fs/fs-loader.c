@@ -49,6 +49,7 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #include "fs-loader.h"
 
@@ -521,6 +522,72 @@ svn_fs_set_warning_func(svn_fs_t *fs, svn_fs_warning_callback_t warning,
   fs->warning_baton = warning_baton;
 }
 
+void
+svn_fs__warn(svn_fs_t *fs, svn_error_t *err)
+{
+  fs->warning(fs->warning_baton, err);
+}
+
+svn_error_t *
+svn_fs__sync(svn_fs_t *fs,
+             svn_boolean_t defer,
+             apr_pool_t *scratch_pool)
+{
+  if (!fs->vtable->sync)
+    {
+      if (defer)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("Deferred flushing is not supported "
+                                   "by filesystem '%s'"),
+                                 svn_dirent_local_style(fs->path,
+                                                        scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->sync(fs, defer, scratch_pool));
+}
+
+svn_error_t *
+svn_fs__set_io_stats(svn_fs_t *fs,
+                     svn_boolean_t enabled,
+                     svn_stream_t *trace,
+                     apr_pool_t *scratch_pool)
+{
+  if (!fs->vtable->set_io_stats)
+    {
+      if (enabled)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("I/O statistics are not supported "
+                                   "by filesystem '%s'"),
+                                 svn_dirent_local_style(fs->path,
+                                                        scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->set_io_stats(fs, enabled, trace,
+                                                  scratch_pool));
+}
+
+svn_error_t *
+svn_fs__get_io_stats(svn_fs__io_stats_t **stats,
+                     svn_fs_t *fs,
+                     svn_boolean_t reset,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  if (!fs->vtable->get_io_stats)
+    {
+      *stats = apr_pcalloc(result_pool, sizeof(**stats));
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->get_io_stats(stats, fs, reset,
+                                                  result_pool,
+                                                  scratch_pool));
+}
+
 svn_error_t *
 svn_fs_create2(svn_fs_t **fs_p,
                const char *path,
@@ -555,16 +622,62 @@ svn_fs_open2(svn_fs_t **fs_p, const char *path, apr_hash_t *fs_config,
              apr_pool_t *scratch_pool)
 {
   fs_library_vtable_t *vtable;
+  svn_trace__span_t *span;
 
   SVN_ERR(fs_library_vtable(&vtable, path, scratch_pool));
   *fs_p = fs_new(fs_config, result_pool);
-  SVN_ERR(vtable->open_fs(*fs_p, path, common_pool_lock, scratch_pool,
-                          common_pool));
+
+  span = svn_trace__begin("fs.open");
+  svn_trace__attr(span, "path", path);
+  SVN_ERR(svn_trace__end(span,
+                         vtable->open_fs(*fs_p, path, common_pool_lock,
+                                         scratch_pool, common_pool)));
   SVN_ERR(vtable->set_svn_fs_open(*fs_p, svn_fs_open2));
 
   return SVN_NO_ERROR;
 }
 
+struct svn_fs_shared_t
+{
+  /* The filesystem that all views get opened from.  It is never used to
+     access the repository and never modified. */
+  svn_fs_t *fs;
+};
+
+svn_error_t *
+svn_fs_open_shared(svn_fs_shared_t **shared_p,
+                   const char *path,
+                   apr_hash_t *fs_config,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_shared_t *shared = apr_pcalloc(result_pool, sizeof(*shared));
+
+  SVN_ERR(svn_fs_open2(&shared->fs, path, fs_config, result_pool,
+                       scratch_pool));
+  *shared_p = shared;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_open_view(svn_fs_t **fs_p,
+                 svn_fs_shared_t *shared,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = shared->fs;
+
+  if (!fs->vtable->open_view)
+    return svn_error_trace(svn_fs_open2(fs_p, fs->path, fs->config,
+                                        result_pool, scratch_pool));
+
+  *fs_p = fs_new(fs->config, result_pool);
+  SVN_ERR(fs->vtable->open_view(*fs_p, fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_upgrade2(const char *path,
                 svn_fs_upgrade_notify_t notify_func,
@@ -710,18 +823,19 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_pack2(const char *path,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
 
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
-  fs = fs_new(NULL, pool);
+  fs = fs_new(fs_config, pool);
 
   SVN_ERR(vtable->pack_fs(fs, path, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
@@ -730,15 +844,16 @@ svn_fs_pack(const char *path,
 }
 
 svn_error_t *
-svn_fs_recover(const char *path,
-               svn_cancel_func_t cancel_func, void *cancel_baton,
-               apr_pool_t *pool)
+svn_fs_recover2(const char *path,
+                apr_hash_t *fs_config,
+                svn_cancel_func_t cancel_func, void *cancel_baton,
+                apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
 
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
-  fs = fs_new(NULL, pool);
+  fs = fs_new(fs_config, pool);
 
   SVN_ERR(vtable->open_fs_for_recovery(fs, path, common_pool_lock,
                                        pool, common_pool));
@@ -824,7 +939,7 @@ svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
 svn_error_t *
 svn_fs_berkeley_recover(const char *path, apr_pool_t *pool)
 {
-  return svn_error_trace(svn_fs_recover(path, NULL, NULL, pool));
+  return svn_error_trace(svn_fs_recover2(path, NULL, NULL, NULL, pool));
 }
 
 svn_error_t *
@@ -1059,7 +1174,31 @@ svn_error_t *
 svn_fs_path_change_get(svn_fs_path_change3_t **change,
                        svn_fs_path_change_iterator_t *iterator)
 {
-  return iterator->vtable->get(change, iterator);
+  SVN_ERR(iterator->vtable->get(change, iterator));
+
+  /* Filter on behalf of FSAPs that don't implement SEEK. */
+  if (iterator->path)
+    while (   *change
+           && !svn_fspath__skip_ancestor(iterator->path,
+                                         (*change)->path.data))
+      SVN_ERR(iterator->vtable->get(change, iterator));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_path_change_seek(svn_fs_path_change_iterator_t *iterator,
+                        const char *path,
+                        apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_fspath__is_canonical(path));
+
+  if (iterator->vtable->seek)
+    return svn_error_trace(iterator->vtable->seek(iterator, path,
+                                                  scratch_pool));
+
+  iterator->path = path;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1458,8 +1597,12 @@ svn_error_t *
 svn_fs_dir_entries(apr_hash_t **entries_p, svn_fs_root_t *root,
                    const char *path, apr_pool_t *pool)
 {
-  return svn_error_trace(root->vtable->dir_entries(entries_p, root, path,
-                                                   pool));
+  svn_trace__span_t *span = svn_trace__begin("fs.dir_entries");
+  svn_trace__attr(span, "path", path);
+
+  return svn_error_trace(
+           svn_trace__end(span, root->vtable->dir_entries(entries_p, root,
+                                                          path, pool)));
 }
 
 svn_error_t *
@@ -1539,8 +1682,14 @@ svn_error_t *
 svn_fs_file_contents(svn_stream_t **contents, svn_fs_root_t *root,
                      const char *path, apr_pool_t *pool)
 {
-  return svn_error_trace(root->vtable->file_contents(contents, root, path,
-                                                     pool));
+  /* This only covers locating the contents.  The actual reading happens
+     later through the returned stream. */
+  svn_trace__span_t *span = svn_trace__begin("fs.file_contents");
+  svn_trace__attr(span, "path", path);
+
+  return svn_error_trace(
+           svn_trace__end(span, root->vtable->file_contents(contents, root,
+                                                            path, pool)));
 }
 
 svn_error_t *
@@ -1564,6 +1713,27 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs__file_contents_ranges(const char **file_path,
+                             apr_array_header_t **ranges,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  *file_path = NULL;
+  *ranges = NULL;
+
+  if (root->vtable->file_contents_ranges == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(root->vtable->file_contents_ranges(file_path,
+                                                            ranges,
+                                                            root, path,
+                                                            result_pool,
+                                                            scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1669,6 +1839,52 @@ svn_fs_deltify_revision(svn_fs_t *fs, svn_revnum_t revision, apr_pool_t *pool)
   return svn_error_trace(fs->vtable->deltify(fs, revision, pool));
 }
 
+svn_error_t *
+svn_fs_subtree_changed(svn_boolean_t *changed,
+                       svn_fs_t *fs,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       apr_pool_t *scratch_pool)
+{
+  /* Without further information, every path may have changed. */
+  if (!fs->vtable->subtree_changed)
+    {
+      *changed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->subtree_changed(
+                           changed, fs,
+                           svn_fs__canonicalize_abspath(path, scratch_pool),
+                           start, end, scratch_pool));
+}
+
+svn_error_t *
+svn_fs_build_rep_cache(svn_fs_t *fs,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       svn_fs_progress_notify_func_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  if (!fs->vtable->build_rep_cache)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Filesystem '%s' does not support "
+                               "rep-sharing"),
+                             svn_dirent_local_style(fs->path,
+                                                    scratch_pool));
+
+  return svn_error_trace(fs->vtable->build_rep_cache(fs, start_rev, end_rev,
+                                                     notify_func,
+                                                     notify_baton,
+                                                     cancel_func,
+                                                     cancel_baton,
+                                                     scratch_pool));
+}
+
 svn_error_t *
 svn_fs_refresh_revision_props(svn_fs_t *fs,
                               apr_pool_t *scratch_pool)
@@ -1705,6 +1921,44 @@ svn_fs_revision_proplist2(apr_hash_t **table_p,
                                                        scratch_pool));
 }
 
+svn_error_t *
+svn_fs_revision_proplist_range(svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_boolean_t refresh,
+                               svn_fs_revision_proplist_receiver_t receiver,
+                               void *receiver_baton,
+                               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  if (fs->vtable->revision_proplist_range)
+    return svn_error_trace(fs->vtable->revision_proplist_range(
+                             fs, start, end, refresh,
+                             receiver, receiver_baton, scratch_pool));
+
+  /* Fall back to reading the revisions one by one.  A single read
+     barrier at the start of the range is enough. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start; ; rev += (start <= end) ? 1 : -1)
+    {
+      apr_hash_t *proplist;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(fs->vtable->revision_proplist(&proplist, fs, rev,
+                                            refresh && rev == start,
+                                            iterpool, iterpool));
+      SVN_ERR(receiver(receiver_baton, rev, proplist, iterpool));
+
+      if (rev == end)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_change_rev_prop2(svn_fs_t *fs, svn_revnum_t rev, const char *name,
                         const svn_string_t *const *old_value_p,
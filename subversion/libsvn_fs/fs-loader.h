@@ -28,6 +28,7 @@
 #include "svn_types.h"
 #include "svn_fs.h"
 #include "svn_props.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_mutex.h"
 
 #ifdef __cplusplus
@@ -207,6 +208,15 @@ typedef struct fs_vtable_t
                                     svn_boolean_t refresh,
                                     apr_pool_t *result_pool, 
                                     apr_pool_t *scratch_pool);
+  /* May be NULL, in which case the loader uses revision_proplist. */
+  svn_error_t *(*revision_proplist_range)(
+                         svn_fs_t *fs,
+                         svn_revnum_t start,
+                         svn_revnum_t end,
+                         svn_boolean_t refresh,
+                         svn_fs_revision_proplist_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *scratch_pool);
   svn_error_t *(*change_rev_prop)(svn_fs_t *fs, svn_revnum_t rev,
                                   const char *name,
                                   const svn_string_t *const *old_value_p,
@@ -226,6 +236,11 @@ typedef struct fs_vtable_t
   svn_error_t *(*list_transactions)(apr_array_header_t **names_p,
                                     svn_fs_t *fs, apr_pool_t *pool);
   svn_error_t *(*deltify)(svn_fs_t *fs, svn_revnum_t rev, apr_pool_t *pool);
+  /* May be NULL, in which case the loader reports all paths as changed. */
+  svn_error_t *(*subtree_changed)(svn_boolean_t *changed, svn_fs_t *fs,
+                                  const char *path, svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *scratch_pool);
   svn_error_t *(*lock)(svn_fs_t *fs,
                        apr_hash_t *targets,
                        const char *comment, svn_boolean_t is_dav_comment,
@@ -266,6 +281,31 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  /* May be NULL, in which case flushes cannot be deferred. */
+  svn_error_t *(*sync)(svn_fs_t *fs, svn_boolean_t defer,
+                       apr_pool_t *scratch_pool);
+  /* May be NULL, in which case no I/O statistics get collected. */
+  svn_error_t *(*set_io_stats)(svn_fs_t *fs, svn_boolean_t enabled,
+                               svn_stream_t *trace,
+                               apr_pool_t *scratch_pool);
+  svn_error_t *(*get_io_stats)(svn_fs__io_stats_t **stats, svn_fs_t *fs,
+                               svn_boolean_t reset,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+  /* May be NULL, in which case there is no rep-cache to build. */
+  svn_error_t *(*build_rep_cache)(svn_fs_t *fs, svn_revnum_t start_rev,
+                                  svn_revnum_t end_rev,
+                                  svn_fs_progress_notify_func_t notify_func,
+                                  void *notify_baton,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *scratch_pool);
+  /* May be NULL, in which case views get opened like any other FS.
+     Otherwise, set up VIEW, which only has its pool and config set, for
+     the same repository as FS.  FS may be used by other threads at the
+     same time and must not be modified. */
+  svn_error_t *(*open_view)(svn_fs_t *view, svn_fs_t *fs,
+                            apr_pool_t *scratch_pool);
 } fs_vtable_t;
 
 
@@ -387,6 +427,13 @@ typedef struct root_vtable_t
                                             svn_fs_process_contents_func_t processor,
                                             void* baton,
                                             apr_pool_t *pool);
+  /* May be NULL, in which case no contents are considered verbatim. */
+  svn_error_t *(*file_contents_ranges)(const char **file_path,
+                                       apr_array_header_t **ranges,
+                                       svn_fs_root_t *root,
+                                       const char *path,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool);
   svn_error_t *(*make_file)(svn_fs_root_t *root, const char *path,
                             apr_pool_t *pool);
   svn_error_t *(*apply_textdelta)(svn_txdelta_window_handler_t *contents_p,
@@ -434,6 +481,12 @@ typedef struct changes_iterator_vtable_t
 {
   svn_error_t *(*get)(svn_fs_path_change3_t **change,
                       svn_fs_path_change_iterator_t *iterator);
+
+  /* Optional.  If NULL, svn_fs_path_change_seek will filter the
+     changes returned by GET instead. */
+  svn_error_t *(*seek)(svn_fs_path_change_iterator_t *iterator,
+                       const char *path,
+                       apr_pool_t *scratch_pool);
 } changes_iterator_vtable_t;
 
 
@@ -544,6 +597,10 @@ struct svn_fs_path_change_iterator_t
   /* FSAP-specific vtable and private data */
   const changes_iterator_vtable_t *vtable;
   void *fsap_data;
+
+  /* If not NULL, report only changes at or below this path.
+     Only used if VTABLE does not implement SEEK. */
+  const char *path;
 };
 
 struct svn_fs_history_t
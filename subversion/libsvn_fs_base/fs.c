@@ -555,6 +555,7 @@ static fs_vtable_t fs_vtable = {
   base_bdb_refresh_revision,
   svn_fs_base__revision_prop,
   svn_fs_base__revision_proplist,
+  NULL /* revision_proplist_range */,
   svn_fs_base__change_rev_prop,
   svn_fs_base__set_uuid,
   svn_fs_base__revision_root,
@@ -563,6 +564,7 @@ static fs_vtable_t fs_vtable = {
   svn_fs_base__purge_txn,
   svn_fs_base__list_transactions,
   svn_fs_base__deltify,
+  NULL /* subtree_changed */,
   svn_fs_base__lock,
   svn_fs_base__generate_lock_token,
   svn_fs_base__unlock,
@@ -574,6 +576,11 @@ static fs_vtable_t fs_vtable = {
   base_bdb_verify_root,
   base_bdb_freeze,
   base_bdb_set_errcall,
+  NULL /* sync */,
+  NULL /* set_io_stats */,
+  NULL /* get_io_stats */,
+  NULL /* build_rep_cache */,
+  NULL /* open_view */
 };
 
 /* Where the format number is stored. */
@@ -36,10 +36,12 @@
 #include "fs_fs.h"
 #include "id.h"
 #include "index.h"
+#include "io_stats.h"
 #include "low_level.h"
 #include "pack.h"
 #include "util.h"
 #include "temp_serializer.h"
+#include "warmup.h"
 
 #include "../libsvn_fs/fs-loader.h"
 #include "../libsvn_delta/delta.h"  /* for SVN_DELTA_WINDOW_SIZE */
@@ -56,12 +58,20 @@ block_read(void **result,
            apr_pool_t *result_pool,
            apr_pool_t *scratch_pool);
 
+static svn_error_t *
+verify_item_checksum(const svn_fs_fs__p2l_entry_t *entry,
+                     const char *data,
+                     apr_size_t len,
+                     apr_pool_t *pool);
+
 
 /* Define this to enable access logging via dbg_log_access
 #define SVN_FS_FS__LOG_ACCESS
  */
 
-/* When SVN_FS_FS__LOG_ACCESS has been defined, write a line to console
+/* Count the item access in the I/O statistics of FS.
+ *
+ * When SVN_FS_FS__LOG_ACCESS has been defined, also write a line to console
  * showing where REVISION, ITEM_INDEX is located in FS and use ITEM to
  * show details on it's contents if not NULL.  To support format 6 and
  * earlier repos, ITEM_TYPE (SVN_FS_FS__ITEM_TYPE_*) must match ITEM.
@@ -190,6 +200,8 @@ dbg_log_access(svn_fs_t *fs,
 
 #endif
 
+  svn_fs_fs__io_stats_item(fs);
+
   return SVN_NO_ERROR;
 }
 
@@ -530,9 +542,280 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                          SVN_FS_FS__ITEM_TYPE_NODEREV,
                          scratch_pool));
 
+  if (!err && !svn_fs_fs__id_is_txn(id))
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      if (ffd->cache_warmup)
+        svn_fs_fs__warmup_record(fs, rev_item, (*noderev_p)->kind,
+                                 scratch_pool);
+    }
+
   return svn_error_trace(err);
 }
 
+/* Noderevs to read from the same rev / pack file in one batch. */
+typedef struct noderev_batch_t
+{
+  /* The rev / pack file to read from. */
+  svn_fs_fs__revision_file_t *rev_file;
+
+  /* svn_fs_fs__id_part_t (revision, item index) of all noderevs to read. */
+  apr_array_header_t *items;
+
+  /* Positions within the caller's VALUES array, matching the ITEMS. */
+  apr_array_header_t *item_indexes;
+
+  /* svn_fs_fs__read_request_t for each noderev found in the P2L index. */
+  apr_array_header_t *requests;
+
+  /* svn_fs_fs__p2l_entry_t * matching the REQUESTS. */
+  apr_array_header_t *entries;
+
+  /* Positions within the caller's VALUES array, matching the REQUESTS. */
+  apr_array_header_t *indexes;
+} noderev_batch_t;
+
+/* For all IDS in FS whose noderevs are not marked as FOUND, read those
+ * noderevs in batches, one per rev / pack file, and store them at the
+ * respective positions in VALUES.  Cache the noderevs read, if caching
+ * has been enabled.  This requires FS to use logical addressing.
+ * Noderevs that can't be found that way will be left as NULL in VALUES.
+ * Allocate the noderevs in RESULT_POOL and temporaries in SCRATCH_POOL.
+ */
+static svn_error_t *
+read_node_revisions_batched(void **values,
+                            const svn_boolean_t *found,
+                            svn_fs_t *fs,
+                            const apr_array_header_t *ids,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *batches = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+  int i;
+
+  /* Sort all items into batches. */
+  for (i = 0; i < ids->nelts; ++i)
+    {
+      const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+      const svn_fs_fs__id_part_t *rev_item;
+      noderev_batch_t *batch;
+      svn_revnum_t base_rev;
+
+      if (found[i] || svn_fs_fs__id_is_txn(id))
+        continue;
+
+      svn_pool_clear(iterpool);
+      rev_item = svn_fs_fs__id_rev_item(id);
+      SVN_ERR(svn_fs_fs__ensure_revision_exists(rev_item->revision, fs,
+                                                iterpool));
+
+      base_rev = svn_fs_fs__packed_base_rev(fs, rev_item->revision);
+      batch = apr_hash_get(batches, &base_rev, sizeof(base_rev));
+      if (batch == NULL)
+        {
+          svn_revnum_t *key = apr_pmemdup(scratch_pool, &base_rev,
+                                          sizeof(base_rev));
+
+          batch = apr_pcalloc(scratch_pool, sizeof(*batch));
+          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&batch->rev_file, fs,
+                                                   rev_item->revision,
+                                                   scratch_pool, iterpool));
+          batch->items = apr_array_make(scratch_pool, 4,
+                                        sizeof(svn_fs_fs__id_part_t));
+          batch->item_indexes = apr_array_make(scratch_pool, 4, sizeof(int));
+          batch->requests = apr_array_make(scratch_pool, 4,
+                                           sizeof(svn_fs_fs__read_request_t));
+          batch->entries = apr_array_make(scratch_pool, 4,
+                                          sizeof(svn_fs_fs__p2l_entry_t *));
+          batch->indexes = apr_array_make(scratch_pool, 4, sizeof(int));
+          apr_hash_set(batches, key, sizeof(*key), batch);
+        }
+
+      APR_ARRAY_PUSH(batch->items, svn_fs_fs__id_part_t) = *rev_item;
+      APR_ARRAY_PUSH(batch->item_indexes, int) = i;
+    }
+
+  /* Locate all items.  The P2L index tells us exactly how many bytes to
+   * read for each of them. */
+  for (hi = apr_hash_first(scratch_pool, batches); hi; hi = apr_hash_next(hi))
+    {
+      noderev_batch_t *batch = apr_hash_this_val(hi);
+      int count = batch->items->nelts;
+      apr_off_t *offsets = apr_palloc(scratch_pool,
+                                      count * sizeof(*offsets));
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__item_offsets(offsets, fs, batch->rev_file,
+                                      (const svn_fs_fs__id_part_t *)
+                                        batch->items->elts,
+                                      count, iterpool));
+
+      for (i = 0; i < count; ++i)
+        {
+          const svn_fs_fs__id_part_t *rev_item
+            = &APR_ARRAY_IDX(batch->items, i, svn_fs_fs__id_part_t);
+          svn_fs_fs__p2l_entry_t *entry;
+          svn_fs_fs__read_request_t *request;
+
+          SVN_ERR(svn_fs_fs__p2l_entry_lookup(&entry, fs, batch->rev_file,
+                                              rev_item->revision,
+                                              offsets[i],
+                                              scratch_pool, iterpool));
+          if (   entry == NULL
+              || entry->type != SVN_FS_FS__ITEM_TYPE_NODEREV
+              || entry->item.revision != rev_item->revision
+              || entry->item.number != rev_item->number)
+            continue;
+
+          request = apr_array_push(batch->requests);
+          request->offset = entry->offset;
+          request->size = (apr_size_t)entry->size;
+          request->data = NULL;
+          APR_ARRAY_PUSH(batch->entries, svn_fs_fs__p2l_entry_t *) = entry;
+          APR_ARRAY_PUSH(batch->indexes, int)
+            = APR_ARRAY_IDX(batch->item_indexes, i, int);
+        }
+    }
+
+  /* Fetch and parse each batch. */
+  for (hi = apr_hash_first(scratch_pool, batches); hi; hi = apr_hash_next(hi))
+    {
+      noderev_batch_t *batch = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__rev_file_read_many(batch->rev_file, batch->requests,
+                                            iterpool, iterpool));
+
+      for (i = 0; i < batch->requests->nelts; ++i)
+        {
+          svn_fs_fs__read_request_t *request
+            = &APR_ARRAY_IDX(batch->requests, i, svn_fs_fs__read_request_t);
+          svn_fs_fs__p2l_entry_t *entry
+            = APR_ARRAY_IDX(batch->entries, i, svn_fs_fs__p2l_entry_t *);
+          int index = APR_ARRAY_IDX(batch->indexes, i, int);
+          node_revision_t *noderev;
+          svn_string_t text;
+
+          SVN_ERR(verify_item_checksum(entry, request->data, request->size,
+                                       iterpool));
+
+          text.data = request->data;
+          text.len = request->size;
+          SVN_ERR(svn_fs_fs__read_noderev(&noderev,
+                                          svn_stream_from_string(&text,
+                                                                 iterpool),
+                                          result_pool, iterpool));
+          SVN_ERR(fixup_node_revision(fs, noderev, iterpool));
+
+          if (ffd->node_revision_cache)
+            {
+              pair_cache_key_t key = { 0 };
+              key.revision = entry->item.revision;
+              key.second = entry->item.number;
+              SVN_ERR(svn_cache__set(ffd->node_revision_cache, &key,
+                                     noderev, iterpool));
+            }
+
+          values[index] = noderev;
+        }
+
+      SVN_ERR(svn_fs_fs__close_revision_file(batch->rev_file));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int count = ids->nelts;
+  const void **keys = apr_pcalloc(scratch_pool, count * sizeof(*keys));
+  void **values = apr_pcalloc(scratch_pool, count * sizeof(*values));
+  svn_boolean_t *found = apr_pcalloc(scratch_pool, count * sizeof(*found));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *noderevs = apr_array_make(result_pool, count, sizeof(node_revision_t *));
+
+  /* Look up all committed noderevs in the cache with a single call.
+   * Keys for txn nodes remain NULL and will never be found. */
+  if (ffd->node_revision_cache)
+    {
+      for (i = 0; i < count; ++i)
+        {
+          const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+          if (!svn_fs_fs__id_is_txn(id))
+            {
+              const svn_fs_fs__id_part_t *rev_item
+                = svn_fs_fs__id_rev_item(id);
+              pair_cache_key_t *key = apr_pcalloc(scratch_pool,
+                                                  sizeof(*key));
+              key->revision = rev_item->revision;
+              key->second = rev_item->number;
+              keys[i] = key;
+            }
+        }
+
+      SVN_ERR(svn_cache__get_many(values, found, ffd->node_revision_cache,
+                                  keys, count, result_pool, scratch_pool));
+    }
+
+  /* Read the remaining noderevs in batches where we know their exact
+   * location.  Single misses are better served by block-read as that
+   * will also cache the neighboring items. */
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      int missing = 0;
+      for (i = 0; i < count; ++i)
+        if (!found[i])
+          ++missing;
+
+      if (missing > 1)
+        SVN_ERR(read_node_revisions_batched(values, found, fs, ids,
+                                            result_pool, scratch_pool));
+    }
+
+  /* Fill the gaps the usual way. */
+  for (i = 0; i < count; ++i)
+    {
+      const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+      node_revision_t *noderev = values[i];
+
+      svn_pool_clear(iterpool);
+      if (found[i])
+        {
+          const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
+          SVN_ERR(dbg_log_access(fs,
+                                 rev_item->revision,
+                                 rev_item->number,
+                                 noderev,
+                                 SVN_FS_FS__ITEM_TYPE_NODEREV,
+                                 iterpool));
+        }
+      else if (noderev == NULL)
+        {
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id,
+                                               result_pool, iterpool));
+        }
+
+      APR_ARRAY_PUSH(*noderevs, node_revision_t *) = noderev;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Given a revision file REV_FILE, opened to REV in FS, find the Node-ID
    of the header located at OFFSET and store it in *ID_P.  Allocate
@@ -633,6 +916,7 @@ get_root_changes_offset(apr_off_t *root_offset,
   SVN_ERR(aligned_seek(fs, rev_file->file, NULL, start, pool));
   SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, len, NULL, NULL,
                                  pool));
+  svn_fs_fs__io_stats_read(rev_file, start, len);
 
   /* Parse the last line. */
   trailer = svn_stringbuf_ncreate(buffer, len, pool);
@@ -807,10 +1091,19 @@ auto_read_diff_version(rep_state_t *rs, apr_pool_t *pool)
 {
   if (rs->ver == -1)
     {
-      char buf[4];
-      SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
-      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                     sizeof(buf), NULL, NULL, pool));
+      char buffer[4];
+      const char *buf = svn_fs_fs__rev_file_mapped_data(rs->sfile->rfile,
+                                                        rs->start,
+                                                        sizeof(buffer));
+      if (buf == NULL)
+        {
+          SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
+          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buffer,
+                                         sizeof(buffer), NULL, NULL, pool));
+          svn_fs_fs__io_stats_read(rs->sfile->rfile, rs->start,
+                                   sizeof(buffer));
+          buf = buffer;
+        }
 
       /* ### Layering violation */
       if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
@@ -1541,6 +1834,98 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *WINDOW_LEN to the on-disk length of the txdelta window that starts
+   at the current position in RS, reading its header from the mapped file
+   contents.  Set *WINDOW_LEN to 0, if the window is not fully contained in
+   the mapped data.  Return the window data in *DATA.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+get_mapped_window(const char **data,
+                  apr_size_t *window_len,
+                  rep_state_t *rs,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file = rs->sfile->rfile;
+  svn_string_t rep_data;
+  svn_stream_t *stream;
+
+  /* The remainder of the representation. */
+  rep_data.len = (apr_size_t)(rs->size - rs->current);
+  rep_data.data = svn_fs_fs__rev_file_mapped_data(rev_file,
+                                                  rs->start + rs->current,
+                                                  rep_data.len);
+  *window_len = 0;
+  *data = rep_data.data;
+  if (rep_data.data == NULL)
+    return SVN_NO_ERROR;
+
+  stream = svn_stream_from_string(&rep_data, scratch_pool);
+  SVN_ERR(svn_txdelta__read_raw_window_len(window_len, stream,
+                                           scratch_pool));
+
+  if (*window_len > rep_data.len)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Reading one svndiff window read beyond "
+                              "the end of the representation"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement read_delta_window() for mapped rev / pack files:  Skip
+   forwards to THIS_CHUNK in REP_STATE and then parse the next delta
+   window from the mapped data into *NWIN.  If the data could not be
+   found in the mapped range, set *FOUND to FALSE and leave RS in a
+   consistent state such that the caller may fall back to file access.
+   Allocate the window in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+read_mapped_delta_window(svn_txdelta_window_t **nwin,
+                         svn_boolean_t *found,
+                         int this_chunk,
+                         rep_state_t *rs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_string_t window_data;
+  apr_size_t window_len;
+  svn_stream_t *stream;
+
+  *found = FALSE;
+
+  /* Skip windows to reach the current chunk if we aren't there yet.
+     We only need to parse the window headers for that. */
+  while (rs->chunk_index < this_chunk)
+    {
+      SVN_ERR(get_mapped_window(&window_data.data, &window_len, rs,
+                                scratch_pool));
+      if (window_len == 0)
+        return SVN_NO_ERROR;
+
+      rs->chunk_index++;
+      rs->current += window_len;
+      if (rs->current >= rs->size)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Reading one svndiff window read "
+                                  "beyond the end of the "
+                                  "representation"));
+    }
+
+  /* Parse the actual window directly from the mapped data. */
+  SVN_ERR(get_mapped_window(&window_data.data, &window_len, rs,
+                            scratch_pool));
+  if (window_len == 0)
+    return SVN_NO_ERROR;
+
+  window_data.len = window_len;
+  stream = svn_stream_from_string(&window_data, scratch_pool);
+  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, stream, rs->ver,
+                                          result_pool));
+  rs->current += window_len;
+  *found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Skip forwards to THIS_CHUNK in REP_STATE and then read the next delta
    window into *NWIN.  Note that RS->CHUNK_INDEX will be THIS_CHUNK rather
    than THIS_CHUNK + 1 when this function returns. */
@@ -1592,6 +1977,21 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
   SVN_ERR(auto_read_diff_version(rs, scratch_pool));
 
+  /* Parse directly from the file contents, if they are mapped. */
+  if (rs->sfile->rfile->mapped_data)
+    {
+      svn_boolean_t found;
+      SVN_ERR(read_mapped_delta_window(nwin, &found, this_chunk, rs,
+                                       result_pool, scratch_pool));
+      if (found)
+        {
+          if (SVN_IS_VALID_REVNUM(rs->revision))
+            SVN_ERR(set_cached_window(*nwin, rs, scratch_pool));
+
+          return SVN_NO_ERROR;
+        }
+    }
+
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
   start_offset = rs->start + rs->current;
@@ -1640,6 +2040,7 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
                   apr_pool_t *scratch_pool)
 {
   apr_off_t offset;
+  const char *data;
 
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
@@ -1647,13 +2048,23 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
+  data = svn_fs_fs__rev_file_mapped_data(rs->sfile->rfile, offset, size);
 
   /* Read the plain data. */
-  *nwin = svn_stringbuf_create_ensure(size, result_pool);
-  SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data, size,
-                                 NULL, NULL, result_pool));
-  (*nwin)->data[size] = 0;
+  if (data)
+    {
+      *nwin = svn_stringbuf_ncreate(data, size, result_pool);
+    }
+  else
+    {
+      SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
+
+      *nwin = svn_stringbuf_create_ensure(size, result_pool);
+      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data,
+                                     size, NULL, NULL, result_pool));
+      (*nwin)->data[size] = 0;
+      svn_fs_fs__io_stats_read(rs->sfile->rfile, offset, size);
+    }
 
   /* Update RS. */
   rs->current += (apr_off_t)size;
@@ -1672,6 +2083,80 @@ skip_plain_window(rep_state_t *rs,
   return SVN_NO_ERROR;
 }
 
+/* Upper limit for the number of bytes per rep that we ask the OS to
+   prefetch for the next delta window.  Windows cover at most
+   SVN_DELTA_WINDOW_SIZE bytes of fulltext and their on-disk size is
+   rarely larger than that.  Everything beyond the limit will simply
+   be read on demand. */
+#define PREFETCH_SIZE (2 * SVN_DELTA_WINDOW_SIZE)
+
+/* Tell the OS that we are about to read the data of RS starting at its
+   current position.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_rep_state(rep_state_t *rs,
+                   apr_pool_t *scratch_pool)
+{
+  apr_off_t length;
+
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+
+  length = rs->size - rs->current;
+  if (length > PREFETCH_SIZE)
+    length = PREFETCH_SIZE;
+
+  svn_io__file_prefetch(rs->sfile->rfile->file, rs->start + rs->current,
+                        length);
+
+  return SVN_NO_ERROR;
+}
+
+/* If enabled for RB->FS, let the OS fetch the data for the next delta
+   windows of all reps in RB->RS_LIST concurrently and in the background.
+   The same goes for the plain base rep, if any.  The delta windows will
+   then be read and combined the usual way without waiting for each
+   individual read.  Skip all windows that can be found in our caches.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_delta_windows(struct rep_read_baton *rb,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Short chains won't benefit from concurrent reads. */
+  if (!ffd->prefetch_delta_chains || rb->rs_list->nelts < 2)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      svn_boolean_t is_cached = FALSE;
+
+      svn_pool_clear(iterpool);
+      if (rs->window_cache)
+        {
+          window_cache_key_t key = { 0 };
+          get_window_key(&key, rs);
+          key.chunk_index = rb->chunk_index;
+          SVN_ERR(svn_cache__has_key(&is_cached, rs->window_cache, &key,
+                                     iterpool));
+        }
+
+      if (!is_cached)
+        SVN_ERR(prefetch_rep_state(rs, iterpool));
+    }
+
+  if (rb->src_state && !rb->base_window)
+    SVN_ERR(prefetch_rep_state(rb->src_state, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
    base representation.  Store the window in *RESULT. */
@@ -1686,13 +2171,17 @@ get_combined_window(svn_stringbuf_t **result,
   rep_state_t *rs;
   apr_pool_t *iterpool;
 
+  /* Get the I/O for all reps in the chain going at once rather than
+     waiting for each read individually in the loop below. */
+  iterpool = svn_pool_create(rb->pool);
+  SVN_ERR(prefetch_delta_windows(rb, iterpool));
+
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
      delta limits the number of deltas in a chain to well under 100.
      Stop early if one of them does not depend on its predecessors. */
   window_pool = svn_pool_create(rb->pool);
   windows = apr_array_make(window_pool, 0, sizeof(svn_txdelta_window_t *));
-  iterpool = svn_pool_create(rb->pool);
   for (i = 0; i < rb->rs_list->nelts; ++i)
     {
       svn_txdelta_window_t *window;
@@ -1832,6 +2321,7 @@ get_contents_from_windows(struct rep_read_baton *rb,
       else
         {
           apr_off_t offset;
+          const char *data;
           if (((apr_off_t) copy_len) > rs->size - rs->current)
             copy_len = (apr_size_t) (rs->size - rs->current);
 
@@ -1839,9 +2329,20 @@ get_contents_from_windows(struct rep_read_baton *rb,
           SVN_ERR(auto_set_start_offset(rs, rb->pool));
 
           offset = rs->start + rs->current;
-          SVN_ERR(rs_aligned_seek(rs, NULL, offset, rb->pool));
-          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, cur,
-                                         copy_len, NULL, NULL, rb->pool));
+          data = svn_fs_fs__rev_file_mapped_data(rs->sfile->rfile, offset,
+                                                 copy_len);
+          if (data)
+            {
+              memcpy(cur, data, copy_len);
+            }
+          else
+            {
+              SVN_ERR(rs_aligned_seek(rs, NULL, offset, rb->pool));
+              SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, cur,
+                                             copy_len, NULL, NULL,
+                                             rb->pool));
+              svn_fs_fs__io_stats_read(rs->sfile->rfile, offset, copy_len);
+            }
         }
 
       rs->current += copy_len;
@@ -2110,6 +2611,7 @@ rep_read_contents(void *baton,
                   apr_size_t *len)
 {
   struct rep_read_baton *rb = baton;
+  apr_time_t start_time = 0;
 
   /* Get data from the fulltext cache for as long as we can. */
   if (rb->fulltext_cache)
@@ -2124,6 +2626,10 @@ rep_read_contents(void *baton,
       rb->fulltext_cache = NULL;
     }
 
+  /* Only take the time if somebody is interested in it. */
+  if (svn_fs_fs__io_stats_enabled(rb->fs))
+    start_time = apr_time_now();
+
   /* No fulltext cache to help us.  We must read from the window stream. */
   if (!rb->rs_list)
     {
@@ -2132,6 +2638,9 @@ rep_read_contents(void *baton,
       SVN_ERR(build_rep_list(&rb->rs_list, &rb->base_window,
                              &rb->src_state, rb->fs, &rb->rep,
                              rb->filehandle_pool));
+      svn_fs_fs__io_stats_delta_chain(rb->fs,
+                                      rb->rs_list->nelts
+                                      + (rb->src_state ? 1 : 0));
 
       /* In case we did read from the fulltext cache before, make the
        * window stream catch up.  Also, initialize the fulltext buffer
@@ -2147,6 +2656,10 @@ rep_read_contents(void *baton,
   else
     SVN_ERR(get_contents_from_windows(rb, buf, len));
 
+  if (start_time)
+    svn_fs_fs__io_stats_reconstruction_time(rb->fs,
+                                            apr_time_now() - start_time);
+
   if (rb->current_fulltext)
     svn_stringbuf_appendbytes(rb->current_fulltext, buf, *len);
 
@@ -2237,6 +2750,193 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
   return SVN_NO_ERROR;
 }
 
+/* Read a 7/8 encoded unsigned number from FILE into *VALUE and add the
+ * number of bytes consumed to *CONSUMED.  Set *VALUE to -1 for numbers
+ * that don't fit into an apr_off_t.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_window_number(apr_off_t *value,
+                   apr_off_t *consumed,
+                   apr_file_t *file,
+                   apr_pool_t *scratch_pool)
+{
+  apr_uint64_t temp = 0;
+  char c;
+
+  do
+    {
+      if (temp > (APR_INT64_MAX >> 7))
+        {
+          *value = -1;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(svn_io_file_getc(&c, file, scratch_pool));
+      ++*consumed;
+      temp = (temp << 7) | ((unsigned char)c & 0x7f);
+    }
+  while ((unsigned char)c & 0x80);
+
+  *value = (apr_off_t)temp;
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the svndiff0 window starting at the current position of
+ * FILE consists of a single "new data" instruction only, i.e. that its
+ * target view is stored verbatim.  If so, append the location of that
+ * data to RANGES, add the size of the whole window to *CONSUMED and
+ * position FILE behind it.  Otherwise, set *VERBATIM to FALSE.
+ * START is the current position in FILE.  Use SCRATCH_POOL for
+ * temporaries. */
+static svn_error_t *
+read_verbatim_window(svn_boolean_t *verbatim,
+                     apr_off_t *consumed,
+                     apr_array_header_t *ranges,
+                     apr_file_t *file,
+                     apr_off_t start,
+                     apr_pool_t *scratch_pool)
+{
+  apr_off_t sview_offset, sview_len, tview_len, inslen, newlen;
+  apr_off_t instruction_len, header_len = 0;
+  svn_fs__file_range_t *range;
+  char c;
+
+  SVN_ERR(read_window_number(&sview_offset, &header_len, file,
+                             scratch_pool));
+  SVN_ERR(read_window_number(&sview_len, &header_len, file, scratch_pool));
+  SVN_ERR(read_window_number(&tview_len, &header_len, file, scratch_pool));
+  SVN_ERR(read_window_number(&inslen, &header_len, file, scratch_pool));
+  SVN_ERR(read_window_number(&newlen, &header_len, file, scratch_pool));
+
+  *verbatim = (sview_offset == 0 && sview_len == 0 && tview_len > 0
+               && inslen > 0 && newlen == tview_len);
+  if (!*verbatim)
+    return SVN_NO_ERROR;
+
+  /* The instructions section must contain exactly one "new data" op
+   * covering the whole target view. */
+  SVN_ERR(svn_io_file_getc(&c, file, scratch_pool));
+  instruction_len = 1;
+  if (((unsigned char)c >> 6) != svn_txdelta_new)
+    {
+      *verbatim = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  if ((c & 0x3f) == 0)
+    {
+      apr_off_t op_len;
+      SVN_ERR(read_window_number(&op_len, &instruction_len, file,
+                                 scratch_pool));
+      *verbatim = op_len == tview_len;
+    }
+  else
+    {
+      *verbatim = (c & 0x3f) == tview_len;
+    }
+
+  if (!*verbatim || instruction_len != inslen)
+    {
+      *verbatim = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  range = apr_array_push(ranges);
+  range->offset = start + header_len + inslen;
+  range->length = newlen;
+
+  *consumed += header_len + inslen + newlen;
+  start = range->offset + range->length;
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_contents_ranges(const char **file_path,
+                               apr_array_header_t **ranges,
+                               svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *rh;
+  apr_array_header_t *result;
+  const char *name;
+  apr_off_t offset, start;
+  apr_off_t consumed;
+  char magic[4];
+
+  *file_path = NULL;
+  *ranges = NULL;
+
+  /* Only committed, non-empty contents qualify. */
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id) || rep->size == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs,
+                                            scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&rh, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  start = offset + rh->header_size;
+  result = apr_array_make(result_pool, 1, sizeof(svn_fs__file_range_t));
+
+  if (rh->type == svn_fs_fs__rep_plain)
+    {
+      svn_fs__file_range_t *range = apr_array_push(result);
+      range->offset = start;
+      range->length = rep->size;
+    }
+  else if (rh->type == svn_fs_fs__rep_self_delta && rep->size > 4)
+    {
+      /* Only uncompressed svndiff0 may contain the data verbatim. */
+      SVN_ERR(aligned_seek(fs, rev_file->file, NULL, start, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, magic, sizeof(magic),
+                                     NULL, NULL, scratch_pool));
+      if (memcmp(magic, "SVN\0", sizeof(magic)) != 0)
+        result = NULL;
+
+      for (consumed = sizeof(magic);
+           result && consumed < (apr_off_t)rep->size; )
+        {
+          svn_boolean_t verbatim;
+          SVN_ERR(read_verbatim_window(&verbatim, &consumed, result,
+                                       rev_file->file, start + consumed,
+                                       scratch_pool));
+          if (!verbatim)
+            result = NULL;
+        }
+
+      /* Reject corrupted or otherwise unexpected window sequences. */
+      if (result && consumed != (apr_off_t)rep->size)
+        result = NULL;
+    }
+  else
+    {
+      result = NULL;
+    }
+
+  if (result)
+    {
+      SVN_ERR(svn_io_file_name_get(&name, rev_file->file, scratch_pool));
+      if (name)
+        {
+          *file_path = apr_pstrdup(result_pool, name);
+          *ranges = result;
+        }
+    }
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
                                   svn_fs_t *fs,
@@ -2515,8 +3215,17 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Because source and target stream will already verify their content,
    * there is no need to do this once more.  In particular if the stream
-   * content is being fetched from cache. */
-  svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
+   * content is being fetched from cache.
+   *
+   * Large binaries often get data inserted or removed, which the standard
+   * delta algorithm does not cope with. */
+  if (   source
+      && ffd->cdc_delta_threshold > 0
+      && target->data_rep
+      && target->data_rep->expanded_size >= ffd->cdc_delta_threshold)
+    svn_txdelta__cdc(stream_p, source_stream, target_stream, FALSE, pool);
+  else
+    svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
 
   return SVN_NO_ERROR;
 }
@@ -2812,6 +3521,159 @@ locate_dir_cache(svn_fs_t *fs,
     }
 }
 
+/* Upper limit for the number of rev / pack files per directory listing
+   that prefetch_dir_entries will send read-ahead hints for.  Children
+   that are spread over many more files than that are not going to be
+   visited in quick succession anyway. */
+#define PREFETCH_MAX_FILES 8
+
+/* qsort-compatible comparison function for apr_off_t elements. */
+static int
+compare_offsets(const void *a,
+                const void *b)
+{
+  apr_off_t lhs = *(const apr_off_t *)a;
+  apr_off_t rhs = *(const apr_off_t *)b;
+
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+/* If enabled for FS, tell the OS to read the blocks containing the
+ * noderevs of the committed directory ENTRIES (svn_fs_dirent_t *) in
+ * the background.  Entries whose noderevs are already cached will be
+ * skipped.  The range extends up to and including the block that the
+ * next item starts in which, in packed shards, usually is the beginning
+ * of the node's representation.
+ *
+ * Tree walks like update reports will read these items shortly after
+ * listing the directory.  Hinting them all at once lets the OS fetch
+ * them in parallel with the processing of the previous entries.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+prefetch_dir_entries(svn_fs_t *fs,
+                     apr_array_header_t *entries,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *items;
+  apr_pool_t *iterpool;
+  int first, last, i;
+  int files = 0;
+
+  /* We need the P2L index to determine the item sizes. */
+  if (   !ffd->prefetch_dir_entries
+      || !svn_fs_fs__use_log_addressing(fs)
+      || entries->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Collect the noderevs that we would have to read from disk. */
+  items = apr_array_make(scratch_pool, entries->nelts,
+                         sizeof(svn_fs_fs__id_part_t));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      const svn_fs_fs__id_part_t *rev_item;
+      svn_boolean_t is_cached = FALSE;
+
+      if (svn_fs_fs__id_is_txn(dirent->id))
+        continue;
+
+      rev_item = svn_fs_fs__id_rev_item(dirent->id);
+      if (ffd->node_revision_cache)
+        {
+          pair_cache_key_t key = { 0 };
+          key.revision = rev_item->revision;
+          key.second = rev_item->number;
+
+          SVN_ERR(svn_cache__has_key(&is_cached, ffd->node_revision_cache,
+                                     &key, scratch_pool));
+        }
+
+      if (!is_cached)
+        APR_ARRAY_PUSH(items, svn_fs_fs__id_part_t) = *rev_item;
+    }
+
+  /* Group them by revision, i.e. by rev / pack file. */
+  svn_sort__array(items,
+                  (int (*)(const void *, const void *))
+                    svn_fs_fs__id_part_compare);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (first = 0;
+       first < items->nelts && files < PREFETCH_MAX_FILES;
+       first = last, ++files)
+    {
+      const svn_fs_fs__id_part_t *group
+        = &APR_ARRAY_IDX(items, first, svn_fs_fs__id_part_t);
+      svn_revnum_t base = svn_fs_fs__packed_base_rev(fs, group->revision);
+      svn_fs_fs__revision_file_t *rev_file;
+      apr_off_t *offsets;
+      apr_off_t block_mask;
+      apr_off_t range_start = -1;
+      apr_off_t range_end = -1;
+
+      svn_pool_clear(iterpool);
+
+      for (last = first + 1; last < items->nelts; ++last)
+        {
+          const svn_fs_fs__id_part_t *item
+            = &APR_ARRAY_IDX(items, last, svn_fs_fs__id_part_t);
+          if (svn_fs_fs__packed_base_rev(fs, item->revision) != base)
+            break;
+        }
+
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs,
+                                               group->revision,
+                                               iterpool, iterpool));
+      offsets = apr_palloc(iterpool, (last - first) * sizeof(*offsets));
+      SVN_ERR(svn_fs_fs__item_offsets(offsets, fs, rev_file, group,
+                                      last - first, iterpool));
+
+      /* Visit the items in file order and merge overlapping ranges such
+       * that we hint each block only once. */
+      qsort(offsets, last - first, sizeof(*offsets), compare_offsets);
+      block_mask = ~((apr_off_t)rev_file->block_size - 1);
+      for (i = 0; i < last - first; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry;
+          apr_off_t start = offsets[i] & block_mask;
+          apr_off_t end;
+
+          SVN_ERR(svn_fs_fs__p2l_entry_lookup(&entry, fs, rev_file,
+                                              group->revision, offsets[i],
+                                              iterpool, iterpool));
+          end = entry ? entry->offset + entry->size : offsets[i];
+          end = (end & block_mask) + rev_file->block_size;
+
+          if (start <= range_end)
+            {
+              range_end = MAX(range_end, end);
+            }
+          else
+            {
+              if (range_start >= 0)
+                svn_io__file_prefetch(rev_file->file, range_start,
+                                      range_end - range_start);
+
+              range_start = start;
+              range_end = end;
+            }
+        }
+
+      if (range_start >= 0)
+        svn_io__file_prefetch(rev_file->file, range_start,
+                              range_end - range_start);
+
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             svn_fs_t *fs,
@@ -2843,6 +3705,10 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
             {
               /* Still valid. Done. */
               *entries_p = dir->entries;
+              if (!svn_fs_fs__id_is_txn(noderev->id))
+                SVN_ERR(prefetch_dir_entries(fs, dir->entries,
+                                             scratch_pool));
+
               return SVN_NO_ERROR;
             }
         }
@@ -2861,6 +3727,9 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
   if (cache && svn_cache__is_cachable(cache, 150 * dir->entries->nelts))
     SVN_ERR(svn_cache__set(cache, key, dir, scratch_pool));
 
+  if (!svn_fs_fs__id_is_txn(noderev->id))
+    SVN_ERR(prefetch_dir_entries(fs, dir->entries, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -2874,6 +3743,125 @@ svn_fs_fs__find_dir_entry(apr_array_header_t *entries,
   return result ? *result : NULL;
 }
 
+/* Number of entries per chunk when caching very large directories in
+ * DIR_CHUNK_CACHE. */
+#define DIR_CHUNK_SIZE 1024
+
+/* Initialize *KEY for CHUNK of the committed directory NODEREV. */
+static void
+init_dir_chunk_key(dir_chunk_cache_key_t *key,
+                   node_revision_t *noderev,
+                   apr_int64_t chunk)
+{
+  key->revision = noderev->data_rep->revision;
+  key->item_index = noderev->data_rep->item_index;
+  key->chunk = chunk;
+}
+
+/* Look up the entry NAME of the committed directory NODEREV in FS in the
+ * chunked directory cache.  If the information is in the cache, set *FOUND
+ * and return the entry allocated in RESULT_POOL in *DIRENT, NULL if there
+ * is no such entry.  Otherwise, set *FOUND to FALSE.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+dir_chunk_cache_get(svn_fs_dirent_t **dirent,
+                    svn_boolean_t *found,
+                    svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    const char *name,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  dir_chunk_cache_key_t key;
+  extract_dir_entry_baton_t baton;
+  apr_int64_t chunk;
+
+  /* Find the chunk to look into. */
+  init_dir_chunk_key(&key, noderev, -1);
+  SVN_ERR(svn_cache__get_partial((void **)&chunk, found,
+                                 ffd->dir_chunk_cache, &key,
+                                 svn_fs_fs__extract_dir_chunk,
+                                 (void *)name, scratch_pool));
+  if (!*found)
+    return SVN_NO_ERROR;
+
+  /* NAME sorts before the first entry? */
+  *dirent = NULL;
+  if (chunk < 0)
+    return SVN_NO_ERROR;
+
+  /* Search that chunk. */
+  key.chunk = chunk;
+  baton.txn_filesize = SVN_INVALID_FILESIZE;
+  baton.name = name;
+  SVN_ERR(svn_cache__get_partial((void **)dirent, found,
+                                 ffd->dir_chunk_cache, &key,
+                                 svn_fs_fs__extract_dir_entry,
+                                 &baton, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the sorted ENTRIES of the committed directory NODEREV in FS in
+ * the chunked directory cache.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+dir_chunk_cache_set(svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    apr_array_header_t *entries,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  dir_chunk_cache_key_t key;
+  svn_fs_fs__dir_data_t dir;
+  apr_array_header_t *chunk_starts;
+  int i;
+
+  /* Don't bother if even the chunk index would be too large. */
+  if (!svn_cache__is_cachable(ffd->dir_chunk_cache,
+                              150 * (entries->nelts / DIR_CHUNK_SIZE + 1))
+      || !svn_cache__is_cachable(ffd->dir_chunk_cache,
+                                 150 * DIR_CHUNK_SIZE))
+    return SVN_NO_ERROR;
+
+  chunk_starts = apr_array_make(scratch_pool,
+                                entries->nelts / DIR_CHUNK_SIZE + 1,
+                                sizeof(svn_fs_dirent_t *));
+  dir.txn_filesize = SVN_INVALID_FILESIZE;
+
+  for (i = 0; i < entries->nelts; i += DIR_CHUNK_SIZE)
+    {
+      int count = MIN(DIR_CHUNK_SIZE, entries->nelts - i);
+
+      svn_pool_clear(iterpool);
+
+      /* Wrap the chunk's entries in an array without copying them. */
+      dir.entries = apr_array_make(iterpool, 0, sizeof(svn_fs_dirent_t *));
+      dir.entries->elts = entries->elts + i * entries->elt_size;
+      dir.entries->nelts = count;
+      dir.entries->nalloc = count;
+
+      init_dir_chunk_key(&key, noderev, i / DIR_CHUNK_SIZE);
+      SVN_ERR(svn_cache__set(ffd->dir_chunk_cache, &key, &dir, iterpool));
+
+      APR_ARRAY_PUSH(chunk_starts, svn_fs_dirent_t *)
+        = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+    }
+
+  /* Store the index last.  Readers will fall back to reading the whole
+   * directory if any of the chunks got evicted. */
+  dir.entries = chunk_starts;
+  init_dir_chunk_key(&key, noderev, -1);
+  SVN_ERR(svn_cache__set(ffd->dir_chunk_cache, &key, &dir, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   svn_fs_t *fs,
@@ -2882,6 +3870,7 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   extract_dir_entry_baton_t baton;
   svn_boolean_t found = FALSE;
 
@@ -2898,6 +3887,7 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       /* Cache lookup. */
       baton.txn_filesize = filesize;
       baton.name = name;
+      baton.out_of_date = FALSE;
       SVN_ERR(svn_cache__get_partial((void **)dirent,
                                      &found,
                                      cache,
@@ -2905,6 +3895,11 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                      svn_fs_fs__extract_dir_entry,
                                      &baton,
                                      result_pool));
+
+      /* Very large committed directories may have been cached in chunks. */
+      if (!found && key && cache == ffd->dir_cache)
+        SVN_ERR(dir_chunk_cache_get(dirent, &found, fs, noderev, name,
+                                    result_pool, scratch_pool));
     }
 
   /* fetch data from disk if we did not find it in the cache */
@@ -2925,6 +3920,8 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
        * about right. */
       if (cache && svn_cache__is_cachable(cache, 150 * dir.entries->nelts))
         SVN_ERR(svn_cache__set(cache, key, &dir, scratch_pool));
+      else if (key && cache == ffd->dir_cache)
+        SVN_ERR(dir_chunk_cache_set(fs, noderev, dir.entries, scratch_pool));
 
       /* find desired entry and return a copy in POOL, if found */
       entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
@@ -2976,6 +3973,7 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
       svn_error_t *err;
       fs_fs_data_t *ffd = fs->fsap_data;
       representation_t *rep = noderev->prop_rep;
+      svn_stringbuf_t *content;
       pair_cache_key_t key = { 0 };
 
       key.revision = rep->revision;
@@ -2989,20 +3987,25 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
             return SVN_NO_ERROR;
         }
 
+      /* Parse the whole property list in-place, such that keys and values
+         point into a single buffer. */
       proplist = apr_hash_make(pool);
       SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->prop_rep, FALSE,
                                       pool));
-      err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
+      SVN_ERR(svn_stringbuf_from_stream(&content, stream,
+                                        (apr_size_t)rep->expanded_size,
+                                        pool));
+      SVN_ERR(svn_stream_close(stream));
+      err = svn_hash__parse(proplist, content->data, content->len,
+                            SVN_HASH_TERMINATOR, pool);
       if (err)
         {
           svn_string_t *id_str = svn_fs_fs__id_unparse(noderev->id, pool);
 
-          err = svn_error_compose_create(err, svn_stream_close(stream));
           return svn_error_quick_wrapf(err,
                    _("malformed property list for node-revision '%s'"),
                    id_str->data);
         }
-      SVN_ERR(svn_stream_close(stream));
 
       if (ffd->properties_cache && SVN_IS_VALID_REVNUM(rep->revision))
         SVN_ERR(svn_cache__set(ffd->properties_cache, &key, proplist, pool));
@@ -3018,6 +4021,44 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_property(svn_string_t **value,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        const char *name,
+                        apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = noderev->prop_rep;
+  apr_hash_t *proplist;
+
+  /* Committed property lists may be cached.  Read just the one value
+     from there without deserializing the whole list. */
+  if (   rep
+      && !svn_fs_fs__id_txn_used(&rep->txn_id)
+      && ffd->properties_cache
+      && SVN_IS_VALID_REVNUM(rep->revision))
+    {
+      pair_cache_key_t key = { 0 };
+      svn_boolean_t is_cached;
+
+      key.revision = rep->revision;
+      key.second = rep->item_index;
+      SVN_ERR(svn_cache__get_partial((void **)value, &is_cached,
+                                     ffd->properties_cache, &key,
+                                     svn_fs_fs__extract_property,
+                                     (void *)name, pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  /* This will also populate the cache. */
+  SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, pool));
+  *value = proplist ? svn_hash_gets(proplist, name) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__create_changes_context(svn_fs_fs__changes_context_t **context,
                                   svn_fs_t *fs,
@@ -3301,21 +4342,33 @@ cache_windows(svn_fs_t *fs,
           /* Read, decode and cache the window. */
           svn_fs_fs__raw_cached_window_t window;
           apr_off_t start_offset = rs->start + rs->current;
-          apr_size_t window_len;
-          char *buf;
-
-          /* navigate to the current window */
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
-                                                   rs->sfile->rfile->stream,
-                                                   iterpool));
-
-          /* Read the raw window. */
-          buf = apr_palloc(iterpool, window_len + 1);
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                         window_len, NULL, NULL, iterpool));
-          buf[window_len] = 0;
+          apr_size_t window_len = 0;
+          const char *data = NULL;
+
+          /* Mapped data can be cached without copying it first. */
+          if (rs->sfile->rfile->mapped_data)
+            SVN_ERR(get_mapped_window(&data, &window_len, rs, iterpool));
+
+          if (window_len == 0)
+            {
+              char *buf;
+
+              /* navigate to the current window */
+              SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
+              SVN_ERR(svn_txdelta__read_raw_window_len(
+                          &window_len, rs->sfile->rfile->stream, iterpool));
+
+              /* Read the raw window. */
+              buf = apr_palloc(iterpool, window_len + 1);
+              SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
+              SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
+                                             window_len, NULL, NULL,
+                                             iterpool));
+              svn_fs_fs__io_stats_read(rs->sfile->rfile, start_offset,
+                                       window_len);
+              buf[window_len] = 0;
+              data = buf;
+            }
 
           /* update relative offset in representation */
           rs->current += window_len;
@@ -3323,7 +4376,7 @@ cache_windows(svn_fs_t *fs,
           /* Construct the cachable raw window object. */
           window.end_offset = rs->current;
           window.window.len = window_len;
-          window.window.data = buf;
+          window.window.data = data;
 
           /* cache the window now */
           SVN_ERR(svn_cache__set(rs->raw_window_cache, &key, &window,
@@ -3378,6 +4431,7 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
     {
       svn_stringbuf_t *plaintext;
       svn_boolean_t is_cached;
+      const char *data;
 
       /* already in cache? */
       SVN_ERR(svn_cache__has_key(&is_cached, rs.combined_cache,
@@ -3386,16 +4440,27 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
       if (is_cached)
         return SVN_NO_ERROR;
 
-      /* for larger reps, the header may have crossed a block boundary.
-       * make sure we still read blocks properly aligned, i.e. don't use
-       * plain seek here. */
-      SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+      data = svn_fs_fs__rev_file_mapped_data(rev_file, offset, rs.size);
+      if (data)
+        {
+          plaintext = svn_stringbuf_ncreate(data, (apr_size_t)rs.size,
+                                            result_pool);
+        }
+      else
+        {
+          /* for larger reps, the header may have crossed a block boundary.
+           * make sure we still read blocks properly aligned, i.e. don't use
+           * plain seek here. */
+          SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset,
+                               scratch_pool));
 
-      plaintext = svn_stringbuf_create_ensure(rs.size, result_pool);
-      SVN_ERR(svn_io_file_read_full2(rev_file->file, plaintext->data,
-                                     rs.size, &plaintext->len, NULL,
-                                     result_pool));
-      plaintext->data[plaintext->len] = 0;
+          plaintext = svn_stringbuf_create_ensure(rs.size, result_pool);
+          SVN_ERR(svn_io_file_read_full2(rev_file->file, plaintext->data,
+                                         rs.size, &plaintext->len, NULL,
+                                         result_pool));
+          plaintext->data[plaintext->len] = 0;
+          svn_fs_fs__io_stats_read(rev_file, offset, plaintext->len);
+        }
       rs.current += rs.size;
 
       SVN_ERR(set_cached_combined_window(plaintext, &rs, scratch_pool));
@@ -3458,11 +4523,21 @@ block_read_contents(svn_fs_t *fs,
 {
   pair_cache_key_t header_key = { 0 };
   svn_fs_fs__rep_header_t *rep_header;
+  svn_stream_t *stream = rev_file->stream;
+  svn_string_t *mapped;
 
   header_key.revision = (apr_int32_t)entry->item.revision;
   header_key.second = entry->item.number;
 
-  SVN_ERR(read_rep_header(&rep_header, fs, rev_file->stream, &header_key,
+  /* Parse the header directly from memory, if the file has been mapped. */
+  mapped = apr_palloc(scratch_pool, sizeof(*mapped));
+  mapped->len = (apr_size_t)entry->size;
+  mapped->data = svn_fs_fs__rev_file_mapped_data(rev_file, entry->offset,
+                                                 entry->size);
+  if (mapped->data)
+    stream = svn_stream_from_string(mapped, scratch_pool);
+
+  SVN_ERR(read_rep_header(&rep_header, fs, stream, &header_key,
                           scratch_pool, scratch_pool));
   SVN_ERR(block_read_windows(rep_header, fs, rev_file, entry, max_offset,
                              scratch_pool, scratch_pool));
@@ -3470,31 +4545,18 @@ block_read_contents(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* For the given REV_FILE in FS, in *STREAM return a stream covering the
- * item specified by ENTRY.  Also, verify the item's content by low-level
- * checksum.  Allocate the result in POOL.
+/* Verify that the LEN bytes of DATA match the low-level checksum given
+ * by ENTRY.  Use POOL for allocations.
  */
 static svn_error_t *
-read_item(svn_stream_t **stream,
-          svn_fs_t *fs,
-          svn_fs_fs__revision_file_t *rev_file,
-          svn_fs_fs__p2l_entry_t* entry,
-          apr_pool_t *pool)
+verify_item_checksum(const svn_fs_fs__p2l_entry_t *entry,
+                     const char *data,
+                     apr_size_t len,
+                     apr_pool_t *pool)
 {
-  apr_uint32_t digest;
   svn_checksum_t *expected, *actual;
   apr_uint32_t plain_digest;
-
-  /* Read item into string buffer. */
-  svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
-  text->len = entry->size;
-  text->data[text->len] = 0;
-  SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
-                                 NULL, NULL, pool));
-
-  /* Return (construct, calculate) stream and checksum. */
-  *stream = svn_stream_from_stringbuf(text, pool);
-  digest = svn__fnv1a_32x4(text->data, text->len);
+  apr_uint32_t digest = svn__fnv1a_32x4(data, len);
 
   /* Checksums will match most of the time. */
   if (entry->fnv1_checksum == digest)
@@ -3520,6 +4582,42 @@ read_item(svn_stream_t **stream,
                  entry->item.revision);
 }
 
+/* For the given REV_FILE in FS, in *STREAM return a stream covering the
+ * item specified by ENTRY.  Also, verify the item's content by low-level
+ * checksum.  Allocate the result in POOL.
+ */
+static svn_error_t *
+read_item(svn_stream_t **stream,
+          svn_fs_t *fs,
+          svn_fs_fs__revision_file_t *rev_file,
+          svn_fs_fs__p2l_entry_t* entry,
+          apr_pool_t *pool)
+{
+  svn_string_t *mapped;
+
+  /* In mmap mode, we don't need to copy the data. */
+  mapped = apr_palloc(pool, sizeof(*mapped));
+  mapped->len = (apr_size_t)entry->size;
+  mapped->data = svn_fs_fs__rev_file_mapped_data(rev_file, entry->offset,
+                                                 entry->size);
+  if (!mapped->data)
+    {
+      /* Read item into string buffer. */
+      svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
+                                     NULL, NULL, pool));
+
+      mapped->data = text->data;
+    }
+
+  /* Return (construct, calculate) stream and checksum. */
+  *stream = svn_stream_from_string(mapped, pool);
+  return svn_error_trace(verify_item_checksum(entry, mapped->data,
+                                              mapped->len, pool));
+}
+
 /* If not already cached, read the changed paths list addressed by ENTRY in
  * FS and cache it if it has no more than SVN_FS_FS__CHANGES_BLOCK_SIZE
  * entries and caching is enabled.  Read the data from REV_FILE.
@@ -3692,8 +4790,10 @@ block_read(void **result,
                                           ffd->block_size, scratch_pool,
                                           scratch_pool));
 
-      SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
-                           iterpool));
+      /* Mapped files don't need their blocks to be buffered. */
+      if (!revision_file->mapped_data)
+        SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
+                             iterpool));
 
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
@@ -3727,6 +4827,11 @@ block_read(void **result,
               void *item = NULL;
               SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
                                        &entry->offset, iterpool));
+
+              /* Mapped accesses get counted when they happen. */
+              if (!revision_file->mapped_data)
+                svn_fs_fs__io_stats_read(revision_file, entry->offset,
+                                         (apr_size_t)entry->size);
               switch (entry->type)
                 {
                   case SVN_FS_FS__ITEM_TYPE_FILE_REP:
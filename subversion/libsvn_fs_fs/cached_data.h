@@ -51,6 +51,18 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/* Set *NODEREVS to an array of node_revision_t * containing the
+   node-revisions for all const svn_fs_id_t * in IDS within FS, in the
+   same order.  This is equivalent to but more efficient than calling
+   svn_fs_fs__get_node_revision for each element in IDS.  Allocate the
+   result in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Set *ROOT_ID to the node-id for the root of revision REV in
    filesystem FS.  Do any allocations in POOL. */
 svn_error_t *
@@ -119,6 +131,18 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* Set *FILE_PATH and *RANGES to the location of the contents of REP in FS
+   as described for svn_fs__file_contents_ranges().  REP may be NULL.
+   Allocate the results in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+svn_error_t *
+svn_fs_fs__get_contents_ranges(const char **file_path,
+                               apr_array_header_t **ranges,
+                               svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
@@ -170,6 +194,17 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist,
                         node_revision_t *noderev,
                         apr_pool_t *pool);
 
+/* Set *VALUE to the value of property NAME of node-revision NODEREV as
+   seen in filesystem FS, or to NULL if there is no such property.  If
+   the property list is cached, only the one value gets read from the
+   cache.  Use POOL for allocations. */
+svn_error_t *
+svn_fs_fs__get_property(svn_string_t **value,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        const char *name,
+                        apr_pool_t *pool);
+
 /* Create a changes retrieval context object in *RESULT_POOL and return it
  * in *CONTEXT.  It will allow svn_fs_x__get_changes to fetch consecutive
  * blocks (one per invocation) from REV's changed paths list in FS. */
@@ -27,10 +27,12 @@
 #include "tree.h"
 #include "index.h"
 #include "temp_serializer.h"
+#include "util.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_config.h"
 #include "svn_cache_config.h"
+#include "svn_dirent_uri.h"
 
 #include "svn_private_config.h"
 #include "svn_hash.h"
@@ -277,12 +279,14 @@ init_callbacks(svn_cache__t *cache,
 }
 
 /* Sets *CACHE_P to cache instance based on provided options.
- * Creates memcache if MEMCACHE is not NULL. Creates membuffer cache if
+ * Creates memcache if MEMCACHE is not NULL, with a membuffer near cache
+ * if MEMBUFFER is not NULL as well. Otherwise, creates membuffer cache if
  * MEMBUFFER is not NULL. Fallbacks to inprocess cache if MEMCACHE and
  * MEMBUFFER are NULL and pages is non-zero.  Sets *CACHE_P to NULL
  * otherwise.  Use the given PRIORITY class for the new cache.  If it
- * is 0, then use the default priority class.  HAS_NAMESPACE indicates
- * whether we prefixed this cache instance with a namespace.
+ * is 0, then use the default priority class.  Membuffer caches will use
+ * the ADMISSION policy.  HAS_NAMESPACE indicates whether we prefixed this
+ * cache instance with a namespace.
  *
  * Unless NO_HANDLER is true, register an error handler that reports errors
  * as warnings to the FS warning callback.
@@ -300,6 +304,7 @@ create_cache(svn_cache__t **cache_p,
              apr_ssize_t klen,
              const char *prefix,
              apr_uint32_t priority,
+             svn_cache__admission_t admission,
              svn_boolean_t has_namespace,
              svn_fs_t *fs,
              svn_boolean_t no_handler,
@@ -314,7 +319,17 @@ create_cache(svn_cache__t **cache_p,
 
   if (memcache)
     {
-      SVN_ERR(svn_cache__create_memcache(cache_p, memcache,
+      /* Keep the membuffer cache as a near cache in front of memcached
+       * such that hot items don't cost a network round-trip. */
+      svn_cache__t *near_cache = NULL;
+      if (membuffer)
+        SVN_ERR(svn_cache__create_membuffer_cache(
+                  &near_cache, membuffer, serializer, deserializer,
+                  klen, prefix, priority, admission, FALSE,
+                  has_namespace,
+                  result_pool, scratch_pool));
+
+      SVN_ERR(svn_cache__create_memcache(cache_p, memcache, near_cache,
                                          serializer, deserializer, klen,
                                          prefix, result_pool));
       error_handler = no_handler
@@ -327,14 +342,16 @@ create_cache(svn_cache__t **cache_p,
        * i.e. their data will not be needed after a while. */
       SVN_ERR(svn_cache__create_membuffer_cache(
                 cache_p, membuffer, serializer, deserializer,
-                klen, prefix, priority, FALSE, has_namespace,
+                klen, prefix, priority, admission, FALSE,
+                has_namespace,
                 result_pool, scratch_pool));
     }
   else if (pages)
     {
-      SVN_ERR(svn_cache__create_inprocess(
-                cache_p, serializer, deserializer, klen, pages,
-                items_per_page, FALSE, prefix, result_pool));
+      /* Evict single entries rather than whole pages. */
+      SVN_ERR(svn_cache__create_sharded(
+                cache_p, serializer, deserializer, klen, 1,
+                pages * items_per_page, 0, FALSE, prefix, result_pool));
     }
   else
     {
@@ -346,6 +363,95 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Open the persistent cache store of FS in *STORE_P, if that has been
+ * enabled in FS's configuration.  Set it to NULL otherwise.  Unless
+ * NO_HANDLER is set, failures to open the store will only be reported as
+ * warnings.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+open_persistent_store(svn_cache__persistent_t **store_p,
+                      svn_fs_t *fs,
+                      svn_boolean_t no_handler,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest = 0;
+  apr_uint64_t dummy;
+  svn_error_t *err;
+
+  *store_p = NULL;
+  if (ffd->persistent_cache_size == 0)
+    return SVN_NO_ERROR;
+
+  /* Data is only valid for this repository, identified by UUID and
+   * instance ID.  The cache keys contain the revision numbers, which are
+   * only valid as long as the repository has not been rolled back to an
+   * earlier youngest revision.  A new repository has no 'current' yet. */
+  err = svn_fs_fs__read_current(&youngest, &dummy, &dummy, fs,
+                                scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      youngest = 0;
+      err = SVN_NO_ERROR;
+    }
+
+  if (!err)
+    err = svn_cache__get_persistent_store(store_p,
+                                          svn_dirent_join(
+                                            fs->path,
+                                            PATH_PERSISTENT_CACHE,
+                                            scratch_pool),
+                                          apr_pstrcat(scratch_pool,
+                                                      fs->uuid, ":",
+                                                      ffd->instance_id,
+                                                      SVN_VA_NULL),
+                                          (apr_uint64_t)youngest,
+                                          ffd->persistent_cache_size,
+                                          scratch_pool);
+  if (err && !no_handler)
+    {
+      /* We can live without the persistent cache. */
+      *store_p = NULL;
+      (fs->warning)(fs->warning_baton, err);
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* If STORE is not NULL, back *CACHE_P by it.  SERIALIZER, DESERIALIZER,
+ * KLEN and PREFIX must match the parameters used to create *CACHE_P.
+ * Register the error handler for FS unless NO_HANDLER is set.
+ *
+ * The new cache is allocated in RESULT_POOL.
+ */
+static svn_error_t *
+add_persistent_tier(svn_cache__t **cache_p,
+                    svn_cache__persistent_t *store,
+                    svn_cache__serialize_func_t serializer,
+                    svn_cache__deserialize_func_t deserializer,
+                    apr_ssize_t klen,
+                    const char *prefix,
+                    svn_fs_t *fs,
+                    svn_boolean_t no_handler,
+                    apr_pool_t *result_pool)
+{
+  if (*cache_p && store)
+    {
+      SVN_ERR(svn_cache__create_persistent(cache_p, *cache_p, store,
+                                           serializer, deserializer, klen,
+                                           prefix, result_pool));
+      SVN_ERR(init_callbacks(*cache_p, fs,
+                             no_handler ? NULL
+                                        : warn_and_fail_on_cache_errors,
+                             result_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
@@ -363,6 +469,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_nodeprops;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
+  svn_cache__persistent_t *persistent_store;
 
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
@@ -376,6 +483,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   has_namespace = strlen(cache_namespace) > 0;
 
   membuffer = svn_cache__get_global_membuffer_cache();
+  SVN_ERR(open_persistent_store(&persistent_store, fs, no_handler, pool));
 
   /* General rules for assigning cache priorities:
    *
@@ -414,6 +522,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(svn_revnum_t),
                        apr_pstrcat(pool, prefix, "RRI", SVN_VA_NULL),
                        0,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -430,6 +539,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        APR_HASH_KEY_STRING,
                        apr_pstrcat(pool, prefix, "DAG", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -448,6 +558,23 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "DIR", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
+  /* Same as above, for the chunks of very large directories. */
+  SVN_ERR(create_cache(&(ffd->dir_chunk_cache),
+                       NULL,
+                       membuffer,
+                       1, 8,
+                       svn_fs_fs__serialize_dir_entries,
+                       svn_fs_fs__deserialize_dir_entries,
+                       sizeof(dir_chunk_cache_key_t),
+                       apr_pstrcat(pool, prefix, "DIRCHUNK", SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -465,6 +592,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "PACK-MANIFEST",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -480,6 +608,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "NODEREVS", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -495,6 +624,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "REPHEADER", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -510,6 +640,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "CHANGES", SVN_VA_NULL),
                        0,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -525,6 +656,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "REVPROP", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        TRUE, /* contents is short-lived */
                        fs,
                        no_handler,
@@ -542,10 +674,19 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            sizeof(pair_cache_key_t),
                            apr_pstrcat(pool, prefix, "TEXT", SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           svn_cache__admission_scan_resistant,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->fulltext_cache),
+                                  persistent_store,
+                                  NULL, NULL,
+                                  sizeof(pair_cache_key_t),
+                                  "TEXT",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_cache),
                            NULL,
@@ -557,10 +698,20 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "MERGEINFO",
                                        SVN_VA_NULL),
                            0,
+                           svn_cache__admission_default,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->mergeinfo_cache),
+                                  persistent_store,
+                                  svn_fs_fs__serialize_mergeinfo,
+                                  svn_fs_fs__deserialize_mergeinfo,
+                                  APR_HASH_KEY_STRING,
+                                  "MERGEINFO",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_existence_cache),
                            NULL,
@@ -572,16 +723,49 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "HAS_MERGEINFO",
                                        SVN_VA_NULL),
                            0,
+                           svn_cache__admission_default,
+                           has_namespace,
+                           fs,
+                           no_handler,
+                           fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->mergeinfo_existence_cache),
+                                  persistent_store,
+                                  NULL, NULL,
+                                  APR_HASH_KEY_STRING,
+                                  "HAS_MERGEINFO",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
+
+      SVN_ERR(create_cache(&(ffd->closest_copy_cache),
+                           NULL,
+                           membuffer,
+                           0, 0, /* Do not use the inprocess cache */
+                           /* Values are svn_stringbuf_t */
+                           NULL, NULL,
+                           APR_HASH_KEY_STRING,
+                           apr_pstrcat(pool, prefix, "COPY", SVN_VA_NULL),
+                           0,
+                           svn_cache__admission_default,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->closest_copy_cache),
+                                  persistent_store,
+                                  NULL, NULL,
+                                  APR_HASH_KEY_STRING,
+                                  "COPY",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
     }
   else
     {
       ffd->fulltext_cache = NULL;
       ffd->mergeinfo_cache = NULL;
       ffd->mergeinfo_existence_cache = NULL;
+      ffd->closest_copy_cache = NULL;
     }
 
   /* if enabled, cache node properties */
@@ -597,6 +781,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "PROP",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           svn_cache__admission_default,
                            has_namespace,
                            fs,
                            no_handler,
@@ -620,6 +805,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "RAW_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           svn_cache__admission_scan_resistant,
                            has_namespace,
                            fs,
                            no_handler,
@@ -635,6 +821,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "TXDELTA_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           svn_cache__admission_scan_resistant,
                            has_namespace,
                            fs,
                            no_handler,
@@ -650,13 +837,23 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "COMBINED_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           svn_cache__admission_scan_resistant,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->combined_window_cache),
+                                  persistent_store,
+                                  NULL, NULL,
+                                  sizeof(window_cache_key_t),
+                                  "COMBINED_WINDOW",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
     }
   else
     {
+      ffd->raw_window_cache = NULL;
       ffd->txdelta_window_cache = NULL;
       ffd->combined_window_cache = NULL;
     }
@@ -674,6 +871,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "L2P_HEADER",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -691,6 +889,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "L2P_PAGE",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -705,6 +904,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "P2L_HEADER",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -719,6 +919,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "P2L_PAGE",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler,
@@ -877,6 +1078,7 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
                        APR_HASH_KEY_STRING,
                        prefix,
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        TRUE, /* The TXN-ID is our namespace. */
                        fs,
                        TRUE,
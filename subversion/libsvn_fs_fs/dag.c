@@ -498,6 +498,20 @@ svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__dag_get_property(svn_string_t **value_p,
+                            dag_node_t *node,
+                            const char *name,
+                            apr_pool_t *pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_error_trace(svn_fs_fs__get_property(value_p, node->fs, noderev,
+                                                 name, pool));
+}
+
 svn_error_t *
 svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
                          dag_node_t *node,
@@ -1020,6 +1034,29 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_file_contents_ranges(const char **file_path,
+                                    apr_array_header_t **ranges,
+                                    dag_node_t *node,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (node->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_fs_fs__get_contents_ranges(file_path, ranges, node->fs,
+                                        noderev->data_rep,
+                                        result_pool, scratch_pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_file_length(svn_filesize_t *length,
                            dag_node_t *file,
@@ -177,6 +177,17 @@ svn_error_t *svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
                                          dag_node_t *node,
                                          apr_pool_t *pool);
 
+/* Set *VALUE_P to the value of property NAME of NODE, or to NULL if
+   NODE has no such property.  This is cheaper than looking it up in
+   the result of svn_fs_fs__dag_get_proplist().
+
+   Use POOL for all allocations.
+ */
+svn_error_t *svn_fs_fs__dag_get_property(svn_string_t **value_p,
+                                         dag_node_t *node,
+                                         const char *name,
+                                         apr_pool_t *pool);
+
 /* Set *HAS_PROPS to TRUE if NODE has properties. Use SCRATCH_POOL
    for temporary allocations */
 svn_error_t *svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
@@ -427,6 +438,17 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          apr_pool_t *pool);
 
 
+/* Set *FILE_PATH and *RANGES to the location of the contents of the file
+   NODE as described for svn_fs__file_contents_ranges().  Allocate the
+   results in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__dag_file_contents_ranges(const char **file_path,
+                                    apr_array_header_t **ranges,
+                                    dag_node_t *node,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+
+
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
    string will be used.
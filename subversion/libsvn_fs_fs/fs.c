@@ -35,9 +35,11 @@
 #include "fs.h"
 #include "fs_fs.h"
 #include "tree.h"
+#include "batch_fsync.h"
 #include "lock.h"
 #include "hotcopy.h"
 #include "id.h"
+#include "io_stats.h"
 #include "pack.h"
 #include "recovery.h"
 #include "rep-cache.h"
@@ -45,6 +47,7 @@
 #include "transaction.h"
 #include "util.h"
 #include "verify.h"
+#include "warmup.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
 
@@ -123,6 +126,36 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* Reserved transaction numbers get handed out to all threads. */
+      SVN_ERR(svn_mutex__init(&ffsd->txn_numbers_lock, TRUE, common_pool));
+
+      /* The in-process L2P indexes of packed shards get filled on demand
+         by concurrent readers. */
+      SVN_ERR(svn_mutex__init(&ffsd->packed_l2p_lock, TRUE, common_pool));
+      ffsd->packed_l2p_pool = svn_pool_create(common_pool);
+      ffsd->packed_l2p = apr_hash_make(ffsd->packed_l2p_pool);
+
+      /* The rep-cache filter gets created on demand. */
+      SVN_ERR(svn_mutex__init(&ffsd->rep_cache_filter_lock, TRUE,
+                              common_pool));
+      ffsd->rep_cache_filter_pool = svn_pool_create(common_pool);
+
+      /* Group commits are coordinated between all threads committing
+         to this repository. */
+      SVN_ERR(svn_mutex__init(&ffsd->group_commit_lock, TRUE, common_pool));
+#if APR_HAS_THREADS
+      status = apr_thread_cond_create(&ffsd->group_commit_cond, common_pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create condition variable"));
+#endif
+      ffsd->group_commit_written = SVN_INVALID_REVNUM;
+      ffsd->group_commit_synced = SVN_INVALID_REVNUM;
+
+      /* The 'current' file watcher gets created on demand. */
+      SVN_ERR(svn_mutex__init(&ffsd->current_lock, TRUE, common_pool));
+      ffsd->current_youngest = SVN_INVALID_REVNUM;
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -261,6 +294,7 @@ static fs_vtable_t fs_vtable = {
   fs_refresh_revprops,
   svn_fs_fs__revision_prop,
   svn_fs_fs__get_revision_proplist,
+  svn_fs_fs__get_revision_proplist_range,
   svn_fs_fs__change_rev_prop,
   fs_set_uuid,
   svn_fs_fs__revision_root,
@@ -269,6 +303,7 @@ static fs_vtable_t fs_vtable = {
   svn_fs_fs__purge_txn,
   svn_fs_fs__list_transactions,
   svn_fs_fs__deltify,
+  svn_fs_fs__subtree_changed,
   svn_fs_fs__lock,
   svn_fs_fs__generate_lock_token,
   svn_fs_fs__unlock,
@@ -279,7 +314,12 @@ static fs_vtable_t fs_vtable = {
   fs_info,
   svn_fs_fs__verify_root,
   fs_freeze,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__sync,
+  svn_fs_fs__set_io_stats,
+  svn_fs_fs__get_io_stats,
+  svn_fs_fs__build_rep_cache,
+  svn_fs_fs__open_view
 };
 
 
@@ -293,6 +333,7 @@ initialize_fs_struct(svn_fs_t *fs)
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
+  ffd->unsynced_rev = SVN_INVALID_REVNUM;
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -308,6 +349,79 @@ uninitialize_fs_struct(svn_fs_t *fs)
   fs->fsap_data = NULL;
 }
 
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config;
+
+  SVN_ERR(svn_fs_fs__open_view(instance, fs, scratch_pool));
+  *instance_p = instance;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_view(svn_fs_t *view,
+                     svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_data_t *view_ffd;
+
+  SVN_ERR(initialize_fs_struct(view));
+  view->path = apr_pstrdup(view->pool, fs->path);
+  view->uuid = apr_pstrdup(view->pool, fs->uuid);
+
+  /* Everything that svn_fs_fs__open() read from the format, uuid and
+     config files is the same for all instances.  So is the process-wide
+     shared data, which has already been initialized for FS. */
+  view_ffd = view->fsap_data;
+  *view_ffd = *ffd;
+  view_ffd->instance_id = apr_pstrdup(view->pool, ffd->instance_id);
+  if (ffd->pack_access_hints)
+    view_ffd->pack_access_hints = apr_pstrdup(view->pool,
+                                              ffd->pack_access_hints);
+
+  /* Reset all per-instance state. */
+  view_ffd->revprop_prefix = 0;
+  view_ffd->txn_dir_cache = NULL;
+  view_ffd->packed_l2p = NULL;
+  view_ffd->has_write_lock = FALSE;
+  view_ffd->rep_cache_db = NULL;
+  view_ffd->rep_cache_db_opened = 0;
+  view_ffd->lock_db = NULL;
+  view_ffd->lock_db_opened = 0;
+  view_ffd->mergeinfo_index_db = NULL;
+  view_ffd->mergeinfo_index_db_opened = 0;
+  if (ffd->sync_deferred)
+    view_ffd->flush_to_disk = ffd->deferred_flush_to_disk;
+  view_ffd->sync_deferred = FALSE;
+  view_ffd->unsynced_rev = SVN_INVALID_REVNUM;
+  view_ffd->deferred_reps = NULL;
+  view_ffd->deferred_revs = 0;
+  view_ffd->deferred_reps_pool = NULL;
+  view_ffd->io_stats_enabled = FALSE;
+  memset(&view_ffd->io_stats, 0, sizeof(view_ffd->io_stats));
+  view_ffd->io_stats_cache_gets = 0;
+  view_ffd->io_stats_cache_hits = 0;
+  view_ffd->io_trace = NULL;
+  view_ffd->io_trace_handle = 0;
+
+  /* The cache front-ends are not thread-safe, so every view needs its
+     own.  They all share the same back-end. */
+  SVN_ERR(svn_fs_fs__initialize_caches(view, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements the fs_library_vtable_t.create() API.  Create a new
    fsfs-backed Subversion filesystem at path PATH and link it into
    *FS.  Perform temporary allocations in POOL, and fs-global allocations
@@ -359,6 +473,8 @@ fs_open(svn_fs_t *fs,
   SVN_ERR(svn_fs_fs__initialize_caches(fs, subpool));
   SVN_MUTEX__WITH_LOCK(common_pool_lock,
                        fs_serialized_init(fs, common_pool, subpool));
+  SVN_MUTEX__WITH_LOCK(common_pool_lock,
+                       svn_fs_fs__warmup_init(fs, common_pool, subpool));
 
   svn_pool_destroy(subpool);
 
@@ -625,6 +741,8 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_fs_fs__batch_fsync_init(common_pool));
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
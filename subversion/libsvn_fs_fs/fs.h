@@ -28,12 +28,14 @@
 #include <apr_network_io.h>
 #include <apr_md5.h>
 #include <apr_sha1.h>
+#include <apr_thread_cond.h>
 
 #include "svn_fs.h"
 #include "svn_config.h"
 #include "private/svn_atomic.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
 
@@ -64,12 +66,24 @@ extern "C" {
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
+#define PATH_LOCKS_DB         "locks.db"         /* Database of locks */
+#define PATH_MERGEINFO_INDEX_DB "mergeinfo-index.db"
+                                                 /* Nodes with mergeinfo */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
+#define PATH_REVPROPS_OVERLAY "overlay"          /* Revprop changes not yet
+                                                    merged into the packs */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
+#define PATH_CHANGES_INDEX    "changes"          /* Changed-paths index of a
+                                                    packed shard */
+#define PATH_PERSISTENT_CACHE "persistent-cache" /* On-disk cache of fulltexts,
+                                                    delta windows and
+                                                    mergeinfo */
+#define PATH_CACHE_WARMUP     "cache-warmup"     /* Hottest noderevs to preload
+                                                    into the caches */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
@@ -100,6 +114,7 @@ extern "C" {
 /* Names of sections and options in fsfs.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_PERSISTENT_CACHE_SIZE "persistent-cache-size"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
@@ -107,14 +122,36 @@ extern "C" {
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_CDC_DELTA_THRESHOLD        "cdc-delta-threshold"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_COMPRESSION_THREADS "compression-threads"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
+#define CONFIG_OPTION_REVPROP_OVERLAY_SIZE      "revprop-overlay-size"
 #define CONFIG_SECTION_IO                "io"
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_PREFETCH_DELTA_CHAINS "prefetch-delta-chains"
+#define CONFIG_OPTION_PREFETCH_DIR_ENTRIES "prefetch-dir-entries"
+#define CONFIG_OPTION_ENABLE_MMAP        "enable-mmap"
+#define CONFIG_OPTION_WATCH_CURRENT      "watch-current"
+#define CONFIG_OPTION_GROUP_COMMIT       "group-commit"
+#define CONFIG_OPTION_OPTIMISTIC_COMMIT  "optimistic-commit"
+#define CONFIG_SECTION_MERGEINFO         "mergeinfo"
+#define CONFIG_OPTION_ENABLE_MERGEINFO_INDEX "enable-mergeinfo-index"
+#define CONFIG_SECTION_SQLITE            "sqlite"
+#define CONFIG_OPTION_ENABLE_WAL         "enable-wal"
+#define CONFIG_OPTION_MMAP_SIZE          "mmap-size"
+#define CONFIG_OPTION_CACHE_SIZE         "cache-size"
+#define CONFIG_OPTION_BUSY_TIMEOUT       "busy-timeout"
+#define CONFIG_OPTION_BUSY_BACKOFF       "busy-backoff"
+#define CONFIG_SECTION_HOTCOPY           "hotcopy"
+#define CONFIG_OPTION_JOBS               "jobs"
+#define CONFIG_OPTION_CLONE_FILES        "clone-files"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_ACCESS_HINTS       "access-hints"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
@@ -127,7 +164,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -188,6 +225,15 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3.
+   Reading it also requires a build with Zstandard support.  Servers that
+   only know format 8 would not be able to read such representations. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 9
+
+/* The minimum format number that stores locks in a SQLite database
+   instead of the digest file tree. */
+#define SVN_FS_FS__MIN_LOCK_DB_FORMAT 9
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -263,6 +309,68 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* Transaction numbers that this process reserved in the txn-current
+     file of the repository at TXN_NUMBERS_PATH but did not use, yet:
+     NEXT_TXN_NUMBER up to but excluding TXN_NUMBERS_END.  Access to these
+     is synchronised under TXN_NUMBERS_LOCK, which may be acquired while
+     holding any of the above locks but not the other way around. */
+  svn_mutex__t *txn_numbers_lock;
+  const char *txn_numbers_path;
+  apr_uint64_t next_txn_number;
+  apr_uint64_t txn_numbers_end;
+
+  /* Fully decoded log-to-phys indexes of packed shards, mapping the
+     shard's first revision to its index.  The indexes themselves are
+     immutable and may be read without synchronization.  Access to this
+     hash, PACKED_L2P_POOL and PACKED_L2P_SIZE is synchronised under
+     PACKED_L2P_LOCK. */
+  apr_hash_t *packed_l2p;
+  svn_mutex__t *packed_l2p_lock;
+
+  /* Sub-pool of COMMON_POOL holding the PACKED_L2P data. */
+  apr_pool_t *packed_l2p_pool;
+
+  /* Approximate number of bytes allocated for PACKED_L2P entries. */
+  apr_size_t packed_l2p_size;
+
+  /* Bloom filter over the keys in rep-cache.db, or NULL if it has not
+     been created, yet.  Allocated in REP_CACHE_FILTER_POOL, a sub-pool
+     of COMMON_POOL.  Access is synchronised under REP_CACHE_FILTER_LOCK.
+     See rep-cache.c for details. */
+  struct rep_cache_filter_t *rep_cache_filter;
+  apr_pool_t *rep_cache_filter_pool;
+  svn_mutex__t *rep_cache_filter_lock;
+
+  /* Cache warm-up state, allocated in COMMON_POOL.  NULL if no FS object
+     for this repository has enabled the warm-up.  See warmup.c. */
+  struct cache_warmup_t *warmup;
+
+  /* Group commit state.  GROUP_COMMIT_WRITTEN is the youngest revision
+     that has been committed through this process and whose 'current'
+     update may not have been flushed to disk, yet.  Everything up to
+     GROUP_COMMIT_SYNCED is known to be durable.  GROUP_COMMIT_RUNNING
+     is set while one of the committers flushes 'current' on behalf of
+     all, during which the others wait for GROUP_COMMIT_COND.  All of
+     these are synchronised under GROUP_COMMIT_LOCK. */
+  svn_mutex__t *group_commit_lock;
+#if APR_HAS_THREADS
+  apr_thread_cond_t *group_commit_cond;
+#endif
+  svn_revnum_t group_commit_written;
+  svn_revnum_t group_commit_synced;
+  svn_boolean_t group_commit_running;
+
+  /* Youngest revision as per the 'current' file, for FS instances that
+     have the "watch-current" option set.  CURRENT_WATCHER tells us when
+     CURRENT_YOUNGEST needs to be refreshed; it may be NULL if change
+     notifications are not available.  CURRENT_WATCHER_CREATED is set once
+     we tried to create it.  All of these are synchronised under
+     CURRENT_LOCK. */
+  svn_mutex__t *current_lock;
+  svn_io__file_watcher_t *current_watcher;
+  svn_boolean_t current_watcher_created;
+  svn_revnum_t current_youngest;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -284,6 +392,19 @@ typedef struct pair_cache_key_t
   apr_int64_t second;
 } pair_cache_key_t;
 
+/* Key type for the chunks of large directories in DIR_CHUNK_CACHE.
+
+   Note: Again, all members are 64 bits wide to prevent padding. */
+typedef struct dir_chunk_cache_key_t
+{
+  /* Revision and item index of the directory representation. */
+  apr_int64_t revision;
+  apr_int64_t item_index;
+
+  /* Number of the chunk within the directory, -1 for the chunk index. */
+  apr_int64_t chunk;
+} dir_chunk_cache_key_t;
+
 /* Key type that identifies a txdelta window.
 
    Note: Cache keys should require no padding. */
@@ -303,7 +424,8 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
@@ -335,6 +457,40 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* If set, hint the OS to read the next windows of all reps in a delta
+   * chain concurrently before we combine them. */
+  svn_boolean_t prefetch_delta_chains;
+
+  /* If set, hint the OS to read the noderevs of all entries of a committed
+   * directory in the background when listing that directory. */
+  svn_boolean_t prefetch_dir_entries;
+
+  /* If set, map rev / pack files into memory and read from there. */
+  svn_boolean_t enable_mmap;
+
+  /* If set, track the youngest revision through change notifications for
+   * the 'current' file instead of reading it every time. */
+  svn_boolean_t watch_current;
+
+  /* If set, concurrent commits within this process share the disk flush
+   * that makes their 'current' file updates durable. */
+  svn_boolean_t group_commit;
+
+  /* If set, commits write the final revision contents before acquiring
+   * the write lock and only move them into place while holding it. */
+  svn_boolean_t optimistic_commit;
+
+  /* Maximum number of shards to copy concurrently when this repository
+   * is the source of a hotcopy.  Always >= 1. */
+  int hotcopy_jobs;
+
+  /* If set, hotcopy may create reflink copies of rev and pack files. */
+  svn_boolean_t hotcopy_clone_files;
+
+  /* Absolute path of the file listing frequently accessed paths to place
+     first when packing.  NULL if not configured. */
+  const char *pack_access_hints;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -348,6 +504,9 @@ typedef struct fs_fs_data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* Maximum size of the on-disk cache file in bytes.  0 disables it. */
+  apr_int64_t persistent_cache_size;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -364,6 +523,12 @@ typedef struct fs_fs_data_t
      names to (svn_fs_dirent_t *). */
   svn_cache__t *dir_cache;
 
+  /* Immutable directories too large for DIR_CACHE get split into sorted
+     chunks of entries, each cached individually as svn_fs_fs__dir_data_t.
+     Chunk -1 lists the first entry of each chunk.  Maps from
+     dir_chunk_cache_key_t. */
+  svn_cache__t *dir_chunk_cache;
+
   /* Fulltext cache; currently only used with memcached.  Maps from
      rep key (revision/offset) to svn_stringbuf_t. */
   svn_cache__t *fulltext_cache;
@@ -417,6 +582,11 @@ typedef struct fs_fs_data_t
      if the node has mergeinfo, "0" if it doesn't. */
   svn_cache__t *mergeinfo_existence_cache;
 
+  /* Cache for svn_fs_closest_copy() results on revision roots; the key is
+     a combination of revision and path; value is "<rev> <path>" of the
+     closest copy destination, or empty if there is none. */
+  svn_cache__t *closest_copy_cache;
+
   /* Cache for l2p_header_t objects; the key is (revision, is-packed).
      Will be NULL for pre-format7 repos */
   svn_cache__t *l2p_header_cache;
@@ -447,12 +617,37 @@ typedef struct fs_fs_data_t
   /* Data shared between all svn_fs_t objects for a given filesystem. */
   fs_fs_shared_data_t *shared;
 
+  /* Packed shard L2P indexes from SHARED->PACKED_L2P that this svn_fs_t
+     already used, keyed by the shard's first revision.  Lets us skip the
+     locking on SHARED.  NULL until first used. */
+  apr_hash_t *packed_l2p;
+
   /* The sqlite database used for rep caching. */
   svn_sqlite__db_t *rep_cache_db;
 
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* The sqlite database holding the locks, if the repository format
+     uses one.  NULL until opened.  See lock.c for details. */
+  svn_sqlite__db_t *lock_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t lock_db_opened;
+
+  /* The sqlite database listing the nodes with mergeinfo.  NULL until
+     opened.  See mergeinfo-index.c for details. */
+  svn_sqlite__db_t *mergeinfo_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t mergeinfo_index_db_opened;
+
+  /* Whether to maintain and use the mergeinfo index. */
+  svn_boolean_t enable_mergeinfo_index;
+
+  /* Tuning options for all of the above SQLite databases. */
+  svn_sqlite__open_options_t sqlite_options;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -468,6 +663,11 @@ typedef struct fs_fs_data_t
   /* Whether packed revprop files shall be compressed. */
   svn_boolean_t compress_packed_revprops;
 
+  /* Size in bytes up to which changes to packed revprops are collected
+   * in an overlay file per shard before merging them into the pack files.
+   * 0 disables the overlay. */
+  apr_int64_t revprop_overlay_size;
+
   /* Whether directory nodes shall be deltified just like file nodes. */
   svn_boolean_t deltify_directories;
 
@@ -481,12 +681,20 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* Deltas between file contents of at least this size (in bytes) that
+   * have to be computed on the fly use content-defined chunking.
+   * 0 disables that. */
+  apr_int64_t cdc_delta_threshold;
+
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
   /* Compression level (currently, only used with compression_type_zlib). */
   int delta_compression_level;
 
+  /* Maximum number of threads to use when compressing delta windows. */
+  int delta_compression_threads;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -502,6 +710,70 @@ typedef struct fs_fs_data_t
   /* Ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
 
+  /* Set while svn_fs_fs__sync() has disabled FLUSH_TO_DISK for new
+     commits.  DEFERRED_FLUSH_TO_DISK is the value to restore afterwards. */
+  svn_boolean_t sync_deferred;
+  svn_boolean_t deferred_flush_to_disk;
+
+  /* Oldest revision committed through this instance that has not been
+     flushed to disk, or SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t unsynced_rev;
+
+  /* Maximum number of shards to pack concurrently.  Always >= 1. */
+  int pack_jobs;
+
+  /* Record the hottest noderevs for the cache warm-up and preload the
+     top-level directories of new revisions, respectively. */
+  svn_boolean_t cache_warmup;
+  svn_boolean_t cache_warmup_on_commit;
+
+  /* Maximum number of shards to verify concurrently.  Always >= 1. */
+  int verify_jobs;
+
+  /* Maximum number of rev / pack files to scan concurrently for
+     svn_fs_fs__get_stats().  Always >= 1. */
+  int stats_jobs;
+
+  /* Maximum number of shards to scan concurrently for
+     svn_fs_fs__build_rep_cache().  Always >= 1. */
+  int build_rep_cache_jobs;
+
+  /* Maximum number of revision files to scan concurrently when
+     svn_fs_fs__recover() looks for the largest node-id and copy-id.
+     Always >= 1. */
+  int recover_jobs;
+
+  /* If set, svn_fs_fs__recover() checks the youngest unpacked shard
+     and trusts the ID counters in 'current' for older revisions. */
+  svn_boolean_t quick_recover;
+
+  /* Number of revisions to collect new rep-cache entries for before
+     writing them to the database.  Always >= 1. */
+  int rep_cache_batch_revs;
+
+  /* Rep-cache entries of revisions committed through this instance that
+     have not been written to the database, yet.  Maps SHA1 digests to
+     representation_t *.  NULL if there are none.  DEFERRED_REVS is the
+     number of revisions they belong to.  Both are allocated in
+     DEFERRED_REPS_POOL, which gets created on demand. */
+  apr_hash_t *deferred_reps;
+  int deferred_revs;
+  apr_pool_t *deferred_reps_pool;
+
+  /* I/O statistics as reported by svn_fs_fs__get_io_stats(), minus the
+     cache counters.  Only updated while IO_STATS_ENABLED is set. */
+  svn_boolean_t io_stats_enabled;
+  svn_fs__io_stats_t io_stats;
+
+  /* Sums of the cache access counters when IO_STATS were last reset. */
+  apr_uint64_t io_stats_cache_gets;
+  apr_uint64_t io_stats_cache_hits;
+
+  /* Stream to write the I/O access trace to.  NULL if not tracing.
+     IO_TRACE_HANDLE is the last file handle number given out. */
+  svn_stream_t *io_trace;
+  int io_trace_handle;
+
   /* Pointer to svn_fs_open. */
   svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
                                apr_pool_t *, apr_pool_t *);
@@ -37,6 +37,7 @@
 #include "cached_data.h"
 #include "id.h"
 #include "index.h"
+#include "lock.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -72,6 +73,17 @@
    Values < 1 disable deltification. */
 #define SVN_FS_FS_MAX_DELTIFICATION_WALK 1023
 
+/* Upper limit for the number of threads used to compress the delta
+   windows of a single representation. */
+#define SVN_FS_FS_MAX_COMPRESSION_THREADS 64
+
+/* Upper limit for the number of shards being packed or verified
+   concurrently. */
+#define SVN_FS_FS_MAX_JOBS 64
+
+/* Upper limit for SVN_FS_CONFIG_FSFS_REP_CACHE_BATCH_REVS. */
+#define SVN_FS_FS_MAX_REP_CACHE_BATCH_REVS 10000
+
 /* Notes:
 
 To avoid opening and closing the rev-files all the time, it would
@@ -692,7 +704,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 |
+                   zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -722,6 +735,25 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < 1 || level > 19)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -747,6 +779,11 @@ read_config(fs_fs_data_t *ffd,
             apr_pool_t *scratch_pool)
 {
   svn_config_t *config;
+  apr_int64_t compression_threads;
+  apr_int64_t hotcopy_jobs;
+  apr_int64_t sqlite_mmap_size;
+  apr_int64_t sqlite_cache_size;
+  apr_int64_t sqlite_busy_timeout;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -788,6 +825,13 @@ read_config(fs_fs_data_t *ffd,
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
     }
 
+  /* This only affects deltas sent to clients, not the repository format. */
+  SVN_ERR(svn_config_get_int64(config, &ffd->cdc_delta_threshold,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_CDC_DELTA_THRESHOLD,
+                               0));
+  ffd->cdc_delta_threshold = MAX(0, ffd->cdc_delta_threshold) * 0x400;
+
   /* Initialize revprop packing settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
     {
@@ -801,13 +845,19 @@ read_config(fs_fs_data_t *ffd,
                                    ffd->compress_packed_revprops
                                        ? 0x40
                                        : 0x10));
+      SVN_ERR(svn_config_get_int64(config, &ffd->revprop_overlay_size,
+                                   CONFIG_SECTION_PACKED_REVPROPS,
+                                   CONFIG_OPTION_REVPROP_OVERLAY_SIZE,
+                                   0));
 
       ffd->revprop_pack_size *= 1024;
+      ffd->revprop_overlay_size = MAX(0, ffd->revprop_overlay_size) * 1024;
     }
   else
     {
       ffd->revprop_pack_size = 0x10000;
       ffd->compress_packed_revprops = FALSE;
+      ffd->revprop_overlay_size = 0;
     }
 
   if (ffd->format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
@@ -848,6 +898,74 @@ read_config(fs_fs_data_t *ffd,
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
     }
 
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_delta_chains,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DELTA_CHAINS,
+                              FALSE));
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_dir_entries,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DIR_ENTRIES,
+                              FALSE));
+  SVN_ERR(svn_config_get_bool(config, &ffd->enable_mmap,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_ENABLE_MMAP,
+                              FALSE));
+  SVN_ERR(svn_config_get_bool(config, &ffd->watch_current,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_WATCH_CURRENT,
+                              FALSE));
+  SVN_ERR(svn_config_get_bool(config, &ffd->group_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_GROUP_COMMIT,
+                              FALSE));
+  SVN_ERR(svn_config_get_bool(config, &ffd->optimistic_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_OPTIMISTIC_COMMIT,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->enable_mergeinfo_index,
+                              CONFIG_SECTION_MERGEINFO,
+                              CONFIG_OPTION_ENABLE_MERGEINFO_INDEX,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->sqlite_options.wal,
+                              CONFIG_SECTION_SQLITE,
+                              CONFIG_OPTION_ENABLE_WAL,
+                              FALSE));
+  SVN_ERR(svn_config_get_int64(config, &sqlite_mmap_size,
+                               CONFIG_SECTION_SQLITE,
+                               CONFIG_OPTION_MMAP_SIZE, 0));
+  ffd->sqlite_options.mmap_size = MAX(0, sqlite_mmap_size) * 0x400;
+  SVN_ERR(svn_config_get_int64(config, &sqlite_cache_size,
+                               CONFIG_SECTION_SQLITE,
+                               CONFIG_OPTION_CACHE_SIZE, 0));
+  ffd->sqlite_options.cache_size = MAX(0, sqlite_cache_size) * 0x400;
+  SVN_ERR(svn_config_get_int64(config, &sqlite_busy_timeout,
+                               CONFIG_SECTION_SQLITE,
+                               CONFIG_OPTION_BUSY_TIMEOUT, 0));
+  ffd->sqlite_options.busy_timeout
+    = (apr_int32_t)MIN(MAX(0, sqlite_busy_timeout), APR_INT32_MAX);
+  SVN_ERR(svn_config_get_bool(config, &ffd->sqlite_options.busy_backoff,
+                              CONFIG_SECTION_SQLITE,
+                              CONFIG_OPTION_BUSY_BACKOFF,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_int64(config, &hotcopy_jobs,
+                               CONFIG_SECTION_HOTCOPY,
+                               CONFIG_OPTION_JOBS, 1));
+  ffd->hotcopy_jobs = (int)MIN(MAX(1, hotcopy_jobs), SVN_FS_FS_MAX_JOBS);
+  SVN_ERR(svn_config_get_bool(config, &ffd->hotcopy_clone_files,
+                              CONFIG_SECTION_HOTCOPY,
+                              CONFIG_OPTION_CLONE_FILES,
+                              TRUE));
+
+  svn_config_get(config, &ffd->pack_access_hints, CONFIG_SECTION_PACK,
+                 CONFIG_OPTION_ACCESS_HINTS, NULL);
+  if (ffd->pack_access_hints)
+    ffd->pack_access_hints = svn_dirent_join(fs_path,
+                                             ffd->pack_access_hints,
+                                             result_pool);
+
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
@@ -890,6 +1008,17 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "filesystem format 9 or higher"));
+              if (!svn__zstd_available())
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' is not "
+                                          "supported by this build"));
+            }
         }
       else if (compression_level_val)
         {
@@ -925,6 +1054,13 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  SVN_ERR(svn_config_get_int64(config, &compression_threads,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_COMPRESSION_THREADS, 1));
+  ffd->delta_compression_threads
+    = (int)MIN(MAX(1, compression_threads),
+               SVN_FS_FS_MAX_COMPRESSION_THREADS);
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -945,6 +1081,15 @@ read_config(fs_fs_data_t *ffd,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  SVN_ERR(svn_config_get_int64(config, &ffd->persistent_cache_size,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_PERSISTENT_CACHE_SIZE,
+                               0));
+  if (ffd->persistent_cache_size < 0)
+    ffd->persistent_cache_size = 0;
+  else
+    ffd->persistent_cache_size *= 0x100000; /* convert MB to bytes */
+
   return SVN_NO_ERROR;
 }
 
@@ -971,12 +1116,30 @@ write_config(svn_fs_t *fs,
 "### no authentication for reads or writes, so you must ensure that your"    NL
 "### memcached servers are only accessible by trusted users."                NL
 ""                                                                           NL
+"[" SVN_CACHE_CONFIG_CATEGORY_MEMCACHED "]"                                  NL
+"### Writes to the memcached servers normally wait for the servers to"       NL
+"### confirm them.  Setting this option makes a background thread send"      NL
+"### them instead.  Writes may then get dropped if the servers can't keep"   NL
+"### up.  Items read from memcached are kept in the in-process cache as"     NL
+"### well such that frequently used items don't cost a network round-trip."  NL
+"# " SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES " = false"                         NL
+""                                                                           NL
 "[" CONFIG_SECTION_CACHES "]"                                                NL
 "### When a cache-related error occurs, normally Subversion ignores it"      NL
 "### and continues, logging an error if the server is appropriately"         NL
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"###"                                                                        NL
+"### To avoid a long warm-up phase after server restarts, fulltexts,"        NL
+"### combined delta windows and mergeinfo lookup results may additionally"   NL
+"### be kept in a file on disk"                                              NL
+"### (db/" PATH_PERSISTENT_CACHE ").  This option specifies the maximum size"   NL
+"### of that file in MB; once it is full, no new data will be added to it."  NL
+"### The file must be writable for all server processes.  Delete it when"    NL
+"### replacing existing revisions, e.g. when restoring from a backup."       NL
+"### The persistent cache is disabled by default."                           NL
+"# " CONFIG_OPTION_PERSISTENT_CACHE_SIZE " = 1024"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -1037,6 +1200,9 @@ write_config(svn_fs_t *fs,
 "### repositories that are dominated by large, changing binaries."           NL
 "### Should be a power of two minus 1.  A value of 0 will effectively"       NL
 "### disable deltification."                                                 NL
+"### Commits will then store new contents as self-compressed fulltexts"      NL
+"### without reading any older revisions.  These are never converted to"     NL
+"### deltas in place later on; see 'svnadmin help pack'."                    NL
 "### For 1.8, the default value is 1023; earlier versions have no limit."    NL
 "# " CONFIG_OPTION_MAX_DELTIFICATION_WALK " = 1023"                          NL
 "###"                                                                        NL
@@ -1055,6 +1221,18 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### When the server sends the difference between two file versions that"   NL
+"### is not stored in the repository as is, e.g. during 'svn update' across" NL
+"### several revisions, it computes a delta on the fly.  The standard"       NL
+"### algorithm only compares data at roughly the same offsets, which fails"  NL
+"### to find most matches once data has been inserted into or removed from"  NL
+"### a large binary file.  Files of at least this size in kBytes will"       NL
+"### instead be compared using content-defined chunking, which finds moved"  NL
+"### blocks anywhere in the file but needs to read the whole source first."  NL
+"### This does not change the repository contents in any way."               NL
+"### The default value is 0, which disables this feature."                   NL
+"# " CONFIG_OPTION_CDC_DELTA_THRESHOLD " = 0"                                NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
@@ -1066,8 +1244,13 @@ write_config(svn_fs_t *fs,
 "### significantly speed up commits as well as reading the data."            NL
 "### lz4 compression algorithm is supported, starting from format 8"         NL
 "### repositories, available in Subversion 1.10 and higher."                 NL
+"### zstd (Zstandard) compresses better than zlib, in particular for small"  NL
+"### text files, and decompresses much faster.  It is only available if"     NL
+"### Subversion has been built with Zstandard support and requires format 9" NL
+"### as well.  Only builds with Zstandard support can read such data."       NL
 "### The syntax of this option is:"                                          NL
-"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9 |" NL
+"###                 zstd | zstd-1 ... zstd-19"                              NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'lz4' if supported by the repository format and"   NL
 "### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
@@ -1079,6 +1262,14 @@ write_config(svn_fs_t *fs,
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### Compressing large files can take a long time.  Since the individual"    NL
+"### delta windows get compressed independently, that work can be spread"    NL
+"### across several threads.  This setting controls the maximum number of"   NL
+"### threads to use per representation.  Files smaller than 100 kBytes"      NL
+"### will always be processed by a single thread."                           NL
+"### The default value is 1, i.e. no additional threads."                    NL
+"# " CONFIG_OPTION_COMPRESSION_THREADS " = 1"                                NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1100,6 +1291,18 @@ write_config(svn_fs_t *fs,
 "### even more so writing, become significantly more CPU intensive."         NL
 "### Compressing packed revprops is disabled by default."                    NL
 "# " CONFIG_OPTION_COMPRESS_PACKED_REVPROPS " = false"                       NL
+"###"                                                                        NL
+"### Changing a packed revprop normally rewrites the whole pack file that"   NL
+"### contains it.  If a non-zero size (in kBytes) is given here, changes"    NL
+"### will instead be appended to an overlay file in the respective packed"  NL
+"### shard.  Once that file grows beyond the given size, its contents get"   NL
+"### merged into the pack files and the overlay file is removed.  This"      NL
+"### makes changing many revprops in packed shards much faster."             NL
+"### Versions prior to Subversion 1.10 do not know about the overlay and"    NL
+"### will not see the changes stored in it.  Changing revprops with this"   NL
+"### option set to 0 merges any existing overlay into the pack files."       NL
+"### The overlay is disabled by default."                                    NL
+"# " CONFIG_OPTION_REVPROP_OVERLAY_SIZE " = 0"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_IO "]"                                                    NL
 "### Parameters in this section control the data access granularity in"      NL
@@ -1147,6 +1350,146 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### When reconstructing a file from a chain of deltas,  the OS may be"      NL
+"### asked to fetch the required data of all deltas in that chain in the"    NL
+"### background and concurrently,  instead of one read after another."       NL
+"### This reduces latency on storage with a high access time or a good"      NL
+"### amount of internal parallelism (NFS, RAID, SSD).  It has no effect on"  NL
+"### platforms that don't support such I/O hints.  Unlike the settings"      NL
+"### above,  this one applies to all repository formats."                    NL
+"### The extra hints cost a system call per delta and window and can evict"  NL
+"### useful data from the OS cache when most deltas are cached anyway."      NL
+"### prefetch-delta-chains is disabled by default."                          NL
+"# " CONFIG_OPTION_PREFETCH_DELTA_CHAINS " = false"                          NL
+"###"                                                                        NL
+"### Tree walks like update reports typically visit all entries of a"        NL
+"### directory right after listing it.  If prefetch-dir-entries is set,"     NL
+"### FSFS will ask the OS to fetch the node revisions of those entries,"     NL
+"### and the data following them,  in the background as soon as the"         NL
+"### directory has been read.  This requires the logical addressing"         NL
+"### introduced in format 7 and is most useful on storage with a high"       NL
+"### access time.  It adds a few index lookups to every directory listing"   NL
+"### and is therefore disabled by default."                                  NL
+"# " CONFIG_OPTION_PREFETCH_DIR_ENTRIES " = false"                           NL
+"###"                                                                        NL
+"### On 64 bit platforms, revision and pack files may be mapped into"        NL
+"### memory.  Representations, node revisions and changed paths lists"       NL
+"### will then be parsed directly from the OS file cache instead of being"   NL
+"### copied through user-space file buffers first.  This can reduce CPU"     NL
+"### load and memory usage of servers with a large,  hot working set."       NL
+"### Revision files must not be modified while being mapped.  Hence, don't"  NL
+"### use this if 'svnfsfs load-index' might run concurrently.  Also, some"   NL
+"### network file systems don't support mapped files well."                  NL
+"### enable-mmap is disabled by default and has no effect on 32 bit hosts."  NL
+"# " CONFIG_OPTION_ENABLE_MMAP " = false"                                    NL
+"###"                                                                        NL
+"### Servers look up the youngest revision very often,  e.g. for every"      NL
+"### 'svn info' or status check of polling clients.  Each lookup reads the"  NL
+"### 'current' file.  If watch-current is set,  the server will instead"     NL
+"### ask the OS to notify it of changes to that file and only read it"       NL
+"### after it has been modified.  This is only supported on some platforms"  NL
+"### (currently Linux) and doesn't work for network file systems that"       NL
+"### get modified by other hosts,  e.g. NFS."                                NL
+"### watch-current is disabled by default."                                  NL
+"# " CONFIG_OPTION_WATCH_CURRENT " = false"                                  NL
+"###"                                                                        NL
+"### When multiple threads of the same server process commit to this"        NL
+"### repository at the same time, they may share the disk flush that makes"  NL
+"### the new 'current' file durable.  Revision and revprop files are still"  NL
+"### flushed for each commit before 'current' gets updated, so a crash can"  NL
+"### at most lose the last few commits that have not been reported as"       NL
+"### successful, yet.  This reduces the number of synchronous writes when"   NL
+"### many small commits come in concurrently but may add a little latency"   NL
+"### to the individual commit.  It has no effect if fsync is disabled."      NL
+"### group-commit is disabled by default."                                   NL
+"# " CONFIG_OPTION_GROUP_COMMIT " = false"                                   NL
+"###"                                                                        NL
+"### Setting optimistic-commit to true makes commits write the new revision" NL
+"### file before they take the repository write lock.  While holding the"    NL
+"### lock, they then only check that the transaction is still up to date"    NL
+"### and move the file into place.  This reduces lock contention between"    NL
+"### large concurrent commits.  A commit that turns out to be out of date"   NL
+"### has to discard the work done before the lock, though.  The option has"  NL
+"### no effect on repositories with format 2 or older."                      NL
+"### optimistic-commit is disabled by default."                              NL
+"# " CONFIG_OPTION_OPTIMISTIC_COMMIT " = false"                              NL
+""                                                                           NL
+"[" CONFIG_SECTION_MERGEINFO "]"                                             NL
+"### Queries for the mergeinfo of all paths below a directory, e.g. during"  NL
+"### merges, have to walk every directory with mergeinfo somewhere below"    NL
+"### it.  With subtree mergeinfo on many paths, that is most of the tree."   NL
+"### Enabling this option makes each commit maintain a SQLite database,"     NL
+"### mergeinfo-index.db, listing all nodes with mergeinfo per revision."     NL
+"### Such queries then use a single index lookup instead.  The index is"     NL
+"### built from the latest revision by the next commit and only covers"      NL
+"### revisions from that point on; older revisions are still crawled."       NL
+"### enable-mergeinfo-index is disabled by default."                         NL
+"# " CONFIG_OPTION_ENABLE_MERGEINFO_INDEX " = false"                         NL
+""                                                                           NL
+"[" CONFIG_SECTION_SQLITE "]"                                                NL
+"### These options tune the SQLite databases of this repository, i.e."       NL
+"### rep-cache.db, locks.db and mergeinfo-index.db."                         NL
+"###"                                                                        NL
+"### With write-ahead logging (WAL), readers of a database don't block"      NL
+"### writers and vice versa, e.g. rep-cache lookups during commits.  It"     NL
+"### needs shared memory between all processes accessing the database and"   NL
+"### will not be used where that is known not to work, e.g. on NFS or SMB."  NL
+"### Once switched to WAL, SQLite versions older than 3.7.0 can't read the"  NL
+"### database until a process without this option switched it back."         NL
+"### enable-wal is disabled by default."                                     NL
+"# " CONFIG_OPTION_ENABLE_WAL " = false"                                     NL
+"###"                                                                        NL
+"### mmap-size makes SQLite read up to that many kBytes of each database"    NL
+"### through a memory mapping instead of individual read calls.  Don't"      NL
+"### enable it on network file systems.  The default is 0, i.e. disabled."   NL
+"# " CONFIG_OPTION_MMAP_SIZE " = 0"                                          NL
+"###"                                                                        NL
+"### cache-size sets the size of the page cache per database connection"     NL
+"### in kBytes.  The default is 0, i.e. the SQLite default of 2 MBytes."     NL
+"# " CONFIG_OPTION_CACHE_SIZE " = 0"                                         NL
+"###"                                                                        NL
+"### busy-timeout is the time in milliseconds to wait for other processes"   NL
+"### to release a database lock.  0 selects the default of 10 seconds."      NL
+"# " CONFIG_OPTION_BUSY_TIMEOUT " = 0"                                       NL
+"###"                                                                        NL
+"### With busy-backoff enabled, lock waits start with very short sleeps"     NL
+"### which grow exponentially, instead of SQLite's coarser default steps."   NL
+"### This helps with many short, concurrent transactions."                   NL
+"### busy-backoff is disabled by default."                                   NL
+"# " CONFIG_OPTION_BUSY_BACKOFF " = false"                                   NL
+""                                                                           NL
+"[" CONFIG_SECTION_HOTCOPY "]"                                               NL
+"### These options apply when this repository is the source of a hotcopy."   NL
+"###"                                                                        NL
+"### Shards can be copied concurrently, which may help on storage with a"    NL
+"### good amount of internal parallelism (RAID, SSD, network storage)."      NL
+"### The destination will still be updated in revision order.  This sets"    NL
+"### the maximum number of shards being copied at the same time."            NL
+"### The default value is 1, i.e. no additional threads."                    NL
+"# " CONFIG_OPTION_JOBS " = 1"                                               NL
+"###"                                                                        NL
+"### On file systems that support it (e.g. Btrfs or XFS), revision and"      NL
+"### pack files may be cloned instead of copied.  The hotcopy will then"     NL
+"### share its data blocks with the source until either one gets modified."  NL
+"### This makes hotcopies almost instantaneous but the copy will not"        NL
+"### protect against damage to the underlying storage.  Disable this if"     NL
+"### the hotcopy serves as a backup on the same file system."                NL
+"### clone-files is enabled by default."                                     NL
+"# " CONFIG_OPTION_CLONE_FILES " = true"                                     NL
+""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### Packing usually places the latest version of every node and its delta"  NL
+"### chain at the front of the pack file, in path order.  You may give it"   NL
+"### a list of frequently read paths, e.g. recorded from the server's"       NL
+"### operational log.  Nodes at or below these paths will then be placed"    NL
+"### first, such that e.g. a checkout of a busy branch reads fewer blocks."  NL
+"### The file contains one path per line, optionally preceded by an access"  NL
+"### count followed by whitespace.  Paths with higher counts are placed"     NL
+"### first.  Empty lines and lines starting with '#' are ignored."           NL
+"### Relative file names are relative to the db/ directory."                 NL
+"### No access hints are used by default."                                   NL
+"# " CONFIG_OPTION_ACCESS_HINTS " = pack-hints.txt"                          NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1160,12 +1503,34 @@ write_config(svn_fs_t *fs,
                             fsfs_conf_contents, pool);
 }
 
+/* Set *JOBS to the number of concurrent jobs given for KEY in CONFIG.
+ * Default to 1 if CONFIG does not specify KEY. */
+static svn_error_t *
+read_jobs_option(int *jobs,
+                 apr_hash_t *config,
+                 const char *key)
+{
+  const char *value = svn_hash__get_cstring(config, key, NULL);
+
+  *jobs = 1;
+  if (value)
+    {
+      apr_int64_t number;
+      SVN_ERR(svn_cstring_strtoi64(&number, value, 0,
+                                   SVN_FS_FS_MAX_JOBS, 10));
+      *jobs = (int)MAX(1, number);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read / Evaluate the global configuration in FS->CONFIG to set up
  * parameters in FS. */
 static svn_error_t *
 read_global_config(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  const char *value;
 
   ffd->use_block_read = svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_FSFS_BLOCK_READ,
@@ -1173,6 +1538,38 @@ read_global_config(svn_fs_t *fs)
   ffd->flush_to_disk = !svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                                            FALSE);
+  ffd->cache_warmup = svn_hash__get_bool(fs->config,
+                                         SVN_FS_CONFIG_FSFS_CACHE_WARMUP,
+                                         FALSE);
+  ffd->cache_warmup_on_commit
+    = svn_hash__get_bool(fs->config,
+                         SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT, FALSE);
+
+  SVN_ERR(read_jobs_option(&ffd->pack_jobs, fs->config,
+                           SVN_FS_CONFIG_FSFS_PACK_JOBS));
+  SVN_ERR(read_jobs_option(&ffd->verify_jobs, fs->config,
+                           SVN_FS_CONFIG_FSFS_VERIFY_JOBS));
+  SVN_ERR(read_jobs_option(&ffd->stats_jobs, fs->config,
+                           SVN_FS_CONFIG_FSFS_STATS_JOBS));
+  SVN_ERR(read_jobs_option(&ffd->build_rep_cache_jobs, fs->config,
+                           SVN_FS_CONFIG_FSFS_BUILD_REP_CACHE_JOBS));
+  SVN_ERR(read_jobs_option(&ffd->recover_jobs, fs->config,
+                           SVN_FS_CONFIG_FSFS_RECOVER_JOBS));
+  ffd->quick_recover = svn_hash__get_bool(fs->config,
+                                          SVN_FS_CONFIG_FSFS_QUICK_RECOVER,
+                                          FALSE);
+
+  value = svn_hash__get_cstring(fs->config,
+                                SVN_FS_CONFIG_FSFS_REP_CACHE_BATCH_REVS,
+                                NULL);
+  ffd->rep_cache_batch_revs = 1;
+  if (value)
+    {
+      apr_int64_t number;
+      SVN_ERR(svn_cstring_strtoi64(&number, value, 0,
+                                   SVN_FS_FS_MAX_REP_CACHE_BATCH_REVS, 10));
+      ffd->rep_cache_batch_revs = (int)MAX(1, number);
+    }
 
   /* Ignore the user-specified larger block size if we don't use block-read.
      Defaulting to 4k gives us the same access granularity in format 7 as in
@@ -1372,6 +1769,12 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                                pool));
     }
 
+  /* Move the locks into a database.  Until the format bump, older
+     servers will keep using the digest tree, so remove it only after
+     that. */
+  if (format < SVN_FS_FS__MIN_LOCK_DB_FORMAT)
+    SVN_ERR(svn_fs_fs__create_lock_db(fs, pool));
+
   /* We will need the UUID info shortly ...
      Read it before the format bump as the UUID file still uses the old
      format. */
@@ -1396,6 +1799,9 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                        svn_fs_upgrade_format_bumped,
                                        pool));
 
+  if (format < SVN_FS_FS__MIN_LOCK_DB_FORMAT)
+    SVN_ERR(svn_fs_fs__remove_lock_digests(fs, pool));
+
   /* Now, it is safe to remove the redundant revprop files. */
   if (needs_revprop_shard_cleanup)
     SVN_ERR(svn_fs_fs__upgrade_cleanup_pack_revprops(fs,
@@ -1442,6 +1848,44 @@ get_youngest(svn_revnum_t *youngest_p,
 }
 
 
+/* Implement get_youngest for FS using the shared youngest revision that
+   gets refreshed upon change notifications for the 'current' file.
+   The caller must hold the CURRENT_LOCK.  Use POOL for temporaries. */
+static svn_error_t *
+get_watched_youngest(svn_revnum_t *youngest_p,
+                     svn_fs_t *fs,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  svn_boolean_t changed = TRUE;
+
+  /* Start watching before reading 'current' for the first time such that
+     we won't miss any modification after that. */
+  if (!ffsd->current_watcher_created)
+    {
+      SVN_ERR(svn_io__file_watcher_create(&ffsd->current_watcher,
+                                          svn_fs_fs__path_current(fs, pool),
+                                          ffsd->common_pool, pool));
+      ffsd->current_watcher_created = TRUE;
+    }
+  else if (ffsd->current_watcher)
+    {
+      changed = svn_io__file_watcher_changed(ffsd->current_watcher);
+    }
+
+  if (changed || !SVN_IS_VALID_REVNUM(ffsd->current_youngest))
+    {
+      /* Don't keep a value that we could not read. */
+      ffsd->current_youngest = SVN_INVALID_REVNUM;
+      SVN_ERR(get_youngest(&ffsd->current_youngest, fs, pool));
+    }
+
+  *youngest_p = ffsd->current_youngest;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__youngest_rev(svn_revnum_t *youngest_p,
                         svn_fs_t *fs,
@@ -1449,7 +1893,12 @@ svn_fs_fs__youngest_rev(svn_revnum_t *youngest_p,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
-  SVN_ERR(get_youngest(youngest_p, fs, pool));
+  if (ffd->watch_current && ffd->shared)
+    SVN_MUTEX__WITH_LOCK(ffd->shared->current_lock,
+                         get_watched_youngest(youngest_p, fs, pool));
+  else
+    SVN_ERR(get_youngest(youngest_p, fs, pool));
+
   ffd->youngest_rev_cache = *youngest_p;
 
   return SVN_NO_ERROR;
@@ -1901,6 +2350,10 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
                                  pool));
     }
 
+  /* Create the (empty) lock database. */
+  if (format >= SVN_FS_FS__MIN_LOCK_DB_FORMAT)
+    SVN_ERR(svn_fs_fs__create_lock_db(fs, pool));
+
   ffd->youngest_rev_cache = 0;
   return SVN_NO_ERROR;
 }
@@ -2317,10 +2770,11 @@ svn_fs_fs__info_format(int *fs_format,
       (*supports_version)->minor = 9;
       break;
     case 8:
+    case 9:
       (*supports_version)->minor = 10;
       break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -48,6 +48,27 @@ svn_error_t *svn_fs_fs__initialize_shared_data(svn_fs_t *fs,
                                                apr_pool_t *pool,
                                                apr_pool_t *common_pool);
 
+/* Open another instance of the already opened filesystem FS and return
+   it in *INSTANCE_P.  The new instance shares FS' configuration and its
+   process-wide data but has its own caches and file handles, i.e. it
+   may be used by a different thread than FS.  Allocate the instance in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                                      svn_fs_t *fs,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
+/* Set up VIEW, of which only the pool, config and warning members have
+   been initialized, as another instance of the already opened
+   filesystem FS without reading any of its files again.  FS is not
+   modified and may be used by another thread at the same time.  Use
+   SCRATCH_POOL for temporary allocations.
+
+   This implements the fs_vtable_t.open_view() API. */
+svn_error_t *svn_fs_fs__open_view(svn_fs_t *view,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *scratch_pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
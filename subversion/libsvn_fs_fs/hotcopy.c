@@ -19,9 +19,14 @@
  *    under the License.
  * ====================================================================
  */
+
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
@@ -38,12 +43,15 @@
  * the destination and do not differ in terms of kind, size, and mtime.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change
  * the value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not
- * required. */
+ * required.  The contents will be copied in kernel space where possible.
+ * If ALLOW_CLONE is set, the copy may share its data blocks with the
+ * source file. */
 static svn_error_t *
 hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
                          const char *src_path,
                          const char *dst_path,
                          const char *file,
+                         svn_boolean_t allow_clone,
                          apr_pool_t *scratch_pool)
 {
   const svn_io_dirent2_t *src_dirent;
@@ -52,6 +60,7 @@ hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
   const char *dst_target;
 
   /* Does the destination already exist? If not, we must copy it. */
+  src_target = svn_dirent_join(src_path, file, scratch_pool);
   dst_target = svn_dirent_join(dst_path, file, scratch_pool);
   SVN_ERR(svn_io_stat_dirent2(&dst_dirent, dst_target, FALSE, TRUE,
                               scratch_pool, scratch_pool));
@@ -59,7 +68,6 @@ hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
     {
       /* If the destination's stat information indicates that the file
        * is equal to the source, don't bother copying the file again. */
-      src_target = svn_dirent_join(src_path, file, scratch_pool);
       SVN_ERR(svn_io_stat_dirent2(&src_dirent, src_target, FALSE, FALSE,
                                   scratch_pool, scratch_pool));
       if (src_dirent->kind == dst_dirent->kind &&
@@ -72,8 +80,11 @@ hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
   if (skipped_p)
     *skipped_p = FALSE;
 
-  return svn_error_trace(svn_io_dir_file_copy(src_path, dst_path, file,
-                                              scratch_pool));
+  return svn_error_trace(svn_io_copy_file2(src_target, dst_target,
+                                           SVN_IO_COPY_FILE_PERMS
+                                           | (allow_clone
+                                              ? SVN_IO_COPY_FILE_CLONE : 0),
+                                           NULL, scratch_pool));
 }
 
 /* Set *NAME_P to the UTF-8 representation of directory entry NAME.
@@ -115,13 +126,15 @@ entry_name_to_utf8(const char **name_p,
  * exist in the destination and do not differ from the source in terms of
  * kind, size, and mtime. Set *SKIPPED_P to FALSE only if at least one
  * file was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required. */
+ * SKIPPED_P may be NULL if not required.  ALLOW_CLONE is as for
+ * hotcopy_io_dir_file_copy(). */
 static svn_error_t *
 hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                 const char *src,
                                 const char *dst_parent,
                                 const char *dst_basename,
                                 svn_boolean_t copy_perms,
+                                svn_boolean_t allow_clone,
                                 svn_cancel_func_t cancel_func,
                                 void *cancel_baton,
                                 apr_pool_t *pool)
@@ -185,7 +198,8 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
           if (this_entry.filetype == APR_REG) /* regular file */
             {
               SVN_ERR(hotcopy_io_dir_file_copy(skipped_p, src, dst_path,
-                                               entryname_utf8, subpool));
+                                               entryname_utf8, allow_clone,
+                                               subpool));
             }
           else if (this_entry.filetype == APR_LNK) /* symlink */
             {
@@ -213,6 +227,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                                       dst_path,
                                                       entryname_utf8,
                                                       copy_perms,
+                                                      allow_clone,
                                                       cancel_func,
                                                       cancel_baton,
                                                       subpool));
@@ -241,6 +256,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
  * to DST_SUBDIR. Assume a sharding layout based on MAX_FILES_PER_DIR.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change the
  * value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not required.
+ * ALLOW_CLONE is as for hotcopy_io_dir_file_copy().
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
@@ -248,6 +264,7 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
                         const char *dst_subdir,
                         svn_revnum_t rev,
                         int max_files_per_dir,
+                        svn_boolean_t allow_clone,
                         apr_pool_t *scratch_pool)
 {
   const char *src_subdir_shard = src_subdir,
@@ -271,7 +288,7 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
   SVN_ERR(hotcopy_io_dir_file_copy(skipped_p,
                                    src_subdir_shard, dst_subdir_shard,
                                    apr_psprintf(scratch_pool, "%ld", rev),
-                                   scratch_pool));
+                                   allow_clone, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -279,15 +296,17 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
+ *
+ * This only reads the configuration of SRC_FS and the paths of both
+ * filesystems, i.e. it may be called from a worker thread.  Use
+ * hotcopy_finish_packed_shard() to make the shard visible in DST_FS.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -312,6 +331,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
   SVN_ERR(hotcopy_io_copy_dir_recursively(skipped_p, src_subdir_packed_shard,
                                           dst_subdir, packed_shard,
                                           TRUE /* copy_perms */,
+                                          src_ffd->hotcopy_clone_files,
                                           NULL /* cancel_func */, NULL,
                                           scratch_pool));
 
@@ -332,6 +352,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
 
           SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                           revprop_rev, max_files_per_dir,
+                                          src_ffd->hotcopy_clone_files,
                                           iterpool));
         }
       svn_pool_destroy(iterpool);
@@ -342,6 +363,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
       if (rev == 0)
         SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                         0, max_files_per_dir,
+                                        src_ffd->hotcopy_clone_files,
                                         scratch_pool));
 
       /* packed revprops folder */
@@ -353,19 +375,11 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               src_subdir_packed_shard,
                                               dst_subdir, packed_shard,
                                               TRUE /* copy_perms */,
+                                              src_ffd->hotcopy_clone_files,
                                               NULL /* cancel_func */, NULL,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
-    {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -532,6 +546,344 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* Parameters and state of hotcopy_revisions() that are shared by its
+ * helper functions. */
+typedef struct revisions_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+
+  /* Youngest revision in DST_FS before this hotcopy started. */
+  svn_revnum_t dst_youngest;
+  svn_boolean_t incremental;
+
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+
+  /* Shard size of both filesystems. */
+  int max_files_per_dir;
+
+  svn_fs_hotcopy_notify_t notify_func;
+  void* notify_baton;
+  svn_cancel_func_t cancel_func;
+  void* cancel_baton;
+
+  /* The current min-unpacked-rev of DST_FS. */
+  svn_revnum_t dst_min_unpacked_rev;
+} revisions_baton_t;
+
+/* After the packed shard starting at revision REV has been copied by
+ * hotcopy_copy_packed_shard(), make it visible in BATON->DST_FS, notify
+ * the caller unless SKIPPED is set and remove revision files which are
+ * now obsolete in DST_FS.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_finish_packed_shard(revisions_baton_t *baton,
+                            svn_revnum_t rev,
+                            svn_boolean_t skipped,
+                            apr_pool_t *scratch_pool)
+{
+  svn_fs_t *dst_fs = baton->dst_fs;
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  int max_files_per_dir = baton->max_files_per_dir;
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (baton->dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      baton->dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                baton->dst_min_unpacked_rev,
+                                                scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > baton->dst_youngest)
+    {
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                       scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (baton->notify_func && !skipped)
+    baton->notify_func(baton->notify_baton, rev, pack_end_rev,
+                       scratch_pool);
+
+  /* Remove revision files which are now packed. */
+  if (baton->incremental)
+    {
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
+                                       rev + max_files_per_dir,
+                                       max_files_per_dir, scratch_pool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                             rev + max_files_per_dir,
+                                             max_files_per_dir,
+                                             scratch_pool));
+    }
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, scratch_pool),
+                        baton->cancel_func, baton->cancel_baton,
+                        scratch_pool));
+  if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                         scratch_pool),
+                          baton->cancel_func, baton->cancel_baton,
+                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the rev and revprop files of the non-packed revision REV as
+ * described by BATON.  Set *SKIPPED_P to FALSE only if at least one of
+ * them was copied.  Like hotcopy_copy_packed_shard(), this may be called
+ * from a worker thread.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_revision(svn_boolean_t *skipped_p,
+                      const revisions_baton_t *baton,
+                      svn_revnum_t rev,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *src_ffd = baton->src_fs->fsap_data;
+
+  /* Copying non-packed revisions is racy in case the source repository is
+   * being packed concurrently with this hotcopy operation. The race can
+   * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
+   * support packed revisions. With the pack lock, however, the race is
+   * impossible, because hotcopy and pack operations block each other.
+   *
+   * We assume that all revisions coming after 'min-unpacked-rev' really
+   * are unpacked and that's not necessarily true with concurrent packing.
+   * Don't try to be smart in this edge case, because handling it properly
+   * might require copying *everything* from the start. Just abort the
+   * hotcopy with an ENOENT (revision file moved to a pack, so it is no
+   * longer where we expect it to be). */
+
+  /* Copy the rev file. */
+  SVN_ERR(hotcopy_copy_shard_file(skipped_p,
+                                  baton->src_revs_dir, baton->dst_revs_dir,
+                                  rev, baton->max_files_per_dir,
+                                  src_ffd->hotcopy_clone_files,
+                                  scratch_pool));
+  /* Copy the revprop file. */
+  SVN_ERR(hotcopy_copy_shard_file(skipped_p,
+                                  baton->src_revprops_dir,
+                                  baton->dst_revprops_dir,
+                                  rev, baton->max_files_per_dir,
+                                  src_ffd->hotcopy_clone_files,
+                                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* After the non-packed revision REV has been copied by
+ * hotcopy_copy_revision(), checkpoint the progress in BATON->DST_FS if
+ * necessary and notify the caller unless SKIPPED is set.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_finish_revision(revisions_baton_t *baton,
+                        svn_revnum_t rev,
+                        svn_boolean_t skipped,
+                        apr_pool_t *scratch_pool)
+{
+  int max_files_per_dir = baton->max_files_per_dir;
+
+  /* Whenever this revision did not previously exist in the destination,
+   * checkpoint the progress via 'current' (do that once per full shard
+   * in order not to slow things down). */
+  if (rev > baton->dst_youngest)
+    {
+      if (max_files_per_dir && (rev % max_files_per_dir == 0))
+        {
+          SVN_ERR(svn_fs_fs__write_current(baton->dst_fs, rev, 0, 0,
+                                           scratch_pool));
+        }
+    }
+
+  if (baton->notify_func && !skipped)
+    baton->notify_func(baton->notify_baton, rev, rev, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of non-packed revisions to copy per task in non-sharded
+ * repositories. */
+#define REVISIONS_PER_TASK 1000
+
+/* A range of revisions being copied concurrently with others.  This is
+ * either a packed shard or (part of) a shard of non-packed revisions. */
+typedef struct copy_task_t
+{
+  /* Describes the hotcopy.  The tasks only read the constant members. */
+  const revisions_baton_t *baton;
+
+  /* The first revision and the number of revisions to copy. */
+  svn_revnum_t start_rev;
+  int count;
+
+  /* Whether START_REV is the beginning of a packed shard. */
+  svn_boolean_t packed;
+} copy_task_t;
+
+/* Result of a copy_task_t. */
+typedef struct copy_result_t
+{
+  /* The task that produced this result. */
+  const copy_task_t *task;
+
+  /* For packed shards, a single flag telling whether the shard had been
+     skipped.  Otherwise, one such flag per revision. */
+  svn_boolean_t *skipped;
+} copy_result_t;
+
+/* Implements svn_task__process_func_t.  Copy the revisions of the
+ * copy_task_t in PROCESS_BATON and return a copy_result_t in *RESULT. */
+static svn_error_t *
+copy_revisions_task(void **result,
+                    void *process_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const copy_task_t *task = process_baton;
+  const revisions_baton_t *baton = task->baton;
+  copy_result_t *copy_result = apr_pcalloc(result_pool,
+                                           sizeof(*copy_result));
+  int i;
+
+  copy_result->task = task;
+  copy_result->skipped = apr_palloc(result_pool, task->count
+                                    * sizeof(*copy_result->skipped));
+  for (i = 0; i < task->count; ++i)
+    copy_result->skipped[i] = TRUE;
+
+  if (task->packed)
+    {
+      SVN_ERR(hotcopy_copy_packed_shard(&copy_result->skipped[0],
+                                        baton->src_fs, baton->dst_fs,
+                                        task->start_rev,
+                                        baton->max_files_per_dir,
+                                        scratch_pool));
+    }
+  else
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+      for (i = 0; i < task->count; ++i)
+        {
+          svn_pool_clear(iterpool);
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(hotcopy_copy_revision(&copy_result->skipped[i], baton,
+                                        task->start_rev + i, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  *result = copy_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Update the hotcopy destination
+ * described by the revisions_baton_t in OUTPUT_BATON according to the
+ * copy_result_t in RESULT. */
+static svn_error_t *
+finish_copy_task(void *result,
+                 void *output_baton,
+                 apr_pool_t *scratch_pool)
+{
+  copy_result_t *copy_result = result;
+  const copy_task_t *task = copy_result->task;
+  revisions_baton_t *baton = output_baton;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (task->packed)
+    return svn_error_trace(hotcopy_finish_packed_shard(
+                             baton, task->start_rev, copy_result->skipped[0],
+                             scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < task->count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(hotcopy_finish_revision(baton, task->start_rev + i,
+                                      copy_result->skipped[i], iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the packed shards below SRC_MIN_UNPACKED_REV as well as all
+ * revisions from there up to and including SRC_YOUNGEST as described by
+ * BATON, with up to JOBS ranges of revisions being copied concurrently.
+ * The results will be made visible in BATON->DST_FS strictly in revision
+ * order, just like the sequential code in hotcopy_revisions() does.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_revisions_parallel(revisions_baton_t *baton,
+                           svn_revnum_t src_min_unpacked_rev,
+                           svn_revnum_t src_youngest,
+                           int jobs,
+                           apr_pool_t *pool)
+{
+  int max_files_per_dir = baton->max_files_per_dir;
+  int revs_per_task = max_files_per_dir ? max_files_per_dir
+                                        : REVISIONS_PER_TASK;
+  apr_pool_t *set_pool = svn_pool_create(pool);
+  svn_task__set_t *set;
+  svn_revnum_t rev = 0;
+
+  SVN_ERR(svn_task__set_create(&set, jobs, finish_copy_task, baton,
+                               baton->cancel_func, baton->cancel_baton,
+                               set_pool));
+
+  /* Packed shards come first, followed by the non-packed revisions,
+     at most one shard per task. */
+  while (rev <= src_youngest)
+    {
+      copy_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      task->baton = baton;
+      task->start_rev = rev;
+      if (rev < src_min_unpacked_rev)
+        {
+          task->count = max_files_per_dir;
+          task->packed = TRUE;
+        }
+      else
+        {
+          svn_revnum_t end_rev = (rev / revs_per_task + 1) * revs_per_task;
+          if (end_rev > src_youngest + 1)
+            end_rev = src_youngest + 1;
+
+          task->count = (int)(end_rev - rev);
+        }
+
+      rev += task->count;
+      SVN_ERR(svn_task__add(set, copy_revisions_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
@@ -557,8 +909,8 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   int max_files_per_dir = src_ffd->max_files_per_dir;
+  revisions_baton_t baton;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
   svn_revnum_t rev;
@@ -596,6 +948,32 @@ hotcopy_revisions(svn_fs_t *src_fs,
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
+  baton.src_fs = src_fs;
+  baton.dst_fs = dst_fs;
+  baton.dst_youngest = dst_youngest;
+  baton.incremental = incremental;
+  baton.src_revs_dir = src_revs_dir;
+  baton.dst_revs_dir = dst_revs_dir;
+  baton.src_revprops_dir = src_revprops_dir;
+  baton.dst_revprops_dir = dst_revprops_dir;
+  baton.max_files_per_dir = max_files_per_dir;
+  baton.notify_func = notify_func;
+  baton.notify_baton = notify_baton;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+  baton.dst_min_unpacked_rev = dst_min_unpacked_rev;
+
+  /* Copy multiple shards concurrently if we have been asked to. */
+  if (src_ffd->hotcopy_jobs > 1)
+    {
+      SVN_ERR(hotcopy_revisions_parallel(&baton, src_min_unpacked_rev,
+                                         src_youngest, src_ffd->hotcopy_jobs,
+                                         pool));
+      SVN_ERR_ASSERT(src_min_unpacked_rev == baton.dst_min_unpacked_rev);
+
+      return SVN_NO_ERROR;
+    }
+
   /*
    * Copy the necessary rev files.
    */
@@ -605,66 +983,24 @@ hotcopy_revisions(svn_fs_t *src_fs,
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
       svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
+      /* Copy the packed shard and make it visible. */
+      SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
                                         rev, max_files_per_dir,
                                         iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
-                                           iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
-        {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
-        }
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
+      SVN_ERR(hotcopy_finish_packed_shard(&baton, rev, skipped, iterpool));
     }
 
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
   SVN_ERR_ASSERT(rev == src_min_unpacked_rev);
-  SVN_ERR_ASSERT(src_min_unpacked_rev == dst_min_unpacked_rev);
+  SVN_ERR_ASSERT(src_min_unpacked_rev == baton.dst_min_unpacked_rev);
 
   /* Now, copy pairs of non-packed revisions and revprop files.
    * If necessary, update 'current' after copying all files from a shard. */
@@ -677,44 +1013,8 @@ hotcopy_revisions(svn_fs_t *src_fs,
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copying non-packed revisions is racy in case the source repository is
-       * being packed concurrently with this hotcopy operation. The race can
-       * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
-       * support packed revisions. With the pack lock, however, the race is
-       * impossible, because hotcopy and pack operations block each other.
-       *
-       * We assume that all revisions coming after 'min-unpacked-rev' really
-       * are unpacked and that's not necessarily true with concurrent packing.
-       * Don't try to be smart in this edge case, because handling it properly
-       * might require copying *everything* from the start. Just abort the
-       * hotcopy with an ENOENT (revision file moved to a pack, so it is no
-       * longer where we expect it to be). */
-
-      /* Copy the rev file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
-                                      iterpool));
-      /* Copy the revprop file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revprops_dir, dst_revprops_dir,
-                                      rev, max_files_per_dir,
-                                      iterpool));
-
-      /* Whenever this revision did not previously exist in the destination,
-       * checkpoint the progress via 'current' (do that once per full shard
-       * in order not to slow things down). */
-      if (rev > dst_youngest)
-        {
-          if (max_files_per_dir && (rev % max_files_per_dir == 0))
-            {
-              SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0,
-                                               iterpool));
-            }
-        }
-
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, rev, iterpool);
+      SVN_ERR(hotcopy_copy_revision(&skipped, &baton, rev, iterpool));
+      SVN_ERR(hotcopy_finish_revision(&baton, rev, skipped, iterpool));
     }
   svn_pool_destroy(iterpool);
 
@@ -747,6 +1047,7 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
                       void* cancel_baton,
                       apr_pool_t *pool)
 {
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_revnum_t rev;
 
@@ -761,10 +1062,12 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
 
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revs_dir, dst_revs_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
+                                       src_ffd->hotcopy_clone_files,
                                        iterpool));
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revprops_dir,
                                        dst_revprops_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
+                                       src_ffd->hotcopy_clone_files,
                                        iterpool));
 
       if (notify_func && !skipped)
@@ -959,12 +1262,25 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* Same for the lock database used by newer formats instead of the
+   * locks tree.  Copy it after the tree, so that we get all locks even
+   * if the source got upgraded in the meantime. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_LOCKS_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_LOCKS_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+    }
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
   if (kind == svn_node_dir)
     SVN_ERR(hotcopy_io_copy_dir_recursively(NULL, src_subdir, dst_fs->path,
-                                            PATH_NODE_ORIGINS_DIR, TRUE,
+                                            PATH_NODE_ORIGINS_DIR, TRUE, FALSE,
                                             cancel_func, cancel_baton, pool));
 
   /*
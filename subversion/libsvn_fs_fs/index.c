@@ -33,6 +33,7 @@
 #include "private/svn_temp_serializer.h"
 
 #include "index.h"
+#include "io_stats.h"
 #include "pack.h"
 #include "temp_serializer.h"
 #include "util.h"
@@ -186,6 +187,9 @@ struct svn_fs_fs__packed_number_stream_t
   /* underlying data file containing the packed values */
   apr_file_t *file;
 
+  /* rev / pack file that FILE belongs to */
+  svn_fs_fs__revision_file_t *rev_file;
+
   /* Offset within FILE at which the stream data starts
    * (i.e. which offset will reported as offset 0 by packed_stream_offset). */
   apr_off_t stream_start;
@@ -288,6 +292,9 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
     return stream_error_create(stream, err,
       _("Can't read index file '%s' at offset 0x%s"));
 
+  svn_fs_fs__io_stats_read(stream->rev_file, stream->next_offset,
+                           bytes_read);
+
   /* if the last number is incomplete, trim it from the buffer */
   while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
     --bytes_read;
@@ -344,13 +351,13 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 }
 
 /* Create and open a packed number stream reading from offsets START to
- * END in FILE and return it in *STREAM.  Access the file in chunks of
+ * END in REV_FILE and return it in *STREAM.  Access the file in chunks of
  * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
  * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
-                   apr_file_t *file,
+                   svn_fs_fs__revision_file_t *rev_file,
                    apr_off_t start,
                    apr_off_t end,
                    const char *stream_prefix,
@@ -367,10 +374,11 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   SVN_ERR_ASSERT(len < sizeof(buffer));
 
   /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
+  SVN_ERR(svn_io_file_aligned_seek(rev_file->file, block_size, NULL, start,
                                    scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, len, NULL, NULL,
                                  scratch_pool));
+  svn_fs_fs__io_stats_read(rev_file, start, len);
 
   if (strncmp(buffer, stream_prefix, len))
     return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
@@ -382,7 +390,8 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   result = apr_palloc(result_pool, sizeof(*result));
 
   result->pool = result_pool;
-  result->file = file;
+  result->file = rev_file->file;
+  result->rev_file = rev_file;
   result->stream_start = start + len;
   result->stream_end = end;
 
@@ -946,7 +955,7 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
@@ -1521,6 +1530,327 @@ l2p_entry_access_func(void **out,
   return l2p_page_get_entry(baton, page, offsets, result_pool);
 }
 
+/*
+ * In-process log-to-phys index for packed shards
+ */
+
+/* Upper limit for the memory used by all packed_l2p_t instances of any
+ * given repository. */
+#define PACKED_L2P_MAX_SIZE (64 * 1024 * 1024)
+
+/* Immutable, fully decoded log-to-phys index of a packed shard.
+ * Instances are shared among all svn_fs_t of the same repository within
+ * the process.  Since pack files never change, neither do their indexes
+ * and we can read them without any synchronization.
+ */
+typedef struct packed_l2p_t
+{
+  /* first revision covered by this index */
+  svn_revnum_t first_revision;
+
+  /* number of revisions covered */
+  apr_size_t revision_count;
+
+  /* The items of revision FIRST_REVISION + N are at indexes ITEM_START[N]
+   * up to but not including ITEM_START[N+1] in the offsets array. */
+  apr_uint32_t *item_start;
+
+  /* Pack file offset + 1 of each item, 0 for unused item indexes.
+   * Only one of these is being used, depending on the pack file size. */
+  apr_uint32_t *offsets32;
+  apr_uint64_t *offsets64;
+} packed_l2p_t;
+
+/* Value stored in fs_fs_data_t.PACKED_L2P for shards that don't have
+ * a packed_l2p_t. */
+static const packed_l2p_t no_packed_l2p = { 0 };
+
+/* Forward declaration. */
+static svn_error_t *
+get_l2p_header(l2p_header_t **header,
+               svn_fs_fs__revision_file_t *rev_file,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool);
+
+/* Read the complete log-to-phys index of the pack file REV_FILE in FS and
+ * return it in *INDEX, allocated in RESULT_POOL.  Its approximate size
+ * will be returned in *SIZE.  Set *INDEX to NULL if the index cannot be
+ * represented as packed_l2p_t.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_packed_l2p(packed_l2p_t **index,
+                apr_size_t *size,
+                svn_fs_fs__revision_file_t *rev_file,
+                svn_fs_t *fs,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  l2p_header_t *header;
+  packed_l2p_t *result;
+  apr_uint64_t item_count = 0;
+  apr_uint32_t item;
+  apr_size_t i, page;
+  svn_boolean_t wide;
+  apr_pool_t *iterpool;
+
+  *index = NULL;
+  *size = 0;
+
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  SVN_ERR(get_l2p_header(&header, rev_file, fs, rev_file->start_revision,
+                         scratch_pool, scratch_pool));
+
+  /* Only the last page of each revision may be partially filled.
+   * Otherwise, we could not simply concatenate the pages. */
+  for (i = 0; i < header->revision_count; ++i)
+    {
+      apr_size_t first_page = header->page_table_index[i];
+      apr_size_t last_page = header->page_table_index[i + 1];
+
+      /* Revisions without pages have no items. */
+      if (first_page == last_page)
+        continue;
+
+      for (page = first_page; page + 1 < last_page; ++page)
+        if (header->page_table[page].entry_count != header->page_size)
+          return SVN_NO_ERROR;
+
+      item_count += (apr_uint64_t)(last_page - first_page - 1)
+                  * header->page_size
+                  + header->page_table[last_page - 1].entry_count;
+    }
+
+  if (item_count > APR_UINT32_MAX)
+    return SVN_NO_ERROR;
+
+  /* All items are stored in front of the L2P index. */
+  wide = (apr_uint64_t)rev_file->l2p_offset >= APR_UINT32_MAX;
+  *size = sizeof(*result)
+        + (header->revision_count + 1) * sizeof(*result->item_start)
+        + (apr_size_t)item_count * (wide ? sizeof(*result->offsets64)
+                                         : sizeof(*result->offsets32));
+  if (*size > PACKED_L2P_MAX_SIZE)
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->first_revision = header->first_revision;
+  result->revision_count = header->revision_count;
+  result->item_start
+    = apr_palloc(result_pool,
+                 (header->revision_count + 1) * sizeof(*result->item_start));
+  if (wide)
+    result->offsets64
+      = apr_palloc(result_pool,
+                   (apr_size_t)item_count * sizeof(*result->offsets64));
+  else
+    result->offsets32
+      = apr_palloc(result_pool,
+                   (apr_size_t)item_count * sizeof(*result->offsets32));
+
+  /* Read all pages in file order, i.e. sequentially. */
+  iterpool = svn_pool_create(scratch_pool);
+  item = 0;
+  for (i = 0; i < header->revision_count; ++i)
+    {
+      result->item_start[i] = item;
+      for (page = header->page_table_index[i];
+           page < header->page_table_index[i + 1];
+           ++page)
+        {
+          l2p_page_t *l2p_page;
+          apr_uint32_t k;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(get_l2p_page(&l2p_page, rev_file, fs,
+                               header->first_revision,
+                               &header->page_table[page], iterpool));
+
+          /* Unused entries are -1, i.e. become 0. */
+          for (k = 0; k < l2p_page->entry_count; ++k, ++item)
+            if (wide)
+              result->offsets64[item] = l2p_page->offsets[k] + 1;
+            else
+              result->offsets32[item]
+                = (apr_uint32_t)(l2p_page->offsets[k] + 1);
+        }
+    }
+
+  result->item_start[header->revision_count] = item;
+  svn_pool_destroy(iterpool);
+
+  *index = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *INDEX to the entry for FIRST_REVISION in FFSD->PACKED_L2P and set
+ * *LIMIT_REACHED if there is no room for further entries.
+ * To be called under FFSD->PACKED_L2P_LOCK.
+ */
+static svn_error_t *
+find_shared_packed_l2p(const packed_l2p_t **index,
+                       svn_boolean_t *limit_reached,
+                       fs_fs_shared_data_t *ffsd,
+                       svn_revnum_t first_revision)
+{
+  *index = apr_hash_get(ffsd->packed_l2p, &first_revision,
+                        sizeof(first_revision));
+  *limit_reached = ffsd->packed_l2p_size >= PACKED_L2P_MAX_SIZE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Publish a copy of INDEX with approximately SIZE bytes in FFSD unless
+ * some other thread did that already or the memory limit would be
+ * exceeded.  Return the shared entry in *SHARED, which may be NULL.
+ * To be called under FFSD->PACKED_L2P_LOCK.
+ */
+static svn_error_t *
+add_shared_packed_l2p(const packed_l2p_t **shared,
+                      fs_fs_shared_data_t *ffsd,
+                      const packed_l2p_t *index,
+                      apr_size_t size)
+{
+  apr_pool_t *pool = ffsd->packed_l2p_pool;
+  packed_l2p_t *copy;
+  apr_size_t item_count;
+
+  *shared = apr_hash_get(ffsd->packed_l2p, &index->first_revision,
+                         sizeof(index->first_revision));
+  if (*shared || ffsd->packed_l2p_size + size > PACKED_L2P_MAX_SIZE)
+    return SVN_NO_ERROR;
+
+  item_count = index->item_start[index->revision_count];
+  copy = apr_pmemdup(pool, index, sizeof(*index));
+  copy->item_start
+    = apr_pmemdup(pool, index->item_start,
+                  (index->revision_count + 1) * sizeof(*index->item_start));
+  if (index->offsets64)
+    copy->offsets64 = apr_pmemdup(pool, index->offsets64,
+                                  item_count * sizeof(*index->offsets64));
+  else
+    copy->offsets32 = apr_pmemdup(pool, index->offsets32,
+                                  item_count * sizeof(*index->offsets32));
+
+  apr_hash_set(ffsd->packed_l2p, &copy->first_revision,
+               sizeof(copy->first_revision), copy);
+  ffsd->packed_l2p_size += size;
+  *shared = copy;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the in-process log-to-phys index for the pack file REV_FILE in
+ * FS in *INDEX.  Create it if necessary and permitted by the memory limit.
+ * Set *INDEX to NULL if it is not available.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+get_packed_l2p(const packed_l2p_t **index,
+               svn_fs_t *fs,
+               svn_fs_fs__revision_file_t *rev_file,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  svn_revnum_t first_revision = rev_file->start_revision;
+  const packed_l2p_t *result = NULL;
+  svn_boolean_t limit_reached = FALSE;
+
+  *index = NULL;
+  if (!ffsd || !rev_file->is_packed)
+    return SVN_NO_ERROR;
+
+  /* Fast path: Already known to this svn_fs_t.  No locking required. */
+  if (ffd->packed_l2p)
+    {
+      result = apr_hash_get(ffd->packed_l2p, &first_revision,
+                            sizeof(first_revision));
+      if (result)
+        {
+          *index = result == &no_packed_l2p ? NULL : result;
+          return SVN_NO_ERROR;
+        }
+    }
+  else
+    {
+      ffd->packed_l2p = apr_hash_make(fs->pool);
+    }
+
+  /* Maybe, some other svn_fs_t in this process built the index already. */
+  SVN_MUTEX__WITH_LOCK(ffsd->packed_l2p_lock,
+                       find_shared_packed_l2p(&result, &limit_reached, ffsd,
+                                              first_revision));
+
+  /* Read the index from disk - without holding the lock. */
+  if (!result && !limit_reached)
+    {
+      apr_pool_t *subpool = svn_pool_create(scratch_pool);
+      packed_l2p_t *local;
+      apr_size_t size;
+
+      SVN_ERR(read_packed_l2p(&local, &size, rev_file, fs, subpool,
+                              subpool));
+      if (local)
+        SVN_MUTEX__WITH_LOCK(ffsd->packed_l2p_lock,
+                             add_shared_packed_l2p(&result, ffsd, local,
+                                                   size));
+
+      svn_pool_destroy(subpool);
+    }
+
+  /* Remember the outcome.  Don't try again within this svn_fs_t. */
+  apr_hash_set(ffd->packed_l2p,
+               apr_pmemdup(fs->pool, &first_revision, sizeof(first_revision)),
+               sizeof(first_revision),
+               result ? result : &no_packed_l2p);
+  *index = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Using the in-process log-to-phys INDEX, find the absolute offset in the
+ * pack file for (REVISION, ITEM_INDEX) and return it in *OFFSET.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+packed_l2p_lookup(apr_off_t *offset,
+                  const packed_l2p_t *index,
+                  svn_revnum_t revision,
+                  apr_uint64_t item_index,
+                  apr_pool_t *scratch_pool)
+{
+  apr_size_t rel_revision = (apr_size_t)(revision - index->first_revision);
+  apr_uint32_t first_item;
+  apr_uint64_t value;
+
+  if (   revision < index->first_revision
+      || rel_revision >= index->revision_count)
+    return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                      _("Corrupt L2P index for r%ld only covers r%ld:%ld"),
+                      revision, index->first_revision,
+                      index->first_revision
+                        + (svn_revnum_t)index->revision_count);
+
+  first_item = index->item_start[rel_revision];
+  if (item_index >= index->item_start[rel_revision + 1] - first_item)
+    return svn_error_createf(SVN_ERR_FS_INDEX_OVERFLOW , NULL,
+                             _("Item index %s"
+                               " too large in revision %ld"),
+                             apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                          item_index),
+                             revision);
+
+  value = index->offsets64
+        ? index->offsets64[first_item + item_index]
+        : index->offsets32[first_item + item_index];
+  *offset = (apr_off_t)value - 1;
+
+  return SVN_NO_ERROR;
+}
+
 /* Using the log-to-phys indexes in FS, find the absolute offset in the
  * rev file for (REVISION, ITEM_INDEX) and return it in *OFFSET.
  * Use SCRATCH_POOL for temporary allocations.
@@ -1540,6 +1870,13 @@ l2p_index_lookup(apr_off_t *offset,
   svn_fs_fs__page_cache_key_t key = { 0 };
   svn_boolean_t is_cached = FALSE;
   void *dummy = NULL;
+  const packed_l2p_t *packed_l2p;
+
+  /* For pack files, we prefer the in-process index. */
+  SVN_ERR(get_packed_l2p(&packed_l2p, fs, rev_file, scratch_pool));
+  if (packed_l2p)
+    return svn_error_trace(packed_l2p_lookup(offset, packed_l2p, revision,
+                                             item_index, scratch_pool));
 
   /* read index master data structure and extract the info required to
    * access the l2p index page for (REVISION,ITEM_INDEX)*/
@@ -1795,6 +2132,7 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   else if (svn_fs_fs__use_log_addressing(fs))
     {
       /* ordinary index lookup */
+      svn_fs_fs__io_stats_index_lookups(fs, 1);
       SVN_ERR(l2p_index_lookup(absolute_position, fs, rev_file, revision,
                                item_index, scratch_pool));
     }
@@ -1816,6 +2154,47 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__item_offsets(apr_off_t *absolute_positions,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const svn_fs_fs__id_part_t *items,
+                        int count,
+                        apr_pool_t *scratch_pool)
+{
+  const packed_l2p_t *packed_l2p = NULL;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_ERR(get_packed_l2p(&packed_l2p, fs, rev_file, scratch_pool));
+
+  /* Resolve all items from the in-process index at once. */
+  if (packed_l2p)
+    {
+      svn_fs_fs__io_stats_index_lookups(fs, count);
+      for (i = 0; i < count; ++i)
+        SVN_ERR(packed_l2p_lookup(&absolute_positions[i], packed_l2p,
+                                  items[i].revision, items[i].number,
+                                  scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Standard lookup of each individual item. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__item_offset(&absolute_positions[i], fs, rev_file,
+                                     items[i].revision, NULL,
+                                     items[i].number, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /*
  * phys-to-log index
  */
@@ -2138,7 +2517,7 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
@@ -2892,6 +3271,8 @@ svn_fs_fs__p2l_index_lookup(apr_array_header_t **entries,
   apr_array_header_t *result = apr_array_make(result_pool, 16,
                                               sizeof(svn_fs_fs__p2l_entry_t));
 
+  svn_fs_fs__io_stats_index_lookups(fs, 1);
+
   /* Fetch entries page-by-page.  Since the p2l index is supposed to cover
    * every single byte in the rev / pack file - even unused sections -
    * every iteration must result in some progress. */
@@ -3001,6 +3382,7 @@ svn_fs_fs__p2l_entry_lookup(svn_fs_fs__p2l_entry_t **entry_p,
   p2l_page_info_baton_t page_info;
 
   *entry_p = NULL;
+  svn_fs_fs__io_stats_index_lookups(fs, 1);
 
   /* look for this info in our cache */
   SVN_ERR(get_p2l_keys(&page_info, &key, rev_file, fs, revision, offset,
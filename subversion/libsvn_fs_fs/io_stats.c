@@ -0,0 +1,253 @@
+/* io_stats.c --- I/O statistics and access tracing
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "io_stats.h"
+
+#include "svn_private_config.h"
+
+/* Write the LEN bytes at LINE to the I/O trace of FFD.  Tracing is a
+ * diagnostic aid only, so stop tracing instead of failing on errors. */
+static void
+write_trace(fs_fs_data_t *ffd,
+            const char *line,
+            int len)
+{
+  apr_size_t to_write;
+  svn_error_t *err;
+
+  if (len < 0)
+    return;
+
+  to_write = (apr_size_t)len;
+  err = svn_stream_write(ffd->io_trace, line, &to_write);
+  if (err)
+    {
+      svn_error_clear(err);
+      ffd->io_trace = NULL;
+    }
+}
+
+void
+svn_fs_fs__io_stats_open(svn_fs_fs__revision_file_t *file,
+                         const char *path)
+{
+  fs_fs_data_t *ffd = file->fs ? file->fs->fsap_data : NULL;
+  if (!ffd || !ffd->io_stats_enabled)
+    return;
+
+  ffd->io_stats.files_opened++;
+
+  if (ffd->io_trace)
+    {
+      char line[APR_PATH_MAX + 40];
+      file->trace_handle = ++ffd->io_trace_handle;
+      write_trace(ffd, line,
+                  apr_snprintf(line, sizeof(line),
+                               "open(\"%s\", O_RDONLY) = %d\n",
+                               path, file->trace_handle));
+    }
+}
+
+void
+svn_fs_fs__io_stats_read(svn_fs_fs__revision_file_t *file,
+                         apr_off_t offset,
+                         apr_size_t size)
+{
+  fs_fs_data_t *ffd = file->fs ? file->fs->fsap_data : NULL;
+  if (!ffd || !ffd->io_stats_enabled)
+    return;
+
+  ffd->io_stats.bytes_read += size;
+
+  if (ffd->io_trace && file->trace_handle)
+    {
+      char line[160];
+      write_trace(ffd, line,
+                  apr_snprintf(line, sizeof(line),
+                               "lseek(%d, %" APR_OFF_T_FMT ", SEEK_SET) = %"
+                               APR_OFF_T_FMT "\n"
+                               "read(%d, \"\", %" APR_SIZE_T_FMT ") = %"
+                               APR_SIZE_T_FMT "\n",
+                               file->trace_handle, offset, offset,
+                               file->trace_handle, size, size));
+    }
+}
+
+void
+svn_fs_fs__io_stats_close(svn_fs_fs__revision_file_t *file)
+{
+  fs_fs_data_t *ffd = file->fs ? file->fs->fsap_data : NULL;
+  if (!ffd || !ffd->io_stats_enabled)
+    return;
+
+  if (ffd->io_trace && file->trace_handle)
+    {
+      char line[40];
+      write_trace(ffd, line,
+                  apr_snprintf(line, sizeof(line), "close(%d) = 0\n",
+                               file->trace_handle));
+    }
+
+  file->trace_handle = 0;
+}
+
+void
+svn_fs_fs__io_stats_item(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->io_stats_enabled)
+    ffd->io_stats.items_read++;
+}
+
+void
+svn_fs_fs__io_stats_index_lookups(svn_fs_t *fs,
+                                  int count)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->io_stats_enabled)
+    ffd->io_stats.index_lookups += count;
+}
+
+svn_boolean_t
+svn_fs_fs__io_stats_enabled(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->io_stats_enabled;
+}
+
+void
+svn_fs_fs__io_stats_delta_chain(svn_fs_t *fs,
+                                int chain_length)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (!ffd->io_stats_enabled)
+    return;
+
+  ffd->io_stats.reps_reconstructed++;
+  ffd->io_stats.delta_chain_length += chain_length;
+  if (ffd->io_stats.max_delta_chain_length < (apr_uint64_t)chain_length)
+    ffd->io_stats.max_delta_chain_length = chain_length;
+}
+
+void
+svn_fs_fs__io_stats_reconstruction_time(svn_fs_t *fs,
+                                        apr_interval_time_t duration)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->io_stats_enabled)
+    ffd->io_stats.reconstruction_time += duration;
+}
+
+/* Set *GETS and *HITS to the sums of the access counters of all caches
+ * used by FS. */
+static void
+get_cache_counts(apr_uint64_t *gets,
+                 apr_uint64_t *hits,
+                 svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_cache__t *caches[] =
+    {
+      ffd->rev_root_id_cache,
+      ffd->rev_node_cache,
+      ffd->dir_cache,
+      ffd->dir_chunk_cache,
+      ffd->fulltext_cache,
+      ffd->revprop_cache,
+      ffd->properties_cache,
+      ffd->packed_offset_cache,
+      ffd->raw_window_cache,
+      ffd->txdelta_window_cache,
+      ffd->combined_window_cache,
+      ffd->node_revision_cache,
+      ffd->changes_cache,
+      ffd->rep_header_cache,
+      ffd->mergeinfo_cache,
+      ffd->mergeinfo_existence_cache,
+      ffd->closest_copy_cache,
+      ffd->l2p_header_cache,
+      ffd->l2p_page_cache,
+      ffd->p2l_header_cache,
+      ffd->p2l_page_cache
+    };
+  apr_size_t i;
+
+  *gets = 0;
+  *hits = 0;
+  for (i = 0; i < sizeof(caches) / sizeof(caches[0]); ++i)
+    if (caches[i])
+      svn_cache__add_access_counts(gets, hits, caches[i]);
+}
+
+svn_error_t *
+svn_fs_fs__set_io_stats(svn_fs_t *fs,
+                        svn_boolean_t enabled,
+                        svn_stream_t *trace,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Start from scratch when statistics get enabled. */
+  if (enabled && !ffd->io_stats_enabled)
+    {
+      memset(&ffd->io_stats, 0, sizeof(ffd->io_stats));
+      get_cache_counts(&ffd->io_stats_cache_gets, &ffd->io_stats_cache_hits,
+                       fs);
+    }
+
+  ffd->io_stats_enabled = enabled;
+  ffd->io_trace = enabled ? trace : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_io_stats(svn_fs__io_stats_t **stats,
+                        svn_fs_t *fs,
+                        svn_boolean_t reset,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t gets, hits;
+
+  *stats = apr_pmemdup(result_pool, &ffd->io_stats, sizeof(**stats));
+  if (!ffd->io_stats_enabled)
+    return SVN_NO_ERROR;
+
+  get_cache_counts(&gets, &hits, fs);
+  (*stats)->cache_gets = gets - ffd->io_stats_cache_gets;
+  (*stats)->cache_hits = hits - ffd->io_stats_cache_hits;
+
+  if (reset)
+    {
+      memset(&ffd->io_stats, 0, sizeof(ffd->io_stats));
+      ffd->io_stats_cache_gets = gets;
+      ffd->io_stats_cache_hits = hits;
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,92 @@
+/* io_stats.h --- I/O statistics and access tracing
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS__IO_STATS_H
+#define SVN_LIBSVN_FS_FS__IO_STATS_H
+
+#include "fs.h"
+
+/* The functions in this module count the I/O done by a filesystem while
+ * I/O statistics have been enabled for it.  They are always compiled in
+ * and reduce to a single flag check otherwise.
+ *
+ * If a trace stream has been given as well, every access to a revision or
+ * pack file gets written to it as open(), lseek(), read() and close()
+ * lines in strace syntax.  Feeding that output into fsfs-access-map gives
+ * the same analysis as an actual strace of the process would.
+ */
+
+/* Record that FILE has been opened from PATH. */
+void
+svn_fs_fs__io_stats_open(svn_fs_fs__revision_file_t *file,
+                         const char *path);
+
+/* Record that SIZE bytes starting at OFFSET have been read from FILE. */
+void
+svn_fs_fs__io_stats_read(svn_fs_fs__revision_file_t *file,
+                         apr_off_t offset,
+                         apr_size_t size);
+
+/* Record that FILE is about to be closed. */
+void
+svn_fs_fs__io_stats_close(svn_fs_fs__revision_file_t *file);
+
+/* Record that an item has been requested from FS. */
+void
+svn_fs_fs__io_stats_item(svn_fs_t *fs);
+
+/* Record that COUNT item index lookups have been done in FS. */
+void
+svn_fs_fs__io_stats_index_lookups(svn_fs_t *fs,
+                                  int count);
+
+/* Return TRUE if FS currently collects I/O statistics. */
+svn_boolean_t
+svn_fs_fs__io_stats_enabled(svn_fs_t *fs);
+
+/* Record that FS starts reconstructing a representation from a delta
+ * chain of CHAIN_LENGTH representations. */
+void
+svn_fs_fs__io_stats_delta_chain(svn_fs_t *fs,
+                                int chain_length);
+
+/* Record that FS spent DURATION reconstructing representations. */
+void
+svn_fs_fs__io_stats_reconstruction_time(svn_fs_t *fs,
+                                        apr_interval_time_t duration);
+
+/* Implements svn_fs__set_io_stats() for FSFS. */
+svn_error_t *
+svn_fs_fs__set_io_stats(svn_fs_t *fs,
+                        svn_boolean_t enabled,
+                        svn_stream_t *trace,
+                        apr_pool_t *scratch_pool);
+
+/* Implements svn_fs__get_io_stats() for FSFS. */
+svn_error_t *
+svn_fs_fs__get_io_stats(svn_fs__io_stats_t **stats,
+                        svn_fs_t *fs,
+                        svn_boolean_t reset,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+#endif
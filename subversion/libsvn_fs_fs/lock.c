@@ -37,6 +37,7 @@
 #include "tree.h"
 #include "fs_fs.h"
 #include "util.h"
+#include "locks-db.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "private/svn_fs_util.h"
@@ -58,6 +59,11 @@
    calculate a subdirectory in which to drop that file. */
 #define DIGEST_SUBDIR_LEN 3
 
+/* Schema version of the lock database. */
+#define LOCKS_DB_SCHEMA_FORMAT 1
+
+LOCKS_DB_SQL_DECLARE_STATEMENTS(statements);
+
 
 
 /*** Generic helper functions. ***/
@@ -457,6 +463,237 @@ static svn_boolean_t lock_expired(const svn_lock_t *lock)
   return lock->expiration_date && (apr_time_now() > lock->expiration_date);
 }
 
+/*** The lock database.
+
+     Repositories of format SVN_FS_FS__MIN_LOCK_DB_FORMAT and newer keep
+     all locks in a SQLite database instead of the digest file tree.  The
+     database gets created together with the repository or, when
+     upgrading older repositories, from their digest tree.  Older servers
+     reject such repositories due to their format number, so they can't
+     miss any of the locks. ***/
+
+static APR_INLINE const char *
+path_lock_db(const char *fs_path,
+             apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, PATH_LOCKS_DB, result_pool);
+}
+
+/* Body of get_lock_db().
+   Implements svn_atomic__init_once().init_func. */
+static svn_error_t *
+open_lock_db(void *baton,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open2(&sdb, path_lock_db(fs->path, pool),
+                            svn_sqlite__mode_readwrite, statements,
+                            &ffd->sqlite_options,
+                            fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version != LOCKS_DB_SCHEMA_FORMAT)
+    {
+      SVN_ERR(svn_sqlite__close(sdb));
+      return svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                               _("Unsupported lock database format %d"),
+                               version);
+    }
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->lock_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SDB to the lock database of FS or to NULL if FS still uses the
+   digest file tree.  The database remains open for the lifetime of FS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_lock_db(svn_sqlite__db_t **sdb,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (! ffd->lock_db && ffd->format >= SVN_FS_FS__MIN_LOCK_DB_FORMAT)
+    {
+      svn_error_t *err = svn_atomic__init_once(&ffd->lock_db_opened,
+                                               open_lock_db, fs,
+                                               scratch_pool);
+      SVN_ERR(svn_error_quick_wrapf(err,
+                         _("Couldn't open lock database '%s'"),
+                         svn_dirent_local_style(path_lock_db(fs->path,
+                                                             scratch_pool),
+                                                scratch_pool)));
+    }
+
+  *sdb = ffd->lock_db;
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOCK to the lock described by the current row of STMT, which must
+   be one of the SELECT statements in locks-db.sql.  Allocate it in
+   RESULT_POOL. */
+static void
+lock_from_row(svn_lock_t **lock,
+              svn_sqlite__stmt_t *stmt,
+              apr_pool_t *result_pool)
+{
+  svn_lock_t *result = svn_lock_create(result_pool);
+
+  result->path = apr_pstrcat(result_pool, "/",
+                             svn_sqlite__column_text(stmt, 0, NULL),
+                             SVN_VA_NULL);
+  result->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  result->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  result->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  result->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  result->creation_date = svn_sqlite__column_int64(stmt, 5);
+  result->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  *lock = result;
+}
+
+/* Set *LOCK_P to the lock for PATH in SDB or to NULL if there is none.
+   Allocate it in POOL. */
+static svn_error_t *
+db_get_lock(svn_lock_t **lock_p,
+            svn_sqlite__db_t *sdb,
+            const char *path,
+            apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path + 1));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  *lock_p = NULL;
+  if (have_row)
+    lock_from_row(lock_p, stmt, pool);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *LOCKS to the array of svn_lock_t * in SDB for PATH and, depending
+   on DEPTH, the paths below it.  Ordered by path.  Allocate the result
+   in RESULT_POOL. */
+static svn_error_t *
+db_list_locks(apr_array_header_t **locks,
+              svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_depth_t depth,
+              apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int stmt_idx;
+
+  /* Since Subversion only allows locks on files, depth=immediates is
+     the same as depth=files. */
+  if (depth == svn_depth_empty)
+    stmt_idx = STMT_GET_LOCK;
+  else if (depth == svn_depth_files || depth == svn_depth_immediates)
+    stmt_idx = STMT_SELECT_LOCKS_IMMEDIATES;
+  else
+    stmt_idx = STMT_SELECT_LOCKS_RECURSIVE;
+
+  *locks = apr_array_make(result_pool, 16, sizeof(svn_lock_t *));
+
+  /* We read all rows before returning, so callers may run other queries
+     on SDB for each lock they process. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path + 1));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      lock_from_row(apr_array_push(*locks), stmt, result_pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Write all svn_lock_t * in LOCKS to SDB, replacing any existing locks
+   on the same paths.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+insert_locks(svn_sqlite__db_t *sdb,
+             const apr_array_header_t *locks,
+             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  int i;
+
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      const svn_lock_t *lock = APR_ARRAY_IDX(locks, i, const svn_lock_t *);
+      const char *relpath = lock->path + 1;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_LOCK));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sssssdL",
+                                relpath,
+                                svn_relpath_dirname(relpath, scratch_pool),
+                                lock->token, lock->owner, lock->comment,
+                                lock->is_dav_comment,
+                                (apr_int64_t)lock->creation_date));
+      if (lock->expiration_date)
+        SVN_ERR(svn_sqlite__bind_int64(stmt, 8, lock->expiration_date));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like insert_locks() but do it in a single transaction. */
+static svn_error_t *
+db_set_locks(svn_sqlite__db_t *sdb,
+             const apr_array_header_t *locks,
+             apr_pool_t *scratch_pool)
+{
+  SVN_SQLITE__WITH_TXN(insert_locks(sdb, locks, scratch_pool), sdb);
+  return SVN_NO_ERROR;
+}
+
+/* Remove the locks on all paths (const char *) in PATHS from SDB. */
+static svn_error_t *
+delete_locks(svn_sqlite__db_t *sdb,
+             const apr_array_header_t *paths)
+{
+  svn_sqlite__stmt_t *stmt;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_LOCK));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s", path + 1));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like delete_locks() but do it in a single transaction. */
+static svn_error_t *
+db_delete_locks(svn_sqlite__db_t *sdb,
+                const apr_array_header_t *paths)
+{
+  SVN_SQLITE__WITH_TXN(delete_locks(sdb, paths), sdb);
+  return SVN_NO_ERROR;
+}
+
+
 /* Set *LOCK_P to the lock for PATH in FS.  HAVE_WRITE_LOCK should be
    TRUE if the caller (or one of its callers) has taken out the
    repository-wide write lock, FALSE otherwise.  If MUST_EXIST is
@@ -472,15 +709,24 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_sqlite__db_t *sdb;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(get_lock_db(&sdb, fs, pool));
+  if (sdb)
+    {
+      SVN_ERR(db_get_lock(&lock, sdb, path, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -594,6 +840,102 @@ walk_locks(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Like walk_locks() but for FS with the lock database SDB.  Only report
+   locks on PATH and, depending on DEPTH, below it. */
+static svn_error_t *
+walk_db_locks(svn_fs_t *fs,
+              svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_depth_t depth,
+              svn_fs_get_locks_callback_t get_locks_func,
+              void *get_locks_baton,
+              svn_boolean_t have_write_lock,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *locks;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(db_list_locks(&locks, sdb, path, depth, pool));
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+
+      svn_pool_clear(iterpool);
+      if (lock_expired(lock))
+        {
+          /* Only remove the lock if we have the write lock.
+             Read operations shouldn't change the filesystem. */
+          if (have_write_lock)
+            SVN_ERR(unlock_single(fs, lock, iterpool));
+        }
+      else
+        {
+          SVN_ERR(get_locks_func(get_locks_baton, lock, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* This implements the svn_fs_get_locks_callback_t interface, where
+   BATON is an array of svn_lock_t * to add a copy of LOCK to. */
+static svn_error_t *
+collect_locks_callback(void *baton,
+                       svn_lock_t *lock,
+                       apr_pool_t *pool)
+{
+  apr_array_header_t *locks = baton;
+  APR_ARRAY_PUSH(locks, svn_lock_t *) = svn_lock_dup(lock, locks->pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__create_lock_db(svn_fs_t *fs,
+                          apr_pool_t *scratch_pool)
+{
+  const char *db_path = path_lock_db(fs->path, scratch_pool);
+  const char *tmp_path = apr_pstrcat(scratch_pool, db_path, ".tmp",
+                                     SVN_VA_NULL);
+  const char *digest_path;
+  apr_array_header_t *locks = apr_array_make(scratch_pool, 16,
+                                             sizeof(svn_lock_t *));
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", scratch_pool));
+  SVN_ERR(walk_locks(fs, digest_path, collect_locks_callback, locks,
+                     FALSE, scratch_pool));
+
+  /* Remove the leftovers of a previously interrupted attempt. */
+  SVN_ERR(svn_io_remove_file2(tmp_path, TRUE, scratch_pool));
+  SVN_ERR(svn_io_file_create_empty(tmp_path, scratch_pool));
+  SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, scratch_pool),
+                            tmp_path, scratch_pool));
+
+  SVN_ERR(svn_sqlite__open(&sdb, tmp_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0,
+                           scratch_pool, scratch_pool));
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb, STMT_CREATE_SCHEMA),
+                        sdb);
+  SVN_SQLITE__ERR_CLOSE(db_set_locks(sdb, locks, scratch_pool), sdb);
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  return svn_error_trace(svn_io_file_rename2(tmp_path, db_path, TRUE,
+                                             scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__remove_lock_digests(svn_fs_t *fs,
+                               apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_io_remove_dir2(
+                           svn_dirent_join(fs->path, PATH_LOCKS_DIR,
+                                           scratch_pool),
+                           TRUE, NULL, NULL, scratch_pool));
+}
+
 
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
@@ -652,10 +994,22 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
-                         fs, have_write_lock, pool));
+      svn_sqlite__db_t *sdb;
+
+      SVN_ERR(get_lock_db(&sdb, fs, pool));
+      if (sdb)
+        {
+          SVN_ERR(walk_db_locks(fs, sdb, path, svn_depth_infinity,
+                                get_locks_callback, fs, have_write_lock,
+                                pool));
+        }
+      else
+        {
+          const char *digest_path;
+          SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+          SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+                             fs, have_write_lock, pool));
+        }
     }
   else
     {
@@ -845,6 +1199,9 @@ lock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *sdb;
+  apr_array_header_t *locks = apr_array_make(pool, lb->targets->nelts,
+                                             sizeof(svn_lock_t *));
 
   /* Until we implement directory locks someday, we only allow locks
      on files. */
@@ -852,6 +1209,7 @@ lock_body(void *baton, apr_pool_t *pool)
      library dependencies, which are not portable. */
   SVN_ERR(lb->fs->vtable->youngest_rev(&youngest, lb->fs, pool));
   SVN_ERR(lb->fs->vtable->revision_root(&root, lb->fs, youngest, pool));
+  SVN_ERR(get_lock_db(&sdb, lb->fs, pool));
 
   for (i = 0; i < lb->targets->nelts; ++i)
     {
@@ -869,8 +1227,8 @@ lock_body(void *baton, apr_pool_t *pool)
                          youngest, iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database doesn't need them. */
+      if (!info.fs_err && !sdb)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -925,8 +1283,25 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (sdb)
+            APR_ARRAY_PUSH(locks, svn_lock_t *) = info->lock;
+          else
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
+        }
+    }
+
+  /* Write all new locks to the database at once. */
+  if (sdb && locks->nelts)
+    {
+      svn_error_t *err = db_set_locks(sdb, locks, iterpool);
+      if (err)
+        {
+          /* None of the locks have been written. */
+          for (i = 0; i < lb->infos->nelts; ++i)
+            APR_ARRAY_IDX(lb->infos, i, struct lock_info_t).lock = NULL;
+
+          return svn_error_trace(err);
         }
     }
 
@@ -997,10 +1372,13 @@ unlock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *indices_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *sdb;
 
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
 
+  SVN_ERR(get_lock_db(&sdb, ub->fs, pool));
+
   for (i = 0; i < ub->targets->nelts; ++i)
     {
       const svn_sort__item_t *item = &APR_ARRAY_IDX(ub->targets, i,
@@ -1019,8 +1397,8 @@ unlock_body(void *baton, apr_pool_t *pool)
                              iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database doesn't need them. */
+      if (!info.fs_err && !sdb)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
@@ -1028,6 +1406,33 @@ unlock_body(void *baton, apr_pool_t *pool)
 
   rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
 
+  /* Remove all locks from the database at once. */
+  if (sdb)
+    {
+      apr_array_header_t *paths = apr_array_make(pool, ub->infos->nelts,
+                                                 sizeof(const char *));
+
+      for (i = 0; i < ub->infos->nelts; ++i)
+        {
+          struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                      struct unlock_info_t);
+          if (! info->fs_err)
+            APR_ARRAY_PUSH(paths, const char *) = info->path;
+        }
+
+      SVN_ERR(db_delete_locks(sdb, paths));
+
+      for (i = 0; i < ub->infos->nelts; ++i)
+        {
+          struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                      struct unlock_info_t);
+          info->done = (info->fs_err == SVN_NO_ERROR);
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
   /* Unlike the lock_body(), we need to delete locks *before* we start to
      update indices. */
 
@@ -1350,10 +1755,18 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
 {
   const char *digest_path;
   get_locks_filter_baton_t glfb;
+  svn_sqlite__db_t *sdb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
   path = svn_fs__canonicalize_abspath(path, pool);
 
+  /* The lock database can answer depth-restricted queries directly. */
+  SVN_ERR(get_lock_db(&sdb, fs, pool));
+  if (sdb)
+    return svn_error_trace(walk_db_locks(fs, sdb, path, depth,
+                                         get_locks_func, get_locks_baton,
+                                         FALSE, pool));
+
   glfb.path = path;
   glfb.requested_depth = depth;
   glfb.get_locks_func = get_locks_func;
@@ -73,6 +73,25 @@ svn_error_t *svn_fs_fs__get_locks(svn_fs_t *fs,
                                   apr_pool_t *pool);
 
 
+/* Create the lock database of FS and fill it with all unexpired locks
+   from the digest file tree, if there is one.  The database gets built
+   under a temporary name and moved into place atomically.  The digest
+   tree is left untouched, see svn_fs_fs__remove_lock_digests().
+
+   This assumes that the write lock is held.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__create_lock_db(svn_fs_t *fs,
+                          apr_pool_t *scratch_pool);
+
+/* Remove the lock digest file tree of FS, if any.  Call this only after
+   the format of FS has been bumped to SVN_FS_FS__MIN_LOCK_DB_FORMAT or
+   newer, i.e. once no server reads the digest tree anymore.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__remove_lock_digests(svn_fs_t *fs,
+                               apr_pool_t *scratch_pool);
+
 /* Examine PATH for existing locks, and check whether they can be
    used.  Use POOL for temporary allocations.
 
@@ -0,0 +1,71 @@
+/* locks-db.sql -- schema for the FSFS lock database
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* A table holding one row per lock.  Paths are stored as relpaths,
+   i.e. without the leading '/', so IS_STRICT_DESCENDANT_OF() works on
+   them.  EXPIRATION_DATE is NULL for locks that don't expire. */
+CREATE TABLE locks (
+  relpath TEXT NOT NULL PRIMARY KEY,
+  parent_relpath TEXT,
+  token TEXT NOT NULL,
+  owner TEXT NOT NULL,
+  comment TEXT,
+  is_dav_comment INTEGER NOT NULL,
+  creation_date INTEGER NOT NULL,
+  expiration_date INTEGER
+  );
+
+CREATE INDEX i_locks_parent ON locks (parent_relpath);
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_GET_LOCK
+SELECT relpath, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE relpath = ?1
+
+-- STMT_SELECT_LOCKS_RECURSIVE
+SELECT relpath, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE relpath = ?1 OR IS_STRICT_DESCENDANT_OF(relpath, ?1)
+ORDER BY relpath
+
+-- STMT_SELECT_LOCKS_IMMEDIATES
+SELECT relpath, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE relpath = ?1 OR parent_relpath = ?1
+ORDER BY relpath
+
+-- STMT_SET_LOCK
+INSERT OR REPLACE INTO locks (relpath, parent_relpath, token, owner, comment,
+                              is_dav_comment, creation_date, expiration_date)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)
+
+-- STMT_DELETE_LOCK
+DELETE FROM locks
+WHERE relpath = ?1
@@ -0,0 +1,89 @@
+/* mergeinfo-index-db.sql -- schema for the FSFS mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row for each span of revisions during which the node at RELPATH
+   carried svn:mergeinfo.  Paths are stored as relpaths, i.e. without the
+   leading '/', so IS_STRICT_DESCENDANT_OF() works on them.  REMOVED_REV
+   is the first revision without that mergeinfo, or NULL while the node
+   still has it in the latest indexed revision. */
+CREATE TABLE mergeinfo_paths (
+  relpath TEXT NOT NULL,
+  added_rev INTEGER NOT NULL,
+  removed_rev INTEGER,
+  PRIMARY KEY (relpath, added_rev)
+  );
+
+/* A single row giving the range of revisions that MERGEINFO_PATHS
+   describes completely. */
+CREATE TABLE indexed_revs (
+  id INTEGER NOT NULL PRIMARY KEY,
+  first_rev INTEGER NOT NULL,
+  last_rev INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_GET_INDEXED_REVS
+SELECT first_rev, last_rev
+FROM indexed_revs
+WHERE id = 0
+
+-- STMT_SET_INDEXED_REVS
+INSERT OR REPLACE INTO indexed_revs (id, first_rev, last_rev)
+VALUES (0, ?1, ?2)
+
+-- STMT_SELECT_DESCENDANTS
+SELECT relpath
+FROM mergeinfo_paths
+WHERE IS_STRICT_DESCENDANT_OF(relpath, ?1)
+  AND added_rev <= ?2
+  AND (removed_rev IS NULL OR removed_rev > ?2)
+ORDER BY relpath
+
+-- STMT_HAS_PATH
+SELECT 1
+FROM mergeinfo_paths
+WHERE relpath = ?1 AND removed_rev IS NULL
+
+/* Replacing is needed for nodes that get removed and re-added within
+   the same revision. */
+-- STMT_ADD_PATH
+INSERT OR REPLACE INTO mergeinfo_paths (relpath, added_rev, removed_rev)
+VALUES (?1, ?2, NULL)
+
+-- STMT_REMOVE_PATH
+UPDATE mergeinfo_paths
+SET removed_rev = ?2
+WHERE relpath = ?1 AND removed_rev IS NULL
+
+-- STMT_REMOVE_PATH_RECURSIVE
+UPDATE mergeinfo_paths
+SET removed_rev = ?2
+WHERE (relpath = ?1 OR IS_STRICT_DESCENDANT_OF(relpath, ?1))
+  AND removed_rev IS NULL
+
+-- STMT_CLEAR_INDEX
+DELETE FROM mergeinfo_paths;
+DELETE FROM indexed_revs;
@@ -0,0 +1,498 @@
+/* mergeinfo-index.c --- the FSFS mergeinfo index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "fs_fs.h"
+#include "dag.h"
+#include "transaction.h"
+#include "mergeinfo-index.h"
+#include "mergeinfo-index-db.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_fs_util.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+#include "svn_private_config.h"
+
+/* Queries for descendant mergeinfo have to walk every directory whose
+   node-revision claims to have mergeinfo below it.  With subtree
+   mergeinfo on many thousand paths, that is most of the tree.
+
+   The index records, for each node carrying svn:mergeinfo, the span of
+   revisions during which it did so.  Any revision between FIRST_REV and
+   LAST_REV of the INDEXED_REVS table can therefore be answered with a
+   single range scan over the relpaths.  The index gets created from the
+   latest revision and is then updated from each new revision's changed
+   paths list. */
+
+/* Schema version of the mergeinfo index. */
+#define MERGEINFO_INDEX_SCHEMA_FORMAT 1
+
+/* If the index lags behind by more than this many revisions, rebuilding
+   it from the latest revision is cheaper than catching up. */
+#define MAX_CATCH_UP_REVS 1000
+
+MERGEINFO_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Body of get_index_db().
+   Implements svn_atomic__init_once().init_func. */
+static svn_error_t *
+open_index_db(void *baton,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open2(&sdb,
+                            svn_dirent_join(fs->path, PATH_MERGEINFO_INDEX_DB,
+                                            pool),
+                            svn_sqlite__mode_rwcreate, statements,
+                            &ffd->sqlite_options,
+                            fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version == 0)
+    {
+      /* An uninitialized (no schema) database.  Create the schema. */
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+  else if (version != MERGEINFO_INDEX_SCHEMA_FORMAT)
+    {
+      SVN_ERR(svn_sqlite__close(sdb));
+      return svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                               _("Unsupported mergeinfo index format %d"),
+                               version);
+    }
+
+  ffd->mergeinfo_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SDB to the mergeinfo index database of FS or to NULL if FS does
+   not use one.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_index_db(svn_sqlite__db_t **sdb,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->enable_mergeinfo_index && svn_fs_fs__fs_supports_mergeinfo(fs))
+    SVN_ERR(svn_atomic__init_once(&ffd->mergeinfo_index_db_opened,
+                                  open_index_db, fs, scratch_pool));
+
+  *sdb = ffd->mergeinfo_index_db;
+  return SVN_NO_ERROR;
+}
+
+/* Set *FIRST_REV and *LAST_REV to the range of revisions covered by the
+   index in SDB.  Set both to SVN_INVALID_REVNUM if the index is empty. */
+static svn_error_t *
+get_indexed_revs(svn_revnum_t *first_rev,
+                 svn_revnum_t *last_rev,
+                 svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INDEXED_REVS));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *first_rev = svn_sqlite__column_revnum(stmt, 0);
+      *last_rev = svn_sqlite__column_revnum(stmt, 1);
+    }
+  else
+    {
+      *first_rev = SVN_INVALID_REVNUM;
+      *last_rev = SVN_INVALID_REVNUM;
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Baton for lookup_descendants(). */
+typedef struct lookup_baton_t
+{
+  apr_array_header_t **paths;
+  svn_revnum_t rev;
+  const char *path;
+  apr_pool_t *result_pool;
+} lookup_baton_t;
+
+/* Implement svn_fs_fs__mergeinfo_index_lookup() for the lookup_baton_t
+   BATON within a transaction on SDB.  Implements
+   svn_sqlite__transaction_callback_t. */
+static svn_error_t *
+lookup_descendants(void *baton,
+                   svn_sqlite__db_t *sdb,
+                   apr_pool_t *scratch_pool)
+{
+  lookup_baton_t *b = baton;
+  svn_revnum_t first_rev, last_rev;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *paths;
+
+  *b->paths = NULL;
+
+  SVN_ERR(get_indexed_revs(&first_rev, &last_rev, sdb));
+  if (   !SVN_IS_VALID_REVNUM(first_rev)
+      || b->rev < first_rev
+      || b->rev > last_rev)
+    return SVN_NO_ERROR;
+
+  paths = apr_array_make(b->result_pool, 16, sizeof(const char *));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_DESCENDANTS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", b->path + 1, b->rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *relpath = svn_sqlite__column_text(stmt, 0, NULL);
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(b->result_pool, "/", relpath, SVN_VA_NULL);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  *b->paths = paths;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_lookup(apr_array_header_t **paths,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t rev,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+
+  *paths = NULL;
+
+  err = get_index_db(&sdb, fs, scratch_pool);
+  if (!err && sdb)
+    {
+      lookup_baton_t baton;
+      baton.paths = paths;
+      baton.rev = rev;
+      baton.path = path;
+      baton.result_pool = result_pool;
+
+      /* Read the covered range and the rows from the same snapshot. */
+      err = svn_sqlite__with_transaction(sdb, lookup_descendants, &baton,
+                                         scratch_pool);
+    }
+
+  /* Without a usable index, the caller will crawl the tree instead. */
+  if (err)
+    {
+      svn_error_clear(err);
+      *paths = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Record in SDB that the node at RELPATH carries mergeinfo as of REV. */
+static svn_error_t *
+add_path(svn_sqlite__db_t *sdb,
+         const char *relpath,
+         svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_ADD_PATH));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", relpath, rev));
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Record in SDB that the node at RELPATH and, if RECURSIVE is set, all
+   nodes below it don't carry mergeinfo anymore as of REV. */
+static svn_error_t *
+remove_path(svn_sqlite__db_t *sdb,
+            const char *relpath,
+            svn_boolean_t recursive,
+            svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    recursive ? STMT_REMOVE_PATH_RECURSIVE
+                                              : STMT_REMOVE_PATH));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", relpath, rev));
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Add all nodes carrying mergeinfo in the sub-tree of revision REV that
+   starts at NODE, found at RELPATH, to the index in SDB.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_subtree(svn_sqlite__db_t *sdb,
+            dag_node_t *node,
+            const char *relpath,
+            svn_revnum_t rev,
+            apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_mergeinfo, go_down;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, node));
+  if (has_mergeinfo)
+    SVN_ERR(add_path(sdb, relpath, rev));
+
+  SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down, node));
+  if (!go_down)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, node, scratch_pool));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      dag_node_t *kid;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_fs__dag_get_node(&kid, svn_fs_fs__dag_get_fs(node),
+                                      dirent->id, iterpool));
+      SVN_ERR(add_subtree(sdb, kid,
+                          svn_relpath_join(relpath, dirent->name, iterpool),
+                          rev, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *NODE_P to the node at RELPATH below the directory ROOT, or to NULL
+   if there is no such node.  Use POOL for allocations. */
+static svn_error_t *
+open_node(dag_node_t **node_p,
+          dag_node_t *root,
+          const char *relpath,
+          apr_pool_t *pool)
+{
+  dag_node_t *node = root;
+  const char *rest = *relpath ? relpath : NULL;
+
+  while (node && rest)
+    {
+      char *entry = svn_fs__next_entry_name(&rest, rest, pool);
+
+      if (svn_fs_fs__dag_node_kind(node) != svn_node_dir)
+        node = NULL;
+      else
+        SVN_ERR(svn_fs_fs__dag_open(&node, node, entry, pool, pool));
+    }
+
+  *node_p = node;
+  return SVN_NO_ERROR;
+}
+
+/* Apply the changes of revision REV in FS to the index in SDB.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changes;
+  apr_array_header_t *sorted;
+  dag_node_t *root;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_fs__paths_changed(&changes, fs, rev, scratch_pool));
+  SVN_ERR(svn_fs_fs__dag_revision_root(&root, fs, rev, scratch_pool));
+
+  /* Parents come before their children, so deletions and replacements
+     are applied before the changes below them. */
+  sorted = svn_sort__hash(changes, svn_sort_compare_items_as_paths,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_fs_path_change2_t *change = item->value;
+      const char *relpath = (const char *)item->key + 1;
+      dag_node_t *node;
+
+      svn_pool_clear(iterpool);
+
+      switch (change->change_kind)
+        {
+          case svn_fs_path_change_delete:
+            SVN_ERR(remove_path(sdb, relpath, TRUE, rev));
+            break;
+
+          case svn_fs_path_change_replace:
+            SVN_ERR(remove_path(sdb, relpath, TRUE, rev));
+            /* Fall through. */
+
+          case svn_fs_path_change_add:
+            /* Copies bring along all mergeinfo of their source tree. */
+            SVN_ERR(open_node(&node, root, relpath, iterpool));
+            if (node)
+              SVN_ERR(add_subtree(sdb, node, relpath, rev, iterpool));
+            break;
+
+          case svn_fs_path_change_modify:
+            if (change->prop_mod
+                && change->mergeinfo_mod != svn_tristate_false)
+              {
+                svn_boolean_t has_mergeinfo;
+
+                SVN_ERR(open_node(&node, root, relpath, iterpool));
+                if (node)
+                  SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo,
+                                                       node));
+                else
+                  has_mergeinfo = FALSE;
+
+                if (has_mergeinfo)
+                  {
+                    svn_sqlite__stmt_t *stmt;
+                    svn_boolean_t have_row;
+
+                    /* Keep the ADDED_REV of nodes that merely got their
+                       mergeinfo changed. */
+                    SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                                      STMT_HAS_PATH));
+                    SVN_ERR(svn_sqlite__bindf(stmt, "s", relpath));
+                    SVN_ERR(svn_sqlite__step(&have_row, stmt));
+                    SVN_ERR(svn_sqlite__reset(stmt));
+
+                    if (!have_row)
+                      SVN_ERR(add_path(sdb, relpath, rev));
+                  }
+                else
+                  {
+                    SVN_ERR(remove_path(sdb, relpath, FALSE, rev));
+                  }
+              }
+            break;
+
+          default:
+            break;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for update_index(). */
+typedef struct update_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t youngest;
+} update_baton_t;
+
+/* Bring the index in SDB up to date with the update_baton_t BATON.
+   Implements svn_sqlite__transaction_callback_t. */
+static svn_error_t *
+update_index(void *baton,
+             svn_sqlite__db_t *sdb,
+             apr_pool_t *scratch_pool)
+{
+  update_baton_t *b = baton;
+  svn_revnum_t first_rev, last_rev;
+  svn_sqlite__stmt_t *stmt;
+
+  /* Another process may have been faster than us. */
+  SVN_ERR(get_indexed_revs(&first_rev, &last_rev, sdb));
+  if (last_rev == b->youngest)
+    return SVN_NO_ERROR;
+
+  if (   !SVN_IS_VALID_REVNUM(last_rev)
+      || last_rev > b->youngest
+      || b->youngest - last_rev > MAX_CATCH_UP_REVS)
+    {
+      dag_node_t *root;
+
+      SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_CLEAR_INDEX));
+      SVN_ERR(svn_fs_fs__dag_revision_root(&root, b->fs, b->youngest,
+                                           scratch_pool));
+      SVN_ERR(add_subtree(sdb, root, "", b->youngest, scratch_pool));
+      first_rev = b->youngest;
+    }
+  else
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      svn_revnum_t rev;
+
+      for (rev = last_rev + 1; rev <= b->youngest; ++rev)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(index_revision(sdb, b->fs, rev, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INDEXED_REVS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "rr", first_rev, b->youngest));
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_update(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+
+  err = get_index_db(&sdb, fs, scratch_pool);
+  if (!err && sdb)
+    {
+      update_baton_t baton;
+      baton.fs = fs;
+      baton.youngest = youngest;
+
+      /* Concurrent committers serialize on the database's write lock. */
+      err = svn_sqlite__with_immediate_transaction(sdb, update_index, &baton,
+                                                   scratch_pool);
+    }
+
+  /* The index is optional.  If we could not update it, a later commit
+     will catch up or rebuild it. */
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,65 @@
+/* mergeinfo-index.h : interface to the FSFS mergeinfo index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* The mergeinfo index is an optional SQLite database that lists, for each
+   revision it covers, all nodes carrying svn:mergeinfo.  It is enabled by
+   the fsfs.conf option [mergeinfo] enable-mergeinfo-index and updated
+   after each commit.  A missing, outdated or broken index is never an
+   error; callers simply fall back to crawling the DAG. */
+
+/* Set *PATHS to the sorted list of fspaths (const char *) of all strict
+   descendants of the fspath PATH that carry svn:mergeinfo in revision REV
+   of FS.  Set *PATHS to NULL if the index of FS is not enabled or does
+   not cover REV.  Allocate *PATHS in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_lookup(apr_array_header_t **paths,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t rev,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* If the mergeinfo index is enabled for FS, bring it up to date with
+   revision YOUNGEST, creating it if necessary.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_update(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H */
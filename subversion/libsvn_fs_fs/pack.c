@@ -22,6 +22,7 @@
 #include <assert.h>
 #include <string.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
@@ -30,8 +31,11 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_fspath.h"
+#include "private/svn_task.h"
 
 #include "fs_fs.h"
+#include "cached_data.h"
 #include "pack.h"
 #include "util.h"
 #include "id.h"
@@ -119,8 +123,26 @@ typedef struct path_order_t
 
   /* item ID of the representation containing the new data. May be (0, 0). */
   svn_fs_fs__id_part_t rep_id;
+
+  /* rank of the most frequently accessed hint path covering this node,
+   * 0 being the hottest.  NO_ACCESS_RANK if not covered by any hint. */
+  int access_rank;
 } path_order_t;
 
+/* Value of path_order_t.access_rank for nodes that are not covered by
+ * any access hint. */
+#define NO_ACCESS_RANK (-1)
+
+/* A node at a frequently accessed path, see sort_reps_range(). */
+typedef struct hot_node_t
+{
+  /* path_order_t.access_rank of the node. */
+  int rank;
+
+  /* index of the node in the path order array. */
+  int index;
+} hot_node_t;
+
 /* Represents a reference from item FROM to item TO.  FROM may be a noderev
  * or rep_id while TO is (currently) always a representation.  We will sort
  * them by TO which allows us to collect all dependent items.
@@ -234,10 +256,146 @@ typedef struct pack_context_t
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
 
+  /* maps frequently accessed paths (const char *) to their rank (int *),
+   * 0 being the hottest.  NULL if no access hints have been given. */
+  apr_hash_t *access_hints;
+
   /* ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
 } pack_context_t;
 
+/* Access hint as read from the hints file. */
+typedef struct access_hint_t
+{
+  /* fspath being accessed */
+  const char *path;
+
+  /* number of accesses (or any other weight) */
+  apr_int64_t count;
+
+  /* line number, to keep the order of equally frequent paths stable */
+  int line;
+} access_hint_t;
+
+/* Implements compare_fn_t.  Sort access_hint_t * by descending count. */
+static int
+compare_access_hints(const void *lhs_p,
+                     const void *rhs_p)
+{
+  const access_hint_t *lhs = *(const access_hint_t * const *)lhs_p;
+  const access_hint_t *rhs = *(const access_hint_t * const *)rhs_p;
+
+  if (lhs->count != rhs->count)
+    return lhs->count < rhs->count ? 1 : -1;
+
+  return lhs->line - rhs->line;
+}
+
+/* Read the access hints file at PATH and return the path -> rank mapping
+ * in *HINTS, allocated in RESULT_POOL.  Each non-empty line that does not
+ * start with '#' contains an optional access count, followed by white
+ * space and a repository path.  The most frequently accessed path gets
+ * rank 0.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_access_hints(apr_hash_t **hints,
+                  const char *path,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  apr_array_header_t *lines;
+  apr_array_header_t *entries;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&content, path, scratch_pool));
+  lines = svn_cstring_split(content->data, "\n", TRUE, scratch_pool);
+  entries = apr_array_make(scratch_pool, lines->nelts,
+                           sizeof(access_hint_t *));
+
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      char *line = APR_ARRAY_IDX(lines, i, char *);
+      access_hint_t *hint;
+
+      if (*line == '#')
+        continue;
+
+      hint = apr_pcalloc(scratch_pool, sizeof(*hint));
+      hint->count = 1;
+      hint->line = i;
+
+      /* Optional access count. */
+      if (*line != '/')
+        {
+          char *count = line;
+          line += strcspn(line, " \t");
+          if (*line)
+            *line++ = '\0';
+
+          SVN_ERR(svn_cstring_strtoi64(&hint->count, count, 0,
+                                       APR_INT64_MAX, 10));
+          line += strspn(line, " \t");
+        }
+
+      if (*line != '/')
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 _("Invalid access hint '%s' in '%s'"),
+                                 APR_ARRAY_IDX(lines, i, const char *),
+                                 svn_dirent_local_style(path,
+                                                        scratch_pool));
+
+      hint->path = svn_fspath__canonicalize(line, scratch_pool);
+      APR_ARRAY_PUSH(entries, access_hint_t *) = hint;
+    }
+
+  /* Hottest paths first.  Only the first occurrence of a path counts. */
+  svn_sort__array(entries, compare_access_hints);
+
+  *hints = apr_hash_make(result_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      access_hint_t *hint = APR_ARRAY_IDX(entries, i, access_hint_t *);
+      if (!svn_hash_gets(*hints, hint->path))
+        {
+          int *rank = apr_palloc(result_pool, sizeof(*rank));
+          *rank = i;
+          svn_hash_sets(*hints, apr_pstrdup(result_pool, hint->path), rank);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the rank of the hottest access hint in CONTEXT that covers PATH,
+ * i.e. that is PATH itself or any of its parents.  Return NO_ACCESS_RANK
+ * if there is no such hint.  Use SCRATCH_POOL for temporary allocations.
+ */
+static int
+get_access_rank(pack_context_t *context,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  int result = NO_ACCESS_RANK;
+
+  if (!context->access_hints)
+    return result;
+
+  while (TRUE)
+    {
+      int *rank = svn_hash_gets(context->access_hints, path);
+      if (rank && (result == NO_ACCESS_RANK || *rank < result))
+        result = *rank;
+
+      if (svn_fspath__is_root(path, strlen(path)))
+        break;
+
+      path = svn_fspath__dirname(path, scratch_pool);
+    }
+
+  return result;
+}
+
 /* Create and initialize a new pack context for packing shard SHARD_REV in
  * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
  * and return the structure in *CONTEXT.
@@ -283,6 +441,11 @@ initialize_pack_context(pack_context_t *context,
 
   context->flush_to_disk = flush_to_disk;
 
+  /* optional access statistics to guide the item placement */
+  if (ffd->pack_access_hints)
+    SVN_ERR(read_access_hints(&context->access_hints, ffd->pack_access_hints,
+                              pool, pool));
+
   /* Create the new directory and pack file. */
   context->shard_dir = shard_dir;
   context->pack_file_dir = pack_file_dir;
@@ -773,6 +936,8 @@ copy_node_to_temp(pack_context_t *context,
   path_order->revision = svn_fs_fs__id_rev(noderev->id);
   path_order->predecessor_count = noderev->predecessor_count;
   path_order->noderev_id = *svn_fs_fs__id_rev_item(noderev->id);
+  path_order->access_rank = get_access_rank(context, noderev->created_path,
+                                            pool);
   APR_ARRAY_PUSH(context->path_order, path_order_t *) = path_order;
 
   return SVN_NO_ERROR;
@@ -871,20 +1036,75 @@ classify_nodes(path_order_t **path_order,
     }
 }
 
+/* implements compare_fn_t.  Sort hot_node_t by RANK, then INDEX.
+ */
+static int
+compare_hot_nodes(const void *lhs_p,
+                  const void *rhs_p)
+{
+  const hot_node_t *lhs = lhs_p;
+  const hot_node_t *rhs = rhs_p;
+
+  if (lhs->rank != rhs->rank)
+    return lhs->rank < rhs->rank ? -1 : 1;
+
+  return lhs->index - rhs->index;
+}
+
+/* Pick the node at index I in *PATH_ORDER and all nodes for the same path
+ * along its deltification chain.  Move them to *TEMP, starting at *DEST,
+ * and advance *DEST accordingly.  Entries that have already been picked
+ * are NULL.  LAST is the end of the range to consider.  The references
+ * in CONTEXT must already be sorted.
+ */
+static void
+pick_delta_chain(pack_context_t *context,
+                 path_order_t **path_order,
+                 path_order_t **temp,
+                 int *dest,
+                 int i,
+                 int last)
+{
+  const svn_prefix_string__t *path = path_order[i]->path;
+  svn_fs_fs__id_part_t rep_id = path_order[i]->rep_id;
+
+  /* All nodes for the same path are adjacent, latest first. */
+  for (; i < last; ++i)
+    if (path_order[i])
+      {
+        if (svn_prefix_string__compare(path, path_order[i]->path))
+          break;
+
+        if (svn_fs_fs__id_part_eq(&path_order[i]->rep_id, &rep_id))
+          {
+            reference_t **reference;
+
+            temp[(*dest)++] = path_order[i];
+            path_order[i] = NULL;
+
+            reference = svn_sort__array_lookup(context->references,
+                                               &rep_id, NULL,
+              (int (*)(const void *, const void *))compare_ref_to_item);
+            if (reference)
+              rep_id = (*reference)->to;
+          }
+      }
+}
+
 /* Order a range of data collected in CONTEXT such that we can place them
  * in the desired order.  The input is taken from *PATH_ORDER, offsets FIRST
  * to LAST and then written in the final order to the same range in *TEMP.
+ * Use SCRATCH_POOL for temporary allocations.
  */
 static void
 sort_reps_range(pack_context_t *context,
                 path_order_t **path_order,
                 path_order_t **temp,
                 int first,
-                int last)
+                int last,
+                apr_pool_t *scratch_pool)
 {
-  const svn_prefix_string__t *path;
   int i, dest;
-  svn_fs_fs__id_part_t rep_id;
   fs_fs_data_t *ffd = context->fs->fsap_data;
 
   /* The logic below would fail for empty ranges. */
@@ -893,6 +1113,7 @@ sort_reps_range(pack_context_t *context,
 
   /* Re-order noderevs like this:
    *
+   * (0) HEAD of frequently accessed paths + dependency chain, hottest first.
    * (1) Most likely to be referenced by future pack files, in path order.
    * (2) highest revision rep per path + dependency chain
    * (3) Remaining reps in path, rev order
@@ -901,6 +1122,32 @@ sort_reps_range(pack_context_t *context,
    */
   dest = first;
 
+  /* (0) If we have been told which paths get read most often, we keep
+   * the data needed to e.g. check out these paths close together at the
+   * front of the pack file.  That minimizes the number of blocks to read
+   * for them.  Within the same hint, we keep the path order.
+   */
+  if (context->access_hints)
+    {
+      apr_array_header_t *hot_nodes
+        = apr_array_make(scratch_pool, 16, sizeof(hot_node_t));
+
+      for (i = first; i < last; ++i)
+        if (path_order[i]->is_head
+            && path_order[i]->access_rank != NO_ACCESS_RANK)
+          {
+            hot_node_t *node = apr_array_push(hot_nodes);
+            node->rank = path_order[i]->access_rank;
+            node->index = i;
+          }
+
+      svn_sort__array(hot_nodes, compare_hot_nodes);
+      for (i = 0; i < hot_nodes->nelts; ++i)
+        pick_delta_chain(context, path_order, temp, &dest,
+                         APR_ARRAY_IDX(hot_nodes, i, hot_node_t).index,
+                         last);
+    }
+
   /* (1) There are two classes of representations that are likely to be
    * referenced from future shards.  These form a "hot zone" of mostly
    * relevant data, i.e. we try to include as many reps as possible that
@@ -917,7 +1164,13 @@ sort_reps_range(pack_context_t *context,
    */
   for (i = first; i < last; ++i)
     {
-      int round = roundness(path_order[i]->predecessor_count);
+      int round;
+
+      /* Already picked in (0)? */
+      if (!path_order[i])
+        continue;
+
+      round = roundness(path_order[i]->predecessor_count);
 
       /* Class 1:
        * Pretty round _and_ a significant stop in the node's delta chain.
@@ -959,36 +1212,15 @@ sort_reps_range(pack_context_t *context,
   for (i = first; i < last; ++i)
     if (path_order[i])
       {
-        /* This is the first path we still have to handle. */
-        path = path_order[i]->path;
-        rep_id = path_order[i]->rep_id;
-        break;
-      }
-
-  for (i = first; i < last; ++i)
-    if (path_order[i])
-      {
-        /* New path? */
-        if (svn_prefix_string__compare(path, path_order[i]->path))
-          {
-            path = path_order[i]->path;
-            rep_id = path_order[i]->rep_id;
-          }
-
-        /* Pick nodes along the deltification chain.  Skip side-branches. */
-        if (svn_fs_fs__id_part_eq(&path_order[i]->rep_id, &rep_id))
-          {
-            reference_t **reference;
-
-            temp[dest++] = path_order[i];
-            path_order[i] = NULL;
-
-            reference = svn_sort__array_lookup(context->references,
-                                               &rep_id, NULL,
-              (int (*)(const void *, const void *))compare_ref_to_item);
-            if (reference)
-              rep_id = (*reference)->to;
-          }
+        const svn_prefix_string__t *path = path_order[i]->path;
+        pick_delta_chain(context, path_order, temp, &dest, i, last);
+
+        /* Skip the remaining nodes for this path. */
+        while (   i + 1 < last
+               && (   !path_order[i + 1]
+                   || !svn_prefix_string__compare(path,
+                                                  path_order[i + 1]->path)))
+          ++i;
       }
 
   /* (3) All remaining nodes in path, rev order.  Linear deltification
@@ -1041,7 +1273,7 @@ sort_reps(pack_context_t *context)
   classify_nodes(path_order, count);
 
   /* Rearrange those sub-sections separately. */
-  sort_reps_range(context, path_order, temp, 0, count);
+  sort_reps_range(context, path_order, temp, 0, count, temp_pool);
 
   /* We now know the final ordering. */
   for (i = 0; i < count; ++i)
@@ -1800,6 +2032,295 @@ pack_phys_addressed(const char *pack_file_dir,
   return SVN_NO_ERROR;
 }
 
+/* Changed-paths index logic:
+ *
+ * For every packed shard, we keep a small text file that lists all paths
+ * changed within that shard together with the revisions that changed them.
+ * The lines are sorted by path and have the form
+ *
+ *   <rev>[,<rev>...] <path>\n
+ *
+ * The index is derived data.  Shards packed before it got introduced
+ * simply don't have one and readers must fall back to the revisions'
+ * changed paths lists.
+ */
+
+/* Changed-paths information collected for a single path in a shard. */
+typedef struct changed_path_revs_t
+{
+  /* Revisions that changed the path, in ascending order. */
+  apr_array_header_t *revs;
+} changed_path_revs_t;
+
+/* Return TRUE, if a change to CHANGED_PATH may affect the history of PATH,
+ * i.e. if it is PATH itself, one of its parents or something below PATH.
+ * Both are expected to be canonical fspaths. */
+static svn_boolean_t
+is_related_path(const char *path,
+                const char *changed_path)
+{
+  return svn_fspath__skip_ancestor(path, changed_path)
+      || svn_fspath__skip_ancestor(changed_path, path);
+}
+
+/* In filesystem FS, write the changed-paths index for the revision shard
+ * starting at SHARD_REV and containing exactly MAX_FILES_PER_DIR revisions
+ * to PACK_FILE_DIR.  The revisions must not have been packed yet.  If
+ * FLUSH_TO_DISK is non-zero, do not return until the data has actually
+ * been written on the disk.  Use POOL for allocations.
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ */
+static svn_error_t *
+write_changes_index(svn_fs_t *fs,
+                    const char *pack_file_dir,
+                    svn_revnum_t shard_rev,
+                    int max_files_per_dir,
+                    svn_boolean_t flush_to_disk,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *paths = svn_hash__make(pool);
+  svn_stringbuf_t *index = svn_stringbuf_create_empty(pool);
+  apr_array_header_t *sorted;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+  int i, k;
+
+  /* Collect the revisions per changed path. */
+  for (rev = shard_rev; rev < shard_rev + max_files_per_dir; ++rev)
+    {
+      svn_fs_fs__changes_context_t *context;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, rev,
+                                                iterpool));
+      while (!context->eol)
+        {
+          apr_array_header_t *changes;
+
+          SVN_ERR(svn_fs_fs__get_changes(&changes, context, iterpool,
+                                         iterpool));
+          for (i = 0; i < changes->nelts; ++i)
+            {
+              change_t *change = APR_ARRAY_IDX(changes, i, change_t *);
+              changed_path_revs_t *entry
+                = apr_hash_get(paths, change->path.data, change->path.len);
+
+              if (!entry)
+                {
+                  entry = apr_palloc(pool, sizeof(*entry));
+                  entry->revs = apr_array_make(pool, 4, sizeof(svn_revnum_t));
+                  apr_hash_set(paths,
+                               apr_pstrmemdup(pool, change->path.data,
+                                              change->path.len),
+                               change->path.len, entry);
+                }
+
+              /* The same path may be listed more than once per revision. */
+              if (   entry->revs->nelts == 0
+                  || APR_ARRAY_IDX(entry->revs, entry->revs->nelts - 1,
+                                   svn_revnum_t) != rev)
+                APR_ARRAY_PUSH(entry->revs, svn_revnum_t) = rev;
+            }
+        }
+    }
+
+  /* Serialize the index in path order. */
+  sorted = svn_sort__hash(paths, svn_sort_compare_items_lexically, pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      changed_path_revs_t *entry = item->value;
+
+      for (k = 0; k < entry->revs->nelts; ++k)
+        {
+          char buffer[SVN_INT64_BUFFER_SIZE];
+          apr_size_t len
+            = svn__i64toa(buffer, APR_ARRAY_IDX(entry->revs, k,
+                                                svn_revnum_t));
+
+          if (k)
+            svn_stringbuf_appendbyte(index, ',');
+          svn_stringbuf_appendbytes(index, buffer, len);
+        }
+
+      svn_stringbuf_appendbyte(index, ' ');
+      svn_stringbuf_appendbytes(index, item->key, item->klen);
+      svn_stringbuf_appendbyte(index, '\n');
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_io_write_atomic2(
+                           svn_dirent_join(pack_file_dir, PATH_CHANGES_INDEX,
+                                           pool),
+                           index->data, index->len, NULL, flush_to_disk,
+                           pool));
+}
+
+/* Set *CHANGED to TRUE, if the changed-paths INDEX read from INDEX_PATH
+ * lists a revision in START to END (inclusive) for a path related to PATH
+ * as defined by is_related_path().  Otherwise, leave *CHANGED untouched.
+ * INDEX will be modified in the process.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+scan_changes_index(svn_boolean_t *changed,
+                   svn_stringbuf_t *index,
+                   const char *index_path,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   apr_pool_t *scratch_pool)
+{
+  char *line = index->data;
+  char *index_end = index->data + index->len;
+
+  while (line < index_end)
+    {
+      char *eol = memchr(line, '\n', index_end - line);
+      char *separator = eol ? memchr(line, ' ', eol - line) : NULL;
+
+      if (!separator)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Corrupt changed-paths index '%s'"),
+                                 svn_dirent_local_style(index_path,
+                                                        scratch_pool));
+
+      *eol = '\0';
+      if (is_related_path(path, separator + 1))
+        {
+          const char *p = line;
+          *separator = '\0';
+
+          while (*p)
+            {
+              svn_revnum_t rev;
+
+              SVN_ERR(svn_revnum_parse(&rev, p, &p));
+              if (rev >= start && rev <= end)
+                {
+                  *changed = TRUE;
+                  return SVN_NO_ERROR;
+                }
+
+              if (*p == ',')
+                ++p;
+            }
+        }
+
+      line = eol + 1;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__subtree_changed(svn_boolean_t *changed,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  if (start > end)
+    {
+      rev = start;
+      start = end;
+      end = rev;
+    }
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+
+  /* Without packed shards, there is no index and we can't tell cheaply. */
+  *changed = TRUE;
+  if (!ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+
+  /* Non-packed revisions have no index and we would have to read their
+     changed paths lists.  That is only cheap for a short tail of
+     revisions, e.g. if the repository gets packed regularly.  Otherwise,
+     don't guess. */
+  if (end - MAX(start, ffd->min_unpacked_rev) >= ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = end; rev >= start && !svn_fs_fs__is_packed_rev(fs, rev); --rev)
+    {
+      svn_fs_fs__changes_context_t *context;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, rev,
+                                                iterpool));
+      while (!context->eol)
+        {
+          apr_array_header_t *changes;
+          int i;
+
+          SVN_ERR(svn_fs_fs__get_changes(&changes, context, iterpool,
+                                         iterpool));
+          for (i = 0; i < changes->nelts; ++i)
+            {
+              change_t *change = APR_ARRAY_IDX(changes, i, change_t *);
+              if (is_related_path(path, change->path.data))
+                {
+                  svn_pool_destroy(iterpool);
+                  return SVN_NO_ERROR;
+                }
+            }
+        }
+    }
+
+  /* Scan the packed shards using their changed-paths indexes. */
+  while (rev >= start)
+    {
+      svn_revnum_t shard_rev = rev - rev % ffd->max_files_per_dir;
+      const char *index_path;
+      svn_stringbuf_t *index;
+      svn_boolean_t found = FALSE;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      index_path = svn_fs_fs__path_rev_packed(fs, rev, PATH_CHANGES_INDEX,
+                                              iterpool);
+      err = svn_stringbuf_from_file2(&index, index_path, iterpool);
+
+      /* Shards packed by older releases don't have an index. */
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+
+      SVN_ERR(scan_changes_index(&found, index, index_path, path,
+                                 MAX(start, shard_rev), rev, iterpool));
+      if (found)
+        {
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+
+      rev = shard_rev - 1;
+    }
+
+  svn_pool_destroy(iterpool);
+  *changed = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
 /* In filesystem FS, pack the revision SHARD containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
  * using POOL for allocations.  Try to limit the amount of temporary
@@ -1847,6 +2368,11 @@ pack_rev_shard(svn_fs_t *fs,
                                 max_files_per_dir, flush_to_disk,
                                 cancel_func, cancel_baton, pool));
 
+  /* The revisions are still available in their non-packed form. */
+  SVN_ERR(write_changes_index(fs, pack_file_dir, shard_rev,
+                              max_files_per_dir, flush_to_disk,
+                              cancel_func, cancel_baton, pool));
+
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
 
@@ -1957,6 +2483,53 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Set *REV_PACK_FILE_DIR and *REV_SHARD_PATH to the paths of the packed
+ * and the non-packed version of SHARD in REVS_DIR, allocated in POOL.
+ */
+static void
+get_shard_paths(const char **rev_pack_file_dir,
+                const char **rev_shard_path,
+                const char *revs_dir,
+                apr_int64_t shard,
+                apr_pool_t *pool)
+{
+  *rev_pack_file_dir = svn_dirent_join(revs_dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+  *rev_shard_path = svn_dirent_join(revs_dir,
+                                    apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                                 shard),
+                                    pool);
+}
+
+/* Make the shard described by BATON use the pack file that has already
+ * been created for it and notify the caller that we are done with it.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1975,16 +2548,8 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
+  get_shard_paths(&rev_pack_file_dir, &baton->rev_shard_path,
+                  baton->revs_dir, baton->shard, pool);
 
   /* pack the revision content */
   SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
@@ -1992,19 +2557,116 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(switch_to_packed_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
+/* A shard whose pack file gets created concurrently with others. */
+typedef struct shard_task_t
+{
+  /* Instance of the filesystem being packed that nobody else modifies.
+     The tasks open their own instances from it because the FSFS caches
+     etc. are not thread-safe. */
+  svn_fs_t *fs;
+
+  /* The shard to pack, its parent folder and the memory limit to pass
+     to pack_rev_shard(). */
+  apr_int64_t shard;
+  const char *revs_dir;
+  apr_size_t max_mem;
+} shard_task_t;
+
+/* Implements svn_task__process_func_t.  Create the pack file for the
+   shard_task_t in PROCESS_BATON and return the path of the unpacked
+   shard in *RESULT. */
+static svn_error_t *
+pack_shard_task(void **result,
+                void *process_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  shard_task_t *task = process_baton;
+  const char *rev_pack_file_dir;
+  const char *rev_shard_path;
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+
+  SVN_ERR(svn_fs_fs__open_instance(&fs, task->fs, scratch_pool,
+                                   scratch_pool));
+  ffd = fs->fsap_data;
+
+  get_shard_paths(&rev_pack_file_dir, &rev_shard_path, task->revs_dir,
+                  task->shard, result_pool);
+  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
+                         task->shard, ffd->max_files_per_dir, task->max_mem,
+                         ffd->flush_to_disk, cancel_func, cancel_baton,
+                         scratch_pool));
+
+  *result = (void *)rev_shard_path;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Switch the repository over to
+   the pack file of the next shard, whose unpacked path is RESULT.
+   OUTPUT_BATON is the struct pack_baton of the operation. */
+static svn_error_t *
+switch_shard_output(void *result,
+                    void *output_baton,
+                    apr_pool_t *scratch_pool)
+{
+  struct pack_baton *baton = output_baton;
+
+  /* Notify caller we're starting to pack this shard.  Do it here to get
+     the same sequence of notifications as with a sequential pack. */
   if (baton->notify_func)
     SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+                               svn_fs_pack_notify_start, scratch_pool));
+
+  baton->rev_shard_path = result;
+  SVN_ERR(switch_to_packed_shard(baton, scratch_pool));
+  baton->shard++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pack the shards from BATON->SHARD up to but not including
+   COMPLETED_SHARDS, creating up to JOBS pack files concurrently.
+   The repository gets switched over to the new pack files strictly in
+   shard order, i.e. min-unpacked-rev never skips a shard.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+pack_shards_parallel(struct pack_baton *baton,
+                     apr_int64_t completed_shards,
+                     int jobs,
+                     apr_pool_t *pool)
+{
+  apr_pool_t *set_pool = svn_pool_create(pool);
+  svn_task__set_t *set;
+  svn_fs_t *fs;
+  apr_int64_t shard;
+
+  /* The main thread keeps modifying BATON->FS while the tasks run.
+     Give them a snapshot to open their instances from. */
+  SVN_ERR(svn_fs_fs__open_instance(&fs, baton->fs, pool, pool));
+
+  SVN_ERR(svn_task__set_create(&set, jobs, switch_shard_output, baton,
+                               baton->cancel_func, baton->cancel_baton,
+                               set_pool));
+  for (shard = baton->shard; shard < completed_shards; shard++)
+    {
+      shard_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      task->fs = fs;
+      task->shard = shard;
+      task->revs_dir = baton->revs_dir;
+      task->max_mem = baton->max_mem;
+
+      SVN_ERR(svn_task__add(set, pack_shard_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
 
   return SVN_NO_ERROR;
 }
@@ -2080,6 +2742,13 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  /* Create multiple pack files concurrently if we have been asked to
+     and if there is more than one shard to pack. */
+  pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  if (ffd->pack_jobs > 1 && completed_shards - pb->shard > 1)
+    return svn_error_trace(pack_shards_parallel(pb, completed_shards,
+                                                ffd->pack_jobs, pool));
+
   iterpool = svn_pool_create(pool);
   for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
        pb->shard < completed_shards;
@@ -56,6 +56,24 @@ svn_fs_fs__get_packed_offset(apr_off_t *rev_offset,
                              svn_revnum_t rev,
                              apr_pool_t *pool);
 
+/* Set *CHANGED to FALSE, if no revision from START to END (inclusive) in
+ * FS changed PATH, any of its parents or anything below PATH.  Otherwise,
+ * set it to TRUE.  START may be larger than END.
+ *
+ * This uses the changed-paths indexes of packed shards and may report
+ * TRUE for shards without such an index.  Unpacked revisions get only
+ * scanned if there are less than a shard's worth of them in the range;
+ * otherwise, TRUE is reported.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__subtree_changed(svn_boolean_t *changed,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           apr_pool_t *scratch_pool);
+
 /* Return the svn_dir_entry_t* objects of DIRECTORY in an APR array
  * allocated in RESULT_POOL with entries added in storage (on-disk) order.
  * FS' format will be used to pick the optimal ordering strategy.  Use
@@ -25,13 +25,16 @@
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
+#include "fs_fs.h"
 #include "index.h"
 #include "low_level.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "util.h"
 #include "cached_data.h"
+#include "verify.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -288,10 +291,12 @@ recover_find_max_ids(svn_fs_t *fs,
 
 /* Part of the recovery procedure.  Given an open non-packed revision file
    REV_FILE for REV, locate the trailer that specifies the offset to the root
-   node-id and store this offset in *ROOT_OFFSET.  Do temporary allocations in
-   POOL. */
+   node-id and store this offset in *ROOT_OFFSET.  If CHANGES_OFFSET is not
+   NULL, store the offset of the changed paths list in *CHANGES_OFFSET.  Do
+   temporary allocations in POOL. */
 static svn_error_t *
 recover_get_root_offset(apr_off_t *root_offset,
+                        apr_off_t *changes_offset,
                         svn_revnum_t rev,
                         svn_fs_fs__revision_file_t *rev_file,
                         apr_pool_t *pool)
@@ -326,7 +331,267 @@ recover_get_root_offset(apr_off_t *root_offset,
                                  NULL, NULL, pool));
 
   trailer = svn_stringbuf_ncreate(buffer, len, pool);
-  SVN_ERR(svn_fs_fs__parse_revision_trailer(root_offset, NULL, trailer, rev));
+  SVN_ERR(svn_fs_fs__parse_revision_trailer(root_offset, changes_offset,
+                                            trailer, rev));
+
+  return SVN_NO_ERROR;
+}
+
+/* Part of the recovery procedure.  Scan revisions START to END of FS
+   and raise *MAX_NODE_ID and *MAX_COPY_ID to the largest node-id and
+   copy-id found in them.  Call the optional CANCEL_FUNC with CANCEL_BATON
+   once per revision.  Perform temporary allocations in POOL. */
+static svn_error_t *
+find_max_ids_in_range(svn_fs_t *fs,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      apr_uint64_t *max_node_id,
+                      apr_uint64_t *max_copy_id,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (rev = start; rev <= end; rev++)
+    {
+      svn_fs_fs__revision_file_t *rev_file;
+      apr_off_t root_offset;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, iterpool,
+                                               iterpool));
+      SVN_ERR(recover_get_root_offset(&root_offset, NULL, rev, rev_file,
+                                      iterpool));
+      SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
+                                   max_node_id, max_copy_id, iterpool));
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of revisions scanned by a single task. */
+#define RECOVER_TASK_REVS 64
+
+/* A range of revisions being scanned concurrently with others. */
+typedef struct recover_task_t
+{
+  /* Instance of the filesystem being recovered that nobody else uses.
+     The tasks open their own instances from it because the FSFS caches
+     and file handles are not thread-safe. */
+  svn_fs_t *fs;
+
+  /* First and last revision to scan. */
+  svn_revnum_t start;
+  svn_revnum_t end;
+} recover_task_t;
+
+/* The largest IDs found by a recover_task_t, or in total. */
+typedef struct max_ids_t
+{
+  apr_uint64_t node_id;
+  apr_uint64_t copy_id;
+} max_ids_t;
+
+/* Implements svn_task__process_func_t.  Scan the revisions given by the
+   recover_task_t in PROCESS_BATON and return their largest IDs as a
+   max_ids_t in *RESULT. */
+static svn_error_t *
+recover_task(void **result,
+             void *process_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  recover_task_t *task = process_baton;
+  max_ids_t *max_ids = apr_pcalloc(result_pool, sizeof(*max_ids));
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&fs, task->fs, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(find_max_ids_in_range(fs, task->start, task->end,
+                                &max_ids->node_id, &max_ids->copy_id,
+                                cancel_func, cancel_baton, scratch_pool));
+
+  *result = max_ids;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Raise the max_ids_t in
+   OUTPUT_BATON to the max_ids_t in RESULT. */
+static svn_error_t *
+merge_max_ids(void *result,
+              void *output_baton,
+              apr_pool_t *scratch_pool)
+{
+  max_ids_t *task_ids = result;
+  max_ids_t *max_ids = output_baton;
+
+  if (task_ids->node_id > max_ids->node_id)
+    max_ids->node_id = task_ids->node_id;
+  if (task_ids->copy_id > max_ids->copy_id)
+    max_ids->copy_id = task_ids->copy_id;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like find_max_ids_in_range but scan up to JOBS revision files
+   concurrently. */
+static svn_error_t *
+find_max_ids_parallel(svn_fs_t *fs,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      apr_uint64_t *max_node_id,
+                      apr_uint64_t *max_copy_id,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      int jobs,
+                      apr_pool_t *pool)
+{
+  apr_pool_t *set_pool = svn_pool_create(pool);
+  svn_task__set_t *set;
+  svn_fs_t *snapshot;
+  max_ids_t max_ids;
+  svn_revnum_t rev;
+
+  max_ids.node_id = *max_node_id;
+  max_ids.copy_id = *max_copy_id;
+
+  /* Opening an instance accesses FS, so do it here in this thread. */
+  SVN_ERR(svn_fs_fs__open_instance(&snapshot, fs, pool, pool));
+
+  SVN_ERR(svn_task__set_create(&set, jobs, merge_max_ids, &max_ids,
+                               cancel_func, cancel_baton, set_pool));
+  for (rev = start; rev <= end; rev += RECOVER_TASK_REVS)
+    {
+      recover_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      task->fs = snapshot;
+      task->start = rev;
+      task->end = end - rev < RECOVER_TASK_REVS
+                ? end
+                : rev + RECOVER_TASK_REVS - 1;
+
+      SVN_ERR(svn_task__add(set, recover_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  *max_node_id = max_ids.node_id;
+  *max_copy_id = max_ids.copy_id;
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of youngest revisions checked by the quick recovery mode in
+   repositories that are not sharded. */
+#define QUICK_RECOVER_REVS 1000
+
+/* Implements svn_fs_fs__change_receiver_t.  Accept any change; the
+   caller only wants to know that the changed paths list parses. */
+static svn_error_t *
+skip_change(void *baton,
+            change_t *change,
+            apr_pool_t *scratch_pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Part of the quick recovery procedure.  Check that the root node of
+   the non-packed revision REV in FS is a directory node created in REV
+   and that the changed paths list of REV can be read.  Perform temporary
+   allocations in POOL. */
+static svn_error_t *
+quick_verify_revision(svn_fs_t *fs,
+                      svn_revnum_t rev,
+                      apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_off_t root_offset;
+  apr_off_t changes_offset;
+  node_revision_t *noderev;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool, pool));
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      SVN_ERR(svn_fs_fs__item_offset(&root_offset, fs, rev_file, rev, NULL,
+                                     SVN_FS_FS__ITEM_INDEX_ROOT_NODE, pool));
+      SVN_ERR(svn_fs_fs__item_offset(&changes_offset, fs, rev_file, rev,
+                                     NULL, SVN_FS_FS__ITEM_INDEX_CHANGES,
+                                     pool));
+    }
+  else
+    {
+      SVN_ERR(recover_get_root_offset(&root_offset, &changes_offset, rev,
+                                      rev_file, pool));
+    }
+
+  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &root_offset, pool));
+  SVN_ERR(svn_fs_fs__read_noderev(&noderev, rev_file->stream, pool, pool));
+  if (   noderev->kind != svn_node_dir
+      || svn_fs_fs__id_rev(noderev->id) != rev)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Revision %ld has no valid root node"), rev);
+
+  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &changes_offset, pool));
+  SVN_ERR(svn_fs_fs__read_changes_incrementally(rev_file->stream,
+                                                skip_change, NULL, pool));
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
+/* Part of the quick recovery procedure.  Check the non-packed revisions
+   of the youngest shard of FS up to MAX_REV, calling the optional
+   CANCEL_FUNC with CANCEL_BATON once per revision.  Perform temporary
+   allocations in POOL. */
+static svn_error_t *
+quick_verify_youngest_shard(svn_fs_t *fs,
+                            svn_revnum_t max_rev,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t shard_size = ffd->max_files_per_dir
+                          ? ffd->max_files_per_dir
+                          : QUICK_RECOVER_REVS;
+  svn_revnum_t start = max_rev - max_rev % shard_size;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  if (start < ffd->min_unpacked_rev)
+    start = ffd->min_unpacked_rev;
+  if (start > max_rev)
+    return SVN_NO_ERROR;
+
+  /* Check the indexes first such that we can rely on the item lookups
+     in quick_verify_revision(). */
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_ERR(svn_fs_fs__verify_indexes(fs, start, max_rev,
+                                      cancel_func, cancel_baton, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (rev = start; rev <= max_rev; rev++)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_error_quick_wrapf(quick_verify_revision(fs, rev, iterpool),
+                                    _("Quick verification of r%ld failed"),
+                                    rev));
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -401,6 +666,13 @@ recover_body(void *baton, apr_pool_t *pool)
                              _("Expected current rev to be <= %ld "
                                "but found %ld"), max_rev, youngest_rev);
 
+  /* In quick mode, make sure that the revisions we are about to publish
+     are readable before doing anything else. */
+  if (ffd->quick_recover)
+    SVN_ERR(quick_verify_youngest_shard(fs, max_rev,
+                                        b->cancel_func, b->cancel_baton,
+                                        pool));
+
   /* We only need to search for maximum IDs for old FS formats which
      se global ID counters. */
   if (ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
@@ -408,28 +680,36 @@ recover_body(void *baton, apr_pool_t *pool)
       /* Next we need to find the maximum node id and copy id in use across the
          filesystem.  Unfortunately, the only way we can get this information
          is to scan all the noderevs of all the revisions and keep track as
-         we go along. */
-      svn_revnum_t rev;
-      apr_pool_t *iterpool = svn_pool_create(pool);
+         we go along.  These formats have neither packs nor indexes, so
+         all we can do is to scan several revision files at once. */
+      svn_revnum_t start_rev = 0;
 
-      for (rev = 0; rev <= max_rev; rev++)
+      /* In quick mode, trust the counters recorded in 'current' for all
+         revisions up to the one that it names. */
+      if (ffd->quick_recover)
         {
-          svn_fs_fs__revision_file_t *rev_file;
-          apr_off_t root_offset;
-
-          svn_pool_clear(iterpool);
-
-          if (b->cancel_func)
-            SVN_ERR(b->cancel_func(b->cancel_baton));
-
-          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool,
-                                                   iterpool));
-          SVN_ERR(recover_get_root_offset(&root_offset, rev, rev_file, pool));
-          SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
-                                       &next_node_id, &next_copy_id, pool));
-          SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+          svn_revnum_t current_rev;
+          apr_uint64_t current_node_id, current_copy_id;
+
+          SVN_ERR(svn_fs_fs__read_current(&current_rev, &current_node_id,
+                                          &current_copy_id, fs, pool));
+          start_rev = current_rev + 1;
+          if (current_node_id)
+            next_node_id = current_node_id - 1;
+          if (current_copy_id)
+            next_copy_id = current_copy_id - 1;
         }
-      svn_pool_destroy(iterpool);
+
+      if (ffd->recover_jobs > 1 && max_rev - start_rev >= RECOVER_TASK_REVS)
+        SVN_ERR(find_max_ids_parallel(fs, start_rev, max_rev,
+                                      &next_node_id, &next_copy_id,
+                                      b->cancel_func, b->cancel_baton,
+                                      ffd->recover_jobs, pool));
+      else
+        SVN_ERR(find_max_ids_in_range(fs, start_rev, max_rev,
+                                      &next_node_id, &next_copy_id,
+                                      b->cancel_func, b->cancel_baton,
+                                      pool));
 
       /* Now that we finally have the maximum revision, node-id and copy-id, we
          can bump the two ids to get the next of each. */
@@ -43,6 +43,24 @@ WHERE hash = ?1
 INSERT OR FAIL INTO rep_cache (hash, revision, offset, size, expanded_size)
 VALUES (?1, ?2, ?3, ?4, ?5)
 
+/* Like STMT_SET_REP but silently skip existing entries and insert
+   multiple rows at once.  The number of rows must match
+   REP_CACHE_BATCH_ROWS in rep-cache.c. */
+-- STMT_SET_REPS_BATCH
+INSERT OR IGNORE INTO rep_cache (hash, revision, offset, size, expanded_size)
+VALUES (?1, ?2, ?3, ?4, ?5),
+       (?6, ?7, ?8, ?9, ?10),
+       (?11, ?12, ?13, ?14, ?15),
+       (?16, ?17, ?18, ?19, ?20),
+       (?21, ?22, ?23, ?24, ?25),
+       (?26, ?27, ?28, ?29, ?30),
+       (?31, ?32, ?33, ?34, ?35),
+       (?36, ?37, ?38, ?39, ?40)
+
+-- STMT_SET_REP_IF_NEW
+INSERT OR IGNORE INTO rep_cache (hash, revision, offset, size, expanded_size)
+VALUES (?1, ?2, ?3, ?4, ?5)
+
 -- STMT_GET_REPS_FOR_RANGE
 SELECT hash, revision, offset, size, expanded_size
 FROM rep_cache
@@ -52,6 +70,16 @@ WHERE revision >= ?1 AND revision <= ?2
 SELECT MAX(revision)
 FROM rep_cache
 
+-- STMT_GET_MAX_ROWID
+SELECT MAX(rowid)
+FROM rep_cache
+
+-- STMT_GET_HASHES_AFTER_ROWID
+SELECT rowid, hash
+FROM rep_cache
+WHERE rowid > ?1
+ORDER BY rowid
+
 -- STMT_DEL_REPS_YOUNGER_THAN_REV
 DELETE FROM rep_cache
 WHERE revision > ?1
@@ -27,12 +27,23 @@
 #include "cached_data.h"
 #include "fs_fs.h"
 #include "fs.h"
+#include "id.h"
+#include "index.h"
+#include "low_level.h"
 #include "rep-cache.h"
+#include "rev_file.h"
+#include "util.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_path.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
 
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_sqlite.h"
+#include "private/svn_task.h"
 
 #include "rep-cache-db.h"
 
@@ -51,6 +62,463 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+
+/** The rep-cache filter.
+ *
+ * Most rep-cache lookups during commits and loads are for new content
+ * and will not find anything.  To avoid hitting SQLite for those, we
+ * keep a Bloom filter over all SHA1 keys in the rep-cache, shared by
+ * all instances of the same repository within this process.  It gets
+ * built on first use, persisted next to rep-cache.db and brought up to
+ * date incrementally using SQLite's ROWIDs.  Entries added by other
+ * processes after our latest refresh may not be in the filter, which
+ * may cause a missed opportunity for rep-sharing but never affects
+ * correctness.
+ */
+
+/* Version number of the persisted filter file format. */
+#define FILTER_FORMAT 1
+
+/* Number of bits to set per key. */
+#define FILTER_PROBES 8
+
+/* Number of filter bits per entry at full capacity.  Together with
+   FILTER_PROBES, this gives a false positive rate of well below 0.1%. */
+#define FILTER_BITS_PER_ENTRY 16
+
+/* Minimum number of entries to size a new filter for. */
+#define FILTER_MIN_CAPACITY 0x10000
+
+/* Write the filter to disk after that many entries have been read from
+   the database since it was last written. */
+#define FILTER_SAVE_THRESHOLD 0x1000
+
+/* The filter data structure. */
+typedef struct rep_cache_filter_t
+{
+  /* The filter bits.  The array has a size that is a power of two. */
+  unsigned char *bits;
+
+  /* Number of bits in BITS minus one. */
+  apr_uint64_t mask;
+
+  /* Number of entries that can be added before the filter needs to be
+     rebuilt with a larger size. */
+  apr_int64_t capacity;
+
+  /* Number of entries added so far. */
+  apr_int64_t entries;
+
+  /* All rep-cache rows up to this ROWID have been added. */
+  apr_int64_t last_rowid;
+
+  /* Number of entries read from the database but not written to disk. */
+  apr_int64_t unsaved;
+
+  /* Youngest revision known when we last refreshed the filter. */
+  svn_revnum_t refreshed_rev;
+} rep_cache_filter_t;
+
+static APR_INLINE const char *
+path_rep_cache_filter(const char *fs_path,
+                      apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, REP_CACHE_FILTER_NAME, result_pool);
+}
+
+/* Return the value of the hex digit C or -1 if C is not a hex digit. */
+static int
+hex_digit_value(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+
+  return -1;
+}
+
+/* Set *H1 and *H2 to the first two 32 bit words of the SHA1 DIGEST. */
+static void
+digest_hashes(apr_uint32_t *h1,
+              apr_uint32_t *h2,
+              const unsigned char *digest)
+{
+  *h1 = ((apr_uint32_t)digest[0] << 24) | ((apr_uint32_t)digest[1] << 16)
+      | ((apr_uint32_t)digest[2] << 8) | digest[3];
+  *h2 = ((apr_uint32_t)digest[4] << 24) | ((apr_uint32_t)digest[5] << 16)
+      | ((apr_uint32_t)digest[6] << 8) | digest[7];
+}
+
+/* Set *H1 and *H2 like digest_hashes() does, but take the SHA1 digest
+   in its HEX representation as stored in the database.  Return FALSE if
+   HEX is not a valid SHA1 digest prefix. */
+static svn_boolean_t
+hex_hashes(apr_uint32_t *h1,
+           apr_uint32_t *h2,
+           const char *hex)
+{
+  unsigned char digest[8];
+  int i;
+
+  for (i = 0; i < 8; ++i)
+    {
+      int hi = hex_digit_value(hex[2 * i]);
+      int lo = hi < 0 ? -1 : hex_digit_value(hex[2 * i + 1]);
+      if (lo < 0)
+        return FALSE;
+
+      digest[i] = (unsigned char)((hi << 4) | lo);
+    }
+
+  digest_hashes(h1, h2, digest);
+  return TRUE;
+}
+
+/* Add the key given by its hashes H1 and H2 to FILTER. */
+static void
+filter_add(rep_cache_filter_t *filter,
+           apr_uint32_t h1,
+           apr_uint32_t h2)
+{
+  apr_uint64_t hash = h1;
+  int i;
+
+  /* Use double hashing to derive the bit positions. */
+  for (i = 0; i < FILTER_PROBES; ++i, hash += h2 | 1)
+    {
+      apr_uint64_t bit = hash & filter->mask;
+      filter->bits[bit / 8] |= (unsigned char)(1 << (bit % 8));
+    }
+
+  ++filter->entries;
+}
+
+/* Return TRUE if the key given by its hashes H1 and H2 may have been
+   added to FILTER and FALSE if it certainly has not been. */
+static svn_boolean_t
+filter_may_contain(const rep_cache_filter_t *filter,
+                   apr_uint32_t h1,
+                   apr_uint32_t h2)
+{
+  apr_uint64_t hash = h1;
+  int i;
+
+  for (i = 0; i < FILTER_PROBES; ++i, hash += h2 | 1)
+    {
+      apr_uint64_t bit = hash & filter->mask;
+      if ((filter->bits[bit / 8] & (1 << (bit % 8))) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Return a new, empty filter allocated in RESULT_POOL that can hold at
+   least CAPACITY entries. */
+static rep_cache_filter_t *
+filter_create(apr_int64_t capacity,
+              apr_pool_t *result_pool)
+{
+  rep_cache_filter_t *filter = apr_pcalloc(result_pool, sizeof(*filter));
+  apr_uint64_t bit_count = FILTER_MIN_CAPACITY * FILTER_BITS_PER_ENTRY;
+
+  while (bit_count < (apr_uint64_t)capacity * FILTER_BITS_PER_ENTRY)
+    bit_count *= 2;
+
+  filter->bits = apr_pcalloc(result_pool, (apr_size_t)(bit_count / 8));
+  filter->mask = bit_count - 1;
+  filter->capacity = bit_count / FILTER_BITS_PER_ENTRY;
+  filter->entries = 0;
+  filter->last_rowid = 0;
+  filter->unsaved = 0;
+  filter->refreshed_rev = SVN_INVALID_REVNUM;
+
+  return filter;
+}
+
+/* Write FILTER to its file in FS.  Use SCRATCH_POOL for temporaries.
+
+   The file is merely a cache, so the caller may ignore errors. */
+static svn_error_t *
+filter_save(rep_cache_filter_t *filter,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf;
+  apr_size_t bit_bytes = (apr_size_t)((filter->mask + 1) / 8);
+
+  buf = svn_stringbuf_createf(scratch_pool,
+                              "%d %" APR_UINT64_T_FMT " %" APR_INT64_T_FMT
+                              " %" APR_INT64_T_FMT "\n",
+                              FILTER_FORMAT, filter->mask + 1,
+                              filter->entries, filter->last_rowid);
+  svn_stringbuf_appendbytes(buf, (const char *)filter->bits, bit_bytes);
+
+  SVN_ERR(svn_io_write_atomic2(path_rep_cache_filter(fs->path,
+                                                     scratch_pool),
+                               buf->data, buf->len,
+                               path_rep_cache_db(fs->path, scratch_pool),
+                               FALSE, scratch_pool));
+  filter->unsaved = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the filter file of FS and return its contents in *FILTER_P,
+   allocated in RESULT_POOL.  Set *FILTER_P to NULL if there is no
+   usable filter file.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+filter_load(rep_cache_filter_t **filter_p,
+            svn_fs_t *fs,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  rep_cache_filter_t *filter;
+  const char *eol;
+  apr_array_header_t *header;
+  apr_int64_t values[4];
+  apr_int64_t format, bit_count, entries, last_rowid;
+  int i;
+  svn_error_t *err;
+
+  *filter_p = NULL;
+
+  err = svn_stringbuf_from_file2(&content,
+                                 path_rep_cache_filter(fs->path,
+                                                       scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Unknown formats or sizes that don't match the header are simply
+     ignored.  We will then rebuild the filter from scratch. */
+  eol = memchr(content->data, '\n', content->len);
+  if (!eol)
+    return SVN_NO_ERROR;
+
+  header = svn_cstring_split(apr_pstrmemdup(scratch_pool, content->data,
+                                            eol - content->data),
+                             " ", FALSE, scratch_pool);
+  if (header->nelts != 4)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < header->nelts; ++i)
+    {
+      err = svn_cstring_atoi64(&values[i],
+                               APR_ARRAY_IDX(header, i, const char *));
+      if (err)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  format = values[0];
+  bit_count = values[1];
+  entries = values[2];
+  last_rowid = values[3];
+
+  if (   format != FILTER_FORMAT
+      || bit_count < FILTER_MIN_CAPACITY * FILTER_BITS_PER_ENTRY
+      || (bit_count & (bit_count - 1)) != 0
+      || entries < 0
+      || last_rowid < 0
+      || content->data + content->len - (eol + 1) != bit_count / 8)
+    return SVN_NO_ERROR;
+
+  filter = filter_create(bit_count / FILTER_BITS_PER_ENTRY, result_pool);
+  SVN_ERR_ASSERT(filter->mask + 1 == bit_count);
+  memcpy(filter->bits, eol + 1, (apr_size_t)(bit_count / 8));
+  filter->entries = entries;
+  filter->last_rowid = last_rowid;
+
+  *filter_p = filter;
+  return SVN_NO_ERROR;
+}
+
+/* Add all rows from FS' rep-cache with a ROWID larger than FILTER's
+   LAST_ROWID to FILTER.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+filter_add_new_rows(rep_cache_filter_t *filter,
+                    svn_fs_t *fs,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_HASHES_AFTER_ROWID));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, filter->last_rowid));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      apr_uint32_t h1, h2;
+      const char *hex = svn_sqlite__column_text(stmt, 1, NULL);
+
+      if (hex && strlen(hex) >= 16 && hex_hashes(&h1, &h2, hex))
+        {
+          filter_add(filter, h1, h2);
+          ++filter->unsaved;
+        }
+
+      filter->last_rowid = svn_sqlite__column_int64(stmt, 0);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Make sure that the filter shared by all instances of FS exists and
+   is reasonably up to date.  The caller must hold the filter lock and
+   the rep-cache must already be open.  Use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+ensure_filter(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  rep_cache_filter_t *filter = ffsd->rep_cache_filter;
+
+  /* Up to date with respect to the latest revision we know of? */
+  if (filter && filter->refreshed_rev >= ffd->youngest_rev_cache)
+    return SVN_NO_ERROR;
+
+  /* Load or create the filter. */
+  if (!filter)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+      apr_int64_t max_rowid;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                        STMT_GET_MAX_ROWID));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      max_rowid = svn_sqlite__column_int64(stmt, 0);
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      svn_pool_clear(ffsd->rep_cache_filter_pool);
+      SVN_ERR(filter_load(&filter, fs, ffsd->rep_cache_filter_pool,
+                          scratch_pool));
+
+      /* A persisted filter that is ahead of the database does not belong
+         to it (rows got removed or the database has been replaced). */
+      if (filter && filter->last_rowid > max_rowid)
+        filter = NULL;
+
+      if (!filter)
+        filter = filter_create(MAX(FILTER_MIN_CAPACITY, 2 * max_rowid),
+                               ffsd->rep_cache_filter_pool);
+    }
+
+  filter->refreshed_rev = ffd->youngest_rev_cache;
+  SVN_ERR(filter_add_new_rows(filter, fs, scratch_pool));
+
+  /* Too full?  Start over with a larger one. */
+  if (filter->entries > filter->capacity)
+    {
+      svn_pool_clear(ffsd->rep_cache_filter_pool);
+      filter = filter_create(2 * filter->entries,
+                             ffsd->rep_cache_filter_pool);
+      filter->refreshed_rev = ffd->youngest_rev_cache;
+      SVN_ERR(filter_add_new_rows(filter, fs, scratch_pool));
+    }
+
+  /* Persist it every once in a while.  Users may not have write access
+     to the repository, so don't complain if that fails. */
+  if (filter->unsaved >= FILTER_SAVE_THRESHOLD)
+    svn_error_clear(filter_save(filter, fs, scratch_pool));
+
+  ffsd->rep_cache_filter = filter;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MAY_EXIST to FALSE if the rep-cache of FS certainly does not
+   contain an entry for the SHA1 DIGEST.  Use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+filter_lookup(svn_boolean_t *may_exist,
+              svn_fs_t *fs,
+              const unsigned char *digest,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint32_t h1, h2;
+  svn_error_t *err;
+
+  digest_hashes(&h1, &h2, digest);
+
+  SVN_ERR(svn_mutex__lock(ffd->shared->rep_cache_filter_lock));
+  err = ensure_filter(fs, scratch_pool);
+  if (err)
+    {
+      /* The filter must not be used if we could not bring it up to
+         date.  We will try again with the next lookup. */
+      ffd->shared->rep_cache_filter = NULL;
+      svn_error_clear(err);
+      *may_exist = TRUE;
+    }
+  else
+    {
+      *may_exist = filter_may_contain(ffd->shared->rep_cache_filter, h1, h2);
+    }
+
+  return svn_error_trace(
+           svn_mutex__unlock(ffd->shared->rep_cache_filter_lock,
+                             SVN_NO_ERROR));
+}
+
+/* Add the SHA1 DIGEST to the rep-cache filter of FS, if there is one. */
+static svn_error_t *
+filter_insert(svn_fs_t *fs,
+              const unsigned char *digest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint32_t h1, h2;
+
+  digest_hashes(&h1, &h2, digest);
+
+  SVN_ERR(svn_mutex__lock(ffd->shared->rep_cache_filter_lock));
+  if (ffd->shared->rep_cache_filter)
+    filter_add(ffd->shared->rep_cache_filter, h1, h2);
+
+  return svn_error_trace(
+           svn_mutex__unlock(ffd->shared->rep_cache_filter_lock,
+                             SVN_NO_ERROR));
+}
+
+/* Drop the rep-cache filter of FS after rows got removed from the
+   database.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+filter_reset(svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(svn_mutex__lock(ffd->shared->rep_cache_filter_lock));
+  ffd->shared->rep_cache_filter = NULL;
+  svn_pool_clear(ffd->shared->rep_cache_filter_pool);
+
+  return svn_error_trace(
+           svn_mutex__unlock(ffd->shared->rep_cache_filter_lock,
+                             svn_io_remove_file2(
+                               path_rep_cache_filter(fs->path,
+                                                     scratch_pool),
+                               TRUE, scratch_pool)));
+}
+
+
 
 /** Library-private API's. **/
 
@@ -95,10 +563,10 @@ open_rep_cache(void *baton,
       }
   }
 #endif
-  SVN_ERR(svn_sqlite__open(&sdb, db_path,
-                           svn_sqlite__mode_rwcreate, statements,
-                           0, NULL, 0,
-                           fs->pool, pool));
+  SVN_ERR(svn_sqlite__open2(&sdb, db_path,
+                            svn_sqlite__mode_rwcreate, statements,
+                            &ffd->sqlite_options,
+                            fs->pool, pool));
 
   SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
                         sdb);
@@ -268,6 +736,7 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t may_exist;
   representation_t *rep;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
@@ -280,6 +749,28 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* Entries of recent commits may not have been written to the
+     database, yet. */
+  if (ffd->deferred_reps)
+    {
+      rep = apr_hash_get(ffd->deferred_reps, checksum->digest,
+                         APR_SHA1_DIGESTSIZE);
+      if (rep)
+        {
+          *rep_p = svn_fs_fs__rep_copy(rep, pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Most lookups are for new content.  Skip the database query if we
+     can tell that there is no matching entry. */
+  SVN_ERR(filter_lookup(&may_exist, fs, checksum->digest, pool));
+  if (!may_exist)
+    {
+      *rep_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -328,6 +819,7 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_error_t *err;
+  svn_boolean_t constraint_failed;
   svn_checksum_t checksum;
   checksum.kind = svn_checksum_sha1;
   checksum.digest = rep->sha1_digest;
@@ -351,14 +843,18 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                             (apr_int64_t) rep->expanded_size));
 
   err = svn_sqlite__insert(NULL, stmt);
-  if (err)
-    {
-      representation_t *old_rep;
+  if (err && err->apr_err != SVN_ERR_SQLITE_CONSTRAINT)
+    return svn_error_trace(err);
 
-      if (err->apr_err != SVN_ERR_SQLITE_CONSTRAINT)
-        return svn_error_trace(err);
+  constraint_failed = (err != NULL);
+  svn_error_clear(err);
 
-      svn_error_clear(err);
+  /* Either way, the database has an entry for this checksum now. */
+  SVN_ERR(filter_insert(fs, rep->sha1_digest));
+
+  if (constraint_failed)
+    {
+      representation_t *old_rep;
 
       /* Constraint failed so the mapping for SHA1_CHECKSUM->REP
          should exist.  If so that's cool -- just do nothing.  If not,
@@ -377,6 +873,279 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
 }
 
 
+/* Number of rows inserted by a single STMT_SET_REPS_BATCH. */
+#define REP_CACHE_BATCH_ROWS 8
+
+/* Bind the columns of REP to the 5 parameters of STMT starting at SLOT.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+bind_rep(svn_sqlite__stmt_t *stmt,
+         int slot,
+         const representation_t *rep,
+         apr_pool_t *scratch_pool)
+{
+  svn_checksum_t checksum;
+  checksum.kind = svn_checksum_sha1;
+  checksum.digest = rep->sha1_digest;
+
+  SVN_ERR(svn_sqlite__bind_text(stmt, slot,
+                                svn_checksum_to_cstring(&checksum,
+                                                        scratch_pool)));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 1, rep->revision));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 2, rep->item_index));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 3, rep->size));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 4, rep->expanded_size));
+
+  return SVN_NO_ERROR;
+}
+
+/* The rep-cache of FS already contains an entry for the checksum of REP.
+   Return SVN_ERR_FS_CORRUPT if it does not match REP.  Use SCRATCH_POOL
+   for temporaries. */
+static svn_error_t *
+check_existing_rep(svn_fs_t *fs,
+                   const representation_t *rep,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_revnum_t revision = SVN_INVALID_REVNUM;
+  apr_uint64_t item_index = 0;
+  svn_filesize_t size = 0;
+  svn_checksum_t checksum;
+  checksum.kind = svn_checksum_sha1;
+  checksum.digest = rep->sha1_digest;
+
+  /* Deferred entries must not hide the database contents here, so
+     don't use svn_fs_fs__get_rep_reference(). */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s",
+                            svn_checksum_to_cstring(&checksum,
+                                                    scratch_pool)));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      revision = svn_sqlite__column_revnum(stmt, 0);
+      item_index = svn_sqlite__column_int64(stmt, 1);
+      size = svn_sqlite__column_int64(stmt, 2);
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (have_row
+      && (   revision != rep->revision
+          || item_index != rep->item_index
+          || size != rep->size))
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Representation key for checksum '%s' exists "
+                               "in filesystem '%s' with a different value "
+                               "(%ld,%" APR_UINT64_T_FMT ",%"
+                               SVN_FILESIZE_T_FMT ") than what we were "
+                               "about to store (%ld,%" APR_UINT64_T_FMT ",%"
+                               SVN_FILESIZE_T_FMT ")"),
+                             svn_checksum_to_cstring_display(&checksum,
+                                                             scratch_pool),
+                             fs->path, revision, item_index, size,
+                             rep->revision, rep->item_index, rep->size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Insert all REPS (representation_t *) into the rep-cache of FS.  Skip
+   existing entries but return SVN_ERR_FS_CORRUPT if they differ from the
+   ones in REPS.  The caller is responsible for wrapping this in an SQLite
+   transaction.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+insert_reps(svn_fs_t *fs,
+            const apr_array_header_t *reps,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int affected_rows;
+  int i, k;
+
+  /* Insert full batches using a single statement each. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_SET_REPS_BATCH));
+  for (i = 0; i + REP_CACHE_BATCH_ROWS <= reps->nelts;
+       i += REP_CACHE_BATCH_ROWS)
+    {
+      svn_pool_clear(iterpool);
+      for (k = 0; k < REP_CACHE_BATCH_ROWS; ++k)
+        SVN_ERR(bind_rep(stmt, 5 * k + 1,
+                         APR_ARRAY_IDX(reps, i + k, representation_t *),
+                         iterpool));
+
+      /* If some rows existed already, verify them.  That is rare, so
+         simply check all rows of the batch. */
+      SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+      if (affected_rows < REP_CACHE_BATCH_ROWS)
+        for (k = 0; k < REP_CACHE_BATCH_ROWS; ++k)
+          SVN_ERR(check_existing_rep(fs, APR_ARRAY_IDX(reps, i + k,
+                                                       representation_t *),
+                                     iterpool));
+    }
+
+  /* Insert the remainder row by row. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_SET_REP_IF_NEW));
+  for (; i < reps->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(bind_rep(stmt, 1,
+                       APR_ARRAY_IDX(reps, i, representation_t *),
+                       iterpool));
+      SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+      if (affected_rows == 0)
+        SVN_ERR(check_existing_rep(fs, APR_ARRAY_IDX(reps, i,
+                                                     representation_t *),
+                                   iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (reps->nelts == 0)
+    return SVN_NO_ERROR;
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* We only allow SHA1 checksums in this table. */
+  for (i = 0; i < reps->nelts; ++i)
+    if (! APR_ARRAY_IDX(reps, i, representation_t *)->has_sha1)
+      return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
+                              _("Only SHA1 checksums can be used as keys in "
+                                "the rep_cache table.\n"));
+
+  /* Use a single sqlite transaction to speed things up;
+     see <http://www.sqlite.org/faq.html#q19>. */
+  SVN_SQLITE__WITH_TXN(insert_reps(fs, reps, scratch_pool),
+                       ffd->rep_cache_db);
+
+  for (i = 0; i < reps->nelts; ++i)
+    SVN_ERR(filter_insert(fs, APR_ARRAY_IDX(reps, i,
+                                            representation_t *)->sha1_digest));
+
+  return SVN_NO_ERROR;
+}
+
+/* qsort()-style comparison function for representation_t * by their
+   SHA1 digest. */
+static int
+compare_rep_digests(const void *a,
+                    const void *b)
+{
+  const representation_t *lhs = *(const representation_t * const *)a;
+  const representation_t *rhs = *(const representation_t * const *)b;
+
+  return memcmp(lhs->sha1_digest, rhs->sha1_digest,
+                sizeof(lhs->sha1_digest));
+}
+
+/* Pool pre-cleanup handler that writes any deferred rep-cache entries
+   of the svn_fs_t given as DATA to the database.  Errors are ignored;
+   the rep-cache is allowed to lag behind. */
+static apr_status_t
+flush_deferred_reps(void *data)
+{
+  svn_fs_t *fs = data;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *scratch_pool = svn_pool_create(NULL);
+
+  if (ffd->deferred_reps)
+    svn_error_clear(svn_fs_fs__flush_rep_references(fs, scratch_pool));
+
+  svn_pool_destroy(scratch_pool);
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_fs_fs__defer_rep_references(svn_fs_t *fs,
+                                const apr_array_header_t *reps,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  if (ffd->rep_cache_batch_revs <= 1)
+    return svn_error_trace(svn_fs_fs__set_rep_references(fs, reps,
+                                                         scratch_pool));
+
+  /* Remember the entries until we have collected enough revisions. */
+  if (! ffd->deferred_reps)
+    {
+      if (! ffd->deferred_reps_pool)
+        {
+          ffd->deferred_reps_pool = svn_pool_create(fs->pool);
+          apr_pool_pre_cleanup_register(fs->pool, fs, flush_deferred_reps);
+        }
+
+      ffd->deferred_reps = apr_hash_make(ffd->deferred_reps_pool);
+      ffd->deferred_revs = 0;
+    }
+
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      representation_t *rep
+        = svn_fs_fs__rep_copy(APR_ARRAY_IDX(reps, i, representation_t *),
+                              ffd->deferred_reps_pool);
+      apr_hash_set(ffd->deferred_reps, rep->sha1_digest,
+                   sizeof(rep->sha1_digest), rep);
+    }
+
+  if (++ffd->deferred_revs >= ffd->rep_cache_batch_revs)
+    SVN_ERR(svn_fs_fs__flush_rep_references(fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *reps;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  if (! ffd->deferred_reps)
+    return SVN_NO_ERROR;
+
+  reps = apr_array_make(scratch_pool, apr_hash_count(ffd->deferred_reps),
+                        sizeof(representation_t *));
+  for (hi = apr_hash_first(scratch_pool, ffd->deferred_reps);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(reps, representation_t *) = apr_hash_this_val(hi);
+
+  /* Inserting in key order gives better locality in the database. */
+  svn_sort__array(reps, compare_rep_digests);
+
+  err = svn_fs_fs__set_rep_references(fs, reps, scratch_pool);
+
+  /* The rep-cache may lag behind, so don't try again if that failed. */
+  ffd->deferred_reps = NULL;
+  ffd->deferred_revs = 0;
+  svn_pool_clear(ffd->deferred_reps_pool);
+
+  return svn_error_trace(err);
+}
+
+
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
                              svn_revnum_t youngest,
@@ -394,6 +1163,492 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
   SVN_ERR(svn_sqlite__step_done(stmt));
 
+  /* New rows may reuse the ROWIDs of the ones we just removed. */
+  SVN_ERR(filter_reset(fs, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append copies of the file contents and property representations that
+   were created in revision REV of FS to REPS, for the node ID and, if
+   that is a directory, all nodes below it.  Nodes not created in REV
+   don't contain any such representation.  If not NULL, call CANCEL_FUNC
+   with CANCEL_BATON for each node.  Allocate the copies in RESULT_POOL
+   and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+collect_node_reps(apr_array_header_t *reps,
+                  svn_fs_t *fs,
+                  const svn_fs_id_t *id,
+                  svn_revnum_t rev,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  if (svn_fs_fs__id_rev(id) != rev)
+    return SVN_NO_ERROR;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, scratch_pool,
+                                       scratch_pool));
+
+  /* Select the same reps as a commit would. */
+  if (   noderev->data_rep && noderev->kind == svn_node_file
+      && noderev->data_rep->revision == rev && noderev->data_rep->has_sha1)
+    APR_ARRAY_PUSH(reps, representation_t *)
+      = svn_fs_fs__rep_copy(noderev->data_rep, result_pool);
+
+  if (   noderev->prop_rep && noderev->prop_rep->revision == rev
+      && noderev->prop_rep->has_sha1)
+    APR_ARRAY_PUSH(reps, representation_t *)
+      = svn_fs_fs__rep_copy(noderev->prop_rep, result_pool);
+
+  if (noderev->kind == svn_node_dir)
+    {
+      apr_array_header_t *entries;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev,
+                                          scratch_pool, scratch_pool));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          const svn_fs_dirent_t *dirent
+            = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(collect_node_reps(reps, fs, dirent->id, rev,
+                                    cancel_func, cancel_baton,
+                                    result_pool, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of revisions per task in build_rep_cache_log() for repositories
+   that are not sharded. */
+#define REVISIONS_PER_SCAN 1000
+
+/* The svn_fs_t instances used to scan rev / pack files in
+   build_rep_cache_log().  Each instance is used by one task at a time. */
+typedef struct scan_instances_t
+{
+  svn_mutex__t *mutex;
+
+  /* The svn_fs_t * not currently in use. */
+  apr_array_header_t *idle;
+} scan_instances_t;
+
+/* Baton for scan_reps().  The revisions START_REV to END_REV share the
+   same shard. */
+typedef struct scan_baton_t
+{
+  scan_instances_t *instances;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+} scan_baton_t;
+
+/* Result of scan_reps(). */
+typedef struct scanned_reps_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* The representation_t * to add to the rep-cache. */
+  apr_array_header_t *reps;
+} scanned_reps_t;
+
+/* Baton for store_reps(). */
+typedef struct store_baton_t
+{
+  svn_fs_t *fs;
+  svn_fs_progress_notify_func_t notify_func;
+  void *notify_baton;
+} store_baton_t;
+
+/* Pool cleanup function destroying the pool in DATA. */
+static apr_status_t
+destroy_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Take an idle instance from INSTANCES and return it in *FS. */
+static svn_error_t *
+take_instance(svn_fs_t **fs,
+              scan_instances_t *instances)
+{
+  svn_fs_t *idle = NULL;
+
+  SVN_ERR(svn_mutex__lock(instances->mutex));
+  if (instances->idle->nelts > 0)
+    idle = APR_ARRAY_IDX(instances->idle, --instances->idle->nelts,
+                         svn_fs_t *);
+  SVN_ERR(svn_mutex__unlock(instances->mutex, SVN_NO_ERROR));
+
+  /* There is one instance per thread that may be scanning. */
+  SVN_ERR_ASSERT(idle != NULL);
+
+  *fs = idle;
+  return SVN_NO_ERROR;
+}
+
+/* Return FS to the idle ones in INSTANCES and return ERR. */
+static svn_error_t *
+release_instance(scan_instances_t *instances,
+                 svn_fs_t *fs,
+                 svn_error_t *err)
+{
+  svn_error_t *lock_err = svn_mutex__lock(instances->mutex);
+  if (lock_err)
+    return svn_error_compose_create(err, lock_err);
+
+  APR_ARRAY_PUSH(instances->idle, svn_fs_t *) = fs;
+
+  return svn_error_trace(svn_mutex__unlock(instances->mutex, err));
+}
+
+/* Use the P2L index of the rev / pack file containing REVISION in FS to
+   find all noderevs of revisions START_REV to END_REV in that file.
+   Append copies of the representations that collect_node_reps() would
+   select for them to REPS.  If not NULL, call CANCEL_FUNC with
+   CANCEL_BATON for each index page.  Allocate the copies in RESULT_POOL
+   and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+scan_rev_or_pack_file(apr_array_header_t *reps,
+                      svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      svn_revnum_t start_rev,
+                      svn_revnum_t end_rev,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_off_t max_offset;
+  apr_off_t offset;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, revision,
+                                           scratch_pool, iterpool));
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, rev_file,
+                                        revision, scratch_pool));
+
+  for (offset = 0; offset < max_offset; )
+    {
+      apr_array_header_t *entries;
+      int i;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, rev_file, revision,
+                                          offset, ffd->p2l_page_size,
+                                          iterpool, iterpool));
+
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+          svn_revnum_t rev = entry->item.revision;
+          svn_stringbuf_t *item;
+          node_revision_t *noderev;
+
+          /* The first entry may start in the previous page. */
+          if (i == 0 && entry->offset < offset)
+            continue;
+
+          offset += entry->size;
+          if (   entry->type != SVN_FS_FS__ITEM_TYPE_NODEREV
+              || entry->size == 0 || rev < start_rev || rev > end_rev)
+            continue;
+
+          item = svn_stringbuf_create_ensure(entry->size, iterpool);
+          item->len = entry->size;
+          item->data[item->len] = 0;
+          SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
+                                           rev_file->block_size, NULL,
+                                           entry->offset, iterpool));
+          SVN_ERR(svn_io_file_read_full2(rev_file->file, item->data,
+                                         item->len, NULL, NULL, iterpool));
+          SVN_ERR(svn_fs_fs__read_noderev(&noderev,
+                                          svn_stream_from_stringbuf(item,
+                                                                    iterpool),
+                                          iterpool, iterpool));
+
+          if (   noderev->data_rep && noderev->kind == svn_node_file
+              && noderev->data_rep->revision == rev
+              && noderev->data_rep->has_sha1)
+            APR_ARRAY_PUSH(reps, representation_t *)
+              = svn_fs_fs__rep_copy(noderev->data_rep, result_pool);
+
+          if (   noderev->prop_rep && noderev->prop_rep->revision == rev
+              && noderev->prop_rep->has_sha1)
+            APR_ARRAY_PUSH(reps, representation_t *)
+              = svn_fs_fs__rep_copy(noderev->prop_rep, result_pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Collect the representations of
+   the revisions given by the scan_baton_t in BATON and return them as
+   scanned_reps_t.  This may run in any thread. */
+static svn_error_t *
+scan_reps(void **result,
+          void *baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  scan_baton_t *scan = baton;
+  scanned_reps_t *scanned = apr_pcalloc(result_pool, sizeof(*scanned));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+
+  scanned->start_rev = scan->start_rev;
+  scanned->end_rev = scan->end_rev;
+  scanned->reps = apr_array_make(result_pool, 16,
+                                 sizeof(representation_t *));
+
+  /* A pack file gets scanned once, rev files one by one. */
+  SVN_ERR(take_instance(&fs, scan->instances));
+  for (rev = scan->start_rev; rev <= scan->end_rev && !err; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      err = scan_rev_or_pack_file(scanned->reps, fs, rev, scan->start_rev,
+                                  scan->end_rev, cancel_func, cancel_baton,
+                                  result_pool, iterpool);
+      if (svn_fs_fs__is_packed_rev(fs, rev))
+        break;
+    }
+  SVN_ERR(release_instance(scan->instances, fs, err));
+
+  svn_pool_destroy(iterpool);
+
+  *result = scanned;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Add the scanned_reps_t in RESULT
+   to the rep-cache of the store_baton_t in BATON, using a single SQLite
+   transaction, and notify about the revisions covered. */
+static svn_error_t *
+store_reps(void *result,
+           void *baton,
+           apr_pool_t *scratch_pool)
+{
+  scanned_reps_t *scanned = result;
+  store_baton_t *sb = baton;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_fs_fs__set_rep_references(sb->fs, scanned->reps,
+                                        scratch_pool));
+
+  if (sb->notify_func)
+    for (rev = scanned->start_rev; rev <= scanned->end_rev; ++rev)
+      sb->notify_func(rev, sb->notify_baton, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__build_rep_cache() for FS in logical addressing
+   mode.  Instead of walking the trees, scan the P2L indexes for noderevs,
+   one shard at a time.  If JOBS > 1, scan up to JOBS shards concurrently.
+   The rep-cache gets updated and notifications get sent in revision
+   order and from the calling thread only.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+build_rep_cache_log(svn_fs_t *fs,
+                    svn_revnum_t start_rev,
+                    svn_revnum_t end_rev,
+                    int jobs,
+                    svn_fs_progress_notify_func_t notify_func,
+                    void *notify_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  scan_instances_t *instances = apr_pcalloc(scratch_pool,
+                                            sizeof(*instances));
+  store_baton_t *sb = apr_pcalloc(scratch_pool, sizeof(*sb));
+  svn_task__set_t *set = NULL;
+  apr_pool_t *set_pool = NULL;
+  apr_pool_t *iterpool;
+  int shard_size = ffd->max_files_per_dir ? ffd->max_files_per_dir
+                                          : REVISIONS_PER_SCAN;
+  svn_revnum_t rev;
+  int i;
+
+  sb->fs = fs;
+  sb->notify_func = notify_func;
+  sb->notify_baton = notify_baton;
+
+  SVN_ERR(svn_mutex__init(&instances->mutex, jobs > 1, scratch_pool));
+  instances->idle = apr_array_make(scratch_pool, jobs + 1,
+                                   sizeof(svn_fs_t *));
+
+  if (jobs > 1)
+    {
+      /* While waiting for results, this thread helps with the scanning.
+       * Hence the extra instance.
+       *
+       * Opening an instance accesses FS, so do it here in this thread.
+       * The instances may be used by any thread, so they must not share
+       * a (non thread-safe) allocator with SCRATCH_POOL. */
+      for (i = 0; i <= jobs; i++)
+        {
+          apr_pool_t *instance_pool = svn_pool_create(NULL);
+          svn_fs_t *instance;
+
+          apr_pool_cleanup_register(scratch_pool, instance_pool,
+                                    destroy_pool, apr_pool_cleanup_null);
+          SVN_ERR(svn_fs_fs__open_instance(&instance, fs, instance_pool,
+                                           scratch_pool));
+          APR_ARRAY_PUSH(instances->idle, svn_fs_t *) = instance;
+        }
+
+      /* Sub-pools get destroyed before the cleanups above run.  So, upon
+       * error, the task set will be done with all instances before they
+       * go. */
+      set_pool = svn_pool_create(scratch_pool);
+      SVN_ERR(svn_task__set_create(&set, jobs, store_reps, sb,
+                                   cancel_func, cancel_baton, set_pool));
+    }
+  else
+    {
+      APR_ARRAY_PUSH(instances->idle, svn_fs_t *) = fs;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start_rev; rev <= end_rev; )
+    {
+      scan_baton_t *scan;
+
+      svn_pool_clear(iterpool);
+
+      /* One task per shard. */
+      scan = apr_pcalloc(set ? scratch_pool : iterpool, sizeof(*scan));
+      scan->instances = instances;
+      scan->start_rev = rev;
+      scan->end_rev = (rev / shard_size + 1) * shard_size - 1;
+      if (scan->end_rev > end_rev)
+        scan->end_rev = end_rev;
+      rev = scan->end_rev + 1;
+
+      if (set)
+        {
+          SVN_ERR(svn_task__add(set, scan_reps, scan));
+        }
+      else
+        {
+          void *scanned;
+
+          SVN_ERR(scan_reps(&scanned, scan, cancel_func, cancel_baton,
+                            iterpool, iterpool));
+          SVN_ERR(store_reps(scanned, sb, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (set)
+    {
+      SVN_ERR(svn_task__set_finish(set));
+      svn_pool_destroy(set_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__build_rep_cache(svn_fs_t *fs,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_fs_progress_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("FSFS format (%d) too old for rep-sharing; "
+                               "please upgrade the filesystem."),
+                             ffd->format);
+
+  if (! ffd->rep_sharing_allowed)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Filesystem does not allow rep-sharing."));
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  if (end_rev > youngest)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("No such revision %ld"), end_rev);
+  if (start_rev > end_rev || start_rev < 0)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("Invalid revision range %ld:%ld"),
+                             start_rev, end_rev);
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    return svn_error_trace(build_rep_cache_log(fs, start_rev, end_rev,
+                                               ffd->build_rep_cache_jobs,
+                                               notify_func, notify_baton,
+                                               cancel_func, cancel_baton,
+                                               scratch_pool));
+
+  /* Without P2L index, we need to walk the trees.
+     One SQLite transaction per revision keeps the database lock short
+     enough for concurrent commits to proceed. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      apr_array_header_t *reps;
+      svn_fs_id_t *root_id;
+
+      svn_pool_clear(iterpool);
+
+      reps = apr_array_make(iterpool, 16, sizeof(representation_t *));
+      SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, iterpool,
+                                      iterpool));
+      SVN_ERR(collect_node_reps(reps, fs, root_id, rev,
+                                cancel_func, cancel_baton,
+                                iterpool, iterpool));
+      SVN_ERR(svn_fs_fs__set_rep_references(fs, reps, iterpool));
+
+      if (notify_func)
+        notify_func(rev, notify_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
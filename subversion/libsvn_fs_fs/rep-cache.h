@@ -33,6 +33,7 @@ extern "C" {
 
 
 #define REP_CACHE_DB_NAME        "rep-cache.db"
+#define REP_CACHE_FILTER_NAME    "rep-cache.filter"
 
 /* Open and create, if needed, the rep cache database associated with FS.
    Use POOL for temporary allocations. */
@@ -83,6 +84,61 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Add all REPS (an array of representation_t *) to the rep-cache of FS
+   using a single SQLite transaction.  Entries that already exist will be
+   left untouched.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
+/* Add all REPS (an array of representation_t *) of a newly committed
+   revision to the rep-cache of FS.  If FS has been configured to batch
+   rep-cache updates for multiple revisions, the entries may only be
+   collected in memory and will be written to the database together with
+   those of later revisions.  Use SCRATCH_POOL for temporary allocations.
+
+   Entries not written to the database will be lost if the process gets
+   terminated before the FS pool has been cleaned up.  This is fine as
+   the rep-cache is allowed to lag behind the repository. */
+svn_error_t *
+svn_fs_fs__defer_rep_references(svn_fs_t *fs,
+                                const apr_array_header_t *reps,
+                                apr_pool_t *scratch_pool);
+
+/* Write all rep-cache entries collected by
+   svn_fs_fs__defer_rep_references() for FS to the database.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool);
+
+/* Add the file contents and property representations created in
+   revisions START_REV to END_REV in FS to the rep-cache of FS, unless
+   it already contains them.  Later commits may then share these
+   representations, e.g. after the rep-cache has been lost or if the
+   repository has been created with rep-sharing disabled.
+
+   In logical addressing mode, the noderevs get found through the P2L
+   index and up to #SVN_FS_CONFIG_FSFS_BUILD_REP_CACHE_JOBS shards get
+   scanned concurrently.  The database is updated in one transaction per
+   shard.
+
+   After processing a revision, call NOTIFY_FUNC with NOTIFY_BATON, if
+   not NULL.  If not NULL, call CANCEL_FUNC with CANCEL_BATON from time
+   to time.  Use SCRATCH_POOL for temporary allocations.
+
+   This implements svn_fs_build_rep_cache(). */
+svn_error_t *
+svn_fs_fs__build_rep_cache(svn_fs_t *fs,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_fs_progress_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
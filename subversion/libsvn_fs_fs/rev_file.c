@@ -23,12 +23,16 @@
 #include "rev_file.h"
 #include "fs_fs.h"
 #include "index.h"
+#include "io_stats.h"
 #include "low_level.h"
 #include "util.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_cache_config.h"
+#include "svn_pools.h"
 #include "private/svn_io_private.h"
+#include "private/svn_sorts_private.h"
 #include "svn_private_config.h"
 
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
@@ -46,6 +50,10 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
 
   file->file = NULL;
   file->stream = NULL;
+  file->mmap = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->pooled_handle = NULL;
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
   file->block_size = ffd->block_size;
@@ -54,6 +62,8 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+  file->fs = fs;
+  file->trace_handle = 0;
   file->pool = pool;
 }
 
@@ -120,6 +130,249 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* If enabled for FS, map the whole contents of the already open FILE into
+ * memory, allocated in RESULT_POOL.  This is an optimization only; if the
+ * platform or the OS won't let us, simply continue to use FILE->FILE.
+ * SCRATCH_POOL is for temporary allocations. */
+static svn_error_t *
+auto_map_file(svn_fs_fs__revision_file_t *file,
+              svn_fs_t *fs,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  /* On 32 bit hosts, pack files could easily exhaust the address space. */
+#if APR_HAS_MMAP && APR_SIZEOF_VOIDP >= 8
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_filesize_t size;
+  apr_mmap_t *mapping;
+
+  if (!ffd->enable_mmap)
+    return SVN_NO_ERROR;
+
+  /* Rev and pack files are immutable, i.e. their size won't change. */
+  SVN_ERR(svn_io_file_size_get(&size, file->file, scratch_pool));
+  if (size <= 0 || size > APR_SIZE_MAX)
+    return SVN_NO_ERROR;
+
+  if (apr_mmap_create(&mapping, file->file, 0, (apr_size_t)size,
+                      APR_MMAP_READ, result_pool) == APR_SUCCESS)
+    {
+      file->mmap = mapping;
+      file->mapped_data = mapping->mm;
+      file->mapped_size = (apr_off_t)size;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Process-wide list of idle, read-only pack file handles.
+ *
+ * Opening a pack file means open(), fstat() and a new APR file buffer.
+ * Short-lived requests, e.g. in a threaded server, pay that price over and
+ * over again for the same few pack files.  Since pack files are immutable,
+ * we keep their handles around after use and give them to the next reader
+ * of the same file - from this or any other svn_fs_t instance.
+ *
+ * A handle is owned exclusively by one revision file object at a time,
+ * i.e. readers never interfere with each other's file pointer or buffer.
+ * Concurrent readers of the same pack file simply get separate handles.
+ *
+ * At most svn_cache_config_t.file_handle_count idle handles are being
+ * kept open, the least recently used ones getting closed first.
+ */
+struct svn_fs_fs__pooled_handle_t
+{
+  /* Next, less recently used idle handle.  NULL for the last idle handle
+   * and for handles currently in use. */
+  svn_fs_fs__pooled_handle_t *next;
+
+  /* Identifies the pack file: repository UUID, instance ID and the
+   * absolute path of the file. */
+  const char *key;
+
+  /* The open file, allocated in POOL. */
+  apr_file_t *file;
+
+  /* Root pool owned by this handle. */
+  apr_pool_t *pool;
+};
+
+/* Idle handles, most recently used first, and their number.  All access
+ * is serialized by IDLE_HANDLES_LOCK. */
+static svn_fs_fs__pooled_handle_t *idle_handles = NULL;
+static apr_size_t idle_handle_count = 0;
+static svn_mutex__t *idle_handles_lock = NULL;
+static volatile svn_atomic_t idle_handles_initialized = FALSE;
+
+/* Implements svn_atomic__init_once().init_func. */
+static svn_error_t *
+init_idle_handles(void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  /* The lock must outlive all svn_fs_t instances. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&idle_handles_lock, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if we should use a pooled handle to open REV in FS.
+ * WRITABLE is the requested access mode. */
+static svn_boolean_t
+use_pooled_handle(svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_boolean_t writable)
+{
+  /* Open files cannot be deleted on Windows, i.e. we would get into the
+   * way of removing or replacing repositories. */
+#ifdef WIN32
+  return FALSE;
+#else
+  return !writable
+      && svn_fs_fs__is_packed_rev(fs, rev)
+      && svn_cache_config_get()->file_handle_count > 0;
+#endif
+}
+
+/* Remove the most recently used idle handle for KEY from the list and
+ * return it in *HANDLE.  Set it to NULL if there is no such handle.
+ * The caller must hold IDLE_HANDLES_LOCK. */
+static svn_error_t *
+take_idle_handle(svn_fs_fs__pooled_handle_t **handle,
+                 const char *key)
+{
+  svn_fs_fs__pooled_handle_t **link;
+
+  for (link = &idle_handles; *link; link = &(*link)->next)
+    if (strcmp((*link)->key, key) == 0)
+      {
+        *handle = *link;
+        *link = (*handle)->next;
+        (*handle)->next = NULL;
+        --idle_handle_count;
+
+        return SVN_NO_ERROR;
+      }
+
+  *handle = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Prepend HANDLE to the list of idle handles.  If that exceeds the limit,
+ * remove the least recently used handle from the list and return it in
+ * *EVICTED.  Otherwise, set it to NULL.  The caller must hold
+ * IDLE_HANDLES_LOCK. */
+static svn_error_t *
+add_idle_handle(svn_fs_fs__pooled_handle_t **evicted,
+                svn_fs_fs__pooled_handle_t *handle)
+{
+  handle->next = idle_handles;
+  idle_handles = handle;
+  ++idle_handle_count;
+
+  *evicted = NULL;
+  if (idle_handle_count > svn_cache_config_get()->file_handle_count)
+    {
+      svn_fs_fs__pooled_handle_t **link = &idle_handles;
+      while ((*link)->next)
+        link = &(*link)->next;
+
+      *evicted = *link;
+      *link = NULL;
+      --idle_handle_count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* APR pool cleanup callback returning the svn_fs_fs__pooled_handle_t in
+ * BATON to the list of idle handles. */
+static apr_status_t
+release_pooled_handle(void *baton)
+{
+  svn_fs_fs__pooled_handle_t *handle = baton;
+  svn_fs_fs__pooled_handle_t *evicted = NULL;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(idle_handles_lock);
+  if (err)
+    {
+      /* Simply close the file then. */
+      svn_error_clear(err);
+      svn_pool_destroy(handle->pool);
+
+      return APR_SUCCESS;
+    }
+
+  err = svn_mutex__unlock(idle_handles_lock,
+                          add_idle_handle(&evicted, handle));
+  svn_error_clear(err);
+
+  /* Close the file outside the lock. */
+  if (evicted)
+    svn_pool_destroy(evicted->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *HANDLE to a read-only handle for the pack file at PATH in FS.
+ * Re-use an idle handle, if available, and open a new one otherwise.
+ * The handle will be returned to the list of idle handles when
+ * RESULT_POOL gets cleaned up.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+acquire_pooled_handle(svn_fs_fs__pooled_handle_t **handle,
+                      svn_fs_t *fs,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__pooled_handle_t *result;
+  const char *key = apr_pstrcat(scratch_pool, fs->uuid, ":",
+                                ffd->instance_id, ":", path, SVN_VA_NULL);
+
+  SVN_ERR(svn_atomic__init_once(&idle_handles_initialized,
+                                init_idle_handles, NULL, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(idle_handles_lock, take_idle_handle(&result, key));
+
+  if (result)
+    {
+      /* Make it look like a freshly opened file. */
+      apr_off_t offset = 0;
+      svn_error_t *err = svn_io_file_seek(result->file, APR_SET, &offset,
+                                          scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(result->pool);
+          return svn_error_trace(err);
+        }
+    }
+  else
+    {
+      apr_pool_t *pool = svn_pool_create(NULL);
+      svn_error_t *err;
+
+      result = apr_pcalloc(pool, sizeof(*result));
+      result->key = apr_pstrdup(pool, key);
+      result->pool = pool;
+
+      err = svn_io_file_open(&result->file, path, APR_READ | APR_BUFFERED,
+                             APR_OS_DEFAULT, pool);
+      if (err)
+        {
+          svn_pool_destroy(pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  apr_pool_cleanup_register(result_pool, result, release_pooled_handle,
+                            apr_pool_cleanup_null);
+  *handle = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -149,9 +402,18 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                      : SVN_NO_ERROR;
 
       /* open the revision file in buffered r/o or r/w mode */
-      if (!err)
-        err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
-                               result_pool);
+      if (!err && use_pooled_handle(fs, rev, writable))
+        {
+          err = acquire_pooled_handle(&file->pooled_handle, fs, path,
+                                      result_pool, scratch_pool);
+          if (!err)
+            apr_file = file->pooled_handle->file;
+        }
+      else if (!err)
+        {
+          err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
+                                 result_pool);
+        }
 
       if (!err)
         {
@@ -159,6 +421,11 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
           file->stream = svn_stream_from_aprfile2(apr_file, TRUE,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
+          svn_fs_fs__io_stats_open(file, path);
+
+          /* Mapped data must not change, hence read-only access only. */
+          if (!writable)
+            SVN_ERR(auto_map_file(file, fs, result_pool, scratch_pool));
 
           return SVN_NO_ERROR;
         }
@@ -245,6 +512,7 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
       SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
                                      sizeof(footer_length), NULL, NULL,
                                      file->pool));
+      svn_fs_fs__io_stats_read(file, filesize - 1, sizeof(footer_length));
 
       /* Read footer. */
       footer = svn_stringbuf_create_ensure(footer_length, file->pool);
@@ -254,6 +522,8 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
       SVN_ERR(svn_io_file_read_full2(file->file, footer->data, footer_length,
                                      &footer->len, NULL, file->pool));
       footer->data[footer->len] = '\0';
+      svn_fs_fs__io_stats_read(file, filesize - 1 - footer_length,
+                               footer->len);
 
       /* Extract index locations. */
       SVN_ERR(svn_fs_fs__parse_footer(&file->l2p_offset, &file->l2p_checksum,
@@ -290,16 +560,151 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__rev_file_mapped_data(svn_fs_fs__revision_file_t *file,
+                                apr_off_t offset,
+                                apr_off_t len)
+{
+  if (   file->mapped_data == NULL
+      || offset < 0
+      || len < 0
+      || offset > file->mapped_size
+      || len > file->mapped_size - offset)
+    return NULL;
+
+  svn_fs_fs__io_stats_read(file, offset, (apr_size_t)len);
+  return file->mapped_data + offset;
+}
+
+/* Implements svn_sort__array comparison for svn_fs_fs__read_request_t
+ * pointers, ordering them by file offset.
+ */
+static int
+compare_request_offsets(const void *lhs,
+                        const void *rhs)
+{
+  const svn_fs_fs__read_request_t *lhs_request
+    = *(const svn_fs_fs__read_request_t * const *)lhs;
+  const svn_fs_fs__read_request_t *rhs_request
+    = *(const svn_fs_fs__read_request_t * const *)rhs;
+
+  if (lhs_request->offset < rhs_request->offset)
+    return -1;
+
+  return lhs_request->offset == rhs_request->offset ? 0 : 1;
+}
+
+svn_error_t *
+svn_fs_fs__rev_file_read_many(svn_fs_fs__revision_file_t *file,
+                              apr_array_header_t *requests,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *pending
+    = apr_array_make(scratch_pool, requests->nelts,
+                     sizeof(svn_fs_fs__read_request_t *));
+  apr_pool_t *iterpool;
+  int i, k;
+
+  /* Serve requests from memory whenever we can. */
+  for (i = 0; i < requests->nelts; ++i)
+    {
+      svn_fs_fs__read_request_t *request
+        = &APR_ARRAY_IDX(requests, i, svn_fs_fs__read_request_t);
+
+      request->data = svn_fs_fs__rev_file_mapped_data(file, request->offset,
+                                                      request->size);
+      if (request->data == NULL)
+        APR_ARRAY_PUSH(pending, svn_fs_fs__read_request_t *) = request;
+    }
+
+  if (pending->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Submit all reads at once, letting the OS fetch them in parallel. */
+  for (i = 0; i < pending->nelts; ++i)
+    {
+      svn_fs_fs__read_request_t *request
+        = APR_ARRAY_IDX(pending, i, svn_fs_fs__read_request_t *);
+      svn_io__file_prefetch(file->file, request->offset, request->size);
+    }
+
+  /* Collect the data in file order. */
+  svn_sort__array(pending, compare_request_offsets);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < pending->nelts; i = k)
+    {
+      svn_fs_fs__read_request_t *request
+        = APR_ARRAY_IDX(pending, i, svn_fs_fs__read_request_t *);
+      apr_off_t start = request->offset;
+      apr_off_t end = start + request->size;
+      char *buffer;
+
+      svn_pool_clear(iterpool);
+
+      /* Combine all following requests that are no more than a block
+       * away from the current range.  Reading the gap is cheaper than
+       * another seek & read. */
+      for (k = i + 1; k < pending->nelts; ++k)
+        {
+          request = APR_ARRAY_IDX(pending, k, svn_fs_fs__read_request_t *);
+          if (request->offset > end + file->block_size)
+            break;
+
+          if (end < request->offset + (apr_off_t)request->size)
+            end = request->offset + request->size;
+        }
+
+      /* Read the whole range at once. */
+      buffer = apr_palloc(result_pool, (apr_size_t)(end - start));
+      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
+                                       start, iterpool));
+      SVN_ERR(svn_io_file_read_full2(file->file, buffer,
+                                     (apr_size_t)(end - start), NULL, NULL,
+                                     iterpool));
+      svn_fs_fs__io_stats_read(file, start, (apr_size_t)(end - start));
+
+      /* Hand out the data. */
+      for (; i < k; ++i)
+        {
+          request = APR_ARRAY_IDX(pending, i, svn_fs_fs__read_request_t *);
+          request->data = buffer + (request->offset - start);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unmap revision file"));
+    }
+
+  if (file->file)
+    svn_fs_fs__io_stats_close(file);
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
-  if (file->file)
+  if (file->pooled_handle)
+    apr_pool_cleanup_run(file->pool, file->pooled_handle,
+                         release_pooled_handle);
+  else if (file->file)
     SVN_ERR(svn_io_file_close(file->file, file->pool));
 
   file->file = NULL;
   file->stream = NULL;
+  file->pooled_handle = NULL;
+  file->mmap = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
 
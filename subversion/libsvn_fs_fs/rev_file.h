@@ -23,6 +23,8 @@
 #ifndef SVN_LIBSVN_FS__REV_FILE_H
 #define SVN_LIBSVN_FS__REV_FILE_H
 
+#include <apr_mmap.h>
+
 #include "svn_fs.h"
 #include "id.h"
 
@@ -38,6 +40,10 @@
 typedef struct svn_fs_fs__packed_number_stream_t
   svn_fs_fs__packed_number_stream_t;
 
+/* Opaque type of the process-wide, re-usable pack file handles.
+ */
+typedef struct svn_fs_fs__pooled_handle_t svn_fs_fs__pooled_handle_t;
+
 /* Data file, including indexes data, and associated properties for
  * START_REVISION.  As the FILE is kept open, background pack operations
  * will not cause access to this file to fail.
@@ -57,6 +63,21 @@ typedef struct svn_fs_fs__revision_file_t
   /* stream based on FILE and not NULL exactly when FILE is not NULL */
   svn_stream_t *stream;
 
+  /* If not NULL, FILE belongs to this shared pack file handle and will be
+   * given back to the pool of idle handles instead of being closed. */
+  svn_fs_fs__pooled_handle_t *pooled_handle;
+
+  /* If not NULL, the whole FILE has been mapped into memory and its
+   * contents may be read directly from here.  Only ever set for committed
+   * revisions opened read-only with mmap support enabled. */
+  apr_mmap_t *mmap;
+
+  /* Contents of FILE as mapped by MMAP.  NULL if MMAP is NULL. */
+  const char *mapped_data;
+
+  /* Number of bytes available at MAPPED_DATA.  0 if MMAP is NULL. */
+  apr_off_t mapped_size;
+
   /* the opened P2L index stream or NULL.  Always NULL for txns. */
   svn_fs_fs__packed_number_stream_t *p2l_stream;
 
@@ -90,6 +111,13 @@ typedef struct svn_fs_fs__revision_file_t
    * been called, yet. */
   apr_off_t footer_offset;
 
+  /* filesystem this file belongs to.  NULL for txn proto-rev files. */
+  svn_fs_t *fs;
+
+  /* number identifying this file in the I/O trace of FS.  0 if it has
+   * not been traced. */
+  int trace_handle;
+
   /* pool containing this object */
   apr_pool_t *pool;
 } svn_fs_fs__revision_file_t;
@@ -137,6 +165,51 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
+/* If FILE has been mapped into memory and the LEN bytes starting at
+ * OFFSET in FILE are fully contained in the mapped range, return a pointer
+ * to that data.  Return NULL otherwise, in which case the caller must read
+ * the data through FILE->FILE or FILE->STREAM.  The data remains valid
+ * until FILE gets closed.  Accessing it does not affect the file pointer.
+ */
+const char *
+svn_fs_fs__rev_file_mapped_data(svn_fs_fs__revision_file_t *file,
+                                apr_off_t offset,
+                                apr_off_t len);
+
+/* Describes a single read within a batch read by
+ * svn_fs_fs__rev_file_read_many().
+ */
+typedef struct svn_fs_fs__read_request_t
+{
+  /* Position of the data within the rev / pack file. */
+  apr_off_t offset;
+
+  /* Number of bytes to read. */
+  apr_size_t size;
+
+  /* The data read.  Set by svn_fs_fs__rev_file_read_many(). */
+  const char *data;
+} svn_fs_fs__read_request_t;
+
+/* Read the data for all svn_fs_fs__read_request_t elements in REQUESTS
+ * from FILE and set their DATA members accordingly.  The requests may be
+ * given in any order and may overlap.
+ *
+ * All reads get submitted to the OS at once such that it may process them
+ * concurrently.  Then, the data will be fetched in file order, combining
+ * requests that are close to each other into single reads.  If FILE has
+ * been mapped into memory, no I/O will happen at all and the DATA members
+ * point into the mapped file contents.
+ *
+ * The DATA will be allocated in RESULT_POOL and is not guaranteed to be
+ * NUL-terminated.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_read_many(svn_fs_fs__revision_file_t *file,
+                              apr_array_header_t *requests,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Close all files and streams in FILE.
  */
 svn_error_t *
@@ -32,6 +32,7 @@
 #include "temp_serializer.h"
 #include "util.h"
 
+#include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "../libsvn_fs/fs-loader.h"
@@ -180,8 +181,106 @@ typedef struct packed_revprops_t
   /* content of the manifest.
    * Maps long(rev - MANIFEST_START) to const char* pack file name */
   apr_array_header_t *manifest;
+
+  /* Changes from the shard's overlay file, see read_overlay().
+   * Maps svn_revnum_t to svn_string_t *.  May be NULL. */
+  apr_hash_t *overlay;
 } packed_revprops_t;
 
+/* Revprop overlay.
+ *
+ * Rewriting a whole pack file for every revprop change is expensive when
+ * many revprops get changed, e.g. by tools that rewrite svn:log.  If
+ * enabled, changes to packed revprops are appended to an overlay file in
+ * the packed shard folder instead.  Each record consists of a header line
+ * "<revision> <length>\n" followed by the serialized revprops.  Later
+ * records supersede earlier ones for the same revision.
+ *
+ * Readers must read the overlay before the pack file.  Since merging the
+ * overlay into the packs replaces the pack files before removing the
+ * overlay, they will then never see outdated revprops.
+ */
+
+/* Return the path of the overlay file for the packed shard containing
+ * REVISION in FS.  Allocate the result in RESULT_POOL. */
+static const char *
+path_revprops_overlay(svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      apr_pool_t *result_pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_revprops_pack_shard(fs, revision,
+                                                             result_pool),
+                         PATH_REVPROPS_OVERLAY, result_pool);
+}
+
+/* Read the overlay file for the packed shard containing REVISION in FS.
+ * Return the latest serialized revprops per revision in *RECORDS, mapping
+ * svn_revnum_t to svn_string_t *, or NULL if there is no overlay.  If
+ * VALID_LEN is not NULL, set it to the size of the complete records in
+ * that file.
+ *
+ * Incomplete records can only be left behind by a crashed writer at the
+ * end of the file, so we simply stop parsing there.
+ *
+ * Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+read_overlay(apr_hash_t **records,
+             apr_size_t *valid_len,
+             svn_fs_t *fs,
+             svn_revnum_t revision,
+             apr_pool_t *result_pool)
+{
+  const char *path = path_revprops_overlay(fs, revision, result_pool);
+  svn_stringbuf_t *content;
+  svn_boolean_t missing;
+  const char *p, *end;
+
+  SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&content, &missing, path,
+                                             FALSE, result_pool));
+
+  /* Don't silently ignore changes due to transient I/O errors. */
+  if (!content && !missing)
+    SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&content, NULL, path, TRUE,
+                                               result_pool));
+
+  *records = NULL;
+  if (valid_len)
+    *valid_len = 0;
+  if (!content)
+    return SVN_NO_ERROR;
+
+  *records = apr_hash_make(result_pool);
+  for (p = content->data, end = content->data + content->len; p < end; )
+    {
+      const char *next;
+      svn_revnum_t *key;
+      svn_string_t *serialized;
+      apr_size_t len;
+
+      key = apr_palloc(result_pool, sizeof(*key));
+      *key = (svn_revnum_t)svn__strtoul(p, &next);
+      if (next == p || *next != ' ')
+        break;
+
+      p = next + 1;
+      len = (apr_size_t)svn__strtoul(p, &next);
+      if (next == p || *next != '\n' || len > (apr_size_t)(end - next - 1))
+        break;
+
+      serialized = apr_palloc(result_pool, sizeof(*serialized));
+      serialized->data = next + 1;
+      serialized->len = len;
+      apr_hash_set(*records, key, sizeof(*key), serialized);
+
+      p = next + 1 + len;
+      if (valid_len)
+        *valid_len = p - content->data;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Parse the serialized revprops in CONTENT and return them in *PROPERTIES.
  * Also, put them into the revprop cache, if activated, for future use.
  *
@@ -196,11 +295,13 @@ parse_revprop(apr_hash_t **properties,
               apr_pool_t *result_pool,
               apr_pool_t *scratch_pool)
 {
-  svn_stream_t *stream = svn_stream_from_string(content, scratch_pool);
+  /* CONTENT may be shared or get cached later.  Parse a copy of it in-place
+     such that the keys and values can point into that single buffer. */
+  char *data = apr_pmemdup(result_pool, content->data, content->len);
   *properties = apr_hash_make(result_pool);
 
-  SVN_ERR_W(svn_hash_read2(*properties, stream, SVN_HASH_TERMINATOR,
-                           result_pool),
+  SVN_ERR_W(svn_hash__parse(*properties, data, content->len,
+                            SVN_HASH_TERMINATOR, result_pool),
             apr_psprintf(scratch_pool, "Failed to parse revprops for r%ld.",
                          revision));
 
@@ -462,6 +563,7 @@ parse_packed_revprops(svn_fs_t *fs,
   apr_int64_t first_rev, count, i;
   apr_size_t offset;
   const char *header_end;
+  svn_stringbuf_t *merged = NULL;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   /* Initial value for the "Leaking bucket" pattern. */
@@ -525,6 +627,12 @@ parse_packed_revprops(svn_fs_t *fs,
                                        sizeof(offset));
       revprops->offsets = apr_array_make(result_pool, (int)count,
                                          sizeof(offset));
+
+      /* With pending changes in the overlay, we need to construct the
+       * pack content as it will be after merging them. */
+      if (revprops->overlay)
+        merged = svn_stringbuf_create_ensure(revprops->packed_revprops->len,
+                                             result_pool);
     }
 
   /* Now parse, revision by revision, the size and content of each
@@ -547,6 +655,15 @@ parse_packed_revprops(svn_fs_t *fs,
       serialized.data = revprops->packed_revprops->data + offset;
       serialized.len = (apr_size_t)size;
 
+      /* Changes in the overlay take precedence. */
+      if (revprops->overlay)
+        {
+          svn_string_t *changed = apr_hash_get(revprops->overlay, &revision,
+                                               sizeof(revision));
+          if (changed)
+            serialized = *changed;
+        }
+
       if (revision == revprops->revision)
         {
           /* Parse (and possibly cache) the one revprop list we care about. */
@@ -589,13 +706,25 @@ parse_packed_revprops(svn_fs_t *fs,
         {
           /* fill REVPROPS data structures */
           APR_ARRAY_PUSH(revprops->sizes, apr_size_t) = serialized.len;
-          APR_ARRAY_PUSH(revprops->offsets, apr_size_t) = offset;
+          if (merged)
+            {
+              APR_ARRAY_PUSH(revprops->offsets, apr_size_t) = merged->len;
+              svn_stringbuf_appendbytes(merged, serialized.data,
+                                        serialized.len);
+            }
+          else
+            {
+              APR_ARRAY_PUSH(revprops->offsets, apr_size_t) = offset;
+            }
         }
       revprops->total_size += serialized.len;
 
-      offset += serialized.len;
+      offset += (apr_size_t)size;
     }
 
+  if (merged)
+    revprops->packed_revprops = merged;
+
   return SVN_NO_ERROR;
 }
 
@@ -631,6 +760,9 @@ read_pack_revprop(packed_revprops_t **revprops,
   result = apr_pcalloc(pool, sizeof(*result));
   result->revision = rev;
 
+  /* pending changes must be read before the pack file, see above. */
+  SVN_ERR(read_overlay(&result->overlay, NULL, fs, rev, pool));
+
   /* try to read the packed revprops. This may require retries if we have
    * concurrent writers. */
   for (i = 0;
@@ -672,6 +804,37 @@ read_pack_revprop(packed_revprops_t **revprops,
   return SVN_NO_ERROR;
 }
 
+/* Look up the revprops for revision REV in FS's revprop cache.  Set
+ * *IS_CACHED to indicate whether they are there and, if so, return them
+ * in *PROPLIST_P.  Allocate the result in RESULT_POOL and use SCRATCH_POOL
+ * for temporaries.
+ */
+static svn_error_t *
+get_cached_revprops(apr_hash_t **proplist_p,
+                    svn_boolean_t *is_cached,
+                    svn_fs_t *fs,
+                    svn_revnum_t rev,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  pair_cache_key_t key;
+
+  /* Auto-alloc prefix and construct the key. */
+  SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
+  key.revision = rev;
+  key.second = ffd->revprop_prefix;
+
+  /* The only way that this might error out is due to parser error. */
+  SVN_ERR_W(svn_cache__get((void **) proplist_p, is_cached,
+                           ffd->revprop_cache, &key, result_pool),
+            apr_psprintf(scratch_pool,
+                         "Failed to parse revprops for r%ld.",
+                         rev));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the revprops for revision REV in FS and return them in *PROPERTIES_P.
  *
  * Allocations will be done in POOL.
@@ -706,19 +869,9 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
     {
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
-      pair_cache_key_t key;
-
-      /* Auto-alloc prefix and construct the key. */
-      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
-      key.revision = rev;
-      key.second = ffd->revprop_prefix;
-
-      /* The only way that this might error out is due to parser error. */
-      SVN_ERR_W(svn_cache__get((void **) proplist_p, &is_cached,
-                               ffd->revprop_cache, &key, result_pool),
-                apr_psprintf(scratch_pool,
-                             "Failed to parse revprops for r%ld.",
-                             rev));
+
+      SVN_ERR(get_cached_revprops(proplist_p, &is_cached, fs, rev,
+                                  result_pool, scratch_pool));
       if (is_cached)
         return SVN_NO_ERROR;
     }
@@ -761,6 +914,129 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+/* Invoke RECEIVER with RECEIVER_BATON for the revprops of all revisions
+ * from REV towards END in steps of STEP (+1 or -1) that are stored in
+ * the same pack file as REV.  Also, put them into the revprop cache, if
+ * POPULATE_CACHE is set.  Set *LAST_REV to the last revision reported.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+send_pack_revprops(svn_revnum_t *last_rev,
+                   svn_fs_t *fs,
+                   svn_revnum_t rev,
+                   svn_revnum_t end,
+                   int step,
+                   svn_boolean_t populate_cache,
+                   svn_fs_revision_proplist_receiver_t receiver,
+                   void *receiver_baton,
+                   apr_pool_t *scratch_pool)
+{
+  packed_revprops_t *revprops;
+  svn_revnum_t pack_end;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(read_pack_revprop(&revprops, fs, rev, TRUE, populate_cache,
+                            scratch_pool));
+
+  /* Clip the range to the pack's contents. */
+  if (step > 0)
+    pack_end = MIN(end, revprops->start_revision
+                        + revprops->sizes->nelts - 1);
+  else
+    pack_end = MAX(end, revprops->start_revision);
+
+  /* REV itself has already been parsed. */
+  SVN_ERR(receiver(receiver_baton, rev, revprops->properties, iterpool));
+  while (rev != pack_end)
+    {
+      apr_hash_t *proplist;
+      svn_string_t serialized;
+      int idx;
+
+      svn_pool_clear(iterpool);
+      rev += step;
+
+      idx = (int)(rev - revprops->start_revision);
+      serialized.data = revprops->packed_revprops->data
+                      + APR_ARRAY_IDX(revprops->offsets, idx, apr_size_t);
+      serialized.len = APR_ARRAY_IDX(revprops->sizes, idx, apr_size_t);
+
+      SVN_ERR(parse_revprop(&proplist, fs, rev, &serialized, iterpool,
+                            iterpool));
+      SVN_ERR(receiver(receiver_baton, rev, proplist, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *last_rev = rev;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_revision_proplist_range(
+                            svn_fs_t *fs,
+                            svn_revnum_t start,
+                            svn_revnum_t end,
+                            svn_boolean_t refresh,
+                            svn_fs_revision_proplist_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int step = start <= end ? 1 : -1;
+  svn_revnum_t rev;
+
+  /* Same policy as in svn_fs_fs__get_revision_proplist(). */
+  svn_boolean_t populate_cache = !refresh;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(MAX(start, end), fs,
+                                            scratch_pool));
+  if (refresh)
+    svn_fs_fs__reset_revprop_cache(fs);
+
+  for (rev = start; ; rev += step)
+    {
+      apr_hash_t *proplist;
+      svn_boolean_t is_cached = FALSE;
+
+      svn_pool_clear(iterpool);
+
+      if (!refresh)
+        SVN_ERR(get_cached_revprops(&proplist, &is_cached, fs, rev,
+                                    iterpool, iterpool));
+
+      if (is_cached)
+        {
+          SVN_ERR(receiver(receiver_baton, rev, proplist, iterpool));
+        }
+      else if (   ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT
+               && svn_fs_fs__is_packed_revprop(fs, rev))
+        {
+          /* Report as many revisions as possible from this pack. */
+          SVN_ERR(send_pack_revprops(&rev, fs, rev, end, step,
+                                     populate_cache, receiver,
+                                     receiver_baton, iterpool));
+        }
+      else
+        {
+          /* Non-packed revprops.  This also handles the case that REV
+           * got packed just now. */
+          SVN_ERR(svn_fs_fs__get_revision_proplist(&proplist, fs, rev,
+                                                   FALSE, iterpool,
+                                                   iterpool));
+          SVN_ERR(receiver(receiver_baton, rev, proplist, iterpool));
+        }
+
+      if (rev == end)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Serialize the revision property list PROPLIST of revision REV in
  * filesystem FS to a non-packed file.  Return the name of that temporary
  * file in *TMP_PATH and the file path that it must be moved to in
@@ -1162,6 +1438,163 @@ write_packed_revprop(const char **final_path,
   return SVN_NO_ERROR;
 }
 
+/* Append PROPLIST as the new revprops of the packed revision REV in FS
+ * to the overlay file of its shard, creating it as necessary with the
+ * permissions of PERMS_REFERENCE.  Drop any incomplete record left behind
+ * by an earlier writer.  Return the new size of the overlay file in
+ * *OVERLAY_SIZE.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+append_to_overlay(apr_size_t *overlay_size,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  apr_hash_t *proplist,
+                  const char *perms_reference,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *path = path_revprops_overlay(fs, rev, scratch_pool);
+  apr_hash_t *records;
+  apr_size_t valid_len;
+  apr_off_t offset;
+  apr_file_t *file;
+  svn_stringbuf_t *record;
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(scratch_pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(serialized, scratch_pool);
+
+  SVN_ERR(svn_hash_write2(proplist, stream, SVN_HASH_TERMINATOR,
+                          scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  record = svn_stringbuf_createf(scratch_pool, "%ld %" APR_SIZE_T_FMT "\n",
+                                 rev, serialized->len);
+  svn_stringbuf_appendstr(record, serialized);
+
+  SVN_ERR(read_overlay(&records, &valid_len, fs, rev, scratch_pool));
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_WRITE | APR_CREATE,
+                           APR_OS_DEFAULT, scratch_pool));
+  if (records == NULL)
+    SVN_ERR(svn_io_copy_perms(perms_reference, path, scratch_pool));
+
+  SVN_ERR(svn_io_file_trunc(file, valid_len, scratch_pool));
+  offset = valid_len;
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, record->data, record->len, NULL,
+                                 scratch_pool));
+  if (ffd->flush_to_disk)
+    SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  *overlay_size = valid_len + record->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Merge the overlay of the packed shard containing REV in FS into the
+ * shard's pack files and remove it.  Give new files the permissions of
+ * PERMS_REFERENCE.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * Every pack file with pending changes gets rewritten once, keeping the
+ * revision ranges of all packs.  The manifest is switched to the new pack
+ * files before the overlay file gets removed.
+ */
+static svn_error_t *
+merge_overlay(svn_fs_t *fs,
+              svn_revnum_t rev,
+              const char *perms_reference,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *records;
+  apr_hash_index_t *hi;
+  apr_array_header_t *revisions;
+  apr_array_header_t *files_to_delete = NULL;
+  apr_array_header_t *manifest = NULL;
+  packed_revprops_t *revprops = NULL;
+  svn_revnum_t next_rev = SVN_INVALID_REVNUM;
+  const char *final_path;
+  const char *tmp_path;
+  apr_file_t *file;
+  svn_stream_t *stream;
+  int i;
+
+  SVN_ERR(read_overlay(&records, NULL, fs, rev, scratch_pool));
+  if (records == NULL)
+    return SVN_NO_ERROR;
+
+  revisions = apr_array_make(scratch_pool, apr_hash_count(records),
+                             sizeof(svn_revnum_t));
+  for (hi = apr_hash_first(scratch_pool, records); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(revisions, svn_revnum_t)
+      = *(const svn_revnum_t *)apr_hash_this_key(hi);
+  svn_sort__array(revisions, svn_sort_compare_revisions);
+
+  /* svn_sort_compare_revisions() orders by descending revision. */
+  for (i = revisions->nelts - 1; i >= 0; --i)
+    {
+      svn_revnum_t revision = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      int count, k;
+
+      /* Covered by the pack file that we just rewrote? */
+      if (SVN_IS_VALID_REVNUM(next_rev) && revision < next_rev)
+        continue;
+
+      /* This already contains the overlay changes. */
+      SVN_ERR(read_pack_revprop(&revprops, fs, revision, TRUE, FALSE,
+                                scratch_pool));
+      count = revprops->sizes->nelts;
+
+      SVN_ERR(repack_file_open(&file, fs, revprops, 0, count,
+                               &files_to_delete, scratch_pool));
+      SVN_ERR(repack_revprops(fs, revprops, 0, count, -1, NULL,
+                              revprops->total_size
+                                + (count + 2) * SVN_INT64_BUFFER_SIZE,
+                              file, scratch_pool));
+
+      /* All pack reads see the same on-disk manifest.  Collect the new
+       * pack file names in the first one. */
+      if (manifest == NULL)
+        manifest = revprops->manifest;
+      for (k = 0; k < count; ++k)
+        {
+          int idx = (int)(revprops->start_revision + k
+                          - revprops->manifest_start);
+          APR_ARRAY_IDX(manifest, idx, const char *)
+            = APR_ARRAY_IDX(revprops->manifest, idx, const char *);
+        }
+
+      next_rev = revprops->start_revision + count;
+    }
+
+  /* No valid records at all? */
+  if (revprops)
+    {
+      final_path = svn_dirent_join(revprops->folder, PATH_MANIFEST,
+                                   scratch_pool);
+      SVN_ERR(svn_io_open_unique_file3(&file, &tmp_path, revprops->folder,
+                                       svn_io_file_del_none, scratch_pool,
+                                       scratch_pool));
+      stream = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
+      for (i = 0; i < manifest->nelts; ++i)
+        SVN_ERR(svn_stream_printf(stream, scratch_pool, "%s\n",
+                                  APR_ARRAY_IDX(manifest, i, const char *)));
+      SVN_ERR(svn_stream_close(stream));
+      if (ffd->flush_to_disk)
+        SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+      SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+      SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path,
+                                    perms_reference, files_to_delete,
+                                    scratch_pool));
+    }
+
+  SVN_ERR(svn_io_remove_file2(path_revprops_overlay(fs, rev, scratch_pool),
+                              TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Set the revision property list of revision REV in filesystem FS to
    PROPLIST.  Use POOL for temporary allocations. */
 svn_error_t *
@@ -1170,6 +1603,7 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
                                  apr_hash_t *proplist,
                                  apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_boolean_t is_packed;
   const char *final_path;
   const char *tmp_path;
@@ -1181,6 +1615,38 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   /* this info will not change while we hold the global FS write lock */
   is_packed = svn_fs_fs__is_packed_revprop(fs, rev);
 
+  /* We use the rev file of this revision as the perms reference,
+   * because when setting revprops for the first time, the revprop
+   * file won't exist and therefore can't serve as its own reference.
+   * (Whereas the rev file should already exist at this point.)
+   */
+  perms_reference = svn_fs_fs__path_rev_absolute(fs, rev, pool);
+
+  if (is_packed)
+    {
+      svn_node_kind_t kind = svn_node_none;
+
+      /* A left-over overlay must be used until it has been merged. */
+      if (ffd->revprop_overlay_size == 0)
+        SVN_ERR(svn_io_check_path(path_revprops_overlay(fs, rev, pool),
+                                  &kind, pool));
+
+      if (ffd->revprop_overlay_size > 0 || kind != svn_node_none)
+        {
+          apr_size_t overlay_size;
+
+          SVN_ERR(append_to_overlay(&overlay_size, fs, rev, proplist,
+                                    perms_reference, pool));
+          if (overlay_size >= ffd->revprop_overlay_size)
+            SVN_ERR(merge_overlay(fs, rev, perms_reference, pool));
+
+          /* Previous cache contents is invalid now. */
+          svn_fs_fs__reset_revprop_cache(fs);
+
+          return SVN_NO_ERROR;
+        }
+    }
+
   /* Serialize the new revprop data */
   if (is_packed)
     SVN_ERR(write_packed_revprop(&final_path, &tmp_path, &files_to_delete,
@@ -1192,13 +1658,6 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   /* Previous cache contents is invalid now. */
   svn_fs_fs__reset_revprop_cache(fs);
 
-  /* We use the rev file of this revision as the perms reference,
-   * because when setting revprops for the first time, the revprop
-   * file won't exist and therefore can't serve as its own reference.
-   * (Whereas the rev file should already exist at this point.)
-   */
-  perms_reference = svn_fs_fs__path_rev_absolute(fs, rev, pool);
-
   /* Now, switch to the new revprop data. */
   SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
                                 files_to_delete, pool));
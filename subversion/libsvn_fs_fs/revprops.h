@@ -76,6 +76,19 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool);
 
+/* Implements svn_fs_revision_proplist_range() for FS.  Revisions in
+ * packed shards are parsed from a single read of their pack file.
+ */
+svn_error_t *
+svn_fs_fs__get_revision_proplist_range(
+                            svn_fs_t *fs,
+                            svn_revnum_t start,
+                            svn_revnum_t end,
+                            svn_boolean_t refresh,
+                            svn_fs_revision_proplist_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
 /* Set the revision property list of revision REV in filesystem FS to
    PROPLIST.  Use POOL for temporary allocations. */
 svn_error_t *
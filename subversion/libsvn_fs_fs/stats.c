@@ -28,6 +28,7 @@
 #include "private/svn_cache.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 #include "private/svn_fs_fs_private.h"
 
 #include "index.h"
@@ -596,82 +597,140 @@ parse_dir(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Parse the noderev given as NODEREV_STR and store the info in QUERY and
- * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
- * directories and representations linked in that tree structure.
+/* Update the representation stats in QUERY for a node of KIND that has
+ * been created at CREATED_PATH and uses DATA_REP and PROP_REP, both of
+ * which may be NULL.  PLAIN_ADDED indicates that the node has no
+ * predecessor.  REVISION_INFO is the revision containing the node.
+ * Return the rep stats for the text and props in *TEXT and *PROPS,
+ * respectively, or NULL where there is no such representation.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_noderev(query_t *query,
-             svn_stringbuf_t *noderev_str,
-             revision_info_t *revision_info,
-             apr_pool_t *result_pool,
-             apr_pool_t *scratch_pool)
+add_noderev_reps(rep_stats_t **text,
+                 rep_stats_t **props,
+                 query_t *query,
+                 svn_node_kind_t kind,
+                 const char *created_path,
+                 svn_boolean_t plain_added,
+                 representation_t *data_rep,
+                 representation_t *prop_rep,
+                 revision_info_t *revision_info,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
 {
-  rep_stats_t *text = NULL;
-  rep_stats_t *props = NULL;
-  node_revision_t *noderev;
-
-  svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
-  SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, scratch_pool,
-                                  scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->data_rep,
-                                         scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->prop_rep,
-                                         scratch_pool));
+  *text = NULL;
+  *props = NULL;
 
-  if (noderev->data_rep)
+  if (data_rep)
     {
-      SVN_ERR(parse_representation(&text, query,
-                                   noderev->data_rep, revision_info,
+      SVN_ERR(parse_representation(text, query, data_rep, revision_info,
                                    result_pool, scratch_pool));
 
       /* if we are the first to use this rep, mark it as "text rep" */
-      if (++text->ref_count == 1)
-        text->kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
+      if (++(*text)->ref_count == 1)
+        (*text)->kind = kind == svn_node_dir ? dir_rep : file_rep;
     }
 
-  if (noderev->prop_rep)
+  if (prop_rep)
     {
-      SVN_ERR(parse_representation(&props, query,
-                                   noderev->prop_rep, revision_info,
+      SVN_ERR(parse_representation(props, query, prop_rep, revision_info,
                                    result_pool, scratch_pool));
 
       /* if we are the first to use this rep, mark it as "prop rep" */
-      if (++props->ref_count == 1)
-        props->kind = noderev->kind == svn_node_dir ? dir_property_rep
-                                                    : file_property_rep;
+      if (++(*props)->ref_count == 1)
+        (*props)->kind = kind == svn_node_dir ? dir_property_rep
+                                              : file_property_rep;
     }
 
   /* record largest changes */
-  if (text && text->ref_count == 1)
-    add_change(query->stats, text->size, text->expanded_size, text->revision,
-               noderev->created_path, text->kind, !noderev->predecessor_id);
-  if (props && props->ref_count == 1)
-    add_change(query->stats, props->size, props->expanded_size,
-               props->revision, noderev->created_path, props->kind,
-               !noderev->predecessor_id);
+  if (*text && (*text)->ref_count == 1)
+    add_change(query->stats, (*text)->size, (*text)->expanded_size,
+               (*text)->revision, created_path, (*text)->kind, plain_added);
+  if (*props && (*props)->ref_count == 1)
+    add_change(query->stats, (*props)->size, (*props)->expanded_size,
+               (*props)->revision, created_path, (*props)->kind,
+               plain_added);
 
-  /* if this is a directory and has not been processed, yet, read and
-   * process it recursively */
-  if (   noderev->kind == svn_node_dir && text && text->ref_count == 1
-      && !svn_fs_fs__use_log_addressing(query->fs))
-    SVN_ERR(parse_dir(query, noderev, revision_info, result_pool,
-                      scratch_pool));
+  return SVN_NO_ERROR;
+}
 
-  /* update stats */
-  if (noderev->kind == svn_node_dir)
+/* Add a noderev of KIND with on-disk size SIZE to the stats in
+ * REVISION_INFO.
+ */
+static void
+count_noderev(revision_info_t *revision_info,
+              svn_node_kind_t kind,
+              apr_size_t size)
+{
+  if (kind == svn_node_dir)
     {
-      revision_info->dir_noderev_size += noderev_str->len;
+      revision_info->dir_noderev_size += size;
       revision_info->dir_noderev_count++;
     }
   else
     {
-      revision_info->file_noderev_size += noderev_str->len;
+      revision_info->file_noderev_size += size;
       revision_info->file_noderev_count++;
     }
+}
+
+/* Parse the noderev given as NODEREV_STR in FS and return it in *NODEREV,
+ * allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+parse_noderev(node_revision_t **noderev,
+              svn_fs_t *fs,
+              svn_stringbuf_t *noderev_str,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
+  SVN_ERR(svn_fs_fs__read_noderev(noderev, stream, result_pool,
+                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, (*noderev)->data_rep,
+                                         scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, (*noderev)->prop_rep,
+                                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the noderev given as NODEREV_STR and store the info in QUERY and
+ * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
+ * directories and representations linked in that tree structure.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_noderev(query_t *query,
+             svn_stringbuf_t *noderev_str,
+             revision_info_t *revision_info,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  rep_stats_t *text;
+  rep_stats_t *props;
+  node_revision_t *noderev;
+
+  SVN_ERR(parse_noderev(&noderev, query->fs, noderev_str, scratch_pool,
+                        scratch_pool));
+  SVN_ERR(add_noderev_reps(&text, &props, query, noderev->kind,
+                           noderev->created_path, !noderev->predecessor_id,
+                           noderev->data_rep, noderev->prop_rep,
+                           revision_info, result_pool, scratch_pool));
+
+  /* if this is a directory and has not been processed, yet, read and
+   * process it recursively */
+  if (   noderev->kind == svn_node_dir && text && text->ref_count == 1
+      && !svn_fs_fs__use_log_addressing(query->fs))
+    SVN_ERR(parse_dir(query, noderev, revision_info, result_pool,
+                      scratch_pool));
+
+  /* update stats */
+  count_noderev(revision_info, noderev->kind, noderev_str->len);
 
   return SVN_NO_ERROR;
 }
@@ -988,53 +1047,102 @@ resolve_representation_refs(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Process the logically addressed revision contents of revisions BASE to
- * BASE + COUNT - 1 in QUERY.
+/* A noderev found while scanning a logically addressed rev / pack file.
+ * We keep just enough of it to update the representation stats once all
+ * previous revisions have been processed. */
+typedef struct noderev_info_t
+{
+  /* Revision that contains the noderev. */
+  svn_revnum_t revision;
+
+  /* Node kind. */
+  svn_node_kind_t kind;
+
+  /* TRUE, if the node has no predecessor. */
+  svn_boolean_t plain_added;
+
+  /* Path the node got created at. */
+  const char *created_path;
+
+  /* Text and property representations.  May be NULL. */
+  representation_t *data_rep;
+  representation_t *prop_rep;
+} noderev_info_t;
+
+/* Everything found in a single logically addressed rev / pack file that
+ * affects the stats.  This can be collected for many rev / pack files in
+ * parallel but must then be added to the query strictly in revision
+ * order. */
+typedef struct log_scan_t
+{
+  /* The revisions BASE to BASE + COUNT - 1 covered by the file.
+   * Their REPRESENTATIONS lists are NULL. */
+  svn_revnum_t base;
+  int count;
+  apr_array_header_t *revisions;
+
+  /* All noderevs as noderev_info_t *, in file order. */
+  apr_array_header_t *noderevs;
+
+  /* All delta chain links as rep_ref_t *. */
+  apr_array_header_t *rep_refs;
+} log_scan_t;
+
+/* Scan the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in FS and return the findings in *SCAN.  This does not
+ * access any query data, i.e. it may be called from a worker thread as
+ * long as FS is used by that thread only.  Call the optional CANCEL_FUNC
+ * with CANCEL_BATON once in a while.
  *
- * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+ * Allocate *SCAN in RESULT_POOL and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
-read_log_rev_or_packfile(query_t *query,
+scan_log_rev_or_packfile(log_scan_t **scan,
+                         svn_fs_t *fs,
                          svn_revnum_t base,
                          int count,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
-  fs_fs_data_t *ffd = query->fs->fsap_data;
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_off_t max_offset;
   apr_off_t offset = 0;
   int i;
   svn_fs_fs__revision_file_t *rev_file;
-
-  /* We collect the delta chain links as we scan the file.  Afterwards,
-   * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
+  log_scan_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  /* We collect the noderevs and delta chain links as we scan the file.
+   * add_log_scan() will later use them to update the rep stats. */
+  result->base = base;
+  result->count = count;
+  result->revisions = apr_array_make(result_pool, count,
+                                     sizeof(revision_info_t *));
+  result->noderevs = apr_array_make(result_pool, 64,
+                                    sizeof(noderev_info_t *));
+  result->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
 
   /* we will process every revision in the rev / pack file */
   for (i = 0; i < count; ++i)
     {
       /* create the revision info for the current rev */
       revision_info_t *info = apr_pcalloc(result_pool, sizeof(*info));
-      info->representations = apr_array_make(result_pool, 4,
-                                             sizeof(rep_stats_t*));
       info->revision = base + i;
 
-      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+      APR_ARRAY_PUSH(result->revisions, revision_info_t*) = info;
     }
 
   /* open the pack / rev file that is covered by the p2l index */
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, base,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, base,
                                            scratch_pool, iterpool));
-  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, query->fs, rev_file,
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, rev_file,
                                         base, scratch_pool));
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  APR_ARRAY_IDX(result->revisions, 0, revision_info_t*)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1045,11 +1153,11 @@ read_log_rev_or_packfile(query_t *query,
       svn_pool_clear(iterpool);
 
       /* cancellation support */
-      if (query->cancel_func)
-        SVN_ERR(query->cancel_func(query->cancel_baton));
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
 
       /* get all entries for the current block */
-      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, query->fs, rev_file, base,
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, rev_file, base,
                                           offset, ffd->p2l_page_size,
                                           iterpool, iterpool));
 
@@ -1070,13 +1178,35 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
+          SVN_ERR_ASSERT(   entry->item.revision >= base
+                         && entry->item.revision < base + count);
+          info = APR_ARRAY_IDX(result->revisions,
+                               entry->item.revision - base,
                                revision_info_t*);
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
+              node_revision_t *noderev;
+              noderev_info_t *noderev_info
+                = apr_pcalloc(result_pool, sizeof(*noderev_info));
+
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              SVN_ERR(read_noderev(query, item, info, result_pool, iterpool));
+              SVN_ERR(parse_noderev(&noderev, fs, item, iterpool,
+                                    iterpool));
+              count_noderev(info, noderev->kind, item->len);
+
+              noderev_info->revision = info->revision;
+              noderev_info->kind = noderev->kind;
+              noderev_info->plain_added = !noderev->predecessor_id;
+              noderev_info->created_path
+                = apr_pstrdup(result_pool, noderev->created_path);
+              noderev_info->data_rep
+                = svn_fs_fs__rep_copy(noderev->data_rep, result_pool);
+              noderev_info->prop_rep
+                = svn_fs_fs__rep_copy(noderev->prop_rep, result_pool);
+
+              APR_ARRAY_PUSH(result->noderevs, noderev_info_t *)
+                = noderev_info;
             }
           else if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
             {
@@ -1092,7 +1222,7 @@ read_log_rev_or_packfile(query_t *query,
             {
               /* Collect the delta chain link. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1117,7 +1247,7 @@ read_log_rev_or_packfile(query_t *query,
                   ref->base_revision = SVN_INVALID_REVNUM;
                 }
 
-              APR_ARRAY_PUSH(rep_refs, rep_ref_t *) = ref;
+              APR_ARRAY_PUSH(result->rep_refs, rep_ref_t *) = ref;
             }
 
           /* advance offset */
@@ -1125,28 +1255,114 @@ read_log_rev_or_packfile(query_t *query,
         }
     }
 
+  /* clean up and close file handles */
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  *scan = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the findings in SCAN to QUERY.  All revisions before SCAN->BASE
+ * must already have been added.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+add_log_scan(query_t *query,
+             log_scan_t *scan,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR_ASSERT(query->revisions->nelts == scan->base);
+
+  /* Move the revision infos over to the query. */
+  for (i = 0; i < scan->count; ++i)
+    {
+      revision_info_t *info
+        = apr_pmemdup(result_pool,
+                      APR_ARRAY_IDX(scan->revisions, i, revision_info_t *),
+                      sizeof(*info));
+      info->representations = apr_array_make(result_pool, 4,
+                                             sizeof(rep_stats_t*));
+
+      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+    }
+
+  /* Process the representations in the same order as we found them. */
+  for (i = 0; i < scan->noderevs->nelts; ++i)
+    {
+      rep_stats_t *text;
+      rep_stats_t *props;
+      noderev_info_t *noderev
+        = APR_ARRAY_IDX(scan->noderevs, i, noderev_info_t *);
+      revision_info_t *info = APR_ARRAY_IDX(query->revisions,
+                                            noderev->revision,
+                                            revision_info_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(add_noderev_reps(&text, &props, query, noderev->kind,
+                               noderev->created_path, noderev->plain_added,
+                               noderev->data_rep, noderev->prop_rep, info,
+                               result_pool, iterpool));
+    }
+
   /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
+  SVN_ERR(resolve_representation_refs(query, scan->rep_refs));
 
-  /* clean up and close file handles */
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
+/* Process the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in QUERY.  If SCAN is not NULL, it contains the
+ * result of scan_log_rev_or_packfile() for those revisions and we won't
+ * read the file again.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_rev_or_packfile(query_t *query,
+                         log_scan_t *scan,
+                         svn_revnum_t base,
+                         int count,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  if (!scan)
+    SVN_ERR(scan_log_rev_or_packfile(&scan, query->fs, base, count,
+                                     query->cancel_func,
+                                     query->cancel_baton,
+                                     scratch_pool, scratch_pool));
+
+  SVN_ERR_ASSERT(scan->base == base && scan->count == count);
+  SVN_ERR(add_log_scan(query, scan, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the content of the pack file staring at revision BASE logical
- * addressing mode and store it in QUERY.
+ * addressing mode and store it in QUERY.  SCAN is as for
+ * read_log_rev_or_packfile().
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
 read_log_pack_file(query_t *query,
+                   log_scan_t *scan,
                    svn_revnum_t base,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, base, query->shard_size,
+  SVN_ERR(read_log_rev_or_packfile(query, scan, base, query->shard_size,
                                    result_pool, scratch_pool));
 
   /* one more pack file processed */
@@ -1157,18 +1373,20 @@ read_log_pack_file(query_t *query,
 }
 
 /* Read the content of the file for REVISION in logical addressing mode
- * and store its contents in QUERY.
+ * and store its contents in QUERY.  SCAN is as for
+ * read_log_rev_or_packfile().
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
 read_log_revision_file(query_t *query,
+                       log_scan_t *scan,
                        svn_revnum_t revision,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
+  SVN_ERR(read_log_rev_or_packfile(query, scan, revision, 1,
                                    result_pool, scratch_pool));
 
   /* show progress every 1000 revs or so */
@@ -1183,6 +1401,188 @@ read_log_revision_file(query_t *query,
   return SVN_NO_ERROR;
 }
 
+/* Number of non-packed revisions to scan per task in non-sharded
+ * repositories. */
+#define REVISIONS_PER_TASK 1000
+
+/* A range of revisions being scanned concurrently with others.  This is
+ * either a packed shard or (part of) a shard of non-packed revisions. */
+typedef struct stats_task_t
+{
+  /* Instance of the filesystem being scanned that nobody else uses.
+     The tasks open their own instances from it because the FSFS caches
+     etc. are not thread-safe. */
+  svn_fs_t *fs;
+
+  /* The first revision and the number of revisions to scan. */
+  svn_revnum_t start_rev;
+  int count;
+
+  /* Whether START_REV is the beginning of a packed shard. */
+  svn_boolean_t packed;
+} stats_task_t;
+
+/* Result of a stats_task_t. */
+typedef struct stats_result_t
+{
+  /* Whether the scans cover a packed shard. */
+  svn_boolean_t packed;
+
+  /* The log_scan_t * for each rev / pack file, in revision order. */
+  apr_array_header_t *scans;
+} stats_result_t;
+
+/* Output baton of the parallel scan. */
+typedef struct stats_output_baton_t
+{
+  /* Collects the findings. */
+  query_t *query;
+
+  /* Pool to allocate the findings in. */
+  apr_pool_t *result_pool;
+} stats_output_baton_t;
+
+/* Implements svn_task__process_func_t.  Scan the revisions of the
+ * stats_task_t in PROCESS_BATON and return a stats_result_t in *RESULT. */
+static svn_error_t *
+stats_task(void **result,
+           void *process_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  const stats_task_t *task = process_baton;
+  stats_result_t *stats_result = apr_pcalloc(result_pool,
+                                             sizeof(*stats_result));
+  int step = task->packed ? task->count : 1;
+  apr_pool_t *iterpool;
+  svn_fs_t *fs;
+  int i;
+
+  SVN_ERR(svn_fs_fs__open_instance(&fs, task->fs, scratch_pool,
+                                   scratch_pool));
+
+  stats_result->packed = task->packed;
+  stats_result->scans = apr_array_make(result_pool, task->count / step,
+                                       sizeof(log_scan_t *));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < task->count; i += step)
+    {
+      log_scan_t *scan;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(scan_log_rev_or_packfile(&scan, fs, task->start_rev + i, step,
+                                       cancel_func, cancel_baton,
+                                       result_pool, iterpool));
+      APR_ARRAY_PUSH(stats_result->scans, log_scan_t *) = scan;
+    }
+  svn_pool_destroy(iterpool);
+
+  *result = stats_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Add the findings of the
+ * stats_result_t in RESULT to the stats_output_baton_t in OUTPUT_BATON. */
+static svn_error_t *
+add_stats_result(void *result,
+                 void *output_baton,
+                 apr_pool_t *scratch_pool)
+{
+  stats_result_t *stats_result = result;
+  stats_output_baton_t *baton = output_baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < stats_result->scans->nelts; ++i)
+    {
+      log_scan_t *scan = APR_ARRAY_IDX(stats_result->scans, i,
+                                       log_scan_t *);
+
+      svn_pool_clear(iterpool);
+      if (stats_result->packed)
+        SVN_ERR(read_log_pack_file(baton->query, scan, scan->base,
+                                   baton->result_pool, iterpool));
+      else
+        SVN_ERR(read_log_revision_file(baton->query, scan, scan->base,
+                                       baton->result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like read_revisions() for logically addressed repositories but with up
+ * to JOBS rev / pack files being scanned concurrently.  The findings are
+ * being added to QUERY strictly in revision order and from the calling
+ * thread only, i.e. the results as well as the progress notifications are
+ * the same as for the sequential code.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_revisions_parallel(query_t *query,
+                            int jobs,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  int revs_per_task = query->shard_size ? query->shard_size
+                                        : REVISIONS_PER_TASK;
+  stats_output_baton_t baton;
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+  svn_revnum_t rev = 0;
+  svn_fs_t *fs;
+
+  /* The main thread keeps using QUERY->FS while the tasks run.
+     Give them a snapshot to open their instances from. */
+  SVN_ERR(svn_fs_fs__open_instance(&fs, query->fs, scratch_pool,
+                                   scratch_pool));
+
+  baton.query = query;
+  baton.result_pool = result_pool;
+
+  set_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, add_stats_result, &baton,
+                               query->cancel_func, query->cancel_baton,
+                               set_pool));
+
+  /* Packed shards come first, followed by the non-packed revisions,
+     at most one shard per task. */
+  while (rev <= query->head)
+    {
+      stats_task_t *task = apr_pcalloc(scratch_pool, sizeof(*task));
+
+      task->fs = fs;
+      task->start_rev = rev;
+      if (rev < query->min_unpacked_rev)
+        {
+          task->count = query->shard_size;
+          task->packed = TRUE;
+        }
+      else
+        {
+          svn_revnum_t end_rev = (rev / revs_per_task + 1) * revs_per_task;
+          if (end_rev > query->head + 1)
+            end_rev = query->head + 1;
+
+          task->count = (int)(end_rev - rev);
+        }
+
+      rev += task->count;
+      SVN_ERR(svn_task__add(set, stats_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the repository and collect the stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
@@ -1193,9 +1593,21 @@ read_revisions(query_t *query,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  fs_fs_data_t *ffd = query->fs->fsap_data;
+  apr_pool_t *iterpool;
   svn_revnum_t revision;
 
+  /* Scan multiple rev / pack files concurrently if we have been asked to.
+   * In phys. addressing mode, we need to follow the DAG through the
+   * previous revisions, so that will always be done sequentially. */
+  if (ffd->stats_jobs > 1 && svn_fs_fs__use_log_addressing(query->fs))
+    return svn_error_trace(read_log_revisions_parallel(query,
+                                                       ffd->stats_jobs,
+                                                       result_pool,
+                                                       scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+
   /* read all packed revs */
   for ( revision = 0
       ; revision < query->min_unpacked_rev
@@ -1204,7 +1616,8 @@ read_revisions(query_t *query,
       svn_pool_clear(iterpool);
 
       if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_pack_file(query, revision, result_pool, iterpool));
+        SVN_ERR(read_log_pack_file(query, NULL, revision, result_pool,
+                                   iterpool));
       else
         SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
     }
@@ -1215,7 +1628,7 @@ read_revisions(query_t *query,
       svn_pool_clear(iterpool);
 
       if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_revision_file(query, revision, result_pool,
+        SVN_ERR(read_log_revision_file(query, NULL, revision, result_pool,
                                        iterpool));
       else
         SVN_ERR(read_phys_revision_file(query, revision, result_pool,
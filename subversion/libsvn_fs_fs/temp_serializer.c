@@ -595,23 +595,35 @@ svn_fs_fs__serialize_properties(void **data,
   apr_hash_index_t *hi;
   svn_stringbuf_t *serialized;
   apr_size_t i;
+  apr_size_t size;
 
   /* create our auxiliary data structure */
   properties.count = apr_hash_count(hash);
   properties.keys = apr_palloc(pool, sizeof(const char*) * (properties.count + 1));
   properties.values = apr_palloc(pool, sizeof(const svn_string_t *) * properties.count);
 
-  /* populate it with the hash entries */
+  /* Populate it with the hash entries while calculating the size of the
+   * serialized data. */
+  size = SVN_TEMP_SERIALIZER__STRUCT_SIZE(sizeof(properties))
+       + SVN_TEMP_SERIALIZER__STRUCT_SIZE(sizeof(const char*)
+                                          * (properties.count + 1))
+       + SVN_TEMP_SERIALIZER__STRUCT_SIZE(sizeof(const svn_string_t *)
+                                          * properties.count)
+       + 1;
   for (hi = apr_hash_first(pool, hash), i=0; hi; hi = apr_hash_next(hi), ++i)
     {
       properties.keys[i] = apr_hash_this_key(hi);
       properties.values[i] = apr_hash_this_val(hi);
+
+      size += apr_hash_this_key_len(hi) + 1
+            + SVN_TEMP_SERIALIZER__STRUCT_SIZE(sizeof(svn_string_t))
+            + SVN_TEMP_SERIALIZER__STRUCT_SIZE(properties.values[i]->len + 1);
     }
 
   /* serialize it */
   context = svn_temp_serializer__init(&properties,
                                       sizeof(properties),
-                                      properties.count * 100,
+                                      size,
                                       pool);
 
   properties.keys[i] = "";
@@ -627,6 +639,55 @@ svn_fs_fs__serialize_properties(void **data,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__extract_property(void **out,
+                            const void *data,
+                            apr_size_t data_len,
+                            void *baton,
+                            apr_pool_t *pool)
+{
+  const properties_data_t *properties = data;
+  const char *name = baton;
+  const char * const *keys;
+  const svn_string_t * const *values;
+  apr_size_t name_len = strlen(name);
+  apr_size_t i;
+
+  /* Navigate the serialized data in-place.  Only the value that we are
+   * looking for gets copied. */
+  keys = svn_temp_deserializer__ptr(properties,
+                                    (const void *const *)&properties->keys);
+  values = svn_temp_deserializer__ptr(properties,
+                                      (const void *const *)&properties->values);
+
+  *out = NULL;
+  for (i = 0; i < properties->count; ++i)
+    {
+      /* Keys are stored back-to-back.  Hence, their offsets tell us
+       * their lengths. */
+      apr_size_t len = (apr_size_t)keys[i+1] - (apr_size_t)keys[i] - 1;
+      const char *key;
+      const svn_string_t *value;
+      const char *value_data;
+
+      if (len != name_len)
+        continue;
+
+      key = svn_temp_deserializer__ptr(keys, (const void *const *)&keys[i]);
+      if (memcmp(key, name, len))
+        continue;
+
+      value = svn_temp_deserializer__ptr(values,
+                                         (const void *const *)&values[i]);
+      value_data = svn_temp_deserializer__ptr(value,
+                                              (const void *const *)&value->data);
+      *out = svn_string_ncreate(value_data, value->len, pool);
+      break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__deserialize_properties(void **out,
                                   void *data,
@@ -682,17 +743,11 @@ svn_fs_fs__deserialize_revprops(void **out,
                                 apr_size_t data_len,
                                 apr_pool_t *pool)
 {
-  apr_hash_t *properties;
-  svn_stream_t *stream;
-
-  svn_string_t buffer;
-  buffer.data = data;
-  buffer.len = data_len;
+  apr_hash_t *properties = svn_hash__make(pool);
 
-  stream = svn_stream_from_string(&buffer, pool);
-  properties = svn_hash__make(pool);
-
-  SVN_ERR(svn_hash_read2(properties, stream, SVN_HASH_TERMINATOR, pool));
+  /* DATA is our private copy, so the keys and values can point into it. */
+  SVN_ERR(svn_hash__parse(properties, data, data_len, SVN_HASH_TERMINATOR,
+                          pool));
 
   /* done */
   *out = properties;
@@ -981,6 +1036,29 @@ svn_fs_fs__extract_dir_entry(void **out,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__extract_dir_chunk(void **out,
+                             const void *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool)
+{
+  const dir_data_t *dir_data = data;
+  const char *name = baton;
+  svn_boolean_t found;
+
+  const svn_fs_dirent_t * const *entries =
+    svn_temp_deserializer__ptr(data, (const void *const *)&dir_data->entries);
+
+  /* The chunk to look in is the last one starting at or before NAME. */
+  apr_size_t pos = find_entry((svn_fs_dirent_t **)entries, name,
+                              dir_data->count, &found);
+
+  *(apr_int64_t *)out = found ? (apr_int64_t)pos : (apr_int64_t)pos - 1;
+
+  return SVN_NO_ERROR;
+}
+
 /* Utility function for svn_fs_fs__replace_dir_entry that implements the
  * modification as a simply deserialize / modify / serialize sequence.
  */
@@ -1317,6 +1395,7 @@ svn_fs_fs__serialize_mergeinfo(void **data,
   unsigned i;
   int k;
   apr_size_t range_count;
+  apr_size_t keys_size;
 
   /* initialize our auxiliary data structure */
   merges.count = apr_hash_count(mergeinfo);
@@ -1328,6 +1407,7 @@ svn_fs_fs__serialize_mergeinfo(void **data,
 
   i = 0;
   range_count = 0;
+  keys_size = 0;
   for (hi = apr_hash_first(pool, mergeinfo); hi; hi = apr_hash_next(hi), ++i)
     {
       svn_rangelist_t *ranges;
@@ -1336,6 +1416,7 @@ svn_fs_fs__serialize_mergeinfo(void **data,
                         (void **)&ranges);
       merges.range_counts[i] = ranges->nelts;
       range_count += ranges->nelts;
+      keys_size += merges.key_lengths[i] + 1;
     }
 
   merges.ranges = apr_palloc(pool, sizeof(*merges.ranges) * range_count);
@@ -1349,10 +1430,20 @@ svn_fs_fs__serialize_mergeinfo(void **data,
     }
 
   /* serialize it and all its elements */
-  context = svn_temp_serializer__init(&merges,
-                                      sizeof(merges),
-                                      range_count * 30,
-                                      pool);
+  context = svn_temp_serializer__init(
+              &merges,
+              sizeof(merges),
+              SVN_TEMP_SERIALIZER__STRUCT_SIZE(sizeof(merges))
+              + SVN_TEMP_SERIALIZER__STRUCT_SIZE(merges.count
+                                                 * sizeof(*merges.keys))
+              + keys_size
+              + SVN_TEMP_SERIALIZER__STRUCT_SIZE(merges.count
+                                                 * sizeof(*merges.key_lengths))
+              + SVN_TEMP_SERIALIZER__STRUCT_SIZE(merges.count
+                                                 * sizeof(*merges.range_counts))
+              + SVN_TEMP_SERIALIZER__STRUCT_SIZE(range_count
+                                                 * sizeof(*merges.ranges)),
+              pool);
 
   /* keys array */
   svn_temp_serializer__push(context,
@@ -155,6 +155,19 @@ svn_fs_fs__deserialize_properties(void **out,
                                   apr_size_t data_len,
                                   apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for a single property
+ * within a serialized properties hash, identified by its name in
+ * (const char *) @a baton.  Set (svn_string_t *) @a *out to a copy of
+ * its value or to @c NULL if there is no such property.
+ */
+svn_error_t *
+svn_fs_fs__extract_property(void **out,
+                            const void *data,
+                            apr_size_t data_len,
+                            void *baton,
+                            apr_pool_t *pool);
+
 /**
  * Implements #svn_cache__serialize_func_t for a properties hash
  * (@a in is an #apr_hash_t of svn_string_t elements, keyed by const char*).
@@ -297,6 +310,20 @@ svn_fs_fs__extract_dir_entry(void **out,
                              void *baton,
                              apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for the chunk index of a
+ * large directory, i.e. a serialized directory whose entries are the
+ * first entries of each chunk of the actual directory.  Set
+ * (apr_int64_t) @a *out to the number of the chunk that may contain the
+ * entry called (const char *) @a *baton, or to -1 if no chunk can.
+ */
+svn_error_t *
+svn_fs_fs__extract_dir_chunk(void **out,
+                             const void *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool);
+
 /**
  * Describes the change to be done to a directory: Set the entry
  * identify by @a name to the value @a new_entry. If the latter is
@@ -42,6 +42,9 @@
 #include "cached_data.h"
 #include "lock.h"
 #include "rep-cache.h"
+#include "batch_fsync.h"
+#include "mergeinfo-index.h"
+#include "warmup.h"
 
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
@@ -820,8 +823,104 @@ typedef struct process_changes_baton_t
      replacements.  If those replacements get deleted again, this
      container contains the record that we have to revert to. */
   apr_hash_t *deletions;
+
+  /* Maps the paths of directories (without trailing '/') to hashes of
+     their immediate sub-paths that either have an entry in CHANGED_PATHS
+     or are listed in SUB_PATHS themselves.  The sub-paths are given with
+     the keys exactly as used in CHANGED_PATHS.  This lets us find all
+     changes below a deleted path without scanning all changes.  Entries
+     may be stale, i.e. the changes may have been folded away since. */
+  apr_hash_t *sub_paths;
 } process_changes_baton_t;
 
+/* Return the length of PATH of length LEN without trailing '/',
+   unless PATH is the root. */
+static apr_size_t
+strip_trailing_slashes(const char *path,
+                       apr_size_t len)
+{
+  while (len > 1 && path[len - 1] == '/')
+    --len;
+
+  return len;
+}
+
+/* Record in BATON->SUB_PATHS that there is an entry for PATH of length
+   LEN in BATON->CHANGED_PATHS. */
+static void
+add_sub_path(process_changes_baton_t *baton,
+             const char *path,
+             apr_size_t len)
+{
+  apr_pool_t *pool = apr_hash_pool_get(baton->sub_paths);
+  const char *key = path;
+  apr_size_t key_len = len;
+
+  /* Add KEY to the sub-path list of its parent.  Continue with the parent
+     unless that one already had a list, i.e. is already known to its own
+     parent. */
+  while (TRUE)
+    {
+      apr_hash_t *children;
+      const char *child;
+      apr_size_t parent_len = strip_trailing_slashes(key, key_len);
+
+      /* Find the parent.  Stop at the root (and at relative paths). */
+      if (parent_len <= 1)
+        return;
+
+      while (parent_len > 0 && key[parent_len - 1] != '/')
+        --parent_len;
+      if (parent_len == 0)
+        return;
+
+      parent_len = strip_trailing_slashes(key, parent_len);
+      children = apr_hash_get(baton->sub_paths, key, parent_len);
+      if (children && apr_hash_get(children, key, key_len))
+        return;
+
+      child = apr_pstrmemdup(pool, key, key_len);
+      if (children)
+        {
+          apr_hash_set(children, child, key_len, child);
+          return;
+        }
+
+      children = apr_hash_make(pool);
+      apr_hash_set(children, child, key_len, child);
+
+      key = apr_pstrmemdup(pool, key, parent_len);
+      key_len = parent_len;
+      apr_hash_set(baton->sub_paths, key, key_len, children);
+    }
+}
+
+/* Remove all entries for paths below PATH of length LEN from
+   BATON->CHANGED_PATHS and BATON->SUB_PATHS. */
+static void
+remove_sub_paths(process_changes_baton_t *baton,
+                 const char *path,
+                 apr_size_t len)
+{
+  apr_hash_index_t *hi;
+  apr_hash_t *children;
+
+  len = strip_trailing_slashes(path, len);
+  children = apr_hash_get(baton->sub_paths, path, len);
+  if (!children)
+    return;
+
+  apr_hash_set(baton->sub_paths, path, len, NULL);
+  for (hi = apr_hash_first(NULL, children); hi; hi = apr_hash_next(hi))
+    {
+      const char *child = apr_hash_this_key(hi);
+      apr_ssize_t child_len = apr_hash_this_key_len(hi);
+
+      apr_hash_set(baton->changed_paths, child, child_len, NULL);
+      remove_sub_paths(baton, child, child_len);
+    }
+}
+
 /* An implementation of svn_fs_fs__change_receiver_t.
    Examine all the changed path entries in CHANGES and store them in
    *CHANGED_PATHS.  Folding is done to remove redundant or unnecessary
@@ -833,63 +932,22 @@ process_changes(void *baton_p,
 {
   process_changes_baton_t *baton = baton_p;
 
+  const svn_string_t *path = &change->path;
+
   SVN_ERR(fold_change(baton->changed_paths, baton->deletions, change));
 
   /* Now, if our change was a deletion or replacement, we have to
      blow away any changes thus far on paths that are (or, were)
-     children of this path.
-     ### i won't bother with another iteration pool here -- at
-     most we talking about a few extra dups of paths into what
-     is already a temporary subpool.
-  */
-
+     children of this path.  Thanks to SUB_PATHS, this takes time
+     proportional to the number of changes removed instead of the
+     number of all changes, which can be huge during e.g. loads. */
   if ((change->info.change_kind == svn_fs_path_change_delete)
        || (change->info.change_kind == svn_fs_path_change_replace))
-    {
-      apr_hash_index_t *hi;
-
-      /* a potential child path must contain at least 2 more chars
-         (the path separator plus at least one char for the name).
-         Also, we should not assume that all paths have been normalized
-         i.e. some might have trailing path separators.
-      */
-      apr_ssize_t path_len = change->path.len;
-      apr_ssize_t min_child_len = path_len == 0
-                                ? 1
-                                : change->path.data[path_len-1] == '/'
-                                    ? path_len + 1
-                                    : path_len + 2;
-
-      /* CAUTION: This is the inner loop of an O(n^2) algorithm.
-         The number of changes to process may be >> 1000.
-         Therefore, keep the inner loop as tight as possible.
-      */
-      for (hi = apr_hash_first(scratch_pool, baton->changed_paths);
-           hi;
-           hi = apr_hash_next(hi))
-        {
-          /* KEY is the path. */
-          const void *path;
-          apr_ssize_t klen;
-          svn_fs_path_change2_t *old_change;
-          apr_hash_this(hi, &path, &klen, (void**)&old_change);
-
-          /* If we come across a child of our path, remove it.
-             Call svn_fspath__skip_ancestor only if there is a chance that
-             this is actually a sub-path.
-           */
-          if (klen >= min_child_len)
-            {
-              const char *child;
+    remove_sub_paths(baton, path->data, path->len);
 
-              child = svn_fspath__skip_ancestor(change->path.data, path);
-              if (child && child[0] != '\0')
-                {
-                  apr_hash_set(baton->changed_paths, path, klen, NULL);
-                }
-            }
-        }
-    }
+  /* Remember where to find the new or modified entry. */
+  if (apr_hash_get(baton->changed_paths, path->data, path->len))
+    add_sub_path(baton, path->data, path->len);
 
   return SVN_NO_ERROR;
 }
@@ -907,6 +965,7 @@ svn_fs_fs__txn_changes_fetch(apr_hash_t **changed_paths_p,
 
   baton.changed_paths = changed_paths;
   baton.deletions = apr_hash_make(scratch_pool);
+  baton.sub_paths = apr_hash_make(scratch_pool);
 
   SVN_ERR(svn_io_file_open(&file,
                            path_txn_changes(fs, txn_id, scratch_pool),
@@ -999,6 +1058,13 @@ create_new_txn_noderev_from_rev(svn_fs_t *fs,
   return svn_fs_fs__put_node_revision(fs, noderev->id, noderev, TRUE, pool);
 }
 
+/* Number of transaction numbers to reserve per update of the txn-current
+   file.  Those not used immediately will be handed out to subsequent
+   transactions created by this process, saving the file update - which
+   includes an fsync - for each of them.  Unused numbers are simply lost
+   when the process ends, leaving gaps in the sequence. */
+#define TXN_NUMBER_RESERVATION 16
+
 /* A structure used by get_and_increment_txn_key_body(). */
 struct get_and_increment_txn_key_baton {
   svn_fs_t *fs;
@@ -1006,6 +1072,49 @@ struct get_and_increment_txn_key_baton {
   apr_pool_t *pool;
 };
 
+/* If FS's shared data contains an unused, reserved transaction number,
+   remove it from there and return it in *TXN_NUMBER.  Set *FOUND to
+   indicate whether we found one.  The caller must hold the
+   TXN_NUMBERS_LOCK. */
+static svn_error_t *
+take_reserved_txn_number(apr_uint64_t *txn_number,
+                         svn_boolean_t *found,
+                         svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+
+  /* Naively copied repositories share the same shared data but each has
+     its own txn-current file. */
+  *found = ffsd->next_txn_number < ffsd->txn_numbers_end
+        && strcmp(ffsd->txn_numbers_path, fs->path) == 0;
+  if (*found)
+    *txn_number = ffsd->next_txn_number++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the transaction numbers from FIRST up to but excluding END as
+   reserved for FS in FS's shared data.  The caller must hold the
+   TXN_NUMBERS_LOCK. */
+static svn_error_t *
+reserve_txn_numbers(svn_fs_t *fs,
+                    apr_uint64_t first,
+                    apr_uint64_t end)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+
+  if (   ffsd->txn_numbers_path == NULL
+      || strcmp(ffsd->txn_numbers_path, fs->path) != 0)
+    ffsd->txn_numbers_path = apr_pstrdup(ffsd->common_pool, fs->path);
+
+  ffsd->next_txn_number = first;
+  ffsd->txn_numbers_end = end;
+
+  return SVN_NO_ERROR;
+}
+
 /* Callback used in the implementation of create_txn_dir().  This gets
    the current base 36 value in PATH_TXN_CURRENT and increments it.
    It returns the original value by the baton. */
@@ -1026,7 +1135,8 @@ get_and_increment_txn_key_body(void *baton, apr_pool_t *pool)
   cb->txn_number = svn__base36toui64(NULL, buf->data);
 
   /* remove trailing newlines */
-  line_length = svn__ui64tobase36(new_id_str, cb->txn_number+1);
+  line_length = svn__ui64tobase36(new_id_str,
+                                  cb->txn_number + TXN_NUMBER_RESERVATION);
   new_id_str[line_length] = '\n';
 
   /* Increment the key and add a trailing \n to the string so the
@@ -1036,6 +1146,12 @@ get_and_increment_txn_key_body(void *baton, apr_pool_t *pool)
                                txn_current_filename /* copy_perms path */,
                                ffd->flush_to_disk, pool));
 
+  /* Keep the numbers that we don't use right now for later. */
+  SVN_MUTEX__WITH_LOCK(ffd->shared->txn_numbers_lock,
+                       reserve_txn_numbers(cb->fs, cb->txn_number + 1,
+                                           cb->txn_number
+                                             + TXN_NUMBER_RESERVATION));
+
   return SVN_NO_ERROR;
 }
 
@@ -1049,19 +1165,28 @@ create_txn_dir(const char **id_p,
                svn_revnum_t rev,
                apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct get_and_increment_txn_key_baton cb;
   const char *txn_dir;
+  svn_boolean_t found;
 
-  /* Get the current transaction sequence value, which is a base-36
-     number, from the txn-current file, and write an
+  /* Use a transaction number that we reserved earlier, if any.
+     Otherwise, get the current transaction sequence value, which is a
+     base-36 number, from the txn-current file, and write an
      incremented value back out to the file.  Place the revision
      number the transaction is based off into the transaction id. */
-  cb.pool = pool;
-  cb.fs = fs;
-  SVN_ERR(svn_fs_fs__with_txn_current_lock(fs,
-                                           get_and_increment_txn_key_body,
-                                           &cb,
-                                           pool));
+  SVN_MUTEX__WITH_LOCK(ffd->shared->txn_numbers_lock,
+                       take_reserved_txn_number(&cb.txn_number, &found, fs));
+  if (!found)
+    {
+      cb.pool = pool;
+      cb.fs = fs;
+      SVN_ERR(svn_fs_fs__with_txn_current_lock(fs,
+                                               get_and_increment_txn_key_body,
+                                               &cb,
+                                               pool));
+    }
+
   txn_id->revision = rev;
   txn_id->number = cb.txn_number;
 
@@ -2169,7 +2294,12 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2184,8 +2314,10 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
       svndiff_version = 0;
     }
 
-  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
-                          ffd->delta_compression_level, pool);
+  svn_txdelta_to_svndiff_parallel(handler, handler_baton, output,
+                                  svndiff_version,
+                                  ffd->delta_compression_level,
+                                  ffd->delta_compression_threads, pool);
 }
 
 /* Get a rep_write_baton and store it in *WB_P for the representation
@@ -3475,31 +3607,76 @@ verify_before_commit(svn_fs_t *fs,
 
 /* Update the 'current' file to hold the correct next node and copy_ids
    from transaction TXN_ID in filesystem FS.  The current revision is
-   set to REV.  Perform temporary allocations in POOL. */
+   set to REV.  Flush the new file to disk if FS is configured to do so.
+
+   If DEFER_RENAME_SYNC is set, the contents of the new file still get
+   flushed to disk before it replaces 'current' but the rename itself is
+   not; the caller must do that later through flush_current().  A crash
+   in between leaves either the old or the new, complete 'current' file
+   and since the revision contents have been flushed before, both refer
+   to durable data only.
+
+   Perform temporary allocations in POOL. */
 static svn_error_t *
 write_final_current(svn_fs_t *fs,
                     const svn_fs_fs__id_part_t *txn_id,
                     svn_revnum_t rev,
                     apr_uint64_t start_node_id,
                     apr_uint64_t start_copy_id,
+                    svn_boolean_t defer_rename_sync,
                     apr_pool_t *pool)
 {
   apr_uint64_t txn_node_id;
   apr_uint64_t txn_copy_id;
   fs_fs_data_t *ffd = fs->fsap_data;
+  const char *name = svn_fs_fs__path_current(fs, pool);
+  const char *buf;
+  apr_file_t *tmp_file;
+  const char *tmp_path;
+  svn_error_t *err;
 
   if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    return svn_fs_fs__write_current(fs, rev, 0, 0, pool);
+    {
+      buf = svn_fs_fs__unparse_current(fs, rev, 0, 0, pool);
+    }
+  else
+    {
+      /* To find the next available ids, we add the id that used to be in
+         the 'current' file, to the next ids from the transaction file. */
+      SVN_ERR(read_next_ids(&txn_node_id, &txn_copy_id, fs, txn_id, pool));
 
-  /* To find the next available ids, we add the id that used to be in
-     the 'current' file, to the next ids from the transaction file. */
-  SVN_ERR(read_next_ids(&txn_node_id, &txn_copy_id, fs, txn_id, pool));
+      start_node_id += txn_node_id;
+      start_copy_id += txn_copy_id;
 
-  start_node_id += txn_node_id;
-  start_copy_id += txn_copy_id;
+      buf = svn_fs_fs__unparse_current(fs, rev, start_node_id,
+                                       start_copy_id, pool);
+    }
+
+  if (!defer_rename_sync)
+    return svn_error_trace(svn_io_write_atomic2(name, buf, strlen(buf),
+                                                name /* copy_perms_path */,
+                                                ffd->flush_to_disk, pool));
+
+  /* Same as svn_io_write_atomic2() but without syncing the rename. */
+  SVN_ERR(svn_io_open_unique_file3(&tmp_file, &tmp_path,
+                                   svn_dirent_dirname(name, pool),
+                                   svn_io_file_del_none, pool, pool));
+
+  err = svn_io_file_write_full(tmp_file, buf, strlen(buf), NULL, pool);
+  if (!err)
+    err = svn_io_file_flush_to_disk(tmp_file, pool);
+  err = svn_error_compose_create(err, svn_io_file_close(tmp_file, pool));
+
+  if (!err)
+    err = svn_io_copy_perms(name, tmp_path, pool);
+  if (!err)
+    err = svn_io_file_rename2(tmp_path, name, FALSE, pool);
+
+  if (err)
+    err = svn_error_compose_create(err, svn_io_remove_file2(tmp_path, TRUE,
+                                                            pool));
 
-  return svn_fs_fs__write_current(fs, rev, start_node_id, start_copy_id,
-                                  pool);
+  return svn_error_trace(err);
 }
 
 /* Verify that the user registered with FS has all the locks necessary to
@@ -3575,13 +3752,14 @@ verify_locks(svn_fs_t *fs,
 }
 
 /* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   from file PERMS_REFERENCE and schedule the necessary fsync calls in
+   BATCH. This involves setting svn:date and removing any temporary
+   properties associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3611,20 +3789,17 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate any existing file, since file
+     may already exists from failed transaction.  BATCH owns the file
+     handle and will close it. */
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&revprop_file, batch, path,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
-
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
   return SVN_NO_ERROR;
@@ -3706,6 +3881,197 @@ promote_cached_directories(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Record in SHARED that the 'current' file has been bumped to REVISION
+ * but not been flushed to disk, yet.  The caller must hold the
+ * GROUP_COMMIT_LOCK. */
+static svn_error_t *
+note_unflushed_current(fs_fs_shared_data_t *shared,
+                       svn_revnum_t revision)
+{
+  shared->group_commit_written = MAX(shared->group_commit_written, revision);
+
+  return SVN_NO_ERROR;
+}
+
+/* Flush the 'current' file of FS as well as its directory entry to disk.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+flush_current(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__batch_fsync_t *batch;
+  apr_file_t *file;
+  const char *path = svn_fs_fs__path_current(fs, scratch_pool);
+
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, TRUE, scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, path,
+                                           scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, path, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__batch_fsync_run(batch, scratch_pool));
+}
+
+/* Return once the 'current' file of FS has been flushed to disk for at
+ * least REVISION.  Whichever thread comes first performs the flush on
+ * behalf of all revisions committed so far; all others that are covered
+ * by it simply wait for it to finish.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+wait_for_durable_current(svn_fs_t *fs,
+                         svn_revnum_t revision,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *shared = ffd->shared;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(shared->group_commit_lock));
+  while (!err && shared->group_commit_synced < revision)
+    {
+      if (shared->group_commit_running)
+        {
+#if APR_HAS_THREADS
+          apr_status_t status
+            = apr_thread_cond_wait(shared->group_commit_cond,
+                                   svn_mutex__get(shared->group_commit_lock));
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't wait for condition variable"));
+#endif
+        }
+      else
+        {
+          /* Everything written up to now will be covered by our flush. */
+          svn_revnum_t target = shared->group_commit_written;
+          svn_error_t *lock_err;
+#if APR_HAS_THREADS
+          apr_status_t status;
+#endif
+
+          shared->group_commit_running = TRUE;
+          SVN_ERR(svn_mutex__unlock(shared->group_commit_lock,
+                                    SVN_NO_ERROR));
+
+          err = flush_current(fs, scratch_pool);
+
+          lock_err = svn_mutex__lock(shared->group_commit_lock);
+          if (lock_err)
+            return svn_error_compose_create(err, lock_err);
+
+          shared->group_commit_running = FALSE;
+          if (!err)
+            shared->group_commit_synced = MAX(shared->group_commit_synced,
+                                              target);
+
+          /* Wake up those covered by this flush as well as all that need
+             to start another one. */
+#if APR_HAS_THREADS
+          status = apr_thread_cond_broadcast(shared->group_commit_cond);
+          if (status && !err)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't broadcast condition variable"));
+#endif
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(shared->group_commit_lock, err));
+}
+
+/* Write the final contents of the revision NEW_REV into PROTO_FILE,
+   the writable proto-rev file of transaction TXN_ID in FS: all node-
+   revisions and directory contents, the changed-path information
+   CHANGED_PATHS as well as the index data resp. the revision trailer.
+   INITIAL_OFFSET is the current end of PROTO_FILE.  START_NODE_ID,
+   START_COPY_ID, DIRECTORY_IDS, REPS_TO_CACHE, REPS_HASH and REPS_POOL
+   are passed through to write_final_rev().  Use POOL for allocations. */
+static svn_error_t *
+write_final_proto_rev(apr_file_t *proto_file,
+                      svn_revnum_t new_rev,
+                      svn_fs_t *fs,
+                      const svn_fs_fs__id_part_t *txn_id,
+                      apr_uint64_t start_node_id,
+                      apr_uint64_t start_copy_id,
+                      apr_off_t initial_offset,
+                      apr_hash_t *changed_paths,
+                      apr_array_header_t *directory_ids,
+                      apr_array_header_t *reps_to_cache,
+                      apr_hash_t *reps_hash,
+                      apr_pool_t *reps_pool,
+                      apr_pool_t *pool)
+{
+  const svn_fs_id_t *root_id, *new_root_id;
+  apr_off_t changed_path_offset;
+
+  /* Write out all the node-revisions and directory contents. */
+  root_id = svn_fs_fs__id_txn_create_root(txn_id, pool);
+  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, fs, root_id,
+                          start_node_id, start_copy_id, initial_offset,
+                          directory_ids, reps_to_cache, reps_hash,
+                          reps_pool, TRUE, pool));
+
+  /* Write the changed-path information. */
+  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
+                                        fs, txn_id, changed_paths, pool));
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      /* Append the index data to the rev file. */
+      SVN_ERR(svn_fs_fs__add_index_data(fs, proto_file,
+                      svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool),
+                      svn_fs_fs__path_p2l_proto_index(fs, txn_id, pool),
+                      new_rev, pool));
+    }
+  else
+    {
+      /* Write the final line. */
+
+      svn_stringbuf_t *trailer
+        = svn_fs_fs__unparse_revision_trailer
+                  ((apr_off_t)svn_fs_fs__id_item(new_root_id),
+                   changed_path_offset,
+                   pool);
+      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
+                                     NULL, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* A revision that svn_fs_fs__commit() wrote into the proto-rev file
+   before acquiring the repository write lock, together with everything
+   needed to either finish or undo that work. */
+typedef struct prepared_commit_t
+{
+  /* The revision number the proto-rev file contents have been written
+     for and the repository format at that time. */
+  svn_revnum_t new_rev;
+  int format;
+
+  /* Lock cookie of the proto-rev file, which stays locked until the
+     commit has either been completed or rolled back. */
+  void *lockcookie;
+
+  /* The txn's changed paths, as written to the proto-rev file. */
+  apr_hash_t *changed_paths;
+
+  /* Directories put into the DIR_CACHE while writing the proto-rev. */
+  apr_array_header_t *directory_ids;
+
+  /* Original sizes of the proto-rev file and the proto-index files.
+     -1 for any file that did not exist before. */
+  apr_off_t proto_rev_size;
+  apr_off_t l2p_proto_index_size;
+  apr_off_t p2l_proto_index_size;
+
+  /* Original contents of the txn's item index counter file.  NULL if
+     that file did not exist before. */
+  svn_stringbuf_t *item_index;
+
+  /* Set once the proto-rev file has been moved into place, i.e. when
+     the preparation can no longer be undone. */
+  svn_boolean_t consumed;
+} prepared_commit_t;
+
 /* Baton used for commit_body below. */
 struct commit_baton {
   svn_revnum_t *new_rev_p;
@@ -3714,8 +4080,200 @@ struct commit_baton {
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
+
+  /* If not NULL, the final revision has already been written to the
+     proto-rev file outside the write lock. */
+  prepared_commit_t *prepared;
 };
 
+/* Set *SIZE to the size of the file at PATH or to -1 if it does not
+   exist.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_file_size(apr_off_t *size,
+              const char *path,
+              apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err = svn_io_stat(&finfo, path, APR_FINFO_SIZE, scratch_pool);
+
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *size = -1;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(err);
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Truncate the file at PATH to SIZE, as returned by get_file_size().
+   Remove it, if SIZE is -1.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+restore_file_size(const char *path,
+                  apr_off_t size,
+                  apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+
+  if (size < 0)
+    return svn_error_trace(svn_io_remove_file2(path, TRUE, scratch_pool));
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_WRITE, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_trunc(file, size, scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Undo everything that prepare_commit() did for CB->PREPARED, i.e. restore
+   the transaction's proto-rev, proto-index and item index files, forget
+   about any reps collected for the rep-cache and unlock the proto-rev file.
+   Reset CB->PREPARED to NULL.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+rollback_prepared_commit(struct commit_baton *cb,
+                         apr_pool_t *scratch_pool)
+{
+  prepared_commit_t *prepared = cb->prepared;
+  svn_fs_t *fs = cb->fs;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(prepared && !prepared->consumed);
+  cb->prepared = NULL;
+
+  err = restore_file_size(svn_fs_fs__path_txn_proto_rev(fs, txn_id,
+                                                        scratch_pool),
+                          prepared->proto_rev_size, scratch_pool);
+
+  if (!err && svn_fs_fs__use_log_addressing(fs))
+    {
+      err = restore_file_size(svn_fs_fs__path_l2p_proto_index(fs, txn_id,
+                                                              scratch_pool),
+                              prepared->l2p_proto_index_size, scratch_pool);
+      if (!err)
+        err = restore_file_size(
+                svn_fs_fs__path_p2l_proto_index(fs, txn_id, scratch_pool),
+                prepared->p2l_proto_index_size, scratch_pool);
+      if (!err)
+        {
+          const char *path = svn_fs_fs__path_txn_item_index(fs, txn_id,
+                                                            scratch_pool);
+          if (prepared->item_index)
+            err = svn_io_write_atomic2(path, prepared->item_index->data,
+                                       prepared->item_index->len, NULL,
+                                       FALSE, scratch_pool);
+          else
+            err = svn_io_remove_file2(path, TRUE, scratch_pool);
+        }
+    }
+
+  /* None of the reps written for the prepared revision will exist. */
+  if (cb->reps_to_cache)
+    apr_array_clear(cb->reps_to_cache);
+  if (cb->reps_hash)
+    apr_hash_clear(cb->reps_hash);
+
+  /* Always release the proto-rev lock. */
+  return svn_error_compose_create(err,
+                                  unlock_proto_rev(fs, txn_id,
+                                                   prepared->lockcookie,
+                                                   scratch_pool));
+}
+
+/* If optimistic commits are enabled for CB->FS and CB->TXN is based on
+   the youngest revision, write the final revision into the txn's proto-
+   rev file before we acquire the write lock and set CB->PREPARED.
+   commit_body() will then only need to check that the txn is still up
+   to date and move the result into place.  Otherwise, set CB->PREPARED
+   to NULL.  Allocate the result as well as temporaries in POOL. */
+static svn_error_t *
+prepare_commit(struct commit_baton *cb,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs = cb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  prepared_commit_t *prepared;
+  svn_revnum_t youngest;
+  apr_file_t *proto_file;
+  svn_error_t *err;
+
+  cb->prepared = NULL;
+
+  /* Older formats need the global node and copy ID counters from
+     'current' to finalize the IDs, which we can't know without the lock.
+   */
+  if (!ffd->optimistic_commit
+      || ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return SVN_NO_ERROR;
+
+  /* An out-of-date txn will be rejected by commit_body() anyway. */
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, pool));
+  if (cb->txn->base_rev != youngest)
+    return SVN_NO_ERROR;
+
+  prepared = apr_pcalloc(pool, sizeof(*prepared));
+  prepared->new_rev = youngest + 1;
+  prepared->format = ffd->format;
+  prepared->directory_ids = apr_array_make(pool, 4, sizeof(pair_cache_key_t));
+  SVN_ERR(svn_fs_fs__txn_changes_fetch(&prepared->changed_paths, fs, txn_id,
+                                       pool));
+
+  /* Remember the state of all files that we are going to modify. */
+  SVN_ERR(get_writable_proto_rev(&proto_file, &prepared->lockcookie,
+                                 fs, txn_id, pool));
+  err = svn_io_file_get_offset(&prepared->proto_rev_size, proto_file, pool);
+  if (!err && svn_fs_fs__use_log_addressing(fs))
+    {
+      err = get_file_size(&prepared->l2p_proto_index_size,
+                          svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool),
+                          pool);
+      if (!err)
+        err = get_file_size(&prepared->p2l_proto_index_size,
+                            svn_fs_fs__path_p2l_proto_index(fs, txn_id,
+                                                            pool),
+                            pool);
+      if (!err)
+        {
+          err = svn_stringbuf_from_file2(&prepared->item_index,
+                          svn_fs_fs__path_txn_item_index(fs, txn_id, pool),
+                          pool);
+          if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+            {
+              svn_error_clear(err);
+              err = SVN_NO_ERROR;
+              prepared->item_index = NULL;
+            }
+        }
+    }
+
+  if (err)
+    {
+      svn_error_clear(svn_io_file_close(proto_file, pool));
+      return svn_error_compose_create(err,
+                                      unlock_proto_rev(fs, txn_id,
+                                                       prepared->lockcookie,
+                                                       pool));
+    }
+
+  /* From here on, any failure must be rolled back. */
+  cb->prepared = prepared;
+  err = write_final_proto_rev(proto_file, prepared->new_rev, fs, txn_id,
+                              0, 0, prepared->proto_rev_size,
+                              prepared->changed_paths,
+                              prepared->directory_ids, cb->reps_to_cache,
+                              cb->reps_hash, cb->reps_pool, pool);
+  err = svn_error_compose_create(err, svn_io_file_close(proto_file, pool));
+  if (err)
+    return svn_error_compose_create(err,
+                                    rollback_prepared_commit(cb, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The work-horse for svn_fs_fs__commit, called with the FS write lock.
    This implements the svn_fs_fs__with_write_lock() 'body' callback
    type.  BATON is a 'struct commit_baton *'. */
@@ -3726,17 +4284,16 @@ commit_body(void *baton, apr_pool_t *pool)
   fs_fs_data_t *ffd = cb->fs->fsap_data;
   const char *old_rev_filename, *rev_filename, *proto_filename;
   const char *revprop_filename;
-  const svn_fs_id_t *root_id, *new_root_id;
   apr_uint64_t start_node_id;
   apr_uint64_t start_copy_id;
   svn_revnum_t old_rev, new_rev;
-  apr_file_t *proto_file;
   void *proto_file_lockcookie;
-  apr_off_t initial_offset, changed_path_offset;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
-  apr_array_header_t *directory_ids = apr_array_make(pool, 4,
-                                                     sizeof(pair_cache_key_t));
+  apr_array_header_t *directory_ids;
+  svn_fs_fs__batch_fsync_t *batch;
+  apr_file_t *rev_file;
+  svn_boolean_t defer_current_flush;
 
   /* Re-Read the current repository format.  All our repo upgrade and
      config evaluation strategies are such that existing information in
@@ -3754,6 +4311,11 @@ commit_body(void *baton, apr_pool_t *pool)
    */
   SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
 
+  /* A revision prepared before the upgrade may use the wrong addressing
+     mode.  Start over in that case. */
+  if (cb->prepared && cb->prepared->format != ffd->format)
+    SVN_ERR(rollback_prepared_commit(cb, pool));
+
   /* Read the current youngest revision and, possibly, the next available
      node id and copy id (for old format filesystems).  Update the cached
      value for the youngest revision, because we have just checked it. */
@@ -3769,8 +4331,11 @@ commit_body(void *baton, apr_pool_t *pool)
 
   /* We need the changes list for verification as well as for writing it
      to the final rev file. */
-  SVN_ERR(svn_fs_fs__txn_changes_fetch(&changed_paths, cb->fs, txn_id,
-                                       pool));
+  if (cb->prepared)
+    changed_paths = cb->prepared->changed_paths;
+  else
+    SVN_ERR(svn_fs_fs__txn_changes_fetch(&changed_paths, cb->fs, txn_id,
+                                         pool));
 
   /* Locks may have been added (or stolen) between the calling of
      previous svn_fs.h functions and svn_fs_commit_txn(), so we need
@@ -3781,47 +4346,37 @@ commit_body(void *baton, apr_pool_t *pool)
   /* We are going to be one better than this puny old revision. */
   new_rev = old_rev + 1;
 
-  /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
-                                 cb->fs, txn_id, pool));
-  SVN_ERR(svn_io_file_get_offset(&initial_offset, proto_file, pool));
-
-  /* Write out all the node-revisions and directory contents. */
-  root_id = svn_fs_fs__id_txn_create_root(txn_id, pool);
-  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
-                          start_node_id, start_copy_id, initial_offset,
-                          directory_ids, cb->reps_to_cache, cb->reps_hash,
-                          cb->reps_pool, TRUE, pool));
-
-  /* Write the changed-path information. */
-  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
-                                        cb->fs, txn_id, changed_paths,
-                                        pool));
-
-  if (svn_fs_fs__use_log_addressing(cb->fs))
+  if (cb->prepared)
     {
-      /* Append the index data to the rev file. */
-      SVN_ERR(svn_fs_fs__add_index_data(cb->fs, proto_file,
-                      svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, pool),
-                      svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, pool),
-                      new_rev, pool));
+      /* The txn is based on OLD_REV, hence it has been prepared for
+         NEW_REV and the proto-rev file is complete. */
+      SVN_ERR_ASSERT(cb->prepared->new_rev == new_rev);
+      proto_file_lockcookie = cb->prepared->lockcookie;
+      directory_ids = cb->prepared->directory_ids;
     }
   else
     {
-      /* Write the final line. */
-
-      svn_stringbuf_t *trailer
-        = svn_fs_fs__unparse_revision_trailer
-                  ((apr_off_t)svn_fs_fs__id_item(new_root_id),
-                   changed_path_offset,
-                   pool);
-      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
-                                     NULL, pool));
+      apr_file_t *proto_file;
+      apr_off_t initial_offset;
+
+      directory_ids = apr_array_make(pool, 4, sizeof(pair_cache_key_t));
+
+      /* Get a write handle on the proto revision file. */
+      SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
+                                     cb->fs, txn_id, pool));
+      SVN_ERR(svn_io_file_get_offset(&initial_offset, proto_file, pool));
+
+      SVN_ERR(write_final_proto_rev(proto_file, new_rev, cb->fs, txn_id,
+                                    start_node_id, start_copy_id,
+                                    initial_offset, changed_paths,
+                                    directory_ids, cb->reps_to_cache,
+                                    cb->reps_hash, cb->reps_pool, pool));
+      SVN_ERR(svn_io_file_close(proto_file, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
-  SVN_ERR(svn_io_file_close(proto_file, pool));
+  /* Collect all files and directories that we are about to touch, such
+     that they can be flushed to disk at once before we bump 'current'. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
      race with another caller writing to the prototype revision file
@@ -3845,6 +4400,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3861,6 +4417,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3872,9 +4429,17 @@ commit_body(void *baton, apr_pool_t *pool)
   old_rev_filename = svn_fs_fs__path_rev_absolute(cb->fs, old_rev, pool);
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
+
+  /* Keep the file writable for now, so BATCH can open it.  The final
+     permissions are applied once it has been scheduled for fsync. */
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     proto_filename, FALSE, pool));
+  if (cb->prepared)
+    cb->prepared->consumed = TRUE;
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, rev_filename, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&rev_file, batch, rev_filename,
+                                           pool));
+  SVN_ERR(svn_io_copy_perms(old_rev_filename, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3886,7 +4451,11 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
+
+  /* Write all revision data to disk before we bump 'current'.  This is
+     a single, concurrently executed fsync barrier for all of them. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3894,9 +4463,19 @@ commit_body(void *baton, apr_pool_t *pool)
       SVN_ERR(verify_before_commit(cb->fs, new_rev, pool));
     }
 
-  /* Update the 'current' file. */
+  /* Update the 'current' file.  In group commit mode, syncing the rename
+     will be done by svn_fs_fs__commit() after we released the write lock,
+     which allows concurrent commits to share it. */
+  defer_current_flush = ffd->group_commit && ffd->flush_to_disk;
   SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
-                              start_copy_id, pool));
+                              start_copy_id, defer_current_flush, pool));
+  if (defer_current_flush)
+    SVN_MUTEX__WITH_LOCK(ffd->shared->group_commit_lock,
+                         note_unflushed_current(ffd->shared, new_rev));
+
+  /* Remember what svn_fs_fs__sync() will have to flush. */
+  if (!ffd->flush_to_disk && !SVN_IS_VALID_REVNUM(ffd->unsynced_rev))
+    ffd->unsynced_rev = new_rev;
 
   /* At this point the new revision is committed and globally visible
      so let the caller know it succeeded by giving it the new revision
@@ -3917,25 +4496,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -3944,6 +4504,7 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 {
   struct commit_baton cb;
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
 
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
@@ -3962,28 +4523,38 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+  /* Do the bulk of the work before we block concurrent commits. */
+  SVN_ERR(prepare_commit(&cb, pool));
+
+  err = svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool);
+  if (err && cb.prepared && !cb.prepared->consumed)
+    err = svn_error_compose_create(err, rollback_prepared_commit(&cb, pool));
+  SVN_ERR(err);
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
+  /* In group commit mode, commit_body left it to us to make the new
+     'current' durable.  Do that before reporting success to the client. */
+  if (ffd->group_commit && ffd->flush_to_disk)
+    SVN_ERR(wait_for_durable_current(fs, *new_rev_p, pool));
+
+  /* Keep the optional mergeinfo index in sync.  This never fails. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_update(fs, *new_rev_p, pool));
+
+  /* Let the cache warm-up preload the new revision. */
+  svn_fs_fs__warmup_commit(fs, *new_rev_p);
+
   if (ffd->rep_sharing_allowed)
     {
-      svn_error_t *err;
-
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
+      /* Write new entries to the rep-sharing database, possibly
+         together with those of later commits. */
       /* ### A commit that touches thousands of files will starve other
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+      err = svn_fs_fs__defer_rep_references(fs, cb.reps_to_cache, pool);
 
       if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
         {
@@ -4001,6 +4572,142 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of revisions whose files svn_fs_fs__sync() keeps open
+   at the same time. */
+#define SYNC_MAX_REVS_PER_BATCH 64
+
+/* Schedule the existing, possibly read-only file at PATH for fsync in
+ * BATCH.  If the file needed to be made writable for that, append PATH,
+ * allocated in RESULT_POOL, to READ_ONLY_FILES.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+schedule_existing_file(svn_fs_fs__batch_fsync_t *batch,
+                       const char *path,
+                       apr_array_header_t *read_only_files,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_PROT, scratch_pool));
+  if (!(finfo.protection & APR_UWRITE))
+    {
+      SVN_ERR(svn_io_set_file_read_write(path, FALSE, scratch_pool));
+      APR_ARRAY_PUSH(read_only_files, const char *)
+        = apr_pstrdup(result_pool, path);
+    }
+
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, path,
+                                           scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Flush the rev and revprop files of revisions START_REV to END_REV in FS
+ * to disk, together with their directory entries.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+sync_revisions(svn_fs_t *fs,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__batch_fsync_t *batch;
+  apr_array_header_t *read_only_files
+    = apr_array_make(scratch_pool, 0, sizeof(const char *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+  svn_revnum_t rev;
+  int i;
+
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, TRUE, scratch_pool));
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      /* Rev files are read-only but the fsync needs write access on some
+         platforms. */
+      SVN_ERR(schedule_existing_file(batch,
+                                     svn_fs_fs__path_rev_absolute(fs, rev,
+                                                                  iterpool),
+                                     read_only_files, scratch_pool,
+                                     iterpool));
+
+      /* Packed revprops have been flushed when they got packed. */
+      if (!svn_fs_fs__is_packed_revprop(fs, rev))
+        SVN_ERR(schedule_existing_file(batch,
+                                       svn_fs_fs__path_revprops(fs, rev,
+                                                                iterpool),
+                                       read_only_files, scratch_pool,
+                                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  err = svn_fs_fs__batch_fsync_run(batch, scratch_pool);
+
+  /* Restore the original permissions, even if the fsync failed. */
+  for (i = 0; i < read_only_files->nelts; ++i)
+    err = svn_error_compose_create(err,
+            svn_io_set_file_read_only(APR_ARRAY_IDX(read_only_files, i,
+                                                    const char *),
+                                      FALSE, scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_fs_fs__sync(svn_fs_t *fs,
+                svn_boolean_t defer,
+                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Pending rep-cache entries are part of what the caller wants to
+     persist. */
+  SVN_ERR(svn_fs_fs__flush_rep_references(fs, scratch_pool));
+
+  if (SVN_IS_VALID_REVNUM(ffd->unsynced_rev))
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      svn_revnum_t youngest = ffd->youngest_rev_cache;
+      svn_revnum_t rev;
+
+      /* Limit the number of files being open at the same time. */
+      for (rev = ffd->unsynced_rev;
+           rev <= youngest;
+           rev += SYNC_MAX_REVS_PER_BATCH)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(sync_revisions(fs, rev,
+                                 MIN(youngest,
+                                     rev + SYNC_MAX_REVS_PER_BATCH - 1),
+                                 iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      /* Only now, 'current' may point to the new revisions on disk. */
+      SVN_ERR(flush_current(fs, scratch_pool));
+      ffd->unsynced_rev = SVN_INVALID_REVNUM;
+    }
+
+  /* Switch flushing for future commits on or off. */
+  if (defer && !ffd->sync_deferred)
+    {
+      ffd->sync_deferred = TRUE;
+      ffd->deferred_flush_to_disk = ffd->flush_to_disk;
+      ffd->flush_to_disk = FALSE;
+    }
+  else if (!defer && ffd->sync_deferred)
+    {
+      ffd->sync_deferred = FALSE;
+      ffd->flush_to_disk = ffd->deferred_flush_to_disk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_fs_fs__list_transactions(apr_array_header_t **names_p,
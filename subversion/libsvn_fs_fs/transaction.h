@@ -220,6 +220,17 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_txn_t *txn,
                   apr_pool_t *pool);
 
+/* Flush all revisions that have been committed through FS without being
+   flushed to disk, together with the 'current' file, to disk.  If DEFER
+   is set, stop flushing each new commit until the next call to this
+   function; otherwise, restore the configured flushing behavior.  This
+   implements the svn_fs__sync() API.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__sync(svn_fs_t *fs,
+                svn_boolean_t defer,
+                apr_pool_t *scratch_pool);
+
 /* Set *NAMES_P to an array of names which are all the active
    transactions in filesystem FS.  Allocate the array from POOL. */
 svn_error_t *
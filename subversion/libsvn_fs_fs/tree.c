@@ -55,6 +55,7 @@
 #include "cached_data.h"
 #include "dag.h"
 #include "lock.h"
+#include "mergeinfo-index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
@@ -1533,13 +1534,9 @@ fs_node_prop(svn_string_t **value_p,
              apr_pool_t *pool)
 {
   dag_node_t *node;
-  apr_hash_t *proplist;
 
   SVN_ERR(get_dag(&node, root, path, pool));
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, node, pool));
-  *value_p = NULL;
-  if (proplist)
-    *value_p = svn_hash_gets(proplist, propname);
+  SVN_ERR(svn_fs_fs__dag_get_property(value_p, node, propname, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2938,6 +2935,34 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__file_contents_ranges() ---  */
+
+static svn_error_t *
+fs_file_contents_ranges(const char **file_path,
+                        apr_array_header_t **ranges,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+
+  *file_path = NULL;
+  *ranges = NULL;
+
+  /* Only committed data is immutable. */
+  if (root->is_txn_root)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_fs_fs__dag_file_contents_ranges(file_path, ranges, node,
+                                             result_pool, scratch_pool);
+}
+
+/* --- End machinery for svn_fs__file_contents_ranges() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -3591,11 +3616,14 @@ find_youngest_copyroot(svn_revnum_t *rev_p,
 }
 
 
-static svn_error_t *fs_closest_copy(svn_fs_root_t **root_p,
-                                    const char **path_p,
-                                    svn_fs_root_t *root,
-                                    const char *path,
-                                    apr_pool_t *pool)
+/* Implement svn_fs_closest_copy() for the canonical PATH in ROOT without
+   any caching.  Allocate the results in POOL. */
+static svn_error_t *
+find_closest_copy(svn_fs_root_t **root_p,
+                  const char **path_p,
+                  svn_fs_root_t *root,
+                  const char *path,
+                  apr_pool_t *pool)
 {
   svn_fs_t *fs = root->fs;
   parent_path_t *parent_path, *copy_dst_parent_path;
@@ -3608,7 +3636,6 @@ static svn_error_t *fs_closest_copy(svn_fs_root_t **root_p,
   *root_p = NULL;
   *path_p = NULL;
 
-  path = svn_fs__canonicalize_abspath(path, pool);
   SVN_ERR(open_path(&parent_path, root, path, 0, FALSE, pool));
 
   /* Find the youngest copyroot in the path of this node-rev, which
@@ -3662,6 +3689,61 @@ static svn_error_t *fs_closest_copy(svn_fs_root_t **root_p,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *fs_closest_copy(svn_fs_root_t **root_p,
+                                    const char **path_p,
+                                    svn_fs_root_t *root,
+                                    const char *path,
+                                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+  const char *cache_key;
+  svn_stringbuf_t *copy;
+  svn_boolean_t found;
+
+  path = svn_fs__canonicalize_abspath(path, pool);
+
+  /* Results for transaction roots may still change. */
+  if (root->is_txn_root || !ffd->closest_copy_cache)
+    return svn_error_trace(find_closest_copy(root_p, path_p, root, path,
+                                             pool));
+
+  /* Revision roots are immutable, so we can simply remember the result
+     to make repeated location tracing cheaper. */
+  cache_key = svn_fs_fs__combine_number_and_string(root->rev, path, pool);
+  SVN_ERR(svn_cache__get((void **)&copy, &found, ffd->closest_copy_cache,
+                         cache_key, pool));
+  if (found)
+    {
+      svn_revnum_t copy_rev;
+      const char *copy_path;
+
+      *root_p = NULL;
+      *path_p = NULL;
+      if (svn_stringbuf_isempty(copy))
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_revnum_parse(&copy_rev, copy->data, &copy_path));
+      if (*copy_path != ' ')
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Invalid cached copy information for "
+                                   "'%s' in r%ld"), path, root->rev);
+
+      SVN_ERR(svn_fs_fs__revision_root(root_p, root->fs, copy_rev, pool));
+      *path_p = copy_path + 1;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(find_closest_copy(root_p, path_p, root, path, pool));
+
+  copy = *root_p
+       ? svn_stringbuf_createf(pool, "%ld %s", (*root_p)->rev, *path_p)
+       : svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_cache__set(ffd->closest_copy_cache, cache_key, copy, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Set *PREV_PATH and *PREV_REV to the path and revision which
    represent the location at which PATH in FS was located immediately
@@ -4140,6 +4222,55 @@ assemble_history(svn_fs_t *fs,
 /* mergeinfo queries */
 
 
+/* Parse the mergeinfo of NODE, found at PATH, and call RECEIVER with it
+   and BATON.  NODE must claim to have mergeinfo.
+
+   SCRATCH_POOL is used for temporary allocations, including the mergeinfo
+   hash passed to RECEIVER.
+ */
+static svn_error_t *
+report_node_mergeinfo(const char *path,
+                      dag_node_t *node,
+                      svn_fs_mergeinfo_receiver_t receiver,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_t mergeinfo;
+  svn_string_t *mergeinfo_string;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_fs__dag_get_property(&mergeinfo_string, node,
+                                      SVN_PROP_MERGEINFO, scratch_pool));
+  if (!mergeinfo_string)
+    {
+      svn_string_t *idstr = svn_fs_fs__id_unparse(svn_fs_fs__dag_get_id(node),
+                                                  scratch_pool);
+      return svn_error_createf
+        (SVN_ERR_FS_CORRUPT, NULL,
+         _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
+         idstr->data);
+    }
+
+  /* Issue #3896: If a node has syntactically invalid mergeinfo, then
+     treat it as if no mergeinfo is present rather than raising a parse
+     error. */
+  err = svn_mergeinfo_parse(&mergeinfo, mergeinfo_string->data,
+                            scratch_pool);
+  if (err)
+    {
+      if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        svn_error_clear(err);
+      else
+        return svn_error_trace(err);
+    }
+  else
+    {
+      SVN_ERR(receiver(path, mergeinfo, baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* DIR_DAG is a directory DAG node which has mergeinfo in its
    descendants.  This function iterates over its children.  For each
    child with immediate mergeinfo, call RECEIVER with it and BATON.
@@ -4178,42 +4309,8 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down, kid_dag));
 
       if (has_mergeinfo)
-        {
-          /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
-          svn_mergeinfo_t kid_mergeinfo;
-          svn_string_t *mergeinfo_string;
-          svn_error_t *err;
-
-          SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, kid_dag, iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-          if (!mergeinfo_string)
-            {
-              svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
-              return svn_error_createf
-                (SVN_ERR_FS_CORRUPT, NULL,
-                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
-                 idstr->data);
-            }
-
-          /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-             treat it as if no mergeinfo is present rather than raising a parse
-             error. */
-          err = svn_mergeinfo_parse(&kid_mergeinfo,
-                                    mergeinfo_string->data,
-                                    iterpool);
-          if (err)
-            {
-              if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
-                svn_error_clear(err);
-              else
-                return svn_error_trace(err);
-              }
-          else
-            {
-              SVN_ERR(receiver(kid_path, kid_mergeinfo, baton, iterpool));
-            }
-        }
+        SVN_ERR(report_node_mergeinfo(kid_path, kid_dag, receiver, baton,
+                                      iterpool));
 
       if (go_down)
         SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
@@ -4262,7 +4359,6 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
                                 apr_pool_t *scratch_pool)
 {
   parent_path_t *parent_path, *nearest_ancestor;
-  apr_hash_t *proplist;
   svn_string_t *mergeinfo_string;
 
   path = svn_fs__canonicalize_abspath(path, scratch_pool);
@@ -4301,9 +4397,9 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                      scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  SVN_ERR(svn_fs_fs__dag_get_property(&mergeinfo_string,
+                                      nearest_ancestor->node,
+                                      SVN_PROP_MERGEINFO, scratch_pool));
   if (!mergeinfo_string)
     return svn_error_createf
       (SVN_ERR_FS_CORRUPT, NULL,
@@ -4415,11 +4511,38 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
 {
   dag_node_t *this_dag;
   svn_boolean_t go_down;
+  apr_array_header_t *kid_paths;
 
   SVN_ERR(get_dag(&this_dag, root, path, scratch_pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
                                                         this_dag));
-  if (go_down)
+  if (!go_down)
+    return SVN_NO_ERROR;
+
+  /* Let the mergeinfo index tell us where to look, if it covers ROOT. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_lookup(&kid_paths, root->fs, root->rev,
+                                            svn_fs__canonicalize_abspath(
+                                              path, scratch_pool),
+                                            scratch_pool, scratch_pool));
+  if (kid_paths)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < kid_paths->nelts; ++i)
+        {
+          const char *kid_path = APR_ARRAY_IDX(kid_paths, i, const char *);
+          dag_node_t *kid_dag;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(get_dag(&kid_dag, root, kid_path, iterpool));
+          SVN_ERR(report_node_mergeinfo(kid_path, kid_dag, receiver, baton,
+                                        iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
     SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
                                               path,
                                               this_dag,
@@ -4547,6 +4670,7 @@ static root_vtable_t root_vtable = {
   fs_file_checksum,
   fs_file_contents,
   fs_try_process_file_contents,
+  fs_file_contents_ranges,
   fs_make_file,
   fs_apply_textdelta,
   fs_apply_text,
@@ -4726,10 +4850,14 @@ verify_node(dag_node_t *node,
   if (kind == svn_node_dir)
     {
       apr_array_header_t *entries;
+      apr_array_header_t *older_ids;
+      apr_array_header_t *noderevs;
       apr_int64_t children_mergeinfo = 0;
       APR_ARRAY_PUSH(parent_nodes, dag_node_t*) = node;
 
       SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, node, pool));
+      older_ids = apr_array_make(pool, entries->nelts,
+                                 sizeof(const svn_fs_id_t *));
 
       /* Compute CHILDREN_MERGEINFO. */
       for (i = 0; i < entries->nelts; ++i)
@@ -4752,16 +4880,23 @@ verify_node(dag_node_t *node,
             }
           else
             {
-              /* access mergeinfo counter with minimal overhead */
-              node_revision_t *noderev;
-              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
-                                                   iterpool, iterpool));
-              child_mergeinfo = noderev->mergeinfo_count;
+              /* collect these and process them in one batch below */
+              APR_ARRAY_PUSH(older_ids, const svn_fs_id_t *) = dirent->id;
+              continue;
             }
 
           children_mergeinfo += child_mergeinfo;
         }
 
+      /* Access the mergeinfo counters of children from older revisions
+       * with minimal overhead.  Their noderevs are probably cached. */
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revisions(&noderevs, fs, older_ids,
+                                            iterpool, iterpool));
+      for (i = 0; i < noderevs->nelts; ++i)
+        children_mergeinfo
+          += APR_ARRAY_IDX(noderevs, i, node_revision_t *)->mergeinfo_count;
+
       /* Side-effect of issue #4129. */
       if (children_mergeinfo+has_mergeinfo != mergeinfo_count)
         return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
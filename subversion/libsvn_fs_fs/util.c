@@ -492,6 +492,27 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__unparse_current(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_uint64_t next_node_id,
+                           apr_uint64_t next_copy_id,
+                           apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  char node_id_str[SVN_INT64_BUFFER_SIZE];
+  char copy_id_str[SVN_INT64_BUFFER_SIZE];
+
+  if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return apr_psprintf(result_pool, "%ld\n", rev);
+
+  svn__ui64tobase36(node_id_str, next_node_id);
+  svn__ui64tobase36(copy_id_str, next_copy_id);
+
+  return apr_psprintf(result_pool, "%ld %s %s\n", rev, node_id_str,
+                      copy_id_str);
+}
+
 svn_error_t *
 svn_fs_fs__write_current(svn_fs_t *fs,
                          svn_revnum_t rev,
@@ -499,25 +520,13 @@ svn_fs_fs__write_current(svn_fs_t *fs,
                          apr_uint64_t next_copy_id,
                          apr_pool_t *pool)
 {
-  char *buf;
+  const char *buf;
   const char *name;
   fs_fs_data_t *ffd = fs->fsap_data;
 
   /* Now we can just write out this line. */
-  if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    {
-      buf = apr_psprintf(pool, "%ld\n", rev);
-    }
-  else
-    {
-      char node_id_str[SVN_INT64_BUFFER_SIZE];
-      char copy_id_str[SVN_INT64_BUFFER_SIZE];
-      svn__ui64tobase36(node_id_str, next_node_id);
-      svn__ui64tobase36(copy_id_str, next_copy_id);
-
-      buf = apr_psprintf(pool, "%ld %s %s\n", rev, node_id_str, copy_id_str);
-    }
-
+  buf = svn_fs_fs__unparse_current(fs, rev, next_node_id, next_copy_id,
+                                   pool);
   name = svn_fs_fs__path_current(fs, pool);
   SVN_ERR(svn_io_write_atomic2(name, buf, strlen(buf),
                                name /* copy_perms_path */,
@@ -636,7 +645,8 @@ svn_fs_fs__move_into_place(const char *old_filename,
     {
       /* Can't rename across devices; fall back to copying. */
       svn_error_clear(err);
-      SVN_ERR(svn_io_copy_file(old_filename, new_filename, TRUE, pool));
+      SVN_ERR(svn_io_copy_file2(old_filename, new_filename,
+                                SVN_IO_COPY_FILE_PERMS, NULL, pool));
 
       /* Flush the target of the copy to disk.
          ### The code below is duplicates svn_io_file_rename2(), because
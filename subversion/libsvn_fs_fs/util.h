@@ -336,6 +336,17 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
                         svn_fs_t *fs,
                         apr_pool_t *pool);
 
+/* Return the contents of a 'current' file specifying REV, NEXT_NODE_ID,
+   and NEXT_COPY_ID in FS' format, allocated in RESULT_POOL.  (The two
+   next-ID parameters are ignored and may be 0 if the FS format does not
+   use them.) */
+const char *
+svn_fs_fs__unparse_current(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_uint64_t next_node_id,
+                           apr_uint64_t next_copy_id,
+                           apr_pool_t *result_pool);
+
 /* Atomically update the 'current' file to hold the specifed REV,
    NEXT_NODE_ID, and NEXT_COPY_ID.  (The two next-ID parameters are
    ignored and may be 0 if the FS format does not use them.)
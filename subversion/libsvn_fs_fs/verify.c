@@ -24,6 +24,7 @@
 #include "svn_checksum.h"
 #include "svn_time.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #include "verify.h"
 #include "fs_fs.h"
@@ -791,6 +792,59 @@ pack_size(svn_fs_t *fs, svn_revnum_t rev)
   return rev < ffd->min_unpacked_rev ? ffd->max_files_per_dir : 1;
 }
 
+/* Run the index checks of verify_f7_metadata_consistency() on the
+ * rev / pack file containing the COUNT revisions starting at PACK_START
+ * in FS.  The other parameters are the same as for
+ * verify_f7_metadata_consistency().
+ */
+static svn_error_t *
+verify_pack_indexes(svn_fs_t *fs,
+                    svn_revnum_t pack_start,
+                    svn_revnum_t count,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *pool)
+{
+  /* Check for external corruption to the indexes. */
+  SVN_ERR(verify_index_checksums(fs, pack_start, cancel_func,
+                                 cancel_baton, pool));
+
+  /* two-way index check */
+  SVN_ERR(compare_l2p_to_p2l_index(fs, pack_start, count,
+                                   cancel_func, cancel_baton, pool));
+  SVN_ERR(compare_p2l_to_l2p_index(fs, pack_start, count,
+                                   cancel_func, cancel_baton, pool));
+
+  /* verify in-index checksums and types vs. actual rev / pack files */
+  SVN_ERR(compare_p2l_to_rev(fs, pack_start, count,
+                             cancel_func, cancel_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Run all metadata checks of verify_f7_metadata_consistency() on the
+ * rev / pack file containing the COUNT revisions starting at PACK_START
+ * in FS.  The other parameters are the same as for
+ * verify_f7_metadata_consistency().
+ */
+static svn_error_t *
+verify_pack_metadata(svn_fs_t *fs,
+                     svn_revnum_t pack_start,
+                     svn_revnum_t count,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  SVN_ERR(verify_pack_indexes(fs, pack_start, count,
+                              cancel_func, cancel_baton, pool));
+
+  /* ensure that revprops are available and accessible */
+  SVN_ERR(verify_revprops(fs, pack_start, pack_start + count,
+                          cancel_func, cancel_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Verify that on-disk representation has not been tempered with (in a way
  * that leaves the repository in a corrupted state).  This compares log-to-
  * phys with phys-to-log indexes, verifies the low-level checksums and
@@ -827,28 +881,9 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
       if (notify_func && (pack_start % ffd->max_files_per_dir == 0))
         notify_func(pack_start, notify_baton, iterpool);
 
-      /* Check for external corruption to the indexes. */
-      err = verify_index_checksums(fs, pack_start, cancel_func,
-                                   cancel_baton, iterpool);
-
-      /* two-way index check */
-      if (!err)
-        err = compare_l2p_to_p2l_index(fs, pack_start, pack_end - pack_start,
-                                       cancel_func, cancel_baton, iterpool);
-      if (!err)
-        err = compare_p2l_to_l2p_index(fs, pack_start, pack_end - pack_start,
-                                       cancel_func, cancel_baton, iterpool);
-
-      /* verify in-index checksums and types vs. actual rev / pack files */
-      if (!err)
-        err = compare_p2l_to_rev(fs, pack_start, pack_end - pack_start,
+      err = verify_pack_metadata(fs, pack_start, count,
                                  cancel_func, cancel_baton, iterpool);
 
-      /* ensure that revprops are available and accessible */
-      if (!err)
-        err = verify_revprops(fs, pack_start, pack_end,
-                              cancel_func, cancel_baton, iterpool);
-
       /* concurrent packing is one of the reasons why verification may fail.
          Make sure, we operate on up-to-date information. */
       if (err)
@@ -883,6 +918,192 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* A rev / pack file whose metadata gets verified concurrently with
+   others. */
+typedef struct verify_task_t
+{
+  /* Instance of the filesystem being verified that nobody else uses.
+     The tasks open their own instances from it because the FSFS caches
+     etc. are not thread-safe.  The instances still share the global,
+     size-limited membuffer cache. */
+  svn_fs_t *fs;
+
+  /* The revisions in the rev / pack file to verify. */
+  svn_revnum_t pack_start;
+  svn_revnum_t count;
+} verify_task_t;
+
+/* The result of verify_task(). */
+typedef struct verify_result_t
+{
+  /* The verified revisions, copied from the verify_task_t. */
+  svn_revnum_t pack_start;
+  svn_revnum_t count;
+
+  /* Result of verify_pack_metadata().  Verification failures are not
+     fatal to the other tasks as the repository may have been packed
+     concurrently, see check_verify_result(). */
+  svn_error_t *err;
+} verify_result_t;
+
+/* Output baton for check_verify_result(). */
+typedef struct verify_output_baton_t
+{
+  /* The filesystem being verified and the caller's callbacks. */
+  svn_fs_t *fs;
+  svn_fs_progress_notify_func_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* All revisions before this one have been verified. */
+  svn_revnum_t verified_end;
+} verify_output_baton_t;
+
+/* Implements svn_task__process_func_t.  Verify the rev / pack file given
+   by the verify_task_t in PROCESS_BATON and return a verify_result_t in
+   *RESULT. */
+static svn_error_t *
+verify_task(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  verify_task_t *task = process_baton;
+  verify_result_t *verified = apr_pcalloc(result_pool, sizeof(*verified));
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&fs, task->fs, scratch_pool,
+                                   scratch_pool));
+
+  verified->pack_start = task->pack_start;
+  verified->count = task->count;
+  verified->err = verify_pack_metadata(fs, task->pack_start, task->count,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool);
+  if (verified->err && verified->err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_t *err = verified->err;
+      verified->err = SVN_NO_ERROR;
+      return svn_error_trace(err);
+    }
+
+  *result = verified;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Process the verify_result_t in
+   RESULT.  If the verification failed because the shard got packed in
+   the meantime, re-check the whole shard in this thread.  OUTPUT_BATON
+   is the verify_output_baton_t of the operation. */
+static svn_error_t *
+check_verify_result(void *result,
+                    void *output_baton,
+                    apr_pool_t *scratch_pool)
+{
+  verify_result_t *verified = result;
+  verify_output_baton_t *baton = output_baton;
+  svn_fs_t *fs = baton->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *task_err = verified->err;
+  svn_error_t *err;
+
+  verified->err = SVN_NO_ERROR;
+
+  /* Already covered by the re-check of a shard that got packed? */
+  if (verified->pack_start + verified->count <= baton->verified_end)
+    {
+      svn_error_clear(task_err);
+      return SVN_NO_ERROR;
+    }
+
+  if (   baton->notify_func
+      && (verified->pack_start % ffd->max_files_per_dir == 0))
+    baton->notify_func(verified->pack_start, baton->notify_baton,
+                       scratch_pool);
+
+  if (task_err)
+    {
+      /* concurrent packing is one of the reasons why verification may
+         fail.  Make sure, we operate on up-to-date information. */
+      err = svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev,
+                                             fs, scratch_pool);
+      if (err)
+        return svn_error_trace(svn_error_compose_create(task_err, err));
+
+      /* No change in the repository layout means a real failure. */
+      if (verified->count == pack_size(fs, verified->pack_start))
+        return svn_error_trace(task_err);
+
+      /* Re-check the whole shard, which got packed in the meantime. */
+      svn_error_clear(task_err);
+      verified->count = pack_size(fs, verified->pack_start);
+      verified->pack_start
+        = svn_fs_fs__packed_base_rev(fs, verified->pack_start);
+      SVN_ERR(verify_pack_metadata(fs, verified->pack_start,
+                                   verified->count, baton->cancel_func,
+                                   baton->cancel_baton, scratch_pool));
+    }
+
+  baton->verified_end = verified->pack_start + verified->count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like verify_f7_metadata_consistency but check up to JOBS rev / pack
+ * files concurrently.  Notifications are being sent in revision order
+ * and from the calling thread only.
+ */
+static svn_error_t *
+verify_f7_metadata_parallel(svn_fs_t *fs,
+                            svn_revnum_t start,
+                            svn_revnum_t end,
+                            svn_fs_progress_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            int jobs,
+                            apr_pool_t *pool)
+{
+  apr_pool_t *set_pool = svn_pool_create(pool);
+  verify_output_baton_t baton = { 0 };
+  svn_task__set_t *set;
+  svn_fs_t *snapshot;
+  svn_revnum_t next_revision = start;
+
+  baton.fs = fs;
+  baton.notify_func = notify_func;
+  baton.notify_baton = notify_baton;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+  baton.verified_end = start;
+
+  /* Opening an instance accesses FS, so do it here in this thread. */
+  SVN_ERR(svn_fs_fs__open_instance(&snapshot, fs, pool, pool));
+
+  SVN_ERR(svn_task__set_create(&set, jobs, check_verify_result, &baton,
+                               cancel_func, cancel_baton, set_pool));
+  while (next_revision <= end)
+    {
+      verify_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      task->fs = snapshot;
+      task->count = pack_size(fs, next_revision);
+      task->pack_start = svn_fs_fs__packed_base_rev(fs, next_revision);
+      next_revision = MAX(task->pack_start + task->count,
+                          baton.verified_end);
+
+      SVN_ERR(svn_task__add(set, verify_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__verify(svn_fs_t *fs,
                   svn_revnum_t start,
@@ -909,9 +1130,18 @@ svn_fs_fs__verify(svn_fs_t *fs,
   /* log/phys index consistency.  We need to check them first to make
      sure we can access the rev / pack files in format7. */
   if (svn_fs_fs__use_log_addressing(fs))
-    SVN_ERR(verify_f7_metadata_consistency(fs, start, end,
-                                           notify_func, notify_baton,
-                                           cancel_func, cancel_baton, pool));
+    {
+      if (ffd->verify_jobs > 1 && ffd->max_files_per_dir && start < end)
+        SVN_ERR(verify_f7_metadata_parallel(fs, start, end,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            ffd->verify_jobs, pool));
+      else
+        SVN_ERR(verify_f7_metadata_consistency(fs, start, end,
+                                               notify_func, notify_baton,
+                                               cancel_func, cancel_baton,
+                                               pool));
+    }
 
   /* rep cache consistency */
   if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
@@ -920,3 +1150,32 @@ svn_fs_fs__verify(svn_fs_t *fs,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_fs_fs__verify_indexes(svn_fs_t *fs,
+                          svn_revnum_t start,
+                          svn_revnum_t end,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *pool)
+{
+  svn_revnum_t revision;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR_ASSERT(svn_fs_fs__use_log_addressing(fs));
+
+  for (revision = start; revision <= end; )
+    {
+      svn_revnum_t count = pack_size(fs, revision);
+      svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs, revision);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(verify_pack_indexes(fs, pack_start, count,
+                                  cancel_func, cancel_baton, iterpool));
+      revision = pack_start + count;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
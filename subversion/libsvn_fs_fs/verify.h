@@ -39,4 +39,17 @@ svn_error_t *svn_fs_fs__verify(svn_fs_t *fs,
                                void *cancel_baton,
                                apr_pool_t *pool);
 
+/* Check the indexes of the rev / pack files covering revisions START to
+ * END in the format 7 fsfs filesystem FS against each other, against
+ * their checksums and against the rev / pack file contents.  Unlike
+ * svn_fs_fs__verify, do not require these revisions to be visible in
+ * 'current' yet.  The optional CANCEL_FUNC will periodically be called
+ * with CANCEL_BATON.  Use POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__verify_indexes(svn_fs_t *fs,
+                                       svn_revnum_t start,
+                                       svn_revnum_t end,
+                                       svn_cancel_func_t cancel_func,
+                                       void *cancel_baton,
+                                       apr_pool_t *pool);
+
 #endif
@@ -0,0 +1,652 @@
+/* warmup.c --- preloading the caches of FSFS repositories
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "cached_data.h"
+#include "fs_fs.h"
+#include "id.h"
+#include "warmup.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
+
+#include "svn_private_config.h"
+
+/* Number of noderevs to list in the warm-up file. */
+#define WARMUP_MAX_ITEMS 4096
+
+/* Number of noderevs to track before we forget the colder ones. */
+#define WARMUP_MAX_TRACKED (4 * WARMUP_MAX_ITEMS)
+
+/* Minimum time between two updates of the warm-up file. */
+#define WARMUP_SAVE_INTERVAL apr_time_from_sec(300)
+
+/* Preload the contents of files up to this size. */
+#define WARMUP_MAX_FILE_SIZE 0x10000
+
+/* After a commit, preload the directories down to this many levels below
+   the root. */
+#define WARMUP_COMMIT_DEPTH 1
+
+/* First line of the warm-up file. */
+#define WARMUP_HEADER "fsfs-cache-warmup 1\n"
+
+/* A noderev that has been read and how often that happened. */
+typedef struct hot_item_t
+{
+  /* Revision and item index of the noderev. */
+  pair_cache_key_t key;
+
+  /* Node kind of the noderev. */
+  svn_node_kind_t kind;
+
+  /* Number of reads since the last pruning, with older ones decaying. */
+  apr_uint64_t hits;
+} hot_item_t;
+
+/* Process-wide warm-up state of a repository.  See warmup.h. */
+struct cache_warmup_t
+{
+  /* Local path of the warm-up file. */
+  const char *path;
+
+  /* Serializes access to the members from HITS to COMMITS_SCHEDULED. */
+  svn_mutex__t *mutex;
+
+  /* Maps pair_cache_key_t to hot_item_t *.  Both are allocated in
+     HITS_POOL, a root pool.  NULL, if noderevs shall not be recorded. */
+  apr_hash_t *hits;
+  apr_pool_t *hits_pool;
+
+  /* When the warm-up file has last been updated. */
+  apr_time_t last_save;
+
+  /* Whether to preload the revisions committed in this process. */
+  svn_boolean_t on_commit;
+
+  /* Youngest revision committed in this process that has not been
+     preloaded, yet, or SVN_INVALID_REVNUM. */
+  svn_revnum_t next_rev;
+
+  /* Whether a preload_commits_task() is queued or running that will
+     pick up NEXT_REV. */
+  svn_boolean_t commits_scheduled;
+
+  /* The preloading tasks run in TASKS, one at a time.  TASKS_MUTEX
+     serializes adding to and waiting for them.  Never acquire it while
+     holding MUTEX. */
+  svn_task__set_t *tasks;
+  svn_mutex__t *tasks_mutex;
+
+  /* The instance the tasks open their own ones from.  It lives in its
+     own root pool. */
+  svn_fs_t *fs;
+};
+
+/* qsort()-style comparison function sorting hot_item_t * by descending
+   number of hits. */
+static int
+compare_hits(const void *lhs,
+             const void *rhs)
+{
+  const hot_item_t *lhs_item = *(const hot_item_t * const *)lhs;
+  const hot_item_t *rhs_item = *(const hot_item_t * const *)rhs;
+
+  if (lhs_item->hits == rhs_item->hits)
+    return 0;
+
+  return lhs_item->hits > rhs_item->hits ? -1 : 1;
+}
+
+/* Return the hot_item_t * of WARMUP, hottest first, allocated in
+   RESULT_POOL.  The caller must hold the WARMUP->MUTEX. */
+static apr_array_header_t *
+get_hottest(struct cache_warmup_t *warmup,
+            apr_pool_t *result_pool)
+{
+  apr_array_header_t *items
+    = apr_array_make(result_pool, apr_hash_count(warmup->hits),
+                     sizeof(hot_item_t *));
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, warmup->hits);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(items, hot_item_t *) = apr_hash_this_val(hi);
+
+  svn_sort__array(items, compare_hits);
+
+  return items;
+}
+
+/* Forget about all but the WARMUP_MAX_ITEMS hottest noderevs in WARMUP
+   and halve their number of hits, such that items that became hot only
+   recently can catch up.  The caller must hold the WARMUP->MUTEX. */
+static void
+prune_hits(struct cache_warmup_t *warmup)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_hash_t *hits = apr_hash_make(pool);
+  apr_array_header_t *items = get_hottest(warmup, pool);
+  int i;
+
+  for (i = 0; i < items->nelts && i < WARMUP_MAX_ITEMS; ++i)
+    {
+      hot_item_t *item = apr_pmemdup(pool,
+                                     APR_ARRAY_IDX(items, i, hot_item_t *),
+                                     sizeof(*item));
+      item->hits = (item->hits + 1) / 2;
+      apr_hash_set(hits, &item->key, sizeof(item->key), item);
+    }
+
+  svn_pool_destroy(warmup->hits_pool);
+  warmup->hits_pool = pool;
+  warmup->hits = hits;
+}
+
+/* Return the contents of the warm-up file for the hottest noderevs in
+   WARMUP, allocated in RESULT_POOL.  The caller must hold the
+   WARMUP->MUTEX. */
+static svn_stringbuf_t *
+serialize_hottest(struct cache_warmup_t *warmup,
+                  apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create(WARMUP_HEADER,
+                                                   result_pool);
+  apr_array_header_t *items = get_hottest(warmup, result_pool);
+  int i;
+
+  for (i = 0; i < items->nelts && i < WARMUP_MAX_ITEMS; ++i)
+    {
+      const hot_item_t *item = APR_ARRAY_IDX(items, i, hot_item_t *);
+
+      svn_stringbuf_appendcstr(contents,
+                               apr_psprintf(result_pool,
+                                            "%c %" APR_INT64_T_FMT
+                                            " %" APR_INT64_T_FMT "\n",
+                                            item->kind == svn_node_dir
+                                              ? 'd' : 'f',
+                                            item->key.revision,
+                                            item->key.second));
+    }
+
+  return contents;
+}
+
+void
+svn_fs_fs__warmup_record(svn_fs_t *fs,
+                         const svn_fs_fs__id_part_t *rev_item,
+                         svn_node_kind_t kind,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct cache_warmup_t *warmup = ffd->shared->warmup;
+  svn_stringbuf_t *contents = NULL;
+  pair_cache_key_t key;
+  hot_item_t *item;
+  apr_time_t now;
+  svn_error_t *err;
+
+  if (!warmup || !warmup->hits)
+    return;
+
+  key.revision = rev_item->revision;
+  key.second = rev_item->number;
+
+  err = svn_mutex__lock(warmup->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  item = apr_hash_get(warmup->hits, &key, sizeof(key));
+  if (!item)
+    {
+      if (apr_hash_count(warmup->hits) >= WARMUP_MAX_TRACKED)
+        prune_hits(warmup);
+
+      item = apr_pcalloc(warmup->hits_pool, sizeof(*item));
+      item->key = key;
+      item->kind = kind;
+      apr_hash_set(warmup->hits, &item->key, sizeof(item->key), item);
+    }
+  item->hits++;
+
+  /* Take a snapshot while we hold the lock but write it without. */
+  now = apr_time_now();
+  if (now - warmup->last_save >= WARMUP_SAVE_INTERVAL)
+    {
+      warmup->last_save = now;
+      contents = serialize_hottest(warmup, scratch_pool);
+    }
+
+  svn_error_clear(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+
+  if (contents)
+    svn_error_clear(svn_io_write_atomic2(warmup->path, contents->data,
+                                         contents->len, NULL, FALSE,
+                                         scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__warmup_save(svn_fs_t *fs,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct cache_warmup_t *warmup = ffd->shared->warmup;
+  svn_stringbuf_t *contents;
+
+  if (!warmup || !warmup->hits)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(warmup->mutex));
+  warmup->last_save = apr_time_now();
+  contents = serialize_hottest(warmup, scratch_pool);
+  SVN_ERR(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+
+  return svn_error_trace(svn_io_write_atomic2(warmup->path, contents->data,
+                                              contents->len, NULL, FALSE,
+                                              scratch_pool));
+}
+
+/* Read the noderev ID in FS and put it, its properties and its directory
+   listing or, for small files, its contents into the caches.  Continue
+   with sub-directories down to DEPTH levels below ID.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+preload_node(svn_fs_t *fs,
+             const svn_fs_id_t *id,
+             int depth,
+             apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, scratch_pool,
+                                       scratch_pool));
+
+  if (noderev->prop_rep)
+    {
+      apr_hash_t *proplist;
+      SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev,
+                                      scratch_pool));
+    }
+
+  if (noderev->kind == svn_node_dir)
+    {
+      apr_array_header_t *entries;
+      apr_pool_t *iterpool;
+      int i;
+
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev,
+                                          scratch_pool, scratch_pool));
+      if (depth <= 0)
+        return SVN_NO_ERROR;
+
+      iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i,
+                                                  svn_fs_dirent_t *);
+          if (dirent->kind != svn_node_dir)
+            continue;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(preload_node(fs, dirent->id, depth - 1, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+  else if (noderev->data_rep)
+    {
+      representation_t *rep = noderev->data_rep;
+      svn_filesize_t size = rep->expanded_size ? rep->expanded_size
+                                               : rep->size;
+
+      if (size <= WARMUP_MAX_FILE_SIZE)
+        {
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_fs__get_contents(&contents, fs, rep, TRUE,
+                                          scratch_pool));
+          SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(scratch_pool),
+                                   NULL, NULL, scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Preload the noderevs listed in the warm-up file at PATH into the caches
+   of FS.  Skip entries that cannot be read, e.g. because the repository
+   has been replaced since the file was written.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+preload_hottest(svn_fs_t *fs,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  svn_stringbuf_t *contents;
+  svn_revnum_t youngest;
+  char *line, *next;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (strncmp(contents->data, WARMUP_HEADER, strlen(WARMUP_HEADER)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (line = contents->data + strlen(WARMUP_HEADER); *line; line = next)
+    {
+      svn_fs_fs__id_part_t rev_item;
+      svn_fs_fs__id_part_t unused = { 0 };
+      char kind;
+      apr_int64_t revision;
+      apr_uint64_t number;
+
+      svn_pool_clear(iterpool);
+
+      next = strchr(line, '\n');
+      if (!next)
+        break;
+      *next++ = '\0';
+
+      if (sscanf(line, "%c %" APR_INT64_T_FMT " %" APR_UINT64_T_FMT,
+                 &kind, &revision, &number) != 3
+          || revision < 0 || revision > youngest)
+        continue;
+
+      rev_item.revision = (svn_revnum_t)revision;
+      rev_item.number = number;
+      svn_error_clear(preload_node(fs,
+                                   svn_fs_fs__id_rev_create(&unused, &unused,
+                                                            &rev_item,
+                                                            iterpool),
+                                   0, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_warning_callback_t.  Warm-up is best-effort, so
+   ignore all problems with the caches. */
+static void
+ignore_warning(void *baton,
+               svn_error_t *err)
+{
+}
+
+/* Open an instance of the repository of WARMUP for a preloading task in
+   *FS, allocated in RESULT_POOL.  It neither records its own reads nor
+   reports cache problems.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_task_instance(svn_fs_t **fs,
+                   struct cache_warmup_t *warmup,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd;
+
+  SVN_ERR(svn_fs_fs__open_instance(fs, warmup->fs, result_pool,
+                                   scratch_pool));
+
+  (*fs)->warning = ignore_warning;
+  ffd = (*fs)->fsap_data;
+  ffd->cache_warmup = FALSE;
+  ffd->cache_warmup_on_commit = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Preload the noderevs listed in
+   the warm-up file of the struct cache_warmup_t in PROCESS_BATON.
+   Warm-up is best-effort, so this never fails. */
+static svn_error_t *
+preload_hottest_task(void **result,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  struct cache_warmup_t *warmup = process_baton;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  err = open_task_instance(&fs, warmup, scratch_pool, scratch_pool);
+  if (!err)
+    err = preload_hottest(fs, warmup->path, scratch_pool);
+  svn_error_clear(err);
+  *result = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Preload the top-level directories
+   of the revisions committed through the struct cache_warmup_t in
+   PROCESS_BATON until it has caught up with the commits.  Like
+   preload_hottest_task(), this never fails. */
+static svn_error_t *
+preload_commits_task(void **result,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  struct cache_warmup_t *warmup = process_baton;
+  apr_pool_t *iterpool;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  /* Without an instance, the next commit will have to try again. */
+  *result = NULL;
+  err = open_task_instance(&fs, warmup, scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_error_clear(svn_mutex__lock(warmup->mutex));
+      warmup->commits_scheduled = FALSE;
+      svn_error_clear(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (TRUE)
+    {
+      svn_revnum_t revision;
+      svn_fs_id_t *root_id;
+
+      svn_pool_clear(iterpool);
+
+      /* Take the latest commit, or stop if there is none.  In the latter
+         case, the next commit has to schedule a new task. */
+      err = svn_mutex__lock(warmup->mutex);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      revision = warmup->next_rev;
+      warmup->next_rev = SVN_INVALID_REVNUM;
+      if (!SVN_IS_VALID_REVNUM(revision))
+        warmup->commits_scheduled = FALSE;
+
+      svn_error_clear(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+      if (!SVN_IS_VALID_REVNUM(revision))
+        break;
+
+      err = svn_fs_fs__rev_get_root(&root_id, fs, revision, iterpool,
+                                    iterpool);
+      if (!err)
+        err = preload_node(fs, root_id, WARMUP_COMMIT_DEPTH, iterpool);
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add a task calling PROCESS_FUNC for WARMUP to its task set. */
+static svn_error_t *
+add_task(struct cache_warmup_t *warmup,
+         svn_task__process_func_t process_func)
+{
+  SVN_MUTEX__WITH_LOCK(warmup->tasks_mutex,
+                       svn_task__add(warmup->tasks, process_func, warmup));
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_fs_fs__warmup_commit(svn_fs_t *fs,
+                         svn_revnum_t new_rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct cache_warmup_t *warmup = ffd->shared->warmup;
+  svn_boolean_t schedule;
+  svn_error_t *err;
+
+  if (!ffd->cache_warmup_on_commit || !warmup || !warmup->on_commit)
+    return;
+
+  err = svn_mutex__lock(warmup->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  /* The task only needs to catch up with the latest revision. */
+  if (!SVN_IS_VALID_REVNUM(warmup->next_rev) || warmup->next_rev < new_rev)
+    warmup->next_rev = new_rev;
+
+  schedule = !warmup->commits_scheduled;
+  warmup->commits_scheduled = TRUE;
+
+  svn_error_clear(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+
+  /* Don't hold WARMUP->MUTEX here because svn_fs_fs__warmup_wait() may
+     hold TASKS_MUTEX while waiting for a task that needs the former.
+     With at most one task per kind being queued, adding it never waits
+     for earlier tasks. */
+  if (schedule)
+    {
+      err = add_task(warmup, preload_commits_task);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_error_clear(svn_mutex__lock(warmup->mutex));
+          warmup->commits_scheduled = FALSE;
+          svn_error_clear(svn_mutex__unlock(warmup->mutex, SVN_NO_ERROR));
+        }
+    }
+}
+
+svn_error_t *
+svn_fs_fs__warmup_wait(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct cache_warmup_t *warmup = ffd->shared->warmup;
+
+  if (warmup)
+    SVN_MUTEX__WITH_LOCK(warmup->tasks_mutex,
+                         svn_task__set_finish(warmup->tasks));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__warmup_init(svn_fs_t *fs,
+                       apr_pool_t *common_pool,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  struct cache_warmup_t *warmup;
+  apr_pool_t *instance_pool;
+  svn_error_t *err;
+
+  if (ffsd->warmup || !(ffd->cache_warmup || ffd->cache_warmup_on_commit))
+    return SVN_NO_ERROR;
+
+  /* Preloading in the foreground would only delay the actual requests. */
+  if (svn_task__get_thread_limit() == 0)
+    return SVN_NO_ERROR;
+
+  warmup = apr_pcalloc(common_pool, sizeof(*warmup));
+  warmup->path = svn_dirent_join(fs->path, PATH_CACHE_WARMUP, common_pool);
+  warmup->last_save = apr_time_now();
+  warmup->on_commit = ffd->cache_warmup_on_commit;
+  warmup->next_rev = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_mutex__init(&warmup->mutex, TRUE, common_pool));
+  SVN_ERR(svn_mutex__init(&warmup->tasks_mutex, TRUE, common_pool));
+
+  /* This is background work; a single worker thread is plenty. */
+  SVN_ERR(svn_task__set_create(&warmup->tasks, 1, NULL, NULL, NULL, NULL,
+                               common_pool));
+
+  /* The tasks open their own instances from this one, which nobody
+     modifies and which lives as long as the process. */
+  instance_pool = svn_pool_create(NULL);
+  err = svn_fs_fs__open_instance(&warmup->fs, fs, instance_pool,
+                                 scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(instance_pool);
+      return svn_error_trace(err);
+    }
+
+  if (ffd->cache_warmup)
+    {
+      warmup->hits_pool = svn_pool_create(NULL);
+      warmup->hits = apr_hash_make(warmup->hits_pool);
+      svn_error_clear(add_task(warmup, preload_hottest_task));
+    }
+
+  ffsd->warmup = warmup;
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,90 @@
+/* warmup.h : interface to the FSFS cache warm-up
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_WARMUP_H
+#define SVN_LIBSVN_FS_FS_WARMUP_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* The cache warm-up preloads the process-wide caches of a repository in
+   a background thread, so that the first requests after a server start
+   or after a commit don't have to read everything from disk.
+
+   With SVN_FS_CONFIG_FSFS_CACHE_WARMUP, the most frequently read node
+   revisions get recorded and periodically saved to db/cache-warmup.  The
+   first FS object opened for a repository in this process then preloads
+   the noderevs, directory listings, properties and small file contents
+   listed in that file.  With SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT,
+   the top-level directories of each revision committed in this process
+   get preloaded as well.  Warm-up is best-effort; failures are ignored.
+   The preloading runs as tasks of a svn_task__set_t, one at a time, and
+   is disabled if there are no worker threads. */
+
+/* If FS has been opened with one of the cache warm-up options and the
+   warm-up has not been started for its repository in this process, yet,
+   start it now.  The caller must serialize this by holding the common
+   pool lock.  Allocate long-lived data in COMMON_POOL and use
+   SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__warmup_init(svn_fs_t *fs,
+                       apr_pool_t *common_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Note that the noderev of KIND at REV_ITEM has been read from FS.
+   This may save the hottest noderevs to the warm-up file.  Use
+   SCRATCH_POOL for temporary allocations. */
+void
+svn_fs_fs__warmup_record(svn_fs_t *fs,
+                         const svn_fs_fs__id_part_t *rev_item,
+                         svn_node_kind_t kind,
+                         apr_pool_t *scratch_pool);
+
+/* Tell the warm-up of FS that NEW_REV has just been committed.  This
+   never fails and does not wait for the preloading. */
+void
+svn_fs_fs__warmup_commit(svn_fs_t *fs,
+                         svn_revnum_t new_rev);
+
+/* Write the hottest noderevs recorded for FS to the warm-up file now
+   instead of waiting for the next periodic update.  Do nothing if FS
+   doesn't record them.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__warmup_save(svn_fs_t *fs,
+                       apr_pool_t *scratch_pool);
+
+/* Wait until all preloading scheduled for the repository of FS so far
+   has been done.  Do nothing if there is no warm-up for it.  This is
+   meant for tests. */
+svn_error_t *
+svn_fs_fs__warmup_wait(svn_fs_t *fs);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_WARMUP_H */
@@ -1425,6 +1425,83 @@ read_container_window(svn_stringbuf_t **nwin,
   return SVN_NO_ERROR;
 }
 
+/* Upper limit for the number of bytes per rep that we ask the OS to
+   prefetch for the next delta window.  Windows cover at most
+   SVN_DELTA_WINDOW_SIZE bytes of fulltext and their on-disk size is
+   rarely larger than that.  Everything beyond the limit will simply
+   be read on demand. */
+#define PREFETCH_SIZE (2 * SVN_DELTA_WINDOW_SIZE)
+
+/* Tell the OS that we are about to read the data of RS starting at its
+   current position.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_rep_state(rep_state_t *rs,
+                   apr_pool_t *scratch_pool)
+{
+  apr_file_t *apr_file;
+  apr_off_t length;
+
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+  SVN_ERR(svn_fs_x__rev_file_get(&apr_file, rs->sfile->rfile));
+
+  length = rs->size - rs->current;
+  if (length > PREFETCH_SIZE)
+    length = PREFETCH_SIZE;
+
+  svn_io__file_prefetch(apr_file, rs->start + rs->current, length);
+
+  return SVN_NO_ERROR;
+}
+
+/* If enabled for RB->FS, let the OS fetch the data for the next delta
+   windows of all reps in RB->RS_LIST concurrently and in the background.
+   The same goes for the plain base rep, if any.  The delta windows will
+   then be read and combined the usual way without waiting for each
+   individual read.  Skip all windows that can be found in our caches.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_delta_windows(rep_read_baton_t *rb,
+                       apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = rb->fs->fsap_data;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Short chains won't benefit from concurrent reads. */
+  if (!ffd->prefetch_delta_chains || rb->rs_list->nelts < 2)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      svn_boolean_t is_cached = FALSE;
+
+      svn_pool_clear(iterpool);
+      if (   rs->chunk_index == 0
+          && svn_fs_x__is_revision(rs->rep_id.change_set)
+          && rs->window_cache)
+        {
+          svn_fs_x__window_cache_key_t key = { 0 };
+          get_window_key(&key, rs);
+          key.chunk_index = rb->chunk_index;
+          SVN_ERR(svn_cache__has_key(&is_cached, rs->window_cache, &key,
+                                     iterpool));
+        }
+
+      if (!is_cached)
+        SVN_ERR(prefetch_rep_state(rs, iterpool));
+    }
+
+  if (rb->src_state && !rb->base_window)
+    SVN_ERR(prefetch_rep_state(rb->src_state, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
    base representation.  Store the window in *RESULT. */
@@ -1439,13 +1516,17 @@ get_combined_window(svn_stringbuf_t **result,
   rep_state_t *rs;
   apr_pool_t *iterpool;
 
+  /* Get the I/O for all reps in the chain going at once rather than
+     waiting for each read individually in the loop below. */
+  iterpool = svn_pool_create(rb->scratch_pool);
+  SVN_ERR(prefetch_delta_windows(rb, iterpool));
+
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
      delta limits the number of deltas in a chain to well under 100.
      Stop early if one of them does not depend on its predecessors. */
   window_pool = svn_pool_create(rb->scratch_pool);
   windows = apr_array_make(window_pool, 0, sizeof(svn_txdelta_window_t *));
-  iterpool = svn_pool_create(rb->scratch_pool);
   for (i = 0; i < rb->rs_list->nelts; ++i)
     {
       svn_txdelta_window_t *window;
@@ -3009,6 +3090,48 @@ svn_fs_x__get_changes(apr_array_header_t **changes,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__find_change(int *index,
+                      svn_fs_x__changes_context_t *context,
+                      const char *path,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  svn_boolean_t found = FALSE;
+  *index = -1;
+
+  /* Only containers allow for random access to the changes.  The changes
+     lists in non-packed revisions must be parsed sequentially. */
+  if (svn_fs_x__is_packed_rev(context->fs, context->revision))
+    {
+      apr_off_t offset;
+      int *found_index;
+      svn_fs_x__pair_cache_key_t key;
+      svn_fs_x__changes_find_path_baton_t baton;
+      svn_fs_x__id_t id;
+
+      id.change_set = svn_fs_x__change_set_by_rev(context->revision);
+      id.number = SVN_FS_X__ITEM_INDEX_CHANGES;
+      baton.path = path;
+
+      SVN_ERR(svn_fs_x__item_offset(&offset, &baton.sub_item, context->fs,
+                                    context->revision_file,
+                                    &id, scratch_pool));
+      key.revision = svn_fs_x__packed_base_rev(context->fs,
+                                               context->revision);
+      key.second = offset;
+
+      SVN_ERR(svn_cache__get_partial((void **)&found_index, &found,
+                                     ffd->changes_container_cache, &key,
+                                     svn_fs_x__changes_find_path_func,
+                                     &baton, scratch_pool));
+      if (found)
+        *index = *found_index;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Fetch the representation data (header, txdelta / plain windows)
  * addressed by ENTRY->ITEM in FS and cache it under KEY.  Read the data
  * from REV_FILE.  If MAX_OFFSET is not -1, don't read windows that start
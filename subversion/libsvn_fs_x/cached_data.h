@@ -200,4 +200,15 @@ svn_fs_x__get_changes(apr_array_header_t **changes,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Set *INDEX to the position of the first change in the list read by
+ * CONTEXT whose path does not sort before PATH.  If that cannot be
+ * determined without reading the whole list, i.e. if the list is not
+ * part of a cached changes container, set *INDEX to -1.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_x__find_change(int *index,
+                      svn_fs_x__changes_context_t *context,
+                      const char *path,
+                      apr_pool_t *scratch_pool);
+
 #endif
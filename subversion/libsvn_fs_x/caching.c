@@ -298,13 +298,15 @@ init_callbacks(svn_cache__t *cache,
 /* Sets *CACHE_P to cache instance based on provided options.
  *
  * If DUMMY_CACHE is set, create a null cache.  Otherwise, creates a memcache
- * if MEMCACHE is not NULL or a membuffer cache if MEMBUFFER is not NULL.
+ * if MEMCACHE is not NULL (with a membuffer near cache if MEMBUFFER is not
+ * NULL as well) or a membuffer cache if MEMBUFFER is not NULL.
  * Falls back to inprocess cache if no other cache type has been selected
  * and PAGES is not 0.  Create a null cache otherwise.
  *
  * Use the given PRIORITY class for the new cache.  If PRIORITY is 0, then
- * use the default priority class. HAS_NAMESPACE indicates whether we
- * prefixed this cache instance with a namespace.
+ * use the default priority class.  Membuffer caches will use the ADMISSION
+ * policy.  HAS_NAMESPACE indicates whether we prefixed this cache instance
+ * with a namespace.
  *
  * Unless NO_HANDLER is true, register an error handler that reports errors
  * as warnings to the FS warning callback.
@@ -322,6 +324,7 @@ create_cache(svn_cache__t **cache_p,
              apr_ssize_t klen,
              const char *prefix,
              apr_uint32_t priority,
+             svn_cache__admission_t admission,
              svn_boolean_t has_namespace,
              svn_fs_t *fs,
              svn_boolean_t no_handler,
@@ -341,7 +344,17 @@ create_cache(svn_cache__t **cache_p,
     }
   else if (memcache)
     {
-      SVN_ERR(svn_cache__create_memcache(cache_p, memcache,
+      /* Keep the membuffer cache as a near cache in front of memcached
+       * such that hot items don't cost a network round-trip. */
+      svn_cache__t *near_cache = NULL;
+      if (membuffer)
+        SVN_ERR(svn_cache__create_membuffer_cache(
+                  &near_cache, membuffer, serializer, deserializer,
+                  klen, prefix, priority, admission, FALSE,
+                  has_namespace,
+                  result_pool, scratch_pool));
+
+      SVN_ERR(svn_cache__create_memcache(cache_p, memcache, near_cache,
                                          serializer, deserializer, klen,
                                          prefix, result_pool));
       error_handler = no_handler
@@ -354,14 +367,16 @@ create_cache(svn_cache__t **cache_p,
        * i.e. their data will not be needed after a while. */
       SVN_ERR(svn_cache__create_membuffer_cache(
                 cache_p, membuffer, serializer, deserializer,
-                klen, prefix, priority, FALSE, has_namespace,
+                klen, prefix, priority, admission, FALSE,
+                has_namespace,
                 result_pool, scratch_pool));
     }
   else if (pages)
     {
-      SVN_ERR(svn_cache__create_inprocess(
-                cache_p, serializer, deserializer, klen, pages,
-                items_per_page, FALSE, prefix, result_pool));
+      /* Evict single entries rather than whole pages. */
+      SVN_ERR(svn_cache__create_sharded(
+                cache_p, serializer, deserializer, klen, 1,
+                pages * items_per_page, 0, FALSE, prefix, result_pool));
     }
   else
     {
@@ -433,6 +448,24 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
   /* 1st level DAG node cache */
   ffd->dag_node_cache = svn_fs_x__create_dag_cache(fs->pool);
 
+  /* 2nd level DAG node cache.  Paths within a revision are immutable,
+   * so all sessions can share what any of them resolved. */
+  SVN_ERR(create_cache(&(ffd->rev_node_id_cache),
+                       NULL,
+                       membuffer,
+                       1, 1000, /* ~16 bytes / entry; 1k entries total */
+                       svn_fs_x__serialize_id,
+                       svn_fs_x__deserialize_id,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "DAGID",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
+                       has_namespace,
+                       fs,
+                       no_handler, FALSE,
+                       fs->pool, scratch_pool));
+
   /* Very rough estimate: 1K per directory. */
   SVN_ERR(create_cache(&(ffd->dir_cache),
                        NULL,
@@ -443,6 +476,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        sizeof(svn_fs_x__id_t),
                        apr_pstrcat(scratch_pool, prefix, "DIR", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -459,6 +493,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "NODEREVS",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -475,6 +510,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "REPHEADER",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -491,6 +527,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "CHANGES",
                                    SVN_VA_NULL),
                        0,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -507,6 +544,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "TEXT",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_scan_resistant,
                        has_namespace,
                        fs,
                        no_handler, !cache_fulltexts,
@@ -522,6 +560,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "PROP",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, !cache_nodeprops,
@@ -538,6 +577,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "REVPROP",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, !cache_revprops,
@@ -554,6 +594,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "TXDELTA_WINDOW",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                       svn_cache__admission_scan_resistant,
                        has_namespace,
                        fs,
                        no_handler, !cache_txdeltas,
@@ -569,6 +610,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "COMBINED_WINDOW",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                       svn_cache__admission_scan_resistant,
                        has_namespace,
                        fs,
                        no_handler, !cache_txdeltas,
@@ -585,6 +627,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "NODEREVSCNT",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -599,6 +642,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "CHANGESCNT",
                                    SVN_VA_NULL),
                        0,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -613,6 +657,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "REPSCNT",
                                    SVN_VA_NULL),
                        0,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -630,6 +675,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "L2P_HEADER",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -645,6 +691,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "L2P_PAGE",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -659,6 +706,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "P2L_HEADER",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
@@ -673,6 +721,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(scratch_pool, prefix, "P2L_PAGE",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       svn_cache__admission_default,
                        has_namespace,
                        fs,
                        no_handler, FALSE,
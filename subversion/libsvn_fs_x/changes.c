@@ -20,6 +20,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include "svn_private_config.h"
 #include "svn_sorts.h"
 
@@ -533,3 +535,69 @@ svn_fs_x__changes_get_list_func(void **out,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_fs_x__changes_find_path_func(void **out,
+                                 const void *data,
+                                 apr_size_t data_len,
+                                 void *baton,
+                                 apr_pool_t *pool)
+{
+  int lower;
+  int upper;
+  int first;
+
+  svn_fs_x__changes_find_path_baton_t *b = baton;
+  apr_uint32_t idx = b->sub_item;
+  apr_size_t path_len = strlen(b->path);
+  const svn_fs_x__changes_t *container = data;
+
+  /* resolve all the sub-container pointers we need */
+  const string_table_t *paths
+    = svn_temp_deserializer__ptr(container,
+                                 (const void *const *)&container->paths);
+  const apr_array_header_t *serialized_offsets
+    = svn_temp_deserializer__ptr(container,
+                                 (const void *const *)&container->offsets);
+  const apr_array_header_t *serialized_changes
+    = svn_temp_deserializer__ptr(container,
+                                 (const void *const *)&container->changes);
+  const int *offsets
+    = svn_temp_deserializer__ptr(serialized_offsets,
+                              (const void *const *)&serialized_offsets->elts);
+  const binary_change_t *changes
+    = svn_temp_deserializer__ptr(serialized_changes,
+                              (const void *const *)&serialized_changes->elts);
+
+  /* validate index */
+  if (idx + 1 >= (apr_size_t)serialized_offsets->nelts)
+    return svn_error_createf(SVN_ERR_FS_CONTAINER_INDEX, NULL,
+                             _("Changes list index %u exceeds container "
+                               "size %d"),
+                             (unsigned)idx, serialized_offsets->nelts - 1);
+
+  /* The lists got sorted with svn_sort_compare_items_lexically when
+   * they were written.  Use the same ordering for the binary search. */
+  first = offsets[idx];
+  lower = first;
+  upper = offsets[idx+1];
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      apr_size_t len;
+      const char *middle_path
+        = svn_fs_x__string_table_get_func(paths, changes[middle].path,
+                                          &len, pool);
+      int diff = memcmp(middle_path, b->path, MIN(len, path_len));
+
+      if (diff < 0 || (diff == 0 && len < path_len))
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  lower -= first;
+  *out = apr_pmemdup(pool, &lower, sizeof(lower));
+
+  return SVN_NO_ERROR;
+}
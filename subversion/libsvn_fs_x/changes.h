@@ -145,4 +145,27 @@ svn_fs_x__changes_get_list_func(void **out,
                                 void *baton,
                                 apr_pool_t *pool);
 
+/* Baton type to be used with svn_fs_x__changes_find_path_func. */
+typedef struct svn_fs_x__changes_find_path_baton_t
+{
+  /* Sub-item to query */
+  apr_uint32_t sub_item;
+
+  /* Path to look for. */
+  const char *path;
+} svn_fs_x__changes_find_path_baton_t;
+
+/* Implements svn_cache__partial_getter_func_t for svn_fs_x__changes_t,
+ * setting *OUT to the index (int *) of the first change within the list
+ * selected by the svn_fs_x__changes_find_path_baton_t passed in as *BATON
+ * whose path does not sort before the baton's PATH.  Change lists are
+ * sorted lexically by path, so this is a binary search.
+ */
+svn_error_t *
+svn_fs_x__changes_find_path_func(void **out,
+                                 const void *data,
+                                 apr_size_t data_len,
+                                 void *baton,
+                                 apr_pool_t *pool);
+
 #endif
@@ -467,6 +467,64 @@ svn_fs_x__invalidate_dag_cache(svn_fs_root_t *root,
 }
 
 
+/* 2nd level cache */
+
+/* Return the key under which the node for PATH in revision root ROOT is
+   stored in the 2nd level cache.  Allocate it in RESULT_POOL. */
+static const char *
+rev_node_id_key(svn_fs_root_t *root,
+                const svn_string_t *path,
+                apr_pool_t *result_pool)
+{
+  return svn_fs_x__combine_number_and_string(root->rev,
+                                             apr_pstrmemdup(result_pool,
+                                                            path->data,
+                                                            path->len),
+                                             result_pool);
+}
+
+/* Look up the node for PATH in revision root ROOT in the process-wide 2nd
+   level cache, using KEY as returned by rev_node_id_key().  If found,
+   add it to the 1st level cache and return a reference to it in *NODE_P.
+   Set *NODE_P to NULL otherwise.  Use SCRATCH_POOL for temporaries.
+
+   NOTE: *NODE_P will live within the DAG cache and we merely return a
+   reference to it.  Hence, it will invalid upon the next cache insertion.
+   Callers must create a copy if they want a non-temporary object.
+ */
+static svn_error_t *
+rev_node_id_cache_get(dag_node_t **node_p,
+                      svn_fs_root_t *root,
+                      const svn_string_t *path,
+                      const char *key,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = root->fs->fsap_data;
+  svn_fs_x__id_t *node_id;
+  svn_boolean_t found;
+  cache_entry_t *bucket;
+
+  SVN_ERR(svn_cache__get((void **)&node_id, &found, ffd->rev_node_id_cache,
+                         key, scratch_pool));
+  if (!found)
+    {
+      *node_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  auto_clear_dag_cache(ffd->dag_node_cache);
+  bucket = cache_lookup(ffd->dag_node_cache,
+                        svn_fs_x__root_change_set(root), path);
+  if (bucket->node == NULL)
+    SVN_ERR(svn_fs_x__dag_get_node(&bucket->node, root->fs, node_id,
+                                   ffd->dag_node_cache->pool,
+                                   scratch_pool));
+
+  *node_p = bucket->node;
+  return SVN_NO_ERROR;
+}
+
+
 /* Traversing directory paths.  */
 
 /* Try a short-cut for the open_path() function using the last node accessed.
@@ -651,12 +709,14 @@ walk_dag_path(dag_node_t **node_p,
               svn_string_t *path,
               apr_pool_t *scratch_pool)
 {
+  svn_fs_x__data_t *ffd = root->fs->fsap_data;
   dag_node_t *here = NULL; /* The directory we're currently looking at.  */
   apr_pool_t *iterpool;
   svn_fs_x__change_set_t change_set = svn_fs_x__root_change_set(root);
   const char *entry;
   svn_string_t directory;
   svn_stringbuf_t *entry_buffer;
+  const char *key = NULL;
 
   /* Special case: root directory.
      We will later assume that all paths have at least one parent level,
@@ -686,6 +746,12 @@ walk_dag_path(dag_node_t **node_p,
       /* Did the shortcut work? */
       if (*node_p)
           return SVN_NO_ERROR;
+
+      /* Maybe, some other session already walked this path. */
+      key = rev_node_id_key(root, path, scratch_pool);
+      SVN_ERR(rev_node_id_cache_get(node_p, root, path, key, scratch_pool));
+      if (*node_p)
+          return SVN_NO_ERROR;
     }
 
   /* Second attempt: Try starting the lookup immediately at the parent
@@ -699,33 +765,44 @@ walk_dag_path(dag_node_t **node_p,
 
       /* Did the shortcut work? */
       if (here)
-        return svn_error_trace(dag_step(node_p, root, here,
-                                        entry_buffer->data, path,
-                                        change_set, FALSE, scratch_pool));
+        {
+          SVN_ERR(dag_step(&here, root, here, entry_buffer->data, path,
+                           change_set, FALSE, scratch_pool));
+        }
     }
 
-  /* Now there is something to iterate over. Thus, create the ITERPOOL. */
-  iterpool = svn_pool_create(scratch_pool);
-
-  /* Make a parent_path item for the root node, using its own current
-     copy id.  */
-  SVN_ERR(get_root_node(&here, root, change_set, iterpool));
-  path->len = 0;
-
-  /* Walk the path segment by segment. */
-  for (entry = next_entry_name(path, entry_buffer);
-       entry;
-       entry = next_entry_name(path, entry_buffer))
+  if (here == NULL)
     {
-      svn_pool_clear(iterpool);
+      /* Now there is something to iterate over. Thus, create the ITERPOOL. */
+      iterpool = svn_pool_create(scratch_pool);
+
+      /* Make a parent_path item for the root node, using its own current
+         copy id.  */
+      SVN_ERR(get_root_node(&here, root, change_set, iterpool));
+      path->len = 0;
+
+      /* Walk the path segment by segment. */
+      for (entry = next_entry_name(path, entry_buffer);
+           entry;
+           entry = next_entry_name(path, entry_buffer))
+        {
+          svn_pool_clear(iterpool);
+
+          /* Note that HERE is allocated from the DAG node cache and will
+             therefore survive the ITERPOOL cleanup. */
+          SVN_ERR(dag_step(&here, root, here, entry, path, change_set, FALSE,
+                           iterpool));
+        }
 
-      /* Note that HERE is allocated from the DAG node cache and will
-         therefore survive the ITERPOOL cleanup. */
-      SVN_ERR(dag_step(&here, root, here, entry, path, change_set, FALSE,
-                       iterpool));
+      svn_pool_destroy(iterpool);
     }
 
-  svn_pool_destroy(iterpool);
+  /* Share the result with all other sessions. */
+  if (key)
+    SVN_ERR(svn_cache__set(ffd->rev_node_id_cache, key,
+                           (void *)svn_fs_x__dag_get_id(here),
+                           scratch_pool));
+
   *node_p = here;
 
   return SVN_NO_ERROR;
@@ -292,6 +292,7 @@ static fs_vtable_t fs_vtable = {
   x_refresh_revprops,
   svn_fs_x__revision_prop,
   x_revision_proplist,
+  NULL /* revision_proplist_range */,
   svn_fs_x__change_rev_prop,
   x_set_uuid,
   svn_fs_x__revision_root,
@@ -300,6 +301,7 @@ static fs_vtable_t fs_vtable = {
   svn_fs_x__purge_txn,
   svn_fs_x__list_transactions,
   svn_fs_x__deltify,
+  NULL /* subtree_changed */,
   svn_fs_x__lock,
   svn_fs_x__generate_lock_token,
   svn_fs_x__unlock,
@@ -310,7 +312,12 @@ static fs_vtable_t fs_vtable = {
   x_info,
   svn_fs_x__verify_root,
   x_freeze,
-  x_set_errcall
+  x_set_errcall,
+  NULL /* sync */,
+  NULL /* set_io_stats */,
+  NULL /* get_io_stats */,
+  NULL /* build_rep_cache */,
+  NULL /* open_view */
 };
 
 
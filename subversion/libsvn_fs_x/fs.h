@@ -104,6 +104,7 @@ extern "C" {
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_COMPRESSION_THREADS "compression-threads"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
@@ -111,6 +112,7 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_PREFETCH_DELTA_CHAINS "prefetch-delta-chains"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 
@@ -274,6 +276,10 @@ typedef struct svn_fs_x__data_t
   /* Rev / pack file granularity covered by phys-to-log index pages */
   apr_int64_t p2l_page_size;
 
+  /* If set, hint the OS to read the next windows of all reps in a delta
+   * chain concurrently before we combine them. */
+  svn_boolean_t prefetch_delta_chains;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -290,6 +296,12 @@ typedef struct svn_fs_x__data_t
   /* Caches native dag_node_t* instances */
   svn_fs_x__dag_cache_t *dag_node_cache;
 
+  /* 2nd level DAG node cache, shared between all svn_fs_t instances of
+     this repository.  Maps revision number and normalized path, combined
+     by svn_fs_x__combine_number_and_string(), to the svn_fs_x__id_t of the
+     respective node revision. */
+  svn_cache__t *rev_node_id_cache;
+
   /* A cache of the contents of immutable directories; maps from
      unparsed FS ID to a apr_hash_t * mapping (const char *) dirent
      names to (svn_fs_x__dirent_t *). */
@@ -394,6 +406,9 @@ typedef struct svn_fs_x__data_t
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Maximum number of threads to use when compressing delta windows. */
+  int delta_compression_threads;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
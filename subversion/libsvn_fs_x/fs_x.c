@@ -71,6 +71,10 @@
    Values < 1 disable deltification. */
 #define SVN_FS_X_MAX_DELTIFICATION_WALK 1023
 
+/* Upper limit for the number of threads used to compress the delta
+   windows of a single representation. */
+#define SVN_FS_X_MAX_COMPRESSION_THREADS 64
+
 
 
 
@@ -262,6 +266,7 @@ read_config(svn_fs_x__data_t *ffd,
 {
   svn_config_t *config;
   apr_int64_t compression_level;
+  apr_int64_t compression_threads;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -289,6 +294,13 @@ read_config(svn_fs_x__data_t *ffd,
     = (int)MIN(MAX(SVN_DELTA_COMPRESSION_LEVEL_NONE, compression_level),
                 SVN_DELTA_COMPRESSION_LEVEL_MAX);
 
+  SVN_ERR(svn_config_get_int64(config, &compression_threads,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_COMPRESSION_THREADS, 1));
+  ffd->delta_compression_threads
+    = (int)MIN(MAX(1, compression_threads),
+               SVN_FS_X_MAX_COMPRESSION_THREADS);
+
   /* Initialize revprop packing settings in ffd. */
   SVN_ERR(svn_config_get_bool(config, &ffd->compress_packed_revprops,
                               CONFIG_SECTION_PACKED_REVPROPS,
@@ -332,6 +344,11 @@ read_config(svn_fs_x__data_t *ffd,
   ffd->p2l_page_size *= 0x400;
   /* L2P pages are in entries - not in (k)Bytes */
 
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_delta_chains,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DELTA_CHAINS,
+                              FALSE));
+
   /* Debug options. */
   SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                               CONFIG_SECTION_DEBUG,
@@ -374,6 +391,14 @@ write_config(svn_fs_t *fs,
 "### no authentication for reads or writes, so you must ensure that your"    NL
 "### memcached servers are only accessible by trusted users."                NL
 ""                                                                           NL
+"[" SVN_CACHE_CONFIG_CATEGORY_MEMCACHED "]"                                  NL
+"### Writes to the memcached servers normally wait for the servers to"       NL
+"### confirm them.  Setting this option makes a background thread send"      NL
+"### them instead.  Writes may then get dropped if the servers can't keep"   NL
+"### up.  Items read from memcached are kept in the in-process cache as"     NL
+"### well such that frequently used items don't cost a network round-trip."  NL
+"# " SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES " = false"                         NL
+""                                                                           NL
 "[" CONFIG_SECTION_CACHES "]"                                                NL
 "### When a cache-related error occurs, normally Subversion ignores it"      NL
 "### and continues, logging an error if the server is appropriately"         NL
@@ -457,6 +482,14 @@ write_config(svn_fs_t *fs,
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### Compressing large files can take a long time.  Since the individual"    NL
+"### delta windows get compressed independently, that work can be spread"    NL
+"### across several threads.  This setting controls the maximum number of"   NL
+"### threads to use per representation.  Files smaller than 100 kBytes"      NL
+"### will always be processed by a single thread."                           NL
+"### The default value is 1, i.e. no additional threads."                    NL
+"# " CONFIG_OPTION_COMPRESSION_THREADS " = 1"                                NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -528,6 +561,17 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### When reconstructing a file from a chain of deltas,  the OS may be"      NL
+"### asked to fetch the required data of all deltas in that chain in the"    NL
+"### background and concurrently,  instead of one read after another."       NL
+"### This reduces latency on storage with a high access time or a good"      NL
+"### amount of internal parallelism (NFS, RAID, SSD).  It has no effect on"  NL
+"### platforms that don't support such I/O hints."                           NL
+"### The extra hints cost a system call per delta and window and can evict"  NL
+"### useful data from the OS cache when most deltas are cached anyway."      NL
+"### prefetch-delta-chains is disabled by default."                          NL
+"# " CONFIG_OPTION_PREFETCH_DELTA_CHAINS " = false"                          NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG,
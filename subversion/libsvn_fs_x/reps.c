@@ -113,6 +113,10 @@ typedef struct base_t
   apr_uint32_t rep;
 } base_t;
 
+/* Hash key type. 32 bits for pseudo-Adler32 hash sums.
+ */
+typedef apr_uint32_t hash_key_t;
+
 /* Yet another hash data structure.  This one tries to be more cache
  * friendly by putting the first byte of each hashed sequence in a
  * common array.  This array will often fit into L1 or L2 at least and
@@ -130,8 +134,10 @@ typedef struct hash_t
    */
   apr_uint32_t *offsets;
 
-  /* to be used later for optimizations. */
-  apr_uint32_t *last_matches;
+  /* for used entries i, keys[i] is the hash_key() of the sequence at
+   * offsets[i].  This saves us from re-calculating it when growing the
+   * hash. */
+  hash_key_t *keys;
 
   /* number of buckets in this hash, i.e. elements in each array above.
    * Must be 1 << (8 * sizeof(hash_key_t) - shift) */
@@ -147,10 +153,6 @@ typedef struct hash_t
   apr_pool_t *pool;
 } hash_t;
 
-/* Hash key type. 32 bits for pseudo-Adler32 hash sums.
- */
-typedef apr_uint32_t hash_key_t;
-
 /* Constructor data structure.
  */
 struct svn_fs_x__reps_builder_t
@@ -176,6 +178,9 @@ struct svn_fs_x__reps_builder_t
 
   /* number of bytes in the text corpus that belongs to bases */
   apr_size_t base_text_len;
+
+  /* statistics on the work done so far */
+  svn_fs_x__reps_builder_info_t info;
 };
 
 /* R/o container.
@@ -269,26 +274,25 @@ hash_key_replace(hash_key_t adler32, const char c_out, const char c_in)
 }
 
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
-   at DATA.  Return the checksum value.  */
+   at DATA.  Return the checksum value.
+
+   Rather than accumulating S2 from the running S1, we use the equivalent
+   closed form S2 = sum((MATCH_BLOCKSIZE - i) * DATA[i]).  All loop
+   iterations are independent then, which allows the compiler to
+   vectorize the loop.  */
 static hash_key_t
 hash_key(const char *data)
 {
   const unsigned char *input = (const unsigned char *)data;
-  const unsigned char *last = input + MATCH_BLOCKSIZE;
+  int i;
 
   hash_key_t s1 = 0;
   hash_key_t s2 = 0;
 
-  for (; input < last; input += 8)
+  for (i = 0; i < MATCH_BLOCKSIZE; ++i)
     {
-      s1 += input[0]; s2 += s1;
-      s1 += input[1]; s2 += s1;
-      s1 += input[2]; s2 += s1;
-      s1 += input[3]; s2 += s1;
-      s1 += input[4]; s2 += s1;
-      s1 += input[5]; s2 += s1;
-      s1 += input[6]; s2 += s1;
-      s1 += input[7]; s2 += s1;
+      s1 += input[i];
+      s2 += (hash_key_t)(MATCH_BLOCKSIZE - i) * input[i];
     }
 
   return s2 * 0x10000 + s1;
@@ -316,8 +320,7 @@ allocate_hash_members(hash_t *hash,
   hash->size = size;
 
   hash->prefixes = apr_pcalloc(result_pool, size);
-  hash->last_matches = apr_pcalloc(result_pool,
-                                   sizeof(*hash->last_matches) * size);
+  hash->keys = apr_pcalloc(result_pool, sizeof(*hash->keys) * size);
   hash->offsets = apr_palloc(result_pool, sizeof(*hash->offsets) * size);
 
   for (i = 0; i < size; ++i)
@@ -339,11 +342,10 @@ init_hash(hash_t *hash,
 }
 
 /* Make HASH have at least MIN_SIZE buckets but at least double the number
- * of buckets in HASH by rehashing it based TEXT.
+ * of buckets in HASH by rehashing it.
  */
 static void
 grow_hash(hash_t *hash,
-          svn_stringbuf_t *text,
           apr_size_t min_size)
 {
   hash_t copy;
@@ -369,7 +371,7 @@ grow_hash(hash_t *hash,
       apr_uint32_t offset = hash->offsets[i];
       if (offset != NO_OFFSET)
         {
-          hash_key_t key = hash_key(text->data + offset);
+          hash_key_t key = hash->keys[i];
           size_t idx = hash_to_index(&copy, key);
 
           if (copy.offsets[idx] == NO_OFFSET)
@@ -377,7 +379,7 @@ grow_hash(hash_t *hash,
 
           copy.prefixes[idx] = hash->prefixes[i];
           copy.offsets[idx] = offset;
-          copy.last_matches[idx] = hash->last_matches[i];
+          copy.keys[idx] = key;
         }
     }
 
@@ -458,7 +460,7 @@ add_new_text(svn_fs_x__reps_builder_t *builder,
   /* expand the hash upfront to minimize the chances of collisions */
   buckets_required = builder->hash.used + len / MATCH_BLOCKSIZE;
   if (buckets_required * 3 >= builder->hash.size * 2)
-    grow_hash(&builder->hash, builder->text, 2 * buckets_required);
+    grow_hash(&builder->hash, 2 * buckets_required);
 
   /* add hash entries for the new sequence */
   for (offset = instruction.offset;
@@ -477,7 +479,10 @@ add_new_text(svn_fs_x__reps_builder_t *builder,
 
       builder->hash.offsets[idx] = (apr_uint32_t)offset;
       builder->hash.prefixes[idx] = builder->text->data[offset];
+      builder->hash.keys[idx] = key;
     }
+
+  builder->info.new_text_len += len;
 }
 
 svn_error_t *
@@ -553,6 +558,7 @@ svn_fs_x__reps_add(apr_size_t *rep_idx,
           instruction.count = (apr_uint32_t)(prefix_match + postfix_match +
                                              MATCH_BLOCKSIZE);
           APR_ARRAY_PUSH(builder->instructions, instruction_t) = instruction;
+          builder->info.matched_len += instruction.count;
 
           processed = current + MATCH_BLOCKSIZE + postfix_match;
           current = processed;
@@ -564,10 +570,19 @@ svn_fs_x__reps_add(apr_size_t *rep_idx,
                         - rep.first_instruction;
   APR_ARRAY_PUSH(builder->reps, rep_t) = rep;
 
+  builder->info.rep_count++;
+  builder->info.input_len += contents->len;
+
   *rep_idx = (apr_size_t)(builder->reps->nelts - 1);
   return SVN_NO_ERROR;
 }
 
+const svn_fs_x__reps_builder_info_t *
+svn_fs_x__reps_builder_info(const svn_fs_x__reps_builder_t *builder)
+{
+  return &builder->info;
+}
+
 apr_size_t
 svn_fs_x__reps_estimate_size(const svn_fs_x__reps_builder_t *builder)
 {
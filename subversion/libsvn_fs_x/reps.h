@@ -69,6 +69,23 @@ typedef struct svn_fs_x__reps_baton_t
   apr_size_t idx;
 } svn_fs_x__reps_baton_t;
 
+/* Statistics on the work done by a svn_fs_x__reps_builder_t.
+ */
+typedef struct svn_fs_x__reps_builder_info_t
+{
+  /* number of fulltexts (including bases) added to the builder */
+  apr_size_t rep_count;
+
+  /* total size of these fulltexts in bytes */
+  apr_size_t input_len;
+
+  /* number of bytes covered by copies from existing text */
+  apr_size_t matched_len;
+
+  /* number of bytes that had to be added to the text corpus */
+  apr_size_t new_text_len;
+} svn_fs_x__reps_builder_info_t;
+
 /* Create and populate noderev containers. */
 
 /* Create and return a new builder object, allocated in RESULT_POOL.
@@ -103,6 +120,12 @@ svn_fs_x__reps_add(apr_size_t *rep_idx,
                    svn_fs_x__reps_builder_t *builder,
                    const svn_string_t *contents);
 
+/* Return the statistics collected by BUILDER so far.  The result remains
+ * valid and gets updated for as long as BUILDER exists.
+ */
+const svn_fs_x__reps_builder_info_t *
+svn_fs_x__reps_builder_info(const svn_fs_x__reps_builder_t *builder);
+
 /* Return a rough estimate in bytes for the serialized representation
  * of BUILDER.
  */
@@ -1601,11 +1601,11 @@ svn_fs_x__pack_revprops_shard(svn_fs_t *fs,
   if (start_rev == 0)
     {
       /* Never pack revprops for r0, just copy it. */
-      SVN_ERR(svn_io_copy_file(svn_fs_x__path_revprops(fs, 0, iterpool),
-                               svn_dirent_join(pack_file_dir, "p0",
-                                               scratch_pool),
-                               TRUE,
-                               iterpool));
+      SVN_ERR(svn_io_copy_file2(svn_fs_x__path_revprops(fs, 0, iterpool),
+                                svn_dirent_join(pack_file_dir, "p0",
+                                                scratch_pool),
+                                SVN_IO_COPY_FILE_PERMS, NULL,
+                                iterpool));
 
       ++start_rev;
       /* Special special case: if max_files_per_dir is 1, then at this point
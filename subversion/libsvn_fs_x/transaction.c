@@ -2309,12 +2309,14 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
                             apr_pool_cleanup_null);
 
   /* Prepare to write the svndiff data. */
-  svn_txdelta_to_svndiff3(&wh,
-                          &whb,
-                          svn_stream_disown(b->rep_stream, b->result_pool),
-                          diff_version,
-                          ffd->delta_compression_level,
-                          result_pool);
+  svn_txdelta_to_svndiff_parallel(&wh,
+                                  &whb,
+                                  svn_stream_disown(b->rep_stream,
+                                                    b->result_pool),
+                                  diff_version,
+                                  ffd->delta_compression_level,
+                                  ffd->delta_compression_threads,
+                                  result_pool);
 
   b->delta_stream = svn_txdelta_target_push(wh, whb, source,
                                             b->result_pool);
@@ -2918,12 +2920,13 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
   SVN_ERR(svn_io_file_get_offset(&delta_start, file, scratch_pool));
 
   /* Prepare to write the svndiff data. */
-  svn_txdelta_to_svndiff3(&diff_wh,
-                          &diff_whb,
-                          svn_stream_disown(file_stream, scratch_pool),
-                          diff_version,
-                          ffd->delta_compression_level,
-                          scratch_pool);
+  svn_txdelta_to_svndiff_parallel(&diff_wh,
+                                  &diff_whb,
+                                  svn_stream_disown(file_stream, scratch_pool),
+                                  diff_version,
+                                  ffd->delta_compression_level,
+                                  ffd->delta_compression_threads,
+                                  scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
   whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
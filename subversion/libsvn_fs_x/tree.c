@@ -2279,14 +2279,17 @@ typedef struct fs_revision_changes_iterator_data_t
   /* A cleanable scratch pool in case we need one.
      No further sub-pool creation necessary. */
   apr_pool_t *scratch_pool;
+
+  /* If not NULL, report only changes at or below this path. */
+  const char *path;
 } fs_revision_changes_iterator_data_t;
 
+/* Return the next change from the list that DATA iterates over in
+ * *CHANGE or NULL, if the list has been exhausted. */
 static svn_error_t *
-x_revision_changes_iterator_get(svn_fs_path_change3_t **change,
-                                svn_fs_path_change_iterator_t *iterator)
+next_revision_change(svn_fs_path_change3_t **change,
+                     fs_revision_changes_iterator_data_t *data)
 {
-  fs_revision_changes_iterator_data_t *data = iterator->fsap_data;
-
   /* If we exhausted our block of changes and did not reach the end of the
      list, yet, fetch the next block.  Note that that block may be empty. */
   if ((data->idx >= data->changes->nelts) && !data->context->eol)
@@ -2317,9 +2320,81 @@ x_revision_changes_iterator_get(svn_fs_path_change3_t **change,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+x_revision_changes_iterator_get(svn_fs_path_change3_t **change,
+                                svn_fs_path_change_iterator_t *iterator)
+{
+  fs_revision_changes_iterator_data_t *data = iterator->fsap_data;
+  apr_size_t path_len;
+
+  SVN_ERR(next_revision_change(change, data));
+  if (!data->path)
+    return SVN_NO_ERROR;
+
+  /* Changes lists are sorted lexically by path.  All paths that have
+     DATA->PATH as a string prefix form a single range in that list. */
+  path_len = strlen(data->path);
+  while (*change)
+    {
+      const char *path = (*change)->path.data;
+
+      if (strncmp(path, data->path, path_len) == 0)
+        {
+          if (svn_fspath__skip_ancestor(data->path, path))
+            break;
+        }
+      else if (strcmp(path, data->path) > 0)
+        {
+          /* Past the sub-tree.  Don't read the remainder of the list. */
+          data->context->eol = TRUE;
+          data->idx = data->changes->nelts;
+          *change = NULL;
+          break;
+        }
+
+      SVN_ERR(next_revision_change(change, data));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement changes_iterator_vtable_t.seek for in-revision change lists. */
+static svn_error_t *
+x_revision_changes_iterator_seek(svn_fs_path_change_iterator_t *iterator,
+                                 const char *path,
+                                 apr_pool_t *scratch_pool)
+{
+  fs_revision_changes_iterator_data_t *data = iterator->fsap_data;
+  data->path = path;
+
+  /* Unless we already started iterating, jump to the first change that
+     may be at or below PATH.  Otherwise, we simply filter the rest. */
+  if (data->idx == 0 && data->context->next == data->changes->nelts)
+    {
+      int index;
+      SVN_ERR(svn_fs_x__find_change(&index, data->context, path,
+                                    scratch_pool));
+
+      if (index >= data->changes->nelts)
+        {
+          /* Skip the current block and continue at INDEX. */
+          data->context->next = index;
+          data->context->eol = FALSE;
+          data->idx = data->changes->nelts;
+        }
+      else if (index > 0)
+        {
+          data->idx = index;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static changes_iterator_vtable_t rev_changes_iterator_vtable =
 {
-  x_revision_changes_iterator_get
+  x_revision_changes_iterator_get,
+  x_revision_changes_iterator_seek
 };
 
 static svn_error_t *
@@ -3222,6 +3297,7 @@ static root_vtable_t root_vtable = {
   x_file_checksum,
   x_file_contents,
   x_try_process_file_contents,
+  NULL,
   x_make_file,
   x_apply_textdelta,
   x_apply_text,
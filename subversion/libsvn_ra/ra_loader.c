@@ -54,6 +54,7 @@
 
 #include "private/svn_auth_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_trace.h"
 #include "svn_private_config.h"
 
 
@@ -256,14 +257,16 @@ svn_ra_create_callbacks(svn_ra_callbacks2_t **callbacks,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *svn_ra_open4(svn_ra_session_t **session_p,
-                          const char **corrected_url_p,
-                          const char *repos_URL,
-                          const char *uuid,
-                          const svn_ra_callbacks2_t *callbacks,
-                          void *callback_baton,
-                          apr_hash_t *config,
-                          apr_pool_t *pool)
+/* Implement svn_ra_open4() without tracing.  Parameters are the same. */
+static svn_error_t *
+open_session(svn_ra_session_t **session_p,
+             const char **corrected_url_p,
+             const char *repos_URL,
+             const char *uuid,
+             const svn_ra_callbacks2_t *callbacks,
+             void *callback_baton,
+             apr_hash_t *config,
+             apr_pool_t *pool)
 {
   apr_pool_t *sesspool = svn_pool_create(pool);
   apr_pool_t *scratch_pool = svn_pool_create(sesspool);
@@ -478,6 +481,23 @@ svn_ra__dup_session(svn_ra_session_t **new_session,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *svn_ra_open4(svn_ra_session_t **session_p,
+                          const char **corrected_url_p,
+                          const char *repos_URL,
+                          const char *uuid,
+                          const svn_ra_callbacks2_t *callbacks,
+                          void *callback_baton,
+                          apr_hash_t *config,
+                          apr_pool_t *pool)
+{
+  svn_trace__span_t *span = svn_trace__begin("ra.open");
+  svn_trace__attr(span, "url", repos_URL);
+
+  return svn_trace__end(span, open_session(session_p, corrected_url_p,
+                                           repos_URL, uuid, callbacks,
+                                           callback_baton, config, pool));
+}
+
 svn_error_t *svn_ra_reparent(svn_ra_session_t *session,
                              const char *url,
                              apr_pool_t *pool)
@@ -626,9 +646,18 @@ svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                              apr_hash_t **props,
                              apr_pool_t *pool)
 {
+  svn_trace__span_t *span;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
-  return session->vtable->get_file(session, path, revision, stream,
-                                   fetched_rev, props, pool);
+
+  span = svn_trace__begin("ra.get_file");
+  svn_trace__attr(span, "path", path);
+  svn_trace__attr_int(span, "revision", revision);
+
+  return svn_trace__end(span,
+                        session->vtable->get_file(session, path, revision,
+                                                  stream, fetched_rev, props,
+                                                  pool));
 }
 
 svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
@@ -640,9 +669,19 @@ svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                              apr_uint32_t dirent_fields,
                              apr_pool_t *pool)
 {
+  svn_trace__span_t *span;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
-  return session->vtable->get_dir(session, dirents, fetched_rev, props,
-                                  path, revision, dirent_fields, pool);
+
+  span = svn_trace__begin("ra.get_dir");
+  svn_trace__attr(span, "path", path);
+  svn_trace__attr_int(span, "revision", revision);
+
+  return svn_trace__end(span,
+                        session->vtable->get_dir(session, dirents,
+                                                 fetched_rev, props, path,
+                                                 revision, dirent_fields,
+                                                 pool));
 }
 
 svn_error_t *
@@ -656,6 +695,8 @@ svn_ra_list(svn_ra_session_t *session,
             void *receiver_baton,
             apr_pool_t *scratch_pool)
 {
+  svn_trace__span_t *span;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
   if (!session->vtable->list)
     return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
@@ -663,9 +704,170 @@ svn_ra_list(svn_ra_session_t *session,
   SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_LIST,
                                         NULL, scratch_pool));
 
-  return session->vtable->list(session, path, revision, patterns, depth,
-                               dirent_fields, receiver, receiver_baton,
-                               scratch_pool);
+  span = svn_trace__begin("ra.list");
+  svn_trace__attr(span, "path", path);
+  svn_trace__attr_int(span, "revision", revision);
+
+  return svn_trace__end(span,
+                        session->vtable->list(session, path, revision,
+                                              patterns, depth, dirent_fields,
+                                              receiver, receiver_baton,
+                                              scratch_pool));
+}
+
+/* Implement svn_ra_get_files_batch() for RA sessions that cannot send
+   the whole batch at once.  Parameters are the same. */
+static svn_error_t *
+get_files_one_by_one(svn_ra_session_t *session,
+                     const apr_array_header_t *paths,
+                     svn_revnum_t revision,
+                     svn_boolean_t want_props,
+                     svn_boolean_t want_contents,
+                     apr_uint32_t dirent_fields,
+                     svn_ra_fetch_receiver_t receiver,
+                     void *receiver_baton,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Make all paths come from the same revision. */
+  if (!SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_ra_get_latest_revnum(session, &revision, scratch_pool));
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_node_kind_t kind;
+      apr_hash_t *props = NULL;
+      apr_hash_t *dirents = NULL;
+      svn_stream_t *contents = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_check_path(session, path, revision, &kind, iterpool));
+
+      if (kind == svn_node_dir)
+        {
+          SVN_ERR(svn_ra_get_dir2(session, want_contents ? &dirents : NULL,
+                                  NULL, want_props ? &props : NULL, path,
+                                  revision, dirent_fields, iterpool));
+          SVN_ERR(receiver(receiver_baton, path, revision, kind, props,
+                           dirents, NULL, iterpool));
+        }
+      else if (kind == svn_node_file)
+        {
+          /* The receiver wants the props before it provides the stream
+             for the contents, so this may take two requests. */
+          if (want_props)
+            SVN_ERR(svn_ra_get_file(session, path, revision, NULL, NULL,
+                                    &props, iterpool));
+          SVN_ERR(receiver(receiver_baton, path, revision, kind, props,
+                           NULL, want_contents ? &contents : NULL,
+                           iterpool));
+          if (contents)
+            {
+              SVN_ERR(svn_ra_get_file(session, path, revision, contents,
+                                      NULL, NULL, iterpool));
+              SVN_ERR(svn_stream_close(contents));
+            }
+        }
+      else
+        {
+          SVN_ERR(receiver(receiver_baton, path, revision, kind, NULL,
+                           NULL, NULL, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_get_files_batch(svn_ra_session_t *session,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       svn_boolean_t want_props,
+                       svn_boolean_t want_contents,
+                       apr_uint32_t dirent_fields,
+                       svn_ra_fetch_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_batch = FALSE;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+    }
+
+  if (session->vtable->get_files_batch)
+    SVN_ERR(svn_ra_has_capability(session, &has_batch,
+                                  SVN_RA_CAPABILITY_GET_FILES_BATCH,
+                                  scratch_pool));
+
+  if (has_batch)
+    return session->vtable->get_files_batch(session, paths, revision,
+                                            want_props, want_contents,
+                                            dirent_fields,
+                                            receiver, receiver_baton,
+                                            scratch_pool);
+
+  return svn_error_trace(get_files_one_by_one(session, paths, revision,
+                                              want_props, want_contents,
+                                              dirent_fields,
+                                              receiver, receiver_baton,
+                                              scratch_pool));
+}
+
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_stat_many = FALSE;
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+    }
+
+  if (session->vtable->stat_many)
+    SVN_ERR(svn_ra_has_capability(session, &has_stat_many,
+                                  SVN_RA_CAPABILITY_STAT_MANY,
+                                  scratch_pool));
+
+  if (has_stat_many)
+    return session->vtable->stat_many(session, dirents, paths, revision,
+                                      result_pool, scratch_pool);
+
+  /* Make all paths come from the same revision. */
+  if (!SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_ra_get_latest_revnum(session, &revision, scratch_pool));
+
+  *dirents = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_stat(session, path, revision, &dirent, iterpool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path),
+                      svn_dirent_dup(dirent, result_pool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
@@ -699,6 +901,117 @@ svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
                                         include_descendants, pool);
 }
 
+#ifndef SVN_DISABLE_TRACING
+
+/* Baton for the tracing reporter. */
+typedef struct trace_report_baton_t
+{
+  /* The reporter and its baton that we forward all calls to. */
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  /* Name of the span covering finish_report(), i.e. the actual edit. */
+  const char *span_name;
+} trace_report_baton_t;
+
+/* Implements svn_ra_reporter3_t.set_path for the tracing reporter. */
+static svn_error_t *
+trace_set_path(void *report_baton,
+               const char *path,
+               svn_revnum_t revision,
+               svn_depth_t depth,
+               svn_boolean_t start_empty,
+               const char *lock_token,
+               apr_pool_t *pool)
+{
+  trace_report_baton_t *b = report_baton;
+  return b->reporter->set_path(b->report_baton, path, revision, depth,
+                               start_empty, lock_token, pool);
+}
+
+/* Implements svn_ra_reporter3_t.delete_path for the tracing reporter. */
+static svn_error_t *
+trace_delete_path(void *report_baton,
+                  const char *path,
+                  apr_pool_t *pool)
+{
+  trace_report_baton_t *b = report_baton;
+  return b->reporter->delete_path(b->report_baton, path, pool);
+}
+
+/* Implements svn_ra_reporter3_t.link_path for the tracing reporter. */
+static svn_error_t *
+trace_link_path(void *report_baton,
+                const char *path,
+                const char *url,
+                svn_revnum_t revision,
+                svn_depth_t depth,
+                svn_boolean_t start_empty,
+                const char *lock_token,
+                apr_pool_t *pool)
+{
+  trace_report_baton_t *b = report_baton;
+  return b->reporter->link_path(b->report_baton, path, url, revision, depth,
+                                start_empty, lock_token, pool);
+}
+
+/* Implements svn_ra_reporter3_t.finish_report for the tracing reporter. */
+static svn_error_t *
+trace_finish_report(void *report_baton,
+                    apr_pool_t *pool)
+{
+  trace_report_baton_t *b = report_baton;
+  svn_trace__span_t *span = svn_trace__begin(b->span_name);
+
+  return svn_trace__end(span, b->reporter->finish_report(b->report_baton,
+                                                         pool));
+}
+
+/* Implements svn_ra_reporter3_t.abort_report for the tracing reporter. */
+static svn_error_t *
+trace_abort_report(void *report_baton,
+                   apr_pool_t *pool)
+{
+  trace_report_baton_t *b = report_baton;
+  return b->reporter->abort_report(b->report_baton, pool);
+}
+
+static const svn_ra_reporter3_t trace_reporter =
+{
+  trace_set_path,
+  trace_delete_path,
+  trace_link_path,
+  trace_finish_report,
+  trace_abort_report
+};
+
+#endif
+
+/* If tracing is enabled, replace *REPORTER and *REPORT_BATON with a
+ * reporter that runs finish_report() within a span named SPAN_NAME.
+ * Allocate the wrapper in RESULT_POOL. */
+static void
+trace_report(const svn_ra_reporter3_t **reporter,
+             void **report_baton,
+             const char *span_name,
+             apr_pool_t *result_pool)
+{
+#ifndef SVN_DISABLE_TRACING
+  trace_report_baton_t *b;
+
+  if (!svn_trace__enabled())
+    return;
+
+  b = apr_palloc(result_pool, sizeof(*b));
+  b->reporter = *reporter;
+  b->report_baton = *report_baton;
+  b->span_name = span_name;
+
+  *reporter = &trace_reporter;
+  *report_baton = b;
+#endif
+}
+
 svn_error_t *
 svn_ra_do_update3(svn_ra_session_t *session,
                   const svn_ra_reporter3_t **reporter,
@@ -715,13 +1028,16 @@ svn_ra_do_update3(svn_ra_session_t *session,
 {
   SVN_ERR_ASSERT(svn_path_is_empty(update_target)
                  || svn_path_is_single_path_component(update_target));
-  return session->vtable->do_update(session,
-                                    reporter, report_baton,
-                                    revision_to_update_to, update_target,
-                                    depth, send_copyfrom_args,
-                                    ignore_ancestry,
-                                    update_editor, update_baton,
-                                    result_pool, scratch_pool);
+  SVN_ERR(session->vtable->do_update(session,
+                                     reporter, report_baton,
+                                     revision_to_update_to, update_target,
+                                     depth, send_copyfrom_args,
+                                     ignore_ancestry,
+                                     update_editor, update_baton,
+                                     result_pool, scratch_pool));
+  trace_report(reporter, report_baton, "ra.update", result_pool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -741,15 +1057,18 @@ svn_ra_do_switch3(svn_ra_session_t *session,
 {
   SVN_ERR_ASSERT(svn_path_is_empty(switch_target)
                  || svn_path_is_single_path_component(switch_target));
-  return session->vtable->do_switch(session,
-                                    reporter, report_baton,
-                                    revision_to_switch_to, switch_target,
-                                    depth, switch_url,
-                                    send_copyfrom_args,
-                                    ignore_ancestry,
-                                    switch_editor,
-                                    switch_baton,
-                                    result_pool, scratch_pool);
+  SVN_ERR(session->vtable->do_switch(session,
+                                     reporter, report_baton,
+                                     revision_to_switch_to, switch_target,
+                                     depth, switch_url,
+                                     send_copyfrom_args,
+                                     ignore_ancestry,
+                                     switch_editor,
+                                     switch_baton,
+                                     result_pool, scratch_pool));
+  trace_report(reporter, report_baton, "ra.switch", result_pool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_ra_do_status2(svn_ra_session_t *session,
@@ -764,10 +1083,13 @@ svn_error_t *svn_ra_do_status2(svn_ra_session_t *session,
 {
   SVN_ERR_ASSERT(svn_path_is_empty(status_target)
                  || svn_path_is_single_path_component(status_target));
-  return session->vtable->do_status(session,
-                                    reporter, report_baton,
-                                    status_target, revision, depth,
-                                    status_editor, status_baton, pool);
+  SVN_ERR(session->vtable->do_status(session,
+                                     reporter, report_baton,
+                                     status_target, revision, depth,
+                                     status_editor, status_baton, pool));
+  trace_report(reporter, report_baton, "ra.status", pool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_ra_do_diff3(svn_ra_session_t *session,
@@ -785,12 +1107,15 @@ svn_error_t *svn_ra_do_diff3(svn_ra_session_t *session,
 {
   SVN_ERR_ASSERT(svn_path_is_empty(diff_target)
                  || svn_path_is_single_path_component(diff_target));
-  return session->vtable->do_diff(session,
-                                  reporter, report_baton,
-                                  revision, diff_target,
-                                  depth, ignore_ancestry,
-                                  text_deltas, versus_url, diff_editor,
-                                  diff_baton, pool);
+  SVN_ERR(session->vtable->do_diff(session,
+                                   reporter, report_baton,
+                                   revision, diff_target,
+                                   depth, ignore_ancestry,
+                                   text_deltas, versus_url, diff_editor,
+                                   diff_baton, pool));
+  trace_report(reporter, report_baton, "ra.diff", pool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
@@ -806,6 +1131,8 @@ svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
                              void *receiver_baton,
                              apr_pool_t *pool)
 {
+  svn_trace__span_t *span;
+
   if (paths)
     {
       int i;
@@ -819,10 +1146,19 @@ svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
   if (include_merged_revisions)
     SVN_ERR(svn_ra__assert_mergeinfo_capable_server(session, NULL, pool));
 
-  return session->vtable->get_log(session, paths, start, end, limit,
-                                  discover_changed_paths, strict_node_history,
-                                  include_merged_revisions, revprops,
-                                  receiver, receiver_baton, pool);
+  span = svn_trace__begin("ra.get_log");
+  svn_trace__attr_int(span, "start", start);
+  svn_trace__attr_int(span, "end", end);
+  svn_trace__attr_int(span, "limit", limit);
+
+  return svn_trace__end(span,
+                        session->vtable->get_log(session, paths, start, end,
+                                                 limit,
+                                                 discover_changed_paths,
+                                                 strict_node_history,
+                                                 include_merged_revisions,
+                                                 revprops, receiver,
+                                                 receiver_baton, pool));
 }
 
 svn_error_t *svn_ra_check_path(svn_ra_session_t *session,
@@ -1065,6 +1401,27 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_ra_get_file_annotation(svn_ra_session_t *session,
+                           const char *path,
+                           svn_revnum_t revision,
+                           svn_ra_annotate_receiver_t receiver,
+                           void *receiver_baton,
+                           apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  if (!session->vtable->get_file_annotation)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session,
+                                        SVN_RA_CAPABILITY_FILE_ANNOTATION,
+                                        NULL, scratch_pool));
+
+  return session->vtable->get_file_annotation(session, path, revision,
+                                              receiver, receiver_baton,
+                                              scratch_pool);
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
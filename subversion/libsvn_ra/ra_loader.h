@@ -343,6 +343,35 @@ typedef struct svn_ra__vtable_t {
                        void *receiver_baton,
                        apr_pool_t *scratch_pool);
 
+  /* See svn_ra_get_file_annotation(). */
+  svn_error_t *(*get_file_annotation)(svn_ra_session_t *session,
+                                      const char *path,
+                                      svn_revnum_t revision,
+                                      svn_ra_annotate_receiver_t receiver,
+                                      void *receiver_baton,
+                                      apr_pool_t *scratch_pool);
+
+  /* See svn_ra_get_files_batch().  May be NULL, in which case the RA
+     loader falls back to individual requests. */
+  svn_error_t *(*get_files_batch)(svn_ra_session_t *session,
+                                  const apr_array_header_t *paths,
+                                  svn_revnum_t revision,
+                                  svn_boolean_t want_props,
+                                  svn_boolean_t want_contents,
+                                  apr_uint32_t dirent_fields,
+                                  svn_ra_fetch_receiver_t receiver,
+                                  void *receiver_baton,
+                                  apr_pool_t *scratch_pool);
+
+  /* See svn_ra_stat_many().  May be NULL, in which case the RA loader
+     falls back to individual requests. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            apr_hash_t **dirents,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
@@ -369,6 +369,11 @@ make_reporter(svn_ra_session_t *session,
                                         additional details. */
                                   result_pool));
 
+  /* The editor lives in the same process as the repository, so computing
+     text deltas only costs CPU time on both sides.  Hand it the contents
+     as they are. */
+  svn_repos__report_set_send_fulltexts(rbaton, TRUE);
+
   /* Wrap the report baton given us by the repos layer with our own
      reporter baton. */
   *report_baton = make_reporter_baton(sess, rbaton, result_pool);
@@ -1210,6 +1215,43 @@ svn_ra_local__stat(svn_ra_session_t *session,
   return svn_repos_stat(dirent, root, abs_path, pool);
 }
 
+static svn_error_t *
+svn_ra_local__stat_many(svn_ra_session_t *session,
+                        apr_hash_t **dirents,
+                        const apr_array_header_t *paths,
+                        svn_revnum_t revision,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_fs_youngest_rev(&revision, sess->fs, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, scratch_pool));
+
+  *dirents = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_repos_stat(&dirent, root,
+                             svn_fspath__join(sess->fs_path->data, path,
+                                              iterpool),
+                             result_pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), dirent);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 
@@ -1673,6 +1715,8 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_FILE_ANNOTATION) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_STAT_MANY) == 0
       )
     {
       *has = TRUE;
@@ -1863,6 +1907,54 @@ svn_ra_local__list(svn_ra_session_t *session,
                                         sess->callback_baton, pool));
 }
 
+/* Trivially forward repos-layer callbacks to RA-layer callbacks.
+ * Their signatures are the same. */
+typedef struct annotate_receiver_baton_t
+{
+  svn_ra_annotate_receiver_t receiver;
+  void *receiver_baton;
+} annotate_receiver_baton_t;
+
+static svn_error_t *
+annotate_receiver(void *baton,
+                  apr_int64_t line_no,
+                  svn_revnum_t revision,
+                  const svn_string_t *line,
+                  apr_pool_t *scratch_pool)
+{
+  annotate_receiver_baton_t *b = baton;
+  return b->receiver(b->receiver_baton, line_no, revision, line,
+                     scratch_pool);
+}
+
+static svn_error_t *
+svn_ra_local__get_file_annotation(svn_ra_session_t *session,
+                                  const char *path,
+                                  svn_revnum_t revision,
+                                  svn_ra_annotate_receiver_t receiver,
+                                  void *receiver_baton,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path,
+                                          scratch_pool);
+
+  annotate_receiver_baton_t baton;
+  baton.receiver = receiver;
+  baton.receiver_baton = receiver_baton;
+
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_fs_youngest_rev(&revision, sess->fs, scratch_pool));
+
+  return svn_error_trace(svn_repos_get_file_annotation(
+                           sess->repos, abs_path, revision, NULL, NULL,
+                           annotate_receiver, &baton,
+                           sess->callbacks
+                             ? sess->callbacks->cancel_func
+                             : NULL,
+                           sess->callback_baton, scratch_pool));
+}
+
 /*----------------------------------------------------------------*/
 
 static const svn_version_t *
@@ -1914,6 +2006,9 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  svn_ra_local__get_file_annotation,
+  NULL /* get_files_batch */,
+  svn_ra_local__stat_many,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
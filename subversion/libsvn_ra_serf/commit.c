@@ -40,6 +40,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_skel.h"
+#include "private/svn_sorts_private.h"
 
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
@@ -72,10 +73,20 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* PUT and PROPPATCH requests of closed files that are still in flight
+     (pending_file_t *), and the maximum number of them.  Errors of these
+     requests get reported by later editor calls, at the latest by
+     close_edit(). */
+  apr_array_header_t *pending_files;
+  int max_pending_files;
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
 
+/* Maximum number of pending file requests per connection. */
+#define MAX_PENDING_FILES_PER_CONN 4
+
 /* Structure associated with a PROPPATCH request. */
 typedef struct proppatch_context_t {
   apr_pool_t *pool;
@@ -194,8 +205,28 @@ typedef struct file_context_t {
   /* URL to PUT the file at. */
   const char *url;
 
+  /* Pool for the svndiff that survives the file baton, so that the
+     PUT may complete after close_file().  NULL if not used. */
+  apr_pool_t *put_pool;
+
 } file_context_t;
 
+/* The requests of a closed file that are still in flight. */
+typedef struct pending_file_t {
+  /* Pool holding the requests and everything they refer to. */
+  apr_pool_t *pool;
+
+  /* Copy of the file's context, allocated in POOL. */
+  file_context_t *file;
+
+  /* The request currently in flight and its expected status code. */
+  svn_ra_serf__handler_t *handler;
+  int expected_result;
+
+  /* The PROPPATCH to send once the PUT completed, or NULL. */
+  proppatch_context_t *proppatch;
+} pending_file_t;
+
 
 /* Setup routines and handlers for various requests we'll invoke. */
 
@@ -829,13 +860,14 @@ create_proppatch_body(serf_bucket_t **bkt,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t*
-proppatch_resource(svn_ra_serf__session_t *session,
-                   proppatch_context_t *proppatch,
-                   apr_pool_t *pool)
+/* Return a new handler for the PROPPATCH request PROPPATCH using
+   SESSION, allocated in POOL. */
+static svn_ra_serf__handler_t *
+create_proppatch_handler(svn_ra_serf__session_t *session,
+                         proppatch_context_t *proppatch,
+                         apr_pool_t *pool)
 {
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
   handler = svn_ra_serf__create_handler(session, pool);
 
@@ -852,8 +884,15 @@ proppatch_resource(svn_ra_serf__session_t *session,
   handler->response_handler = svn_ra_serf__handle_multistatus_only;
   handler->response_baton = handler;
 
-  err = svn_ra_serf__context_run_one(handler, pool);
+  return handler;
+}
 
+/* Return the result of the completed PROPPATCH HANDLER, given ERR as
+   returned while running it. */
+static svn_error_t *
+proppatch_result(svn_ra_serf__handler_t *handler,
+                 svn_error_t *err)
+{
   if (!err && handler->sline.code != 207)
     err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
@@ -873,6 +912,20 @@ proppatch_resource(svn_ra_serf__session_t *session,
   return svn_error_trace(err);
 }
 
+static svn_error_t*
+proppatch_resource(svn_ra_serf__session_t *session,
+                   proppatch_context_t *proppatch,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  handler = create_proppatch_handler(session, proppatch, pool);
+  err = svn_ra_serf__context_run_one(handler, pool);
+
+  return svn_error_trace(proppatch_result(handler, err));
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_empty_put_body(serf_bucket_t **body_bkt,
@@ -1955,10 +2008,17 @@ apply_textdelta(void *file_baton,
    * It will be used with most recent servers having the "send result checksum
    * in response to a PUT" capability, and only if the editor driver uses the
    * new callback.
+   *
+   * If the PUT may still be in flight after close_file(), the body must
+   * outlive the file baton.
    */
+  if (ctx->commit_ctx->max_pending_files > 0)
+    ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
+
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool ? ctx->put_pool
+                                                   : ctx->pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
   negotiate_put_encoding(&svndiff_version, &compression_level,
@@ -2062,6 +2122,26 @@ apply_textdelta_stream(const svn_delta_editor_t *editor,
   int expected_result;
   svn_error_t *err;
 
+  /* Streaming the body ties the PUT to the lifetime of OPEN_BATON.  To be
+   * able to have several PUTs in flight, spool the svndiff instead and let
+   * close_file() send it.
+   */
+  if (ctx->commit_ctx->max_pending_files > 0)
+    {
+      svn_txdelta_stream_t *txdelta_stream;
+      svn_txdelta_window_handler_t handler_func;
+      void *handler_baton;
+
+      SVN_ERR(open_func(&txdelta_stream, open_baton, scratch_pool,
+                        scratch_pool));
+      SVN_ERR(apply_textdelta(file_baton, base_checksum, scratch_pool,
+                              &handler_func, &handler_baton));
+      return svn_error_trace(svn_txdelta_send_txstream(txdelta_stream,
+                                                       handler_func,
+                                                       handler_baton,
+                                                       scratch_pool));
+    }
+
   /* Remember that we have sent the svndiff.  A case when we need to
    * perform a zero-byte file PUT (during add_file, close_file editor
    * sequences) is handled in close_file().
@@ -2114,6 +2194,311 @@ apply_textdelta_stream(const svn_delta_editor_t *editor,
   return SVN_NO_ERROR;
 }
 
+/* Set *CONN to the connection to send the next pending file request over,
+   opening additional connections up to the session's limit as needed. */
+static svn_error_t *
+get_pending_file_connection(svn_ra_serf__connection_t **conn,
+                            commit_context_t *ctx)
+{
+  svn_ra_serf__session_t *sess = ctx->session;
+
+  /* Http/2 multiplexes everything over the main connection. */
+  if (!sess->http20 && sess->num_conns < sess->max_connections)
+    {
+      int cur = sess->num_conns;
+      apr_status_t status;
+
+      sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
+      sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                                 NULL, NULL);
+      sess->conns[cur]->last_status_code = -1;
+      sess->conns[cur]->session = sess;
+      status = serf_connection_create2(&sess->conns[cur]->conn,
+                                       sess->context,
+                                       sess->session_url,
+                                       svn_ra_serf__conn_setup,
+                                       sess->conns[cur],
+                                       svn_ra_serf__conn_closed,
+                                       sess->conns[cur],
+                                       sess->pool);
+      if (status)
+        return svn_ra_serf__wrap_err(status, NULL);
+
+      sess->num_conns++;
+    }
+
+  /* Same stupid algorithm from get_best_connection() in update.c */
+  *conn = sess->conns[sess->cur_conn];
+  sess->cur_conn++;
+
+  if (sess->cur_conn >= sess->num_conns)
+    sess->cur_conn = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *HANDLER to a new handler for the PUT request of the file CTX and
+   *EXPECTED_RESULT to the status code indicating success.  If
+   PUT_EMPTY_FILE is set, send an empty body instead of CTX's svndiff.
+   Allocate the handler in POOL. */
+static svn_error_t *
+create_put_handler(svn_ra_serf__handler_t **handler_p,
+                   int *expected_result,
+                   file_context_t *ctx,
+                   svn_boolean_t put_empty_file,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+
+  handler = svn_ra_serf__create_handler(ctx->commit_ctx->session, pool);
+
+  handler->method = "PUT";
+  handler->path = ctx->url;
+
+  if (ctx->commit_ctx->session->supports_put_result_checksum)
+    {
+      put_response_ctx_t *prc = apr_pcalloc(pool, sizeof(*prc));
+
+      prc->handler = handler;
+      prc->file_ctx = ctx;
+
+      handler->response_handler = put_response_handler;
+      handler->response_baton = prc;
+    }
+  else
+    {
+      handler->response_handler = svn_ra_serf__expect_empty_body;
+      handler->response_baton = handler;
+    }
+
+  if (put_empty_file)
+    {
+      handler->body_delegate = create_empty_put_body;
+      handler->body_delegate_baton = ctx;
+      handler->body_type = "text/plain";
+    }
+  else
+    {
+      SVN_ERR(svn_stream_close(ctx->stream));
+
+      svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                             &handler->body_delegate_baton,
+                                             ctx->svndiff);
+      handler->body_type = SVN_SVNDIFF_MIME_TYPE;
+    }
+
+  handler->header_delegate = setup_put_headers;
+  handler->header_delegate_baton = ctx;
+
+  if (ctx->added && ! ctx->copy_path)
+    *expected_result = 201; /* Created */
+  else
+    *expected_result = 204; /* Updated */
+
+  *handler_p = handler;
+  return SVN_NO_ERROR;
+}
+
+/* Return a PROPPATCH request for the property changes of the file CTX,
+   allocated in POOL. */
+static proppatch_context_t *
+make_file_proppatch(file_context_t *ctx,
+                    apr_pool_t *pool)
+{
+  proppatch_context_t *proppatch;
+
+  proppatch = apr_pcalloc(pool, sizeof(*proppatch));
+  proppatch->pool = pool;
+  proppatch->relpath = ctx->relpath;
+  proppatch->path = ctx->url;
+  proppatch->commit_ctx = ctx->commit_ctx;
+  proppatch->prop_changes = ctx->prop_changes;
+  proppatch->base_revision = ctx->base_revision;
+
+  return proppatch;
+}
+
+/* Compare the result checksum that the driver reported for the file CTX
+   with the one the server reported, if any. */
+static svn_error_t *
+verify_result_checksum(file_context_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *result_checksum;
+
+  if (!ctx->result_checksum || !ctx->remote_result_checksum)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_checksum_parse_hex(&result_checksum, svn_checksum_md5,
+                                 ctx->result_checksum, scratch_pool));
+
+  if (!svn_checksum_match(result_checksum, ctx->remote_result_checksum))
+    return svn_checksum_mismatch_err(result_checksum,
+                                     ctx->remote_result_checksum,
+                                     scratch_pool,
+                                     _("Checksum mismatch for '%s'"),
+                                     svn_dirent_local_style(ctx->relpath,
+                                                            scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the requests of the closed file CTX without waiting for them to
+   complete.  SEND_PUT and PUT_EMPTY_FILE are as determined by
+   close_file().  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+queue_pending_file(file_context_t *ctx,
+                   svn_boolean_t send_put,
+                   svn_boolean_t put_empty_file,
+                   apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = ctx->commit_ctx;
+  pending_file_t *pending;
+  file_context_t *file;
+  apr_pool_t *pool;
+  apr_hash_index_t *hi;
+
+  /* The file baton's pool may go away before the requests complete, so
+     copy everything they need into a pool of their own.  The svndiff is
+     already in PUT_POOL. */
+  pool = ctx->put_pool ? ctx->put_pool : svn_pool_create(commit_ctx->pool);
+
+  file = apr_pmemdup(pool, ctx, sizeof(*ctx));
+  file->pool = pool;
+  file->parent_dir = NULL;
+  file->relpath = apr_pstrdup(pool, ctx->relpath);
+  file->name = svn_relpath_basename(file->relpath, NULL);
+  file->url = apr_pstrdup(pool, ctx->url);
+  file->copy_path = apr_pstrdup(pool, ctx->copy_path);
+  file->base_checksum = apr_pstrdup(pool, ctx->base_checksum);
+  file->result_checksum = apr_pstrdup(pool, ctx->result_checksum);
+  file->prop_changes = apr_hash_make(pool);
+  for (hi = apr_hash_first(scratch_pool, ctx->prop_changes);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const svn_prop_t *prop = apr_hash_this_val(hi);
+      svn_prop_t *new_prop = apr_palloc(pool, sizeof(*new_prop));
+
+      new_prop->name = apr_pstrdup(pool, prop->name);
+      new_prop->value = prop->value ? svn_string_dup(prop->value, pool)
+                                    : NULL;
+      svn_hash_sets(file->prop_changes, new_prop->name, new_prop);
+    }
+
+  pending = apr_pcalloc(pool, sizeof(*pending));
+  pending->pool = pool;
+  pending->file = file;
+
+  if (apr_hash_count(file->prop_changes))
+    pending->proppatch = make_file_proppatch(file, pool);
+
+  if (send_put)
+    {
+      SVN_ERR(create_put_handler(&pending->handler,
+                                 &pending->expected_result,
+                                 file, put_empty_file, pool));
+    }
+  else
+    {
+      pending->handler = create_proppatch_handler(commit_ctx->session,
+                                                  pending->proppatch, pool);
+      pending->expected_result = 207;
+      pending->proppatch = NULL;
+    }
+
+  SVN_ERR(get_pending_file_connection(&pending->handler->conn, commit_ctx));
+  svn_ra_serf__request_create(pending->handler);
+
+  APR_ARRAY_PUSH(commit_ctx->pending_files, pending_file_t *) = pending;
+
+  return SVN_NO_ERROR;
+}
+
+/* Handle the completed pending file requests of CTX and run the serf
+   context until no more than MAX_PENDING of them are in flight.  Use
+   SCRATCH_POOL for temporaries. */
+static svn_error_t *
+process_pending_files(commit_context_t *ctx,
+                      int max_pending,
+                      apr_pool_t *scratch_pool)
+{
+  apr_interval_time_t waittime_left = ctx->session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      for (i = 0; i < ctx->pending_files->nelts; )
+        {
+          pending_file_t *pending = APR_ARRAY_IDX(ctx->pending_files, i,
+                                                  pending_file_t *);
+          svn_ra_serf__handler_t *handler = pending->handler;
+
+          if (!handler->done)
+            {
+              i++;
+              continue;
+            }
+
+          if (pending->expected_result == 207)
+            SVN_ERR(proppatch_result(handler, SVN_NO_ERROR));
+          else if (handler->sline.code != pending->expected_result)
+            return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+          /* Property changes must be applied to the resource created by
+             the PUT, so send them only now. */
+          if (pending->proppatch)
+            {
+              pending->handler
+                = create_proppatch_handler(ctx->session, pending->proppatch,
+                                           pending->pool);
+              pending->expected_result = 207;
+              pending->proppatch = NULL;
+
+              pending->handler->conn = handler->conn;
+              svn_ra_serf__request_create(pending->handler);
+              i++;
+              continue;
+            }
+
+          SVN_ERR(verify_result_checksum(pending->file, iterpool));
+          if (pending->file->svndiff)
+            SVN_ERR(svn_ra_serf__request_body_cleanup(pending->file->svndiff,
+                                                      iterpool));
+          svn_pool_destroy(pending->pool);
+
+          svn_sort__array_delete(ctx->pending_files, i, 1);
+        }
+
+      if (ctx->pending_files->nelts <= max_pending)
+        break;
+
+      SVN_ERR(svn_ra_serf__context_run(ctx->session, &waittime_left,
+                                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Cancel all pending file requests of CTX. */
+static void
+cancel_pending_files(commit_context_t *ctx)
+{
+  int i;
+
+  /* Destroying the pools unregisters the requests. */
+  for (i = 0; i < ctx->pending_files->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(ctx->pending_files, i,
+                                   pending_file_t *)->pool);
+
+  apr_array_clear(ctx->pending_files);
+}
+
 static svn_error_t *
 change_file_prop(void *file_baton,
                  const char *name,
@@ -2149,46 +2534,38 @@ close_file(void *file_baton,
   if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
     put_empty_file = TRUE;
 
-  /* If we have a stream of changes, push them to the server... */
-  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
+  /* Don't wait for the requests to complete if we may have several of
+     them in flight.  Make room for this file's requests first. */
+  if (ctx->commit_ctx->max_pending_files > 0)
     {
-      svn_ra_serf__handler_t *handler;
-      int expected_result;
-
-      handler = svn_ra_serf__create_handler(ctx->commit_ctx->session,
-                                            scratch_pool);
+      svn_boolean_t send_put = (ctx->svndiff || put_empty_file)
+                               && !ctx->svndiff_sent;
 
-      handler->method = "PUT";
-      handler->path = ctx->url;
-
-      handler->response_handler = svn_ra_serf__expect_empty_body;
-      handler->response_baton = handler;
-
-      if (put_empty_file)
+      if (send_put || apr_hash_count(ctx->prop_changes))
         {
-          handler->body_delegate = create_empty_put_body;
-          handler->body_delegate_baton = ctx;
-          handler->body_type = "text/plain";
+          SVN_ERR(process_pending_files(ctx->commit_ctx,
+                                        ctx->commit_ctx->max_pending_files
+                                          - 1,
+                                        scratch_pool));
+          SVN_ERR(queue_pending_file(ctx, send_put, put_empty_file,
+                                     scratch_pool));
         }
-      else
-        {
-          SVN_ERR(svn_stream_close(ctx->stream));
 
-          svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
-                                                 &handler->body_delegate_baton,
-                                                 ctx->svndiff);
-          handler->body_type = SVN_SVNDIFF_MIME_TYPE;
-        }
+      ctx->commit_ctx->open_batons--;
 
-      handler->header_delegate = setup_put_headers;
-      handler->header_delegate_baton = ctx;
+      return SVN_NO_ERROR;
+    }
 
-      SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+  /* If we have a stream of changes, push them to the server... */
+  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
+    {
+      svn_ra_serf__handler_t *handler;
+      int expected_result;
 
-      if (ctx->added && ! ctx->copy_path)
-        expected_result = 201; /* Created */
-      else
-        expected_result = 204; /* Updated */
+      SVN_ERR(create_put_handler(&handler, &expected_result, ctx,
+                                 put_empty_file, scratch_pool));
+
+      SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
       if (handler->sline.code != expected_result)
         return svn_error_trace(svn_ra_serf__unexpected_status(handler));
@@ -2200,36 +2577,11 @@ close_file(void *file_baton,
 
   /* If we had any prop changes, push them via PROPPATCH. */
   if (apr_hash_count(ctx->prop_changes))
-    {
-      proppatch_context_t *proppatch;
-
-      proppatch = apr_pcalloc(scratch_pool, sizeof(*proppatch));
-      proppatch->pool = scratch_pool;
-      proppatch->relpath = ctx->relpath;
-      proppatch->path = ctx->url;
-      proppatch->commit_ctx = ctx->commit_ctx;
-      proppatch->prop_changes = ctx->prop_changes;
-      proppatch->base_revision = ctx->base_revision;
-
-      SVN_ERR(proppatch_resource(ctx->commit_ctx->session,
-                                 proppatch, scratch_pool));
-    }
-
-  if (ctx->result_checksum && ctx->remote_result_checksum)
-    {
-      svn_checksum_t *result_checksum;
-
-      SVN_ERR(svn_checksum_parse_hex(&result_checksum, svn_checksum_md5,
-                                     ctx->result_checksum, scratch_pool));
+    SVN_ERR(proppatch_resource(ctx->commit_ctx->session,
+                               make_file_proppatch(ctx, scratch_pool),
+                               scratch_pool));
 
-      if (!svn_checksum_match(result_checksum, ctx->remote_result_checksum))
-        return svn_checksum_mismatch_err(result_checksum,
-                                         ctx->remote_result_checksum,
-                                         scratch_pool,
-                                         _("Checksum mismatch for '%s'"),
-                                         svn_dirent_local_style(ctx->relpath,
-                                                                scratch_pool));
-    }
+  SVN_ERR(verify_result_checksum(ctx, scratch_pool));
 
   ctx->commit_ctx->open_batons--;
 
@@ -2251,6 +2603,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* All file contents and properties must be in place before we MERGE. */
+  SVN_ERR(process_pending_files(ctx, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2300,6 +2655,8 @@ abort_edit(void *edit_baton,
   commit_context_t *ctx = edit_baton;
   svn_ra_serf__handler_t *handler;
 
+  cancel_pending_files(ctx);
+
   /* If an activity or transaction wasn't even created, don't bother
      trying to delete it. */
   if (! (ctx->activity_url || ctx->txn_url))
@@ -2392,6 +2749,12 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
 
   ctx->deleted_entries = apr_hash_make(ctx->pool);
 
+  ctx->pending_files = apr_array_make(ctx->pool, 0, sizeof(pending_file_t *));
+  /* HTTP/1.0 servers can't keep several requests in flight. */
+  if (!session->http10)
+    ctx->max_pending_files = session->max_connections
+                               * MAX_PENDING_FILES_PER_CONN;
+
   editor = svn_delta_default_editor(pool);
   editor->open_root = open_root;
   editor->delete_entry = delete_entry;
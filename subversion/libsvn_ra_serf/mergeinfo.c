@@ -32,6 +32,7 @@
 #include "svn_xml.h"
 
 #include "private/svn_dav_protocol.h"
+#include "private/svn_mergeinfo_private.h"
 #include "../libsvn_ra/ra_loader.h"
 #include "svn_private_config.h"
 #include "ra_serf.h"
@@ -53,6 +54,7 @@ typedef enum mergeinfo_state_e {
    get_mergeinfo.  */
 typedef struct mergeinfo_context_t {
   apr_pool_t *pool;
+  svn_mergeinfo__parser_t *parser;
   svn_mergeinfo_t result_catalog;
   const apr_array_header_t *paths;
   svn_revnum_t revision;
@@ -106,8 +108,9 @@ mergeinfo_closed(svn_ra_serf__xml_estate_t *xes,
           if (path[0] == '/')
             ++path;
 
-          SVN_ERR(svn_mergeinfo_parse(&path_mergeinfo, info,
-                                      mergeinfo_ctx->pool));
+          SVN_ERR(svn_mergeinfo__parser_parse(&path_mergeinfo,
+                                              mergeinfo_ctx->parser, info,
+                                              scratch_pool));
 
           svn_hash_sets(mergeinfo_ctx->result_catalog,
                         apr_pstrdup(mergeinfo_ctx->pool, path),
@@ -207,6 +210,7 @@ svn_ra_serf__get_mergeinfo(svn_ra_session_t *ra_session,
 
   mergeinfo_ctx = apr_pcalloc(pool, sizeof(*mergeinfo_ctx));
   mergeinfo_ctx->pool = pool;
+  mergeinfo_ctx->parser = svn_mergeinfo__parser_create(pool);
   mergeinfo_ctx->result_catalog = apr_hash_make(pool);
   mergeinfo_ctx->paths = paths;
   mergeinfo_ctx->revision = revision;
@@ -241,6 +241,11 @@ capabilities_headers_iterator_callback(void *baton,
         {
           session->supports_put_result_checksum = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_STAT_MANY, vals))
+        {
+          svn_hash_sets(session->capabilities,
+                        SVN_RA_CAPABILITY_STAT_MANY, capability_yes);
+        }
     }
 
   /* SVN-specific headers -- if present, server supports HTTP protocol v2 */
@@ -384,6 +389,8 @@ options_response_handler(serf_request_t *request,
                     capability_no);
       svn_hash_sets(session->capabilities, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                     capability_no);
+      svn_hash_sets(session->capabilities, SVN_RA_CAPABILITY_STAT_MANY,
+                    capability_no);
 
       /* Then see which ones we can discover. */
       serf_bucket_headers_do(hdrs, capabilities_headers_iterator_callback,
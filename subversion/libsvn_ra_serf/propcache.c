@@ -0,0 +1,265 @@
+/*
+ * propcache.c: persistent cache of immutable DAV properties.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_checksum.h"
+#include "svn_io.h"
+#include "svn_types.h"
+#include "svn_pools.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "propcache.h"
+
+/* Module-private structure used to hold the cache state.  The entries
+ * themselves live in files named after the SHA1 of their key.  Each file
+ * starts with the decimal length of the key, a space and the key itself,
+ * followed by the cached data.
+ */
+struct svn_ra_serf__propcache_t
+{
+  /* Directory containing the entry files. */
+  const char *dir;
+
+  /* Upper limit of the total size of all entry files. */
+  apr_int64_t max_size;
+
+  /* Total size of all entry files as far as we know or -1 if we don't
+   * know it yet.  Other processes may add to it without us noticing. */
+  apr_int64_t size;
+};
+
+/* After eviction, the cache shall be filled to at most this percentage
+ * of its maximum size.  This keeps us from scanning the directory upon
+ * every write to a full cache. */
+#define EVICTION_TARGET_PERCENT 75
+
+
+/* Set *PATH to the name of the file holding the entry for KEY in
+ * PROPCACHE.  Allocate the result in POOL.
+ */
+static svn_error_t *
+entry_path(const char **path,
+           svn_ra_serf__propcache_t *propcache,
+           const char *key,
+           apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, key, strlen(key),
+                       pool));
+  *path = svn_dirent_join(propcache->dir,
+                          svn_checksum_to_cstring_display(checksum, pool),
+                          pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort svn_io_dirent2_t values from least to most recently used. */
+static int
+compare_mtime(const svn_sort__item_t *a,
+              const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *lhs = a->value;
+  const svn_io_dirent2_t *rhs = b->value;
+
+  if (lhs->mtime == rhs->mtime)
+    return 0;
+
+  return lhs->mtime < rhs->mtime ? -1 : 1;
+}
+
+/* Determine the actual size of PROPCACHE on disk and, if it exceeds the
+ * limit, remove the least recently used entries.  Use SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+evict_entries(svn_ra_serf__propcache_t *propcache,
+              apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_int64_t total = 0;
+  apr_int64_t target;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, propcache->dir, FALSE,
+                              scratch_pool, scratch_pool));
+  sorted = svn_sort__hash(dirents, compare_mtime, scratch_pool);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_io_dirent2_t *dirent
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      total += dirent->filesize;
+    }
+
+  propcache->size = total;
+  if (total <= propcache->max_size)
+    return SVN_NO_ERROR;
+
+  target = propcache->max_size / 100 * EVICTION_TARGET_PERCENT;
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts && total > target; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+
+      svn_pool_clear(iterpool);
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      /* Another process may have removed it already. */
+      SVN_ERR(svn_io_remove_file2(svn_dirent_join(propcache->dir, item->key,
+                                                  iterpool),
+                                  TRUE, iterpool));
+      total -= dirent->filesize;
+    }
+  svn_pool_destroy(iterpool);
+
+  propcache->size = total;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_ra_serf__propcache_create(svn_ra_serf__propcache_t **propcache_p,
+                              const char *dir,
+                              apr_int64_t max_size,
+                              apr_pool_t *result_pool)
+{
+  svn_ra_serf__propcache_t *propcache = apr_pcalloc(result_pool,
+                                                    sizeof(*propcache));
+
+  propcache->dir = apr_pstrdup(result_pool, dir);
+  propcache->max_size = max_size;
+  propcache->size = -1;
+
+  *propcache_p = propcache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__propcache_dup(svn_ra_serf__propcache_t **propcache_p,
+                           svn_ra_serf__propcache_t *propcache,
+                           apr_pool_t *result_pool)
+{
+  return svn_error_trace(svn_ra_serf__propcache_create(propcache_p,
+                                                       propcache->dir,
+                                                       propcache->max_size,
+                                                       result_pool));
+}
+
+svn_error_t *
+svn_ra_serf__propcache_get(svn_stringbuf_t **data_p,
+                           svn_ra_serf__propcache_t *propcache,
+                           const char *key,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const char *path;
+  svn_stringbuf_t *contents;
+  apr_size_t key_len = strlen(key);
+  apr_size_t prefix_len;
+  char *end;
+  svn_error_t *err;
+
+  *data_p = NULL;
+
+  SVN_ERR(entry_path(&path, propcache, key, scratch_pool));
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err)
+    {
+      /* Most likely, the entry simply does not exist. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Verify that this entry is actually for KEY. */
+  if (strtoul(contents->data, &end, 10) != key_len || *end != ' ')
+    return SVN_NO_ERROR;
+
+  prefix_len = end - contents->data + 1;
+  if (contents->len < prefix_len + key_len
+      || memcmp(contents->data + prefix_len, key, key_len) != 0)
+    return SVN_NO_ERROR;
+
+  prefix_len += key_len;
+  *data_p = svn_stringbuf_ncreate(contents->data + prefix_len,
+                                  contents->len - prefix_len,
+                                  result_pool);
+
+  /* Mark the entry as recently used. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), path,
+                                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__propcache_set(svn_ra_serf__propcache_t *propcache,
+                           const char *key,
+                           const svn_stringbuf_t *data,
+                           apr_pool_t *scratch_pool)
+{
+  const char *path;
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  contents = svn_stringbuf_createf(scratch_pool, "%" APR_SIZE_T_FMT " %s",
+                                   strlen(key), key);
+  svn_stringbuf_appendbytes(contents, data->data, data->len);
+
+  /* Don't bother with entries that would evict everything else. */
+  if (contents->len > propcache->max_size / 100 * EVICTION_TARGET_PERCENT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(entry_path(&path, propcache, key, scratch_pool));
+  err = svn_io_make_dir_recursively(propcache->dir, scratch_pool);
+  if (!err)
+    err = svn_io_write_atomic2(path, contents->data, contents->len, NULL,
+                               FALSE, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (propcache->size >= 0)
+    propcache->size += contents->len;
+
+  if (propcache->size < 0 || propcache->size > propcache->max_size)
+    svn_error_clear(evict_entries(propcache, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
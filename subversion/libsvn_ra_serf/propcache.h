@@ -0,0 +1,94 @@
+/*
+ * propcache.h: persistent cache of immutable DAV properties.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_SERF_PROPCACHE_H
+#define SVN_LIBSVN_RA_SERF_PROPCACHE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Persistent property cache.  Unlike the baseline information cache,
+ * this one lives on disk in the user's configuration area and is shared
+ * by all client processes of that user.  It maps arbitrary string keys
+ * to opaque data.  Callers must make sure to only store data that will
+ * never change for the given key, e.g. properties of revision-pinned
+ * resources.
+ *
+ * The total size of the cached data is bounded; least recently used
+ * entries get evicted first.  The cache is best-effort:  I/O failures
+ * are treated as cache misses and never reported to the caller.
+ */
+typedef struct svn_ra_serf__propcache_t svn_ra_serf__propcache_t;
+
+/* Name of the cache directory within the user's configuration area. */
+#define SVN_RA_SERF__PROPCACHE_DIR "http-property-cache"
+
+/* Creates new instance of the property cache storing its data in the
+ * directory DIR and set *PROPCACHE_P to it, allocated in RESULT_POOL.
+ * DIR will be created upon first use.  MAX_SIZE is the approximate upper
+ * limit of the data on disk in bytes.
+ */
+svn_error_t *
+svn_ra_serf__propcache_create(svn_ra_serf__propcache_t **propcache_p,
+                              const char *dir,
+                              apr_int64_t max_size,
+                              apr_pool_t *result_pool);
+
+/* Set *PROPCACHE_P to a new instance of the property cache using the
+ * same storage and limits as PROPCACHE, allocated in RESULT_POOL.
+ */
+svn_error_t *
+svn_ra_serf__propcache_dup(svn_ra_serf__propcache_t **propcache_p,
+                           svn_ra_serf__propcache_t *propcache,
+                           apr_pool_t *result_pool);
+
+/* Sets *DATA_P to the data stored in PROPCACHE for KEY, allocated in
+ * RESULT_POOL.  *DATA_P will be NULL if the cache doesn't have that
+ * information.
+ */
+svn_error_t *
+svn_ra_serf__propcache_get(svn_stringbuf_t **data_p,
+                           svn_ra_serf__propcache_t *propcache,
+                           const char *key,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Store DATA for KEY in PROPCACHE, evicting old entries as necessary.
+ */
+svn_error_t *
+svn_ra_serf__propcache_set(svn_ra_serf__propcache_t *propcache,
+                           const char *key,
+                           const svn_stringbuf_t *data,
+                           apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_PROPCACHE_H*/
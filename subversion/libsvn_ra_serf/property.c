@@ -34,6 +34,7 @@
 
 #include "private/svn_dav_protocol.h"
 #include "private/svn_fspath.h"
+#include "private/svn_skel.h"
 #include "private/svn_string_private.h"
 #include "svn_private_config.h"
 
@@ -82,6 +83,15 @@ typedef struct propfind_context_t {
    * "good"; otherwise, they'll get discarded.
    */
   apr_hash_t *ps_props;
+
+  /* key in the persistent property cache or NULL if the response
+   * must not be cached. */
+  const char *cache_key;
+
+  /* (PATH NS NAME VALUE) lists of all delivered properties in reverse
+   * order, allocated in CACHE_POOL.  NULL if CACHE_KEY is NULL. */
+  svn_skel_t *cache_skel;
+  apr_pool_t *cache_pool;
 } propfind_context_t;
 
 
@@ -145,6 +155,87 @@ static apr_int64_t parse_status_code(const char *status_line)
   return 0;
 }
 
+/* Return the key for the PROPFIND request for PATH at LABEL with DEPTH and
+   FIND_PROPS in SESSION's persistent property cache, allocated in POOL.
+   Return NULL if the response may change over time or if there is no
+   such cache. */
+static const char *
+propfind_cache_key(svn_ra_serf__session_t *session,
+                   const char *path,
+                   const char *label,
+                   const char *depth,
+                   const svn_ra_serf__dav_props_t *find_props,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *key;
+  const svn_ra_serf__dav_props_t *prop;
+
+  if (!session->propcache || !session->uuid)
+    return NULL;
+
+  /* Only revision-pinned resources are immutable.  These are requested
+     either with a Label header or via HTTPv2 rev-root URLs. */
+  if (!label
+      && !(session->rev_root_stub
+           && svn_urlpath__skip_ancestor(session->rev_root_stub, path)))
+    return NULL;
+
+  /* With HTTPv1, the properties of the VCC at some label are those of
+     the baseline, i.e. include the revision properties, which may be
+     changed at any time.  Only the DAV: properties are immutable. */
+  if (session->vcc_url && !strcmp(path, session->vcc_url))
+    {
+      if (!find_props)
+        return NULL;
+
+      for (prop = find_props; prop->xmlns; prop++)
+        if (strcmp(prop->xmlns, D_) || !strcmp(prop->name, "allprop"))
+          return NULL;
+    }
+
+  key = svn_stringbuf_createf(pool, "%s\n%s\n%s\n%s",
+                              session->uuid, label ? label : "",
+                              depth, path);
+  for (prop = find_props; prop && prop->xmlns; prop++)
+    {
+      svn_stringbuf_appendbyte(key, '\n');
+      svn_stringbuf_appendcstr(key, prop->xmlns);
+      svn_stringbuf_appendbyte(key, ' ');
+      svn_stringbuf_appendcstr(key, prop->name);
+    }
+
+  return key->data;
+}
+
+/* Deliver a property to CTX's PROP_FUNC and remember it for the
+   persistent property cache, if CTX's response may be cached. */
+static svn_error_t *
+deliver_prop(propfind_context_t *ctx,
+             const char *path,
+             const char *ns,
+             const char *name,
+             const svn_string_t *value,
+             apr_pool_t *scratch_pool)
+{
+  if (ctx->cache_skel)
+    {
+      apr_pool_t *pool = ctx->cache_pool;
+      svn_skel_t *item = svn_skel__make_empty_list(pool);
+
+      svn_skel__prepend(svn_skel__mem_atom(apr_pmemdup(pool, value->data,
+                                                       value->len),
+                                           value->len, pool),
+                        item);
+      svn_skel__prepend_str(apr_pstrdup(pool, name), item, pool);
+      svn_skel__prepend_str(apr_pstrdup(pool, ns), item, pool);
+      svn_skel__prepend_str(apr_pstrdup(pool, path), item, pool);
+      svn_skel__prepend(item, ctx->cache_skel);
+    }
+
+  return svn_error_trace(ctx->prop_func(ctx->prop_func_baton, path,
+                                        ns, name, value, scratch_pool));
+}
+
 /* Conforms to svn_ra_serf__xml_opened_t  */
 static svn_error_t *
 propfind_opened(svn_ra_serf__xml_estate_t *xes,
@@ -209,6 +300,15 @@ propfind_closed(svn_ra_serf__xml_estate_t *xes,
          onto the "done list". External callers will then know this
          request has been completed (tho stray response bytes may still
          arrive).  */
+
+      if (ctx->cache_skel)
+        {
+          svn_stringbuf_t *data = svn_skel__unparse(ctx->cache_skel,
+                                                    scratch_pool);
+          SVN_ERR(svn_ra_serf__propcache_set(
+                    ctx->handler->session->propcache, ctx->cache_key, data,
+                    scratch_pool));
+        }
     }
   else if (leaving_state == HREF)
     {
@@ -221,10 +321,7 @@ propfind_closed(svn_ra_serf__xml_estate_t *xes,
 
       svn_ra_serf__xml_note(xes, RESPONSE, "path", path);
 
-      SVN_ERR(ctx->prop_func(ctx->prop_func_baton,
-                             path,
-                             D_, "href",
-                             cdata, scratch_pool));
+      SVN_ERR(deliver_prop(ctx, path, D_, "href", cdata, scratch_pool));
     }
   else if (leaving_state == COLLECTION)
     {
@@ -329,8 +426,8 @@ propfind_closed(svn_ra_serf__xml_estate_t *xes,
                   const char *name = apr_hash_this_key(hi_prop);
                   const svn_string_t *value = apr_hash_this_val(hi_prop);
 
-                  SVN_ERR(ctx->prop_func(ctx->prop_func_baton, path,
-                                         ns, name, value, iterpool));
+                  SVN_ERR(deliver_prop(ctx, path, ns, name, value,
+                                       iterpool));
                 }
             }
 
@@ -482,6 +579,15 @@ svn_ra_serf__create_propfind_handler(svn_ra_serf__handler_t **propfind_handler,
       new_prop_ctx->label = NULL;
     }
 
+  new_prop_ctx->cache_key = propfind_cache_key(sess, path,
+                                               new_prop_ctx->label, depth,
+                                               find_props, pool);
+  if (new_prop_ctx->cache_key)
+    {
+      new_prop_ctx->cache_skel = svn_skel__make_empty_list(pool);
+      new_prop_ctx->cache_pool = pool;
+    }
+
   xmlctx = svn_ra_serf__xml_context_create(propfind_ttable,
                                            propfind_opened,
                                            propfind_closed,
@@ -509,6 +615,88 @@ svn_ra_serf__create_propfind_handler(svn_ra_serf__handler_t **propfind_handler,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_serf__propfind_from_cache(svn_boolean_t *found,
+                                 svn_ra_serf__session_t *session,
+                                 const char *path,
+                                 svn_revnum_t rev,
+                                 const char *depth,
+                                 const svn_ra_serf__dav_props_t *find_props,
+                                 svn_ra_serf__prop_func_t prop_func,
+                                 void *prop_func_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  const char *key;
+  svn_stringbuf_t *data;
+  svn_skel_t *skel;
+  svn_skel_t *item;
+  apr_array_header_t *items;
+  apr_pool_t *iterpool;
+  int i;
+
+  *found = FALSE;
+
+  key = propfind_cache_key(session, path,
+                           SVN_IS_VALID_REVNUM(rev)
+                             ? apr_ltoa(scratch_pool, rev) : NULL,
+                           depth, find_props, scratch_pool);
+  if (!key)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_serf__propcache_get(&data, session->propcache, key,
+                                     scratch_pool, scratch_pool));
+  if (!data)
+    return SVN_NO_ERROR;
+
+  /* Validate the whole entry before delivering anything.  Treat
+     malformed entries as cache misses. */
+  skel = svn_skel__parse(data->data, data->len, scratch_pool);
+  if (!skel || skel->is_atom)
+    return SVN_NO_ERROR;
+
+  items = apr_array_make(scratch_pool, svn_skel__list_length(skel),
+                         sizeof(svn_skel_t *));
+  for (item = skel->children; item; item = item->next)
+    {
+      svn_skel_t *elt;
+
+      if (svn_skel__list_length(item) != 4)
+        return SVN_NO_ERROR;
+
+      for (elt = item->children; elt; elt = elt->next)
+        if (!elt->is_atom)
+          return SVN_NO_ERROR;
+
+      APR_ARRAY_PUSH(items, svn_skel_t *) = item;
+    }
+
+  /* The properties have been recorded in reverse order. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = items->nelts - 1; i >= 0; i--)
+    {
+      svn_skel_t *elt = APR_ARRAY_IDX(items, i, svn_skel_t *)->children;
+      const char *item_path, *ns, *name;
+      const svn_string_t *value;
+
+      svn_pool_clear(iterpool);
+
+      item_path = apr_pstrmemdup(iterpool, elt->data, elt->len);
+      elt = elt->next;
+      ns = apr_pstrmemdup(iterpool, elt->data, elt->len);
+      elt = elt->next;
+      name = apr_pstrmemdup(iterpool, elt->data, elt->len);
+      elt = elt->next;
+      value = svn_string_ncreate(elt->data, elt->len, iterpool);
+
+      SVN_ERR(prop_func(prop_func_baton, item_path, ns, name, value,
+                        iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  *found = TRUE;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_serf__deliver_svn_props(void *baton,
                                const char *path,
@@ -574,9 +762,20 @@ svn_ra_serf__fetch_node_props(apr_hash_t **results,
 {
   apr_hash_t *props;
   svn_ra_serf__handler_t *handler;
+  svn_boolean_t found;
 
   props = apr_hash_make(result_pool);
 
+  SVN_ERR(svn_ra_serf__propfind_from_cache(&found, session,
+                                           url, revision, "0", which_props,
+                                           deliver_node_props,
+                                           props, scratch_pool));
+  if (found)
+    {
+      *results = props;
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_ra_serf__create_propfind_handler(&handler, session,
                                                url, revision, "0", which_props,
                                                deliver_node_props,
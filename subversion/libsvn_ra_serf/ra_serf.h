@@ -42,6 +42,7 @@
 #include "private/svn_editor.h"
 
 #include "blncache.h"
+#include "propcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -144,6 +145,9 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Should we offer http/2 during the TLS handshake. */
+  svn_boolean_t enable_http2;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -243,6 +247,10 @@ struct svn_ra_serf__session_t {
 
   svn_ra_serf__blncache_t *blncache;
 
+  /* Persistent cache for properties of revision-pinned resources.
+     NULL if disabled. */
+  svn_ra_serf__propcache_t *propcache;
+
   /* Trisate flag that indicates user preference for using bulk updates
      (svn_tristate_true) with all the properties and content in the
      update-report response. If svn_tristate_false, request a skelta
@@ -458,6 +466,10 @@ typedef struct svn_ra_serf__handler_t {
   /* If TRUE doesn't fail requests on HTTP redirect statuses like 301, 307 */
   svn_boolean_t no_fail_on_http_redirect_status;
 
+  /* If TRUE, the request gets sent ahead of all requests queued without
+     this flag.  Only honored on http/2 connections. */
+  svn_boolean_t prioritized;
+
   /* Has the request/response been completed?  */
   svn_boolean_t done;
   svn_boolean_t scheduled; /* Is the request scheduled in a context */
@@ -985,6 +997,26 @@ svn_ra_serf__create_propfind_handler(svn_ra_serf__handler_t **handler,
                                      void *prop_func_baton,
                                      apr_pool_t *result_pool);
 
+/* If SESSION's persistent property cache contains the response of the
+   PROPFIND request that svn_ra_serf__create_propfind_handler() would
+   create for PATH, REV, DEPTH and FIND_PROPS, deliver those properties
+   to PROP_FUNC() with PROP_FUNC_BATON and set *FOUND to TRUE.  Otherwise,
+   set *FOUND to FALSE.
+
+   Responses get added to that cache automatically by the PROPFIND
+   handler if they refer to revision-pinned resources.
+ */
+svn_error_t *
+svn_ra_serf__propfind_from_cache(svn_boolean_t *found,
+                                 svn_ra_serf__session_t *session,
+                                 const char *path,
+                                 svn_revnum_t rev,
+                                 const char *depth,
+                                 const svn_ra_serf__dav_props_t *find_props,
+                                 svn_ra_serf__prop_func_t prop_func,
+                                 void *prop_func_baton,
+                                 apr_pool_t *scratch_pool);
+
 
 /* Using SESSION, fetch the properties specified by WHICH_PROPS using CONN
    for URL at REVISION. The resulting properties are placed into a 2-level
@@ -1232,6 +1264,15 @@ svn_ra_serf__stat(svn_ra_session_t *ra_session,
                   svn_dirent_t **dirent,
                   apr_pool_t *pool);
 
+/* Implements svn_ra__vtable_t.stat_many(). */
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       apr_hash_t **dirents,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
 /* Implements svn_ra__vtable_t.get_locations(). */
 svn_error_t *
 svn_ra_serf__get_locations(svn_ra_session_t *session,
@@ -31,6 +31,7 @@
 
 #define SB_BLOCKSIZE 1024
 #define SB_MAXSIZE 32768
+#define SB_MAXSIZE_LIMIT (1024 * 1024)
 
 
 struct sbb_baton
@@ -50,7 +51,11 @@ svn_ra_serf__copy_into_spillbuf(svn_spillbuf_t **spillbuf,
                                 apr_pool_t *result_pool,
                                 apr_pool_t *scratch_pool)
 {
-  *spillbuf = svn_spillbuf__create(SB_BLOCKSIZE, SB_MAXSIZE, result_pool);
+  *spillbuf = svn_spillbuf__create(SB_BLOCKSIZE,
+                                   svn_spillbuf__adaptive_maxsize(
+                                     SB_MAXSIZE, SB_MAXSIZE_LIMIT),
+                                   result_pool);
+  svn_spillbuf__set_read_mapped(*spillbuf, TRUE);
 
   /* Copy all data from the bucket into the spillbuf.  */
   while (TRUE)
@@ -164,6 +164,7 @@ load_config(svn_ra_serf__session_t *session,
   const char *exceptions;
   apr_port_t proxy_port;
   svn_tristate_t chunked_requests;
+  apr_int64_t property_cache_size;
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   apr_int64_t log_components;
   apr_int64_t log_level;
@@ -245,6 +246,22 @@ load_config(svn_ra_serf__session_t *session,
                                SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS));
 
+  /* Should we offer http/2. */
+  SVN_ERR(svn_config_get_bool(config, &session->enable_http2,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_ENABLE_HTTP2,
+#ifdef SVN__SERF_TEST_HTTP2
+                              TRUE));
+#else
+                              FALSE));
+#endif
+
+  /* Size of the persistent property cache in MB. */
+  SVN_ERR(svn_config_get_int64(config, &property_cache_size,
+                               SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_HTTP_PROPERTY_CACHE_SIZE,
+                               0));
+
   /* Should we use chunked transfer encoding. */
   SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
                                   SVN_CONFIG_SECTION_GLOBAL,
@@ -312,6 +329,17 @@ load_config(svn_ra_serf__session_t *session,
                                    SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                    session->max_connections));
 
+      /* Should we offer http/2. */
+      SVN_ERR(svn_config_get_bool(config, &session->enable_http2,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_ENABLE_HTTP2,
+                                  session->enable_http2));
+
+      SVN_ERR(svn_config_get_int64(config, &property_cache_size,
+                                   server_group,
+                                   SVN_CONFIG_OPTION_HTTP_PROPERTY_CACHE_SIZE,
+                                   property_cache_size));
+
       /* Should we use chunked transfer encoding. */
       SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
                                       server_group,
@@ -357,6 +385,25 @@ load_config(svn_ra_serf__session_t *session,
   if (session->max_connections < 2)
     session->max_connections = 2;
 
+  /* The property cache lives in the user's config area, next to the
+     auth cache. */
+  session->propcache = NULL;
+  if (property_cache_size > 0)
+    {
+      const char *cache_dir;
+
+      SVN_ERR(svn_config_get_user_config_path(
+                &cache_dir,
+                svn_auth_get_parameter(session->auth_baton,
+                                       SVN_AUTH_PARAM_CONFIG_DIR),
+                SVN_RA_SERF__PROPCACHE_DIR, scratch_pool));
+      if (cache_dir)
+        SVN_ERR(svn_ra_serf__propcache_create(&session->propcache, cache_dir,
+                                              property_cache_size
+                                                * 1024 * 1024,
+                                              result_pool));
+    }
+
   /* Parse the connection timeout value, if any. */
   session->timeout = apr_time_from_sec(DEFAULT_HTTP_TIMEOUT);
   if (timeout_str)
@@ -643,6 +690,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* using_compression */
   /* http10 */
   /* http20 */
+  /* enable_http2 */
   /* using_chunked_requests */
   /* detect_chunking */
 
@@ -735,6 +783,11 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   SVN_ERR(svn_ra_serf__blncache_create(&new_sess->blncache,
                                        new_sess->pool));
 
+  if (new_sess->propcache)
+    SVN_ERR(svn_ra_serf__propcache_dup(&new_sess->propcache,
+                                       new_sess->propcache,
+                                       new_sess->pool));
+
   if (new_sess->server_allows_bulk)
     new_sess->server_allows_bulk = apr_pstrdup(result_pool,
                                                new_sess->server_allows_bulk);
@@ -1064,6 +1117,9 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   NULL /* svn_ra_list */,
+  NULL /* get_file_annotation */,
+  NULL /* get_files_batch */,
+  svn_ra_serf__stat_many,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
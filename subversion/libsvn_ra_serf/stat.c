@@ -505,9 +505,14 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
 
   gdb.path = path;
 
-  /* If we're asked for children, fetch them now. */
+  /* If we're asked for children, fetch them now.  Listings and
+     properties of revision-pinned paths may already be in the
+     persistent property cache. */
   if (dirents)
     {
+      const svn_ra_serf__dav_props_t *props;
+      svn_boolean_t found;
+
       /* Always request node kind to check that path is really a
        * directory. */
       if (!ret_props)
@@ -515,31 +520,70 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
 
       gdb.dirents = apr_hash_make(result_pool);
 
-      SVN_ERR(svn_ra_serf__create_propfind_handler(
-                                          &dirent_handler, session,
-                                          path, SVN_INVALID_REVNUM, "1",
-                                          get_dirent_props(dirent_fields,
-                                                           session,
-                                                           scratch_pool),
-                                          get_dir_dirents_cb, &gdb,
-                                          scratch_pool));
+      props = get_dirent_props(dirent_fields, session, scratch_pool);
+      err = svn_ra_serf__propfind_from_cache(&found, session, path,
+                                             SVN_INVALID_REVNUM, "1",
+                                             props, get_dir_dirents_cb,
+                                             &gdb, scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(scratch_pool);
+          return svn_error_trace(err);
+        }
 
-      svn_ra_serf__request_create(dirent_handler);
+      /* See below for why we may have to requery. */
+      if (found
+          && gdb.supports_deadprop_count == svn_tristate_false
+          && session->supports_deadprop_count == svn_tristate_unknown
+          && dirent_fields & SVN_DIRENT_HAS_PROPS)
+        {
+          session->supports_deadprop_count = svn_tristate_false;
+          apr_hash_clear(gdb.dirents);
+          props = get_dirent_props(dirent_fields, session, scratch_pool);
+          found = FALSE;
+        }
+
+      if (!found)
+        {
+          SVN_ERR(svn_ra_serf__create_propfind_handler(
+                                              &dirent_handler, session,
+                                              path, SVN_INVALID_REVNUM, "1",
+                                              props,
+                                              get_dir_dirents_cb, &gdb,
+                                              scratch_pool));
+
+          svn_ra_serf__request_create(dirent_handler);
+        }
     }
   else
     gdb.dirents = NULL;
 
   if (ret_props)
     {
+      svn_boolean_t found;
+
       gdb.ret_props = apr_hash_make(result_pool);
-      SVN_ERR(svn_ra_serf__create_propfind_handler(
-                                          &props_handler, session,
-                                          path, SVN_INVALID_REVNUM, "0",
-                                          all_props,
-                                          get_dir_props_cb, &gdb,
-                                          scratch_pool));
-
-      svn_ra_serf__request_create(props_handler);
+      err = svn_ra_serf__propfind_from_cache(&found, session, path,
+                                             SVN_INVALID_REVNUM, "0",
+                                             all_props,
+                                             get_dir_props_cb, &gdb,
+                                             scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(scratch_pool); /* Unregisters outstanding requests */
+          return svn_error_trace(err);
+        }
+      if (!found)
+        {
+          SVN_ERR(svn_ra_serf__create_propfind_handler(
+                                              &props_handler, session,
+                                              path, SVN_INVALID_REVNUM, "0",
+                                              all_props,
+                                              get_dir_props_cb, &gdb,
+                                              scratch_pool));
+
+          svn_ra_serf__request_create(props_handler);
+        }
     }
   else
     gdb.ret_props = NULL;
@@ -0,0 +1,205 @@
+/*
+ * stat_many.c :  stat several paths in a single REPORT
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <serf.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_string.h"
+#include "svn_time.h"
+#include "svn_xml.h"
+#include "svn_private_config.h"
+
+#include "private/svn_dav_protocol.h"
+
+#include "../libsvn_ra/ra_loader.h"
+
+#include "ra_serf.h"
+
+
+/*
+ * This enum represents the current state of our XML parsing for a REPORT.
+ */
+enum stat_many_state_e {
+  INITIAL = XML_STATE_INITIAL,
+  REPORT,
+  ENTRY
+};
+
+typedef struct stat_many_context_t {
+  /* pool to allocate the result in */
+  apr_pool_t *pool;
+
+  /* parameters set by our caller */
+  const apr_array_header_t *paths;
+  svn_revnum_t revision;
+
+  /* Returned dirents hash */
+  apr_hash_t *dirents;
+
+} stat_many_context_t;
+
+#define D_ "DAV:"
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t stat_many_ttable[] = {
+  { INITIAL, S_, SVN_DAV__STAT_MANY_REPORT, REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, SVN_DAV__STAT_ENTRY, ENTRY,
+    FALSE, { "path", "kind", "size", "has-props", "created-rev",
+             "?date", "?author", NULL }, TRUE },
+
+  { 0 }
+};
+
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+stat_many_closed(svn_ra_serf__xml_estate_t *xes,
+                 void *baton,
+                 int leaving_state,
+                 const svn_string_t *cdata,
+                 apr_hash_t *attrs,
+                 apr_pool_t *scratch_pool)
+{
+  stat_many_context_t *sm_ctx = baton;
+  svn_dirent_t *dirent;
+  const char *date, *author;
+  apr_int64_t val;
+
+  SVN_ERR_ASSERT(leaving_state == ENTRY);
+
+  dirent = svn_dirent_create(sm_ctx->pool);
+  dirent->kind = svn_node_kind_from_word(svn_hash_gets(attrs, "kind"));
+  SVN_ERR(svn_cstring_atoi64(&val, svn_hash_gets(attrs, "size")));
+  dirent->size = (svn_filesize_t)val;
+  dirent->has_props = (strcmp(svn_hash_gets(attrs, "has-props"),
+                              "true") == 0);
+  SVN_ERR(svn_cstring_atoi64(&val, svn_hash_gets(attrs, "created-rev")));
+  dirent->created_rev = (svn_revnum_t)val;
+
+  date = svn_hash_gets(attrs, "date");
+  if (date)
+    SVN_ERR(svn_time_from_cstring(&dirent->time, date, scratch_pool));
+
+  author = svn_hash_gets(attrs, "author");
+  if (author)
+    dirent->last_author = apr_pstrdup(sm_ctx->pool, author);
+
+  svn_hash_sets(sm_ctx->dirents,
+                apr_pstrdup(sm_ctx->pool, svn_hash_gets(attrs, "path")),
+                dirent);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_stat_many_body(serf_bucket_t **body_bkt,
+                      void *baton,
+                      serf_bucket_alloc_t *alloc,
+                      apr_pool_t *pool /* request pool */,
+                      apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  stat_many_context_t *sm_ctx = baton;
+  int i;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:" SVN_DAV__STAT_MANY_REPORT,
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    "xmlns:D", "DAV:",
+                                    SVN_VA_NULL);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:" SVN_DAV__REVISION,
+                               apr_ltoa(pool, sm_ctx->revision),
+                               alloc);
+
+  for (i = 0; i < sm_ctx->paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(sm_ctx->paths, i, const char *);
+      svn_ra_serf__add_tag_buckets(buckets,
+                                   "S:" SVN_DAV__PATH, path,
+                                   alloc);
+    }
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc,
+                                     "S:" SVN_DAV__STAT_MANY_REPORT);
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       apr_hash_t **dirents,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  stat_many_context_t *sm_ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *req_url;
+
+  /* Resolve HEAD once, so that all paths are stat'ed in the same
+     revision. */
+  SVN_ERR(svn_ra_serf__get_stable_url(&req_url, &revision, session,
+                                      NULL /* url */, revision,
+                                      scratch_pool, scratch_pool));
+
+  sm_ctx = apr_pcalloc(scratch_pool, sizeof(*sm_ctx));
+  sm_ctx->pool = result_pool;
+  sm_ctx->paths = paths;
+  sm_ctx->revision = revision;
+  sm_ctx->dirents = apr_hash_make(result_pool);
+
+  xmlctx = svn_ra_serf__xml_context_create(stat_many_ttable,
+                                           NULL, stat_many_closed, NULL,
+                                           sm_ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = req_url;
+  handler->body_delegate = create_stat_many_body;
+  handler->body_delegate_baton = sm_ctx;
+  handler->body_type = "text/xml";
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  *dirents = sm_ctx->dirents;
+
+  return SVN_NO_ERROR;
+}
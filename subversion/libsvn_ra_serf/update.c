@@ -255,9 +255,18 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+/* With http/2, all requests share a single connection as concurrent
+   streams and a slow response does not hold up the others.  So we can
+   keep many more of them in flight. */
+#define HTTP2_REQUEST_COUNT_TO_RESUME 200
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
+/* Upper limit for the in-memory part of a spilled response on hosts
+   with plenty of memory. */
+#define SPILLBUF_MAXBUFFSIZE_LIMIT (16 * 1024 * 1024)
+
 #define PARSE_CHUNK_SIZE 8000 /* Copied from xml.c ### Needs tuning */
 
 /* Forward-declare our report context. */
@@ -388,6 +397,9 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* When the request was queued. */
+  apr_time_t queued;
+
 } fetch_ctx_t;
 
 /*
@@ -453,8 +465,36 @@ struct report_context_t {
 
   /* Did we close the root directory? */
   svn_boolean_t closed_root;
+
+  /* Connection scaling, see adjust_connections().  We let TARGET_CONNS
+     connections carry up to REQS_PER_CONN requests each and resume
+     parsing the REPORT response below RESUME_COUNT outstanding ones. */
+  int target_conns;
+  unsigned int reqs_per_conn;
+  unsigned int resume_count;
+
+  /* Fetches completed in the current measurement window, the data they
+     received and the fastest request's time to completion. */
+  apr_time_t window_start;
+  unsigned int window_fetches;
+  apr_uint64_t window_bytes;
+  apr_interval_time_t window_min_latency;
+
+  /* Throughput in bytes per second measured before we last opened
+     another connection, and whether opening more may still pay off. */
+  apr_uint64_t last_throughput;
+  svn_boolean_t scaling_done;
 };
 
+/* Return the number of outstanding requests below which we resume
+   processing the REPORT response of CTX. */
+static unsigned int
+request_count_to_resume(const report_context_t *ctx)
+{
+  return ctx->sess->http20 ? HTTP2_REQUEST_COUNT_TO_RESUME
+                           : ctx->resume_count;
+}
+
 static svn_error_t *
 create_dir_baton(dir_baton_t **new_dir,
                  report_context_t *ctx,
@@ -544,21 +584,121 @@ create_file_baton(file_baton_t **new_file,
   return SVN_NO_ERROR;
 }
 
-/** Minimum nr. of outstanding requests needed before a new connection is
+/** Initial nr. of outstanding requests needed before a new connection is
  *  opened. */
 #define REQS_PER_CONN 8
 
-/** This function creates a new connection for this serf session, but only
- * if the number of NUM_ACTIVE_REQS > REQS_PER_CONN or if there currently is
- * only one main connection open.
+/* Bounds for the pipelining depth chosen by adjust_connections(). */
+#define MIN_REQS_PER_CONN 2
+#define MAX_REQS_PER_CONN 32
+
+/* A measurement window spans at least this many fetches and this
+   much time. */
+#define WINDOW_FETCHES 32
+#define WINDOW_DURATION apr_time_from_msec(250)
+
+/* Opening another connection must improve the throughput by at least
+   1/THROUGHPUT_GAIN_DIVISOR to make us try yet another one. */
+#define THROUGHPUT_GAIN_DIVISOR 10
+
+/* Initialize the connection scaling state of CTX. */
+static void
+init_connection_scaling(report_context_t *ctx)
+{
+  /* Start with one auxiliary connection. */
+  ctx->target_conns = 2;
+  ctx->reqs_per_conn = REQS_PER_CONN;
+  ctx->resume_count = REQUEST_COUNT_TO_RESUME;
+  ctx->window_start = apr_time_now();
+}
+
+/* Account for a fetch of CTX having received BYTES within LATENCY after
+   being queued.  At the end of each measurement window, re-evaluate the
+   number of connections to use and their pipelining depth.
+
+   The pipelining depth per connection is the bandwidth-delay product,
+   i.e. the observed throughput per connection times the fastest request
+   latency (our best estimate of the round-trip time without queueing)
+   in units of the average response size.
+
+   Connections get added one at a time as long as each of them raised
+   the throughput noticeably, up to the http-max-connections limit.
+   Once one did not, we stop adding any. */
+static void
+adjust_connections(report_context_t *ctx,
+                   apr_uint64_t bytes,
+                   apr_interval_time_t latency)
+{
+  svn_ra_serf__session_t *sess = ctx->sess;
+  apr_time_t now;
+  apr_interval_time_t elapsed;
+  apr_uint64_t throughput, per_conn, avg_size, depth;
+
+  ctx->window_fetches++;
+  ctx->window_bytes += bytes;
+  if (ctx->window_fetches == 1 || latency < ctx->window_min_latency)
+    ctx->window_min_latency = latency;
+
+  now = apr_time_now();
+  elapsed = now - ctx->window_start;
+  if (ctx->window_fetches < WINDOW_FETCHES || elapsed < WINDOW_DURATION)
+    return;
+
+  throughput = ctx->window_bytes * APR_USEC_PER_SEC / elapsed;
+  avg_size = ctx->window_bytes / ctx->window_fetches;
+  per_conn = throughput / (sess->num_conns > 1 ? sess->num_conns - 1 : 1);
+
+  depth = avg_size
+        ? per_conn * ctx->window_min_latency / APR_USEC_PER_SEC / avg_size + 1
+        : MAX_REQS_PER_CONN;
+  if (depth < MIN_REQS_PER_CONN)
+    depth = MIN_REQS_PER_CONN;
+  if (depth > MAX_REQS_PER_CONN)
+    depth = MAX_REQS_PER_CONN;
+  ctx->reqs_per_conn = (unsigned int)depth;
+
+  if (!ctx->scaling_done && sess->num_conns >= ctx->target_conns)
+    {
+      if (ctx->last_throughput
+          && throughput < ctx->last_throughput
+                          + ctx->last_throughput / THROUGHPUT_GAIN_DIVISOR)
+        ctx->scaling_done = TRUE;
+      else if (ctx->target_conns < sess->max_connections)
+        {
+          ctx->last_throughput = throughput;
+          ctx->target_conns++;
+        }
+    }
+
+  /* Keep enough requests queued to fill the pipelines. */
+  ctx->resume_count = ctx->reqs_per_conn * ctx->target_conns;
+  if (ctx->resume_count < REQUEST_COUNT_TO_RESUME / 2)
+    ctx->resume_count = REQUEST_COUNT_TO_RESUME / 2;
+
+  ctx->window_start = now;
+  ctx->window_fetches = 0;
+  ctx->window_bytes = 0;
+}
+
+/** This function creates a new connection for the session of CTX, but only
+ * if the number of NUM_ACTIVE_REQS > the current pipelining depth times the
+ * number of connections or if there currently is only one main connection
+ * open.  It never opens more than adjust_connections() decided to use.
+ * Http/2 sessions multiplex all requests over their main connection and
+ * never open another one.
  */
 static svn_error_t *
-open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
+open_connection_if_needed(report_context_t *ctx, int num_active_reqs)
 {
+  svn_ra_serf__session_t *sess = ctx->sess;
+
+  if (sess->http20 || sess->num_conns >= ctx->target_conns)
+    return SVN_NO_ERROR;
+
   /* For each REQS_PER_CONN outstanding requests open a new connection, with
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
-      ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
+      ((num_active_reqs / ctx->reqs_per_conn) > (unsigned int)sess->num_conns))
     {
       int cur = sess->num_conns;
       apr_status_t status;
@@ -608,6 +748,10 @@ get_best_connection(report_context_t *ctx)
   if (ctx->report_received && (ctx->sess->max_connections > 2))
     first_conn = 0;
 
+  /* The REPORT response is just one of many streams with http/2. */
+  if (ctx->sess->http20)
+    first_conn = 0;
+
   /* If there's only one available auxiliary connection to use, don't bother
      doing all the cur_conn math -- just return that one connection.  */
   if (ctx->sess->num_conns - first_conn == 1)
@@ -1190,6 +1334,8 @@ file_fetch_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_fetches--;
+  adjust_connections(file->parent_dir->ctx, fetch_ctx->read_size,
+                     apr_time_now() - fetch_ctx->queued);
 
   file->fetch_file = FALSE;
 
@@ -1217,8 +1363,8 @@ fetch_for_file(file_baton_t *file,
 
   /* Open extra connections if we have enough requests to send. */
   if (ctx->sess->num_conns < ctx->sess->max_connections)
-    SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
-                                                 ctx->num_active_propfinds));
+    SVN_ERR(open_connection_if_needed(ctx, ctx->num_active_fetches +
+                                           ctx->num_active_propfinds));
 
   /* What connection should we go on? */
   conn = get_best_connection(ctx);
@@ -1346,6 +1492,7 @@ fetch_for_file(file_baton_t *file,
           handler->done_delegate_baton = fetch_ctx;
 
           fetch_ctx->handler = handler;
+          fetch_ctx->queued = apr_time_now();
 
           svn_ra_serf__request_create(handler);
 
@@ -1367,6 +1514,9 @@ fetch_for_file(file_baton_t *file,
       file->propfind_handler->done_delegate = file_props_done;
       file->propfind_handler->done_delegate_baton = file;
 
+      /* Let metadata overtake the file bodies. */
+      file->propfind_handler->prioritized = TRUE;
+
       /* Create a serf request for the PROPFIND.  */
       svn_ra_serf__request_create(file->propfind_handler);
 
@@ -1445,8 +1595,8 @@ fetch_for_dir(dir_baton_t *dir,
 
   /* Open extra connections if we have enough requests to send. */
   if (ctx->sess->num_conns < ctx->sess->max_connections)
-    SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
-                                                 ctx->num_active_propfinds));
+    SVN_ERR(open_connection_if_needed(ctx, ctx->num_active_fetches +
+                                           ctx->num_active_propfinds));
 
   /* What connection should we go on? */
   conn = get_best_connection(ctx);
@@ -1465,6 +1615,9 @@ fetch_for_dir(dir_baton_t *dir,
       dir->propfind_handler->done_delegate = dir_props_done;
       dir->propfind_handler->done_delegate_baton = dir;
 
+      /* Let metadata overtake the file bodies. */
+      dir->propfind_handler->prioritized = TRUE;
+
       /* Create a serf request for the PROPFIND.  */
       svn_ra_serf__request_create(dir->propfind_handler);
 
@@ -2251,7 +2404,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < request_count_to_resume(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2295,9 +2448,12 @@ update_delay_handler(serf_request_t *request,
         }
 
       /* Let's start using the spill infrastructure */
-      udb->spillbuf = svn_spillbuf__create(SPILLBUF_BLOCKSIZE,
-                                           SPILLBUF_MAXBUFFSIZE,
-                                           udb->report->pool);
+      udb->spillbuf = svn_spillbuf__create(
+                        SPILLBUF_BLOCKSIZE,
+                        svn_spillbuf__adaptive_maxsize(
+                          SPILLBUF_MAXBUFFSIZE, SPILLBUF_MAXBUFFSIZE_LIMIT),
+                        udb->report->pool);
+      svn_spillbuf__set_read_mapped(udb->spillbuf, TRUE);
     }
 
   /* Read everything we can to a spillbuffer */
@@ -2335,7 +2491,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < request_count_to_resume(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2407,7 +2563,7 @@ process_editor_report(report_context_t *ctx,
   handler->response_baton = ud;
 
   /* Open the first extra connection. */
-  SVN_ERR(open_connection_if_needed(sess, 0));
+  SVN_ERR(open_connection_if_needed(ctx, 0));
 
   sess->cur_conn = 1;
 
@@ -2605,6 +2761,8 @@ make_update_reporter(svn_ra_session_t *ra_session,
   report->editor_baton = update_baton;
   report->done = FALSE;
 
+  init_connection_scaling(report);
+
   *reporter = &ra_serf_reporter;
   *report_baton = report;
 
@@ -480,7 +480,7 @@ load_authorities(svn_ra_serf__connection_t *conn, const char *authorities,
   return SVN_NO_ERROR;
 }
 
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
 /* Implements serf_ssl_protocol_result_cb_t */
 static apr_status_t
 conn_negotiate_protocol(void *data,
@@ -557,8 +557,10 @@ conn_setup(apr_socket_t *sock,
               SVN_ERR(load_authorities(conn, conn->session->ssl_authorities,
                                        conn->session->pool));
             }
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
-          if (APR_SUCCESS ==
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+          /* Servers without http/2 support simply select http/1.1. */
+          if (conn->session->enable_http2
+              && APR_SUCCESS ==
                 serf_ssl_negotiate_protocol(conn->ssl_context, "h2,http/1.1",
                                             conn_negotiate_protocol, conn))
             {
@@ -1660,8 +1662,13 @@ svn_ra_serf__request_create(svn_ra_serf__handler_t *handler)
 
      ### I fixed a request leak in serf in r2258 on auth failures.
    */
-  (void) serf_connection_request_create(handler->conn->conn,
-                                        setup_request_cb, handler);
+  if (handler->prioritized && handler->session->http20)
+    (void) serf_connection_priority_request_create(handler->conn->conn,
+                                                   setup_request_cb,
+                                                   handler);
+  else
+    (void) serf_connection_request_create(handler->conn->conn,
+                                          setup_request_cb, handler);
 }
 
 
@@ -65,9 +65,12 @@ struct svn_ra_serf__xml_context_t {
   svn_ra_serf__xml_cdata_t cdata_cb;
   void *baton;
 
-  /* Linked list of free states.  */
+  /* Linked list of free states, to be recycled by new elements.  */
   svn_ra_serf__xml_estate_t *free_states;
 
+  /* Pool that all states get allocated in.  */
+  apr_pool_t *states_pool;
+
 #ifdef SVN_DEBUG
   /* Used to verify we are not re-entering a callback, specifically to
      ensure SCRATCH_POOL is not cleared while an outer callback is
@@ -103,7 +106,9 @@ struct svn_ra_serf__xml_estate_t {
   /* The current state value.  */
   int state;
 
-  /* The xml tag that opened this state. Waiting for the tag to close.  */
+  /* The xml tag that opened this state. Waiting for the tag to close.
+     Unless the element matched a wildcard transition, the strings point
+     into the transition table.  */
   svn_ra_serf__dav_props_t tag;
 
   /* Should the CLOSED_CB function be called for custom processing when
@@ -125,7 +130,8 @@ struct svn_ra_serf__xml_estate_t {
   /* Any collected cdata. May be NULL if no cdata is being collected.  */
   svn_stringbuf_t *cdata;
 
-  /* Previous/outer state.  */
+  /* Previous/outer state.  For states on the FREE_STATES list of the
+     context, the next free state.  */
   svn_ra_serf__xml_estate_t *prev;
 
 };
@@ -218,7 +224,8 @@ expand_ns(svn_ra_serf__dav_props_t *returned_prop_name,
 
       for (ns = ns_list; ns; ns = ns->next)
         {
-          if (strncmp(ns->xmlns, name, colon - name) == 0)
+          if (strncmp(ns->xmlns, name, colon - name) == 0
+              && ns->xmlns[colon - name] == '\0')
             {
               returned_prop_name->xmlns = ns->url;
               returned_prop_name->name = colon + 1;
@@ -538,6 +545,7 @@ svn_ra_serf__xml_context_create(
   xmlctx->cdata_cb = cdata_cb;
   xmlctx->baton = baton;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
+  xmlctx->states_pool = result_pool;
 
   xes = apr_pcalloc(result_pool, sizeof(*xes));
   /* XES->STATE == 0  */
@@ -631,6 +639,27 @@ svn_ra_serf__xml_state_pool(svn_ra_serf__xml_estate_t *xes)
 }
 
 
+/* Return a zero-initialized state for XMLCTX.  States are recycled, so
+   this will not allocate memory for most elements.  */
+static svn_ra_serf__xml_estate_t *
+alloc_state(svn_ra_serf__xml_context_t *xmlctx)
+{
+  svn_ra_serf__xml_estate_t *xes = xmlctx->free_states;
+
+  if (xes)
+    {
+      xmlctx->free_states = xes->prev;
+      memset(xes, 0, sizeof(*xes));
+    }
+  else
+    {
+      xes = apr_pcalloc(xmlctx->states_pool, sizeof(*xes));
+    }
+
+  return xes;
+}
+
+
 static svn_error_t *
 xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
              const char *raw_name,
@@ -689,22 +718,13 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   SVN_ERR_ASSERT(!scan->collect_cdata || scan->custom_close);
 
   /* Found a transition. Make it happen.  */
+  new_xes = alloc_state(xmlctx);
 
-  /* ### todo. push state  */
-
-  /* ### how to use free states?  */
-  /* This state should be allocated in the extent pool. If we will be
-     collecting information for this state, then construct a subpool.
-
-     ### potentially optimize away the subpool if none of the
-     ### attributes are present. subpools are cheap, tho...  */
-  new_pool = xes_pool(current);
+  /* If we will be collecting information for this state, then construct
+     a subpool for it.  */
   if (scan->collect_cdata || scan->collect_attrs[0])
     {
-      new_pool = svn_pool_create(new_pool);
-
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
+      new_pool = svn_pool_create(xes_pool(current));
       new_xes->state_pool = new_pool;
 
       /* If we're supposed to collect cdata, then set up a buffer for
@@ -733,11 +753,17 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
                   name = *saveattr;
                   value = svn_xml_get_attr_value(name, attrs);
                   if (value == NULL)
-                    return svn_error_createf(
+                    {
+                      svn_pool_destroy(new_pool);
+                      new_xes->prev = xmlctx->free_states;
+                      xmlctx->free_states = new_xes;
+
+                      return svn_error_createf(
                                 SVN_ERR_XML_ATTRIB_NOT_FOUND,
                                 NULL,
                                 _("Missing XML attribute '%s' on '%s' element"),
                                 name, scan->name);
+                    }
                 }
 
               if (value)
@@ -748,15 +774,23 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
     }
   else
     {
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
       /* STATE_POOL remains NULL.  */
+      new_pool = xes_pool(current);
     }
 
-  /* Some basic copies to set up the new estate.  */
+  /* Some basic copies to set up the new estate.  The tag name can be
+     taken from the transition table unless it was a wildcard match.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  if (*scan->name == '*')
+    {
+      new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
+      new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+    }
+  else
+    {
+      new_xes->tag.name = scan->name;
+      new_xes->tag.xmlns = scan->ns;
+    }
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -820,17 +854,15 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
   /* Pop the state.  */
   xmlctx->current = xes->prev;
 
-  /* ### not everything should go on the free state list. XES may go
-     ### away with the state pool.  */
-  xes->prev = xmlctx->free_states;
-  xmlctx->free_states = xes;
-
   /* If there is a STATE_POOL, then toss it. This will get rid of as much
-     memory as possible. Potentially the XES (if we didn't create a pool
-     right away, then XES may be in a parent pool).  */
+     memory as possible.  */
   if (xes->state_pool)
     svn_pool_destroy(xes->state_pool);
 
+  /* XES itself lives in the context's pool and will be recycled.  */
+  xes->prev = xmlctx->free_states;
+  xmlctx->free_states = xes;
+
   return SVN_NO_ERROR;
 }
 
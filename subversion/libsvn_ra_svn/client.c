@@ -51,8 +51,10 @@
 #include "svn_private_config.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_mergeinfo_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #include "../libsvn_ra/ra_loader.h"
 
@@ -629,6 +631,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  const char *compressed_stream_cap = NULL;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
 
@@ -649,6 +652,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->callbacks_baton = callbacks_baton;
   sess->bytes_read = sess->bytes_written = 0;
   sess->auth_baton = auth_baton;
+  sess->max_connections = 1;
 
   if (config)
     SVN_ERR(svn_config_copy_config(&sess->config, config, pool));
@@ -743,11 +747,24 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
                             _("Server does not support edit pipelining"));
 
+  /* Pick a method to compress the whole connection stream with, if the
+   * server offers any.  Zstandard compresses better at similar speed. */
+  if (conn->compression_level > 0)
+    {
+      if (svn_ra_svn_has_capability(conn,
+                                    SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD)
+          && svn__zstd_available())
+        compressed_stream_cap = SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD;
+      else if (svn_ra_svn_has_capability(conn,
+                                         SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4))
+        compressed_stream_cap = SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4;
+    }
+
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,9 +773,21 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  compressed_stream_cap,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
+
+  /* Both sides compress everything after this response. */
+  if (compressed_stream_cap)
+    SVN_ERR(svn_ra_svn__enable_compression(
+              conn,
+              strcmp(compressed_stream_cap,
+                     SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD) == 0
+                ? svn_ra_svn__compression_zstd
+                : svn_ra_svn__compression_lz4,
+              pool));
+
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -839,6 +868,37 @@ is_valid_hostinfo(const char *hostinfo)
   return TRUE;
 }
 
+/* Set *MAX_CONNECTIONS to the "svn-max-connections" value in the servers
+   configuration CFG, honoring the server group recorded in AUTH_BATON.
+   CFG may be NULL. */
+static svn_error_t *
+load_max_connections(int *max_connections,
+                     svn_config_t *cfg,
+                     svn_auth_baton_t *auth_baton)
+{
+  const char *server_group;
+  apr_int64_t value;
+
+  SVN_ERR(svn_config_get_int64(cfg, &value, SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                               SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS));
+
+  server_group = svn_auth_get_parameter(auth_baton,
+                                        SVN_AUTH_PARAM_SERVER_GROUP);
+  if (server_group)
+    SVN_ERR(svn_config_get_int64(cfg, &value, server_group,
+                                 SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                                 value));
+
+  if (value > SVN_RA_SVN__MAX_CONNECTIONS_LIMIT)
+    value = SVN_RA_SVN__MAX_CONNECTIONS_LIMIT;
+  if (value < 1)
+    value = 1;
+
+  *max_connections = (int)value;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_open(svn_ra_session_t *session,
                                 const char **corrected_url,
                                 const char *url,
@@ -900,6 +960,7 @@ static svn_error_t *ra_svn_open(svn_ra_session_t *session,
   SVN_ERR(open_session(&sess, url, &uri, tunnel, tunnel_argv, config,
                        callbacks, callback_baton,
                        auth_baton, sess_pool, scratch_pool));
+  SVN_ERR(load_max_connections(&sess->max_connections, cfg, auth_baton));
   session->priv = sess;
 
   return SVN_NO_ERROR;
@@ -1433,46 +1494,32 @@ parse_iproplist(apr_array_header_t **inherited_props,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
-                                    svn_revnum_t rev, svn_stream_t *stream,
-                                    svn_revnum_t *fetched_rev,
-                                    apr_hash_t **props,
-                                    apr_pool_t *pool)
+/* Read the contents of the file PATH from CONN, sent as a series of
+ * strings terminated by an empty string, and write them to STREAM.
+ * STREAM may be NULL, in which case the contents are simply skipped.
+ * If EXPECTED_DIGEST is not NULL, verify the contents against that MD5
+ * hex digest.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_file_contents(svn_ra_svn_conn_t *conn,
+                   svn_stream_t *stream,
+                   const char *expected_digest,
+                   const char *path,
+                   apr_pool_t *scratch_pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist;
-  const char *expected_digest;
   svn_checksum_t *expected_checksum = NULL;
   svn_checksum_ctx_t *checksum_ctx;
   apr_pool_t *iterpool;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
-                                         (props != NULL), (stream != NULL)));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
-                                        &expected_digest,
-                                        &rev, &proplist));
-
-  if (fetched_rev)
-    *fetched_rev = rev;
-  if (props)
-    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
-
-  /* We're done if the contents weren't wanted. */
-  if (!stream)
-    return SVN_NO_ERROR;
-
-  if (expected_digest)
+  if (expected_digest && stream)
     {
       SVN_ERR(svn_checksum_parse_hex(&expected_checksum, svn_checksum_md5,
-                                     expected_digest, pool));
-      checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+                                     expected_digest, scratch_pool));
+      checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
     }
 
   /* Read the file's contents. */
-  iterpool = svn_pool_create(pool);
+  iterpool = svn_pool_create(scratch_pool);
   while (1)
     {
       svn_ra_svn__item_t *item;
@@ -1485,6 +1532,9 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
       if (item->u.string.len == 0)
         break;
 
+      if (!stream)
+        continue;
+
       if (expected_checksum)
         SVN_ERR(svn_checksum_update(checksum_ctx, item->u.string.data,
                                     item->u.string.len));
@@ -1494,15 +1544,14 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
     }
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, ""));
-
   if (expected_checksum)
     {
       svn_checksum_t *checksum;
 
-      SVN_ERR(svn_checksum_final(&checksum, checksum_ctx, pool));
+      SVN_ERR(svn_checksum_final(&checksum, checksum_ctx, scratch_pool));
       if (!svn_checksum_match(checksum, expected_checksum))
-        return svn_checksum_mismatch_err(expected_checksum, checksum, pool,
+        return svn_checksum_mismatch_err(expected_checksum, checksum,
+                                         scratch_pool,
                                          _("Checksum mismatch for '%s'"),
                                          path);
     }
@@ -1510,6 +1559,64 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__fetch_file(svn_ra_svn__session_baton_t *sess,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_stream_t *stream,
+                       apr_pool_t *scratch_pool)
+{
+  svn_ra_svn_conn_t *conn = sess->conn;
+  svn_ra_svn__list_t *proplist;
+  const char *expected_digest;
+
+  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, scratch_pool, path, revision,
+                                         FALSE, TRUE));
+  SVN_ERR(handle_auth_request(sess, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, "(?c)rl",
+                                        &expected_digest,
+                                        &revision, &proplist));
+  SVN_ERR(read_file_contents(conn, stream, expected_digest, path,
+                             scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
+                                    svn_revnum_t rev, svn_stream_t *stream,
+                                    svn_revnum_t *fetched_rev,
+                                    apr_hash_t **props,
+                                    apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist;
+  const char *expected_digest;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
+                                         (props != NULL), (stream != NULL)));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
+                                        &expected_digest,
+                                        &rev, &proplist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+  if (props)
+    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
+
+  /* We're done if the contents weren't wanted. */
+  if (!stream)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_file_contents(conn, stream, expected_digest, path, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write the protocol words that correspond to DIRENT_FIELDS to CONN
  * and use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
@@ -1539,45 +1646,17 @@ send_dirent_fields(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
-                                   apr_hash_t **dirents,
-                                   svn_revnum_t *fetched_rev,
-                                   apr_hash_t **props,
-                                   const char *path,
-                                   svn_revnum_t rev,
-                                   apr_uint32_t dirent_fields,
-                                   apr_pool_t *pool)
+/* Set *DIRENTS_P to a hash mapping entry names to svn_dirent_t *, as
+ * sent by the server in DIRLIST.  Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+parse_dirlist(apr_hash_t **dirents_p,
+              svn_ra_svn__list_t *dirlist,
+              apr_pool_t *result_pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist, *dirlist;
+  apr_hash_t *dirents = svn_hash__make(result_pool);
   int i;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
-                                  rev, (props != NULL), (dirents != NULL)));
-  SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
-
-  /* Always send the, nominally optional, want-iprops as "false" to
-     workaround a bug in svnserve 1.8.0-1.8.8 that causes the server
-     to see "true" if it is omitted. */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
-
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
-                                        &dirlist));
-
-  if (fetched_rev)
-    *fetched_rev = rev;
-  if (props)
-    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
-
-  /* We're done if dirents aren't wanted. */
-  if (!dirents)
-    return SVN_NO_ERROR;
-
-  /* Interpret the directory list. */
-  *dirents = svn_hash__make(pool);
   for (i = 0; i < dirlist->nelts; i++)
     {
       const char *name, *kind, *cdate, *cauthor;
@@ -1601,7 +1680,7 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
                                  _("Invalid directory entry name '%s'"),
                                  name);
 
-      dirent = svn_dirent_create(pool);
+      dirent = svn_dirent_create(result_pool);
       dirent->kind = svn_node_kind_from_word(kind);
       dirent->size = size;/* FIXME: svn_filesize_t */
       dirent->has_props = has_props;
@@ -1617,14 +1696,55 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
       if (cdate == NULL)
         dirent->time = 0;
       else
-        SVN_ERR(svn_time_from_cstring(&dirent->time, cdate, pool));
+        SVN_ERR(svn_time_from_cstring(&dirent->time, cdate,
+                                      result_pool));
       dirent->last_author = cauthor;
-      svn_hash_sets(*dirents, name, dirent);
+      svn_hash_sets(dirents, name, dirent);
     }
 
+  *dirents_p = dirents;
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
+                                   apr_hash_t **dirents,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   const char *path,
+                                   svn_revnum_t rev,
+                                   apr_uint32_t dirent_fields,
+                                   apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist, *dirlist;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
+                                  rev, (props != NULL), (dirents != NULL)));
+  SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
+
+  /* Always send the, nominally optional, want-iprops as "false" to
+     workaround a bug in svnserve 1.8.0-1.8.8 that causes the server
+     to see "true" if it is omitted. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
+
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
+                                        &dirlist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+  if (props)
+    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
+
+  /* We're done if dirents aren't wanted. */
+  if (!dirents)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(parse_dirlist(dirents, dirlist, pool));
+}
+
 /* Converts a apr_uint64_t with values TRUE, FALSE or
    SVN_RA_SVN_UNSPECIFIED_NUMBER as provided by svn_ra_svn__parse_tuple
    to a svn_tristate_t */
@@ -1674,6 +1794,9 @@ static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
   *catalog = NULL;
   if (mergeinfo_tuple->nelts > 0)
     {
+      /* Subtree mergeinfo tends to repeat the same merge sources. */
+      svn_mergeinfo__parser_t *parser = svn_mergeinfo__parser_create(pool);
+
       *catalog = svn_hash__make(pool);
       for (i = 0; i < mergeinfo_tuple->nelts; i++)
         {
@@ -1686,7 +1809,8 @@ static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
                                     _("Mergeinfo element is not a list"));
           SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "cc",
                                           &path, &to_parse));
-          SVN_ERR(svn_mergeinfo_parse(&for_path, to_parse, pool));
+          SVN_ERR(svn_mergeinfo__parser_parse(&for_path, parser, to_parse,
+                                              pool));
 
           /* Correct for naughty servers that send "relative" paths
              with leading slashes! */
@@ -1703,6 +1827,60 @@ static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Open COUNT additional connections to the session URL of SESS and
+   return their session batons in *FETCH_SESSIONS, allocated in
+   RESULT_POOL.  Every connection lives in a root pool of its own, so
+   that it can be used from a different thread. */
+static svn_error_t *
+open_fetch_sessions(apr_array_header_t **fetch_sessions,
+                    svn_ra_svn__session_baton_t *sess,
+                    int count,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *url = sess->parent->client_url->data;
+  svn_ra_callbacks2_t *callbacks;
+  int i;
+
+  /* Progress gets reported by the main connection only. */
+  callbacks = apr_pmemdup(result_pool, sess->callbacks, sizeof(*callbacks));
+  callbacks->progress_func = NULL;
+
+  *fetch_sessions = apr_array_make(result_pool, count,
+                                   sizeof(svn_ra_svn__session_baton_t *));
+  for (i = 0; i < count; ++i)
+    {
+      apr_pool_t *pool = svn_pool_create(NULL);
+      svn_ra_svn__session_baton_t *fetch_sess;
+      apr_uri_t uri;
+      svn_error_t *err;
+
+      err = parse_url(url, &uri, pool);
+      if (!err)
+        err = open_session(&fetch_sess, url, &uri, sess->tunnel_name,
+                           sess->tunnel_argv, sess->config, callbacks,
+                           sess->callbacks_baton, sess->auth_baton,
+                           pool, scratch_pool);
+      if (err)
+        {
+          int j;
+
+          svn_pool_destroy(pool);
+          for (j = 0; j < (*fetch_sessions)->nelts; ++j)
+            svn_pool_destroy(APR_ARRAY_IDX(*fetch_sessions, j,
+                                           svn_ra_svn__session_baton_t *)
+                               ->pool);
+
+          return svn_error_trace(err);
+        }
+
+      APR_ARRAY_PUSH(*fetch_sessions, svn_ra_svn__session_baton_t *)
+        = fetch_sess;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_update(svn_ra_session_t *session,
                                   const svn_ra_reporter3_t **reporter,
                                   void **report_baton, svn_revnum_t rev,
@@ -1717,14 +1895,43 @@ static svn_error_t *ra_svn_update(svn_ra_session_t *session,
   svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  svn_boolean_t text_deltas = TRUE;
 
   /* Callbacks may assume that all data is relative the sessions's URL. */
   SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
 
+  /* Fetch the file contents over additional connections if configured
+     and if we may run them concurrently.  The server then only tells us
+     which files changed. */
+  if (sess_baton->max_connections > 1
+      && svn_task__get_thread_limit() > 0
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_UPDATE_TEXT_DELTAS))
+    {
+      apr_array_header_t *fetch_sessions;
+      svn_error_t *err;
+
+      err = open_fetch_sessions(&fetch_sessions, sess_baton,
+                                sess_baton->max_connections - 1,
+                                pool, scratch_pool);
+
+      /* The single connection we already have works just as well. */
+      if (err)
+        svn_error_clear(err);
+      else
+        {
+          SVN_ERR(svn_ra_svn__get_fetching_editor(&update_editor,
+                                                  &update_baton,
+                                                  update_editor,
+                                                  update_baton,
+                                                  fetch_sessions, pool));
+          text_deltas = FALSE;
+        }
+    }
+
   /* Tell the server we want to start an update. */
   SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
                                        depth, send_copyfrom_args,
-                                       ignore_ancestry));
+                                       ignore_ancestry, text_deltas));
   SVN_ERR(handle_auth_request(sess_baton, pool));
 
   /* Fetch a reporter for the caller to drive.  The reporter will drive
@@ -3073,6 +3280,9 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_FILE_ANNOTATION, SVN_RA_SVN_CAP_FILE_ANNOTATION},
+      {SVN_RA_CAPABILITY_GET_FILES_BATCH, SVN_RA_SVN_CAP_GET_FILES_BATCH},
+      {SVN_RA_CAPABILITY_STAT_MANY, SVN_RA_SVN_CAP_STAT_MANY},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3242,6 +3452,234 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_get_file_annotation(svn_ra_session_t *session,
+                           const char *path,
+                           svn_revnum_t revision,
+                           svn_ra_annotate_receiver_t receiver,
+                           void *receiver_baton,
+                           apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_int64_t line_no;
+
+  path = reparent_path(session, path, scratch_pool);
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(c(?r))",
+                                  "get-file-annotation", path, revision));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the annotated lines. */
+  for (line_no = 0; ; line_no++)
+    {
+      svn_ra_svn__item_t *item;
+      svn_revnum_t line_rev;
+      svn_string_t *line;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next line or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Annotation entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "rs",
+                                      &line_rev, &line));
+
+      SVN_ERR(receiver(receiver_baton, line_no, line_rev, line, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_get_files_batch(svn_ra_session_t *session,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       svn_boolean_t want_props,
+                       svn_boolean_t want_contents,
+                       apr_uint32_t dirent_fields,
+                       svn_ra_fetch_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Send all requests in one go.  The server streams the results back
+     in the same order, so we never wait for a round-trip per path. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!",
+                                  "get-files-batch"));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_cstring(conn, iterpool,
+                                        reparent_path(session, path,
+                                                      iterpool)));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)(?r)bb(!",
+                                  revision, want_props, want_contents));
+  SVN_ERR(send_dirent_fields(conn, dirent_fields, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the entries. */
+  for (i = 0; ; i++)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist, *dirlist;
+      const char *path, *kind_word, *expected_digest;
+      svn_revnum_t rev;
+      svn_node_kind_t kind;
+      apr_hash_t *props = NULL;
+      apr_hash_t *dirents = NULL;
+      svn_stream_t *contents = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next entry or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Batch entry not a list"));
+      if (i >= paths->nelts)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Server sent more batch entries than "
+                                  "requested"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "cwrl(?c)l",
+                                      &path, &kind_word, &rev, &proplist,
+                                      &expected_digest, &dirlist));
+
+      /* Report the path as requested, not as reparented. */
+      path = APR_ARRAY_IDX(paths, i, const char *);
+      kind = svn_node_kind_from_word(kind_word);
+
+      if (want_props && kind != svn_node_none)
+        SVN_ERR(svn_ra_svn__parse_proplist(proplist, iterpool, &props));
+      if (want_contents && kind == svn_node_dir)
+        SVN_ERR(parse_dirlist(&dirents, dirlist, iterpool));
+
+      SVN_ERR(receiver(receiver_baton, path, rev, kind, props, dirents,
+                       (want_contents && kind == svn_node_file)
+                         ? &contents
+                         : NULL,
+                       iterpool));
+
+      /* The server sends the contents of files right after their entry
+         and we must consume them even if the receiver is not
+         interested. */
+      if (want_contents && kind == svn_node_file)
+        {
+          SVN_ERR(read_file_contents(conn, contents, expected_digest, path,
+                                     iterpool));
+          if (contents)
+            SVN_ERR(svn_stream_close(contents));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "stat-many"));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_cstring(conn, iterpool,
+                                        reparent_path(session, path,
+                                                      iterpool)));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)(?r))", revision));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  *dirents = apr_hash_make(result_pool);
+  for (i = 0; ; i++)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *list;
+      const char *path, *kind, *cdate, *cauthor;
+      svn_boolean_t has_props;
+      svn_revnum_t crev;
+      apr_uint64_t size;
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next entry or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Stat entry not a list"));
+      if (i >= paths->nelts)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Server sent more stat entries than "
+                                  "requested"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "c(?l)", &path, &list));
+      if (! list)
+        continue;
+
+      SVN_ERR(svn_ra_svn__parse_tuple(list, "wnbr(?c)(?c)",
+                                      &kind, &size, &has_props,
+                                      &crev, &cdate, &cauthor));
+
+      dirent = svn_dirent_create(result_pool);
+      dirent->kind = svn_node_kind_from_word(kind);
+      dirent->size = size;/* FIXME: svn_filesize_t */
+      dirent->has_props = has_props;
+      dirent->created_rev = crev;
+      SVN_ERR(svn_time_from_cstring(&dirent->time, cdate, iterpool));
+      dirent->last_author = apr_pstrdup(result_pool, cauthor);
+
+      /* Report the path as requested, not as reparented. */
+      svn_hash_sets(*dirents, APR_ARRAY_IDX(paths, i, const char *), dirent);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3282,6 +3720,9 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_get_file_annotation,
+  ra_svn_get_files_batch,
+  ra_svn_stat_many,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
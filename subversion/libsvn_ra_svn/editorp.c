@@ -582,7 +582,7 @@ ra_svn_handle_delete_entry(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)s",
                                   &path, &rev, &token));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
   SVN_CMD_ERR(ds->editor->delete_entry(path, rev, entry->baton, pool));
   return SVN_NO_ERROR;
 }
@@ -604,7 +604,7 @@ ra_svn_handle_add_dir(svn_ra_svn_conn_t *conn,
                                   &child_token, &copy_path, &copy_rev));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
 
   /* Some operations pass COPY_PATH as a full URL (commits, etc.).
      Others (replay, e.g.) deliver an fspath.  That's ... annoying. */
@@ -639,7 +639,7 @@ ra_svn_handle_open_dir(svn_ra_svn_conn_t *conn,
                                   &child_token, &rev));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
   SVN_CMD_ERR(ds->editor->open_directory(path, entry->baton, rev, subpool,
                                          &child_baton));
   store_token(ds, child_baton, child_token, FALSE, subpool);
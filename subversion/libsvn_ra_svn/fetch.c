@@ -0,0 +1,678 @@
+/*
+ * fetch.c :  Fetching file contents over parallel connections
+ *            during updates
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_general.h>
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_ra_svn.h"
+
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
+
+#include "ra_svn.h"
+
+/* The main connection sends the update drive without any file contents.
+ * For every file whose contents changed, we add a task that fetches them
+ * over one of the extra connections, buffering the text in a spill
+ * buffer.  The task set's output function then applies the buffered text
+ * to the wrapped editor as a self-contained delta and closes the file.
+ * Directories are closed once all their children are.
+ *
+ * The output function runs in the thread driving this editor, so the
+ * wrapped editor only ever gets called from there. */
+
+/* Number of fetch jobs we allow to be queued or in flight per connection
+   before close_file blocks. */
+#define JOBS_PER_CONNECTION 8
+
+/* Size parameters of the spill buffers holding the fetched contents. */
+#define SPILL_BLOCKSIZE (16 * 1024)
+#define SPILL_MAXSIZE (256 * 1024)
+
+typedef struct edit_baton_t edit_baton_t;
+
+typedef struct dir_baton_t
+{
+  edit_baton_t *eb;
+  struct dir_baton_t *parent;
+  void *wrapped_baton;
+
+  /* Pool of this baton, independent from the pools of the edit drive. */
+  apr_pool_t *pool;
+
+  /* Number of open or deferred children, plus one until close_directory
+     has been called on us. */
+  int ref_count;
+} dir_baton_t;
+
+typedef struct file_baton_t
+{
+  edit_baton_t *eb;
+  dir_baton_t *parent;
+  void *wrapped_baton;
+  apr_pool_t *pool;
+
+  const char *path;
+
+  /* Whether the drive called apply_textdelta, i.e. whether the contents
+     changed and must be fetched.  BASE_CHECKSUM is what it passed. */
+  svn_boolean_t fetch;
+  const char *base_checksum;
+
+  /* What the drive passed to close_file. */
+  const char *text_checksum;
+} file_baton_t;
+
+/* One of the extra connections. */
+typedef struct fetch_session_t
+{
+  svn_ra_svn__session_baton_t *sess;
+
+  /* Serializes the fetch tasks using SESS. */
+  svn_mutex__t *mutex;
+} fetch_session_t;
+
+typedef struct fetch_job_t
+{
+  file_baton_t *fb;
+
+  /* Copy of FB->PATH, owned by the job. */
+  const char *path;
+
+  /* The connection to fetch the contents over. */
+  fetch_session_t *session;
+
+  /* The fetched contents. */
+  svn_spillbuf_t *contents;
+
+  /* Root pool owned by the job, so that its task may allocate in it. */
+  apr_pool_t *pool;
+
+  struct fetch_job_t *next;
+} fetch_job_t;
+
+struct edit_baton_t
+{
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_baton;
+
+  /* Revision to fetch the file contents from. */
+  svn_revnum_t target_revision;
+
+  /* The extra connections.  Jobs get assigned to them round-robin,
+     NEXT_SESSION being the index of the next one to use. */
+  fetch_session_t *sessions;
+  int session_count;
+  int next_session;
+
+  /* Maximum number of jobs queued, in flight or not yet applied. */
+  int max_outstanding;
+
+  /* Root pool holding the task set and the session mutexes.  NULL once
+     the tasks have been shut down. */
+  apr_pool_t *task_pool;
+  svn_task__set_t *set;
+
+  /* FIFO of jobs that have been queued but not applied yet, i.e. in the
+     order in which the set delivers them. */
+  fetch_job_t *pending_first;
+  fetch_job_t *pending_last;
+
+  /* Number of jobs in the FIFO. */
+  int outstanding;
+
+  apr_pool_t *pool;
+};
+
+/* Destroy JOB and everything it owns. */
+static void
+destroy_job(fetch_job_t *job)
+{
+  svn_pool_destroy(job->pool);
+}
+
+/* Pool cleanup function for the edit_baton_t in DATA.  Terminates the
+   tasks and releases their connections as well as all jobs. */
+static apr_status_t
+fetch_cleanup(void *data)
+{
+  edit_baton_t *eb = data;
+  fetch_job_t *job;
+  int i;
+
+  if (!eb->task_pool)
+    return APR_SUCCESS;
+
+  /* This cancels the queued jobs and waits for those in flight. */
+  svn_pool_destroy(eb->task_pool);
+  eb->task_pool = NULL;
+  eb->set = NULL;
+
+  for (job = eb->pending_first; job; )
+    {
+      fetch_job_t *next = job->next;
+      destroy_job(job);
+      job = next;
+    }
+
+  eb->pending_first = eb->pending_last = NULL;
+  eb->outstanding = 0;
+
+  for (i = 0; i < eb->session_count; ++i)
+    svn_pool_destroy(eb->sessions[i].sess->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Release one reference to DB.  Close it in the wrapped editor once
+   there are none left. */
+static svn_error_t *
+release_dir(dir_baton_t *db)
+{
+  while (db && --db->ref_count == 0)
+    {
+      edit_baton_t *eb = db->eb;
+      dir_baton_t *parent = db->parent;
+
+      SVN_ERR(eb->wrapped_editor->close_directory(db->wrapped_baton,
+                                                  db->pool));
+      svn_pool_destroy(db->pool);
+
+      db = parent;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Send CONTENTS, if not NULL, as the new text of FB to the wrapped
+   editor, then close FB. */
+static svn_error_t *
+finish_file(file_baton_t *fb,
+            svn_stream_t *contents)
+{
+  edit_baton_t *eb = fb->eb;
+  dir_baton_t *parent = fb->parent;
+
+  if (contents)
+    {
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+
+      /* Windows without source ops apply to any base. */
+      SVN_ERR(eb->wrapped_editor->apply_textdelta(fb->wrapped_baton,
+                                                  fb->base_checksum,
+                                                  fb->pool,
+                                                  &handler,
+                                                  &handler_baton));
+      SVN_ERR(svn_txdelta_send_stream(contents, handler, handler_baton,
+                                      NULL, fb->pool));
+    }
+
+  SVN_ERR(eb->wrapped_editor->close_file(fb->wrapped_baton,
+                                         fb->text_checksum, fb->pool));
+  svn_pool_destroy(fb->pool);
+
+  return svn_error_trace(release_dir(parent));
+}
+
+/* Implements svn_task__process_func_t.  Fetch the contents of the
+   fetch_job_t in PROCESS_BATON and return the job in *RESULT. */
+static svn_error_t *
+fetch_task(void **result,
+           void *process_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  fetch_job_t *job = process_baton;
+  edit_baton_t *eb = job->fb->eb;
+  svn_stream_t *stream = svn_stream__from_spillbuf(job->contents,
+                                                   job->pool);
+
+  /* Another task may still be using this connection. */
+  SVN_MUTEX__WITH_LOCK(job->session->mutex,
+                       svn_ra_svn__fetch_file(job->session->sess,
+                                              job->path,
+                                              eb->target_revision,
+                                              stream, scratch_pool));
+
+  *result = job;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Apply and destroy the fetch_job_t
+   in RESULT, which must be the oldest job of the edit_baton_t in
+   OUTPUT_BATON. */
+static svn_error_t *
+apply_job(void *result,
+          void *output_baton,
+          apr_pool_t *scratch_pool)
+{
+  fetch_job_t *job = result;
+  edit_baton_t *eb = output_baton;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(job == eb->pending_first);
+
+  eb->pending_first = job->next;
+  if (!eb->pending_first)
+    eb->pending_last = NULL;
+  eb->outstanding--;
+
+  err = finish_file(job->fb,
+                    svn_stream__from_spillbuf(job->contents, job->pool));
+  destroy_job(job);
+
+  return svn_error_trace(err);
+}
+
+/* Queue a job fetching the contents of FB. */
+static svn_error_t *
+queue_job(edit_baton_t *eb,
+          file_baton_t *fb)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  fetch_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->fb = fb;
+  job->path = apr_pstrdup(pool, fb->path);
+  job->session = &eb->sessions[eb->next_session];
+  job->contents = svn_spillbuf__create(SPILL_BLOCKSIZE, SPILL_MAXSIZE, pool);
+  job->pool = pool;
+
+  eb->next_session = (eb->next_session + 1) % eb->session_count;
+
+  if (eb->pending_last)
+    eb->pending_last->next = job;
+  else
+    eb->pending_first = job;
+  eb->pending_last = job;
+  eb->outstanding++;
+
+  /* This may already apply completed jobs, including this one. */
+  return svn_error_trace(svn_task__add(eb->set, fetch_task, job));
+}
+
+/* Create the task set and the session mutexes for EB. */
+static svn_error_t *
+start_tasks(edit_baton_t *eb)
+{
+  int i;
+
+  eb->task_pool = svn_pool_create(NULL);
+  apr_pool_cleanup_register(eb->pool, eb, fetch_cleanup,
+                            apr_pool_cleanup_null);
+
+  for (i = 0; i < eb->session_count; ++i)
+    SVN_ERR(svn_mutex__init(&eb->sessions[i].mutex, TRUE, eb->task_pool));
+
+  /* The set pool is a sub-pool of TASK_POOL, i.e. it gets destroyed and
+     waits for the running tasks before the mutexes go away. */
+  SVN_ERR(svn_task__set_create(&eb->set, eb->session_count, apply_job, eb,
+                               NULL, NULL, svn_pool_create(eb->task_pool)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  /* The tasks only read this once a job has been queued, i.e. after
+     it has been published through svn_task__add(). */
+  eb->target_revision = target_revision;
+
+  return svn_error_trace(eb->wrapped_editor->set_target_revision(
+                           eb->wrapped_baton, target_revision, pool));
+}
+
+/* Allocate a new directory baton below PARENT. */
+static dir_baton_t *
+make_dir_baton(edit_baton_t *eb,
+               dir_baton_t *parent)
+{
+  apr_pool_t *pool = svn_pool_create(eb->pool);
+  dir_baton_t *db = apr_pcalloc(pool, sizeof(*db));
+
+  db->eb = eb;
+  db->parent = parent;
+  db->pool = pool;
+  db->ref_count = 1;
+
+  if (parent)
+    parent->ref_count++;
+
+  return db;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *dir_pool,
+          void **root_baton)
+{
+  edit_baton_t *eb = edit_baton;
+  dir_baton_t *db = make_dir_baton(eb, NULL);
+
+  SVN_ERR(eb->wrapped_editor->open_root(eb->wrapped_baton, base_revision,
+                                        db->pool, &db->wrapped_baton));
+
+  *root_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t base_revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->delete_entry(
+                           path, base_revision, pb->wrapped_baton, pool));
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *dir_pool,
+              void **child_baton)
+{
+  dir_baton_t *pb = parent_baton;
+  dir_baton_t *db = make_dir_baton(pb->eb, pb);
+
+  SVN_ERR(pb->eb->wrapped_editor->add_directory(path, pb->wrapped_baton,
+                                                copyfrom_path,
+                                                copyfrom_revision,
+                                                db->pool,
+                                                &db->wrapped_baton));
+
+  *child_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *dir_pool,
+               void **child_baton)
+{
+  dir_baton_t *pb = parent_baton;
+  dir_baton_t *db = make_dir_baton(pb->eb, pb);
+
+  SVN_ERR(pb->eb->wrapped_editor->open_directory(path, pb->wrapped_baton,
+                                                 base_revision, db->pool,
+                                                 &db->wrapped_baton));
+
+  *child_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  dir_baton_t *db = dir_baton;
+
+  return svn_error_trace(db->eb->wrapped_editor->change_dir_prop(
+                           db->wrapped_baton, name, value, pool));
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *pool)
+{
+  dir_baton_t *db = dir_baton;
+
+  return svn_error_trace(release_dir(db));
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->absent_directory(
+                           path, pb->wrapped_baton, pool));
+}
+
+/* Allocate a new file baton for PATH below PARENT. */
+static file_baton_t *
+make_file_baton(dir_baton_t *parent,
+                const char *path)
+{
+  apr_pool_t *pool = svn_pool_create(parent->eb->pool);
+  file_baton_t *fb = apr_pcalloc(pool, sizeof(*fb));
+
+  fb->eb = parent->eb;
+  fb->parent = parent;
+  fb->pool = pool;
+  fb->path = apr_pstrdup(pool, path);
+
+  parent->ref_count++;
+
+  return fb;
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *file_pool,
+         void **file_baton)
+{
+  dir_baton_t *pb = parent_baton;
+  file_baton_t *fb = make_file_baton(pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->add_file(path, pb->wrapped_baton,
+                                           copyfrom_path, copyfrom_revision,
+                                           fb->pool, &fb->wrapped_baton));
+
+  *file_baton = fb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *file_pool,
+          void **file_baton)
+{
+  dir_baton_t *pb = parent_baton;
+  file_baton_t *fb = make_file_baton(pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->open_file(path, pb->wrapped_baton,
+                                            base_revision, fb->pool,
+                                            &fb->wrapped_baton));
+
+  *file_baton = fb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  file_baton_t *fb = file_baton;
+
+  /* The drive carries no delta, just the fact that there is one. */
+  fb->fetch = TRUE;
+  fb->base_checksum = apr_pstrdup(fb->pool, base_checksum);
+
+  *handler = svn_delta_noop_window_handler;
+  *handler_baton = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  file_baton_t *fb = file_baton;
+
+  return svn_error_trace(fb->eb->wrapped_editor->change_file_prop(
+                           fb->wrapped_baton, name, value, pool));
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  file_baton_t *fb = file_baton;
+  edit_baton_t *eb = fb->eb;
+
+  fb->text_checksum = apr_pstrdup(fb->pool, text_checksum);
+
+  if (!fb->fetch)
+    return svn_error_trace(finish_file(fb, NULL));
+
+  /* Limit the amount of buffered contents.  This waits for all queued
+     jobs but there are at most MAX_OUTSTANDING of them. */
+  if (eb->outstanding >= eb->max_outstanding)
+    SVN_ERR(svn_task__set_finish(eb->set));
+
+  return svn_error_trace(queue_job(eb, fb));
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->absent_file(
+                           path, pb->wrapped_baton, pool));
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  SVN_ERR(svn_task__set_finish(eb->set));
+
+  apr_pool_cleanup_run(eb->pool, eb, fetch_cleanup);
+
+  return svn_error_trace(eb->wrapped_editor->close_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  apr_pool_cleanup_run(eb->pool, eb, fetch_cleanup);
+
+  return svn_error_trace(eb->wrapped_editor->abort_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+svn_error_t *
+svn_ra_svn__get_fetching_editor(const svn_delta_editor_t **editor,
+                                void **edit_baton,
+                                const svn_delta_editor_t *wrapped_editor,
+                                void *wrapped_baton,
+                                apr_array_header_t *fetch_sessions,
+                                apr_pool_t *result_pool)
+{
+  svn_delta_editor_t *fetching_editor = svn_delta_default_editor(result_pool);
+  edit_baton_t *eb = apr_pcalloc(result_pool, sizeof(*eb));
+  svn_error_t *err;
+  int i;
+
+  eb->wrapped_editor = wrapped_editor;
+  eb->wrapped_baton = wrapped_baton;
+  eb->target_revision = SVN_INVALID_REVNUM;
+  eb->session_count = fetch_sessions->nelts;
+  eb->sessions = apr_pcalloc(result_pool,
+                             eb->session_count * sizeof(*eb->sessions));
+  eb->max_outstanding = eb->session_count * JOBS_PER_CONNECTION;
+  eb->pool = result_pool;
+
+  for (i = 0; i < eb->session_count; ++i)
+    eb->sessions[i].sess = APR_ARRAY_IDX(fetch_sessions, i,
+                                         svn_ra_svn__session_baton_t *);
+
+  /* We own the sessions even if we fail. */
+  err = start_tasks(eb);
+  if (err)
+    {
+      apr_pool_cleanup_run(result_pool, eb, fetch_cleanup);
+      return svn_error_trace(err);
+    }
+
+  fetching_editor->set_target_revision = set_target_revision;
+  fetching_editor->open_root = open_root;
+  fetching_editor->delete_entry = delete_entry;
+  fetching_editor->add_directory = add_directory;
+  fetching_editor->open_directory = open_directory;
+  fetching_editor->change_dir_prop = change_dir_prop;
+  fetching_editor->close_directory = close_directory;
+  fetching_editor->absent_directory = absent_directory;
+  fetching_editor->add_file = add_file;
+  fetching_editor->open_file = open_file;
+  fetching_editor->apply_textdelta = apply_textdelta;
+  fetching_editor->change_file_prop = change_file_prop;
+  fetching_editor->close_file = close_file;
+  fetching_editor->absent_file = absent_file;
+  fetching_editor->close_edit = close_edit;
+  fetching_editor->abort_edit = abort_edit;
+
+  *editor = fetching_editor;
+  *edit_baton = eb;
+
+  return SVN_NO_ERROR;
+}
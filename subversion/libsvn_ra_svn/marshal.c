@@ -236,6 +236,27 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   return conn;
 }
 
+svn_ra_svn_conn_t *
+svn_ra_svn__create_buffer_conn(svn_ra_svn_conn_t *conn,
+                               svn_stringbuf_t *buffer,
+                               apr_uint64_t max_size,
+                               apr_pool_t *result_pool)
+{
+  svn_stream_t *in_stream
+    = svn_stream_from_stringbuf(svn_stringbuf_create_empty(result_pool),
+                                result_pool);
+  svn_stream_t *out_stream = svn_stream_from_stringbuf(buffer, result_pool);
+  svn_ra_svn_conn_t *result
+    = svn_ra_svn_create_conn5(NULL, in_stream, out_stream,
+                              conn->compression_level, 0, 0, 0, max_size,
+                              result_pool);
+
+  /* Make the editor etc. produce the same data as for CONN. */
+  result->capabilities = apr_hash_copy(result_pool, conn->capabilities);
+
+  return result;
+}
+
 svn_error_t *
 svn_ra_svn_set_capabilities(svn_ra_svn_conn_t *conn,
                             const apr_array_header_t *list)
@@ -345,14 +366,21 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+/* Write the NVEC buffers in VEC to socket or output file as appropriate.
+   The contents of VEC will be modified. */
+static svn_error_t *writebuf_outputv(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     struct iovec *vec,
+                                     int nvec)
 {
-  const char *end = data + len;
+  apr_size_t len = 0;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
+  int i;
+
+  for (i = 0; i < nvec; ++i)
+    len += vec[i].iov_len;
 
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
@@ -360,14 +388,21 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   conn->current_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  while (TRUE)
     {
-      count = end - data;
+      /* Skip what has been written already. */
+      while (nvec > 0 && vec->iov_len == 0)
+        {
+          ++vec;
+          --nvec;
+        }
+      if (nvec == 0)
+        break;
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec, &count));
       if (count == 0)
         {
           if (!subpool)
@@ -376,7 +411,6 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
 
       if (session)
         {
@@ -387,6 +421,19 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             (cb->progress_func)(session->bytes_written + session->bytes_read,
                                 -1, cb->progress_baton, subpool);
         }
+
+      for (; count > 0; ++vec, --nvec)
+        if (count < vec->iov_len)
+          {
+            vec->iov_base = (char *)vec->iov_base + count;
+            vec->iov_len -= count;
+            break;
+          }
+        else
+          {
+            count -= vec->iov_len;
+            vec->iov_len = 0;
+          }
     }
 
   conn->written_since_error_check += len;
@@ -398,6 +445,18 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Write data to socket or output file as appropriate. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  struct iovec vec;
+
+  vec.iov_base = (void *)data;
+  vec.iov_len = len;
+
+  return svn_error_trace(writebuf_outputv(conn, pool, &vec, 1));
+}
+
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
@@ -409,17 +468,34 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write the contents of the write buffer followed by LEN bytes of DATA
+   to the socket.  DATA does not get copied and both go out in a single
+   vectored write, if possible. */
+static svn_error_t *writebuf_flush_with(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        const char *data,
+                                        apr_size_t len)
+{
+  struct iovec vec[2];
+
+  vec[0].iov_base = conn->write_buf;
+  vec[0].iov_len = conn->write_pos;
+  vec[1].iov_base = (void *)data;
+  vec[1].iov_len = len;
+
+  /* Clear conn->write_pos first in case the block handler does a read. */
+  conn->write_pos = 0;
+  SVN_ERR(writebuf_outputv(conn, pool, vec, 2));
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
+  /* data >= 8k is sent immediately, together with what has been buffered
+     so far but without copying it. */
   if (len >= sizeof(conn->write_buf) / 2)
-    {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
-
-      return writebuf_output(conn, pool, data, len);
-    }
+    return writebuf_flush_with(conn, pool, data, len);
 
   /* ensure room for the data to add */
   if (conn->write_pos + len > sizeof(conn->write_buf))
@@ -432,6 +508,14 @@ static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_buffer(svn_ra_svn_conn_t *conn,
+                         apr_pool_t *pool,
+                         const svn_stringbuf_t *data)
+{
+  return svn_error_trace(writebuf_write(conn, pool, data->data, data->len));
+}
+
 /* Write STRING_LITERAL, which is a string literal argument.
 
    Note: The purpose of the empty string "" in the macro definition is to
@@ -848,6 +932,30 @@ svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               svn_ra_svn__compression_t method,
+                               apr_pool_t *pool)
+{
+  svn_stringbuf_t *leftover;
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, pool));
+
+  /* Anything left in the read buffer has already been compressed by
+     the other side. */
+  leftover = svn_stringbuf_ncreate(conn->read_ptr,
+                                   conn->read_end - conn->read_ptr,
+                                   conn->pool);
+  conn->read_ptr = conn->read_buf;
+  conn->read_end = conn->read_buf;
+
+  conn->stream = svn_ra_svn__stream_compressed(conn->stream, method,
+                                               leftover, conn->pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* --- WRITING TUPLES --- */
 
 static svn_error_t *
@@ -1891,14 +1999,18 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
                            void *baton,
                            svn_ra_svn_conn_t *conn,
                            svn_boolean_t error_on_disconnect,
+                           svn_ra_svn__command_stats_t *stats,
                            apr_pool_t *pool)
 {
   const char *cmdname;
   svn_error_t *err, *write_err;
   svn_ra_svn__list_t *params;
   const svn_ra_svn__cmd_entry_t *command;
+  apr_time_t start = 0;
 
   *terminate = FALSE;
+  if (stats)
+    memset(stats, 0, sizeof(*stats));
 
   /* Limit I/O for every command separately. */
   svn_ra_svn__reset_command_io_counters(conn);
@@ -1919,6 +2031,9 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      if (stats)
+        start = apr_time_now();
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
@@ -1942,6 +2057,14 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
       err = svn_error_compose_create(check_io_limits(conn), err);
 
       *terminate = command->terminate;
+
+      if (stats)
+        {
+          stats->cmdname = command->cmdname;
+          stats->duration = apr_time_now() - start;
+          stats->bytes_in = conn->current_in;
+          stats->bytes_out = conn->current_out;
+        }
     }
   else
     {
@@ -1984,7 +2107,7 @@ svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
       svn_pool_clear(iterpool);
 
       err = svn_ra_svn__handle_command(&terminate, cmd_hash, baton, conn,
-                                       error_on_disconnect, iterpool);
+                                       error_on_disconnect, NULL, iterpool);
       if (err)
         {
           svn_pool_destroy(subpool);
@@ -2445,7 +2568,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry)
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas)
 {
   SVN_ERR(writebuf_write_literal(conn, pool, "( update ( "));
   SVN_ERR(write_tuple_start_list(conn, pool));
@@ -2456,6 +2580,7 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
   SVN_ERR(write_tuple_depth(conn, pool, depth));
   SVN_ERR(write_tuple_boolean(conn, pool, send_copyfrom_args));
   SVN_ERR(write_tuple_boolean(conn, pool, ignore_ancestry));
+  SVN_ERR(write_tuple_boolean(conn, pool, text_deltas));
   SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
 
   return SVN_NO_ERROR;
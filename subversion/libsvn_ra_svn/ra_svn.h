@@ -33,6 +33,10 @@ extern "C" {
 #include <apr_network_io.h>
 #include <apr_file_io.h>
 #include <apr_thread_proc.h>
+
+#define APR_WANT_IOVEC
+#include <apr_want.h>
+
 #include "svn_ra.h"
 #include "svn_ra_svn.h"
 
@@ -67,6 +71,13 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 
+/* The maximum amount of uncompressed data per frame on a compressed
+ * stream. */
+#define SVN_RA_SVN__COMPRESSED_FRAME_SIZE (16 * SVN_RA_SVN__WRITEBUF_SIZE)
+
+/* Upper limit for the "svn-max-connections" run-time option. */
+#define SVN_RA_SVN__MAX_CONNECTIONS_LIMIT 16
+
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 
@@ -160,6 +171,8 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+  int max_connections; /* Connections to use for fetching file contents
+                          during updates, including CONN itself. */
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -207,6 +220,18 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_from_streams(svn_stream_t *in_stream,
                                                       svn_stream_t *out_stream,
                                                       apr_pool_t *pool);
 
+/* Return a stream that compresses all data written to STREAM with METHOD
+ * and decompresses all data read from it.  LEFTOVER contains data that has
+ * already been received from STREAM and must be decompressed before
+ * reading any further; it may be empty.  Allocate the result in
+ * RESULT_POOL.
+ */
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              svn_ra_svn__compression_t method,
+                              svn_stringbuf_t *leftover,
+                              apr_pool_t *result_pool);
+
 /* Create an svn_ra_svn__stream_t using READ_CB, WRITE_CB, TIMEOUT_CB,
  * PENDING_CB, and BATON.
  */
@@ -222,6 +247,16 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM in that order, returning the
+ * total number of bytes written in *LEN.  Like svn_ra_svn__stream_write,
+ * this may write less than all the data.  Socket streams send all buffers
+ * in a single system call; other streams write at most one buffer.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec,
+                                       int nvec,
+                                       apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -275,6 +310,35 @@ svn_boolean_t svn_ra_svn__find_mech(const svn_ra_svn__list_t *mechlist,
 /* Initialize the SASL library. */
 svn_error_t *svn_ra_svn__sasl_init(void);
 
+/* Write the contents of PATH in REVISION, relative to the session URL of
+ * SESS, to STREAM.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_ra_svn__fetch_file(svn_ra_svn__session_baton_t *sess,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_stream_t *stream,
+                       apr_pool_t *scratch_pool);
+
+/* Return in *EDITOR and *EDIT_BATON an editor that forwards all calls to
+ * WRAPPED_EDITOR and WRAPPED_BATON, except that file contents are not
+ * taken from the edit drive but fetched separately through the
+ * svn_ra_svn__session_baton_t * in FETCH_SESSIONS, concurrently if
+ * there is more than one session.  The drive is expected to come from an update report without
+ * text deltas.  File and directory closes are deferred until the fetched
+ * contents have been applied.
+ *
+ * All FETCH_SESSIONS must be open at the same URL as the edit root and
+ * must have been allocated in root pools of their own.  The editor takes
+ * ownership of them and destroys their pools when RESULT_POOL gets
+ * cleaned up. */
+svn_error_t *
+svn_ra_svn__get_fetching_editor(const svn_delta_editor_t **editor,
+                                void **edit_baton,
+                                const svn_delta_editor_t *wrapped_editor,
+                                void *wrapped_baton,
+                                apr_array_header_t *fetch_sessions,
+                                apr_pool_t *result_pool);
+
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@
 
 
 
+#include <string.h>
 #include <apr_general.h>
 #include <apr_network_io.h>
 #include <apr_poll.h>
@@ -31,9 +32,11 @@
 #include "svn_error.h"
 #include "svn_pools.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 #include "svn_private_config.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_svn.h"
 
@@ -42,6 +45,10 @@ struct svn_ra_svn__stream_st {
   svn_stream_t *out_stream;
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* The socket that OUT_STREAM writes to, if any.  Allows for vectored
+     writes bypassing OUT_STREAM. */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
@@ -167,6 +174,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *stream;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +185,250 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  stream = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                     b, sock_timeout_cb, result_pool);
+  stream->sock = sock;
+
+  return stream;
+}
+
+/* Functions to implement a compressed svn_ra_svn__stream_t.
+ *
+ * Each write to the stream becomes a frame of its own.  A frame is the
+ * length of its payload, encoded with svn__encode_uint, followed by the
+ * payload as produced by svn__compress_lz4 or svn__compress_zstd.  Since
+ * the marshaller writes only when it flushes, no data is held back. */
+
+/* Zstandard compression level to use.  We care about latency more than
+   about the last percent of compression ratio. */
+#define COMPRESSED_STREAM_ZSTD_LEVEL 1
+
+/* Baton for a compressed svn_ra_svn__stream_t. */
+typedef struct compressed_baton_t
+{
+  /* Inherited stream. */
+  svn_ra_svn__stream_t *stream;
+
+  /* The compression method. */
+  svn_ra_svn__compression_t method;
+
+  /* Data that has been received from STREAM before compression got
+     enabled and that has not been consumed yet, starting at LEFTOVER_POS. */
+  svn_stringbuf_t *leftover;
+  apr_size_t leftover_pos;
+
+  /* Payload of the frame being read. */
+  svn_stringbuf_t *read_frame;
+
+  /* Decompressed data, to be returned starting at READ_POS. */
+  svn_stringbuf_t *read_buf;
+  apr_size_t read_pos;
+
+  /* Compressed data of the frame being written. */
+  svn_stringbuf_t *compressed;
+
+  /* The frame being written, to be sent starting at WRITE_POS, and the
+     number of uncompressed bytes that it contains. */
+  svn_stringbuf_t *write_buf;
+  apr_size_t write_pos;
+  apr_size_t write_input_len;
+} compressed_baton_t;
+
+/* Read exactly LEN bytes from B's leftover data or its inherited stream
+   into DATA. */
+static svn_error_t *
+read_raw(compressed_baton_t *b,
+         char *data,
+         apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t count = len;
+
+      if (b->leftover_pos < b->leftover->len)
+        {
+          count = MIN(count, b->leftover->len - b->leftover_pos);
+          memcpy(data, b->leftover->data + b->leftover_pos, count);
+          b->leftover_pos += count;
+        }
+      else
+        {
+          SVN_ERR(svn_ra_svn__stream_read(b->stream, data, &count));
+        }
+
+      data += count;
+      len -= count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next frame from B and decompress it into B->READ_BUF. */
+static svn_error_t *
+read_frame(compressed_baton_t *b)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_uint64_t payload_len;
+  apr_size_t i;
+
+  /* Read the frame header byte by byte.  The last byte of an encoded
+     integer has the high bit cleared. */
+  for (i = 0; i < sizeof(header); ++i)
+    {
+      SVN_ERR(read_raw(b, (char *)&header[i], 1));
+      if (header[i] < 0x80)
+        break;
+    }
+
+  if (   i == sizeof(header)
+      || svn__decode_uint(&payload_len, header, header + i + 1) == NULL
+      || payload_len > 2 * SVN_RA_SVN__COMPRESSED_FRAME_SIZE)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Invalid compressed frame header"));
+
+  svn_stringbuf_ensure(b->read_frame, (apr_size_t)payload_len);
+  SVN_ERR(read_raw(b, b->read_frame->data, (apr_size_t)payload_len));
+  b->read_frame->len = (apr_size_t)payload_len;
+
+  if (b->method == svn_ra_svn__compression_zstd)
+    SVN_ERR(svn__decompress_zstd(b->read_frame->data, b->read_frame->len,
+                                 b->read_buf,
+                                 SVN_RA_SVN__COMPRESSED_FRAME_SIZE));
+  else
+    SVN_ERR(svn__decompress_lz4(b->read_frame->data, b->read_frame->len,
+                                b->read_buf,
+                                SVN_RA_SVN__COMPRESSED_FRAME_SIZE));
+  b->read_pos = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compressed_read_cb(void *baton,
+                   char *buffer,
+                   apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  while (b->read_pos == b->read_buf->len)
+    SVN_ERR(read_frame(b));
+
+  *len = MIN(*len, b->read_buf->len - b->read_pos);
+  memcpy(buffer, b->read_buf->data + b->read_pos, *len);
+  b->read_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compressed_write_cb(void *baton,
+                    const char *buffer,
+                    apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  /* Compress the data into a new frame, unless we still have one that
+     could not be sent completely before.  In that case, we get called
+     with the same arguments again. */
+  if (b->write_pos == b->write_buf->len)
+    {
+      unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+      unsigned char *header_end;
+
+      b->write_input_len = MIN(*len, SVN_RA_SVN__COMPRESSED_FRAME_SIZE);
+      if (b->method == svn_ra_svn__compression_zstd)
+        SVN_ERR(svn__compress_zstd(buffer, b->write_input_len,
+                                   b->compressed,
+                                   COMPRESSED_STREAM_ZSTD_LEVEL));
+      else
+        SVN_ERR(svn__compress_lz4(buffer, b->write_input_len,
+                                  b->compressed));
+
+      header_end = svn__encode_uint(header, b->compressed->len);
+      svn_stringbuf_setempty(b->write_buf);
+      svn_stringbuf_appendbytes(b->write_buf, (const char *)header,
+                                header_end - header);
+      svn_stringbuf_appendstr(b->write_buf, b->compressed);
+      b->write_pos = 0;
+    }
+
+  while (b->write_pos < b->write_buf->len)
+    {
+      apr_size_t count = b->write_buf->len - b->write_pos;
+      SVN_ERR(svn_ra_svn__stream_write(b->stream,
+                                       b->write_buf->data + b->write_pos,
+                                       &count));
+      if (count == 0)
+        {
+          /* The rest of the frame will be written out during the next
+             call to this function. */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      b->write_pos += count;
+    }
+
+  *len = b->write_input_len;
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compressed_timeout_cb(void *baton,
+                      apr_interval_time_t interval)
+{
+  compressed_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compressed_data_available_cb(void *baton,
+                             svn_boolean_t *data_available)
+{
+  compressed_baton_t *b = baton;
+
+  if (   b->read_pos < b->read_buf->len
+      || b->leftover_pos < b->leftover->len)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              svn_ra_svn__compression_t method,
+                              svn_stringbuf_t *leftover,
+                              apr_pool_t *result_pool)
+{
+  compressed_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *in_stream = svn_stream_create(b, result_pool);
+  svn_stream_t *out_stream = svn_stream_create(b, result_pool);
+
+  b->stream = stream;
+  b->method = method;
+  b->leftover = leftover;
+  b->read_frame = svn_stringbuf_create_empty(result_pool);
+  b->read_buf = svn_stringbuf_create_empty(result_pool);
+  b->compressed = svn_stringbuf_create_empty(result_pool);
+  b->write_buf = svn_stringbuf_create_empty(result_pool);
+
+  svn_stream_set_read2(in_stream, compressed_read_cb,
+                       NULL /* use default */);
+  svn_stream_set_data_available(in_stream, compressed_data_available_cb);
+  svn_stream_set_write(out_stream, compressed_write_cb);
+
+  /* The result has no socket, so vectored writes go through
+     OUT_STREAM as well. */
+  return svn_ra_svn__stream_create(in_stream, out_stream, b,
+                                   compressed_timeout_cb, result_pool);
 }
 
 svn_ra_svn__stream_t *
@@ -193,6 +443,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   s->out_stream = out_stream;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
+  s->sock = NULL;
   return s;
 }
 
@@ -203,6 +454,37 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec,
+                          int nvec,
+                          apr_size_t *len)
+{
+  int i;
+
+  if (stream->sock)
+    {
+      apr_status_t status = apr_socket_sendv(stream->sock, vec, nvec, len);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Generic streams have no vectored write.  Write the first non-empty
+     buffer and let the caller come back for the rest. */
+  for (i = 0; i < nvec; ++i)
+    if (vec[i].iov_len)
+      {
+        *len = vec[i].iov_len;
+        return svn_error_trace(svn_stream_write(stream->out_stream,
+                                                vec[i].iov_base, len));
+      }
+
+  *len = 0;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
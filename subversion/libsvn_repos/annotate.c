@@ -0,0 +1,444 @@
+/* annotate.c : server-side line-by-line revision attribution
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_tables.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_diff.h"
+#include "svn_repos.h"
+#include "svn_io.h"
+
+#include "private/svn_cache.h"
+
+#include "repos.h"
+#include "svn_private_config.h"
+
+
+
+/* A history location of the file being annotated. */
+typedef struct location_t
+{
+  const char *path;
+  svn_revnum_t revision;
+} location_t;
+
+/* Baton for history_receiver(). */
+typedef struct history_baton_t
+{
+  /* The annotation cache or NULL. */
+  svn_cache__t *cache;
+
+  /* Locations that still need to be processed, youngest first.
+   * Elements are location_t. */
+  apr_array_header_t *locations;
+
+  /* The cached line revisions of the oldest location in LOCATIONS,
+   * or NULL if that one has to be computed from scratch. */
+  svn_stringbuf_t *cached_revs;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Allocate LOCATIONS and CACHED_REVS in here. */
+  apr_pool_t *pool;
+} history_baton_t;
+
+/* Baton for the svn_diff_output_fns_t callbacks. */
+typedef struct diff_baton_t
+{
+  /* Line revisions of the previous version of the file. */
+  const svn_revnum_t *old_revs;
+
+  /* Line revisions of the new version, to be filled. */
+  svn_revnum_t *new_revs;
+
+  /* Revision of the new version. */
+  svn_revnum_t revision;
+} diff_baton_t;
+
+/* Return the annotation cache for REPOS, creating it on demand.  Return
+ * NULL if there is no global membuffer cache to put it in.
+ */
+static svn_error_t *
+get_cache(svn_cache__t **cache,
+          svn_repos_t *repos,
+          apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer;
+  const char *uuid;
+
+  if (repos->annotate_cache)
+    {
+      *cache = repos->annotate_cache;
+      return SVN_NO_ERROR;
+    }
+
+  *cache = NULL;
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, scratch_pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &repos->annotate_cache, membuffer, NULL, NULL,
+            APR_HASH_KEY_STRING,
+            apr_pstrcat(scratch_pool, "repos-annotate:", uuid, SVN_VA_NULL),
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            svn_cache__admission_default,
+            TRUE, FALSE, repos->pool, scratch_pool));
+
+  *cache = repos->annotate_cache;
+  return SVN_NO_ERROR;
+}
+
+/* Return the cache key for PATH in REVISION, allocated in POOL. */
+static const char *
+cache_key(const char *path,
+          svn_revnum_t revision,
+          apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%ld:%s", revision, path);
+}
+
+/* Implements svn_repos_history_func_t.  Collect locations until we find
+ * one that is already in the cache.
+ */
+static svn_error_t *
+history_receiver(void *baton,
+                 const char *path,
+                 svn_revnum_t revision,
+                 apr_pool_t *pool)
+{
+  history_baton_t *hb = baton;
+  location_t *location;
+
+  if (hb->cancel_func)
+    SVN_ERR(hb->cancel_func(hb->cancel_baton));
+
+  location = apr_array_push(hb->locations);
+  location->path = apr_pstrdup(hb->pool, path);
+  location->revision = revision;
+
+  if (hb->cache)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **)&hb->cached_revs, &found, hb->cache,
+                             cache_key(path, revision, pool), hb->pool));
+      if (found)
+        return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Split TEXT into lines the same way svn_diff_mem_string_diff() does and
+ * return them as an array of svn_string_t allocated in POOL.  The lines
+ * point into TEXT.
+ */
+static apr_array_header_t *
+split_lines(const svn_string_t *text,
+            apr_pool_t *pool)
+{
+  apr_array_header_t *lines = apr_array_make(pool, 0, sizeof(svn_string_t));
+  const char *startp = text->data;
+  const char *endp = text->data + text->len;
+  const char *curp;
+
+  for (curp = startp; curp != endp; curp++)
+    {
+      if (*curp == '\r' && curp + 1 != endp && curp[1] == '\n')
+        curp++;
+
+      if (*curp == '\r' || *curp == '\n')
+        {
+          svn_string_t *line = apr_array_push(lines);
+          line->data = startp;
+          line->len = curp - startp + 1;
+          startp = curp + 1;
+        }
+    }
+
+  if (startp != endp)
+    {
+      svn_string_t *line = apr_array_push(lines);
+      line->data = startp;
+      line->len = endp - startp;
+    }
+
+  return lines;
+}
+
+/* Implements svn_diff_output_fns_t::output_common. */
+static svn_error_t *
+output_common(void *baton,
+              apr_off_t original_start,
+              apr_off_t original_length,
+              apr_off_t modified_start,
+              apr_off_t modified_length,
+              apr_off_t latest_start,
+              apr_off_t latest_length)
+{
+  diff_baton_t *db = baton;
+
+  memcpy(db->new_revs + modified_start, db->old_revs + original_start,
+         modified_length * sizeof(*db->new_revs));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t::output_diff_modified. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  diff_baton_t *db = baton;
+  apr_off_t i;
+
+  for (i = 0; i < modified_length; i++)
+    db->new_revs[modified_start + i] = db->revision;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t annotate_output_fns =
+{
+  output_common,
+  output_diff_modified
+};
+
+/* Read the contents of PATH in REVISION of FS into *CONTENTS, allocated
+ * in RESULT_POOL.
+ */
+static svn_error_t *
+read_contents(svn_string_t **contents,
+              svn_fs_t *fs,
+              const char *path,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, scratch_pool));
+  SVN_ERR(svn_string_from_stream2(contents, stream, 0, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_get_file_annotation(svn_repos_t *repos,
+                              const char *path,
+                              svn_revnum_t revision,
+                              svn_repos_authz_func_t authz_read_func,
+                              void *authz_read_baton,
+                              svn_repos_annotate_receiver_t receiver,
+                              void *receiver_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+  history_baton_t hb;
+  svn_diff_file_options_t *diff_options;
+  svn_stringbuf_t *revs = NULL;
+  svn_string_t *contents = NULL;
+  location_t cached_location;
+  location_t *previous = NULL;
+  apr_array_header_t *lines;
+  apr_pool_t *iterpool;
+  apr_pool_t *lastpool;
+  apr_pool_t *nextpool;
+  int i;
+
+  /* Verify that PATH is a file in REVISION. */
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_file)
+    return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                             _("'%s' is not a file in revision %ld"),
+                             path, revision);
+
+  /* Collect the history back to the youngest cached location.  What the
+   * history looks like depends on the AUTHZ_READ_FUNC, which is not part
+   * of the cache key.  So, only unrestricted results may be shared. */
+  if (authz_read_func)
+    hb.cache = NULL;
+  else
+    SVN_ERR(get_cache(&hb.cache, repos, scratch_pool));
+  hb.locations = apr_array_make(scratch_pool, 16, sizeof(location_t));
+  hb.cached_revs = NULL;
+  hb.cancel_func = cancel_func;
+  hb.cancel_baton = cancel_baton;
+  hb.pool = scratch_pool;
+
+  SVN_ERR(svn_repos_history2(repos->fs, path, history_receiver, &hb,
+                             authz_read_func, authz_read_baton,
+                             0, revision, TRUE, scratch_pool));
+
+  if (hb.cached_revs)
+    {
+      cached_location = *(location_t *)apr_array_pop(hb.locations);
+      previous = &cached_location;
+      revs = hb.cached_revs;
+    }
+
+  /* Walk forward from there and derive each location's line revisions
+   * from those of its predecessor.  REVS and CONTENTS live in LASTPOOL,
+   * the data for the current location gets allocated in NEXTPOOL. */
+  diff_options = svn_diff_file_options_create(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  lastpool = svn_pool_create(scratch_pool);
+  nextpool = svn_pool_create(scratch_pool);
+  for (i = hb.locations->nelts - 1; i >= 0; i--)
+    {
+      location_t *location = &APR_ARRAY_IDX(hb.locations, i, location_t);
+      svn_string_t *new_contents = NULL;
+      svn_stringbuf_t *new_revs;
+      svn_boolean_t changed = TRUE;
+      apr_pool_t *tmppool;
+
+      svn_pool_clear(iterpool);
+      svn_pool_clear(nextpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (previous)
+        {
+          svn_fs_root_t *previous_root;
+
+          SVN_ERR(svn_fs_revision_root(&previous_root, repos->fs,
+                                       previous->revision, iterpool));
+          SVN_ERR(svn_fs_revision_root(&root, repos->fs,
+                                       location->revision, iterpool));
+          SVN_ERR(svn_fs_contents_different(&changed,
+                                            previous_root, previous->path,
+                                            root, location->path,
+                                            iterpool));
+        }
+
+      if (!changed)
+        {
+          /* E.g. a property change or a copy.  The lines stay the same. */
+          new_revs = svn_stringbuf_dup(revs, nextpool);
+          if (contents)
+            new_contents = svn_string_dup(contents, nextpool);
+        }
+      else
+        {
+          diff_baton_t db;
+          apr_size_t line_count;
+
+          SVN_ERR(read_contents(&new_contents, repos->fs, location->path,
+                                location->revision, nextpool, iterpool));
+          line_count = split_lines(new_contents, iterpool)->nelts;
+
+          new_revs = svn_stringbuf_create_ensure(
+                       line_count * sizeof(svn_revnum_t), nextpool);
+          new_revs->len = line_count * sizeof(svn_revnum_t);
+
+          db.new_revs = (svn_revnum_t *)new_revs->data;
+          db.revision = location->revision;
+
+          if (revs)
+            {
+              svn_diff_t *diff;
+
+              /* The cache only provides the revisions, not the text. */
+              if (!contents)
+                SVN_ERR(read_contents(&contents, repos->fs, previous->path,
+                                      previous->revision, iterpool,
+                                      iterpool));
+
+              db.old_revs = (const svn_revnum_t *)revs->data;
+              SVN_ERR(svn_diff_mem_string_diff(&diff, contents, new_contents,
+                                               diff_options, iterpool));
+              SVN_ERR(svn_diff_output2(diff, &db, &annotate_output_fns,
+                                       cancel_func, cancel_baton));
+            }
+          else
+            {
+              apr_size_t k;
+
+              for (k = 0; k < line_count; k++)
+                db.new_revs[k] = location->revision;
+            }
+        }
+
+      if (hb.cache)
+        SVN_ERR(svn_cache__set(hb.cache,
+                               cache_key(location->path, location->revision,
+                                         iterpool),
+                               new_revs, iterpool));
+
+      revs = new_revs;
+      contents = new_contents;
+      previous = location;
+
+      tmppool = lastpool;
+      lastpool = nextpool;
+      nextpool = tmppool;
+    }
+
+  /* If everything came from the cache, we still need the text itself. */
+  if (!contents)
+    SVN_ERR(read_contents(&contents, repos->fs, previous->path,
+                          previous->revision, scratch_pool, iterpool));
+
+  /* Report the lines. */
+  lines = split_lines(contents, scratch_pool);
+  if (lines->nelts * sizeof(svn_revnum_t) != revs->len)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Cached annotation for '%s' in revision %ld "
+                               "does not match the file contents"),
+                             previous->path, previous->revision);
+
+  for (i = 0; i < lines->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(receiver(receiver_baton, i,
+                       ((const svn_revnum_t *)revs->data)[i],
+                       &APR_ARRAY_IDX(lines, i, svn_string_t), iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(lastpool);
+  svn_pool_destroy(nextpool);
+
+  return SVN_NO_ERROR;
+}
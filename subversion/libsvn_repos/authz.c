@@ -26,6 +26,7 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_fnmatch.h>
+#include <apr_mmap.h>
 
 #include "svn_hash.h"
 #include "svn_pools.h"
@@ -44,6 +45,8 @@
 #include "authz.h"
 #include "config_file.h"
 
+#include "svn_private_config.h"
+
 
 /*** Access rights. ***/
 
@@ -965,6 +968,677 @@ create_user_authz(authz_full_t *authz,
 }
 
 
+/*** Compiled snapshots. ***/
+
+/* Filtering the full model for a single user is cheap.  With thousands of
+ * users and many server processes, however, it adds up because every
+ * worker has to do it again after each restart.  A snapshot file contains
+ * the filtered path rule trees for all users mentioned in an authz file,
+ * for the anonymous user and for all other authenticated users, in a
+ * position-independent form that can be mapped into memory as is.
+ *
+ * All integers are apr_uint32_t in native byte order.  The file layout is:
+ *
+ *   snapshot_header_t
+ *   authz ID, padded to a multiple of 4 bytes
+ *   snapshot_entry_t[ENTRY_COUNT], sorted by repository and user name
+ *   NUL-terminated repository and user names, padded
+ *   flat trees, each one 4-byte aligned
+ *
+ * Users with identical rules share the same flat tree.  A flat tree is a
+ * flat_tree_t followed by NODE_COUNT flat_node_t, CHILD_COUNT node indexes
+ * and STRINGS_SIZE bytes of NUL-terminated segment strings.  Node 0 is the
+ * root and all sub-nodes have larger indexes than their parents.
+ */
+
+/* Identifies snapshot files.  Exactly 8 chars. */
+#define SNAPSHOT_MAGIC "SVNAZSNP"
+
+/* Format of the snapshot files that we write and understand. */
+#define SNAPSHOT_FORMAT 1
+
+/* Snapshots are read on the machine that wrote them.  This catches the
+ * exception to that rule. */
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+/* Snapshot user name standing in for all authenticated users that are not
+ * mentioned in the authz file; they all get the same rules.  User names
+ * cannot contain newlines, so this never clashes with a real user. */
+#define SNAPSHOT_OTHER_USER "\n"
+
+/* Node index value used for "no such node". */
+#define SNAPSHOT_NO_NODE ((apr_uint32_t)-1)
+
+/* Flags in flat_node_t. */
+#define FLAT_NODE_HAS_PATTERNS 0x1
+#define FLAT_NODE_REPEAT       0x2
+
+/* Start of each snapshot file. */
+typedef struct snapshot_header_t
+{
+  char magic[8];
+  apr_uint32_t format;
+  apr_uint32_t byte_order;
+
+  /* Size of the authz ID that follows the header. */
+  apr_uint32_t id_size;
+
+  /* Number of snapshot_entry_t in the lookup table. */
+  apr_uint32_t entry_count;
+} snapshot_header_t;
+
+/* Lookup table entry.  All offsets are relative to the start of the file. */
+typedef struct snapshot_entry_t
+{
+  apr_uint32_t repository;
+  apr_uint32_t user;
+  apr_uint32_t tree;
+  apr_uint32_t tree_size;
+} snapshot_entry_t;
+
+/* Header of a flat tree. */
+typedef struct flat_tree_t
+{
+  apr_uint32_t node_count;
+  apr_uint32_t child_count;
+  apr_uint32_t strings_size;
+} flat_tree_t;
+
+/* Flat form of a node_t. */
+typedef struct flat_node_t
+{
+  /* Offset and length of the segment within the string section. */
+  apr_uint32_t segment;
+  apr_uint32_t segment_len;
+
+  /* The limited_rights_t contents. */
+  apr_int32_t sequence_number;
+  apr_uint32_t rights;
+  apr_uint32_t min_rights;
+  apr_uint32_t max_rights;
+
+  /* The sub-node indexes start at FIRST_CHILD within the child index
+   * section: SUB_NODE_COUNT literal sub-nodes followed by PREFIX_COUNT,
+   * SUFFIX_COUNT and COMPLEX_COUNT pattern sub-nodes, in the order of the
+   * respective node_pattern_t arrays. */
+  apr_uint32_t first_child;
+  apr_uint32_t sub_node_count;
+  apr_uint32_t prefix_count;
+  apr_uint32_t suffix_count;
+  apr_uint32_t complex_count;
+
+  /* Indexes of the "*" and "**" sub-nodes or SNAPSHOT_NO_NODE. */
+  apr_uint32_t any;
+  apr_uint32_t any_var;
+
+  /* Combination of FLAT_NODE_* flags. */
+  apr_uint32_t flags;
+} flat_node_t;
+
+/* A snapshot file mapped into memory. */
+struct authz_snapshot_t
+{
+  /* The file contents. */
+  const char *data;
+  apr_size_t size;
+
+  /* The lookup table within DATA. */
+  const snapshot_entry_t *entries;
+  apr_uint32_t entry_count;
+
+  /* Repository names (const char *) that have specific rules.  All other
+   * repositories get the same rules as AUTHZ_ANY_REPOSITORY. */
+  apr_hash_t *named_repos;
+};
+
+/* Context used while flattening a node_t tree. */
+typedef struct flatten_context_t
+{
+  /* Flattened nodes (flat_node_t). */
+  apr_array_header_t *nodes;
+
+  /* Sub-node indexes (apr_uint32_t). */
+  apr_array_header_t *children;
+
+  /* The string section. */
+  svn_stringbuf_t *strings;
+
+  /* For temporary allocations. */
+  apr_pool_t *scratch_pool;
+} flatten_context_t;
+
+/* Append zero bytes to BUFFER until its length is a multiple of 4. */
+static void
+pad_snapshot_buffer(svn_stringbuf_t *buffer)
+{
+  static const char zeros[4] = { 0 };
+  svn_stringbuf_appendbytes(buffer, zeros,
+                            APR_ALIGN(buffer->len, 4) - buffer->len);
+}
+
+static apr_uint32_t
+flatten_node(flatten_context_t *ctx,
+             const node_t *node);
+
+/* Flatten all nodes in the sorted_pattern_t ARRAY and store their indexes
+ * in CTX's child slots, starting at *SLOT.  Update *SLOT accordingly. */
+static void
+flatten_pattern_array(flatten_context_t *ctx,
+                      apr_uint32_t *slot,
+                      const apr_array_header_t *array)
+{
+  int i;
+  if (!array)
+    return;
+
+  for (i = 0; i < array->nelts; ++i)
+    {
+      const sorted_pattern_t *pattern
+        = &APR_ARRAY_IDX(array, i, sorted_pattern_t);
+      apr_uint32_t index = flatten_node(ctx, pattern->node);
+      APR_ARRAY_IDX(ctx->children, (*slot)++, apr_uint32_t) = index;
+    }
+}
+
+/* Append the flat form of NODE and its sub-tree to CTX.  Return the index
+ * of NODE's flat form. */
+static apr_uint32_t
+flatten_node(flatten_context_t *ctx,
+             const node_t *node)
+{
+  const node_pattern_t *patterns = node->pattern_sub_nodes;
+  apr_uint32_t index = ctx->nodes->nelts;
+  apr_uint32_t slot, count;
+  flat_node_t flat = { 0 };
+
+  flat.segment = (apr_uint32_t)ctx->strings->len;
+  flat.segment_len = (apr_uint32_t)node->segment.len;
+  svn_stringbuf_appendbytes(ctx->strings, node->segment.data,
+                            node->segment.len);
+  svn_stringbuf_appendbyte(ctx->strings, '\0');
+
+  flat.sequence_number = node->rights.access.sequence_number;
+  flat.rights = node->rights.access.rights;
+  flat.min_rights = node->rights.min_rights;
+  flat.max_rights = node->rights.max_rights;
+
+  flat.any = SNAPSHOT_NO_NODE;
+  flat.any_var = SNAPSHOT_NO_NODE;
+  flat.sub_node_count = node->sub_nodes ? apr_hash_count(node->sub_nodes) : 0;
+  if (patterns)
+    {
+      flat.flags = FLAT_NODE_HAS_PATTERNS
+                 | (patterns->repeat ? FLAT_NODE_REPEAT : 0);
+      flat.prefix_count = patterns->prefixes ? patterns->prefixes->nelts : 0;
+      flat.suffix_count = patterns->suffixes ? patterns->suffixes->nelts : 0;
+      flat.complex_count = patterns->complex ? patterns->complex->nelts : 0;
+    }
+
+  /* Reserve the child slots before adding any sub-nodes. */
+  flat.first_child = ctx->children->nelts;
+  count = flat.sub_node_count + flat.prefix_count + flat.suffix_count
+        + flat.complex_count;
+  for (slot = 0; slot < count; ++slot)
+    APR_ARRAY_PUSH(ctx->children, apr_uint32_t) = SNAPSHOT_NO_NODE;
+
+  APR_ARRAY_PUSH(ctx->nodes, flat_node_t) = flat;
+
+  /* Add the sub-nodes.  Note that this reallocates CTX's arrays. */
+  slot = flat.first_child;
+  if (node->sub_nodes)
+    {
+      /* Sort the sub-nodes to make the output reproducible. */
+      apr_array_header_t *sorted
+        = svn_sort__hash(node->sub_nodes, svn_sort_compare_items_lexically,
+                         ctx->scratch_pool);
+      int i;
+
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          const node_t *sub_node
+            = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+          apr_uint32_t sub_index = flatten_node(ctx, sub_node);
+          APR_ARRAY_IDX(ctx->children, slot++, apr_uint32_t) = sub_index;
+        }
+    }
+
+  if (patterns)
+    {
+      flat_node_t *target;
+      apr_uint32_t any = SNAPSHOT_NO_NODE;
+      apr_uint32_t any_var = SNAPSHOT_NO_NODE;
+
+      if (patterns->any)
+        any = flatten_node(ctx, patterns->any);
+      if (patterns->any_var)
+        any_var = flatten_node(ctx, patterns->any_var);
+
+      flatten_pattern_array(ctx, &slot, patterns->prefixes);
+      flatten_pattern_array(ctx, &slot, patterns->suffixes);
+      flatten_pattern_array(ctx, &slot, patterns->complex);
+
+      target = &APR_ARRAY_IDX(ctx->nodes, index, flat_node_t);
+      target->any = any;
+      target->any_var = any_var;
+    }
+
+  return index;
+}
+
+/* Append the flat form of the filtered tree ROOT to BUFFER.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+flatten_tree(svn_stringbuf_t *buffer,
+             const node_t *root,
+             apr_pool_t *scratch_pool)
+{
+  flatten_context_t ctx;
+  flat_tree_t header;
+
+  ctx.nodes = apr_array_make(scratch_pool, 16, sizeof(flat_node_t));
+  ctx.children = apr_array_make(scratch_pool, 16, sizeof(apr_uint32_t));
+  ctx.strings = svn_stringbuf_create_empty(scratch_pool);
+  ctx.scratch_pool = scratch_pool;
+
+  flatten_node(&ctx, root);
+
+  header.node_count = ctx.nodes->nelts;
+  header.child_count = ctx.children->nelts;
+  header.strings_size = (apr_uint32_t)ctx.strings->len;
+
+  svn_stringbuf_appendbytes(buffer, (const char *)&header, sizeof(header));
+  svn_stringbuf_appendbytes(buffer, ctx.nodes->elts,
+                            ctx.nodes->nelts * ctx.nodes->elt_size);
+  svn_stringbuf_appendbytes(buffer, ctx.children->elts,
+                            ctx.children->nelts * ctx.children->elt_size);
+  svn_stringbuf_appendbytes(buffer, ctx.strings->data, ctx.strings->len);
+  pad_snapshot_buffer(buffer);
+}
+
+/* Context used while reconstructing a node_t tree from its flat form. */
+typedef struct unflatten_context_t
+{
+  const flat_tree_t *tree;
+  const flat_node_t *nodes;
+  const apr_uint32_t *children;
+  const char *strings;
+
+  /* Target pool for the node_t tree. */
+  apr_pool_t *result_pool;
+} unflatten_context_t;
+
+static node_t *
+unflatten_node(const unflatten_context_t *ctx,
+               apr_uint32_t index);
+
+/* Return the reconstructed sub-node INDEX of node PARENT in CTX.
+ * Return NULL if INDEX is not valid. */
+static node_t *
+unflatten_sub_node(const unflatten_context_t *ctx,
+                   apr_uint32_t parent,
+                   apr_uint32_t index)
+{
+  /* Requiring sub-nodes to follow their parents also rules out cycles. */
+  if (index <= parent || index >= ctx->tree->node_count)
+    return NULL;
+
+  return unflatten_node(ctx, index);
+}
+
+/* Set *ARRAY to the sorted_pattern_t array of the COUNT sub-nodes of
+ * PARENT in CTX whose indexes start at child slot *SLOT.  Update *SLOT
+ * accordingly.  Return FALSE if the flat data is not valid. */
+static svn_boolean_t
+unflatten_pattern_array(apr_array_header_t **array,
+                        const unflatten_context_t *ctx,
+                        apr_uint32_t parent,
+                        apr_uint32_t *slot,
+                        apr_uint32_t count)
+{
+  apr_uint32_t i;
+
+  *array = NULL;
+  if (!count)
+    return TRUE;
+
+  *array = apr_array_make(ctx->result_pool, count, sizeof(sorted_pattern_t));
+  for (i = 0; i < count; ++i)
+    {
+      sorted_pattern_t pattern;
+      pattern.node = unflatten_sub_node(ctx, parent,
+                                        ctx->children[(*slot)++]);
+      pattern.next = NULL;
+      if (!pattern.node)
+        return FALSE;
+
+      APR_ARRAY_PUSH(*array, sorted_pattern_t) = pattern;
+    }
+
+  /* Re-establish the prefix links, just like finalize_tree() does. */
+  link_prefix_patterns(*array);
+
+  return TRUE;
+}
+
+/* Return node INDEX of CTX, including its sub-tree, reconstructed as a
+ * filtered tree node.  Return NULL if the flat data is not valid. */
+static node_t *
+unflatten_node(const unflatten_context_t *ctx,
+               apr_uint32_t index)
+{
+  const flat_node_t *flat = &ctx->nodes[index];
+  apr_uint32_t slot = flat->first_child;
+  apr_uint32_t i;
+  node_t *node;
+
+  /* Check the references into the other sections. */
+  if (   (apr_uint64_t)flat->segment + flat->segment_len
+           >= ctx->tree->strings_size
+      || ctx->strings[flat->segment + flat->segment_len] != '\0')
+    return NULL;
+
+  if (  (apr_uint64_t)flat->first_child + flat->sub_node_count
+      + flat->prefix_count + flat->suffix_count + flat->complex_count
+      > ctx->tree->child_count)
+    return NULL;
+
+  /* Segments point directly into the snapshot data. */
+  node = apr_pcalloc(ctx->result_pool, sizeof(*node));
+  node->segment.data = ctx->strings + flat->segment;
+  node->segment.len = flat->segment_len;
+  node->rights.access.sequence_number = flat->sequence_number;
+  node->rights.access.rights = flat->rights;
+  node->rights.min_rights = flat->min_rights;
+  node->rights.max_rights = flat->max_rights;
+
+  if (flat->sub_node_count)
+    {
+      node->sub_nodes = svn_hash__make(ctx->result_pool);
+      for (i = 0; i < flat->sub_node_count; ++i)
+        {
+          node_t *sub_node = unflatten_sub_node(ctx, index,
+                                                ctx->children[slot++]);
+          if (!sub_node)
+            return NULL;
+
+          apr_hash_set(node->sub_nodes, sub_node->segment.data,
+                       sub_node->segment.len, sub_node);
+        }
+    }
+
+  if (flat->flags & FLAT_NODE_HAS_PATTERNS)
+    {
+      node_pattern_t *patterns = apr_pcalloc(ctx->result_pool,
+                                             sizeof(*patterns));
+      node->pattern_sub_nodes = patterns;
+      patterns->repeat = (flat->flags & FLAT_NODE_REPEAT) != 0;
+
+      if (flat->any != SNAPSHOT_NO_NODE)
+        {
+          patterns->any = unflatten_sub_node(ctx, index, flat->any);
+          if (!patterns->any)
+            return NULL;
+        }
+
+      if (flat->any_var != SNAPSHOT_NO_NODE)
+        {
+          patterns->any_var = unflatten_sub_node(ctx, index, flat->any_var);
+          if (!patterns->any_var)
+            return NULL;
+        }
+
+      if (   !unflatten_pattern_array(&patterns->prefixes, ctx, index, &slot,
+                                      flat->prefix_count)
+          || !unflatten_pattern_array(&patterns->suffixes, ctx, index, &slot,
+                                      flat->suffix_count)
+          || !unflatten_pattern_array(&patterns->complex, ctx, index, &slot,
+                                      flat->complex_count))
+        return NULL;
+    }
+
+  return node;
+}
+
+/* Return the filtered tree stored in flat form in the SIZE bytes at DATA.
+ * The result references DATA and is otherwise allocated in RESULT_POOL.
+ * Return NULL if the flat data is not valid. */
+static node_t *
+unflatten_tree(const char *data,
+               apr_size_t size,
+               apr_pool_t *result_pool)
+{
+  unflatten_context_t ctx;
+
+  ctx.tree = (const flat_tree_t *)data;
+  if (   size < sizeof(*ctx.tree)
+      || ctx.tree->node_count == 0
+      || sizeof(*ctx.tree)
+         + (apr_uint64_t)ctx.tree->node_count * sizeof(flat_node_t)
+         + (apr_uint64_t)ctx.tree->child_count * sizeof(apr_uint32_t)
+         + ctx.tree->strings_size > size)
+    return NULL;
+
+  ctx.nodes = (const flat_node_t *)(data + sizeof(*ctx.tree));
+  ctx.children = (const apr_uint32_t *)(ctx.nodes + ctx.tree->node_count);
+  ctx.strings = (const char *)(ctx.children + ctx.tree->child_count);
+  ctx.result_pool = result_pool;
+
+  return unflatten_node(&ctx, 0);
+}
+
+/* Return the lookup table entry for REPOSITORY and USER in SNAPSHOT or
+ * NULL, if there is no such entry. */
+static const snapshot_entry_t *
+find_snapshot_entry(const authz_snapshot_t *snapshot,
+                    const char *repository,
+                    const char *user)
+{
+  apr_uint32_t lower = 0;
+  apr_uint32_t upper = snapshot->entry_count;
+
+  while (lower < upper)
+    {
+      apr_uint32_t middle = lower + (upper - lower) / 2;
+      const snapshot_entry_t *entry = &snapshot->entries[middle];
+      int diff = strcmp(snapshot->data + entry->repository, repository);
+      if (diff == 0)
+        diff = strcmp(snapshot->data + entry->user, user);
+
+      if (diff == 0)
+        return entry;
+      else if (diff < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  return NULL;
+}
+
+/* Return the filtered path rule tree for USER and REPOSITORY from AUTHZ's
+ * snapshot, allocated in RESULT_POOL.  Return NULL if there is no snapshot
+ * or it does not cover this combination.
+ */
+static node_t *
+snapshot_user_authz(const authz_full_t *authz,
+                    const char *repository,
+                    const char *user,
+                    apr_pool_t *result_pool)
+{
+  const authz_snapshot_t *snapshot = authz->snapshot;
+  const snapshot_entry_t *entry;
+
+  if (!snapshot)
+    return NULL;
+
+  /* Map REPOSITORY and USER to the names under which the snapshot stores
+   * the equivalent rules. */
+  if (!svn_hash_gets(snapshot->named_repos, repository))
+    repository = AUTHZ_ANY_REPOSITORY;
+
+  if (!user)
+    user = AUTHZ_ANONYMOUS_USER;
+  else if (   strcmp(user, AUTHZ_ANONYMOUS_USER)
+           && !svn_hash_gets(authz->user_rights, user))
+    user = SNAPSHOT_OTHER_USER;
+
+  entry = find_snapshot_entry(snapshot, repository, user);
+  if (!entry)
+    return NULL;
+
+  return unflatten_tree(snapshot->data + entry->tree, entry->tree_size,
+                        result_pool);
+}
+
+/* Return TRUE if OFFSET in SNAPSHOT's data is the start of a
+ * NUL-terminated string. */
+static svn_boolean_t
+is_snapshot_string(const authz_snapshot_t *snapshot,
+                   apr_uint32_t offset)
+{
+  return offset < snapshot->size
+      && memchr(snapshot->data + offset, '\0', snapshot->size - offset);
+}
+
+/* Read the snapshot file at PATH into *SNAPSHOT_P, allocated in
+ * RESULT_POOL, if it matches the full model AUTHZ identified by AUTHZ_ID.
+ * Otherwise, set *SNAPSHOT_P to NULL.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+read_snapshot(authz_snapshot_t **snapshot_p,
+              const authz_full_t *authz,
+              const svn_membuf_t *authz_id,
+              const char *path,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  authz_snapshot_t *snapshot;
+  const snapshot_header_t *header;
+  apr_pool_t *pool;
+  apr_size_t entries_offset;
+  svn_node_kind_t kind;
+  apr_uint32_t i;
+  int k;
+
+  *snapshot_p = NULL;
+
+  SVN_ERR(svn_io_check_path(path, &kind, scratch_pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* Use a separate pool, so we can release the file contents again if
+   * they turn out to be unusable. */
+  pool = svn_pool_create(result_pool);
+  snapshot = apr_pcalloc(pool, sizeof(*snapshot));
+
+#if APR_HAS_MMAP
+  {
+    apr_file_t *file;
+    apr_finfo_t finfo;
+    apr_mmap_t *mmap;
+    apr_status_t status;
+
+    SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+    SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, scratch_pool));
+    if (finfo.size < (apr_off_t)sizeof(*header))
+      {
+        svn_pool_destroy(pool);
+        return SVN_NO_ERROR;
+      }
+
+    status = apr_mmap_create(&mmap, file, 0, (apr_size_t)finfo.size,
+                             APR_MMAP_READ, pool);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't map '%s'"),
+                                svn_dirent_local_style(path, scratch_pool));
+
+    /* The mapping remains valid after closing the file. */
+    SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+    snapshot->data = mmap->mm;
+    snapshot->size = mmap->size;
+  }
+#else
+  {
+    svn_stringbuf_t *contents;
+    SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+
+    snapshot->data = contents->data;
+    snapshot->size = contents->len;
+  }
+#endif
+
+  /* Is this a snapshot of the AUTHZ_ID model? */
+  header = (const snapshot_header_t *)snapshot->data;
+  entries_offset = sizeof(*header) + APR_ALIGN(authz_id->size, 4);
+  if (   snapshot->size < sizeof(*header)
+      || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic))
+      || header->format != SNAPSHOT_FORMAT
+      || header->byte_order != SNAPSHOT_BYTE_ORDER
+      || header->id_size != authz_id->size
+      || entries_offset
+         + (apr_uint64_t)header->entry_count * sizeof(snapshot_entry_t)
+         > snapshot->size
+      || memcmp(snapshot->data + sizeof(*header), authz_id->data,
+                authz_id->size))
+    {
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  snapshot->entries
+    = (const snapshot_entry_t *)(snapshot->data + entries_offset);
+  snapshot->entry_count = header->entry_count;
+
+  /* Make sure that lookups stay within the snapshot data. */
+  for (i = 0; i < snapshot->entry_count; ++i)
+    {
+      const snapshot_entry_t *entry = &snapshot->entries[i];
+      if (   !is_snapshot_string(snapshot, entry->repository)
+          || !is_snapshot_string(snapshot, entry->user)
+          || entry->tree % 4
+          || (apr_uint64_t)entry->tree + entry->tree_size > snapshot->size)
+        {
+          svn_pool_destroy(pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  snapshot->named_repos = svn_hash__make(pool);
+  for (k = 0; k < authz->acls->nelts; ++k)
+    {
+      const authz_acl_t *acl = &APR_ARRAY_IDX(authz->acls, k, authz_acl_t);
+      svn_hash_sets(snapshot->named_repos, acl->rule.repos, acl->rule.repos);
+    }
+
+  *snapshot_p = snapshot;
+  return SVN_NO_ERROR;
+}
+
+/* If PATH is a local authz file, attach the snapshot matching AUTHZ and
+ * AUTHZ_ID, if any, to AUTHZ.  Snapshots are merely an optimization, so
+ * any problem with them is silently ignored.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static void
+attach_snapshot(authz_full_t *authz,
+                const svn_membuf_t *authz_id,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  const char *snapshot_path;
+
+  if (svn_path_is_url(path))
+    return;
+
+  snapshot_path = apr_pstrcat(scratch_pool, path,
+                              SVN_REPOS__AUTHZ_SNAPSHOT_SUFFIX, SVN_VA_NULL);
+  svn_error_clear(read_snapshot(&authz->snapshot, authz, authz_id,
+                                snapshot_path, authz->pool, scratch_pool));
+}
+
+
 /*** Lookup. ***/
 
 /* Reusable lookup state object. It is easy to pass to functions and
@@ -1467,6 +2141,25 @@ get_user_rules(svn_authz_t *authz,
   return authz->filtered;
 }
 
+/* Return the filtered path rule tree for USER and REPOSITORY in AUTHZ,
+ * allocated in RESULT_POOL.  Take it from the snapshot, if possible.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static node_t *
+get_user_authz(authz_full_t *authz,
+               const char *repository,
+               const char *user,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  node_t *root = snapshot_user_authz(authz, repository, user, result_pool);
+  if (!root)
+    root = create_user_authz(authz, repository, user, result_pool,
+                             scratch_pool);
+
+  return root;
+}
+
 /* In AUTHZ's user rules, construct the actual filtered tree.
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -1508,8 +2201,8 @@ filter_tree(svn_authz_t *authz,
           SVN_ERR_ASSERT(add_ref == authz->full);
 
           /* Now construct the new filtered tree and cache it. */
-          root = create_user_authz(authz->full, repos_name, user, item_pool,
-                                   scratch_pool);
+          root = get_user_authz(authz->full, repos_name, user, item_pool,
+                                scratch_pool);
           svn_error_clear(svn_object_pool__insert((void **)&root,
                                                   filtered_pool, key, root,
                                                   item_pool, pool));
@@ -1517,8 +2210,8 @@ filter_tree(svn_authz_t *authz,
      }
   else
     {
-      root = create_user_authz(authz->full, repos_name, user, pool,
-                               scratch_pool);
+      root = get_user_authz(authz->full, repos_name, user, pool,
+                            scratch_pool);
     }
 
   /* Write a new entry. */
@@ -1601,6 +2294,7 @@ authz_read(authz_full_t **authz_p,
             }
           else
             {
+              attach_snapshot(*authz_p, *authz_id, path, scratch_pool);
               SVN_ERR(svn_object_pool__insert((void **)authz_p, authz_pool,
                                               *authz_id, *authz_p,
                                               item_pool, result_pool));
@@ -1616,6 +2310,8 @@ authz_read(authz_full_t **authz_p,
                                                    result_pool, scratch_pool),
                                   "Error while parsing authz file: '%s':",
                                   path);
+      if (!err)
+        attach_snapshot(*authz_p, *authz_id, path, scratch_pool);
     }
 
   svn_repos__destroy_config_access(config_access);
@@ -1665,6 +2361,24 @@ svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+svn_authz_t *
+svn_repos__authz_share(const svn_authz_t *authz,
+                       apr_pool_t *result_pool)
+{
+  svn_authz_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  result->full = authz->full;
+  result->authz_id = authz->authz_id;
+  result->pool = result_pool;
+
+  return result;
+}
+
+const svn_membuf_t *
+svn_repos__authz_id(const svn_authz_t *authz)
+{
+  return authz->authz_id;
+}
+
 svn_error_t *
 svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              const char *path, const char *user,
@@ -1727,3 +2441,231 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos__authz_write_snapshot(svn_authz_t *authz,
+                                const char *path,
+                                apr_pool_t *scratch_pool)
+{
+  const authz_full_t *full = authz->full;
+  apr_hash_t *repos_hash = svn_hash__make(scratch_pool);
+  apr_hash_t *user_hash = svn_hash__make(scratch_pool);
+  apr_hash_t *trees = svn_hash__make(scratch_pool);
+  apr_array_header_t *repositories, *users;
+  apr_uint32_t *repos_offsets, *user_offsets;
+  svn_stringbuf_t *names = svn_stringbuf_create_empty(scratch_pool);
+  svn_stringbuf_t *tree_data = svn_stringbuf_create_empty(scratch_pool);
+  svn_stringbuf_t *contents;
+  snapshot_entry_t *entries;
+  snapshot_header_t header;
+  apr_size_t entry_count, names_offset, trees_offset, i;
+  apr_pool_t *iterpool;
+  apr_hash_index_t *hi;
+  int r, u;
+
+  if (!authz->authz_id)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("Snapshots require an authz model that "
+                              "has been read from a file"));
+
+  /* All repositories with specific rules plus the catch-all. */
+  svn_hash_sets(repos_hash, AUTHZ_ANY_REPOSITORY, "");
+  for (r = 0; r < full->acls->nelts; ++r)
+    {
+      const authz_acl_t *acl = &APR_ARRAY_IDX(full->acls, r, authz_acl_t);
+      svn_hash_sets(repos_hash, acl->rule.repos, "");
+    }
+
+  /* All users mentioned in the model plus the anonymous and all other
+   * authenticated users. */
+  svn_hash_sets(user_hash, AUTHZ_ANONYMOUS_USER, "");
+  svn_hash_sets(user_hash, SNAPSHOT_OTHER_USER, "");
+  for (hi = apr_hash_first(scratch_pool, full->user_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    svn_hash_sets(user_hash, apr_hash_this_key(hi), "");
+
+  /* The lookup table must be sorted like strcmp() does. */
+  repositories = svn_sort__hash(repos_hash, svn_sort_compare_items_lexically,
+                                scratch_pool);
+  users = svn_sort__hash(user_hash, svn_sort_compare_items_lexically,
+                         scratch_pool);
+
+  /* Store each name only once. */
+  repos_offsets = apr_palloc(scratch_pool,
+                             repositories->nelts * sizeof(*repos_offsets));
+  for (r = 0; r < repositories->nelts; ++r)
+    {
+      const char *name = APR_ARRAY_IDX(repositories, r, svn_sort__item_t).key;
+      repos_offsets[r] = (apr_uint32_t)names->len;
+      svn_stringbuf_appendbytes(names, name, strlen(name) + 1);
+    }
+
+  user_offsets = apr_palloc(scratch_pool, users->nelts * sizeof(*user_offsets));
+  for (u = 0; u < users->nelts; ++u)
+    {
+      const char *name = APR_ARRAY_IDX(users, u, svn_sort__item_t).key;
+      user_offsets[u] = (apr_uint32_t)names->len;
+      svn_stringbuf_appendbytes(names, name, strlen(name) + 1);
+    }
+
+  pad_snapshot_buffer(names);
+
+  /* Filter the model for every combination.  Identical trees get stored
+   * only once. */
+  entry_count = (apr_size_t)repositories->nelts * users->nelts;
+  entries = apr_pcalloc(scratch_pool, entry_count * sizeof(*entries));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (r = 0; r < repositories->nelts; ++r)
+    for (u = 0; u < users->nelts; ++u)
+      {
+        const char *repository
+          = APR_ARRAY_IDX(repositories, r, svn_sort__item_t).key;
+        const char *user = APR_ARRAY_IDX(users, u, svn_sort__item_t).key;
+        snapshot_entry_t *entry = &entries[r * users->nelts + u];
+        const snapshot_entry_t *known;
+        svn_stringbuf_t *flat;
+        svn_checksum_t *checksum;
+        node_t *root;
+
+        svn_pool_clear(iterpool);
+
+        /* SNAPSHOT_OTHER_USER is not mentioned in any rule and therefore
+         * gets exactly the rules of all other authenticated users. */
+        root = create_user_authz(authz->full, repository, user, iterpool,
+                                 iterpool);
+        flat = svn_stringbuf_create_empty(iterpool);
+        flatten_tree(flat, root, iterpool);
+
+        SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, flat->data,
+                             flat->len, iterpool));
+        known = apr_hash_get(trees, checksum->digest,
+                             svn_checksum_size(checksum));
+        if (known)
+          {
+            entry->tree = known->tree;
+            entry->tree_size = known->tree_size;
+          }
+        else
+          {
+            entry->tree = (apr_uint32_t)tree_data->len;
+            entry->tree_size = (apr_uint32_t)flat->len;
+            svn_stringbuf_appendbytes(tree_data, flat->data, flat->len);
+            apr_hash_set(trees,
+                         apr_pmemdup(scratch_pool, checksum->digest,
+                                     svn_checksum_size(checksum)),
+                         svn_checksum_size(checksum), entry);
+          }
+
+        entry->repository = repos_offsets[r];
+        entry->user = user_offsets[u];
+      }
+
+  svn_pool_destroy(iterpool);
+
+  /* Turn all offsets into file offsets. */
+  names_offset = sizeof(header) + APR_ALIGN(authz->authz_id->size, 4)
+               + entry_count * sizeof(*entries);
+  trees_offset = names_offset + names->len;
+  if ((apr_uint64_t)trees_offset + tree_data->len > APR_UINT32_MAX)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Authz snapshot for '%s' would be too large"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  for (i = 0; i < entry_count; ++i)
+    {
+      entries[i].repository += (apr_uint32_t)names_offset;
+      entries[i].user += (apr_uint32_t)names_offset;
+      entries[i].tree += (apr_uint32_t)trees_offset;
+    }
+
+  /* Assemble and write the snapshot file. */
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.format = SNAPSHOT_FORMAT;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.id_size = (apr_uint32_t)authz->authz_id->size;
+  header.entry_count = (apr_uint32_t)entry_count;
+
+  contents = svn_stringbuf_create_ensure(trees_offset + tree_data->len,
+                                         scratch_pool);
+  svn_stringbuf_appendbytes(contents, (const char *)&header, sizeof(header));
+  svn_stringbuf_appendbytes(contents, authz->authz_id->data,
+                            authz->authz_id->size);
+  pad_snapshot_buffer(contents);
+  svn_stringbuf_appendbytes(contents, (const char *)entries,
+                            entry_count * sizeof(*entries));
+  svn_stringbuf_appendbytes(contents, names->data, names->len);
+  svn_stringbuf_appendbytes(contents, tree_data->data, tree_data->len);
+
+  return svn_error_trace(svn_io_write_atomic2(path, contents->data,
+                                              contents->len, NULL, TRUE,
+                                              scratch_pool));
+}
+
+svn_error_t *
+svn_repos_authz_check_access_many(svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  svn_boolean_t *access_granted,
+                                  apr_pool_t *pool)
+{
+  const authz_access_t required =
+    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  authz_user_rules_t *rules = get_user_rules(
+      authz,
+      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+      user);
+
+  /* Uniform access to the repository decides all paths at once. */
+  if (   (rules->global_rights.min_access & required) == required
+      || (rules->global_rights.max_access & required) != required)
+    {
+      const svn_boolean_t granted
+        = ((rules->global_rights.min_access & required) == required);
+      for (i = 0; i < paths->nelts; ++i)
+        access_granted[i] = granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Did we already filter the data model? */
+  if (!rules->root)
+    SVN_ERR(filter_tree(authz, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      /* Not looking for a specific path? */
+      if (!path)
+        {
+          access_granted[i] = TRUE;
+          continue;
+        }
+
+      svn_pool_clear(iterpool);
+
+      /* Continue from the previous lookup if that covered our parent. */
+      path = init_lockup_state(rules->lookup_state, rules->root, path);
+
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path[0] == '/');
+
+      access_granted[i] = lookup(rules->lookup_state, path, required,
+                                 recursive, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
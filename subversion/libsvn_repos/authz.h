@@ -125,6 +125,10 @@ typedef struct authz_global_rights_t
 } authz_global_rights_t;
 
 
+/* Pre-compiled path rule trees for all users, read from a snapshot file.
+   Opaque outside of authz.c. */
+typedef struct authz_snapshot_t authz_snapshot_t;
+
 /* Immutable authorization info */
 typedef struct authz_full_t
 {
@@ -144,6 +148,10 @@ typedef struct authz_full_t
      an authz_global_rights_t*. */
   apr_hash_t *user_rights;
 
+  /* Path rule trees compiled from this model, if a matching snapshot
+     file was found next to the authz file.  May be NULL. */
+  authz_snapshot_t *snapshot;
+
   /* The pool from which all the parsed authz data is allocated.
      This is the RESULT_POOL passed to svn_authz__tng_parse.
 
@@ -1200,6 +1200,20 @@ update_global_rights(authz_global_rights_t *gr,
 }
 
 
+/* Update the global rights GR of USER from ACL. */
+static void
+update_rights_of_user(authz_global_rights_t *gr,
+                      const authz_acl_t *acl,
+                      const char *user)
+{
+  authz_access_t access;
+  svn_boolean_t has_access =
+    svn_authz__get_acl_access(&access, acl, user, acl->rule.repos);
+
+  if (has_access)
+    update_global_rights(gr, acl->rule.repos, access);
+}
+
 /* Hash iterator to update global per-user rights from an ACL. */
 static svn_error_t *
 update_user_rights(void *baton,
@@ -1208,18 +1222,73 @@ update_user_rights(void *baton,
                    void *value,
                    apr_pool_t *scratch_pool)
 {
-  const authz_acl_t *const acl = baton;
-  const char *const user = key;
-  authz_global_rights_t *const gr = value;
-  authz_access_t access;
-  svn_boolean_t has_access =
-    svn_authz__get_acl_access(&access, acl, user, acl->rule.repos);
-
-  if (has_access)
-    update_global_rights(gr, acl->rule.repos, access);
+  update_rights_of_user(value, baton, key);
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE, if only users explicitly listed in the ACEs of ACL,
+   either by name or as group members, may get any access from it. */
+static svn_boolean_t
+acl_is_selective(const authz_acl_t *acl)
+{
+  int i;
+
+  if (acl->has_anon_access || acl->has_authn_access)
+    return FALSE;
+
+  for (i = 0; i < acl->user_access->nelts; ++i)
+    if (APR_ARRAY_IDX(acl->user_access, i, authz_ace_t).inverted)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Update the global per-user rights in CB for all users that are listed
+   in the ACEs of ACL.  Only valid if acl_is_selective() returns TRUE.
+
+   This is equivalent to calling update_user_rights() for all users but
+   takes time proportional to the size of the ACL instead of the number
+   of users defined in the whole authz file.  Users may be visited more
+   than once, which is fine because merging the same rights is
+   idempotent. */
+static void
+update_listed_user_rights(ctor_baton_t *cb,
+                          const authz_acl_t *acl,
+                          apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < acl->user_access->nelts; ++i)
+    {
+      const authz_ace_t *const ace =
+        &APR_ARRAY_IDX(acl->user_access, i, authz_ace_t);
+
+      if (ace->members)
+        {
+          apr_hash_index_t *hi;
+          for (hi = apr_hash_first(scratch_pool, ace->members);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              const char *const user = apr_hash_this_key(hi);
+              authz_global_rights_t *const gr
+                = svn_hash_gets(cb->authz->user_rights, user);
+
+              if (gr)
+                update_rights_of_user(gr, acl, user);
+            }
+        }
+      else
+        {
+          authz_global_rights_t *const gr
+            = svn_hash_gets(cb->authz->user_rights, ace->name);
+
+          if (gr)
+            update_rights_of_user(gr, acl, ace->name);
+        }
+    }
+}
+
 
 /* List iterator, expands/merges a parsed ACL into its final form and
    appends it to the authz info's ACL array. */
@@ -1270,8 +1339,14 @@ expand_acl_callback(void *baton,
       update_global_rights(&cb->authz->authn_rights,
                            acl->rule.repos, acl->authn_access);
     }
-  SVN_ERR(svn_iter_apr_hash(NULL, cb->authz->user_rights,
-                            update_user_rights, acl, scratch_pool));
+
+  /* Large authz files tend to have many users and many ACLs that grant
+     access to just a few of them.  Don't scan all users in that case. */
+  if (acl_is_selective(acl))
+    update_listed_user_rights(cb, acl, scratch_pool);
+  else
+    SVN_ERR(svn_iter_apr_hash(NULL, cb->authz->user_rights,
+                              update_user_rights, acl, scratch_pool));
   return SVN_NO_ERROR;
 }
 
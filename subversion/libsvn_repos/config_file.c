@@ -25,9 +25,12 @@
 
 
 #include "svn_checksum.h"
+#include "svn_hash.h"
 #include "svn_path.h"
 #include "svn_pools.h"
 
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_config_private.h"
@@ -267,9 +270,161 @@ get_repos_config(svn_stream_t **stream,
   return SVN_NO_ERROR;
 }
 
+/* Config files on disk that we have read before.
+ *
+ * Long-running servers read the same config and authz files over and
+ * over again, only to find their checksums unchanged and the parsed
+ * objects already in the object pool.  To avoid that, remember the
+ * content checksum together with the file's stat() data.  As long as the
+ * latter does not change, the checksum is still valid and the file
+ * contents only need to be read if the caller actually parses them.
+ */
+typedef struct file_info_t
+{
+  /* The stat() data of the file when we read it. */
+  apr_off_t size;
+  apr_time_t mtime;
+  apr_time_t ctime;
+
+  /* MD5 checksum of the file contents. */
+  svn_checksum_t *checksum;
+} file_info_t;
+
+/* Modifications of a file within this time after its last modification
+ * may not change its timestamp due to limited timestamp resolution. */
+#define FILE_TIMESTAMP_SLACK apr_time_from_sec(2)
+
+/* Maps const char * paths to file_info_t *.  Both are allocated in
+ * FILE_INFO_POOL and access is serialized by FILE_INFO_MUTEX. */
+static apr_hash_t *file_infos = NULL;
+static apr_pool_t *file_info_pool = NULL;
+static svn_mutex__t *file_info_mutex = NULL;
+static volatile svn_atomic_t file_infos_initialized = FALSE;
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_file_infos(void *baton, apr_pool_t *pool)
+{
+  file_info_pool = svn_pool_create(NULL);
+  file_infos = apr_hash_make(file_info_pool);
+  SVN_ERR(svn_mutex__init(&file_info_mutex, TRUE, file_info_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHECKSUM to the remembered content checksum of the file at PATH,
+ * allocated in RESULT_POOL, if its stat() data still matches FINFO.
+ * Set it to NULL otherwise.  NOW is the current time.
+ *
+ * Must be called with FILE_INFO_MUTEX held.
+ */
+static svn_error_t *
+lookup_file_info(svn_checksum_t **checksum,
+                 const char *path,
+                 const apr_finfo_t *finfo,
+                 apr_time_t now,
+                 apr_pool_t *result_pool)
+{
+  file_info_t *info = svn_hash_gets(file_infos, path);
+
+  /* Don't trust timestamps of files that have just been modified. */
+  if (   info
+      && info->size == finfo->size
+      && info->mtime == finfo->mtime
+      && info->ctime == finfo->ctime
+      && now - finfo->mtime > FILE_TIMESTAMP_SLACK)
+    *checksum = svn_checksum_dup(info->checksum, result_pool);
+  else
+    *checksum = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember that the file at PATH with stat() data FINFO has contents
+ * with the given MD5 CHECKSUM.  If CHECKSUM is NULL, forget about PATH.
+ *
+ * Must be called with FILE_INFO_MUTEX held.
+ */
+static svn_error_t *
+store_file_info(const char *path,
+                const apr_finfo_t *finfo,
+                const svn_checksum_t *checksum)
+{
+  file_info_t *info = svn_hash_gets(file_infos, path);
+
+  if (!checksum)
+    {
+      /* The entries are small, so we don't bother reclaiming them. */
+      if (info)
+        info->size = -1;
+
+      return SVN_NO_ERROR;
+    }
+
+  if (!info)
+    {
+      info = apr_pcalloc(file_info_pool, sizeof(*info));
+      info->checksum = svn_checksum_create(svn_checksum_md5, file_info_pool);
+      svn_hash_sets(file_infos, apr_pstrdup(file_info_pool, path), info);
+    }
+
+  info->size = finfo->size;
+  info->mtime = finfo->mtime;
+  info->ctime = finfo->ctime;
+  memcpy((unsigned char *)info->checksum->digest, checksum->digest,
+         svn_checksum_size(checksum));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for open_unchanged_file(). */
+typedef struct unchanged_file_baton_t
+{
+  /* The file to read and its expected contents checksum. */
+  const char *path;
+  const svn_checksum_t *checksum;
+} unchanged_file_baton_t;
+
+/* Implements svn_stream_lazyopen_func_t.  Read the whole file described
+ * by the unchanged_file_baton_t BATON into memory and verify that its
+ * contents have not changed since we got its checksum. */
+static svn_error_t *
+open_unchanged_file(svn_stream_t **stream,
+                    void *baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  unchanged_file_baton_t *b = baton;
+  svn_stringbuf_t *contents;
+  svn_checksum_t *actual;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, b->path, result_pool));
+  SVN_ERR(svn_checksum(&actual, svn_checksum_md5,
+                       contents->data, contents->len, scratch_pool));
+
+  /* The file has been modified after we checked it.  Since our caller
+   * already uses the old checksum, all we can do is to error out. */
+  if (!svn_checksum_match(b->checksum, actual))
+    {
+      SVN_MUTEX__WITH_LOCK(file_info_mutex,
+                           store_file_info(b->path, NULL, NULL));
+      return svn_error_trace(svn_checksum_mismatch_err(
+                               b->checksum, actual, scratch_pool,
+                               _("Config file '%s' changed while being read"),
+                               svn_dirent_local_style(b->path,
+                                                      scratch_pool)));
+    }
+
+  *stream = svn_stream_from_stringbuf(contents, result_pool);
+  return SVN_NO_ERROR;
+}
+
 /* Open the file at PATH, return its content checksum in CHECKSUM and the
  * content itself through *STREAM.  Allocate those with the lifetime of
  * ACCESS.
+ *
+ * If the file has not changed since we last read it, *STREAM will only
+ * read the file once it gets accessed.
  */
 static svn_error_t *
 get_file_config(svn_stream_t **stream,
@@ -281,13 +436,51 @@ get_file_config(svn_stream_t **stream,
 {
   svn_stringbuf_t *contents;
   svn_node_kind_t node_kind;
+  apr_finfo_t finfo;
+  apr_time_t now;
+  svn_error_t *err;
+
+  SVN_ERR(svn_atomic__init_once(&file_infos_initialized, init_file_infos,
+                                NULL, scratch_pool));
 
   /* Special case: non-existent paths may be handled as "empty" contents. */
-  SVN_ERR(svn_io_check_path(path, &node_kind, scratch_pool));
+  err = svn_io_stat(&finfo, path, APR_FINFO_MIN, scratch_pool);
+  if (err && (   APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      node_kind = svn_node_none;
+    }
+  else
+    {
+      SVN_ERR(err);
+      node_kind = finfo.filetype == APR_REG ? svn_node_file
+                : finfo.filetype == APR_DIR ? svn_node_dir
+                : svn_node_unknown;
+    }
+
   if (node_kind != svn_node_file)
     return svn_error_trace(handle_missing_file(stream, checksum, access,
                                                path, must_exist, node_kind));
 
+  /* Unchanged file?  Then, the caller will most likely not need to read
+   * the contents at all. */
+  now = apr_time_now();
+  SVN_MUTEX__WITH_LOCK(file_info_mutex,
+                       lookup_file_info(checksum, path, &finfo, now,
+                                        access->pool));
+  if (*checksum)
+    {
+      unchanged_file_baton_t *baton = apr_palloc(access->pool,
+                                                 sizeof(*baton));
+      baton->path = apr_pstrdup(access->pool, path);
+      baton->checksum = *checksum;
+
+      *stream = svn_stream_lazyopen_create(open_unchanged_file, baton,
+                                           FALSE, access->pool);
+      return SVN_NO_ERROR;
+    }
+
   /* Now, we should be able to read the file. */
   SVN_ERR(svn_stringbuf_from_file2(&contents, path, access->pool));
 
@@ -296,6 +489,11 @@ get_file_config(svn_stream_t **stream,
                        contents->data, contents->len, access->pool));
   *stream = svn_stream_from_stringbuf(contents, access->pool);
 
+  /* If the file got modified while we were reading it, the stat() data
+   * will be different next time and we won't use this checksum. */
+  SVN_MUTEX__WITH_LOCK(file_info_mutex,
+                       store_file_info(path, &finfo, *checksum));
+
   return SVN_NO_ERROR;
 }
 
@@ -0,0 +1,417 @@
+/* date-index.c : mapping revision numbers to their svn:date
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_file_io.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_props.h"
+#include "svn_time.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+/* svn_repos_dated_revision() does a binary search over the svn:date
+ * revprops.  With packed revprops, every probe may have to read and
+ * parse a whole pack file.  The date index is a flat file in the db
+ * directory that simply lists the svn:date of every revision:
+ *
+ *   DATE_INDEX_MAGIC (8 bytes)
+ *   date of r0, r1, ... as big-endian 64 bit apr_time_t values
+ *
+ * New records are appended after each commit.  Changes to svn:date
+ * overwrite the respective record.  A trailing partial record, e.g.
+ * from an interrupted update, is being ignored and overwritten.
+ *
+ * The index is strictly optional: if it is missing or can't be updated,
+ * we simply fall back to reading the revprops.  Writers serialize using
+ * an exclusive lock on the index file itself.
+ */
+#define DATE_INDEX_MAGIC "SVNDATE1"
+#define HEADER_SIZE (sizeof(DATE_INDEX_MAGIC) - 1)
+#define RECORD_SIZE 8
+
+/* Number of records to collect before appending them to the index. */
+#define APPEND_BATCH 1024
+
+struct svn_repos__date_index_t
+{
+  /* The open index file. */
+  apr_file_t *file;
+
+  /* Number of revisions covered, starting at r0. */
+  svn_revnum_t count;
+};
+
+/* Return the path of the date index of REPOS, allocated in POOL. */
+static const char *
+index_path(svn_repos_t *repos,
+           apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_repos_db_env(repos, pool),
+                         SVN_REPOS__DATE_INDEX, pool);
+}
+
+/* Write TM to the RECORD_SIZE bytes at BUFFER. */
+static void
+encode_time(unsigned char *buffer,
+            apr_time_t tm)
+{
+  apr_uint64_t value = (apr_uint64_t)tm;
+  int i;
+
+  for (i = RECORD_SIZE - 1; i >= 0; --i)
+    {
+      buffer[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+    }
+}
+
+/* Return the time stored in the RECORD_SIZE bytes at BUFFER. */
+static apr_time_t
+decode_time(const unsigned char *buffer)
+{
+  apr_uint64_t value = 0;
+  int i;
+
+  for (i = 0; i < RECORD_SIZE; ++i)
+    value = (value << 8) | buffer[i];
+
+  return (apr_time_t)value;
+}
+
+/* Set *COUNT to the number of complete records in the index FILE.  Set
+   it to -1 if FILE does not start with a valid header. */
+static svn_error_t *
+get_record_count(svn_revnum_t *count,
+                 apr_file_t *file,
+                 apr_pool_t *scratch_pool)
+{
+  char header[HEADER_SIZE];
+  svn_filesize_t size;
+  apr_off_t offset = 0;
+  apr_size_t bytes_read;
+
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  if (size < HEADER_SIZE)
+    {
+      *count = -1;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, header, HEADER_SIZE, &bytes_read,
+                                 NULL, scratch_pool));
+  if (memcmp(header, DATE_INDEX_MAGIC, HEADER_SIZE))
+    *count = -1;
+  else
+    *count = (svn_revnum_t)((size - HEADER_SIZE) / RECORD_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the records in BUFFER to FILE, which covers COUNT revisions.
+   Clear BUFFER afterwards. */
+static svn_error_t *
+append_records(apr_file_t *file,
+               svn_revnum_t count,
+               svn_stringbuf_t *buffer,
+               apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = HEADER_SIZE + (apr_off_t)count * RECORD_SIZE;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, buffer->data, buffer->len, NULL,
+                                 scratch_pool));
+  svn_stringbuf_setempty(buffer);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos__date_index_update() for the locked index FILE. */
+static svn_error_t *
+update_index(apr_file_t *file,
+             svn_repos_t *repos,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  svn_revnum_t youngest, count, rev;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+  SVN_ERR(get_record_count(&count, file, scratch_pool));
+
+  /* Start from scratch if this is not a valid index file. */
+  if (count < 0)
+    {
+      SVN_ERR(svn_io_file_trunc(file, 0, scratch_pool));
+      SVN_ERR(svn_io_file_write_full(file, DATE_INDEX_MAGIC, HEADER_SIZE,
+                                     NULL, scratch_pool));
+      count = 0;
+    }
+
+  /* The repository may have been replaced by one with fewer revisions.
+     Also, get rid of incomplete records. */
+  if (count > youngest + 1)
+    count = youngest + 1;
+  SVN_ERR(svn_io_file_trunc(file,
+                            HEADER_SIZE + (apr_off_t)count * RECORD_SIZE,
+                            scratch_pool));
+  if (count > youngest)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_refresh_revision_props(repos->fs, scratch_pool));
+  for (rev = count; rev <= youngest; ++rev)
+    {
+      svn_string_t *date;
+      apr_time_t tm;
+      unsigned char record[RECORD_SIZE];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* We can't index revisions without a valid date.  Stop there;
+         lookups fall back to the revprops for later revisions. */
+      SVN_ERR(svn_fs_revision_prop2(&date, repos->fs, rev,
+                                    SVN_PROP_REVISION_DATE, FALSE,
+                                    iterpool, iterpool));
+      if (!date)
+        break;
+
+      err = svn_time_from_cstring(&tm, date->data, iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      encode_time(record, tm);
+      svn_stringbuf_appendbytes(buffer, (const char *)record, RECORD_SIZE);
+      if (buffer->len >= APPEND_BATCH * RECORD_SIZE)
+        {
+          SVN_ERR(append_records(file, rev + 1 - APPEND_BATCH, buffer,
+                                 iterpool));
+        }
+    }
+
+  if (buffer->len)
+    SVN_ERR(append_records(file, rev - buffer->len / RECORD_SIZE, buffer,
+                           iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the date index of REPOS in *FILE for reading and writing and lock
+   it exclusively.  Create it if CREATE is set.  If it does not exist,
+   set *FILE to NULL.  Allocate *FILE in POOL, closing it releases the
+   lock. */
+static svn_error_t *
+open_locked(apr_file_t **file,
+            svn_repos_t *repos,
+            svn_boolean_t create,
+            apr_pool_t *pool)
+{
+  apr_int32_t flags = APR_READ | APR_WRITE;
+  svn_error_t *err;
+
+  if (create)
+    flags |= APR_CREATE;
+
+  err = svn_io_file_open(file, index_path(repos, pool), flags,
+                         APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  return svn_error_trace(svn_io_lock_open_file(*file, TRUE, FALSE, pool));
+}
+
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  SVN_ERR(open_locked(&file, repos, create, scratch_pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  err = update_index(file, repos, scratch_pool);
+
+  return svn_error_compose_create(err, svn_io_file_close(file,
+                                                         scratch_pool));
+}
+
+svn_error_t *
+svn_repos__date_index_set(svn_repos_t *repos,
+                          svn_revnum_t rev,
+                          const svn_string_t *date,
+                          apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count;
+  apr_time_t tm;
+  svn_error_t *err;
+
+  SVN_ERR(open_locked(&file, repos, FALSE, scratch_pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  err = get_record_count(&count, file, scratch_pool);
+  if (!err && rev < count)
+    {
+      apr_off_t offset = HEADER_SIZE + (apr_off_t)rev * RECORD_SIZE;
+      svn_boolean_t valid = FALSE;
+
+      if (date)
+        {
+          svn_error_t *time_err = svn_time_from_cstring(&tm, date->data,
+                                                        scratch_pool);
+          valid = !time_err;
+          svn_error_clear(time_err);
+        }
+
+      /* Without a valid date, REV and everything after it can't be
+         indexed anymore. */
+      if (valid)
+        {
+          unsigned char record[RECORD_SIZE];
+
+          encode_time(record, tm);
+          err = svn_io_file_seek(file, APR_SET, &offset, scratch_pool);
+          if (!err)
+            err = svn_io_file_write_full(file, record, RECORD_SIZE, NULL,
+                                         scratch_pool);
+        }
+      else
+        {
+          err = svn_io_file_trunc(file, offset, scratch_pool);
+        }
+    }
+
+  return svn_error_compose_create(err, svn_io_file_close(file,
+                                                         scratch_pool));
+}
+
+svn_error_t *
+svn_repos__date_index_remove(svn_repos_t *repos,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_io_remove_file2(index_path(repos, scratch_pool),
+                                             TRUE, scratch_pool));
+}
+
+/* Open the date index of REPOS for reading and fill in INDEX.  Allocate
+   the file handle in RESULT_POOL. */
+static svn_error_t *
+open_for_reading(svn_repos__date_index_t *index,
+                 svn_repos_t *repos,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_io_file_open(&index->file, index_path(repos, scratch_pool),
+                           APR_READ, APR_OS_DEFAULT, result_pool));
+  SVN_ERR(get_record_count(&index->count, index->file, scratch_pool));
+  if (index->count < 0)
+    index->count = 0;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_open(svn_repos__date_index_t **index,
+                           svn_repos_t *repos,
+                           svn_revnum_t youngest,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_repos__date_index_t *result = apr_pcalloc(result_pool,
+                                                sizeof(*result));
+  svn_boolean_t outdated = TRUE;
+  svn_error_t *err;
+
+  *index = NULL;
+
+  err = open_for_reading(result, repos, result_pool, scratch_pool);
+  if (!err)
+    {
+      outdated = result->count <= youngest;
+      if (outdated)
+        err = svn_io_file_close(result->file, scratch_pool);
+    }
+
+  /* Catch up with commits that did not update the index, e.g. from
+     'svnadmin load'.  If we can't, a partial index is still useful. */
+  if (outdated)
+    {
+      svn_error_clear(err);
+      svn_error_clear(svn_repos__date_index_update(repos, TRUE,
+                                                   scratch_pool));
+      err = open_for_reading(result, repos, result_pool, scratch_pool);
+    }
+
+  /* The index is optional. */
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (result->count > 0)
+    *index = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_get(svn_boolean_t *found,
+                          apr_time_t *tm,
+                          svn_repos__date_index_t *index,
+                          svn_revnum_t rev,
+                          apr_pool_t *scratch_pool)
+{
+  unsigned char record[RECORD_SIZE];
+  apr_off_t offset = HEADER_SIZE + (apr_off_t)rev * RECORD_SIZE;
+
+  *found = index && rev >= 0 && rev < index->count;
+  if (!*found)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_seek(index->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(index->file, record, RECORD_SIZE, NULL,
+                                 NULL, scratch_pool));
+  *tm = decode_time(record);
+
+  return SVN_NO_ERROR;
+}
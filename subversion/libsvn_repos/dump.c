@@ -44,6 +44,9 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_task.h"
+
+#include "repos.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1967,6 +1970,207 @@ write_revision_record(svn_stream_t *stream,
 
 
 
+/* Make sure that *START_REV and *END_REV describe a valid revision range
+   in FS, defaulting to all revisions.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+check_dump_range(svn_revnum_t *start_rev,
+                 svn_revnum_t *end_rev,
+                 svn_fs_t *fs,
+                 apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest;
+
+  /* Determine the current youngest revision of the filesystem. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, scratch_pool));
+
+  /* Use default vals if necessary. */
+  if (! SVN_IS_VALID_REVNUM(*start_rev))
+    *start_rev = 0;
+  if (! SVN_IS_VALID_REVNUM(*end_rev))
+    *end_rev = youngest;
+
+  /* Validate the revisions. */
+  if (*start_rev > *end_rev)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Start revision %ld"
+                               " is greater than end revision %ld"),
+                             *start_rev, *end_rev);
+  if (*end_rev > youngest)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("End revision %ld is invalid "
+                               "(youngest revision is %ld)"),
+                             *end_rev, youngest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the "general" metadata of a dump of FS to STREAM.  USE_DELTAS
+   selects the dumpfile format version.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+write_dump_header(svn_stream_t *stream,
+                  svn_fs_t *fs,
+                  svn_boolean_t use_deltas,
+                  apr_pool_t *scratch_pool)
+{
+  const char *uuid;
+  int version;
+
+  /* Write out the UUID. */
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+
+  /* If we're not using deltas, use the previous version, for
+     compatibility with svn 1.0.x. */
+  version = SVN_REPOS_DUMPFILE_FORMAT_VERSION;
+  if (!use_deltas)
+    version--;
+
+  /* Write out "general" metadata for the dumpfile.  In this case, a
+     magic header followed by a dumpfile format version. */
+  SVN_ERR(svn_stream_printf(stream, scratch_pool,
+                            SVN_REPOS_DUMPFILE_MAGIC_HEADER ": %d\n\n",
+                            version));
+  SVN_ERR(svn_stream_printf(stream, scratch_pool, SVN_REPOS_DUMPFILE_UUID
+                            ": %s\n\n", uuid));
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump revision REV of FS to STREAM, as part of a dump starting at
+   START_REV.  INCREMENTAL, USE_DELTAS, INCLUDE_REVPROPS, INCLUDE_CHANGES,
+   NOTIFY_FUNC and NOTIFY_BATON are as in svn_repos_dump_fs4(), except
+   that the final notification for REV is left to the caller.  Set
+   *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO if we issued the
+   respective warnings but never reset them.  Use SCRATCH_POOL for
+   temporary allocations.
+
+   The output depends on START_REV only for the first revision of a
+   non-incremental dump.  Hence, dumps of adjacent revision ranges may
+   simply be concatenated. */
+static svn_error_t *
+dump_one_revision(svn_stream_t *stream,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_revnum_t start_rev,
+                  svn_boolean_t incremental,
+                  svn_boolean_t use_deltas,
+                  svn_boolean_t include_revprops,
+                  svn_boolean_t include_changes,
+                  svn_boolean_t *found_old_reference,
+                  svn_boolean_t *found_old_mergeinfo,
+                  svn_repos_notify_func_t notify_func,
+                  void *notify_baton,
+                  apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
+                                scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   NULL,
+                                   NULL,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                NULL, NULL, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the final notifications of a dump to NOTIFY_FUNC with NOTIFY_BATON,
+   if not NULL.  FOUND_OLD_REFERENCE and FOUND_OLD_MERGEINFO are as set
+   by dump_one_revision().  Use SCRATCH_POOL for temporary allocations. */
+static void
+notify_dump_end(svn_boolean_t found_old_reference,
+                svn_boolean_t found_old_mergeinfo,
+                svn_repos_notify_func_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_repos_notify_t *notify;
+
+  if (! notify_func)
+    return;
+
+  /* Did we issue any warnings about references to revisions older than
+     the oldest dumped revision?  If so, then issue a final generic
+     warning, since the inline warnings already issued might easily be
+     missed. */
+
+  notify = svn_repos_notify_create(svn_repos_notify_dump_end, scratch_pool);
+  notify_func(notify_baton, notify, scratch_pool);
+
+  if (found_old_reference)
+    {
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_reference,
+                     _("The range of revisions dumped "
+                       "contained references to "
+                       "copy sources outside that "
+                       "range."));
+    }
+
+  /* Ditto if we issued any warnings about old revisions referenced
+     in dumped mergeinfo. */
+  if (found_old_mergeinfo)
+    {
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_mergeinfo,
+                     _("The range of revisions dumped "
+                       "contained mergeinfo "
+                       "which reference revisions outside "
+                       "that range."));
+    }
+}
+
 /* The main dumper. */
 svn_error_t *
 svn_repos_dump_fs4(svn_repos_t *repos,
@@ -1983,14 +2187,9 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
-  svn_revnum_t youngest;
-  const char *uuid;
-  int version;
   svn_boolean_t found_old_reference = FALSE;
   svn_boolean_t found_old_mergeinfo = FALSE;
   svn_repos_notify_t *notify;
@@ -1999,45 +2198,11 @@ svn_repos_dump_fs4(svn_repos_t *repos,
    * time we will refresh the revprop data in this query. */
   SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
 
-  /* Determine the current youngest revision of the filesystem. */
-  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
-
-  /* Use default vals if necessary. */
-  if (! SVN_IS_VALID_REVNUM(start_rev))
-    start_rev = 0;
-  if (! SVN_IS_VALID_REVNUM(end_rev))
-    end_rev = youngest;
+  SVN_ERR(check_dump_range(&start_rev, &end_rev, fs, pool));
   if (! stream)
     stream = svn_stream_empty(pool);
 
-  /* Validate the revisions. */
-  if (start_rev > end_rev)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("Start revision %ld"
-                               " is greater than end revision %ld"),
-                             start_rev, end_rev);
-  if (end_rev > youngest)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("End revision %ld is invalid "
-                               "(youngest revision is %ld)"),
-                             end_rev, youngest);
-
-  /* Write out the UUID. */
-  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
-
-  /* If we're not using deltas, use the previous version, for
-     compatibility with svn 1.0.x. */
-  version = SVN_REPOS_DUMPFILE_FORMAT_VERSION;
-  if (!use_deltas)
-    version--;
-
-  /* Write out "general" metadata for the dumpfile.  In this case, a
-     magic header followed by a dumpfile format version. */
-  SVN_ERR(svn_stream_printf(stream, pool,
-                            SVN_REPOS_DUMPFILE_MAGIC_HEADER ": %d\n\n",
-                            version));
-  SVN_ERR(svn_stream_printf(stream, pool, SVN_REPOS_DUMPFILE_UUID
-                            ": %s\n\n", uuid));
+  SVN_ERR(write_dump_header(stream, fs, use_deltas, pool));
 
   /* Create a notify object that we can reuse in the loop. */
   if (notify_func)
@@ -2047,71 +2212,18 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   /* Main loop:  we're going to dump revision REV.  */
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
-                                    iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    NULL, NULL, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+      SVN_ERR(dump_one_revision(stream, fs, rev, start_rev, incremental,
+                                use_deltas, include_revprops,
+                                include_changes, &found_old_reference,
+                                &found_old_mergeinfo, notify_func,
+                                notify_baton, iterpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -2119,38 +2231,8 @@ svn_repos_dump_fs4(svn_repos_t *repos,
         }
     }
 
-  if (notify_func)
-    {
-      /* Did we issue any warnings about references to revisions older than
-         the oldest dumped revision?  If so, then issue a final generic
-         warning, since the inline warnings already issued might easily be
-         missed. */
-
-      notify = svn_repos_notify_create(svn_repos_notify_dump_end, iterpool);
-      notify_func(notify_baton, notify, iterpool);
-
-      if (found_old_reference)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_reference,
-                         _("The range of revisions dumped "
-                           "contained references to "
-                           "copy sources outside that "
-                           "range."));
-        }
-
-      /* Ditto if we issued any warnings about old revisions referenced
-         in dumped mergeinfo. */
-      if (found_old_mergeinfo)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_mergeinfo,
-                         _("The range of revisions dumped "
-                           "contained mergeinfo "
-                           "which reference revisions outside "
-                           "that range."));
-        }
-    }
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, iterpool);
 
   svn_pool_destroy(iterpool);
 
@@ -2391,12 +2473,501 @@ report_error(svn_revnum_t revision,
     }
 }
 
+/* Result of a verify_rev_task_t, i.e. of verifying a single revision
+   or of dumping a range of revisions. */
+typedef struct verify_rev_result_t
+{
+  /* The task that produced this result. */
+  const struct verify_rev_task_t *task;
+
+  /* The task's result pool.  Everything below is allocated in it. */
+  apr_pool_t *pool;
+
+  /* Error returned by verify_one_revision() or dump_rev_range(), unless
+     it was a cancellation. */
+  svn_error_t *err;
+
+  /* Dumps only: The temporary file receiving the dump data and the
+     flags reported by dump_one_revision(). */
+  apr_file_t *dump_file;
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+
+  /* Notifications and FS warnings (svn_repos_notify_t * and
+     svn_error_t *, respectively) issued while processing the task.  They
+     will be forwarded by the main thread, in revision order. */
+  apr_array_header_t *notifications;
+  apr_array_header_t *warnings;
+} verify_rev_result_t;
+
+/* State shared by the tasks of a parallel verification or dump. */
+typedef struct parallel_verify_baton_t
+{
+  /* Instances of the repository for the tasks.  They must not use the
+     caller's svn_fs_t as the FS API objects are not thread-safe. */
+  svn_repos__fs_pool_t *fs_pool;
+
+  /* Parameters to pass to verify_one_revision(). */
+  svn_boolean_t notify;
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+
+  /* If set, the tasks dump revision ranges instead of verifying them.
+     START_REV is the start of the whole dump and the other parameters
+     are passed to dump_one_revision(). */
+  svn_boolean_t dump;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+} parallel_verify_baton_t;
+
+/* A revision to verify.  When dumping in parallel, this is a range of
+   revisions to dump instead. */
+typedef struct verify_rev_task_t
+{
+  parallel_verify_baton_t *pvb;
+
+  /* The revision to verify.  For dumps, the revisions REV to END_REV. */
+  svn_revnum_t rev;
+  svn_revnum_t end_rev;
+} verify_rev_task_t;
+
+/* The caller's callbacks that the results of the tasks get forwarded to
+   from the main thread. */
+typedef struct verify_output_baton_t
+{
+  /* The caller's filesystem that receives the buffered warnings. */
+  svn_fs_t *fs;
+
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+
+  /* Verification only: pre-allocated notification structure for
+     NOTIFY_FUNC and the callback to report failures to. */
+  svn_repos_notify_t *notify;
+  svn_repos_verify_callback_t verify_callback;
+  void *verify_baton;
+
+  /* Dumps only: where to send the dump data and the accumulated warning
+     flags of all ranges. */
+  svn_repos__dump_stream_func_t stream_func;
+  void *stream_baton;
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} verify_output_baton_t;
+
+/* Implements svn_repos_notify_func_t for the tasks.  Record a copy of
+   NOTIFY in the verify_rev_result_t BATON. */
+static void
+buffer_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  verify_rev_result_t *result = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(result->pool, notify,
+                                         sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(result->pool, notify->warning_str);
+  copy->path = apr_pstrdup(result->pool, notify->path);
+  APR_ARRAY_PUSH(result->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_fs_warning_callback_t for the task filesystems.
+   Record a copy of ERR in the verify_rev_result_t BATON of the task
+   currently using the filesystem.  BATON is NULL while the filesystem
+   is idle. */
+static void
+buffer_fs_warning(void *baton,
+                  svn_error_t *err)
+{
+  verify_rev_result_t *result = baton;
+
+  if (result)
+    APR_ARRAY_PUSH(result->warnings, svn_error_t *) = svn_error_dup(err);
+}
+
+/* Pool cleanup function clearing the warnings of the verify_rev_result_t
+   in DATA that have not been forwarded. */
+static apr_status_t
+cleanup_warnings(void *data)
+{
+  verify_rev_result_t *result = data;
+  int i;
+
+  for (i = 0; i < result->warnings->nelts; ++i)
+    svn_error_clear(APR_ARRAY_IDX(result->warnings, i, svn_error_t *));
+  apr_array_clear(result->warnings);
+
+  return APR_SUCCESS;
+}
+
+/* Dump the range of revisions given by TASK into the DUMP_FILE of RESULT,
+   using FS.  Buffer notifications like verify_rev_task() does, including
+   the per-revision end notifications.  Use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+dump_rev_range(verify_rev_result_t *result,
+               const verify_rev_task_t *task,
+               svn_fs_t *fs,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  parallel_verify_baton_t *pvb = task->pvb;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stream_t *stream;
+  svn_repos_notify_t *notify
+    = svn_repos_notify_create(svn_repos_notify_dump_rev_end, scratch_pool);
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_io_open_unique_file3(&result->dump_file, NULL, NULL,
+                                   svn_io_file_del_on_close,
+                                   result->pool, scratch_pool));
+  stream = svn_stream_from_aprfile2(result->dump_file, TRUE, scratch_pool);
+
+  /* Only the first range gets the dumpfile header such that all ranges
+     concatenated give the same output as a sequential dump. */
+  if (task->rev == pvb->start_rev)
+    SVN_ERR(write_dump_header(stream, fs, pvb->use_deltas, iterpool));
+
+  for (rev = task->rev; rev <= task->end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(dump_one_revision(stream, fs, rev, pvb->start_rev,
+                                pvb->incremental, pvb->use_deltas,
+                                pvb->include_revprops, pvb->include_changes,
+                                &result->found_old_reference,
+                                &result->found_old_mergeinfo,
+                                pvb->notify ? buffer_notification : NULL,
+                                result, iterpool));
+
+      if (pvb->notify)
+        {
+          notify->revision = rev;
+          buffer_notification(result, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Implements svn_task__process_func_t.  Verify the revision given by the
+   verify_rev_task_t in PROCESS_BATON, or dump the range of revisions
+   given by it, and return a verify_rev_result_t in *RESULT.  Errors
+   other than cancellation get reported through the result such that
+   the main thread can decide whether to continue. */
+static svn_error_t *
+verify_rev_task(void **result,
+                void *process_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const verify_rev_task_t *task = process_baton;
+  parallel_verify_baton_t *pvb = task->pvb;
+  verify_rev_result_t *verify_result = apr_pcalloc(result_pool,
+                                                   sizeof(*verify_result));
+  svn_fs_t *fs;
+  svn_error_t *err;
+  svn_error_t *release_err;
+
+  verify_result->task = task;
+  verify_result->pool = result_pool;
+  verify_result->notifications = apr_array_make(result_pool, 0,
+                                                sizeof(svn_repos_notify_t *));
+  verify_result->warnings = apr_array_make(result_pool, 0,
+                                           sizeof(svn_error_t *));
+  apr_pool_cleanup_register(result_pool, verify_result, cleanup_warnings,
+                            apr_pool_cleanup_null);
+
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs, pvb->fs_pool));
+
+  svn_fs_set_warning_func(fs, buffer_fs_warning, verify_result);
+  if (pvb->dump)
+    err = dump_rev_range(verify_result, task, fs,
+                         cancel_func, cancel_baton, scratch_pool);
+  else
+    err = verify_one_revision(fs, task->rev,
+                              pvb->notify ? buffer_notification : NULL,
+                              verify_result, pvb->start_rev,
+                              pvb->check_normalization,
+                              cancel_func, cancel_baton, scratch_pool);
+  svn_fs_set_warning_func(fs, buffer_fs_warning, NULL);
+
+  release_err = svn_repos__fs_pool_release(pvb->fs_pool, fs);
+  if (release_err || (err && err->apr_err == SVN_ERR_CANCELLED))
+    return svn_error_trace(svn_error_compose_create(err, release_err));
+
+  verify_result->err = err;
+  *result = verify_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Forward the warnings and notifications buffered in RESULT to the
+   callbacks in BATON.  Use SCRATCH_POOL for temporaries. */
+static void
+forward_buffered_output(verify_rev_result_t *result,
+                        verify_output_baton_t *baton,
+                        apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < result->warnings->nelts; ++i)
+    {
+      svn_error_t *warning = APR_ARRAY_IDX(result->warnings, i,
+                                           svn_error_t *);
+      svn_fs__warn(baton->fs, warning);
+      svn_error_clear(warning);
+    }
+  apr_array_clear(result->warnings);
+
+  for (i = 0; i < result->notifications->nelts; ++i)
+    baton->notify_func(baton->notify_baton,
+                       APR_ARRAY_IDX(result->notifications, i,
+                                     svn_repos_notify_t *),
+                       scratch_pool);
+}
+
+/* Implements svn_task__output_func_t.  Report the verify_rev_result_t in
+   RESULT to the callbacks in the verify_output_baton_t OUTPUT_BATON. */
+static svn_error_t *
+report_verify_result(void *result,
+                     void *output_baton,
+                     apr_pool_t *scratch_pool)
+{
+  verify_rev_result_t *verify_result = result;
+  verify_output_baton_t *baton = output_baton;
+
+  forward_buffered_output(verify_result, baton, scratch_pool);
+
+  if (verify_result->err)
+    {
+      svn_error_t *err = verify_result->err;
+
+      verify_result->err = SVN_NO_ERROR;
+      SVN_ERR(report_error(verify_result->task->rev, err,
+                           baton->verify_callback, baton->verify_baton,
+                           scratch_pool));
+    }
+  else if (baton->notify_func)
+    {
+      /* Tell the caller that we're done with this revision. */
+      baton->notify->revision = verify_result->task->rev;
+      baton->notify_func(baton->notify_baton, baton->notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Hand the dump data and the
+   notifications in the verify_rev_result_t RESULT over to the caller's
+   callbacks in the verify_output_baton_t OUTPUT_BATON. */
+static svn_error_t *
+write_dump_result(void *result,
+                  void *output_baton,
+                  apr_pool_t *scratch_pool)
+{
+  verify_rev_result_t *dump_result = result;
+  verify_output_baton_t *baton = output_baton;
+  const verify_rev_task_t *task = dump_result->task;
+  svn_stream_t *stream;
+  apr_off_t offset = 0;
+
+  forward_buffered_output(dump_result, baton, scratch_pool);
+
+  baton->found_old_reference |= dump_result->found_old_reference;
+  baton->found_old_mergeinfo |= dump_result->found_old_mergeinfo;
+
+  if (dump_result->err)
+    {
+      svn_error_t *err = dump_result->err;
+
+      dump_result->err = SVN_NO_ERROR;
+      return svn_error_trace(err);
+    }
+
+  /* Hand the buffered dump data over to the caller. */
+  SVN_ERR(svn_io_file_seek(dump_result->dump_file, APR_SET, &offset,
+                           scratch_pool));
+  SVN_ERR(baton->stream_func(&stream, baton->stream_baton, task->rev,
+                             task->end_rev, scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_copy3(svn_stream_from_aprfile2(dump_result->dump_file,
+                                                    TRUE, scratch_pool),
+                           stream, baton->cancel_func, baton->cancel_baton,
+                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set up *PVB_P to verify revisions of FS.  The other parameters will be
+   passed through to verify_one_revision().  The filesystem instances
+   opened by the tasks get closed when POOL gets cleaned up, i.e. after
+   the task sets in sub-pools of POOL are gone. */
+static svn_error_t *
+start_parallel_verify(parallel_verify_baton_t **pvb_p,
+                      svn_fs_t *fs,
+                      svn_boolean_t notify,
+                      svn_revnum_t start_rev,
+                      svn_boolean_t check_normalization,
+                      apr_pool_t *pool)
+{
+  parallel_verify_baton_t *pvb = apr_pcalloc(pool, sizeof(*pvb));
+
+  SVN_ERR(svn_repos__fs_pool_create(&pvb->fs_pool, fs, pool));
+
+  pvb->notify = notify;
+  pvb->start_rev = start_rev;
+  pvb->check_normalization = check_normalization;
+
+  *pvb_p = pvb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like the content verification loop in svn_repos_verify_fs4() but
+   verify up to JOBS revisions of FS concurrently.  Notifications and
+   calls to VERIFY_CALLBACK are being made in revision order and from
+   the calling thread only.  NOTIFY is a pre-allocated notification
+   structure for NOTIFY_FUNC. */
+static svn_error_t *
+verify_revisions_parallel(svn_fs_t *fs,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_boolean_t check_normalization,
+                          int jobs,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_repos_notify_t *notify,
+                          svn_repos_verify_callback_t verify_callback,
+                          void *verify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  parallel_verify_baton_t *pvb;
+  verify_output_baton_t baton = { 0 };
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+  svn_revnum_t rev;
+
+  SVN_ERR(start_parallel_verify(&pvb, fs, notify_func != NULL, start_rev,
+                                check_normalization, scratch_pool));
+
+  baton.fs = fs;
+  baton.notify_func = notify_func;
+  baton.notify_baton = notify_baton;
+  baton.notify = notify;
+  baton.verify_callback = verify_callback;
+  baton.verify_baton = verify_baton;
+
+  set_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, report_verify_result, &baton,
+                               cancel_func, cancel_baton, set_pool));
+
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      verify_rev_task_t *task = apr_pcalloc(scratch_pool, sizeof(*task));
+
+      task->pvb = pvb;
+      task->rev = rev;
+      task->end_rev = rev;
+      SVN_ERR(svn_task__add(set, verify_rev_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos__dump_fs_ranges() for FS with JOBS > 1.  OR the
+   respective warning flags of all ranges into *FOUND_OLD_REFERENCE and
+   *FOUND_OLD_MERGEINFO.  Notifications, calls to STREAM_FUNC and the
+   output itself are being made in revision order and from the calling
+   thread only. */
+static svn_error_t *
+dump_ranges_parallel(svn_fs_t *fs,
+                     svn_repos__dump_stream_func_t stream_func,
+                     void *stream_baton,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_revnum_t range_size,
+                     int jobs,
+                     svn_boolean_t incremental,
+                     svn_boolean_t use_deltas,
+                     svn_boolean_t include_revprops,
+                     svn_boolean_t include_changes,
+                     svn_boolean_t *found_old_reference,
+                     svn_boolean_t *found_old_mergeinfo,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  parallel_verify_baton_t *pvb;
+  verify_output_baton_t baton = { 0 };
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+  svn_revnum_t rev;
+
+  SVN_ERR(start_parallel_verify(&pvb, fs, notify_func != NULL, start_rev,
+                                FALSE, scratch_pool));
+  pvb->dump = TRUE;
+  pvb->incremental = incremental;
+  pvb->use_deltas = use_deltas;
+  pvb->include_revprops = include_revprops;
+  pvb->include_changes = include_changes;
+
+  baton.fs = fs;
+  baton.notify_func = notify_func;
+  baton.notify_baton = notify_baton;
+  baton.stream_func = stream_func;
+  baton.stream_baton = stream_baton;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+
+  set_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, write_dump_result, &baton,
+                               cancel_func, cancel_baton, set_pool));
+
+  for (rev = start_rev; rev <= end_rev; )
+    {
+      verify_rev_task_t *task = apr_pcalloc(scratch_pool, sizeof(*task));
+
+      task->pvb = pvb;
+      task->rev = rev;
+      task->end_rev = end_rev - rev < range_size ? end_rev
+                                                 : rev + range_size - 1;
+      SVN_ERR(svn_task__add(set, verify_rev_task, task));
+      rev = task->end_rev + 1;
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  *found_old_reference |= baton.found_old_reference;
+  *found_old_mergeinfo |= baton.found_old_mergeinfo;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2412,6 +2983,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_repos_notify_t *notify;
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
+  apr_hash_t *fs_config = svn_fs_config(fs, pool);
   svn_error_t *err;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
@@ -2453,8 +3025,18 @@ svn_repos_verify_fs3(svn_repos_t *repos,
         = svn_repos_notify_create(svn_repos_notify_verify_rev_structure, pool);
     }
 
+  /* Let the backend check multiple shards in parallel as well. */
+  if (jobs > 1)
+    {
+      if (!fs_config)
+        fs_config = apr_hash_make(pool);
+
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                    apr_itoa(pool, jobs));
+    }
+
   /* Verify global metadata and backend-specific data first. */
-  err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
+  err = svn_fs_verify(svn_fs_path(fs, pool), fs_config,
                       start_rev, end_rev,
                       verify_notify, verify_notify_baton,
                       cancel_func, cancel_baton, pool);
@@ -2469,7 +3051,13 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                            verify_baton, iterpool));
     }
 
-  if (!metadata_only)
+  if (!metadata_only && jobs > 1 && start_rev < end_rev)
+    SVN_ERR(verify_revisions_parallel(fs, start_rev, end_rev,
+                                      check_normalization, jobs,
+                                      notify_func, notify_baton, notify,
+                                      verify_callback, verify_baton,
+                                      cancel_func, cancel_baton, iterpool));
+  else if (!metadata_only)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
         svn_pool_clear(iterpool);
@@ -2508,3 +3096,109 @@ svn_repos_verify_fs3(svn_repos_t *repos,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos__dump_fs_ranges(svn_repos_t *repos,
+                          svn_repos__dump_stream_func_t stream_func,
+                          void *stream_baton,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_revnum_t range_size,
+                          int jobs,
+                          svn_boolean_t incremental,
+                          svn_boolean_t use_deltas,
+                          svn_boolean_t include_revprops,
+                          svn_boolean_t include_changes,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
+  svn_revnum_t range_start, range_end;
+  apr_pool_t *iterpool;
+  apr_pool_t *revpool;
+  svn_repos_notify_t *notify;
+
+  /* Make sure we catch up on the latest revprop changes.  This is the only
+   * time we will refresh the revprop data in this query. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, scratch_pool));
+
+  SVN_ERR(check_dump_range(&start_rev, &end_rev, fs, scratch_pool));
+  if (range_size <= 0)
+    range_size = end_rev - start_rev + 1;
+
+  if (jobs > 1 && end_rev - start_rev >= range_size)
+    {
+      SVN_ERR(dump_ranges_parallel(fs, stream_func, stream_baton,
+                                   start_rev, end_rev, range_size, jobs,
+                                   incremental, use_deltas,
+                                   include_revprops, include_changes,
+                                   &found_old_reference,
+                                   &found_old_mergeinfo,
+                                   notify_func, notify_baton,
+                                   cancel_func, cancel_baton,
+                                   scratch_pool));
+      notify_dump_end(found_old_reference, found_old_mergeinfo,
+                      notify_func, notify_baton, scratch_pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Create a notify object that we can reuse in the loop. */
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                     scratch_pool);
+
+  iterpool = svn_pool_create(scratch_pool);
+  revpool = svn_pool_create(scratch_pool);
+  for (range_start = start_rev; range_start <= end_rev;
+       range_start = range_end + 1)
+    {
+      svn_stream_t *stream;
+      svn_revnum_t rev;
+
+      svn_pool_clear(iterpool);
+      range_end = end_rev - range_start < range_size
+                ? end_rev
+                : range_start + range_size - 1;
+
+      SVN_ERR(stream_func(&stream, stream_baton, range_start, range_end,
+                          iterpool, iterpool));
+      if (range_start == start_rev)
+        SVN_ERR(write_dump_header(stream, fs, use_deltas, iterpool));
+
+      for (rev = range_start; rev <= range_end; rev++)
+        {
+          svn_pool_clear(revpool);
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(dump_one_revision(stream, fs, rev, start_rev, incremental,
+                                    use_deltas, include_revprops,
+                                    include_changes, &found_old_reference,
+                                    &found_old_mergeinfo, notify_func,
+                                    notify_baton, revpool));
+
+          if (notify_func)
+            {
+              notify->revision = rev;
+              notify_func(notify_baton, notify, revpool);
+            }
+        }
+
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, iterpool);
+
+  svn_pool_destroy(revpool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
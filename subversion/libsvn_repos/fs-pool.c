@@ -0,0 +1,197 @@
+/* fs-pool.c : filesystem instances for concurrent tasks
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_hash.h>
+
+#include "svn_pools.h"
+#include "svn_fs.h"
+
+#include "private/svn_mutex.h"
+
+#include "repos.h"
+
+/* An instance opened by an svn_repos__fs_pool_t. */
+typedef struct fs_instance_t
+{
+  svn_fs_t *fs;
+
+  /* Set while the instance has been acquired by somebody. */
+  svn_boolean_t in_use;
+
+  /* Root pool of this instance, holding FS and this struct.  Being a
+     root pool, it can be created without access to the shared pools. */
+  apr_pool_t *pool;
+
+  /* Next instance of the same svn_repos__fs_pool_t. */
+  struct fs_instance_t *next;
+} fs_instance_t;
+
+struct svn_repos__fs_pool_t
+{
+  /* The repository to open instances of and its config. */
+  const char *path;
+  apr_hash_t *config;
+
+  /* Serializes access to INSTANCES and their IN_USE flags.  It is not
+     being held while opening new instances. */
+  svn_mutex__t *mutex;
+
+  /* All instances opened so far.  There are never more of them than
+     tasks running at the same time, so a list is good enough. */
+  fs_instance_t *instances;
+};
+
+/* Pool cleanup function closing all instances of the
+   svn_repos__fs_pool_t in DATA. */
+static apr_status_t
+cleanup_fs_pool(void *data)
+{
+  svn_repos__fs_pool_t *fs_pool = data;
+
+  while (fs_pool->instances)
+    {
+      fs_instance_t *instance = fs_pool->instances;
+
+      fs_pool->instances = instance->next;
+      svn_pool_destroy(instance->pool);
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_repos__fs_pool_create(svn_repos__fs_pool_t **fs_pool,
+                          svn_fs_t *fs,
+                          apr_pool_t *result_pool)
+{
+  svn_repos__fs_pool_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->path = svn_fs_path(fs, result_pool);
+  result->config = svn_fs_config(fs, result_pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+  apr_pool_cleanup_register(result_pool, result, cleanup_fs_pool,
+                            apr_pool_cleanup_null);
+
+  *fs_pool = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark an idle instance in FS_POOL as being in use and return it in
+   *INSTANCE, or set *INSTANCE to NULL if there is none. */
+static svn_error_t *
+take_idle_instance(fs_instance_t **instance,
+                   svn_repos__fs_pool_t *fs_pool)
+{
+  fs_instance_t *candidate;
+
+  for (candidate = fs_pool->instances; candidate; candidate = candidate->next)
+    if (!candidate->in_use)
+      {
+        candidate->in_use = TRUE;
+        break;
+      }
+
+  *instance = candidate;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add INSTANCE to FS_POOL. */
+static svn_error_t *
+add_instance(svn_repos__fs_pool_t *fs_pool,
+             fs_instance_t *instance)
+{
+  instance->next = fs_pool->instances;
+  fs_pool->instances = instance;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__fs_pool_acquire(svn_fs_t **fs,
+                           svn_repos__fs_pool_t *fs_pool)
+{
+  fs_instance_t *instance;
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  SVN_MUTEX__WITH_LOCK(fs_pool->mutex,
+                       take_idle_instance(&instance, fs_pool));
+  if (instance)
+    {
+      *fs = instance->fs;
+      return SVN_NO_ERROR;
+    }
+
+  /* Opening an instance reads from the repository, so don't make the
+     other tasks wait for that.  Each instance gets a copy of the config
+     hash because we can't tell how svn_fs_open2() is going to use it. */
+  pool = svn_pool_create(NULL);
+  instance = apr_pcalloc(pool, sizeof(*instance));
+  instance->in_use = TRUE;
+  instance->pool = pool;
+  err = svn_fs_open2(&instance->fs, fs_pool->path,
+                     fs_pool->config ? apr_hash_copy(pool, fs_pool->config)
+                                     : NULL,
+                     pool, pool);
+  if (!err)
+    err = svn_mutex__lock(fs_pool->mutex);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  SVN_ERR(svn_mutex__unlock(fs_pool->mutex,
+                            add_instance(fs_pool, instance)));
+  *fs = instance->fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark the instance FS of FS_POOL as idle. */
+static svn_error_t *
+release_instance(svn_repos__fs_pool_t *fs_pool,
+                 svn_fs_t *fs)
+{
+  fs_instance_t *instance;
+
+  for (instance = fs_pool->instances; instance; instance = instance->next)
+    if (instance->fs == fs)
+      {
+        SVN_ERR_ASSERT(instance->in_use);
+        instance->in_use = FALSE;
+        return SVN_NO_ERROR;
+      }
+
+  SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_repos__fs_pool_release(svn_repos__fs_pool_t *fs_pool,
+                           svn_fs_t *fs)
+{
+  SVN_MUTEX__WITH_LOCK(fs_pool->mutex, release_instance(fs_pool, fs));
+
+  return SVN_NO_ERROR;
+}
@@ -39,6 +39,8 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_cache.h"
+#include "private/svn_skel.h"
 
 
 /*** Commit wrappers ***/
@@ -110,6 +112,10 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Keep the date index current but leave its initial creation, which
+     may take a while, to the first date lookup.  It is only a cache. */
+  svn_error_clear(svn_repos__date_index_update(repos, FALSE, pool));
+
   /* Run post-commit hooks. */
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
@@ -407,6 +413,10 @@ svn_repos_fs_change_rev_prop4(svn_repos_t *repos,
       SVN_ERR(svn_fs_change_rev_prop2(repos->fs, rev, name,
                                       &old_value, new_value, pool));
 
+      if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
+        svn_error_clear(svn_repos__date_index_set(repos, rev, new_value,
+                                                  pool));
+
       if (use_post_revprop_change_hook)
         SVN_ERR(svn_repos__hooks_post_revprop_change(repos, hooks_env, rev,
                                                      author, name, old_value,
@@ -1013,10 +1023,154 @@ svn_repos_fs_pack2(svn_repos_t *repos,
   pnb.notify_func = notify_func;
   pnb.notify_baton = notify_baton;
 
-  return svn_fs_pack(repos->db_path,
-                     notify_func ? pack_notify_func : NULL,
-                     notify_func ? &pnb : NULL,
-                     cancel_func, cancel_baton, pool);
+  return svn_fs_pack2(repos->db_path, svn_fs_config(repos->fs, pool),
+                      notify_func ? pack_notify_func : NULL,
+                      notify_func ? &pnb : NULL,
+                      cancel_func, cancel_baton, pool);
+}
+
+/* Return the cache of inherited properties for FS in *CACHE, or NULL if
+   there is no global membuffer cache to put it in.  Cached values are the
+   unparsed IPROPS skels of all non-empty proplists on a directory and its
+   parents, unfiltered by authz.  Allocate the cache in RESULT_POOL. */
+static svn_error_t *
+get_iprops_cache(svn_cache__t **cache,
+                 svn_fs_t *fs,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            cache, membuffer, NULL, NULL, APR_HASH_KEY_STRING,
+            apr_pstrcat(scratch_pool, "repos-iprops:", uuid, ":",
+                        svn_fs_path(fs, scratch_pool), SVN_VA_NULL),
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            svn_cache__admission_default,
+            TRUE, FALSE, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *IPROPS to the depth-first ordered array of all non-empty
+   proplists on directory DIR_PATH under revision ROOT and its parents,
+   including DIR_PATH itself.  Use and fill CACHE along the way.
+   Allocate the result in RESULT_POOL. */
+static svn_error_t *
+get_dir_iprops(apr_array_header_t **iprops,
+               svn_fs_root_t *root,
+               const char *dir_path,
+               svn_cache__t *cache,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char *key = apr_psprintf(scratch_pool, "%ld:%s",
+                                 svn_fs_revision_root_revision(root),
+                                 dir_path);
+  svn_stringbuf_t *value;
+  svn_boolean_t found;
+  apr_hash_t *proplist;
+  svn_skel_t *skel;
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, key, scratch_pool));
+  if (found)
+    {
+      skel = svn_skel__parse(value->data, value->len, scratch_pool);
+      if (skel)
+        return svn_error_trace(svn_skel__parse_iprops(iprops, skel,
+                                                      result_pool));
+    }
+
+  /* Cache miss.  Our parents' entries are a prefix of ours. */
+  if (dir_path[0] == '/' && dir_path[1] == '\0')
+    *iprops = apr_array_make(result_pool, 1,
+                             sizeof(svn_prop_inherited_item_t *));
+  else
+    SVN_ERR(get_dir_iprops(iprops, root,
+                           svn_fspath__dirname(dir_path, scratch_pool),
+                           cache, result_pool, scratch_pool));
+
+  SVN_ERR(svn_fs_node_proplist(&proplist, root, dir_path, result_pool));
+  if (apr_hash_count(proplist))
+    {
+      svn_prop_inherited_item_t *i_props =
+        apr_pcalloc(result_pool, sizeof(*i_props));
+      i_props->path_or_url = apr_pstrdup(result_pool, dir_path + 1);
+      i_props->prop_hash = proplist;
+      APR_ARRAY_PUSH(*iprops, svn_prop_inherited_item_t *) = i_props;
+    }
+
+  SVN_ERR(svn_skel__unparse_iproplist(&skel, *iprops, scratch_pool,
+                                      scratch_pool));
+  SVN_ERR(svn_cache__set(cache, key, svn_skel__unparse(skel, scratch_pool),
+                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos_fs_get_inherited_props for revision roots using
+   the inherited properties CACHE. */
+static svn_error_t *
+get_inherited_props_cached(apr_array_header_t **inherited_props_p,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           const char *propname,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           svn_cache__t *cache,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *inherited_props;
+  apr_array_header_t *dir_iprops;
+  int i;
+
+  SVN_ERR(get_dir_iprops(&dir_iprops, root,
+                         svn_fspath__dirname(path, scratch_pool), cache,
+                         result_pool, scratch_pool));
+
+  inherited_props = apr_array_make(result_pool, dir_iprops->nelts,
+                                   sizeof(svn_prop_inherited_item_t *));
+  for (i = 0; i < dir_iprops->nelts; i++)
+    {
+      svn_prop_inherited_item_t *i_props
+        = APR_ARRAY_IDX(dir_iprops, i, svn_prop_inherited_item_t *);
+      svn_boolean_t allowed = TRUE;
+
+      svn_pool_clear(iterpool);
+      if (authz_read_func)
+        SVN_ERR(authz_read_func(&allowed, root,
+                                svn_fspath__canonicalize(i_props->path_or_url,
+                                                         iterpool),
+                                authz_read_baton, iterpool));
+      if (!allowed)
+        continue;
+
+      if (propname)
+        {
+          svn_string_t *propval = svn_hash_gets(i_props->prop_hash,
+                                                propname);
+          if (!propval)
+            continue;
+
+          i_props->prop_hash = apr_hash_make(result_pool);
+          svn_hash_sets(i_props->prop_hash, propname, propval);
+        }
+
+      APR_ARRAY_PUSH(inherited_props, svn_prop_inherited_item_t *) = i_props;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *inherited_props_p = inherited_props;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1029,10 +1183,30 @@ svn_repos_fs_get_inherited_props(apr_array_header_t **inherited_props_p,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   apr_array_header_t *inherited_props;
   const char *parent_path = path;
 
+  /* Inherited properties of revision roots never change, so we can cache
+     them per directory. */
+  if (svn_fs_is_revision_root(root)
+      && !(path[0] == '/' && path[1] == '\0'))
+    {
+      svn_cache__t *cache;
+
+      SVN_ERR(get_iprops_cache(&cache, svn_fs_root_fs(root), scratch_pool,
+                               scratch_pool));
+      if (cache)
+        return svn_error_trace(get_inherited_props_cached(inherited_props_p,
+                                                         root, path, propname,
+                                                         authz_read_func,
+                                                         authz_read_baton,
+                                                         cache, result_pool,
+                                                         scratch_pool));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+
   inherited_props = apr_array_make(result_pool, 1,
                                    sizeof(svn_prop_inherited_item_t *));
   while (!(parent_path[0] == '/' && parent_path[1] == '\0'))
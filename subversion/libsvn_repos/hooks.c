@@ -28,6 +28,7 @@
 #include <apr_file_io.h>
 
 #include "svn_config.h"
+#include "svn_dso.h"
 #include "svn_hash.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
@@ -35,11 +36,16 @@
 #include "svn_pools.h"
 #include "svn_repos.h"
 #include "svn_utf.h"
+#include "svn_version.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_atomic.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
 
 
@@ -193,6 +199,26 @@ env_from_env_hash(apr_hash_t *env_hash,
   return env;
 }
 
+/* Return the environment (mapping variable names to values) for the hook
+ * NAME given in HOOKS_ENV, or NULL if there is none.  That is a custom
+ * environment defined for this hook or else the default environment. */
+static apr_hash_t *
+get_hook_env(apr_hash_t *hooks_env,
+             const char *name)
+{
+  apr_hash_t *hook_env = NULL;
+
+  if (hooks_env)
+    {
+      hook_env = svn_hash_gets(hooks_env, name);
+      if (hook_env == NULL)
+        hook_env = svn_hash_gets(hooks_env,
+                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+    }
+
+  return hook_env;
+}
+
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
    program that is to be run.  The hook's exit status will be checked,
    and if an error occurred the hook's stderr output will be added to
@@ -237,16 +263,7 @@ run_hook_cmd(svn_string_t **result,
    * destroy in order to clean up the stderr pipe opened for the process. */
   cmd_pool = svn_pool_create(pool);
 
-  /* Check if a custom environment is defined for this hook, or else
-   * whether a default environment is defined. */
-  if (hooks_env)
-    {
-      hook_env = svn_hash_gets(hooks_env, name);
-      if (hook_env == NULL)
-        hook_env = svn_hash_gets(hooks_env,
-                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
-    }
-
+  hook_env = get_hook_env(hooks_env, name);
   err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
                           env_from_env_hash(hook_env, pool, pool),
                           FALSE, FALSE, stdin_handle, result != NULL,
@@ -445,6 +462,153 @@ svn_repos__parse_hooks_env(apr_hash_t **hooks_env_p,
   return SVN_NO_ERROR;
 }
 
+
+/*** Hook plugins. ***/
+
+/* Process-wide cache of the hook plugins loaded so far, mapping absolute
+ * library paths to svn_repos_hook_plugin_t *.  Everything is allocated
+ * in PLUGIN_POOL and access to the cache is serialized by PLUGIN_MUTEX. */
+static apr_pool_t *plugin_pool = NULL;
+static apr_hash_t *plugin_cache = NULL;
+static svn_mutex__t *plugin_mutex = NULL;
+static volatile svn_atomic_t plugin_cache_init_state = 0;
+
+/* Implements svn_atomic__init_once's callback. */
+static svn_error_t *
+init_plugin_cache(void *baton,
+                  apr_pool_t *pool)
+{
+  plugin_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&plugin_mutex, TRUE, plugin_pool));
+  plugin_cache = apr_hash_make(plugin_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PLUGIN to the hooks of the plugin library at the absolute path
+ * LIBPATH, loading and initializing it if that did not happen before.
+ * Must be called with PLUGIN_MUTEX being held.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+load_plugin(const svn_repos_hook_plugin_t **plugin,
+            const char *libpath,
+            apr_pool_t *scratch_pool)
+{
+  svn_repos_hook_plugin_t *result = svn_hash_gets(plugin_cache, libpath);
+
+  if (!result)
+    {
+#if APR_HAS_DSO
+      apr_dso_handle_t *dso;
+      apr_dso_handle_sym_t symbol;
+      svn_repos_hook_plugin_init_t initfunc;
+      apr_status_t status;
+
+      SVN_ERR(svn_dso_load(&dso, libpath));
+      if (!dso)
+        return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                                 _("Can't load hook plugin '%s'"),
+                                 svn_dirent_local_style(libpath,
+                                                        scratch_pool));
+
+      status = apr_dso_sym(&symbol, dso, SVN_REPOS_HOOK_PLUGIN_INIT);
+      if (status)
+        return svn_error_wrap_apr(status, _("'%s' does not define '%s()'"),
+                                  svn_dirent_local_style(libpath,
+                                                         scratch_pool),
+                                  SVN_REPOS_HOOK_PLUGIN_INIT);
+
+      initfunc = (svn_repos_hook_plugin_init_t) symbol;
+      result = apr_pcalloc(plugin_pool, sizeof(*result));
+      SVN_ERR(initfunc(result, svn_repos_version(), plugin_pool));
+
+      svn_hash_sets(plugin_cache, apr_pstrdup(plugin_pool, libpath), result);
+#else
+      return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                               _("Can't load hook plugin '%s'; dynamic "
+                                 "loading is not supported"),
+                               svn_dirent_local_style(libpath,
+                                                      scratch_pool));
+#endif
+    }
+
+  *plugin = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PLUGIN to the hook plugin configured for the hook NAME of REPOS
+ * in HOOKS_ENV or to NULL if there is none.  Use POOL for temporary
+ * allocations. */
+static svn_error_t *
+get_hook_plugin(const svn_repos_hook_plugin_t **plugin,
+                svn_repos_t *repos,
+                apr_hash_t *hooks_env,
+                const char *name,
+                apr_pool_t *pool)
+{
+  apr_hash_t *hook_env = get_hook_env(hooks_env, name);
+  const char *libpath;
+
+  *plugin = NULL;
+  libpath = hook_env ? svn_hash_gets(hook_env, SVN_REPOS_HOOK_PLUGIN_OPTION)
+                     : NULL;
+  if (!libpath || !*libpath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_dirent_get_absolute(&libpath,
+                                  svn_dirent_join(
+                                    svn_repos_hook_dir(repos, pool),
+                                    svn_dirent_internal_style(libpath, pool),
+                                    pool),
+                                  pool));
+
+  SVN_ERR(svn_atomic__init_once(&plugin_cache_init_state, init_plugin_cache,
+                                NULL, pool));
+  SVN_MUTEX__WITH_LOCK(plugin_mutex, load_plugin(plugin, libpath, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make PLUGIN the hooks of the library at LIBPATH.
+ * Must be called with PLUGIN_MUTEX being held. */
+static svn_error_t *
+register_plugin(const char *libpath,
+                const svn_repos_hook_plugin_t *plugin)
+{
+  svn_hash_sets(plugin_cache, apr_pstrdup(plugin_pool, libpath),
+                apr_pmemdup(plugin_pool, plugin, sizeof(*plugin)));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__hook_plugin_register(const char *libpath,
+                                const svn_repos_hook_plugin_t *plugin,
+                                apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(libpath));
+
+  SVN_ERR(svn_atomic__init_once(&plugin_cache_init_state, init_plugin_cache,
+                                NULL, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(plugin_mutex, register_plugin(libpath, plugin));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return ERR, as returned by the plugin implementation of hook NAME,
+ * wrapped like a hook script failure. */
+static svn_error_t *
+plugin_hook_error(svn_error_t *err,
+                  const char *name)
+{
+  if (err)
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                             _("'%s' hook plugin failed"), name);
+
+  return SVN_NO_ERROR;
+}
+
 /* Return an error for the failure of HOOK due to a broken symlink. */
 static svn_error_t *
 hook_symlink_error(const char *hook)
@@ -463,8 +627,17 @@ svn_repos__hooks_start_commit(svn_repos_t *repos,
                               apr_pool_t *pool)
 {
   const char *hook = svn_repos_start_commit_hook(repos, pool);
+  const svn_repos_hook_plugin_t *plugin;
   svn_boolean_t broken_link;
 
+  SVN_ERR(get_hook_plugin(&plugin, repos, hooks_env,
+                          SVN_REPOS__HOOK_START_COMMIT, pool));
+  if (plugin && plugin->start_commit)
+    SVN_ERR(plugin_hook_error(plugin->start_commit(repos, user, capabilities,
+                                                   txn_name, plugin->baton,
+                                                   pool),
+                              SVN_REPOS__HOOK_START_COMMIT));
+
   if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
@@ -548,8 +721,27 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
                             apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_commit_hook(repos, pool);
+  const svn_repos_hook_plugin_t *plugin;
   svn_boolean_t broken_link;
 
+  SVN_ERR(get_hook_plugin(&plugin, repos, hooks_env,
+                          SVN_REPOS__HOOK_PRE_COMMIT, pool));
+  if (plugin && plugin->pre_commit)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_access_t *access_ctx;
+      apr_hash_t *lock_tokens = NULL;
+
+      SVN_ERR(svn_fs_open_txn(&txn, repos->fs, txn_name, pool));
+      SVN_ERR(svn_fs_get_access(&access_ctx, repos->fs));
+      if (access_ctx)
+        lock_tokens = svn_fs__access_get_lock_tokens(access_ctx);
+
+      SVN_ERR(plugin_hook_error(plugin->pre_commit(repos, txn, lock_tokens,
+                                                   plugin->baton, pool),
+                                SVN_REPOS__HOOK_PRE_COMMIT));
+    }
+
   if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
@@ -586,16 +778,27 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
 }
 
 
-svn_error_t  *
-svn_repos__hooks_post_commit(svn_repos_t *repos,
-                             apr_hash_t *hooks_env,
-                             svn_revnum_t rev,
-                             const char *txn_name,
-                             apr_pool_t *pool)
+/* Run the post-commit hook plugin and script for REV of REPOS, without
+ * considering SVN_REPOS_HOOK_ASYNC_OPTION.  Otherwise like
+ * svn_repos__hooks_post_commit(). */
+static svn_error_t *
+run_post_commit(svn_repos_t *repos,
+                apr_hash_t *hooks_env,
+                svn_revnum_t rev,
+                const char *txn_name,
+                apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_commit_hook(repos, pool);
+  const svn_repos_hook_plugin_t *plugin;
   svn_boolean_t broken_link;
 
+  SVN_ERR(get_hook_plugin(&plugin, repos, hooks_env,
+                          SVN_REPOS__HOOK_POST_COMMIT, pool));
+  if (plugin && plugin->post_commit)
+    SVN_ERR(plugin_hook_error(plugin->post_commit(repos, rev, txn_name,
+                                                  plugin->baton, pool),
+                              SVN_REPOS__HOOK_POST_COMMIT));
+
   if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
@@ -618,6 +821,418 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
 }
 
 
+/*** Asynchronous post-commit hooks. ***/
+
+/* Directory below the repository's db directory that holds the queue of
+ * pending post-commit hook runs.  Each entry is a file named
+ * SVN_REPOS__HOOK_POST_COMMIT "-" revision that contains the name of
+ * the committed transaction.  Entries whose hook keeps failing get the
+ * HOOK_QUEUE_FAILED_SUFFIX and the failure added.  Only the holder of
+ * the lock on HOOK_QUEUE_LOCK may run the hooks. */
+#define HOOK_QUEUE_DIR "hook-queue"
+#define HOOK_QUEUE_LOCK "lock"
+#define HOOK_QUEUE_FAILED_SUFFIX ".failed"
+
+/* Number of times we run a failing hook before we give up on it. */
+#define HOOK_QUEUE_ATTEMPTS 3
+
+/* Delay before the first retry of a failed hook.  It doubles with every
+   further retry. */
+#define HOOK_QUEUE_RETRY_DELAY apr_time_from_sec(1)
+
+/* Return TRUE if HOOKS_ENV enables SVN_REPOS_HOOK_ASYNC_OPTION for the
+ * post-commit hook. */
+static svn_boolean_t
+post_commit_is_async(apr_hash_t *hooks_env)
+{
+  apr_hash_t *hook_env = get_hook_env(hooks_env, SVN_REPOS__HOOK_POST_COMMIT);
+
+  return hook_env
+      && svn_tristate__from_word(svn_hash_gets(hook_env,
+                                               SVN_REPOS_HOOK_ASYNC_OPTION))
+           == svn_tristate_true;
+}
+
+/* Return the hook queue directory of the repository at REPOS_PATH,
+ * allocated in POOL. */
+static const char *
+hook_queue_dir(const char *repos_path,
+               apr_pool_t *pool)
+{
+  return svn_dirent_join_many(pool, repos_path, SVN_REPOS__DB_DIR,
+                              HOOK_QUEUE_DIR, SVN_VA_NULL);
+}
+
+/* Durably add the post-commit hook run for REV, created from TXN_NAME,
+ * to the hook queue of REPOS.  Use POOL for temporary allocations. */
+static svn_error_t *
+enqueue_post_commit(svn_repos_t *repos,
+                    svn_revnum_t rev,
+                    const char *txn_name,
+                    apr_pool_t *pool)
+{
+  const char *queue_dir = hook_queue_dir(repos->path, pool);
+  const char *contents = apr_pstrcat(pool, txn_name ? txn_name : "", "\n",
+                                     SVN_VA_NULL);
+
+  SVN_ERR(svn_io_make_dir_recursively(queue_dir, pool));
+  SVN_ERR(svn_io_write_atomic2(
+            svn_dirent_join(queue_dir,
+                            apr_psprintf(pool, "%s-%ld",
+                                         SVN_REPOS__HOOK_POST_COMMIT, rev),
+                            pool),
+            contents, strlen(contents), NULL, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort svn_revnum_t elements in ascending order. */
+static int
+compare_revnums(const void *a,
+                const void *b)
+{
+  svn_revnum_t a_rev = *(const svn_revnum_t *)a;
+  svn_revnum_t b_rev = *(const svn_revnum_t *)b;
+
+  if (a_rev == b_rev)
+    return 0;
+
+  return a_rev < b_rev ? -1 : 1;
+}
+
+/* Set *REVS to the revisions of the pending entries in QUEUE_DIR, in
+ * ascending order.  Allocate them in RESULT_POOL and use SCRATCH_POOL
+ * for temporary allocations. */
+static svn_error_t *
+read_hook_queue(apr_array_header_t **revs,
+                const char *queue_dir,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  static const char prefix[] = SVN_REPOS__HOOK_POST_COMMIT "-";
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  *revs = apr_array_make(result_pool, 0, sizeof(svn_revnum_t));
+
+  err = svn_io_get_dirents3(&dirents, queue_dir, TRUE, scratch_pool,
+                            scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const char *end;
+      svn_revnum_t rev;
+
+      if (strncmp(name, prefix, sizeof(prefix) - 1) != 0)
+        continue;
+
+      /* Skip failed entries and anything else we don't know. */
+      err = svn_revnum_parse(&rev, name + sizeof(prefix) - 1, &end);
+      if (err || *end)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      APR_ARRAY_PUSH(*revs, svn_revnum_t) = rev;
+    }
+
+  svn_sort__array(*revs, compare_revnums);
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the queued post-commit hook for REV of REPOS, whose entry in the
+ * hook queue is ENTRY_PATH, and remove the entry.  Retry failed hooks
+ * and mark their entry as failed if they never succeed.  HOOKS_ENV is
+ * as for svn_repos__hooks_post_commit().  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+run_queued_post_commit(svn_repos_t *repos,
+                       apr_hash_t *hooks_env,
+                       svn_revnum_t rev,
+                       const char *entry_path,
+                       apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *txn_name;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool;
+  const char *contents;
+  int attempt;
+
+  SVN_ERR(svn_stringbuf_from_file2(&txn_name, entry_path, scratch_pool));
+  svn_stringbuf_strip_whitespace(txn_name);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (attempt = 0; attempt < HOOK_QUEUE_ATTEMPTS; attempt++)
+    {
+      svn_pool_clear(iterpool);
+      svn_error_clear(err);
+
+      if (attempt)
+        apr_sleep(HOOK_QUEUE_RETRY_DELAY << (attempt - 1));
+
+      err = run_post_commit(repos, hooks_env, rev, txn_name->data, iterpool);
+      if (!err)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  if (!err)
+    return svn_error_trace(svn_io_remove_file2(entry_path, FALSE,
+                                               scratch_pool));
+
+  /* Keep the entry and the reason for the admin to look at, but don't
+     hold up the following entries any longer. */
+  contents = apr_psprintf(scratch_pool, "%s\n\n%s\n", txn_name->data,
+                          svn_repos__post_commit_error_str(err,
+                                                           scratch_pool));
+  svn_error_clear(err);
+
+  SVN_ERR(svn_io_write_atomic2(apr_pstrcat(scratch_pool, entry_path,
+                                           HOOK_QUEUE_FAILED_SUFFIX,
+                                           SVN_VA_NULL),
+                               contents, strlen(contents), NULL, TRUE,
+                               scratch_pool));
+
+  return svn_error_trace(svn_io_remove_file2(entry_path, FALSE,
+                                             scratch_pool));
+}
+
+/* Run all queued post-commit hooks of REPOS in revision order, unless
+ * another process is already doing that.  HOOKS_ENV is as for
+ * svn_repos__hooks_post_commit().  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+drain_hook_queue(svn_repos_t *repos,
+                 apr_hash_t *hooks_env,
+                 apr_pool_t *scratch_pool)
+{
+  const char *queue_dir = hook_queue_dir(repos->path, scratch_pool);
+  const char *lock_path = svn_dirent_join(queue_dir, HOOK_QUEUE_LOCK,
+                                          scratch_pool);
+  apr_pool_t *lock_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *revs;
+
+  SVN_ERR(read_hook_queue(&revs, queue_dir, scratch_pool, iterpool));
+  while (revs->nelts)
+    {
+      apr_file_t *lock_file;
+      svn_error_t *err;
+      int i;
+
+      svn_pool_clear(lock_pool);
+      SVN_ERR(svn_io_file_open(&lock_file, lock_path,
+                               APR_WRITE | APR_CREATE, APR_OS_DEFAULT,
+                               lock_pool));
+      err = svn_io_lock_open_file(lock_file, TRUE, TRUE, lock_pool);
+      if (err && APR_STATUS_IS_EAGAIN(err->apr_err))
+        {
+          /* The lock holder will pick up our entries as well. */
+          svn_error_clear(err);
+          break;
+        }
+      SVN_ERR(err);
+
+      for (i = 0; i < revs->nelts; i++)
+        {
+          svn_revnum_t rev = APR_ARRAY_IDX(revs, i, svn_revnum_t);
+          const char *entry_path;
+
+          svn_pool_clear(iterpool);
+          entry_path = svn_dirent_join(queue_dir,
+                                       apr_psprintf(iterpool, "%s-%ld",
+                                                    SVN_REPOS__HOOK_POST_COMMIT,
+                                                    rev),
+                                       iterpool);
+
+          /* Another process may have run it before we got the lock. */
+          err = run_queued_post_commit(repos, hooks_env, rev, entry_path,
+                                       iterpool);
+          if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+            svn_error_clear(err);
+          else
+            SVN_ERR(err);
+        }
+
+      /* Release the lock before looking for new entries.  Processes that
+         queued them while we held the lock left them to us. */
+      svn_pool_clear(lock_pool);
+      SVN_ERR(read_hook_queue(&revs, queue_dir, scratch_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(lock_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* The task set that runs queued post-commit hooks in the background once
+ * svn_repos__hook_queue_start() has been called.  Its tasks run one at a
+ * time, so they never compete for the queue lock of a repository within
+ * this process.  Adding tasks is serialized by QUEUE_MUTEX. */
+static svn_task__set_t *queue_set = NULL;
+static svn_mutex__t *queue_mutex = NULL;
+static volatile svn_atomic_t queue_init_state = 0;
+static volatile svn_atomic_t queue_started = FALSE;
+
+/* A background run of the hook queue of one repository. */
+typedef struct queue_task_t
+{
+  /* Absolute path of the repository. */
+  const char *repos_path;
+
+  /* The hooks environment file used by the commit, may be NULL. */
+  const char *hooks_env_path;
+
+  /* Pool for all of the above. */
+  apr_pool_t *pool;
+} queue_task_t;
+
+/* Implements svn_task__process_func_t.  Run the queued post-commit hooks
+ * of the repository given by the queue_task_t in PROCESS_BATON and return
+ * that baton in *RESULT. */
+static svn_error_t *
+run_queue_task(void **result,
+               void *process_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  queue_task_t *task = process_baton;
+  apr_array_header_t *revs;
+  svn_repos_t *repos;
+  apr_hash_t *hooks_env;
+  svn_error_t *err;
+
+  *result = task;
+
+  /* Earlier tasks may have run our entries already. */
+  err = read_hook_queue(&revs, hook_queue_dir(task->repos_path,
+                                              scratch_pool),
+                        scratch_pool, scratch_pool);
+  if (!err && revs->nelts)
+    {
+      err = svn_repos_open3(&repos, task->repos_path, NULL, scratch_pool,
+                            scratch_pool);
+      if (!err)
+        err = svn_repos_hooks_setenv(repos, task->hooks_env_path,
+                                     scratch_pool);
+      if (!err)
+        err = svn_repos__parse_hooks_env(&hooks_env, repos->hooks_env_path,
+                                         scratch_pool, scratch_pool);
+      if (!err)
+        err = drain_hook_queue(repos, hooks_env, scratch_pool);
+    }
+
+  /* There is nobody to report to, and failing would cancel all later
+     tasks.  Whatever we could not process stays queued and gets picked
+     up by the next commit. */
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Release the queue_task_t RESULT. */
+static svn_error_t *
+release_queue_task(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  queue_task_t *task = result;
+
+  svn_pool_destroy(task->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_atomic__init_once's callback. */
+static svn_error_t *
+init_queue_set(void *baton,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  SVN_ERR(svn_mutex__init(&queue_mutex, TRUE, pool));
+  return svn_error_trace(svn_task__set_create(&queue_set, 1,
+                                              release_queue_task, NULL,
+                                              NULL, NULL, pool));
+}
+
+svn_error_t *
+svn_repos__hook_queue_start(apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&queue_init_state, init_queue_set, NULL,
+                                scratch_pool));
+  svn_atomic_set(&queue_started, TRUE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that the queued post-commit hooks of REPOS get run.  Unless
+ * svn_repos__hook_queue_start() has been called, run them right away.
+ * HOOKS_ENV is as for svn_repos__hooks_post_commit().  Use POOL for
+ * temporary allocations. */
+static svn_error_t *
+process_hook_queue(svn_repos_t *repos,
+                   apr_hash_t *hooks_env,
+                   apr_pool_t *pool)
+{
+  queue_task_t *task;
+  apr_pool_t *task_pool;
+  svn_error_t *err;
+
+  /* Short-lived processes may exit before a background run completes,
+     leaving the rest of the queue to the next commit and a hook that
+     got killed half-way to be run again. */
+  if (!svn_atomic_read(&queue_started))
+    return svn_error_trace(drain_hook_queue(repos, hooks_env, pool));
+
+  task_pool = svn_pool_create(NULL);
+  task = apr_pcalloc(task_pool, sizeof(*task));
+  task->pool = task_pool;
+  task->hooks_env_path = apr_pstrdup(task_pool, repos->hooks_env_path);
+  err = svn_dirent_get_absolute(&task->repos_path, repos->path, task_pool);
+  if (err)
+    {
+      svn_pool_destroy(task_pool);
+      return svn_error_trace(err);
+    }
+
+  SVN_MUTEX__WITH_LOCK(queue_mutex,
+                       svn_task__add(queue_set, run_queue_task, task));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t  *
+svn_repos__hooks_post_commit(svn_repos_t *repos,
+                             apr_hash_t *hooks_env,
+                             svn_revnum_t rev,
+                             const char *txn_name,
+                             apr_pool_t *pool)
+{
+  if (post_commit_is_async(hooks_env))
+    {
+      SVN_ERR(enqueue_post_commit(repos, rev, txn_name, pool));
+      return svn_error_trace(process_hook_queue(repos, hooks_env, pool));
+    }
+
+  return svn_error_trace(run_post_commit(repos, hooks_env, rev, txn_name,
+                                         pool));
+}
+
+
 svn_error_t  *
 svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
                                     apr_hash_t *hooks_env,
@@ -743,8 +1358,18 @@ svn_repos__hooks_pre_lock(svn_repos_t *repos,
                           apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_lock_hook(repos, pool);
+  const svn_repos_hook_plugin_t *plugin;
+  const char *plugin_token = NULL;
   svn_boolean_t broken_link;
 
+  SVN_ERR(get_hook_plugin(&plugin, repos, hooks_env,
+                          SVN_REPOS__HOOK_PRE_LOCK, pool));
+  if (plugin && plugin->pre_lock)
+    SVN_ERR(plugin_hook_error(plugin->pre_lock(&plugin_token, repos, path,
+                                               username, comment, steal_lock,
+                                               plugin->baton, pool, pool),
+                              SVN_REPOS__HOOK_PRE_LOCK));
+
   if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
@@ -766,13 +1391,14 @@ svn_repos__hooks_pre_lock(svn_repos_t *repos,
       SVN_ERR(run_hook_cmd(&buf, SVN_REPOS__HOOK_PRE_LOCK, hook, args,
                            hooks_env, NULL, pool));
 
+      /* No validation here; the FS will take care of that.  A token
+         printed by the script takes precedence over the plugin's. */
       if (token)
-        /* No validation here; the FS will take care of that. */
-        *token = buf->data;
+        *token = (buf->len || !plugin_token) ? buf->data : plugin_token;
 
     }
   else if (token)
-    *token = "";
+    *token = plugin_token ? plugin_token : "";
 
   return SVN_NO_ERROR;
 }
@@ -26,10 +26,13 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_time.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
+#include "private/svn_trace.h"
 #include "private/svn_utf_private.h"
 #include "svn_private_config.h" /* for SVN_TEMPLATE_ROOT_DIR */
 
@@ -91,17 +94,92 @@ svn_repos_stat(svn_dirent_t **dirent,
   return SVN_NO_ERROR;
 }
 
-/* Return TRUE of DIRNAME matches any of the const char * in PATTERNS.
- * Note that any DIRNAME will match if PATTERNS is empty.
- * Use SCRATCH_BUFFER for temporary string contents. */
+/* The search patterns of a listing, prepared for quick matching. */
+typedef struct list_filter_t
+{
+  /* Patterns without any wildcards.  Maps them to themselves. */
+  apr_hash_t *literals;
+
+  /* All other patterns as const char *. */
+  apr_array_header_t *globs;
+} list_filter_t;
+
+/* Return a filter for the const char * glob PATTERNS, allocated in
+ * RESULT_POOL.  Return NULL if the filter would let every name pass,
+ * i.e. if PATTERNS is NULL or contains a plain "*".
+ */
+static list_filter_t *
+compile_filter(const apr_array_header_t *patterns,
+               apr_pool_t *result_pool)
+{
+  list_filter_t *filter;
+  int i;
+
+  if (!patterns)
+    return NULL;
+
+  filter = apr_pcalloc(result_pool, sizeof(*filter));
+  filter->literals = apr_hash_make(result_pool);
+  filter->globs = apr_array_make(result_pool, patterns->nelts,
+                                 sizeof(const char *));
+
+  for (i = 0; i < patterns->nelts; ++i)
+    {
+      const char *pattern = APR_ARRAY_IDX(patterns, i, const char *);
+
+      if (strcmp(pattern, "*") == 0)
+        return NULL;
+
+      /* Without wildcards, apr_fnmatch() degenerates to strcmp(). */
+      if (strpbrk(pattern, "*?[\\") == NULL)
+        svn_hash_sets(filter->literals, pattern, pattern);
+      else
+        APR_ARRAY_PUSH(filter->globs, const char *) = pattern;
+    }
+
+  return filter;
+}
+
+/* Return TRUE of DIRNAME matches any of the patterns in FILTER.
+ * Note that any DIRNAME will match if FILTER is NULL.
+ * Use SCRATCH_BUFFER for temporary string contents.
+ *
+ * This is equivalent to svn_utf__fuzzy_glob_match() but normalizes
+ * DIRNAME only once for all patterns and does not call apr_fnmatch()
+ * for patterns without wildcards. */
 static svn_boolean_t
 matches_any(const char *dirname,
-            const apr_array_header_t *patterns,
+            const list_filter_t *filter,
             svn_membuf_t *scratch_buffer)
 {
-  return patterns
-       ? svn_utf__fuzzy_glob_match(dirname, patterns, scratch_buffer)
-       : TRUE;
+  const char *normalized;
+  svn_error_t *err;
+  int i;
+
+  if (!filter)
+    return TRUE;
+
+  /* If normalization should fail for some reason, consider DIRNAME a
+   * mismatch. */
+  err = svn_utf__xfrm(&normalized, dirname, strlen(dirname), TRUE, TRUE,
+                      scratch_buffer);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  if (svn_hash_gets(filter->literals, normalized))
+    return TRUE;
+
+  for (i = 0; i < filter->globs->nelts; ++i)
+    {
+      const char *pattern = APR_ARRAY_IDX(filter->globs, i, const char *);
+      if (apr_fnmatch(pattern, normalized, 0) == APR_SUCCESS)
+        return TRUE;
+    }
+
+  return FALSE;
 }
 
 /* Utility to prevent code duplication.
@@ -156,7 +234,57 @@ compare_filtered_dirent(const void *lhs,
   return strcmp(lhs_dirent->dirent->name, rhs_dirent->dirent->name);
 }
 
-/* Core of svn_repos_list with the same parameter list.
+/* Set *SORTED to the entries of directory PATH under ROOT that may need
+ * to be reported or recursed into, as filtered_dirent_t sorted by name.
+ * Filter by DEPTH and FILTER.  Use SCRATCH_BUFFER for temporary string
+ * contents and allocate the result in RESULT_POOL.
+ *
+ * Performance trade-off:
+ * Constructing a full path vs. faster sort due to authz filtering.
+ * We filter according to DEPTH and FILTER only because constructing
+ * the full path required for authz is somewhat expensive and we don't
+ * want to do this twice while authz will rarely filter paths out.
+ */
+static svn_error_t *
+get_filtered_entries(apr_array_header_t **sorted,
+                     svn_fs_root_t *root,
+                     const char *path,
+                     const list_filter_t *filter,
+                     svn_depth_t depth,
+                     svn_membuf_t *scratch_buffer,
+                     apr_pool_t *result_pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, result_pool));
+  *sorted = apr_array_make(result_pool, apr_hash_count(entries),
+                           sizeof(filtered_dirent_t));
+  for (hi = apr_hash_first(result_pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      filtered_dirent_t filtered;
+      filtered.dirent = apr_hash_this_val(hi);
+
+      /* Skip directories if we want to report files only. */
+      if (filtered.dirent->kind == svn_node_dir && depth == svn_depth_files)
+        continue;
+
+      /* We can skip files that don't match any of the search patterns. */
+      filtered.is_match = matches_any(filtered.dirent->name, filter,
+                                      scratch_buffer);
+      if (!filtered.is_match && filtered.dirent->kind == svn_node_file)
+        continue;
+
+      APR_ARRAY_PUSH(*sorted, filtered_dirent_t) = filtered;
+    }
+
+  svn_sort__array(*sorted, compare_filtered_dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of svn_repos_list with the same parameter list, except that the
+ * patterns are given as FILTER.
  *
  * However, DEPTH is not svn_depth_empty and PATH has already been reported.
  * Therefore, we can call this recursively.
@@ -166,7 +294,7 @@ compare_filtered_dirent(const void *lhs,
 static svn_error_t *
 do_list(svn_fs_root_t *root,
         const char *path,
-        const apr_array_header_t *patterns,
+        const list_filter_t *filter,
         svn_depth_t depth,
         svn_boolean_t path_info_only,
         svn_repos_authz_func_t authz_read_func,
@@ -178,44 +306,13 @@ do_list(svn_fs_root_t *root,
         svn_membuf_t *scratch_buffer,
         apr_pool_t *scratch_pool)
 {
-  apr_hash_t *entries;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_hash_index_t *hi;
   apr_array_header_t *sorted;
   int i;
 
-  /* Fetch all directory entries, filter and sort them.
-   *
-   * Performance trade-off:
-   * Constructing a full path vs. faster sort due to authz filtering.
-   * We filter according to DEPTH and PATTERNS only because constructing
-   * the full path required for authz is somewhat expensive and we don't
-   * want to do this twice while authz will rarely filter paths out.
-   */
-  SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
-  sorted = apr_array_make(scratch_pool, apr_hash_count(entries),
-                          sizeof(filtered_dirent_t));
-  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
-    {
-      filtered_dirent_t filtered;
-      svn_pool_clear(iterpool);
-
-      filtered.dirent = apr_hash_this_val(hi);
-
-      /* Skip directories if we want to report files only. */
-      if (filtered.dirent->kind == svn_node_dir && depth == svn_depth_files)
-        continue;
-
-      /* We can skip files that don't match any of the search patterns. */
-      filtered.is_match = matches_any(filtered.dirent->name, patterns,
-                                      scratch_buffer);
-      if (!filtered.is_match && filtered.dirent->kind == svn_node_file)
-        continue;
-
-      APR_ARRAY_PUSH(sorted, filtered_dirent_t) = filtered;
-    }
-
-  svn_sort__array(sorted, compare_filtered_dirent);
+  /* Fetch all directory entries, filter and sort them. */
+  SVN_ERR(get_filtered_entries(&sorted, root, path, filter, depth,
+                               scratch_buffer, scratch_pool));
 
   /* Iterate over all remaining directory entries and report them.
    * Recurse into sub-directories if requested. */
@@ -253,7 +350,7 @@ do_list(svn_fs_root_t *root,
 
       /* Recurse on directories. */
       if (depth == svn_depth_infinity && dirent->kind == svn_node_dir)
-        SVN_ERR(do_list(root, sub_path, patterns, svn_depth_infinity,
+        SVN_ERR(do_list(root, sub_path, filter, svn_depth_infinity,
                         path_info_only, authz_read_func, authz_read_baton,
                         receiver, receiver_baton, cancel_func,
                         cancel_baton, scratch_buffer, iterpool));
@@ -264,21 +361,359 @@ do_list(svn_fs_root_t *root,
   return SVN_NO_ERROR;
 }
 
+/* An entry found by a task. */
+typedef struct list_entry_t
+{
+  /* Full path of the entry. */
+  const char *path;
+
+  /* The details to report.  NULL if the entry did not match the filter
+     and only needs to be checked for authz. */
+  svn_dirent_t *dirent;
+} list_entry_t;
+
+/* State of a listing that walks multiple sub-trees concurrently. */
+typedef struct parallel_list_baton_t
+{
+  /* Instances of the repository for the tasks.  They must not use the
+     caller's svn_fs_t as the FS API objects are not thread-safe. */
+  svn_repos__fs_pool_t *fs_pool;
+
+  /* Parameters to pass to do_list().  REVISION selects the root. */
+  svn_revnum_t revision;
+  const list_filter_t *filter;
+  svn_boolean_t path_info_only;
+
+  /* The caller's root and callbacks.  Only used by the main thread when
+     reporting the results. */
+  svn_fs_root_t *root;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  svn_repos_dirent_receiver_t receiver;
+  void *receiver_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} parallel_list_baton_t;
+
+/* A directory entry directly below the listing root that the caller
+   has access to.  Directories get their sub-trees listed by a task. */
+typedef struct list_task_t
+{
+  parallel_list_baton_t *plb;
+
+  /* Path and kind of the entry and whether it passed the filter. */
+  const char *path;
+  svn_node_kind_t kind;
+  svn_boolean_t is_match;
+
+  /* Whether the entry itself still needs to be reported when reporting
+     the contents of its sub-tree. */
+  svn_boolean_t report_self;
+} list_task_t;
+
+/* Result of a list_task_t. */
+typedef struct list_result_t
+{
+  /* The task that produced this result. */
+  const list_task_t *task;
+
+  /* The result pool of the task. */
+  apr_pool_t *pool;
+
+  /* All list_entry_t that do_list() would check for authz, in the same
+     order. */
+  apr_array_header_t *entries;
+} list_result_t;
+
+/* Implements svn_repos_authz_func_t for the tasks.  Record PATH in the
+   list_result_t BATON and grant access.  The actual authz check is done
+   later, in the main thread. */
+static svn_error_t *
+record_entry(svn_boolean_t *allowed,
+             svn_fs_root_t *root,
+             const char *path,
+             void *baton,
+             apr_pool_t *pool)
+{
+  list_result_t *result = baton;
+  list_entry_t *entry = apr_array_push(result->entries);
+
+  entry->path = apr_pstrdup(result->pool, path);
+  entry->dirent = NULL;
+  *allowed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_dirent_receiver_t for the tasks.  Attach a copy
+   of DIRENT to the entry for PATH recorded last in the list_result_t
+   BATON. */
+static svn_error_t *
+record_dirent(const char *path,
+              svn_dirent_t *dirent,
+              void *baton,
+              apr_pool_t *scratch_pool)
+{
+  list_result_t *result = baton;
+  list_entry_t *entry;
+
+  /* do_list() always checks authz right before reporting. */
+  SVN_ERR_ASSERT(result->entries->nelts > 0);
+  entry = &APR_ARRAY_IDX(result->entries, result->entries->nelts - 1,
+                         list_entry_t);
+  SVN_ERR_ASSERT(strcmp(entry->path, path) == 0);
+
+  entry->dirent = svn_dirent_dup(dirent, result->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  List the sub-tree of the
+   list_task_t in PROCESS_BATON and return a list_result_t in *RESULT. */
+static svn_error_t *
+list_task(void **result,
+          void *process_baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  const list_task_t *task = process_baton;
+  parallel_list_baton_t *plb = task->plb;
+  list_result_t *list_result = apr_pcalloc(result_pool,
+                                           sizeof(*list_result));
+  svn_membuf_t scratch_buffer;
+  svn_fs_root_t *root;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  list_result->task = task;
+  list_result->pool = result_pool;
+  list_result->entries = apr_array_make(result_pool, 16,
+                                        sizeof(list_entry_t));
+
+  if (task->kind == svn_node_dir)
+    {
+      /* The root references FS, so it must be gone before we hand FS
+         to the next task. */
+      apr_pool_t *root_pool = svn_pool_create(scratch_pool);
+
+      svn_membuf__create(&scratch_buffer, 256, scratch_pool);
+      SVN_ERR(svn_repos__fs_pool_acquire(&fs, plb->fs_pool));
+
+      err = svn_fs_revision_root(&root, fs, plb->revision, root_pool);
+      if (!err)
+        err = do_list(root, task->path, plb->filter, svn_depth_infinity,
+                      plb->path_info_only, record_entry, list_result,
+                      record_dirent, list_result, cancel_func, cancel_baton,
+                      &scratch_buffer, root_pool);
+
+      svn_pool_destroy(root_pool);
+      SVN_ERR(svn_error_compose_create(
+                err, svn_repos__fs_pool_release(plb->fs_pool, fs)));
+    }
+
+  *result = list_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Report the list_result_t in
+   RESULT as do_list() would have done, using the callbacks in the
+   parallel_list_baton_t OUTPUT_BATON. */
+static svn_error_t *
+report_list_result(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  list_result_t *list_result = result;
+  const list_task_t *task = list_result->task;
+  parallel_list_baton_t *plb = output_baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *denied = NULL;
+  int i;
+
+  if (task->report_self && task->is_match)
+    SVN_ERR(report_dirent(plb->root, task->path, task->kind,
+                          plb->path_info_only, plb->receiver,
+                          plb->receiver_baton, scratch_pool));
+
+  if (plb->cancel_func)
+    SVN_ERR(plb->cancel_func(plb->cancel_baton));
+
+  for (i = 0; i < list_result->entries->nelts; ++i)
+    {
+      list_entry_t *entry = &APR_ARRAY_IDX(list_result->entries, i,
+                                           list_entry_t);
+      svn_pool_clear(iterpool);
+
+      /* The entries come in depth-first order.  Skip everything below a
+       * directory that we don't have access to. */
+      if (denied && svn_dirent_skip_ancestor(denied, entry->path))
+        continue;
+
+      denied = NULL;
+      if (plb->authz_read_func)
+        {
+          svn_boolean_t has_access;
+          SVN_ERR(plb->authz_read_func(&has_access, plb->root, entry->path,
+                                       plb->authz_read_baton, iterpool));
+          if (!has_access)
+            {
+              denied = entry->path;
+              continue;
+            }
+        }
+
+      if (entry->dirent)
+        SVN_ERR(plb->receiver(entry->path, entry->dirent,
+                              plb->receiver_baton, iterpool));
+
+      if (plb->cancel_func)
+        SVN_ERR(plb->cancel_func(plb->cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like do_list() for DEPTH being svn_depth_infinity but list the
+ * sub-trees of the directories immediately below PATH concurrently,
+ * using up to JOBS threads.  ROOT must be a revision root.
+ *
+ * The receiver and authz callbacks will only be called from the current
+ * thread.  If ORDERED is set, entries will be reported in the same order
+ * as do_list() does.  Otherwise, the entries directly below PATH come
+ * first, followed by the contents of each sub-directory.
+ */
+static svn_error_t *
+do_list_parallel(svn_fs_root_t *root,
+                 const char *path,
+                 const list_filter_t *filter,
+                 svn_boolean_t path_info_only,
+                 svn_repos_authz_func_t authz_read_func,
+                 void *authz_read_baton,
+                 svn_repos_dirent_receiver_t receiver,
+                 void *receiver_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 int jobs,
+                 svn_boolean_t ordered,
+                 svn_membuf_t *scratch_buffer,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  parallel_list_baton_t *plb = apr_pcalloc(scratch_pool, sizeof(*plb));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted;
+  apr_array_header_t *top;
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+  int i;
+
+  /* The first level is quick to do here and allows us to hand out the
+   * sub-trees of authorized directories only. */
+  SVN_ERR(get_filtered_entries(&sorted, root, path, filter,
+                               svn_depth_infinity, scratch_buffer,
+                               scratch_pool));
+  top = apr_array_make(scratch_pool, sorted->nelts, sizeof(list_task_t));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      filtered_dirent_t *filtered = &APR_ARRAY_IDX(sorted, i,
+                                                   filtered_dirent_t);
+      list_task_t *task;
+      const char *sub_path;
+
+      svn_pool_clear(iterpool);
+
+      sub_path = svn_dirent_join(path, filtered->dirent->name, scratch_pool);
+      if (authz_read_func)
+        {
+          svn_boolean_t has_access;
+          SVN_ERR(authz_read_func(&has_access, root, sub_path,
+                                  authz_read_baton, iterpool));
+          if (!has_access)
+            continue;
+        }
+
+      task = apr_array_push(top);
+      task->plb = plb;
+      task->path = sub_path;
+      task->kind = filtered->dirent->kind;
+      task->is_match = filtered->is_match;
+      task->report_self = ordered;
+    }
+
+  /* Without a fixed order, report the first level right away. */
+  if (!ordered)
+    for (i = 0; i < top->nelts; ++i)
+      {
+        list_task_t *task = &APR_ARRAY_IDX(top, i, list_task_t);
+
+        svn_pool_clear(iterpool);
+        if (task->is_match)
+          SVN_ERR(report_dirent(root, task->path, task->kind,
+                                path_info_only, receiver, receiver_baton,
+                                iterpool));
+
+        if (cancel_func)
+          SVN_ERR(cancel_func(cancel_baton));
+      }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_repos__fs_pool_create(&plb->fs_pool, fs, scratch_pool));
+
+  plb->revision = svn_fs_revision_root_revision(root);
+  plb->filter = filter;
+  plb->path_info_only = path_info_only;
+  plb->root = root;
+  plb->authz_read_func = authz_read_func;
+  plb->authz_read_baton = authz_read_baton;
+  plb->receiver = receiver;
+  plb->receiver_baton = receiver_baton;
+  plb->cancel_func = cancel_func;
+  plb->cancel_baton = cancel_baton;
+
+  /* Sub-pools get destroyed before the cleanups of their parent run, so
+     the task set will be gone before the FS instances. */
+  set_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, report_list_result, plb,
+                               cancel_func, cancel_baton, set_pool));
+
+  for (i = 0; i < top->nelts; ++i)
+    {
+      list_task_t *task = &APR_ARRAY_IDX(top, i, list_task_t);
+
+      /* Entries that are neither reported nor listed need no task. */
+      if (task->report_self || task->kind == svn_node_dir)
+        SVN_ERR(svn_task__add(set, list_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
-svn_repos_list(svn_fs_root_t *root,
-               const char *path,
-               const apr_array_header_t *patterns,
-               svn_depth_t depth,
-               svn_boolean_t path_info_only,
-               svn_repos_authz_func_t authz_read_func,
-               void *authz_read_baton,
-               svn_repos_dirent_receiver_t receiver,
-               void *receiver_baton,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *scratch_pool)
+svn_repos__list(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                svn_boolean_t path_info_only,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                int jobs,
+                svn_boolean_t ordered,
+                apr_pool_t *scratch_pool)
 {
   svn_membuf_t scratch_buffer;
+  list_filter_t *filter;
 
   /* Parameter check. */
   svn_node_kind_t kind;
@@ -320,19 +755,58 @@ svn_repos_list(svn_fs_root_t *root,
   /* We need a scratch buffer for temporary string data.
    * Create one with a reasonable initial size. */
   svn_membuf__create(&scratch_buffer, 256, scratch_pool);
+  filter = compile_filter(patterns, scratch_pool);
 
   /* Actually report PATH, if it passes the filters. */
-  if (matches_any(svn_dirent_dirname(path, scratch_pool), patterns,
+  if (matches_any(svn_dirent_dirname(path, scratch_pool), filter,
                   &scratch_buffer))
     SVN_ERR(report_dirent(root, path, kind, path_info_only,
                           receiver, receiver_baton, scratch_pool));
 
   /* Report directory contents if requested. */
+  if (   depth == svn_depth_infinity && jobs > 1
+      && svn_fs_is_revision_root(root))
+    return svn_error_trace(do_list_parallel(root, path, filter,
+                                            path_info_only,
+                                            authz_read_func,
+                                            authz_read_baton,
+                                            receiver, receiver_baton,
+                                            cancel_func, cancel_baton,
+                                            jobs, ordered, &scratch_buffer,
+                                            scratch_pool));
+
   if (depth > svn_depth_empty)
-    SVN_ERR(do_list(root, path, patterns, depth,
+    SVN_ERR(do_list(root, path, filter, depth,
                     path_info_only, authz_read_func, authz_read_baton,
                     receiver, receiver_baton, cancel_func, cancel_baton,
                     &scratch_buffer, scratch_pool));
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_list(svn_fs_root_t *root,
+               const char *path,
+               const apr_array_header_t *patterns,
+               svn_depth_t depth,
+               svn_boolean_t path_info_only,
+               svn_repos_authz_func_t authz_read_func,
+               void *authz_read_baton,
+               svn_repos_dirent_receiver_t receiver,
+               void *receiver_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  svn_trace__span_t *span = svn_trace__begin("repos.list");
+  svn_trace__attr(span, "path", path);
+
+  return svn_error_trace(
+           svn_trace__end(span,
+                          svn_repos__list(root, path, patterns, depth,
+                                          path_info_only, authz_read_func,
+                                          authz_read_baton, receiver,
+                                          receiver_baton, cancel_func,
+                                          cancel_baton, 1, TRUE,
+                                          scratch_pool)));
+}
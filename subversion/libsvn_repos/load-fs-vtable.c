@@ -37,11 +37,15 @@
 #include "svn_dirent_uri.h"
 
 #include <apr_lib.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "private/svn_fspath.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_fs_private.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -86,6 +90,18 @@ struct parse_baton
   /* The oldest revision loaded from the dump stream.  If no revisions
      have been loaded yet, this is set to SVN_INVALID_REVNUM. */
   svn_revnum_t oldest_dumpstream_rev;
+
+  /* Bulk loads only (see svn_repos__load_fs_bulk()): Make the commits
+     durable after every BATCH_REVS revisions, UNSYNCED_REVS of which
+     have been loaded since the last time.  SYNC_DEFERRED is set if the
+     FS supports deferring its flushes.  LAST_LOADED_REV is the latest
+     revision from the dump stream that has been loaded.  If not NULL,
+     record it in the file at CHECKPOINT_PATH at every durability point. */
+  int batch_revs;
+  int unsynced_revs;
+  svn_boolean_t sync_deferred;
+  svn_revnum_t last_loaded_rev;
+  const char *checkpoint_path;
 };
 
 struct revision_baton
@@ -462,10 +478,12 @@ make_revision_baton(apr_hash_t *headers,
     {
       rb->rev = SVN_STR_TO_REV(val);
 
-      /* If we're filtering revisions, is this one we'll skip? */
+      /* If we're filtering revisions, is this one we'll skip?  Bulk
+         loads may resume with an open-ended range. */
       rb->skipped = (SVN_IS_VALID_REVNUM(pb->start_rev)
                      && ((rb->rev < pb->start_rev) ||
-                         (rb->rev > pb->end_rev)));
+                         (SVN_IS_VALID_REVNUM(pb->end_rev)
+                          && rb->rev > pb->end_rev)));
     }
 
   return rb;
@@ -1265,6 +1283,453 @@ svn_repos_load_fs5(svn_repos_t *repos,
                                      cancel_func, cancel_baton, pool);
 }
 
+/*----------------------------------------------------------------------*/
+
+/** Bulk loading **/
+
+#if APR_HAS_THREADS
+
+/* Size of the chunks that the read-ahead thread reads at once and the
+   number of chunks it may read ahead of the parser. */
+#define READ_AHEAD_CHUNK_SIZE (4 * SVN__STREAM_CHUNK_SIZE)
+#define READ_AHEAD_CHUNKS 16
+
+/* A chunk of data read ahead from the source stream. */
+typedef struct read_ahead_chunk_t
+{
+  char data[READ_AHEAD_CHUNK_SIZE];
+  apr_size_t len;
+} read_ahead_chunk_t;
+
+/* Baton for the read-ahead stream.  A separate thread reads the source
+   stream into a ring of chunks while the parser consumes them, so that
+   reading (and decompressing) the dump overlaps with building and
+   committing the transactions. */
+typedef struct read_ahead_baton_t
+{
+  /* The stream to read from.  Only accessed by the read-ahead thread
+     while it is running. */
+  svn_stream_t *source;
+
+  /* Ring buffer of READ_AHEAD_CHUNKS chunks.  Chunk number N lives at
+     index N % READ_AHEAD_CHUNKS. */
+  read_ahead_chunk_t *chunks;
+
+  /* Number of chunks filled by the reader and released by the parser,
+     respectively.  Protected by MUTEX, like all of the following. */
+  apr_size_t filled;
+  apr_size_t consumed;
+
+  /* Set by the reader once it hit EOF or an error.  ERR is the latter
+     and will be returned by the parser's next read. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Set when the stream gets closed before the source has been read
+     completely. */
+  svn_boolean_t shutdown;
+
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+
+  /* The pool that the thread's cleanup is registered with. */
+  apr_pool_t *pool;
+
+  /* The chunk currently being consumed by the parser and the read
+     position within it.  Only accessed by the parser. */
+  read_ahead_chunk_t *current;
+  apr_size_t pos;
+} read_ahead_baton_t;
+
+/* Thread function of the read-ahead stream with read_ahead_baton_t DATA.
+ */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *thread,
+                  void *data)
+{
+  read_ahead_baton_t *rab = data;
+  svn_boolean_t done = FALSE;
+
+  while (!done)
+    {
+      read_ahead_chunk_t *chunk;
+      svn_error_t *err;
+      apr_size_t len = READ_AHEAD_CHUNK_SIZE;
+
+      /* Wait for a free chunk. */
+      apr_thread_mutex_lock(rab->mutex);
+      while (!rab->shutdown
+             && rab->filled - rab->consumed == READ_AHEAD_CHUNKS)
+        apr_thread_cond_wait(rab->cond, rab->mutex);
+      done = rab->shutdown;
+      apr_thread_mutex_unlock(rab->mutex);
+
+      if (done)
+        break;
+
+      chunk = &rab->chunks[rab->filled % READ_AHEAD_CHUNKS];
+      err = svn_stream_read_full(rab->source, chunk->data, &len);
+
+      apr_thread_mutex_lock(rab->mutex);
+      if (err)
+        {
+          rab->err = err;
+          done = TRUE;
+        }
+      else
+        {
+          /* A short read means EOF. */
+          chunk->len = len;
+          rab->filled++;
+          done = len < READ_AHEAD_CHUNK_SIZE;
+        }
+      rab->done = done;
+      apr_thread_cond_broadcast(rab->cond);
+      apr_thread_mutex_unlock(rab->mutex);
+    }
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Implements svn_read_fn_t for the read-ahead stream. */
+static svn_error_t *
+read_ahead_read(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  read_ahead_baton_t *rab = baton;
+  apr_size_t total = 0;
+
+  while (total < *len)
+    {
+      apr_size_t to_copy;
+
+      if (!rab->current || rab->pos == rab->current->len)
+        {
+          svn_error_t *err = SVN_NO_ERROR;
+
+          apr_thread_mutex_lock(rab->mutex);
+
+          /* Hand the exhausted chunk back to the reader. */
+          if (rab->current)
+            {
+              rab->consumed++;
+              rab->current = NULL;
+              apr_thread_cond_broadcast(rab->cond);
+            }
+
+          while (rab->consumed == rab->filled && !rab->done)
+            apr_thread_cond_wait(rab->cond, rab->mutex);
+
+          if (rab->consumed < rab->filled)
+            {
+              rab->current = &rab->chunks[rab->consumed % READ_AHEAD_CHUNKS];
+              rab->pos = 0;
+            }
+          else
+            {
+              err = rab->err;
+              rab->err = SVN_NO_ERROR;
+            }
+
+          apr_thread_mutex_unlock(rab->mutex);
+
+          SVN_ERR(err);
+
+          /* EOF */
+          if (!rab->current)
+            break;
+
+          continue;
+        }
+
+      to_copy = MIN(*len - total, rab->current->len - rab->pos);
+      memcpy(buffer + total, rab->current->data + rab->pos, to_copy);
+      rab->pos += to_copy;
+      total += to_copy;
+    }
+
+  *len = total;
+  return SVN_NO_ERROR;
+}
+
+/* Stop the read-ahead thread of read_ahead_baton_t DATA, if still
+   running, and release all resources but the source stream. */
+static apr_status_t
+read_ahead_cleanup(void *data)
+{
+  read_ahead_baton_t *rab = data;
+  apr_status_t status;
+
+  apr_thread_mutex_lock(rab->mutex);
+  rab->shutdown = TRUE;
+  apr_thread_cond_broadcast(rab->cond);
+  apr_thread_mutex_unlock(rab->mutex);
+
+  apr_thread_join(&status, rab->thread);
+  svn_error_clear(rab->err);
+  rab->err = SVN_NO_ERROR;
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_close_fn_t for the read-ahead stream. */
+static svn_error_t *
+read_ahead_close(void *baton)
+{
+  read_ahead_baton_t *rab = baton;
+
+  apr_pool_cleanup_run(rab->pool, rab, read_ahead_cleanup);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *STREAM to a stream, allocated in RESULT_POOL, that returns the
+   contents of SOURCE, read ahead by a separate thread.  Closing *STREAM
+   stops the thread but leaves SOURCE open.  If the thread cannot be
+   started, return SOURCE itself. */
+static svn_error_t *
+read_ahead_stream_create(svn_stream_t **stream,
+                         svn_stream_t *source,
+                         apr_pool_t *result_pool)
+{
+  read_ahead_baton_t *rab = apr_pcalloc(result_pool, sizeof(*rab));
+  apr_status_t status;
+
+  rab->source = source;
+  rab->pool = result_pool;
+  rab->chunks = apr_palloc(result_pool,
+                           READ_AHEAD_CHUNKS * sizeof(*rab->chunks));
+
+  status = apr_thread_mutex_create(&rab->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   result_pool);
+  if (!status)
+    status = apr_thread_cond_create(&rab->cond, result_pool);
+  if (!status)
+    status = apr_thread_create(&rab->thread, NULL, read_ahead_thread, rab,
+                               result_pool);
+  if (status)
+    {
+      /* Degrade gracefully to synchronous reading. */
+      *stream = source;
+      return SVN_NO_ERROR;
+    }
+
+  apr_pool_cleanup_register(result_pool, rab, read_ahead_cleanup,
+                            apr_pool_cleanup_null);
+
+  *stream = svn_stream_create(rab, result_pool);
+  svn_stream_set_read2(*stream, NULL /* only full read support */,
+                       read_ahead_read);
+  svn_stream_set_close(*stream, read_ahead_close);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Make all revisions loaded through PB so far durable and, if enabled,
+   record the progress in PB's checkpoint file.  If DEFER is not set,
+   return the filesystem to its normal flushing behavior.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bulk_load_sync(struct parse_baton *pb,
+               svn_boolean_t defer,
+               apr_pool_t *scratch_pool)
+{
+  if (pb->sync_deferred)
+    {
+      SVN_ERR(svn_fs__sync(pb->fs, defer, scratch_pool));
+      pb->sync_deferred = defer;
+    }
+
+  pb->unsynced_revs = 0;
+
+  if (pb->checkpoint_path && SVN_IS_VALID_REVNUM(pb->last_loaded_rev))
+    {
+      svn_revnum_t youngest;
+      const char *contents;
+
+      SVN_ERR(svn_fs_youngest_rev(&youngest, pb->fs, scratch_pool));
+      contents = apr_psprintf(scratch_pool, "%ld %ld\n",
+                              pb->last_loaded_rev, youngest);
+      SVN_ERR(svn_io_write_atomic2(pb->checkpoint_path, contents,
+                                   strlen(contents), NULL, TRUE,
+                                   scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos_parse_fns3_t.close_revision for bulk loads.
+ *
+ * Commit the revision like close_revision() does and, at the end of
+ * each batch, make all commits of that batch durable at once. */
+static svn_error_t *
+bulk_close_revision(void *baton)
+{
+  struct revision_baton *rb = baton;
+  struct parse_baton *pb = rb->pb;
+
+  SVN_ERR(close_revision(baton));
+  if (rb->skipped)
+    return SVN_NO_ERROR;
+
+  pb->last_loaded_rev = rb->rev;
+  if (++pb->unsynced_revs >= pb->batch_revs)
+    SVN_ERR(bulk_load_sync(pb, TRUE, rb->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the checkpoint file at PATH as written by bulk_load_sync() and
+   return the last dump stream revision recorded in it in *DUMP_REV and
+   the corresponding youngest revision of the repository in *REPOS_REV.
+   If there is no such file, set both to SVN_INVALID_REVNUM.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_load_checkpoint(svn_revnum_t *dump_rev,
+                     svn_revnum_t *repos_rev,
+                     const char *path,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  const char *p;
+  svn_error_t *err;
+
+  *dump_rev = SVN_INVALID_REVNUM;
+  *repos_rev = SVN_INVALID_REVNUM;
+
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  err = svn_revnum_parse(dump_rev, contents->data, &p);
+  if (!err && *p == ' ')
+    err = svn_revnum_parse(repos_rev, p + 1, &p);
+  if (err || *p != '\n')
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, err,
+                             _("Invalid checkpoint file '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__load_fs_bulk(svn_repos_t *repos,
+                        svn_stream_t *dumpstream,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        enum svn_repos_load_uuid uuid_action,
+                        const char *parent_dir,
+                        svn_boolean_t use_pre_commit_hook,
+                        svn_boolean_t use_post_commit_hook,
+                        svn_boolean_t validate_props,
+                        svn_boolean_t ignore_dates,
+                        int batch_revs,
+                        const char *checkpoint_path,
+                        svn_repos_notify_func_t notify_func,
+                        void *notify_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *pool)
+{
+  const svn_repos_parse_fns3_t *fs_parser;
+  svn_repos_parse_fns3_t *parser;
+  void *parse_baton;
+  struct parse_baton *pb;
+  svn_stream_t *stream = dumpstream;
+  svn_revnum_t checkpoint_rev = SVN_INVALID_REVNUM;
+  svn_error_t *err;
+
+  /* Resume after the last durable revision of a previous run.  Anything
+     that got committed after that may not have made it to disk. */
+  if (checkpoint_path)
+    {
+      svn_revnum_t repos_rev;
+      svn_revnum_t youngest;
+
+      SVN_ERR(read_load_checkpoint(&checkpoint_rev, &repos_rev,
+                                   checkpoint_path, pool));
+      SVN_ERR(svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), pool));
+      if (SVN_IS_VALID_REVNUM(checkpoint_rev) && youngest != repos_rev)
+        return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                                 _("The repository is at r%ld but the "
+                                   "checkpoint '%s' has been taken at r%ld; "
+                                   "revisions after the checkpoint may be "
+                                   "incomplete"),
+                                 youngest,
+                                 svn_dirent_local_style(checkpoint_path,
+                                                        pool),
+                                 repos_rev);
+    }
+
+  SVN_ERR(svn_repos_get_fs_build_parser5(&fs_parser, &parse_baton,
+                                         repos,
+                                         start_rev, end_rev,
+                                         TRUE, /* look for copyfrom revs */
+                                         validate_props,
+                                         uuid_action,
+                                         parent_dir,
+                                         use_pre_commit_hook,
+                                         use_post_commit_hook,
+                                         ignore_dates,
+                                         notify_func,
+                                         notify_baton,
+                                         pool));
+
+  pb = parse_baton;
+  pb->batch_revs = MAX(1, batch_revs);
+  pb->checkpoint_path = checkpoint_path;
+  pb->last_loaded_rev = SVN_INVALID_REVNUM;
+
+  /* Skip everything up to and including the checkpoint.  Without an
+     explicit range, there is no upper limit. */
+  if (   SVN_IS_VALID_REVNUM(checkpoint_rev)
+      && (   !SVN_IS_VALID_REVNUM(pb->start_rev)
+          || pb->start_rev <= checkpoint_rev))
+    pb->start_rev = checkpoint_rev + 1;
+
+  parser = apr_pmemdup(pool, fs_parser, sizeof(*parser));
+  parser->close_revision = bulk_close_revision;
+
+  /* Let the filesystem skip the flushes of individual commits.  Backends
+     that don't support that will simply make every commit durable. */
+  err = svn_fs__sync(pb->fs, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      pb->sync_deferred = FALSE;
+    }
+  else
+    {
+      SVN_ERR(err);
+      pb->sync_deferred = TRUE;
+    }
+
+#if APR_HAS_THREADS
+  SVN_ERR(read_ahead_stream_create(&stream, dumpstream, pool));
+#endif
+
+  err = svn_repos_parse_dumpstream3(stream, parser, parse_baton, FALSE,
+                                    cancel_func, cancel_baton, pool);
+
+  /* Stop reading ahead but leave DUMPSTREAM open, like
+     svn_repos_load_fs5() does. */
+  if (stream != dumpstream)
+    err = svn_error_compose_create(err, svn_stream_close(stream));
+
+  /* Whatever got loaded, make it durable and record the progress. */
+  return svn_error_trace(svn_error_compose_create(err,
+                                         bulk_load_sync(pb, FALSE, pool)));
+}
+
 /*----------------------------------------------------------------------*/
 
 /** The same functionality for revprops only **/
@@ -317,6 +317,30 @@ parse_text_block(svn_stream_t *stream,
       SVN_ERR(parse_fns->set_fulltext(&text_stream, record_baton));
     }
 
+  /* Without a sink for our data, we only need to get past it.  Streams
+     that support marks can seek, so we don't need to read the data at
+     all.  Read the last byte, though, to detect truncated input. */
+  if (!text_stream && content_length && svn_stream_supports_mark(stream))
+    {
+      while (content_length > 1)
+        {
+          if (content_length - 1 >= (svn_filesize_t)SVN_MAX_OBJECT_SIZE)
+            rlen = SVN_MAX_OBJECT_SIZE;
+          else
+            rlen = (apr_size_t) (content_length - 1);
+
+          SVN_ERR(svn_stream_skip(stream, rlen));
+          content_length -= rlen;
+        }
+
+      rlen = 1;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
+      if (rlen != 1)
+        return stream_ran_dry();
+
+      return SVN_NO_ERROR;
+    }
+
   /* Regardless of whether or not we have a sink for our data, we
      need to read it. */
   while (content_length)
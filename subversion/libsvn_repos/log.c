@@ -44,6 +44,8 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
+#include "private/svn_trace.h"
 
 
 /* This is a mere convenience struct such that we don't need to pass that
@@ -56,6 +58,9 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* Optional cache of per-revision mergeinfo changes. */
+  svn_repos__mergeinfo_cache_t *mergeinfo_cache;
 } log_callbacks_t;
 
 
@@ -429,8 +434,446 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If the history is being fetched by worker threads, this is the
+     prefetch state shared by all paths and HIST is NULL.  READY is the
+     batch of history locations we are currently consuming and PENDING
+     is the batch being fetched after that, either of which may be NULL.
+     See get_prefetched_history(). */
+  struct history_prefetch_t *prefetch;
+  struct history_batch_t *ready;
+  struct history_batch_t *pending;
 };
 
+/* If optional AUTHZ_READ_FUNC is non-NULL, then use it (with
+ * AUTHZ_READ_BATON and FS) to check whether INFO->PATH is readable
+ * in INFO->HISTORY_REV.  If it isn't, set INFO->DONE to TRUE.
+ */
+static svn_error_t *
+check_history_readable(struct path_info *info,
+                       svn_fs_t *fs,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *history_root;
+  svn_boolean_t readable;
+
+  if (! authz_read_func)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_revision_root(&history_root, fs, info->history_rev,
+                               scratch_pool));
+  SVN_ERR(authz_read_func(&readable, history_root, info->path->data,
+                          authz_read_baton, scratch_pool));
+  if (! readable)
+    info->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the histories concurrently if there are at least this many paths
+   to follow.  Use no more than PARALLEL_HISTORY_JOBS threads.  Only the
+   first MAX_OPEN_HISTORIES paths get prefetched. */
+#define PARALLEL_HISTORY_MIN_PATHS 4
+#define PARALLEL_HISTORY_JOBS 4
+
+/* Number of history locations a task fetches in one go. */
+#define HISTORY_BATCH_SIZE 64
+
+/* One step in the history of some path. */
+typedef struct history_location_t
+{
+  const char *path;
+  svn_revnum_t rev;
+} history_location_t;
+
+/* A batch of history locations of a single path, fetched by
+   fetch_history_task(). */
+typedef struct history_batch_t
+{
+  /* Private pool of this batch, a sub-pool of the prefetch's BATCH_POOL.
+     Only used by the main thread. */
+  apr_pool_t *pool;
+
+  /* Continue the history of PATH@REV.  If FIRST_TIME is set, the first
+     location to report is the last change at or before REV, otherwise
+     the change before that (c.f. get_history()). */
+  const char *path;
+  svn_revnum_t rev;
+  svn_boolean_t first_time;
+
+  /* The locations found, as history_location_t, youngest first.  Like
+     in get_history(), the last one may predate the START revision.
+     NULL until deliver_history_batch() received the result. */
+  apr_array_header_t *locations;
+
+  /* Set if the history continues beyond the last of the LOCATIONS. */
+  svn_boolean_t more;
+
+  /* Error looking up the location of PATH@REV, if any.  Reported when
+     the batch gets consumed. */
+  svn_error_t *err;
+
+  /* Index of the next entry in LOCATIONS to be consumed. */
+  int next;
+
+  /* The history prefetch that this batch belongs to. */
+  struct history_prefetch_t *prefetch;
+} history_batch_t;
+
+/* The result of fetch_history_task(). */
+typedef struct history_result_t
+{
+  history_batch_t *batch;
+  apr_array_header_t *locations;
+  svn_boolean_t more;
+  svn_error_t *err;
+} history_result_t;
+
+/* State of fetching the histories of multiple paths concurrently. */
+typedef struct history_prefetch_t
+{
+  /* Holds everything below. */
+  apr_pool_t *pool;
+
+  /* Parent of the batch pools.  It must outlive SET, so it is created
+     before the pool that SET lives in. */
+  apr_pool_t *batch_pool;
+
+  /* The fetch_history_task() tasks. */
+  svn_task__set_t *set;
+
+  /* Instances of the repository for the tasks.  They must not use the
+     caller's svn_fs_t as the FS API objects are not thread-safe. */
+  svn_repos__fs_pool_t *fs_pool;
+
+  /* Parameters of the history traversal, see get_history(). */
+  svn_boolean_t strict;
+  svn_revnum_t start;
+
+  /* The struct path_info * whose batches we must clean up eventually.
+     Set by get_path_histories(). */
+  apr_array_header_t *histories;
+} history_prefetch_t;
+
+/* Return TRUE if ERR indicates that a path to follow does not exist in
+   the requested revision. */
+static svn_boolean_t
+is_location_error(svn_error_t *err)
+{
+  return err
+      && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
+          err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
+          err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION);
+}
+
+/* Fill RESULT->LOCATIONS with up to HISTORY_BATCH_SIZE locations from
+   the history described by BATCH, using FS.  Allocate them in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+fetch_history_batch(history_result_t *result,
+                    const history_batch_t *batch,
+                    svn_fs_t *fs,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  history_prefetch_t *prefetch = batch->prefetch;
+  apr_pool_t *hist_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *prev_pool = svn_pool_create(scratch_pool);
+  svn_fs_root_t *root;
+  svn_fs_history_t *hist;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, batch->rev, scratch_pool));
+  SVN_ERR(svn_fs_node_history2(&hist, root, batch->path, hist_pool,
+                               hist_pool));
+  SVN_ERR(svn_fs_history_prev2(&hist, hist, ! prefetch->strict, hist_pool,
+                               hist_pool));
+  if (hist && ! batch->first_time)
+    SVN_ERR(svn_fs_history_prev2(&hist, hist, ! prefetch->strict,
+                                 hist_pool, hist_pool));
+
+  while (hist)
+    {
+      history_location_t *location;
+      const char *path;
+      svn_revnum_t rev;
+      apr_pool_t *temp_pool;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_history_location(&path, &rev, hist, hist_pool));
+
+      location = apr_array_push(result->locations);
+      location->path = apr_pstrdup(result_pool, path);
+      location->rev = rev;
+
+      if (rev < prefetch->start)
+        break;
+
+      if (result->locations->nelts == HISTORY_BATCH_SIZE)
+        {
+          result->more = TRUE;
+          break;
+        }
+
+      /* The next history object requires the current one. */
+      svn_pool_clear(prev_pool);
+      SVN_ERR(svn_fs_history_prev2(&hist, hist, ! prefetch->strict,
+                                   prev_pool, prev_pool));
+      temp_pool = hist_pool;
+      hist_pool = prev_pool;
+      prev_pool = temp_pool;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Fetch the history locations for
+   the history_batch_t in PROCESS_BATON and return them as a
+   history_result_t in *RESULT.  Failures to find the location of the
+   batch get reported through the result, as they may be ignorable; all
+   other errors fail the whole prefetch. */
+static svn_error_t *
+fetch_history_task(void **result,
+                   void *process_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  history_batch_t *batch = process_baton;
+  history_prefetch_t *prefetch = batch->prefetch;
+  history_result_t *history = apr_pcalloc(result_pool, sizeof(*history));
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  history->batch = batch;
+  history->locations = apr_array_make(result_pool, HISTORY_BATCH_SIZE,
+                                      sizeof(history_location_t));
+
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs, prefetch->fs_pool));
+  err = fetch_history_batch(history, batch, fs, cancel_func, cancel_baton,
+                            result_pool, scratch_pool);
+  if (is_location_error(err))
+    {
+      history->err = err;
+      err = SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_error_compose_create(
+            err, svn_repos__fs_pool_release(prefetch->fs_pool, fs)));
+
+  *result = history;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Hand the history_result_t in
+   RESULT over to its batch. */
+static svn_error_t *
+deliver_history_batch(void *result,
+                      void *output_baton,
+                      apr_pool_t *scratch_pool)
+{
+  history_result_t *history = result;
+  history_batch_t *batch = history->batch;
+  int i;
+
+  batch->locations = apr_array_make(batch->pool, history->locations->nelts,
+                                    sizeof(history_location_t));
+  for (i = 0; i < history->locations->nelts; ++i)
+    {
+      history_location_t *location
+        = &APR_ARRAY_IDX(history->locations, i, history_location_t);
+      history_location_t *copy = apr_array_push(batch->locations);
+
+      copy->path = apr_pstrdup(batch->pool, location->path);
+      copy->rev = location->rev;
+    }
+
+  batch->more = history->more;
+  batch->err = history->err;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the fetching of the history of PATH@REV in PREFETCH and return
+   the new batch in *BATCH_P.  FIRST_TIME is as in history_batch_t. */
+static svn_error_t *
+queue_history_batch(history_batch_t **batch_p,
+                    history_prefetch_t *prefetch,
+                    const char *path,
+                    svn_revnum_t rev,
+                    svn_boolean_t first_time)
+{
+  apr_pool_t *pool = svn_pool_create(prefetch->batch_pool);
+  history_batch_t *batch = apr_pcalloc(pool, sizeof(*batch));
+
+  batch->pool = pool;
+  batch->path = apr_pstrdup(pool, path);
+  batch->rev = rev;
+  batch->first_time = first_time;
+  batch->prefetch = prefetch;
+
+  *batch_p = batch;
+
+  return svn_error_trace(svn_task__add(prefetch->set, fetch_history_task,
+                                       batch));
+}
+
+/* Release BATCH, which may be NULL, as well as its unreported error. */
+static void
+release_history_batch(history_batch_t *batch)
+{
+  if (batch)
+    {
+      svn_error_clear(batch->err);
+      svn_pool_destroy(batch->pool);
+    }
+}
+
+/* Discard the batches of INFO. */
+static void
+release_history_batches(struct path_info *info)
+{
+  release_history_batch(info->ready);
+  info->ready = NULL;
+
+  /* A PENDING batch that has not been delivered yet may still be read by
+     its task.  Its memory goes with the task set. */
+  if (info->pending && info->pending->locations)
+    release_history_batch(info->pending);
+  info->pending = NULL;
+}
+
+/* Like get_history() but take the next location from the batches that
+   INFO->PREFETCH fetched for us.  Whenever we start consuming a new
+   batch, queue the next one such that the workers keep busy.  The
+   AUTHZ_READ_FUNC is only ever called from this thread. */
+static svn_error_t *
+get_prefetched_history(struct path_info *info,
+                       svn_fs_t *fs,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       apr_pool_t *scratch_pool)
+{
+  history_batch_t *batch = info->ready;
+  history_location_t *location;
+
+  if (!batch || batch->next == batch->locations->nelts)
+    {
+      release_history_batch(batch);
+      info->ready = NULL;
+
+      batch = info->pending;
+      if (!batch)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      /* Results get delivered in queue order.  Collect all outstanding
+         ones if this batch has not been delivered yet. */
+      if (!batch->locations)
+        SVN_ERR(svn_task__set_finish(info->prefetch->set));
+
+      info->pending = NULL;
+      info->ready = batch;
+      if (batch->err)
+        {
+          svn_error_t *err = batch->err;
+          batch->err = SVN_NO_ERROR;
+          return svn_error_trace(err);
+        }
+
+      if (batch->more)
+        {
+          location = &APR_ARRAY_IDX(batch->locations,
+                                    batch->locations->nelts - 1,
+                                    history_location_t);
+          SVN_ERR(queue_history_batch(&info->pending, info->prefetch,
+                                      location->path, location->rev,
+                                      FALSE));
+        }
+      else if (batch->locations->nelts == 0)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  location = &APR_ARRAY_IDX(batch->locations, batch->next++,
+                            history_location_t);
+  info->history_rev = location->rev;
+  svn_stringbuf_set(info->path, location->path);
+
+  /* If this history item predates our START revision then
+     don't fetch any more for this path. */
+  if (info->history_rev < info->prefetch->start)
+    {
+      info->done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Is the history item readable?  If not, done with path. */
+  return svn_error_trace(check_history_readable(info, fs, authz_read_func,
+                                                authz_read_baton,
+                                                scratch_pool));
+}
+
+/* Set up *PREFETCH_P to fetch histories from FS using up to JOBS
+   threads.  STRICT and START are as in get_history().  Outstanding
+   tasks get cancelled when POOL gets cleaned up or
+   stop_history_prefetch() is called, whichever comes first. */
+static svn_error_t *
+start_history_prefetch(history_prefetch_t **prefetch_p,
+                       svn_fs_t *fs,
+                       int jobs,
+                       svn_boolean_t strict,
+                       svn_revnum_t start,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *prefetch_pool = svn_pool_create(pool);
+  history_prefetch_t *prefetch = apr_pcalloc(prefetch_pool,
+                                             sizeof(*prefetch));
+
+  prefetch->pool = prefetch_pool;
+  prefetch->strict = strict;
+  prefetch->start = start;
+  SVN_ERR(svn_repos__fs_pool_create(&prefetch->fs_pool, fs, prefetch_pool));
+
+  /* Sub-pools get destroyed in reverse order of creation, so the task set
+     will be gone before the batches that its tasks read.  It will also be
+     gone before the FS instances get closed by the cleanup of
+     PREFETCH_POOL. */
+  prefetch->batch_pool = svn_pool_create(prefetch_pool);
+  SVN_ERR(svn_task__set_create(&prefetch->set, jobs, deliver_history_batch,
+                               prefetch, NULL, NULL,
+                               svn_pool_create(prefetch_pool)));
+
+  *prefetch_p = prefetch;
+
+  return SVN_NO_ERROR;
+}
+
+/* Cancel the outstanding tasks of PREFETCH as started by
+   start_history_prefetch() and release all its resources. */
+static void
+stop_history_prefetch(history_prefetch_t *prefetch)
+{
+  int i;
+
+  if (prefetch->histories)
+    for (i = 0; i < prefetch->histories->nelts; ++i)
+      release_history_batches(APR_ARRAY_IDX(prefetch->histories, i,
+                                            struct path_info *));
+
+  svn_pool_destroy(prefetch->pool);
+}
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -446,6 +889,8 @@ struct path_info
  * If optional AUTHZ_READ_FUNC is non-NULL, then use it (with
  * AUTHZ_READ_BATON and FS) to check whether INFO->PATH is still readable if
  * we do indeed find more history for the path.
+ *
+ * If INFO->PREFETCH is set, take the history from there instead.
  */
 static svn_error_t *
 get_history(struct path_info *info,
@@ -462,6 +907,12 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->prefetch)
+    return svn_error_trace(get_prefetched_history(info, fs,
+                                                  authz_read_func,
+                                                  authz_read_baton,
+                                                  scratch_pool));
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -519,19 +970,8 @@ get_history(struct path_info *info,
     }
 
   /* Is the history item readable?  If not, done with path. */
-  if (authz_read_func)
-    {
-      svn_boolean_t readable;
-      SVN_ERR(svn_fs_revision_root(&history_root, fs,
-                                   info->history_rev,
-                                   scratch_pool));
-      SVN_ERR(authz_read_func(&readable, history_root,
-                              info->path->data,
-                              authz_read_baton,
-                              scratch_pool));
-      if (! readable)
-        info->done = TRUE;
-    }
+  SVN_ERR(check_history_readable(info, fs, authz_read_func,
+                                 authz_read_baton, scratch_pool));
 
   if (! info->hist)
     {
@@ -589,24 +1029,21 @@ check_history(svn_boolean_t *changed,
                      authz_read_baton, start, result_pool, scratch_pool);
 }
 
-/* Return the next interesting revision in our list of HISTORIES. */
-static svn_revnum_t
-next_history_rev(const apr_array_header_t *histories)
+/* Implements the comparison function of svn_priority_queue__create()
+   for struct path_info * elements.  Order them by HISTORY_REV, youngest
+   first, such that the queue always presents the next interesting
+   revision. */
+static int
+compare_history_revs(const void *a,
+                     const void *b)
 {
-  svn_revnum_t next_rev = SVN_INVALID_REVNUM;
-  int i;
+  const struct path_info *lhs = *(struct path_info * const *)a;
+  const struct path_info *rhs = *(struct path_info * const *)b;
 
-  for (i = 0; i < histories->nelts; ++i)
-    {
-      struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                             struct path_info *);
-      if (info->done)
-        continue;
-      if (info->history_rev > next_rev)
-        next_rev = info->history_rev;
-    }
+  if (lhs->history_rev == rhs->history_rev)
+    return 0;
 
-  return next_rev;
+  return lhs->history_rev > rhs->history_rev ? -1 : 1;
 }
 
 /* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
@@ -875,13 +1312,53 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
 }
 
 
+/* Like fs_mergeinfo_changed() but use the optional MERGEINFO_CACHE
+   to skip the computation if possible and update it otherwise. */
+static svn_error_t *
+cached_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                         svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                         svn_fs_t *fs,
+                         svn_repos__mergeinfo_cache_t *mergeinfo_cache,
+                         svn_revnum_t rev,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  if (mergeinfo_cache)
+    {
+      SVN_ERR(svn_repos__mergeinfo_cache_get(deleted_mergeinfo_catalog,
+                                             added_mergeinfo_catalog,
+                                             mergeinfo_cache, rev,
+                                             result_pool, scratch_pool));
+      if (*deleted_mergeinfo_catalog)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(fs_mergeinfo_changed(deleted_mergeinfo_catalog,
+                               added_mergeinfo_catalog,
+                               fs, rev, result_pool, scratch_pool));
+
+  /* Most revisions don't touch mergeinfo and we can tell that quickly.
+     Only record those that were expensive to process. */
+  if (mergeinfo_cache
+      && (   apr_hash_count(*deleted_mergeinfo_catalog)
+          || apr_hash_count(*added_mergeinfo_catalog)))
+    SVN_ERR(svn_repos__mergeinfo_cache_set(mergeinfo_cache, rev,
+                                           *deleted_mergeinfo_catalog,
+                                           *added_mergeinfo_catalog,
+                                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the differences for added mergeinfo in
-   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO. */
+   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO.
+   MERGEINFO_CACHE is as for cached_mergeinfo_changed(). */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                svn_mergeinfo_t *deleted_mergeinfo,
                                svn_fs_t *fs,
+                               svn_repos__mergeinfo_cache_t *mergeinfo_cache,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
                                apr_pool_t *result_pool,
@@ -907,10 +1384,10 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
     return SVN_NO_ERROR;
 
   /* Fetch the mergeinfo changes for REV. */
-  err = fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
-                             &added_mergeinfo_catalog,
-                             fs, rev,
-                             scratch_pool, scratch_pool);
+  err = cached_mergeinfo_changed(&deleted_mergeinfo_catalog,
+                                 &added_mergeinfo_catalog,
+                                 fs, mergeinfo_cache, rev,
+                                 scratch_pool, scratch_pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -1095,11 +1572,14 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
 }
 
 
-/* Fill LOG_ENTRY with history information in FS at REV. */
+/* Fill LOG_ENTRY with history information in FS at REV.  If REV_PROPLIST
+   is not NULL, it contains all revision properties of REV and will be
+   used instead of reading them from FS. */
 static svn_error_t *
 fill_log_entry(svn_repos_log_entry_t *log_entry,
                svn_revnum_t rev,
                svn_fs_t *fs,
+               apr_hash_t *rev_proplist,
                const apr_array_header_t *revprops,
                const log_callbacks_t *callbacks,
                apr_pool_t *pool)
@@ -1136,8 +1616,11 @@ fill_log_entry(svn_repos_log_entry_t *log_entry,
   if (get_revprops && want_revprops)
     {
       /* User is allowed to see at least some revprops. */
-      SVN_ERR(svn_fs_revision_proplist2(&r_props, fs, rev, FALSE, pool,
-                                        pool));
+      if (rev_proplist)
+        r_props = rev_proplist;
+      else
+        SVN_ERR(svn_fs_revision_proplist2(&r_props, fs, rev, FALSE, pool,
+                                          pool));
       if (revprops == NULL)
         {
           /* Requested all revprops... */
@@ -1289,7 +1772,8 @@ interesting_merge(void *baton,
 
    If REVPROPS is NULL, retrieve all revision properties; else, retrieve
    only the revision properties named by the (const char *) array elements
-   (i.e. retrieve none if the array is empty).
+   (i.e. retrieve none if the array is empty).  REV_PROPLIST may provide
+   all revision properties of REV, see fill_log_entry().
 
    LOG_TARGET_HISTORY_AS_MERGEINFO, HANDLING_MERGED_REVISION, and
    NESTED_MERGES are as per the arguments of the same name to DO_LOGS.
@@ -1309,6 +1793,7 @@ send_log(svn_revnum_t rev,
          svn_bit_array__t *nested_merges,
          svn_boolean_t subtractive_merge,
          svn_boolean_t handling_merged_revision,
+         apr_hash_t *rev_proplist,
          const apr_array_header_t *revprops,
          svn_boolean_t has_children,
          const log_callbacks_t *callbacks,
@@ -1343,7 +1828,8 @@ send_log(svn_revnum_t rev,
       baton.found_rev_of_interest = TRUE;
     }
 
-  SVN_ERR(fill_log_entry(&log_entry, rev, fs, revprops, callbacks, pool));
+  SVN_ERR(fill_log_entry(&log_entry, rev, fs, rev_proplist, revprops,
+                         callbacks, pool));
   log_entry.has_children = has_children;
   log_entry.subtractive_merge = subtractive_merge;
 
@@ -1387,10 +1873,22 @@ send_log(svn_revnum_t rev,
    memory. */
 #define MAX_OPEN_HISTORIES 32
 
+/* Return TRUE if IGNORE_MISSING_LOCATIONS is set and ERR indicates that
+   a path to follow does not exist in the requested revision. */
+static svn_boolean_t
+is_ignorable_location_error(svn_error_t *err,
+                            svn_boolean_t ignore_missing_locations)
+{
+  return ignore_missing_locations && is_location_error(err);
+}
+
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
-   repository locations as fatal -- just ignore them.  */
+   repository locations as fatal -- just ignore them.
+
+   If PREFETCH is not NULL, have its worker threads fetch the histories
+   of all PATHS concurrently.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
                    svn_fs_t *fs,
@@ -1401,6 +1899,7 @@ get_path_histories(apr_array_header_t **histories,
                    svn_boolean_t ignore_missing_locations,
                    svn_repos_authz_func_t authz_read_func,
                    void *authz_read_baton,
+                   struct history_prefetch_t *prefetch,
                    apr_pool_t *pool)
 {
   svn_fs_root_t *root;
@@ -1419,14 +1918,18 @@ get_path_histories(apr_array_header_t **histories,
   *histories = apr_array_make(pool, paths->nelts,
                               sizeof(struct path_info *));
 
+  if (prefetch)
+    prefetch->histories = *histories;
+
   SVN_ERR(svn_fs_revision_root(&root, fs, hist_end, pool));
 
   iterpool = svn_pool_create(pool);
   for (i = 0; i < paths->nelts; i++)
     {
       const char *this_path = APR_ARRAY_IDX(paths, i, const char *);
-      struct path_info *info = apr_palloc(pool,
-                                          sizeof(struct path_info));
+      struct path_info *info = apr_pcalloc(pool,
+                                           sizeof(struct path_info));
+      svn_boolean_t changed;
       svn_pool_clear(iterpool);
 
       if (authz_read_func)
@@ -1443,20 +1946,46 @@ get_path_histories(apr_array_header_t **histories,
       info->history_rev = hist_end;
       info->first_time = TRUE;
 
+      if (prefetch && i < MAX_OPEN_HISTORIES)
+        {
+          /* Skip paths that certainly have no history within the range. */
+          err = svn_fs_subtree_changed(&changed, fs, this_path,
+                                       hist_start, hist_end, iterpool);
+          if (is_ignorable_location_error(err, ignore_missing_locations))
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+          if (! changed)
+            continue;
+
+          /* Missing locations will be reported by the worker and are
+             being handled below. */
+          info->prefetch = prefetch;
+          APR_ARRAY_PUSH(*histories, struct path_info *) = info;
+          SVN_ERR(queue_history_batch(&info->pending, prefetch, this_path,
+                                      hist_end, TRUE));
+          continue;
+        }
+
       if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
-          if (err
-              && ignore_missing_locations
-              && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
-                  err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
-                  err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION))
+          if (is_ignorable_location_error(err, ignore_missing_locations))
             {
               svn_error_clear(err);
               continue;
             }
           SVN_ERR(err);
+
+          /* Skip paths that certainly have no history within the range. */
+          SVN_ERR(svn_fs_subtree_changed(&changed, fs, this_path,
+                                         hist_start, hist_end, iterpool));
+          if (! changed)
+            continue;
+
           info->newpool = svn_pool_create(pool);
           info->oldpool = svn_pool_create(pool);
         }
@@ -1471,11 +2000,7 @@ get_path_histories(apr_array_header_t **histories,
                         strict_node_history,
                         authz_read_func, authz_read_baton,
                         hist_start, pool, iterpool);
-      if (err
-          && ignore_missing_locations
-          && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
-              err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
-              err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION))
+      if (is_ignorable_location_error(err, ignore_missing_locations))
         {
           svn_error_clear(err);
           continue;
@@ -1483,6 +2008,40 @@ get_path_histories(apr_array_header_t **histories,
       SVN_ERR(err);
       APR_ARRAY_PUSH(*histories, struct path_info *) = info;
     }
+
+  /* All prefetched histories are being fetched by now.  Wait for the
+     first location of each one of them. */
+  if (prefetch)
+    {
+      int kept = 0;
+      for (i = 0; i < (*histories)->nelts; i++)
+        {
+          struct path_info *info = APR_ARRAY_IDX(*histories, i,
+                                                 struct path_info *);
+          svn_pool_clear(iterpool);
+
+          if (! info->prefetch)
+            {
+              APR_ARRAY_IDX(*histories, kept++, struct path_info *) = info;
+              continue;
+            }
+
+          err = get_history(info, fs,
+                            strict_node_history,
+                            authz_read_func, authz_read_baton,
+                            hist_start, pool, iterpool);
+          if (is_ignorable_location_error(err, ignore_missing_locations))
+            {
+              svn_error_clear(err);
+              release_history_batches(info);
+              continue;
+            }
+          SVN_ERR(err);
+          APR_ARRAY_IDX(*histories, kept++, struct path_info *) = info;
+        }
+      (*histories)->nelts = kept;
+    }
+
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1990,7 +2549,9 @@ do_logs(svn_fs_t *fs,
   apr_hash_t *rev_mergeinfo = NULL;
   svn_revnum_t current;
   apr_array_header_t *histories;
-  svn_boolean_t any_histories_left = TRUE;
+  apr_array_header_t *queue_elements;
+  svn_priority_queue__t *queue;
+  struct history_prefetch_t *prefetch = NULL;
   int send_count = 0;
   int i;
 
@@ -2012,29 +2573,49 @@ do_logs(svn_fs_t *fs,
      about all the revisions in the range -- only the ones in which
      one of our paths was changed.  So let's go figure out which
      revisions contain real changes to at least one of our paths.  */
+  /* With many paths, walking their histories one step at a time quickly
+     dominates the runtime.  Let worker threads do that concurrently. */
+  if (   paths->nelts >= PARALLEL_HISTORY_MIN_PATHS
+      && svn_task__get_thread_limit() > 0)
+    SVN_ERR(start_history_prefetch(&prefetch, fs,
+                                   MIN(paths->nelts, PARALLEL_HISTORY_JOBS),
+                                   strict_node_history, hist_start, pool));
+
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks->authz_read_baton, prefetch, pool));
+
+  /* Keep the histories that are not depleted yet ordered by their next
+     interesting revision. */
+  queue_elements = apr_array_make(pool, histories->nelts,
+                                  sizeof(struct path_info *));
+  for (i = 0; i < histories->nelts; i++)
+    {
+      struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                             struct path_info *);
+      if (! info->done)
+        APR_ARRAY_PUSH(queue_elements, struct path_info *) = info;
+    }
+  queue = svn_priority_queue__create(queue_elements, compare_history_revs);
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
      history in reverse order just send it to them right away. */
   iterpool = svn_pool_create(pool);
   iterpool2 = svn_pool_create(pool);
-  for (current = hist_end;
-       any_histories_left;
-       current = next_history_rev(histories))
+  while (svn_priority_queue__size(queue) > 0)
     {
       svn_boolean_t changed = FALSE;
-      any_histories_left = FALSE;
+      struct path_info *info
+        = *(struct path_info **)svn_priority_queue__peek(queue);
+
+      current = info->history_rev;
       svn_pool_clear(iterpool);
 
-      for (i = 0; i < histories->nelts; i++)
+      /* Advance all histories that have a change in the current rev. */
+      do
         {
-          struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                                 struct path_info *);
-
           svn_pool_clear(iterpool2);
 
           /* Check history for this path in current rev. */
@@ -2043,9 +2624,16 @@ do_logs(svn_fs_t *fs,
                                 callbacks->authz_read_func,
                                 callbacks->authz_read_baton,
                                 hist_start, pool, iterpool2));
-          if (! info->done)
-            any_histories_left = TRUE;
+          if (info->done)
+            svn_priority_queue__pop(queue);
+          else
+            svn_priority_queue__update(queue);
+
+          info = svn_priority_queue__size(queue) > 0
+               ? *(struct path_info **)svn_priority_queue__peek(queue)
+               : NULL;
         }
+      while (info && info->history_rev == current);
 
       svn_pool_clear(iterpool2);
 
@@ -2075,7 +2663,9 @@ do_logs(svn_fs_t *fs,
                 }
               SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
                                                      &deleted_mergeinfo,
-                                                     fs, cur_paths,
+                                                     fs,
+                                                     callbacks->mergeinfo_cache,
+                                                     cur_paths,
                                                      current,
                                                      iterpool, iterpool));
               has_children = (apr_hash_count(added_mergeinfo) > 0
@@ -2090,7 +2680,8 @@ do_logs(svn_fs_t *fs,
               SVN_ERR(send_log(current, fs,
                                log_target_history_as_mergeinfo, nested_merges,
                                subtractive_merge, handling_merged_revisions,
-                               revprops, has_children, callbacks, iterpool));
+                               NULL, revprops, has_children, callbacks,
+                               iterpool));
 
               if (has_children) /* Implies include_merged_revisions == TRUE */
                 {
@@ -2101,7 +2692,7 @@ do_logs(svn_fs_t *fs,
                          recursions so we can track and squelch duplicates. */
                       subpool = svn_pool_create(pool);
                       nested_merges = svn_bit_array__create(hist_end, subpool);
-                      processed = svn_hash__make(subpool);
+                      processed = svn_hash__make_fast(subpool);
                     }
 
                   SVN_ERR(handle_merged_revisions(
@@ -2152,6 +2743,9 @@ do_logs(svn_fs_t *fs,
   svn_pool_destroy(iterpool2);
   svn_pool_destroy(iterpool);
 
+  if (prefetch)
+    stop_history_prefetch(prefetch);
+
   if (subpool)
     {
       nested_merges = NULL;
@@ -2189,7 +2783,8 @@ do_logs(svn_fs_t *fs,
           SVN_ERR(send_log(current, fs,
                            log_target_history_as_mergeinfo, nested_merges,
                            subtractive_merge, handling_merged_revisions,
-                           revprops, has_children, callbacks, iterpool));
+                           NULL, revprops, has_children, callbacks,
+                           iterpool));
           if (has_children)
             {
               if (!nested_merges)
@@ -2303,22 +2898,57 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_get_logs5(svn_repos_t *repos,
-                    const apr_array_header_t *paths,
-                    svn_revnum_t start,
-                    svn_revnum_t end,
-                    int limit,
-                    svn_boolean_t strict_node_history,
-                    svn_boolean_t include_merged_revisions,
-                    const apr_array_header_t *revprops,
-                    svn_repos_authz_func_t authz_read_func,
-                    void *authz_read_baton,
-                    svn_repos_path_change_receiver_t path_change_receiver,
-                    void *path_change_receiver_baton,
-                    svn_repos_log_entry_receiver_t revision_receiver,
-                    void *revision_receiver_baton,
-                    apr_pool_t *scratch_pool)
+/* Number of revisions for which svn_repos_get_logs5() fetches revprops
+   at once when logging the repository root. */
+#define LOG_REVPROPS_BATCH_SIZE 256
+
+/* Revision properties for a batch of consecutive revisions. */
+typedef struct revprops_batch_t
+{
+  /* Revision from which the batch starts, in log order. */
+  svn_revnum_t first;
+
+  /* Property lists, indexed by distance from FIRST. */
+  apr_hash_t **proplists;
+
+  /* Pool to allocate the property lists in. */
+  apr_pool_t *pool;
+} revprops_batch_t;
+
+/* Implements svn_fs_revision_proplist_receiver_t.
+   Copy PROPLIST into BATON, which is a revprops_batch_t. */
+static svn_error_t *
+collect_revprops(void *baton,
+                 svn_revnum_t revision,
+                 apr_hash_t *proplist,
+                 apr_pool_t *scratch_pool)
+{
+  revprops_batch_t *batch = baton;
+  svn_revnum_t idx = revision >= batch->first ? revision - batch->first
+                                              : batch->first - revision;
+
+  batch->proplists[idx] = svn_prop_hash_dup(proplist, batch->pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos_get_logs5() without tracing.  Parameters are the
+   same. */
+static svn_error_t *
+get_logs(svn_repos_t *repos,
+         const apr_array_header_t *paths,
+         svn_revnum_t start,
+         svn_revnum_t end,
+         int limit,
+         svn_boolean_t strict_node_history,
+         svn_boolean_t include_merged_revisions,
+         const apr_array_header_t *revprops,
+         svn_repos_authz_func_t authz_read_func,
+         void *authz_read_baton,
+         svn_repos_path_change_receiver_t path_change_receiver,
+         void *path_change_receiver_baton,
+         svn_repos_log_entry_receiver_t revision_receiver,
+         void *revision_receiver_baton,
+         apr_pool_t *scratch_pool)
 {
   svn_revnum_t head = SVN_INVALID_REVNUM;
   svn_fs_t *fs = repos->fs;
@@ -2332,6 +2962,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.mergeinfo_cache = NULL;
 
   if (revprops)
     {
@@ -2398,6 +3029,10 @@ svn_repos_get_logs5(svn_repos_t *repos,
       apr_uint64_t send_count = 0;
       int i;
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      svn_boolean_t want_revprops = !revprops || revprops->nelts;
+      revprops_batch_t batch = { 0 };
+
+      batch.pool = svn_pool_create(scratch_pool);
 
       /* If we are provided an authz callback function, use it to
          verify that the user has read access to the root path in the
@@ -2427,6 +3062,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
       for (i = 0; i < send_count; ++i)
         {
           svn_revnum_t rev;
+          apr_hash_t *rev_proplist = NULL;
 
           svn_pool_clear(iterpool);
 
@@ -2434,10 +3070,33 @@ svn_repos_get_logs5(svn_repos_t *repos,
             rev = end - i;
           else
             rev = start + i;
+
+          /* Fetch the revprops for the next batch of revisions at once. */
+          if (want_revprops)
+            {
+              if (i % LOG_REVPROPS_BATCH_SIZE == 0)
+                {
+                  apr_uint64_t count = MIN(send_count - i,
+                                           LOG_REVPROPS_BATCH_SIZE);
+                  svn_pool_clear(batch.pool);
+                  batch.first = rev;
+                  batch.proplists = apr_pcalloc(batch.pool,
+                                                count * sizeof(apr_hash_t *));
+                  SVN_ERR(svn_fs_revision_proplist_range(
+                            fs, rev,
+                            descending_order ? rev - (svn_revnum_t)count + 1
+                                             : rev + (svn_revnum_t)count - 1,
+                            FALSE, collect_revprops, &batch, iterpool));
+                }
+
+              rev_proplist = batch.proplists[i % LOG_REVPROPS_BATCH_SIZE];
+            }
+
           SVN_ERR(send_log(rev, fs, NULL, NULL,
-                           FALSE, FALSE, revprops, FALSE,
+                           FALSE, FALSE, rev_proplist, revprops, FALSE,
                            &callbacks, iterpool));
         }
+      svn_pool_destroy(batch.pool);
       svn_pool_destroy(iterpool);
 
       return SVN_NO_ERROR;
@@ -2458,6 +3117,10 @@ svn_repos_get_logs5(svn_repos_t *repos,
                                              authz_read_baton,
                                              scratch_pool, subpool));
       svn_pool_destroy(subpool);
+
+      SVN_ERR(svn_repos__mergeinfo_cache_open(&callbacks.mergeinfo_cache,
+                                              repos, scratch_pool,
+                                              scratch_pool));
     }
 
   return do_logs(repos->fs, paths, paths_history_mergeinfo, NULL, NULL,
@@ -2465,3 +3128,38 @@ svn_repos_get_logs5(svn_repos_t *repos,
                  include_merged_revisions, FALSE, FALSE, FALSE,
                  revprops, descending_order, &callbacks, scratch_pool);
 }
+
+svn_error_t *
+svn_repos_get_logs5(svn_repos_t *repos,
+                    const apr_array_header_t *paths,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    int limit,
+                    svn_boolean_t strict_node_history,
+                    svn_boolean_t include_merged_revisions,
+                    const apr_array_header_t *revprops,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_repos_path_change_receiver_t path_change_receiver,
+                    void *path_change_receiver_baton,
+                    svn_repos_log_entry_receiver_t revision_receiver,
+                    void *revision_receiver_baton,
+                    apr_pool_t *scratch_pool)
+{
+  svn_trace__span_t *span = svn_trace__begin("repos.get_logs");
+  svn_trace__attr_int(span, "start", start);
+  svn_trace__attr_int(span, "end", end);
+  svn_trace__attr_int(span, "limit", limit);
+
+  return svn_error_trace(
+           svn_trace__end(span,
+                          get_logs(repos, paths, start, end, limit,
+                                   strict_node_history,
+                                   include_merged_revisions, revprops,
+                                   authz_read_func, authz_read_baton,
+                                   path_change_receiver,
+                                   path_change_receiver_baton,
+                                   revision_receiver,
+                                   revision_receiver_baton,
+                                   scratch_pool)));
+}
@@ -0,0 +1,49 @@
+/* mergeinfo-cache-db.sql -- schema for the mergeinfo change cache
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row per revision whose mergeinfo changes have been recorded.
+   DATE is the svn:date of that revision when the row was written.  A
+   row whose DATE does not match the current svn:date is stale, e.g.
+   because the repository has been restored from an older backup and
+   the revision number was then reused for a different commit.
+   DELETED and ADDED are the mergeinfo catalogs as serialized property
+   skels, mapping paths to mergeinfo strings. */
+CREATE TABLE mergeinfo_changes (
+  revision INTEGER NOT NULL PRIMARY KEY,
+  date TEXT,
+  deleted BLOB,
+  added BLOB
+  );
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_GET_MERGEINFO_CHANGES
+SELECT date, deleted, added
+FROM mergeinfo_changes
+WHERE revision = ?1
+
+-- STMT_SET_MERGEINFO_CHANGES
+INSERT OR REPLACE INTO mergeinfo_changes (revision, date, deleted, added)
+VALUES (?1, ?2, ?3, ?4)
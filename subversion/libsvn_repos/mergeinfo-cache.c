@@ -0,0 +1,290 @@
+/* mergeinfo-cache.c : persistent cache of per-revision mergeinfo changes
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_props.h"
+#include "svn_mergeinfo.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+#include "private/svn_sqlite.h"
+
+#include "mergeinfo-cache-db.h"
+
+/* A few magic values */
+#define MERGEINFO_CACHE_SCHEMA_FORMAT   1
+
+MERGEINFO_CACHE_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Finding the mergeinfo changes of a revision with 'svn log -g' requires
+ * a walk over the changed paths plus two mergeinfo lookups for every
+ * path whose properties have been modified.  Revisions never change,
+ * so we record the result per revision in an SQLite database next to
+ * the FS and reuse it for all later log requests.
+ *
+ * The cache is strictly optional: any failure to create, read or
+ * update it makes us simply fall back to computing the changes.
+ */
+struct svn_repos__mergeinfo_cache_t
+{
+  /* The repository's filesystem. */
+  svn_fs_t *fs;
+
+  /* The open cache database. */
+  svn_sqlite__db_t *sdb;
+};
+
+/* Open the cache database for REPOS in *SDB, creating it if necessary.
+   Allocate it in RESULT_POOL. */
+static svn_error_t *
+open_cache_db(svn_sqlite__db_t **sdb,
+              svn_repos_t *repos,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  const char *db_path = svn_dirent_join(svn_repos_db_env(repos,
+                                                         scratch_pool),
+                                        SVN_REPOS__MERGEINFO_CACHE_DB,
+                                        scratch_pool);
+  int version;
+
+  SVN_ERR(svn_sqlite__open(sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, *sdb,
+                                                        scratch_pool),
+                        *sdb);
+  if (version < MERGEINFO_CACHE_SCHEMA_FORMAT)
+    {
+      /* Must be 0 -- an uninitialized (no schema) database. Create
+         the schema. Results in schema version of 1.  */
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(*sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            *sdb);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__mergeinfo_cache_open(svn_repos__mergeinfo_cache_t **cache,
+                                svn_repos_t *repos,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err = open_cache_db(&sdb, repos, result_pool, scratch_pool);
+
+  /* Read-only repositories etc. simply don't get a cache. */
+  if (err)
+    {
+      svn_error_clear(err);
+      *cache = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *cache = apr_pcalloc(result_pool, sizeof(**cache));
+  (*cache)->fs = svn_repos_fs(repos);
+  (*cache)->sdb = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATE to the svn:date of REV in CACHE's FS, or to NULL if there is
+   none.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+get_revision_date(svn_string_t **date,
+                  svn_repos__mergeinfo_cache_t *cache,
+                  svn_revnum_t rev,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_fs_revision_prop2(date, cache->fs, rev,
+                                               SVN_PROP_REVISION_DATE,
+                                               FALSE, result_pool,
+                                               scratch_pool));
+}
+
+/* Convert the serialized catalog PROPS, as read from the database, to a
+   mergeinfo catalog in *CATALOG, allocated in RESULT_POOL. */
+static svn_error_t *
+parse_catalog(svn_mergeinfo_catalog_t *catalog,
+              apr_hash_t *props,
+              apr_pool_t *result_pool)
+{
+  apr_hash_index_t *hi;
+
+  *catalog = svn_hash__make(result_pool);
+  if (! props)
+    return SVN_NO_ERROR;
+
+  for (hi = apr_hash_first(result_pool, props); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      const svn_string_t *value = apr_hash_this_val(hi);
+      svn_mergeinfo_t mergeinfo;
+
+      SVN_ERR(svn_mergeinfo_parse(&mergeinfo, value->data, result_pool));
+      svn_hash_sets(*catalog, path, mergeinfo);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Convert CATALOG into the hash of svn_string_t * that we store in the
+   database and return it in *PROPS.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+serialize_catalog(apr_hash_t **props,
+                  svn_mergeinfo_catalog_t catalog,
+                  apr_pool_t *result_pool)
+{
+  apr_hash_index_t *hi;
+
+  *props = svn_hash__make(result_pool);
+  for (hi = apr_hash_first(result_pool, catalog); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_mergeinfo_t mergeinfo = apr_hash_this_val(hi);
+      svn_string_t *value;
+
+      SVN_ERR(svn_mergeinfo_to_string(&value, mergeinfo, result_pool));
+      svn_hash_sets(*props, path, value);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos__mergeinfo_cache_get() but don't hide errors. */
+static svn_error_t *
+cache_get(svn_mergeinfo_catalog_t *deleted_p,
+          svn_mergeinfo_catalog_t *added_p,
+          svn_repos__mergeinfo_cache_t *cache,
+          svn_revnum_t rev,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_string_t *date;
+  const char *stored_date;
+  apr_hash_t *deleted, *added;
+  svn_error_t *err;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, cache->sdb,
+                                    STMT_GET_MERGEINFO_CHANGES));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (! have_row)
+    return svn_error_trace(svn_sqlite__reset(stmt));
+
+  stored_date = svn_sqlite__column_text(stmt, 0, scratch_pool);
+  err = svn_sqlite__column_properties(&deleted, stmt, 1, scratch_pool,
+                                      scratch_pool);
+  if (! err)
+    err = svn_sqlite__column_properties(&added, stmt, 2, scratch_pool,
+                                        scratch_pool);
+  SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+
+  /* Ignore stale entries. */
+  SVN_ERR(get_revision_date(&date, cache, rev, scratch_pool, scratch_pool));
+  if (   (date == NULL) != (stored_date == NULL)
+      || (date && strcmp(date->data, stored_date)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(parse_catalog(deleted_p, deleted, result_pool));
+  SVN_ERR(parse_catalog(added_p, added, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__mergeinfo_cache_get(svn_mergeinfo_catalog_t *deleted_p,
+                               svn_mergeinfo_catalog_t *added_p,
+                               svn_repos__mergeinfo_cache_t *cache,
+                               svn_revnum_t rev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  *deleted_p = NULL;
+  *added_p = NULL;
+
+  err = cache_get(deleted_p, added_p, cache, rev, result_pool,
+                  scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *deleted_p = NULL;
+      *added_p = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos__mergeinfo_cache_set() but don't hide errors. */
+static svn_error_t *
+cache_set(svn_repos__mergeinfo_cache_t *cache,
+          svn_revnum_t rev,
+          svn_mergeinfo_catalog_t deleted,
+          svn_mergeinfo_catalog_t added,
+          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_string_t *date;
+  apr_hash_t *deleted_props, *added_props;
+
+  SVN_ERR(get_revision_date(&date, cache, rev, scratch_pool, scratch_pool));
+  SVN_ERR(serialize_catalog(&deleted_props, deleted, scratch_pool));
+  SVN_ERR(serialize_catalog(&added_props, added, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, cache->sdb,
+                                    STMT_SET_MERGEINFO_CHANGES));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, rev));
+  if (date)
+    SVN_ERR(svn_sqlite__bind_text(stmt, 2, date->data));
+  SVN_ERR(svn_sqlite__bind_properties(stmt, 3, deleted_props,
+                                      scratch_pool));
+  SVN_ERR(svn_sqlite__bind_properties(stmt, 4, added_props, scratch_pool));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+svn_error_t *
+svn_repos__mergeinfo_cache_set(svn_repos__mergeinfo_cache_t *cache,
+                               svn_revnum_t rev,
+                               svn_mergeinfo_catalog_t deleted,
+                               svn_mergeinfo_catalog_t added,
+                               apr_pool_t *scratch_pool)
+{
+  /* Concurrent writers, read-only database files etc. shall never
+     make the log request fail. */
+  svn_error_clear(cache_set(cache, rev, deleted, added, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
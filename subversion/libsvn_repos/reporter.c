@@ -34,50 +34,87 @@
 #include "repos.h"
 #include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
+#include "private/svn_trace.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
+/* Flags of a report operation in the spill-buffer. */
+#define REPORT_ENTRY       0x01
+#define REPORT_LINK_PATH   0x02
+#define REPORT_REV         0x04
+#define REPORT_START_EMPTY 0x08
+#define REPORT_LOCK_TOKEN  0x10
+
+/* The depth of a report operation, stored in the upper bits of its
+   flags byte. */
+#define REPORT_DEPTH_SHIFT      5
+#define REPORT_DEPTH_INFINITY   0
+#define REPORT_DEPTH_EXCLUDE    1
+#define REPORT_DEPTH_EMPTY      2
+#define REPORT_DEPTH_FILES      3
+#define REPORT_DEPTH_IMMEDIATES 4
+
+/* Default for the total amount of delta data that may be buffered for
+   the concurrent text delta computation. */
+#define DEFAULT_DELTA_BUFFER_LIMIT (16 * 1024 * 1024)
+
 /* Theory of operation: we write report operations out to a spill-buffer
    as we receive them.  When the report is finished, we read the
    operations back out again, using them to guide the progression of
    the delta between the source and target revs.
 
-   Spill-buffer content format: we use a simple ad-hoc format to store the
-   report operations.  Each report operation is the concatention of
-   the following ("+/-" indicates the single character '+' or '-';
-   <length> and <revnum> are written out as decimal strings):
-
-     +/-                      '-' marks the end of the report
-     If previous is +:
-       <length>:<bytes>       Length-counted path string
-       +/-                    '+' indicates the presence of link_path
-       If previous is +:
-         <length>:<bytes>     Length-counted link_path string
-       +/-                    '+' indicates presence of revnum
-       If previous is +:
-         <revnum>:            Revnum of set_path or link_path
-       +/-                    '+' indicates depth other than svn_depth_infinity
-       If previous is +:
-         <depth>:             "X","E","F","M" =>
-                                 svn_depth_{exclude,empty,files,immediates}
-       +/-                    '+' indicates start_empty field set
-       +/-                    '+' indicates presence of lock_token field.
-       If previous is +:
-         <length>:<bytes>     Length-counted lock_token string
+   Spill-buffer content format: we use a compact binary format to store
+   the report operations.  Numbers are written in the variable-length
+   encoding of svn__encode_uint().  Each report operation is the
+   concatenation of the following:
+
+     <flags>                  One byte; 0 marks the end of the report.
+                              Otherwise, REPORT_ENTRY is set, together
+                              with the REPORT_* flags that indicate the
+                              presence of the optional fields below, and
+                              the depth (REPORT_DEPTH_*) in the upper bits.
+     <prefix>                 Number of leading bytes that the path shares
+                              with the path of the previous operation
+     <length><bytes>          Remainder of the path
+     If REPORT_LINK_PATH:
+       <length><bytes>\0      Link_path string
+     If REPORT_REV:
+       <revnum>               Revnum of set_path or link_path
+     If REPORT_LOCK_TOKEN:
+       <length><bytes>\0      Lock_token string
+
+   Reports of large working copies tend to list many paths within the
+   same directories, so the prefix compression keeps the spill-buffer
+   small.  Once the report is complete, we map its contents into memory
+   and let the link_path and lock_token strings point into it directly.
 
    Terminology: for brevity, this file frequently uses the prefixes
    "s_" for source, "t_" for target, and "e_" for editor.  Also, to
    avoid overloading the word "target", we talk about the source
-   "anchor and operand", rather than the usual "anchor and target". */
+   "anchor and operand", rather than the usual "anchor and target".
+
+   Concurrent text deltas: if enabled through
+   svn_repos__report_set_delta_jobs(), delta_dirs() looks ahead over the
+   run of file entries it is about to process and hands the corresponding
+   text delta computations over to a task set.  Each task uses its
+   own FS instance and buffers the delta windows in memory.  delta_files()
+   then replays the buffered windows instead of computing them.  Hence,
+   the editor is still being driven strictly in order and from the calling
+   thread only.  The look-ahead never crosses a sub-directory entry, so all
+   outstanding delta tasks belong to the directory currently being
+   processed and get consumed in the order they were created. */
 
 /* Describes the state of a working copy subtree, as given by a
-   report.  Because we keep a lookahead pathinfo, we need to allocate
-   each one of these things in a subpool of the report baton and free
-   it when done. */
+   report.  Because we keep a lookahead pathinfo, we can't rely on the
+   usual pool lifetimes.  Instead, these structures get recycled through
+   a free list in the report baton; see release_path_info(). */
 typedef struct path_info_t
 {
   const char *path;            /* path, munged to be anchor-relative */
@@ -86,7 +123,8 @@ typedef struct path_info_t
   svn_depth_t depth;           /* Depth of this path, meaningless for files */
   svn_boolean_t start_empty;   /* Meaningless for delete_path */
   const char *lock_token;      /* NULL if no token */
-  apr_pool_t *pool;            /* Container pool */
+  svn_stringbuf_t *path_buf;   /* Storage for PATH */
+  struct path_info_t *next;    /* Next entry in the free list */
 } path_info_t;
 
 /* Describes the standard revision properties that are relevant for
@@ -113,6 +151,7 @@ typedef struct report_baton_t
   svn_boolean_t text_deltas;   /* Whether to report text deltas */
   apr_size_t zero_copy_limit;  /* Max item size that will be sent using
                                   the zero-copy code path. */
+  svn_boolean_t send_fulltexts; /* Send file contents instead of deltas */
 
   /* If the client requested a specific depth, record it here; if the
      client did not, then this is svn_depth_unknown, and the depth of
@@ -128,8 +167,19 @@ typedef struct report_baton_t
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
 
-  /* The spill-buffer holding the report. */
+  /* The spill-buffer holding the report.  Once the report is complete,
+     its contents get mapped to the range REPORT_POS to REPORT_END, with
+     REPORT_POS being the next operation to read. */
   svn_spillbuf_reader_t *reader;
+  const unsigned char *report_pos;
+  const unsigned char *report_end;
+
+  /* Path of the operation last written to or read from the report.
+     The next path gets prefix-compressed against it. */
+  svn_stringbuf_t *prev_path;
+
+  /* Path infos no longer in use; see release_path_info(). */
+  path_info_t *free_infos;
 
   /* For the actual editor drive, we'll need a lookahead path info
      entry, a cache of FS roots, and a pool to store them. */
@@ -143,6 +193,14 @@ typedef struct report_baton_t
 
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
+
+  /* Number of text deltas computed concurrently and the maximum amount
+     of delta data that they may buffer.  PREFETCH is NULL unless the
+     tasks are active, i.e. during finish_report. */
+  int delta_jobs;
+  apr_size_t delta_buffer_limit;
+  struct delta_prefetch_t *prefetch;
+
   apr_pool_t *pool;
 } report_baton_t;
 
@@ -165,154 +223,164 @@ static svn_error_t *delta_dirs(report_baton_t *b, svn_revnum_t s_rev,
 
 /* --- READING PREVIOUSLY STORED REPORT INFORMATION --- */
 
+/* Return an error indicating that the report data in the spill-buffer is
+   malformed. */
 static svn_error_t *
-read_number(apr_uint64_t *num, svn_spillbuf_reader_t *reader, apr_pool_t *pool)
+bad_report_error(void)
 {
-  char c;
-
-  *num = 0;
-  while (1)
-    {
-      SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-      if (c == ':')
-        break;
-      *num = *num * 10 + (c - '0');
-    }
-  return SVN_NO_ERROR;
+  return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
+                          _("Invalid report data"));
 }
 
 static svn_error_t *
-read_string(const char **str, svn_spillbuf_reader_t *reader, apr_pool_t *pool)
+read_number(apr_uint64_t *num, report_baton_t *b)
 {
-  apr_uint64_t len;
-  apr_size_t size;
-  apr_size_t amt;
-  char *buf;
-
-  SVN_ERR(read_number(&len, reader, pool));
-
-  /* Len can never be less than zero.  But could len be so large that
-     len + 1 wraps around and we end up passing 0 to apr_palloc(),
-     thus getting a pointer to no storage?  Probably not (16 exabyte
-     string, anyone?) but let's be future-proof anyway. */
-  if (len + 1 < len || len + 1 > APR_SIZE_MAX)
-    {
-      /* xgettext doesn't expand preprocessor definitions, so we must
-         pass translatable string to apr_psprintf() function to create
-         intermediate string with appropriate format specifier. */
-      return svn_error_createf(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
-                               apr_psprintf(pool,
-                                            _("Invalid length (%%%s) when "
-                                              "about to read a string"),
-                                            APR_UINT64_T_FMT),
-                               len);
-    }
+  const unsigned char *p = svn__decode_uint(num, b->report_pos,
+                                            b->report_end);
+  if (!p)
+    return bad_report_error();
 
-  size = (apr_size_t)len;
-  buf = apr_palloc(pool, size+1);
-  if (size > 0)
-    {
-      SVN_ERR(svn_spillbuf__reader_read(&amt, reader, buf, size, pool));
-      SVN_ERR_ASSERT(amt == size);
-    }
-  buf[len] = 0;
-  *str = buf;
+  b->report_pos = p;
   return SVN_NO_ERROR;
 }
 
+/* Set *STR to the length-counted, NUL-terminated string at the current
+   position in B's report data.  The string is not being copied. */
 static svn_error_t *
-read_rev(svn_revnum_t *rev, svn_spillbuf_reader_t *reader, apr_pool_t *pool)
+read_string(const char **str, report_baton_t *b)
 {
-  char c;
-  apr_uint64_t num;
+  apr_uint64_t len;
 
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  if (c == '+')
-    {
-      SVN_ERR(read_number(&num, reader, pool));
-      *rev = (svn_revnum_t) num;
-    }
-  else
-    *rev = SVN_INVALID_REVNUM;
+  SVN_ERR(read_number(&len, b));
+  if (len >= (apr_uint64_t)(b->report_end - b->report_pos)
+      || b->report_pos[len] != '\0')
+    return bad_report_error();
+
+  *str = (const char *)b->report_pos;
+  b->report_pos += len + 1;
   return SVN_NO_ERROR;
 }
 
-/* Read a single character to set *DEPTH (having already read '+')
-   from READER.  PATH is the path to which the depth applies, and is
-   used for error reporting only. */
+/* Set *DEPTH to the depth encoded in the report operation FLAGS.  PATH is
+   the path to which the depth applies, and is used for error reporting
+   only. */
 static svn_error_t *
-read_depth(svn_depth_t *depth, svn_spillbuf_reader_t *reader, const char *path,
-           apr_pool_t *pool)
+read_depth(svn_depth_t *depth, unsigned char flags, const char *path)
 {
-  char c;
+  int code = flags >> REPORT_DEPTH_SHIFT;
 
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  switch (c)
+  switch (code)
     {
-    case 'X':
+    case REPORT_DEPTH_INFINITY:
+      *depth = svn_depth_infinity;
+      break;
+    case REPORT_DEPTH_EXCLUDE:
       *depth = svn_depth_exclude;
       break;
-    case 'E':
+    case REPORT_DEPTH_EMPTY:
       *depth = svn_depth_empty;
       break;
-    case 'F':
+    case REPORT_DEPTH_FILES:
       *depth = svn_depth_files;
       break;
-    case 'M':
+    case REPORT_DEPTH_IMMEDIATES:
       *depth = svn_depth_immediates;
       break;
-
-      /* Note that we do not tolerate explicit representation of
-         svn_depth_infinity here, because that's not how
-         write_path_info() writes it. */
     default:
       return svn_error_createf(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
-                               _("Invalid depth (%c) for path '%s'"), c, path);
+                               _("Invalid depth (%d) for path '%s'"),
+                               code, path);
     }
 
   return SVN_NO_ERROR;
 }
 
-/* Read a report operation *PI out of READER.  Set *PI to NULL if we
-   have reached the end of the report. */
+/* Read the next report operation *PI out of B's report data.  Set *PI
+   to NULL if we have reached the end of the report.  The caller should
+   hand *PI to release_path_info() once it is done with it. */
 static svn_error_t *
 read_path_info(path_info_t **pi,
-               svn_spillbuf_reader_t *reader,
-               apr_pool_t *pool)
+               report_baton_t *b)
 {
-  char c;
+  unsigned char flags;
+  apr_uint64_t prefix, len, rev;
+  path_info_t *info;
 
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  if (c == '-')
+  if (b->report_pos == b->report_end)
+    return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL, NULL);
+
+  flags = *b->report_pos++;
+  if (flags == 0)
     {
       *pi = NULL;
       return SVN_NO_ERROR;
     }
 
-  *pi = apr_palloc(pool, sizeof(**pi));
-  SVN_ERR(read_string(&(*pi)->path, reader, pool));
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  if (c == '+')
-    SVN_ERR(read_string(&(*pi)->link_path, reader, pool));
-  else
-    (*pi)->link_path = NULL;
-  SVN_ERR(read_rev(&(*pi)->rev, reader, pool));
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  if (c == '+')
-    SVN_ERR(read_depth(&((*pi)->depth), reader, (*pi)->path, pool));
-  else
-    (*pi)->depth = svn_depth_infinity;
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  (*pi)->start_empty = (c == '+');
-  SVN_ERR(svn_spillbuf__reader_getc(&c, reader, pool));
-  if (c == '+')
-    SVN_ERR(read_string(&(*pi)->lock_token, reader, pool));
+  if (!(flags & REPORT_ENTRY))
+    return bad_report_error();
+
+  /* Reconstruct the path from the previous one. */
+  SVN_ERR(read_number(&prefix, b));
+  SVN_ERR(read_number(&len, b));
+  if (prefix > b->prev_path->len
+      || len > (apr_uint64_t)(b->report_end - b->report_pos))
+    return bad_report_error();
+
+  b->prev_path->len = (apr_size_t)prefix;
+  b->prev_path->data[b->prev_path->len] = '\0';
+  svn_stringbuf_appendbytes(b->prev_path, (const char *)b->report_pos,
+                            (apr_size_t)len);
+  b->report_pos += len;
+
+  /* Recycle an old path info, if possible. */
+  if (b->free_infos)
+    {
+      info = b->free_infos;
+      b->free_infos = info->next;
+    }
   else
-    (*pi)->lock_token = NULL;
-  (*pi)->pool = pool;
+    {
+      info = apr_palloc(b->pool, sizeof(*info));
+      info->path_buf = svn_stringbuf_create_empty(b->pool);
+    }
+
+  svn_stringbuf_set(info->path_buf, b->prev_path->data);
+  info->path = info->path_buf->data;
+
+  info->link_path = NULL;
+  if (flags & REPORT_LINK_PATH)
+    SVN_ERR(read_string(&info->link_path, b));
+
+  info->rev = SVN_INVALID_REVNUM;
+  if (flags & REPORT_REV)
+    {
+      SVN_ERR(read_number(&rev, b));
+      info->rev = (svn_revnum_t)rev;
+    }
+
+  SVN_ERR(read_depth(&info->depth, flags, info->path));
+  info->start_empty = (flags & REPORT_START_EMPTY) != 0;
+
+  info->lock_token = NULL;
+  if (flags & REPORT_LOCK_TOKEN)
+    SVN_ERR(read_string(&info->lock_token, b));
+
+  info->next = NULL;
+  *pi = info;
   return SVN_NO_ERROR;
 }
 
+/* Put INFO, as returned by read_path_info(), on B's free list such that
+   its memory can be reused for the following report operations.  INFO
+   must not be used afterwards. */
+static void
+release_path_info(report_baton_t *b,
+                  path_info_t *info)
+{
+  info->next = b->free_infos;
+  b->free_infos = info;
+}
+
 /* Return true if PI's path is a child of PREFIX (which has length PLEN). */
 static svn_boolean_t
 relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
@@ -334,16 +402,14 @@ relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
    At all times, B->lookahead is presumed to be the next pathinfo not
    yet returned as an immediate child, or NULL if we have reached the
    end of the report.  Because we use a lookahead element, we can't
-   rely on the usual nested pool lifetimes, so allocate each pathinfo
-   in a subpool of the report baton's pool.  The caller should delete
-   (*INFO)->pool when it is done with the information. */
+   rely on the usual nested pool lifetimes.  The caller should pass
+   *INFO to release_path_info() when it is done with the information. */
 static svn_error_t *
 fetch_path_info(report_baton_t *b, const char **entry, path_info_t **info,
                 const char *prefix, apr_pool_t *pool)
 {
   apr_size_t plen = strlen(prefix);
   const char *relpath, *sep;
-  apr_pool_t *subpool;
 
   if (!relevant(b->lookahead, prefix, plen))
     {
@@ -367,8 +433,7 @@ fetch_path_info(report_baton_t *b, const char **entry, path_info_t **info,
           /* This is an immediate child; return it and advance. */
           *entry = relpath;
           *info = b->lookahead;
-          subpool = svn_pool_create(b->pool);
-          SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+          SVN_ERR(read_path_info(&b->lookahead, b));
         }
     }
   return SVN_NO_ERROR;
@@ -380,13 +445,11 @@ static svn_error_t *
 skip_path_info(report_baton_t *b, const char *prefix)
 {
   apr_size_t plen = strlen(prefix);
-  apr_pool_t *subpool;
 
   while (relevant(b->lookahead, prefix, plen))
     {
-      svn_pool_destroy(b->lookahead->pool);
-      subpool = svn_pool_create(b->pool);
-      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+      release_path_info(b, b->lookahead);
+      SVN_ERR(read_path_info(&b->lookahead, b));
     }
   return SVN_NO_ERROR;
 }
@@ -662,6 +725,334 @@ send_zero_copy_delta(const unsigned char *contents,
 }
 
 
+struct delta_prefetch_t;
+
+/* A text delta being computed by a task. */
+typedef struct delta_task_t
+{
+  /* Private pool of this task.  It is a root pool because the task
+     allocates in it as well.  All members below are allocated in it. */
+  apr_pool_t *pool;
+
+  /* Index of the directory entry in delta_dirs() that this task has
+     been created for. */
+  int entry;
+
+  /* Compute the delta from S_REV/S_PATH to T_PATH in the target root.
+     S_PATH is NULL to compute the delta against the empty file. */
+  svn_revnum_t s_rev;
+  const char *s_path;
+  const char *t_path;
+
+  /* The delta windows (svn_txdelta_window_t *) created so far. */
+  apr_array_header_t *windows;
+
+  /* TRUE, if WINDOWS contains the complete delta, i.e. the task did
+     not run into an error and did not exceed its buffer limit. */
+  svn_boolean_t complete;
+
+  /* Set once the result of the task has been delivered. */
+  svn_boolean_t done;
+
+  /* Set by the main thread if it is not interested in the result. */
+  volatile svn_atomic_t cancelled;
+
+  /* The concurrent delta computation that this task belongs to. */
+  struct delta_prefetch_t *dp;
+} delta_task_t;
+
+/* State of the concurrent text delta computation of a report. */
+typedef struct delta_prefetch_t
+{
+  /* Root pool holding the objects below. */
+  apr_pool_t *pool;
+
+  /* Runs delta_task() for the TASKS. */
+  svn_task__set_t *set;
+
+  /* Instances of the repository for the tasks. */
+  svn_repos__fs_pool_t *fs_pool;
+
+  /* Ring buffer of TASK_COUNT text deltas being computed.  The tasks with
+     indexes FIRST up to but not including NEXT are in flight. */
+  delta_task_t *tasks;
+  int task_count;
+  apr_uint64_t first;
+  apr_uint64_t next;
+
+  /* Maximum size of the delta data buffered by a single task. */
+  apr_size_t task_buffer_limit;
+
+  /* Target revision of the report. */
+  svn_revnum_t t_rev;
+} delta_prefetch_t;
+
+/* Compute the text delta described by TASK using FS. */
+static svn_error_t *
+compute_delta(delta_task_t *task,
+              svn_fs_t *fs)
+{
+  delta_prefetch_t *dp = task->dp;
+  svn_fs_root_t *s_root = NULL;
+  svn_fs_root_t *t_root;
+  svn_txdelta_stream_t *dstream;
+  apr_size_t buffered = 0;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_fs_revision_root(&t_root, fs, dp->t_rev, task->pool));
+  if (task->s_path)
+    SVN_ERR(svn_fs_revision_root(&s_root, fs, task->s_rev, task->pool));
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root, task->s_path,
+                                       t_root, task->t_path, task->pool));
+
+  iterpool = svn_pool_create(task->pool);
+  while (!svn_atomic_read(&task->cancelled))
+    {
+      svn_txdelta_window_t *window;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+      if (!window)
+        {
+          task->complete = TRUE;
+          break;
+        }
+
+      /* Leave large deltas to the main thread. */
+      buffered += window->num_ops * sizeof(*window->ops);
+      if (window->new_data)
+        buffered += window->new_data->len;
+      if (buffered > dp->task_buffer_limit)
+        break;
+
+      APR_ARRAY_PUSH(task->windows, svn_txdelta_window_t *)
+        = svn_txdelta_window_dup(window, task->pool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Compute the text delta given by
+   the delta_task_t in PROCESS_BATON and return the task in *RESULT.
+   Failures to compute the delta simply leave the task incomplete.  The
+   main thread will then compute the delta itself and report the error,
+   if any.  Failures to get an FS instance get returned. */
+static svn_error_t *
+delta_task(void **result,
+           void *process_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  delta_task_t *task = process_baton;
+  delta_prefetch_t *dp = task->dp;
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs, dp->fs_pool));
+  svn_error_clear(compute_delta(task, fs));
+  SVN_ERR(svn_repos__fs_pool_release(dp->fs_pool, fs));
+
+  *result = task;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Mark the delta_task_t in RESULT
+   as done. */
+static svn_error_t *
+deliver_delta_task(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  delta_task_t *task = result;
+
+  task->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for TASK in DP to complete. */
+static svn_error_t *
+wait_for_delta_task(delta_prefetch_t *dp,
+                    delta_task_t *task)
+{
+  /* This waits for all tasks in flight but there are at most TASK_COUNT
+     of them. */
+  if (!task->done)
+    SVN_ERR(svn_task__set_finish(dp->set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand the text delta from S_REV/S_PATH to T_PATH over to a task in DP.
+   ENTRY is the index of the respective directory entry. */
+static svn_error_t *
+queue_delta_task(delta_prefetch_t *dp,
+                 int entry,
+                 svn_revnum_t s_rev,
+                 const char *s_path,
+                 const char *t_path)
+{
+  delta_task_t *task = &dp->tasks[dp->next % dp->task_count];
+
+  task->pool = svn_pool_create(NULL);
+  task->entry = entry;
+  task->s_rev = s_rev;
+  task->s_path = s_path ? apr_pstrdup(task->pool, s_path) : NULL;
+  task->t_path = apr_pstrdup(task->pool, t_path);
+  task->windows = apr_array_make(task->pool, 1,
+                                 sizeof(svn_txdelta_window_t *));
+  task->complete = FALSE;
+  task->done = FALSE;
+  svn_atomic_set(&task->cancelled, FALSE);
+
+  /* From here on, the task will be released by retire_delta_task() or
+     cleanup_delta_prefetch(). */
+  dp->next++;
+
+  return svn_error_trace(svn_task__add(dp->set, delta_task, task));
+}
+
+/* Discard the oldest task in DP, waiting for it if necessary. */
+static svn_error_t *
+retire_delta_task(delta_prefetch_t *dp)
+{
+  delta_task_t *task = &dp->tasks[dp->first % dp->task_count];
+
+  svn_atomic_set(&task->cancelled, TRUE);
+  SVN_ERR(wait_for_delta_task(dp, task));
+
+  svn_pool_destroy(task->pool);
+  dp->first++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Discard all tasks in DP that have been created for directory entries
+   up to and including index ENTRY. */
+static svn_error_t *
+retire_delta_tasks(delta_prefetch_t *dp,
+                   int entry)
+{
+  while (   dp->first < dp->next
+         && dp->tasks[dp->first % dp->task_count].entry <= entry)
+    SVN_ERR(retire_delta_task(dp));
+
+  return SVN_NO_ERROR;
+}
+
+/* If the oldest task in DP computes the text delta from S_REV/S_PATH to
+   T_PATH, wait for it and set *WINDOWS to the list of delta windows, if
+   complete.  Set *WINDOWS to NULL in all other cases.  The windows remain
+   valid until the task gets retired. */
+static svn_error_t *
+get_prefetched_delta(apr_array_header_t **windows,
+                     delta_prefetch_t *dp,
+                     svn_revnum_t s_rev,
+                     const char *s_path,
+                     const char *t_path)
+{
+  delta_task_t *task = &dp->tasks[dp->first % dp->task_count];
+
+  *windows = NULL;
+  if (dp->first == dp->next || strcmp(task->t_path, t_path) != 0)
+    return SVN_NO_ERROR;
+
+  if (s_path
+      ? !task->s_path || task->s_rev != s_rev || strcmp(task->s_path, s_path)
+      : task->s_path != NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(wait_for_delta_task(dp, task));
+  if (task->complete)
+    *windows = task->windows;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function releasing the tasks in flight of the
+   delta_prefetch_t in DATA.  Its task set is gone by then. */
+static apr_status_t
+cleanup_delta_prefetch(void *data)
+{
+  delta_prefetch_t *dp = data;
+
+  for (; dp->first < dp->next; dp->first++)
+    svn_pool_destroy(dp->tasks[dp->first % dp->task_count].pool);
+
+  return APR_SUCCESS;
+}
+
+/* Stop all outstanding tasks in DP and discard their results. */
+static svn_error_t *
+finish_delta_prefetch(delta_prefetch_t *dp)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (dp->first < dp->next && !err)
+    err = retire_delta_task(dp);
+
+  svn_pool_destroy(dp->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Set up *DP_P to compute the text deltas for report B concurrently.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+start_delta_prefetch(delta_prefetch_t **dp_p,
+                     report_baton_t *b,
+                     apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = b->repos->fs;
+  delta_prefetch_t *dp;
+  apr_pool_t *pool;
+  svn_error_t *err;
+  int i;
+
+  /* The tasks access the task slots, so these live in a root pool of
+     their own. */
+  pool = svn_pool_create(NULL);
+  dp = apr_pcalloc(pool, sizeof(*dp));
+  dp->pool = pool;
+
+  /* Allow for some look-ahead such that the tasks don't run dry while
+     the main thread is busy sending a large delta. */
+  dp->task_count = 4 * b->delta_jobs;
+  dp->tasks = apr_pcalloc(pool, dp->task_count * sizeof(*dp->tasks));
+  for (i = 0; i < dp->task_count; ++i)
+    dp->tasks[i].dp = dp;
+
+  dp->task_buffer_limit = (b->delta_buffer_limit
+                             ? b->delta_buffer_limit
+                             : DEFAULT_DELTA_BUFFER_LIMIT) / dp->task_count;
+  dp->t_rev = b->t_rev;
+
+  apr_pool_cleanup_register(pool, dp, cleanup_delta_prefetch,
+                            apr_pool_cleanup_null);
+
+  /* The tasks must not use FS itself as the FS API objects are not
+     thread-safe.  The set lives in a sub-pool, which gets destroyed
+     before the cleanups of POOL close the instances and release the
+     tasks. */
+  err = svn_repos__fs_pool_create(&dp->fs_pool, fs, pool);
+  if (!err)
+    err = svn_task__set_create(&dp->set, b->delta_jobs, deliver_delta_task,
+                               dp, NULL, NULL, svn_pool_create(pool));
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *dp_p = dp;
+
+  return SVN_NO_ERROR;
+}
+
 /* Make the appropriate edits on FILE_BATON to change its contents and
    properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
    possibly using LOCK_TOKEN to determine if the client's lock on the file
@@ -708,8 +1099,37 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
 
   if (dhandler != svn_delta_noop_window_handler)
     {
-      if (b->text_deltas)
+      if (b->text_deltas && b->send_fulltexts)
+        {
+          /* Windows consisting of new data only are valid deltas against
+             any source, so the receiver does not need to know about it. */
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_file_contents(&contents, b->t_root, t_path, pool));
+          SVN_ERR(svn_txdelta_send_stream(contents, dhandler, dbaton, NULL,
+                                          pool));
+        }
+      else if (b->text_deltas)
         {
+          /* The delta may already have been computed by some task. */
+          if (b->prefetch)
+            {
+              apr_array_header_t *windows;
+              int i;
+
+              SVN_ERR(get_prefetched_delta(&windows, b->prefetch, s_rev,
+                                           s_path, t_path));
+              if (windows)
+                {
+                  for (i = 0; i < windows->nelts; ++i)
+                    SVN_ERR(dhandler(APR_ARRAY_IDX(windows, i,
+                                                   svn_txdelta_window_t *),
+                                     dbaton));
+
+                  return svn_error_trace(dhandler(NULL, dbaton));
+                }
+            }
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -1099,6 +1519,130 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
 
+/* Find the source for the directory entry T_ENTRY in delta_dirs() while
+   processing the dirents of the target.  S_ENTRIES are the dirents of the
+   source directory S_PATH (either may be NULL).  WC_DEPTH and
+   REQUESTED_DEPTH are those given to delta_dirs().
+
+   Set *SKIP if T_ENTRY is not to be processed at all.  Otherwise, return
+   the source entry and its path in *S_ENTRY and *S_FULLPATH, respectively,
+   or NULL for both if there is none.  Allocate the result in POOL. */
+static void
+get_source_entry(svn_boolean_t *skip,
+                 const svn_fs_dirent_t **s_entry,
+                 const char **s_fullpath,
+                 const svn_fs_dirent_t *t_entry,
+                 apr_hash_t *s_entries,
+                 const char *s_path,
+                 svn_depth_t wc_depth,
+                 svn_depth_t requested_depth,
+                 apr_pool_t *pool)
+{
+  *skip = FALSE;
+  *s_entry = NULL;
+  *s_fullpath = NULL;
+
+  /* If we're making the working copy deeper, pretend the source doesn't
+     exist. */
+  if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+    return;
+
+  if (t_entry->kind == svn_node_file
+      && requested_depth == svn_depth_unknown
+      && wc_depth < svn_depth_files)
+    *skip = TRUE;
+
+  if (t_entry->kind == svn_node_dir
+      && (wc_depth < svn_depth_immediates
+          || requested_depth == svn_depth_files))
+    *skip = TRUE;
+
+  if (*skip)
+    return;
+
+  /* Look for an entry with the same name in the source dirents. */
+  *s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name) : NULL;
+  *s_fullpath = *s_entry ? svn_fspath__join(s_path, t_entry->name, pool)
+                         : NULL;
+}
+
+
+/* Create delta tasks in B->PREFETCH for the file entries following index
+   CURRENT in T_ORDERED_ENTRIES, as far as there are free task slots and
+   until reaching the next sub-directory entry.  *PREFETCHED is the index
+   of the first entry not yet looked at and will be updated accordingly.
+   The other parameters are those of delta_dirs().
+
+   This predicts the text deltas that update_entry() will request for
+   these entries.  Mispredictions are harmless; they only waste some
+   task time.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_file_deltas(report_baton_t *b,
+                     int *prefetched,
+                     int current,
+                     apr_array_header_t *t_ordered_entries,
+                     apr_hash_t *s_entries,
+                     svn_revnum_t s_rev,
+                     const char *s_path,
+                     const char *t_path,
+                     svn_depth_t wc_depth,
+                     svn_depth_t requested_depth,
+                     apr_pool_t *scratch_pool)
+{
+  delta_prefetch_t *dp = b->prefetch;
+  int i;
+
+  for (i = (*prefetched > current) ? *prefetched : current;
+       i < t_ordered_entries->nelts
+         && dp->next - dp->first < (apr_uint64_t)dp->task_count;
+       ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry;
+      const char *s_fullpath;
+      svn_boolean_t skip;
+
+      /* Tasks must not remain outstanding while we recurse. */
+      if (t_entry->kind != svn_node_file)
+        break;
+
+      get_source_entry(&skip, &s_entry, &s_fullpath, t_entry, s_entries,
+                       s_path, wc_depth, requested_depth, scratch_pool);
+      if (skip)
+        continue;
+
+      /* Unchanged files don't need a delta.  Unrelated ones get added
+         and may be sent as copies. */
+      if (s_entry && s_entry->kind == svn_node_file)
+        {
+          int distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+
+          if (distance == 0)
+            continue;
+
+          if (distance == -1 && !b->ignore_ancestry)
+            s_fullpath = NULL;
+        }
+      else
+        {
+          s_fullpath = NULL;
+        }
+
+      if (!s_fullpath && b->send_copyfrom_args)
+        continue;
+
+      SVN_ERR(queue_delta_task(dp, i, s_rev, s_fullpath,
+                               svn_fspath__join(t_path, t_entry->name,
+                                                scratch_pool)));
+    }
+
+  *prefetched = i;
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Emit edits within directory DIR_BATON (with corresponding path
    E_PATH) with the changes from the directory S_REV/S_PATH to the
    directory B->t_rev/T_PATH.  S_PATH may be NULL if the entry does
@@ -1165,6 +1709,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
   int i;
+  int prefetched = 0;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
      source path so that we add all the properties.
@@ -1217,7 +1762,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
               if (s_entries)
                 svn_hash_sets(s_entries, name, NULL);
 
-              svn_pool_destroy(info->pool);
+              release_path_info(b, info);
               continue;
             }
 
@@ -1253,10 +1798,10 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
               && (! info || info->depth != svn_depth_exclude || t_entry))
             svn_hash_sets(s_entries, name, NULL);
 
-          /* pathinfo entries live in their own subpools due to lookahead,
-             so we need to clear each one out as we finish with it. */
+          /* pathinfo entries outlive the iteration due to lookahead,
+             so we need to recycle each one as we finish with it. */
           if (info)
-            svn_pool_destroy(info->pool);
+            release_path_info(b, info);
         }
 
       /* Remove any deleted entries.  Do this before processing the
@@ -1310,34 +1855,21 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
              = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
           const svn_fs_dirent_t *s_entry;
           const char *s_fullpath, *t_fullpath, *e_fullpath;
+          svn_boolean_t skip;
 
           svn_pool_clear(iterpool);
 
-          if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
-            {
-              /* We're making the working copy deeper, pretend the source
-                 doesn't exist. */
-              s_entry = NULL;
-              s_fullpath = NULL;
-            }
-          else
-            {
-              if (t_entry->kind == svn_node_file
-                  && requested_depth == svn_depth_unknown
-                  && wc_depth < svn_depth_files)
-                continue;
-
-              if (t_entry->kind == svn_node_dir
-                  && (wc_depth < svn_depth_immediates
-                      || requested_depth == svn_depth_files))
-                continue;
-
-              /* Look for an entry with the same name in the source dirents. */
-              s_entry = s_entries ?
-                  svn_hash_gets(s_entries, t_entry->name) : NULL;
-              s_fullpath = s_entry ?
-                  svn_fspath__join(s_path, t_entry->name, iterpool) : NULL;
-            }
+          /* Let the tasks compute the upcoming text deltas. */
+          if (b->prefetch)
+            SVN_ERR(prefetch_file_deltas(b, &prefetched, i,
+                                         t_ordered_entries, s_entries,
+                                         s_rev, s_path, t_path, wc_depth,
+                                         requested_depth, iterpool));
+
+          get_source_entry(&skip, &s_entry, &s_fullpath, t_entry, s_entries,
+                           s_path, wc_depth, requested_depth, iterpool);
+          if (skip)
+            continue;
 
           /* Compose the report, editor, and target paths for this entry. */
           e_fullpath = svn_relpath_join(e_path, t_entry->name, iterpool);
@@ -1348,8 +1880,15 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                DEPTH_BELOW_HERE(wc_depth),
                                DEPTH_BELOW_HERE(requested_depth),
                                iterpool));
+
+          if (b->prefetch)
+            SVN_ERR(retire_delta_tasks(b->prefetch, i));
         }
 
+      /* Don't leave tasks behind for entries that we skipped. */
+      if (b->prefetch)
+        SVN_ERR(retire_delta_tasks(b->prefetch, t_ordered_entries->nelts));
+
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
@@ -1424,19 +1963,26 @@ static svn_error_t *
 finish_report(report_baton_t *b, apr_pool_t *pool)
 {
   path_info_t *info;
-  apr_pool_t *subpool;
+  const char *data;
+  apr_size_t len;
   svn_revnum_t s_rev;
   int i;
 
   /* Save our pool to manage the lookahead and fs_root cache with. */
   b->pool = pool;
 
-  /* Add the end marker. */
-  SVN_ERR(svn_spillbuf__reader_write(b->reader, "-", 1, pool));
+  /* Add the end marker, i.e. a 0 flags byte (the string terminator). */
+  SVN_ERR(svn_spillbuf__reader_write(b->reader, "", 1, pool));
+
+  /* Make the whole report accessible in memory. */
+  SVN_ERR(svn_spillbuf__reader_map(&data, &len, b->reader, pool, pool));
+  b->report_pos = (const unsigned char *)data;
+  b->report_end = b->report_pos + len;
+  svn_stringbuf_setempty(b->prev_path);
 
   /* Read the first pathinfo from the report and verify that it is a top-level
      set_path entry. */
-  SVN_ERR(read_path_info(&info, b->reader, pool));
+  SVN_ERR(read_path_info(&info, b));
   if (!info || strcmp(info->path, b->s_operand) != 0
       || info->link_path || !SVN_IS_VALID_REVNUM(info->rev))
     return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
@@ -1444,8 +1990,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   s_rev = info->rev;
 
   /* Initialize the lookahead pathinfo. */
-  subpool = svn_pool_create(pool);
-  SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+  SVN_ERR(read_path_info(&b->lookahead, b));
 
   if (b->lookahead && strcmp(b->lookahead->path, b->s_operand) == 0)
     {
@@ -1463,7 +2008,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
           b->lookahead->depth = info->depth;
         }
       info = b->lookahead;
-      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+      SVN_ERR(read_path_info(&b->lookahead, b));
     }
 
   /* Open the target root and initialize the source root cache. */
@@ -1471,9 +2016,22 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   for (i = 0; i < NUM_CACHED_SOURCE_ROOTS; i++)
     b->s_roots[i] = NULL;
 
+  /* Set up the tasks if we are to compute text deltas concurrently.
+     Without threads, they would only delay the editor drive. */
+  if (   b->delta_jobs > 1 && b->text_deltas && !b->send_fulltexts
+      && svn_task__get_thread_limit() > 0)
+    SVN_ERR(start_delta_prefetch(&b->prefetch, b, pool));
+
   {
     svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
 
+    if (b->prefetch)
+      {
+        err = svn_error_compose_create(err,
+                                       finish_delta_prefetch(b->prefetch));
+        b->prefetch = NULL;
+      }
+
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
 
@@ -1486,6 +2044,26 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
 
 /* --- COLLECTING THE REPORT INFORMATION --- */
 
+/* Append NUM to REP, using the encoding of svn__encode_uint(). */
+static void
+write_number(svn_stringbuf_t *rep, apr_uint64_t num)
+{
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *end = svn__encode_uint(buf, num);
+
+  svn_stringbuf_appendbytes(rep, (const char *)buf, end - buf);
+}
+
+/* Append the length-counted, NUL-terminated string STR to REP. */
+static void
+write_string(svn_stringbuf_t *rep, const char *str)
+{
+  apr_size_t len = strlen(str);
+
+  write_number(rep, len);
+  svn_stringbuf_appendbytes(rep, str, len + 1);
+}
+
 /* Record a report operation into the spill buffer.  Return an error
    if DEPTH is svn_depth_unknown. */
 static svn_error_t *
@@ -1494,39 +2072,62 @@ write_path_info(report_baton_t *b, const char *path, const char *lpath,
                 svn_boolean_t start_empty,
                 const char *lock_token, apr_pool_t *pool)
 {
-  const char *lrep, *rrep, *drep, *ltrep, *rep;
+  svn_stringbuf_t *rep;
+  unsigned char flags = REPORT_ENTRY;
+  apr_size_t len, prefix;
 
   /* Munge the path to be anchor-relative, so that we can use edit paths
      as report paths. */
   path = svn_relpath_join(b->s_operand, path, pool);
 
-  lrep = lpath ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                              strlen(lpath), lpath) : "-";
-  rrep = (SVN_IS_VALID_REVNUM(rev)) ?
-    apr_psprintf(pool, "+%ld:", rev) : "-";
-
   if (depth == svn_depth_exclude)
-    drep = "+X";
+    flags |= REPORT_DEPTH_EXCLUDE << REPORT_DEPTH_SHIFT;
   else if (depth == svn_depth_empty)
-    drep = "+E";
+    flags |= REPORT_DEPTH_EMPTY << REPORT_DEPTH_SHIFT;
   else if (depth == svn_depth_files)
-    drep = "+F";
+    flags |= REPORT_DEPTH_FILES << REPORT_DEPTH_SHIFT;
   else if (depth == svn_depth_immediates)
-    drep = "+M";
+    flags |= REPORT_DEPTH_IMMEDIATES << REPORT_DEPTH_SHIFT;
   else if (depth == svn_depth_infinity)
-    drep = "-";
+    flags |= REPORT_DEPTH_INFINITY << REPORT_DEPTH_SHIFT;
   else
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
                              _("Unsupported report depth '%s'"),
                              svn_depth_to_word(depth));
 
-  ltrep = lock_token ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                                    strlen(lock_token), lock_token) : "-";
-  rep = apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s%s%s%s%c%s",
-                     strlen(path), path, lrep, rrep, drep,
-                     start_empty ? '+' : '-', ltrep);
+  if (lpath)
+    flags |= REPORT_LINK_PATH;
+  if (SVN_IS_VALID_REVNUM(rev))
+    flags |= REPORT_REV;
+  if (start_empty)
+    flags |= REPORT_START_EMPTY;
+  if (lock_token)
+    flags |= REPORT_LOCK_TOKEN;
+
+  /* Only write the part of PATH that differs from the previous one. */
+  len = strlen(path);
+  for (prefix = 0;
+       prefix < len && prefix < b->prev_path->len
+         && path[prefix] == b->prev_path->data[prefix];
+       ++prefix)
+    ;
+
+  rep = svn_stringbuf_create_ensure(len - prefix + 32, pool);
+  svn_stringbuf_appendbyte(rep, (char)flags);
+  write_number(rep, prefix);
+  write_number(rep, len - prefix);
+  svn_stringbuf_appendbytes(rep, path + prefix, len - prefix);
+  if (lpath)
+    write_string(rep, lpath);
+  if (SVN_IS_VALID_REVNUM(rev))
+    write_number(rep, rev);
+  if (lock_token)
+    write_string(rep, lock_token);
+
+  svn_stringbuf_set(b->prev_path, path);
+
   return svn_error_trace(
-            svn_spillbuf__reader_write(b->reader, rep, strlen(rep), pool));
+            svn_spillbuf__reader_write(b->reader, rep->data, rep->len, pool));
 }
 
 svn_error_t *
@@ -1568,9 +2169,13 @@ svn_error_t *
 svn_repos_finish_report(void *baton, apr_pool_t *pool)
 {
   report_baton_t *b = baton;
+  svn_trace__span_t *span;
 
   SVN_ERR(svn_fs_refresh_revision_props(svn_repos_fs(b->repos), pool));
-  return svn_error_trace(finish_report(b, pool));
+
+  span = svn_trace__begin("repos.finish_report");
+  svn_trace__attr_int(span, "revision", b->t_rev);
+  return svn_error_trace(svn_trace__end(span, finish_report(b, pool)));
 }
 
 svn_error_t *
@@ -1579,6 +2184,26 @@ svn_repos_abort_report(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__report_set_delta_jobs(void *baton,
+                                 int jobs,
+                                 apr_size_t max_buffer)
+{
+  report_baton_t *b = baton;
+
+  b->delta_jobs = jobs;
+  b->delta_buffer_limit = max_buffer;
+}
+
+void
+svn_repos__report_set_send_fulltexts(void *baton,
+                                     svn_boolean_t send_fulltexts)
+{
+  report_baton_t *b = baton;
+
+  b->send_fulltexts = send_fulltexts;
+}
+
 /* --- BEGINNING THE REPORT --- */
 
 
@@ -1620,6 +2245,7 @@ svn_repos_begin_report3(void **report_baton,
                           : svn_fspath__join(b->fs_base, s_operand, pool);
   b->text_deltas = text_deltas;
   b->zero_copy_limit = zero_copy_limit;
+  b->send_fulltexts = FALSE;
   b->requested_depth = depth;
   b->ignore_ancestry = ignore_ancestry;
   b->send_copyfrom_args = send_copyfrom_args;
@@ -1628,12 +2254,23 @@ svn_repos_begin_report3(void **report_baton,
   b->edit_baton = edit_baton;
   b->authz_read_func = authz_read_func;
   b->authz_read_baton = authz_read_baton;
-  b->revision_infos = apr_hash_make(pool);
+  b->revision_infos = svn_hash__make_fast(pool);
   b->pool = pool;
-  b->reader = svn_spillbuf__reader_create(1000 /* blocksize */,
-                                          1000000 /* maxsize */,
-                                          pool);
+  b->reader = svn_spillbuf__reader_create_extended(
+                1000 /* blocksize */,
+                svn_spillbuf__adaptive_maxsize(1000000 /* min. maxsize */,
+                                               16 * 1024 * 1024),
+                TRUE /* delete on close */,
+                TRUE /* spill all data */,
+                NULL, pool);
+  b->report_pos = NULL;
+  b->report_end = NULL;
+  b->prev_path = svn_stringbuf_create_empty(pool);
+  b->free_infos = NULL;
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->delta_jobs = 1;
+  b->delta_buffer_limit = 0;
+  b->prefetch = NULL;
 
   /* Hand reporter back to client. */
   *report_baton = b;
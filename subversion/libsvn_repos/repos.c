@@ -979,7 +979,23 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 ""                                                                           NL
 "### This sets the PATH environment variable for the pre-commit hook."       NL
 "[pre-commit]"                                                               NL
-"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL;
+"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL
+""                                                                           NL
+"### The special SVN_HOOK_PLUGIN variable names a shared library that"      NL
+"### implements hooks in-process, without starting a hook script.  The"     NL
+"### start-commit, pre-commit, post-commit and pre-lock hooks may be"       NL
+"### implemented this way.  Relative paths are relative to the hooks"       NL
+"### directory.  A plugin hook runs before the hook script of the same"     NL
+"### name, if there is one."                                                 NL
+"# SVN_HOOK_PLUGIN = /usr/local/lib/libmyhooks.so"                           NL
+""                                                                           NL
+"### Setting the special SVN_HOOK_ASYNC variable to 'yes' for the"          NL
+"### post-commit hook lets commits complete without waiting for it.  The"   NL
+"### hook runs are queued below the db directory and get executed in"      NL
+"### revision order by a background thread of multi-threaded servers."       NL
+"### Other processes still run the hooks before the commit completes."       NL
+"# [post-commit]"                                                            NL
+"# SVN_HOOK_ASYNC = yes"                                                     NL;
 
     SVN_ERR_W(svn_io_file_create(svn_dirent_join(repos->conf_path,
                                                  SVN_REPOS__CONF_HOOKS_ENV \
@@ -1678,7 +1694,8 @@ svn_repos_fs_type(svn_repos_t *repos,
  */
 
 svn_error_t *
-svn_repos_recover4(const char *path,
+svn_repos_recover5(const char *path,
+                   apr_hash_t *fs_config,
                    svn_boolean_t nonblocking,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
@@ -1712,7 +1729,8 @@ svn_repos_recover4(const char *path,
     }
 
   /* Recover the database to a consistent state. */
-  SVN_ERR(svn_fs_recover(repos->db_path, cancel_func, cancel_baton, subpool));
+  SVN_ERR(svn_fs_recover2(repos->db_path, fs_config,
+                          cancel_func, cancel_baton, subpool));
 
   /* Close shop and free the subpool, to release the exclusive lock. */
   svn_pool_destroy(subpool);
@@ -1909,7 +1927,7 @@ static svn_error_t *hotcopy_structure(void *baton,
       return svn_error_trace(err);
     }
   else if (finfo->filetype == APR_REG)
-    return svn_io_copy_file(path, target, TRUE, pool);
+    return svn_io_copy_file2(path, target, SVN_IO_COPY_FILE_PERMS, NULL, pool);
   else if (finfo->filetype == APR_LNK)
     return svn_io_copy_link(path, target, pool);
   else
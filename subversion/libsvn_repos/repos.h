@@ -153,6 +153,10 @@ struct svn_repos_t
      those constants' addresses, therefore). */
   apr_hash_t *repository_capabilities;
 
+  /* Line-to-revision maps of files as computed by
+     svn_repos_get_file_annotation().  Created on demand; see annotate.c. */
+  struct svn_cache__t *annotate_cache;
+
   /* Pool from which this structure was allocated.  Also used for
      auxiliary repository-related data that requires a matching
      lifespan.  (As the svn_repos_t structure tends to be relatively
@@ -219,7 +223,9 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
 
    HOOKS_ENV is a hash of hook script environment information returned
    via svn_repos__parse_hooks_env() (or NULL if no such information is
-   available).
+   available).  If it enables SVN_REPOS_HOOK_ASYNC_OPTION for the hook,
+   only queue the hook run and return; errors are then only reported if
+   that fails.
 
    REV is the revision that was created as a result of the commit.  */
 svn_error_t *
@@ -387,6 +393,133 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+
+/*** Mergeinfo Change Cache ***/
+
+/* Name of the mergeinfo change cache database within the repository's
+   SVN_REPOS__DB_DIR. */
+#define SVN_REPOS__MERGEINFO_CACHE_DB "mergeinfo-cache.db"
+
+/* Persistent cache of the mergeinfo changes per revision, as computed
+   for 'svn log -g'.  See mergeinfo-cache.c. */
+typedef struct svn_repos__mergeinfo_cache_t svn_repos__mergeinfo_cache_t;
+
+/* Open the mergeinfo change cache of REPOS and return it in *CACHE,
+   creating the database if it does not exist, yet.  If that fails,
+   e.g. because we may not write to the repository, set *CACHE to NULL.
+   Allocate *CACHE in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__mergeinfo_cache_open(svn_repos__mergeinfo_cache_t **cache,
+                                svn_repos_t *repos,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* Look up the mergeinfo changes of REV in CACHE.  If found, set
+   *DELETED_P and *ADDED_P to the catalogs of deleted and added mergeinfo,
+   respectively, allocated in RESULT_POOL.  Otherwise, set both to NULL.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__mergeinfo_cache_get(svn_mergeinfo_catalog_t *deleted_p,
+                               svn_mergeinfo_catalog_t *added_p,
+                               svn_repos__mergeinfo_cache_t *cache,
+                               svn_revnum_t rev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* Record the DELETED and ADDED mergeinfo catalogs as the mergeinfo
+   changes of REV in CACHE.  Failures to update the cache are silently
+   ignored.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__mergeinfo_cache_set(svn_repos__mergeinfo_cache_t *cache,
+                               svn_revnum_t rev,
+                               svn_mergeinfo_catalog_t deleted,
+                               svn_mergeinfo_catalog_t added,
+                               apr_pool_t *scratch_pool);
+
+
+/*** Date Index ***/
+
+/* Name of the file within the repository's SVN_REPOS__DB_DIR that maps
+   revision numbers to their svn:date.  See date-index.c. */
+#define SVN_REPOS__DATE_INDEX "rev-dates"
+
+/* Read-only handle to the date index of a repository. */
+typedef struct svn_repos__date_index_t svn_repos__date_index_t;
+
+/* Open the date index of REPOS for reading and return it in *INDEX.
+   Try to bring it up to date with YOUNGEST first, if necessary.  If the
+   index does not exist and cannot be created, e.g. because we may not
+   write to the repository, set *INDEX to NULL.  Allocate *INDEX in
+   RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__date_index_open(svn_repos__date_index_t **index,
+                           svn_repos_t *repos,
+                           svn_revnum_t youngest,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* If INDEX is not NULL and covers REV, set *FOUND to TRUE and *TM to
+   the svn:date of REV as recorded in INDEX.  Otherwise, set *FOUND to
+   FALSE.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__date_index_get(svn_boolean_t *found,
+                          apr_time_t *tm,
+                          svn_repos__date_index_t *index,
+                          svn_revnum_t rev,
+                          apr_pool_t *scratch_pool);
+
+/* Add all revisions of REPOS to its date index that are not in there,
+   yet.  If the index does not exist, create it if CREATE is set and do
+   nothing otherwise.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             apr_pool_t *scratch_pool);
+
+/* Tell the date index of REPOS that the svn:date of REV has been changed
+   to DATE, which may be NULL.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__date_index_set(svn_repos_t *repos,
+                          svn_revnum_t rev,
+                          const svn_string_t *date,
+                          apr_pool_t *scratch_pool);
+
+/* Remove the date index of REPOS, e.g. after finding it to be out of
+   date.  It will be rebuilt on demand.  Use SCRATCH_POOL for
+   temporaries. */
+svn_error_t *
+svn_repos__date_index_remove(svn_repos_t *repos,
+                             apr_pool_t *scratch_pool);
+
+
+/*** Filesystem Instance Pool ***/
+
+/* The FS API objects are not thread-safe.  Tasks running concurrently
+   therefore each need an svn_fs_t of their own.  This pool hands out
+   instances of a given repository, opening them on demand and keeping
+   them around for later tasks.  It is thread-safe. */
+typedef struct svn_repos__fs_pool_t svn_repos__fs_pool_t;
+
+/* Create a pool of instances of the repository of FS in *FS_POOL.  The
+   instances use the same config as FS, so they share its caches.  They
+   will be closed when RESULT_POOL gets cleaned up, which must not happen
+   before the last of them has been released. */
+svn_error_t *
+svn_repos__fs_pool_create(svn_repos__fs_pool_t **fs_pool,
+                          svn_fs_t *fs,
+                          apr_pool_t *result_pool);
+
+/* Set *FS to an instance from FS_POOL that is not used by anybody else.
+   Open a new one if all are in use. */
+svn_error_t *
+svn_repos__fs_pool_acquire(svn_fs_t **fs,
+                           svn_repos__fs_pool_t *fs_pool);
+
+/* Return FS, acquired from FS_POOL, to that pool. */
+svn_error_t *
+svn_repos__fs_pool_release(svn_repos__fs_pool_t *fs_pool,
+                           svn_fs_t *fs);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
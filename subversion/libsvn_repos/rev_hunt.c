@@ -76,26 +76,46 @@ get_time(apr_time_t *tm,
 }
 
 
-svn_error_t *
-svn_repos_dated_revision(svn_revnum_t *revision,
-                         svn_repos_t *repos,
-                         apr_time_t tm,
-                         apr_pool_t *pool)
+/* Set *TM to the time of REV, using the date INDEX if it covers REV.
+   Otherwise, read the revprop from FS.  Use POOL for temporaries. */
+static svn_error_t *
+get_indexed_time(apr_time_t *tm,
+                 svn_repos__date_index_t *index,
+                 svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 apr_pool_t *pool)
+{
+  svn_boolean_t found;
+
+  SVN_ERR(svn_repos__date_index_get(&found, tm, index, rev, pool));
+  if (!found)
+    SVN_ERR(get_time(tm, fs, rev, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of svn_repos_dated_revision.  Binary search for TM in the
+   revisions 0 to REV_LATEST of FS, using the date INDEX where possible.
+   INDEX may be NULL. */
+static svn_error_t *
+find_dated_revision(svn_revnum_t *revision,
+                    svn_repos__date_index_t *index,
+                    svn_fs_t *fs,
+                    svn_revnum_t rev_latest,
+                    apr_time_t tm,
+                    apr_pool_t *pool)
 {
-  svn_revnum_t rev_mid, rev_top, rev_bot, rev_latest;
+  svn_revnum_t rev_mid, rev_top, rev_bot;
   apr_time_t this_time;
-  svn_fs_t *fs = repos->fs;
 
   /* Initialize top and bottom values of binary search. */
-  SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
-  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
   rev_bot = 0;
   rev_top = rev_latest;
 
   while (rev_bot <= rev_top)
     {
       rev_mid = (rev_top + rev_bot) / 2;
-      SVN_ERR(get_time(&this_time, fs, rev_mid, pool));
+      SVN_ERR(get_indexed_time(&this_time, index, fs, rev_mid, pool));
 
       if (this_time > tm)/* we've overshot */
         {
@@ -108,7 +128,8 @@ svn_repos_dated_revision(svn_revnum_t *revision,
             }
 
           /* see if time falls between rev_mid and rev_mid-1: */
-          SVN_ERR(get_time(&previous_time, fs, rev_mid - 1, pool));
+          SVN_ERR(get_indexed_time(&previous_time, index, fs, rev_mid - 1,
+                                   pool));
           if (previous_time <= tm)
             {
               *revision = rev_mid - 1;
@@ -129,7 +150,8 @@ svn_repos_dated_revision(svn_revnum_t *revision,
             }
 
           /* see if time falls between rev_mid and rev_mid+1: */
-          SVN_ERR(get_time(&next_time, fs, rev_mid + 1, pool));
+          SVN_ERR(get_indexed_time(&next_time, index, fs, rev_mid + 1,
+                                   pool));
           if (next_time > tm)
             {
               *revision = rev_mid;
@@ -149,6 +171,74 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if REVISION is a valid result of find_dated_revision for
+   TM in FS with the youngest revision REV_LATEST, according to the
+   actual revprops.  Use POOL for temporaries. */
+static svn_error_t *
+verify_dated_revision(svn_boolean_t *valid,
+                      svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      svn_revnum_t rev_latest,
+                      apr_time_t tm,
+                      apr_pool_t *pool)
+{
+  apr_time_t this_time;
+
+  /* r0 is also the result for times before its own date.  An exact
+     match may be followed by revisions with the same date. */
+  SVN_ERR(get_time(&this_time, fs, revision, pool));
+  *valid = this_time <= tm || revision == 0;
+
+  if (*valid && this_time != tm && revision < rev_latest)
+    {
+      apr_time_t next_time;
+
+      SVN_ERR(get_time(&next_time, fs, revision + 1, pool));
+      *valid = next_time > tm;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_dated_revision(svn_revnum_t *revision,
+                         svn_repos_t *repos,
+                         apr_time_t tm,
+                         apr_pool_t *pool)
+{
+  svn_revnum_t rev_latest;
+  svn_fs_t *fs = repos->fs;
+  svn_repos__date_index_t *index;
+
+  SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  /* Most probes can be answered by the date index instead of reading
+   * revprops.  The latter may require parsing a whole revprop pack. */
+  SVN_ERR(svn_repos__date_index_open(&index, repos, rev_latest, pool,
+                                     pool));
+  SVN_ERR(find_dated_revision(revision, index, fs, rev_latest, tm, pool));
+
+  /* Revprops may have been changed bypassing the repos layer and thus the
+   * index.  Double-check the result; if it is wrong, the index is out of
+   * date and must be rebuilt. */
+  if (index)
+    {
+      svn_boolean_t valid;
+
+      SVN_ERR(verify_dated_revision(&valid, fs, *revision, rev_latest, tm,
+                                    pool));
+      if (!valid)
+        {
+          svn_error_clear(svn_repos__date_index_remove(repos, pool));
+          SVN_ERR(find_dated_revision(revision, NULL, fs, rev_latest, tm,
+                                      pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_repos_get_committed_info(svn_revnum_t *committed_rev,
@@ -36,6 +36,17 @@
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
+/* On x86, we use SSSE3 to translate 12 bytes into 16 chars at once and
+ * vice versa.  It is not part of the x86-64 base ABI, so we detect it at
+ * runtime and only need the compiler to support the intrinsics.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#include <tmmintrin.h>
+#include <cpuid.h>
+#define SVN_BASE64_SSSE3 1
+#endif
+
 /* When asked to format the base64-encoded output as multiple lines,
    we put this many chars in each line (plus one new line char) unless
    we run out of data.
@@ -50,6 +61,77 @@
 static const char base64tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
                                 "abcdefghijklmnopqrstuvwxyz0123456789+/";
 
+#ifdef SVN_BASE64_SSSE3
+
+/* Return TRUE if the CPU supports SSSE3. */
+static svn_boolean_t
+has_ssse3(void)
+{
+  /* 0 = not checked yet, 1 = available, -1 = not available.
+   * Racing threads will simply come to the same conclusion. */
+  static volatile int available = 0;
+
+  if (available == 0)
+    {
+      unsigned int eax, ebx, ecx, edx;
+
+      available = (   __get_cpuid(1, &eax, &ebx, &ecx, &edx)
+                   && (ecx & (1u << 9)))
+                ? 1
+                : -1;
+    }
+
+  return available > 0;
+}
+
+/* Base64-encode up to GROUPS three-byte groups from IN into OUT and
+   return the number of groups actually encoded.  Every iteration reads
+   16 bytes but only consumes 12 of them.  So, the last few groups are
+   left to the caller to not read beyond IN + 3 * GROUPS. */
+__attribute__((target("ssse3")))
+static apr_size_t
+encode_groups_ssse3(char *out, const unsigned char *in, apr_size_t groups)
+{
+  /* Spread bytes B0 B1 B2 over one 32 bit lane as B1 B0 B2 B1. */
+  const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                      4, 5, 3, 4, 1, 2, 0, 1);
+
+  /* Offsets to add to the 6 bit values, selected by value range. */
+  const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '+' - 62,
+                                        '/' - 63, 'A', 0, 0);
+  apr_size_t done = 0;
+
+  for (; groups - done >= 6; done += 4, in += 12, out += 16)
+    {
+      __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in),
+                                   spread);
+      __m128i range;
+
+      /* Move the 4 six-bit values of each lane into separate bytes. */
+      v = _mm_or_si128(
+            _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                            _mm_set1_epi32(0x04000040)),
+            _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                            _mm_set1_epi32(0x01000010)));
+
+      /* 0..25 -> 13, 26..51 -> 0, 52..63 -> 1..12 */
+      range = _mm_subs_epu8(v, _mm_set1_epi8(51));
+      range = _mm_or_si128(range,
+                           _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), v),
+                                         _mm_set1_epi8(13)));
+
+      _mm_storeu_si128((__m128i *)out,
+                       _mm_add_epi8(v, _mm_shuffle_epi8(offsets, range)));
+    }
+
+  return done;
+}
+
+#endif
+
 
 /* Binary input --> base64-encoded output */
 
@@ -85,30 +167,37 @@ encode_group(const unsigned char *in, char *out)
   out[3] = base64tab[part2 & 0x3f];
 }
 
-/* Base64-encode a line, i.e. BYTES_PER_LINE bytes from DATA into
-   BASE64_LINELEN chars and append it to STR.  It does not assume that
-   a new line char will be appended, though.
+/* Base64-encode GROUPS complete groups, i.e. 3 * GROUPS bytes from
+   DATA into 4 * GROUPS chars and append them to STR.  It does not add
+   any new line chars.
    The code in this function will simply transform the data without
    performing any boundary checks.  Therefore, DATA must have at least
-   BYTES_PER_LINE left and space for at least another BASE64_LINELEN
+   3 * GROUPS bytes left and space for at least another 4 * GROUPS
    chars must have been pre-allocated in STR before calling this
    function. */
 static void
-encode_line(svn_stringbuf_t *str, const char *data)
+encode_groups(svn_stringbuf_t *str, const char *data, apr_size_t groups)
 {
   /* Translate directly from DATA to STR->DATA. */
   const unsigned char *in = (const unsigned char *)data;
   char *out = str->data + str->len;
-  char *end = out + BASE64_LINELEN;
+  char *end = out + 4 * groups;
+
+#ifdef SVN_BASE64_SSSE3
+  if (has_ssse3())
+    {
+      apr_size_t done = encode_groups_ssse3(out, in, groups);
+      in += 3 * done;
+      out += 4 * done;
+    }
+#endif
 
-  /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
-     a multiple of 4. */
   for ( ; out != end; in += 3, out += 4)
     encode_group(in, out);
 
   /* Expand and terminate the string. */
   *out = '\0';
-  str->len += BASE64_LINELEN;
+  str->len += 4 * groups;
 }
 
 /* (Continue to) Base64-encode the byte string DATA (of length LEN)
@@ -150,10 +239,13 @@ encode_bytes(svn_stringbuf_t *str, const void *data, apr_size_t len,
           && (*linelen == 0 || !break_lines)
           && (end - p >= BYTES_PER_LINE))
         {
-          /* Yes, we can encode a whole chunk of data at once. */
-          encode_line(str, p);
-          p += BYTES_PER_LINE;
-          *linelen += BASE64_LINELEN;
+          /* Yes, we can encode a whole chunk of data at once.  Without
+             line breaks, that is everything up to the last full group. */
+          apr_size_t groups = break_lines ? BYTES_PER_LINE / 3
+                                          : (apr_size_t)(end - p) / 3;
+          encode_groups(str, p, groups);
+          p += 3 * groups;
+          *linelen += 4 * groups;
         }
       else
         {
@@ -361,28 +453,97 @@ decode_group_directly(const unsigned char *in, char *out)
   return (part0 | part1 | part2 | part3) != (unsigned char)(-1);
 }
 
-/* Base64-encode up to BASE64_LINELEN chars from *DATA and append it to
-   STR.  After the function returns, *DATA will point to the first char
-   that has not been translated, yet.  Returns TRUE if all BASE64_LINELEN
-   chars could be translated, i.e. no special char has been encountered
-   in between.
+#ifdef SVN_BASE64_SSSE3
+
+/* Base64-decode 16 char chunks from *DATA into OUT for as long as they
+   consist of base64 chars only and at least 16 chars are left before
+   END.  Return the number of bytes written to OUT and make *DATA point
+   to the first char not decoded.
+   Every iteration stores 16 bytes of which only 12 are valid.  Hence,
+   OUT must have room for 4 extra bytes. */
+__attribute__((target("ssse3")))
+static apr_size_t
+decode_chunks_ssse3(char *out,
+                    const unsigned char **data,
+                    const unsigned char *end)
+{
+  /* Bit masks classifying chars by their low and high nibble.
+     A char is valid iff the masks for its nibbles don't overlap. */
+  const __m128i lo_class = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1a,
+                                         0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i hi_class = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02,
+                                         0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x10, 0x10);
+
+  /* Offsets that map valid chars to their 6 bit values, selected by
+     the high nibble ('/' being special-cased). */
+  const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                        0, 0, 0, 0, 0, 0, 0, 0);
+
+  /* Pick the 3 valid bytes from each 32 bit lane. */
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                     14, 13, 12, -1, -1, -1, -1);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  const unsigned char *p = *data;
+  char *start = out;
+
+  for (; end - p >= 16; p += 16, out += 12)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)p);
+      __m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), mask_2f);
+      __m128i invalid = _mm_and_si128(
+                          _mm_shuffle_epi8(lo_class,
+                                           _mm_and_si128(v, mask_2f)),
+                          _mm_shuffle_epi8(hi_class, hi));
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128()))
+          != 0xffff)
+        break;
+
+      /* Turn the chars into their 6 bit values. */
+      hi = _mm_add_epi8(hi, _mm_cmpeq_epi8(v, mask_2f));
+      v = _mm_add_epi8(v, _mm_shuffle_epi8(offsets, hi));
+
+      /* Pack 4x6 bits into 3x8 per lane. */
+      v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+      v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+      _mm_storeu_si128((__m128i *)out, _mm_shuffle_epi8(v, pack));
+    }
+
+  *data = p;
+  return out - start;
+}
+
+#endif
+
+/* Base64-decode as many complete groups from *DATA as possible and
+   append the result to STR.  Stop at END or at the first group that
+   contains a special char (e.g. '=' or new line).  After the function
+   returns, *DATA will point to the first char that has not been
+   translated, yet.  Returns TRUE if at least one group has been decoded.
    The code in this function will simply transform the data without
-   performing any boundary checks.  Therefore, DATA must have at least
-   BASE64_LINELEN left and space for at least another BYTES_PER_LINE
-   chars must have been pre-allocated in STR before calling this
-   function. */
+   performing any boundary checks.  Therefore, space for at least another
+   (END - *DATA) / 4 * 3 + 4 chars must have been pre-allocated in STR
+   before calling this function. */
 static svn_boolean_t
-decode_line(svn_stringbuf_t *str, const char **data)
+decode_groups(svn_stringbuf_t *str, const char **data, const char *end)
 {
-  /* Decode up to BYTES_PER_LINE bytes directly from *DATA into STR->DATA. */
+  /* Decode directly from *DATA into STR->DATA. */
   const unsigned char *p = *(const unsigned char **)data;
+  const unsigned char *start = p;
   char *out = str->data + str->len;
-  char *end = out + BYTES_PER_LINE;
 
-  /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
-     a multiple of 4.  Stop translation as soon as we encounter a special
-     char.  Leave the entire group untouched in that case. */
-  for (; out < end; p += 4, out += 3)
+#ifdef SVN_BASE64_SSSE3
+  if (has_ssse3())
+    out += decode_chunks_ssse3(out, &p, (const unsigned char *)end);
+#endif
+
+  /* Stop translation as soon as we encounter a special char.  Leave the
+     entire group untouched in that case. */
+  for (; (const char *)end - (const char *)p >= 4; p += 4, out += 3)
     if (!decode_group_directly(p, out))
       break;
 
@@ -393,7 +554,7 @@ decode_line(svn_stringbuf_t *str, const char **data)
 
   /* Return FALSE, if the caller should continue the decoding process
      using the slow standard method. */
-  return out == end;
+  return p != start;
 }
 
 
@@ -416,23 +577,22 @@ decode_bytes(svn_stringbuf_t *str, const char *data, apr_size_t len,
 
   /* Resize the stringbuf to make room for the maximum size of output,
      to avoid repeated resizes later.  The optimizations in
-     decode_line rely on no resizes being necessary!
+     decode_groups rely on no resizes being necessary!
 
      (*inbuflen+len) is encoded data length
      (*inbuflen+len)/4 is the number of complete 4-bytes sets
      (*inbuflen+len)/4*3 is the number of decoded bytes
+     4 extra bytes may be overwritten by the vector code
      svn_stringbuf_ensure will add an additional byte for the terminating 0.
   */
-  svn_stringbuf_ensure(str, str->len + ((*inbuflen + len) / 4) * 3);
+  svn_stringbuf_ensure(str, str->len + ((*inbuflen + len) / 4) * 3 + 4);
 
   while ( !*done && p < end )
     {
-      /* If no data is left in temporary INBUF and there is at least
-         one line-sized chunk left to decode, we may use the optimized
-         code path. */
-      if ((*inbuflen == 0) && (end - p >= BASE64_LINELEN))
-        if (decode_line(str, &p))
-          continue;
+      /* If no data is left in temporary INBUF, we may use the optimized
+         code path up to the next special char. */
+      if ((*inbuflen == 0) && decode_groups(str, &p, end))
+        continue;
 
       /* A special case or decode_line encountered a special char. */
       if (*p == '=')
@@ -453,6 +453,95 @@ inprocess_cache_set(void *cache_void,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+inprocess_cache_get_many_internal(char **buffers,
+                                  apr_size_t *sizes,
+                                  inprocess_cache_t *cache,
+                                  const void * const *keys,
+                                  int count,
+                                  apr_pool_t *result_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      SVN_ERR(inprocess_cache_get_internal(&buffers[i], &sizes[i], cache,
+                                           keys[i], result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inprocess_cache_get_many(void **values,
+                         svn_boolean_t *found,
+                         void *cache_void,
+                         const void * const *keys,
+                         int count,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  inprocess_cache_t *cache = cache_void;
+  char **buffers = apr_pcalloc(scratch_pool, count * sizeof(*buffers));
+  apr_size_t *sizes = apr_pcalloc(scratch_pool, count * sizeof(*sizes));
+  int i;
+
+  /* Copy all buffers while holding the lock just once. */
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       inprocess_cache_get_many_internal(buffers,
+                                                         sizes,
+                                                         cache,
+                                                         keys,
+                                                         count,
+                                                         result_pool));
+
+  /* deserialize the buffer contents outside the lock. */
+  for (i = 0; i < count; ++i)
+    {
+      found[i] = (buffers[i] != NULL);
+      if (!buffers[i] || !sizes[i])
+        values[i] = NULL;
+      else
+        SVN_ERR(cache->deserialize_func(&values[i], buffers[i], sizes[i],
+                                        result_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inprocess_cache_set_many_internal(inprocess_cache_t *cache,
+                                  const void * const *keys,
+                                  void * const *values,
+                                  int count,
+                                  apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      SVN_ERR(inprocess_cache_set_internal(cache, keys[i], values[i],
+                                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inprocess_cache_set_many(void *cache_void,
+                         const void * const *keys,
+                         void * const *values,
+                         int count,
+                         apr_pool_t *scratch_pool)
+{
+  inprocess_cache_t *cache = cache_void;
+
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       inprocess_cache_set_many_internal(cache,
+                                                         keys,
+                                                         values,
+                                                         count,
+                                                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type for svn_cache__iter. */
 struct cache_iter_baton {
   svn_iter_apr_hash_cb_t user_cb;
@@ -640,7 +729,9 @@ static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_is_cachable,
   inprocess_cache_get_partial,
   inprocess_cache_set_partial,
-  inprocess_cache_get_info
+  inprocess_cache_get_info,
+  inprocess_cache_get_many,
+  inprocess_cache_set_many
 };
 
 svn_error_t *
@@ -22,7 +22,10 @@
  */
 
 #include <assert.h>
+#include <apr_global_mutex.h>
 #include <apr_md5.h>
+#include <apr_portable.h>
+#include <apr_shm.h>
 #include <apr_thread_rwlock.h>
 
 #include "svn_pools.h"
@@ -39,7 +42,6 @@
 #include "private/svn_string_private.h"
 
 #include "cache.h"
-#include "fnv1a.h"
 
 /*
  * This svn_cache__t implementation actually consists of two parts:
@@ -63,8 +65,15 @@
  * Only the start address of these two data parts are given as a native
  * pointer. All other references are expressed as offsets to these pointers.
  * With that design, it is relatively easy to share the same data structure
- * between different processes and / or to persist them on disk. These
- * out-of-process features have not been implemented, yet.
+ * between different processes and / or to persist them on disk.
+ *
+ * Forking servers may place the whole cache, i.e. the segment headers as
+ * well as the directories and data buffers, in a single shared memory
+ * region (see svn_cache__membuffer_cache_create_shared).  Since the region
+ * gets created before the first child is forked, it will be mapped to the
+ * same address in all processes and native pointers remain valid.  Access
+ * is then serialized by inter-process locks.  Persisting the cache on disk
+ * has not been implemented, yet.
  *
  * Superficially, cache levels are being used as usual: insertion happens
  * into L1 and evictions will promote items to L2.  But their whole point
@@ -106,6 +115,15 @@
  * with new entries. For details on the fine-tuning involved, see the
  * comments in ensure_data_insertable_l2().
  *
+ * Bulk operations like export or verify may stream large amounts of data
+ * through the cache that will not be needed again.  Cache instances may
+ * therefore opt into a scan-resistant admission policy: their items will
+ * only be promoted from L1 to L2 if they got hit while in L1 or if they
+ * have been written to the cache repeatedly within a recent time window.
+ * The latter is tracked by a small frequency sketch of saturating counters
+ * per segment, similar to a "ghost list" of recently evicted keys.  It gets
+ * aged by halving all counters periodically (see record_write).
+ *
  * Due to the randomized mapping of keys to entry groups, some groups may
  * overflow.  In that case, there are spare groups that can be chained to
  * an already used group to extend it.
@@ -129,6 +147,16 @@
  * to scale well despite that bottleneck, we simply segment the cache into
  * a number of independent caches (segments). Items will be multiplexed based
  * on their hash key.
+ *
+ * Even within a segment, readers may still contend for the cache line that
+ * holds the lock's reader count, e.g. when many threads look up the same
+ * hot items.  Therefore, a segment may use multiple read-write locks
+ * ("lock stripes").  Readers only acquire the stripe selected by their
+ * thread ID while writers must acquire all stripes of the segment.
+ *
+ * Neither the directory nor the data buffer get touched when the cache is
+ * being created.  On NUMA machines, their pages will therefore be placed
+ * on the node of the thread that first uses them.
  */
 
 /* APR's read-write lock implementation on Windows is horribly inefficient.
@@ -164,6 +192,11 @@
  */
 #define MIN_SEGMENT_SIZE APR_UINT64_C(0x10000)
 
+/* The maximum number of read-write locks per segment.  More stripes reduce
+ * contention between readers but make write access more expensive.
+ */
+#define MAX_LOCK_STRIPES 64
+
 /* The maximum number of segments allowed. Larger numbers reduce the size
  * of each segment, in turn reducing the max size of a cachable item.
  * Also, each segment gets its own lock object. The actual number supported
@@ -186,6 +219,26 @@
  */
 #define GROUP_INIT_GRANULARITY 32
 
+/* Saturation value of the counters in the frequency sketch.
+ */
+#define MAX_WRITE_FREQUENCY 15
+
+/* The frequency sketch counters get halved after that many writes per
+ * sketch counter.
+ */
+#define SKETCH_AGING_FACTOR 8
+
+/* Lock mechanism used for caches in shared memory.  fcntl() locks are
+ * released automatically if the process holding them dies.  Moreover,
+ * child processes closing the lock file upon exit does not affect the
+ * lock in any other process.
+ */
+#if APR_HAS_FCNTL_SERIALIZE
+#  define SHARED_LOCK_MECH APR_LOCK_FCNTL
+#else
+#  define SHARED_LOCK_MECH APR_LOCK_DEFAULT
+#endif
+
 /* Invalid index reference value. Equivalent to APR_UINT32_T(-1)
  */
 #define NO_INDEX APR_UINT32_MAX
@@ -563,7 +616,7 @@ typedef struct entry_t
    * above ensures that there will be no overflows.
    * Only valid for used entries.
    */
-  apr_size_t size;
+  apr_uint32_t size;
 
   /* Number of (read) hits for this entry. Will be reset upon write.
    * Only valid for used entries.
@@ -589,6 +642,11 @@ typedef struct entry_t
    * priority items.
    */
   apr_uint32_t priority;
+
+  /* The svn_cache__admission_t policy that decides whether this entry
+   * may be promoted to L2.
+   */
+  apr_uint32_t admission;
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
   /* Remember type, content and key hashes.
    */
@@ -767,6 +825,20 @@ struct svn_membuffer_t
    */
   cache_level_t l2;
 
+  /* Frequency sketch with SKETCH_MASK+1 saturating counters.  Counts how
+   * often items of scan-resistant caches have been written to this
+   * segment.  Only accessed by writers.  Never NULL.
+   */
+  unsigned char *sketch;
+
+  /* Number of elements in SKETCH minus 1.  SKETCH_MASK+1 is a power of 2.
+   */
+  apr_uint32_t sketch_mask;
+
+  /* Number of counter increments in SKETCH since it was last aged.
+   */
+  apr_uint64_t sketch_samples;
+
 
   /* Number of used dictionary entries, i.e. number of cached items.
    * Purely statistical information that may be used for profiling only.
@@ -796,6 +868,38 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Number of items evicted from L1 that got promoted to L2.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_promotions;
+
+  /* Number of items evicted from L1 that did not find room in L2.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_l1_evictions;
+
+  /* Number of items evicted from L1 that were not admitted to L2 by their
+   * scan-resistant admission policy.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_rejections;
+
+  /* Number of items dropped from L2 to make room for other items.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_l2_evictions;
+
+  /* Number of items dropped because their entry group overflowed.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_conflicts;
+
+  /* Inter-process lock that serializes all access to this segment if the
+   * cache resides in shared memory.  Readers and writers alike acquire it
+   * exclusively.  NULL for process-local caches.
+   */
+  apr_global_mutex_t *shared_lock;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -803,8 +907,14 @@ struct svn_membuffer_t
    */
   svn_mutex__t *lock;
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  /* Same for read-write lock. */
-  apr_thread_rwlock_t *lock;
+  /* Same for read-write locks.  Readers acquire only one of them (see
+   * get_read_lock) while writers must acquire all of them in ascending
+   * order.  NULL if the cache is not thread-safe.
+   */
+  apr_thread_rwlock_t **locks;
+
+  /* Number of elements in LOCKS.  Always a power of two. */
+  apr_uint32_t lock_count;
 
   /* If set, write access will wait until they get exclusive access.
    * Otherwise, they will become no-ops if the segment is currently
@@ -823,17 +933,99 @@ struct svn_membuffer_t
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+
+/* Return the read-write lock that the current thread shall use to read
+ * from CACHE.  The selection is stable for any given thread.
+ */
+static APR_INLINE apr_thread_rwlock_t *
+get_read_lock(svn_membuffer_t *cache)
+{
+  apr_os_thread_t thread_id;
+  apr_uint64_t hash = 0;
+
+  if (cache->lock_count == 1)
+    return cache->locks[0];
+
+  /* The thread ID is an opaque type.  Thus, simply hash its first bytes
+   * and use the upper bits of the result to select the stripe. */
+  thread_id = apr_os_thread_current();
+  memcpy(&hash, &thread_id, MIN(sizeof(hash), sizeof(thread_id)));
+  hash *= APR_UINT64_C(0x9e3779b97f4a7c15);
+
+  return cache->locks[(apr_uint32_t)(hash >> 32) & (cache->lock_count - 1)];
+}
+
+/* Acquire all read-write locks of CACHE for writing.  If BLOCKING is not
+ * set, return the error status of the first lock that could not be
+ * acquired immediately.  In that case, no lock will be held upon return.
+ */
+static apr_status_t
+write_lock_stripes(svn_membuffer_t *cache, svn_boolean_t blocking)
+{
+  apr_uint32_t i;
+  for (i = 0; i < cache->lock_count; ++i)
+    {
+      apr_status_t status = blocking
+                          ? apr_thread_rwlock_wrlock(cache->locks[i])
+                          : apr_thread_rwlock_trywrlock(cache->locks[i]);
+      if (status)
+        {
+          /* Release what we got so far in reverse order. */
+          while (i > 0)
+            apr_thread_rwlock_unlock(cache->locks[--i]);
+
+          return status;
+        }
+    }
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+/* Acquire the inter-process lock of the shared memory segment CACHE.
+ */
+static svn_error_t *
+lock_shared_cache(svn_membuffer_t *cache)
+{
+  apr_status_t status = apr_global_mutex_lock(cache->shared_lock);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the inter-process lock of the shared memory segment CACHE.
+ * Return ERR upon success.
+ */
+static svn_error_t *
+unlock_shared_cache(svn_membuffer_t *cache, svn_error_t *err)
+{
+  apr_status_t status = apr_global_mutex_unlock(cache->shared_lock);
+  if (err)
+    return err;
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->shared_lock)
+    return lock_shared_cache(cache);
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
+  if (cache->locks)
   {
-    apr_status_t status = apr_thread_rwlock_rdlock(cache->lock);
+    apr_status_t status = apr_thread_rwlock_rdlock(get_read_lock(cache));
     if (status)
       return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
   }
@@ -851,19 +1043,22 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+  if (cache->shared_lock)
+    return lock_shared_cache(cache);
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
+  if (cache->locks)
     {
       apr_status_t status;
       if (cache->allow_blocking_writes)
         {
-          status = apr_thread_rwlock_wrlock(cache->lock);
+          status = write_lock_stripes(cache, TRUE);
         }
       else
         {
-          status = apr_thread_rwlock_trywrlock(cache->lock);
+          status = write_lock_stripes(cache, FALSE);
           if (SVN_LOCK_IS_BUSY(status))
             {
               *success = FALSE;
@@ -888,13 +1083,19 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->shared_lock)
+    return lock_shared_cache(cache);
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
-  if (status)
-    return svn_error_wrap_apr(status,
-                              _("Can't write-lock cache mutex"));
+  if (cache->locks)
+    {
+      apr_status_t status = write_lock_stripes(cache, TRUE);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't write-lock cache mutex"));
+    }
 
   return SVN_NO_ERROR;
 #else
@@ -902,18 +1103,60 @@ force_write_lock_cache(svn_membuffer_t *cache)
 #endif
 }
 
-/* If locking is supported for CACHE, release the current lock
- * (read or write).  Return ERR upon success.
+/* If locking is supported for CACHE, release the current read lock.
+ * Return ERR upon success.
+ */
+static svn_error_t *
+read_unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
+{
+  if (cache->shared_lock)
+    return unlock_shared_cache(cache, err);
+
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  return svn_mutex__unlock(cache->lock, err);
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  if (cache->locks)
+  {
+    apr_status_t status = apr_thread_rwlock_unlock(get_read_lock(cache));
+    if (err)
+      return err;
+
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+  }
+
+  return err;
+#else
+  return err;
+#endif
+}
+
+/* If locking is supported for CACHE, release the current write lock.
+ * Return ERR upon success.
  */
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+  if (cache->shared_lock)
+    return unlock_shared_cache(cache, err);
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
+  if (cache->locks)
   {
-    apr_status_t status = apr_thread_rwlock_unlock(cache->lock);
+    apr_status_t status = APR_SUCCESS;
+    apr_uint32_t i = cache->lock_count;
+
+    /* Release in reverse order of acquisition. */
+    while (i > 0)
+      {
+        apr_status_t unlock_status
+          = apr_thread_rwlock_unlock(cache->locks[--i]);
+        if (!status)
+          status = unlock_status;
+      }
+
     if (err)
       return err;
 
@@ -930,10 +1173,10 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 /* If supported, guard the execution of EXPR with a read lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
-#define WITH_READ_LOCK(cache, expr)         \
-do {                                        \
-  SVN_ERR(read_lock_cache(cache));          \
-  SVN_ERR(unlock_cache(cache, (expr)));     \
+#define WITH_READ_LOCK(cache, expr)             \
+do {                                            \
+  SVN_ERR(read_lock_cache(cache));              \
+  SVN_ERR(read_unlock_cache(cache, (expr)));    \
 } while (0)
 
 /* If supported, guard the execution of EXPR with a write lock to CACHE.
@@ -1539,6 +1782,7 @@ find_entry(svn_membuffer_t *cache,
               let_entry_age(cache, &to_shrink->entries[i]);
 
           drop_entry(cache, entry);
+          cache->total_conflicts++;
         }
 
       /* initialize entry for the new key
@@ -1617,6 +1861,91 @@ promote_entry(svn_membuffer_t *cache, entry_t *entry)
   chain_entry(cache, &cache->l2, entry, idx);
 }
 
+/* Set *IDX1 and *IDX2 to the two counters in CACHE's frequency sketch
+ * that represent KEY.  Because keys of fixed-size caches are not hashed,
+ * scramble all of KEY before selecting the counters.
+ */
+static void
+get_sketch_indexes(apr_uint32_t *idx1,
+                   apr_uint32_t *idx2,
+                   svn_membuffer_t *cache,
+                   const entry_key_t *key)
+{
+  apr_uint64_t hash = (key->fingerprint[0] ^ key->prefix_idx)
+                    * APR_UINT64_C(0x9e3779b97f4a7c15);
+  hash = (hash ^ key->fingerprint[1]) * APR_UINT64_C(0xc2b2ae3d27d4eb4f);
+
+  *idx1 = (apr_uint32_t)(hash >> 32) & cache->sketch_mask;
+  *idx2 = (apr_uint32_t)(hash >> 8) & cache->sketch_mask;
+}
+
+/* Return the estimated number of times that KEY has recently been
+ * written to CACHE.  This may overestimate but never underestimates
+ * the true number (up to MAX_WRITE_FREQUENCY).
+ */
+static apr_uint32_t
+get_write_frequency(svn_membuffer_t *cache,
+                    const entry_key_t *key)
+{
+  apr_uint32_t idx1, idx2;
+  get_sketch_indexes(&idx1, &idx2, cache, key);
+
+  return MIN(cache->sketch[idx1], cache->sketch[idx2]);
+}
+
+/* Count another write of KEY to CACHE in its frequency sketch.  Age all
+ * counters once the number of recorded writes exceeds the sketch size
+ * by SKETCH_AGING_FACTOR such that old access patterns are forgotten.
+ *
+ * Note: This function requires the caller to hold the write lock of CACHE.
+ */
+static void
+record_write(svn_membuffer_t *cache,
+             const entry_key_t *key)
+{
+  apr_uint32_t idx1, idx2;
+  apr_uint32_t frequency;
+  get_sketch_indexes(&idx1, &idx2, cache, key);
+
+  /* Conservative update: only increment the counters that determine the
+   * current estimate.  This reduces the overestimation due to conflicts.
+   */
+  frequency = MIN(cache->sketch[idx1], cache->sketch[idx2]);
+  if (frequency < MAX_WRITE_FREQUENCY)
+    {
+      if (cache->sketch[idx1] == frequency)
+        cache->sketch[idx1]++;
+      if (cache->sketch[idx2] == frequency)
+        cache->sketch[idx2]++;
+    }
+
+  if (++cache->sketch_samples
+      > SKETCH_AGING_FACTOR * ((apr_uint64_t)cache->sketch_mask + 1))
+    {
+      apr_uint32_t i;
+      for (i = 0; i <= cache->sketch_mask; ++i)
+        cache->sketch[i] >>= 1;
+
+      cache->sketch_samples /= 2;
+    }
+}
+
+/* Return TRUE if the admission policy of ENTRY in CACHE allows it to
+ * compete for space in L2 when it gets evicted from L1.
+ */
+static svn_boolean_t
+is_admissible_to_l2(svn_membuffer_t *cache,
+                    entry_t *entry)
+{
+  if (entry->admission != svn_cache__admission_scan_resistant)
+    return TRUE;
+
+  /* Items that have been read or re-written since they have been added
+   * are unlikely to be part of a single, sequential scan. */
+  return entry->hit_count > 0
+      || get_write_frequency(cache, &entry->key) > 1;
+}
+
 /* This function implements the cache insertion / eviction strategy for L2.
  *
  * If necessary, enlarge the insertion window of CACHE->L2 until it is at
@@ -1756,6 +2085,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
               drop_entry(cache, entry);
+              cache->total_l2_evictions++;
             }
         }
     }
@@ -1813,17 +2143,28 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
       else
         {
           /* Remove the entry from the end of insertion window and promote
-           * it to L2, if it is important enough.
+           * it to L2, if it is admissible and important enough.
            */
-          svn_boolean_t keep = ensure_data_insertable_l2(cache, entry);
+          svn_boolean_t admissible = is_admissible_to_l2(cache, entry);
+          svn_boolean_t keep = admissible
+                            && ensure_data_insertable_l2(cache, entry);
 
           /* We might have touched the group that contains ENTRY. Recheck. */
           if (entry_index == cache->l1.next)
             {
               if (keep)
-                promote_entry(cache, entry);
+                {
+                  promote_entry(cache, entry);
+                  cache->total_promotions++;
+                }
               else
-                drop_entry(cache, entry);
+                {
+                  drop_entry(cache, entry);
+                  if (admissible)
+                    cache->total_l1_evictions++;
+                  else
+                    cache->total_rejections++;
+                }
             }
         }
     }
@@ -1832,31 +2173,98 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Create a shared memory block of SIZE bytes, allocated in POOL, and
+ * return its base address in *SHM_BASE.  If SHM_NAME is not NULL, it will
+ * be a named region and any stale region of that name will be removed.
+ */
+static svn_error_t *
+create_shared_memory(char **shm_base,
+                     apr_size_t size,
+                     const char *shm_name,
+                     apr_pool_t *pool)
+{
+  apr_shm_t *shm;
+  apr_status_t status;
+
+  if (shm_name)
+    apr_shm_remove(shm_name, pool);
+
+  status = apr_shm_create(&shm, size, shm_name, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create shared memory for the cache"));
+
+  *shm_base = apr_shm_baseaddr_get(shm);
+  return SVN_NO_ERROR;
+}
+
+/* Return SIZE bytes of memory for the cache structures.  If *SHM_BASE is
+ * not NULL, take them from the shared memory block at that address and
+ * advance *SHM_BASE by SIZE rounded up to full GROUP_BLOCK_SIZE units.
+ * Otherwise, allocate from POOL.  Zero the memory if CLEAR is set.
+ */
+static void *
+allocate_cache_memory(char **shm_base,
+                      apr_size_t size,
+                      svn_boolean_t clear,
+                      apr_pool_t *pool)
+{
+  void *result;
+  if (*shm_base == NULL)
+    return clear ? apr_pcalloc(pool, size) : apr_palloc(pool, size);
+
+  result = *shm_base;
+  *shm_base += APR_ALIGN(size, GROUP_BLOCK_SIZE);
+  if (clear)
+    memset(result, 0, size);
+
+  return result;
+}
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  If SHARED is set, place all
+ * cache structures in a shared memory region named SHM_NAME (may be NULL)
+ * and use inter-process locks instead of the ones selected by THREAD_SAFE,
+ * LOCK_STRIPES and ALLOW_BLOCKING_WRITES.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       apr_size_t lock_stripes,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       const char *shm_name,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  char *shm_base = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
   apr_uint32_t main_group_count;
   apr_uint32_t spare_group_count;
   apr_uint32_t group_init_size;
+  apr_uint32_t sketch_size;
   apr_uint64_t data_size;
   apr_uint64_t max_entry_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Shared caches can't use it because its indexes are process-local.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
-  total_size -= total_size / 100;
+  if (shared)
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, 0, FALSE, pool));
+    }
+  else
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
+                                 pool));
+      total_size -= total_size / 100;
+    }
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1877,6 +2285,15 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   while ((segment_count & (segment_count-1)) != 0)
     segment_count &= segment_count-1;
 
+  /* Same for the number of lock stripes.  Use at least one lock.
+   */
+  if (lock_stripes > MAX_LOCK_STRIPES)
+    lock_stripes = MAX_LOCK_STRIPES;
+  while ((lock_stripes & (lock_stripes-1)) != 0)
+    lock_stripes &= lock_stripes-1;
+  if (lock_stripes < 1)
+    lock_stripes = 1;
+
   /* if the caller hasn't provided a reasonable segment count or the above
    * limitations set it to 0, derive one from the absolute cache size
    */
@@ -1910,9 +2327,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1963,6 +2377,34 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Use a few frequency counters per entry to keep the number of false
+   * positives low.  Their number must be a power of 2.
+   */
+  sketch_size = main_group_count * GROUP_SIZE * 4;
+  while ((sketch_size & (sketch_size-1)) != 0)
+    sketch_size &= sketch_size-1;
+
+  /* Shared caches get all of their memory from a single region.
+   */
+  if (shared)
+    {
+      apr_size_t segment_size
+        = APR_ALIGN(group_count * sizeof(entry_group_t), GROUP_BLOCK_SIZE)
+        + APR_ALIGN(group_init_size, GROUP_BLOCK_SIZE)
+        + APR_ALIGN(sketch_size, GROUP_BLOCK_SIZE)
+        + APR_ALIGN((apr_size_t)ALIGN_VALUE(data_size), GROUP_BLOCK_SIZE);
+      apr_size_t shm_size
+        = APR_ALIGN(segment_count * sizeof(*c), GROUP_BLOCK_SIZE)
+        + segment_count * segment_size;
+
+      SVN_ERR(create_shared_memory(&shm_base, shm_size, shm_name, pool));
+    }
+
+  /* allocate cache as an array of segments / cache objects */
+  c = allocate_cache_memory(&shm_base, segment_count * sizeof(*c), FALSE,
+                            pool);
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1978,12 +2420,21 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory
+        = allocate_cache_memory(&shm_base,
+                                group_count * sizeof(entry_group_t),
+                                FALSE, pool);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized
+        = allocate_cache_memory(&shm_base, group_init_size, TRUE, pool);
+
+      /* Nothing has been written, yet. */
+      c[seg].sketch
+        = allocate_cache_memory(&shm_base, sketch_size, TRUE, pool);
+      c[seg].sketch_mask = sketch_size - 1;
+      c[seg].sketch_samples = 0;
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2004,7 +2455,10 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data
+        = allocate_cache_memory(&shm_base,
+                                (apr_size_t)ALIGN_VALUE(data_size),
+                                FALSE, pool);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2012,6 +2466,11 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].total_promotions = 0;
+      c[seg].total_l1_evictions = 0;
+      c[seg].total_rejections = 0;
+      c[seg].total_l2_evictions = 0;
+      c[seg].total_conflicts = 0;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
@@ -2023,6 +2482,20 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
           return svn_error_wrap_apr(APR_ENOMEM, "OOM");
         }
 
+      /* Shared caches are always being synchronized between processes as
+       * well as between threads.
+       */
+      c[seg].shared_lock = NULL;
+      if (shared)
+        {
+          apr_status_t status
+            = apr_global_mutex_create(&c[seg].shared_lock, NULL,
+                                      SHARED_LOCK_MECH, pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create cache mutex"));
+        }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
       /* A lock for intra-process synchronization to the cache, or NULL if
        * the cache's creator doesn't feel the cache needs to be
@@ -2030,14 +2503,22 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        */
       SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-      /* Same for read-write lock. */
-      c[seg].lock = NULL;
+      /* Same for read-write locks. */
+      c[seg].locks = NULL;
+      c[seg].lock_count = (apr_uint32_t)lock_stripes;
       if (thread_safe)
         {
-          apr_status_t status =
-              apr_thread_rwlock_create(&(c[seg].lock), pool);
-          if (status)
-            return svn_error_wrap_apr(status, _("Can't create cache mutex"));
+          apr_uint32_t i;
+          c[seg].locks = apr_palloc(pool,
+                                    lock_stripes * sizeof(*c[seg].locks));
+          for (i = 0; i < c[seg].lock_count; ++i)
+            {
+              apr_status_t status =
+                  apr_thread_rwlock_create(&(c[seg].locks[i]), pool);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't create cache mutex"));
+            }
         }
 
       /* Select the behavior of write operations.
@@ -2054,6 +2535,45 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  apr_size_t lock_stripes,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count, lock_stripes,
+                                                thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, NULL, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         const char *shm_name,
+                                         apr_pool_t *pool)
+{
+#if APR_HAS_FORK && APR_HAS_SHARED_MEMORY
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count, 1,
+                                                FALSE, TRUE,
+                                                TRUE, shm_name, pool));
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Shared memory caches require fork() and "
+                            "shared memory support"));
+#endif
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
@@ -2101,6 +2621,10 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       cache[seg].data_used = 0;
       cache[seg].used_entries = 0;
 
+      /* Forget about past writes. */
+      memset(cache[seg].sketch, 0, (apr_size_t)cache[seg].sketch_mask + 1);
+      cache[seg].sketch_samples = 0;
+
       /* Segment may be used again. */
       SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
     }
@@ -2166,7 +2690,7 @@ select_level(svn_membuffer_t *cache,
       /* Large but important items go into L2. */
       entry_t dummy_entry = { { { 0 } } };
       dummy_entry.priority = priority;
-      dummy_entry.size = size;
+      dummy_entry.size = (apr_uint32_t)size;
 
       return ensure_data_insertable_l2(cache, &dummy_entry)
            ? &cache->l2
@@ -2179,7 +2703,8 @@ select_level(svn_membuffer_t *cache,
 
 /* Try to insert the serialized item given in BUFFER with ITEM_SIZE
  * into the group GROUP_INDEX of CACHE and uniquely identify it by
- * hash value TO_FIND.
+ * hash value TO_FIND.  The item shall be subject to the given PRIORITY
+ * and the svn_cache__admission_t ADMISSION policy.
  *
  * However, there is no guarantee that it will actually be put into
  * the cache. If there is already some data associated with TO_FIND,
@@ -2196,6 +2721,7 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
                              char *buffer,
                              apr_size_t item_size,
                              apr_uint32_t priority,
+                             svn_cache__admission_t admission,
                              DEBUG_CACHE_MEMBUFFER_TAG_ARG
                              apr_pool_t *scratch_pool)
 {
@@ -2209,6 +2735,11 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
    * membuffer in single-threaded mode. */
   assert(0 == svn_atomic_inc(&cache->write_lock_count));
 
+  /* Repeated writes indicate that the item is not part of a one-off scan.
+   */
+  if (admission == svn_cache__admission_scan_resistant)
+    record_write(cache, &to_find->entry_key);
+
   /* Quick check make sure arithmetics will work further down the road. */
   size = item_size + to_find->entry_key.key_len;
   if (size < item_size)
@@ -2228,8 +2759,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
        * negative value.
        */
       cache->data_used += (apr_uint64_t)size - entry->size;
-      entry->size = size;
+      entry->size = (apr_uint32_t)size;
       entry->priority = priority;
+      entry->admission = admission;
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
 
@@ -2265,9 +2797,10 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
        * the serialized item's (future) position within data buffer.
        */
       entry = find_entry(cache, group_index, to_find, TRUE);
-      entry->size = size;
+      entry->size = (apr_uint32_t)size;
       entry->offset = level->current_data;
       entry->priority = priority;
+      entry->admission = admission;
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
 
@@ -2314,7 +2847,7 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
  * However, there is no guarantee that it will actually be put into
  * the cache. If there is already some data associated to the KEY,
  * it will be removed from the cache even if the new data cannot
- * be inserted.
+ * be inserted.  PRIORITY and ADMISSION control the item's eviction.
  *
  * The SERIALIZER is called to transform the ITEM into a single,
  * flat data buffer. Temporary allocations may be done in POOL.
@@ -2325,6 +2858,7 @@ membuffer_cache_set(svn_membuffer_t *cache,
                     void *item,
                     svn_cache__serialize_func_t serializer,
                     apr_uint32_t priority,
+                    svn_cache__admission_t admission,
                     DEBUG_CACHE_MEMBUFFER_TAG_ARG
                     apr_pool_t *scratch_pool)
 {
@@ -2350,11 +2884,192 @@ membuffer_cache_set(svn_membuffer_t *cache,
                                                buffer,
                                                size,
                                                priority,
+                                               admission,
                                                DEBUG_CACHE_MEMBUFFER_TAG
                                                scratch_pool));
   return SVN_NO_ERROR;
 }
 
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Map each of the COUNT KEYS to the CACHE segment and group that shall
+ * contain the respective item.  Return them in SEGMENTS and GROUP_INDEXES,
+ * respectively, allocated in SCRATCH_POOL.  For NULL keys, the segment
+ * will be NULL as well.
+ */
+static void
+get_group_indexes(svn_membuffer_t ***segments,
+                  apr_uint32_t **group_indexes,
+                  svn_membuffer_t *cache,
+                  const full_key_t * const *keys,
+                  int count,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+
+  *segments = apr_pcalloc(scratch_pool, count * sizeof(**segments));
+  *group_indexes = apr_pcalloc(scratch_pool, count * sizeof(**group_indexes));
+
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      {
+        (*segments)[i] = cache;
+        (*group_indexes)[i] = get_group_index(&(*segments)[i],
+                                              &keys[i]->entry_key);
+      }
+}
+
+/* Store the serialized ITEM_SIZE bytes in BUFFER in CACHE and identify
+ * it by KEY.  GROUP_INDEX is the entry group to use within CACHE.  The
+ * item shall be subject to the given PRIORITY and ADMISSION policy.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+membuffer_cache_set_serialized(svn_membuffer_t *cache,
+                               const full_key_t *key,
+                               apr_uint32_t group_index,
+                               char *buffer,
+                               apr_size_t item_size,
+                               apr_uint32_t priority,
+                               svn_cache__admission_t admission,
+                               apr_pool_t *scratch_pool)
+{
+  WITH_WRITE_LOCK(cache,
+                  membuffer_cache_set_internal(cache,
+                                               key,
+                                               group_index,
+                                               buffer,
+                                               item_size,
+                                               priority,
+                                               admission,
+                                               scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+/* Store the serialized data of all items among the COUNT KEYS that map
+ * to SEGMENTS[FIRST], taking them from BUFFERS and SIZES.  The entries in
+ * SEGMENTS that have been processed will be reset to NULL.  GROUP_INDEXES
+ * has been determined by get_group_indexes.  All items shall be subject
+ * to the given PRIORITY and ADMISSION policy.  Use SCRATCH_POOL for
+ * temporary allocations.
+ *
+ * Note: This function requires the caller to serialize access to
+ * SEGMENTS[FIRST].  Don't call it directly, call membuffer_cache_set_many
+ * instead.
+ */
+static svn_error_t *
+membuffer_cache_set_many_internal(svn_membuffer_t **segments,
+                                  const apr_uint32_t *group_indexes,
+                                  const full_key_t * const *keys,
+                                  char **buffers,
+                                  const apr_size_t *sizes,
+                                  int first,
+                                  int count,
+                                  apr_uint32_t priority,
+                                  svn_cache__admission_t admission,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *segment = segments[first];
+  int i;
+
+  for (i = first; i < count; ++i)
+    if (segments[i] == segment)
+      {
+        SVN_ERR(membuffer_cache_set_internal(segment,
+                                             keys[i],
+                                             group_indexes[i],
+                                             buffers[i],
+                                             sizes[i],
+                                             priority,
+                                             admission,
+                                             scratch_pool));
+        segments[i] = NULL;
+      }
+
+  return SVN_NO_ERROR;
+}
+
+/* Try to insert the COUNT ITEMS and use the respective KEYS to uniquely
+ * identify them.  NULL KEYS will be skipped.  Apart from acquiring every
+ * segment lock of CACHE at most once, this behaves like a sequence of
+ * membuffer_cache_set calls with the same SERIALIZER, PRIORITY and
+ * ADMISSION.  Temporary allocations may be done in SCRATCH_POOL.
+ */
+static svn_error_t *
+membuffer_cache_set_many(svn_membuffer_t *cache,
+                         const full_key_t * const *keys,
+                         void * const *items,
+                         int count,
+                         svn_cache__serialize_func_t serializer,
+                         apr_uint32_t priority,
+                         svn_cache__admission_t admission,
+                         apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t **segments;
+  apr_uint32_t *group_indexes;
+  char **buffers = apr_pcalloc(scratch_pool, count * sizeof(*buffers));
+  apr_size_t *sizes = apr_pcalloc(scratch_pool, count * sizeof(*sizes));
+  int i;
+
+  get_group_indexes(&segments, &group_indexes, cache, keys, count,
+                    scratch_pool);
+
+  /* Serialize data outside the locks.
+   */
+  for (i = 0; i < count; ++i)
+    if (segments[i] && items[i])
+      SVN_ERR(serializer((void **)&buffers[i], &sizes[i], items[i],
+                         scratch_pool));
+
+  /* Write all items of the same segment under a single lock.
+   * SEGMENTS[I] will be reset once the respective item has been stored. */
+  for (i = 0; i < count; ++i)
+    if (segments[i])
+      {
+        svn_membuffer_t *segment = segments[i];
+        svn_boolean_t got_lock = TRUE;
+
+        SVN_ERR(write_lock_cache(segment, &got_lock));
+        if (got_lock)
+          {
+            SVN_ERR(unlock_cache(segment,
+                        membuffer_cache_set_many_internal(segments,
+                                                          group_indexes,
+                                                          keys,
+                                                          buffers,
+                                                          sizes,
+                                                          i,
+                                                          count,
+                                                          priority,
+                                                          admission,
+                                                          scratch_pool)));
+          }
+        else
+          {
+            /* The segment is busy.  Fall back to per-item writes such
+             * that stale entries still get removed. */
+            int k;
+            for (k = i; k < count; ++k)
+              if (segments[k] == segment)
+                {
+                  SVN_ERR(membuffer_cache_set_serialized(segment,
+                                                         keys[k],
+                                                         group_indexes[k],
+                                                         buffers[k],
+                                                         sizes[k],
+                                                         priority,
+                                                         admission,
+                                                         scratch_pool));
+                  segments[k] = NULL;
+                }
+          }
+      }
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 /* Count a hit in ENTRY within CACHE.
  */
 static void
@@ -2473,6 +3188,100 @@ membuffer_cache_get(svn_membuffer_t *cache,
   return deserializer(item, buffer, size, result_pool);
 }
 
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Copy the serialized data of all items among the COUNT KEYS that map
+ * to SEGMENTS[FIRST] into BUFFERS and return their sizes in SIZES.  The
+ * entries in SEGMENTS that have been processed will be reset to NULL.
+ * GROUP_INDEXES has been determined by get_group_indexes.  Allocations
+ * will be done in RESULT_POOL.
+ *
+ * Note: This function requires the caller to serialize access to
+ * SEGMENTS[FIRST].  Don't call it directly, call membuffer_cache_get_many
+ * instead.
+ */
+static svn_error_t *
+membuffer_cache_get_many_internal(svn_membuffer_t **segments,
+                                  const apr_uint32_t *group_indexes,
+                                  const full_key_t * const *keys,
+                                  char **buffers,
+                                  apr_size_t *sizes,
+                                  int first,
+                                  int count,
+                                  apr_pool_t *result_pool)
+{
+  svn_membuffer_t *segment = segments[first];
+  int i;
+
+  for (i = first; i < count; ++i)
+    if (segments[i] == segment)
+      {
+        SVN_ERR(membuffer_cache_get_internal(segment,
+                                             group_indexes[i],
+                                             keys[i],
+                                             &buffers[i],
+                                             &sizes[i],
+                                             result_pool));
+        segments[i] = NULL;
+      }
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for the COUNT ITEMS identified by KEYS.  If no item has been
+ * stored for some KEYS[I] or if that is NULL, ITEMS[I] will be NULL.
+ * Otherwise, the DESERIALIZER is called to re-construct the proper object
+ * from the serialized data.  Every segment of CACHE will be locked at
+ * most once.  Allocations will be done in RESULT_POOL and SCRATCH_POOL.
+ */
+static svn_error_t *
+membuffer_cache_get_many(svn_membuffer_t *cache,
+                         const full_key_t * const *keys,
+                         int count,
+                         void **items,
+                         svn_cache__deserialize_func_t deserializer,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t **segments;
+  apr_uint32_t *group_indexes;
+  char **buffers = apr_pcalloc(scratch_pool, count * sizeof(*buffers));
+  apr_size_t *sizes = apr_pcalloc(scratch_pool, count * sizeof(*sizes));
+  int i;
+
+  get_group_indexes(&segments, &group_indexes, cache, keys, count,
+                    scratch_pool);
+
+  /* Fetch all items of the same segment under a single lock.
+   * SEGMENTS[I] will be reset once the respective item has been read. */
+  for (i = 0; i < count; ++i)
+    if (segments[i])
+      {
+        svn_membuffer_t *segment = segments[i];
+        WITH_READ_LOCK(segment,
+                       membuffer_cache_get_many_internal(segments,
+                                                         group_indexes,
+                                                         keys,
+                                                         buffers,
+                                                         sizes,
+                                                         i,
+                                                         count,
+                                                         result_pool));
+      }
+
+  /* re-construct the original data objects from their serialized form.
+   */
+  for (i = 0; i < count; ++i)
+    if (buffers[i] == NULL)
+      items[i] = NULL;
+    else
+      SVN_ERR(deserializer(&items[i], buffers[i], sizes[i], result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND.  If no item has been stored for KEY, *FOUND
  * will be FALSE and TRUE otherwise.
@@ -2689,6 +3498,8 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
                * Note that the key has already been stored in the past, i.e.
                * it is shorter than the MAX_ENTRY_SIZE.
                */
+              apr_uint32_t priority = entry->priority;
+              apr_uint32_t admission = entry->admission;
               drop_entry(cache, entry);
               if (   (cache->max_entry_size - key_len >= item_size)
                   && ensure_data_insertable_l1(cache, item_size + key_len))
@@ -2696,8 +3507,10 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
                   /* Write the new entry.
                    */
                   entry = find_entry(cache, group_index, to_find, TRUE);
-                  entry->size = item_size + key_len;
+                  entry->size = (apr_uint32_t)(item_size + key_len);
                   entry->offset = cache->l1.current_data;
+                  entry->priority = priority;
+                  entry->admission = admission;
 
                   if (key_len)
                     memcpy(cache->data + entry->offset,
@@ -2799,6 +3612,9 @@ typedef struct svn_membuffer_cache_t
   /* priority class for all items written through this interface */
   apr_uint32_t priority;
 
+  /* admission policy for all items written through this interface */
+  svn_cache__admission_t admission;
+
   /* Temporary buffer containing the hash key for the current access
    */
   full_key_t combined_key;
@@ -2827,7 +3643,7 @@ combine_long_key(svn_membuffer_cache_t *cache,
                  const void *key,
                  apr_ssize_t key_len)
 {
-  apr_uint32_t *digest_buffer;
+  apr_uint64_t hash;
   char *key_copy;
   apr_size_t prefix_len = cache->prefix.key_len;
   apr_size_t aligned_key_len;
@@ -2847,15 +3663,17 @@ combine_long_key(svn_membuffer_cache_t *cache,
   memcpy(key_copy, key, key_len);
   memset(key_copy + key_len, 0, aligned_key_len - key_len);
 
-  /* Hash key into 16 bytes. */
-  digest_buffer = (apr_uint32_t *)cache->combined_key.entry_key.fingerprint;
-  svn__fnv1a_32x4_raw(digest_buffer, key, key_len);
+  /* Hash key into 16 bytes.  Since we compare the full keys upon lookup,
+   * 64 bits of hash are plenty.  Derive the second half by a bijective
+   * scramble, so segment and group selection see different bits. */
+  hash = svn__hash64(key, key_len, 0);
 
   /* Combine with prefix. */
   cache->combined_key.entry_key.fingerprint[0]
-    ^= cache->prefix.fingerprint[0];
+    = hash ^ cache->prefix.fingerprint[0];
   cache->combined_key.entry_key.fingerprint[1]
-    ^= cache->prefix.fingerprint[1];
+    = (hash * APR_UINT64_C(0x9e3779b97f4a7c15))
+    ^ cache->prefix.fingerprint[1];
 }
 
 /* Basically calculate a hash value for KEY of length KEY_LEN, combine it
@@ -2917,6 +3735,47 @@ combine_key(svn_membuffer_cache_t *cache,
     = data[1] ^ cache->prefix.fingerprint[1];
 }
 
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Combine each of the COUNT KEYS with the prefix of CACHE and return the
+ * results in *FULL_KEYS, allocated in RESULT_POOL.  NULL KEYS will result
+ * in NULL entries.
+ */
+static void
+combine_keys(const full_key_t ***full_keys,
+             svn_membuffer_cache_t *cache,
+             const void * const *keys,
+             int count,
+             apr_pool_t *result_pool)
+{
+  full_key_t **result = apr_pcalloc(result_pool, count * sizeof(*result));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      {
+        apr_size_t key_len;
+
+        combine_key(cache, keys[i], cache->key_len);
+
+        /* COMBINED_KEY will be overwritten by the next key. */
+        result[i] = apr_pmemdup(result_pool, &cache->combined_key,
+                                sizeof(cache->combined_key));
+        key_len = cache->combined_key.entry_key.key_len;
+        if (key_len)
+          {
+            result[i]->full_key.data
+              = apr_pmemdup(result_pool, cache->combined_key.full_key.data,
+                            key_len);
+            result[i]->full_key.size = key_len;
+          }
+      }
+
+  *full_keys = (const full_key_t **)result;
+}
+
+#endif
+
 /* Implement svn_cache__vtable_t.get (not thread-safe)
  */
 static svn_error_t *
@@ -3019,10 +3878,99 @@ svn_membuffer_cache_set(void *cache_void,
                              value,
                              cache->serializer,
                              cache->priority,
+                             cache->admission,
                              DEBUG_CACHE_MEMBUFFER_TAG
                              scratch_pool);
 }
 
+/* Implement svn_cache__vtable_t.get_many (not thread-safe)
+ */
+static svn_error_t *
+svn_membuffer_cache_get_many(void **values,
+                             svn_boolean_t *found,
+                             void *cache_void,
+                             const void * const *keys,
+                             int count,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  int i;
+
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+
+  /* Content tags are per item.  Keep it simple in debug code. */
+  for (i = 0; i < count; ++i)
+    SVN_ERR(svn_membuffer_cache_get(&values[i], &found[i], cache_void,
+                                    keys[i], result_pool));
+
+#else
+
+  svn_membuffer_cache_t *cache = cache_void;
+  const full_key_t **full_keys;
+
+  /* construct the full, i.e. globally unique, keys by adding
+   * this cache instances' prefix
+   */
+  combine_keys(&full_keys, cache, keys, count, scratch_pool);
+
+  /* Look the items up. */
+  SVN_ERR(membuffer_cache_get_many(cache->membuffer,
+                                   full_keys,
+                                   count,
+                                   values,
+                                   cache->deserializer,
+                                   result_pool,
+                                   scratch_pool));
+
+  /* return result */
+  for (i = 0; i < count; ++i)
+    found[i] = values[i] != NULL;
+
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_many (not thread-safe)
+ */
+static svn_error_t *
+svn_membuffer_cache_set_many(void *cache_void,
+                             const void * const *keys,
+                             void * const *values,
+                             int count,
+                             apr_pool_t *scratch_pool)
+{
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+
+  int i;
+  for (i = 0; i < count; ++i)
+    SVN_ERR(svn_membuffer_cache_set(cache_void, keys[i], values[i],
+                                    scratch_pool));
+
+  return SVN_NO_ERROR;
+
+#else
+
+  svn_membuffer_cache_t *cache = cache_void;
+  const full_key_t **full_keys;
+
+  combine_keys(&full_keys, cache, keys, count, scratch_pool);
+
+  /* (probably) add the items to the cache. But there is no real guarantee
+   * that any item will actually be cached afterwards.
+   */
+  return membuffer_cache_set_many(cache->membuffer,
+                                  full_keys,
+                                  values,
+                                  count,
+                                  cache->serializer,
+                                  cache->priority,
+                                  cache->admission,
+                                  scratch_pool);
+
+#endif
+}
+
 /* Implement svn_cache__vtable_t.iter as "not implemented"
  */
 static svn_error_t *
@@ -3127,11 +4075,18 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
   info->data_size += segment->l1.size + segment->l2.size;
   info->used_size += segment->data_used;
   info->total_size += segment->l1.size + segment->l2.size +
-      segment->group_count * GROUP_SIZE * sizeof(entry_t);
+      segment->group_count * GROUP_SIZE * sizeof(entry_t) +
+      segment->sketch_mask + 1;
 
   info->used_entries += segment->used_entries;
   info->total_entries += segment->group_count * GROUP_SIZE;
 
+  info->promotions += segment->total_promotions;
+  info->l1_evictions += segment->total_l1_evictions;
+  info->rejections += segment->total_rejections;
+  info->l2_evictions += segment->total_l2_evictions;
+  info->conflicts += segment->total_conflicts;
+
   if (include_histogram)
     for (i = 0; i < segment->group_count; ++i)
       if (is_group_initialized(segment, i))
@@ -3186,7 +4141,9 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+  svn_membuffer_cache_get_many,
+  svn_membuffer_cache_set_many
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3289,6 +4246,50 @@ svn_membuffer_cache_set_partial_synced(void *cache_void,
   return SVN_NO_ERROR;
 }
 
+/* Implement svn_cache__vtable_t.get_many and serialize all cache access.
+ */
+static svn_error_t *
+svn_membuffer_cache_get_many_synced(void **values,
+                                    svn_boolean_t *found,
+                                    void *cache_void,
+                                    const void * const *keys,
+                                    int count,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       svn_membuffer_cache_get_many(values,
+                                                    found,
+                                                    cache_void,
+                                                    keys,
+                                                    count,
+                                                    result_pool,
+                                                    scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_many and serialize all cache access.
+ */
+static svn_error_t *
+svn_membuffer_cache_set_many_synced(void *cache_void,
+                                    const void * const *keys,
+                                    void * const *values,
+                                    int count,
+                                    apr_pool_t *scratch_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       svn_membuffer_cache_set_many(cache_void,
+                                                    keys,
+                                                    values,
+                                                    count,
+                                                    scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* the v-table for membuffer-based caches with multi-threading support)
  */
 static svn_cache__vtable_t membuffer_cache_synced_vtable = {
@@ -3299,7 +4300,9 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+  svn_membuffer_cache_get_many_synced,
+  svn_membuffer_cache_set_many_synced
 };
 
 /* standard serialization function for svn_stringbuf_t items.
@@ -3349,6 +4352,7 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_ssize_t klen,
                                   const char *prefix,
                                   apr_uint32_t priority,
+                                  svn_cache__admission_t admission,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t short_lived,
                                   apr_pool_t *result_pool,
@@ -3372,6 +4376,7 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                       ? deserializer
                       : deserialize_svn_stringbuf;
   cache->priority = priority;
+  cache->admission = admission;
   cache->key_len = klen;
 
   SVN_ERR(svn_mutex__init(&cache->mutex, thread_safe, result_pool));
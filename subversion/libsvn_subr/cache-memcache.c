@@ -23,6 +23,7 @@
 
 #include <apr_md5.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_base64.h"
 #include "svn_path.h"
@@ -30,6 +31,8 @@
 #include "svn_private_config.h"
 #include "private/svn_cache.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 #include "cache.h"
 
@@ -39,15 +42,80 @@
 
 /* A note on thread safety:
 
-   The apr_memcache_t object does its own mutex handling, and nothing
-   else in memcache_t is ever modified, so this implementation should
-   be fully thread-safe.
+   The apr_memcache_t object does its own mutex handling.  The hash ring
+   in svn_memcache_t is only modified while the object gets configured
+   and the write queue is protected by its own mutexes.  Nothing else in
+   memcache_t is ever modified, so this implementation should be fully
+   thread-safe as long as the near cache is thread-safe.
 */
 
+/* Number of points that each memcached server occupies on the hash ring.
+   Every MD5 digest provides 4 of them.  Many points per server keep the
+   key distribution even. */
+#define POINTS_PER_SERVER 160
+
+/* Dead memcached servers will be tried again after this time. */
+#define SERVER_RETRY_INTERVAL apr_time_from_sec(5)
+
+/* Maximum number of asynchronous writes that may be pending.  Writes that
+   don't fit into the queue will be dropped. */
+#define WRITE_QUEUE_SIZE 1024
+
+/* One point on the consistent hash ring. */
+typedef struct ring_point_t
+{
+  /* Position on the ring. */
+  apr_uint32_t hash;
+
+  /* The server handling all keys that hash to positions after the
+     previous point, up to and including HASH. */
+  apr_memcache_server_t *server;
+} ring_point_t;
+
+/* A value waiting to be written to memcached by the background writer.
+   KEY and DATA are stored in the same malloc'ed block, right after this
+   struct. */
+typedef struct pending_write_t
+{
+  /* Next item in the queue. */
+  struct pending_write_t *next;
+
+  char *key;
+  char *data;
+  apr_size_t len;
+} pending_write_t;
+
+/* The wrapper around apr_memcache_t. */
+struct svn_memcache_t {
+  apr_memcache_t *c;
+
+  /* The consistent hash ring.  RING_SIZE points, sorted by hash. */
+  ring_point_t *ring;
+  int ring_size;
+
+  /* If not NULL, writes go into the queue from QUEUE_FIRST to QUEUE_LAST
+     and a task in WRITER sends them to the servers in the background.
+     WRITE_SCHEDULED tells whether such a task has been added and will
+     look at the queue again.  All this is protected by QUEUE_MUTEX.
+     TASKS_MUTEX serializes access to WRITER; never acquire it while
+     holding QUEUE_MUTEX. */
+  svn_task__set_t *writer;
+  pending_write_t *queue_first;
+  pending_write_t *queue_last;
+  int queue_length;
+  svn_boolean_t write_scheduled;
+  svn_mutex__t *queue_mutex;
+  svn_mutex__t *tasks_mutex;
+};
+
 /* The (internal) cache object. */
 typedef struct memcache_t {
   /* The memcached server set we're using. */
-  apr_memcache_t *memcache;
+  svn_memcache_t *memcache;
+
+  /* Optional in-process cache in front of the memcached servers.  It
+   * will be tried first and receives all items read from memcached. */
+  svn_cache__t *near_cache;
 
   /* A prefix used to differentiate our data from any other data in
    * the memcached (URI-encoded). */
@@ -63,11 +131,6 @@ typedef struct memcache_t {
   svn_cache__deserialize_func_t deserialize_func;
 } memcache_t;
 
-/* The wrapper around apr_memcache_t. */
-struct svn_memcache_t {
-  apr_memcache_t *c;
-};
-
 
 /* The memcached protocol says the maximum key length is 250.  Let's
    just say 249, to be safe. */
@@ -127,6 +190,62 @@ build_key(const char **mc_key,
   return SVN_NO_ERROR;
 }
 
+/* Fetch the serialized items for all COUNT KEYS of CACHE from memcached.
+ * Set DATA[I] and SIZE[I] for every item found; set DATA[I] to NULL for
+ * all others.  NULL keys will never be found.  Allocate the data in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+memcache_fetch(char **data,
+               apr_size_t *size,
+               memcache_t *cache,
+               const void * const *keys,
+               int count,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char **mc_keys = apr_pcalloc(scratch_pool, count * sizeof(*mc_keys));
+  apr_hash_t *values = NULL;
+  apr_status_t apr_err;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      data[i] = NULL;
+      size[i] = 0;
+
+      if (keys[i] == NULL)
+        continue;
+
+      SVN_ERR(build_key(&mc_keys[i], cache, keys[i], scratch_pool));
+      apr_memcache_add_multget_key(scratch_pool, mc_keys[i], &values);
+    }
+
+  if (values == NULL)
+    return SVN_NO_ERROR;
+
+  /* apr_memcache groups the keys by server and pipelines the requests,
+     i.e. we pay one round-trip per server instead of one per key. */
+  apr_err = apr_memcache_multgetp(cache->memcache->c, scratch_pool,
+                                  result_pool, values);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < count; ++i)
+    if (mc_keys[i])
+      {
+        apr_memcache_value_t *value = svn_hash_gets(values, mc_keys[i]);
+        if (value && value->status == APR_SUCCESS && value->data)
+          {
+            data[i] = value->data;
+            size[i] = value->len;
+          }
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* Core functionality of our getter functions: fetch DATA from the memcached
  * given by CACHE_VOID and identified by KEY. Indicate success in FOUND and
  * use a tempoary sub-pool of POOL for allocations.
@@ -139,97 +258,346 @@ memcache_internal_get(char **data,
                       const void *key,
                       apr_pool_t *pool)
 {
-  memcache_t *cache = cache_void;
-  apr_status_t apr_err;
-  const char *mc_key;
-  apr_pool_t *subpool;
+  apr_pool_t *subpool = svn_pool_create(pool);
 
-  if (key == NULL)
+  SVN_ERR(memcache_fetch(data, size, cache_void, &key, 1, pool, subpool));
+  *found = *data != NULL;
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Re-construct the item from DATA_LEN bytes of serialized DATA in CACHE
+ * and return it in *VALUE_P.  Allocate it in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize(void **value_p,
+            memcache_t *cache,
+            char *data,
+            apr_size_t data_len,
+            apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
     {
-      *found = FALSE;
-      return SVN_NO_ERROR;
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
     }
 
-  subpool = svn_pool_create(pool);
-  SVN_ERR(build_key(&mc_key, cache, key, subpool));
+  return SVN_NO_ERROR;
+}
 
-  apr_err = apr_memcache_getp(cache->memcache,
-                              pool,
-                              mc_key,
-                              data,
-                              size,
-                              NULL /* ignore flags */);
-  if (apr_err == APR_NOTFOUND)
+/* Put VALUE under KEY into the near cache of CACHE, if there is one.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+promote(memcache_t *cache,
+        const void *key,
+        void *value,
+        apr_pool_t *scratch_pool)
+{
+  svn_cache__t *near_cache = cache->near_cache;
+  if (near_cache == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(near_cache->vtable->set(near_cache->cache_internal,
+                                                 key, value, scratch_pool));
+}
+
+/* Implement vtable.get_many.  Whatever the near cache cannot provide
+ * will be fetched from memcached in a single batch.
+ */
+static svn_error_t *
+memcache_get_many(void **values,
+                  svn_boolean_t *found,
+                  void *cache_void,
+                  const void * const *keys,
+                  int count,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  memcache_t *cache = cache_void;
+  svn_cache__t *near_cache = cache->near_cache;
+  const void **missing = apr_palloc(scratch_pool, count * sizeof(*missing));
+  char **data = apr_palloc(scratch_pool, count * sizeof(*data));
+  apr_size_t *sizes = apr_palloc(scratch_pool, count * sizeof(*sizes));
+  int i;
+
+  for (i = 0; i < count; ++i)
     {
-      *found = FALSE;
-      svn_pool_destroy(subpool);
-      return SVN_NO_ERROR;
+      values[i] = NULL;
+      found[i] = FALSE;
     }
-  else if (apr_err != APR_SUCCESS || !*data)
-    return svn_error_wrap_apr(apr_err,
-                              _("Unknown memcached error while reading"));
 
-  *found = TRUE;
+  if (near_cache)
+    SVN_ERR(near_cache->vtable->get_many(values, found,
+                                         near_cache->cache_internal,
+                                         keys, count, result_pool,
+                                         scratch_pool));
+
+  for (i = 0; i < count; ++i)
+    missing[i] = found[i] ? NULL : keys[i];
+
+  SVN_ERR(memcache_fetch(data, sizes, cache, missing, count, result_pool,
+                         scratch_pool));
+
+  /* If we found it, de-serialize it. */
+  for (i = 0; i < count; ++i)
+    if (data[i])
+      {
+        SVN_ERR(deserialize(&values[i], cache, data[i], sizes[i],
+                            result_pool));
+        found[i] = TRUE;
+
+        SVN_ERR(promote(cache, keys[i], values[i], scratch_pool));
+      }
 
-  svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
-
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
              void *cache_void,
              const void *key,
              apr_pool_t *result_pool)
+{
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+
+  SVN_ERR(memcache_get_many(value_p, found, cache_void, &key, 1,
+                            result_pool, subpool));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.has_key in terms of the getter.
+ */
+static svn_error_t *
+memcache_has_key(svn_boolean_t *found,
+                 void *cache_void,
+                 const void *key,
+                 apr_pool_t *scratch_pool)
 {
   memcache_t *cache = cache_void;
+  svn_cache__t *near_cache = cache->near_cache;
   char *data;
   apr_size_t data_len;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  if (near_cache)
+    {
+      SVN_ERR(near_cache->vtable->has_key(found, near_cache->cache_internal,
+                                          key, scratch_pool));
+      if (*found)
+        return SVN_NO_ERROR;
+    }
+
   SVN_ERR(memcache_internal_get(&data,
                                 &data_len,
                                 found,
                                 cache_void,
                                 key,
-                                result_pool));
+                                scratch_pool));
 
-  /* If we found it, de-serialize it. */
-  if (*found)
+  return SVN_NO_ERROR;
+}
+
+/* Queue LEN bytes of DATA to be written under MC_KEY by the background
+ * writer of MEMCACHE.  Drop the item if the queue is full.  Return TRUE
+ * if the caller shall schedule a write_queue_task().
+ */
+static svn_boolean_t
+enqueue_write(svn_memcache_t *memcache,
+              const char *mc_key,
+              const char *data,
+              apr_size_t len)
+{
+  svn_boolean_t schedule;
+  svn_error_t *err;
+  apr_size_t key_len = strlen(mc_key) + 1;
+  pending_write_t *item = malloc(sizeof(*item) + key_len + len);
+  if (item == NULL)
+    return FALSE;
+
+  item->next = NULL;
+  item->key = (char *)(item + 1);
+  item->data = item->key + key_len;
+  item->len = len;
+  memcpy(item->key, mc_key, key_len);
+  memcpy(item->data, data, len);
+
+  err = svn_mutex__lock(memcache->queue_mutex);
+  if (err)
+    {
+      /* Caching is best-effort. */
+      svn_error_clear(err);
+      free(item);
+      return FALSE;
+    }
+
+  /* If the servers can't keep up, don't make the caller wait for them. */
+  if (memcache->queue_length >= WRITE_QUEUE_SIZE)
+    {
+      free(item);
+      schedule = FALSE;
+    }
+  else
+    {
+      if (memcache->queue_last)
+        memcache->queue_last->next = item;
+      else
+        memcache->queue_first = item;
+      memcache->queue_last = item;
+      memcache->queue_length++;
+
+      schedule = !memcache->write_scheduled;
+      memcache->write_scheduled = TRUE;
+    }
+
+  svn_error_clear(svn_mutex__unlock(memcache->queue_mutex, SVN_NO_ERROR));
+
+  return schedule;
+}
+
+/* Implements svn_task__process_func_t.  Send the queued writes of the
+ * svn_memcache_t given as PROCESS_BATON to the servers until the queue
+ * is empty.  There is nobody to report errors to, so this never fails.
+ */
+static svn_error_t *
+write_queue_task(void **result,
+                 void *process_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_memcache_t *memcache = process_baton;
+
+  while (TRUE)
     {
-      if (cache->deserialize_func)
+      pending_write_t *write;
+      svn_error_t *err = svn_mutex__lock(memcache->queue_mutex);
+
+      if (err)
+        {
+          /* Can't happen with a working mutex.  Leave the queue to the
+             pool cleanup. */
+          svn_error_clear(err);
+          break;
+        }
+
+      write = memcache->queue_first;
+      if (write)
         {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
+          memcache->queue_first = write->next;
+          if (memcache->queue_first == NULL)
+            memcache->queue_last = NULL;
+          memcache->queue_length--;
         }
       else
         {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
+          memcache->write_scheduled = FALSE;
         }
+
+      svn_error_clear(svn_mutex__unlock(memcache->queue_mutex,
+                                        SVN_NO_ERROR));
+      if (write == NULL)
+        break;
+
+      /* A failed write is only a missed caching opportunity. */
+      apr_memcache_set(memcache->c, write->key, write->data, write->len,
+                       0, 0);
+      free(write);
     }
 
+  *result = NULL;
   return SVN_NO_ERROR;
 }
 
-/* Implement vtable.has_key in terms of the getter.
+/* Add a write_queue_task() for MEMCACHE to its task set.  Any thread
+ * may call this.
  */
 static svn_error_t *
-memcache_has_key(svn_boolean_t *found,
-                 void *cache_void,
-                 const void *key,
-                 apr_pool_t *scratch_pool)
+add_write_task(svn_memcache_t *memcache)
 {
-  char *data;
-  apr_size_t data_len;
-  SVN_ERR(memcache_internal_get(&data,
-                                &data_len,
-                                found,
-                                cache_void,
-                                key,
-                                scratch_pool));
+  SVN_MUTEX__WITH_LOCK(memcache->tasks_mutex,
+                       svn_task__add(memcache->writer, write_queue_task,
+                                     memcache));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that a write_queue_task() will send the queued writes of
+ * MEMCACHE.
+ */
+static void
+schedule_writes(svn_memcache_t *memcache)
+{
+  svn_error_t *err = add_write_task(memcache);
+  if (err)
+    {
+      /* Don't leave the queue behind without a task draining it.
+         The items will be freed by the pool cleanup. */
+      svn_error_clear(err);
+      svn_error_clear(svn_mutex__lock(memcache->queue_mutex));
+      memcache->write_scheduled = FALSE;
+      svn_error_clear(svn_mutex__unlock(memcache->queue_mutex,
+                                        SVN_NO_ERROR));
+    }
+}
+
+/* Pool pre-cleanup function flushing the queued writes of the
+ * svn_memcache_t given as DATA and releasing those that could not be
+ * sent.  This must happen before the task set gets destroyed.
+ */
+static apr_status_t
+stop_writer(void *data)
+{
+  svn_memcache_t *memcache = data;
+  pending_write_t *write;
+
+  svn_error_clear(svn_mutex__lock(memcache->tasks_mutex));
+  svn_error_clear(svn_task__set_finish(memcache->writer));
+  svn_error_clear(svn_mutex__unlock(memcache->tasks_mutex, SVN_NO_ERROR));
+
+  for (write = memcache->queue_first; write; )
+    {
+      pending_write_t *next = write->next;
+      free(write);
+      write = next;
+    }
+  memcache->queue_first = NULL;
+  memcache->queue_last = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Make all writes to MEMCACHE asynchronous by creating a task set that
+ * sends them in the background.  Allocate everything in POOL, which is
+ * the pool that MEMCACHE lives in.
+ */
+static svn_error_t *
+start_writer(svn_memcache_t *memcache,
+             apr_pool_t *pool)
+{
+  SVN_ERR(svn_mutex__init(&memcache->queue_mutex, TRUE, pool));
+  SVN_ERR(svn_mutex__init(&memcache->tasks_mutex, TRUE, pool));
+
+  /* A single writer per server set sends the writes in order. */
+  SVN_ERR(svn_task__set_create(&memcache->writer, 1, NULL, NULL, NULL, NULL,
+                               pool));
+  apr_pool_pre_cleanup_register(pool, memcache, stop_writer);
 
   return SVN_NO_ERROR;
 }
@@ -250,7 +618,16 @@ memcache_internal_set(void *cache_void,
   apr_status_t apr_err;
 
   SVN_ERR(build_key(&mc_key, cache, key, scratch_pool));
-  apr_err = apr_memcache_set(cache->memcache, mc_key, (char *)data, len, 0, 0);
+
+  if (cache->memcache->writer)
+    {
+      if (enqueue_write(cache->memcache, mc_key, data, len))
+        schedule_writes(cache->memcache);
+      return SVN_NO_ERROR;
+    }
+
+  apr_err = apr_memcache_set(cache->memcache->c, mc_key, (char *)data, len,
+                             0, 0);
 
   /* ### Maybe write failures should be ignored (but logged)? */
   if (apr_err != APR_SUCCESS)
@@ -268,7 +645,8 @@ memcache_set(void *cache_void,
              apr_pool_t *scratch_pool)
 {
   memcache_t *cache = cache_void;
-  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_cache__t *near_cache = cache->near_cache;
+  apr_pool_t *subpool;
   void *data;
   apr_size_t data_len;
   svn_error_t *err;
@@ -276,6 +654,11 @@ memcache_set(void *cache_void,
   if (key == NULL)
     return SVN_NO_ERROR;
 
+  if (near_cache)
+    SVN_ERR(near_cache->vtable->set(near_cache->cache_internal, key, value,
+                                    scratch_pool));
+
+  subpool = svn_pool_create(scratch_pool);
   if (cache->serialize_func)
     {
       SVN_ERR((cache->serialize_func)(&data, &data_len, value, subpool));
@@ -302,21 +685,49 @@ memcache_get_partial(void **value_p,
                      void *baton,
                      apr_pool_t *result_pool)
 {
-  svn_error_t *err = SVN_NO_ERROR;
-
+  memcache_t *cache = cache_void;
+  svn_cache__t *near_cache = cache->near_cache;
+  apr_pool_t *subpool;
   char *data;
   apr_size_t size;
+  void *value;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  if (near_cache)
+    {
+      SVN_ERR(near_cache->vtable->get_partial(value_p, found,
+                                              near_cache->cache_internal,
+                                              key, func, baton,
+                                              result_pool));
+      if (*found)
+        return SVN_NO_ERROR;
+    }
+
+  subpool = svn_pool_create(result_pool);
   SVN_ERR(memcache_internal_get(&data,
                                 &size,
                                 found,
                                 cache_void,
                                 key,
-                                result_pool));
+                                subpool));
 
-  /* If we found it, de-serialize it. */
-  return *found
-    ? func(value_p, data, size, baton, result_pool)
-    : err;
+  /* If we found it, de-serialize it.  Deserialization may modify the
+     buffer, so call FUNC first. */
+  if (*found)
+    {
+      SVN_ERR(func(value_p, data, size, baton, result_pool));
+      if (near_cache)
+        {
+          SVN_ERR(deserialize(&value, cache, data, size, subpool));
+          SVN_ERR(promote(cache, key, value, subpool));
+        }
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
 }
 
 
@@ -327,13 +738,21 @@ memcache_set_partial(void *cache_void,
                      void *baton,
                      apr_pool_t *scratch_pool)
 {
+  memcache_t *cache = cache_void;
+  svn_cache__t *near_cache = cache->near_cache;
   svn_error_t *err = SVN_NO_ERROR;
 
   void *data;
   apr_size_t size;
   svn_boolean_t found = FALSE;
 
-  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  apr_pool_t *subpool;
+
+  if (near_cache)
+    SVN_ERR(near_cache->vtable->set_partial(near_cache->cache_internal, key,
+                                            func, baton, scratch_pool));
+
+  subpool = svn_pool_create(scratch_pool);
   SVN_ERR(memcache_internal_get((char **)&data,
                                 &size,
                                 &found,
@@ -390,6 +809,23 @@ memcache_get_info(void *cache_void,
   return SVN_NO_ERROR;
 }
 
+/* Implement vtable.set_many in terms of the single-item setter.
+ * With asynchronous writes enabled, this does not wait for the servers.
+ */
+static svn_error_t *
+memcache_set_many(void *cache_void,
+                  const void * const *keys,
+                  void * const *values,
+                  int count,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    SVN_ERR(memcache_set(cache_void, keys[i], values[i], scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_cache__vtable_t memcache_vtable = {
   memcache_get,
   memcache_has_key,
@@ -398,12 +834,15 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_many,
+  memcache_set_many
 };
 
 svn_error_t *
 svn_cache__create_memcache(svn_cache__t **cache_p,
                           svn_memcache_t *memcache,
+                          svn_cache__t *near_cache,
                           svn_cache__serialize_func_t serialize_func,
                           svn_cache__deserialize_func_t deserialize_func,
                           apr_ssize_t klen,
@@ -417,7 +856,8 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   cache->deserialize_func = deserialize_func;
   cache->klen = klen;
   cache->prefix = svn_path_uri_encode(prefix, pool);
-  cache->memcache = memcache->c;
+  cache->memcache = memcache;
+  cache->near_cache = near_cache;
 
   wrapper->vtable = &memcache_vtable;
   wrapper->cache_internal = cache;
@@ -429,12 +869,115 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
-
+
+/*** Consistent hashing. ***/
+
+/* qsort()-compatible comparison function for ring_point_t. */
+static int
+compare_ring_points(const void *lhs,
+                    const void *rhs)
+{
+  apr_uint32_t lhs_hash = ((const ring_point_t *)lhs)->hash;
+  apr_uint32_t rhs_hash = ((const ring_point_t *)rhs)->hash;
+
+  return lhs_hash < rhs_hash ? -1 : (lhs_hash > rhs_hash ? 1 : 0);
+}
+
+/* Add POINTS_PER_SERVER points for SERVER to the hash ring of MEMCACHE.
+ * SERVER takes over only the keys that hash to positions right before its
+ * own points, i.e. adding a server to N others moves about 1/(N+1) of all
+ * keys while all other keys stay where they are.  Allocate the new ring
+ * in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static void
+add_to_ring(svn_memcache_t *memcache,
+            apr_memcache_server_t *server,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  ring_point_t *ring = apr_palloc(result_pool,
+                                  (memcache->ring_size + POINTS_PER_SERVER)
+                                  * sizeof(*ring));
+  int i, k;
+
+  if (memcache->ring_size)
+    memcpy(ring, memcache->ring, memcache->ring_size * sizeof(*ring));
+
+  for (i = 0; i < POINTS_PER_SERVER / 4; ++i)
+    {
+      unsigned char digest[APR_MD5_DIGESTSIZE];
+      const char *id = apr_psprintf(scratch_pool, "%s:%d-%d",
+                                    server->host, (int)server->port, i);
+      apr_md5(digest, id, strlen(id));
+
+      for (k = 0; k < 4; ++k)
+        {
+          ring_point_t *point = &ring[memcache->ring_size++];
+          const unsigned char *bytes = digest + 4 * k;
+
+          point->hash = (apr_uint32_t)bytes[0]
+                      | ((apr_uint32_t)bytes[1] << 8)
+                      | ((apr_uint32_t)bytes[2] << 16)
+                      | ((apr_uint32_t)bytes[3] << 24);
+          point->server = server;
+        }
+    }
+
+  qsort(ring, memcache->ring_size, sizeof(*ring), compare_ring_points);
+  memcache->ring = ring;
+}
+
+/* Implements apr_memcache_server_func.  Return the server responsible for
+ * HASH according to the hash ring of the svn_memcache_t given as BATON.
+ * If that server is dead, the key falls through to the next server on
+ * the ring.
+ */
+static apr_memcache_server_t *
+find_server(void *baton,
+            apr_memcache_t *mc,
+            const apr_uint32_t hash)
+{
+  svn_memcache_t *memcache = baton;
+  int lower = 0;
+  int upper = memcache->ring_size;
+  int i;
+
+  /* Find the first point at or after HASH. */
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      if (memcache->ring[middle].hash < hash)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  for (i = 0; i < memcache->ring_size; ++i)
+    {
+      apr_memcache_server_t *server
+        = memcache->ring[(lower + i) % memcache->ring_size].server;
+
+      if (server->status == APR_MC_SERVER_LIVE)
+        return server;
+
+      /* Give dead servers another chance every now and then.  Should it
+         still be down, apr_memcache will disable it again. */
+      if (apr_time_now() - server->btime > SERVER_RETRY_INTERVAL)
+        {
+          apr_memcache_enable_server(mc, server);
+          return server;
+        }
+    }
+
+  return NULL;
+}
+
+
 /*** Creating apr_memcache_t from svn_config_t. ***/
 
 /* Baton for add_memcache_server. */
 struct ams_baton {
-  apr_memcache_t *memcache;
+  svn_memcache_t *memcache;
   apr_pool_t *memcache_pool;
   svn_error_t *err;
 };
@@ -497,7 +1040,7 @@ add_memcache_server(const char *name,
       return FALSE;
     }
 
-  apr_err = apr_memcache_add_server(b->memcache, server);
+  apr_err = apr_memcache_add_server(b->memcache->c, server);
   if (apr_err != APR_SUCCESS)
     {
       b->err = svn_error_wrap_apr(apr_err,
@@ -505,6 +1048,8 @@ add_memcache_server(const char *name,
       return FALSE;
     }
 
+  add_to_ring(b->memcache, server, b->memcache_pool, pool);
+
   return TRUE;
 }
 
@@ -519,6 +1064,7 @@ struct svn_memcache_t {
 svn_error_t *
 svn_cache__create_memcache(svn_cache__t **cache_p,
                           svn_memcache_t *memcache,
+                          svn_cache__t *near_cache,
                           svn_cache__serialize_func_t serialize_func,
                           svn_cache__deserialize_func_t deserialize_func,
                           apr_ssize_t klen,
@@ -564,6 +1110,7 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
 #ifdef SVN_HAVE_MEMCACHE
   {
     struct ams_baton b;
+    svn_boolean_t async_writes;
     svn_memcache_t *memcache = apr_pcalloc(result_pool, sizeof(*memcache));
     apr_status_t apr_err = apr_memcache_create(result_pool,
                                                (apr_uint16_t)server_count,
@@ -573,7 +1120,13 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
       return svn_error_wrap_apr(apr_err,
                                 _("Unknown error creating apr_memcache_t"));
 
-    b.memcache = memcache->c;
+    /* Distribute the keys using our own hash ring instead of
+       apr_memcache's modulo scheme, which would move almost all keys
+       whenever the set of servers changes. */
+    memcache->c->server_func = find_server;
+    memcache->c->server_baton = memcache;
+
+    b.memcache = memcache;
     b.memcache_pool = result_pool;
     b.err = SVN_NO_ERROR;
     svn_config_enumerate2(config,
@@ -584,6 +1137,13 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
     if (b.err)
       return b.err;
 
+    SVN_ERR(svn_config_get_bool(config, &async_writes,
+                                SVN_CACHE_CONFIG_CATEGORY_MEMCACHED,
+                                SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES,
+                                FALSE));
+    if (async_writes)
+      SVN_ERR(start_writer(memcache, result_pool));
+
     *memcache_p = memcache;
 
     return SVN_NO_ERROR;
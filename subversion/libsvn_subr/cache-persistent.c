@@ -0,0 +1,1235 @@
+/*
+ * cache-persistent.c: file-based persistent cache tier
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_version.h"
+
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+
+#include "cache.h"
+
+/* A persistent store keeps serialized cache items in a single file such
+ * that they survive process restarts.  It is meant to back an in-memory
+ * cache as its "L3" tier:  Lookups that miss the in-memory cache will be
+ * tried against the file and successfully read items will be put into
+ * the in-memory cache again.
+ *
+ * The file starts with a header line that identifies the platform and
+ * version as well as the TAG given by the user.  Since serialized items
+ * are not portable, any mismatch in the header discards the whole file.
+ * After the header, there is a sequence of records, each consisting of
+ * a record_header_t followed by the full key and the item data.  Records
+ * are never modified once written, i.e. the file is append-only.  Once
+ * its size limit has been reached, no further records will be added.
+ * This makes the store only suitable for immutable data.
+ *
+ * Every process keeps an index of the records in the file in memory.
+ * It gets updated with the records that other processes have appended
+ * in the meantime whenever we append a record ourselves.  Since that
+ * usually follows a failed lookup, misses don't cost any file access.
+ * Appending to the file requires the exclusive file lock.  Under that
+ * lock, incomplete records left by crashed writers get removed as well.
+ *
+ * The index is only a hint.  Every record that we read will be checked
+ * against the requested key and its checksum before we use it.
+ *
+ * The index is split into buckets, each with its own lock and file
+ * handle for lookups.  Appending and catching up with other writers is
+ * serialized by a separate per-store lock.  Thus, lookups of different
+ * keys rarely block each other and never wait for a writer.
+ *
+ * Next to the TAG, the header contains the generation of the data source,
+ * e.g. its youngest revision.  It only ever increases.  A file with a
+ * larger generation than that of the source opening it has been written
+ * by a different history of the source and gets discarded.
+ *
+ * All stores are process-global objects, i.e. all svn_cache__t that use
+ * the same file will share the same store instance.
+ */
+
+/* Version number of the file format.  Bump this whenever the file layout
+ * or any of the cache serialization formats change. */
+#define STORE_FORMAT 2
+
+/* Number of buckets that the index of a store is split into.  Each one
+ * keeps a file handle open. */
+#define BUCKET_COUNT 8
+
+/* Header of every record in the store file.  Its fields are stored in
+ * the native byte order; the file header makes sure the file is only
+ * being used on matching platforms.
+ */
+typedef struct record_header_t
+{
+  /* Length of the full key (prefix + key) following the header. */
+  apr_uint32_t key_len;
+
+  /* Length of the serialized item data following the key. */
+  apr_uint32_t data_len;
+
+  /* FNV-1a checksum over the item data. */
+  apr_uint32_t checksum;
+} record_header_t;
+
+/* Location of a record in the store file, as kept in the index.
+ */
+typedef struct record_t
+{
+  /* Offset of the record header in the file. */
+  apr_off_t offset;
+
+  /* Length of the serialized item data. */
+  apr_uint32_t data_len;
+} record_t;
+
+/* Part of the index of a store, covering the keys that hash to it.
+ */
+typedef struct bucket_t
+{
+  /* Maps full keys to record_t *. */
+  apr_hash_t *index;
+
+  /* The store file, used to read the records found in INDEX. */
+  apr_file_t *file;
+
+  /* Serializes all access to INDEX and FILE within the process. */
+  svn_mutex__t *mutex;
+
+  /* Pool used for FILE and all data in INDEX. */
+  apr_pool_t *pool;
+} bucket_t;
+
+struct svn_cache__persistent_t
+{
+  /* The expected file header, without the generation. */
+  const char *header;
+
+  /* Length of HEADER in bytes. */
+  apr_size_t header_len;
+
+  /* Offset of the first record, i.e. behind HEADER and the generation. */
+  apr_off_t data_start;
+
+  /* Upper limit for the file size. */
+  apr_off_t max_size;
+
+  /* The latest generation of the data source that this store has been
+   * requested for. */
+  apr_uint64_t generation;
+
+  /* The store file, opened for reading and writing.  It is used to read
+   * the index and to append records. */
+  apr_file_t *file;
+
+  /* Offset behind the last record that has been added to the index. */
+  apr_off_t indexed_end;
+
+  /* Serializes access to FILE, INDEXED_END and GENERATION within the
+   * process.  Access across processes is serialized by file locks.  Never
+   * acquire this while holding the lock of a bucket. */
+  svn_mutex__t *mutex;
+
+  /* The index, split by key hash. */
+  bucket_t buckets[BUCKET_COUNT];
+
+  /* The path of FILE. */
+  const char *path;
+
+  /* Pool used for FILE and all other data of this structure. */
+  apr_pool_t *pool;
+};
+
+/* Return the file header to use for stores with the given TAG, allocated
+ * in RESULT_POOL.
+ */
+static const char *
+get_header(const char *tag,
+           apr_pool_t *result_pool)
+{
+  apr_uint32_t one = 1;
+  char endianness = *(const char *)&one ? 'L' : 'B';
+
+  return apr_psprintf(result_pool,
+                      "SVN persistent cache %d %s %c%d\n%s\n",
+                      STORE_FORMAT, SVN_VER_NUMBER, endianness,
+                      (int)sizeof(void *), tag);
+}
+
+/* Return the bucket of STORE that indexes the KEY_LEN bytes of KEY.
+ */
+static bucket_t *
+get_bucket(svn_cache__persistent_t *store,
+           const void *key,
+           apr_size_t key_len)
+{
+  return &store->buckets[svn__fnv1a_32(key, key_len) % BUCKET_COUNT];
+}
+
+/* Set *RECORD to the entry of BUCKET for the KEY_LEN bytes of KEY or to
+ * NULL if there is none.  The caller must hold BUCKET->MUTEX.
+ */
+static svn_error_t *
+bucket_lookup(record_t **record,
+              bucket_t *bucket,
+              const void *key,
+              apr_size_t key_len)
+{
+  *record = apr_hash_get(bucket->index, key, key_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the record at OFFSET with DATA_LEN bytes of data to BUCKET under
+ * the KEY_LEN bytes of KEY, unless there is an entry for KEY already.
+ * The caller must hold BUCKET->MUTEX.
+ */
+static svn_error_t *
+bucket_insert(bucket_t *bucket,
+              const void *key,
+              apr_size_t key_len,
+              apr_off_t offset,
+              apr_uint32_t data_len)
+{
+  record_t *record;
+
+  /* Later records for the same key can only be the result of a race
+   * between processes and are equivalent. */
+  if (apr_hash_get(bucket->index, key, key_len))
+    return SVN_NO_ERROR;
+
+  record = apr_palloc(bucket->pool, sizeof(*record));
+  record->offset = offset;
+  record->data_len = data_len;
+  apr_hash_set(bucket->index, apr_pmemdup(bucket->pool, key, key_len),
+               key_len, record);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove all entries from BUCKET.  The caller must hold BUCKET->MUTEX.
+ */
+static svn_error_t *
+bucket_clear(bucket_t *bucket)
+{
+  apr_hash_clear(bucket->index);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the record at OFFSET with DATA_LEN bytes of data to the index of
+ * STORE under the KEY_LEN bytes of KEY.
+ */
+static svn_error_t *
+index_record(svn_cache__persistent_t *store,
+             const void *key,
+             apr_size_t key_len,
+             apr_off_t offset,
+             apr_uint32_t data_len)
+{
+  bucket_t *bucket = get_bucket(store, key, key_len);
+  SVN_MUTEX__WITH_LOCK(bucket->mutex,
+                       bucket_insert(bucket, key, key_len, offset,
+                                     data_len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the generation of STORE to its file.  The caller must hold the
+ * file lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_generation(svn_cache__persistent_t *store,
+                 apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = store->header_len;
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, &store->generation,
+                                 sizeof(store->generation), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Truncate the file of STORE and write a fresh header to it.  Reset the
+ * index accordingly.  The caller must hold the file lock.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+reset_file(svn_cache__persistent_t *store,
+           apr_pool_t *scratch_pool)
+{
+  int i;
+
+  SVN_ERR(svn_io_file_trunc(store->file, 0, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, store->header,
+                                 store->header_len, NULL, scratch_pool));
+  SVN_ERR(write_generation(store, scratch_pool));
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    SVN_MUTEX__WITH_LOCK(store->buckets[i].mutex,
+                         bucket_clear(&store->buckets[i]));
+
+  store->indexed_end = store->data_start;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MATCHES to TRUE, if the file of STORE starts with the expected
+ * header.  If so, set *GENERATION to the generation found in the file.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+check_header(svn_boolean_t *matches,
+             apr_uint64_t *generation,
+             svn_cache__persistent_t *store,
+             apr_pool_t *scratch_pool)
+{
+  apr_size_t len = (apr_size_t)store->data_start;
+  char *buffer = apr_palloc(scratch_pool, len);
+  apr_size_t bytes_read;
+  svn_boolean_t eof;
+  apr_off_t offset = 0;
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(store->file, buffer, len, &bytes_read,
+                                 &eof, scratch_pool));
+
+  *matches = bytes_read == len
+          && memcmp(buffer, store->header, store->header_len) == 0;
+  if (*matches)
+    memcpy(generation, buffer + store->header_len, sizeof(*generation));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all complete records behind STORE->INDEXED_END to the index.
+ * If there is an incomplete record at the end of the file, set
+ * *INCOMPLETE to TRUE and FALSE otherwise.  The caller must hold
+ * STORE->MUTEX.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_index(svn_boolean_t *incomplete,
+           svn_cache__persistent_t *store,
+           apr_pool_t *scratch_pool)
+{
+  svn_filesize_t file_size;
+  apr_off_t offset = store->indexed_end;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *incomplete = FALSE;
+  SVN_ERR(svn_io_file_size_get(&file_size, store->file, scratch_pool));
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+
+  while (store->indexed_end < file_size)
+    {
+      record_header_t header;
+      apr_size_t bytes_read;
+      svn_boolean_t eof;
+      apr_off_t record_size;
+      char *key;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the record header and the key. */
+      SVN_ERR(svn_io_file_read_full2(store->file, &header, sizeof(header),
+                                     &bytes_read, &eof, iterpool));
+      if (bytes_read < sizeof(header))
+        {
+          *incomplete = TRUE;
+          break;
+        }
+
+      record_size = (apr_off_t)sizeof(header) + header.key_len
+                  + header.data_len;
+      if (   header.key_len == 0
+          || store->indexed_end + record_size > file_size)
+        {
+          *incomplete = TRUE;
+          break;
+        }
+
+      key = apr_palloc(iterpool, header.key_len);
+      SVN_ERR(svn_io_file_read_full2(store->file, key, header.key_len,
+                                     &bytes_read, &eof, iterpool));
+      if (bytes_read < header.key_len)
+        {
+          *incomplete = TRUE;
+          break;
+        }
+
+      SVN_ERR(index_record(store, key, header.key_len, store->indexed_end,
+                           header.data_len));
+
+      /* Skip the data. */
+      store->indexed_end += record_size;
+      offset = store->indexed_end;
+      SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the file lock of STORE and return ERR.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+unlock_file(svn_cache__persistent_t *store,
+            svn_error_t *err,
+            apr_pool_t *scratch_pool)
+{
+  return svn_error_compose_create(err,
+                                  svn_io_unlock_open_file(store->file,
+                                                          scratch_pool));
+}
+
+/* Make sure the file of STORE has the expected header and read its
+ * index.  Discard the file contents if the header does not match or if
+ * it has been written for a later generation.  Raise the generation in
+ * the file to that of STORE.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+initialize_file(svn_cache__persistent_t *store,
+                apr_pool_t *scratch_pool)
+{
+  svn_boolean_t matches;
+  apr_uint64_t generation = 0;
+  svn_boolean_t incomplete;
+
+  SVN_ERR(check_header(&matches, &generation, store, scratch_pool));
+  if (!matches || generation != store->generation)
+    {
+      /* Check again under the lock because another process may just be
+       * initializing the file as well. */
+      svn_error_t *err;
+
+      SVN_ERR(svn_io_lock_open_file(store->file, TRUE, FALSE, scratch_pool));
+      err = check_header(&matches, &generation, store, scratch_pool);
+      if (!err && (!matches || generation > store->generation))
+        err = reset_file(store, scratch_pool);
+      else if (!err && generation < store->generation)
+        err = write_generation(store, scratch_pool);
+
+      SVN_ERR(unlock_file(store, err, scratch_pool));
+    }
+
+  store->indexed_end = store->data_start;
+  return svn_error_trace(read_index(&incomplete, store, scratch_pool));
+}
+
+/* Implement update_generation.  The caller must hold STORE->MUTEX.
+ */
+static svn_error_t *
+update_generation_internal(svn_boolean_t *stale,
+                           svn_cache__persistent_t *store,
+                           apr_uint64_t generation,
+                           apr_pool_t *scratch_pool)
+{
+  svn_boolean_t matches;
+  apr_uint64_t file_generation = 0;
+  svn_error_t *err;
+
+  *stale = generation < store->generation;
+  if (generation <= store->generation)
+    return SVN_NO_ERROR;
+
+  /* Only ever raise the generation in the file. */
+  store->generation = generation;
+  SVN_ERR(svn_io_lock_open_file(store->file, TRUE, FALSE, scratch_pool));
+  err = check_header(&matches, &file_generation, store, scratch_pool);
+  if (!err && matches && file_generation < generation)
+    err = write_generation(store, scratch_pool);
+
+  return svn_error_trace(unlock_file(store, err, scratch_pool));
+}
+
+/* Make STORE valid for GENERATION of the data source.  Set *STALE to
+ * TRUE, if STORE has been used for a later generation already, i.e. if
+ * its data may belong to a different history.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+update_generation(svn_boolean_t *stale,
+                  svn_cache__persistent_t *store,
+                  apr_uint64_t generation,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_MUTEX__WITH_LOCK(store->mutex,
+                       update_generation_internal(stale, store, generation,
+                                                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement store_get for BUCKET.  The caller must hold BUCKET->MUTEX.
+ */
+static svn_error_t *
+bucket_get(char **data,
+           apr_size_t *data_len,
+           bucket_t *bucket,
+           const void *key,
+           apr_size_t key_len,
+           apr_pool_t *result_pool)
+{
+  record_t *record = apr_hash_get(bucket->index, key, key_len);
+  record_header_t header = { 0 };
+  apr_size_t bytes_read;
+  svn_boolean_t eof;
+  apr_off_t offset;
+  char *buffer;
+
+  if (record == NULL)
+    return SVN_NO_ERROR;
+
+  /* Read the whole record. */
+  offset = record->offset;
+  buffer = apr_palloc(result_pool, key_len + record->data_len);
+
+  SVN_ERR(svn_io_file_seek(bucket->file, APR_SET, &offset, result_pool));
+  SVN_ERR(svn_io_file_read_full2(bucket->file, &header, sizeof(header),
+                                 &bytes_read, &eof, result_pool));
+  if (bytes_read == sizeof(header))
+    SVN_ERR(svn_io_file_read_full2(bucket->file, buffer,
+                                   key_len + record->data_len,
+                                   &bytes_read, &eof, result_pool));
+
+  /* Only use it if it is still what the index claims it to be.
+   * The file may have been reset by another process. */
+  if (   bytes_read != key_len + record->data_len
+      || header.key_len != key_len
+      || header.data_len != record->data_len
+      || memcmp(buffer, key, key_len)
+      || header.checksum != svn__fnv1a_32(buffer + key_len,
+                                          record->data_len))
+    {
+      apr_hash_set(bucket->index, key, key_len, NULL);
+      return SVN_NO_ERROR;
+    }
+
+  *data = buffer + key_len;
+  *data_len = record->data_len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATA to a copy of the item data stored for the KEY_LEN bytes of
+ * KEY in STORE and *DATA_LEN to its length.  Set *DATA to NULL if there
+ * is no such item.  Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+store_get(char **data,
+          apr_size_t *data_len,
+          svn_cache__persistent_t *store,
+          const void *key,
+          apr_size_t key_len,
+          apr_pool_t *result_pool)
+{
+  bucket_t *bucket = get_bucket(store, key, key_len);
+
+  *data = NULL;
+  *data_len = 0;
+
+  SVN_MUTEX__WITH_LOCK(bucket->mutex,
+                       bucket_get(data, data_len, bucket, key, key_len,
+                                  result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND to TRUE if STORE contains an item for the KEY_LEN bytes of
+ * KEY and to FALSE otherwise.
+ */
+static svn_error_t *
+store_has_key(svn_boolean_t *found,
+              svn_cache__persistent_t *store,
+              const void *key,
+              apr_size_t key_len)
+{
+  bucket_t *bucket = get_bucket(store, key, key_len);
+  record_t *record;
+
+  SVN_MUTEX__WITH_LOCK(bucket->mutex,
+                       bucket_lookup(&record, bucket, key, key_len));
+  *found = record != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append a record for the KEY_LEN bytes of KEY and DATA_LEN bytes of
+ * DATA to the file of STORE, unless that would exceed the size limit or
+ * the key already exists.  The caller must hold STORE->MUTEX and the file
+ * lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+append_record(svn_cache__persistent_t *store,
+              const void *key,
+              apr_size_t key_len,
+              const void *data,
+              apr_size_t data_len,
+              apr_pool_t *scratch_pool)
+{
+  bucket_t *bucket = get_bucket(store, key, key_len);
+  record_header_t header;
+  record_t *record;
+  svn_boolean_t incomplete;
+  apr_off_t offset;
+
+  /* Catch up with other writers and remove any incomplete record. */
+  SVN_ERR(read_index(&incomplete, store, scratch_pool));
+  if (incomplete)
+    SVN_ERR(svn_io_file_trunc(store->file, store->indexed_end,
+                              scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(bucket->mutex,
+                       bucket_lookup(&record, bucket, key, key_len));
+  if (record)
+    return SVN_NO_ERROR;
+
+  if (store->indexed_end + (apr_off_t)(sizeof(header) + key_len + data_len)
+      > store->max_size)
+    return SVN_NO_ERROR;
+
+  header.key_len = (apr_uint32_t)key_len;
+  header.data_len = (apr_uint32_t)data_len;
+  header.checksum = svn__fnv1a_32(data, data_len);
+
+  offset = store->indexed_end;
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, &header, sizeof(header),
+                                 NULL, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, key, key_len, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, data, data_len, NULL,
+                                 scratch_pool));
+
+  SVN_ERR(index_record(store, key, key_len, store->indexed_end,
+                       header.data_len));
+  store->indexed_end += sizeof(header) + key_len + data_len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement store_set.  The caller must hold STORE->MUTEX.
+ */
+static svn_error_t *
+store_set_internal(svn_cache__persistent_t *store,
+                   const void *key,
+                   apr_size_t key_len,
+                   const void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *scratch_pool)
+{
+  /* Don't even try if the file is full. */
+  if (store->indexed_end + (apr_off_t)(sizeof(record_header_t) + key_len
+                                       + data_len) > store->max_size)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_lock_open_file(store->file, TRUE, FALSE, scratch_pool));
+  return svn_error_trace(unlock_file(store,
+                                     append_record(store, key, key_len,
+                                                   data, data_len,
+                                                   scratch_pool),
+                                     scratch_pool));
+}
+
+/* Add DATA_LEN bytes of DATA to STORE and identify it by the KEY_LEN
+ * bytes of KEY.  There is no guarantee that the data will actually be
+ * stored.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+store_set(svn_cache__persistent_t *store,
+          const void *key,
+          apr_size_t key_len,
+          const void *data,
+          apr_size_t data_len,
+          apr_pool_t *scratch_pool)
+{
+  svn_boolean_t found;
+
+  if (key_len > APR_UINT32_MAX || data_len > APR_UINT32_MAX)
+    return SVN_NO_ERROR;
+
+  /* Items are immutable, so there is no need to write them twice. */
+  SVN_ERR(store_has_key(&found, store, key, key_len));
+  if (found)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(store->mutex,
+                       store_set_internal(store, key, key_len, data,
+                                          data_len, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The process-global registry of all stores, mapping file paths to
+ * svn_cache__persistent_t *.  Access is serialized by REGISTRY_MUTEX,
+ * which is never held during file access.
+ */
+static apr_hash_t *registry = NULL;
+static svn_mutex__t *registry_mutex = NULL;
+static apr_pool_t *registry_pool = NULL;
+static volatile svn_atomic_t registry_initialized = 0;
+
+/* Initializer function as required by svn_atomic__init_once.  Create the
+ * store registry.  BATON and UNUSED_POOL are unused.
+ */
+static svn_error_t *
+initialize_registry(void *baton,
+                    apr_pool_t *unused_pool)
+{
+  registry_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  registry = apr_hash_make(registry_pool);
+
+  return svn_error_trace(svn_mutex__init(&registry_mutex, TRUE,
+                                         registry_pool));
+}
+
+/* Set *STORE_P to the registered store for PATH, if it expects HEADER.
+ * Set it to NULL otherwise.  The caller must hold the REGISTRY_MUTEX.
+ */
+static svn_error_t *
+find_store(svn_cache__persistent_t **store_p,
+           const char *path,
+           const char *header)
+{
+  svn_cache__persistent_t *store = svn_hash_gets(registry, path);
+
+  /* Data in stores for e.g. a previous repository UUID is invalid. */
+  *store_p = store && strcmp(store->header, header) == 0 ? store : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make STORE the registered store for its file.  The caller must hold the
+ * REGISTRY_MUTEX.
+ */
+static svn_error_t *
+register_store(svn_cache__persistent_t *store)
+{
+  /* Any previous instance for the same file becomes stale but may still
+   * be in use by some caches.  So, we can't destroy it. */
+  svn_hash_sets(registry, store->path, store);
+
+  return SVN_NO_ERROR;
+}
+
+/* Open a new store instance for the file at PATH in *STORE_P.  HEADER,
+ * GENERATION and MAX_SIZE are as for svn_cache__get_persistent_store.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+open_store(svn_cache__persistent_t **store_p,
+           const char *path,
+           const char *header,
+           apr_uint64_t generation,
+           apr_uint64_t max_size,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(registry_pool);
+  svn_cache__persistent_t *store = apr_pcalloc(pool, sizeof(*store));
+  svn_error_t *err;
+  int i;
+
+  store->header = apr_pstrdup(pool, header);
+  store->header_len = strlen(header);
+  store->data_start = store->header_len + sizeof(store->generation);
+  store->generation = generation;
+  store->max_size = max_size > APR_INT64_MAX
+                  ? APR_INT64_MAX
+                  : (apr_off_t)max_size;
+  store->path = apr_pstrdup(pool, path);
+  store->pool = pool;
+
+  err = svn_mutex__init(&store->mutex, TRUE, pool);
+  for (i = 0; i < BUCKET_COUNT && !err; ++i)
+    {
+      bucket_t *bucket = &store->buckets[i];
+
+      bucket->pool = svn_pool_create(pool);
+      bucket->index = apr_hash_make(bucket->pool);
+      err = svn_mutex__init(&bucket->mutex, TRUE, bucket->pool);
+    }
+
+  if (!err)
+    err = svn_io_file_open(&store->file, path,
+                           APR_READ | APR_WRITE | APR_CREATE | APR_BINARY,
+                           APR_OS_DEFAULT, pool);
+  for (i = 0; i < BUCKET_COUNT && !err; ++i)
+    err = svn_io_file_open(&store->buckets[i].file, path,
+                           APR_READ | APR_BINARY, APR_OS_DEFAULT,
+                           store->buckets[i].pool);
+  if (!err)
+    err = initialize_file(store, scratch_pool);
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *store_p = store;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__get_persistent_store(svn_cache__persistent_t **store_p,
+                                const char *path,
+                                const char *tag,
+                                apr_uint64_t generation,
+                                apr_uint64_t max_size,
+                                apr_pool_t *scratch_pool)
+{
+  const char *header = get_header(tag, scratch_pool);
+  svn_cache__persistent_t *store;
+
+  SVN_ERR(svn_atomic__init_once(&registry_initialized, initialize_registry,
+                                NULL, NULL));
+  SVN_MUTEX__WITH_LOCK(registry_mutex, find_store(&store, path, header));
+
+  if (store)
+    {
+      svn_boolean_t stale;
+
+      SVN_ERR(update_generation(&stale, store, generation, scratch_pool));
+      if (!stale)
+        {
+          *store_p = store;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Concurrent callers may each open a new instance.  The last one to
+   * register wins but all of them are equally valid. */
+  SVN_ERR(open_store(&store, path, header, generation, max_size,
+                     scratch_pool));
+  SVN_MUTEX__WITH_LOCK(registry_mutex, register_store(store));
+  *store_p = store;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The cache front-end that combines an in-memory cache with a store.
+ */
+typedef struct persistent_cache_t
+{
+  /* The cache to try first.  Items read from STORE will be put here. */
+  svn_cache__t *memory_cache;
+
+  /* The persistent backing store. */
+  svn_cache__persistent_t *store;
+
+  /* (De-)serializers for the data written to STORE. */
+  svn_cache__serialize_func_t serialize_func;
+  svn_cache__deserialize_func_t deserialize_func;
+
+  /* Key length as given to svn_cache__create_persistent. */
+  apr_ssize_t klen;
+
+  /* Prefix combined with every key to form the key within STORE. */
+  const char *prefix;
+
+  /* Length of PREFIX in bytes. */
+  apr_size_t prefix_len;
+} persistent_cache_t;
+
+/* Return the key to use within the store of CACHE for the given KEY in
+ * *FULL_KEY and its length in *FULL_KEY_LEN.  Allocate it in RESULT_POOL.
+ */
+static void
+combine_key(const void **full_key,
+            apr_size_t *full_key_len,
+            persistent_cache_t *cache,
+            const void *key,
+            apr_pool_t *result_pool)
+{
+  apr_size_t key_len = cache->klen == APR_HASH_KEY_STRING
+                     ? strlen(key)
+                     : (apr_size_t)cache->klen;
+  char *result = apr_palloc(result_pool, cache->prefix_len + key_len);
+
+  memcpy(result, cache->prefix, cache->prefix_len);
+  memcpy(result + cache->prefix_len, key, key_len);
+
+  *full_key = result;
+  *full_key_len = cache->prefix_len + key_len;
+}
+
+/* Look for the item identified by KEY in the store of CACHE and return
+ * a copy of its serialized form in *DATA and *DATA_LEN.  *DATA will be
+ * NULL if the item could not be found.  Allocate the result in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+get_from_store(char **data,
+               apr_size_t *data_len,
+               persistent_cache_t *cache,
+               const void *key,
+               apr_pool_t *result_pool)
+{
+  const void *full_key;
+  apr_size_t full_key_len;
+
+  combine_key(&full_key, &full_key_len, cache, key, result_pool);
+  return svn_error_trace(store_get(data, data_len, cache->store, full_key,
+                                   full_key_len, result_pool));
+}
+
+/* Re-construct the item from DATA_LEN bytes of serialized DATA in CACHE
+ * and return it in *VALUE_P.  Allocate it in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize(void **value_p,
+            persistent_cache_t *cache,
+            char *data,
+            apr_size_t data_len,
+            apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *value_str;
+
+  if (cache->deserialize_func)
+    return svn_error_trace(cache->deserialize_func(value_p, data, data_len,
+                                                   result_pool));
+
+  /* Default: svn_stringbuf_t with terminating NUL. */
+  value_str = apr_palloc(result_pool, sizeof(*value_str));
+  value_str->pool = result_pool;
+  value_str->blocksize = data_len;
+  value_str->len = data_len - 1;
+  value_str->data = data;
+  *value_p = value_str;
+
+  return SVN_NO_ERROR;
+}
+
+/* Put VALUE under KEY back into the in-memory cache of CACHE.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+promote(persistent_cache_t *cache,
+        const void *key,
+        void *value,
+        apr_pool_t *scratch_pool)
+{
+  svn_cache__t *memory_cache = cache->memory_cache;
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = memory_cache->vtable->set(memory_cache->cache_internal,
+                                               key, value, subpool);
+  svn_pool_destroy(subpool);
+
+  return svn_error_trace(err);
+}
+
+static svn_error_t *
+persistent_cache_get(void **value_p,
+                     svn_boolean_t *found,
+                     void *cache_void,
+                     const void *key,
+                     apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+  char *data;
+  apr_size_t data_len;
+
+  *value_p = NULL;
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(memory_cache->vtable->get(value_p, found,
+                                    memory_cache->cache_internal,
+                                    key, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  /* Memory miss.  Try the store. */
+  SVN_ERR(get_from_store(&data, &data_len, cache, key, result_pool));
+  if (data == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(deserialize(value_p, cache, data, data_len, result_pool));
+  *found = TRUE;
+
+  return svn_error_trace(promote(cache, key, *value_p, result_pool));
+}
+
+static svn_error_t *
+persistent_cache_has_key(svn_boolean_t *found,
+                         void *cache_void,
+                         const void *key,
+                         apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+  const void *full_key;
+  apr_size_t full_key_len;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(memory_cache->vtable->has_key(found,
+                                        memory_cache->cache_internal,
+                                        key, scratch_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  combine_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  return svn_error_trace(store_has_key(found, cache->store, full_key,
+                                       full_key_len));
+}
+
+static svn_error_t *
+persistent_cache_set(void *cache_void,
+                     const void *key,
+                     void *value,
+                     apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+  const void *full_key;
+  apr_size_t full_key_len;
+  void *data;
+  apr_size_t data_len;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(memory_cache->vtable->set(memory_cache->cache_internal,
+                                    key, value, scratch_pool));
+
+  /* We don't store removals. */
+  if (value == NULL)
+    return SVN_NO_ERROR;
+
+  if (cache->serialize_func)
+    {
+      SVN_ERR(cache->serialize_func(&data, &data_len, value, scratch_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value_str = value;
+      data = value_str->data;
+      data_len = value_str->len + 1; /* copy trailing NUL */
+    }
+
+  combine_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  return svn_error_trace(store_set(cache->store, full_key, full_key_len,
+                                   data, data_len, scratch_pool));
+}
+
+static svn_error_t *
+persistent_cache_iter(svn_boolean_t *completed,
+                      void *cache_void,
+                      svn_iter_apr_hash_cb_t user_cb,
+                      void *user_baton,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a persistent cache"));
+}
+
+static svn_boolean_t
+persistent_cache_is_cachable(void *cache_void,
+                             apr_size_t size)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+
+  return memory_cache->vtable->is_cachable(memory_cache->cache_internal,
+                                           size);
+}
+
+static svn_error_t *
+persistent_cache_get_partial(void **value_p,
+                             svn_boolean_t *found,
+                             void *cache_void,
+                             const void *key,
+                             svn_cache__partial_getter_func_t func,
+                             void *baton,
+                             apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+  apr_pool_t *subpool;
+  char *data;
+  apr_size_t data_len;
+  void *value;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(memory_cache->vtable->get_partial(value_p, found,
+                                            memory_cache->cache_internal,
+                                            key, func, baton, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  /* Memory miss.  Try the store. */
+  subpool = svn_pool_create(result_pool);
+  SVN_ERR(get_from_store(&data, &data_len, cache, key, subpool));
+  if (data == NULL)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Deserialization may modify the buffer.  So, call FUNC first. */
+  SVN_ERR(func(value_p, data, data_len, baton, result_pool));
+  *found = TRUE;
+
+  SVN_ERR(deserialize(&value, cache, data, data_len, subpool));
+  SVN_ERR(promote(cache, key, value, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_set_partial(void *cache_void,
+                             const void *key,
+                             svn_cache__partial_setter_func_t func,
+                             void *baton,
+                             apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+
+  /* Stored items are immutable.  Only update the in-memory copy. */
+  return svn_error_trace(memory_cache->vtable->set_partial(
+                             memory_cache->cache_internal, key, func, baton,
+                             scratch_pool));
+}
+
+static svn_error_t *
+persistent_cache_get_info(void *cache_void,
+                          svn_cache__info_t *info,
+                          svn_boolean_t reset,
+                          apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  svn_cache__t *memory_cache = cache->memory_cache;
+
+  return svn_error_trace(memory_cache->vtable->get_info(
+                             memory_cache->cache_internal, info, reset,
+                             result_pool));
+}
+
+static svn_error_t *
+persistent_cache_get_many(void **values,
+                          svn_boolean_t *found,
+                          void *cache_void,
+                          const void * const *keys,
+                          int count,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    SVN_ERR(persistent_cache_get(&values[i], &found[i], cache_void, keys[i],
+                                 result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_set_many(void *cache_void,
+                          const void * const *keys,
+                          void * const *values,
+                          int count,
+                          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(persistent_cache_set(cache_void, keys[i], values[i],
+                                   iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t persistent_cache_vtable = {
+  persistent_cache_get,
+  persistent_cache_has_key,
+  persistent_cache_set,
+  persistent_cache_iter,
+  persistent_cache_is_cachable,
+  persistent_cache_get_partial,
+  persistent_cache_set_partial,
+  persistent_cache_get_info,
+  persistent_cache_get_many,
+  persistent_cache_set_many
+};
+
+svn_error_t *
+svn_cache__create_persistent(svn_cache__t **cache_p,
+                             svn_cache__t *memory_cache,
+                             svn_cache__persistent_t *store,
+                             svn_cache__serialize_func_t serialize,
+                             svn_cache__deserialize_func_t deserialize,
+                             apr_ssize_t klen,
+                             const char *prefix,
+                             apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  persistent_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  SVN_ERR_ASSERT(memory_cache && store);
+  SVN_ERR_ASSERT(klen == APR_HASH_KEY_STRING || klen >= 1);
+
+  cache->memory_cache = memory_cache;
+  cache->store = store;
+  cache->serialize_func = serialize;
+  cache->deserialize_func = deserialize;
+  cache->klen = klen;
+
+  /* Make the prefix unambiguous within the store key. */
+  cache->prefix = apr_pstrdup(result_pool, prefix);
+  cache->prefix_len = strlen(prefix) + 1;
+
+  wrapper->vtable = &persistent_cache_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->pretend_empty = memory_cache->pretend_empty;
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,761 @@
+/*
+ * cache-sharded.c: in-memory caching for Subversion with striped locks
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "svn_pools.h"
+
+#include "svn_private_config.h"
+
+#include "cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+
+/* This cache splits the key space into independent shards.  Each shard
+ * has its own lock, hash index and LRU list, so threads working on
+ * different keys rarely contend for the same lock.
+ *
+ * In contrast to the inprocess cache, entries are evicted individually.
+ * Every entry lives in a single malloc()ed block that gets freed as soon
+ * as the entry is replaced or evicted.  Thus, memory usage follows the
+ * configured limits closely and does not grow with the number of updates.
+ */
+
+/* Default number of shards for thread-safe caches. */
+#define DEFAULT_SHARD_COUNT 16
+
+/* Seed for the hash function that selects the shard. */
+#define SHARD_HASH_SEED 0x5348415244ULL
+
+/* A cache entry.  The key and the serialized value follow this struct
+ * within the same memory block.
+ */
+typedef struct sharded_entry_t
+{
+  /* Neighbours in the LRU list of the shard.  PREV is more recently used,
+   * NEXT is less recently used. */
+  struct sharded_entry_t *prev;
+  struct sharded_entry_t *next;
+
+  /* Copy of the key, KEY_LEN bytes. */
+  const void *key;
+  apr_size_t key_len;
+
+  /* Serialized value, SIZE bytes.  NULL if SIZE is 0. */
+  void *value;
+  apr_size_t size;
+} sharded_entry_t;
+
+/* One independently locked section of the cache. */
+typedef struct shard_t
+{
+  /* Maps keys to sharded_entry_t. */
+  apr_hash_t *hash;
+
+  /* Most and least recently used entry, respectively. */
+  sharded_entry_t *first;
+  sharded_entry_t *last;
+
+  /* Number of entries and sum of their SIZEs. */
+  apr_uint64_t entry_count;
+  apr_uint64_t data_size;
+
+  /* Number of entries removed to make room for new ones. */
+  apr_uint64_t evictions;
+
+  /* Serializes access to this shard.  NULL for single-threaded caches. */
+  svn_mutex__t *mutex;
+} shard_t;
+
+/* The (internal) cache object. */
+typedef struct sharded_cache_t
+{
+  /* A user-defined identifier for this cache instance. */
+  const char *id;
+
+  /* Length of the keys or APR_HASH_KEY_STRING. */
+  apr_ssize_t klen;
+
+  /* Used to copy values into and out of the cache. */
+  svn_cache__serialize_func_t serialize_func;
+  svn_cache__deserialize_func_t deserialize_func;
+
+  /* SHARD_COUNT shards. */
+  shard_t *shards;
+  int shard_count;
+
+  /* Limits per shard.  0 means "unlimited". */
+  apr_uint64_t max_shard_entries;
+  apr_uint64_t max_shard_size;
+
+  /* Limits as given to the constructor. */
+  apr_uint64_t max_entries;
+  apr_uint64_t max_size;
+} sharded_cache_t;
+
+/* Return the length of KEY in CACHE. */
+static apr_size_t
+key_length(sharded_cache_t *cache,
+           const void *key)
+{
+  return cache->klen == APR_HASH_KEY_STRING
+       ? strlen(key)
+       : (apr_size_t)cache->klen;
+}
+
+/* Return the shard of CACHE that KEY belongs to. */
+static shard_t *
+get_shard(sharded_cache_t *cache,
+          const void *key)
+{
+  apr_uint64_t hash;
+
+  if (cache->shard_count == 1)
+    return cache->shards;
+
+  /* The hash index inside the shard uses the lower bits of a similar
+   * hash.  Use a different seed and the upper bits here to keep both
+   * independent. */
+  hash = svn__hash64(key, key_length(cache, key), SHARD_HASH_SEED);
+  return &cache->shards[(hash >> 32) % cache->shard_count];
+}
+
+/* Unlink ENTRY from the LRU list of SHARD. */
+static void
+unlink_entry(shard_t *shard,
+             sharded_entry_t *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    shard->first = entry->next;
+
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    shard->last = entry->prev;
+}
+
+/* Make ENTRY the most recently used entry in SHARD. */
+static void
+link_entry_first(shard_t *shard,
+                 sharded_entry_t *entry)
+{
+  entry->prev = NULL;
+  entry->next = shard->first;
+  if (shard->first)
+    shard->first->prev = entry;
+  else
+    shard->last = entry;
+
+  shard->first = entry;
+}
+
+/* Mark ENTRY in SHARD as just used. */
+static void
+touch_entry(shard_t *shard,
+            sharded_entry_t *entry)
+{
+  if (shard->first != entry)
+    {
+      unlink_entry(shard, entry);
+      link_entry_first(shard, entry);
+    }
+}
+
+/* Remove ENTRY from SHARD and release its memory. */
+static void
+drop_entry(shard_t *shard,
+           sharded_entry_t *entry)
+{
+  apr_hash_set(shard->hash, entry->key, entry->key_len, NULL);
+  unlink_entry(shard, entry);
+
+  shard->entry_count--;
+  shard->data_size -= entry->size;
+
+  free(entry);
+}
+
+/* Evict the least recently used entries from SHARD until another entry
+ * of SIZE bytes fits into the limits of CACHE.
+ */
+static void
+make_room(sharded_cache_t *cache,
+          shard_t *shard,
+          apr_size_t size)
+{
+  while (shard->last
+         && ((cache->max_shard_entries
+              && shard->entry_count + 1 > cache->max_shard_entries)
+             || (cache->max_shard_size
+                 && shard->data_size + size > cache->max_shard_size)))
+    {
+      drop_entry(shard, shard->last);
+      shard->evictions++;
+    }
+}
+
+/* Store SIZE bytes of serialized DATA under KEY in SHARD of CACHE,
+ * replacing any previous entry for KEY.  If the item is too large to
+ * fit into the shard at all, just remove the previous entry.
+ */
+static svn_error_t *
+store_entry(sharded_cache_t *cache,
+            shard_t *shard,
+            const void *key,
+            const void *data,
+            apr_size_t size)
+{
+  apr_size_t key_len = key_length(cache, key);
+  sharded_entry_t *entry = apr_hash_get(shard->hash, key, key_len);
+  apr_size_t value_offset;
+
+  if (entry)
+    drop_entry(shard, entry);
+
+  if (cache->max_shard_size && size > cache->max_shard_size)
+    return SVN_NO_ERROR;
+
+  make_room(cache, shard, size);
+
+  /* Include a terminating NUL for string keys.  Partial getters work on
+   * the value in-place, so keep it aligned. */
+  value_offset = APR_ALIGN_DEFAULT(sizeof(*entry) + key_len + 1);
+  entry = malloc(value_offset + size);
+  if (entry == NULL)
+    return SVN_NO_ERROR;
+
+  entry->key = entry + 1;
+  entry->key_len = key_len;
+  memcpy((char *)(entry + 1), key, key_len);
+  ((char *)(entry + 1))[key_len] = '\0';
+
+  entry->size = size;
+  entry->value = size ? (char *)entry + value_offset : NULL;
+  if (size)
+    memcpy(entry->value, data, size);
+
+  apr_hash_set(shard->hash, entry->key, key_len, entry);
+  link_entry_first(shard, entry);
+
+  shard->entry_count++;
+  shard->data_size += size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Serialize VALUE for CACHE into *DATA, *SIZE.  NULL values result in
+ * empty data.  Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+serialize(void **data,
+          apr_size_t *size,
+          sharded_cache_t *cache,
+          void *value,
+          apr_pool_t *result_pool)
+{
+  *data = NULL;
+  *size = 0;
+  if (value)
+    SVN_ERR(cache->serialize_func(data, size, value, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the serialized value of KEY in SHARD of CACHE into *BUFFER and
+ * *SIZE, allocated in RESULT_POOL.  Set *BUFFER to NULL if not found.
+ */
+static svn_error_t *
+sharded_cache_get_internal(char **buffer,
+                           apr_size_t *size,
+                           sharded_cache_t *cache,
+                           shard_t *shard,
+                           const void *key,
+                           apr_pool_t *result_pool)
+{
+  sharded_entry_t *entry = apr_hash_get(shard->hash, key,
+                                        key_length(cache, key));
+
+  if (entry)
+    {
+      touch_entry(shard, entry);
+
+      /* A non-NULL buffer indicates a hit even for empty values. */
+      *buffer = apr_palloc(result_pool, entry->size ? entry->size : 1);
+      if (entry->size)
+        memcpy(*buffer, entry->value, entry->size);
+
+      *size = entry->size;
+    }
+  else
+    {
+      *buffer = NULL;
+      *size = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Deserialize SIZE bytes of BUFFER from CACHE into *VALUE_P and set
+ * *FOUND accordingly.  Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize(void **value_p,
+            svn_boolean_t *found,
+            sharded_cache_t *cache,
+            char *buffer,
+            apr_size_t size,
+            apr_pool_t *result_pool)
+{
+  *found = (buffer != NULL);
+  if (!buffer || !size)
+    *value_p = NULL;
+  else
+    SVN_ERR(cache->deserialize_func(value_p, buffer, size, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_get(void **value_p,
+                  svn_boolean_t *found,
+                  void *cache_void,
+                  const void *key,
+                  apr_pool_t *result_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  shard_t *shard;
+  char *buffer;
+  apr_size_t size;
+
+  *value_p = NULL;
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  shard = get_shard(cache, key);
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       sharded_cache_get_internal(&buffer, &size, cache,
+                                                  shard, key, result_pool));
+
+  /* Deserialize outside the lock. */
+  return svn_error_trace(deserialize(value_p, found, cache, buffer, size,
+                                     result_pool));
+}
+
+static svn_error_t *
+sharded_cache_has_key_internal(svn_boolean_t *found,
+                               sharded_cache_t *cache,
+                               shard_t *shard,
+                               const void *key)
+{
+  *found = apr_hash_get(shard->hash, key, key_length(cache, key)) != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_has_key(svn_boolean_t *found,
+                      void *cache_void,
+                      const void *key,
+                      apr_pool_t *scratch_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  shard_t *shard;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  shard = get_shard(cache, key);
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       sharded_cache_has_key_internal(found, cache, shard,
+                                                      key));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_set(void *cache_void,
+                  const void *key,
+                  void *value,
+                  apr_pool_t *scratch_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  apr_pool_t *subpool;
+  shard_t *shard;
+  void *data;
+  apr_size_t size;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  /* Serialize outside the lock. */
+  subpool = svn_pool_create(scratch_pool);
+  SVN_ERR(serialize(&data, &size, cache, value, subpool));
+
+  shard = get_shard(cache, key);
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       store_entry(cache, shard, key, data, size));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for svn_cache__iter. */
+struct cache_iter_baton {
+  svn_iter_apr_hash_cb_t user_cb;
+  void *user_baton;
+};
+
+/* Call the user's callback with the serialized value, not the entry.
+   Implements the svn_iter_apr_hash_cb_t prototype. */
+static svn_error_t *
+iter_cb(void *baton,
+        const void *key,
+        apr_ssize_t klen,
+        void *val,
+        apr_pool_t *pool)
+{
+  struct cache_iter_baton *b = baton;
+  sharded_entry_t *entry = val;
+  return (b->user_cb)(b->user_baton, key, klen, entry->value, pool);
+}
+
+static svn_error_t *
+sharded_cache_iter(svn_boolean_t *completed,
+                   void *cache_void,
+                   svn_iter_apr_hash_cb_t user_cb,
+                   void *user_baton,
+                   apr_pool_t *scratch_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  struct cache_iter_baton b;
+  int i;
+
+  b.user_cb = user_cb;
+  b.user_baton = user_baton;
+
+  *completed = TRUE;
+  for (i = 0; i < cache->shard_count && *completed; ++i)
+    {
+      shard_t *shard = &cache->shards[i];
+      SVN_MUTEX__WITH_LOCK(shard->mutex,
+                           svn_iter_apr_hash(completed, shard->hash,
+                                             iter_cb, &b, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_boolean_t
+sharded_cache_is_cachable(void *cache_void,
+                          apr_size_t size)
+{
+  sharded_cache_t *cache = cache_void;
+
+  /* Don't let a single item push out a large part of its shard. */
+  if (cache->max_shard_size)
+    return size <= cache->max_shard_size / 4;
+
+  return size < SVN_ALLOCATOR_RECOMMENDED_MAX_FREE;
+}
+
+static svn_error_t *
+sharded_cache_get_partial_internal(void **value_p,
+                                   svn_boolean_t *found,
+                                   sharded_cache_t *cache,
+                                   shard_t *shard,
+                                   const void *key,
+                                   svn_cache__partial_getter_func_t func,
+                                   void *baton,
+                                   apr_pool_t *result_pool)
+{
+  sharded_entry_t *entry = apr_hash_get(shard->hash, key,
+                                        key_length(cache, key));
+  if (! entry)
+    {
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  touch_entry(shard, entry);
+
+  *found = TRUE;
+  return func(value_p, entry->value, entry->size, baton, result_pool);
+}
+
+static svn_error_t *
+sharded_cache_get_partial(void **value_p,
+                          svn_boolean_t *found,
+                          void *cache_void,
+                          const void *key,
+                          svn_cache__partial_getter_func_t func,
+                          void *baton,
+                          apr_pool_t *result_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  shard_t *shard;
+
+  *found = FALSE;
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  shard = get_shard(cache, key);
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       sharded_cache_get_partial_internal(value_p, found,
+                                                          cache, shard, key,
+                                                          func, baton,
+                                                          result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_set_partial_internal(sharded_cache_t *cache,
+                                   shard_t *shard,
+                                   const void *key,
+                                   svn_cache__partial_setter_func_t func,
+                                   void *baton,
+                                   apr_pool_t *scratch_pool)
+{
+  sharded_entry_t *entry = apr_hash_get(shard->hash, key,
+                                        key_length(cache, key));
+  void *data;
+  apr_size_t size;
+
+  if (! entry)
+    return SVN_NO_ERROR;
+
+  /* FUNC may grow the data, so let it work on a copy and store the
+   * result as a new entry. */
+  size = entry->size;
+  data = size ? apr_pmemdup(scratch_pool, entry->value, size) : NULL;
+  SVN_ERR(func(&data, &size, baton, scratch_pool));
+
+  return svn_error_trace(store_entry(cache, shard, key, data, size));
+}
+
+static svn_error_t *
+sharded_cache_set_partial(void *cache_void,
+                          const void *key,
+                          svn_cache__partial_setter_func_t func,
+                          void *baton,
+                          apr_pool_t *scratch_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  apr_pool_t *subpool;
+  shard_t *shard;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  subpool = svn_pool_create(scratch_pool);
+  shard = get_shard(cache, key);
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       sharded_cache_set_partial_internal(cache, shard, key,
+                                                          func, baton,
+                                                          subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the statistics of SHARD to INFO and reset its eviction counter
+ * if RESET is set.
+ */
+static svn_error_t *
+add_shard_info(svn_cache__info_t *info,
+               shard_t *shard,
+               svn_boolean_t reset)
+{
+  info->used_entries += shard->entry_count;
+  info->used_size += shard->data_size;
+  info->data_size += shard->data_size;
+  info->l2_evictions += shard->evictions;
+
+  if (reset)
+    shard->evictions = 0;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_get_info(void *cache_void,
+                       svn_cache__info_t *info,
+                       svn_boolean_t reset,
+                       apr_pool_t *result_pool)
+{
+  sharded_cache_t *cache = cache_void;
+  int i;
+
+  info->id = apr_pstrdup(result_pool, cache->id);
+
+  for (i = 0; i < cache->shard_count; ++i)
+    {
+      shard_t *shard = &cache->shards[i];
+      SVN_MUTEX__WITH_LOCK(shard->mutex,
+                           add_shard_info(info, shard, reset));
+    }
+
+  info->total_entries = cache->max_entries;
+  info->total_size = info->data_size
+                   + info->used_entries * sizeof(sharded_entry_t)
+                   + cache->shard_count * sizeof(shard_t);
+
+  /* Report the configured limit as the capacity, if there is one. */
+  if (cache->max_size > info->total_size)
+    info->total_size = cache->max_size;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_get_many(void **values,
+                       svn_boolean_t *found,
+                       void *cache_void,
+                       const void * const *keys,
+                       int count,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    SVN_ERR(sharded_cache_get(&values[i], &found[i], cache_void, keys[i],
+                              result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sharded_cache_set_many(void *cache_void,
+                       const void * const *keys,
+                       void * const *values,
+                       int count,
+                       apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    SVN_ERR(sharded_cache_set(cache_void, keys[i], values[i],
+                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t sharded_cache_vtable = {
+  sharded_cache_get,
+  sharded_cache_has_key,
+  sharded_cache_set,
+  sharded_cache_iter,
+  sharded_cache_is_cachable,
+  sharded_cache_get_partial,
+  sharded_cache_set_partial,
+  sharded_cache_get_info,
+  sharded_cache_get_many,
+  sharded_cache_set_many
+};
+
+/* Pool cleanup function releasing all entries of the sharded_cache_t
+ * given as DATA.
+ */
+static apr_status_t
+free_entries(void *data)
+{
+  sharded_cache_t *cache = data;
+  int i;
+
+  for (i = 0; i < cache->shard_count; ++i)
+    {
+      sharded_entry_t *entry = cache->shards[i].first;
+      while (entry)
+        {
+          sharded_entry_t *next = entry->next;
+          free(entry);
+          entry = next;
+        }
+
+      cache->shards[i].first = NULL;
+      cache->shards[i].last = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_cache__create_sharded(svn_cache__t **cache_p,
+                          svn_cache__serialize_func_t serialize_func,
+                          svn_cache__deserialize_func_t deserialize_func,
+                          apr_ssize_t klen,
+                          int shards,
+                          apr_uint64_t max_entries,
+                          apr_uint64_t max_size,
+                          svn_boolean_t thread_safe,
+                          const char *id,
+                          apr_pool_t *pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(pool, sizeof(*wrapper));
+  sharded_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
+  int i;
+
+  SVN_ERR_ASSERT(klen == APR_HASH_KEY_STRING || klen >= 1);
+  SVN_ERR_ASSERT(max_entries > 0 || max_size > 0);
+  SVN_ERR_ASSERT(shards >= 0);
+
+  if (shards == 0)
+    shards = thread_safe ? DEFAULT_SHARD_COUNT : 1;
+
+  /* Every shard must be able to hold at least one entry. */
+  if (max_entries && (apr_uint64_t)shards > max_entries)
+    shards = (int)max_entries;
+
+  cache->id = apr_pstrdup(pool, id);
+  cache->klen = klen;
+  cache->serialize_func = serialize_func;
+  cache->deserialize_func = deserialize_func;
+  cache->max_entries = max_entries;
+  cache->max_size = max_size;
+  cache->max_shard_entries = max_entries / shards;
+  cache->max_shard_size = max_size / shards;
+  if (max_size && cache->max_shard_size == 0)
+    cache->max_shard_size = 1;
+
+  cache->shard_count = shards;
+  cache->shards = apr_pcalloc(pool, shards * sizeof(*cache->shards));
+  for (i = 0; i < shards; ++i)
+    {
+      cache->shards[i].hash = svn_hash__make_fast(pool);
+      SVN_ERR(svn_mutex__init(&cache->shards[i].mutex, thread_safe, pool));
+    }
+
+  apr_pool_cleanup_register(pool, cache, free_entries,
+                            apr_pool_cleanup_null);
+
+  wrapper->vtable = &sharded_cache_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->pretend_empty = !!getenv("SVN_X_DOES_NOT_MARK_THE_SPOT");
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
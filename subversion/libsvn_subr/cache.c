@@ -151,6 +151,66 @@ svn_cache__iter(svn_boolean_t *completed,
                                scratch_pool);
 }
 
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    svn_cache__t *cache,
+                    const void * const *keys,
+                    int count,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  int i;
+
+  /* In case any errors happen and are quelched, make sure we start
+     out with all of FOUND set to false. */
+  for (i = 0; i < count; ++i)
+    {
+      values[i] = NULL;
+      found[i] = FALSE;
+    }
+
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  cache->reads += count;
+  err = handle_error(cache,
+                     (cache->vtable->get_many)(values,
+                                               found,
+                                               cache->cache_internal,
+                                               keys,
+                                               count,
+                                               result_pool,
+                                               scratch_pool),
+                     scratch_pool);
+
+  for (i = 0; i < count; ++i)
+    if (found[i])
+      cache->hits++;
+
+  return err;
+}
+
+svn_error_t *
+svn_cache__set_many(svn_cache__t *cache,
+                    const void * const *keys,
+                    void * const *values,
+                    int count,
+                    apr_pool_t *scratch_pool)
+{
+  cache->writes += count;
+  return handle_error(cache,
+                      (cache->vtable->set_many)(cache->cache_internal,
+                                                keys,
+                                                values,
+                                                count,
+                                                scratch_pool),
+                      scratch_pool);
+}
+
 svn_error_t *
 svn_cache__get_partial(void **value,
                        svn_boolean_t *found,
@@ -204,6 +264,15 @@ svn_cache__set_partial(svn_cache__t *cache,
                       scratch_pool);
 }
 
+void
+svn_cache__add_access_counts(apr_uint64_t *gets,
+                             apr_uint64_t *hits,
+                             svn_cache__t *cache)
+{
+  *gets += cache->reads;
+  *hits += cache->hits;
+}
+
 svn_error_t *
 svn_cache__get_info(svn_cache__t *cache,
                     svn_cache__info_t *info,
@@ -300,7 +369,12 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
                             "          %" APR_UINT64_T_FMT " entries (%5.2f%%)"
-                            " of %" APR_UINT64_T_FMT " total\n%s",
+                            " of %" APR_UINT64_T_FMT " total\n"
+                            "evicted : %" APR_UINT64_T_FMT " promoted to L2, "
+                            "%" APR_UINT64_T_FMT " dropped from L1, "
+                            "%" APR_UINT64_T_FMT " not admitted to L2\n"
+                            "          %" APR_UINT64_T_FMT " dropped from L2, "
+                            "%" APR_UINT64_T_FMT " bucket conflicts\n%s",
 
                             info->id,
 
@@ -315,5 +389,9 @@ svn_cache__format_info(const svn_cache__info_t *info,
 
                             info->used_entries, data_entry_rate,
                             info->total_entries,
+
+                            info->promotions, info->l1_evictions,
+                            info->rejections, info->l2_evictions,
+                            info->conflicts,
                             histogram);
 }
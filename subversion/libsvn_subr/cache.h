@@ -82,6 +82,22 @@ typedef struct svn_cache__vtable_t {
                            svn_cache__info_t *info,
                            svn_boolean_t reset,
                            apr_pool_t *result_pool);
+
+  /* See svn_cache__get_many(). */
+  svn_error_t *(*get_many)(void **values,
+                           svn_boolean_t *found,
+                           void *cache_implementation,
+                           const void * const *keys,
+                           int count,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+  /* See svn_cache__set_many(). */
+  svn_error_t *(*set_many)(void *cache_implementation,
+                           const void * const *keys,
+                           void * const *values,
+                           int count,
+                           apr_pool_t *scratch_pool);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
@@ -64,6 +64,17 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Number of read-write locks per membuffer cache segment.  This is not
+ * part of svn_cache_config_t because that struct must not be extended.
+ */
+static apr_size_t cache_lock_stripes = 1;
+
+/* Whether to put the global membuffer cache into shared memory and the
+ * name of the shared memory region (NULL for an anonymous one).
+ */
+static svn_boolean_t cache_shared = FALSE;
+static const char *cache_shm_name = NULL;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +131,24 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      if (cache_shared)
+        err = svn_cache__membuffer_cache_create_shared(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            cache_shm_name,
+            pool);
+      else
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            cache_lock_stripes,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -179,3 +200,28 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+void
+svn_cache__config_set_lock_stripes(apr_size_t lock_stripes)
+{
+  cache_lock_stripes = lock_stripes;
+}
+
+apr_size_t
+svn_cache__config_get_lock_stripes(void)
+{
+  return cache_lock_stripes;
+}
+
+void
+svn_cache__config_set_shared(svn_boolean_t shared,
+                             const char *shm_name)
+{
+  cache_shared = shared;
+  cache_shm_name = shm_name;
+}
+
+svn_boolean_t
+svn_cache__config_get_shared(void)
+{
+  return cache_shared;
+}
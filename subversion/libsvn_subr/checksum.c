@@ -40,6 +40,26 @@
 
 #include "svn_private_config.h"
 
+/* SHA-1 block functions using the dedicated CPU instructions.
+ *
+ * The ARMv8 crypto extension is known at compile time, so we use it
+ * whenever the compiler has been told to.  The x86 SHA extension is not
+ * part of any base ABI and needs to be detected at runtime; we only need
+ * the compiler to support the respective intrinsics.
+ *
+ * Without either, we fall back to APR's portable implementation.
+ */
+#if defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#include <arm_neon.h>
+#define SVN_SHA1_ARMV8 1
+#elif (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#include <immintrin.h>
+#include <cpuid.h>
+#define SVN_SHA1_SHANI 1
+#endif
+
 
 
 /* The MD5 digest for the empty string. */
@@ -468,6 +488,332 @@ svn_checksum_dup(const svn_checksum_t *checksum,
     }
 }
 
+/* Process BLOCKS consecutive 64 byte blocks at DATA and update STATE. */
+typedef void (*sha1_blocks_fn_t)(apr_uint32_t state[5],
+                                 const unsigned char *data,
+                                 apr_size_t blocks);
+
+#if defined(SVN_SHA1_SHANI)
+
+/* Perform rounds 4*G .. 4*G+3 for 3 <= G <= 18 with the message schedule
+ * in W0 (current), W1, W2 and W3 (latest).  The latter three are being
+ * prepared for the following rounds along the way.  F selects the round
+ * function. */
+#define SHA1_SHANI_ROUNDS(e_in, e_out, w0, w1, w2, w3, f) \
+  do { \
+    e_in = _mm_sha1nexte_epu32(e_in, w0); \
+    e_out = abcd; \
+    w1 = _mm_sha1msg2_epu32(w1, w0); \
+    abcd = _mm_sha1rnds4_epu32(abcd, e_in, f); \
+    w3 = _mm_sha1msg1_epu32(w3, w0); \
+    w2 = _mm_xor_si128(w2, w0); \
+  } while (0)
+
+/* Implement sha1_blocks_fn_t using the x86 SHA extension. */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void
+sha1_blocks_shani(apr_uint32_t state[5],
+                  const unsigned char *data,
+                  apr_size_t blocks)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+                                      0x08090a0b0c0d0e0fULL);
+  __m128i abcd, e0, e1, abcd_saved, e0_saved;
+  __m128i w0, w1, w2, w3;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; blocks > 0; --blocks, data += 64)
+    {
+      abcd_saved = abcd;
+      e0_saved = e0;
+
+      /* Rounds 0-3 */
+      w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), mask);
+      e0 = _mm_add_epi32(e0, w0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      /* Rounds 4-7 */
+      w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)),
+                            mask);
+      e1 = _mm_sha1nexte_epu32(e1, w1);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+      w0 = _mm_sha1msg1_epu32(w0, w1);
+
+      /* Rounds 8-11 */
+      w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)),
+                            mask);
+      e0 = _mm_sha1nexte_epu32(e0, w2);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      w1 = _mm_sha1msg1_epu32(w1, w2);
+      w0 = _mm_xor_si128(w0, w2);
+
+      /* Rounds 12-75.  The last two steps prepare a few message words
+       * that we won't need but that is cheaper than special-casing. */
+      w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)),
+                            mask);
+      SHA1_SHANI_ROUNDS(e1, e0, w3, w0, w1, w2, 0);
+      SHA1_SHANI_ROUNDS(e0, e1, w0, w1, w2, w3, 0);
+      SHA1_SHANI_ROUNDS(e1, e0, w1, w2, w3, w0, 1);
+      SHA1_SHANI_ROUNDS(e0, e1, w2, w3, w0, w1, 1);
+      SHA1_SHANI_ROUNDS(e1, e0, w3, w0, w1, w2, 1);
+      SHA1_SHANI_ROUNDS(e0, e1, w0, w1, w2, w3, 1);
+      SHA1_SHANI_ROUNDS(e1, e0, w1, w2, w3, w0, 1);
+      SHA1_SHANI_ROUNDS(e0, e1, w2, w3, w0, w1, 2);
+      SHA1_SHANI_ROUNDS(e1, e0, w3, w0, w1, w2, 2);
+      SHA1_SHANI_ROUNDS(e0, e1, w0, w1, w2, w3, 2);
+      SHA1_SHANI_ROUNDS(e1, e0, w1, w2, w3, w0, 2);
+      SHA1_SHANI_ROUNDS(e0, e1, w2, w3, w0, w1, 2);
+      SHA1_SHANI_ROUNDS(e1, e0, w3, w0, w1, w2, 3);
+      SHA1_SHANI_ROUNDS(e0, e1, w0, w1, w2, w3, 3);
+      SHA1_SHANI_ROUNDS(e1, e0, w1, w2, w3, w0, 3);
+      SHA1_SHANI_ROUNDS(e0, e1, w2, w3, w0, w1, 3);
+
+      /* Rounds 76-79 */
+      e1 = _mm_sha1nexte_epu32(e1, w3);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+      e0 = _mm_sha1nexte_epu32(e0, e0_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+/* Return the SHA-1 block function to use on this machine. */
+static sha1_blocks_fn_t
+get_sha1_blocks(void)
+{
+  /* 0 = not checked yet, 1 = available, -1 = not available.
+   * Racing threads will simply come to the same conclusion. */
+  static volatile int available = 0;
+
+  if (available == 0)
+    {
+      unsigned int eax, ebx, ecx, edx;
+      svn_boolean_t has_sha = FALSE;
+
+      if (__get_cpuid_max(0, NULL) >= 7)
+        {
+          /* SSSE3 and SSE4.1 are reported in leaf 1, SHA in leaf 7. */
+          __cpuid(1, eax, ebx, ecx, edx);
+          if ((ecx & (1u << 9)) && (ecx & (1u << 19)))
+            {
+              __cpuid_count(7, 0, eax, ebx, ecx, edx);
+              has_sha = (ebx & (1u << 29)) != 0;
+            }
+        }
+
+      available = has_sha ? 1 : -1;
+    }
+
+  return available > 0 ? sha1_blocks_shani : NULL;
+}
+
+#elif defined(SVN_SHA1_ARMV8)
+
+/* Implement sha1_blocks_fn_t using the ARMv8 crypto extension. */
+static void
+sha1_blocks_armv8(apr_uint32_t state[5],
+                  const unsigned char *data,
+                  apr_size_t blocks)
+{
+  static const apr_uint32_t k[4] = {
+    0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+  };
+  uint32x4_t abcd = vld1q_u32(state);
+  apr_uint32_t e = state[4];
+
+  for (; blocks > 0; --blocks, data += 64)
+    {
+      uint32x4_t abcd_saved = abcd;
+      apr_uint32_t e_saved = e;
+      uint32x4_t w[4];
+      int g;
+
+      for (g = 0; g < 4; ++g)
+        w[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * g)));
+
+      /* 20 groups of 4 rounds each.  W[G % 4] holds the message words
+       * for group G once the schedule has been extended. */
+      for (g = 0; g < 20; ++g)
+        {
+          uint32x4_t wk;
+          apr_uint32_t e_next;
+
+          if (g >= 4)
+            w[g % 4] = vsha1su1q_u32(vsha1su0q_u32(w[g % 4],
+                                                   w[(g + 1) % 4],
+                                                   w[(g + 2) % 4]),
+                                     w[(g + 3) % 4]);
+
+          wk = vaddq_u32(w[g % 4], vdupq_n_u32(k[g / 5]));
+          e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+          if (g < 5)
+            abcd = vsha1cq_u32(abcd, e, wk);
+          else if (g >= 10 && g < 15)
+            abcd = vsha1mq_u32(abcd, e, wk);
+          else
+            abcd = vsha1pq_u32(abcd, e, wk);
+
+          e = e_next;
+        }
+
+      abcd = vaddq_u32(abcd, abcd_saved);
+      e += e_saved;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e;
+}
+
+/* Return the SHA-1 block function to use on this machine. */
+static sha1_blocks_fn_t
+get_sha1_blocks(void)
+{
+  return sha1_blocks_armv8;
+}
+
+#else
+
+/* Return the SHA-1 block function to use on this machine. */
+static sha1_blocks_fn_t
+get_sha1_blocks(void)
+{
+  return NULL;
+}
+
+#endif
+
+/* SHA-1 context.  If the CPU supports SHA-1, we use our own buffering and
+ * padding around the accelerated block function.  Otherwise, we simply
+ * defer to APR. */
+typedef struct sha1_ctx_t
+{
+  /* Accelerated block function or NULL to use APR. */
+  sha1_blocks_fn_t blocks;
+
+  /* Context used if BLOCKS is NULL. */
+  apr_sha1_ctx_t apr_ctx;
+
+  /* Hash state, total number of bytes processed and the incomplete
+   * last block.  Used if BLOCKS is not NULL. */
+  apr_uint32_t state[5];
+  apr_uint64_t length;
+  unsigned char buffer[64];
+} sha1_ctx_t;
+
+/* Initialize the SHA-1 context CTX. */
+static void
+sha1_init(sha1_ctx_t *ctx)
+{
+  ctx->blocks = get_sha1_blocks();
+  if (ctx->blocks)
+    {
+      ctx->state[0] = 0x67452301;
+      ctx->state[1] = 0xefcdab89;
+      ctx->state[2] = 0x98badcfe;
+      ctx->state[3] = 0x10325476;
+      ctx->state[4] = 0xc3d2e1f0;
+      ctx->length = 0;
+    }
+  else
+    {
+      apr_sha1_init(&ctx->apr_ctx);
+    }
+}
+
+/* Add LEN bytes at DATA to the SHA-1 context CTX. */
+static void
+sha1_update(sha1_ctx_t *ctx,
+            const void *data,
+            apr_size_t len)
+{
+  const unsigned char *p = data;
+  apr_size_t used;
+
+  if (!ctx->blocks)
+    {
+      apr_sha1_update(&ctx->apr_ctx, data, (unsigned int)len);
+      return;
+    }
+
+  used = (apr_size_t)(ctx->length % sizeof(ctx->buffer));
+  ctx->length += len;
+
+  /* Complete a partial block from earlier calls. */
+  if (used)
+    {
+      apr_size_t to_copy = MIN(sizeof(ctx->buffer) - used, len);
+      memcpy(ctx->buffer + used, p, to_copy);
+      p += to_copy;
+      len -= to_copy;
+
+      if (used + to_copy < sizeof(ctx->buffer))
+        return;
+
+      ctx->blocks(ctx->state, ctx->buffer, 1);
+    }
+
+  /* Process all full blocks directly from the caller's buffer. */
+  if (len >= sizeof(ctx->buffer))
+    {
+      apr_size_t blocks = len / sizeof(ctx->buffer);
+      ctx->blocks(ctx->state, p, blocks);
+      p += blocks * sizeof(ctx->buffer);
+      len -= blocks * sizeof(ctx->buffer);
+    }
+
+  memcpy(ctx->buffer, p, len);
+}
+
+/* Write the SHA-1 digest for all data added to CTX to DIGEST.
+ * CTX will be unusable afterwards. */
+static void
+sha1_final(unsigned char *digest,
+           sha1_ctx_t *ctx)
+{
+  apr_uint64_t bits = ctx->length * 8;
+  apr_size_t used;
+  int i;
+
+  if (!ctx->blocks)
+    {
+      apr_sha1_final(digest, &ctx->apr_ctx);
+      return;
+    }
+
+  used = (apr_size_t)(ctx->length % sizeof(ctx->buffer));
+  ctx->buffer[used++] = 0x80;
+  if (used > sizeof(ctx->buffer) - 8)
+    {
+      memset(ctx->buffer + used, 0, sizeof(ctx->buffer) - used);
+      ctx->blocks(ctx->state, ctx->buffer, 1);
+      used = 0;
+    }
+
+  memset(ctx->buffer + used, 0, sizeof(ctx->buffer) - 8 - used);
+  for (i = 0; i < 8; ++i)
+    ctx->buffer[sizeof(ctx->buffer) - 8 + i]
+      = (unsigned char)(bits >> (56 - 8 * i));
+
+  ctx->blocks(ctx->state, ctx->buffer, 1);
+
+  for (i = 0; i < 5; ++i)
+    {
+      digest[4 * i + 0] = (unsigned char)(ctx->state[i] >> 24);
+      digest[4 * i + 1] = (unsigned char)(ctx->state[i] >> 16);
+      digest[4 * i + 2] = (unsigned char)(ctx->state[i] >> 8);
+      digest[4 * i + 3] = (unsigned char)(ctx->state[i]);
+    }
+}
+
 svn_error_t *
 svn_checksum(svn_checksum_t **checksum,
              svn_checksum_kind_t kind,
@@ -475,7 +821,7 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
+  sha1_ctx_t sha1_ctx;
 
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
@@ -487,9 +833,9 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        sha1_init(&sha1_ctx);
+        sha1_update(&sha1_ctx, data, len);
+        sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -550,8 +896,8 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = apr_palloc(pool, sizeof(sha1_ctx_t));
+        sha1_init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -580,8 +926,8 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        memset(ctx->apr_ctx, 0, sizeof(sha1_ctx_t));
+        sha1_init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -611,7 +957,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        sha1_update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -644,7 +990,7 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -665,6 +1011,64 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+/* Feed the data to MD5 and SHA-1 in slices of this size, so the second
+ * pass over each slice will find it in the L1 cache. */
+#define MD5_SHA1_SLICE_SIZE 0x1000
+
+struct svn_checksum__md5_sha1_ctx_t
+{
+  apr_md5_ctx_t md5_ctx;
+  sha1_ctx_t sha1_ctx;
+};
+
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(apr_pool_t *result_pool)
+{
+  svn_checksum__md5_sha1_ctx_t *ctx = apr_palloc(result_pool, sizeof(*ctx));
+  svn_checksum__md5_sha1_ctx_reset(ctx);
+
+  return ctx;
+}
+
+void
+svn_checksum__md5_sha1_ctx_reset(svn_checksum__md5_sha1_ctx_t *ctx)
+{
+  apr_md5_init(&ctx->md5_ctx);
+  sha1_init(&ctx->sha1_ctx);
+}
+
+void
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len)
+{
+  const char *p = data;
+
+  while (len > 0)
+    {
+      apr_size_t slice = MIN(len, MD5_SHA1_SLICE_SIZE);
+
+      apr_md5_update(&ctx->md5_ctx, p, slice);
+      sha1_update(&ctx->sha1_ctx, p, slice);
+
+      p += slice;
+      len -= slice;
+    }
+}
+
+void
+svn_checksum__md5_sha1_final(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *result_pool)
+{
+  *md5_checksum = svn_checksum_create(svn_checksum_md5, result_pool);
+  apr_md5_final((unsigned char *)(*md5_checksum)->digest, &ctx->md5_ctx);
+
+  *sha1_checksum = svn_checksum_create(svn_checksum_sha1, result_pool);
+  sha1_final((unsigned char *)(*sha1_checksum)->digest, &ctx->sha1_ctx);
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
@@ -854,3 +1258,90 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
 
   return result;
 }
+
+/* Baton used by the write_handler_md5_sha1 and close_handler_md5_sha1. */
+typedef struct md5_sha1_stream_baton_t
+{
+  /* Stream we are wrapping. Forward write() and close() operations to it. */
+  svn_stream_t *inner_stream;
+
+  /* Build the checksum data in here. */
+  svn_checksum__md5_sha1_ctx_t *context;
+
+  /* Write the final checksums here. */
+  svn_checksum_t **md5_checksum;
+  svn_checksum_t **sha1_checksum;
+
+  /* Allocate the resulting checksums here. */
+  apr_pool_t *pool;
+} md5_sha1_stream_baton_t;
+
+/* Implement svn_write_fn_t.
+ * Update the checksums and pass data on to inner stream.
+ */
+static svn_error_t *
+write_handler_md5_sha1(void *baton,
+                       const char *data,
+                       apr_size_t *len)
+{
+  md5_sha1_stream_baton_t *b = baton;
+
+  svn_checksum__md5_sha1_update(b->context, data, *len);
+  SVN_ERR(svn_stream_write(b->inner_stream, data, len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_close_fn_t.
+ * Finalize the checksums and close the inner stream.
+ */
+static svn_error_t *
+close_handler_md5_sha1(void *baton)
+{
+  md5_sha1_stream_baton_t *b = baton;
+
+  svn_checksum__md5_sha1_final(b->md5_checksum, b->sha1_checksum,
+                               b->context, b->pool);
+
+  return svn_error_trace(svn_stream_close(b->inner_stream));
+}
+
+/* Implement svn_stream_seek_fn_t.
+ * Like the svn_stream_checksummed2() streams, we only support resets.
+ */
+static svn_error_t *
+seek_handler_md5_sha1(void *baton,
+                      const svn_stream_mark_t *mark)
+{
+  md5_sha1_stream_baton_t *b = baton;
+
+  if (mark)
+    return svn_error_create(SVN_ERR_STREAM_SEEK_NOT_SUPPORTED, NULL, NULL);
+
+  svn_checksum__md5_sha1_ctx_reset(b->context);
+  return svn_error_trace(svn_stream_reset(b->inner_stream));
+}
+
+svn_stream_t *
+svn_checksum__wrap_write_stream_md5_sha1(svn_checksum_t **md5_checksum,
+                                         svn_checksum_t **sha1_checksum,
+                                         svn_stream_t *inner_stream,
+                                         apr_pool_t *pool)
+{
+  svn_stream_t *outer_stream;
+
+  md5_sha1_stream_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+  baton->inner_stream = inner_stream;
+  baton->context = svn_checksum__md5_sha1_ctx_create(pool);
+  baton->md5_checksum = md5_checksum;
+  baton->sha1_checksum = sha1_checksum;
+  baton->pool = pool;
+
+  outer_stream = svn_stream_create(baton, pool);
+  svn_stream_set_write(outer_stream, write_handler_md5_sha1);
+  svn_stream_set_close(outer_stream, close_handler_md5_sha1);
+  if (svn_stream_supports_reset(inner_stream))
+    svn_stream_set_seek(outer_stream, seek_handler_md5_sha1);
+
+  return outer_stream;
+}
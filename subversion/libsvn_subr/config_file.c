@@ -59,7 +59,7 @@ typedef struct parse_context_t
   svn_config__constructor_t *constructor;
   void *constructor_baton;
 
-  /* The stream struct */
+  /* The stream struct.  NULL when parsing an in-memory buffer. */
   svn_stream_t *stream;
 
   /* The current line in the file */
@@ -78,12 +78,16 @@ typedef struct parse_context_t
   svn_stringbuf_t *line_read;
 
   /* Parser buffer for getc() to avoid call overhead into several libraries
-     for every character */
-  char parser_buffer[SVN__STREAM_CHUNK_SIZE]; /* Larger than most config files */
+     for every character.  Either points to STREAM_BUFFER or, when parsing
+     from memory, to the complete input data. */
+  const char *parser_buffer;
   size_t buffer_pos; /* Current position within parser_buffer */
   size_t buffer_size; /* parser_buffer contains this many bytes */
 
-  /* Non-zero if we hit EOF on the stream. */
+  /* Chunk buffer to read STREAM into.  NULL when parsing from memory. */
+  char *stream_buffer; /* SVN__STREAM_CHUNK_SIZE bytes */
+
+  /* Non-zero if we hit EOF on the stream or parse from memory. */
   svn_boolean_t hit_stream_eof;
 } parse_context_t;
 
@@ -218,11 +222,13 @@ parser_getc(parse_context_t *ctx, int *c)
           if (!ctx->hit_stream_eof)
             {
               ctx->buffer_pos = 0;
-              ctx->buffer_size = sizeof(ctx->parser_buffer);
+              ctx->buffer_size = SVN__STREAM_CHUNK_SIZE;
 
-              SVN_ERR(svn_stream_read_full(ctx->stream, ctx->parser_buffer,
+              SVN_ERR(svn_stream_read_full(ctx->stream, ctx->stream_buffer,
                                            &(ctx->buffer_size)));
-              ctx->hit_stream_eof = (ctx->buffer_size != sizeof(ctx->parser_buffer));
+              ctx->parser_buffer = ctx->stream_buffer;
+              ctx->hit_stream_eof
+                = (ctx->buffer_size != SVN__STREAM_CHUNK_SIZE);
             }
 
           if (ctx->buffer_pos < ctx->buffer_size)
@@ -387,7 +393,7 @@ skip_bom(parse_context_t *ctx)
   SVN_ERR(parser_getc(ctx, &ch));
   if (ch == 0xEF)
     {
-      const unsigned char *buf = (unsigned char *)ctx->parser_buffer;
+      const unsigned char *buf = (const unsigned char *)ctx->parser_buffer;
       /* This makes assumptions about the implementation of parser_getc and
        * the use of skip_bom.  Specifically that parser_getc() will get all
        * of the BOM characters into the parse_context_t buffer.  This can
@@ -715,13 +721,12 @@ svn_config__parse_file(svn_config_t *cfg, const char *file,
                        svn_boolean_t must_exist, apr_pool_t *result_pool)
 {
   svn_error_t *err = SVN_NO_ERROR;
-  apr_file_t *apr_file;
-  svn_stream_t *stream;
+  svn_stringbuf_t *contents;
   apr_pool_t *scratch_pool = svn_pool_create(result_pool);
 
-  /* Use unbuffered IO since we use our own buffering. */
-  err = svn_io_file_open(&apr_file, file, APR_READ, APR_OS_DEFAULT,
-                         scratch_pool);
+  /* Config files are small enough to be read in one go.  Parsing them
+     in memory saves the stream layer and copying them chunk by chunk. */
+  err = svn_stringbuf_from_file2(&contents, file, scratch_pool);
 
   if (! must_exist && err && APR_STATUS_IS_ENOENT(err->apr_err))
     {
@@ -732,8 +737,7 @@ svn_config__parse_file(svn_config_t *cfg, const char *file,
   else
     SVN_ERR(err);
 
-  stream = svn_stream_from_aprfile2(apr_file, FALSE, scratch_pool);
-  err = svn_config__parse_stream(stream,
+  err = svn_config__parse_buffer(contents->data, contents->len,
                                  svn_config__constructor_create(
                                      NULL, NULL,
                                      svn_config__default_add_value_fn,
@@ -748,27 +752,24 @@ svn_config__parse_file(svn_config_t *cfg, const char *file,
                               svn_dirent_local_style(file, scratch_pool));
     }
 
-  /* Close the streams (and other cleanup): */
+  /* Release the file contents (and other cleanup): */
   svn_pool_destroy(scratch_pool);
 
   return err;
 }
 
-svn_error_t *
-svn_config__parse_stream(svn_stream_t *stream,
-                         svn_config__constructor_t *constructor,
-                         void *constructor_baton,
-                         apr_pool_t *scratch_pool)
+/* Return a new parser context in SCRATCH_POOL that will pass the data
+ * to CONSTRUCTOR with CONSTRUCTOR_BATON.  The caller has to set up the
+ * input data. */
+static parse_context_t *
+create_parse_context(svn_config__constructor_t *constructor,
+                     void *constructor_baton,
+                     apr_pool_t *scratch_pool)
 {
-  parse_context_t *ctx;
-  svn_boolean_t stop;
-  int ch, count;
-
-  ctx = apr_palloc(scratch_pool, sizeof(*ctx));
+  parse_context_t *ctx = apr_pcalloc(scratch_pool, sizeof(*ctx));
 
   ctx->constructor = constructor;
   ctx->constructor_baton = constructor_baton;
-  ctx->stream = stream;
   ctx->line = 1;
   ctx->ungotten_char = EOF;
   ctx->in_section = FALSE;
@@ -776,9 +777,18 @@ svn_config__parse_stream(svn_stream_t *stream,
   ctx->option = svn_stringbuf_create_empty(scratch_pool);
   ctx->value = svn_stringbuf_create_empty(scratch_pool);
   ctx->line_read = svn_stringbuf_create_empty(scratch_pool);
-  ctx->buffer_pos = 0;
-  ctx->buffer_size = 0;
-  ctx->hit_stream_eof = FALSE;
+
+  return ctx;
+}
+
+/* Parse the input data of CTX and pass the results to its constructor.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parse_config(parse_context_t *ctx,
+             apr_pool_t *scratch_pool)
+{
+  svn_boolean_t stop;
+  int ch, count;
 
   SVN_ERR(skip_bom(ctx));
 
@@ -850,6 +860,46 @@ svn_config__parse_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_config__parse_stream(svn_stream_t *stream,
+                         svn_config__constructor_t *constructor,
+                         void *constructor_baton,
+                         apr_pool_t *scratch_pool)
+{
+  parse_context_t *ctx = create_parse_context(constructor, constructor_baton,
+                                              scratch_pool);
+
+  ctx->stream = stream;
+  ctx->stream_buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  ctx->parser_buffer = ctx->stream_buffer;
+  ctx->buffer_pos = 0;
+  ctx->buffer_size = 0;
+  ctx->hit_stream_eof = FALSE;
+
+  return svn_error_trace(parse_config(ctx, scratch_pool));
+}
+
+svn_error_t *
+svn_config__parse_buffer(const char *data,
+                         apr_size_t len,
+                         svn_config__constructor_t *constructor,
+                         void *constructor_baton,
+                         apr_pool_t *scratch_pool)
+{
+  parse_context_t *ctx = create_parse_context(constructor, constructor_baton,
+                                              scratch_pool);
+
+  /* The whole input is already in our buffer; there is nothing to read. */
+  ctx->stream = NULL;
+  ctx->stream_buffer = NULL;
+  ctx->parser_buffer = data;
+  ctx->buffer_pos = 0;
+  ctx->buffer_size = len;
+  ctx->hit_stream_eof = TRUE;
+
+  return svn_error_trace(parse_config(ctx, scratch_pool));
+}
+
 
 /* Helper for ensure_auth_dirs: create SUBDIR under AUTH_DIR, iff
    SUBDIR does not already exist, but ignore any errors.  Use POOL for
@@ -1154,6 +1204,17 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   svn-max-connections        Maximum number of parallel server" NL
+        "###                              connections to use for svn://"     NL
+        "###                              checkouts and updates."            NL
+        "###   http-enable-http2          Whether to offer HTTP/2 to https://" NL
+        "###                              servers and multiplex requests"    NL
+        "###                              over a single connection."         NL
+        "###   http-property-cache-size   Size in MB of the on-disk cache for"
+                                                                             NL
+        "###                              properties and directory listings" NL
+        "###                              of revision-pinned HTTP resources" NL
+        "###                              (0 disables it, the default)."     NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
         "###   ssl-trust-default-ca       Trust the system 'default' CAs"    NL
@@ -1512,6 +1573,31 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set conflict-log-cache to 'yes' to keep the repository"         NL
+        "### history scanned while looking for moves behind tree conflicts"  NL
+        "### in the 'conflict-logs' directory of the configuration area, so" NL
+        "### later runs need not fetch it again.  [New in 1.10]"             NL
+        "# conflict-log-cache = no"                                          NL
+        "### Set log-cache to 'yes' to keep the paths changed in each"       NL
+        "### revision shown by 'svn log --verbose' in the 'log-cache'"       NL
+        "### directory of the configuration area, so they are not fetched"   NL
+        "### from the repository again.  Log messages and other revision"    NL
+        "### properties are always fetched.  [New in 1.10]"                  NL
+        "# log-cache = no"                                                   NL
+        "### Set the number of threads that translate and write files"       NL
+        "### during 'svn export'.  Set to 1 to write files one after"        NL
+        "### another on the main thread.  [New in 1.10]"                     NL
+        "# export-jobs = 4"                                                  NL
+        "### Set the number of threads that look up the locations of"        NL
+        "### externals in their repositories during checkouts, updates and"  NL
+        "### switches, while earlier externals are being updated.  Set to 1" NL
+        "### to look up one external after another.  [New in 1.10]"          NL
+        "# externals-jobs = 4"                                               NL
+        "### Set the number of threads that compare consecutive revisions"   NL
+        "### during 'svn blame' while later revisions are still being"       NL
+        "### received.  Set to 1 to compare one revision after another on"   NL
+        "### the main thread.  [New in 1.10]"                                NL
+        "# blame-jobs = 4"                                                   NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1553,6 +1639,53 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to the path of a directory to share file contents between"  NL
+        "### working copies.  Pristine texts of all working copies using"    NL
+        "### the same directory are hard-linked to it, and checkouts and"    NL
+        "### updates over http:// don't download file contents that are"     NL
+        "### already present there.  The directory should be on the same"    NL
+        "### file system as the working copies.  Disabled by default."       NL
+        "# content-cache-dir ="                                              NL
+        "### Set the number of threads that compare the contents of files"   NL
+        "### with their pristine texts during status walks.  This helps if"  NL
+        "### many files have changed timestamps, e.g. after copying a"       NL
+        "### working copy or on network file systems.  Set to 1 to compare"  NL
+        "### files one after another on the main thread."                    NL
+        "# status-jobs = 4"                                                  NL
+        "### Set compress-pristines to 'yes' to store new pristine texts"    NL
+        "### compressed with LZ4.  This saves disk space at a small CPU"     NL
+        "### cost.  It only applies to working copies of format 32, which"   NL
+        "### clients older than 1.10 can't use."                             NL
+        "# compress-pristines = no"                                          NL
+        "### Set the number of threads that install files from the pristine" NL
+        "### store during checkouts and updates.  This helps with large"     NL
+        "### checkouts on fast disks.  The default of 1 installs files one"  NL
+        "### after another on the main thread."                              NL
+        "# install-jobs = 1"                                                 NL
+        "### Set the number of threads that read and delta files during"     NL
+        "### commits while earlier files are still being sent to the"        NL
+        "### server.  Set to 1 to handle files one after another on the"     NL
+        "### main thread."                                                   NL
+        "# commit-jobs = 2"                                                  NL
+        "### Set to true to let the working copy database use SQLite's"      NL
+        "### write-ahead log.  Readers then don't block writers, e.g. a"     NL
+        "### long 'svn status' and a concurrent commit.  Don't enable this"  NL
+        "### for working copies that are shared between users or accessed"   NL
+        "### read-only, since every client must be able to create and"       NL
+        "### write the wc.db-shm file.  It is ignored on known network file" NL
+        "### systems.  Working copies switch back to a rollback journal"     NL
+        "### when they are opened the next time without this option."        NL
+        "# sqlite-wal = false"                                               NL
+        "### Set the number of kBytes of the working copy database to read"  NL
+        "### through a memory mapping.  Disabled (0) by default."            NL
+        "# sqlite-mmap-size = 0"                                             NL
+        "### Set the SQLite page cache size in kBytes.  0 selects the"       NL
+        "### SQLite default of 2 MBytes."                                    NL
+        "# sqlite-cache-size = 0"                                            NL
+        "### Retry a locked database after short, growing sleeps.  Set to"  NL
+        "### false to use SQLite's coarser default steps instead.  Either"   NL
+        "### way, only one operation at a time can write to the database."   NL
+        "# busy-backoff = true"                                              NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -898,6 +898,18 @@ svn_io_file_rename(const char *from_path, const char *to_path,
                                              FALSE, pool));
 }
 
+svn_error_t *
+svn_io_copy_file(const char *src,
+                 const char *dst,
+                 svn_boolean_t copy_perms,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io_copy_file2(src, dst,
+                                           copy_perms ? SVN_IO_COPY_FILE_PERMS
+                                                      : 0,
+                                           NULL, pool));
+}
+
 svn_error_t *
 svn_io_write_atomic(const char *final_path,
                     const void *buf,
@@ -1199,6 +1199,52 @@ svn_relpath_join(const char *base,
   return path;
 }
 
+void
+svn_dirent__join_append(svn_stringbuf_t *dirent,
+                        const char *component)
+{
+  assert(svn_dirent_is_canonical(dirent->data, dirent->pool));
+  assert(svn_dirent_is_canonical(component, dirent->pool));
+
+  if (SVN_PATH_IS_EMPTY(component))
+    return;
+
+  /* Rooted components replace or amend the root of DIRENT, which is rare
+     and platform specific.  Let svn_dirent_join() deal with it. */
+  if (dirent_is_rooted(component))
+    {
+      svn_stringbuf_set(dirent, svn_dirent_join(dirent->data, component,
+                                                dirent->pool));
+      return;
+    }
+
+  if (dirent->len > 0
+      && dirent->data[dirent->len - 1] != '/'
+#ifdef SVN_USE_DOS_PATHS
+      && dirent->data[dirent->len - 1] != ':'
+#endif
+     )
+    svn_stringbuf_appendbyte(dirent, '/');
+
+  svn_stringbuf_appendcstr(dirent, component);
+}
+
+void
+svn_relpath__join_append(svn_stringbuf_t *relpath,
+                         const char *component)
+{
+  assert(relpath_is_canonical(relpath->data));
+  assert(relpath_is_canonical(component));
+
+  if (SVN_PATH_IS_EMPTY(component))
+    return;
+
+  if (relpath->len > 0)
+    svn_stringbuf_appendbyte(relpath, '/');
+
+  svn_stringbuf_appendcstr(relpath, component);
+}
+
 char *
 svn_dirent_dirname(const char *dirent, apr_pool_t *pool)
 {
@@ -1649,13 +1695,33 @@ svn_uri_canonicalize(const char *uri, apr_pool_t *pool)
 const char *
 svn_relpath_canonicalize(const char *relpath, apr_pool_t *pool)
 {
+  /* Most input is canonical already.  Verifying that is much cheaper
+     than rebuilding the path segment by segment. */
+  if (relpath_is_canonical(relpath))
+    return apr_pstrdup(pool, relpath);
+
   return canonicalize(type_relpath, relpath, pool);
 }
 
+const char *
+svn_relpath__ensure_canonical(const char *relpath, apr_pool_t *result_pool)
+{
+  if (relpath_is_canonical(relpath))
+    return relpath;
+
+  return canonicalize(type_relpath, relpath, result_pool);
+}
+
 const char *
 svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
 {
-  const char *dst = canonicalize(type_dirent, dirent, pool);
+  const char *dst;
+
+  /* See svn_relpath_canonicalize(). */
+  if (svn_dirent_is_canonical(dirent, pool))
+    return apr_pstrdup(pool, dirent);
+
+  dst = canonicalize(type_dirent, dirent, pool);
 
 #ifdef SVN_USE_DOS_PATHS
   /* Handle a specific case on Windows where path == "X:/". Here we have to
@@ -1678,6 +1744,15 @@ svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
   return dst;
 }
 
+const char *
+svn_dirent__ensure_canonical(const char *dirent, apr_pool_t *result_pool)
+{
+  if (svn_dirent_is_canonical(dirent, result_pool))
+    return dirent;
+
+  return svn_dirent_canonicalize(dirent, result_pool);
+}
+
 svn_boolean_t
 svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 {
@@ -1691,8 +1766,11 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
         {
           /* TODO: Scan hostname and sharename and fall back to part code */
 
-          /* ### Fall back to old implementation */
-          return (strcmp(dirent, svn_dirent_canonicalize(dirent, scratch_pool))
+          /* ### Fall back to old implementation.  UNC paths never hit
+             the special cases in svn_dirent_canonicalize(), which in
+             turn calls us. */
+          return (strcmp(dirent, canonicalize(type_dirent, dirent,
+                                              scratch_pool))
                   == 0);
         }
 #endif /* SVN_USE_DOS_PATHS */
@@ -2510,6 +2588,9 @@ svn_fspath__canonicalize(const char *fspath,
   if ((fspath[0] == '/') && (fspath[1] == '\0'))
     return "/";
 
+  if (svn_fspath__is_canonical(fspath))
+    return apr_pstrdup(pool, fspath);
+
   return apr_pstrcat(pool, "/", svn_relpath_canonicalize(fspath, pool),
                      SVN_VA_NULL);
 }
@@ -30,9 +30,53 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* Use 16 byte vector compares where the compiler guarantees the respective
+ * instruction set to be available.  Both SSE2 on x86-64 and NEON on AArch64
+ * are part of the base ABI, so no runtime CPU detection is required. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SVN_EOL_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SVN_EOL_SCAN_NEON 1
+#endif
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+#if defined(SVN_EOL_SCAN_SSE2)
+  {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    /* Vector loads don't care about alignment.  The loops below find the
+     * exact position within the first chunk containing an EOL. */
+    for (; len >= 16; buf += 16, len -= 16)
+      {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                           _mm_cmpeq_epi8(chunk, lf))))
+          break;
+      }
+  }
+#elif defined(SVN_EOL_SCAN_NEON)
+  {
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t lf = vdupq_n_u8('\n');
+
+    for (; len >= 16; buf += 16, len -= 16)
+      {
+        uint8x16_t chunk = vld1q_u8((const uint8_t *)buf);
+        uint64x2_t hit = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(chunk, cr),
+                                                       vceqq_u8(chunk, lf)));
+
+        if (vgetq_lane_u64(hit, 0) | vgetq_lane_u64(hit, 1))
+          break;
+      }
+  }
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -251,6 +251,107 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
 }
 
 
+/* Parse the length line of type TYPE (e.g. 'K') at *P, replacing its
+   newline with a NUL.  The line must end before END.  Set *LEN to the
+   length given in the line and *P to the start of the next line.
+   Use MESSAGE for the error if the length is malformed. */
+static svn_error_t *
+parse_length_line(apr_size_t *len,
+                  char **p,
+                  const char *end,
+                  char type,
+                  const char *message)
+{
+  char *eol = memchr(*p, '\n', end - *p);
+  apr_uint64_t ui64;
+  svn_error_t *err;
+
+  if (eol == NULL || eol - *p < 3 || (*p)[0] != type || (*p)[1] != ' ')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash malformed"));
+
+  *eol = '\0';
+  err = svn_cstring_strtoui64(&ui64, *p + 2, 0, APR_SIZE_MAX, 10);
+  if (err)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, err, message);
+
+  *len = (apr_size_t)ui64;
+  *p = eol + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the data of length LEN at *P, which must be followed by
+   a newline before END, and set *P to the start of the next line.
+   Use MESSAGE for the error if the data is malformed. */
+static svn_error_t *
+terminate_data(char **p,
+               apr_size_t len,
+               const char *end,
+               const char *message)
+{
+  if (len >= (apr_size_t)(end - *p) || (*p)[len] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, message);
+
+  (*p)[len] = '\0';
+  *p += len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool)
+{
+  char *p = data;
+  const char *end = data + len;
+  apr_size_t terminator_len = terminator ? strlen(terminator) : 0;
+
+  while (TRUE)
+    {
+      const char *eol;
+      char *key;
+      apr_size_t keylen;
+      svn_string_t *val;
+
+      /* Check for the end of the hash. */
+      if (p == end)
+        {
+          if (terminator)
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Serialized hash missing terminator"));
+          break;
+        }
+
+      eol = memchr(p, '\n', end - p);
+      if (terminator
+          && (eol ? eol : end) - p == (apr_ssize_t)terminator_len
+          && memcmp(p, terminator, terminator_len) == 0)
+        break;
+
+      SVN_ERR(parse_length_line(&keylen, &p, end, 'K',
+                                _("Serialized hash malformed key length")));
+      key = p;
+      SVN_ERR(terminate_data(&p, keylen, end,
+                             _("Serialized hash malformed key data")));
+
+      val = apr_palloc(pool, sizeof(*val));
+      SVN_ERR(parse_length_line(&val->len, &p, end, 'V',
+                                _("Serialized hash malformed value length")));
+      val->data = p;
+      SVN_ERR(terminate_data(&p, val->len, end,
+                             _("Serialized hash malformed value data")));
+
+      apr_hash_set(hash, key, keylen, val);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Implements svn_hash_write2 and svn_hash_write_incremental. */
 static svn_error_t *
 hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
@@ -666,3 +767,26 @@ svn_hash__make(apr_pool_t *pool)
 {
   return apr_hash_make_custom(pool, hashfunc_compatible);
 }
+
+/* apr_hashfunc_t based on svn__hash64.  It distributes keys well, even
+ * if they differ only in a few bits, and processes long keys faster than
+ * hashfunc_compatible.
+ */
+static unsigned int
+hashfunc_fast(const char *char_key, apr_ssize_t *klen)
+{
+  apr_uint64_t hash;
+
+  if (*klen == APR_HASH_KEY_STRING)
+    *klen = strlen(char_key);
+
+  /* APR uses the lower bits only.  Make all of them count. */
+  hash = svn__hash64(char_key, *klen, 0);
+  return (unsigned int)(hash ^ (hash >> 32));
+}
+
+apr_hash_t *
+svn_hash__make_fast(apr_pool_t *pool)
+{
+  return apr_hash_make_custom(pool, hashfunc_fast);
+}
@@ -0,0 +1,165 @@
+/*
+ * hash64.c :  fast 64 bit non-cryptographic hash function
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "private/svn_subr_private.h"
+
+/**
+ * This follows the structure of wyhash (final version 4), see
+ * https://github.com/wangyi-fudan/wyhash for more info.  Its main
+ * operation is a 64 x 64 -> 128 bit multiplication whose halves get
+ * folded.  Long inputs are processed in 3 independent lanes, so modern
+ * CPUs can keep several multipliers busy at once.
+ *
+ * Since we only use the result within the same process, we read the
+ * input in machine byte order.
+ */
+
+/* Mixing constants. */
+static const apr_uint64_t secret[4] = {
+  APR_UINT64_C(0xa0761d6478bd642f), APR_UINT64_C(0xe7037ed1a0b428db),
+  APR_UINT64_C(0x8ebc6af09c88c6e3), APR_UINT64_C(0x589965cc75374cc3)
+};
+
+/* Replace *A and *B with the lower and upper half of their 128 bit
+ * product, respectively. */
+static APR_INLINE void
+mum(apr_uint64_t *a, apr_uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)*a * *b;
+  *a = (apr_uint64_t)r;
+  *b = (apr_uint64_t)(r >> 64);
+#else
+  apr_uint64_t ha = *a >> 32, hb = *b >> 32;
+  apr_uint64_t la = (apr_uint32_t)*a, lb = (apr_uint32_t)*b;
+  apr_uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  apr_uint64_t t = rl + (rm0 << 32);
+  apr_uint64_t lo = t + (rm1 << 32);
+  apr_uint64_t carry = (t < rl) + (lo < t);
+
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+/* Return the folded 128 bit product of A and B. */
+static APR_INLINE apr_uint64_t
+mix(apr_uint64_t a, apr_uint64_t b)
+{
+  mum(&a, &b);
+  return a ^ b;
+}
+
+/* Read 8 bytes at P. */
+static APR_INLINE apr_uint64_t
+read64(const unsigned char *p)
+{
+  apr_uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* Read 4 bytes at P. */
+static APR_INLINE apr_uint64_t
+read32(const unsigned char *p)
+{
+  apr_uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+apr_uint64_t
+svn__hash64(const void *input,
+            apr_size_t len,
+            apr_uint64_t seed)
+{
+  const unsigned char *p = input;
+  apr_uint64_t a, b;
+
+  seed ^= mix(seed ^ secret[0], secret[1]);
+  if (len <= 16)
+    {
+      if (len >= 4)
+        {
+          /* Two possibly overlapping 4 byte reads from either end cover
+           * up to 16 bytes. */
+          apr_size_t mid = (len >> 3) << 2;
+          a = (read32(p) << 32) | read32(p + mid);
+          b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+        }
+      else if (len > 0)
+        {
+          a = ((apr_uint64_t)p[0] << 16)
+            | ((apr_uint64_t)p[len >> 1] << 8)
+            | p[len - 1];
+          b = 0;
+        }
+      else
+        {
+          a = 0;
+          b = 0;
+        }
+    }
+  else
+    {
+      apr_size_t i = len;
+
+      if (i > 48)
+        {
+          apr_uint64_t see1 = seed;
+          apr_uint64_t see2 = seed;
+
+          do
+            {
+              seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+              see1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ see1);
+              see2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ see2);
+              p += 48;
+              i -= 48;
+            }
+          while (i > 48);
+
+          seed ^= see1 ^ see2;
+        }
+
+      while (i > 16)
+        {
+          seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+          p += 16;
+          i -= 16;
+        }
+
+      /* The last 16 bytes, possibly overlapping with data already seen. */
+      a = read64(p + i - 16);
+      b = read64(p + i - 8);
+    }
+
+  a ^= secret[1];
+  b ^= seed;
+  mum(&a, &b);
+
+  return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
@@ -51,6 +51,34 @@
 #include <fcntl.h>
 #endif
 
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#if defined(__linux__) && defined(HAVE_SENDFILE) \
+ && defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#define USE_LINUX_SENDFILE
+#endif
+
+#ifdef HAVE_CLONEFILE
+#include <sys/clonefile.h>
+#endif
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT1)
+#include <errno.h>
+#include <sys/inotify.h>
+#define USE_INOTIFY
+#endif
+
+#if defined(__linux__) && defined(HAVE_FSTATAT)
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#define USE_DIRFD_STAT
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -68,6 +96,7 @@
 #include "private/svn_io_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_eol_private.h"
 
 #define SVN_SLEEP_ENV_VAR "SVN_I_LOVE_CORRUPTED_WORKING_COPIES_SO_DISABLE_SLEEP_FOR_TIMESTAMPS"
 
@@ -869,17 +898,187 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(USE_LINUX_SENDFILE)
+/* Return TRUE if a failed kernel-side copy with OS error code ERR is a
+ * hint that the respective mechanism is not available for the given pair
+ * of files, i.e. we should simply use the next best way to copy them. */
+static svn_boolean_t
+kernel_copy_unsupported(int err)
+{
+  switch (err)
+    {
+      case EINVAL:
+      case EXDEV:
+      case EBADF:
+      case EPERM:
+#ifdef ENOSYS
+      case ENOSYS:
+#endif
+#ifdef EOPNOTSUPP
+      case EOPNOTSUPP:
+#endif
+#if defined(ENOTSUP) && (!defined(EOPNOTSUPP) || ENOTSUP != EOPNOTSUPP)
+      case ENOTSUP:
+#endif
+#ifdef ENOTTY
+      case ENOTTY:
+#endif
+        return TRUE;
+
+      default:
+        return FALSE;
+    }
+}
+#endif
+
+/* Transfer as much of the contents of FROM_FILE to TO_FILE as possible
+ * without passing the data through user space.  Set *DONE to TRUE, if
+ * the copy is complete.  Otherwise, set it to FALSE.  The latter will
+ * happen if the platform or file system doesn't support any such
+ * mechanism, in which case it is the caller's job to copy the remainder
+ * starting at the current file pointers.  If ALLOW_CLONE is set, TO_FILE
+ * may become a reflink copy sharing the data blocks with FROM_FILE, in
+ * which case *CLONED will be set to TRUE.  It will not be modified
+ * otherwise.
+ *
+ * Both files must have been freshly opened, i.e. there must not be any
+ * data in the APR file buffers.
+ */
+static apr_status_t
+kernel_copy_contents(svn_boolean_t *done,
+                     svn_boolean_t *cloned,
+                     apr_file_t *from_file,
+                     apr_file_t *to_file,
+                     svn_boolean_t allow_clone)
+{
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE) \
+ || defined(USE_LINUX_SENDFILE)
+  apr_os_file_t from_fd, to_fd;
+#endif
+#if defined(HAVE_COPY_FILE_RANGE) || defined(USE_LINUX_SENDFILE)
+  svn_boolean_t copied_any = FALSE;
+#endif
+
+  *done = FALSE;
+
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE) \
+ || defined(USE_LINUX_SENDFILE)
+  if (   apr_os_file_get(&from_fd, from_file)
+      || apr_os_file_get(&to_fd, to_file))
+    return APR_SUCCESS;
+#endif
+
+#ifdef FICLONE
+  /* Cloning is all-or-nothing.  Any failure leaves TO_FILE untouched. */
+  if (allow_clone && ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *done = TRUE;
+      *cloned = TRUE;
+      return APR_SUCCESS;
+    }
+#endif
+
+  /* For the following mechanisms, a return value of 0 most likely means
+   * EOF.  We let the caller's read loop confirm that, so we don't depend
+   * on file systems reporting their data sizes correctly. */
+
+#ifdef HAVE_COPY_FILE_RANGE
+  while (1)
+    {
+      ssize_t copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                       0x40000000, 0);
+      if (copied > 0)
+        {
+          copied_any = TRUE;
+        }
+      else if (copied == 0)
+        {
+          return APR_SUCCESS;
+        }
+      else if (errno != EINTR)
+        {
+          /* Older kernels don't support this for all pairs of files.
+           * Try the next option. */
+          if (copied_any || !kernel_copy_unsupported(errno))
+            return apr_get_os_error();
+
+          break;
+        }
+    }
+#endif
+
+#ifdef USE_LINUX_SENDFILE
+  while (1)
+    {
+      ssize_t copied = sendfile(to_fd, from_fd, NULL, 0x40000000);
+      if (copied > 0)
+        {
+          copied_any = TRUE;
+        }
+      else if (copied == 0)
+        {
+          return APR_SUCCESS;
+        }
+      else if (errno != EINTR)
+        {
+          if (copied_any || !kernel_copy_unsupported(errno))
+            return apr_get_os_error();
+
+          break;
+        }
+    }
+#endif
+
+  return APR_SUCCESS;
+}
+
+#ifdef HAVE_CLONEFILE
+/* Try to replace DST with a clone of SRC using clonefile().  Set *DONE
+ * to TRUE upon success and to FALSE if the file system doesn't support
+ * that.  The clone will have the same permissions as SRC.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+clone_file(svn_boolean_t *done,
+           const char *src,
+           const char *dst,
+           apr_pool_t *pool)
+{
+  const char *dst_tmp;
+  const char *src_apr, *dst_tmp_apr;
+
+  *done = FALSE;
+
+  /* clonefile() insists on creating its target.  So, reserve a unique
+     name in the target folder first and replace the placeholder. */
+  SVN_ERR(svn_io_open_unique_file3(NULL, &dst_tmp,
+                                   svn_dirent_dirname(dst, pool),
+                                   svn_io_file_del_none, pool, pool));
+  SVN_ERR(svn_io_remove_file2(dst_tmp, FALSE, pool));
+
+  SVN_ERR(cstring_from_utf8(&src_apr, src, pool));
+  SVN_ERR(cstring_from_utf8(&dst_tmp_apr, dst_tmp, pool));
+  if (clonefile(src_apr, dst_tmp_apr, CLONE_NOFOLLOW) != 0)
+    return SVN_NO_ERROR;
+
+  *done = TRUE;
+
+  return svn_error_trace(svn_io_file_rename2(dst_tmp, dst, FALSE, pool));
+}
+#endif
 
 svn_error_t *
-svn_io_copy_file(const char *src,
-                 const char *dst,
-                 svn_boolean_t copy_perms,
-                 apr_pool_t *pool)
+svn_io_copy_file2(const char *src,
+                  const char *dst,
+                  apr_int32_t flags,
+                  svn_boolean_t *cloned,
+                  apr_pool_t *scratch_pool)
 {
   apr_file_t *from_file, *to_file;
   apr_status_t apr_err;
   const char *dst_tmp;
   svn_error_t *err;
+  svn_boolean_t done;
+  svn_boolean_t is_clone = FALSE;
 
   /* ### NOTE: sometimes src == dst. In this case, because we copy to a
      ###   temporary file, and then rename over the top of the destination,
@@ -894,53 +1093,82 @@ svn_io_copy_file(const char *src,
      ###     because of this copy-to-temp-then-rename implementation. If it
      ###     weren't for that, the switch would break.
   */
+  if (cloned)
+    *cloned = FALSE;
+
 #ifdef CHECK_FOR_SAME_FILE
   if (strcmp(src, dst) == 0)
     return SVN_NO_ERROR;
 #endif
 
+#ifdef HAVE_CLONEFILE
+  /* Clones always inherit the source permissions, so we can only use
+     them if that is what the caller asked for. */
+  if ((flags & SVN_IO_COPY_FILE_CLONE) && (flags & SVN_IO_COPY_FILE_PERMS))
+    {
+      SVN_ERR(clone_file(&done, src, dst, scratch_pool));
+      if (done)
+        {
+          if (cloned)
+            *cloned = TRUE;
+
+          return SVN_NO_ERROR;
+        }
+    }
+#endif
+
   SVN_ERR(svn_io_file_open(&from_file, src, APR_READ,
-                           APR_OS_DEFAULT, pool));
+                           APR_OS_DEFAULT, scratch_pool));
 
   /* For atomicity, we copy to a tmp file and then rename the tmp
      file over the real destination. */
 
   SVN_ERR(svn_io_open_unique_file3(&to_file, &dst_tmp,
-                                   svn_dirent_dirname(dst, pool),
-                                   svn_io_file_del_none, pool, pool));
+                                   svn_dirent_dirname(dst, scratch_pool),
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
+  apr_err = kernel_copy_contents(&done, &is_clone, from_file, to_file,
+                                 (flags & SVN_IO_COPY_FILE_CLONE) != 0);
+  if (!apr_err && !done)
+    apr_err = copy_contents(from_file, to_file, scratch_pool);
 
   if (apr_err)
     {
       err = svn_error_wrap_apr(apr_err, _("Can't copy '%s' to '%s'"),
-                               svn_dirent_local_style(src, pool),
-                               svn_dirent_local_style(dst_tmp, pool));
+                               svn_dirent_local_style(src, scratch_pool),
+                               svn_dirent_local_style(dst_tmp, scratch_pool));
     }
    else
      err = NULL;
 
   err = svn_error_compose_create(err,
-                                 svn_io_file_close(from_file, pool));
+                                 svn_io_file_close(from_file, scratch_pool));
 
   err = svn_error_compose_create(err,
-                                 svn_io_file_close(to_file, pool));
+                                 svn_io_file_close(to_file, scratch_pool));
 
   if (err)
     {
       return svn_error_compose_create(
                                  err,
-                                 svn_io_remove_file2(dst_tmp, TRUE, pool));
+                                 svn_io_remove_file2(dst_tmp, TRUE,
+                                                     scratch_pool));
     }
 
   /* If copying perms, set the perms on dst_tmp now, so they will be
      atomically inherited in the upcoming rename.  But note that we
      had to wait until now to set perms, because if they say
      read-only, then we'd have failed filling dst_tmp's contents. */
-  if (copy_perms)
-    SVN_ERR(svn_io_copy_perms(src, dst_tmp, pool));
+  if (flags & SVN_IO_COPY_FILE_PERMS)
+    SVN_ERR(svn_io_copy_perms(src, dst_tmp, scratch_pool));
 
-  return svn_error_trace(svn_io_file_rename2(dst_tmp, dst, FALSE, pool));
+  SVN_ERR(svn_io_file_rename2(dst_tmp, dst, FALSE, scratch_pool));
+
+  if (cloned)
+    *cloned = is_clone;
+
+  return SVN_NO_ERROR;
 }
 
 #if !defined(WIN32) && !defined(__OS2__)
@@ -1130,8 +1358,10 @@ svn_error_t *svn_io_copy_dir_recursively(const char *src,
               const char *dst_target = svn_dirent_join(dst_path,
                                                        entryname_utf8,
                                                        subpool);
-              SVN_ERR(svn_io_copy_file(src_target, dst_target,
-                                       copy_perms, subpool));
+              SVN_ERR(svn_io_copy_file2(src_target, dst_target,
+                                        copy_perms ? SVN_IO_COPY_FILE_PERMS
+                                                   : 0,
+                                        NULL, subpool));
             }
           else if (this_entry.filetype == APR_LNK) /* symlink */
             {
@@ -1273,7 +1503,8 @@ svn_io_dir_file_copy(const char *src_path,
   const char *file_src_path = svn_dirent_join(src_path, file, pool);
 
   return svn_error_trace(
-            svn_io_copy_file(file_src_path, file_dest_path, TRUE, pool));
+            svn_io_copy_file2(file_src_path, file_dest_path,
+                              SVN_IO_COPY_FILE_PERMS, NULL, pool));
 }
 
 
@@ -1522,7 +1753,8 @@ reown_file(const char *path,
                                    svn_dirent_dirname(path, pool),
                                    svn_io_file_del_none, pool, pool));
   SVN_ERR(svn_io_file_rename2(path, unique_name, FALSE, pool));
-  SVN_ERR(svn_io_copy_file(unique_name, path, TRUE, pool));
+  SVN_ERR(svn_io_copy_file2(unique_name, path, SVN_IO_COPY_FILE_PERMS, NULL,
+                            pool));
   return svn_error_trace(svn_io_remove_file2(unique_name, FALSE, pool));
 }
 
@@ -2511,6 +2743,152 @@ svn_error_t *svn_io_file_flush_to_disk(apr_file_t *file,
   return SVN_NO_ERROR;
 }
 
+void
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length)
+{
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+  apr_os_file_t filehand;
+
+  if (offset < 0 || length <= 0)
+    return;
+
+  /* This is merely a hint.  The kernel will schedule the reads in the
+     background and return immediately.  Failures are irrelevant to our
+     callers since they will read the data through the normal path anyway. */
+  if (apr_os_file_get(&filehand, file) == APR_SUCCESS)
+    (void)posix_fadvise(filehand, offset, length, POSIX_FADV_WILLNEED);
+#endif
+}
+
+
+#ifdef USE_INOTIFY
+
+struct svn_io__file_watcher_t
+{
+  /* inotify instance watching the parent directory of the file. */
+  int fd;
+
+  /* Native name of the watched file within that directory. */
+  const char *name;
+
+  /* Set once we lost track of the directory or missed events.  The file
+     must then be considered modified at all times. */
+  svn_boolean_t broken;
+};
+
+/* APR pool cleanup handler closing the svn_io__file_watcher_t in DATA. */
+static apr_status_t
+close_file_watcher(void *data)
+{
+  svn_io__file_watcher_t *watcher = data;
+  close(watcher->fd);
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+svn_error_t *
+svn_io__file_watcher_create(svn_io__file_watcher_t **watcher,
+                            const char *path,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+#ifdef USE_INOTIFY
+  svn_io__file_watcher_t *result;
+  const char *dir_apr;
+  const char *name_apr;
+  int fd;
+
+  *watcher = NULL;
+  SVN_ERR(cstring_from_utf8(&dir_apr, svn_dirent_dirname(path, scratch_pool),
+                            scratch_pool));
+  SVN_ERR(cstring_from_utf8(&name_apr, svn_dirent_basename(path, NULL),
+                            result_pool));
+
+  /* Renaming a file over PATH removes the inode that we could watch.
+     Therefore, watch the directory and filter by name. */
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0)
+    return SVN_NO_ERROR;
+
+  if (inotify_add_watch(fd, dir_apr,
+                        IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                        | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF
+                        | IN_MOVE_SELF | IN_ONLYDIR) < 0)
+    {
+      close(fd);
+      return SVN_NO_ERROR;
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->fd = fd;
+  result->name = name_apr;
+  result->broken = FALSE;
+  apr_pool_cleanup_register(result_pool, result, close_file_watcher,
+                            apr_pool_cleanup_null);
+
+  *watcher = result;
+#else
+  *watcher = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_io__file_watcher_changed(svn_io__file_watcher_t *watcher)
+{
+#ifdef USE_INOTIFY
+  union
+    {
+      struct inotify_event event;
+      char data[4096];
+    } buffer;
+  svn_boolean_t changed = FALSE;
+
+  /* Drain all pending events. */
+  while (!watcher->broken)
+    {
+      ssize_t len = read(watcher->fd, &buffer, sizeof(buffer));
+      const char *p;
+
+      if (len < 0 && errno == EINTR)
+        continue;
+
+      if (len <= 0)
+        {
+          /* Anything but "no more events" means we can't trust the
+             watcher anymore. */
+          if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            watcher->broken = TRUE;
+
+          break;
+        }
+
+      for (p = buffer.data; p < buffer.data + len; )
+        {
+          const struct inotify_event *event = (const void *)p;
+
+          if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_UNMOUNT
+                             | IN_DELETE_SELF | IN_MOVE_SELF))
+            watcher->broken = TRUE;
+          else if (event->len && strcmp(event->name, watcher->name) == 0)
+            changed = TRUE;
+
+          p += sizeof(*event) + event->len;
+        }
+    }
+
+  return changed || watcher->broken;
+#else
+  /* Watchers can't be created on this platform. */
+  return TRUE;
+#endif
+}
+
 
 
 /* TODO write test for these two functions, then refactor. */
@@ -2808,6 +3186,184 @@ svn_io_dirent2_dup(const svn_io_dirent2_t *item,
                      sizeof(*item));
 }
 
+#ifdef USE_DIRFD_STAT
+
+/* Set *KIND and *IS_SPECIAL from the file type bits in MODE. */
+static void
+map_mode_to_node_kind(svn_node_kind_t *kind,
+                      svn_boolean_t *is_special,
+                      mode_t mode)
+{
+  *is_special = FALSE;
+
+  if (S_ISREG(mode))
+    *kind = svn_node_file;
+  else if (S_ISDIR(mode))
+    *kind = svn_node_dir;
+  else if (S_ISLNK(mode))
+    {
+      *is_special = TRUE;
+      *kind = svn_node_file;
+    }
+  else
+    *kind = svn_node_unknown;
+}
+
+/* Fill DIRENT for the entry NAME in the directory open as DIR_FD, without
+   following symlinks.  If ONLY_CHECK_TYPE is set, we only need the node
+   kind.  Set *GONE if NAME has been removed in the meantime.  Return the
+   error code in case of failure. */
+static apr_status_t
+stat_dir_entry(svn_io_dirent2_t *dirent,
+               svn_boolean_t *gone,
+               int dir_fd,
+               const char *name,
+               svn_boolean_t only_check_type)
+{
+  mode_t mode;
+  int rc;
+
+#if defined(HAVE_STATX) && defined(STATX_BASIC_STATS)
+  /* Tell the file system what we need, so network file systems in
+     particular don't have to fetch the full inode data. */
+  struct statx info;
+  unsigned int mask = STATX_TYPE;
+
+  if (!only_check_type)
+    mask |= STATX_SIZE | STATX_MTIME;
+
+  rc = statx(dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask,
+             &info);
+  if (!rc)
+    mode = info.stx_mode;
+  if (!rc && !only_check_type)
+    {
+      dirent->filesize = info.stx_size;
+      dirent->mtime = apr_time_from_sec(info.stx_mtime.tv_sec)
+                    + info.stx_mtime.tv_nsec / 1000;
+    }
+#else
+  struct stat info;
+
+  rc = fstatat(dir_fd, name, &info, AT_SYMLINK_NOFOLLOW);
+  if (!rc)
+    mode = info.st_mode;
+  if (!rc && !only_check_type)
+    {
+      dirent->filesize = info.st_size;
+      dirent->mtime = apr_time_from_sec(info.st_mtim.tv_sec)
+                    + info.st_mtim.tv_nsec / 1000;
+    }
+#endif
+
+  *gone = FALSE;
+  if (rc)
+    {
+      if (errno == ENOENT)
+        {
+          *gone = TRUE;
+          return APR_SUCCESS;
+        }
+
+      return APR_FROM_OS_ERROR(errno);
+    }
+
+  map_mode_to_node_kind(&dirent->kind, &dirent->special, mode);
+  return APR_SUCCESS;
+}
+
+/* Implement svn_io_get_dirents3() with plain POSIX directory functions.
+   On most file systems, the directory entries already tell us the node
+   kind, so ONLY_CHECK_TYPE listings need no further system calls.  Other
+   data gets read relative to the open directory, which avoids resolving
+   the whole path again for every entry.  PATH_APR is PATH in native
+   encoding. */
+static svn_error_t *
+get_dirents_dirfd(apr_hash_t *dirents,
+                  const char *path,
+                  const char *path_apr,
+                  svn_boolean_t only_check_type,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  DIR *dir = opendir(path_apr);
+  int dir_fd;
+  apr_status_t status = APR_SUCCESS;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (dir == NULL)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't open directory '%s'"),
+                              svn_dirent_local_style(path, scratch_pool));
+
+  dir_fd = dirfd(dir);
+  while (!status && !err)
+    {
+      struct dirent *entry;
+      svn_io_dirent2_t *dirent;
+      svn_boolean_t gone = FALSE;
+      const char *name;
+
+      errno = 0;
+      entry = readdir(dir);
+      if (entry == NULL)
+        {
+          status = APR_FROM_OS_ERROR(errno);
+          break;
+        }
+
+      if ((entry->d_name[0] == '.')
+          && ((entry->d_name[1] == '\0')
+              || ((entry->d_name[1] == '.')
+                  && (entry->d_name[2] == '\0'))))
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+
+#ifdef DT_UNKNOWN
+      if (only_check_type && entry->d_type != DT_UNKNOWN)
+        {
+          if (entry->d_type == DT_REG)
+            dirent->kind = svn_node_file;
+          else if (entry->d_type == DT_DIR)
+            dirent->kind = svn_node_dir;
+          else if (entry->d_type == DT_LNK)
+            {
+              dirent->special = TRUE;
+              dirent->kind = svn_node_file;
+            }
+          else
+            dirent->kind = svn_node_unknown;
+        }
+      else
+#endif
+        {
+          status = stat_dir_entry(dirent, &gone, dir_fd, entry->d_name,
+                                  only_check_type);
+        }
+
+      if (!status && !gone)
+        {
+          err = entry_name_to_utf8(&name, entry->d_name, path, result_pool);
+          if (!err)
+            svn_hash_sets(dirents, name, dirent);
+        }
+    }
+
+  if (status && !err)
+    err = svn_error_wrap_apr(status, _("Can't read directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  if (closedir(dir) && !err)
+    err = svn_error_wrap_apr(apr_get_os_error(),
+                             _("Error closing directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+#endif /* USE_DIRFD_STAT */
+
 svn_error_t *
 svn_io_get_dirents3(apr_hash_t **dirents,
                     const char *path,
@@ -2825,6 +3381,19 @@ svn_io_get_dirents3(apr_hash_t **dirents,
 
   *dirents = apr_hash_make(result_pool);
 
+#ifdef USE_DIRFD_STAT
+  {
+    const char *path_apr;
+
+    SVN_ERR(cstring_from_utf8(&path_apr, path[0] ? path : ".",
+                              scratch_pool));
+
+    return svn_error_trace(get_dirents_dirfd(*dirents, path, path_apr,
+                                             only_check_type, result_pool,
+                                             scratch_pool));
+  }
+#endif
+
   SVN_ERR(svn_io_dir_open(&this_dir, path, scratch_pool));
 
   for (status = apr_dir_read(&this_entry, flags, this_dir);
@@ -4319,6 +4888,31 @@ svn_io_file_rename2(const char *from_path, const char *to_path,
 }
 
 
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, pool));
+
+  status = apr_file_link(from_path_apr, to_path_apr);
+  if (APR_STATUS_IS_ENOTIMPL(status))
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Hard links are not supported on this "
+                               "platform"));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, pool),
+                              svn_dirent_local_style(from_path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_io_file_move(const char *from_path, const char *to_path,
                  apr_pool_t *pool)
@@ -4330,9 +4924,10 @@ svn_io_file_move(const char *from_path, const char *to_path,
     {
       svn_error_clear(err);
 
-      /* svn_io_copy_file() performs atomic copy via temporary file. */
-      err = svn_error_trace(svn_io_copy_file(from_path, to_path, TRUE,
-                                             pool));
+      /* svn_io_copy_file2() performs atomic copy via temporary file. */
+      err = svn_error_trace(svn_io_copy_file2(from_path, to_path,
+                                              SVN_IO_COPY_FILE_PERMS, NULL,
+                                              pool));
     }
 
   return err;
@@ -5370,66 +5965,73 @@ svn_io_file_readline(apr_file_t *file,
 {
   svn_stringbuf_t *str;
   const char *eol_str;
-  apr_size_t numbytes;
-  char c;
-  apr_size_t len;
+  apr_off_t offset;
+  apr_size_t scanned;
   svn_boolean_t found_eof;
 
-  str = svn_stringbuf_create_ensure(80, result_pool);
+  str = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE, result_pool);
+  SVN_ERR(svn_io_file_get_offset(&offset, file, scratch_pool));
 
-  /* Read bytes into STR up to and including, but not storing,
-   * the next EOL sequence. */
+  /* Read chunks into STR until it contains an EOL sequence.  Never read
+   * more than MAX_LEN bytes.  Once we know where the line ends, we set
+   * the file pointer to the first byte after the EOL. */
   eol_str = NULL;
-  numbytes = 1;
-  len = 0;
+  scanned = 0;
   found_eof = FALSE;
-  while (!found_eof)
+  while (str->len < max_len)
     {
-      if (len < max_len)
-        SVN_ERR(svn_io_file_read_full2(file, &c, sizeof(c), &numbytes,
-                                       &found_eof, scratch_pool));
-      len++;
-      if (numbytes != 1 || len > max_len)
-        {
-          found_eof = TRUE;
-          break;
-        }
+      apr_size_t to_read = str->blocksize - str->len - 1;
+      apr_size_t bytes_read;
+      char *eol_pos;
 
-      if (c == '\n')
-        {
-          eol_str = "\n";
-        }
-      else if (c == '\r')
-        {
-          eol_str = "\r";
+      if (to_read > max_len - str->len)
+        to_read = max_len - str->len;
 
-          if (!found_eof && len < max_len)
-            {
-              apr_off_t pos;
+      SVN_ERR(svn_io_file_read_full2(file, str->data + str->len, to_read,
+                                     &bytes_read, &found_eof,
+                                     scratch_pool));
+      str->len += bytes_read;
+      str->data[str->len] = '\0';
 
-              /* Check for "\r\n" by peeking at the next byte. */
-              SVN_ERR(svn_io_file_get_offset(&pos, file, scratch_pool));
-              SVN_ERR(svn_io_file_read_full2(file, &c, sizeof(c), &numbytes,
-                                             &found_eof, scratch_pool));
-              if (numbytes == 1 && c == '\n')
-                {
-                  eol_str = "\r\n";
-                  len++;
-                }
-              else
-                {
-                  /* Pretend we never peeked. */
-                  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, scratch_pool));
-                  found_eof = FALSE;
-                  numbytes = 1;
-                }
-            }
+      eol_pos = svn_eol__find_eol_start(str->data + scanned,
+                                        str->len - scanned);
+      if (eol_pos)
+        {
+          scanned = eol_pos - str->data;
+          if (*eol_pos == '\n')
+            eol_str = "\n";
+          else if (scanned + 1 < str->len)
+            eol_str = eol_pos[1] == '\n' ? "\r\n" : "\r";
+          else if (found_eof || str->len == max_len)
+            eol_str = "\r";
         }
       else
-        svn_stringbuf_appendbyte(str, c);
+        {
+          scanned = str->len;
+        }
 
-      if (eol_str)
+      /* Done?  Otherwise, a trailing '\r' must wait for the next chunk
+       * to tell whether it is part of a "\r\n". */
+      if (eol_str || found_eof)
         break;
+
+      svn_stringbuf_ensure(str, str->blocksize * 2);
+    }
+
+  if (eol_str)
+    {
+      /* Strip the EOL and everything that we read beyond it. */
+      str->len = scanned;
+      str->data[str->len] = '\0';
+      found_eof = FALSE;
+
+      offset += scanned + strlen(eol_str);
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+    }
+  else
+    {
+      /* We hit either EOF or MAX_LEN. */
+      found_eof = TRUE;
     }
 
   if (eol)
@@ -427,3 +427,63 @@ svn_log__list(const char *path, svn_revnum_t revision,
   return apr_psprintf(pool, "list %s r%ld%s%s", log_path, revision,
                       log_depth(depth, pool), pattern_text->data);
 }
+
+const char *
+svn_log__get_files_batch(const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         svn_boolean_t want_contents,
+                         svn_boolean_t want_props,
+                         apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *space_separated_paths = svn_stringbuf_create_empty(pool);
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_pool_clear(iterpool);
+      if (i != 0)
+        svn_stringbuf_appendcstr(space_separated_paths, " ");
+      svn_stringbuf_appendcstr(space_separated_paths,
+                               svn_path_uri_encode(path, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return apr_psprintf(pool, "get-files-batch (%s) r%ld%s%s",
+                      space_separated_paths->data, rev,
+                      want_contents ? " text" : "",
+                      want_props ? " props" : "");
+}
+
+const char *
+svn_log__stat_many(const apr_array_header_t *paths,
+                   svn_revnum_t rev,
+                   apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *space_separated_paths = svn_stringbuf_create_empty(pool);
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_pool_clear(iterpool);
+      if (i != 0)
+        svn_stringbuf_appendcstr(space_separated_paths, " ");
+      svn_stringbuf_appendcstr(space_separated_paths,
+                               svn_path_uri_encode(path, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return apr_psprintf(pool, "stat-many (%s) r%ld",
+                      space_separated_paths->data, rev);
+}
+
+const char *
+svn_log__get_file_annotation(const char *path, svn_revnum_t revision,
+                             apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "get-file-annotation %s r%ld",
+                      svn_path_uri_encode(path, pool), revision);
+}
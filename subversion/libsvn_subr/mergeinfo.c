@@ -84,15 +84,58 @@ combine_ranges(svn_merge_range_t *output,
   return FALSE;
 }
 
-/* pathname -> PATHNAME */
+/* State shared by all lines parsed by svn_mergeinfo_parse() and
+   svn_mergeinfo__parser_parse(). */
+struct svn_mergeinfo__parser_t
+{
+  /* Canonical merge source paths seen so far, mapping to themselves, or
+     NULL if paths are not to be interned. */
+  apr_hash_t *paths;
+
+  /* Pool for the parsed mergeinfo and the interned paths. */
+  apr_pool_t *result_pool;
+};
+
+/* Return a copy of the canonical PATH of length LEN allocated in
+   PARSER's result pool, re-using an existing copy if PARSER interns
+   paths. */
+static const char *
+intern_path(svn_mergeinfo__parser_t *parser,
+            const char *path,
+            apr_size_t len)
+{
+  const char *interned;
+
+  if (!parser->paths)
+    return apr_pstrmemdup(parser->result_pool, path, len);
+
+  interned = apr_hash_get(parser->paths, path, len);
+  if (!interned)
+    {
+      interned = apr_pstrmemdup(parser->result_pool, path, len);
+      apr_hash_set(parser->paths, interned, len, interned);
+    }
+
+  return interned;
+}
+
+/* pathname -> PATHNAME
+ *
+ * Set *PATHNAME to the canonical, interned path at *INPUT, using BUFFER
+ * for temporaries.  Most paths are canonical already, so copying them to
+ * PARSER's result pool is the only allocation in that case.
+ */
 static svn_error_t *
 parse_pathname(const char **input,
                const char *end,
                const char **pathname,
-               apr_pool_t *pool)
+               svn_mergeinfo__parser_t *parser,
+               svn_stringbuf_t *buffer,
+               apr_pool_t *scratch_pool)
 {
   const char *curr = *input;
   const char *last_colon = NULL;
+  const char *path;
 
   /* A pathname may contain colons, so find the last colon before END
      or newline.  We'll consider this the divider between the pathname
@@ -108,11 +151,16 @@ parse_pathname(const char **input,
     return svn_error_create(SVN_ERR_MERGEINFO_PARSE_ERROR, NULL,
                             _("Pathname not terminated by ':'"));
 
-  /* Tolerate relative repository paths, but convert them to absolute.
-     ### Efficiency?  1 string duplication here, 2 in canonicalize. */
-  *pathname = svn_fspath__canonicalize(apr_pstrndup(pool, *input,
-                                                    last_colon - *input),
-                                       pool);
+  /* Tolerate relative repository paths, but convert them to absolute. */
+  svn_stringbuf_setempty(buffer);
+  svn_stringbuf_appendbytes(buffer, *input, last_colon - *input);
+  if (svn_fspath__is_canonical(buffer->data))
+    *pathname = intern_path(parser, buffer->data, buffer->len);
+  else
+    {
+      path = svn_fspath__canonicalize(buffer->data, scratch_pool);
+      *pathname = intern_path(parser, path, strlen(path));
+    }
 
   *input = last_colon;
 
@@ -486,7 +534,8 @@ range_to_string(const svn_merge_range_t *range,
 }
 
 /* Helper for svn_mergeinfo_parse()
-   Append revision ranges onto the array RANGELIST to represent the range
+   Append revision ranges onto the array RANGES of svn_merge_range_t
+   (stored by value) to represent the range
    descriptions found in the string *INPUT.  Read only as far as a newline
    or the position END, whichever comes first.  Set *INPUT to the position
    after the last character of INPUT that was used.
@@ -497,8 +546,7 @@ range_to_string(const svn_merge_range_t *range,
 */
 static svn_error_t *
 parse_rangelist(const char **input, const char *end,
-                svn_rangelist_t *rangelist,
-                apr_pool_t *pool)
+                apr_array_header_t *ranges)
 {
   const char *curr = *input;
 
@@ -516,7 +564,7 @@ parse_rangelist(const char **input, const char *end,
   while (curr < end && *curr != '\n')
     {
       /* Parse individual revisions or revision ranges. */
-      svn_merge_range_t *mrange = apr_pcalloc(pool, sizeof(*mrange));
+      svn_merge_range_t *mrange;
       svn_revnum_t firstrev;
 
       SVN_ERR(svn_revnum_parse(&firstrev, curr, &curr));
@@ -525,6 +573,7 @@ parse_rangelist(const char **input, const char *end,
         return svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, NULL,
                                  _("Invalid character '%c' found in revision "
                                    "list"), *curr);
+      mrange = apr_array_push(ranges);
       mrange->start = firstrev - 1;
       mrange->end = firstrev;
       mrange->inheritable = TRUE;
@@ -555,13 +604,11 @@ parse_rangelist(const char **input, const char *end,
 
       if (*curr == '\n' || curr == end)
         {
-          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = mrange;
           *input = curr;
           return SVN_NO_ERROR;
         }
       else if (*curr == ',')
         {
-          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = mrange;
           curr++;
         }
       else if (*curr == '*')
@@ -570,7 +617,6 @@ parse_rangelist(const char **input, const char *end,
           curr++;
           if (*curr == ',' || *curr == '\n' || curr == end)
             {
-              APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = mrange;
               if (*curr == ',')
                 {
                   curr++;
@@ -610,9 +656,18 @@ svn_rangelist__parse(svn_rangelist_t **rangelist,
                      apr_pool_t *result_pool)
 {
   const char *s = str;
+  apr_array_header_t *ranges = apr_array_make(result_pool, 4,
+                                              sizeof(svn_merge_range_t));
+  int i;
+
+  SVN_ERR(parse_rangelist(&s, s + strlen(s), ranges));
+
+  *rangelist = apr_array_make(result_pool, ranges->nelts,
+                              sizeof(svn_merge_range_t *));
+  for (i = 0; i < ranges->nelts; i++)
+    APR_ARRAY_PUSH(*rangelist, svn_merge_range_t *)
+      = &APR_ARRAY_IDX(ranges, i, svn_merge_range_t);
 
-  *rangelist = apr_array_make(result_pool, 1, sizeof(svn_merge_range_t *));
-  SVN_ERR(parse_rangelist(&s, s + strlen(s), *rangelist, result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -699,22 +754,78 @@ svn_rangelist__canonicalize(svn_rangelist_t *rangelist,
   return SVN_NO_ERROR;
 }
 
+/* Like svn_rangelist__canonicalize() but for the array RANGES of
+   svn_merge_range_t stored by value. */
+static svn_error_t *
+canonicalize_ranges(apr_array_header_t *ranges,
+                    apr_pool_t *scratch_pool)
+{
+  svn_rangelist_t *rangelist;
+  apr_array_header_t *canonical;
+  int i;
+
+  /* Most data in svn:mergeinfo is in normalized form already. */
+  for (i = 0; i < ranges->nelts; i++)
+    {
+      const svn_merge_range_t *range
+        = &APR_ARRAY_IDX(ranges, i, svn_merge_range_t);
+
+      if (range->start >= range->end)
+        break;
+
+      if (i > 0)
+        {
+          const svn_merge_range_t *prev = range - 1;
+
+          if (prev->end > range->start
+              || (prev->end == range->start
+                  && prev->inheritable == range->inheritable))
+            break;
+        }
+    }
+
+  if (i == ranges->nelts)
+    return SVN_NO_ERROR;
+
+  rangelist = apr_array_make(scratch_pool, ranges->nelts,
+                             sizeof(svn_merge_range_t *));
+  for (i = 0; i < ranges->nelts; i++)
+    APR_ARRAY_PUSH(rangelist, svn_merge_range_t *)
+      = &APR_ARRAY_IDX(ranges, i, svn_merge_range_t);
+
+  SVN_ERR(svn_rangelist__canonicalize(rangelist, scratch_pool));
+
+  canonical = apr_array_make(scratch_pool, rangelist->nelts,
+                             sizeof(svn_merge_range_t));
+  for (i = 0; i < rangelist->nelts; i++)
+    APR_ARRAY_PUSH(canonical, svn_merge_range_t)
+      = *APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+
+  apr_array_clear(ranges);
+  apr_array_cat(ranges, canonical);
+
+  return SVN_NO_ERROR;
+}
+
 /* revisionline -> PATHNAME COLON revisionlist
  *
  * Parse one line of mergeinfo starting at INPUT, not reading beyond END,
- * into HASH. Allocate the new entry in HASH deeply from HASH's pool.
+ * into HASH.  Allocate the new entry in HASH from PARSER's result pool.
+ * PATH_BUFFER and RANGES are scratch buffers re-used for every line.
  */
 static svn_error_t *
 parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
+                    svn_mergeinfo__parser_t *parser,
+                    svn_stringbuf_t *path_buffer,
+                    apr_array_header_t *ranges,
                     apr_pool_t *scratch_pool)
 {
   const char *pathname = "";
   apr_ssize_t klen;
   svn_rangelist_t *existing_rangelist;
-  svn_rangelist_t *rangelist = apr_array_make(scratch_pool, 1,
-                                              sizeof(svn_merge_range_t *));
 
-  SVN_ERR(parse_pathname(input, end, &pathname, scratch_pool));
+  SVN_ERR(parse_pathname(input, end, &pathname, parser, path_buffer,
+                         scratch_pool));
 
   if (*(*input) != ':')
     return svn_error_create(SVN_ERR_MERGEINFO_PARSE_ERROR, NULL,
@@ -722,9 +833,10 @@ parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
 
   *input = *input + 1;
 
-  SVN_ERR(parse_rangelist(input, end, rangelist, scratch_pool));
+  apr_array_clear(ranges);
+  SVN_ERR(parse_rangelist(input, end, ranges));
 
-  if (rangelist->nelts == 0)
+  if (ranges->nelts == 0)
       return svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, NULL,
                                _("Mergeinfo for '%s' maps to an "
                                  "empty revision range"), pathname);
@@ -737,10 +849,8 @@ parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
     *input = *input + 1;
 
   /* Sort the rangelist, combine adjacent ranges into single ranges, and
-     make sure there are no overlapping ranges.  Luckily, most data in
-     svn:mergeinfo will already be in normalized form and this will be quick.
-   */
-  SVN_ERR(svn_rangelist__canonicalize(rangelist, scratch_pool));
+     make sure there are no overlapping ranges. */
+  SVN_ERR(canonicalize_ranges(ranges, scratch_pool));
 
   /* Handle any funky mergeinfo with relative merge source paths that
      might exist due to issue #3547.  It's possible that this issue allowed
@@ -751,34 +861,58 @@ parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
   klen = strlen(pathname);
   existing_rangelist = apr_hash_get(hash, pathname, klen);
   if (existing_rangelist)
-    SVN_ERR(svn_rangelist_merge2(rangelist, existing_rangelist,
-                                 scratch_pool, scratch_pool));
+    {
+      svn_rangelist_t *rangelist = svn_rangelist__expand(ranges,
+                                                         scratch_pool);
 
-  apr_hash_set(hash, apr_pstrmemdup(apr_hash_pool_get(hash), pathname, klen),
-               klen, svn_rangelist_dup(rangelist, apr_hash_pool_get(hash)));
+      SVN_ERR(svn_rangelist_merge2(rangelist, existing_rangelist,
+                                   scratch_pool, scratch_pool));
+      apr_hash_set(hash, pathname, klen,
+                   svn_rangelist_dup(rangelist, parser->result_pool));
+    }
+  else
+    {
+      /* All ranges of this line in a single allocation. */
+      apr_hash_set(hash, pathname, klen,
+                   svn_rangelist__expand(ranges, parser->result_pool));
+    }
 
   return SVN_NO_ERROR;
 }
 
 /* top -> revisionline (NEWLINE revisionline)*
  *
- * Parse mergeinfo starting at INPUT, not reading beyond END, into HASH.
- * Allocate all the new entries in HASH deeply from HASH's pool.
+ * Parse mergeinfo starting at INPUT, not reading beyond END, into a new
+ * hash in *MERGEINFO.  Allocate the result from PARSER's result pool.
  */
 static svn_error_t *
-parse_top(const char **input, const char *end, svn_mergeinfo_t hash,
+parse_top(svn_mergeinfo_t *mergeinfo,
+          const char *input,
+          const char *end,
+          svn_mergeinfo__parser_t *parser,
           apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-
-  while (*input < end)
-    {
-      svn_pool_clear(iterpool);
-      SVN_ERR(parse_revision_line(input, end, hash, iterpool));
-    }
-  svn_pool_destroy(iterpool);
+  const char *start = input;
+  /* Temporary allocations beyond the buffers below are only needed for
+     non-canonical input, so we don't clear this pool per line. */
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *path_buffer = svn_stringbuf_create_ensure(64, subpool);
+  apr_array_header_t *ranges = apr_array_make(subpool, 16,
+                                              sizeof(svn_merge_range_t));
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *mergeinfo = svn_hash__make(parser->result_pool);
+  while (input < end && !err)
+    err = parse_revision_line(&input, end, *mergeinfo, parser,
+                              path_buffer, ranges, subpool);
+  svn_pool_destroy(subpool);
 
-  return SVN_NO_ERROR;
+  /* Always return SVN_ERR_MERGEINFO_PARSE_ERROR as the topmost error. */
+  if (err && err->apr_err != SVN_ERR_MERGEINFO_PARSE_ERROR)
+    err = svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, err,
+                            _("Could not parse mergeinfo string '%s'"),
+                            start);
+  return err;
 }
 
 svn_error_t *
@@ -786,17 +920,33 @@ svn_mergeinfo_parse(svn_mergeinfo_t *mergeinfo,
                     const char *input,
                     apr_pool_t *pool)
 {
-  svn_error_t *err;
+  svn_mergeinfo__parser_t parser;
 
-  *mergeinfo = svn_hash__make(pool);
-  err = parse_top(&input, input + strlen(input), *mergeinfo, pool);
+  parser.paths = NULL;
+  parser.result_pool = pool;
 
-  /* Always return SVN_ERR_MERGEINFO_PARSE_ERROR as the topmost error. */
-  if (err && err->apr_err != SVN_ERR_MERGEINFO_PARSE_ERROR)
-    err = svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, err,
-                            _("Could not parse mergeinfo string '%s'"),
-                            input);
-  return err;
+  return parse_top(mergeinfo, input, input + strlen(input), &parser, pool);
+}
+
+svn_mergeinfo__parser_t *
+svn_mergeinfo__parser_create(apr_pool_t *result_pool)
+{
+  svn_mergeinfo__parser_t *parser = apr_pcalloc(result_pool, sizeof(*parser));
+
+  parser->paths = apr_hash_make(result_pool);
+  parser->result_pool = result_pool;
+
+  return parser;
+}
+
+svn_error_t *
+svn_mergeinfo__parser_parse(svn_mergeinfo_t *mergeinfo,
+                            svn_mergeinfo__parser_t *parser,
+                            const char *input,
+                            apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(parse_top(mergeinfo, input, input + strlen(input),
+                                   parser, scratch_pool));
 }
 
 /* Cleanup after svn_rangelist_merge2 when it modifies the ending range of
@@ -2700,6 +2850,328 @@ svn_mergeinfo__mergeinfo_from_segments(svn_mergeinfo_t *mergeinfo_p,
   return SVN_NO_ERROR;
 }
 
+/*** Compact rangelists. ***/
+
+/* How a single revision is covered by a rangelist. */
+typedef enum range_state_t
+{
+  range_state_none = 0,
+  range_state_non_inheritable,
+  range_state_inheritable
+} range_state_t;
+
+/* Set operation on compact rangelists: return the state of a revision in
+   the result, given its STATE1 and STATE2 in the operands. */
+typedef range_state_t (*combine_states_t)(range_state_t state1,
+                                          range_state_t state2,
+                                          svn_boolean_t consider_inheritance);
+
+/* Implements combine_states_t for svn_rangelist__compact_merge. */
+static range_state_t
+merge_states(range_state_t state1,
+             range_state_t state2,
+             svn_boolean_t consider_inheritance)
+{
+  return MAX(state1, state2);
+}
+
+/* Implements combine_states_t for svn_rangelist__compact_intersect. */
+static range_state_t
+intersect_states(range_state_t state1,
+                 range_state_t state2,
+                 svn_boolean_t consider_inheritance)
+{
+  if (state1 == range_state_none || state2 == range_state_none)
+    return range_state_none;
+  if (consider_inheritance && state1 != state2)
+    return range_state_none;
+
+  /* Non-inheritable only if both are non-inheritable. */
+  return MAX(state1, state2);
+}
+
+/* Implements combine_states_t for svn_rangelist__compact_remove.
+   STATE1 is the eraser, STATE2 the whiteboard. */
+static range_state_t
+remove_states(range_state_t state1,
+              range_state_t state2,
+              svn_boolean_t consider_inheritance)
+{
+  if (state1 == range_state_none
+      || (consider_inheritance && state1 != state2))
+    return state2;
+
+  return range_state_none;
+}
+
+/* Append the revisions START+1 through END with STATE to COMPACT,
+   extending its last range where possible. */
+static void
+compact_append(svn_rangelist__compact_t *compact,
+               svn_revnum_t start,
+               svn_revnum_t end,
+               range_state_t state)
+{
+  svn_boolean_t inheritable = (state == range_state_inheritable);
+  svn_merge_range_t *range;
+
+  if (compact->nelts)
+    {
+      range = &APR_ARRAY_IDX(compact, compact->nelts - 1, svn_merge_range_t);
+      if (range->end == start && range->inheritable == inheritable)
+        {
+          range->end = end;
+          return;
+        }
+    }
+
+  range = apr_array_push(compact);
+  range->start = start;
+  range->end = end;
+  range->inheritable = inheritable;
+}
+
+/* Sweep over the boundaries of the compact RANGELIST1 and RANGELIST2 and
+   return the rangelist that contains every revision for which COMBINE,
+   given CONSIDER_INHERITANCE, returns a state other than "none".
+   Allocate the result in RESULT_POOL. */
+static svn_rangelist__compact_t *
+compact_combine(const svn_rangelist__compact_t *rangelist1,
+                const svn_rangelist__compact_t *rangelist2,
+                combine_states_t combine,
+                svn_boolean_t consider_inheritance,
+                apr_pool_t *result_pool)
+{
+  svn_rangelist__compact_t *result
+    = apr_array_make(result_pool, rangelist1->nelts + rangelist2->nelts,
+                     sizeof(svn_merge_range_t));
+  int i1 = 0;
+  int i2 = 0;
+  svn_revnum_t pos = 0;
+
+  while (i1 < rangelist1->nelts || i2 < rangelist2->nelts)
+    {
+      const svn_merge_range_t *range1 = NULL;
+      const svn_merge_range_t *range2 = NULL;
+      range_state_t state1 = range_state_none;
+      range_state_t state2 = range_state_none;
+      svn_revnum_t next = SVN_INVALID_REVNUM;
+      range_state_t state;
+
+      /* Determine the state of the revisions following POS in either
+         operand and how far it extends. */
+      if (i1 < rangelist1->nelts)
+        {
+          range1 = &APR_ARRAY_IDX(rangelist1, i1, svn_merge_range_t);
+          if (range1->start > pos)
+            next = range1->start;
+          else
+            {
+              state1 = range1->inheritable ? range_state_inheritable
+                                           : range_state_non_inheritable;
+              next = range1->end;
+            }
+        }
+
+      if (i2 < rangelist2->nelts)
+        {
+          range2 = &APR_ARRAY_IDX(rangelist2, i2, svn_merge_range_t);
+          if (range2->start > pos)
+            {
+              if (!SVN_IS_VALID_REVNUM(next) || range2->start < next)
+                next = range2->start;
+            }
+          else
+            {
+              state2 = range2->inheritable ? range_state_inheritable
+                                           : range_state_non_inheritable;
+              if (!SVN_IS_VALID_REVNUM(next) || range2->end < next)
+                next = range2->end;
+            }
+        }
+
+      state = combine(state1, state2, consider_inheritance);
+      if (state != range_state_none)
+        compact_append(result, pos, next, state);
+
+      pos = next;
+      if (range1 && range1->end == pos)
+        i1++;
+      if (range2 && range2->end == pos)
+        i2++;
+    }
+
+  return result;
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact(const svn_rangelist_t *rangelist,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *parts;
+  int i;
+
+  if (svn_rangelist__is_canonical(rangelist))
+    {
+      svn_rangelist__compact_t *compact
+        = apr_array_make(result_pool, rangelist->nelts,
+                         sizeof(svn_merge_range_t));
+
+      for (i = 0; i < rangelist->nelts; i++)
+        APR_ARRAY_PUSH(compact, svn_merge_range_t)
+          = *APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+
+      return compact;
+    }
+
+  /* Combine the ranges pairwise to keep this O(N log N). */
+  parts = apr_array_make(scratch_pool, rangelist->nelts,
+                         sizeof(svn_rangelist__compact_t *));
+  for (i = 0; i < rangelist->nelts; i++)
+    {
+      const svn_merge_range_t *range
+        = APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+      svn_rangelist__compact_t *part;
+
+      if (range->start >= range->end)
+        continue;
+
+      part = apr_array_make(scratch_pool, 1, sizeof(svn_merge_range_t));
+      APR_ARRAY_PUSH(part, svn_merge_range_t) = *range;
+      APR_ARRAY_PUSH(parts, svn_rangelist__compact_t *) = part;
+    }
+
+  if (parts->nelts == 0)
+    return apr_array_make(result_pool, 0, sizeof(svn_merge_range_t));
+
+  while (parts->nelts > 1)
+    {
+      apr_array_header_t *merged
+        = apr_array_make(scratch_pool, (parts->nelts + 1) / 2,
+                         sizeof(svn_rangelist__compact_t *));
+
+      for (i = 0; i + 1 < parts->nelts; i += 2)
+        APR_ARRAY_PUSH(merged, svn_rangelist__compact_t *)
+          = svn_rangelist__compact_merge(
+              APR_ARRAY_IDX(parts, i, svn_rangelist__compact_t *),
+              APR_ARRAY_IDX(parts, i + 1, svn_rangelist__compact_t *),
+              scratch_pool);
+      if (i < parts->nelts)
+        APR_ARRAY_PUSH(merged, svn_rangelist__compact_t *)
+          = APR_ARRAY_IDX(parts, i, svn_rangelist__compact_t *);
+
+      parts = merged;
+    }
+
+  return apr_array_copy(result_pool,
+                        APR_ARRAY_IDX(parts, 0, svn_rangelist__compact_t *));
+}
+
+svn_rangelist_t *
+svn_rangelist__expand(const svn_rangelist__compact_t *compact,
+                      apr_pool_t *result_pool)
+{
+  svn_rangelist_t *rangelist = apr_array_make(result_pool, compact->nelts,
+                                              sizeof(svn_merge_range_t *));
+  svn_merge_range_t *ranges;
+  int i;
+
+  if (compact->nelts == 0)
+    return rangelist;
+
+  /* Use a single allocation for all ranges. */
+  ranges = apr_pmemdup(result_pool, compact->elts,
+                       compact->nelts * sizeof(*ranges));
+  for (i = 0; i < compact->nelts; i++)
+    APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = &ranges[i];
+
+  return rangelist;
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_merge(const svn_rangelist__compact_t *rangelist1,
+                             const svn_rangelist__compact_t *rangelist2,
+                             apr_pool_t *result_pool)
+{
+  return compact_combine(rangelist1, rangelist2, merge_states, FALSE,
+                         result_pool);
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_intersect(const svn_rangelist__compact_t *rangelist1,
+                                 const svn_rangelist__compact_t *rangelist2,
+                                 svn_boolean_t consider_inheritance,
+                                 apr_pool_t *result_pool)
+{
+  return compact_combine(rangelist1, rangelist2, intersect_states,
+                         consider_inheritance, result_pool);
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_remove(const svn_rangelist__compact_t *eraser,
+                              const svn_rangelist__compact_t *whiteboard,
+                              svn_boolean_t consider_inheritance,
+                              apr_pool_t *result_pool)
+{
+  return compact_combine(eraser, whiteboard, remove_states,
+                         consider_inheritance, result_pool);
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_set_inheritance(const svn_rangelist__compact_t *compact,
+                                       svn_boolean_t inheritable,
+                                       apr_pool_t *result_pool)
+{
+  svn_rangelist__compact_t *result
+    = apr_array_make(result_pool, compact->nelts, sizeof(svn_merge_range_t));
+  range_state_t state = inheritable ? range_state_inheritable
+                                    : range_state_non_inheritable;
+  int i;
+
+  for (i = 0; i < compact->nelts; i++)
+    {
+      const svn_merge_range_t *range
+        = &APR_ARRAY_IDX(compact, i, svn_merge_range_t);
+
+      compact_append(result, range->start, range->end, state);
+    }
+
+  return result;
+}
+
+const svn_merge_range_t *
+svn_rangelist__compact_find(const svn_rangelist__compact_t *compact,
+                            svn_revnum_t rev)
+{
+  int lower = 0;
+  int upper = compact->nelts;
+
+  /* Find the first range that ends at or after REV. */
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      const svn_merge_range_t *range
+        = &APR_ARRAY_IDX(compact, middle, svn_merge_range_t);
+
+      if (range->end < rev)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  if (lower < compact->nelts)
+    {
+      const svn_merge_range_t *range
+        = &APR_ARRAY_IDX(compact, lower, svn_merge_range_t);
+
+      if (range->start < rev)
+        return range;
+    }
+
+  return NULL;
+}
+
 svn_error_t *
 svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           svn_mergeinfo_t merge_history,
@@ -2709,18 +3181,42 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
   if (apr_hash_count(merge_history))
     {
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      apr_pool_t *merged_pool = svn_pool_create(scratch_pool);
+      apr_pool_t *next_pool = svn_pool_create(scratch_pool);
+      svn_rangelist__compact_t *merged;
       apr_hash_index_t *hi;
 
+      /* Accumulate the result in compact form, alternating between two
+         pools so that memory use does not grow with the number of
+         rangelists. */
+      merged = svn_rangelist__compact(merged_rangelist, merged_pool,
+                                      iterpool);
       for (hi = apr_hash_first(scratch_pool, merge_history);
            hi;
            hi = apr_hash_next(hi))
         {
           svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+          apr_pool_t *tmp_pool;
 
           svn_pool_clear(iterpool);
-          SVN_ERR(svn_rangelist_merge2(merged_rangelist, subtree_rangelist,
-                                       result_pool, iterpool));
+          merged = svn_rangelist__compact_merge(
+                     merged,
+                     svn_rangelist__compact(subtree_rangelist, iterpool,
+                                            iterpool),
+                     next_pool);
+
+          svn_pool_clear(merged_pool);
+          tmp_pool = merged_pool;
+          merged_pool = next_pool;
+          next_pool = tmp_pool;
         }
+
+      apr_array_clear(merged_rangelist);
+      apr_array_cat(merged_rangelist,
+                    svn_rangelist__expand(merged, result_pool));
+
+      svn_pool_destroy(next_pool);
+      svn_pool_destroy(merged_pool);
       svn_pool_destroy(iterpool);
     }
   return SVN_NO_ERROR;
@@ -721,6 +721,24 @@ read_packed_uint_body(unsigned char *p, apr_uint64_t *result)
   return ++p;
 }
 
+/* Number of bytes checked at once by all_single_byte_values().
+ */
+#define SINGLE_BYTE_BLOCK_SIZE sizeof(apr_uint64_t)
+
+/* Return TRUE, if each of the SINGLE_BYTE_BLOCK_SIZE bytes starting at P
+ * encodes a complete value, i.e. none of them has the continuation bit
+ * set.  P does not need to be aligned.
+ */
+static APR_INLINE svn_boolean_t
+all_single_byte_values(const unsigned char *p)
+{
+  apr_uint64_t chunk;
+
+  /* Compilers turn this into a single (unaligned) load. */
+  memcpy(&chunk, p, sizeof(chunk));
+  return (chunk & APR_UINT64_C(0x8080808080808080)) == 0;
+}
+
 /* Read one 7b/8b encoded value from STREAM and return it in *RESULT.
  *
  * Overflows will be detected in the sense that it will end parsing the
@@ -806,6 +824,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE];
       unsigned char *p;
       unsigned char *start;
+      unsigned char *data_end;
       apr_size_t packed_read;
 
       if (private_data->packed->len < sizeof(local_buffer))
@@ -821,10 +840,27 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       else
         p = (unsigned char *)private_data->packed->data;
 
-      /* unpack numbers */
+      /* unpack numbers.  Small values are very common and take only one
+         byte each.  Whole blocks of them can be copied without parsing. */
       start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+      data_end = p + private_data->packed->len;
+      for (i = end; i > 0; )
+        if (   i >= SINGLE_BYTE_BLOCK_SIZE
+            && p + SINGLE_BYTE_BLOCK_SIZE <= data_end
+            && all_single_byte_values(p))
+          {
+            apr_size_t k;
+            for (k = 0; k < SINGLE_BYTE_BLOCK_SIZE; ++k)
+              stream->buffer[i-1-k] = p[k];
+
+            p += SINGLE_BYTE_BLOCK_SIZE;
+            i -= SINGLE_BYTE_BLOCK_SIZE;
+          }
+        else
+          {
+            p = read_packed_uint_body(p, &stream->buffer[i-1]);
+            --i;
+          }
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
@@ -21,11 +21,41 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
+#include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_mutex.h"
 
+/* Maximum amount of memory that an allocator may keep on its free list
+ * while its pool waits in the shared list of unused pools.  A single large
+ * request would otherwise pin SVN_ALLOCATOR_RECOMMENDED_MAX_FREE for each
+ * of those pools.  Pools in per-thread caches are about to be reused by
+ * the same thread and keep the full amount.
+ */
+#define SHARED_MAX_FREE (512 * 1024)
+
+/* Maximum number of pools in the shared list.  Surplus pools get destroyed
+ * upon release, such that a burst of connections won't pin their memory
+ * indefinitely.
+ */
+#define MAX_SHARED_POOLS 256
+
+/* We cache one unused pool per thread using thread-local storage.  APR
+ * ignores thread key destructors on Windows, though, which would leak the
+ * pools cached by terminating threads.
+ */
+#if APR_HAS_THREADS && !defined(WIN32)
+#define SVN_ROOT_POOLS_THREAD_CACHE
+#endif
+
+/* Pool userdata key under which pools in thread caches find their
+ * svn_root_pools__t container. */
+#define ROOT_POOLS_KEY "svn_root_pools__t"
+
 struct svn_root_pools__t
 {
   /* unused pools.
@@ -36,8 +66,38 @@ struct svn_root_pools__t
   /* Mutex to serialize access to UNUSED_POOLS */
   svn_mutex__t *mutex;
 
+#ifdef SVN_ROOT_POOLS_THREAD_CACHE
+  /* Per-thread cache of at most one unused pool.  Access needs no
+   * synchronization. */
+  apr_threadkey_t *thread_cache;
+#endif
+
+  /* Statistics as reported by svn_root_pools__get_info().
+   * All of them are modified atomically. */
+  volatile svn_atomic_t acquired;
+  volatile svn_atomic_t thread_cache_hits;
+  volatile svn_atomic_t shared_hits;
+  volatile svn_atomic_t destroyed;
+  volatile svn_atomic_t thread_cached;
 };
 
+#ifdef SVN_ROOT_POOLS_THREAD_CACHE
+/* Thread key destructor, destroying the unused pool DATA that was cached
+ * by a terminating thread. */
+static void
+cleanup_thread_cache(void *data)
+{
+  apr_pool_t *pool = data;
+  void *pools;
+
+  if (apr_pool_userdata_get(&pools, ROOT_POOLS_KEY, pool) == APR_SUCCESS
+      && pools)
+    svn_atomic_dec(&((svn_root_pools__t *)pools)->thread_cached);
+
+  svn_pool_destroy(pool);
+}
+#endif
+
 svn_error_t *
 svn_root_pools__create(svn_root_pools__t **pools)
 {
@@ -51,6 +111,17 @@ svn_root_pools__create(svn_root_pools__t **pools)
   SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
   result->unused_pools = apr_array_make(pool, 16, sizeof(apr_pool_t *));
 
+#ifdef SVN_ROOT_POOLS_THREAD_CACHE
+  {
+    apr_status_t status
+      = apr_threadkey_private_create(&result->thread_cache,
+                                     cleanup_thread_cache, pool);
+    if (status)
+      return svn_error_wrap_apr(status,
+                                _("Can't create per-thread pool cache"));
+  }
+#endif
+
   /* done */
   *pools = result;
 
@@ -64,12 +135,26 @@ static svn_error_t *
 acquire_pool_internal(apr_pool_t **pool,
                       svn_root_pools__t *pools)
 {
+  apr_pool_t *unused = NULL;
+
   SVN_ERR(svn_mutex__lock(pools->mutex));
-  *pool = pools->unused_pools->nelts
-        ? *(apr_pool_t **)apr_array_pop(pools->unused_pools)
-        : apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  if (pools->unused_pools->nelts)
+    unused = *(apr_pool_t **)apr_array_pop(pools->unused_pools);
   SVN_ERR(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
 
+  if (unused)
+    {
+      /* Lift the restriction imposed while the pool was parked. */
+      apr_allocator_max_free_set(apr_pool_allocator_get(unused),
+                                 SVN_ALLOCATOR_RECOMMENDED_MAX_FREE);
+      svn_atomic_inc(&pools->shared_hits);
+      *pool = unused;
+    }
+  else
+    {
+      *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -77,7 +162,26 @@ apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools)
 {
   apr_pool_t *pool;
-  svn_error_t *err = acquire_pool_internal(&pool, pools);
+  svn_error_t *err;
+
+  svn_atomic_inc(&pools->acquired);
+
+#ifdef SVN_ROOT_POOLS_THREAD_CACHE
+  {
+    void *cached = NULL;
+    if (apr_threadkey_private_get(&cached, pools->thread_cache) == APR_SUCCESS
+        && cached
+        && apr_threadkey_private_set(NULL, pools->thread_cache)
+             == APR_SUCCESS)
+      {
+        svn_atomic_dec(&pools->thread_cached);
+        svn_atomic_inc(&pools->thread_cache_hits);
+        return cached;
+      }
+  }
+#endif
+
+  err = acquire_pool_internal(&pool, pools);
   if (err)
     {
       /* Mutex failure?!  Well, try to continue with unrecycled data. */
@@ -94,17 +198,67 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 {
   svn_error_t *err;
 
+#ifdef SVN_ROOT_POOLS_THREAD_CACHE
+  {
+    /* Keep the pool for the next request of this thread, if that slot
+     * is still empty. */
+    void *cached = NULL;
+    if (apr_threadkey_private_get(&cached, pools->thread_cache) == APR_SUCCESS
+        && !cached)
+      {
+        svn_pool_clear(pool);
+        apr_pool_userdata_setn(pools, ROOT_POOLS_KEY, NULL, pool);
+        if (apr_threadkey_private_set(pool, pools->thread_cache)
+              == APR_SUCCESS)
+          {
+            svn_atomic_inc(&pools->thread_cached);
+            return;
+          }
+      }
+  }
+#endif
+
+  /* Limit the memory retained by the allocator before the clear returns
+   * all blocks to it. */
+  apr_allocator_max_free_set(apr_pool_allocator_get(pool), SHARED_MAX_FREE);
   svn_pool_clear(pool);
 
   err = svn_mutex__lock(pools->mutex);
-  if (err)
+  if (!err)
     {
-      svn_error_clear(err);
-      svn_pool_destroy(pool);
-    }
-  else
-    {
-      APR_ARRAY_PUSH(pools->unused_pools, apr_pool_t *) = pool;
-      svn_error_clear(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+      svn_boolean_t keep = pools->unused_pools->nelts < MAX_SHARED_POOLS;
+      if (keep)
+        APR_ARRAY_PUSH(pools->unused_pools, apr_pool_t *) = pool;
+
+      err = svn_mutex__unlock(pools->mutex, SVN_NO_ERROR);
+      if (keep)
+        {
+          svn_error_clear(err);
+          return;
+        }
     }
+
+  svn_error_clear(err);
+  svn_atomic_inc(&pools->destroyed);
+  svn_pool_destroy(pool);
+}
+
+svn_error_t *
+svn_root_pools__get_info(svn_root_pools__info_t *info,
+                         svn_root_pools__t *pools)
+{
+  SVN_ERR(svn_mutex__lock(pools->mutex));
+  info->shared = pools->unused_pools->nelts;
+  SVN_ERR(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+
+  info->acquired = svn_atomic_read(&pools->acquired);
+  info->thread_cache_hits = svn_atomic_read(&pools->thread_cache_hits);
+  info->shared_hits = svn_atomic_read(&pools->shared_hits);
+  info->destroyed = svn_atomic_read(&pools->destroyed);
+  info->thread_cached = svn_atomic_read(&pools->thread_cached);
+  info->retained_limit
+    = info->thread_cached * (apr_size_t)SVN_ALLOCATOR_RECOMMENDED_MAX_FREE
+    + info->shared * (apr_size_t)SHARED_MAX_FREE;
+
+  return SVN_NO_ERROR;
 }
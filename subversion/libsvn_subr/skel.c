@@ -199,14 +199,46 @@ is_valid_iproplist_skel(const svn_skel_t *skel)
 }
 
 
+/* Number of skel nodes to allocate at once while parsing. */
+#define NODE_BLOCK_SIZE 32
+
+/* Parser state.  Skels get allocated in blocks of NODE_BLOCK_SIZE
+   nodes instead of one by one because real-world skels, e.g. conflict
+   descriptions, consist of many tiny nodes. */
+typedef struct parser_t
+{
+  /* Unused nodes left over from the last allocated block. */
+  svn_skel_t *free_nodes;
+  apr_size_t free_count;
+
+  /* Allocate node blocks here. */
+  apr_pool_t *pool;
+} parser_t;
+
+/* Return a new, zero-initialized skel node from PARSER. */
+static svn_skel_t *
+alloc_node(parser_t *parser)
+{
+  if (parser->free_count == 0)
+    {
+      parser->free_nodes = apr_pcalloc(parser->pool,
+                                       NODE_BLOCK_SIZE
+                                         * sizeof(*parser->free_nodes));
+      parser->free_count = NODE_BLOCK_SIZE;
+    }
+
+  --parser->free_count;
+  return parser->free_nodes++;
+}
+
 static svn_skel_t *parse(const char *data, apr_size_t len,
-                         apr_pool_t *pool);
+                         parser_t *parser);
 static svn_skel_t *list(const char *data, apr_size_t len,
-                        apr_pool_t *pool);
+                        parser_t *parser);
 static svn_skel_t *implicit_atom(const char *data, apr_size_t len,
-                                 apr_pool_t *pool);
+                                 parser_t *parser);
 static svn_skel_t *explicit_atom(const char *data, apr_size_t len,
-                                 apr_pool_t *pool);
+                                 parser_t *parser);
 
 
 svn_skel_t *
@@ -214,7 +246,19 @@ svn_skel__parse(const char *data,
                 apr_size_t len,
                 apr_pool_t *pool)
 {
-  return parse(data, len, pool);
+  parser_t parser;
+  parser.free_nodes = NULL;
+  parser.free_count = 0;
+  parser.pool = pool;
+
+  /* A single atom doesn't need a whole block. */
+  if (len > 0 && *data != '(')
+    {
+      parser.free_nodes = apr_pcalloc(pool, sizeof(*parser.free_nodes));
+      parser.free_count = 1;
+    }
+
+  return parse(data, len, &parser);
 }
 
 
@@ -222,7 +266,7 @@ svn_skel__parse(const char *data,
 static svn_skel_t *
 parse(const char *data,
       apr_size_t len,
-      apr_pool_t *pool)
+      parser_t *parser)
 {
   char c;
 
@@ -234,23 +278,23 @@ parse(const char *data,
 
   /* Is it a list, or an atom?  */
   if (c == '(')
-    return list(data, len, pool);
+    return list(data, len, parser);
 
   /* Is it a string with an implicit length?  */
   if (skel_char_type[(unsigned char) c] == type_name)
-    return implicit_atom(data, len, pool);
+    return implicit_atom(data, len, parser);
 
   /* Otherwise, we assume it's a string with an explicit length;
      svn_skel__getsize will catch the error.  */
   else
-    return explicit_atom(data, len, pool);
+    return explicit_atom(data, len, parser);
 }
 
 
 static svn_skel_t *
 list(const char *data,
      apr_size_t len,
-     apr_pool_t *pool)
+     parser_t *parser)
 {
   const char *end = data + len;
   const char *list_start;
@@ -293,7 +337,7 @@ list(const char *data,
           }
 
         /* Parse the next element in the list.  */
-        element = parse(data, end - data, pool);
+        element = parse(data, end - data, parser);
         if (! element)
           return NULL;
 
@@ -308,7 +352,7 @@ list(const char *data,
 
     /* Construct the return value.  */
     {
-      svn_skel_t *s = apr_pcalloc(pool, sizeof(*s));
+      svn_skel_t *s = alloc_node(parser);
 
       s->is_atom = FALSE;
       s->data = list_start;
@@ -326,7 +370,7 @@ list(const char *data,
 static svn_skel_t *
 implicit_atom(const char *data,
               apr_size_t len,
-              apr_pool_t *pool)
+              parser_t *parser)
 {
   const char *start = data;
   const char *end = data + len;
@@ -345,7 +389,7 @@ implicit_atom(const char *data,
     ;
 
   /* Allocate the skel representing this string.  */
-  s = apr_pcalloc(pool, sizeof(*s));
+  s = alloc_node(parser);
   s->is_atom = TRUE;
   s->data = start;
   s->len = data - start;
@@ -359,7 +403,7 @@ implicit_atom(const char *data,
 static svn_skel_t *
 explicit_atom(const char *data,
               apr_size_t len,
-              apr_pool_t *pool)
+              parser_t *parser)
 {
   const char *end = data + len;
   const char *next;
@@ -384,7 +428,7 @@ explicit_atom(const char *data,
     return NULL;
 
   /* Allocate the skel representing this string.  */
-  s = apr_pcalloc(pool, sizeof(*s));
+  s = alloc_node(parser);
   s->is_atom = TRUE;
   s->data = data;
   s->len = size;
@@ -749,6 +793,111 @@ svn_skel__parse_iprops(apr_array_header_t **iprops,
   return SVN_NO_ERROR;
 }
 
+/* Return the contents of atom SKEL as a NUL-terminated string.  SKEL
+   must have been parsed from a modifiable buffer with at least one more
+   byte after the end of the parsed data.
+
+   Put the terminator right into that buffer, if that does not overwrite
+   the contents of the next atom in the same list.  That would only be
+   the case for an implicit-length atom directly following SKEL.  In
+   that case, copy the contents to RESULT_POOL instead. */
+static const char *
+terminate_atom(const svn_skel_t *skel,
+               apr_pool_t *result_pool)
+{
+  char *end = (char *)skel->data + skel->len;
+  if (skel->next && skel->next->is_atom && skel->next->data == end)
+    return apr_pstrmemdup(result_pool, skel->data, skel->len);
+
+  *end = '\0';
+  return skel->data;
+}
+
+/* Like svn_skel__parse_proplist() but re-use the contents of the atoms
+   in the buffer that the valid proplist SKEL has been parsed from.
+   See terminate_atom() for the requirements. */
+static apr_hash_t *
+proplist_in_place(const svn_skel_t *skel,
+                  apr_pool_t *result_pool)
+{
+  apr_hash_t *proplist = apr_hash_make(result_pool);
+  svn_skel_t *elt;
+
+  for (elt = skel->children; elt; elt = elt->next->next)
+    {
+      svn_string_t *value = apr_palloc(result_pool, sizeof(*value));
+      const char *name = terminate_atom(elt, result_pool);
+
+      value->data = terminate_atom(elt->next, result_pool);
+      value->len = elt->next->len;
+      apr_hash_set(proplist, name, elt->len, value);
+    }
+
+  return proplist;
+}
+
+/* Copy the LEN bytes at DATA into a NUL-terminated buffer allocated in
+   RESULT_POOL and parse it into a skel allocated in SCRATCH_POOL. */
+static svn_skel_t *
+parse_copy(const char *data,
+           apr_size_t len,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  char *buffer = apr_palloc(result_pool, len + 1);
+  memcpy(buffer, data, len);
+  buffer[len] = '\0';
+
+  return svn_skel__parse(buffer, len, scratch_pool);
+}
+
+svn_error_t *
+svn_skel__parse_proplist_data(apr_hash_t **proplist_p,
+                              const char *data,
+                              apr_size_t len,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = parse_copy(data, len, result_pool, scratch_pool);
+
+  /* Validate the skel. */
+  if (! is_valid_proplist_skel(skel))
+    return skel_err("proplist");
+
+  *proplist_p = proplist_in_place(skel, result_pool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_skel__parse_iprops_data(apr_array_header_t **iprops,
+                            const char *data,
+                            apr_size_t len,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = parse_copy(data, len, result_pool, scratch_pool);
+  svn_skel_t *elt;
+
+  /* Validate the skel. */
+  if (! is_valid_iproplist_skel(skel))
+    return skel_err("iprops");
+
+  /* Create the returned structure */
+  *iprops = apr_array_make(result_pool, svn_skel__list_length(skel) / 2,
+                           sizeof(svn_prop_inherited_item_t *));
+
+  for (elt = skel->children; elt; elt = elt->next->next)
+    {
+      svn_prop_inherited_item_t *new_iprop = apr_palloc(result_pool,
+                                                        sizeof(*new_iprop));
+      new_iprop->path_or_url = terminate_atom(elt, result_pool);
+      new_iprop->prop_hash = proplist_in_place(elt->next, result_pool);
+      APR_ARRAY_PUSH(*iprops, svn_prop_inherited_item_t *) = new_iprop;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_skel__parse_prop(svn_string_t **propval,
                      const svn_skel_t *skel,
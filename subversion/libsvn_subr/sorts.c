@@ -27,12 +27,15 @@
 #include <apr_hash.h>
 #include <apr_tables.h>
 #include <stdlib.h>       /* for qsort()   */
+#include <string.h>
 #include <assert.h>
 #include "svn_hash.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 #include "svn_sorts.h"
 #include "svn_error.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 
 
 
@@ -134,11 +137,335 @@ svn_sort_compare_ranges(const void *a, const void *b)
   return item1->start < item2->start ? -1 : 1;
 }
 
+
+/*** Radix sort for paths ***/
+
+/* Arrays with fewer elements than this get sorted with qsort() even if
+   they contain paths. */
+#define PATH_RADIX_SORT_MIN 64
+
+/* Buckets with up to this many entries get sorted by insertion sort. */
+#define INSERTION_SORT_MAX 16
+
+/* Number of nested partitioning steps after which we switch to qsort()
+   to limit the stack usage of radix_sort_paths(). */
+#define MAX_RADIX_LEVELS 32
+
+/* Arrays with at least this many elements get sorted concurrently. */
+#define PARALLEL_SORT_MIN 0x10000
+
+/* Buckets with fewer entries than this are not worth a task of their own
+   when sorting concurrently. */
+#define PARALLEL_BUCKET_MIN 0x400
+
+/* Map byte C of a path to its position in the order used by
+   svn_path_compare_paths(): the terminating NUL sorts first, followed
+   by '/' and all other bytes in their natural order. */
+#define PATH_RANK(c) ((c) == 0   ? 0            \
+                    : (c) == '/' ? 1            \
+                    : (c) < '/'  ? (c) + 1      \
+                    :              (c))
+
+/* An element to sort together with its path. */
+typedef struct path_entry_t
+{
+  const char *path;
+  const void *element;
+} path_entry_t;
+
+/* qsort()-compatible comparison of two path_entry_t. */
+static int
+compare_path_entries(const void *a, const void *b)
+{
+  return svn_path_compare_paths(((const path_entry_t *)a)->path,
+                                ((const path_entry_t *)b)->path);
+}
+
+/* Like svn_path_compare_paths() but only compare PATH1 and PATH2 from
+   offset DEPTH onwards.  Both paths must be equal up to DEPTH. */
+static int
+compare_paths_from(const char *path1,
+                   const char *path2,
+                   apr_size_t depth)
+{
+  const unsigned char *p1 = (const unsigned char *)path1 + depth;
+  const unsigned char *p2 = (const unsigned char *)path2 + depth;
+
+  while (*p1 == *p2 && *p1)
+    {
+      ++p1;
+      ++p2;
+    }
+
+  return (int)PATH_RANK(*p1) - (int)PATH_RANK(*p2);
+}
+
+/* Sort the COUNT ENTRIES, which are equal up to DEPTH, by insertion. */
+static void
+insertion_sort_paths(path_entry_t *entries,
+                     apr_size_t count,
+                     apr_size_t depth)
+{
+  apr_size_t i, k;
+
+  for (i = 1; i < count; ++i)
+    {
+      path_entry_t entry = entries[i];
+      for (k = i;
+           k > 0 && compare_paths_from(entries[k - 1].path, entry.path,
+                                       depth) > 0;
+           --k)
+        entries[k] = entries[k - 1];
+
+      entries[k] = entry;
+    }
+}
+
+/* Distribute the COUNT ENTRIES, which are equal up to *DEPTH, into
+   buckets by the rank of the first byte in which they differ.  Update
+   *DEPTH to the offset of that byte and set COUNTS to the bucket sizes.
+   TEMP provides space for COUNT entries.
+
+   Return FALSE if all entries are equal, i.e. they are sorted already. */
+static svn_boolean_t
+partition_paths(path_entry_t *entries,
+                path_entry_t *temp,
+                apr_size_t count,
+                apr_size_t *depth,
+                apr_size_t counts[256])
+{
+  apr_size_t offsets[256];
+  apr_size_t i, offset;
+  unsigned int first;
+
+  /* Skip the common prefix. */
+  for (;;)
+    {
+      memset(counts, 0, 256 * sizeof(*counts));
+      for (i = 0; i < count; ++i)
+        {
+          unsigned char c = (unsigned char)entries[i].path[*depth];
+          ++counts[PATH_RANK(c)];
+        }
+
+      first = PATH_RANK((unsigned char)entries[0].path[*depth]);
+      if (counts[first] != count)
+        break;
+
+      /* All entries end here, i.e. they are all equal. */
+      if (first == 0)
+        return FALSE;
+
+      ++*depth;
+    }
+
+  offset = 0;
+  for (i = 0; i < 256; ++i)
+    {
+      offsets[i] = offset;
+      offset += counts[i];
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      unsigned char c = (unsigned char)entries[i].path[*depth];
+      temp[offsets[PATH_RANK(c)]++] = entries[i];
+    }
+
+  memcpy(entries, temp, count * sizeof(*entries));
+  return TRUE;
+}
+
+/* Sort the COUNT ENTRIES, which are equal up to DEPTH, with a MSD radix
+   sort.  TEMP provides space for COUNT entries.  LEVEL is the recursion
+   depth. */
+static void
+radix_sort_paths(path_entry_t *entries,
+                 path_entry_t *temp,
+                 apr_size_t count,
+                 apr_size_t depth,
+                 int level)
+{
+  apr_size_t counts[256];
+  apr_size_t i, start;
+
+  if (count <= INSERTION_SORT_MAX)
+    {
+      insertion_sort_paths(entries, count, depth);
+      return;
+    }
+
+  if (level >= MAX_RADIX_LEVELS)
+    {
+      qsort(entries, count, sizeof(*entries), compare_path_entries);
+      return;
+    }
+
+  if (!partition_paths(entries, temp, count, &depth, counts))
+    return;
+
+  /* Bucket 0 contains the entries that end at DEPTH, i.e. are equal. */
+  start = counts[0];
+  for (i = 1; i < 256; ++i)
+    {
+      if (counts[i] > 1)
+        radix_sort_paths(entries + start, temp + start, counts[i],
+                         depth + 1, level + 1);
+      start += counts[i];
+    }
+}
+
+/* A bucket to be sorted by sort_bucket_task(). */
+typedef struct sort_bucket_t
+{
+  path_entry_t *entries;
+  path_entry_t *temp;
+  apr_size_t count;
+  apr_size_t depth;
+} sort_bucket_t;
+
+/* Implements svn_task__process_func_t for sort_bucket_t batons. */
+static svn_error_t *
+sort_bucket_task(void **result,
+                 void *process_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  sort_bucket_t *bucket = process_baton;
+  radix_sort_paths(bucket->entries, bucket->temp, bucket->count,
+                   bucket->depth, 1);
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Like radix_sort_paths() for all COUNT ENTRIES but sort the large
+   buckets of the first partitioning step concurrently.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parallel_sort_paths(path_entry_t *entries,
+                    path_entry_t *temp,
+                    apr_size_t count,
+                    apr_pool_t *scratch_pool)
+{
+  svn_task__set_t *set;
+  apr_size_t counts[256];
+  apr_size_t depth = 0;
+  apr_size_t i, start;
+
+  if (!partition_paths(entries, temp, count, &depth, counts))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_task__set_create(&set, 0, NULL, NULL, NULL, NULL,
+                               scratch_pool));
+
+  start = counts[0];
+  for (i = 1; i < 256; ++i)
+    {
+      if (counts[i] >= PARALLEL_BUCKET_MIN)
+        {
+          sort_bucket_t *bucket = apr_palloc(scratch_pool, sizeof(*bucket));
+          bucket->entries = entries + start;
+          bucket->temp = temp + start;
+          bucket->count = counts[i];
+          bucket->depth = depth + 1;
+
+          SVN_ERR(svn_task__add(set, sort_bucket_task, bucket));
+        }
+      else if (counts[i] > 1)
+        {
+          radix_sort_paths(entries + start, temp + start, counts[i],
+                           depth + 1, 1);
+        }
+
+      start += counts[i];
+    }
+
+  return svn_error_trace(svn_task__set_finish(set));
+}
+
+void
+svn_sort__array_by_path(apr_array_header_t *array,
+                        svn_sort__path_func_t path_func,
+                        apr_pool_t *scratch_pool)
+{
+  apr_size_t count = array->nelts;
+  apr_size_t elt_size = array->elt_size;
+  path_entry_t *entries, *temp;
+  char *sorted;
+  apr_size_t i;
+
+  if (count < 2)
+    return;
+
+  entries = apr_palloc(scratch_pool, count * sizeof(*entries));
+  temp = apr_palloc(scratch_pool, count * sizeof(*temp));
+  for (i = 0; i < count; ++i)
+    {
+      entries[i].element = array->elts + i * elt_size;
+      entries[i].path = path_func(entries[i].element);
+    }
+
+  if (count >= PARALLEL_SORT_MIN && svn_task__get_thread_limit() > 1)
+    {
+      /* Destroying the pool waits for all outstanding tasks.  Since our
+         tasks can't fail, errors are about the task set itself and we
+         simply finish the job in this thread. */
+      apr_pool_t *task_pool = svn_pool_create(scratch_pool);
+      svn_error_t *err = parallel_sort_paths(entries, temp, count,
+                                             task_pool);
+      svn_pool_destroy(task_pool);
+
+      if (err)
+        {
+          svn_error_clear(err);
+          radix_sort_paths(entries, temp, count, 0, 0);
+        }
+    }
+  else
+    {
+      radix_sort_paths(entries, temp, count, 0, 0);
+    }
+
+  /* Reorder the array elements according to the sorted entries. */
+  sorted = apr_palloc(scratch_pool, count * elt_size);
+  for (i = 0; i < count; ++i)
+    memcpy(sorted + i * elt_size, entries[i].element, elt_size);
+
+  memcpy(array->elts, sorted, count * elt_size);
+}
+
+/* Implements svn_sort__path_func_t for arrays of const char *. */
+static const char *
+cstring_path(const void *element)
+{
+  return *(const char * const *)element;
+}
+
+/* Implements svn_sort__path_func_t for arrays of svn_sort__item_t. */
+static const char *
+item_path(const void *element)
+{
+  return ((const svn_sort__item_t *)element)->key;
+}
+
 void
 svn_sort__array(apr_array_header_t *array,
                 int (*comparison_func)(const void *,
                                        const void *))
 {
+  /* Large path arrays are much faster to sort by radix. */
+  if (   comparison_func == svn_sort_compare_paths
+      && array->nelts >= PATH_RADIX_SORT_MIN)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(array->pool);
+      svn_sort__array_by_path(array, cstring_path, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+      return;
+    }
+
   qsort(array->elts, array->nelts, array->elt_size, comparison_func);
 }
 
@@ -178,10 +505,23 @@ svn_sort__hash(apr_hash_t *ht,
         }
     }
 
-  /* quicksort the array if it isn't already sorted.  */
+  /* quicksort the array if it isn't already sorted.  Large path arrays
+     are much faster to sort by radix. */
   if (!sorted)
-    svn_sort__array(ary,
-          (int (*)(const void *, const void *))comparison_func);
+    {
+      if (   comparison_func == svn_sort_compare_items_as_paths
+          && ary->nelts >= PATH_RADIX_SORT_MIN)
+        {
+          apr_pool_t *scratch_pool = svn_pool_create(pool);
+          svn_sort__array_by_path(ary, item_path, scratch_pool);
+          svn_pool_destroy(scratch_pool);
+        }
+      else
+        {
+          svn_sort__array(ary,
+                (int (*)(const void *, const void *))comparison_func);
+        }
+    }
 
   return ary;
 }
@@ -21,14 +21,35 @@
  * ====================================================================
  */
 
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
 #include <apr_file_io.h>
+#include <apr_mmap.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 
+#include "private/svn_io_private.h"
 #include "private/svn_subr_private.h"
 
 
+/* Size of the spill file section that we map at once when reading it
+   through a memory map.  */
+#define SPILL_MAP_WINDOW (4 * 1024 * 1024)
+
+/* Offsets of mapped spill file sections are multiples of this.  It
+   covers the usual page sizes as well as the allocation granularity
+   on Windows.  */
+#define SPILL_MAP_ALIGNMENT (64 * 1024)
+
+/* svn_spillbuf__adaptive_maxsize() suggests this fraction of the
+   physical memory as in-memory limit.  */
+#define SPILL_MEMORY_FRACTION 1024
+
+
 struct memblock_t {
   apr_size_t size;
   char *data;
@@ -87,6 +108,22 @@ struct svn_spillbuf_t {
 
   /* The name of the temporary spill file. */
   const char *filename;
+
+  /* When true, read content from SPILL through a memory map instead of
+     copying it into memblocks.  */
+  svn_boolean_t read_mapped;
+
+#if APR_HAS_MMAP
+  /* The currently mapped section of SPILL, if any, starting at file
+     offset MAP_OFFSET.  It is allocated in MAP_POOL.  */
+  apr_mmap_t *mmap;
+  apr_off_t map_offset;
+  apr_pool_t *map_pool;
+
+  /* The memblock that we pass out for mapped content.  Its DATA points
+     into MMAP and it never gets on the AVAIL list.  */
+  struct memblock_t map_block;
+#endif
 };
 
 
@@ -194,6 +231,60 @@ svn_spillbuf__get_file(const svn_spillbuf_t *buf)
   return buf->spill;
 }
 
+void
+svn_spillbuf__set_read_mapped(svn_spillbuf_t *buf,
+                              svn_boolean_t read_mapped)
+{
+#if APR_HAS_MMAP
+  buf->read_mapped = read_mapped;
+#endif
+}
+
+/* Return the size of the physical memory in bytes, or 0 if unknown.  */
+static apr_uint64_t
+get_physical_memory(void)
+{
+#if defined(WIN32)
+  MEMORYSTATUSEX status;
+
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status))
+    return status.ullTotalPhys;
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  if (pages > 0 && page_size > 0)
+    return (apr_uint64_t)pages * (apr_uint64_t)page_size;
+#endif
+
+  return 0;
+}
+
+apr_size_t
+svn_spillbuf__adaptive_maxsize(apr_size_t min_size,
+                               apr_size_t max_size)
+{
+  apr_uint64_t suggested = get_physical_memory() / SPILL_MEMORY_FRACTION;
+
+  if (suggested > max_size)
+    return max_size;
+
+  return suggested > min_size ? (apr_size_t)suggested : min_size;
+}
+
+/* Return TRUE if MEM is BUF's memblock for mapped content.  */
+static APR_INLINE svn_boolean_t
+is_map_block(const svn_spillbuf_t *buf,
+             const struct memblock_t *mem)
+{
+#if APR_HAS_MMAP
+  return mem == &buf->map_block;
+#else
+  return FALSE;
+#endif
+}
+
 /* Get a memblock from the spill-buffer. It will be the block that we
    passed out for reading, come from the free list, or allocated.  */
 static struct memblock_t *
@@ -204,7 +295,8 @@ get_buffer(svn_spillbuf_t *buf)
   if (mem != NULL)
     {
       buf->out_for_reading = NULL;
-      return mem;
+      if (!is_map_block(buf, mem))
+        return mem;
     }
 
   if (buf->avail == NULL)
@@ -225,11 +317,94 @@ static void
 return_buffer(svn_spillbuf_t *buf,
               struct memblock_t *mem)
 {
+  /* Mapped content does not live in a buffer of our own.  */
+  if (is_map_block(buf, mem))
+    return;
+
   mem->next = buf->avail;
   buf->avail = mem;
 }
 
 
+#if APR_HAS_MMAP
+
+/* Release BUF's current map of the spill file, if any.  */
+static void
+unmap_spill(svn_spillbuf_t *buf)
+{
+  if (buf->mmap == NULL)
+    return;
+
+  /* There is nothing useful to do if this fails. */
+  apr_mmap_delete(buf->mmap);
+  buf->mmap = NULL;
+  svn_pool_clear(buf->map_pool);
+}
+
+/* Like read_data() but return the next block of content from BUF's spill
+   file in *MEM by mapping the file into memory.  Set *MEM to NULL if
+   the file cannot be mapped.  Use SCRATCH_POOL for temporaries.  */
+static svn_error_t *
+map_data(struct memblock_t **mem,
+         svn_spillbuf_t *buf,
+         apr_pool_t *scratch_pool)
+{
+  apr_off_t end = buf->spill_start + buf->spill_size;
+  apr_off_t map_end;
+
+  /* Map a new section of the file unless the current one contains
+     the next data. */
+  if (   buf->mmap == NULL
+      || buf->spill_start < buf->map_offset
+      || buf->spill_start >= buf->map_offset + (apr_off_t)buf->mmap->size)
+    {
+      apr_off_t offset = buf->spill_start
+                       - buf->spill_start % SPILL_MAP_ALIGNMENT;
+      apr_size_t size = (apr_size_t)MIN(end - offset, SPILL_MAP_WINDOW);
+      apr_status_t status;
+
+      unmap_spill(buf);
+
+      /* Recently written data may still be in the file buffer. */
+      SVN_ERR(svn_io_file_flush(buf->spill, scratch_pool));
+
+      if (buf->map_pool == NULL)
+        buf->map_pool = svn_pool_create(buf->pool);
+
+      status = apr_mmap_create(&buf->mmap, buf->spill, offset, size,
+                               APR_MMAP_READ, buf->map_pool);
+      if (status)
+        {
+          /* Mapping is only an optimization.  Read the file from now on
+             and make sure to continue where we left off. */
+          apr_off_t output_unused = buf->spill_start;  /* ### stupid API  */
+
+          buf->mmap = NULL;
+          svn_pool_clear(buf->map_pool);
+          buf->read_mapped = FALSE;
+          *mem = NULL;
+
+          return svn_error_trace(svn_io_file_seek(buf->spill, APR_SET,
+                                                  &output_unused,
+                                                  scratch_pool));
+        }
+
+      buf->map_offset = offset;
+    }
+
+  /* Pass out at most one block, just like for non-mapped content. */
+  map_end = MIN(end, buf->map_offset + (apr_off_t)buf->mmap->size);
+  *mem = &buf->map_block;
+  (*mem)->data = (char *)buf->mmap->mm + (buf->spill_start - buf->map_offset);
+  (*mem)->size = (apr_size_t)MIN(map_end - buf->spill_start,
+                                 (apr_off_t)buf->blocksize);
+  (*mem)->next = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_MMAP */
+
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
                     const char *data,
@@ -244,6 +419,11 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
   if (buf->spill == NULL
       && ((buf->maxsize - buf->memory_size) < len))
     {
+#if APR_HAS_MMAP
+      /* Any remaining map belongs to the previous spill file.  */
+      unmap_spill(buf);
+#endif
+
       SVN_ERR(svn_io_open_unique_file3(&buf->spill,
                                        &buf->filename,
                                        buf->dirpath,
@@ -378,25 +558,35 @@ read_data(struct memblock_t **mem,
       return SVN_NO_ERROR;
     }
 
-  /* Assume that the caller has seeked the spill file to the correct pos.  */
+  *mem = NULL;
+#if APR_HAS_MMAP
+  if (buf->read_mapped)
+    SVN_ERR(map_data(mem, buf, scratch_pool));
+#endif
 
-  /* Get a buffer that we can read content into.  */
-  *mem = get_buffer(buf);
-  /* NOTE: mem's size/next are uninitialized.  */
+  if (*mem == NULL)
+    {
+      /* Assume that the caller has seeked the spill file to the correct
+         pos.  */
 
-  if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
-    (*mem)->size = (apr_size_t)buf->spill_size;
-  else
-    (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
-  (*mem)->next = NULL;
+      /* Get a buffer that we can read content into.  */
+      *mem = get_buffer(buf);
+      /* NOTE: mem's size/next are uninitialized.  */
 
-  /* Read some data from the spill file into the memblock.  */
-  err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
-                         scratch_pool);
-  if (err)
-    {
-      return_buffer(buf, *mem);
-      return svn_error_trace(err);
+      if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
+        (*mem)->size = (apr_size_t)buf->spill_size;
+      else
+        (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
+      (*mem)->next = NULL;
+
+      /* Read some data from the spill file into the memblock.  */
+      err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
+                             scratch_pool);
+      if (err)
+        {
+          return_buffer(buf, *mem);
+          return svn_error_trace(err);
+        }
     }
 
   /* Mark the data that we consumed from the spill file.  */
@@ -405,7 +595,9 @@ read_data(struct memblock_t **mem,
   /* Did we consume all the data from the spill file?  */
   if ((buf->spill_size -= (*mem)->size) == 0)
     {
-      /* Close and reset our spill file information.  */
+      /* Close and reset our spill file information.  A map of the file
+         stays valid and we keep it until the mapped block has been
+         consumed.  */
       SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
       buf->spill = NULL;
       buf->spill_start = 0;
@@ -538,6 +730,22 @@ svn_spillbuf__reader_create(apr_size_t blocksize,
   return sbr;
 }
 
+svn_spillbuf_reader_t *
+svn_spillbuf__reader_create_extended(apr_size_t blocksize,
+                                     apr_size_t maxsize,
+                                     svn_boolean_t delete_on_close,
+                                     svn_boolean_t spill_all_contents,
+                                     const char *dirpath,
+                                     apr_pool_t *result_pool)
+{
+  svn_spillbuf_reader_t *sbr = apr_pcalloc(result_pool, sizeof(*sbr));
+  sbr->buf = svn_spillbuf__create_extended(blocksize, maxsize,
+                                           delete_on_close,
+                                           spill_all_contents, dirpath,
+                                           result_pool);
+  return sbr;
+}
+
 svn_error_t *
 svn_spillbuf__reader_read(apr_size_t *amt,
                           svn_spillbuf_reader_t *reader,
@@ -651,6 +859,73 @@ svn_spillbuf__reader_write(svn_spillbuf_reader_t *reader,
 }
 
 
+svn_error_t *
+svn_spillbuf__reader_map(const char **data,
+                         apr_size_t *len,
+                         svn_spillbuf_reader_t *reader,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_spillbuf_t *buf = reader->buf;
+  svn_stringbuf_t *content;
+
+#if APR_HAS_MMAP
+  /* With SPILL_ALL_CONTENTS, the file has a copy of the in-memory blocks
+     as well.  As long as nothing has been read, SPILL_START still equals
+     the size of these blocks and the file holds the complete content. */
+  if (   buf->spill != NULL
+      && buf->spill_all_contents
+      && buf->spill_start == buf->memory_size
+      && buf->out_for_reading == NULL
+      && reader->sb_len == 0
+      && reader->save_len == 0
+      && buf->memory_size + buf->spill_size <= APR_SIZE_MAX)
+    {
+      apr_mmap_t *mm;
+      apr_size_t size = (apr_size_t)(buf->memory_size + buf->spill_size);
+      apr_status_t status;
+
+      /* The data must have made it to the file before we can map it. */
+      SVN_ERR(svn_io_file_flush(buf->spill, scratch_pool));
+      status = apr_mmap_create(&mm, buf->spill, 0, size, APR_MMAP_READ,
+                               result_pool);
+      if (status == APR_SUCCESS)
+        {
+          *data = mm->mm;
+          *len = size;
+          return SVN_NO_ERROR;
+        }
+
+      /* Mapping is only an optimization.  Fall back to reading. */
+    }
+#endif
+
+  content = svn_stringbuf_create_ensure((apr_size_t)svn_spillbuf__get_size(buf)
+                                          + reader->sb_len
+                                          + reader->save_len,
+                                        result_pool);
+  while (TRUE)
+    {
+      apr_size_t amt;
+
+      svn_stringbuf_ensure(content, content->len + buf->blocksize);
+      SVN_ERR(svn_spillbuf__reader_read(&amt, reader,
+                                        content->data + content->len,
+                                        buf->blocksize, scratch_pool));
+      if (amt == 0)
+        break;
+
+      content->len += amt;
+    }
+
+  content->data[content->len] = '\0';
+  *data = content->data;
+  *len = content->len;
+
+  return SVN_NO_ERROR;
+}
+
+
 struct spillbuf_baton
 {
   svn_spillbuf_reader_t *reader;
@@ -684,6 +959,50 @@ write_handler_spillbuf(void *baton, const char *data, apr_size_t *len)
 }
 
 
+static svn_error_t *
+borrow_handler_spillbuf(void *baton, const char **data, apr_size_t *len)
+{
+  struct spillbuf_baton *sb = baton;
+  svn_spillbuf_reader_t *reader = sb->reader;
+
+  /* Content saved from an earlier write goes first.  */
+  if (reader->save_len > 0)
+    {
+      *len = MIN(*len, reader->save_len);
+      *data = reader->save_ptr + reader->save_pos;
+      reader->save_pos += *len;
+      reader->save_len -= *len;
+
+      return SVN_NO_ERROR;
+    }
+
+  if (reader->sb_len == 0)
+    {
+      SVN_ERR(svn_spillbuf__read(&reader->sb_ptr, &reader->sb_len,
+                                 reader->buf, sb->scratch_pool));
+      svn_pool_clear(sb->scratch_pool);
+
+      if (reader->sb_ptr == NULL)
+        {
+          /* End of the spillbuf.  */
+          reader->sb_len = 0;
+          *data = "";
+          *len = 0;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Lend out (part of) the block that the spillbuf gave us.  */
+  *len = MIN(*len, reader->sb_len);
+  *data = reader->sb_ptr;
+  reader->sb_ptr += *len;
+  reader->sb_len -= *len;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_stream_t *
 svn_stream__from_spillbuf(svn_spillbuf_t *buf,
                           apr_pool_t *result_pool)
@@ -700,6 +1019,7 @@ svn_stream__from_spillbuf(svn_spillbuf_t *buf,
   svn_stream_set_read2(stream, NULL /* only full read support */,
                        read_handler_spillbuf);
   svn_stream_set_write(stream, write_handler_spillbuf);
+  svn_stream__set_borrow(stream, borrow_handler_spillbuf, NULL);
 
   return stream;
 }
@@ -21,6 +21,16 @@
  */
 
 #include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+
+#if APR_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "svn_types.h"
 #include "svn_error.h"
@@ -142,6 +152,11 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* Busy timeout in msec and the time in usec that we spent waiting for
+     the current lock conflict, if we use busy_backoff_handler(). */
+  apr_int32_t busy_timeout;
+  apr_interval_time_t busy_waited;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -669,7 +684,8 @@ svn_sqlite__column_properties(apr_hash_t **props,
   apr_size_t len;
   const void *val;
 
-  /* svn_skel__parse_proplist copies everything needed to result_pool */
+  /* svn_skel__parse_proplist_data copies everything needed to
+     result_pool */
   val = svn_sqlite__column_blob(stmt, column, &len, NULL);
   if (val == NULL)
     {
@@ -677,9 +693,8 @@ svn_sqlite__column_properties(apr_hash_t **props,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_skel__parse_proplist(props,
-                                   svn_skel__parse(val, len, scratch_pool),
-                                   result_pool));
+  SVN_ERR(svn_skel__parse_proplist_data(props, val, len,
+                                        result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -694,7 +709,8 @@ svn_sqlite__column_iprops(apr_array_header_t **iprops,
   apr_size_t len;
   const void *val;
 
-  /* svn_skel__parse_iprops copies everything needed to result_pool */
+  /* svn_skel__parse_iprops_data copies everything needed to
+     result_pool */
   val = svn_sqlite__column_blob(stmt, column, &len, NULL);
   if (val == NULL)
     {
@@ -702,9 +718,8 @@ svn_sqlite__column_iprops(apr_array_header_t **iprops,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_skel__parse_iprops(iprops,
-                                 svn_skel__parse(val, len, scratch_pool),
-                                 result_pool));
+  SVN_ERR(svn_skel__parse_iprops_data(iprops, val, len,
+                                      result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1069,6 +1084,93 @@ like_ucs_nfd(sqlite3_context *context,
 }
 #endif /* SVN_UNICODE_NORMALIZATION_FIXES */
 
+/* Implements the sqlite3_busy_handler() callback for the svn_sqlite__db_t
+   in BATON.  COUNT is the number of previous calls for the current lock
+   conflict.  Sleep for 50 usec at first and double that with every retry,
+   up to 20 msec, until the busy timeout has been used up.  This reacts
+   much faster to short transactions than SQLite's default handler. */
+static int
+busy_backoff_handler(void *baton, int count)
+{
+  svn_sqlite__db_t *db = baton;
+  apr_interval_time_t delay = (count < 9) ? (50 << count) : 20000;
+
+  if (count == 0)
+    db->busy_waited = 0;
+
+  if (db->busy_waited >= (apr_interval_time_t)db->busy_timeout * 1000)
+    return 0;
+
+  apr_sleep(delay);
+  db->busy_waited += delay;
+
+  return 1;
+}
+
+/* Return FALSE if PATH is on a file system that is known not to support
+   the shared memory that SQLite's WAL mode requires, e.g. NFS or SMB,
+   or if its directory is not writable, so that the -shm and -wal files
+   could not be created next to it. */
+static svn_boolean_t
+supports_wal(const char *path, apr_pool_t *scratch_pool)
+{
+  const char *dir = svn_dirent_dirname(path, scratch_pool);
+#if defined(__linux__)
+  struct statfs info;
+#endif
+
+#if APR_HAVE_UNISTD_H
+  if (access(*dir ? dir : ".", W_OK) != 0)
+    return FALSE;
+#endif
+
+#if defined(__linux__)
+  if (statfs(*dir ? dir : ".", &info) == 0)
+    switch ((unsigned long)info.f_type)
+      {
+        case 0x6969:            /* NFS */
+        case 0x517B:            /* SMB */
+        case 0xFE534D42:        /* SMB2 */
+        case 0xFF534D42:        /* CIFS */
+        case 0x5346414F:        /* AFS */
+        case 0x73757245:        /* Coda */
+        case 0x65735546:        /* FUSE, e.g. sshfs */
+        case 0x47504653:        /* GPFS */
+        case 0x0BD00BD0:        /* Lustre */
+        case 0x19830326:        /* FhGFS / BeeGFS */
+        case 0x00C36400:        /* Ceph */
+        case 0x01161970:        /* GFS2 */
+        case 0x7461636F:        /* OCFS2 */
+        case 0x01021997:        /* 9p, e.g. WSL2 drvfs */
+        case 0x53464846:        /* WSL1 drvfs */
+        case 0x786F4256:        /* VirtualBox shared folders */
+        case 0x794C7630:        /* overlayfs */
+          return FALSE;
+        default:
+          break;
+      }
+#elif defined(WIN32)
+  /* UNC paths always refer to network shares. */
+  if ((dir[0] == '/' || dir[0] == '\\') && (dir[1] == '/' || dir[1] == '\\'))
+    return FALSE;
+
+  if (dir[0] && dir[1] == ':')
+    {
+      char root[4] = "?:\\";
+
+      root[0] = dir[0];
+      if (GetDriveTypeA(root) == DRIVE_REMOTE)
+        return FALSE;
+    }
+  else if (GetDriveTypeA(NULL) == DRIVE_REMOTE)
+    {
+      return FALSE;
+    }
+#endif
+
+  return TRUE;
+}
+
 svn_error_t *
 svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
@@ -1076,12 +1178,44 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  apr_int32_t timeout,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
+  svn_sqlite__open_options_t options = { 0 };
+
+  options.busy_timeout = timeout;
+
+  return svn_error_trace(svn_sqlite__open2(db, path, mode, statements,
+                                           &options, result_pool,
+                                           scratch_pool));
+}
+
+svn_error_t *
+svn_sqlite__open2(svn_sqlite__db_t **db, const char *path,
+                  svn_sqlite__mode_t mode, const char * const statements[],
+                  const svn_sqlite__open_options_t *options,
+                  apr_pool_t *result_pool, apr_pool_t *scratch_pool)
+{
+  static const svn_sqlite__open_options_t default_options = { 0 };
+  const char *journal_mode;
+
+  if (options == NULL)
+    options = &default_options;
+
   SVN_ERR(svn_atomic__init_once(&sqlite_init_state,
                                 init_sqlite, NULL, scratch_pool));
 
   *db = apr_pcalloc(result_pool, sizeof(**db));
 
-  SVN_ERR(internal_open(*db, path, mode, timeout, scratch_pool));
+  SVN_ERR(internal_open(*db, path, mode, options->busy_timeout,
+                        scratch_pool));
+
+  if (options->busy_backoff)
+    {
+      (*db)->busy_timeout = options->busy_timeout > 0
+                          ? options->busy_timeout
+                          : BUSY_TIMEOUT;
+      SQLITE_ERR_CLOSE(sqlite3_busy_handler((*db)->db3, busy_backoff_handler,
+                                            *db),
+                       *db, scratch_pool);
+    }
 
 #if SQLITE_VERSION_NUMBER >= 3008000 && SQLITE_VERSION_NUMBER < 3009000
   /* disable SQLITE_ENABLE_STAT3/4 from 3.8.1 - 3.8.3 (but not 3.8.3.1+)
@@ -1164,11 +1298,47 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.  A read-only
+     connection asked to use WAL must not switch the database back.
+     Leaving WAL mode fails while other connections use the database; we
+     then simply keep using WAL.  The same applies to write-protected
+     database files, which SQLite silently opens read-only. */
+  if (!options->wal)
+    journal_mode = "PRAGMA journal_mode = TRUNCATE;";
+  else if (   mode == svn_sqlite__mode_readonly
+           || sqlite3_db_readonly((*db)->db3, "main") > 0)
+    journal_mode = NULL;
+  else if (supports_wal(path, scratch_pool))
+    journal_mode = "PRAGMA journal_mode = WAL;";
+  else
+    journal_mode = "PRAGMA journal_mode = TRUNCATE;";
+
+  if (journal_mode)
+    SVN_SQLITE__ERR_CLOSE(exec_sql2(*db, journal_mode, SQLITE_BUSY), *db);
+
+#if SQLITE_VERSION_AT_LEAST(3,7,17)
+  if (options->mmap_size > 0)
+    SVN_SQLITE__ERR_CLOSE(exec_sql(*db,
+                                   apr_psprintf(scratch_pool,
+                                                "PRAGMA mmap_size = %"
+                                                APR_INT64_T_FMT ";",
+                                                options->mmap_size)),
+                          *db);
+#endif
+
+  /* Negative values are in kBytes instead of pages. */
+  if (options->cache_size > 0)
+    SVN_SQLITE__ERR_CLOSE(exec_sql(*db,
+                                   apr_psprintf(scratch_pool,
+                                                "PRAGMA cache_size = -%"
+                                                APR_INT64_T_FMT ";",
+                                                (options->cache_size + 1023)
+                                                / 1024)),
+                          *db);
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
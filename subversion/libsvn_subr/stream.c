@@ -29,6 +29,7 @@
 #include <apr_strings.h>
 #include <apr_file_io.h>
 #include <apr_errno.h>
+#include <apr_mmap.h>
 #include <apr_poll.h>
 #include <apr_portable.h>
 
@@ -62,6 +63,8 @@ struct svn_stream_t {
   svn_stream_seek_fn_t seek_fn;
   svn_stream_data_available_fn_t data_available_fn;
   svn_stream_readline_fn_t readline_fn;
+  svn_stream__borrow_fn_t borrow_fn;
+  svn_stream__return_fn_t return_fn;
   apr_file_t *file; /* Maybe NULL */
 };
 
@@ -145,6 +148,15 @@ svn_stream_set_readline(svn_stream_t *stream,
   stream->readline_fn = readline_fn;
 }
 
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn,
+                       svn_stream__return_fn_t return_fn)
+{
+  stream->borrow_fn = borrow_fn;
+  stream->return_fn = return_fn;
+}
+
 /* Standard implementation for svn_stream_read_full() based on
    multiple svn_stream_read2() calls (in separate function to make
    it more likely for svn_stream_read_full to be inlined) */
@@ -194,6 +206,36 @@ svn_stream_read_full(svn_stream_t *stream, char *buffer, apr_size_t *len)
   return svn_error_trace(stream->read_full_fn(stream->baton, buffer, len));
 }
 
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream,
+                   const char **data,
+                   apr_size_t *len,
+                   char *buffer,
+                   apr_size_t buffer_size)
+{
+  if (stream->borrow_fn)
+    {
+      SVN_ERR(stream->borrow_fn(stream->baton, data, len));
+      if (*data)
+        return SVN_NO_ERROR;
+    }
+
+  /* The stream can't lend us its data.  Copy it. */
+  *len = MIN(*len, buffer_size);
+  *data = buffer;
+
+  return svn_error_trace(svn_stream_read_full(stream, buffer, len));
+}
+
+svn_error_t *
+svn_stream__return(svn_stream_t *stream)
+{
+  if (stream->return_fn == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(stream->return_fn(stream->baton));
+}
+
 svn_error_t *
 svn_stream_skip(svn_stream_t *stream, apr_size_t len)
 {
@@ -411,7 +453,8 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
      associated error.) */
   while (1)
     {
-      apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+      const char *data;
+      apr_size_t len = APR_SIZE_MAX;
 
       if (cancel_func)
         {
@@ -420,14 +463,19 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
              break;
         }
 
-      err = svn_stream_read_full(from, buf, &len);
+      /* Write directly from FROM's buffers, if it lets us. */
+      err = svn_stream__borrow(from, &data, &len, buf, SVN__STREAM_CHUNK_SIZE);
       if (err)
          break;
 
       if (len > 0)
-        err = svn_stream_write(to, buf, &len);
+        err = svn_stream_write(to, data, &len);
+
+      err = svn_error_compose_create(err, svn_stream__return(from));
 
-      if (err || (len != SVN__STREAM_CHUNK_SIZE))
+      /* Only copied data signals the end of the stream by a short read. */
+      if (err || len == 0
+          || (data == buf && len != SVN__STREAM_CHUNK_SIZE))
           break;
     }
 
@@ -643,6 +691,26 @@ data_available_disown(void *baton, svn_boolean_t *data_available)
   return svn_error_trace(svn_stream_data_available(baton, data_available));
 }
 
+static svn_error_t *
+borrow_handler_disown(void *baton, const char **data, apr_size_t *len)
+{
+  svn_stream_t *stream = baton;
+
+  if (stream->borrow_fn == NULL)
+    {
+      *data = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(stream->borrow_fn(stream->baton, data, len));
+}
+
+static svn_error_t *
+return_handler_disown(void *baton)
+{
+  return svn_error_trace(svn_stream__return(baton));
+}
+
 static svn_error_t *
 readline_handler_disown(void *baton,
                         svn_stringbuf_t **stringbuf,
@@ -666,6 +734,7 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
   svn_stream_set_seek(s, seek_handler_disown);
   svn_stream_set_data_available(s, data_available_disown);
   svn_stream_set_readline(s, readline_handler_disown);
+  svn_stream__set_borrow(s, borrow_handler_disown, return_handler_disown);
 
   return s;
 }
@@ -676,7 +745,15 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
 struct baton_apr {
   apr_file_t *file;
   apr_pool_t *pool;
+  svn_boolean_t supports_seek;
   svn_boolean_t truncate_on_seek;
+
+#if APR_HAS_MMAP
+  /* The file section currently lent out by borrow_handler_apr, if any,
+   * and the pool that it has been allocated in. */
+  apr_mmap_t *mmap;
+  apr_pool_t *mmap_pool;
+#endif
 };
 
 /* svn_stream_mark_t for streams backed by APR files. */
@@ -771,11 +848,95 @@ write_handler_apr(void *baton, const char *data, apr_size_t *len)
   return svn_error_trace(err);
 }
 
+#if APR_HAS_MMAP
+
+/* Upper limit of the file section that borrow_handler_apr maps at once. */
+#define MMAP_WINDOW_SIZE (4 * 1024 * 1024)
+
+/* For less data than this, mapping is more expensive than reading. */
+#define MMAP_MIN_SIZE (64 * 1024)
+
+/* File offsets to map must be multiples of this.  It covers the usual
+ * page sizes as well as the allocation granularity on Windows. */
+#define MMAP_ALIGNMENT (64 * 1024)
+
+static svn_error_t *
+return_handler_apr(void *baton)
+{
+  struct baton_apr *btn = baton;
+  apr_status_t status;
+
+  if (btn->mmap == NULL)
+    return SVN_NO_ERROR;
+
+  status = apr_mmap_delete(btn->mmap);
+  btn->mmap = NULL;
+  svn_pool_clear(btn->mmap_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't unmap file section"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+borrow_handler_apr(void *baton, const char **data, apr_size_t *len)
+{
+  struct baton_apr *btn = baton;
+  apr_finfo_t finfo;
+  apr_off_t offset;
+  apr_off_t start;
+  apr_size_t size;
+
+  *data = NULL;
+  SVN_ERR(return_handler_apr(btn));
+
+  /* Only regular files can be mapped.  Everything else gets read. */
+  if (*len < MMAP_MIN_SIZE
+      || apr_file_info_get(&finfo, APR_FINFO_TYPE | APR_FINFO_SIZE,
+                           btn->file)
+         || finfo.filetype != APR_REG)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_get_offset(&offset, btn->file, btn->pool));
+  if (finfo.size - offset < MMAP_MIN_SIZE)
+    return SVN_NO_ERROR;
+
+  size = (apr_size_t)MIN(finfo.size - offset, MMAP_WINDOW_SIZE);
+  size = MIN(size, *len);
+  start = offset - offset % MMAP_ALIGNMENT;
+
+  if (btn->mmap_pool == NULL)
+    btn->mmap_pool = svn_pool_create(btn->pool);
+
+  if (apr_mmap_create(&btn->mmap, btn->file, start,
+                      (apr_size_t)(offset - start) + size,
+                      APR_MMAP_READ, btn->mmap_pool))
+    {
+      /* Mapping is only an optimization.  Fall back to reading. */
+      btn->mmap = NULL;
+      svn_pool_clear(btn->mmap_pool);
+      return SVN_NO_ERROR;
+    }
+
+  *data = (const char *)btn->mmap->mm + (offset - start);
+  *len = size;
+
+  offset += size;
+  return svn_error_trace(svn_io_file_seek(btn->file, APR_SET, &offset,
+                                          btn->pool));
+}
+
+#endif /* APR_HAS_MMAP */
+
 static svn_error_t *
 close_handler_apr(void *baton)
 {
   struct baton_apr *btn = baton;
 
+#if APR_HAS_MMAP
+  SVN_ERR(return_handler_apr(btn));
+#endif
+
   return svn_error_trace(svn_io_file_close(btn->file, btn->pool));
 }
 
@@ -986,6 +1147,54 @@ readline_apr_generic(apr_file_t *file,
     }
 }
 
+/* Like stream_readline_bytewise() but read from FILE directly, which
+   saves us a few layers of function calls per byte.  This does not need
+   FILE to be seekable. */
+static svn_error_t *
+readline_apr_bytewise(apr_file_t *file,
+                      svn_stringbuf_t **stringbuf,
+                      const char *eol,
+                      svn_boolean_t *eof,
+                      apr_pool_t *pool)
+{
+  svn_stringbuf_t *str;
+  const char *match;
+  char c;
+
+  str = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE, pool);
+
+  /* Read into STR up to and including the next EOL sequence. */
+  match = eol;
+  while (*match)
+    {
+      apr_status_t status = apr_file_getc(&c, file);
+      if (APR_STATUS_IS_EOF(status))
+        {
+          *eof = TRUE;
+          *stringbuf = str;
+          return SVN_NO_ERROR;
+        }
+      else if (status != APR_SUCCESS)
+        {
+          return svn_error_wrap_apr(status,
+                                    _("Can't read a line from stream"));
+        }
+
+      if (c == *match)
+        match++;
+      else
+        match = eol;
+
+      svn_stringbuf_appendbyte(str, c);
+    }
+
+  *eof = FALSE;
+  svn_stringbuf_chop(str, match - eol);
+  *stringbuf = str;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 readline_handler_apr(void *baton,
                      svn_stringbuf_t **stringbuf,
@@ -998,15 +1207,21 @@ readline_handler_apr(void *baton,
   if (eol[0] == '\n' && eol[1] == '\0')
     {
       /* Optimize the common case when we're looking for an LF ("\n")
-         end-of-line sequence by using apr_file_gets(). */
+         end-of-line sequence by using apr_file_gets().  This works for
+         pipes as well, e.g. when loading a dump file from stdin. */
       return svn_error_trace(readline_apr_lf(btn->file, stringbuf,
                                              eof, pool));
     }
-  else
+  else if (btn->supports_seek)
     {
       return svn_error_trace(readline_apr_generic(btn->file, stringbuf,
                                                   eol, eof, pool));
     }
+  else
+    {
+      return svn_error_trace(readline_apr_bytewise(btn->file, stringbuf,
+                                                   eol, eof, pool));
+    }
 }
 
 svn_error_t *
@@ -1080,17 +1295,25 @@ make_stream_from_apr_file(apr_file_t *file,
   baton = apr_palloc(pool, sizeof(*baton));
   baton->file = file;
   baton->pool = pool;
+  baton->supports_seek = supports_seek;
   baton->truncate_on_seek = truncate_on_seek;
+#if APR_HAS_MMAP
+  baton->mmap = NULL;
+  baton->mmap_pool = NULL;
+#endif
   stream = svn_stream_create(baton, pool);
   svn_stream_set_read2(stream, read_handler_apr, read_full_handler_apr);
   svn_stream_set_write(stream, write_handler_apr);
+  svn_stream_set_readline(stream, readline_handler_apr);
 
   if (supports_seek)
     {
       svn_stream_set_skip(stream, skip_handler_apr);
       svn_stream_set_mark(stream, mark_handler_apr);
       svn_stream_set_seek(stream, seek_handler_apr);
-      svn_stream_set_readline(stream, readline_handler_apr);
+#if APR_HAS_MMAP
+      svn_stream__set_borrow(stream, borrow_handler_apr, return_handler_apr);
+#endif
     }
 
   svn_stream_set_data_available(stream, data_available_handler_apr);
@@ -1644,6 +1867,18 @@ skip_handler_stringbuf(void *baton, apr_size_t len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_stringbuf(void *baton, const char **data, apr_size_t *len)
+{
+  struct stringbuf_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 write_handler_stringbuf(void *baton, const char *data, apr_size_t *len)
 {
@@ -1746,6 +1981,7 @@ svn_stream_from_stringbuf(svn_stringbuf_t *str,
   svn_stream_set_seek(stream, seek_handler_stringbuf);
   svn_stream_set_data_available(stream, data_available_handler_stringbuf);
   svn_stream_set_readline(stream, readline_handler_stringbuf);
+  svn_stream__set_borrow(stream, borrow_handler_stringbuf, NULL);
   return stream;
 }
 
@@ -1772,6 +2008,18 @@ read_handler_string(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_string(void *baton, const char **data, apr_size_t *len)
+{
+  struct string_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 mark_handler_string(void *baton, svn_stream_mark_t **mark, apr_pool_t *pool)
 {
@@ -1875,6 +2123,7 @@ svn_stream_from_string(const svn_string_t *str,
   svn_stream_set_skip(stream, skip_handler_string);
   svn_stream_set_data_available(stream, data_available_handler_string);
   svn_stream_set_readline(stream, readline_handler_string);
+  svn_stream__set_borrow(stream, borrow_handler_string, NULL);
   return stream;
 }
 
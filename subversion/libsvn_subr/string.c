@@ -37,6 +37,18 @@
 
 #include "svn_private_config.h"
 
+/* Use 16 byte vector compares in the match length functions where the
+ * compiler guarantees the respective instruction set to be available.
+ * Both SSE2 on x86-64 and NEON on AArch64 are part of the base ABI, so
+ * no runtime CPU detection is required. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SVN_MATCH_LENGTH_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SVN_MATCH_LENGTH_NEON 1
+#endif
+
 
 
 /* Allocate the space for a memory buffer from POOL.
@@ -1501,6 +1513,33 @@ svn_string__similarity(const svn_string_t *stringa,
     return SVN_STRING__SIM_RANGE_MAX;
 }
 
+#if defined(SVN_MATCH_LENGTH_SSE2) || defined(SVN_MATCH_LENGTH_NEON)
+
+/* Size of the vectors compared by chunks_equal(). */
+#define VECTOR_SIZE 16
+
+/* Return TRUE, if the VECTOR_SIZE bytes at A and B are equal.
+ * Neither pointer needs to be aligned. */
+static APR_INLINE svn_boolean_t
+chunks_equal(const char *a, const char *b)
+{
+#ifdef SVN_MATCH_LENGTH_SSE2
+  __m128i va = _mm_loadu_si128((const __m128i *)a);
+  __m128i vb = _mm_loadu_si128((const __m128i *)b);
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xffff;
+#else
+  uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t *)a),
+                           vld1q_u8((const uint8_t *)b));
+  uint64x2_t eq64 = vreinterpretq_u64_u8(eq);
+
+  return (vgetq_lane_u64(eq64, 0) & vgetq_lane_u64(eq64, 1))
+      == ~(uint64_t)0;
+#endif
+}
+
+#endif
+
 apr_size_t
 svn_cstring__match_length(const char *a,
                           const char *b,
@@ -1508,6 +1547,17 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef VECTOR_SIZE
+
+  /* Vector loads don't care about alignment.  Skip over the matching
+   * prefix in large steps and let the loops below find the exact position
+   * within the first mismatching chunk. */
+  for (; max_len - pos >= VECTOR_SIZE; pos += VECTOR_SIZE)
+    if (!chunks_equal(a + pos, b + pos))
+      break;
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1536,6 +1586,17 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef VECTOR_SIZE
+
+  /* Same as in svn_cstring__match_length but walking backwards. */
+  for (pos = VECTOR_SIZE; pos <= max_len; pos += VECTOR_SIZE)
+    if (!chunks_equal(a - pos, b - pos))
+      break;
+
+  pos -= VECTOR_SIZE;
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1544,7 +1605,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
@@ -52,6 +52,18 @@
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
 
+/* Scan for interesting characters 16 bytes at a time where the compiler
+ * guarantees the respective instruction set to be available.  Both SSE2
+ * on x86-64 and NEON on AArch64 are part of the base ABI, so no runtime
+ * CPU detection is required. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SVN_SUBST_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SVN_SUBST_SCAN_NEON 1
+#endif
+
 /**
  * The textual elements of a detranslated special file.  One of these
  * strings must appear as the first element of any special file as it
@@ -876,6 +888,10 @@ struct translation_baton
      may trigger a translation action, hence are 'interesting' */
   char interesting[256];
 
+  /* The interesting characters when there are keywords to translate,
+     padded with repetitions of '$'.  Used by count_boring(). */
+  char interesting_chars[3];
+
   /* Length of the string EOL_STR points to. */
   apr_size_t eol_str_len;
 
@@ -946,6 +962,10 @@ create_translation_baton(const char *eol_str,
       b->interesting['\n'] = TRUE;
     }
 
+  b->interesting_chars[0] = '$';
+  b->interesting_chars[1] = eol_str ? '\r' : '$';
+  b->interesting_chars[2] = eol_str ? '\n' : '$';
+
   return b;
 }
 
@@ -981,6 +1001,104 @@ eol_unchanged(struct translation_baton *b,
 }
 
 
+/* Return the number of characters from P up to END that are not
+ * interesting to B, which must have keywords to translate.
+ */
+static APR_INLINE apr_size_t
+count_boring(const struct translation_baton *b,
+             const char *p,
+             const char *end)
+{
+  const char *interesting = b->interesting;
+  apr_size_t len = 0;
+
+#if defined(SVN_SUBST_SCAN_SSE2)
+  {
+    const __m128i c0 = _mm_set1_epi8(b->interesting_chars[0]);
+    const __m128i c1 = _mm_set1_epi8(b->interesting_chars[1]);
+    const __m128i c2 = _mm_set1_epi8(b->interesting_chars[2]);
+
+    for (; (end - p) >= (apr_ssize_t)(len + 16); len += 16)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + len));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c0),
+                                                _mm_cmpeq_epi8(v, c1)),
+                                   _mm_cmpeq_epi8(v, c2));
+
+        if (_mm_movemask_epi8(hit))
+          break;
+      }
+  }
+#elif defined(SVN_SUBST_SCAN_NEON)
+  {
+    const uint8x16_t c0 = vdupq_n_u8((uint8_t)b->interesting_chars[0]);
+    const uint8x16_t c1 = vdupq_n_u8((uint8_t)b->interesting_chars[1]);
+    const uint8x16_t c2 = vdupq_n_u8((uint8_t)b->interesting_chars[2]);
+
+    for (; (end - p) >= (apr_ssize_t)(len + 16); len += 16)
+      {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(p + len));
+        uint64x2_t hit = vreinterpretq_u64_u8(
+                           vorrq_u8(vorrq_u8(vceqq_u8(v, c0),
+                                             vceqq_u8(v, c1)),
+                                    vceqq_u8(v, c2)));
+
+        if (vgetq_lane_u64(hit, 0) | vgetq_lane_u64(hit, 1))
+          break;
+      }
+  }
+#endif
+
+  /* Check 4 bytes at once to allow for efficient pipelining
+     and to reduce loop condition overhead. */
+  while ((end - p) >= (apr_ssize_t)(len + 4))
+    {
+      if (interesting[(unsigned char)p[len]]
+          || interesting[(unsigned char)p[len+1]]
+          || interesting[(unsigned char)p[len+2]]
+          || interesting[(unsigned char)p[len+3]])
+        break;
+
+      len += 4;
+    }
+
+  /* Found an interesting char or EOF in the next 4 bytes.
+     Find its exact position. */
+  while ((p + len) < end
+         && !interesting[(unsigned char)p[len]])
+    ++len;
+
+  return len;
+}
+
+/* Return TRUE if the characters from P up to END, which must not be empty,
+ * can be copied without any change by translate_chunk() with baton B in
+ * the boring state.
+ *
+ * That is the case if there are no keywords to translate, the EOL style
+ * is a single character and the source already uses that, as determined
+ * by B->nl_translation_skippable, and the other EOL character does not
+ * occur.  A trailing '\r' may be the start of a CRLF, though, which needs
+ * translation to a CR target.
+ */
+static APR_INLINE svn_boolean_t
+chunk_unchanged(const struct translation_baton *b,
+                const char *p,
+                const char *end)
+{
+  if (b->keywords
+      || b->eol_str_len != 1
+      || b->nl_translation_skippable != svn_tristate_true)
+    return FALSE;
+
+  if (b->eol_str[0] == '\n')
+    return memchr(p, '\r', end - p) == NULL;
+
+  return b->eol_str[0] == '\r'
+         && end[-1] != '\r'
+         && memchr(p, '\n', end - p) == NULL;
+}
+
 /* Translate eols and keywords of a 'chunk' of characters BUF of size BUFLEN
  * according to the settings and state stored in baton B.
  *
@@ -1110,6 +1228,13 @@ translate_chunk(svn_stream_t *dst,
                 b->nl_translation_skippable = svn_tristate_false;
             }
 
+          /* Pass the rest of the chunk on, if we can. */
+          if (p < end && chunk_unchanged(b, p, end))
+            {
+              SVN_ERR(translate_write(dst, p, end - p));
+              break;
+            }
+
           /* We're in the boring state; look for interesting characters.
              Offset len such that it will become 0 in the first iteration.
            */
@@ -1125,24 +1250,8 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* skip runs without interesting chars in large steps */
+                  len += count_boring(b, p + len, end);
                 }
               else
                 {
@@ -1788,7 +1897,8 @@ svn_subst_copy_and_translate4(const char *src,
 
   /* The easy way out:  no translation needed, just copy. */
   if (! (eol_str || (keywords && (apr_hash_count(keywords) > 0))))
-    return svn_error_trace(svn_io_copy_file(src, dst, FALSE, pool));
+    return svn_error_trace(svn_io_copy_file2(src, dst, SVN_IO_COPY_FILE_CLONE,
+                                             NULL, pool));
 
   /* Open source file. */
   SVN_ERR(svn_stream_open_readonly(&src_stream, src, pool, pool));
@@ -0,0 +1,686 @@
+/*
+ * task.c :  run independent pieces of work concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_pool.h>
+
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_task.h"
+
+#include "svn_private_config.h"
+
+
+
+/* Number of completed but undelivered results that we allow per worker
+ * thread before svn_task__add() starts waiting for the oldest task. */
+#define RESULTS_PER_THREAD 4
+
+/* While waiting for tasks, the owner checks for cancellation and failed
+ * workers in these intervals. */
+#define WAIT_INTERVAL (APR_USEC_PER_SEC / 10)
+
+/* Processing state of a task. */
+typedef enum task_state_t
+{
+  task_queued,
+  task_running,
+  task_done
+} task_state_t;
+
+/* A single task of a set. */
+typedef struct task_t
+{
+  /* Private root pool of this task, so it can be used from any thread.
+   * This struct and the result are allocated in it. */
+  apr_pool_t *pool;
+
+  svn_task__process_func_t process_func;
+  void *process_baton;
+
+  /* Result of PROCESS_FUNC, valid once STATE is task_done. */
+  void *result;
+  svn_error_t *err;
+  task_state_t state;
+
+  /* Next task in the order they have been added. */
+  struct task_t *next;
+} task_t;
+
+/* The part of a task set that its worker threads use.  It lives in its
+ * own root pool, which gets destroyed when the last reference to it is
+ * gone.  Worker jobs that have been queued but did not get a thread yet
+ * may outlive the task set itself.
+ *
+ * Unless noted otherwise, all members are protected by MUTEX.
+ */
+typedef struct shared_state_t
+{
+  apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *mutex;
+
+  /* Signaled whenever a task is done. */
+  apr_thread_cond_t *cond;
+#endif
+
+  /* Number of references: one from the task set plus one per worker
+   * job that has not exited yet. */
+  int refs;
+
+  /* Worker jobs that have been queued and not exited yet. */
+  int workers;
+
+  /* Number of tasks currently being processed. */
+  int running;
+
+  /* Tasks whose results have not been delivered, yet, in the order they
+   * have been added.  Only the owner modifies FIRST and LAST. */
+  task_t *first;
+  task_t *last;
+
+  /* First task in the list that has not been started, yet, if any. */
+  task_t *next_to_run;
+
+  /* Set when the remaining tasks shall not be processed anymore.
+   * May be accessed without holding MUTEX. */
+  volatile svn_atomic_t cancelled;
+
+  /* The APR status of a failure to lock MUTEX in a worker thread,
+   * 0 if there was none.  Once set, the state must not be relied upon
+   * anymore.  May be accessed without holding MUTEX. */
+  volatile svn_atomic_t worker_failure;
+
+  /* User-provided cancellation callback; read-only. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} shared_state_t;
+
+struct svn_task__set_t
+{
+  shared_state_t *state;
+
+  /* Maximum number of worker jobs to queue for this set. */
+  int max_workers;
+
+  /* Wait for the oldest task when there are more undelivered ones. */
+  int max_pending;
+
+  /* Number of tasks in STATE->FIRST .. STATE->LAST. */
+  int pending;
+
+  svn_task__output_func_t output_func;
+  void *output_baton;
+};
+
+/* Process-wide thread limit, -1 if it has not been determined, yet. */
+static volatile int thread_limit = -1;
+
+#if APR_HAS_THREADS
+
+/* The process-wide worker pool and its initialization state. */
+static volatile svn_atomic_t worker_pool_init_state = 0;
+static apr_thread_pool_t *worker_pool = NULL;
+
+#endif
+
+/* Return the number of CPU cores, or 1 if unknown. */
+static int
+get_cpu_count(void)
+{
+#if defined(WIN32)
+  SYSTEM_INFO info;
+
+  GetSystemInfo(&info);
+  if (info.dwNumberOfProcessors > 0)
+    return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (count > 0)
+    return (int)count;
+#endif
+
+  return 1;
+}
+
+int
+svn_task__get_thread_limit(void)
+{
+#if APR_HAS_THREADS
+  if (thread_limit < 0)
+    thread_limit = get_cpu_count();
+
+  return thread_limit;
+#else
+  return 0;
+#endif
+}
+
+void
+svn_task__set_thread_limit(int max_threads)
+{
+  thread_limit = MAX(max_threads, 0);
+
+#if APR_HAS_THREADS
+  /* Once created, the worker pool needs at least one thread. */
+  if (worker_pool && max_threads > 0)
+    {
+      apr_thread_pool_thread_max_set(worker_pool, max_threads);
+      apr_thread_pool_idle_max_set(worker_pool, max_threads);
+    }
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* Implements svn_atomic__err_init_func_t.  Create the WORKER_POOL. */
+static svn_error_t *
+init_worker_pool(void *baton,
+                 apr_pool_t *pool)
+{
+  /* This pool lives until APR gets terminated. */
+  apr_pool_t *global_pool = svn_pool_create(NULL);
+  apr_size_t max_threads = svn_task__get_thread_limit();
+  apr_status_t status;
+
+  status = apr_thread_pool_create(&worker_pool, 0, max_threads, global_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread pool"));
+
+  /* Keep the threads around instead of creating new ones all the time. */
+  apr_thread_pool_idle_max_set(worker_pool, max_threads);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+/* Lock STATE and return the APR status.  Without workers, there is no
+ * mutex and nothing to synchronize. */
+static apr_status_t
+lock_state(shared_state_t *state)
+{
+#if APR_HAS_THREADS
+  if (state->mutex)
+    return apr_thread_mutex_lock(state->mutex);
+#endif
+
+  return APR_SUCCESS;
+}
+
+/* Unlock STATE and return the APR status. */
+static apr_status_t
+unlock_state(shared_state_t *state)
+{
+#if APR_HAS_THREADS
+  if (state->mutex)
+    return apr_thread_mutex_unlock(state->mutex);
+#endif
+
+  return APR_SUCCESS;
+}
+
+/* Like lock_state() but to be used by the owner of STATE. */
+static svn_error_t *
+lock_owner(shared_state_t *state)
+{
+  apr_status_t status = lock_state(state);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock task set"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like unlock_state() but to be used by the owner of STATE.  Return ERR,
+ * if any, in preference to a failure to unlock. */
+static svn_error_t *
+unlock_owner(shared_state_t *state,
+             svn_error_t *err)
+{
+  apr_status_t status = unlock_state(state);
+  if (status && !err)
+    return svn_error_wrap_apr(status, _("Can't unlock task set"));
+
+  return err;
+}
+
+/* Return an error if some worker thread of STATE could not lock it. */
+static svn_error_t *
+check_workers(shared_state_t *state)
+{
+  apr_status_t status = (apr_status_t)svn_atomic_read(&state->worker_failure);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't lock task set in worker thread"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait, with STATE being locked by the owner, until some task is done.
+ * Only to be called while some task is running on a worker thread.
+ * Return an error if the workers failed or, when CHECK_CANCEL is set,
+ * the user cancelled the operation.  STATE remains locked in any case. */
+static svn_error_t *
+wait_for_state(shared_state_t *state,
+               svn_boolean_t check_cancel)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_timedwait(state->cond, state->mutex,
+                                                  WAIT_INTERVAL);
+  if (status && !APR_STATUS_IS_TIMEUP(status))
+    return svn_error_wrap_apr(status, _("Can't wait for tasks"));
+
+  SVN_ERR(check_workers(state));
+  if (check_cancel && state->cancel_func)
+    SVN_ERR(state->cancel_func(state->cancel_baton));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Drop one reference to STATE, which must be locked, and unlock it.
+ * Destroy it if that was the last reference. */
+static void
+release_state(shared_state_t *state)
+{
+  svn_boolean_t last = (--state->refs == 0);
+
+  unlock_state(state);
+  if (last)
+    svn_pool_destroy(state->pool);
+}
+
+/* Implements svn_cancel_func_t for the shared_state_t in BATON. */
+static svn_error_t *
+cancel_task(void *baton)
+{
+  shared_state_t *state = baton;
+
+  if (svn_atomic_read(&state->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  if (state->cancel_func)
+    return svn_error_trace(state->cancel_func(state->cancel_baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Take the next queued task from STATE, which must be locked and must
+ * have one, and mark it as running. */
+static task_t *
+start_next_task(shared_state_t *state)
+{
+  task_t *task = state->next_to_run;
+
+  state->next_to_run = task->next;
+  task->state = task_running;
+  state->running++;
+
+  return task;
+}
+
+/* Process TASK of STATE.  STATE must not be locked. */
+static void
+process_task(task_t *task,
+             shared_state_t *state)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(task->pool);
+
+  task->err = cancel_task(state);
+  if (!task->err)
+    task->err = task->process_func(&task->result, task->process_baton,
+                                   cancel_task, state, task->pool,
+                                   scratch_pool);
+
+  svn_pool_destroy(scratch_pool);
+}
+
+/* Mark TASK of STATE, which must be locked, as done. */
+static void
+complete_task(task_t *task,
+              shared_state_t *state)
+{
+  task->state = task_done;
+  state->running--;
+
+#if APR_HAS_THREADS
+  if (state->cond)
+    apr_thread_cond_broadcast(state->cond);
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* Record the failure STATUS of a worker thread to lock STATE.  The owner
+ * will report it instead of waiting for the worker forever. */
+static void
+worker_failed(shared_state_t *state,
+              apr_status_t status)
+{
+  svn_atomic_set(&state->worker_failure, (svn_atomic_t)status);
+
+  /* Wake up the owner.  This is legal without holding the mutex. */
+  apr_thread_cond_broadcast(state->cond);
+}
+
+/* Thread-pool job: Process tasks of the shared_state_t in DATA until
+ * there are no more queued ones.
+ *
+ * If locking the state fails, we can't safely touch it anymore.  We then
+ * leave it to the owner to report the failure and leak the state. */
+static void * APR_THREAD_FUNC
+worker_func(apr_thread_t *tid,
+            void *data)
+{
+  shared_state_t *state = data;
+  apr_status_t status;
+
+  status = lock_state(state);
+  if (status)
+    {
+      worker_failed(state, status);
+      return NULL;
+    }
+
+  while (state->next_to_run)
+    {
+      task_t *task = start_next_task(state);
+
+      unlock_state(state);
+      process_task(task, state);
+      status = lock_state(state);
+      if (status)
+        {
+          worker_failed(state, status);
+          return NULL;
+        }
+
+      complete_task(task, state);
+    }
+
+  state->workers--;
+  release_state(state);
+
+  return NULL;
+}
+
+#endif
+
+/* Pass the result of TASK, which has already been removed from SET, to
+ * the output function and release TASK.  Cancel the whole SET upon
+ * error. */
+static svn_error_t *
+deliver_task(svn_task__set_t *set,
+             task_t *task)
+{
+  svn_error_t *err = task->err;
+
+  if (!err && set->output_func)
+    err = set->output_func(task->result, set->output_baton, task->pool);
+
+  svn_pool_destroy(task->pool);
+  if (err)
+    svn_atomic_set(&set->state->cancelled, TRUE);
+
+  return svn_error_trace(err);
+}
+
+/* Deliver the results of SET in order, as long as they are available or
+ * more than MAX_PENDING tasks have not been delivered, yet.  While
+ * waiting, process queued tasks in this thread. */
+static svn_error_t *
+deliver_results(svn_task__set_t *set,
+                int max_pending)
+{
+  shared_state_t *state = set->state;
+
+  while (state->first)
+    {
+      task_t *task = state->first;
+
+      SVN_ERR(lock_owner(state));
+      while (task->state != task_done)
+        {
+          svn_error_t *err;
+
+          if (set->pending <= max_pending)
+            return svn_error_trace(unlock_owner(state, SVN_NO_ERROR));
+
+          if (state->next_to_run)
+            {
+              /* Rather than sitting idle, help with the processing. */
+              task_t *own_task = start_next_task(state);
+
+              SVN_ERR(unlock_owner(state, SVN_NO_ERROR));
+              process_task(own_task, state);
+              SVN_ERR(lock_owner(state));
+
+              complete_task(own_task, state);
+            }
+          else
+            {
+              err = wait_for_state(state, TRUE);
+              if (err)
+                {
+                  svn_atomic_set(&state->cancelled, TRUE);
+                  return svn_error_trace(unlock_owner(state, err));
+                }
+            }
+        }
+
+      state->first = task->next;
+      if (state->first == NULL)
+        state->last = NULL;
+
+      SVN_ERR(unlock_owner(state, SVN_NO_ERROR));
+
+      set->pending--;
+      SVN_ERR(deliver_task(set, task));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function for the svn_task__set_t in DATA.  Cancel all
+ * queued tasks and wait for the running ones.  If the workers failed,
+ * the tasks may still be in use and we have to leak them. */
+static apr_status_t
+cleanup_set(void *data)
+{
+  svn_task__set_t *set = data;
+  shared_state_t *state = set->state;
+  task_t *task;
+  apr_status_t status;
+
+  svn_atomic_set(&state->cancelled, TRUE);
+  status = lock_state(state);
+  if (status)
+    return status;
+
+  state->next_to_run = NULL;
+  while (state->running > 0)
+    {
+      svn_error_t *err = wait_for_state(state, FALSE);
+      if (err)
+        {
+          status = err->apr_err;
+          svn_error_clear(err);
+          unlock_state(state);
+          return status;
+        }
+    }
+
+  task = state->first;
+  state->first = NULL;
+  state->last = NULL;
+
+  release_state(state);
+
+  while (task)
+    {
+      task_t *next = task->next;
+
+      svn_error_clear(task->err);
+      svn_pool_destroy(task->pool);
+      task = next;
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_task__set_create(svn_task__set_t **set,
+                     int max_threads,
+                     svn_task__output_func_t output_func,
+                     void *output_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool)
+{
+  apr_pool_t *state_pool = svn_pool_create(NULL);
+  shared_state_t *state = apr_pcalloc(state_pool, sizeof(*state));
+  svn_task__set_t *new_set = apr_pcalloc(result_pool, sizeof(*new_set));
+  int limit = svn_task__get_thread_limit();
+
+  state->pool = state_pool;
+  state->refs = 1;
+  state->cancel_func = cancel_func;
+  state->cancel_baton = cancel_baton;
+
+#if APR_HAS_THREADS
+  if (limit > 0)
+    {
+      apr_status_t status;
+
+      SVN_ERR(svn_atomic__init_once(&worker_pool_init_state,
+                                    init_worker_pool, NULL, result_pool));
+
+      status = apr_thread_mutex_create(&state->mutex,
+                                       APR_THREAD_MUTEX_DEFAULT,
+                                       state_pool);
+      if (!status)
+        status = apr_thread_cond_create(&state->cond, state_pool);
+      if (status)
+        {
+          svn_pool_destroy(state_pool);
+          return svn_error_wrap_apr(status, _("Can't create task set"));
+        }
+    }
+#endif
+
+  new_set->state = state;
+  new_set->max_workers = (max_threads > 0 && max_threads < limit)
+                       ? max_threads
+                       : limit;
+  new_set->max_pending = RESULTS_PER_THREAD * new_set->max_workers;
+  new_set->output_func = output_func;
+  new_set->output_baton = output_baton;
+
+  apr_pool_cleanup_register(result_pool, new_set, cleanup_set,
+                            apr_pool_cleanup_null);
+
+  *set = new_set;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__add(svn_task__set_t *set,
+              svn_task__process_func_t process_func,
+              void *process_baton)
+{
+  shared_state_t *state = set->state;
+  apr_pool_t *pool;
+  task_t *task;
+  svn_boolean_t add_worker;
+  svn_error_t *err;
+
+  SVN_ERR(cancel_task(state));
+  SVN_ERR(check_workers(state));
+
+  pool = svn_pool_create(NULL);
+  task = apr_pcalloc(pool, sizeof(*task));
+  task->pool = pool;
+  task->process_func = process_func;
+  task->process_baton = process_baton;
+  task->state = task_queued;
+
+  err = lock_owner(state);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  if (state->last)
+    state->last->next = task;
+  else
+    state->first = task;
+  state->last = task;
+
+  if (state->next_to_run == NULL)
+    state->next_to_run = task;
+
+  add_worker = state->workers < set->max_workers;
+  if (add_worker)
+    {
+      state->workers++;
+      state->refs++;
+    }
+
+  set->pending++;
+  SVN_ERR(unlock_owner(state, SVN_NO_ERROR));
+
+#if APR_HAS_THREADS
+  if (add_worker)
+    {
+      apr_status_t status = apr_thread_pool_push(worker_pool, worker_func,
+                                                 state, 0, NULL);
+      if (status)
+        {
+          /* The task will still be processed by this thread. */
+          SVN_ERR(lock_owner(state));
+          state->workers--;
+          state->refs--;
+          SVN_ERR(unlock_owner(state, SVN_NO_ERROR));
+        }
+    }
+#endif
+
+  return svn_error_trace(deliver_results(set, set->max_pending));
+}
+
+svn_error_t *
+svn_task__set_finish(svn_task__set_t *set)
+{
+  return svn_error_trace(deliver_results(set, 0));
+}
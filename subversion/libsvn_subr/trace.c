@@ -0,0 +1,337 @@
+/*
+ * trace.c:  lightweight tracing of nested operations
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <apr_file_io.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "svn_io.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_trace.h"
+
+#include "svn_private_config.h"
+
+#ifndef SVN_DISABLE_TRACING
+
+/* Space for the JSON-formatted attributes of a single span. */
+#define SPAN_ARGS_SIZE 512
+
+struct svn_trace__span_t
+{
+  /* Name as passed to svn_trace__begin(). */
+  const char *name;
+
+  /* When the span started. */
+  apr_time_t start;
+
+  /* Attributes as members of a JSON object but without the braces.
+   * ARGS_LEN is the number of bytes used in ARGS. */
+  char args[SPAN_ARGS_SIZE];
+  apr_size_t args_len;
+};
+
+/* Non-zero while spans get recorded. */
+static volatile svn_atomic_t trace_enabled = FALSE;
+
+/* The file that we append the spans to and the mutex serializing the
+ * writes.  Only valid while TRACE_ENABLED is set. */
+static apr_file_t *trace_file = NULL;
+static svn_mutex__t *trace_mutex = NULL;
+
+/* Pool cleanup function that ends tracing. */
+static apr_status_t
+disable_tracing(void *baton)
+{
+  svn_atomic_set(&trace_enabled, FALSE);
+  trace_file = NULL;
+  trace_mutex = NULL;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_trace__init(const char *path,
+                apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+
+  if (svn_atomic_read(&trace_enabled))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__init(&trace_mutex, TRUE, pool));
+  SVN_ERR(svn_io_file_open(&trace_file, path,
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+
+  /* Start the JSON array of events in new files.  Viewers accept the
+   * trailing comma after the last event and the missing closing
+   * bracket, so we never need to rewrite the file. */
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, trace_file, pool));
+  if (finfo.size == 0)
+    SVN_ERR(svn_io_file_write_full(trace_file, "[\n", 2, NULL, pool));
+
+  apr_pool_cleanup_register(pool, NULL, disable_tracing,
+                            apr_pool_cleanup_null);
+  svn_atomic_set(&trace_enabled, TRUE);
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_trace__enabled(void)
+{
+  return svn_atomic_read(&trace_enabled) != FALSE;
+}
+
+svn_trace__span_t *
+svn_trace__begin(const char *name)
+{
+  svn_trace__span_t *span;
+
+  if (!svn_atomic_read(&trace_enabled))
+    return NULL;
+
+  span = malloc(sizeof(*span));
+  if (span)
+    {
+      span->name = name;
+      span->args_len = 0;
+      span->start = apr_time_now();
+    }
+
+  return span;
+}
+
+/* Append LEN bytes at DATA to the attributes of SPAN, if they fit. */
+static void
+append_args(svn_trace__span_t *span,
+            const char *data,
+            apr_size_t len)
+{
+  if (len < sizeof(span->args) - span->args_len)
+    {
+      memcpy(span->args + span->args_len, data, len);
+      span->args_len += len;
+    }
+}
+
+/* Write STR as a JSON string literal, including the quotes, to BUFFER
+ * of size SIZE.  Return the number of bytes written or SIZE if STR does
+ * not fit. */
+static apr_size_t
+format_json_string(char *buffer,
+                   apr_size_t size,
+                   const char *str)
+{
+  apr_size_t len = 0;
+
+  if (size < 2)
+    return size;
+
+  buffer[len++] = '"';
+  for (; *str; ++str)
+    {
+      unsigned char c = *str;
+
+      /* Leave room for the longest escape sequence and the quote. */
+      if (len + 7 >= size)
+        return size;
+
+      if (c == '"' || c == '\\')
+        {
+          buffer[len++] = '\\';
+          buffer[len++] = c;
+        }
+      else if (c < 0x20)
+        {
+          len += apr_snprintf(buffer + len, size - len, "\\u%04x", c);
+        }
+      else
+        {
+          buffer[len++] = c;
+        }
+    }
+
+  buffer[len++] = '"';
+  return len;
+}
+
+/* Add the attribute KEY to SPAN.  VALUE is already formatted as JSON. */
+static void
+add_attr(svn_trace__span_t *span,
+         const char *key,
+         const char *value)
+{
+  char buffer[SPAN_ARGS_SIZE];
+  apr_size_t len = 0;
+
+  if (span->args_len)
+    buffer[len++] = ',';
+
+  len += format_json_string(buffer + len, sizeof(buffer) - len, key);
+  if (len + strlen(value) + 1 >= sizeof(buffer))
+    return;
+
+  buffer[len++] = ':';
+  memcpy(buffer + len, value, strlen(value));
+  len += strlen(value);
+
+  append_args(span, buffer, len);
+}
+
+void
+svn_trace__attr(svn_trace__span_t *span,
+                const char *key,
+                const char *value)
+{
+  char buffer[SPAN_ARGS_SIZE];
+  apr_size_t len;
+
+  if (!span)
+    return;
+
+  len = format_json_string(buffer, sizeof(buffer) - 1, value ? value : "");
+  if (len < sizeof(buffer) - 1)
+    {
+      buffer[len] = '\0';
+      add_attr(span, key, buffer);
+    }
+}
+
+void
+svn_trace__attr_int(svn_trace__span_t *span,
+                    const char *key,
+                    apr_int64_t value)
+{
+  char buffer[32];
+
+  if (!span)
+    return;
+
+  apr_snprintf(buffer, sizeof(buffer), "%" APR_INT64_T_FMT, value);
+  add_attr(span, key, buffer);
+}
+
+/* Return an ID for the current process. */
+static long
+current_process_id(void)
+{
+#ifdef WIN32
+  return (long)GetCurrentProcessId();
+#else
+  return (long)getpid();
+#endif
+}
+
+/* Return an ID for the current thread. */
+static unsigned long
+current_thread_id(void)
+{
+#if APR_HAS_THREADS
+  return (unsigned long)apr_os_thread_current();
+#else
+  return 0;
+#endif
+}
+
+/* Write LINE with LEN bytes to the trace file. */
+static svn_error_t *
+write_line(const char *line,
+           apr_size_t len)
+{
+  /* Tracing may have been disabled since we checked. */
+  if (trace_file)
+    SVN_ERR(svn_io_file_write_full(trace_file, line, len, NULL, NULL));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_trace__end(svn_trace__span_t *span,
+               svn_error_t *err)
+{
+  char line[SPAN_ARGS_SIZE + 256];
+  char name[128];
+  apr_size_t name_len;
+  apr_time_t end;
+  int len;
+
+  if (!span)
+    return err;
+
+  end = apr_time_now();
+  if (err)
+    svn_trace__attr_int(span, "error", err->apr_err);
+
+  name_len = format_json_string(name, sizeof(name) - 1, span->name);
+  if (name_len >= sizeof(name) - 1)
+    name_len = format_json_string(name, sizeof(name) - 1, "?");
+  name[name_len] = '\0';
+
+  /* A "complete" event covering the whole span.  Events on the same
+   * thread nest according to their time ranges. */
+  len = apr_snprintf(line, sizeof(line),
+                     "{\"name\":%s,\"ph\":\"X\",\"ts\":%" APR_TIME_T_FMT
+                     ",\"dur\":%" APR_TIME_T_FMT ",\"pid\":%ld,"
+                     "\"tid\":%lu,\"args\":{%.*s}},\n",
+                     name, span->start, end - span->start,
+                     current_process_id(), current_thread_id(),
+                     (int)span->args_len, span->args);
+  free(span);
+
+  /* Failures to write the trace must not affect the traced operation. */
+  if (svn_atomic_read(&trace_enabled) && len > 0)
+    {
+      svn_mutex__t *mutex = trace_mutex;
+      svn_error_clear(svn_mutex__lock(mutex));
+      svn_error_clear(svn_mutex__unlock(mutex,
+                                        write_line(line, (apr_size_t)len)));
+    }
+
+  return err;
+}
+
+#else
+
+svn_error_t *
+svn_trace__init(const char *path,
+                apr_pool_t *pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Tracing support has been disabled at "
+                            "compile time"));
+}
+
+#endif
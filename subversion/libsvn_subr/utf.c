@@ -768,6 +768,81 @@ convert_cstring(const char **dest,
 }
 
 
+/* Whether plain ASCII, as defined by svn_utf__is_plain_ascii(), reads
+ * the same in UTF-8 and in the native encoding.  0 means "not checked yet",
+ * 1 means "yes" and -1 means "no".  Racing threads will simply come to the
+ * same conclusion. */
+static volatile int plain_ascii_is_native = 0;
+
+/* Convert all plain ASCII chars from UTF-8 to native and back to see
+ * whether the default translators leave them untouched.  Without a
+ * translator, plain ASCII gets copied verbatim.
+ *
+ * Return the result of that test and cache it in plain_ascii_is_native.
+ * Use POOL for temporary allocations. */
+static svn_boolean_t
+is_plain_ascii_native(apr_pool_t *pool)
+{
+  xlate_handle_node_t *node;
+  svn_stringbuf_t *native;
+  svn_stringbuf_t *utf8;
+  svn_stringbuf_t *ascii;
+  svn_error_t *err;
+  char c;
+
+  if (plain_ascii_is_native)
+    return plain_ascii_is_native > 0;
+
+  ascii = svn_stringbuf_create("\t\n\v\f\r", pool);
+  for (c = ' '; c < 0x7f; ++c)
+    svn_stringbuf_appendbyte(ascii, c);
+
+  native = ascii;
+  err = get_uton_xlate_handle_node(&node, pool);
+  if (!err)
+    {
+      if (node->handle)
+        err = convert_to_stringbuf(node, ascii->data, ascii->len, &native,
+                                   pool);
+      err = svn_error_compose_create(
+              err,
+              put_xlate_handle_node(node, SVN_UTF_UTON_XLATE_HANDLE, pool));
+    }
+
+  utf8 = native;
+  if (!err)
+    {
+      err = get_ntou_xlate_handle_node(&node, pool);
+      if (!err)
+        {
+          if (node->handle)
+            err = convert_to_stringbuf(node, native->data, native->len,
+                                       &utf8, pool);
+          err = svn_error_compose_create(
+                  err,
+                  put_xlate_handle_node(node, SVN_UTF_NTOU_XLATE_HANDLE,
+                                        pool));
+        }
+    }
+
+  /* If we can't even translate plain ASCII, don't take shortcuts.
+   * The regular code path will report the problem. */
+  if (err)
+    {
+      svn_error_clear(err);
+      plain_ascii_is_native = -1;
+    }
+  else
+    {
+      plain_ascii_is_native = (svn_stringbuf_compare(ascii, native)
+                               && svn_stringbuf_compare(ascii, utf8))
+                            ? 1
+                            : -1;
+    }
+
+  return plain_ascii_is_native > 0;
+}
+
 svn_error_t *
 svn_utf_cstring_to_utf8(const char **dest,
                         const char *src,
@@ -775,6 +850,14 @@ svn_utf_cstring_to_utf8(const char **dest,
 {
   xlate_handle_node_t *node;
   svn_error_t *err;
+  apr_size_t len = strlen(src);
+
+  /* Most paths are plain ASCII.  Don't bother with translators then. */
+  if (svn_utf__is_plain_ascii(src, len) && is_plain_ascii_native(pool))
+    {
+      *dest = apr_pstrmemdup(pool, src, len);
+      return SVN_NO_ERROR;
+    }
 
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
   err = convert_cstring(dest, src, node, pool);
@@ -899,6 +982,14 @@ svn_utf_cstring_from_utf8(const char **dest,
 {
   xlate_handle_node_t *node;
   svn_error_t *err;
+  apr_size_t len = strlen(src);
+
+  /* Plain ASCII is valid UTF-8 and usually needs no translation. */
+  if (svn_utf__is_plain_ascii(src, len) && is_plain_ascii_native(pool))
+    {
+      *dest = apr_pstrmemdup(pool, src, len);
+      return SVN_NO_ERROR;
+    }
 
   SVN_ERR(check_cstring_utf8(src, pool));
 
@@ -25,6 +25,7 @@
 
 #include <apr_fnmatch.h>
 
+#include "svn_ctype.h"
 #include "private/svn_string_private.h"
 #include "private/svn_utf_private.h"
 #include "svn_private_config.h"
@@ -66,6 +67,17 @@ svn_utf__utf8proc_runtime_version(void)
 
 
 
+/* Return TRUE if the first LENGTH bytes of STRING are all 7 bit ASCII.
+ * Such strings are invariant under canonical decomposition, composition
+ * and diacritical mark stripping, i.e. they are NFC and NFD at the same
+ * time.  Only case folding may change them.
+ */
+static APR_INLINE svn_boolean_t
+is_ascii(const char *string, apr_size_t length)
+{
+  return svn_utf__first_non_ascii(string, length) == string + length;
+}
+
 /* Fill the given BUFFER with decomposed UCS-4 representation of the
  * UTF-8 STRING. If LENGTH is SVN_UTF__UNKNOWN_LENGTH, assume STRING
  * is NUL-terminated; otherwise look only at the first LENGTH bytes in
@@ -116,7 +128,26 @@ decompose_normalized(apr_size_t *result_length,
                      const char *string, apr_size_t length,
                      svn_membuf_t *buffer)
 {
-  ssize_t result = unicode_decomposition(0, string, length, buffer);
+  ssize_t result;
+
+  if (length == SVN_UTF__UNKNOWN_LENGTH)
+    length = strlen(string);
+
+  if (is_ascii(string, length))
+    {
+      apr_int32_t *ucs4buf;
+      apr_size_t i;
+
+      svn_membuf__ensure(buffer, length * sizeof(*ucs4buf));
+      ucs4buf = buffer->data;
+      for (i = 0; i < length; ++i)
+        ucs4buf[i] = (unsigned char)string[i];
+
+      *result_length = length;
+      return SVN_NO_ERROR;
+    }
+
+  result = unicode_decomposition(0, string, length, buffer);
   if (result < 0)
     return svn_error_create(SVN_ERR_UTF8PROC_ERROR, NULL,
                             gettext(utf8proc_errmsg(result)));
@@ -147,6 +178,29 @@ normalize_cstring(apr_size_t *result_length,
   int flags = 0;
   ssize_t result;
 
+  if (length == SVN_UTF__UNKNOWN_LENGTH)
+    length = strlen(string);
+
+  if (is_ascii(string, length))
+    {
+      char *data;
+
+      svn_membuf__ensure(buffer, length + 1);
+      data = buffer->data;
+      if (casefold)
+        {
+          apr_size_t i;
+          for (i = 0; i < length; ++i)
+            data[i] = (char)svn_ctype_tolower(string[i]);
+        }
+      else
+        memcpy(data, string, length);
+
+      data[length] = '\0';
+      *result_length = length;
+      return SVN_NO_ERROR;
+    }
+
   if (casefold)
     flags |= UTF8PROC_CASEFOLD;
 
@@ -197,6 +251,8 @@ svn_utf__normcmp(int *result,
 {
   apr_size_t buflen1;
   apr_size_t buflen2;
+  apr_size_t i;
+  apr_size_t split;
 
   /* Shortcut-circuit the decision if at least one of the strings is empty. */
   const svn_boolean_t empty1 =
@@ -209,8 +265,36 @@ svn_utf__normcmp(int *result,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(decompose_normalized(&buflen1, str1, len1, buf1));
-  SVN_ERR(decompose_normalized(&buflen2, str2, len2, buf2));
+  if (len1 == SVN_UTF__UNKNOWN_LENGTH)
+    len1 = strlen(str1);
+  if (len2 == SVN_UTF__UNKNOWN_LENGTH)
+    len2 = strlen(str2);
+
+  /* ASCII chars decompose to themselves and never combine with what
+   * precedes them.  So, the normalized forms of both strings share the
+   * normalized form of their common prefix up to any ASCII char within
+   * it.  Find the common prefix and remember the last such SPLIT point. */
+  split = 0;
+  for (i = 0; i < len1 && i < len2 && str1[i] == str2[i]; ++i)
+    if ((unsigned char)str1[i] < 0x80)
+      split = i;
+
+  /* If the first difference is between two ASCII chars or the end of
+   * a string, it decides the comparison. */
+  if (   (i == len1 || (unsigned char)str1[i] < 0x80)
+      && (i == len2 || (unsigned char)str2[i] < 0x80))
+    {
+      if (i == len1 || i == len2)
+        *result = (len1 == len2 ? 0 : (i == len1 ? -1 : 1));
+      else
+        *result = (unsigned char)str1[i] - (unsigned char)str2[i];
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Otherwise, normalize the remainders only. */
+  SVN_ERR(decompose_normalized(&buflen1, str1 + split, len1 - split, buf1));
+  SVN_ERR(decompose_normalized(&buflen2, str2 + split, len2 - split, buf2));
   *result = ucs4cmp(buf1->data, buflen1, buf2->data, buflen2);
   return SVN_NO_ERROR;
 }
@@ -406,9 +490,22 @@ svn_utf__glob(svn_boolean_t *match,
     }
 
   /* Now normalize the string */
-  SVN_ERR(decompose_normalized(&tempbuf_len, string, string_len, temp_buf));
-  SVN_ERR(svn_utf__encode_ucs4_string(string_buf, temp_buf->data,
-                                      tempbuf_len, &tempbuf_len));
+  if (string_len == SVN_UTF__UNKNOWN_LENGTH)
+    string_len = strlen(string);
+
+  if (is_ascii(string, string_len))
+    {
+      svn_membuf__ensure(string_buf, string_len + 1);
+      memcpy(string_buf->data, string, string_len);
+      ((char*)string_buf->data)[string_len] = '\0';
+    }
+  else
+    {
+      SVN_ERR(decompose_normalized(&tempbuf_len, string, string_len,
+                                   temp_buf));
+      SVN_ERR(svn_utf__encode_ucs4_string(string_buf, temp_buf->data,
+                                          tempbuf_len, &tempbuf_len));
+    }
 
   *match = !apr_fnmatch(pattern_buf->data, string_buf->data, 0);
   return SVN_NO_ERROR;
@@ -421,6 +518,10 @@ svn_utf__is_normalized(const char *string, apr_pool_t *scratch_pool)
   svn_membuf_t buffer;
   apr_size_t result_length;
   const apr_size_t length = strlen(string);
+
+  if (is_ascii(string, length))
+    return TRUE;
+
   svn_membuf__create(&buffer, length * sizeof(apr_int32_t), scratch_pool);
   err = normalize_cstring(&result_length, string, length,
                           FALSE, FALSE, &buffer);
@@ -60,6 +60,15 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* Like in eol.c, use 16 byte vectors where the base ABI guarantees them. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SVN_UTF_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SVN_UTF_SCAN_NEON 1
+#endif
+
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00-0x7f */
@@ -258,6 +267,26 @@ static const char machine [9][14] = {
 static const char *
 first_non_fsm_start_char(const char *data, apr_size_t max_len)
 {
+#if defined(SVN_UTF_SCAN_SSE2)
+
+  /* The MSB of each byte is all we need to check. */
+  for (; max_len >= 16; data += 16, max_len -= 16)
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)data)))
+      break;
+
+#elif defined(SVN_UTF_SCAN_NEON)
+
+  for (; max_len >= 16; data += 16, max_len -= 16)
+    {
+      uint64x2_t chunk = vreinterpretq_u64_u8(vld1q_u8((const uint8_t *)data));
+
+      if ((vgetq_lane_u64(chunk, 0) | vgetq_lane_u64(chunk, 1))
+          & APR_UINT64_C(0x8080808080808080))
+        break;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -320,10 +349,83 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+
+      /* Non-ASCII chars often come alone, e.g. in paths.  Skip any
+       * ASCII that follows them in bulk again. */
+      if (state == FSM_START)
+        data = first_non_fsm_start_char(data, end - data);
+      else if (state == FSM_ERROR)
+        return FALSE;
     }
   return state == FSM_START;
 }
 
+const char *
+svn_utf__first_non_ascii(const char *data, apr_size_t len)
+{
+  return first_non_fsm_start_char(data, len);
+}
+
+svn_boolean_t
+svn_utf__is_plain_ascii(const char *data, apr_size_t len)
+{
+#if defined(SVN_UTF_SCAN_SSE2)
+  {
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i tab_minus_1 = _mm_set1_epi8(0x08);
+    const __m128i cr_plus_1 = _mm_set1_epi8(0x0e);
+    const __m128i del = _mm_set1_epi8(0x7f);
+
+    for (; len >= 16; data += 16, len -= 16)
+      {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+
+        /* Signed compares also flag all bytes >= 0x80 as "below space". */
+        __m128i below_space = _mm_cmplt_epi8(chunk, space);
+        __m128i whitespace = _mm_and_si128(_mm_cmpgt_epi8(chunk, tab_minus_1),
+                                           _mm_cmplt_epi8(chunk, cr_plus_1));
+        __m128i bad = _mm_or_si128(_mm_andnot_si128(whitespace, below_space),
+                                   _mm_cmpeq_epi8(chunk, del));
+
+        if (_mm_movemask_epi8(bad))
+          return FALSE;
+      }
+  }
+#elif defined(SVN_UTF_SCAN_NEON)
+  {
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t tab = vdupq_n_u8(0x09);
+    const uint8x16_t whitespace_count = vdupq_n_u8(0x0d - 0x09 + 1);
+    const uint8x16_t del = vdupq_n_u8(0x7f);
+
+    for (; len >= 16; data += 16, len -= 16)
+      {
+        uint8x16_t chunk = vld1q_u8((const uint8_t *)data);
+
+        /* Unsigned compares: C >= 0x7f covers DEL and all non-ASCII. */
+        uint8x16_t whitespace = vcltq_u8(vsubq_u8(chunk, tab),
+                                         whitespace_count);
+        uint64x2_t bad = vreinterpretq_u64_u8(
+                           vorrq_u8(vbicq_u8(vcltq_u8(chunk, space),
+                                             whitespace),
+                                    vcgeq_u8(chunk, del)));
+
+        if (vgetq_lane_u64(bad, 0) | vgetq_lane_u64(bad, 1))
+          return FALSE;
+      }
+  }
+#endif
+
+  for (; len > 0; ++data, --len)
+    {
+      unsigned char c = *data;
+      if (c >= 0x7f || (c < 0x20 && (c < 0x09 || c > 0x0d)))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 const char *
 svn_utf__last_valid2(const char *data, apr_size_t len)
 {
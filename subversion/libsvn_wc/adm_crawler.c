@@ -39,6 +39,7 @@
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "wc.h"
@@ -1051,6 +1052,40 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
   return SVN_NO_ERROR;
 }
 
+/* Return the error for the text base of LOCAL_ABSPATH having the MD5
+ * checksum ACTUAL_MD5 instead of the recorded EXPECTED_MD5, wrapping ERR,
+ * which may be SVN_NO_ERROR.
+ */
+static svn_error_t *
+corrupt_text_base_error(const svn_checksum_t *expected_md5,
+                        const svn_checksum_t *actual_md5,
+                        const char *local_abspath,
+                        svn_error_t *err,
+                        apr_pool_t *scratch_pool)
+{
+  /* The entry checksum does not match the actual text
+     base checksum.  Extreme badness. Of course,
+     theoretically we could just switch to
+     fulltext transmission here, and everything would
+     work fine; after all, we're going to replace the
+     text base with a new one in a moment anyway, and
+     we'd fix the checksum then.  But it's better to
+     error out.  People should know that their text
+     bases are getting corrupted, so they can
+     investigate.  Other commands could be affected,
+     too, such as `svn diff'.  */
+
+  err = svn_error_compose_create(
+          svn_checksum_mismatch_err(expected_md5, actual_md5,
+                        scratch_pool,
+                        _("Checksum mismatch for text base of '%s'"),
+                        svn_dirent_local_style(local_abspath,
+                                               scratch_pool)),
+          err);
+
+  return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, err, NULL);
+}
+
 svn_error_t *
 svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
                                       const svn_checksum_t **new_text_base_md5_checksum,
@@ -1175,29 +1210,10 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
      so check the checksum. */
   if (expected_md5_checksum && verify_checksum
       && !svn_checksum_match(expected_md5_checksum, verify_checksum))
-    {
-      /* The entry checksum does not match the actual text
-         base checksum.  Extreme badness. Of course,
-         theoretically we could just switch to
-         fulltext transmission here, and everything would
-         work fine; after all, we're going to replace the
-         text base with a new one in a moment anyway, and
-         we'd fix the checksum then.  But it's better to
-         error out.  People should know that their text
-         bases are getting corrupted, so they can
-         investigate.  Other commands could be affected,
-         too, such as `svn diff'.  */
-
-      err = svn_error_compose_create(
-              svn_checksum_mismatch_err(expected_md5_checksum, verify_checksum,
-                            scratch_pool,
-                            _("Checksum mismatch for text base of '%s'"),
-                            svn_dirent_local_style(local_abspath,
-                                                   scratch_pool)),
-              err);
-
-      return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, err, NULL);
-    }
+    return svn_error_trace(corrupt_text_base_error(expected_md5_checksum,
+                                                   verify_checksum,
+                                                   local_abspath, err,
+                                                   scratch_pool));
 
   /* Now, handle that delta transmission error if any, so we can stop
      thinking about it after this point. */
@@ -1247,6 +1263,496 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                                scratch_pool);
 }
 
+
+/* One file queued in a svn_wc__text_deltas_t. */
+typedef struct queued_text_t
+{
+  const char *local_abspath;
+  svn_boolean_t fulltext;
+
+  /* The preparation of its delta, or NULL if not started. */
+  struct text_delta_job_t *job;
+} queued_text_t;
+
+struct svn_wc__text_deltas_t
+{
+  svn_wc__db_t *db;
+
+  /* Queued files as queued_text_t, and the indexes of the next file to
+     transmit and of the next file whose delta is to be prepared. */
+  apr_array_header_t *queue;
+  int next_transmit;
+  int next_start;
+
+  /* Prepare the deltas of at most this many files ahead of their
+     transmission.  0 disables the pipeline. */
+  int max_ahead;
+
+  /* Runs text_delta_task() for the jobs. */
+  svn_task__set_t *set;
+};
+
+/* The delta of one file, computed by a task and spooled to a temporary
+   file in svndiff format until the file gets transmitted. */
+typedef struct text_delta_job_t
+{
+  /* Private pool of this job.  It is a root pool because the task
+     allocates in it as well.  All members below are allocated in it. */
+  apr_pool_t *pool;
+
+  const char *local_abspath;
+
+  /* The delta source and target, opened by the main thread.  The target
+     also installs the new pristine text. */
+  svn_stream_t *base_stream;
+  svn_stream_t *local_stream;
+  svn_wc__db_install_data_t *install_data;
+
+  /* Recorded MD5 of the delta source, NULL for full texts. */
+  const svn_checksum_t *expected_md5;
+
+  /* The svndiff data and the number of windows in it. */
+  apr_file_t *spool;
+  int windows;
+
+  /* Set when the streams get closed by the task. */
+  svn_checksum_t *verify_md5;
+  svn_checksum_t *local_md5;
+  svn_checksum_t *local_sha1;
+
+  /* The result, valid once DONE has been set. */
+  svn_error_t *err;
+  svn_boolean_t done;
+} text_delta_job_t;
+
+/* Open the streams of a new job for QT in DELTAS->DB and spool file.
+   This is the part that needs the working copy database, so it runs on
+   the main thread.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prepare_text_delta(text_delta_job_t **job_p,
+                   svn_wc__text_deltas_t *deltas,
+                   const queued_text_t *qt,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  text_delta_job_t *job = apr_pcalloc(pool, sizeof(*job));
+  svn_stream_t *install_stream;
+  const char *tmpdir_abspath;
+  svn_error_t *err;
+
+  job->pool = pool;
+  job->local_abspath = apr_pstrdup(pool, qt->local_abspath);
+
+  /* Set up the streams like svn_wc__internal_transmit_text_deltas(). */
+  err = svn_wc__internal_translated_stream(&job->local_stream, deltas->db,
+                                           qt->local_abspath,
+                                           qt->local_abspath,
+                                           SVN_WC_TRANSLATE_TO_NF,
+                                           pool, scratch_pool);
+  if (!err)
+    err = svn_wc__db_pristine_prepare_install(&install_stream,
+                                              &job->install_data,
+                                              &job->local_sha1, NULL,
+                                              deltas->db, qt->local_abspath,
+                                              pool, scratch_pool);
+  if (!err && !qt->fulltext)
+    err = read_and_checksum_pristine_text(&job->base_stream,
+                                          &job->expected_md5,
+                                          &job->verify_md5,
+                                          deltas->db, qt->local_abspath,
+                                          pool, scratch_pool);
+  if (!err)
+    err = svn_wc__db_temp_wcroot_tempdir(&tmpdir_abspath, deltas->db,
+                                         qt->local_abspath,
+                                         scratch_pool, scratch_pool);
+  if (!err)
+    err = svn_io_open_unique_file3(&job->spool, NULL, tmpdir_abspath,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  if (qt->fulltext)
+    job->base_stream = svn_stream_empty(pool);
+
+  job->local_stream = copying_stream(job->local_stream, install_stream,
+                                     pool);
+  job->local_stream = svn_stream_checksummed2(job->local_stream,
+                                              &job->local_md5, NULL,
+                                              svn_checksum_md5, TRUE, pool);
+
+  *job_p = job;
+  return SVN_NO_ERROR;
+}
+
+/* Compute the delta of JOB into its spool file and close its streams.
+   This does not access the working copy database. */
+static svn_error_t *
+compute_text_delta(text_delta_job_t *job)
+{
+  apr_pool_t *iterpool = svn_pool_create(job->pool);
+  svn_txdelta_stream_t *txdelta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_txdelta_window_t *window;
+  svn_error_t *err;
+  svn_error_t *err2;
+
+  svn_txdelta2(&txdelta_stream, job->base_stream, job->local_stream,
+               FALSE, job->pool);
+
+  /* The spool is read back soon, so don't waste time on compression. */
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_aprfile2(job->spool, TRUE,
+                                                   job->pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, job->pool);
+  do
+    {
+      svn_pool_clear(iterpool);
+
+      err = svn_txdelta_next_window(&window, txdelta_stream, iterpool);
+      if (!err)
+        err = handler(window, handler_baton);
+      if (!err && window)
+        job->windows++;
+    }
+  while (!err && window);
+
+  svn_pool_destroy(iterpool);
+
+  /* Close the two streams to force writing the digests. */
+  err2 = svn_stream_close(job->base_stream);
+  if (err2)
+    {
+      /* The checksum will be uninitialized in this case. */
+      job->verify_md5 = NULL;
+      err = svn_error_compose_create(err, err2);
+    }
+
+  return svn_error_compose_create(err, svn_stream_close(job->local_stream));
+}
+
+/* Implements svn_task__process_func_t.  Run the text_delta_job_t in
+   PROCESS_BATON and return it in *RESULT.  The job belongs to this task
+   until its result has been delivered, so failures get recorded in the
+   job and reported when the file gets transmitted. */
+static svn_error_t *
+text_delta_task(void **result,
+                void *process_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  text_delta_job_t *job = process_baton;
+
+  job->err = compute_text_delta(job);
+
+  *result = job;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Mark the text_delta_job_t in
+   RESULT as done. */
+static svn_error_t *
+deliver_text_delta(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  text_delta_job_t *job = result;
+
+  job->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Start preparing the deltas of the files queued in DELTAS, as far ahead
+   of the next file to transmit as allowed. */
+static svn_error_t *
+start_text_deltas(svn_wc__text_deltas_t *deltas,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (deltas->next_start < deltas->queue->nelts
+         && deltas->next_start - deltas->next_transmit < deltas->max_ahead)
+    {
+      queued_text_t *qt = &APR_ARRAY_IDX(deltas->queue, deltas->next_start,
+                                         queued_text_t);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      deltas->next_start++;
+
+      /* Any problems will be reported by the regular code path. */
+      err = prepare_text_delta(&qt->job, deltas, qt, iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      SVN_ERR(svn_task__add(deltas->set, text_delta_task, qt->job));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the txdelta stream reading back a spooled delta. */
+typedef struct spooled_delta_baton_t
+{
+  text_delta_job_t *job;
+  svn_stream_t *spool;
+  int windows_left;
+} spooled_delta_baton_t;
+
+/* Implements svn_txdelta_next_window_fn_t */
+static svn_error_t *
+spooled_delta_next_window(svn_txdelta_window_t **window,
+                          void *baton,
+                          apr_pool_t *pool)
+{
+  spooled_delta_baton_t *b = baton;
+
+  if (b->windows_left == 0)
+    {
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  b->windows_left--;
+  return svn_error_trace(svn_txdelta_read_svndiff_window(window, b->spool,
+                                                         0, pool));
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t */
+static const unsigned char *
+spooled_delta_md5_digest(void *baton)
+{
+  spooled_delta_baton_t *b = baton;
+
+  return b->job->local_md5->digest;
+}
+
+/* Implements svn_txdelta_stream_open_func_t for the text_delta_job_t in
+   BATON. */
+static svn_error_t *
+open_spooled_delta(svn_txdelta_stream_t **txdelta_stream_p,
+                   void *baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  text_delta_job_t *job = baton;
+  spooled_delta_baton_t *b = apr_palloc(result_pool, sizeof(*b));
+  char header[4];
+  apr_size_t len = sizeof(header);
+  apr_off_t offset = 0;
+
+  /* We may be restarted, so always start from the beginning. */
+  SVN_ERR(svn_io_file_seek(job->spool, APR_SET, &offset, scratch_pool));
+
+  b->job = job;
+  b->spool = svn_stream_from_aprfile2(job->spool, TRUE, result_pool);
+  b->windows_left = job->windows;
+
+  /* Skip the svndiff header. */
+  SVN_ERR(svn_stream_read_full(b->spool, header, &len));
+  if (len != sizeof(header))
+    return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                            _("Unexpected end of svndiff input"));
+
+  *txdelta_stream_p = svn_txdelta_stream_create(b, spooled_delta_next_window,
+                                                spooled_delta_md5_digest,
+                                                result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Like the second half of svn_wc__internal_transmit_text_deltas(), send
+   the delta computed by the finished JOB through EDITOR, install the new
+   pristine text in DB and close FILE_BATON. */
+static svn_error_t *
+send_text_delta(const svn_checksum_t **new_text_base_md5_checksum,
+                const svn_checksum_t **new_text_base_sha1_checksum,
+                text_delta_job_t *job,
+                svn_wc__db_t *db,
+                const svn_delta_editor_t *editor,
+                void *file_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = job->err;
+
+  job->err = SVN_NO_ERROR;
+
+  /* If we have an error, it may be caused by a corrupt text base,
+     so check the checksum. */
+  if (job->expected_md5 && job->verify_md5
+      && !svn_checksum_match(job->expected_md5, job->verify_md5))
+    return svn_error_trace(corrupt_text_base_error(job->expected_md5,
+                                                   job->verify_md5,
+                                                   job->local_abspath, err,
+                                                   scratch_pool));
+
+  if (!err)
+    {
+      const char *base_digest_hex = NULL;
+
+      if (job->expected_md5)
+        base_digest_hex = svn_checksum_to_cstring_display(job->expected_md5,
+                                                          scratch_pool);
+
+      err = editor->apply_textdelta_stream(editor, file_baton,
+                                           base_digest_hex,
+                                           open_spooled_delta, job,
+                                           scratch_pool);
+    }
+
+  SVN_ERR_W(err, apr_psprintf(scratch_pool,
+                              _("While preparing '%s' for commit"),
+                              svn_dirent_local_style(job->local_abspath,
+                                                     scratch_pool)));
+
+  SVN_ERR(svn_wc__db_pristine_install(job->install_data, job->local_sha1,
+                                      job->local_md5, scratch_pool));
+
+  if (new_text_base_md5_checksum)
+    *new_text_base_md5_checksum = svn_checksum_dup(job->local_md5,
+                                                   result_pool);
+  if (new_text_base_sha1_checksum)
+    *new_text_base_sha1_checksum = svn_checksum_dup(job->local_sha1,
+                                                    result_pool);
+
+  return svn_error_trace(
+             editor->close_file(file_baton,
+                                svn_checksum_to_cstring(job->local_md5,
+                                                        scratch_pool),
+                                scratch_pool));
+}
+
+/* Pool cleanup function releasing all untransmitted deltas of the
+   svn_wc__text_deltas_t in DATA.  Its task set is gone by then. */
+static apr_status_t
+cleanup_text_deltas(void *data)
+{
+  svn_wc__text_deltas_t *deltas = data;
+  int i;
+
+  for (i = deltas->next_transmit; i < deltas->next_start; i++)
+    {
+      queued_text_t *qt = &APR_ARRAY_IDX(deltas->queue, i, queued_text_t);
+
+      if (qt->job)
+        {
+          svn_error_clear(qt->job->err);
+          svn_pool_destroy(qt->job->pool);
+        }
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_wc__text_deltas_create(svn_wc__text_deltas_t **deltas,
+                           svn_wc_context_t *wc_ctx,
+                           apr_pool_t *result_pool)
+{
+  svn_wc__text_deltas_t *td = apr_pcalloc(result_pool, sizeof(*td));
+  int jobs = svn_wc__db_get_commit_jobs(wc_ctx->db);
+
+  td->db = wc_ctx->db;
+  td->queue = apr_array_make(result_pool, 16, sizeof(queued_text_t));
+
+  if (jobs > 1)
+    {
+      /* The set lives in a sub-pool, which gets destroyed before the
+         cleanup functions of RESULT_POOL run.  Thus, no task will be
+         using the jobs when cleanup_text_deltas() releases them. */
+      SVN_ERR(svn_task__set_create(&td->set, jobs, deliver_text_delta, td,
+                                   NULL, NULL, svn_pool_create(result_pool)));
+
+      td->max_ahead = 2 * jobs;
+      apr_pool_cleanup_register(result_pool, td, cleanup_text_deltas,
+                                apr_pool_cleanup_null);
+    }
+
+  *deltas = td;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__text_deltas_queue(svn_wc__text_deltas_t *deltas,
+                          const char *local_abspath,
+                          svn_boolean_t fulltext,
+                          apr_pool_t *scratch_pool)
+{
+  queued_text_t *qt = apr_array_push(deltas->queue);
+
+  qt->local_abspath = apr_pstrdup(deltas->queue->pool, local_abspath);
+  qt->fulltext = fulltext;
+  qt->job = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__text_deltas_transmit(const svn_checksum_t **new_text_base_md5_checksum,
+                             const svn_checksum_t **new_text_base_sha1_checksum,
+                             svn_wc__text_deltas_t *deltas,
+                             const char *local_abspath,
+                             const svn_delta_editor_t *editor,
+                             void *file_baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  queued_text_t *qt;
+
+  SVN_ERR_ASSERT(deltas->next_transmit < deltas->queue->nelts);
+  qt = &APR_ARRAY_IDX(deltas->queue, deltas->next_transmit, queued_text_t);
+  SVN_ERR_ASSERT(strcmp(qt->local_abspath, local_abspath) == 0);
+
+  if (deltas->max_ahead)
+    SVN_ERR(start_text_deltas(deltas, scratch_pool));
+
+  if (qt->job)
+    {
+      text_delta_job_t *job = qt->job;
+      svn_error_t *err;
+
+      /* This waits for all started jobs but there are at most
+         MAX_AHEAD of them. */
+      if (!job->done)
+        SVN_ERR(svn_task__set_finish(deltas->set));
+
+      /* From here on, the job is ours alone. */
+      qt->job = NULL;
+      deltas->next_transmit++;
+
+      err = send_text_delta(new_text_base_md5_checksum,
+                            new_text_base_sha1_checksum,
+                            job, deltas->db, editor, file_baton,
+                            result_pool, scratch_pool);
+      svn_pool_destroy(job->pool);
+
+      return svn_error_trace(err);
+    }
+
+  deltas->next_transmit++;
+
+  return svn_error_trace(
+             svn_wc__internal_transmit_text_deltas(NULL,
+                                                   new_text_base_md5_checksum,
+                                                   new_text_base_sha1_checksum,
+                                                   deltas->db, local_abspath,
+                                                   qt->fulltext, editor,
+                                                   file_baton, result_pool,
+                                                   scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      const char *local_abspath,
@@ -860,8 +860,11 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
 
   *contents = NULL;
 
-  SVN_ERR(svn_wc__db_pristine_check(&present, wc_ctx->db, wri_abspath,
-                                    checksum, scratch_pool));
+  if (!wri_abspath)
+    present = FALSE;
+  else
+    SVN_ERR(svn_wc__db_pristine_check(&present, wc_ctx->db, wri_abspath,
+                                      checksum, scratch_pool));
 
   if (present)
     {
@@ -875,6 +878,11 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
       *contents = svn_stream_lazyopen_create(get_pristine_lazyopen_func,
                                              gpl_baton, FALSE, result_pool);
     }
+  else if (checksum->kind == svn_checksum_sha1)
+    {
+      SVN_ERR(svn_wc__db_pristine_read_cached(contents, wc_ctx->db, checksum,
+                                              result_pool, scratch_pool));
+    }
 
   return SVN_NO_ERROR;
 }
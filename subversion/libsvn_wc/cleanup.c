@@ -35,6 +35,7 @@
 #include "adm_files.h"
 #include "lock.h"
 #include "workqueue.h"
+#include "journal.h"
 
 #include "private/svn_wc_private.h"
 #include "svn_private_config.h"
@@ -111,6 +112,11 @@ cleanup_internal(svn_wc__db_t *db,
 
   SVN_ERR(svn_wc__db_is_wcroot(&is_wcroot, db, dir_abspath, scratch_pool));
 
+  /* Make the next full status walk read everything from disk again, in
+     case the change journal missed something. */
+  if (is_wcroot)
+    SVN_ERR(svn_wc__journal_reset(dir_abspath, scratch_pool));
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_wc__db_verify(db, dir_abspath, scratch_pool));
 #endif
@@ -140,6 +146,7 @@ cleanup_internal(svn_wc__db_t *db,
                                            FALSE /* get_all */,
                                            FALSE /* no_ignore */,
                                            FALSE /* ignore_text_mods */,
+                                           FALSE /* use_journal */,
                                            NULL /* ignore patterns */,
                                            status_dummy_callback, NULL,
                                            cancel_func, cancel_baton,
@@ -152,6 +159,22 @@ cleanup_internal(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* How long svn_wc__cleanup_pristines_some() may take, roughly */
+#define PRISTINE_CLEANUP_TIME (APR_USEC_PER_SEC / 5)
+
+void
+svn_wc__cleanup_pristines_some(svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               apr_pool_t *scratch_pool)
+{
+  svn_boolean_t finished;
+
+  svn_error_clear(svn_wc__db_pristine_cleanup_some(&finished, wc_ctx->db,
+                                                   local_abspath,
+                                                   PRISTINE_CLEANUP_TIME,
+                                                   scratch_pool));
+}
+
 svn_error_t *
 svn_wc_cleanup4(svn_wc_context_t *wc_ctx,
                 const char *local_abspath,
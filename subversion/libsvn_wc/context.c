@@ -114,3 +114,19 @@ svn_wc_context_destroy(svn_wc_context_t *wc_ctx)
 
   return SVN_NO_ERROR;
 }
+
+
+void
+svn_wc__sleep_for_timestamps(svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = svn_wc__db_clear_racy_fileinfo(wc_ctx->db,
+                                                    scratch_pool);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+    }
+}
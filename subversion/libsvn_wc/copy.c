@@ -177,9 +177,9 @@ copy_to_tmpdir(svn_skel_t **work_item,
         SVN_ERR(svn_io_dir_make(dst_tmp_abspath, APR_OS_DEFAULT, scratch_pool));
     }
   else if (!is_special)
-    SVN_ERR(svn_io_copy_file(src_abspath, dst_tmp_abspath,
-                             TRUE /* copy_perms */,
-                             scratch_pool));
+    SVN_ERR(svn_io_copy_file2(src_abspath, dst_tmp_abspath,
+                              SVN_IO_COPY_FILE_PERMS | SVN_IO_COPY_FILE_CLONE,
+                              NULL, scratch_pool));
   else
     SVN_ERR(svn_io_copy_link(src_abspath, dst_tmp_abspath, scratch_pool));
 
@@ -306,6 +306,77 @@ build_info_for_node(svn_wc__info2_t **info,
 }
 
 
+/* Set *INFO to a new struct, allocated in RESULT_POOL, built from the
+   information NODE on LOCAL_ABSPATH that was read along with its siblings.
+   WCROOT_ABSPATH is the root of the working copy containing LOCAL_ABSPATH.
+
+   NODE must describe a BASE node that is not shadowed by WORKING, i.e. one
+   that build_info_for_node() would handle without further queries, except
+   for reading conflicts.  Pointer fields are copied by reference, not
+   dup'd. */
+static svn_error_t *
+build_info_from_db_info(svn_wc__info2_t **info,
+                        svn_wc__db_t *db,
+                        const char *local_abspath,
+                        svn_node_kind_t kind,
+                        const struct svn_wc__db_info_t *node,
+                        const char *wcroot_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_wc__info2_t *tmpinfo;
+  svn_wc_info_t *wc_info;
+
+  tmpinfo = apr_pcalloc(result_pool, sizeof(*tmpinfo));
+  tmpinfo->kind = kind;
+  tmpinfo->rev = node->revnum;
+  tmpinfo->repos_root_URL = node->repos_root_url;
+  tmpinfo->repos_UUID = node->repos_uuid;
+  tmpinfo->URL = svn_path_url_add_component2(node->repos_root_url,
+                                             node->repos_relpath,
+                                             result_pool);
+  tmpinfo->last_changed_rev = node->changed_rev;
+  tmpinfo->last_changed_date = node->changed_date;
+  tmpinfo->last_changed_author = node->changed_author;
+  tmpinfo->size = SVN_INVALID_FILESIZE;
+
+  wc_info = apr_pcalloc(result_pool, sizeof(*wc_info));
+  tmpinfo->wc_info = wc_info;
+
+  wc_info->schedule = svn_wc_schedule_normal;
+  wc_info->copyfrom_rev = SVN_INVALID_REVNUM;
+  wc_info->checksum = node->checksum;
+  wc_info->changelist = node->changelist;
+  wc_info->recorded_size = node->recorded_size;
+  wc_info->recorded_time = node->recorded_time;
+  wc_info->wcroot_abspath = wcroot_abspath;
+
+  if (node->status == svn_wc__db_status_excluded)
+    wc_info->depth = svn_depth_exclude;
+  else
+    wc_info->depth = node->depth;
+
+  if (node->conflicted)
+    SVN_ERR(svn_wc__read_conflicts(&wc_info->conflicts, NULL,
+                                   db, local_abspath,
+                                   FALSE /* create tempfiles */,
+                                   FALSE /* only tree conflicts */,
+                                   result_pool, scratch_pool));
+
+  if (node->lock != NULL)
+    {
+      tmpinfo->lock = apr_pcalloc(result_pool, sizeof(*(tmpinfo->lock)));
+      tmpinfo->lock->token         = node->lock->token;
+      tmpinfo->lock->owner         = node->lock->owner;
+      tmpinfo->lock->comment       = node->lock->comment;
+      tmpinfo->lock->creation_date = node->lock->date;
+    }
+
+  *info = tmpinfo;
+  return SVN_NO_ERROR;
+}
+
+
 /* Set *INFO to a new struct with minimal content, to be
    used in reporting info for unversioned tree conflict victims. */
 /* ### Some fields we could fill out based on the parent dir's entry
@@ -349,9 +420,100 @@ struct found_entry_baton
   /* The set of tree conflicts that have been found but not (yet) visited by
    * the tree walker.  Map of abspath -> empty string. */
   apr_hash_t *tree_conflicts;
+  /* The depth of the walk. */
+  svn_depth_t depth;
+  /* The root of the walk and, once it has been visited as a directory,
+   * what the database has on the nodes below it: a map of directory
+   * relpaths below ROOT_ABSPATH to svn_wc__db_dir_children_t, as from
+   * svn_wc__db_read_descendants_info().  WCROOT_ABSPATH is the root of
+   * the working copy that was read from. */
+  const char *root_abspath;
+  apr_hash_t *dirs;
+  const char *wcroot_abspath;
   apr_pool_t *pool;
 };
 
+/* Read the information on the nodes below FE_BATON->root_abspath that the
+ * walk of depth FE_BATON->depth will visit into FE_BATON->dirs, using one
+ * query per table for the whole walk instead of several per node. */
+static svn_error_t *
+read_walk_info(struct found_entry_baton *fe_baton,
+               apr_pool_t *scratch_pool)
+{
+  if (fe_baton->depth == svn_depth_infinity)
+    {
+      SVN_ERR(svn_wc__db_read_descendants_info(&fe_baton->dirs,
+                                               &fe_baton->wcroot_abspath,
+                                               fe_baton->db,
+                                               fe_baton->root_abspath,
+                                               FALSE /* base_tree_only */,
+                                               fe_baton->pool,
+                                               scratch_pool));
+    }
+  else
+    {
+      svn_wc__db_dir_children_t *children;
+
+      children = apr_pcalloc(fe_baton->pool, sizeof(*children));
+      SVN_ERR(svn_wc__db_read_children_info(&children->nodes,
+                                            &children->conflicts,
+                                            fe_baton->db,
+                                            fe_baton->root_abspath,
+                                            FALSE /* base_tree_only */,
+                                            fe_baton->pool, scratch_pool));
+      SVN_ERR(svn_wc__db_get_wcroot(&fe_baton->wcroot_abspath, fe_baton->db,
+                                    fe_baton->root_abspath,
+                                    fe_baton->pool, scratch_pool));
+
+      fe_baton->dirs = apr_hash_make(fe_baton->pool);
+      svn_hash_sets(fe_baton->dirs, "", children);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return what FE_BATON->dirs has on LOCAL_ABSPATH, if that is enough to
+ * build its info without asking the database again.  Otherwise return
+ * NULL. */
+static const struct svn_wc__db_info_t *
+get_walk_info(struct found_entry_baton *fe_baton,
+              const char *local_abspath,
+              apr_pool_t *scratch_pool)
+{
+  const char *parent_abspath;
+  const char *name;
+  const char *parent_relpath;
+  const svn_wc__db_dir_children_t *children;
+  const struct svn_wc__db_info_t *node;
+
+  if (!fe_baton->dirs)
+    return NULL;
+
+  svn_dirent_split(&parent_abspath, &name, local_abspath, scratch_pool);
+  parent_relpath = svn_dirent_skip_ancestor(fe_baton->root_abspath,
+                                            parent_abspath);
+  if (!parent_relpath)
+    return NULL;
+
+  children = svn_hash_gets(fe_baton->dirs, parent_relpath);
+  node = children ? svn_hash_gets(children->nodes, name) : NULL;
+
+  /* Only BASE nodes carry their repository location; anything added,
+   * deleted or shadowed needs the lookups of build_info_for_node(). */
+  if (!node || !node->repos_relpath || !node->repos_root_url)
+    return NULL;
+
+  switch (node->status)
+    {
+      case svn_wc__db_status_normal:
+      case svn_wc__db_status_incomplete:
+      case svn_wc__db_status_excluded:
+        return node;
+      default:
+        return NULL;
+    }
+}
+
 /* Call WALK_BATON->receiver with WALK_BATON->receiver_baton, passing to it
  * info about the path LOCAL_ABSPATH.
  * An svn_wc__node_found_func_t callback function. */
@@ -362,10 +524,17 @@ info_found_node_callback(const char *local_abspath,
                          apr_pool_t *scratch_pool)
 {
   struct found_entry_baton *fe_baton = walk_baton;
+  const struct svn_wc__db_info_t *node;
   svn_wc__info2_t *info;
 
-  SVN_ERR(build_info_for_node(&info, fe_baton->db, local_abspath,
-                               kind, scratch_pool, scratch_pool));
+  node = get_walk_info(fe_baton, local_abspath, scratch_pool);
+  if (node)
+    SVN_ERR(build_info_from_db_info(&info, fe_baton->db, local_abspath,
+                                    kind, node, fe_baton->wcroot_abspath,
+                                    scratch_pool, scratch_pool));
+  else
+    SVN_ERR(build_info_for_node(&info, fe_baton->db, local_abspath,
+                                 kind, scratch_pool, scratch_pool));
 
   if (info == NULL)
     {
@@ -379,6 +548,11 @@ info_found_node_callback(const char *local_abspath,
                                                       scratch_pool));
     }
 
+  /* Read everything the walk will visit below the root at once. */
+  if (fe_baton->first && kind == svn_node_dir
+      && fe_baton->depth > svn_depth_empty)
+    SVN_ERR(read_walk_info(fe_baton, scratch_pool));
+
   fe_baton->first = FALSE;
 
   SVN_ERR_ASSERT(info->wc_info != NULL);
@@ -463,6 +637,10 @@ svn_wc__get_info(svn_wc_context_t *wc_ctx,
   fe_baton.actual_only = fetch_actual_only;
   fe_baton.first = TRUE;
   fe_baton.tree_conflicts = apr_hash_make(scratch_pool);
+  fe_baton.depth = depth;
+  fe_baton.root_abspath = local_abspath;
+  fe_baton.dirs = NULL;
+  fe_baton.wcroot_abspath = NULL;
   fe_baton.pool = scratch_pool;
 
   err = svn_wc__internal_walk_children(wc_ctx->db, local_abspath,
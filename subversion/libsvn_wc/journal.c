@@ -0,0 +1,927 @@
+/*
+ * journal.c :  the change journal of a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The journal file consists of lines terminated by '\n'.  The first line
+ * is either JOURNAL_PRIMING or JOURNAL_CLEAN.  Both have the same length,
+ * so the state can be flipped in place while the watcher keeps appending.
+ * All other lines are either "D <relpath>" for a directory whose list of
+ * children or whose children's contents changed, or "R <relpath>" for a
+ * directory whose whole subtree must be considered changed.
+ *
+ * File system events reach the watcher asynchronously.  Before a reader
+ * trusts the journal, it creates a marker file in the barrier directory
+ * and waits for the watcher to remove it.  inotify reports all events of
+ * an instance in order, so once the marker is gone, the watcher has
+ * recorded every change made before the reader started.  A journal whose
+ * watcher doesn't pass the barrier in time is not used.  A marker whose
+ * name starts with RESET_MARKER makes the watcher start over with a new,
+ * priming journal before it removes the marker.
+ *
+ * The watcher keeps an exclusive lock on the journal for as long as it
+ * runs.  A journal that isn't locked has been left behind by a watcher
+ * that died and gets removed.
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_file_io.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_string.h"
+#include "svn_wc.h"
+
+#include "private/svn_wc_private.h"
+
+#include "wc.h"
+#include "adm_files.h"
+#include "journal.h"
+
+#include "svn_private_config.h"
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT1)
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#define USE_INOTIFY
+#endif
+
+#define JOURNAL_PRIMING "prime\n"
+#define JOURNAL_CLEAN   "clean\n"
+#define JOURNAL_HEADER_LEN (sizeof(JOURNAL_PRIMING) - 1)
+
+/* The names of the markers in the barrier directory start with these. */
+#define BARRIER_MARKER "barrier"
+#define RESET_MARKER   "reset"
+
+/* How long to wait for the watcher to pass a barrier, and how often to
+   check whether it did. */
+#define BARRIER_TIMEOUT       apr_time_from_sec(2)
+#define BARRIER_POLL_INTERVAL apr_time_from_msec(1)
+
+struct svn_wc__journal_t
+{
+  /* The journal file and the identity of the file we read. */
+  const char *abspath;
+  apr_ino_t inode;
+  apr_dev_t device;
+
+  /* Whether the journal had been primed when we read it. */
+  svn_boolean_t clean;
+
+  /* const char *relpath -> "" for all directories with changed contents. */
+  apr_hash_t *dirs;
+
+  /* const char *relpath -> "" for all directories with a changed subtree. */
+  apr_hash_t *subtrees;
+};
+
+/* Set *SAME to whether FILE is the journal file that JOURNAL was read
+   from.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+same_journal(svn_boolean_t *same,
+             const svn_wc__journal_t *journal,
+             apr_file_t *file,
+             apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_IDENT, file, scratch_pool));
+  *same = (finfo.inode == journal->inode && finfo.device == journal->device);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOCKED to whether some other process holds a lock on FILE,
+   allocated in POOL. */
+static svn_error_t *
+journal_locked(svn_boolean_t *locked,
+               apr_file_t *file,
+               apr_pool_t *pool)
+{
+  svn_error_t *err = svn_io_lock_open_file(file, FALSE, TRUE, pool);
+
+  if (err)
+    {
+      if (!APR_STATUS_IS_EAGAIN(err->apr_err)
+          && !APR_STATUS_IS_EACCES(err->apr_err))
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+      *locked = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  *locked = FALSE;
+  return svn_error_trace(svn_io_unlock_open_file(file, pool));
+}
+
+/* Set *MAINTAINED to whether the journal at JOURNAL_ABSPATH exists and
+   some other process maintains it.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+journal_maintained(svn_boolean_t *maintained,
+                   const char *journal_abspath,
+                   apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file, journal_abspath, APR_READ, APR_OS_DEFAULT,
+                         scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *maintained = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  err = journal_locked(maintained, file, scratch_pool);
+  return svn_error_compose_create(err, svn_io_file_close(file,
+                                                         scratch_pool));
+}
+
+/* Remove the journal at JOURNAL_ABSPATH of the working copy at
+   WCROOT_ABSPATH, and its barrier directory, unless some watcher still
+   maintains it.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+remove_stale_journal(const char *wcroot_abspath,
+                     const char *journal_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  svn_boolean_t maintained;
+
+  SVN_ERR(journal_maintained(&maintained, journal_abspath, scratch_pool));
+  if (maintained)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_remove_file2(journal_abspath, TRUE, scratch_pool));
+  return svn_error_trace(
+           svn_io_remove_dir2(svn_wc__adm_child(wcroot_abspath,
+                                                SVN_WC__ADM_JOURNAL_BARRIER,
+                                                scratch_pool),
+                              TRUE, NULL, NULL, scratch_pool));
+}
+
+/* Create a marker whose name starts with MARKER_NAME in the barrier
+   directory of the working copy at WCROOT_ABSPATH and wait for the watcher
+   to remove it.  Set *PASSED to whether that happened in time.
+
+   Set *PASSED to FALSE as well if the marker can't be created, e.g. in
+   read-only working copies or if nobody watches the working copy.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+pass_barrier(svn_boolean_t *passed,
+             const char *wcroot_abspath,
+             const char *marker_name,
+             apr_pool_t *scratch_pool)
+{
+  const char *marker_abspath;
+  apr_file_t *file;
+  apr_time_t deadline;
+  svn_error_t *err;
+
+  *passed = FALSE;
+
+  err = svn_io_open_uniquely_named(&file, &marker_abspath,
+                                   svn_wc__adm_child(
+                                     wcroot_abspath,
+                                     SVN_WC__ADM_JOURNAL_BARRIER,
+                                     scratch_pool),
+                                   marker_name, NULL, svn_io_file_del_none,
+                                   scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  deadline = apr_time_now() + BARRIER_TIMEOUT;
+  do
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(marker_abspath, &kind, scratch_pool));
+      if (kind == svn_node_none)
+        {
+          *passed = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      apr_sleep(BARRIER_POLL_INTERVAL);
+    }
+  while (apr_time_now() < deadline);
+
+  return svn_error_trace(svn_io_remove_file2(marker_abspath, TRUE,
+                                             scratch_pool));
+}
+
+svn_error_t *
+svn_wc__journal_open(svn_wc__journal_t **journal,
+                     const char *wcroot_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_wc__journal_t *result;
+  const char *abspath = svn_wc__adm_child(wcroot_abspath, SVN_WC__ADM_JOURNAL,
+                                          result_pool);
+  apr_file_t *file;
+  svn_stringbuf_t *contents;
+  svn_node_kind_t kind;
+  svn_boolean_t passed;
+  apr_finfo_t finfo;
+  const char *line;
+  const char *end;
+  svn_error_t *err;
+
+  *journal = NULL;
+
+  SVN_ERR(svn_io_check_path(abspath, &kind, scratch_pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* Make sure that the watcher has caught up with all changes made so
+     far.  Ignore journals that nobody maintains anymore. */
+  SVN_ERR(pass_barrier(&passed, wcroot_abspath, BARRIER_MARKER,
+                       scratch_pool));
+  if (!passed)
+    {
+      svn_error_clear(remove_stale_journal(wcroot_abspath, abspath,
+                                           scratch_pool));
+      return SVN_NO_ERROR;
+    }
+
+  /* Read the journal only now.  If the watcher started over in the
+     meantime, we get the new one. */
+  err = svn_io_file_open(&file, abspath, APR_READ, APR_OS_DEFAULT,
+                         scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_IDENT, file, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_aprfile(&contents, file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  if (contents->len < JOURNAL_HEADER_LEN)
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->abspath = abspath;
+  result->inode = finfo.inode;
+  result->device = finfo.device;
+  result->dirs = apr_hash_make(result_pool);
+  result->subtrees = apr_hash_make(result_pool);
+
+  if (memcmp(contents->data, JOURNAL_CLEAN, JOURNAL_HEADER_LEN) == 0)
+    result->clean = TRUE;
+  else if (memcmp(contents->data, JOURNAL_PRIMING, JOURNAL_HEADER_LEN) != 0)
+    return SVN_NO_ERROR;
+
+  /* Parse all complete lines.  The watcher may be writing the last one
+     right now. */
+  line = contents->data + JOURNAL_HEADER_LEN;
+  while ((end = strchr(line, '\n')) != NULL)
+    {
+      const char *relpath;
+
+      if (end - line < 2 || line[1] != ' ')
+        return SVN_NO_ERROR;
+
+      relpath = apr_pstrmemdup(result_pool, line + 2, end - line - 2);
+      if (line[0] == 'D')
+        svn_hash_sets(result->dirs, relpath, "");
+      else if (line[0] == 'R')
+        svn_hash_sets(result->subtrees, relpath, "");
+      else
+        return SVN_NO_ERROR;
+
+      line = end + 1;
+    }
+
+  *journal = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__journal_reset(const char *wcroot_abspath,
+                      apr_pool_t *scratch_pool)
+{
+  svn_boolean_t passed;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(svn_wc__adm_child(wcroot_abspath,
+                                              SVN_WC__ADM_JOURNAL,
+                                              scratch_pool),
+                            &kind, scratch_pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* If the watcher doesn't respond, status walks won't use its journal
+     anyway. */
+  return svn_error_trace(pass_barrier(&passed, wcroot_abspath, RESET_MARKER,
+                                      scratch_pool));
+}
+
+svn_boolean_t
+svn_wc__journal_is_clean(const svn_wc__journal_t *journal)
+{
+  return journal->clean;
+}
+
+svn_boolean_t
+svn_wc__journal_changed(const svn_wc__journal_t *journal,
+                        const char *dir_relpath,
+                        apr_pool_t *scratch_pool)
+{
+  if (svn_hash_gets(journal->dirs, dir_relpath))
+    return TRUE;
+
+  if (apr_hash_count(journal->subtrees) == 0)
+    return FALSE;
+
+  while (TRUE)
+    {
+      if (svn_hash_gets(journal->subtrees, dir_relpath))
+        return TRUE;
+
+      if (*dir_relpath == '\0')
+        return FALSE;
+
+      dir_relpath = svn_relpath_dirname(dir_relpath, scratch_pool);
+    }
+}
+
+svn_error_t *
+svn_wc__journal_finish_priming(svn_wc__journal_t *journal,
+                               const apr_array_header_t *changed_relpaths,
+                               apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  apr_file_t *header;
+  svn_stringbuf_t *lines;
+  char state[JOURNAL_HEADER_LEN];
+  apr_size_t len = sizeof(state);
+  apr_off_t offset = 0;
+  svn_boolean_t same_file, same_header;
+  int i;
+
+  if (journal->clean)
+    return SVN_NO_ERROR;
+
+  /* Open the file twice so that our lines get appended atomically, just
+     like the watcher's, while we can still update the header in place.
+     If the watcher restarted the journal since we read it, the changes
+     we found may be outdated already; leave the new journal alone. */
+  SVN_ERR(svn_io_file_open(&file, journal->abspath, APR_WRITE | APR_APPEND,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_open(&header, journal->abspath, APR_READ | APR_WRITE,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(same_journal(&same_file, journal, file, scratch_pool));
+  SVN_ERR(same_journal(&same_header, journal, header, scratch_pool));
+
+  SVN_ERR(svn_io_file_read_full2(header, state, len, &len, NULL,
+                                 scratch_pool));
+  if (!same_file || !same_header
+      || len != JOURNAL_HEADER_LEN
+      || memcmp(state, JOURNAL_PRIMING, JOURNAL_HEADER_LEN) != 0)
+    {
+      SVN_ERR(svn_io_file_close(header, scratch_pool));
+      return svn_error_trace(svn_io_file_close(file, scratch_pool));
+    }
+
+  lines = svn_stringbuf_create_empty(scratch_pool);
+  for (i = 0; i < changed_relpaths->nelts; i++)
+    {
+      svn_stringbuf_appendcstr(lines, "D ");
+      svn_stringbuf_appendcstr(lines, APR_ARRAY_IDX(changed_relpaths, i,
+                                                    const char *));
+      svn_stringbuf_appendbyte(lines, '\n');
+    }
+
+  SVN_ERR(svn_io_file_write_full(file, lines->data, lines->len, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  SVN_ERR(svn_io_file_seek(header, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(header, JOURNAL_CLEAN, JOURNAL_HEADER_LEN,
+                                 NULL, scratch_pool));
+  SVN_ERR(svn_io_file_close(header, scratch_pool));
+
+  journal->clean = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+
+#ifdef USE_INOTIFY
+
+/* Events that change what a status walk would find in a directory. */
+#define WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE \
+                      | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+                      | IN_DELETE_SELF | IN_MOVE_SELF \
+                      | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+typedef struct watcher_t
+{
+  /* The working copy being watched. */
+  const char *wcroot_abspath;
+
+  /* Its journal file. */
+  const char *journal_abspath;
+
+  /* The directory in which readers create their barrier markers. */
+  const char *barrier_abspath;
+
+  /* The inotify instance of the current journal, or -1. */
+  int fd;
+
+  /* The watch descriptor of BARRIER_ABSPATH. */
+  int barrier_wd;
+
+  /* The current journal, opened for appending and locked exclusively. */
+  apr_file_t *journal;
+
+  /* int watch descriptor -> const char *relpath of the watched directory */
+  apr_hash_t *watches;
+
+  /* The journal lines written so far, to avoid repeating them. */
+  apr_hash_t *recorded;
+
+  /* Holds everything that belongs to the current journal. */
+  apr_pool_t *pool;
+} watcher_t;
+
+/* Append the journal line "TYPE RELPATH" unless it has been written
+   already. */
+static svn_error_t *
+record_change(watcher_t *watcher,
+              char type,
+              const char *relpath,
+              apr_pool_t *scratch_pool)
+{
+  const char *line = apr_psprintf(scratch_pool, "%c %s\n", type, relpath);
+
+  if (svn_hash_gets(watcher->recorded, line))
+    return SVN_NO_ERROR;
+
+  svn_hash_sets(watcher->recorded, apr_pstrdup(watcher->pool, line), "");
+
+  return svn_error_trace(svn_io_file_write_full(watcher->journal, line,
+                                                strlen(line), NULL,
+                                                scratch_pool));
+}
+
+/* Watch the directory RELPATH and all directories below it, except for
+   administrative areas and nested working copies.  If RECORD is TRUE,
+   RELPATH is new to us and its whole subtree is recorded as changed. */
+static svn_error_t *
+add_watches(watcher_t *watcher,
+            const char *relpath,
+            svn_boolean_t record,
+            apr_pool_t *scratch_pool)
+{
+  const char *abspath = svn_dirent_join(watcher->wcroot_abspath, relpath,
+                                        scratch_pool);
+  const char *abspath_native;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int wd;
+
+  if (*relpath != '\0')
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(svn_wc__adm_child(abspath, NULL,
+                                                  scratch_pool),
+                                &kind, scratch_pool));
+      if (kind != svn_node_none)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_path_cstring_from_utf8(&abspath_native, abspath,
+                                     scratch_pool));
+  wd = inotify_add_watch(watcher->fd, abspath_native, WATCH_EVENTS);
+  if (wd < 0)
+    {
+      if (errno == ENOSPC)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("Can't watch '%s': too many directories; "
+                                   "consider raising "
+                                   "fs.inotify.max_user_watches"),
+                                 svn_dirent_local_style(abspath,
+                                                        scratch_pool));
+      if (errno != ENOENT && errno != ENOTDIR)
+        return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                                  _("Can't watch '%s'"),
+                                  svn_dirent_local_style(abspath,
+                                                         scratch_pool));
+      return SVN_NO_ERROR;
+    }
+
+  /* Watching a directory again after it moved returns the same watch
+     descriptor, which we update to the new location. */
+  {
+    int *key = apr_pmemdup(watcher->pool, &wd, sizeof(wd));
+
+    apr_hash_set(watcher->watches, key, sizeof(*key),
+                 apr_pstrdup(watcher->pool, relpath));
+  }
+
+  if (record)
+    SVN_ERR(record_change(watcher, 'R', relpath, scratch_pool));
+
+  /* Read the directory only now, so that every subdirectory is either
+     listed here or announced by an event. */
+  err = svn_io_get_dirents3(&dirents, abspath, TRUE /* only_check_type */,
+                            scratch_pool, scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      /* Gone already.  The parent's events will tell us. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      if (dirent->kind != svn_node_dir || dirent->special
+          || svn_wc_is_adm_dir(name, iterpool))
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(add_watches(watcher, svn_relpath_join(relpath, name, iterpool),
+                          FALSE, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Watch the barrier directory of WATCHER for new markers and remove all
+   existing ones.  Their creators waited for the previous journal and will
+   read the new one.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+watch_barrier(watcher_t *watcher,
+              apr_pool_t *scratch_pool)
+{
+  const char *abspath_native;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_io_make_dir_recursively(watcher->barrier_abspath,
+                                      scratch_pool));
+  SVN_ERR(svn_path_cstring_from_utf8(&abspath_native,
+                                     watcher->barrier_abspath,
+                                     scratch_pool));
+  watcher->barrier_wd = inotify_add_watch(watcher->fd, abspath_native,
+                                          IN_CREATE | IN_ONLYDIR
+                                          | IN_DONT_FOLLOW);
+  if (watcher->barrier_wd < 0)
+    return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                              _("Can't watch '%s'"),
+                              svn_dirent_local_style(watcher->barrier_abspath,
+                                                     scratch_pool));
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, watcher->barrier_abspath,
+                              TRUE /* only_check_type */,
+                              scratch_pool, scratch_pool));
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_remove_file2(svn_dirent_join(watcher->barrier_abspath,
+                                                  apr_hash_this_key(hi),
+                                                  iterpool),
+                                  TRUE, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Close the current journal of WATCHER, if any. */
+static void
+stop_journal(watcher_t *watcher)
+{
+  if (watcher->fd >= 0)
+    close(watcher->fd);
+  watcher->fd = -1;
+  watcher->barrier_wd = -1;
+
+  svn_pool_clear(watcher->pool);
+  watcher->journal = NULL;
+}
+
+/* Watch the whole working copy from scratch and replace the journal file
+   with a new, priming one. */
+static svn_error_t *
+start_journal(watcher_t *watcher,
+              apr_pool_t *scratch_pool)
+{
+  const char *tmp_abspath;
+
+  stop_journal(watcher);
+
+  watcher->watches = apr_hash_make(watcher->pool);
+  watcher->recorded = apr_hash_make(watcher->pool);
+
+  watcher->fd = inotify_init1(IN_CLOEXEC);
+  if (watcher->fd < 0)
+    return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                              _("Can't create inotify instance"));
+
+  /* Only publish the journal once every directory is being watched. */
+  SVN_ERR(svn_io_open_unique_file3(&watcher->journal, &tmp_abspath,
+                                   svn_wc__adm_child(watcher->wcroot_abspath,
+                                                     SVN_WC__ADM_TMP,
+                                                     scratch_pool),
+                                   svn_io_file_del_none,
+                                   watcher->pool, scratch_pool));
+  SVN_ERR(svn_io_lock_open_file(watcher->journal, TRUE, TRUE, watcher->pool));
+  SVN_ERR(svn_io_file_write_full(watcher->journal, JOURNAL_PRIMING,
+                                 JOURNAL_HEADER_LEN, NULL, scratch_pool));
+
+  SVN_ERR(add_watches(watcher, "", FALSE, scratch_pool));
+
+  /* Reopen for appending, so that our lines never overwrite the ones a
+     priming status walk adds.  Closing the file drops our lock, so take
+     it again before the journal becomes visible. */
+  SVN_ERR(svn_io_file_close(watcher->journal, scratch_pool));
+  SVN_ERR(svn_io_file_open(&watcher->journal, tmp_abspath,
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT,
+                           watcher->pool));
+  SVN_ERR(svn_io_lock_open_file(watcher->journal, TRUE, TRUE, watcher->pool));
+
+  SVN_ERR(svn_io_file_rename2(tmp_abspath, watcher->journal_abspath,
+                              FALSE, scratch_pool));
+
+  /* Only now may readers pass the barrier and read the new journal. */
+  return svn_error_trace(watch_barrier(watcher, scratch_pool));
+}
+
+/* Record the changes reported by the pending events of WATCHER.  Set
+   *RESTART if the events can't be trusted anymore. */
+static svn_error_t *
+process_events(svn_boolean_t *restart,
+               watcher_t *watcher,
+               apr_pool_t *scratch_pool)
+{
+  union
+    {
+      struct inotify_event event;
+      char data[65536];
+    } buffer;
+  ssize_t len;
+  const char *p;
+  apr_pool_t *iterpool;
+
+  *restart = FALSE;
+
+  len = read(watcher->fd, &buffer, sizeof(buffer));
+  if (len < 0 && errno == EINTR)
+    return SVN_NO_ERROR;
+  if (len <= 0)
+    {
+      *restart = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (p = buffer.data; p < buffer.data + len; )
+    {
+      const struct inotify_event *event = (const void *)p;
+      const char *relpath;
+
+      p += sizeof(*event) + event->len;
+      svn_pool_clear(iterpool);
+
+      if (event->mask & (IN_Q_OVERFLOW | IN_UNMOUNT))
+        {
+          *restart = TRUE;
+          break;
+        }
+
+      /* All earlier events have been recorded; let the reader that
+         created this marker pass. */
+      if (event->wd == watcher->barrier_wd)
+        {
+          const char *name;
+
+          if (!(event->mask & IN_CREATE) || !event->len
+              || event->name[0] == '\0')
+            continue;
+
+          SVN_ERR(svn_path_cstring_to_utf8(&name, event->name, iterpool));
+
+          /* start_journal() removes this marker after starting over. */
+          if (strncmp(name, RESET_MARKER, strlen(RESET_MARKER)) == 0)
+            {
+              *restart = TRUE;
+              break;
+            }
+
+          SVN_ERR(svn_io_remove_file2(
+                    svn_dirent_join(watcher->barrier_abspath, name,
+                                    iterpool),
+                    TRUE, iterpool));
+          continue;
+        }
+
+      relpath = apr_hash_get(watcher->watches, &event->wd,
+                             sizeof(event->wd));
+      if (!relpath)
+        continue;
+
+      if (event->mask & IN_IGNORED)
+        {
+          apr_hash_set(watcher->watches, &event->wd, sizeof(event->wd),
+                       NULL);
+          continue;
+        }
+
+      if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+        {
+          SVN_ERR(record_change(watcher, 'R', relpath, iterpool));
+          continue;
+        }
+
+      if (event->len && event->name[0] != '\0')
+        {
+          const char *name;
+          const char *child_relpath;
+
+          SVN_ERR(svn_path_cstring_to_utf8(&name, event->name, iterpool));
+          if (svn_wc_is_adm_dir(name, iterpool))
+            continue;
+
+          child_relpath = svn_relpath_join(relpath, name, iterpool);
+          if ((event->mask & IN_ISDIR)
+              && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+            SVN_ERR(add_watches(watcher, child_relpath, TRUE, iterpool));
+          else if ((event->mask & IN_ISDIR)
+                   && (event->mask & (IN_DELETE | IN_MOVED_FROM)))
+            SVN_ERR(record_change(watcher, 'R', child_relpath, iterpool));
+        }
+
+      SVN_ERR(record_change(watcher, 'D', relpath, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Run WATCHER until CANCEL_FUNC returns an error. */
+static svn_error_t *
+run_watcher(watcher_t *watcher,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(start_journal(watcher, scratch_pool));
+
+  while (TRUE)
+    {
+      struct pollfd pfd;
+      int rc;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      pfd.fd = watcher->fd;
+      pfd.events = POLLIN;
+      rc = poll(&pfd, 1, 1000);
+      if (rc < 0 && errno != EINTR)
+        return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                                  _("Can't wait for file system events"));
+
+      if (rc > 0)
+        {
+          svn_boolean_t restart;
+
+          SVN_ERR(process_events(&restart, watcher, iterpool));
+
+          /* We missed events or have been asked to reset.  Start over
+             with a journal that the next full status walk will prime
+             again. */
+          if (restart)
+            SVN_ERR(start_journal(watcher, iterpool));
+        }
+    }
+}
+
+#endif /* USE_INOTIFY */
+
+svn_error_t *
+svn_wc__journal_watch(const char *wcroot_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+#ifdef USE_INOTIFY
+  watcher_t watcher;
+  svn_boolean_t maintained;
+  svn_error_t *err;
+
+  watcher.wcroot_abspath = wcroot_abspath;
+  watcher.journal_abspath = svn_wc__adm_child(wcroot_abspath,
+                                              SVN_WC__ADM_JOURNAL,
+                                              scratch_pool);
+  watcher.barrier_abspath = svn_wc__adm_child(wcroot_abspath,
+                                              SVN_WC__ADM_JOURNAL_BARRIER,
+                                              scratch_pool);
+  watcher.fd = -1;
+  watcher.barrier_wd = -1;
+  watcher.journal = NULL;
+  watcher.pool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(journal_maintained(&maintained, watcher.journal_abspath,
+                             scratch_pool));
+  if (maintained)
+    return svn_error_createf(SVN_ERR_WC_LOCKED, NULL,
+                             _("Working copy '%s' is already being watched"),
+                             svn_dirent_local_style(wcroot_abspath,
+                                                    scratch_pool));
+
+  err = run_watcher(&watcher, cancel_func, cancel_baton, scratch_pool);
+
+  /* Status walks must not rely on a journal that we no longer update. */
+  stop_journal(&watcher);
+  err = svn_error_compose_create(
+            err,
+            svn_io_remove_file2(watcher.journal_abspath, TRUE,
+                                scratch_pool));
+  return svn_error_compose_create(
+            err,
+            svn_io_remove_dir2(watcher.barrier_abspath, TRUE, NULL, NULL,
+                               scratch_pool));
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Watching working copies for changes is not "
+                            "supported on this platform"));
+#endif
+}
+
+svn_error_t *
+svn_wc__watch_changes(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  const char *wcroot_abspath;
+
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, wc_ctx->db, local_abspath,
+                                scratch_pool, scratch_pool));
+
+  return svn_error_trace(svn_wc__journal_watch(wcroot_abspath,
+                                               cancel_func, cancel_baton,
+                                               scratch_pool));
+}
@@ -0,0 +1,112 @@
+/*
+ * journal.h :  the change journal of a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ *
+ * While a watcher process (see svn_wc__journal_watch()) observes a
+ * working copy, it appends the relpaths of all directories whose contents
+ * change on disk to the journal file in the administrative area.  The
+ * journal starts out "priming".  The first full status walk of the
+ * working copy then adds every directory whose on-disk state does not
+ * match the recorded state and marks the journal "clean".
+ *
+ * From then on, a directory that is not listed in the journal is known to
+ * contain exactly the nodes recorded in wc.db, so status walks need not
+ * list it.  They still stat its files: writes through shared memory
+ * mappings change file contents without any event.
+ */
+
+#ifndef SVN_WC_JOURNAL_H
+#define SVN_WC_JOURNAL_H
+
+#include <apr_pools.h>
+#include <apr_tables.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* The change journal of one working copy, as read by a status walk. */
+typedef struct svn_wc__journal_t svn_wc__journal_t;
+
+/* Set *JOURNAL to the change journal of the working copy rooted at
+   WCROOT_ABSPATH, as it is after the watcher has recorded all changes
+   made so far.  Set *JOURNAL to NULL if no watcher is currently
+   maintaining a journal for it, if the watcher doesn't catch up in time,
+   or if the journal can't be used.
+
+   Allocate *JOURNAL in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_wc__journal_open(svn_wc__journal_t **journal,
+                     const char *wcroot_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool);
+
+/* Make the watcher of the working copy rooted at WCROOT_ABSPATH, if any,
+   start over with a new journal that the next full status walk primes
+   again.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__journal_reset(const char *wcroot_abspath,
+                      apr_pool_t *scratch_pool);
+
+/* Return TRUE if JOURNAL has been primed, i.e. if directories not
+   reported by svn_wc__journal_changed() match their recorded state. */
+svn_boolean_t
+svn_wc__journal_is_clean(const svn_wc__journal_t *journal);
+
+/* Return TRUE if JOURNAL lists the directory DIR_RELPATH, or one of its
+   ancestors, as changed on disk. */
+svn_boolean_t
+svn_wc__journal_changed(const svn_wc__journal_t *journal,
+                        const char *dir_relpath,
+                        apr_pool_t *scratch_pool);
+
+/* Complete the priming of JOURNAL: add CHANGED_RELPATHS, the relpaths
+   (const char *) of all directories whose on-disk state differed from the
+   recorded state during a full status walk, and mark JOURNAL clean.
+
+   Do nothing if JOURNAL has been primed already. */
+svn_error_t *
+svn_wc__journal_finish_priming(svn_wc__journal_t *journal,
+                               const apr_array_header_t *changed_relpaths,
+                               apr_pool_t *scratch_pool);
+
+/* Maintain a new change journal for the working copy rooted at
+   WCROOT_ABSPATH until CANCEL_FUNC with CANCEL_BATON returns an error,
+   then remove the journal and return that error.
+
+   Return SVN_ERR_UNSUPPORTED_FEATURE if working copies can't be watched
+   on this platform.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__journal_watch(const char *wcroot_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_WC_JOURNAL_H */
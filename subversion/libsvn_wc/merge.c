@@ -53,6 +53,9 @@ typedef struct merge_target_t
   const char *diff3_cmd;                    /* The diff3 command and options */
   const apr_array_header_t *merge_options;
 
+  svn_diff_t *diff3;                        /* Precomputed diff3 over */
+  const char *diff3_left_abspath;           /* this left file and target,
+                                               if not NULL */
 } merge_target_t;
 
 
@@ -381,10 +384,12 @@ init_conflict_markers(const char **target_marker,
  * If there are conflicts, set *CONTAINS_CONFLICTS to true, and use
  * TARGET_LABEL, LEFT_LABEL, and RIGHT_LABEL as labels for conflict
  * markers.  Else, set *CONTAINS_CONFLICTS to false.
+ * If DIFF is not NULL, it is the diff3 of the input files already.
  * Do all allocations in POOL. */
 static svn_error_t *
 do_text_merge(svn_boolean_t *contains_conflicts,
               apr_file_t *result_f,
+              svn_diff_t *diff,
               const apr_array_header_t *merge_options,
               const char *detranslated_target,
               const char *left,
@@ -396,7 +401,6 @@ do_text_merge(svn_boolean_t *contains_conflicts,
               void *cancel_baton,
               apr_pool_t *pool)
 {
-  svn_diff_t *diff;
   svn_stream_t *ostream;
   const char *target_marker;
   const char *left_marker;
@@ -413,8 +417,9 @@ do_text_merge(svn_boolean_t *contains_conflicts,
   init_conflict_markers(&target_marker, &left_marker, &right_marker,
                         target_label, left_label, right_label, pool);
 
-  SVN_ERR(svn_diff_file_diff3_2(&diff, left, detranslated_target, right,
-                                diff3_options, pool));
+  if (!diff)
+    SVN_ERR(svn_diff_file_diff3_2(&diff, left, detranslated_target, right,
+                                  diff3_options, pool));
 
   ostream = svn_stream_from_aprfile2(result_f, TRUE, pool);
 
@@ -541,7 +546,8 @@ preserve_pre_merge_files(svn_skel_t **work_items,
       SVN_ERR(svn_io_open_unique_file3(NULL, &tmp_left, temp_dir_abspath,
                                        svn_io_file_del_none,
                                        scratch_pool, scratch_pool));
-      SVN_ERR(svn_io_copy_file(left_abspath, tmp_left, TRUE, scratch_pool));
+      SVN_ERR(svn_io_copy_file2(left_abspath, tmp_left,
+                                SVN_IO_COPY_FILE_PERMS, NULL, scratch_pool));
 
       /* And create a wq item to remove the file later */
       SVN_ERR(svn_wc__wq_build_file_remove(&work_item, mt->db, wcroot_abspath,
@@ -558,7 +564,8 @@ preserve_pre_merge_files(svn_skel_t **work_items,
       SVN_ERR(svn_io_open_unique_file3(NULL, &tmp_right, temp_dir_abspath,
                                        svn_io_file_del_none,
                                        scratch_pool, scratch_pool));
-      SVN_ERR(svn_io_copy_file(right_abspath, tmp_right, TRUE, scratch_pool));
+      SVN_ERR(svn_io_copy_file2(right_abspath, tmp_right,
+                                SVN_IO_COPY_FILE_PERMS, NULL, scratch_pool));
 
       /* And create a wq item to remove the file later */
       SVN_ERR(svn_wc__wq_build_file_remove(&work_item, mt->db, wcroot_abspath,
@@ -865,17 +872,28 @@ merge_text_file(svn_skel_t **work_items,
                                      right_label,
                                      pool));
   else /* Use internal merge. */
-    SVN_ERR(do_text_merge(&contains_conflicts,
-                          result_f,
-                          mt->merge_options,
-                          detranslated_target_abspath,
-                          left_abspath,
-                          right_abspath,
-                          target_label,
-                          left_label,
-                          right_label,
-                          cancel_func, cancel_baton,
-                          pool));
+    {
+      svn_diff_t *diff = NULL;
+
+      /* Use the precomputed diff if it compares the same files. */
+      if (mt->diff3
+          && !strcmp(left_abspath, mt->diff3_left_abspath)
+          && !strcmp(detranslated_target_abspath, mt->local_abspath))
+        diff = mt->diff3;
+
+      SVN_ERR(do_text_merge(&contains_conflicts,
+                            result_f,
+                            diff,
+                            mt->merge_options,
+                            detranslated_target_abspath,
+                            left_abspath,
+                            right_abspath,
+                            target_label,
+                            left_label,
+                            right_label,
+                            cancel_func, cancel_baton,
+                            pool));
+    }
 
   SVN_ERR(svn_io_file_close(result_f, pool));
 
@@ -1032,8 +1050,10 @@ merge_binary_file(svn_skel_t **work_items,
                                      pool, pool));
 
   /* create the backup files */
-  SVN_ERR(svn_io_copy_file(left_abspath, left_copy, TRUE, pool));
-  SVN_ERR(svn_io_copy_file(right_abspath, right_copy, TRUE, pool));
+  SVN_ERR(svn_io_copy_file2(left_abspath, left_copy, SVN_IO_COPY_FILE_PERMS,
+                            NULL, pool));
+  SVN_ERR(svn_io_copy_file2(right_abspath, right_copy, SVN_IO_COPY_FILE_PERMS,
+                            NULL, pool));
 
   /* Was the merge target detranslated? */
   if (strcmp(mt->local_abspath, detranslated_target_abspath) != 0)
@@ -1074,27 +1094,30 @@ merge_binary_file(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_merge(svn_skel_t **work_items,
-                       svn_skel_t **conflict_skel,
-                       enum svn_wc_merge_outcome_t *merge_outcome,
-                       svn_wc__db_t *db,
-                       const char *left_abspath,
-                       const char *right_abspath,
-                       const char *target_abspath,
-                       const char *wri_abspath,
-                       const char *left_label,
-                       const char *right_label,
-                       const char *target_label,
-                       apr_hash_t *old_actual_props,
-                       svn_boolean_t dry_run,
-                       const char *diff3_cmd,
-                       const apr_array_header_t *merge_options,
-                       const apr_array_header_t *prop_diff,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *result_pool,
-                       apr_pool_t *scratch_pool)
+/* Implement svn_wc__internal_merge() with an optional DIFF3 as in
+   svn_wc__merge_with_diff3(). */
+static svn_error_t *
+internal_merge(svn_skel_t **work_items,
+               svn_skel_t **conflict_skel,
+               enum svn_wc_merge_outcome_t *merge_outcome,
+               svn_wc__db_t *db,
+               const char *left_abspath,
+               const char *right_abspath,
+               const char *target_abspath,
+               const char *wri_abspath,
+               const char *left_label,
+               const char *right_label,
+               const char *target_label,
+               apr_hash_t *old_actual_props,
+               svn_boolean_t dry_run,
+               const char *diff3_cmd,
+               const apr_array_header_t *merge_options,
+               const apr_array_header_t *prop_diff,
+               svn_diff_t *diff3,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
 {
   const char *detranslated_target_abspath;
   svn_boolean_t is_binary = FALSE;
@@ -1116,6 +1139,8 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   mt.prop_diff = prop_diff;
   mt.diff3_cmd = diff3_cmd;
   mt.merge_options = merge_options;
+  mt.diff3 = diff3;
+  mt.diff3_left_abspath = left_abspath;
 
   /* Decide if the merge target is a text or binary file. */
   if ((mimeprop = get_prop(prop_diff, SVN_PROP_MIME_TYPE))
@@ -1200,29 +1225,64 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_merge(svn_skel_t **work_items,
+                       svn_skel_t **conflict_skel,
+                       enum svn_wc_merge_outcome_t *merge_outcome,
+                       svn_wc__db_t *db,
+                       const char *left_abspath,
+                       const char *right_abspath,
+                       const char *target_abspath,
+                       const char *wri_abspath,
+                       const char *left_label,
+                       const char *right_label,
+                       const char *target_label,
+                       apr_hash_t *old_actual_props,
+                       svn_boolean_t dry_run,
+                       const char *diff3_cmd,
+                       const apr_array_header_t *merge_options,
+                       const apr_array_header_t *prop_diff,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(internal_merge(work_items, conflict_skel,
+                                        merge_outcome, db,
+                                        left_abspath, right_abspath,
+                                        target_abspath, wri_abspath,
+                                        left_label, right_label,
+                                        target_label, old_actual_props,
+                                        dry_run, diff3_cmd, merge_options,
+                                        prop_diff, NULL,
+                                        cancel_func, cancel_baton,
+                                        result_pool, scratch_pool));
+}
+
 
 svn_error_t *
-svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
-              enum svn_wc_notify_state_t *merge_props_outcome,
-              svn_wc_context_t *wc_ctx,
-              const char *left_abspath,
-              const char *right_abspath,
-              const char *target_abspath,
-              const char *left_label,
-              const char *right_label,
-              const char *target_label,
-              const svn_wc_conflict_version_t *left_version,
-              const svn_wc_conflict_version_t *right_version,
-              svn_boolean_t dry_run,
-              const char *diff3_cmd,
-              const apr_array_header_t *merge_options,
-              apr_hash_t *original_props,
-              const apr_array_header_t *prop_diff,
-              svn_wc_conflict_resolver_func2_t conflict_func,
-              void *conflict_baton,
-              svn_cancel_func_t cancel_func,
-              void *cancel_baton,
-              apr_pool_t *scratch_pool)
+svn_wc__merge_with_diff3(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                         enum svn_wc_notify_state_t *merge_props_outcome,
+                         svn_wc_context_t *wc_ctx,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const svn_wc_conflict_version_t *left_version,
+                         const svn_wc_conflict_version_t *right_version,
+                         svn_boolean_t dry_run,
+                         const char *diff3_cmd,
+                         const apr_array_header_t *merge_options,
+                         apr_hash_t *original_props,
+                         const apr_array_header_t *prop_diff,
+                         svn_diff_t *diff3,
+                         svn_wc_conflict_resolver_func2_t conflict_func,
+                         void *conflict_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
 {
   const char *dir_abspath = svn_dirent_dirname(target_abspath, scratch_pool);
   svn_skel_t *work_items;
@@ -1342,22 +1402,23 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
     }
 
   /* Merge the text. */
-  SVN_ERR(svn_wc__internal_merge(&work_items,
-                                 &conflict_skel,
-                                 merge_content_outcome,
-                                 wc_ctx->db,
-                                 left_abspath,
-                                 right_abspath,
-                                 target_abspath,
-                                 target_abspath,
-                                 left_label, right_label, target_label,
-                                 old_actual_props,
-                                 dry_run,
-                                 diff3_cmd,
-                                 merge_options,
-                                 prop_diff,
-                                 cancel_func, cancel_baton,
-                                 scratch_pool, scratch_pool));
+  SVN_ERR(internal_merge(&work_items,
+                         &conflict_skel,
+                         merge_content_outcome,
+                         wc_ctx->db,
+                         left_abspath,
+                         right_abspath,
+                         target_abspath,
+                         target_abspath,
+                         left_label, right_label, target_label,
+                         old_actual_props,
+                         dry_run,
+                         diff3_cmd,
+                         merge_options,
+                         prop_diff,
+                         diff3,
+                         cancel_func, cancel_baton,
+                         scratch_pool, scratch_pool));
 
   /* If this isn't a dry run, then update the DB, run the work, and
    * call the conflict resolver callback.  */
@@ -1426,3 +1487,50 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
+              enum svn_wc_notify_state_t *merge_props_outcome,
+              svn_wc_context_t *wc_ctx,
+              const char *left_abspath,
+              const char *right_abspath,
+              const char *target_abspath,
+              const char *left_label,
+              const char *right_label,
+              const char *target_label,
+              const svn_wc_conflict_version_t *left_version,
+              const svn_wc_conflict_version_t *right_version,
+              svn_boolean_t dry_run,
+              const char *diff3_cmd,
+              const apr_array_header_t *merge_options,
+              apr_hash_t *original_props,
+              const apr_array_header_t *prop_diff,
+              svn_wc_conflict_resolver_func2_t conflict_func,
+              void *conflict_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_wc__merge_with_diff3(merge_content_outcome,
+                                                  merge_props_outcome,
+                                                  wc_ctx,
+                                                  left_abspath,
+                                                  right_abspath,
+                                                  target_abspath,
+                                                  left_label,
+                                                  right_label,
+                                                  target_label,
+                                                  left_version,
+                                                  right_version,
+                                                  dry_run,
+                                                  diff3_cmd,
+                                                  merge_options,
+                                                  original_props,
+                                                  prop_diff,
+                                                  NULL,
+                                                  conflict_func,
+                                                  conflict_baton,
+                                                  cancel_func,
+                                                  cancel_baton,
+                                                  scratch_pool));
+}
@@ -78,70 +78,56 @@
 */
 
 
-/* Set *MODIFIED_P to TRUE if (after translation) VERSIONED_FILE_ABSPATH
- * (of VERSIONED_FILE_SIZE bytes) differs from PRISTINE_STREAM (of
- * PRISTINE_SIZE bytes), else to FALSE if not.
+/* What we need to know to compare a working file with its pristine text,
+   as collected by prepare_compare(). */
+struct svn_wc__text_compare_t
+{
+  /* The working file and its size and timestamp on disk. */
+  const char *local_abspath;
+  svn_filesize_t working_size;
+  apr_time_t working_mtime;
+
+  /* The pristine text and its size. */
+  const char *pristine_abspath;
+  svn_filesize_t pristine_size;
+
+  /* Which way to translate, see compare_texts(). */
+  svn_boolean_t exact_comparison;
+
+  /* Translation parameters, derived from the file's properties. */
+  svn_boolean_t need_translation;
+  svn_subst_eol_style_t eol_style;
+  const char *eol_str;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+};
+
+/* Set *MODIFIED_P to TRUE if (after translation) the working file of
+ * COMPARE differs from PRISTINE_STREAM, else to FALSE if not.
  *
- * If EXACT_COMPARISON is FALSE, translate VERSIONED_FILE_ABSPATH's EOL
+ * If COMPARE->EXACT_COMPARISON is FALSE, translate the working file's EOL
  * style and keywords to repository-normal form according to its properties,
  * and compare the result with PRISTINE_STREAM.  If EXACT_COMPARISON is
  * TRUE, translate PRISTINE_STREAM's EOL style and keywords to working-copy
- * form according to VERSIONED_FILE_ABSPATH's properties, and compare the
- * result with VERSIONED_FILE_ABSPATH.
- *
- * HAS_PROPS should be TRUE if the file had properties when it was not
- * modified, otherwise FALSE.
- *
- * PROPS_MOD should be TRUE if the file's properties have been changed,
- * otherwise FALSE.
+ * form according to the file's properties, and compare the result with the
+ * working file.
  *
  * PRISTINE_STREAM will be closed before a successful return.
  *
- * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
+ * This does not access the working copy database.  Use SCRATCH_POOL for
+ * temporary allocation.
  */
 static svn_error_t *
-compare_and_verify(svn_boolean_t *modified_p,
-                   svn_wc__db_t *db,
-                   const char *versioned_file_abspath,
-                   svn_filesize_t versioned_file_size,
-                   svn_stream_t *pristine_stream,
-                   svn_filesize_t pristine_size,
-                   svn_boolean_t has_props,
-                   svn_boolean_t props_mod,
-                   svn_boolean_t exact_comparison,
-                   apr_pool_t *scratch_pool)
+compare_texts(svn_boolean_t *modified_p,
+              const svn_wc__text_compare_t *compare,
+              svn_stream_t *pristine_stream,
+              apr_pool_t *scratch_pool)
 {
   svn_boolean_t same;
-  svn_subst_eol_style_t eol_style;
-  const char *eol_str;
-  apr_hash_t *keywords;
-  svn_boolean_t special = FALSE;
-  svn_boolean_t need_translation;
   svn_stream_t *v_stream; /* versioned_file */
 
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(versioned_file_abspath));
-
-  if (props_mod)
-    has_props = TRUE; /* Maybe it didn't have properties; but it has now */
-
-  if (has_props)
-    {
-      SVN_ERR(svn_wc__get_translate_info(&eol_style, &eol_str,
-                                         &keywords,
-                                         &special,
-                                         db, versioned_file_abspath, NULL,
-                                         !exact_comparison,
-                                         scratch_pool, scratch_pool));
-
-      need_translation = svn_subst_translation_required(eol_style, eol_str,
-                                                        keywords, special,
-                                                        TRUE);
-    }
-  else
-    need_translation = FALSE;
-
-  if (! need_translation
-      && (versioned_file_size != pristine_size))
+  if (! compare->need_translation
+      && (compare->working_size != compare->pristine_size))
     {
       *modified_p = TRUE;
 
@@ -152,9 +138,9 @@ compare_and_verify(svn_boolean_t *modified_p,
   /* ### Other checks possible? */
 
   /* Reading files is necessary. */
-  if (special && need_translation)
+  if (compare->special && compare->need_translation)
     {
-      SVN_ERR(svn_subst_read_specialfile(&v_stream, versioned_file_abspath,
+      SVN_ERR(svn_subst_read_specialfile(&v_stream, compare->local_abspath,
                                           scratch_pool, scratch_pool));
     }
   else
@@ -162,18 +148,20 @@ compare_and_verify(svn_boolean_t *modified_p,
       /* We don't use APR-level buffering because the comparison function
        * will do its own buffering. */
       apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, versioned_file_abspath, APR_READ,
+      SVN_ERR(svn_io_file_open(&file, compare->local_abspath, APR_READ,
                                APR_OS_DEFAULT, scratch_pool));
       v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
 
-      if (need_translation)
+      if (compare->need_translation)
         {
-          if (!exact_comparison)
+          const char *eol_str = compare->eol_str;
+
+          if (!compare->exact_comparison)
             {
-              if (eol_style == svn_subst_eol_style_native)
+              if (compare->eol_style == svn_subst_eol_style_native)
                 eol_str = SVN_SUBST_NATIVE_EOL_STR;
-              else if (eol_style != svn_subst_eol_style_fixed
-                       && eol_style != svn_subst_eol_style_none)
+              else if (compare->eol_style != svn_subst_eol_style_fixed
+                       && compare->eol_style != svn_subst_eol_style_none)
                 return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
                                         svn_stream_close(v_stream), NULL);
 
@@ -182,7 +170,7 @@ compare_and_verify(svn_boolean_t *modified_p,
               v_stream = svn_subst_stream_translated(v_stream,
                                                      eol_str,
                                                      TRUE /* repair */,
-                                                     keywords,
+                                                     compare->keywords,
                                                      FALSE /* expand */,
                                                      scratch_pool);
             }
@@ -192,7 +180,8 @@ compare_and_verify(svn_boolean_t *modified_p,
                * arrange to throw an error if its EOL style is inconsistent. */
               pristine_stream = svn_subst_stream_translated(pristine_stream,
                                                             eol_str, FALSE,
-                                                            keywords, TRUE,
+                                                            compare->keywords,
+                                                            TRUE,
                                                             scratch_pool);
             }
         }
@@ -206,37 +195,49 @@ compare_and_verify(svn_boolean_t *modified_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
-                                 svn_wc__db_t *db,
-                                 const char *local_abspath,
-                                 svn_boolean_t exact_comparison,
-                                 apr_pool_t *scratch_pool)
+/* Read what is needed to tell whether LOCAL_ABSPATH in DB is modified.
+ *
+ * If that can be decided without reading any file contents, set *COMPARE
+ * to NULL and *MODIFIED_P to the result.  Otherwise, set *COMPARE to the
+ * information for compare_texts() and *CHECKSUM to the SHA-1 checksum of
+ * the pristine text.
+ *
+ * EXACT_COMPARISON is as for svn_wc__internal_file_modified_p().  Allocate
+ * the results in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+prepare_compare(svn_wc__text_compare_t **compare,
+                const svn_checksum_t **checksum,
+                svn_boolean_t *modified_p,
+                svn_wc__db_t *db,
+                const char *local_abspath,
+                svn_boolean_t exact_comparison,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
-  svn_stream_t *pristine_stream;
-  svn_filesize_t pristine_size;
   svn_wc__db_status_t status;
   svn_node_kind_t kind;
-  const svn_checksum_t *checksum;
   svn_filesize_t recorded_size;
   apr_time_t recorded_mod_time;
   svn_boolean_t has_props;
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
 
+  *compare = NULL;
+
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
-                               NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
+                               NULL, NULL, NULL, checksum, NULL, NULL, NULL,
                                NULL, NULL, NULL,
                                &recorded_size, &recorded_mod_time,
                                NULL, NULL, NULL, &has_props, &props_mod,
                                NULL, NULL, NULL,
                                db, local_abspath,
-                               scratch_pool, scratch_pool));
+                               result_pool, scratch_pool));
 
   /* If we don't have a pristine or the node has a status that allows a
      pristine, just say that the node is modified */
-  if (!checksum
+  if (!*checksum
       || (kind != svn_node_file)
       || ((status != svn_wc__db_status_normal)
           && (status != svn_wc__db_status_added)))
@@ -302,19 +303,79 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
-  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
+  *compare = apr_pcalloc(result_pool, sizeof(**compare));
+  (*compare)->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  (*compare)->working_size = dirent->filesize;
+  (*compare)->working_mtime = dirent->mtime;
+  (*compare)->exact_comparison = exact_comparison;
+
+  if (props_mod)
+    has_props = TRUE; /* Maybe it didn't have properties; but it has now */
+
+  if (has_props)
+    {
+      SVN_ERR(svn_wc__get_translate_info(&(*compare)->eol_style,
+                                         &(*compare)->eol_str,
+                                         &(*compare)->keywords,
+                                         &(*compare)->special,
+                                         db, local_abspath, NULL,
+                                         !exact_comparison,
+                                         result_pool, scratch_pool));
+
+      (*compare)->need_translation
+        = svn_subst_translation_required((*compare)->eol_style,
+                                         (*compare)->eol_str,
+                                         (*compare)->keywords,
+                                         (*compare)->special, TRUE);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement the "timestamp repair" of svn_wc__internal_file_modified_p()
+   for the unmodified file described by COMPARE. */
+static svn_error_t *
+repair_timestamp(svn_wc__db_t *db,
+                 const svn_wc__text_compare_t *compare,
+                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t own_lock;
+
+  SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, compare->local_abspath,
+                                      FALSE, scratch_pool));
+  if (own_lock)
+    SVN_ERR(svn_wc__db_global_record_fileinfo(db, compare->local_abspath,
+                                              compare->working_size,
+                                              compare->working_mtime,
+                                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
+                                 svn_wc__db_t *db,
+                                 const char *local_abspath,
+                                 svn_boolean_t exact_comparison,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__text_compare_t *compare;
+  const svn_checksum_t *checksum;
+  svn_stream_t *pristine_stream;
+
+  SVN_ERR(prepare_compare(&compare, &checksum, modified_p, db, local_abspath,
+                          exact_comparison, scratch_pool, scratch_pool));
+  if (!compare)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &compare->pristine_size,
                                    db, local_abspath, checksum,
                                    scratch_pool, scratch_pool));
 
   /* Check all bytes, and verify checksum if requested. */
   {
     svn_error_t *err;
-    err = compare_and_verify(modified_p, db,
-                             local_abspath, dirent->filesize,
-                             pristine_stream, pristine_size,
-                             has_props, props_mod,
-                             exact_comparison,
-                             scratch_pool);
+    err = compare_texts(modified_p, compare, pristine_stream, scratch_pool);
 
     /* At this point we already opened the pristine file, so we know that
        the access denied applies to the working copy path */
@@ -324,23 +385,66 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
       SVN_ERR(err);
   }
 
+  /* The timestamp is missing or "broken" so "repair" it if we can. */
   if (!*modified_p)
-    {
-      svn_boolean_t own_lock;
-
-      /* The timestamp is missing or "broken" so "repair" it if we can. */
-      SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
-                                          scratch_pool));
-      if (own_lock)
-        SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
-                                                  dirent->filesize,
-                                                  dirent->mtime,
-                                                  scratch_pool));
-    }
+    SVN_ERR(repair_timestamp(db, compare, scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__text_compare_prepare(svn_wc__text_compare_t **compare,
+                             svn_boolean_t *modified_p,
+                             svn_wc__db_t *db,
+                             const char *local_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  const svn_checksum_t *checksum;
+  const char *wcroot_abspath;
+
+  SVN_ERR(prepare_compare(compare, &checksum, modified_p, db, local_abspath,
+                          FALSE, result_pool, scratch_pool));
+  if (!*compare)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_pristine_read(NULL, &(*compare)->pristine_size,
+                                   db, local_abspath, checksum,
+                                   scratch_pool, scratch_pool));
+
+  /* Don't use svn_wc__db_pristine_get_path(), which would expand
+     compressed pristine texts just for comparing them. */
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                scratch_pool, scratch_pool));
+  return svn_error_trace(svn_wc__db_pristine_get_future_path(
+                                   &(*compare)->pristine_abspath,
+                                   wcroot_abspath, checksum,
+                                   result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_compare_run(svn_boolean_t *modified_p,
+                         const svn_wc__text_compare_t *compare,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stream_t *pristine_stream;
+
+  SVN_ERR(svn_wc__db_pristine_open_future_path(&pristine_stream,
+                                               compare->pristine_abspath,
+                                               scratch_pool, scratch_pool));
+
+  return svn_error_trace(compare_texts(modified_p, compare, pristine_stream,
+                                       scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_compare_finish(svn_wc__db_t *db,
+                            const svn_wc__text_compare_t *compare,
+                            apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(repair_timestamp(db, compare, scratch_pool));
+}
+
 
 svn_error_t *
 svn_wc_text_modified_p2(svn_boolean_t *modified_p,
@@ -706,7 +810,7 @@ svn_wc__node_has_local_mods(svn_boolean_t *modified,
 
   err = svn_wc__internal_walk_status(db, local_abspath,
                                      svn_depth_infinity,
-                                     FALSE, FALSE, FALSE, NULL,
+                                     FALSE, FALSE, FALSE, FALSE, NULL,
                                      modcheck_callback, &modcheck_baton,
                                      cancel_func, cancel_baton,
                                      scratch_pool);
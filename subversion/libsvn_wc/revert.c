@@ -246,9 +246,68 @@ revert_restore_handle_copied_dirs(svn_boolean_t *removed_self,
   return SVN_NO_ERROR;
 }
 
+/* The number of queued file installs after which revert_restore() adds
+   them to the work queue and runs it. */
+#define REVERT_WQ_BATCH_SIZE 1000
+
+/* File installs queued while reverting a tree.  They are added to the work
+   queue in batches, each in a single transaction, and the work queue then
+   installs the files of a batch in parallel. */
+typedef struct revert_wq_t
+{
+  /* Where to add the work items */
+  svn_wc__db_t *db;
+  const char *wri_abspath;
+
+  /* Work items not yet added to the work queue, or NULL, allocated in POOL,
+     and their number */
+  svn_skel_t *work_items;
+  int count;
+  apr_pool_t *pool;
+} revert_wq_t;
+
+/* Queue the installation of the pristine of LOCAL_ABSPATH in WQ. */
+static svn_error_t *
+queue_file_install(revert_wq_t *wq,
+                   const char *local_abspath,
+                   svn_boolean_t use_commit_times,
+                   apr_pool_t *scratch_pool)
+{
+  svn_skel_t *work_item;
+
+  SVN_ERR(svn_wc__wq_build_file_install(&work_item, wq->db, local_abspath,
+                                        NULL, use_commit_times, TRUE,
+                                        wq->pool, scratch_pool));
+  wq->work_items = svn_wc__wq_merge(wq->work_items, work_item, wq->pool);
+  wq->count++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the work items queued in WQ to the work queue and run it. */
+static svn_error_t *
+flush_revert_wq(revert_wq_t *wq,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  if (!wq->work_items)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_wq_add(wq->db, wq->wri_abspath, wq->work_items,
+                            scratch_pool));
+  svn_pool_clear(wq->pool);
+  wq->work_items = NULL;
+  wq->count = 0;
+
+  return svn_error_trace(svn_wc__wq_run(wq->db, wq->wri_abspath,
+                                        cancel_func, cancel_baton,
+                                        scratch_pool));
+}
+
 /* Forward definition */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(revert_wq_t *wq,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -271,14 +330,14 @@ revert_wc_data(svn_boolean_t *run_wq,
    REVERT_ROOT is true for explicit revert targets and FALSE for targets
    reached via recursion.
 
-   Sets *RUN_WQ to TRUE when the caller should (eventually) run the workqueue.
-   (The function sets it to FALSE when it has run the WQ itself)
+   Queues the files to install in WQ, which the caller should eventually
+   flush with flush_revert_wq().
 
    If INFO is NULL, LOCAL_ABSPATH doesn't exist in DB. Otherwise INFO
    specifies the state of LOCAL_ABSPATH in DB.
  */
 static svn_error_t *
-revert_restore(svn_boolean_t *run_wq,
+revert_restore(revert_wq_t *wq,
                svn_wc__db_t *db,
                const char *local_abspath,
                svn_depth_t depth,
@@ -373,7 +432,7 @@ revert_restore(svn_boolean_t *run_wq,
 
   if (!metadata_only)
     {
-      SVN_ERR(revert_wc_data(run_wq,
+      SVN_ERR(revert_wc_data(wq,
                              &notify_required,
                              db, local_abspath, status, kind,
                              reverted_kind, recorded_size, recorded_time,
@@ -426,7 +485,7 @@ revert_restore(svn_boolean_t *run_wq,
 
           child_abspath = svn_dirent_join(local_abspath, child_name, iterpool);
 
-          SVN_ERR(revert_restore(run_wq,
+          SVN_ERR(revert_restore(wq,
                                  db, child_abspath, depth, metadata_only,
                                  use_commit_times, FALSE /* revert root */,
                                  apr_hash_this_val(hi),
@@ -435,13 +494,9 @@ revert_restore(svn_boolean_t *run_wq,
                                  iterpool));
         }
 
-      /* Run the queue per directory */
-      if (*run_wq)
-        {
-          SVN_ERR(svn_wc__wq_run(db, local_abspath, cancel_func, cancel_baton,
-                                 iterpool));
-          *run_wq = FALSE;
-        }
+      /* Install the files queued so far, once there are enough of them */
+      if (wq->count >= REVERT_WQ_BATCH_SIZE)
+        SVN_ERR(flush_revert_wq(wq, cancel_func, cancel_baton, iterpool));
 
       svn_pool_destroy(iterpool);
     }
@@ -455,7 +510,7 @@ revert_restore(svn_boolean_t *run_wq,
 
 /* Perform the in-working copy revert of LOCAL_ABSPATH, to what is stored in DB */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(revert_wq_t *wq,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -688,16 +743,8 @@ revert_wc_data(svn_boolean_t *run_wq,
         SVN_ERR(svn_io_dir_make(local_abspath, APR_OS_DEFAULT, scratch_pool));
 
       if (kind == svn_node_file)
-        {
-          svn_skel_t *work_item;
-
-          SVN_ERR(svn_wc__wq_build_file_install(&work_item, db, local_abspath,
-                                                NULL, use_commit_times, TRUE,
-                                                scratch_pool, scratch_pool));
-          SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item,
-                                    scratch_pool));
-          *run_wq = TRUE;
-        }
+        SVN_ERR(queue_file_install(wq, local_abspath, use_commit_times,
+                                   scratch_pool));
       *notify_required = TRUE;
     }
 
@@ -720,7 +767,7 @@ revert(svn_wc__db_t *db,
 {
   svn_error_t *err;
   const struct svn_wc__db_info_t *info = NULL;
-  svn_boolean_t run_queue = FALSE;
+  revert_wq_t wq = { 0 };
 
   SVN_ERR_ASSERT(depth == svn_depth_empty || depth == svn_depth_infinity);
 
@@ -758,19 +805,24 @@ revert(svn_wc__db_t *db,
         }
     }
 
+  wq.db = db;
+  wq.wri_abspath = local_abspath;
+  wq.pool = svn_pool_create(scratch_pool);
+
   if (!err)
     err = svn_error_trace(
-              revert_restore(&run_queue, db, local_abspath, depth, metadata_only,
+              revert_restore(&wq, db, local_abspath, depth, metadata_only,
                              use_commit_times, TRUE /* revert root */,
                              info, cancel_func, cancel_baton,
                              notify_func, notify_baton,
                              scratch_pool));
 
-  if (run_queue)
-    err = svn_error_compose_create(err,
-                                   svn_wc__wq_run(db, local_abspath,
-                                                  cancel_func, cancel_baton,
-                                                  scratch_pool));
+  /* Install what was queued even if reverting failed half-way, as the
+     database has been reverted already. */
+  err = svn_error_compose_create(err,
+                                 flush_revert_wq(&wq, cancel_func,
+                                                 cancel_baton,
+                                                 scratch_pool));
 
   err = svn_error_compose_create(err,
                                  svn_wc__db_revert_list_done(db,
@@ -46,8 +46,10 @@
 
 #include "wc.h"
 #include "props.h"
+#include "journal.h"
 
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
@@ -76,6 +78,9 @@ typedef struct svn_wc__internal_status_t
 
 
 /*** Baton used for walking the local status */
+/* See below. */
+typedef struct text_checker_t text_checker_t;
+
 struct walk_status_baton
 {
   /* The DB handle for managing the working copy state. */
@@ -100,6 +105,27 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /*** Bulk read node information ***/
+  /* If not NULL, the svn_wc__db_dir_children_t of all directories below
+     DESCENDANTS_ABSPATH, read from the working copy at
+     DESCENDANTS_WCROOT_ABSPATH. */
+  apr_hash_t *descendants;
+  const char *descendants_abspath;
+  const char *descendants_wcroot_abspath;
+
+  /* Compares file contents ahead of the walk, if not NULL. */
+  text_checker_t *text_checker;
+
+  /*** Change journal ***/
+  /* If not NULL, the change journal of the working copy at
+     JOURNAL_WCROOT_ABSPATH. */
+  svn_wc__journal_t *journal;
+  const char *journal_wcroot_abspath;
+
+  /* If not NULL, we are priming JOURNAL and collect the relpaths of all
+     directories whose on-disk state differs from the recorded state. */
+  apr_array_header_t *journal_changed;
 };
 
 /*** Editor batons ***/
@@ -308,6 +334,302 @@ get_repos_root_url_relpath(const char **repos_relpath,
   return SVN_NO_ERROR;
 }
 
+/* Content comparisons running concurrently ahead of the status walk.
+   get_dir_status() queues the files that need one and assemble_status()
+   picks up the results, so the status callbacks are still invoked in the
+   same order.  All members are only used by the thread running the
+   status walk. */
+struct text_checker_t
+{
+  /* Parent of the job pools.  It must outlive SET, so it is created
+     before the pool that SET lives in. */
+  apr_pool_t *jobs_pool;
+
+  /* Runs text_check_task() for the jobs. */
+  svn_task__set_t *set;
+
+  /* Number of queued jobs whose results have not been delivered yet. */
+  int pending;
+
+  /* Don't queue more jobs while this many are pending. */
+  int max_pending;
+
+  /* Jobs whose result has not been picked up yet.
+     const char *local_abspath -> text_check_job_t *. */
+  apr_hash_t *jobs;
+};
+
+/* The content comparison of one file. */
+typedef struct text_check_job_t
+{
+  /* Private pool of this job.  All members below are allocated in it. */
+  apr_pool_t *pool;
+
+  svn_wc__text_compare_t *compare;
+
+  /* The result, valid once DONE has been set. */
+  svn_boolean_t modified;
+  svn_error_t *err;
+  svn_boolean_t done;
+
+  /* Set if nobody is going to pick up the result.  The job will then be
+     released as soon as it is done. */
+  svn_boolean_t discarded;
+
+  text_checker_t *checker;
+} text_check_job_t;
+
+/* Result of text_check_task(). */
+typedef struct text_check_result_t
+{
+  text_check_job_t *job;
+  svn_boolean_t modified;
+  svn_error_t *err;
+} text_check_result_t;
+
+/* Release JOB and its unused result. */
+static void
+release_text_check(text_check_job_t *job)
+{
+  svn_error_clear(job->err);
+  svn_pool_destroy(job->pool);
+}
+
+/* Implements svn_task__process_func_t.  Compare the file of the
+   text_check_job_t in PROCESS_BATON and return a text_check_result_t in
+   *RESULT.  Failures get reported through the result as the regular
+   code path will report them again. */
+static svn_error_t *
+text_check_task(void **result,
+                void *process_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  text_check_job_t *job = process_baton;
+  text_check_result_t *check = apr_pcalloc(result_pool, sizeof(*check));
+
+  check->job = job;
+  check->err = svn_wc__text_compare_run(&check->modified, job->compare,
+                                        scratch_pool);
+
+  *result = check;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Hand the text_check_result_t in
+   RESULT over to its job. */
+static svn_error_t *
+deliver_text_check(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  text_check_result_t *check = result;
+  text_check_job_t *job = check->job;
+
+  job->modified = check->modified;
+  job->err = check->err;
+  job->done = TRUE;
+  job->checker->pending--;
+
+  if (job->discarded)
+    release_text_check(job);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove JOB from its checker and release it, once it is done. */
+static void
+discard_text_check(text_check_job_t *job)
+{
+  svn_hash_sets(job->checker->jobs, job->compare->local_abspath, NULL);
+
+  if (job->done)
+    release_text_check(job);
+  else
+    job->discarded = TRUE;
+}
+
+/* Return TRUE if assemble_status() will have to compare the contents of
+   the file with INFO and DIRENT with its pristine text, as far as we can
+   tell in advance. */
+static svn_boolean_t
+needs_text_check(const struct svn_wc__db_info_t *info,
+                 const svn_io_dirent2_t *dirent)
+{
+  return (info
+          && info->kind == svn_node_file
+          && (info->status == svn_wc__db_status_normal
+              || info->status == svn_wc__db_status_added)
+          && info->has_checksum
+          && !info->special
+          && dirent
+          && dirent->kind == svn_node_file
+          && !dirent->special
+          && (info->recorded_size == SVN_INVALID_FILESIZE
+              || info->recorded_time == 0
+              || info->recorded_size != dirent->filesize
+              || info->recorded_time != dirent->mtime));
+}
+
+/* Queue the content comparisons that the children of DIR_ABSPATH in
+   SORTED_CHILDREN will need, starting at index *NEXT, as long as fewer
+   than CHECKER->MAX_PENDING jobs are pending.  Advance *NEXT accordingly.
+   NODES and DIRENTS map the child names to their information as in
+   get_dir_status().  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_text_checks(text_checker_t *checker,
+                  int *next,
+                  const apr_array_header_t *sorted_children,
+                  const char *dir_abspath,
+                  apr_hash_t *nodes,
+                  apr_hash_t *dirents,
+                  svn_wc__db_t *db,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (   *next < sorted_children->nelts
+         && checker->pending < checker->max_pending)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, *next,
+                                              svn_sort__item_t);
+      text_check_job_t *job;
+      apr_pool_t *pool;
+      svn_boolean_t modified;
+      svn_error_t *err;
+
+      ++*next;
+      if (!needs_text_check(apr_hash_get(nodes, item->key, item->klen),
+                            apr_hash_get(dirents, item->key, item->klen)))
+        continue;
+
+      svn_pool_clear(iterpool);
+      pool = svn_pool_create(checker->jobs_pool);
+      job = apr_pcalloc(pool, sizeof(*job));
+      job->pool = pool;
+      job->checker = checker;
+
+      /* Any problems will be reported by the regular code path. */
+      err = svn_wc__text_compare_prepare(&job->compare, &modified, db,
+                                         svn_dirent_join(dir_abspath,
+                                                         item->key,
+                                                         iterpool),
+                                         pool, iterpool);
+      if (err || !job->compare)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(pool);
+          continue;
+        }
+
+      svn_hash_sets(checker->jobs, job->compare->local_abspath, job);
+      checker->pending++;
+      SVN_ERR(svn_task__add(checker->set, text_check_task, job));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Discard the results for the children of DIR_ABSPATH among the first
+   COUNT entries of SORTED_CHILDREN that have not been picked up. */
+static void
+discard_text_checks(text_checker_t *checker,
+                    int count,
+                    const apr_array_header_t *sorted_children,
+                    const char *dir_abspath,
+                    apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < count && apr_hash_count(checker->jobs); i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, i,
+                                              svn_sort__item_t);
+      text_check_job_t *job;
+
+      job = svn_hash_gets(checker->jobs,
+                          svn_dirent_join(dir_abspath, item->key,
+                                          scratch_pool));
+      if (job)
+        discard_text_check(job);
+    }
+}
+
+/* Set *CHECKER to a new text checker running up to JOBS comparisons
+   concurrently.  Outstanding comparisons will be cancelled and all jobs
+   released when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+start_text_checker(text_checker_t **checker,
+                   int jobs,
+                   apr_pool_t *result_pool)
+{
+  text_checker_t *tc = apr_pcalloc(result_pool, sizeof(*tc));
+
+  tc->max_pending = 2 * jobs;
+  tc->jobs = apr_hash_make(result_pool);
+
+  /* Sub-pools get destroyed in reverse order of creation, so the task set
+     will be gone before the jobs that its tasks use. */
+  tc->jobs_pool = svn_pool_create(result_pool);
+  SVN_ERR(svn_task__set_create(&tc->set, jobs, deliver_text_check, tc,
+                               NULL, NULL, svn_pool_create(result_pool)));
+
+  *checker = tc;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MODIFIED_P like svn_wc__internal_file_modified_p() with
+   EXACT_COMPARISON set to FALSE would for LOCAL_ABSPATH in DB.  Use the
+   result of CHECKER's workers if they compared the file already.  CHECKER
+   may be NULL. */
+static svn_error_t *
+check_text_modified(svn_boolean_t *modified_p,
+                    text_checker_t *checker,
+                    svn_wc__db_t *db,
+                    const char *local_abspath,
+                    apr_pool_t *scratch_pool)
+{
+  text_check_job_t *job = checker ? svn_hash_gets(checker->jobs,
+                                                  local_abspath)
+                                  : NULL;
+
+  if (job)
+    {
+      svn_hash_sets(checker->jobs, local_abspath, NULL);
+
+      /* This waits for all queued jobs but there are at most
+         MAX_PENDING of them. */
+      if (!job->done)
+        SVN_ERR(svn_task__set_finish(checker->set));
+
+      if (!job->err)
+        {
+          svn_error_t *err = SVN_NO_ERROR;
+
+          *modified_p = job->modified;
+          if (!job->modified)
+            err = svn_wc__text_compare_finish(db, job->compare,
+                                              scratch_pool);
+
+          svn_pool_destroy(job->pool);
+          return svn_error_trace(err);
+        }
+
+      /* Let the regular code below report the problem. */
+      release_text_check(job);
+    }
+
+  return svn_error_trace(svn_wc__internal_file_modified_p(modified_p, db,
+                                                          local_abspath,
+                                                          FALSE,
+                                                          scratch_pool));
+}
+
 static svn_error_t *
 internal_status(svn_wc__internal_status_t **status,
                 svn_wc__db_t *db,
@@ -334,10 +656,14 @@ internal_status(svn_wc__internal_status_t **status,
    do not adjust the result for missing working copy files.
 
    The status struct's repos_lock field will be set to REPOS_LOCK.
+
+   TEXT_CHECKER, if not NULL, may hold the result of the text modification
+   check of LOCAL_ABSPATH.
 */
 static svn_error_t *
 assemble_status(svn_wc__internal_status_t **status,
                 svn_wc__db_t *db,
+                text_checker_t *text_checker,
                 const char *local_abspath,
                 const char *parent_repos_root_url,
                 const char *parent_repos_relpath,
@@ -471,9 +797,8 @@ assemble_status(svn_wc__internal_status_t **status,
           else
             {
               svn_error_t *err;
-              err = svn_wc__internal_file_modified_p(&text_modified_p,
-                                                     db, local_abspath,
-                                                     FALSE, scratch_pool);
+              err = check_text_modified(&text_modified_p, text_checker,
+                                        db, local_abspath, scratch_pool);
 
               if (err)
                 {
@@ -826,7 +1151,8 @@ send_status_structure(const struct walk_status_baton *wb,
         }
     }
 
-  SVN_ERR(assemble_status(&statstruct, wb->db, local_abspath,
+  SVN_ERR(assemble_status(&statstruct, wb->db, wb->text_checker,
+                          local_abspath,
                           parent_repos_root_url, parent_repos_relpath,
                           parent_repos_uuid,
                           info, dirent, get_all,
@@ -1188,6 +1514,236 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/* Like svn_wc__db_read_children_info() for the directory LOCAL_ABSPATH,
+   but take the information from WB->DESCENDANTS if that covers it. */
+static svn_error_t *
+read_children_info(apr_hash_t **nodes,
+                   apr_hash_t **conflicts,
+                   const struct walk_status_baton *wb,
+                   const char *local_abspath,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const char *relpath = NULL;
+
+  if (wb->descendants)
+    relpath = svn_dirent_skip_ancestor(wb->descendants_abspath,
+                                       local_abspath);
+
+  if (relpath)
+    {
+      const char *wcroot_abspath;
+
+      /* A nested working copy has its own database. */
+      SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, wb->db, local_abspath,
+                                    scratch_pool, scratch_pool));
+
+      if (strcmp(wcroot_abspath, wb->descendants_wcroot_abspath) == 0)
+        {
+          const svn_wc__db_dir_children_t *children;
+
+          children = svn_hash_gets(wb->descendants, relpath);
+          if (children)
+            {
+              *nodes = children->nodes;
+              *conflicts = children->conflicts;
+            }
+          else
+            {
+              *nodes = apr_hash_make(result_pool);
+              *conflicts = apr_hash_make(result_pool);
+            }
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_trace(svn_wc__db_read_children_info(nodes, conflicts,
+                                                       wb->db, local_abspath,
+                                                       !wb->check_working_copy,
+                                                       result_pool,
+                                                       scratch_pool));
+}
+
+/* Set *RELPATH to the relpath of the directory LOCAL_ABSPATH in the
+   working copy of WB->JOURNAL, or to NULL if the journal doesn't cover
+   LOCAL_ABSPATH.  Allocate *RELPATH in RESULT_POOL. */
+static svn_error_t *
+get_journal_relpath(const char **relpath,
+                    const struct walk_status_baton *wb,
+                    const char *local_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *wcroot_abspath;
+
+  *relpath = NULL;
+  if (!wb->journal
+      || !svn_dirent_is_ancestor(wb->journal_wcroot_abspath, local_abspath))
+    return SVN_NO_ERROR;
+
+  /* A nested working copy has its own journal. */
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, wb->db, local_abspath,
+                                scratch_pool, scratch_pool));
+  if (strcmp(wcroot_abspath, wb->journal_wcroot_abspath) == 0)
+    *relpath = svn_dirent_skip_ancestor(wcroot_abspath,
+                                        apr_pstrdup(result_pool,
+                                                    local_abspath));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ON_DISK to whether the node described by INFO should exist in
+   the working copy.  Return FALSE if that can't be told from INFO. */
+static svn_boolean_t
+expected_on_disk(svn_boolean_t *on_disk,
+                 const struct svn_wc__db_info_t *info)
+{
+  switch (info->status)
+    {
+      case svn_wc__db_status_normal:
+      case svn_wc__db_status_added:
+      case svn_wc__db_status_moved_here:
+      case svn_wc__db_status_copied:
+        *on_disk = TRUE;
+        return (info->kind == svn_node_file
+                || info->kind == svn_node_symlink
+                || info->kind == svn_node_dir)
+               && !info->incomplete;
+
+      case svn_wc__db_status_deleted:
+      case svn_wc__db_status_not_present:
+      case svn_wc__db_status_excluded:
+      case svn_wc__db_status_server_excluded:
+      case svn_wc__db_status_base_deleted:
+        *on_disk = FALSE;
+        return TRUE;
+
+      default:
+        return FALSE;
+    }
+}
+
+/* Return TRUE if DIRENTS, the on-disk children of a directory, are
+   exactly the nodes that the working copy recorded in NODES and CONFLICTS,
+   so that journal_dirents() can find them without reading the directory. */
+static svn_boolean_t
+dirents_match_nodes(apr_hash_t *dirents,
+                    apr_hash_t *nodes,
+                    apr_hash_t *conflicts,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  /* Unversioned and ignored items. */
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+
+      if (!svn_hash_gets(nodes, name)
+          && !svn_wc_is_adm_dir(name, scratch_pool))
+        return FALSE;
+    }
+
+  /* Unversioned tree conflict victims. */
+  for (hi = apr_hash_first(scratch_pool, conflicts); hi;
+       hi = apr_hash_next(hi))
+    {
+      if (!svn_hash_gets(nodes, apr_hash_this_key(hi)))
+        return FALSE;
+    }
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent = svn_hash_gets(dirents,
+                                                     apr_hash_this_key(hi));
+      svn_boolean_t on_disk;
+
+      if (!expected_on_disk(&on_disk, info) || on_disk != (dirent != NULL))
+        return FALSE;
+
+      if (!dirent)
+        continue;
+
+      if (info->kind == svn_node_dir)
+        {
+          if (dirent->kind != svn_node_dir || dirent->special)
+            return FALSE;
+        }
+      else if (dirent->kind != svn_node_file)
+        return FALSE;
+#ifdef HAVE_SYMLINK
+      else if (dirent->special != info->special)
+        return FALSE;
+#endif
+    }
+
+  return TRUE;
+}
+
+/* Set *DIRENTS to the dirents of the directory LOCAL_ABSPATH, whose
+   children on disk match NODES as determined by dirents_match_nodes() when
+   the journal was primed.  If ONLY_CHECK_TYPE is FALSE, stat every child.
+
+   Writes through shared memory mappings don't produce file system events,
+   so the journal may miss content changes; only the list of children can
+   be taken from it.  Allocate *DIRENTS in RESULT_POOL. */
+static svn_error_t *
+journal_dirents(apr_hash_t **dirents,
+                apr_hash_t *nodes,
+                const char *local_abspath,
+                svn_boolean_t only_check_type,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *dirents = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent;
+      svn_boolean_t on_disk;
+
+      if (!expected_on_disk(&on_disk, info) || !on_disk)
+        continue;
+
+      svn_pool_clear(iterpool);
+      if (only_check_type)
+        {
+          svn_io_dirent2_t *type_dirent = svn_io_dirent2_create(result_pool);
+
+          if (info->kind == svn_node_dir)
+            type_dirent->kind = svn_node_dir;
+          else
+            {
+              type_dirent->kind = svn_node_file;
+#ifdef HAVE_SYMLINK
+              type_dirent->special = info->special;
+#endif
+            }
+          dirent = type_dirent;
+        }
+      else
+        {
+          SVN_ERR(svn_io_stat_dirent2(&dirent,
+                                      svn_dirent_join(local_abspath, name,
+                                                      iterpool),
+                                      FALSE, TRUE, result_pool, iterpool));
+          if (dirent->kind == svn_node_none)
+            continue;
+        }
+
+      svn_hash_sets(*dirents, name, dirent);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1234,8 +1790,11 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
   apr_pool_t *iterpool;
+  const char *journal_relpath;
+  svn_boolean_t use_journal = FALSE;
   svn_error_t *err;
   int i;
+  int next_check = 0;
 
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
@@ -1245,7 +1804,21 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  if (wb->check_working_copy)
+  SVN_ERR(get_journal_relpath(&journal_relpath, wb, local_abspath,
+                              scratch_pool, iterpool));
+
+  /* A directory whose list of children has not changed since the journal
+     was primed holds what its nodes describe; we build its dirents
+     below. */
+  if (journal_relpath
+      && dirent && dirent->kind == svn_node_dir && !dirent->special
+      && svn_wc__journal_is_clean(wb->journal)
+      && !svn_wc__journal_changed(wb->journal, journal_relpath, iterpool))
+    {
+      use_journal = TRUE;
+      dirents = NULL;
+    }
+  else if (wb->check_working_copy)
     {
       err = svn_io_get_dirents3(&dirents, local_abspath,
                                 wb->ignore_text_mods /* only_check_type*/,
@@ -1278,10 +1851,16 @@ get_dir_status(const struct walk_status_baton *wb,
   /* Create a hash containing all children.  The source hashes
      don't all map the same types, but only the keys of the result
      hash are subsequently used. */
-  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
-                                        wb->db, local_abspath,
-                                        !wb->check_working_copy,
-                                        scratch_pool, iterpool));
+  SVN_ERR(read_children_info(&nodes, &conflicts, wb, local_abspath,
+                             scratch_pool, iterpool));
+
+  if (use_journal)
+    SVN_ERR(journal_dirents(&dirents, nodes, local_abspath,
+                            wb->ignore_text_mods, scratch_pool, iterpool));
+  else if (journal_relpath && wb->journal_changed
+           && !dirents_match_nodes(dirents, nodes, conflicts, iterpool))
+    APR_ARRAY_PUSH(wb->journal_changed, const char *)
+      = apr_pstrdup(wb->journal_changed->pool, journal_relpath);
 
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
@@ -1351,6 +1930,12 @@ get_dir_status(const struct walk_status_baton *wb,
 
       svn_pool_clear(iterpool);
 
+      /* Keep the workers busy with the files ahead of us. */
+      if (wb->text_checker)
+        SVN_ERR(queue_text_checks(wb->text_checker, &next_check,
+                                  sorted_children, local_abspath,
+                                  nodes, dirents, wb->db, iterpool));
+
       item = APR_ARRAY_IDX(sorted_children, i, svn_sort__item_t);
       key = item.key;
       klen = item.klen;
@@ -1381,6 +1966,11 @@ get_dir_status(const struct walk_status_baton *wb,
                                iterpool));
     }
 
+  /* Release the results that assemble_status() did not ask for. */
+  if (wb->text_checker)
+    discard_text_checks(wb->text_checker, next_check, sorted_children,
+                        local_abspath, iterpool);
+
   /* Destroy our subpools. */
   svn_pool_destroy(iterpool);
 
@@ -2444,7 +3034,8 @@ close_edit(void *edit_baton,
                                        eb->default_depth,
                                        eb->get_all,
                                        eb->no_ignore,
-                                       FALSE,
+                                       FALSE /* ignore_text_mods */,
+                                       TRUE /* use_journal */,
                                        eb->ignores,
                                        eb->status_func,
                                        eb->status_baton,
@@ -2626,6 +3217,7 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              svn_boolean_t get_all,
                              svn_boolean_t no_ignore,
                              svn_boolean_t ignore_text_mods,
+                             svn_boolean_t use_journal,
                              const apr_array_header_t *ignore_patterns,
                              svn_wc_status_func4_t status_func,
                              void *status_baton,
@@ -2644,6 +3236,13 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.descendants = NULL;
+  wb.descendants_abspath = NULL;
+  wb.descendants_wcroot_abspath = NULL;
+  wb.text_checker = NULL;
+  wb.journal = NULL;
+  wb.journal_wcroot_abspath = NULL;
+  wb.journal_changed = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +3289,49 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      /* We are going to visit every directory, so read the information
+         on all nodes at once rather than directory by directory. */
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        {
+          SVN_ERR(svn_wc__db_read_descendants_info(
+                                        &wb.descendants,
+                                        &wb.descendants_wcroot_abspath,
+                                        db, local_abspath,
+                                        !wb.check_working_copy,
+                                        scratch_pool, scratch_pool));
+          wb.descendants_abspath = local_abspath;
+        }
+
+      /* If a watcher keeps a journal of this working copy, we only need to
+         list the directories that it saw changing. */
+      if (use_journal)
+        {
+          SVN_ERR(svn_wc__db_get_wcroot(&wb.journal_wcroot_abspath, db,
+                                        local_abspath,
+                                        scratch_pool, scratch_pool));
+          SVN_ERR(svn_wc__journal_open(&wb.journal,
+                                       wb.journal_wcroot_abspath,
+                                       scratch_pool, scratch_pool));
+        }
+
+      /* A new journal must first be primed by a full walk. */
+      if (wb.journal && !svn_wc__journal_is_clean(wb.journal))
+        {
+          if (!ignore_text_mods
+              && (depth == svn_depth_infinity || depth == svn_depth_unknown)
+              && strcmp(local_abspath, wb.journal_wcroot_abspath) == 0)
+            wb.journal_changed = apr_array_make(scratch_pool, 16,
+                                                sizeof(const char *));
+          else
+            wb.journal = NULL;
+        }
+
+      if (!wb.ignore_text_mods && depth != svn_depth_empty
+          && svn_wc__db_get_status_jobs(db) > 1)
+        SVN_ERR(start_text_checker(&wb.text_checker,
+                                   svn_wc__db_get_status_jobs(db),
+                                   scratch_pool));
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +3345,10 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      if (wb.journal_changed)
+        SVN_ERR(svn_wc__journal_finish_priming(wb.journal, wb.journal_changed,
+                                               scratch_pool));
     }
   else
     {
@@ -2756,6 +3402,36 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                                         get_all,
                                         no_ignore,
                                         ignore_text_mods,
+                                        FALSE /* use_journal */,
+                                        ignore_patterns,
+                                        status_func,
+                                        status_baton,
+                                        cancel_func,
+                                        cancel_baton,
+                                        scratch_pool));
+}
+
+svn_error_t *
+svn_wc__walk_status_journaled(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_boolean_t no_ignore,
+                              const apr_array_header_t *ignore_patterns,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(
+           svn_wc__internal_walk_status(wc_ctx->db,
+                                        local_abspath,
+                                        depth,
+                                        get_all,
+                                        no_ignore,
+                                        FALSE /* ignore_text_mods */,
+                                        TRUE /* use_journal */,
                                         ignore_patterns,
                                         status_func,
                                         status_baton,
@@ -2892,7 +3568,7 @@ internal_status(svn_wc__internal_status_t **status,
       parent_repos_uuid = NULL;
     }
 
-  return svn_error_trace(assemble_status(status, db, local_abspath,
+  return svn_error_trace(assemble_status(status, db, NULL, local_abspath,
                                          parent_repos_root_url,
                                          parent_repos_relpath,
                                          parent_repos_uuid,
@@ -52,6 +52,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_editor.h"
+#include "private/svn_task.h"
 
 /* Checks whether a svn_wc__db_status_t indicates whether a node is
    present in a working copy. Used by the editor implementation */
@@ -404,6 +405,10 @@ struct handler_baton
   /* Where we are assembling the new file. */
   svn_wc__db_install_data_t *install_data;
 
+  /* Where we are writing a copy of the new file that may become the
+     working file, or NULL. */
+  const char *working_abspath;
+
     /* The expected source checksum of the text source or NULL if no base
      checksum is available (MD5 if the server provides a checksum, SHA1 if
      the server doesn't) */
@@ -743,6 +748,11 @@ struct file_baton
   const svn_checksum_t *new_text_base_md5_checksum;
   const svn_checksum_t *new_text_base_sha1_checksum;
 
+  /* A temporary file holding a copy of the new text base, written while
+     applying the delta, that may become the working file.  NULL if the
+     file needs translation or local modifications may have to be merged. */
+  const char *new_working_abspath;
+
   /* The checksum of the file before the update */
   const svn_checksum_t *original_checksum;
 
@@ -970,6 +980,7 @@ window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct handler_baton *hb = baton;
   struct file_baton *fb = hb->fb;
+  const char *working_abspath = hb->working_abspath;
   svn_error_t *err;
 
   /* Apply this window.  We may be done at that point.  */
@@ -1026,14 +1037,21 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       /* Store the new pristine text in the pristine store now.  Later, in a
          single transaction we will update the BASE_NODE to include a
          reference to this pristine text's checksum. */
-      SVN_ERR(svn_wc__db_pristine_install(hb->install_data,
-                                          fb->new_text_base_sha1_checksum,
-                                          fb->new_text_base_md5_checksum,
-                                          hb->pool));
+      err = svn_wc__db_pristine_install(hb->install_data,
+                                        fb->new_text_base_sha1_checksum,
+                                        fb->new_text_base_md5_checksum,
+                                        hb->pool);
+      if (!err)
+        fb->new_working_abspath = working_abspath;
     }
 
   svn_pool_destroy(hb->pool);
 
+  /* The copy of the text is closed now, so we can remove it even on
+     Windows.  WORKING_ABSPATH is allocated in FB->POOL. */
+  if (err && working_abspath)
+    svn_error_clear(svn_io_remove_file2(working_abspath, TRUE, fb->pool));
+
   return err;
 }
 
@@ -3567,6 +3585,155 @@ lazy_open_source(svn_stream_t **stream,
   return SVN_NO_ERROR;
 }
 
+/* Hash the new texts of files larger than this concurrently, so that
+   hashing overlaps with applying the delta and writing the files. */
+#define ASYNC_HASH_THRESHOLD (1024 * 1024)
+
+/* Hand the data over to the hashing task in chunks of this size. */
+#define ASYNC_HASH_CHUNK_SIZE (1024 * 1024)
+
+/* Baton for the stream returned by hashing_stream(). */
+typedef struct hash_baton_t
+{
+  /* The stream to pass all data on to. */
+  svn_stream_t *inner;
+
+  /* Where to store the SHA-1 checksum when the stream gets closed. */
+  svn_checksum_t **checksum;
+  svn_checksum_ctx_t *ctx;
+
+  /* Number of bytes hashed by the writer so far. */
+  apr_size_t hashed;
+
+  /* The pool the stream was allocated in. */
+  apr_pool_t *pool;
+
+  /* Runs hash_task() for one chunk at a time.  NULL while the writer
+     does the hashing itself. */
+  svn_task__set_t *set;
+
+  /* Data waiting to be hashed, and the data being hashed by the task. */
+  svn_stringbuf_t *queued;
+  svn_stringbuf_t *hashing;
+} hash_baton_t;
+
+/* Implements svn_task__process_func_t.  Add the data in the HASHING
+   buffer of the hash_baton_t in PROCESS_BATON to its checksum.  There is
+   never more than one of these tasks, so they are serialized. */
+static svn_error_t *
+hash_task(void **result,
+          void *process_baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  hash_baton_t *hb = process_baton;
+
+  SVN_ERR(svn_checksum_update(hb->ctx, hb->hashing->data,
+                              hb->hashing->len));
+  svn_stringbuf_setempty(hb->hashing);
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the hashing task of HB, then start a new one for the data
+   queued so far. */
+static svn_error_t *
+hash_queued(hash_baton_t *hb)
+{
+  svn_stringbuf_t *tmp;
+
+  SVN_ERR(svn_task__set_finish(hb->set));
+
+  tmp = hb->queued;
+  hb->queued = hb->hashing;
+  hb->hashing = tmp;
+
+  return svn_error_trace(svn_task__add(hb->set, hash_task, hb));
+}
+
+/* Implements svn_write_fn_t for the stream returned by hashing_stream(). */
+static svn_error_t *
+hash_write(void *baton,
+           const char *data,
+           apr_size_t *len)
+{
+  hash_baton_t *hb = baton;
+
+  if (hb->set)
+    {
+      svn_stringbuf_appendbytes(hb->queued, data, *len);
+      if (hb->queued->len >= ASYNC_HASH_CHUNK_SIZE)
+        SVN_ERR(hash_queued(hb));
+    }
+  else
+    {
+      SVN_ERR(svn_checksum_update(hb->ctx, data, *len));
+      hb->hashed += *len;
+
+      /* Small files are hashed faster than we could hand them over. */
+      if (hb->hashed >= ASYNC_HASH_THRESHOLD
+          && svn_task__get_thread_limit() > 0)
+        {
+          /* The set pool is a sub-pool of the stream's pool, so any
+             running task will be waited for before the buffers and the
+             checksum context go away. */
+          SVN_ERR(svn_task__set_create(&hb->set, 1, NULL, NULL, NULL, NULL,
+                                       svn_pool_create(hb->pool)));
+          hb->queued = svn_stringbuf_create_ensure(ASYNC_HASH_CHUNK_SIZE,
+                                                   hb->pool);
+          hb->hashing = svn_stringbuf_create_ensure(ASYNC_HASH_CHUNK_SIZE,
+                                                    hb->pool);
+        }
+    }
+
+  return svn_error_trace(svn_stream_write(hb->inner, data, len));
+}
+
+/* Implements svn_close_fn_t for the stream returned by hashing_stream(). */
+static svn_error_t *
+hash_close(void *baton)
+{
+  hash_baton_t *hb = baton;
+
+  if (hb->set)
+    {
+      if (!svn_stringbuf_isempty(hb->queued))
+        SVN_ERR(hash_queued(hb));
+
+      SVN_ERR(svn_task__set_finish(hb->set));
+    }
+
+  SVN_ERR(svn_checksum_final(hb->checksum, hb->ctx, hb->pool));
+
+  return svn_error_trace(svn_stream_close(hb->inner));
+}
+
+/* Return a stream passing all data on to INNER, that sets *CHECKSUM to the
+   SHA-1 checksum of that data when closed.  The data of larger files is
+   hashed concurrently.  Allocate the stream in RESULT_POOL. */
+static svn_stream_t *
+hashing_stream(svn_checksum_t **checksum,
+               svn_stream_t *inner,
+               apr_pool_t *result_pool)
+{
+  hash_baton_t *hb = apr_pcalloc(result_pool, sizeof(*hb));
+  svn_stream_t *stream;
+
+  hb->inner = inner;
+  hb->checksum = checksum;
+  hb->ctx = svn_checksum_ctx_create(svn_checksum_sha1, result_pool);
+  hb->pool = result_pool;
+
+  stream = svn_stream_create(hb, result_pool);
+  svn_stream_set_write(stream, hash_write);
+  svn_stream_set_close(stream, hash_close);
+
+  return stream;
+}
+
 /* Implements svn_stream_lazyopen_func_t. */
 static svn_error_t *
 lazy_open_target(svn_stream_t **stream,
@@ -3584,14 +3751,86 @@ lazy_open_target(svn_stream_t **stream,
      HB->INSTALL_DATA unchanged on error. */
   SVN_ERR(svn_wc__db_pristine_prepare_install(stream,
                                               &install_data,
-                                              &hb->new_text_base_sha1_checksum,
-                                              NULL,
+                                              NULL, NULL,
                                               hb->fb->edit_baton->db,
                                               hb->fb->dir_baton->local_abspath,
                                               result_pool, scratch_pool));
 
   hb->install_data = install_data;
+  *stream = hashing_stream(&hb->new_text_base_sha1_checksum, *stream,
+                           result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if PROPS, which may be NULL, or PROPCHANGES, which may be
+   NULL as well, set a property that makes the working file differ from
+   its text base. */
+static svn_boolean_t
+has_translation_props(apr_hash_t *props,
+                      const apr_array_header_t *propchanges)
+{
+  static const char *const names[] =
+    { SVN_PROP_SPECIAL, SVN_PROP_EOL_STYLE, SVN_PROP_KEYWORDS, NULL };
+  int i, j;
+
+  for (i = 0; names[i]; i++)
+    {
+      if (props && svn_hash_gets(props, names[i]))
+        return TRUE;
+
+      for (j = 0; propchanges && j < propchanges->nelts; j++)
+        {
+          const svn_prop_t *prop = &APR_ARRAY_IDX(propchanges, j,
+                                                  svn_prop_t);
+
+          if (prop->value && strcmp(prop->name, names[i]) == 0)
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Set *LIKELY to TRUE if the new text of the file described by FB will
+   most likely be installed as the working file without translation, as
+   far as we can tell before close_file() gets called. */
+static svn_error_t *
+likely_installed_as_is(svn_boolean_t *likely,
+                       struct file_baton *fb,
+                       apr_pool_t *scratch_pool)
+{
+  struct edit_baton *eb = fb->edit_baton;
+  apr_hash_t *props = NULL;
+
+  *likely = FALSE;
+
+  if (fb->shadowed || fb->obstruction_found || fb->edit_obstructed
+      || fb->add_existed)
+    return SVN_NO_ERROR;
+
+  if (! fb->adding_file)
+    {
+      svn_boolean_t modified;
+      svn_error_t *err;
+
+      /* merge_file() will check again, so don't fail the update here. */
+      err = svn_wc__internal_file_modified_p(&modified, eb->db,
+                                             fb->local_abspath, FALSE,
+                                             scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      if (modified)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_wc__db_read_props(&props, eb->db, fb->local_abspath,
+                                    scratch_pool, scratch_pool));
+    }
 
+  *likely = !has_translation_props(props, fb->propchanges);
   return SVN_NO_ERROR;
 }
 
@@ -3611,6 +3850,7 @@ apply_textdelta(void *file_baton,
   svn_checksum_t *expected_base_checksum;
   svn_stream_t *source;
   svn_stream_t *target;
+  svn_boolean_t install_as_is;
 
   if (fb->skip_this)
     {
@@ -3705,6 +3945,27 @@ apply_textdelta(void *file_baton,
 
   target = svn_stream_lazyopen_create(lazy_open_target, hb, TRUE, handler_pool);
 
+  /* If the new text is going to become the working file as is, write it
+     there in the same pass, instead of reading the pristine text again
+     when running the work queue. */
+  SVN_ERR(likely_installed_as_is(&install_as_is, fb, pool));
+  if (install_as_is)
+    {
+      const char *temp_dir_abspath;
+      const char *working_abspath;
+      svn_stream_t *working_stream;
+
+      SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath, eb->db,
+                                             eb->wcroot_abspath,
+                                             pool, pool));
+      SVN_ERR(svn_stream_open_unique(&working_stream, &working_abspath,
+                                     temp_dir_abspath, svn_io_file_del_none,
+                                     handler_pool, pool));
+
+      hb->working_abspath = apr_pstrdup(fb->pool, working_abspath);
+      target = svn_stream_tee(target, working_stream, handler_pool);
+    }
+
   /* Prepare to apply the delta.  */
   svn_txdelta_apply(source, target,
                     hb->new_text_base_md5_digest,
@@ -4385,6 +4646,10 @@ close_file(void *file_baton,
                 }
               svn_error_clear(err);
 
+              if (fb->new_working_abspath)
+                SVN_ERR(svn_io_remove_file2(fb->new_working_abspath, TRUE,
+                                            scratch_pool));
+
               SVN_ERR(remember_skipped_tree(eb, fb->local_abspath,
                                             scratch_pool));
               fb->skip_this = TRUE;
@@ -4408,7 +4673,27 @@ close_file(void *file_baton,
             content_state = svn_wc_notify_state_unchanged;
         }
 
-      if (install_pristine)
+      if (install_pristine
+          && install_from == NULL
+          && fb->new_working_abspath
+          && !has_translation_props(new_actual_props, NULL))
+        {
+          /* Move the copy of the pristine text we wrote while applying
+             the delta into place. */
+          install_from = fb->new_working_abspath;
+          fb->new_working_abspath = NULL;
+
+          SVN_ERR(svn_wc__wq_build_file_install_moved(&work_item,
+                                                      eb->db,
+                                                      fb->local_abspath,
+                                                      install_from,
+                                                      eb->use_commit_times,
+                                                      scratch_pool,
+                                                      scratch_pool));
+          all_work_items = svn_wc__wq_merge(all_work_items, work_item,
+                                            scratch_pool);
+        }
+      else if (install_pristine)
         {
           svn_boolean_t record_fileinfo;
 
@@ -4463,6 +4748,12 @@ close_file(void *file_baton,
           all_work_items = svn_wc__wq_merge(all_work_items, work_item,
                                             scratch_pool);
         }
+
+      /* Remove the copy of the new text if it didn't become the working
+         file after all. */
+      if (fb->new_working_abspath)
+        SVN_ERR(svn_io_remove_file2(fb->new_working_abspath, TRUE,
+                                    scratch_pool));
     }
   else
     {
@@ -88,9 +88,10 @@ CREATE TABLE PRISTINE (
      pristine texts referenced from this database. */
   checksum  TEXT NOT NULL PRIMARY KEY,
 
-  /* Enumerated values specifying type of compression. The only value
-     supported so far is NULL, meaning that no compression has been applied
-     and the pristine text is stored verbatim in the file. */
+  /* Enumerated values specifying type of compression. NULL means that no
+     compression has been applied and the pristine text is stored verbatim
+     in the file.  Since format 32, 1 means that the text is stored as LZ4
+     compressed blocks in a file with the extension '.svn-lz4'. */
   compression  INTEGER,
 
   /* The size in bytes of the file in which the pristine text is stored.
@@ -905,21 +906,10 @@ WHERE l.op_depth = 0
 
 
 /* ------------------------------------------------------------------------- */
-/* Format 32 ....  */
+/* Format 32 allows compressed pristine texts.  Older clients would not
+   find these, so the bump keeps them out.  No data changes are needed.  */
 -- STMT_UPGRADE_TO_32
-
-/* Drop old index. ### Remove this part from the upgrade to 31 once bumped */
-DROP INDEX IF EXISTS I_ACTUAL_CHANGELIST;
-DROP INDEX IF EXISTS I_EXTERNALS_PARENT;
-CREATE INDEX I_EXTERNALS_PARENT ON EXTERNALS (wc_id, parent_relpath);
-
-DROP INDEX I_NODES_PARENT;
-CREATE UNIQUE INDEX I_NODES_PARENT ON NODES (wc_id, parent_relpath,
-                                             local_relpath, op_depth);
-
-DROP INDEX I_ACTUAL_PARENT;
-CREATE UNIQUE INDEX I_ACTUAL_PARENT ON ACTUAL_NODE (wc_id, parent_relpath,
-                                                    local_relpath);
+PRAGMA user_version = 32;
 
 /* ------------------------------------------------------------------------- */
 
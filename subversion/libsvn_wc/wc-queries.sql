@@ -152,6 +152,31 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
 WHERE wc_id = ?1 AND parent_relpath = ?2 AND op_depth = 0
 ORDER BY local_relpath DESC
 
+-- STMT_SELECT_NODE_DESCENDANTS_INFO
+/* Like STMT_SELECT_NODE_CHILDREN_INFO, but for all descendants. All rows of
+   a node are still returned together and in the same order. */
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, lock_token, lock_owner,
+  lock_comment, lock_date, local_relpath, moved_here, moved_to, file_external
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath AND nodes.op_depth = 0
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+ORDER BY local_relpath DESC, op_depth DESC
+
+-- STMT_SELECT_BASE_NODE_DESCENDANTS_INFO
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, lock_token, lock_owner,
+  lock_comment, lock_date, local_relpath, moved_here, moved_to, file_external
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND op_depth = 0
+ORDER BY local_relpath DESC
+
 -- STMT_SELECT_NODE_CHILDREN_WALKER_INFO
 SELECT local_relpath, op_depth, presence, kind
 FROM nodes_current
@@ -163,6 +188,11 @@ SELECT local_relpath, changelist, properties, conflict_data
 FROM actual_node
 WHERE wc_id = ?1 AND parent_relpath = ?2
 
+-- STMT_SELECT_ACTUAL_DESCENDANTS_INFO
+SELECT local_relpath, changelist, properties, conflict_data
+FROM actual_node
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+
 -- STMT_SELECT_REPOSITORY_BY_ID
 SELECT root, uuid FROM repository WHERE id = ?1
 
@@ -555,6 +585,12 @@ WHERE wc_id = ?1 AND local_relpath = ?2
   AND op_depth = (SELECT MAX(op_depth) FROM nodes
                   WHERE wc_id = ?1 AND local_relpath = ?2)
 
+-- STMT_CLEAR_RACY_FILEINFO
+UPDATE nodes SET last_mod_time = 0
+WHERE wc_id = ?1
+  AND (last_mod_time > ?2
+       OR (last_mod_time > ?3 AND last_mod_time % 1000000 = 0))
+
 -- STMT_INSERT_ACTUAL_CONFLICT
 INSERT INTO actual_node (wc_id, local_relpath, conflict_data, parent_relpath)
 VALUES (?1, ?2, ?3, ?4)
@@ -872,13 +908,21 @@ SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
+-- STMT_SELECT_WORK_ITEMS_AFTER
+SELECT id, work FROM work_queue WHERE id > ?1 ORDER BY id LIMIT ?2
+
 -- STMT_INSERT_OR_IGNORE_PRISTINE
 INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
 VALUES (?1, ?2, ?3, 0)
 
 -- STMT_INSERT_PRISTINE
-INSERT INTO pristine (checksum, md5_checksum, size, refcount)
-VALUES (?1, ?2, ?3, 0)
+INSERT INTO pristine (checksum, md5_checksum, size, refcount, compression)
+VALUES (?1, ?2, ?3, 0, ?4)
+
+-- STMT_SELECT_PRISTINE_COMPRESSION
+SELECT compression
+FROM pristine
+WHERE checksum = ?1
 
 -- STMT_SELECT_PRISTINE
 SELECT md5_checksum
@@ -899,6 +943,7 @@ WHERE md5_checksum = ?1
 SELECT checksum
 FROM pristine
 WHERE refcount = 0
+LIMIT ?1
 
 -- STMT_DELETE_PRISTINE_IF_UNREFERENCED
 DELETE FROM pristine
@@ -926,6 +971,15 @@ WHERE wc_id = ?1
 -- STMT_VACUUM
 VACUUM
 
+/* Applies to new databases and to existing ones on their next VACUUM */
+-- STMT_ENABLE_INCREMENTAL_VACUUM
+PRAGMA auto_vacuum = INCREMENTAL
+
+/* Gives at most 1024 free pages back to the filesystem.  This is a no-op
+   unless incremental vacuum is enabled. */
+-- STMT_INCREMENTAL_VACUUM
+PRAGMA incremental_vacuum(1024)
+
 -- STMT_SELECT_CONFLICT_VICTIMS
 SELECT local_relpath, conflict_data
 FROM actual_node
@@ -1146,6 +1200,29 @@ WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = ?7
 UPDATE nodes SET revision = ?3
 WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
 
+/* Bump the revision of all BASE nodes in the subtree ?2 that aren't
+   there yet, and clear their cached inherited properties.  File externals
+   below ?2 are left alone. */
+-- STMT_UPDATE_BASE_REVISION_RECURSIVE
+UPDATE nodes SET revision = ?3, inherited_props = NULL
+WHERE wc_id = ?1
+  AND op_depth = 0
+  AND (local_relpath = ?2
+       OR (IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+           AND file_external IS NULL))
+  AND revision IS NOT ?3
+
+/* Remove the BASE nodes below ?2 that the server didn't re-add during an
+   update to revision ?3. */
+-- STMT_DELETE_BASE_NOT_PRESENT_RECURSIVE
+DELETE FROM nodes
+WHERE wc_id = ?1
+  AND op_depth = 0
+  AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND file_external IS NULL
+  AND (presence = MAP_NOT_PRESENT
+       OR (presence = MAP_SERVER_EXCLUDED AND revision IS NOT ?3))
+
 -- STMT_UPDATE_BASE_REPOS
 UPDATE nodes SET repos_id = ?3, repos_path = ?4
 WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
@@ -1560,17 +1637,6 @@ SELECT MIN(revision), MAX(revision),
     AND file_external IS NULL
     AND op_depth = 0
 
--- STMT_HAS_SPARSE_NODES
-SELECT 1 FROM nodes
-WHERE wc_id = ?1
-  AND (local_relpath = ?2
-       OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
-  AND op_depth = 0
-  AND (presence IN (MAP_SERVER_EXCLUDED, MAP_EXCLUDED)
-        OR depth NOT IN (MAP_DEPTH_INFINITY, MAP_DEPTH_UNKNOWN))
-  AND file_external IS NULL
-LIMIT 1
-
 -- STMT_SUBTREE_HAS_TREE_MODIFICATIONS
 SELECT 1 FROM nodes
 WHERE wc_id = ?1
@@ -1598,6 +1664,31 @@ WHERE wc_id = ?1
   AND repos_path IS NOT RELPATH_SKIP_JOIN(?2, ?3, local_relpath)
 LIMIT 1
 
+/* Everything svn_wc__db_revision_status() needs to know about the BASE
+   layer in one pass: the (changed) revision range, sparseness and whether
+   any node is switched relative to ?3, the repos_path of ?2. */
+-- STMT_SELECT_REVISION_STATUS
+SELECT MIN(CASE WHEN presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+                THEN revision END),
+       MAX(CASE WHEN presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+                THEN revision END),
+       MIN(CASE WHEN presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+                THEN changed_revision END),
+       MAX(CASE WHEN presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+                THEN changed_revision END),
+       MAX(presence IN (MAP_SERVER_EXCLUDED, MAP_EXCLUDED)
+           OR depth NOT IN (MAP_DEPTH_INFINITY, MAP_DEPTH_UNKNOWN)),
+       MAX(?3 IS NOT NULL
+           AND local_relpath != ?2
+           AND presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+           AND repos_path IS NOT RELPATH_SKIP_JOIN(?2, ?3, local_relpath))
+FROM nodes
+WHERE wc_id = ?1
+  AND (local_relpath = ?2
+       OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+  AND op_depth = 0
+  AND file_external IS NULL
+
 -- STMT_SELECT_MOVED_FROM_RELPATH
 SELECT local_relpath, op_depth FROM nodes
 WHERE wc_id = ?1 AND moved_to = ?2 AND op_depth > 0
@@ -160,10 +160,14 @@ extern "C" {
  * == 1.8.x shipped with format 31
  * == 1.9.x shipped with format 31
  *
+ * The bump to 32 allows pristine texts to be stored LZ4-compressed as
+ * '<SHA1>.svn-lz4', recorded in the compression column of the PRISTINE
+ * table.
+ *
  * Please document any further format changes here.
  */
 
-#define SVN_WC__VERSION 31
+#define SVN_WC__VERSION 32
 
 
 /* Formats <= this have no concept of "revert text-base/props".  */
@@ -195,6 +199,34 @@ extern "C" {
    sqlite_stat1 table on opening */
 #define SVN_WC__ENSURE_STAT1_TABLE 31
 
+/* Formats >= this may store pristine texts compressed. */
+#define SVN_WC__COMPRESSED_PRISTINES 32
+
+/* Default and upper limit for the number of threads comparing file
+   contents during status walks. */
+#define SVN_WC__DEFAULT_STATUS_JOBS 4
+#define SVN_WC__MAX_STATUS_JOBS 64
+
+/* Default and upper limit for the number of threads installing files
+   while running the work queue. */
+#define SVN_WC__DEFAULT_INSTALL_JOBS 1
+#define SVN_WC__MAX_INSTALL_JOBS 64
+
+/* Default and upper limit for the number of threads preparing text
+   deltas during commits. */
+#define SVN_WC__DEFAULT_COMMIT_JOBS 2
+#define SVN_WC__MAX_COMMIT_JOBS 64
+
+/* Don't use SQLite's write-ahead log for wc.db unless enabled in the
+   config.  It needs a writable wc.db-shm next to wc.db, which working
+   copies that are shared between users or only readable can't provide,
+   and file systems that can't share memory between processes are not
+   always detectable.  Retry busy databases after short sleeps.  This
+   only shortens the waits; writers still take turns on wc.db, even if
+   they work on disjoint subtrees. */
+#define SVN_WC__DEFAULT_SQLITE_WAL FALSE
+#define SVN_WC__DEFAULT_SQLITE_BUSY_BACKOFF TRUE
+
 /* Return a string indicating the released version (or versions) of
  * Subversion that used WC format number WC_FORMAT, or some other
  * suitable string if no released version used WC_FORMAT.
@@ -287,6 +319,8 @@ struct svn_wc_traversal_info_t
 #define SVN_WC__ADM_ENTRIES             "entries"
 #define SVN_WC__ADM_TMP                 "tmp"
 #define SVN_WC__ADM_PRISTINE            "pristine"
+#define SVN_WC__ADM_JOURNAL             "journal"
+#define SVN_WC__ADM_JOURNAL_BARRIER     "journal-barrier"
 #define SVN_WC__ADM_NONEXISTENT_PATH    "nonexistent-path"
 
 /* The basename of the ".prej" file, if a directory ever has property
@@ -348,6 +382,42 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool);
 
+/* svn_wc__internal_file_modified_p() with EXACT_COMPARISON set to FALSE,
+ * split into steps so the expensive content comparison can run on another
+ * thread.
+ */
+typedef struct svn_wc__text_compare_t svn_wc__text_compare_t;
+
+/* Do the first step for LOCAL_ABSPATH in DB.  If the result is known
+ * without reading file contents, set *COMPARE to NULL and *MODIFIED_P to
+ * the result.  Otherwise, set *COMPARE to the data for the next steps,
+ * allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_compare_prepare(svn_wc__text_compare_t **compare,
+                             svn_boolean_t *modified_p,
+                             svn_wc__db_t *db,
+                             const char *local_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Compare the contents as described by COMPARE and set *MODIFIED_P.
+ * This does not access the working copy database, so it may run on
+ * any thread that SCRATCH_POOL may be used from.
+ */
+svn_error_t *
+svn_wc__text_compare_run(svn_boolean_t *modified_p,
+                         const svn_wc__text_compare_t *compare,
+                         apr_pool_t *scratch_pool);
+
+/* Do the "timestamp repair" of svn_wc__internal_file_modified_p() in DB
+ * after svn_wc__text_compare_run() found the file of COMPARE unmodified.
+ */
+svn_error_t *
+svn_wc__text_compare_finish(svn_wc__db_t *db,
+                            const svn_wc__text_compare_t *compare,
+                            apr_pool_t *scratch_pool);
+
 
 /* Prepare to merge a file content change into the working copy.
 
@@ -518,7 +588,12 @@ svn_wc__internal_changelist_match(svn_wc__db_t *db,
                                   const apr_hash_t *clhash,
                                   apr_pool_t *scratch_pool);
 
-/* Library-internal version of svn_wc_walk_status(), which see. */
+/* Library-internal version of svn_wc_walk_status(), which see.
+
+   If USE_JOURNAL is TRUE, don't read directories from disk that the
+   change journal of the working copy (see journal.h) reports unchanged.
+   Only status reports may do that; the journal is not precise enough for
+   e.g. harvesting commit items. */
 svn_error_t *
 svn_wc__internal_walk_status(svn_wc__db_t *db,
                              const char *local_abspath,
@@ -526,6 +601,7 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              svn_boolean_t get_all,
                              svn_boolean_t no_ignore,
                              svn_boolean_t ignore_text_mods,
+                             svn_boolean_t use_journal,
                              const apr_array_header_t *ignore_patterns,
                              svn_wc_status_func4_t status_func,
                              void *status_baton,
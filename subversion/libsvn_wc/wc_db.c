@@ -1434,16 +1434,19 @@ create_db(svn_sqlite__db_t **sdb,
           svn_revnum_t root_node_revision,
           svn_depth_t root_node_depth,
           svn_boolean_t exclusive,
-          apr_int32_t timeout,
+          const svn_sqlite__open_options_t *sqlite_options,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
                                   svn_sqlite__mode_rwcreate, exclusive,
-                                  timeout,
+                                  sqlite_options,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
 
+  /* This must be set before any table is created. */
+  SVN_ERR(svn_sqlite__exec_statements(*sdb, STMT_ENABLE_INCREMENTAL_VACUUM));
+
   SVN_SQLITE__WITH_LOCK(init_db(repos_id, wc_id,
                                 *sdb, repos_root_url, repos_uuid,
                                 root_node_repos_relpath, root_node_revision,
@@ -1469,7 +1472,6 @@ svn_wc__db_init(svn_wc__db_t *db,
   apr_int64_t wc_id;
   svn_wc__db_wcroot_t *wcroot;
   svn_boolean_t sqlite_exclusive = FALSE;
-  apr_int32_t sqlite_timeout = 0; /* default timeout */
   apr_hash_index_t *hi;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
@@ -1490,7 +1492,7 @@ svn_wc__db_init(svn_wc__db_t *db,
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
                     repos_uuid, SDB_FILE,
                     repos_relpath, initial_rev, depth, sqlite_exclusive,
-                    sqlite_timeout,
+                    &db->sqlite_options,
                     db->state_pool, scratch_pool));
 
   /* Create the WCROOT for this directory.  */
@@ -1616,6 +1618,25 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
 }
 
 
+int
+svn_wc__db_get_status_jobs(svn_wc__db_t *db)
+{
+  return db->status_jobs;
+}
+
+int
+svn_wc__db_get_install_jobs(svn_wc__db_t *db)
+{
+  return db->install_jobs;
+}
+
+int
+svn_wc__db_get_commit_jobs(svn_wc__db_t *db)
+{
+  return db->commit_jobs;
+}
+
+
 svn_error_t *
 svn_wc__db_base_add_directory(svn_wc__db_t *db,
                               const char *local_abspath,
@@ -6049,6 +6070,15 @@ svn_wc__db_op_add_symlink(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* Timestamps with a fraction of a second come from file systems that
+   resolve at least this finely; some kernels only update them once per
+   clock tick, though. */
+#define HIRES_TIMESTAMP_GRANULE apr_time_from_msec(20)
+
+/* Whole second timestamps may come from file systems like FAT that
+   only store every other second. */
+#define COARSE_TIMESTAMP_GRANULE apr_time_from_sec(2)
+
 /* Record RECORDED_SIZE and RECORDED_TIME into top layer in NODES */
 static svn_error_t *
 db_record_fileinfo(svn_wc__db_wcroot_t *wcroot,
@@ -6068,6 +6098,79 @@ db_record_fileinfo(svn_wc__db_wcroot_t *wcroot,
 
   SVN_ERR_ASSERT(affected_rows == 1);
 
+  /* Until the granule containing RECORDED_TIME has passed, the file may
+     be modified without changing its timestamp. */
+  if (recorded_time > 0)
+    {
+      apr_time_t racy_until = recorded_time;
+
+      if (recorded_time % APR_USEC_PER_SEC)
+        racy_until += HIRES_TIMESTAMP_GRANULE;
+      else
+        racy_until += COARSE_TIMESTAMP_GRANULE;
+
+      if (racy_until > wcroot->racy_until)
+        wcroot->racy_until = racy_until;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_clear_racy_fileinfo_internal(svn_wc__db_wcroot_t *wcroot,
+                                        apr_pool_t *scratch_pool)
+{
+  apr_time_t now = apr_time_now();
+  svn_sqlite__stmt_t *stmt;
+  int affected_rows;
+
+  if (wcroot->racy_until <= now)
+    {
+      wcroot->racy_until = 0;
+      return SVN_NO_ERROR;
+    }
+
+  /* Timestamps older than one granule stay unambiguous: a modification
+     from now on will give the file a newer one. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_CLEAR_RACY_FILEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "iii", wcroot->wc_id,
+                            (apr_int64_t)(now - HIRES_TIMESTAMP_GRANULE),
+                            (apr_int64_t)(now - COARSE_TIMESTAMP_GRANULE)));
+  SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+
+  wcroot->racy_until = 0;
+
+  if (affected_rows)
+    SVN_ERR(flush_entries(wcroot, wcroot->abspath, svn_depth_infinity,
+                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_clear_racy_fileinfo(svn_wc__db_t *db,
+                               apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  /* Several directories map to the same wcroot, but only the first
+     visit of each finds a non-zero RACY_UNTIL. */
+  for (hi = apr_hash_first(scratch_pool, db->dir_data);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_wc__db_wcroot_t *wcroot = apr_hash_this_val(hi);
+
+      if (!wcroot->sdb || !wcroot->racy_until)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_wc__db_clear_racy_fileinfo_internal(wcroot, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
@@ -9274,12 +9377,60 @@ struct read_children_info_item_t
   svn_boolean_t was_dir;
 };
 
-/* Implementation of svn_wc__db_read_children_info */
+/* Set *CHILDREN to the entry in DIRS for the parent directory of
+   CHILD_RELPATH, which must be a descendant of DIR_RELPATH and end with
+   NAME.  Create the entry in RESULT_POOL if it does not exist yet.
+
+   *CHILDREN and *PARENT_RELPATH hold the entry and the directory of the
+   previous call, or NULL.  Siblings are usually processed one after
+   another, so this saves most of the lookups. */
+static void
+get_dir_children(svn_wc__db_dir_children_t **children,
+                 const char **parent_relpath,
+                 apr_hash_t *dirs,
+                 const char *dir_relpath,
+                 const char *child_relpath,
+                 const char *name,
+                 apr_pool_t *result_pool)
+{
+  apr_size_t parent_len = name - child_relpath;
+  const char *key;
+
+  /* Skip the separator, unless the parent is the WC root. */
+  if (parent_len)
+    parent_len--;
+
+  if (*children
+      && strncmp(*parent_relpath, child_relpath, parent_len) == 0
+      && (*parent_relpath)[parent_len] == '\0')
+    return;
+
+  *parent_relpath = apr_pstrmemdup(result_pool, child_relpath, parent_len);
+  key = svn_relpath_skip_ancestor(dir_relpath, *parent_relpath);
+
+  *children = svn_hash_gets(dirs, key);
+  if (!*children)
+    {
+      *children = apr_pcalloc(result_pool, sizeof(**children));
+      (*children)->nodes = apr_hash_make(result_pool);
+      (*children)->conflicts = apr_hash_make(result_pool);
+      svn_hash_sets(dirs, key, *children);
+    }
+}
+
+/* Implementation of svn_wc__db_read_children_info and
+   svn_wc__db_read_descendants_info.
+
+   If DIRS is NULL, read the immediate children of DIR_RELPATH into NODES
+   and CONFLICTS.  Otherwise, ignore NODES and CONFLICTS and read all
+   descendants of DIR_RELPATH into per-directory entries in DIRS; see
+   svn_wc__db_read_descendants_info(). */
 static svn_error_t *
 read_children_info(svn_wc__db_wcroot_t *wcroot,
                    const char *dir_relpath,
                    apr_hash_t *conflicts,
                    apr_hash_t *nodes,
+                   apr_hash_t *dirs,
                    svn_boolean_t base_tree_only,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
@@ -9290,11 +9441,18 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   const char *repos_uuid = NULL;
   apr_int64_t last_repos_id = INVALID_REPOS_ID;
   const char *last_repos_root_url = NULL;
+  svn_wc__db_dir_children_t *dir_children = NULL;
+  const char *dir_children_relpath = NULL;
+  int stmt_idx;
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    (base_tree_only
-                                     ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
-                                     : STMT_SELECT_NODE_CHILDREN_INFO)));
+  if (dirs)
+    stmt_idx = base_tree_only ? STMT_SELECT_BASE_NODE_DESCENDANTS_INFO
+                              : STMT_SELECT_NODE_DESCENDANTS_INFO;
+  else
+    stmt_idx = base_tree_only ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
+                              : STMT_SELECT_NODE_CHILDREN_INFO;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, stmt_idx));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9309,6 +9467,13 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
       int op_depth;
       svn_boolean_t new_child;
 
+      if (dirs)
+        {
+          get_dir_children(&dir_children, &dir_children_relpath, dirs,
+                           dir_relpath, child_relpath, name, result_pool);
+          nodes = dir_children->nodes;
+        }
+
       child_item = (base_tree_only ? NULL : svn_hash_gets(nodes, name));
       if (child_item)
         new_child = FALSE;
@@ -9419,7 +9584,11 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
 
           child->recorded_time = svn_sqlite__column_int64(stmt, 13);
           child->recorded_size = get_recorded_size(stmt, 7);
-          child->has_checksum = !svn_sqlite__column_is_null(stmt, 6);
+          err = svn_sqlite__column_checksum(&child->checksum, stmt, 6,
+                                            result_pool);
+          if (err)
+            SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+          child->has_checksum = (child->checksum != NULL);
           child->copied = op_depth > 0 && !svn_sqlite__column_is_null(stmt, 2);
           child->had_props = SQLITE_PROPERTIES_AVAILABLE(stmt, 14);
 #ifdef HAVE_SYMLINK
@@ -9521,7 +9690,9 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   if (!base_tree_only)
     {
       SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                        STMT_SELECT_ACTUAL_CHILDREN_INFO));
+                                        dirs
+                                          ? STMT_SELECT_ACTUAL_DESCENDANTS_INFO
+                                          : STMT_SELECT_ACTUAL_CHILDREN_INFO));
       SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9532,6 +9703,15 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
           const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
           const char *name = svn_relpath_basename(child_relpath, NULL);
 
+          if (dirs)
+            {
+              get_dir_children(&dir_children, &dir_children_relpath, dirs,
+                               dir_relpath, child_relpath, name,
+                               result_pool);
+              nodes = dir_children->nodes;
+              conflicts = dir_children->conflicts;
+            }
+
           child_item = svn_hash_gets(nodes, name);
           if (!child_item)
             {
@@ -9596,13 +9776,43 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
   VERIFY_USABLE_WCROOT(wcroot);
 
   SVN_WC__DB_WITH_TXN(
-    read_children_info(wcroot, dir_relpath, *conflicts, *nodes,
+    read_children_info(wcroot, dir_relpath, *conflicts, *nodes, NULL,
                        base_tree_only, result_pool, scratch_pool),
     wcroot);
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_read_descendants_info(apr_hash_t **dirs,
+                                 const char **wcroot_abspath,
+                                 svn_wc__db_t *db,
+                                 const char *dir_abspath,
+                                 svn_boolean_t base_tree_only,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *dir_relpath;
+
+  *dirs = apr_hash_make(result_pool);
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &dir_relpath, db,
+                                                dir_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    read_children_info(wcroot, dir_relpath, NULL, NULL, *dirs,
+                       base_tree_only, result_pool, scratch_pool),
+    wcroot);
+
+  *wcroot_abspath = apr_pstrdup(result_pool, wcroot->abspath);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implementation of svn_wc__db_read_single_info.
 
    ### This function is very similar to a lot of code inside
@@ -9756,6 +9966,7 @@ read_single_info(const struct svn_wc__db_info_t **info,
     }
 #endif
 
+  mtb->checksum = svn_checksum_dup(checksum, result_pool);
   mtb->has_checksum = (checksum != NULL);
   mtb->copied = (original_repos_relpath != NULL);
 
@@ -12275,6 +12486,73 @@ bump_node_revision(svn_wc__db_wcroot_t *wcroot,
   return SVN_NO_ERROR;
 }
 
+/* Set-based equivalent of bump_node_revision() for LOCAL_RELPATH in WCROOT
+ * for the common case of a depth-infinity update to NEW_REV that neither
+ * changes repository paths nor skips any subtrees.
+ *
+ * Instead of visiting every node, remove the not-present and outdated
+ * server-excluded BASE nodes below LOCAL_RELPATH and bump all remaining
+ * BASE nodes in a single statement each.  Then store the inherited
+ * properties given in WCROOT_IPROPS for the nodes within that subtree.
+ */
+static svn_error_t *
+bump_node_revisions_recursive(svn_wc__db_wcroot_t *wcroot,
+                              const char *local_relpath,
+                              svn_revnum_t new_rev,
+                              apr_hash_t *wcroot_iprops,
+                              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(flush_entries(wcroot,
+                        svn_dirent_join(wcroot->abspath, local_relpath,
+                                        scratch_pool),
+                        svn_depth_infinity, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_DELETE_BASE_NOT_PRESENT_RECURSIVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isr", wcroot->wc_id, local_relpath,
+                            new_rev));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_UPDATE_BASE_REVISION_RECURSIVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isr", wcroot->wc_id, local_relpath,
+                            new_rev));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  if (wcroot_iprops)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(scratch_pool, wcroot_iprops);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *relpath;
+
+          svn_pool_clear(iterpool);
+
+          relpath = svn_dirent_skip_ancestor(wcroot->abspath,
+                                             apr_hash_this_key(hi));
+          if (!relpath || !svn_relpath_skip_ancestor(local_relpath, relpath))
+            continue;
+
+          SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                            STMT_UPDATE_IPROP));
+          SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, relpath));
+          SVN_ERR(svn_sqlite__bind_iprops(stmt, 3, apr_hash_this_val(hi),
+                                          iterpool));
+          SVN_ERR(svn_sqlite__step_done(stmt));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Helper for svn_wc__db_op_bump_revisions_post_update().
  */
 static svn_error_t *
@@ -12331,14 +12609,24 @@ bump_revisions_post_update(svn_wc__db_wcroot_t *wcroot,
                             new_repos_uuid,
                             wcroot->sdb, scratch_pool));
 
-  SVN_ERR(bump_node_revision(wcroot, local_relpath,
-                             status, kind,  revision, repos_relpath,
-                             new_repos_id,
-                             new_repos_relpath, new_revision,
-                             depth, exclude_relpaths,
-                             wcroot_iprops,
-                             TRUE /* is_root */, FALSE, db,
-                             scratch_pool));
+  /* Most updates bump the whole tree to a single revision without touching
+     any URLs.  Handle that case in bulk and walk the tree otherwise. */
+  if (depth == svn_depth_infinity
+      && new_repos_relpath == NULL
+      && SVN_IS_VALID_REVNUM(new_revision)
+      && (exclude_relpaths == NULL || apr_hash_count(exclude_relpaths) == 0))
+    SVN_ERR(bump_node_revisions_recursive(wcroot, local_relpath,
+                                          new_revision, wcroot_iprops,
+                                          scratch_pool));
+  else
+    SVN_ERR(bump_node_revision(wcroot, local_relpath,
+                               status, kind,  revision, repos_relpath,
+                               new_repos_id,
+                               new_repos_relpath, new_revision,
+                               depth, exclude_relpaths,
+                               wcroot_iprops,
+                               TRUE /* is_root */, FALSE, db,
+                               scratch_pool));
 
   /* ### TODO: Use empty_update flag for change knowledge */
   SVN_ERR(svn_wc__db_bump_moved_away(wcroot, local_relpath, depth, db,
@@ -13336,7 +13624,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     SDB_FILE,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
                     TRUE /* exclusive */,
-                    0 /* timeout */,
+                    &wc_db->sqlite_options,
                     wc_db->state_pool, scratch_pool));
 
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -13455,9 +13743,12 @@ svn_wc__db_wq_add(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  /* Add the work item(s) to the WORK_QUEUE.  */
-  return svn_error_trace(add_work_items(wcroot->sdb, work_item,
-                                        scratch_pool));
+  /* Add the work item(s) to the WORK_QUEUE, a list of them in a single
+     transaction.  */
+  SVN_SQLITE__WITH_LOCK(add_work_items(wcroot->sdb, work_item, scratch_pool),
+                        wcroot->sdb);
+
+  return SVN_NO_ERROR;
 }
 
 /* The body of svn_wc__db_wq_fetch_next().
@@ -13599,6 +13890,95 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_wq_complete_and_fetch().
+ */
+static svn_error_t *
+wq_complete_and_fetch(apr_array_header_t **ids,
+                      apr_array_header_t **work_items,
+                      svn_wc__db_wcroot_t *wcroot,
+                      const apr_array_header_t *completed_ids,
+                      apr_hash_t *record_map,
+                      apr_uint64_t after_id,
+                      int max_items,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  for (i = 0; i < completed_ids->nelts; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(completed_ids, i,
+                                                   apr_uint64_t)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
+  if (max_items == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS_AFTER));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, after_id));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 2, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val;
+
+      APR_ARRAY_PUSH(*ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      APR_ARRAY_PUSH(*work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_wc__db_wq_complete_and_fetch(apr_array_header_t **ids,
+                                 apr_array_header_t **work_items,
+                                 svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 const apr_array_header_t *completed_ids,
+                                 apr_hash_t *record_map,
+                                 apr_uint64_t after_id,
+                                 int max_items,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(ids != NULL);
+  SVN_ERR_ASSERT(work_items != NULL);
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    wq_complete_and_fetch(ids, work_items, wcroot, completed_ids, record_map,
+                          after_id, max_items, result_pool, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* ### temporary API. remove before release.  */
@@ -15473,31 +15853,6 @@ svn_wc__db_min_max_revisions(svn_revnum_t *min_revision,
 }
 
 
-/* Set *IS_SPARSE_CHECKOUT TRUE if LOCAL_RELPATH or any of the nodes
- * within LOCAL_RELPATH is sparse, FALSE otherwise. */
-static svn_error_t *
-is_sparse_checkout_internal(svn_boolean_t *is_sparse_checkout,
-                            svn_wc__db_wcroot_t *wcroot,
-                            const char *local_relpath,
-                            apr_pool_t *scratch_pool)
-{
-  svn_sqlite__stmt_t *stmt;
-  svn_boolean_t have_row;
-
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_HAS_SPARSE_NODES));
-  SVN_ERR(svn_sqlite__bindf(stmt, "is",
-                            wcroot->wc_id,
-                            local_relpath));
-  /* If this query returns a row, the working copy is sparse. */
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-  *is_sparse_checkout = have_row;
-  SVN_ERR(svn_sqlite__reset(stmt));
-
-  return SVN_NO_ERROR;
-}
-
-
 /* Like svn_wc__db_has_switched_subtrees(),
  * but accepts a WCROOT/LOCAL_RELPATH pair. */
 static svn_error_t *
@@ -15699,6 +16054,10 @@ revision_status_txn(svn_revnum_t *min_revision,
 {
   svn_error_t *err;
   svn_boolean_t exists;
+  svn_sqlite__stmt_t *stmt;
+  apr_int64_t repos_id;
+  const char *repos_relpath;
+  svn_boolean_t trail_mismatch = FALSE;
 
   SVN_ERR(does_node_exist(&exists, wcroot, local_relpath));
 
@@ -15710,28 +16069,65 @@ revision_status_txn(svn_revnum_t *min_revision,
                                                       scratch_pool));
     }
 
-  /* Determine mixed-revisionness. */
-  SVN_ERR(get_min_max_revisions(min_revision, max_revision, wcroot,
-                                local_relpath, committed, scratch_pool));
+  /* Switched-ness is relative to the BASE node of LOCAL_RELPATH. */
+  err = svn_wc__db_base_get_info_internal(NULL, NULL, NULL,
+                                          &repos_relpath, &repos_id,
+                                          NULL, NULL, NULL, NULL, NULL,
+                                          NULL, NULL, NULL, NULL, NULL,
+                                          wcroot, local_relpath,
+                                          scratch_pool, scratch_pool);
+  if (err)
+    {
+      if (err->apr_err != SVN_ERR_WC_PATH_NOT_FOUND)
+        return svn_error_trace(err);
 
-  /* Determine sparseness. */
-  SVN_ERR(is_sparse_checkout_internal(is_sparse_checkout, wcroot,
-                                      local_relpath, scratch_pool));
+      svn_error_clear(err); /* No Base node, but no fatal error */
+      repos_relpath = NULL;
+    }
 
-  /* Check for switched nodes. */
-  {
-    err = has_switched_subtrees(is_switched, wcroot, local_relpath,
-                                trail_url, scratch_pool);
+  /* If the trailing part of the URL of the working copy directory does
+     not match the given trailing URL then the whole working copy is
+     switched. */
+  if (repos_relpath && trail_url)
+    {
+      const char *repos_root_url;
+      const char *url;
+      apr_size_t len1, len2;
 
-    if (err)
-      {
-        if (err->apr_err != SVN_ERR_WC_PATH_NOT_FOUND)
-          return svn_error_trace(err);
+      SVN_ERR(svn_wc__db_fetch_repos_info(&repos_root_url, NULL, wcroot,
+                                          repos_id, scratch_pool));
+      url = svn_path_url_add_component2(repos_root_url, repos_relpath,
+                                        scratch_pool);
 
-        svn_error_clear(err); /* No Base node, but no fatal error */
-        *is_switched = FALSE;
-      }
-  }
+      len1 = strlen(trail_url);
+      len2 = strlen(url);
+      trail_mismatch = (len1 > len2) || strcmp(url + len2 - len1, trail_url);
+    }
+
+  /* Determine mixed-revisionness, sparseness and switched subtrees in a
+     single pass over the BASE layer. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_REVISION_STATUS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "iss", wcroot->wc_id, local_relpath,
+                            repos_relpath));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+
+  if (committed)
+    {
+      *min_revision = svn_sqlite__column_revnum(stmt, 2);
+      *max_revision = svn_sqlite__column_revnum(stmt, 3);
+    }
+  else
+    {
+      *min_revision = svn_sqlite__column_revnum(stmt, 0);
+      *max_revision = svn_sqlite__column_revnum(stmt, 1);
+    }
+
+  *is_sparse_checkout = svn_sqlite__column_boolean(stmt, 4);
+  *is_switched = trail_mismatch || svn_sqlite__column_boolean(stmt, 5);
+
+  /* The statement returns exactly one row. */
+  SVN_ERR(svn_sqlite__reset(stmt));
 
   /* Check for db mods. */
   SVN_ERR(has_db_mods(is_modified, wcroot, local_relpath, scratch_pool));
@@ -16018,7 +16414,7 @@ svn_wc__db_bump_format(int *result_format,
   err = svn_wc__db_util_open_db(&sdb, wcroot_abspath, SDB_FILE,
                                 svn_sqlite__mode_readwrite,
                                 TRUE, /* exclusive */
-                                0, /* default timeout */
+                                NULL, /* default options */
                                 NULL, /* my statements */
                                 scratch_pool, scratch_pool);
   if (err)
@@ -16074,6 +16470,8 @@ svn_wc__db_vacuum(svn_wc__db_t *db,
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
                                                 db, local_abspath,
                                                 scratch_pool, scratch_pool));
+  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
+                                      STMT_ENABLE_INCREMENTAL_VACUUM));
   SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
 
   return SVN_NO_ERROR;
@@ -361,6 +361,21 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Return the number of threads that status walks using DB shall use to
+   compare file contents, as configured by the user. */
+int
+svn_wc__db_get_status_jobs(svn_wc__db_t *db);
+
+/* Return the number of threads that svn_wc__wq_run() shall use to install
+   files, as configured by the user. */
+int
+svn_wc__db_get_install_jobs(svn_wc__db_t *db);
+
+/* Return the number of threads that shall prepare text deltas during
+   commits, as configured by the user. */
+int
+svn_wc__db_get_commit_jobs(svn_wc__db_t *db);
+
 
 /* @} */
 
@@ -925,6 +940,19 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Set *CONTENTS to a readable stream that will yield the pristine text
+   stored at PRISTINE_ABSPATH, as returned by
+   svn_wc__db_pristine_get_future_path(), even if the text is stored
+   compressed.  Unlike svn_wc__db_pristine_read(), this does not check
+   that the text is recorded in the database.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_open_future_path(svn_stream_t **contents,
+                                     const char *pristine_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 
 /* If requested set *CONTENTS to a readable stream that will yield the pristine
    text identified by SHA1_CHECKSUM (must be a SHA-1 checksum) within the WC
@@ -945,6 +973,19 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/* Set *CONTENTS to a readable stream that will yield the text identified
+   by SHA1_CHECKSUM (must be a SHA-1 checksum) from the content cache that
+   DB shares with other working copies.  Set *CONTENTS to NULL if there is
+   no such cache or it does not contain the text.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_cached(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 /* Baton for svn_wc__db_pristine_install */
 typedef struct svn_wc__db_install_data_t
                svn_wc__db_install_data_t;
@@ -972,7 +1013,10 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
 /* Install the file created via svn_wc__db_pristine_prepare_install() into
    the pristine data store, to be identified by the SHA-1 checksum of its
-   contents, SHA1_CHECKSUM, and whose MD-5 checksum is MD5_CHECKSUM. */
+   contents, SHA1_CHECKSUM, and whose MD-5 checksum is MD5_CHECKSUM.
+
+   If the working copy uses a content cache, hard link the text from the
+   cache if it is already there, and add it to the cache otherwise. */
 svn_error_t *
 svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
                             const svn_checksum_t *sha1_checksum,
@@ -1046,6 +1090,19 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
                             apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_pristine_cleanup, but stop after the batch of pristines
+ * during which MAX_TIME has passed, and afterwards give some free pages of
+ * the database back to the filesystem.  Do nothing if the work queue is
+ * not empty, as queued work items may refer to unreferenced pristines.
+ *
+ * Set *FINISHED to TRUE if no unreferenced pristines are left. */
+svn_error_t *
+svn_wc__db_pristine_cleanup_some(svn_boolean_t *finished,
+                                 svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 apr_interval_time_t max_time,
+                                 apr_pool_t *scratch_pool);
+
 
 /* Set *PRESENT to true if the pristine store for WRI_ABSPATH in DB contains
    a pristine text with SHA-1 checksum SHA1_CHECKSUM, and to false otherwise.
@@ -1982,7 +2039,7 @@ struct svn_wc__db_moved_to_info_t
 };
 
 /* Structure returned by svn_wc__db_read_children_info.  Only has the
-   fields needed by status. */
+   fields needed by status and info. */
 struct svn_wc__db_info_t {
   svn_wc__db_status_t status;
   svn_node_kind_t kind;
@@ -2006,6 +2063,7 @@ struct svn_wc__db_info_t {
   svn_boolean_t op_root;
 
   svn_boolean_t has_checksum;
+  const svn_checksum_t *checksum;
   svn_boolean_t copied;
   svn_boolean_t had_props;
   svn_boolean_t props_mod;
@@ -2047,6 +2105,37 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
+/* The children of one directory as returned by
+   svn_wc__db_read_descendants_info(). */
+typedef struct svn_wc__db_dir_children_t
+{
+  /* const char *name -> struct svn_wc__db_info_t * */
+  apr_hash_t *nodes;
+
+  /* const char *name -> "" for the children in conflict */
+  apr_hash_t *conflicts;
+} svn_wc__db_dir_children_t;
+
+/* Like svn_wc__db_read_children_info, but for all directories at or below
+   DIR_ABSPATH, using one query per table instead of several per directory.
+
+   Return in *DIRS a hash mapping the path of each directory relative to
+   DIR_ABSPATH ("" for DIR_ABSPATH itself) to its svn_wc__db_dir_children_t.
+   Directories without children in the database are not in *DIRS.  Set
+   *WCROOT_ABSPATH to the root of the working copy that the information was
+   read from; it doesn't cover nested working copies.
+
+   All information is read into memory at once, so this should be used
+   for subtrees that will be walked in their entirety only. */
+svn_error_t *
+svn_wc__db_read_descendants_info(apr_hash_t **dirs,
+                                 const char **wcroot_abspath,
+                                 svn_wc__db_t *db,
+                                 const char *dir_abspath,
+                                 svn_boolean_t base_tree_only,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_read_children_info, but only gets an info node for the root
    element.
 
@@ -2654,6 +2743,10 @@ svn_wc__db_op_bump_revisions_post_update(svn_wc__db_t *db,
 
    RECORDED_TIME may be 0, which will be recorded as such, implying
    "unknown last mod time".
+
+   Until svn_wc__db_clear_racy_fileinfo() is called, a modification of
+   the file within the timestamp resolution of its file system may go
+   unnoticed.
 */
 svn_error_t *
 svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
@@ -2662,6 +2755,16 @@ svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
                                   apr_time_t recorded_time,
                                   apr_pool_t *scratch_pool);
 
+/* Forget the recorded timestamps in all working copies opened in DB that
+   a modification of the file made from now on might not change, so that
+   these files will be compared by content.  This makes sleeping for
+   timestamps (see svn_io_sleep_for_timestamps()) unnecessary.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__db_clear_racy_fileinfo(svn_wc__db_t *db,
+                               apr_pool_t *scratch_pool);
+
 
 /* ### post-commit handling.
    ### maybe multiple phases?
@@ -3028,6 +3131,33 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Batch variant of svn_wc__db_wq_record_and_fetch_next().  In one
+   transaction, mark the work items COMPLETED_IDS (apr_uint64_t) as
+   completed, record the timestamps and sizes in RECORD_MAP (which may be
+   NULL), and fetch up to MAX_ITEMS work items queued after AFTER_ID.
+
+   Set *IDS to the identifiers (apr_uint64_t) and *WORK_ITEMS to the data
+   (svn_skel_t *) of the fetched items, in queue order.  Both are empty if
+   there are no such items or MAX_ITEMS is 0.
+
+   The caller must make sure that COMPLETED_IDS holds all items before any
+   item that remains in the queue, so that restarting the queue after a
+   crash runs the items in their original order.
+
+   RESULT_POOL will be used to allocate *IDS and *WORK_ITEMS, and
+   SCRATCH_POOL will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_complete_and_fetch(apr_array_header_t **ids,
+                                 apr_array_header_t **work_items,
+                                 svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 const apr_array_header_t *completed_ids,
+                                 apr_hash_t *record_map,
+                                 apr_uint64_t after_id,
+                                 int max_items,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 
 /* @} */
 
@@ -3447,7 +3577,8 @@ svn_wc__db_base_moved_to(const char **move_dst_abspath,
                          apr_pool_t *scratch_pool);
 
 /* Recover space from the database file for LOCAL_ABSPATH by running
- * the "vacuum" command. */
+ * the "vacuum" command.  This also enables incremental vacuum for the
+ * database, see svn_wc__db_pristine_cleanup_some(). */
 svn_error_t *
 svn_wc__db_vacuum(svn_wc__db_t *db,
                   const char *local_abspath,
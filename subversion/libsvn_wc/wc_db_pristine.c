@@ -25,11 +25,16 @@
 
 #define SVN_WC__I_AM_WC_DB
 
+#include <string.h>
+
 #include "svn_pools.h"
+#include "svn_hash.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -40,6 +45,17 @@
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
 
+/* Compressed pristine texts use this extension instead of
+ * PRISTINE_STORAGE_EXT.  Older clients can't open working copies with such
+ * texts because of their format number, see SVN_WC__COMPRESSED_PRISTINES. */
+#define PRISTINE_COMPRESSED_EXT ".svn-lz4"
+
+/* Value of the PRISTINE.compression column for compressed texts. */
+#define PRISTINE_COMPRESSION_LZ4 1
+
+/* Size of the blocks that compressed pristine texts are split into. */
+#define PRISTINE_COMPRESSION_BLOCK_SIZE 0x10000
+
 
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
@@ -92,6 +108,394 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Return the location of the text with SHA1_CHECKSUM in the content cache
+   of DB, allocated in RESULT_POOL.  Return NULL if DB has no content cache.
+   The layout is the same as the one of the pristine store. */
+static const char *
+get_cache_fname(svn_wc__db_t *db,
+                const svn_checksum_t *sha1_checksum,
+                apr_pool_t *result_pool)
+{
+  const char *hexdigest;
+  char subdir[3];
+
+  if (!db->content_cache_abspath)
+    return NULL;
+
+  hexdigest = svn_checksum_to_cstring(sha1_checksum, result_pool);
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  return svn_dirent_join_many(result_pool, db->content_cache_abspath,
+                              subdir, hexdigest, SVN_VA_NULL);
+}
+
+/* Return the location of the compressed form of the pristine text that
+   is stored uncompressed at PRISTINE_ABSPATH, allocated in RESULT_POOL.
+   This works for content cache entries as well. */
+static const char *
+get_compressed_fname(const char *pristine_abspath,
+                     apr_pool_t *result_pool)
+{
+  apr_size_t len = strlen(pristine_abspath);
+  apr_size_t ext_len = sizeof(PRISTINE_STORAGE_EXT) - 1;
+
+  if (len > ext_len
+      && !strcmp(pristine_abspath + len - ext_len, PRISTINE_STORAGE_EXT))
+    len -= ext_len;
+
+  return apr_pstrcat(result_pool,
+                     apr_pstrmemdup(result_pool, pristine_abspath, len),
+                     PRISTINE_COMPRESSED_EXT, SVN_VA_NULL);
+}
+
+
+/* Compressed pristine texts are a sequence of frames, each holding up to
+ * PRISTINE_COMPRESSION_BLOCK_SIZE bytes of text.  A frame starts with its
+ * length encoded by svn__encode_uint(), followed by the block as produced
+ * by svn__compress_lz4(). */
+
+/* Baton for the compressing write stream. */
+typedef struct compress_baton_t
+{
+  /* Stream receiving the compressed frames. */
+  svn_stream_t *inner;
+
+  /* Text collected for the next frame. */
+  svn_stringbuf_t *block;
+
+  /* Scratch buffer for the compressed block. */
+  svn_stringbuf_t *compressed;
+
+  /* Number of text bytes written so far. */
+  svn_filesize_t size;
+} compress_baton_t;
+
+/* Write the text collected in BATON as a frame to its inner stream. */
+static svn_error_t *
+write_frame(compress_baton_t *baton)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t len;
+
+  SVN_ERR(svn__compress_lz4(baton->block->data, baton->block->len,
+                            baton->compressed));
+  svn_stringbuf_setempty(baton->block);
+
+  len = svn__encode_uint(header, baton->compressed->len) - header;
+  SVN_ERR(svn_stream_write(baton->inner, (const char *)header, &len));
+
+  len = baton->compressed->len;
+  return svn_error_trace(svn_stream_write(baton->inner,
+                                          baton->compressed->data, &len));
+}
+
+/* Implements svn_write_fn_t for the compressing stream. */
+static svn_error_t *
+compress_write(void *baton,
+               const char *data,
+               apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+  apr_size_t remaining = *len;
+
+  b->size += remaining;
+  while (remaining)
+    {
+      apr_size_t to_copy = MIN(remaining, PRISTINE_COMPRESSION_BLOCK_SIZE
+                                          - b->block->len);
+
+      svn_stringbuf_appendbytes(b->block, data, to_copy);
+      data += to_copy;
+      remaining -= to_copy;
+
+      if (b->block->len == PRISTINE_COMPRESSION_BLOCK_SIZE)
+        SVN_ERR(write_frame(b));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the compressing stream. */
+static svn_error_t *
+compress_close(void *baton)
+{
+  compress_baton_t *b = baton;
+
+  if (b->block->len)
+    SVN_ERR(write_frame(b));
+
+  return svn_error_trace(svn_stream_close(b->inner));
+}
+
+/* Return a stream that writes the text given to it compressed to INNER.
+ * Set *BATON to the stream's baton, so that the caller can find out the
+ * size of the text.  Allocate everything in RESULT_POOL. */
+static svn_stream_t *
+compressed_stream(compress_baton_t **baton,
+                  svn_stream_t *inner,
+                  apr_pool_t *result_pool)
+{
+  compress_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *stream;
+
+  b->inner = inner;
+  b->block = svn_stringbuf_create_ensure(PRISTINE_COMPRESSION_BLOCK_SIZE,
+                                         result_pool);
+  b->compressed = svn_stringbuf_create_empty(result_pool);
+
+  stream = svn_stream_create(b, result_pool);
+  svn_stream_set_write(stream, compress_write);
+  svn_stream_set_close(stream, compress_close);
+
+  *baton = b;
+  return stream;
+}
+
+/* Baton for the decompressing read stream. */
+typedef struct decompress_baton_t
+{
+  /* Stream providing the compressed frames. */
+  svn_stream_t *inner;
+
+  /* Scratch buffer for the compressed block. */
+  svn_stringbuf_t *compressed;
+
+  /* Text of the current frame and the number of bytes of it returned. */
+  svn_stringbuf_t *block;
+  apr_size_t block_pos;
+} decompress_baton_t;
+
+/* Read the next frame from BATON's inner stream into BATON->BLOCK.  Leave
+ * BATON->BLOCK empty at the end of the text. */
+static svn_error_t *
+read_frame(decompress_baton_t *baton)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t header_len = 0;
+  apr_uint64_t frame_len;
+  apr_size_t len;
+
+  svn_stringbuf_setempty(baton->block);
+  baton->block_pos = 0;
+
+  /* Read the frame length, one byte at a time. */
+  do
+    {
+      if (header_len == sizeof(header))
+        return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                                _("Invalid frame in compressed pristine "
+                                  "text"));
+
+      len = 1;
+      SVN_ERR(svn_stream_read_full(baton->inner,
+                                   (char *)header + header_len, &len));
+      if (len == 0)
+        {
+          if (header_len == 0)
+            return SVN_NO_ERROR;
+
+          return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                                  _("Unexpected end of compressed pristine "
+                                    "text"));
+        }
+    }
+  while (header[header_len++] & 0x80);
+
+  svn__decode_uint(&frame_len, header, header + header_len);
+  if (frame_len == 0 || frame_len > 2 * PRISTINE_COMPRESSION_BLOCK_SIZE)
+    return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                            _("Invalid frame in compressed pristine text"));
+
+  svn_stringbuf_setempty(baton->compressed);
+  svn_stringbuf_ensure(baton->compressed, (apr_size_t)frame_len);
+  len = (apr_size_t)frame_len;
+  SVN_ERR(svn_stream_read_full(baton->inner, baton->compressed->data, &len));
+  if (len != frame_len)
+    return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                            _("Unexpected end of compressed pristine text"));
+  baton->compressed->len = len;
+
+  return svn_error_trace(svn__decompress_lz4(baton->compressed->data, len,
+                                             baton->block,
+                                             PRISTINE_COMPRESSION_BLOCK_SIZE));
+}
+
+/* Implements svn_read_fn_t for the decompressing stream. */
+static svn_error_t *
+decompress_read(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  decompress_baton_t *b = baton;
+  apr_size_t remaining = *len;
+
+  while (remaining)
+    {
+      apr_size_t to_copy;
+
+      if (b->block_pos == b->block->len)
+        {
+          SVN_ERR(read_frame(b));
+          if (b->block->len == 0)
+            break;
+        }
+
+      to_copy = MIN(remaining, b->block->len - b->block_pos);
+      memcpy(buffer, b->block->data + b->block_pos, to_copy);
+      b->block_pos += to_copy;
+      buffer += to_copy;
+      remaining -= to_copy;
+    }
+
+  *len -= remaining;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the decompressing stream. */
+static svn_error_t *
+decompress_close(void *baton)
+{
+  decompress_baton_t *b = baton;
+
+  return svn_error_trace(svn_stream_close(b->inner));
+}
+
+/* Return a stream that reads the text compressed in INNER, allocated in
+ * RESULT_POOL. */
+static svn_stream_t *
+decompressed_stream(svn_stream_t *inner,
+                    apr_pool_t *result_pool)
+{
+  decompress_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *stream;
+
+  b->inner = inner;
+  b->compressed = svn_stringbuf_create_empty(result_pool);
+  b->block = svn_stringbuf_create_ensure(PRISTINE_COMPRESSION_BLOCK_SIZE,
+                                         result_pool);
+
+  stream = svn_stream_create(b, result_pool);
+  svn_stream_set_read2(stream, NULL /* only full read support */,
+                       decompress_read);
+  svn_stream_set_close(stream, decompress_close);
+
+  return stream;
+}
+
+/* Set *CONTENTS to a stream reading the pristine text stored at
+ * PRISTINE_ABSPATH, or stored compressed next to it.  Return an ENOENT
+ * error if the text is stored in neither form.
+ *
+ * We don't enable APR_BUFFERED on uncompressed files to maximize
+ * throughput e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE
+ * buffers where needed in streams, there is no point in having another
+ * layer of buffers.  Compressed files are read in small pieces, though.
+ *
+ * Allocate the stream in RESULT_POOL. */
+static svn_error_t *
+open_pristine_file(svn_stream_t **contents,
+                   const char *pristine_abspath,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file, pristine_abspath, APR_READ, APR_OS_DEFAULT,
+                         result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_t *err2;
+
+      err2 = svn_io_file_open(&file,
+                              get_compressed_fname(pristine_abspath,
+                                                   scratch_pool),
+                              APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                              result_pool);
+      if (err2)
+        {
+          svn_error_clear(err2);
+          return svn_error_trace(err);
+        }
+
+      svn_error_clear(err);
+      *contents = decompressed_stream(svn_stream_from_aprfile2(file, FALSE,
+                                                               result_pool),
+                                      result_pool);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+  return SVN_NO_ERROR;
+}
+
+
+/* Return the absolute path to the temporary directory for pristine text
+   files within WCROOT. */
+static char *
+pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot->abspath,
+                              svn_wc_get_adm_dir(scratch_pool),
+                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+}
+
+/* Set *EXPANDED_ABSPATH to a temporary file within WCROOT that contains
+ * the uncompressed form of the compressed pristine text that belongs at
+ * PRISTINE_ABSPATH.  The file remains until DB gets closed, as work queue
+ * items may refer to it.  Should we crash
+ * before that, cleanup will remove it with the other temporary files.
+ *
+ * Allocate *EXPANDED_ABSPATH in RESULT_POOL. */
+static svn_error_t *
+expand_pristine(const char **expanded_abspath,
+                svn_wc__db_t *db,
+                svn_wc__db_wcroot_t *wcroot,
+                const char *pristine_abspath,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *compressed_abspath = get_compressed_fname(pristine_abspath,
+                                                        scratch_pool);
+  const char *tmp_abspath;
+  apr_file_t *file;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  if (! db->expanded_pristines)
+    db->expanded_pristines = apr_hash_make(db->state_pool);
+
+  tmp_abspath = svn_hash_gets(db->expanded_pristines, compressed_abspath);
+  if (! tmp_abspath)
+    {
+      SVN_ERR(svn_io_file_open(&file, compressed_abspath,
+                               APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                               scratch_pool));
+      src_stream = decompressed_stream(svn_stream_from_aprfile2(file, FALSE,
+                                                                scratch_pool),
+                                       scratch_pool);
+      SVN_ERR(svn_stream_open_unique(&dst_stream, &tmp_abspath,
+                                     pristine_get_tempdir(wcroot,
+                                                          scratch_pool,
+                                                          scratch_pool),
+                                     svn_io_file_del_on_pool_cleanup,
+                                     db->state_pool, scratch_pool));
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream, NULL, NULL,
+                               scratch_pool));
+
+      svn_hash_sets(db->expanded_pristines,
+                    apr_pstrdup(db->state_pool, compressed_abspath),
+                    tmp_abspath);
+    }
+
+  *expanded_abspath = apr_pstrdup(result_pool, tmp_abspath);
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -103,7 +507,9 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
-  svn_boolean_t present;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_boolean_t compressed;
 
   SVN_ERR_ASSERT(pristine_abspath != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
@@ -121,19 +527,29 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                                              scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath, sha1_checksum,
-                                    scratch_pool));
-  if (! present)
-    return svn_error_createf(SVN_ERR_WC_DB_ERROR, NULL,
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE_COMPRESSION));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (! have_row)
+    return svn_error_createf(SVN_ERR_WC_DB_ERROR, svn_sqlite__reset(stmt),
                              _("The pristine text with checksum '%s' was "
                                "not found"),
                              svn_checksum_to_cstring_display(sha1_checksum,
                                                              scratch_pool));
 
+  compressed = ! svn_sqlite__column_is_null(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
   SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              result_pool, scratch_pool));
 
+  /* Callers want to read the file directly, so expand a compressed text. */
+  if (compressed)
+    SVN_ERR(expand_pristine(pristine_abspath, db, wcroot, *pristine_abspath,
+                            result_pool, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -150,6 +566,16 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_pristine_open_future_path(svn_stream_t **contents,
+                                     const char *pristine_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(open_pristine_file(contents, pristine_abspath,
+                                            result_pool, scratch_pool));
+}
+
 /* Set *CONTENTS to a readable stream from which the pristine text
  * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
  * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
@@ -197,19 +623,10 @@ pristine_read_txn(svn_stream_t **contents,
     }
 
   /* Open the file as a readable stream.  It will remain readable even when
-   * deleted from disk; APR guarantees that on Windows as well as Unix.
-   *
-   * We also don't enable APR_BUFFERED on this file to maximize throughput
-   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
-   * where needed in streams, there is no point in having another layer of
-   * buffers. */
+   * deleted from disk; APR guarantees that on Windows as well as Unix. */
   if (contents)
-    {
-      apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
-      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
-    }
+    SVN_ERR(open_pristine_file(contents, pristine_abspath,
+                               result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -256,18 +673,96 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
 }
 
 
-/* Return the absolute path to the temporary directory for pristine text
-   files within WCROOT. */
-static char *
-pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+svn_error_t *
+svn_wc__db_pristine_read_cached(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
 {
-  return svn_dirent_join_many(result_pool, wcroot->abspath,
-                              svn_wc_get_adm_dir(scratch_pool),
-                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+  const char *cache_abspath;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  *contents = NULL;
+  cache_abspath = get_cache_fname(db, sha1_checksum, scratch_pool);
+  if (!cache_abspath)
+    return SVN_NO_ERROR;
+
+  err = open_pristine_file(contents, cache_abspath,
+                           result_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+
+/* Try to make PRISTINE_ABSPATH a hard link to the shared text at
+ * CACHE_ABSPATH, if that exists and is SIZE bytes long.  Set *LINKED to
+ * TRUE upon success and to FALSE otherwise. */
+static svn_error_t *
+link_from_cache(svn_boolean_t *linked,
+                const char *cache_abspath,
+                const char *pristine_abspath,
+                apr_off_t size,
+                apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  *linked = FALSE;
+
+  err = svn_io_stat(&finfo, cache_abspath, APR_FINFO_TYPE | APR_FINFO_SIZE,
+                    scratch_pool);
+  if (err || finfo.filetype != APR_REG || finfo.size != size)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Remove any orphan in the way and make sure the store's sub-directory
+   * exists. */
+  SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                         scratch_pool),
+                                      scratch_pool));
+
+  /* Different file systems etc. are no errors; we simply use our copy. */
+  err = svn_io__file_link(cache_abspath, pristine_abspath, scratch_pool);
+  if (err)
+    svn_error_clear(err);
+  else
+    *linked = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Share the installed text at PRISTINE_ABSPATH with other working copies
+ * by hard linking it to CACHE_ABSPATH.  Failure is not an error as the
+ * cache is optional and another working copy may have beaten us to it. */
+static void
+link_to_cache(const char *cache_abspath,
+              const char *pristine_abspath,
+              apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(cache_abspath,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io__file_link(pristine_abspath, cache_abspath, scratch_pool);
+
+  svn_error_clear(err);
 }
 
+
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
  * BATON->tempfile_abspath.
@@ -287,6 +782,13 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* The size of the pristine text, which differs from
+                      * the size of the file if it is compressed. */
+                     svn_filesize_t size,
+                     /* Location of the text in the content cache or NULL. */
+                     const char *cache_abspath,
+                     /* Whether the file is compressed. */
+                     svn_boolean_t compressed,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -294,57 +796,69 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
 
   /* If this pristine text is already present in the store, just keep it:
    * delete the new one and return. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE_SIZE));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
-  SVN_ERR(svn_sqlite__reset(stmt));
 
   if (have_row)
     {
 #ifdef SVN_DEBUG
-      /* Consistency checks.  Verify both files exist and match.
+      /* Consistency checks.  Verify both texts match.  We compare with the
+       * recorded size, as the existing text may be stored in the other
+       * form than the new one.
        * ### We could check much more. */
-      {
-        apr_finfo_t finfo1, finfo2;
-
-        SVN_ERR(svn_stream__install_get_info(&finfo1, install_stream, APR_FINFO_SIZE,
-                                             scratch_pool));
-
-        SVN_ERR(svn_io_stat(&finfo2, pristine_abspath, APR_FINFO_SIZE,
-                            scratch_pool));
-        if (finfo1.size != finfo2.size)
-          {
-            return svn_error_createf(
-              SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
-              _("New pristine text '%s' has different size: %s versus %s"),
-              svn_checksum_to_cstring_display(sha1_checksum, scratch_pool),
-              apr_off_t_toa(scratch_pool, finfo1.size),
-              apr_off_t_toa(scratch_pool, finfo2.size));
-          }
-      }
+      svn_filesize_t stored_size = svn_sqlite__column_int64(stmt, 0);
+
+      if (size != stored_size)
+        {
+          return svn_error_createf(
+            SVN_ERR_WC_CORRUPT_TEXT_BASE, svn_sqlite__reset(stmt),
+            _("New pristine text '%s' has different size: %s versus %s"),
+            svn_checksum_to_cstring_display(sha1_checksum, scratch_pool),
+            apr_off_t_toa(scratch_pool, size),
+            apr_off_t_toa(scratch_pool, stored_size));
+        }
 #endif
+      SVN_ERR(svn_sqlite__reset(stmt));
 
       /* Remove the temp file: it's already there */
       SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
       return SVN_NO_ERROR;
     }
 
+  SVN_ERR(svn_sqlite__reset(stmt));
+
   /* Move the file to its target location.  (If it is already there, it is
-   * an orphan file and it doesn't matter if we overwrite it.) */
+   * an orphan file and it doesn't matter if we overwrite it.)  If the text
+   * is in the content cache, link to it instead. */
   {
     apr_finfo_t finfo;
+    svn_boolean_t linked = FALSE;
+
     SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
                                          APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
+    if (cache_abspath)
+      SVN_ERR(link_from_cache(&linked, cache_abspath, pristine_abspath,
+                              finfo.size, scratch_pool));
+
+    if (linked)
+      SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
+    else
+      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                         TRUE, scratch_pool));
 
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
+    if (compressed)
+      SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_COMPRESSION_LZ4));
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
     SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+
+    if (cache_abspath && !linked)
+      link_to_cache(cache_abspath, pristine_abspath, scratch_pool);
   }
 
   return SVN_NO_ERROR;
@@ -352,8 +866,13 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
 
 struct svn_wc__db_install_data_t
 {
+  svn_wc__db_t *db;
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* The compressing stream in front of INNER_STREAM, or NULL if the text
+   * is stored uncompressed. */
+  compress_baton_t *compress_baton;
 };
 
 svn_error_t *
@@ -379,6 +898,7 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
   temp_dir_abspath = pristine_get_tempdir(wcroot, scratch_pool, scratch_pool);
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
+  (*install_data)->db = db;
   (*install_data)->wcroot = wcroot;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
@@ -388,10 +908,19 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
-  if (md5_checksum)
+  if (db->compress_pristines
+      && wcroot->format >= SVN_WC__COMPRESSED_PRISTINES)
+    *stream = compressed_stream(&(*install_data)->compress_baton, *stream,
+                                result_pool);
+
+  if (md5_checksum && sha1_checksum)
+    *stream = svn_checksum__wrap_write_stream_md5_sha1(md5_checksum,
+                                                       sha1_checksum,
+                                                       *stream, result_pool);
+  else if (md5_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
                                       svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
+  else if (sha1_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
                                       svn_checksum_sha1, FALSE, result_pool);
 
@@ -406,6 +935,8 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  const char *cache_abspath;
+  svn_filesize_t size;
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -415,13 +946,32 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
+  cache_abspath = get_cache_fname(install_data->db, sha1_checksum,
+                                  scratch_pool);
+
+  if (install_data->compress_baton)
+    {
+      pristine_abspath = get_compressed_fname(pristine_abspath, scratch_pool);
+      if (cache_abspath)
+        cache_abspath = get_compressed_fname(cache_abspath, scratch_pool);
+      size = install_data->compress_baton->size;
+    }
+  else
+    {
+      apr_finfo_t finfo;
+
+      SVN_ERR(svn_stream__install_get_info(&finfo, install_data->inner_stream,
+                                           APR_FINFO_SIZE, scratch_pool));
+      size = finfo.size;
+    }
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
-                         sha1_checksum, md5_checksum,
+                         sha1_checksum, md5_checksum, size, cache_abspath,
+                         install_data->compress_baton != NULL,
                          scratch_pool),
     wcroot->sdb);
 
@@ -555,8 +1105,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
-                                   scratch_pool, scratch_pool));
+  SVN_ERR(open_pristine_file(&src_stream, src_abspath,
+                             scratch_pool, scratch_pool));
 
   /* ### Should we verify the SHA1 or MD5 here, or is that too expensive? */
   SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
@@ -687,15 +1237,67 @@ svn_wc__db_pristine_transfer(svn_wc__db_t *db,
 
 
 
+/* Remove the file PRISTINE_ABSPATH from the pristine store, and its entry
+ * CACHE_ABSPATH (if not NULL) from the content cache when no other working
+ * copy uses that entry any more.  Set *REMOVED to whether PRISTINE_ABSPATH
+ * existed.
+ *
+ * The content cache holds hard links, so the link count of a file tells how
+ * many working copies share it.  If another working copy links to the cache
+ * entry while we remove it, that working copy keeps its text; it merely
+ * isn't shared with future working copies. */
+static svn_error_t *
+remove_pristine_file(svn_boolean_t *removed,
+                     const char *pristine_abspath,
+                     const char *cache_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+  svn_boolean_t remove_cached = FALSE;
+
+  err = svn_io_stat(&finfo, pristine_abspath,
+                    APR_FINFO_IDENT | APR_FINFO_NLINK, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *removed = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (cache_abspath && finfo.nlink == 2)
+    {
+      apr_finfo_t cache_finfo;
+
+      err = svn_io_stat(&cache_finfo, cache_abspath, APR_FINFO_IDENT,
+                        scratch_pool);
+      if (err)
+        svn_error_clear(err);
+      else
+        remove_cached = (cache_finfo.inode == finfo.inode
+                         && cache_finfo.device == finfo.device);
+    }
+
+  SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+  if (remove_cached)
+    SVN_ERR(svn_io_remove_file2(cache_abspath, TRUE, scratch_pool));
+
+  *removed = TRUE;
+  return SVN_NO_ERROR;
+}
+
 /* If the pristine text referenced by SHA1_CHECKSUM in WCROOT/SDB, whose path
  * within the pristine store is PRISTINE_ABSPATH, has a reference count of
- * zero, delete it (both the database row and the disk file).
+ * zero, delete it (both the database row and the disk file, compressed or
+ * not).  Release its entry in the content cache of DB as well.
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
  */
 static svn_error_t *
 pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
+                                    svn_wc__db_t *db,
                                     svn_wc__db_wcroot_t *wcroot,
                                     const svn_checksum_t *sha1_checksum,
                                     const char *pristine_abspath,
@@ -721,9 +1323,27 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
 #else
       svn_boolean_t ignore_enoent = TRUE;
 #endif
-
-      SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
-                                  scratch_pool));
+      const char *cache_abspath = get_cache_fname(db, sha1_checksum,
+                                                  scratch_pool);
+      svn_boolean_t removed_plain;
+      svn_boolean_t removed_compressed;
+
+      SVN_ERR(remove_pristine_file(&removed_plain, pristine_abspath,
+                                   cache_abspath, scratch_pool));
+      SVN_ERR(remove_pristine_file(&removed_compressed,
+                                   get_compressed_fname(pristine_abspath,
+                                                        scratch_pool),
+                                   cache_abspath
+                                     ? get_compressed_fname(cache_abspath,
+                                                            scratch_pool)
+                                     : NULL,
+                                   scratch_pool));
+
+      if (!removed_plain && !removed_compressed && !ignore_enoent)
+        return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                                 _("Pristine text '%s' not found on disk"),
+                                 svn_checksum_to_cstring_display(
+                                   sha1_checksum, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -735,7 +1355,8 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
  *
  * Implements 'notes/wc-ng/pristine-store' section A-3(b). */
 static svn_error_t *
-pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
+pristine_remove_if_unreferenced(svn_wc__db_t *db,
+                                svn_wc__db_wcroot_t *wcroot,
                                 const svn_checksum_t *sha1_checksum,
                                 apr_pool_t *scratch_pool)
 {
@@ -748,12 +1369,26 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
    * at the disk, to ensure no concurrent pristine install/delete txn. */
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
     pristine_remove_if_unreferenced_txn(
-      wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
+      wcroot->sdb, db, wcroot, sha1_checksum, pristine_abspath,
+      scratch_pool),
     wcroot->sdb);
 
   return SVN_NO_ERROR;
 }
 
+/* Set *HAVE_WORK to whether the work queue of WCROOT is not empty. */
+static svn_error_t *
+have_queued_work(svn_boolean_t *have_work,
+                 svn_wc__db_wcroot_t *wcroot)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_LOOK_FOR_WORK));
+  SVN_ERR(svn_sqlite__step(have_work, stmt));
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 svn_error_t *
 svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            const char *wri_abspath,
@@ -780,25 +1415,64 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
   /* If the work queue is not empty, don't delete any pristine text because
    * the work queue may contain a reference to it. */
   {
-    svn_sqlite__stmt_t *stmt;
-    svn_boolean_t have_row;
+    svn_boolean_t have_work;
 
-    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_LOOK_FOR_WORK));
-    SVN_ERR(svn_sqlite__step(&have_row, stmt));
-    SVN_ERR(svn_sqlite__reset(stmt));
-
-    if (have_row)
+    SVN_ERR(have_queued_work(&have_work, wcroot));
+    if (have_work)
       return SVN_NO_ERROR;
   }
 
   /* If not referenced, remove the PRISTINE table row and the file. */
-  SVN_ERR(pristine_remove_if_unreferenced(wcroot, sha1_checksum, scratch_pool));
+  SVN_ERR(pristine_remove_if_unreferenced(db, wcroot, sha1_checksum,
+                                          scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
 
-/* Remove all unreferenced pristines in the WC DB in WCROOT.
+/* The number of unreferenced pristines removed per transaction by
+ * pristine_cleanup_wcroot(). */
+#define PRISTINE_CLEANUP_BATCH_SIZE 100
+
+/* Remove the pristine texts with the SHA-1 checksums in CHECKSUMS from
+ * WCROOT in DB, for those of them that are still unreferenced.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_remove_batch_txn(svn_wc__db_t *db,
+                          svn_wc__db_wcroot_t *wcroot,
+                          const apr_array_header_t *checksums,
+                          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      const svn_checksum_t *sha1_checksum
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+      const char *pristine_abspath;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, iterpool, iterpool));
+      SVN_ERR(pristine_remove_if_unreferenced_txn(wcroot->sdb, db, wcroot,
+                                                  sha1_checksum,
+                                                  pristine_abspath,
+                                                  iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove all unreferenced pristines in the WC DB in WCROOT, or if DEADLINE
+ * is not 0, stop after the batch during which DEADLINE passed.  Set
+ * *FINISHED to TRUE if no unreferenced pristines are left.
  *
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
  * them from the 'pristine' table and from disk.
@@ -830,37 +1504,62 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  * TODO: Provide feedback about any errors found and any corrections made.
  */
 static svn_error_t *
-pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
+pristine_cleanup_wcroot(svn_boolean_t *finished,
+                        svn_wc__db_t *db,
+                        svn_wc__db_wcroot_t *wcroot,
+                        apr_time_t deadline,
                         apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int found;
 
-  /* Find each unreferenced pristine in the DB and remove it. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
+  /* Find unreferenced pristines in the DB a batch at a time and remove
+     them, so that other processes get a chance to use the DB between
+     batches. */
+  do
     {
+      svn_sqlite__stmt_t *stmt;
+      apr_array_header_t *checksums;
       svn_boolean_t have_row;
-      const svn_checksum_t *sha1_checksum;
 
       svn_pool_clear(iterpool);
 
+      checksums = apr_array_make(iterpool, PRISTINE_CLEANUP_BATCH_SIZE,
+                                 sizeof(const svn_checksum_t *));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_SELECT_UNREFERENCED_PRISTINES));
+      SVN_ERR(svn_sqlite__bind_int(stmt, 1, PRISTINE_CLEANUP_BATCH_SIZE));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
-        break;
+      while (have_row)
+        {
+          const svn_checksum_t *sha1_checksum;
+          svn_error_t *err;
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
+          err = svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
                                             iterpool);
+          if (err)
+            return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+          APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = sha1_checksum;
+
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      found = checksums->nelts;
+      if (found)
+        SVN_SQLITE__WITH_IMMEDIATE_TXN(
+          pristine_remove_batch_txn(db, wcroot, checksums, iterpool),
+          wcroot->sdb);
     }
+  while (found == PRISTINE_CLEANUP_BATCH_SIZE
+         && (!deadline || apr_time_now() < deadline));
 
   svn_pool_destroy(iterpool);
 
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  *finished = (found < PRISTINE_CLEANUP_BATCH_SIZE);
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -870,6 +1569,30 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  svn_boolean_t finished;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR(pristine_cleanup_wcroot(&finished, db, wcroot, 0, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_cleanup_some(svn_boolean_t *finished,
+                                 svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 apr_interval_time_t max_time,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_boolean_t have_work;
+  apr_time_t deadline = apr_time_now() + max_time;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -877,7 +1600,17 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
+  SVN_ERR(have_queued_work(&have_work, wcroot));
+  if (have_work)
+    {
+      *finished = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(pristine_cleanup_wcroot(finished, db, wcroot, deadline,
+                                  scratch_pool));
+
+  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_INCREMENTAL_VACUUM));
 
   return SVN_NO_ERROR;
 }
@@ -935,10 +1668,18 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
 #endif
     if (err)
       return svn_error_trace(err);
-    else if (kind_on_disk != svn_node_file)
+    else
       {
-        *present = FALSE;
-        return SVN_NO_ERROR;
+        if (kind_on_disk == svn_node_none)
+          SVN_ERR(svn_io_check_path(get_compressed_fname(pristine_abspath,
+                                                         scratch_pool),
+                                    &kind_on_disk, scratch_pool));
+
+        if (kind_on_disk != svn_node_file)
+          {
+            *present = FALSE;
+            return SVN_NO_ERROR;
+          }
       }
   }
 
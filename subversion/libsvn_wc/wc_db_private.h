@@ -49,8 +49,32 @@ struct svn_wc__db_t {
   /* Should we open Sqlite databases EXCLUSIVE */
   svn_boolean_t exclusive;
 
-  /* Busy timeout in ms., 0 for the libsvn_subr default. */
-  apr_int32_t timeout;
+  /* SQLite tuning options.  Its busy timeout of 0 selects the
+     libsvn_subr default. */
+  svn_sqlite__open_options_t sqlite_options;
+
+  /* Directory shared with other working copies to hold pristine texts,
+     or NULL if not configured. */
+  const char *content_cache_abspath;
+
+  /* Number of threads comparing file contents in status walks. */
+  int status_jobs;
+
+  /* Should new pristine texts be stored compressed?  Only applies to
+     working copies of format SVN_WC__COMPRESSED_PRISTINES or newer. */
+  svn_boolean_t compress_pristines;
+
+  /* Temporary uncompressed copies of compressed pristine texts, handed out
+     by svn_wc__db_pristine_get_path().  They get removed when the DB is
+     closed or STATE_POOL is cleaned up.  NULL until first used.
+     const char *compressed_abspath -> const char *expanded_abspath */
+  apr_hash_t *expanded_pristines;
+
+  /* Number of threads installing files while running the work queue. */
+  int install_jobs;
+
+  /* Number of threads preparing text deltas during commits. */
+  int commit_jobs;
 
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
@@ -107,6 +131,11 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Until this time, a modification of a file might not change its
+     timestamp recorded by this process.  0 if no timestamps have been
+     recorded since the last svn_wc__db_clear_racy_fileinfo_internal(). */
+  apr_time_t racy_until;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -117,6 +146,14 @@ svn_wc__db_close_many_wcroots(apr_hash_t *roots,
                               apr_pool_t *scratch_pool);
 
 
+/* Forget the recorded timestamps in WCROOT that a later modification of
+   the file might not change, so that these files will be compared by
+   content instead.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__db_clear_racy_fileinfo_internal(svn_wc__db_wcroot_t *wcroot,
+                                        apr_pool_t *scratch_pool);
+
+
 /* Construct a new svn_wc__db_wcroot_t. The WCROOT_ABSPATH and SDB parameters
    must have lifetime of at least RESULT_POOL.  */
 svn_error_t *
@@ -198,7 +235,8 @@ svn_wc__db_util_fetch_wc_id(apr_int64_t *wc_id,
 /* Open a connection in *SDB to the WC database found in the WC metadata
  * directory inside DIR_ABSPATH, having the filename SDB_FNAME.
  *
- * SMODE, EXCLUSIVE and TIMEOUT are passed to svn_sqlite__open().
+ * SMODE, EXCLUSIVE and SQLITE_OPTIONS are passed to svn_sqlite__open2().
+ * SQLITE_OPTIONS may be NULL.
  *
  * Register MY_STATEMENTS, or if that is null, the default set of WC DB
  * statements, as the set of statements to be prepared now and executed
@@ -211,7 +249,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *sdb_fname,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
-                        apr_int32_t timeout,
+                        const svn_sqlite__open_options_t *sqlite_options,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
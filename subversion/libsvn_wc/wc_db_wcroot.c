@@ -206,6 +206,21 @@ close_wcroot(void *data)
     }
 #endif
 
+  if (wcroot->racy_until)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(NULL);
+
+      err = svn_wc__db_clear_racy_fileinfo_internal(wcroot, scratch_pool);
+      if (err)
+        {
+          /* Fall back to waiting until the timestamps are unambiguous. */
+          svn_error_clear(err);
+          svn_io_sleep_for_timestamps(NULL, NULL);
+        }
+
+      svn_pool_destroy(scratch_pool);
+    }
+
   err = svn_sqlite__close(wcroot->sdb);
   wcroot->sdb = NULL;
   if (err)
@@ -234,13 +249,22 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->dir_data = apr_hash_make(result_pool);
 
   (*db)->state_pool = result_pool;
+  (*db)->status_jobs = SVN_WC__DEFAULT_STATUS_JOBS;
+  (*db)->install_jobs = SVN_WC__DEFAULT_INSTALL_JOBS;
+  (*db)->commit_jobs = SVN_WC__DEFAULT_COMMIT_JOBS;
+  (*db)->sqlite_options.wal = SVN_WC__DEFAULT_SQLITE_WAL;
+  (*db)->sqlite_options.busy_backoff = SVN_WC__DEFAULT_SQLITE_BUSY_BACKOFF;
 
   /* Don't need to initialize (*db)->parse_cache, due to the calloc above */
   if (config)
     {
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
+      svn_boolean_t compress_pristines = FALSE;
       apr_int64_t timeout;
+      apr_int64_t size;
+      apr_int64_t jobs;
+      const char *cache_dir;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -260,7 +284,88 @@ svn_wc__db_open(svn_wc__db_t **db,
       if (err || timeout < 0 || timeout > APR_INT32_MAX)
         svn_error_clear(err);
       else
-        (*db)->timeout = (apr_int32_t)timeout;
+        (*db)->sqlite_options.busy_timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_bool(config, &(*db)->sqlite_options.busy_backoff,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_BUSY_BACKOFF,
+                                SVN_WC__DEFAULT_SQLITE_BUSY_BACKOFF);
+      svn_error_clear(err);
+
+      err = svn_config_get_bool(config, &(*db)->sqlite_options.wal,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_WAL,
+                                SVN_WC__DEFAULT_SQLITE_WAL);
+      svn_error_clear(err);
+
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT64_MAX / 0x400)
+        svn_error_clear(err);
+      else
+        (*db)->sqlite_options.mmap_size = size * 0x400;
+
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT64_MAX / 0x400)
+        svn_error_clear(err);
+      else
+        (*db)->sqlite_options.cache_size = size * 0x400;
+
+      err = svn_config_get_int64(config, &jobs,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_STATUS_JOBS,
+                                 SVN_WC__DEFAULT_STATUS_JOBS);
+      if (err || jobs < 1 || jobs > SVN_WC__MAX_STATUS_JOBS)
+        svn_error_clear(err);
+      else
+        (*db)->status_jobs = (int)jobs;
+
+      err = svn_config_get_int64(config, &jobs,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_INSTALL_JOBS,
+                                 SVN_WC__DEFAULT_INSTALL_JOBS);
+      if (err || jobs < 1 || jobs > SVN_WC__MAX_INSTALL_JOBS)
+        svn_error_clear(err);
+      else
+        (*db)->install_jobs = (int)jobs;
+
+      err = svn_config_get_int64(config, &jobs,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_COMMIT_JOBS,
+                                 SVN_WC__DEFAULT_COMMIT_JOBS);
+      if (err || jobs < 1 || jobs > SVN_WC__MAX_COMMIT_JOBS)
+        svn_error_clear(err);
+      else
+        (*db)->commit_jobs = (int)jobs;
+
+      err = svn_config_get_bool(config, &compress_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_COMPRESS_PRISTINES,
+                                FALSE);
+      if (err)
+        svn_error_clear(err);
+      else
+        (*db)->compress_pristines = compress_pristines;
+
+      svn_config_get(config, &cache_dir, SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_CONTENT_CACHE_DIR, NULL);
+      if (cache_dir && *cache_dir)
+        {
+          err = svn_dirent_get_absolute(&(*db)->content_cache_abspath,
+                                        svn_dirent_internal_style(
+                                          cache_dir, scratch_pool),
+                                        result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->content_cache_abspath = NULL;
+            }
+        }
     }
 
   return SVN_NO_ERROR;
@@ -288,6 +393,19 @@ svn_wc__db_close(svn_wc__db_t *db)
       svn_hash_sets(db->dir_data, local_abspath, NULL);
     }
 
+  /* Remove the temporary copies of compressed pristine texts right away
+     instead of waiting for STATE_POOL to be cleaned up. */
+  if (db->expanded_pristines)
+    {
+      for (hi = apr_hash_first(scratch_pool, db->expanded_pristines);
+           hi;
+           hi = apr_hash_next(hi))
+        SVN_ERR(svn_io_remove_file2(apr_hash_this_val(hi), TRUE,
+                                    scratch_pool));
+
+      db->expanded_pristines = NULL;
+    }
+
   /* Run the cleanup for each WCROOT.  */
   return svn_error_trace(svn_wc__db_close_many_wcroots(roots, db->state_pool,
                                                        scratch_pool));
@@ -377,6 +495,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->racy_until = 0;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -636,7 +755,8 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
                                         svn_sqlite__mode_readwrite,
-                                        db->exclusive, db->timeout, NULL,
+                                        db->exclusive, &db->sqlite_options,
+                                        NULL,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
             {
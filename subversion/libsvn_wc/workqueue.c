@@ -40,6 +40,8 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_task.h"
+#include "private/svn_trace.h"
 
 
 /* Workqueue operation names.  */
@@ -77,13 +79,18 @@ struct work_item_dispatch {
                        apr_pool_t *scratch_pool);
 };
 
-/* Forward definition */
+/* Forward definitions */
 static svn_error_t *
 get_and_record_fileinfo(work_item_baton_t *wqb,
                         const char *local_abspath,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+static void
+remember_fileinfo(work_item_baton_t *wqb,
+                  const char *local_abspath,
+                  const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -445,60 +452,100 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
-static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+/* What is needed to install a file, as read from the database by
+   prepare_file_install().  Installing the file itself does not access the
+   database, so that it can run on a worker thread. */
+typedef struct file_install_t
 {
-  const svn_skel_t *arg1 = work_item->children->next;
-  const svn_skel_t *arg4 = arg1->next->next->next;
-  const char *local_relpath;
+  /* The file to install. */
   const char *local_abspath;
-  svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
+
+  /* Where to read its contents from and whether that is a pristine text. */
+  const char *source_abspath;
+  svn_boolean_t source_is_pristine;
+
+  /* Whether SOURCE_ABSPATH is a temporary copy of the pristine text that
+     may be moved into place, and the pristine text to install instead
+     if it is gone. */
+  svn_boolean_t move_source;
+  const char *pristine_abspath;
+
+  /* How to translate the contents. */
   svn_boolean_t special;
-  svn_stream_t *src_stream;
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
+
+  /* Where to create the temporary file. */
   const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
+
+  /* How to tweak the installed file.  SET_TIME is 0 to keep the current
+     time. */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t set_time;
+
+  /* Whether to record the size and timestamp of the installed file. */
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Set *INSTALL to what is needed to process the OP_FILE_INSTALL work item
+ * WORK_ITEM, allocated in RESULT_POOL. */
+static svn_error_t *
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
+  const char *local_relpath;
+  svn_boolean_t use_commit_times;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&fi->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  fi->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
+                                            db, fi->local_abspath,
+                                            wri_abspath,
                                             scratch_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
+      SVN_ERR(svn_wc__db_from_relpath(&fi->source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
+
+      if (arg4->next != NULL)
+        {
+          SVN_ERR(svn_skel__parse_int(&val, arg4->next, scratch_pool));
+          fi->move_source = (val != 0);
+        }
+
+      if (fi->move_source && checksum)
+        SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->pristine_abspath,
+                                                    wcroot_abspath,
+                                                    checksum,
+                                                    result_pool,
+                                                    scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,27 +560,233 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(fi->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
+      fi->source_is_pristine = TRUE;
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&fi->style, &fi->eol,
+                                     &fi->keywords,
+                                     &fi->special, db, fi->local_abspath,
                                      props, FALSE,
+                                     result_pool, scratch_pool));
+  if (fi->special)
+    {
+      *install = fi;
+      return SVN_NO_ERROR;
+    }
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&fi->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  fi->set_executable = (props
+                        && svn_hash_gets(props, SVN_PROP_EXECUTABLE) != NULL);
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, fi->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      fi->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    fi->set_time = changed_date;
+
+  *install = fi;
+  return SVN_NO_ERROR;
+}
+
+/* Rename SOURCE_ABSPATH to LOCAL_ABSPATH, creating missing parent
+ * directories.  Set *MOVED to FALSE without doing anything if
+ * SOURCE_ABSPATH doesn't exist. */
+static svn_error_t *
+move_into_place(svn_boolean_t *moved,
+                const char *source_abspath,
+                const char *local_abspath,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  svn_node_kind_t kind;
+
+  *moved = TRUE;
+  err = svn_io_file_rename2(source_abspath, local_abspath, FALSE,
+                            scratch_pool);
+  if (!err || !APR_STATUS_IS_ENOENT(err->apr_err))
+    return svn_error_trace(err);
+
+  svn_error_clear(err);
+  SVN_ERR(svn_io_check_path(source_abspath, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      *moved = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* See svn_stream__install_stream(). */
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(local_abspath,
+                                                         scratch_pool),
+                                      scratch_pool));
+  return svn_error_trace(svn_io_file_rename2(source_abspath, local_abspath,
+                                             FALSE, scratch_pool));
+}
+
+/* Copy the plain pristine file PRISTINE_ABSPATH to LOCAL_ABSPATH, letting
+ * the two share their data where the file system supports this.  Set
+ * *COPIED to FALSE without doing anything if PRISTINE_ABSPATH doesn't exist
+ * (the pristine may be stored compressed) or the parent directory of
+ * LOCAL_ABSPATH is missing. */
+static svn_error_t *
+copy_into_place(svn_boolean_t *copied,
+                const char *pristine_abspath,
+                const char *local_abspath,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  *copied = TRUE;
+  err = svn_io_copy_file2(pristine_abspath, local_abspath,
+                          SVN_IO_COPY_FILE_CLONE, NULL, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *copied = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Tweak the file installed as described by INSTALL according to its
+ * properties and set *DIRENT as described for install_file(). */
+static svn_error_t *
+finish_install(const svn_io_dirent2_t **dirent,
+               const file_install_t *install,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+
+  /* Tweak the on-disk file according to its properties.  */
+  if (install->set_executable)
+    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
+
+  if (install->set_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->set_time,
+                                          local_abspath,
+                                          scratch_pool));
+
+  /* ### this should happen before we rename the file into place.  */
+  if (install->record_fileinfo)
+    {
+      SVN_ERR(svn_io_stat_dirent2(dirent, local_abspath, FALSE, FALSE,
+                                  result_pool, scratch_pool));
+      if ((*dirent)->kind != svn_node_file)
+        *dirent = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Install the file described by INSTALL.  If INSTALL->record_fileinfo is
+ * set, set *DIRENT to the stat data of the installed file, allocated in
+ * RESULT_POOL, or to NULL if it is not a file.  Otherwise set *DIRENT to
+ * NULL.
+ *
+ * This does not access the working copy database. */
+static svn_error_t *
+install_file(const svn_io_dirent2_t **dirent,
+             const file_install_t *install,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+  const char *source_abspath = install->source_abspath;
+  svn_boolean_t source_is_pristine = install->source_is_pristine;
+  svn_boolean_t translation_required;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  *dirent = NULL;
+
+  translation_required = svn_subst_translation_required(install->style,
+                                                        install->eol,
+                                                        install->keywords,
+                                                        FALSE /* special */,
+                                                        TRUE);
+
+  if (install->move_source && !install->special && !translation_required)
+    {
+      svn_boolean_t moved;
+
+      SVN_ERR(move_into_place(&moved, source_abspath, local_abspath,
+                              scratch_pool));
+      if (moved)
+        return svn_error_trace(finish_install(dirent, install,
+                                              result_pool, scratch_pool));
+
+      /* The copy is gone, most likely because we moved it before the
+         work item was interrupted.  Install the pristine text instead. */
+      if (! install->pristine_abspath)
+        return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                                 _("Can't install '%s' from pristine store, "
+                                   "because no checksum is recorded for "
+                                   "this file"),
+                                 svn_dirent_local_style(local_abspath,
+                                                        scratch_pool));
+      source_abspath = install->pristine_abspath;
+      source_is_pristine = TRUE;
+    }
+
+  /* Untranslated pristines can be copied as they are, without passing
+     their contents through our buffers. */
+  if (source_is_pristine && !install->special && !translation_required)
+    {
+      svn_boolean_t copied;
+
+      SVN_ERR(copy_into_place(&copied, source_abspath, local_abspath,
+                              scratch_pool));
+      if (copied)
+        return svn_error_trace(finish_install(dirent, install,
+                                              result_pool, scratch_pool));
+    }
+
+  if (source_is_pristine)
+    SVN_ERR(svn_wc__db_pristine_open_future_path(&src_stream,
+                                                 source_abspath,
+                                                 scratch_pool,
+                                                 scratch_pool));
+  else
+    SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
                                      scratch_pool, scratch_pool));
-  if (special)
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
@@ -552,27 +805,21 @@ run_file_install(work_item_baton_t *wqb,
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
-                                     FALSE /* special */,
-                                     TRUE /* force_eol_check */))
+  if (translation_required)
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
   /* Copy from the source to the dest, translating as we go. This will also
@@ -588,45 +835,32 @@ run_file_install(work_item_baton_t *wqb,
   SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
                                      TRUE /* make_parents*/, scratch_pool));
 
-  /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
-                                       scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
+  return svn_error_trace(finish_install(dirent, install,
+                                        result_pool, scratch_pool));
+}
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(install_file(&dirent, install, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
 
-  /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
-    {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
-    }
+  if (dirent)
+    remember_fileinfo(wqb, install->local_abspath, dirent);
 
   return SVN_NO_ERROR;
 }
@@ -672,6 +906,40 @@ svn_wc__wq_build_file_install(svn_skel_t **work_item,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__wq_build_file_install_moved(svn_skel_t **work_item,
+                                    svn_wc__db_t *db,
+                                    const char *local_abspath,
+                                    const char *source_abspath,
+                                    svn_boolean_t use_commit_times,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  const char *local_relpath;
+  const char *wri_abspath;
+  *work_item = svn_skel__make_empty_list(result_pool);
+
+  wri_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
+
+  /* The trailing flag tells that SOURCE_ABSPATH may be moved into place.
+     Older clients ignore it and translate SOURCE_ABSPATH as usual. */
+  svn_skel__prepend_int(TRUE, *work_item, result_pool);
+
+  SVN_ERR(svn_wc__db_to_relpath(&local_relpath, db, wri_abspath,
+                                source_abspath, result_pool, scratch_pool));
+  svn_skel__prepend_str(local_relpath, *work_item, result_pool);
+
+  SVN_ERR(svn_wc__db_to_relpath(&local_relpath, db, wri_abspath,
+                                local_abspath, result_pool, scratch_pool));
+
+  svn_skel__prepend_int(TRUE /* record_fileinfo */, *work_item, result_pool);
+  svn_skel__prepend_int(use_commit_times, *work_item, result_pool);
+  svn_skel__prepend_str(local_relpath, *work_item, result_pool);
+  svn_skel__prepend_str(OP_FILE_INSTALL, *work_item, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -1434,13 +1702,17 @@ dispatch_work_item(work_item_baton_t *wqb,
     {
       if (svn_skel__matches_atom(work_item->children, scan->name))
         {
+          svn_trace__span_t *span;
 
 #ifdef SVN_DEBUG_WORK_QUEUE
           SVN_DBG(("dispatch: operation='%s'\n", scan->name));
 #endif
-          SVN_ERR((*scan->func)(wqb, db, work_item, wri_abspath,
-                                cancel_func, cancel_baton,
-                                scratch_pool));
+          span = svn_trace__begin("wc.work_item");
+          svn_trace__attr(span, "operation", scan->name);
+          SVN_ERR(svn_trace__end(span,
+                                 (*scan->func)(wqb, db, work_item,
+                                               wri_abspath, cancel_func,
+                                               cancel_baton, scratch_pool)));
 
 #ifdef SVN_RUN_WORK_QUEUE_TWICE
 #ifdef SVN_DEBUG_WORK_QUEUE
@@ -1474,6 +1746,377 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+/* Return ERR wrapped in an error telling that the work item ID, whose
+   contents is WORK_ITEM, failed in the work queue of WRI_ABSPATH. */
+static svn_error_t *
+work_item_error(svn_error_t *err,
+                const char *wri_abspath,
+                apr_uint64_t id,
+                const svn_skel_t *work_item,
+                apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/* Number of work items that run_work_queue_parallel() fetches at once. */
+#define WQ_BATCH_SIZE 256
+
+/* File installs running concurrently, see run_work_queue_parallel().
+   Only used by the thread running the work queue. */
+typedef struct file_installer_t
+{
+  /* Parent of the job pools.  It must outlive SET, so it is created
+     before the pool that SET lives in. */
+  apr_pool_t *jobs_pool;
+
+  /* Runs install_task() for the jobs. */
+  svn_task__set_t *set;
+
+  /* The jobs queued since the last call to finish_installs(), in work
+     queue order (install_job_t *), and a map of their targets
+     (const char *local_abspath -> install_job_t *). */
+  apr_array_header_t *jobs;
+  apr_hash_t *targets;
+} file_installer_t;
+
+/* The installation of one file. */
+typedef struct install_job_t
+{
+  /* Private pool of this job.  INSTALL and the results are allocated
+     in it. */
+  apr_pool_t *pool;
+
+  /* The work item, owned by the main thread. */
+  apr_uint64_t id;
+  const svn_skel_t *work_item;
+
+  file_install_t *install;
+
+  /* The result, valid once it has been delivered by deliver_install(). */
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+} install_job_t;
+
+/* Result of install_task(). */
+typedef struct install_result_t
+{
+  install_job_t *job;
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+} install_result_t;
+
+/* Implements svn_task__process_func_t.  Run the install_job_t in
+   PROCESS_BATON and return an install_result_t in *RESULT.  Failures get
+   reported through the result such that finish_installs() can keep the
+   jobs that completed before. */
+static svn_error_t *
+install_task(void **result,
+             void *process_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  install_job_t *job = process_baton;
+  install_result_t *install = apr_pcalloc(result_pool, sizeof(*install));
+
+  /* The caller's cancellation callback may not be thread-safe; the main
+     thread checks it between work items. */
+  install->job = job;
+  install->err = install_file(&install->dirent, job->install, NULL, NULL,
+                              result_pool, scratch_pool);
+
+  *result = install;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Hand the install_result_t in
+   RESULT over to its job. */
+static svn_error_t *
+deliver_install(void *result,
+                void *output_baton,
+                apr_pool_t *scratch_pool)
+{
+  install_result_t *install = result;
+  install_job_t *job = install->job;
+
+  job->err = install->err;
+  if (install->dirent)
+    job->dirent = svn_io_dirent2_dup(install->dirent, job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the OP_FILE_INSTALL work item WORK_ITEM with ID on INSTALLER.  Set
+   *QUEUED to FALSE if it must rather be run on the main thread, i.e. if an
+   install of the same file is still queued or if it can't be prepared.  In
+   the latter case, running it the regular way will report the problem. */
+static svn_error_t *
+queue_install(svn_boolean_t *queued,
+              file_installer_t *installer,
+              svn_wc__db_t *db,
+              const char *wri_abspath,
+              apr_uint64_t id,
+              const svn_skel_t *work_item,
+              apr_pool_t *scratch_pool)
+{
+  install_job_t *job;
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  *queued = FALSE;
+
+  pool = svn_pool_create(installer->jobs_pool);
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->pool = pool;
+  job->id = id;
+  job->work_item = work_item;
+
+  err = prepare_file_install(&job->install, db, work_item, wri_abspath,
+                             pool, scratch_pool);
+  if (err || svn_hash_gets(installer->targets, job->install->local_abspath))
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  APR_ARRAY_PUSH(installer->jobs, install_job_t *) = job;
+  svn_hash_sets(installer->targets, job->install->local_abspath, job);
+  SVN_ERR(svn_task__add(installer->set, install_task, job));
+
+  *queued = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Wait for all jobs of INSTALLER and release them.  Add the ids of the
+   jobs up to the first failed one to COMPLETED and remember their file
+   information in WQB.  Return the error of the first failed job, if any,
+   as reported for the work queue of WRI_ABSPATH. */
+static svn_error_t *
+finish_installs(file_installer_t *installer,
+                apr_array_header_t *completed,
+                work_item_baton_t *wqb,
+                const char *wri_abspath,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_task__set_finish(installer->set));
+
+  for (i = 0; i < installer->jobs->nelts; i++)
+    {
+      install_job_t *job = APR_ARRAY_IDX(installer->jobs, i,
+                                         install_job_t *);
+
+      if (!err && job->err)
+        {
+          err = work_item_error(job->err, wri_abspath, job->id,
+                                job->work_item, scratch_pool);
+          job->err = SVN_NO_ERROR;
+        }
+      else if (!err)
+        {
+          APR_ARRAY_PUSH(completed, apr_uint64_t) = job->id;
+          if (job->dirent)
+            remember_fileinfo(wqb, job->install->local_abspath, job->dirent);
+        }
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+
+  apr_array_clear(installer->jobs);
+  apr_hash_clear(installer->targets);
+
+  return err;
+}
+
+/* Mark the work items in *COMPLETED as completed in the work queue of
+   WRI_ABSPATH in DB and record the file information in WQB.  Then reset
+   WQB and set *COMPLETED to a new empty array in WQB->result_pool. */
+static svn_error_t *
+flush_completed(apr_array_header_t **completed,
+                work_item_baton_t *wqb,
+                svn_wc__db_t *db,
+                const char *wri_abspath,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *ids;
+  apr_array_header_t *work_items;
+
+  if ((*completed)->nelts || wqb->record_map)
+    SVN_ERR(svn_wc__db_wq_complete_and_fetch(&ids, &work_items,
+                                             db, wri_abspath,
+                                             *completed, wqb->record_map,
+                                             0, 0,
+                                             scratch_pool, scratch_pool));
+
+  svn_pool_clear(wqb->result_pool);
+  wqb->record_map = NULL;
+  wqb->used = FALSE;
+  *completed = apr_array_make(wqb->result_pool, WQ_BATCH_SIZE,
+                              sizeof(apr_uint64_t));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *INSTALLER to a new file installer running up to JOBS installs
+   concurrently.  Outstanding installs will be cancelled and all jobs
+   released when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+start_file_installer(file_installer_t **installer,
+                     int jobs,
+                     apr_pool_t *result_pool)
+{
+  file_installer_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
+
+  fi->jobs = apr_array_make(result_pool, WQ_BATCH_SIZE,
+                            sizeof(install_job_t *));
+  fi->targets = apr_hash_make(result_pool);
+
+  /* Sub-pools get destroyed in reverse order of creation, so the task set
+     will be gone before the jobs that its tasks use. */
+  fi->jobs_pool = svn_pool_create(result_pool);
+  SVN_ERR(svn_task__set_create(&fi->set, jobs, deliver_install, fi,
+                               NULL, NULL, svn_pool_create(result_pool)));
+
+  *installer = fi;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_wc__wq_run(), but run up to JOBS file installs concurrently.
+ *
+ * Consecutive OP_FILE_INSTALL items for different files are independent,
+ * so they run concurrently.  Any other work item waits for all queued
+ * installs, and their completion is recorded before it runs, so that it
+ * sees the same state as when running the queue item by item.
+ *
+ * Work items are deleted from the queue in batches, together with the
+ * recorded file information, and always in queue order.  If we crash, the
+ * queue is thus restarted from the first item that may not have completed;
+ * as with the serial loop, items must therefore be safe to run twice. */
+static svn_error_t *
+run_work_queue_parallel(svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        int jobs,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *itempool = svn_pool_create(scratch_pool);
+  file_installer_t *installer;
+  apr_array_header_t *completed;
+  apr_uint64_t last_id = 0;
+  work_item_baton_t wib = { 0 };
+  svn_error_t *err = SVN_NO_ERROR;
+
+  wib.result_pool = svn_pool_create(scratch_pool);
+  completed = apr_array_make(wib.result_pool, WQ_BATCH_SIZE,
+                             sizeof(apr_uint64_t));
+
+  SVN_ERR(start_file_installer(&installer, jobs, scratch_pool));
+
+  while (!err)
+    {
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      /* Mark the previous batch completed and fetch the next one. */
+      SVN_ERR(svn_wc__db_wq_complete_and_fetch(&ids, &work_items,
+                                               db, wri_abspath,
+                                               completed, wib.record_map,
+                                               last_id, WQ_BATCH_SIZE,
+                                               iterpool, iterpool));
+      svn_pool_clear(wib.result_pool);
+      wib.record_map = NULL;
+      wib.used = FALSE;
+      completed = apr_array_make(wib.result_pool, WQ_BATCH_SIZE,
+                                 sizeof(apr_uint64_t));
+
+      if (ids->nelts == 0)
+        break;
+
+      for (i = 0; i < ids->nelts && !err; i++)
+        {
+          apr_uint64_t id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+          const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                      const svn_skel_t *);
+          svn_boolean_t queued = FALSE;
+
+          svn_pool_clear(itempool);
+
+          /* Stop work queue processing, if requested. A future 'svn cleanup'
+             should be able to continue the processing. */
+          if (cancel_func)
+            err = cancel_func(cancel_baton);
+
+          if (!err && svn_skel__matches_atom(work_item->children,
+                                             OP_FILE_INSTALL))
+            err = queue_install(&queued, installer, db, wri_abspath,
+                                id, work_item, itempool);
+
+          if (!err && !queued)
+            {
+              err = finish_installs(installer, completed, &wib, wri_abspath,
+                                    itempool);
+              if (!err)
+                err = flush_completed(&completed, &wib, db, wri_abspath,
+                                      itempool);
+              if (!err)
+                {
+                  err = dispatch_work_item(&wib, db, wri_abspath, work_item,
+                                           cancel_func, cancel_baton,
+                                           itempool);
+                  if (err)
+                    err = work_item_error(err, wri_abspath, id, work_item,
+                                          scratch_pool);
+                  else
+                    APR_ARRAY_PUSH(completed, apr_uint64_t) = id;
+                }
+            }
+
+          last_id = id;
+        }
+
+      if (!err)
+        err = finish_installs(installer, completed, &wib, wri_abspath,
+                              iterpool);
+    }
+
+  if (err)
+    {
+      /* Wait for the remaining installs and keep what completed before
+         the failure. */
+      err = svn_error_compose_create(
+              err,
+              finish_installs(installer, completed, &wib, wri_abspath,
+                              iterpool));
+      err = svn_error_compose_create(
+              err,
+              flush_completed(&completed, &wib, db, wri_abspath, iterpool));
+      return svn_error_trace(err);
+    }
+
+  svn_pool_destroy(itempool);
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1500,6 +2143,16 @@ svn_wc__wq_run(svn_wc__db_t *db,
   }
 #endif
 
+  {
+    int jobs = svn_wc__db_get_install_jobs(db);
+
+    if (jobs > 1)
+      return svn_error_trace(run_work_queue_parallel(db, wri_abspath, jobs,
+                                                     cancel_func,
+                                                     cancel_baton,
+                                                     scratch_pool));
+  }
+
   while (TRUE)
     {
       apr_uint64_t id;
@@ -1546,16 +2199,8 @@ svn_wc__wq_run(svn_wc__db_t *db,
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
-        {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
+        return svn_error_trace(work_item_error(err, wri_abspath, id,
+                                               work_item, scratch_pool));
 
       /* The work item finished without error. Mark it completed
          in the next loop.  */
@@ -1624,18 +2269,28 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   const svn_io_dirent2_t *dirent;
 
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
-                              wqb->result_pool, scratch_pool));
+                              scratch_pool, scratch_pool));
 
   if (dirent->kind != svn_node_file)
     return SVN_NO_ERROR;
 
+  remember_fileinfo(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Arrange that the size and timestamp in DIRENT are recorded for the file
+   LOCAL_ABSPATH when the current work item is marked completed. */
+static void
+remember_fileinfo(work_item_baton_t *wqb,
+                  const char *local_abspath,
+                  const svn_io_dirent2_t *dirent)
+{
   wqb->used = TRUE;
 
   if (! wqb->record_map)
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -116,6 +116,23 @@ svn_wc__wq_build_file_install(svn_skel_t **work_item,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
+/* Like svn_wc__wq_build_file_install() with RECORD_FILEINFO set, but
+   SOURCE_ABSPATH is a temporary file holding the pristine contents of
+   LOCAL_ABSPATH.  If the file needs no translation, SOURCE_ABSPATH is
+   renamed into place instead of being copied.  If SOURCE_ABSPATH is gone
+   when the work item runs, the pristine contents are installed.
+
+   An OP_FILE_REMOVE should still be queued to remove SOURCE_ABSPATH in
+   case it is translated instead of moved. */
+svn_error_t *
+svn_wc__wq_build_file_install_moved(svn_skel_t **work_item,
+                                    svn_wc__db_t *db,
+                                    const char *local_abspath,
+                                    const char *source_abspath,
+                                    svn_boolean_t use_commit_times,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+
 
 /* Set *WORK_ITEM to a new work item that will remove a single
    file LOCAL_ABSPATH from the working copy identified by the pair DB,
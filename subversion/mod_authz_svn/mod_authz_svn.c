@@ -36,6 +36,7 @@
 #include <ap_mmn.h>
 #include <apr_uri.h>
 #include <apr_lib.h>
+#include <apr_time.h>
 #include <mod_dav.h>
 
 #include "mod_dav_svn.h"
@@ -47,6 +48,7 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 /* The apache headers define these and they conflict with our definitions. */
 #ifdef PACKAGE_BUGREPORT
@@ -408,6 +410,7 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
   svn_authz_t *access_conf = NULL;
   svn_error_t *svn_err = SVN_NO_ERROR;
   dav_error *dav_err;
+  apr_time_t start_time;
 
   dav_err = dav_svn_get_repos_path2(r, conf->base_path, &repos_path, scratch_pool);
   if (dav_err)
@@ -464,6 +467,7 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
                     "Path to groups file is %s", groups_file);
     }
 
+  start_time = apr_time_now();
   svn_err = svn_repos_authz_read3(&access_conf,
                                   access_file, groups_file,
                                   TRUE, NULL,
@@ -476,6 +480,13 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
                     svn_err, scratch_pool);
       access_conf = NULL;
     }
+  else
+    {
+      /* Includes the time to parse the rules unless they were cached. */
+      ap_log_rerror(APLOG_MARK, APLOG_DEBUG, 0, r,
+                    "Loaded authz rules in %" APR_TIME_T_FMT " usec",
+                    apr_time_now() - start_time);
+    }
 
   return access_conf;
 }
@@ -509,6 +520,144 @@ get_username_to_authorize(request_rec *r, authz_svn_config_rec *conf,
   return username_to_authorize;
 }
 
+/* Maximum number of authz verdicts to remember per connection. */
+#define VERDICT_CACHE_SIZE 1024
+
+/* Key of the verdict cache in the connection pool's user data. */
+#define VERDICT_CACHE_KEY "mod_authz_svn:verdict-cache"
+
+/* The authz verdicts determined for earlier requests on a connection.
+ * A checkout, for instance, sends thousands of requests for the same user
+ * and closely related paths over the same connection. */
+typedef struct verdict_cache_t
+{
+  /* Identifies the authz rules that the VERDICTS are based on.  This is
+   * a copy of the svn_repos__authz_id() data. */
+  const void *authz_id;
+  apr_size_t authz_id_size;
+
+  /* Maps keys constructed by get_verdict_key() to the verdict, which is
+   * either "0" or "1". */
+  apr_hash_t *verdicts;
+
+  /* Pool containing VERDICTS and their keys; gets cleared when the cache
+   * is full or the authz rules change. */
+  apr_pool_t *verdicts_pool;
+} verdict_cache_t;
+
+/* Return the verdict cache of the connection of R for the authz rules
+ * identified by AUTHZ_ID, which must not be NULL.  Drop all cached
+ * verdicts if they have been determined for different rules. */
+static verdict_cache_t *
+get_verdict_cache(request_rec *r,
+                  const svn_membuf_t *authz_id)
+{
+  apr_pool_t *pool = r->connection->pool;
+  verdict_cache_t *cache = NULL;
+
+  apr_pool_userdata_get((void **)&cache, VERDICT_CACHE_KEY, pool);
+  if (!cache)
+    {
+      cache = apr_pcalloc(pool, sizeof(*cache));
+      cache->verdicts_pool = svn_pool_create(pool);
+      apr_pool_userdata_setn(cache, VERDICT_CACHE_KEY, NULL, pool);
+    }
+  else if (cache->authz_id_size == authz_id->size
+           && memcmp(cache->authz_id, authz_id->data, authz_id->size) == 0)
+    {
+      return cache;
+    }
+  else
+    {
+      svn_pool_clear(cache->verdicts_pool);
+    }
+
+  cache->authz_id = apr_pmemdup(cache->verdicts_pool, authz_id->data,
+                                authz_id->size);
+  cache->authz_id_size = authz_id->size;
+  cache->verdicts = apr_hash_make(cache->verdicts_pool);
+
+  return cache;
+}
+
+/* Return the key under which to cache the verdict on REQUIRED_ACCESS to
+ * REPOS_PATH in REPOS_NAME for USER, allocated in POOL.  USER may be
+ * NULL for anonymous access. */
+static const char *
+get_verdict_key(const char *repos_name,
+                const char *repos_path,
+                const char *user,
+                svn_repos_authz_access_t required_access,
+                apr_pool_t *pool)
+{
+  /* Neither user nor repository names are limited in what characters
+   * they may contain, so prefix them with their lengths. */
+  return apr_psprintf(pool, "%d %s%" APR_SIZE_T_FMT ":%s"
+                      " %" APR_SIZE_T_FMT ":%s %s",
+                      (int)required_access,
+                      user ? "+" : "-",
+                      user ? strlen(user) : 0, user ? user : "",
+                      repos_name ? strlen(repos_name) : 0,
+                      repos_name ? repos_name : "",
+                      repos_path);
+}
+
+/* Like svn_repos_authz_check_access() but look up the verdict on
+ * REPOS_PATH in the per-connection cache of R first and store new
+ * verdicts in that cache.  REPOS_PATH may be NULL but then the verdict
+ * won't be cached. */
+static svn_error_t *
+check_access_cached(request_rec *r,
+                    svn_authz_t *access_conf,
+                    const char *repos_name,
+                    const char *repos_path,
+                    const char *user,
+                    svn_repos_authz_access_t required_access,
+                    svn_boolean_t *access_granted,
+                    apr_pool_t *scratch_pool)
+{
+  const svn_membuf_t *authz_id = svn_repos__authz_id(access_conf);
+  verdict_cache_t *cache;
+  const char *key;
+  const char *verdict;
+
+  if (!repos_path || !authz_id)
+    return svn_error_trace(svn_repos_authz_check_access(access_conf,
+                                                        repos_name,
+                                                        repos_path, user,
+                                                        required_access,
+                                                        access_granted,
+                                                        scratch_pool));
+
+  cache = get_verdict_cache(r, authz_id);
+  key = get_verdict_key(repos_name, repos_path, user, required_access,
+                        scratch_pool);
+  verdict = apr_hash_get(cache->verdicts, key, APR_HASH_KEY_STRING);
+  if (verdict)
+    {
+      *access_granted = (*verdict == '1');
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_repos_authz_check_access(access_conf, repos_name, repos_path,
+                                       user, required_access,
+                                       access_granted, scratch_pool));
+
+  /* Keep the cache bounded: start over once it is full. */
+  if (apr_hash_count(cache->verdicts) >= VERDICT_CACHE_SIZE)
+    {
+      svn_pool_clear(cache->verdicts_pool);
+      cache->authz_id = apr_pmemdup(cache->verdicts_pool, authz_id->data,
+                                    authz_id->size);
+      cache->verdicts = apr_hash_make(cache->verdicts_pool);
+    }
+
+  apr_hash_set(cache->verdicts, apr_pstrdup(cache->verdicts_pool, key),
+               APR_HASH_KEY_STRING, *access_granted ? "1" : "0");
+
+  return SVN_NO_ERROR;
+}
+
 /* Check if the current request R is allowed.  Upon exit *REPOS_PATH_REF
  * will contain the path and repository name that an operation was requested
  * on in the form 'name:path'.  *DEST_REPOS_PATH_REF will contain the
@@ -714,12 +863,12 @@ req_check_access(request_rec *r,
   if (repos_path
       || (!repos_path && (authz_svn_type & svn_authz_write)))
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             authz_svn_type,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access_cached(r, access_conf, repos_name,
+                                    repos_path,
+                                    username_to_authorize,
+                                    authz_svn_type,
+                                    &authz_access_granted,
+                                    r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -749,14 +898,14 @@ req_check_access(request_rec *r,
      repos_path == NULL (see above for explanations) */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf,
-                                             dest_repos_name,
-                                             dest_repos_path,
-                                             username_to_authorize,
-                                             svn_authz_write
-                                             |svn_authz_recursive,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access_cached(r, access_conf,
+                                    dest_repos_name,
+                                    dest_repos_path,
+                                    username_to_authorize,
+                                    svn_authz_write
+                                    |svn_authz_recursive,
+                                    &authz_access_granted,
+                                    r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -813,12 +962,12 @@ subreq_bypass2(request_rec *r,
    */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             svn_authz_none|svn_authz_read,
-                                             &authz_access_granted,
-                                             scratch_pool);
+      svn_err = check_access_cached(r, access_conf, repos_name,
+                                    repos_path,
+                                    username_to_authorize,
+                                    svn_authz_none|svn_authz_read,
+                                    &authz_access_granted,
+                                    scratch_pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
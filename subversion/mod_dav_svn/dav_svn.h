@@ -340,10 +340,44 @@ svn_boolean_t dav_svn__get_revprop_cache_flag(request_rec *r);
 svn_boolean_t
 dav_svn__get_nodeprop_cache_flag(request_rec *r);
 
+/* for the repository referred to by this request, shall the hottest nodes
+ * be recorded and preloaded into the caches? */
+svn_boolean_t dav_svn__get_cache_warmup_flag(request_rec *r);
+
+/* for the repository referred to by this request, shall new revisions be
+ * preloaded into the caches? */
+svn_boolean_t dav_svn__get_cache_warmup_on_commit_flag(request_rec *r);
+
 /* has block read mode been enabled for the repository referred to by this
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
 
+/* for the repository referred to by this request, how many threads shall
+   compute the file deltas of an update report? */
+int dav_svn__get_update_jobs(request_rec *r);
+
+/* for the repository referred to by this request, how many bytes may
+   those threads buffer in total for a single update report? */
+apr_size_t dav_svn__get_update_buffer_size(request_rec *r);
+
+/* for the repository referred to by this request, how many bytes of
+   report output shall be collected before sending them? */
+apr_size_t dav_svn__get_report_buffer_size(request_rec *r);
+
+/* for the repository referred to by this request, how long may report
+   output be held back in that buffer? */
+apr_interval_time_t dav_svn__get_report_flush_interval(request_rec *r);
+
+/* for the repository referred to by this request, shall responses for
+   revision-pinned resources be cached? */
+svn_boolean_t dav_svn__get_response_cache_flag(request_rec *r);
+
+/* for the repository referred to by this request, return the directory
+   of the on-disk response cache tier and set *MAX_SIZE to its size limit
+   in bytes.  Return NULL if there is no on-disk tier. */
+const char *dav_svn__get_response_cache_dir(request_rec *r,
+                                            apr_uint64_t *max_size);
+
 /* for the repository referred to by this request, are subrequests bypassed?
  * A function pointer if yes, NULL if not.
  */
@@ -417,6 +451,11 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return how long a mirror shall hold a read request for a revision
+   that has not been replicated from the master yet (configured via
+   SVNMirrorWaitTimeout).  0 means "don't wait". */
+apr_interval_time_t dav_svn__get_mirror_wait_timeout(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -491,6 +530,16 @@ svn_error_t *
 dav_svn__output_pass_brigade(dav_svn__output *output,
                              apr_bucket_brigade *bb);
 
+/* Make the dav_svn__brigade functions collect the data written to OUTPUT
+   in buffers of BUFFER_SIZE bytes and pass the brigade down the filter
+   stack only when such a buffer is full or when FLUSH_INTERVAL has passed
+   since the last time.  This is much cheaper for reports that produce
+   lots of small XML fragments. */
+void
+dav_svn__output_set_coalescing(dav_svn__output *output,
+                               apr_size_t buffer_size,
+                               apr_interval_time_t flush_interval);
+
 
 /*** activity.c ***/
 
@@ -705,6 +754,7 @@ static const dav_report_elem dav_svn__reports_list[] = {
   { SVN_XML_NAMESPACE, "get-deleted-rev-report" },
   { SVN_XML_NAMESPACE, SVN_DAV__MERGEINFO_REPORT },
   { SVN_XML_NAMESPACE, SVN_DAV__INHERITED_PROPS_REPORT },
+  { SVN_XML_NAMESPACE, SVN_DAV__STAT_MANY_REPORT },
   { NULL, NULL },
 };
 
@@ -757,6 +807,11 @@ dav_svn__get_inherited_props_report(const dav_resource *resource,
                                     const apr_xml_doc *doc,
                                     dav_svn__output *output);
 
+dav_error *
+dav_svn__stat_many_report(const dav_resource *resource,
+                          const apr_xml_doc *doc,
+                          dav_svn__output *output);
+
 /*** posts/ ***/
 
 /* The various POST handlers, defined in posts/, and used by repos.c.  */
@@ -1119,6 +1174,32 @@ dav_svn__get_youngest_rev(svn_revnum_t *youngest_p,
 /* Perform the fixup hook for the R request.  */
 int dav_svn__proxy_request_fixup(request_rec *r);
 
+/* If R is served by a mirror (i.e. SVNMasterURI is set) and REV is
+   younger than the youngest revision of REPOS, wait for svnsync to
+   deliver REV.  Give up after the SVNMirrorWaitTimeout and return
+   an HTTP_SERVICE_UNAVAILABLE error.  Non-mirrors and invalid REVs
+   return immediately.  Use POOL for temporary allocations. */
+dav_error *dav_svn__mirror_wait_for_rev(request_rec *r,
+                                        dav_svn_repos *repos,
+                                        svn_revnum_t rev,
+                                        apr_pool_t *pool);
+
+/* If R is served by a mirror, announce the youngest revision that
+   has been replicated to REPOS in the response headers so that clients
+   may tell how far the mirror lags behind the master.  Use POOL for
+   temporary allocations. */
+void dav_svn__mirror_set_youngest_header(request_rec *r,
+                                         dav_svn_repos *repos,
+                                         apr_pool_t *pool);
+
+/* Scan the request body DOC of the REPORT request R for revision
+   numbers and wait for the youngest of them as per
+   dav_svn__mirror_wait_for_rev().  Use POOL for temporary allocations. */
+dav_error *dav_svn__mirror_wait_for_report(request_rec *r,
+                                           dav_svn_repos *repos,
+                                           const apr_xml_doc *doc,
+                                           apr_pool_t *pool);
+
 /* An Apache input filter which rewrites the locations in headers and
    request body.  It reads from filter F using BB data, MODE mode, BLOCK
    blocking strategy, and READBYTES. */
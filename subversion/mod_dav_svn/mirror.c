@@ -24,10 +24,14 @@
 #include <assert.h>
 
 #include <apr_strmatch.h>
+#include <apr_time.h>
 
 #include <httpd.h>
 #include <http_core.h>
 
+#include "svn_fs.h"
+#include "svn_xml.h"
+
 #include "private/svn_fspath.h"
 
 #include "dav_svn.h"
@@ -134,6 +138,126 @@ int dav_svn__proxy_request_fixup(request_rec *r)
     return OK;
 }
 
+/* How often we look for new revisions while waiting for svnsync. */
+#define MIRROR_POLL_INTERVAL apr_time_from_msec(100)
+
+dav_error *dav_svn__mirror_wait_for_rev(request_rec *r,
+                                        dav_svn_repos *repos,
+                                        svn_revnum_t rev,
+                                        apr_pool_t *pool)
+{
+    svn_error_t *serr;
+    svn_revnum_t youngest;
+    apr_interval_time_t timeout;
+    apr_time_t deadline;
+
+    if (!dav_svn__get_master_uri(r) || !SVN_IS_VALID_REVNUM(rev))
+        return NULL;
+
+    serr = dav_svn__get_youngest_rev(&youngest, repos, pool);
+    if (serr)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "Could not determine youngest revision",
+                                    pool);
+    if (rev <= youngest)
+        return NULL;
+
+    /* The revision is not here yet.  Assuming that it has been committed
+       to the master, svnsync should deliver it shortly.  Keep polling
+       until it arrives or we run out of patience. */
+    timeout = dav_svn__get_mirror_wait_timeout(r);
+    deadline = apr_time_now() + timeout;
+    while (timeout > 0 && apr_time_now() < deadline) {
+        apr_sleep(MIRROR_POLL_INTERVAL);
+
+        serr = svn_fs_youngest_rev(&youngest, repos->fs, pool);
+        if (serr)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "Could not determine youngest "
+                                        "revision", pool);
+
+        /* Keep the youngest revision up to date for the response
+           headers, whether we succeed or not. */
+        repos->youngest_rev = youngest;
+        if (rev <= youngest)
+            return NULL;
+    }
+
+    ap_log_rerror(APLOG_MARK, APLOG_INFO, 0, r,
+                  "Mirror has not received r%ld yet (youngest is r%ld)",
+                  rev, youngest);
+
+    /* Let the client retry (possibly against the master). */
+    apr_table_setn(r->err_headers_out, "Retry-After", "1");
+    return dav_svn__new_error(pool, HTTP_SERVICE_UNAVAILABLE,
+                              SVN_ERR_FS_NO_SUCH_REVISION, 0,
+                              apr_psprintf(pool, "Revision %ld has not been "
+                                           "replicated to this mirror yet",
+                                           rev));
+}
+
+void dav_svn__mirror_set_youngest_header(request_rec *r,
+                                         dav_svn_repos *repos,
+                                         apr_pool_t *pool)
+{
+    svn_error_t *serr;
+    svn_revnum_t youngest;
+
+    if (!dav_svn__get_master_uri(r))
+        return;
+
+    serr = dav_svn__get_youngest_rev(&youngest, repos, pool);
+    if (serr) {
+        /* The header is merely informational. */
+        svn_error_clear(serr);
+        return;
+    }
+
+    /* Use the error headers such that the value survives failed
+       requests as well. */
+    apr_table_set(r->err_headers_out, SVN_DAV_MIRROR_YOUNGEST_REV_HEADER,
+                  apr_ltoa(pool, youngest));
+}
+
+dav_error *dav_svn__mirror_wait_for_report(request_rec *r,
+                                           dav_svn_repos *repos,
+                                           const apr_xml_doc *doc,
+                                           apr_pool_t *pool)
+{
+    static const char *const rev_elements[] = {
+        "revision", "target-revision", "start-revision", "end-revision",
+        "peg-revision", "location-revision", NULL
+    };
+    apr_xml_elem *child;
+    svn_revnum_t max_rev = SVN_INVALID_REVNUM;
+    int ns;
+
+    if (!dav_svn__get_master_uri(r))
+        return NULL;
+
+    ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+    for (child = doc->root->first_child; child != NULL; child = child->next) {
+        const char *const *name;
+        svn_revnum_t rev;
+
+        if (child->ns != ns)
+            continue;
+
+        for (name = rev_elements; *name; ++name)
+            if (strcmp(child->name, *name) == 0)
+                break;
+        if (*name == NULL)
+            continue;
+
+        rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, pool, 1));
+        if (SVN_IS_VALID_REVNUM(rev)
+            && (!SVN_IS_VALID_REVNUM(max_rev) || rev > max_rev))
+            max_rev = rev;
+    }
+
+    return dav_svn__mirror_wait_for_rev(r, repos, max_rev, pool);
+}
+
 typedef struct locate_ctx_t
 {
     const apr_strmatch_pattern *pattern;
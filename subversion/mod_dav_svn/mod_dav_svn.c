@@ -42,8 +42,11 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #include "dav_svn.h"
 #include "mod_authz_svn.h"
@@ -67,6 +70,9 @@ typedef struct server_conf_t {
      compression level. */
   int compression_level;
 
+  /* Path of the file to write trace spans to.  NULL disables tracing. */
+  const char *trace_file;
+
 } server_conf_t;
 
 
@@ -101,12 +107,22 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  apr_interval_time_t mirror_wait_timeout; /* max. wait for replication */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
+  enum conf_flag cache_warmup;       /* whether to preload hot nodes */
+  enum conf_flag cache_warmup_on_commit; /* whether to preload new revs */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  int update_jobs;                   /* threads computing update deltas */
+  apr_size_t update_buffer_size;     /* memory budget of those threads */
+  apr_size_t report_buffer_size;     /* output coalescing for reports */
+  apr_interval_time_t report_flush_interval; /* max. delay of that output */
+  enum conf_flag response_cache;     /* whether to cache immutable responses */
+  const char *response_cache_dir;    /* directory of the on-disk tier */
+  apr_uint64_t response_cache_dir_size; /* size limit of the on-disk tier */
   const char *hooks_env;             /* path to hook script env config file */
 } dir_conf_t;
 
@@ -150,9 +166,46 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  if (conf->trace_file)
+    {
+      serr = svn_trace__init(conf->trace_file, p);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: could not enable tracing: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+    }
+
+  /* A shared cache must be created before httpd forks its children.
+   * It will then survive any child being recycled. */
+  if (svn_cache__config_get_shared()
+      && svn_cache__get_global_membuffer_cache() == NULL)
+    ap_log_perror(APLOG_MARK, APLOG_WARNING, 0, p,
+                  "mod_dav_svn: could not create the shared in-memory "
+                  "cache");
+
   return OK;
 }
 
+/* Implements the #child_init hook.  httpd children serve many requests,
+   so they may run asynchronous post-commit hooks in the background. */
+static void
+init_child(apr_pool_t *p, server_rec *s)
+{
+  svn_error_t *serr = svn_repos__hook_queue_start(p);
+
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_WARNING, serr->apr_err, s,
+                   "mod_dav_svn: could not start the post-commit hook "
+                   "queue: '%s'",
+                   serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -219,6 +272,7 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
   newconf = apr_pcalloc(p, sizeof(*newconf));
 
   newconf->special_uri = INHERIT_VALUE(parent, child, special_uri);
+  newconf->trace_file = INHERIT_VALUE(parent, child, trace_file);
 
   if (child->compression_level < 0)
     {
@@ -269,6 +323,8 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->mirror_wait_timeout = INHERIT_VALUE(parent, child,
+                                               mirror_wait_timeout);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -282,7 +338,22 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fulltext_cache = INHERIT_VALUE(parent, child, fulltext_cache);
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
+  newconf->cache_warmup = INHERIT_VALUE(parent, child, cache_warmup);
+  newconf->cache_warmup_on_commit = INHERIT_VALUE(parent, child,
+                                                  cache_warmup_on_commit);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
+  newconf->update_jobs = INHERIT_VALUE(parent, child, update_jobs);
+  newconf->update_buffer_size = INHERIT_VALUE(parent, child,
+                                              update_buffer_size);
+  newconf->report_buffer_size = INHERIT_VALUE(parent, child,
+                                              report_buffer_size);
+  newconf->report_flush_interval = INHERIT_VALUE(parent, child,
+                                                 report_flush_interval);
+  newconf->response_cache = INHERIT_VALUE(parent, child, response_cache);
+  newconf->response_cache_dir = INHERIT_VALUE(parent, child,
+                                              response_cache_dir);
+  newconf->response_cache_dir_size = INHERIT_VALUE(parent, child,
+                                                   response_cache_dir_size);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
 
@@ -357,6 +428,27 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMirrorWaitTimeout_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_int64_t value = 0;
+  svn_error_t *err = svn_cstring_strtoi64(&value, arg1, 0,
+                                          APR_INT64_MAX / 1000, 10);
+  if (err)
+    {
+      svn_error_clear(err);
+      return apr_psprintf(cmd->pool,
+                          "%s is not a valid mirror wait timeout.", arg1);
+    }
+
+  /* 0 disables waiting but would be indistinguishable from "not set". */
+  conf->mirror_wait_timeout = value ? (apr_interval_time_t)value * 1000 : -1;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -591,6 +683,32 @@ SVNCacheNodeProps_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNCacheWarmup_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->cache_warmup = CONF_FLAG_ON;
+  else
+    conf->cache_warmup = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNCacheWarmupOnCommit_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->cache_warmup_on_commit = CONF_FLAG_ON;
+  else
+    conf->cache_warmup_on_commit = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
 static const char *
 SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -604,6 +722,127 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNUpdateJobs_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN update jobs.";
+    }
+
+  if (value < 1)
+    return apr_psprintf(cmd->pool,
+                        "%d is not a valid number of update jobs.", value);
+
+  conf->update_jobs = value;
+
+  return NULL;
+}
+
+static const char *
+SVNUpdateBufferSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN update buffer size.";
+    }
+
+  if (value == 0 || value > APR_SIZE_MAX / 0x400)
+    return apr_psprintf(cmd->pool,
+                        "%s is not a valid update buffer size.", arg1);
+
+  conf->update_buffer_size = (apr_size_t)value * 0x400;
+
+  return NULL;
+}
+
+static const char *
+SVNReportBufferSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN report buffer size.";
+    }
+
+  if (value == 0 || value > APR_SIZE_MAX / 0x400)
+    return apr_psprintf(cmd->pool,
+                        "%s is not a valid report buffer size.", arg1);
+
+  conf->report_buffer_size = (apr_size_t)value * 0x400;
+
+  return NULL;
+}
+
+static const char *
+SVNReportFlushInterval_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_int64_t value = 0;
+  svn_error_t *err = svn_cstring_strtoi64(&value, arg1, 1,
+                                          APR_INT64_MAX / 1000, 10);
+  if (err)
+    {
+      svn_error_clear(err);
+      return apr_psprintf(cmd->pool,
+                          "%s is not a valid report flush interval.", arg1);
+    }
+
+  conf->report_flush_interval = (apr_interval_time_t)value * 1000;
+
+  return NULL;
+}
+
+static const char *
+SVNResponseCache_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->response_cache = CONF_FLAG_ON;
+  else
+    conf->response_cache = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNResponseCacheDir_cmd(cmd_parms *cmd, void *config,
+                        const char *arg1, const char *arg2)
+{
+  dir_conf_t *conf = config;
+  apr_uint64_t value = 1024;
+
+  if (arg2)
+    {
+      svn_error_t *err = svn_cstring_atoui64(&value, arg2);
+      if (err)
+        {
+          svn_error_clear(err);
+          return "Invalid decimal number for the SVN response cache size.";
+        }
+
+      if (value == 0)
+        return "The SVN response cache size must be at least 1 MB.";
+    }
+
+  conf->response_cache_dir = svn_dirent_internal_style(arg1, cmd->pool);
+  conf->response_cache_dir_size = value * 0x100000;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -624,6 +863,37 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheLockStripes_cmd(cmd_parms *cmd, void *config,
+                                const char *arg1)
+{
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN cache lock stripes.";
+    }
+
+  svn_cache__config_set_lock_stripes((apr_size_t)value);
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  if (apr_strnatcasecmp("off", arg1) == 0)
+    svn_cache__config_set_shared(FALSE, NULL);
+  else if (apr_strnatcasecmp("on", arg1) == 0)
+    svn_cache__config_set_shared(TRUE, NULL);
+  else
+    svn_cache__config_set_shared(TRUE, ap_server_root_relative(cmd->pool,
+                                                               arg1));
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -664,6 +934,18 @@ SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNTraceFile_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->trace_file = ap_server_root_relative(cmd->pool, arg1);
+
+  return NULL;
+}
+
 static const char *
 SVNHooksEnv_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -800,6 +1082,21 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+apr_interval_time_t
+dav_svn__get_mirror_wait_timeout(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  if (conf->mirror_wait_timeout < 0)
+    return 0;
+
+  /* 5 seconds by default. */
+  return conf->mirror_wait_timeout ? conf->mirror_wait_timeout
+                                   : apr_time_from_sec(5);
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -1031,6 +1328,28 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r)
   return get_conf_flag(conf->nodeprop_cache, TRUE);
 }
 
+svn_boolean_t
+dav_svn__get_cache_warmup_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* cache warm-up is disabled by default. */
+  return get_conf_flag(conf->cache_warmup, FALSE);
+}
+
+svn_boolean_t
+dav_svn__get_cache_warmup_on_commit_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* preloading new revisions is disabled by default. */
+  return get_conf_flag(conf->cache_warmup_on_commit, FALSE);
+}
+
 svn_boolean_t
 dav_svn__get_block_read_flag(request_rec *r)
 {
@@ -1042,6 +1361,74 @@ dav_svn__get_block_read_flag(request_rec *r)
   return get_conf_flag(conf->block_read, FALSE);
 }
 
+int
+dav_svn__get_update_jobs(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* concurrent delta computation is disabled by default. */
+  return conf->update_jobs ? conf->update_jobs : 1;
+}
+
+apr_size_t
+dav_svn__get_update_buffer_size(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* 16 MB by default. */
+  return conf->update_buffer_size ? conf->update_buffer_size : 0x1000000;
+}
+
+apr_size_t
+dav_svn__get_report_buffer_size(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* 64 kB by default. */
+  return conf->report_buffer_size ? conf->report_buffer_size : 0x10000;
+}
+
+apr_interval_time_t
+dav_svn__get_report_flush_interval(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* 1 second by default. */
+  return conf->report_flush_interval ? conf->report_flush_interval
+                                     : apr_time_from_sec(1);
+}
+
+svn_boolean_t
+dav_svn__get_response_cache_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* response caching is disabled by default. */
+  return get_conf_flag(conf->response_cache, FALSE);
+}
+
+const char *
+dav_svn__get_response_cache_dir(request_rec *r,
+                                apr_uint64_t *max_size)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  *max_size = conf->response_cache_dir_size;
+  return conf->response_cache_dir;
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1342,6 +1729,13 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMirrorWaitTimeout", SVNMirrorWaitTimeout_cmd, NULL,
+                ACCESS_CONF,
+                "specifies the time in milliseconds a mirror holds read "
+                "requests for revisions that have not been replicated from "
+                "the master yet (default is 5000, 0 disables waiting)"),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1390,6 +1784,21 @@ static const command_rec cmds[] =
                "if sufficient in-memory cache is available"
                "(default is On)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNCacheWarmup", SVNCacheWarmup_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "records the most frequently read nodes of FSFS repositories "
+               "and preloads them into the in-memory cache (see "
+               "SVNInMemoryCacheSize) in the background when a process "
+               "opens the repository (default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNCacheWarmupOnCommit", SVNCacheWarmupOnCommit_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "preloads the top-level directories of each new revision of "
+               "FSFS repositories into the in-memory cache in the "
+               "background (default is Off)."),
+
   /* per directory/location */
   AP_INIT_FLAG("SVNBlockRead", SVNBlockRead_cmd, NULL,
                ACCESS_CONF|RSRC_CONF,
@@ -1397,6 +1806,47 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNUpdateJobs", SVNUpdateJobs_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the number of threads computing file deltas for "
+                "a single update or checkout request (default is 1)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNUpdateBufferSize", SVNUpdateBufferSize_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the maximum size in kB of the data that the "
+                "SVNUpdateJobs threads may buffer for a single update or "
+                "checkout request (default is 16384)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNReportBufferSize", SVNReportBufferSize_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the size in kB of the buffer that collects the "
+                "output of log and mergeinfo reports before it gets sent "
+                "(default is 64)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNReportFlushInterval", SVNReportFlushInterval_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the time in milliseconds after which buffered "
+                "report output gets sent even if the buffer is not full "
+                "(default is 1000)."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNResponseCache", SVNResponseCache_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "caches the svndiff responses to GET requests for "
+               "revision-pinned files in Subversion's in-memory object "
+               "cache (default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE12("SVNResponseCacheDir", SVNResponseCacheDir_cmd, NULL,
+                 ACCESS_CONF|RSRC_CONF,
+                 "specifies a directory in which cached responses will also "
+                 "be kept across restarts, optionally followed by the "
+                 "maximum size in MB per repository (default is 1024)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1404,6 +1854,21 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheLockStripes",
+                SVNInMemoryCacheLockStripes_cmd, NULL,
+                RSRC_CONF,
+                "specifies the number of read locks per segment of "
+                "Subversion's in-memory object cache.  Higher values reduce "
+                "lock contention under threaded MPMs (default value is 1)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+                RSRC_CONF,
+                "specifies whether all httpd processes share one in-memory "
+                "object cache such that recycled children start with a warm "
+                "cache (On, Off or the name of a shared memory file; "
+                "default is Off).  SVNInMemoryCacheSize then specifies the "
+                "size of the shared cache."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
@@ -1416,6 +1881,12 @@ static const command_rec cmds[] =
                RSRC_CONF,
                "use UTF-8 as native character encoding (default is ASCII)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNTraceFile", SVNTraceFile_cmd, NULL,
+                RSRC_CONF,
+                "specifies a file to append timing spans of all requests to "
+                "in Trace Event JSON format (default is no tracing)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNHooksEnv", SVNHooksEnv_cmd, NULL,
                 ACCESS_CONF|RSRC_CONF,
@@ -1444,6 +1915,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(init_child, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
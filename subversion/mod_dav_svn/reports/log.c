@@ -329,8 +329,8 @@ log_revision_receiver(void *baton,
      log-item 4, 16, 64 and 256 to produce a few results fast.
 
      This introduces 4 full flushes of our brigade and the installed output
-     filters at growing intervals and then falls back to the standard
-     buffering of 8000 bytes + whatever buffers are added in output filters. */
+     filters at growing intervals and then falls back to the buffering
+     configured by SVNReportBufferSize and SVNReportFlushInterval. */
   lrb->result_count++;
   if (lrb->result_count == lrb->next_forced_flush)
     {
@@ -491,6 +491,10 @@ dav_svn__log_report(const dav_resource *resource,
   lrb.bb = apr_brigade_create(resource->pool,  /* not the subpool! */
                               dav_svn__output_get_bucket_alloc(output));
   lrb.output = output;
+  dav_svn__output_set_coalescing(
+      output,
+      dav_svn__get_report_buffer_size(resource->info->r),
+      dav_svn__get_report_flush_interval(resource->info->r));
   lrb.needs_header = TRUE;
   lrb.needs_log_item = TRUE;
   lrb.stack_depth = 0;
@@ -205,6 +205,11 @@ dav_svn__get_mergeinfo_report(const dav_resource *resource,
   bb = apr_brigade_create(resource->pool,
                           dav_svn__output_get_bucket_alloc(output));
 
+  dav_svn__output_set_coalescing(
+      output,
+      dav_svn__get_report_buffer_size(resource->info->r),
+      dav_svn__get_report_flush_interval(resource->info->r));
+
   receiver_baton.brigade = bb;
   receiver_baton.output = output;
   receiver_baton.fs_path = resource->info->repos_path;
@@ -0,0 +1,210 @@
+/*
+ * stat-many.c: mod_dav_svn REPORT handler for stat'ing multiple paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_xml.h>
+
+#include <http_request.h>
+#include <http_log.h>
+#include <mod_dav.h>
+
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "svn_xml.h"
+#include "svn_path.h"
+#include "svn_time.h"
+#include "svn_dav.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_dav_protocol.h"
+#include "private/svn_log.h"
+
+#include "../dav_svn.h"
+
+dav_error *
+dav_svn__stat_many_report(const dav_resource *resource,
+                          const apr_xml_doc *doc,
+                          dav_svn__output *output)
+{
+  svn_error_t *serr;
+  dav_error *derr = NULL;
+  apr_xml_elem *child;
+  int ns;
+  apr_bucket_brigade *bb;
+  apr_array_header_t *paths, *full_paths;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = SVN_INVALID_REVNUM;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Sanity check. */
+  if (!resource->info->repos_path)
+    return dav_svn__new_error(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                              "The request does not specify a repository path");
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1)
+    {
+      return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                    "The request does not contain the 'svn:' "
+                                    "namespace, so it is not going to have "
+                                    "certain required elements");
+    }
+
+  iterpool = svn_pool_create(resource->pool);
+  paths = apr_array_make(resource->pool, 4, sizeof(const char *));
+  full_paths = apr_array_make(resource->pool, 4, sizeof(const char *));
+
+  for (child = doc->root->first_child;
+       child != NULL;
+       child = child->next)
+    {
+      /* if this element isn't one of ours, then skip it */
+      if (child->ns != ns)
+        continue;
+
+      if (strcmp(child->name, SVN_DAV__REVISION) == 0)
+        {
+          rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, iterpool, 1));
+        }
+      else if (strcmp(child->name, SVN_DAV__PATH) == 0)
+        {
+          const char *path = dav_xml_get_cdata(child, resource->pool, 0);
+          if ((derr = dav_svn__test_canonical(path, iterpool)))
+            return derr;
+          APR_ARRAY_PUSH(paths, const char *) = path;
+          APR_ARRAY_PUSH(full_paths, const char *)
+            = svn_fspath__join(resource->info->repos_path, path,
+                               resource->pool);
+        }
+      /* else unknown element; skip it */
+    }
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    {
+      serr = svn_fs_youngest_rev(&rev, resource->info->repos->fs,
+                                 resource->pool);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "Could not determine youngest revision",
+                                    resource->pool);
+    }
+
+  /* Refuse the whole request if any of the paths is not readable. */
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      if (! dav_svn__allow_read(resource->info->r, resource->info->repos,
+                                APR_ARRAY_IDX(full_paths, i, const char *),
+                                rev, iterpool))
+        return dav_svn__new_error(resource->pool, HTTP_FORBIDDEN, 0, 0,
+                                  "Access to one of the requested paths "
+                                  "is forbidden");
+    }
+
+  serr = svn_fs_revision_root(&root, resource->info->repos->fs,
+                              rev, resource->pool);
+  if (serr != NULL)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "couldn't retrieve revision root",
+                                resource->pool);
+
+  bb = apr_brigade_create(resource->pool,
+                          dav_svn__output_get_bucket_alloc(output));
+
+  serr = dav_svn__brigade_puts(bb, output,
+                               DAV_XML_HEADER DEBUG_CR
+                               "<S:" SVN_DAV__STAT_MANY_REPORT " "
+                               "xmlns:S=\"" SVN_XML_NAMESPACE "\" "
+                               "xmlns:D=\"DAV:\">" DEBUG_CR);
+  if (serr)
+    {
+      derr = dav_svn__convert_err(serr, HTTP_BAD_REQUEST, NULL,
+                                  resource->pool);
+      goto cleanup;
+    }
+
+  /* Send one entry per existing path.  Missing paths are simply left
+     out, just like a stat of them would return no dirent. */
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      serr = svn_repos_stat(&dirent, root,
+                            APR_ARRAY_IDX(full_paths, i, const char *),
+                            iterpool);
+      if (!serr && dirent)
+        serr = dav_svn__brigade_printf(
+                 bb, output,
+                 "<S:" SVN_DAV__STAT_ENTRY
+                 " path=\"%s\" kind=\"%s\" size=\"%" SVN_FILESIZE_T_FMT "\""
+                 " has-props=\"%s\" created-rev=\"%ld\"%s%s%s%s%s%s/>"
+                 DEBUG_CR,
+                 apr_xml_quote_string(iterpool,
+                                      APR_ARRAY_IDX(paths, i, const char *),
+                                      1),
+                 svn_node_kind_to_word(dirent->kind),
+                 dirent->size,
+                 dirent->has_props ? "true" : "false",
+                 dirent->created_rev,
+                 dirent->time ? " date=\"" : "",
+                 dirent->time ? svn_time_to_cstring(dirent->time, iterpool)
+                              : "",
+                 dirent->time ? "\"" : "",
+                 dirent->last_author ? " author=\"" : "",
+                 dirent->last_author
+                   ? apr_xml_quote_string(iterpool, dirent->last_author, 1)
+                   : "",
+                 dirent->last_author ? "\"" : "");
+
+      if (serr)
+        {
+          derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                      "Error writing REPORT response.",
+                                      resource->pool);
+          goto cleanup;
+        }
+    }
+
+  if ((serr = dav_svn__brigade_puts(bb, output,
+                                    "</S:" SVN_DAV__STAT_MANY_REPORT ">"
+                                    DEBUG_CR)))
+    {
+      derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "Error ending REPORT response.",
+                                  resource->pool);
+      goto cleanup;
+    }
+
+ cleanup:
+
+  /* Log this 'high level' svn action. */
+  dav_svn__operational_log(resource->info,
+                           svn_log__stat_many(full_paths, rev,
+                                              resource->pool));
+  svn_pool_destroy(iterpool);
+  return dav_svn__final_flush_or_error(resource->info->r, bb, output,
+                                       derr, resource->pool);
+}
@@ -24,6 +24,7 @@
 #include <apr_pools.h>
 #include <apr_strings.h>
 #include <apr_xml.h>
+#include <apr_buckets.h>
 
 #include <http_request.h>
 #include <http_log.h>
@@ -34,6 +35,7 @@
 #include "svn_repos.h"
 #include "svn_fs.h"
 #include "svn_base64.h"
+#include "svn_delta.h"
 #include "svn_xml.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
@@ -42,10 +44,15 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_task.h"
 
 #include "../dav_svn.h"
 
 
+struct encoder_t;
+
+
 /* State baton for the overall update process. */
 typedef struct update_ctx_t {
   const dav_resource *resource;
@@ -96,6 +103,10 @@ typedef struct update_ctx_t {
      resource" and are we advertising support for as much? */
   svn_boolean_t enable_v2_response;
 
+  /* If not NULL, text deltas will be svndiff- and base64-encoded
+     concurrently.  Only used in "send-all" mode. */
+  struct encoder_t *encoder;
+
 } update_ctx_t;
 
 
@@ -763,9 +774,368 @@ struct window_handler_baton
   /* The _real_ window handler and baton. */
   svn_txdelta_window_handler_t handler;
   void *handler_baton;
+
+  /* If not NULL, the windows are being collected for the encoder of UC
+     instead of being passed to HANDLER. */
+  struct encode_job_t *job;
+
+  /* Pool to create HANDLER in, should the windows get too large. */
+  apr_pool_t *pool;
 };
 
 
+/* Set WB's real window handler up to write base64-encoded svndiff data
+   to the output of WB's update context.  Allocate it in POOL. */
+static void
+make_svndiff_handler(struct window_handler_baton *wb,
+                     apr_pool_t *pool)
+{
+  svn_stream_t *base64_stream
+    = dav_svn__make_base64_output_stream(wb->uc->bb, wb->uc->output, pool);
+
+  svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
+                          base64_stream, wb->uc->svndiff_version,
+                          wb->uc->compression_level, pool);
+}
+
+
+/* Concurrent encoding of text deltas in "send-all" mode.
+
+   Instead of encoding the windows as they arrive, we collect the windows
+   of a file and hand them over to a task once the delta is complete.  At
+   the same time, a bucket of our own type is appended to the output
+   brigade.  Reading it waits for the task and then turns it into a heap
+   bucket with the encoded data.  Therefore, the XML skeleton keeps being
+   written in order while the tasks catch up.
+
+   Everything not yet read from the output is charged against the buffer
+   limit of the encoder.  When it gets exceeded, we pass the output
+   brigade down the filter chain, which waits for all outstanding
+   tasks.  Deltas that exceed their share of the limit on their own are
+   encoded on the fly as usual. */
+
+/* State of the concurrent text delta encoding of a report.  Only used by
+   the thread serving the request. */
+typedef struct encoder_t
+{
+  /* Runs encode_task() for the jobs. */
+  svn_task__set_t *set;
+
+  /* Number of bytes currently charged by the jobs. */
+  apr_size_t buffered;
+
+  /* Maximum value for BUFFERED before we pass the output on. */
+  apr_size_t buffer_limit;
+
+  /* Collect at most this many bytes of delta windows for a single job. */
+  apr_size_t job_limit;
+
+  /* Encoding parameters, copied from the update context. */
+  int svndiff_version;
+  int compression_level;
+} encoder_t;
+
+/* The svndiff of a single file being encoded by a task. */
+typedef struct encode_job_t
+{
+  /* Private pool of this job.  It is a root pool because the task
+     allocates in it as well.  All members below are allocated in it. */
+  apr_pool_t *pool;
+
+  /* The delta windows (svn_txdelta_window_t *) to encode. */
+  apr_array_header_t *windows;
+
+  /* Number of bytes charged against the buffer limit of ENCODER. */
+  apr_size_t size;
+
+  /* The base64-encoded svndiff data. */
+  svn_stringbuf_t *result;
+
+  /* Set once the result of the task has been delivered.  FAILED is set
+     if RESULT could not be produced. */
+  svn_boolean_t done;
+  svn_boolean_t failed;
+
+  encoder_t *encoder;
+} encode_job_t;
+
+/* Implements svn_task__process_func_t.  Encode the windows of the
+   encode_job_t in PROCESS_BATON and return the job in *RESULT. */
+static svn_error_t *
+encode_task(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  encode_job_t *job = process_baton;
+  encoder_t *encoder = job->encoder;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  stream = svn_base64_encode2(svn_stream_from_stringbuf(job->result,
+                                                        job->pool),
+                              FALSE, job->pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                          encoder->svndiff_version,
+                          encoder->compression_level, job->pool);
+
+  for (i = 0; i < job->windows->nelts && !err; ++i)
+    err = handler(APR_ARRAY_IDX(job->windows, i, svn_txdelta_window_t *),
+                  handler_baton);
+  if (!err)
+    err = handler(NULL, handler_baton);
+
+  /* Encoding in-memory data does not really fail.  If it does anyway,
+     reading the output bucket will report it. */
+  job->failed = (err != SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  *result = job;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Mark the encode_job_t in RESULT
+   as done. */
+static svn_error_t *
+deliver_encode_job(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  encode_job_t *job = result;
+
+  job->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the task processing JOB, unless BLOCK is APR_NONBLOCK_READ.
+   Release the buffer charged by JOB and set *FAILED if the task could not
+   encode the data.  Return APR_EAGAIN if the task has not been delivered
+   yet and we must not wait. */
+static apr_status_t
+finish_encode_job(svn_boolean_t *failed,
+                  encode_job_t *job,
+                  apr_read_type_e block)
+{
+  encoder_t *encoder = job->encoder;
+
+  if (!job->done)
+    {
+      svn_error_t *err;
+      apr_status_t status;
+
+      if (block != APR_BLOCK_READ)
+        return APR_EAGAIN;
+
+      err = svn_task__set_finish(encoder->set);
+      if (err)
+        {
+          status = err->apr_err;
+          svn_error_clear(err);
+          return status;
+        }
+    }
+
+  encoder->buffered -= job->size;
+  job->size = 0;
+  *failed = job->failed;
+
+  return APR_SUCCESS;
+}
+
+/* Implements apr_bucket_type_t.destroy for encoded_bucket_type. */
+static void
+encoded_bucket_destroy(void *data)
+{
+  encode_job_t *job = data;
+  svn_boolean_t failed;
+
+  /* The job pool must remain valid while the task is running. */
+  if (finish_encode_job(&failed, job, APR_BLOCK_READ) == APR_SUCCESS)
+    svn_pool_destroy(job->pool);
+}
+
+/* Implements apr_bucket_type_t.read for encoded_bucket_type.  Once the
+   task is done, turn B into a heap bucket with the encoded data. */
+static apr_status_t
+encoded_bucket_read(apr_bucket *b,
+                    const char **str,
+                    apr_size_t *len,
+                    apr_read_type_e block)
+{
+  encode_job_t *job = b->data;
+  svn_boolean_t failed;
+  apr_status_t status;
+
+  status = finish_encode_job(&failed, job, block);
+  if (status)
+    return status;
+  if (failed)
+    return APR_EGENERAL;
+
+  apr_bucket_heap_make(b, job->result->data, job->result->len, NULL);
+  svn_pool_destroy(job->pool);
+
+  return apr_bucket_read(b, str, len, block);
+}
+
+/* Implements apr_bucket_type_t.setaside for encoded_bucket_type. */
+static apr_status_t
+encoded_bucket_setaside(apr_bucket *b,
+                        apr_pool_t *pool)
+{
+  const char *str;
+  apr_size_t len;
+
+  /* Heap buckets don't need to be set aside. */
+  return encoded_bucket_read(b, &str, &len, APR_BLOCK_READ);
+}
+
+static const apr_bucket_type_t encoded_bucket_type = {
+  "SVN-TXDELTA", 5, APR_BUCKET_DATA,
+  encoded_bucket_destroy,
+  encoded_bucket_read,
+  encoded_bucket_setaside,
+  apr_bucket_split_notimpl,
+  apr_bucket_copy_notimpl
+};
+
+/* Start collecting the windows of a file's text delta for the encoder
+   of WB's update context. */
+static void
+start_encode_job(struct window_handler_baton *wb)
+{
+  encode_job_t *job;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->pool = pool;
+  job->windows = apr_array_make(pool, 1, sizeof(svn_txdelta_window_t *));
+  job->result = svn_stringbuf_create_empty(pool);
+  job->encoder = wb->uc->encoder;
+
+  /* Account for the output bucket that will follow the job's data. */
+  job->size = APR_BUCKET_BUFF_SIZE;
+
+  wb->job = job;
+}
+
+/* Pool cleanup function discarding the windows collected in the
+   struct window_handler_baton DATA, if they never made it to a task. */
+static apr_status_t
+discard_encode_job(void *data)
+{
+  struct window_handler_baton *wb = data;
+
+  if (wb->job)
+    {
+      svn_pool_destroy(wb->job->pool);
+      wb->job = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Hand the windows collected in WB over to a task and append the
+   respective bucket to the output. */
+static svn_error_t *
+queue_encode_job(struct window_handler_baton *wb)
+{
+  encode_job_t *job = wb->job;
+  encoder_t *encoder = job->encoder;
+  update_ctx_t *uc = wb->uc;
+  apr_bucket_alloc_t *list = dav_svn__output_get_bucket_alloc(uc->output);
+  apr_bucket *b;
+  svn_boolean_t flush;
+
+  encoder->buffered += job->size;
+  flush = encoder->buffered > encoder->buffer_limit;
+
+  /* From now on, the bucket owns the job. */
+  b = apr_bucket_alloc(sizeof(*b), list);
+  APR_BUCKET_INIT(b);
+  b->free = apr_bucket_free;
+  b->list = list;
+  b->type = &encoded_bucket_type;
+  b->length = (apr_size_t)(-1);
+  b->start = -1;
+  b->data = job;
+  wb->job = NULL;
+
+  APR_BRIGADE_INSERT_TAIL(uc->bb, b);
+  SVN_ERR(svn_task__add(encoder->set, encode_task, job));
+
+  /* Sending the output waits for and releases all pending jobs. */
+  if (flush)
+    SVN_ERR(dav_svn__output_pass_brigade(uc->output, uc->bb));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add WINDOW to the windows collected in WB.  If the data gets too
+   large, encode all of it on the fly instead. */
+static svn_error_t *
+collect_window(struct window_handler_baton *wb,
+               svn_txdelta_window_t *window)
+{
+  encode_job_t *job = wb->job;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (window == NULL)
+    return svn_error_trace(queue_encode_job(wb));
+
+  job->size += window->num_ops * sizeof(*window->ops);
+  if (window->new_data)
+    job->size += window->new_data->len;
+
+  APR_ARRAY_PUSH(job->windows, svn_txdelta_window_t *)
+    = svn_txdelta_window_dup(window, job->pool);
+
+  if (job->size <= job->encoder->job_limit)
+    return SVN_NO_ERROR;
+
+  /* Too large to buffer. */
+  make_svndiff_handler(wb, wb->pool);
+  for (i = 0; i < job->windows->nelts && !err; ++i)
+    err = wb->handler(APR_ARRAY_IDX(job->windows, i, svn_txdelta_window_t *),
+                      wb->handler_baton);
+
+  svn_pool_destroy(job->pool);
+  wb->job = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Set up UC->ENCODER to encode up to JOBS text deltas concurrently,
+   buffering at most BUFFER_LIMIT bytes.  Outstanding tasks will be
+   cancelled when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+start_encoder(update_ctx_t *uc,
+              int jobs,
+              apr_size_t buffer_limit,
+              apr_pool_t *result_pool)
+{
+  encoder_t *encoder = apr_pcalloc(result_pool, sizeof(*encoder));
+
+  encoder->buffer_limit = buffer_limit;
+  encoder->job_limit = buffer_limit / jobs;
+  encoder->svndiff_version = uc->svndiff_version;
+  encoder->compression_level = uc->compression_level;
+
+  SVN_ERR(svn_task__set_create(&encoder->set, jobs, deliver_encode_job,
+                               encoder, NULL, NULL, result_pool));
+  uc->encoder = encoder;
+
+  return SVN_NO_ERROR;
+}
+
+
 /* This implements 'svn_txdelta_window_handler_t'. */
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
@@ -785,7 +1155,10 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                                         wb->base_checksum));
     }
 
-  SVN_ERR(wb->handler(window, wb->handler_baton));
+  if (wb->job)
+    SVN_ERR(collect_window(wb, window));
+  else
+    SVN_ERR(wb->handler(window, wb->handler_baton));
 
   if (window == NULL)
     {
@@ -805,7 +1178,6 @@ upd_apply_textdelta(void *file_baton,
 {
   item_baton_t *file = file_baton;
   struct window_handler_baton *wb;
-  svn_stream_t *base64_stream;
 
   /* Store the base checksum and the fact the file's text changed. */
   file->base_checksum = apr_pstrdup(file->pool, base_checksum);
@@ -820,17 +1192,20 @@ upd_apply_textdelta(void *file_baton,
       return SVN_NO_ERROR;
     }
 
-  wb = apr_palloc(file->pool, sizeof(*wb));
+  wb = apr_pcalloc(file->pool, sizeof(*wb));
   wb->seen_first_window = FALSE;
   wb->uc = file->uc;
   wb->base_checksum = file->base_checksum;
-  base64_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
-                                                     wb->uc->output,
-                                                     file->pool);
 
-  svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
-                          base64_stream, file->uc->svndiff_version,
-                          file->uc->compression_level, file->pool);
+  if (wb->uc->encoder)
+    {
+      wb->pool = file->pool;
+      start_encode_job(wb);
+      apr_pool_cleanup_register(file->pool, wb, discard_encode_job,
+                                apr_pool_cleanup_null);
+    }
+  else
+    make_svndiff_handler(wb, file->pool);
 
   *handler = window_handler;
   *handler_baton = wb;
@@ -979,6 +1354,8 @@ dav_svn__update_report(const dav_resource *resource,
   svn_boolean_t resource_walk = FALSE;
   svn_boolean_t ignore_ancestry = FALSE;
   svn_boolean_t send_copyfrom_args = FALSE;
+  int update_jobs;
+  apr_size_t update_buffer_size;
   dav_svn__authz_read_baton arb;
   apr_pool_t *subpool = svn_pool_create(resource->pool);
 
@@ -1287,6 +1664,26 @@ dav_svn__update_report(const dav_resource *resource,
                                   "created.",
                                   resource->pool);
     }
+  update_jobs = dav_svn__get_update_jobs(resource->info->r);
+  update_buffer_size = dav_svn__get_update_buffer_size(resource->info->r);
+
+  /* Let the delta computation and the encoding share the buffer. */
+  if (update_jobs > 1 && uc.send_all)
+    {
+      update_buffer_size /= 2;
+      serr = start_encoder(&uc, update_jobs, update_buffer_size,
+                           resource->pool);
+
+      /* We can always encode the deltas ourselves. */
+      if (serr)
+        {
+          ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err,
+                        resource->info->r, "%s", serr->message);
+          svn_error_clear(serr);
+        }
+    }
+
+  svn_repos__report_set_delta_jobs(rbaton, update_jobs, update_buffer_size);
 
   /* scan the XML doc for state information */
   for (child = doc->root->first_child; child != NULL; child = child->next)
@@ -1568,6 +1965,11 @@ dav_svn__update_report(const dav_resource *resource,
   /* Destroy our subpool. */
   svn_pool_destroy(subpool);
 
-  return dav_svn__final_flush_or_error(resource->info->r, uc.bb, output,
+  derr = dav_svn__final_flush_or_error(resource->info->r, uc.bb, output,
                                        derr, resource->pool);
+
+  /* Release any unsent encoder jobs while their task set still exists. */
+  apr_brigade_cleanup(uc.bb);
+
+  return derr;
 }
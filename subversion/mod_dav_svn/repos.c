@@ -53,6 +53,8 @@
 #include "mod_dav_svn.h"
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
@@ -2038,6 +2040,7 @@ parse_querystring(request_rec *r, const char *query,
                   dav_resource_combined *comb, apr_pool_t *pool)
 {
   svn_error_t *serr;
+  dav_error *err;
   svn_revnum_t working_rev, peg_rev;
   apr_table_t *pairs = querystring_to_table(query, pool);
   const char *prevstr = apr_table_get(pairs, "p");
@@ -2057,6 +2060,12 @@ parse_querystring(request_rec *r, const char *query,
       if (!SVN_IS_VALID_REVNUM(peg_rev))
         return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
                                   "invalid peg rev in query string");
+
+      /* A lagging mirror must not trace history from a PEG_REV that
+         it does not have yet. */
+      if ((err = dav_svn__mirror_wait_for_rev(r, comb->priv.repos,
+                                              peg_rev, pool)))
+        return err;
     }
   else
     {
@@ -2411,6 +2420,10 @@ get_resource(request_rec *r,
                     dav_svn__get_revprop_cache_flag(r) ? "2" :"0");
       svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS,
                     dav_svn__get_nodeprop_cache_flag(r) ? "1" :"0");
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP,
+                    dav_svn__get_cache_warmup_flag(r) ? "1" :"0");
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT,
+                    dav_svn__get_cache_warmup_on_commit_flag(r) ? "1" :"0");
       svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
                     dav_svn__get_block_read_flag(r) ? "1" :"0");
 
@@ -2597,6 +2610,16 @@ get_resource(request_rec *r,
     }
 #endif
 
+  /* Mirrors may be asked for revisions that have been committed to the
+     master but have not been replicated yet.  Hold the request until
+     they arrive instead of failing it.  Announce the replication state
+     in either case. */
+  err = dav_svn__mirror_wait_for_rev(r, repos, comb->priv.root.rev,
+                                     r->pool);
+  dav_svn__mirror_set_youngest_header(r, repos, r->pool);
+  if (err)
+    return err;
+
   /* prepare the resource for operation */
   if ((err = prep_resource(comb)) != NULL)
     return err;
@@ -3170,8 +3193,10 @@ set_headers(request_rec *r, const dav_resource *resource)
 
   /* As version resources don't change, encourage caching. */
   if (is_cacheable(r, resource))
-    /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
+    /* Cache resource for one year (specified in seconds) and tell clients
+       that they don't need to revalidate it. */
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   "max-age=31536000, immutable");
   else
     apr_table_setn(r->headers_out, "Cache-Control", "max-age=0");
 
@@ -3298,6 +3323,11 @@ set_headers(request_rec *r, const dav_resource *resource)
 typedef struct diff_ctx_t {
   dav_svn__output *output;
   apr_bucket_brigade *bb;
+
+  /* If not NULL, a copy of everything written so far, to be put into
+     CACHE once the response is complete. */
+  svn_stringbuf_t *response;
+  svn_cache__t *cache;
 } diff_ctx_t;
 
 
@@ -3309,6 +3339,15 @@ write_to_filter(void *baton, const char *buffer, apr_size_t *len)
   /* take the current data and shove it into the filter */
   SVN_ERR(dav_svn__brigade_write(dc->bb, dc->output, buffer, *len));
 
+  /* keep a copy for the response cache for as long as it may fit */
+  if (dc->response)
+    {
+      if (svn_cache__is_cachable(dc->cache, dc->response->len + *len))
+        svn_stringbuf_appendbytes(dc->response, buffer, *len);
+      else
+        dc->response = NULL;
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -3328,6 +3367,105 @@ close_filter(void *baton)
 }
 
 
+/* Set *CACHE to the response cache for the repository of RESOURCE, or
+   to NULL if response caching has not been enabled for it.  Allocate
+   the cache in POOL. */
+static svn_error_t *
+open_response_cache(svn_cache__t **cache,
+                    const dav_resource *resource,
+                    apr_pool_t *pool)
+{
+  request_rec *r = resource->info->r;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_cache__persistent_t *store;
+  apr_uint64_t dir_size;
+  const char *dir;
+  const char *uuid;
+  const char *prefix;
+
+  *cache = NULL;
+  if (!membuffer || !dav_svn__get_response_cache_flag(r))
+    return SVN_NO_ERROR;
+
+  /* Responses are only valid for this repository.  The keys contain the
+     revision numbers. */
+  SVN_ERR(svn_fs_get_uuid(resource->info->repos->fs, &uuid, pool));
+  prefix = apr_pstrcat(pool, "mod_dav_svn:response:", uuid, ":",
+                       SVN_VA_NULL);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, prefix,
+                                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                                            svn_cache__admission_default,
+                                            FALSE, FALSE, pool, pool));
+
+  dir = dav_svn__get_response_cache_dir(r, &dir_size);
+  if (dir)
+    {
+      svn_revnum_t youngest;
+      svn_error_t *err;
+
+      /* Cached responses of a repository that has been rolled back to an
+         earlier youngest revision are invalid. */
+      err = svn_fs_youngest_rev(&youngest, resource->info->repos->fs, pool);
+      if (!err)
+        err = svn_cache__get_persistent_store(&store,
+                                              svn_dirent_join(dir, uuid,
+                                                              pool),
+                                              uuid, (apr_uint64_t)youngest,
+                                              dir_size, pool);
+
+      /* We can live without the on-disk tier. */
+      if (err)
+        {
+          ap_log_rerror(APLOG_MARK, APLOG_WARNING, err->apr_err, r,
+                        "could not open the response cache in '%s': %s",
+                        dir, err->message);
+          svn_error_clear(err);
+        }
+      else
+        {
+          SVN_ERR(svn_cache__create_persistent(cache, *cache, store,
+                                               NULL, NULL,
+                                               APR_HASH_KEY_STRING, prefix,
+                                               pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the response cache key for the svndiff of RESOURCE against the
+   delta BASE, allocated in POOL. */
+static const char *
+response_cache_key(const dav_resource *resource,
+                   const dav_svn__uri_info *base,
+                   apr_pool_t *pool)
+{
+  /* Paths cannot contain newlines but may contain anything else. */
+  return apr_psprintf(pool, "%ld %ld %d %d %s\n%s",
+                      resource->info->root.rev, base->rev,
+                      resource->info->svndiff_version,
+                      dav_svn__get_compression_level(resource->info->r),
+                      resource->info->repos_path, base->repos_path);
+}
+
+/* Write the complete cached RESPONSE to OUTPUT, using BB.  */
+static svn_error_t *
+send_cached_response(dav_svn__output *output,
+                     apr_bucket_brigade *bb,
+                     const svn_stringbuf_t *response)
+{
+  diff_ctx_t dc = { 0 };
+
+  dc.output = output;
+  dc.bb = bb;
+  SVN_ERR(dav_svn__brigade_write(bb, output, response->data, response->len));
+
+  return svn_error_trace(close_filter(&dc));
+}
+
+
 static svn_error_t *
 emit_collection_head(const dav_resource *resource,
                      apr_bucket_brigade *bb,
@@ -3773,6 +3911,8 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       svn_txdelta_window_handler_t handler;
       void * h_baton;
       diff_ctx_t dc = { 0 };
+      svn_cache__t *cache = NULL;
+      const char *cache_key = NULL;
 
       /* First order of business is to parse it. */
       serr = dav_svn__simple_parse_uri(&info, resource,
@@ -3806,6 +3946,45 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                       "to a file in revision %ld",
                                       info.repos_path, info.rev));
 
+          /* Deltas between revision-pinned files never change, so we
+             may have sent this very response before. */
+          if (resource->info->idempotent)
+            {
+              svn_stringbuf_t *response = NULL;
+              svn_boolean_t found = FALSE;
+
+              cache_key = response_cache_key(resource, &info,
+                                             resource->pool);
+              serr = open_response_cache(&cache, resource, resource->pool);
+              if (serr == NULL && cache != NULL)
+                serr = svn_cache__get((void **)&response, &found, cache,
+                                      cache_key, resource->pool);
+
+              /* Failing caches must not fail the request. */
+              if (serr != NULL)
+                {
+                  ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err,
+                                resource->info->r, "%s", serr->message);
+                  svn_error_clear(serr);
+                  cache = NULL;
+                }
+              else if (found)
+                {
+                  bb = apr_brigade_create(resource->pool,
+                                  dav_svn__output_get_bucket_alloc(output));
+                  serr = send_cached_response(output, bb, response);
+                  apr_brigade_destroy(bb);
+                  if (serr != NULL)
+                    return dav_svn__convert_err(serr,
+                                                HTTP_INTERNAL_SERVER_ERROR,
+                                                "could not deliver the "
+                                                "cached txdelta stream",
+                                                resource->pool);
+
+                  return NULL;
+                }
+            }
+
           /* Okay. Let's open up a delta stream for the client to read. */
           serr = svn_fs_get_file_delta_stream(&txd_stream,
                                               root, info.repos_path,
@@ -3824,6 +4003,11 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
              which will copy it to the network */
           dc.output = output;
           dc.bb = bb;
+          if (cache)
+            {
+              dc.response = svn_stringbuf_create_empty(resource->pool);
+              dc.cache = cache;
+            }
           o_stream = svn_stream_create(&dc, resource->pool);
           svn_stream_set_write(o_stream, write_to_filter);
           svn_stream_set_close(o_stream, close_filter);
@@ -3846,6 +4030,18 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                         "could not deliver the txdelta stream",
                                         resource->pool);
 
+          /* The response has been sent completely, remember it. */
+          if (dc.response)
+            {
+              serr = svn_cache__set(cache, cache_key, dc.response,
+                                    resource->pool);
+              if (serr != NULL)
+                {
+                  ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err,
+                                resource->info->r, "%s", serr->message);
+                  svn_error_clear(serr);
+                }
+            }
 
           return NULL;
         }
@@ -3860,6 +4056,65 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       svn_stream_t *stream;
       char *block;
 
+      /* Contents stored verbatim on disk can be handed to the network
+         layer as file buckets, allowing for sendfile().  Keywords
+         expansion needs to see the data, though. */
+      if (! resource->info->keyword_subst)
+        {
+          const char *file_path;
+          apr_array_header_t *ranges;
+          apr_file_t *file = NULL;
+
+          serr = svn_fs__file_contents_ranges(&file_path, &ranges,
+                                              resource->info->root.root,
+                                              resource->info->repos_path,
+                                              resource->pool,
+                                              resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not locate the file contents",
+                                        resource->pool);
+
+          /* The file may have been removed by a concurrent 'svnadmin pack'.
+             Simply fall back to the stream-based code below, then. */
+          if (file_path
+              && apr_file_open(&file, file_path,
+                               APR_READ | APR_BINARY | APR_SENDFILE_ENABLED,
+                               APR_OS_DEFAULT, resource->pool)
+                   == APR_SUCCESS)
+            {
+              int i;
+
+              bb = apr_brigade_create(resource->pool,
+                                      dav_svn__output_get_bucket_alloc(output));
+              for (i = 0; i < ranges->nelts; ++i)
+                {
+                  const svn_fs__file_range_t *range
+                    = &APR_ARRAY_IDX(ranges, i, svn_fs__file_range_t);
+                  apr_brigade_insert_file(bb, file, range->offset,
+                                          range->length, resource->pool);
+                }
+
+              bkt = apr_bucket_eos_create(
+                      dav_svn__output_get_bucket_alloc(output));
+              APR_BRIGADE_INSERT_TAIL(bb, bkt);
+              serr = dav_svn__output_pass_brigade(output, bb);
+              if (serr != NULL)
+                {
+                  apr_brigade_destroy(bb);
+                  /* ### that HTTP code... */
+                  return dav_svn__convert_err(serr,
+                                              HTTP_INTERNAL_SERVER_ERROR,
+                                              "Could not write data to "
+                                              "filter.",
+                                              resource->pool);
+                }
+
+              apr_brigade_destroy(bb);
+              return NULL;
+            }
+        }
+
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
                                   resource->info->repos_path,
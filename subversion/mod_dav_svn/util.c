@@ -28,6 +28,7 @@
 #include <apr_errno.h>
 #include <apr_uri.h>
 #include <apr_buckets.h>
+#include <apr_lib.h>
 
 #include <mod_dav.h>
 #include <http_protocol.h>
@@ -472,6 +473,16 @@ dav_svn__find_ns(const apr_array_header_t *namespaces, const char *uri)
 struct dav_svn__output
 {
   request_rec *r;
+
+  /* Size of the buffers collecting the output of the dav_svn__brigade
+     functions.  0 if they shall write to the brigade directly. */
+  apr_size_t buffer_size;
+
+  /* If not 0, pass the brigade at least this often while collecting. */
+  apr_interval_time_t flush_interval;
+
+  /* When we last passed a brigade down the filter stack. */
+  apr_time_t last_pass;
 };
 
 dav_svn__output *
@@ -498,6 +509,8 @@ dav_svn__output_pass_brigade(dav_svn__output *output,
   status = ap_pass_brigade(output->r->output_filters, bb);
   /* Empty the brigade here, as required by ap_pass_brigade(). */
   apr_brigade_cleanup(bb);
+  if (output->flush_interval)
+    output->last_pass = apr_time_now();
   if (status)
     return svn_error_create(status, NULL, "Could not write data to filter");
 
@@ -509,8 +522,123 @@ dav_svn__output_pass_brigade(dav_svn__output *output,
 }
 
 
+void
+dav_svn__output_set_coalescing(dav_svn__output *output,
+                               apr_size_t buffer_size,
+                               apr_interval_time_t flush_interval)
+{
+  output->buffer_size = buffer_size;
+  output->flush_interval = flush_interval;
+  output->last_pass = apr_time_now();
+}
+
+
 /*** Brigade I/O wrappers ***/
 
+/* Append LEN bytes at DATA to BB, collecting them in heap buckets of
+   OUTPUT's buffer size.  Pass BB down to OUTPUT whenever such a bucket
+   is full or OUTPUT's flush interval has passed.  This is similar to
+   apr_brigade_write() but uses much larger buffers. */
+static svn_error_t *
+coalesce_write(apr_bucket_brigade *bb,
+               dav_svn__output *output,
+               const char *data,
+               apr_size_t len)
+{
+  apr_bucket *e = APR_BRIGADE_LAST(bb);
+  apr_size_t remaining = 0;
+  char *buf = NULL;
+
+  /* Append to the last bucket if we own its buffer exclusively. */
+  if (!APR_BRIGADE_EMPTY(bb) && APR_BUCKET_IS_HEAP(e))
+    {
+      apr_bucket_heap *h = e->data;
+      if (h->refcount.refcount == 1)
+        {
+          remaining = h->alloc_len - (e->length + (apr_size_t)e->start);
+          buf = h->base + e->start + e->length;
+        }
+    }
+
+  if (len > remaining)
+    {
+      if (!APR_BRIGADE_EMPTY(bb))
+        SVN_ERR(dav_svn__output_pass_brigade(output, bb));
+
+      /* Don't copy data that would fill a whole buffer anyway. */
+      if (len >= output->buffer_size)
+        {
+          e = apr_bucket_transient_create(data, len, bb->bucket_alloc);
+          APR_BRIGADE_INSERT_TAIL(bb, e);
+          return svn_error_trace(dav_svn__output_pass_brigade(output, bb));
+        }
+
+      buf = apr_bucket_alloc(output->buffer_size, bb->bucket_alloc);
+      e = apr_bucket_heap_create(buf, output->buffer_size, apr_bucket_free,
+                                 bb->bucket_alloc);
+      APR_BRIGADE_INSERT_TAIL(bb, e);
+      e->length = 0;   /* The bucket is empty, yet. */
+    }
+
+  memcpy(buf, data, len);
+  e->length += len;
+
+  /* Don't keep the client waiting for too long. */
+  if (output->flush_interval
+      && apr_time_now() - output->last_pass >= output->flush_interval)
+    SVN_ERR(dav_svn__output_pass_brigade(output, bb));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for coalesce_flush(). */
+typedef struct coalesce_baton_t
+{
+  /* Must be the first member. */
+  apr_vformatter_buff_t vbuff;
+
+  apr_bucket_brigade *bb;
+  dav_svn__output *output;
+  svn_error_t *err;
+  char buf[APR_BUCKET_BUFF_SIZE];
+} coalesce_baton_t;
+
+/* Implements the flush callback of apr_vformatter() for
+   coalesce_vprintf(). */
+static int
+coalesce_flush(apr_vformatter_buff_t *vbuff)
+{
+  coalesce_baton_t *baton = (coalesce_baton_t *)vbuff;
+
+  if (!baton->err)
+    baton->err = coalesce_write(baton->bb, baton->output, baton->buf,
+                                vbuff->curpos - baton->buf);
+  vbuff->curpos = baton->buf;
+
+  return baton->err ? -1 : 0;
+}
+
+/* Like apr_brigade_vprintf() but using coalesce_write(). */
+static svn_error_t *
+coalesce_vprintf(apr_bucket_brigade *bb,
+                 dav_svn__output *output,
+                 const char *fmt,
+                 va_list ap)
+{
+  coalesce_baton_t baton;
+
+  baton.vbuff.curpos = baton.buf;
+  baton.vbuff.endpos = baton.buf + sizeof(baton.buf);
+  baton.bb = bb;
+  baton.output = output;
+  baton.err = SVN_NO_ERROR;
+
+  if (apr_vformatter(coalesce_flush, &baton.vbuff, fmt, ap) != -1)
+    coalesce_flush(&baton.vbuff);
+
+  return svn_error_trace(baton.err);
+}
+
 
 svn_error_t *
 dav_svn__brigade_write(apr_bucket_brigade *bb,
@@ -519,6 +647,10 @@ dav_svn__brigade_write(apr_bucket_brigade *bb,
                        apr_size_t len)
 {
   apr_status_t apr_err;
+
+  if (output->buffer_size)
+    return svn_error_trace(coalesce_write(bb, output, data, len));
+
   apr_err = apr_brigade_write(bb, ap_filter_flush,
                               output->r->output_filters, data, len);
   if (apr_err)
@@ -537,6 +669,10 @@ dav_svn__brigade_puts(apr_bucket_brigade *bb,
                       const char *str)
 {
   apr_status_t apr_err;
+
+  if (output->buffer_size)
+    return svn_error_trace(coalesce_write(bb, output, str, strlen(str)));
+
   apr_err = apr_brigade_puts(bb, ap_filter_flush,
                              output->r->output_filters, str);
   if (apr_err)
@@ -559,6 +695,12 @@ dav_svn__brigade_printf(apr_bucket_brigade *bb,
   va_list ap;
 
   va_start(ap, fmt);
+  if (output->buffer_size)
+    {
+      svn_error_t *err = coalesce_vprintf(bb, output, fmt, ap);
+      va_end(ap);
+      return svn_error_trace(err);
+    }
   apr_err = apr_brigade_vprintf(bb, ap_filter_flush,
                                 output->r->output_filters, fmt, ap);
   va_end(ap);
@@ -581,6 +723,16 @@ dav_svn__brigade_putstrs(apr_bucket_brigade *bb,
   va_list ap;
 
   va_start(ap, output);
+  if (output->buffer_size)
+    {
+      const char *str;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      while (!err && (str = va_arg(ap, const char *)) != NULL)
+        err = coalesce_write(bb, output, str, strlen(str));
+      va_end(ap);
+      return svn_error_trace(err);
+    }
   apr_err = apr_brigade_vputstrs(bb, ap_filter_flush,
                                  output->r->output_filters, ap);
   va_end(ap);
@@ -155,6 +155,7 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF1);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF2);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_STAT_MANY);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -1105,6 +1106,13 @@ deliver_report(request_rec *r,
   if (doc->root->ns == ns)
     {
       dav_svn__output *output;
+      dav_error *derr;
+
+      /* Don't let a lagging mirror answer for revisions it lacks. */
+      derr = dav_svn__mirror_wait_for_report(r, resource->info->repos,
+                                             doc, resource->pool);
+      if (derr)
+        return derr;
 
       output = dav_svn__output_create(resource->info->r, resource->pool);
 
@@ -1154,6 +1162,10 @@ deliver_report(request_rec *r,
         {
           return dav_svn__get_inherited_props_report(resource, doc, output);
         }
+      else if (strcmp(doc->root->name, SVN_DAV__STAT_MANY_REPORT) == 0)
+        {
+          return dav_svn__stat_many_report(resource, doc, output);
+        }
       /* NOTE: if you add a report, don't forget to add it to the
        *       dav_svn__reports_list[] array.
        */
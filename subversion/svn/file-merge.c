@@ -954,8 +954,8 @@ svn_cl__merge_file(svn_boolean_t *remains_in_conflict,
     merged_path_local_style = svn_dirent_local_style(merged_path,
                                                      scratch_pool);
 
-  SVN_ERR_W(svn_io_copy_file(merged_file_name, merged_path, FALSE,
-                             scratch_pool),
+  SVN_ERR_W(svn_io_copy_file2(merged_file_name, merged_path, 0, NULL,
+                              scratch_pool),
             apr_psprintf(scratch_pool,
                          _("Could not write merged result to '%s', saved "
                            "instead at '%s'.\n'%s' remains in conflict.\n"),
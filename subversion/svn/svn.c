@@ -56,6 +56,7 @@
 #include "private/svn_opt_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 #include "private/svn_utf_private.h"
 
 #include "svn_private_config.h"
@@ -145,6 +146,7 @@ typedef enum svn_cl__longopt_t {
   opt_show_item,
   opt_adds_as_modification,
   opt_vacuum_pristines,
+  opt_trace_file,
 } svn_cl__longopt_t;
 
 
@@ -219,7 +221,11 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "  -U ARG, --context ARG: Show ARG lines of context\n"
                        "                             "
-                       "  -p, --show-c-function: Show C function name")},
+                       "  -p, --show-c-function: Show C function name\n"
+                       "                             "
+                       "  --histogram: Use the faster, non-minimal\n"
+                       "                             "
+                       "    histogram diff algorithm")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -291,6 +297,10 @@ const apr_getopt_option_t svn_cl__options[] =
                        "For example:\n"
                        "                             "
                        "    servers:global:http-library=serf")},
+  {"trace-file",    opt_trace_file, 1,
+                    N_("append timing spans of the operation to file ARG\n"
+                       "                             "
+                       "in Trace Event JSON format")},
   {"auto-props",    opt_autoprops, 0, N_("enable automatic properties")},
   {"no-auto-props", opt_no_autoprops, 0, N_("disable automatic properties")},
   {"native-eol",    opt_native_eol, 1,
@@ -498,7 +508,7 @@ const int svn_cl__global_options[] =
 { opt_auth_username, opt_auth_password, opt_no_auth_cache, opt_non_interactive,
   opt_force_interactive, opt_trust_server_cert,
   opt_trust_server_cert_failures,
-  opt_config_dir, opt_config_options, 0
+  opt_config_dir, opt_config_options, opt_trace_file, 0
 };
 
 /* Options for giving a log message.  (Some of these also have other uses.)
@@ -2526,6 +2536,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case opt_vacuum_pristines:
         opt_state.vacuum_pristines = TRUE;
         break;
+      case opt_trace_file:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        SVN_ERR(svn_trace__init(svn_dirent_internal_style(utf8_opt_arg,
+                                                          pool),
+                                pool));
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -49,6 +49,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "svn_private_config.h"
 
@@ -60,6 +61,14 @@
  * The current threshold is 64MB. */
 #define BLOCK_READ_CACHE_THRESHOLD (0x40 * 0x100000)
 
+/* Number of revisions for which 'svnadmin load' collects new rep-cache
+ * entries before writing them to the database. */
+#define LOAD_REP_CACHE_BATCH_REVS 100
+
+/* Number of revisions that 'svnadmin load --checkpoint-file' flushes to
+ * disk at once unless --sync-interval says otherwise. */
+#define DEFAULT_LOAD_SYNC_INTERVAL 100
+
 static svn_cancel_func_t check_cancel = NULL;
 
 /* Custom filesystem warning function. */
@@ -95,6 +104,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_repcache,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -151,7 +161,12 @@ enum svnadmin__cmdline_options_t
     svnadmin__compatible_version,
     svnadmin__check_normalization,
     svnadmin__metadata_only,
-    svnadmin__no_flush_to_disk
+    svnadmin__no_flush_to_disk,
+    svnadmin__jobs,
+    svnadmin__split_size,
+    svnadmin__sync_interval,
+    svnadmin__checkpoint_file,
+    svnadmin__quick_verify
   };
 
 /* Option codes and descriptions.
@@ -274,6 +289,28 @@ static const apr_getopt_option_t options_table[] =
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("process up to ARG shards or revisions\n"
+        "                             concurrently (each job needs its own share\n"
+        "                             of memory and I/O bandwidth)")},
+
+    {"split-size", svnadmin__split_size, 1,
+     N_("dump ARG revisions per output range; with -F,\n"
+        "                             write each range to FILE.NNNNNN")},
+
+    {"sync-interval", svnadmin__sync_interval, 1,
+     N_("flush loaded revisions to disk in batches of\n"
+        "                             ARG revisions instead of one by one")},
+
+    {"checkpoint-file", svnadmin__checkpoint_file, 1,
+     N_("record the progress of a batched load in file\n"
+        "                             ARG and resume from there if it exists")},
+
+    {"quick-verify", svnadmin__quick_verify, 0,
+     N_("check only the youngest unpacked shard and\n"
+        "                             trust the ID counters of older revisions\n"
+        "                             (FSFS only)")},
+
     {NULL}
   };
 
@@ -283,6 +320,16 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc2_t cmd_table[] =
 {
+  {"build-repcache", subcommand_build_repcache, {0}, N_
+   ("usage: svnadmin build-repcache REPOS_PATH [-r LOWER[:UPPER]]\n\n"
+    "Add the file contents and properties of the given revisions to the\n"
+    "representation cache such that later commits can share them.  This\n"
+    "is useful for repositories that have been created with rep-sharing\n"
+    "disabled or that lost their rep-cache.db.  If no revisions are given,\n"
+    "process all revisions.  If only LOWER is given, process that one\n"
+    "revision.\n"),
+   {'r', 'q', 'M', svnadmin__jobs} },
+
   {"crashtest", subcommand_crashtest, {0}, N_
    ("usage: svnadmin crashtest REPOS_PATH\n\n"
     "Open the repository at REPOS_PATH, then abort, thus simulating\n"
@@ -330,8 +377,14 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "only the paths changed in that revision; otherwise it will describe\n"
     "every path present in the repository as of that revision.  (In either\n"
     "case, the second and subsequent revisions, if any, describe only paths\n"
-    "changed in those revisions.)\n"),
-  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F'},
+    "changed in those revisions.)\n"
+    "\n"
+    "If --jobs is given, ranges of revisions will be dumped concurrently.\n"
+    "If --split-size is given together with -F, each range of that many\n"
+    "revisions is written to a separate file FILE.NNNNNN; concatenating\n"
+    "those files in order yields the same output as a single dump.\n"),
+  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
+   svnadmin__jobs, svnadmin__split_size},
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, N_
@@ -392,12 +445,18 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "was previously empty, its UUID will, by default, be changed to the\n"
     "one specified in the stream.  Progress feedback is sent to stdout.\n"
     "If --revision is specified, limit the loaded revisions to only those\n"
-    "in the dump stream whose revision numbers match the specified range.\n"),
+    "in the dump stream whose revision numbers match the specified range.\n"
+    "\n"
+    "With --sync-interval or --checkpoint-file, load in bulk mode: read the\n"
+    "stream ahead while committing and make the new revisions durable in\n"
+    "batches.  The checkpoint file records the last durable revision; an\n"
+    "interrupted load resumes after it when run again with the same file.\n"),
    {'q', 'r', svnadmin__ignore_uuid, svnadmin__force_uuid,
     svnadmin__ignore_dates,
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, 'F', svnadmin__sync_interval,
+    svnadmin__checkpoint_file},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, N_
@@ -436,8 +495,10 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"pack", subcommand_pack, {0}, N_
    ("usage: svnadmin pack REPOS_PATH\n\n"
     "Possibly compact the repository into a more efficient storage model.\n"
-    "This may not apply to all repositories, in which case, exit.\n"),
-   {'q', 'M'} },
+    "This may not apply to all repositories, in which case, exit.\n"
+    "Packing does not re-deltify or re-compress existing contents; dump and\n"
+    "load the repository to store them with new delta bases or compression.\n"),
+   {'q', 'M', svnadmin__jobs} },
 
   {"recover", subcommand_recover, {0}, N_
    ("usage: svnadmin recover REPOS_PATH\n\n"
@@ -445,7 +506,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "been getting errors indicating that recovery ought to be run.\n"
     "Berkeley DB recovery requires exclusive access and will\n"
     "exit if the repository is in use by another process.\n"),
-   {svnadmin__wait} },
+   {svnadmin__wait, svnadmin__jobs, svnadmin__quick_verify} },
 
   {"rmlocks", subcommand_rmlocks, {0}, N_
    ("usage: svnadmin rmlocks REPOS_PATH LOCKED_PATH...\n\n"
@@ -513,7 +574,8 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
    ("usage: svnadmin verify REPOS_PATH\n\n"
     "Verify the data stored in the repository.\n"),
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -547,6 +609,11 @@ struct svnadmin_opt_state
   svn_boolean_t bypass_prop_validation;             /* --bypass-prop-validation */
   svn_boolean_t ignore_dates;                       /* --ignore-dates */
   svn_boolean_t no_flush_to_disk;                   /* --no-flush-to-disk */
+  int jobs;                                         /* --jobs */
+  svn_boolean_t quick_verify;                       /* --quick-verify */
+  int split_size;                                   /* --split-size */
+  int sync_interval;                                /* --sync-interval */
+  const char *checkpoint_file;                      /* --checkpoint-file */
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
@@ -558,12 +625,14 @@ struct svnadmin_opt_state
 
 
 /* Helper to open a repository and set a warning func (so we don't
- * SEGFAULT when libsvn_fs's default handler gets run).  */
+ * SEGFAULT when libsvn_fs's default handler gets run).  The options in
+ * EXTRA_FS_CONFIG, which may be NULL, get added to the FS config.  */
 static svn_error_t *
-open_repos(svn_repos_t **repos,
-           const char *path,
-           struct svnadmin_opt_state *opt_state,
-           apr_pool_t *pool)
+open_repos_with_config(svn_repos_t **repos,
+                       const char *path,
+                       struct svnadmin_opt_state *opt_state,
+                       apr_hash_t *extra_fs_config,
+                       apr_pool_t *pool)
 {
   /* Enable the "block-read" feature (where it applies)? */
   svn_boolean_t use_block_read
@@ -581,6 +650,16 @@ open_repos(svn_repos_t **repos,
                            use_block_read ? "1" : "0");
   svn_hash_sets(fs_config, SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                            opt_state->no_flush_to_disk ? "1" : "0");
+  if (opt_state->jobs > 1)
+    {
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_JOBS,
+                               apr_itoa(pool, opt_state->jobs));
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BUILD_REP_CACHE_JOBS,
+                               apr_itoa(pool, opt_state->jobs));
+    }
+
+  if (extra_fs_config)
+    fs_config = apr_hash_overlay(pool, extra_fs_config, fs_config);
 
   /* now, open the requested repository */
   SVN_ERR(svn_repos_open3(repos, path, fs_config, pool, pool));
@@ -588,6 +667,17 @@ open_repos(svn_repos_t **repos,
   return SVN_NO_ERROR;
 }
 
+/* Like open_repos_with_config() without additional FS config options. */
+static svn_error_t *
+open_repos(svn_repos_t **repos,
+           const char *path,
+           struct svnadmin_opt_state *opt_state,
+           apr_pool_t *pool)
+{
+  return svn_error_trace(open_repos_with_config(repos, path, opt_state,
+                                                NULL, pool));
+}
+
 
 /* Set *REVNUM to the revision specified by REVISION (or to
    SVN_INVALID_REVNUM if that has the type 'unspecified'),
@@ -700,6 +790,60 @@ crashtest_malfunction_handler(svn_boolean_t can_return,
   return SVN_NO_ERROR; /* Not reached. */
 }
 
+/* Implements svn_fs_progress_notify_func_t. */
+static void
+build_repcache_notify(svn_revnum_t revision,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_printf(pool,
+                                     _("* Processed revision %ld.\n"),
+                                     revision));
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_repcache(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t youngest, lower, upper;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+
+  /* Find the revision numbers at which to start and end. */
+  SVN_ERR(get_revnum(&lower, &opt_state->start_revision,
+                     youngest, repos, pool));
+  SVN_ERR(get_revnum(&upper, &opt_state->end_revision,
+                     youngest, repos, pool));
+
+  /* Fill in implied revisions if necessary. */
+  if (lower == SVN_INVALID_REVNUM)
+    {
+      lower = 0;
+      upper = youngest;
+    }
+  else if (upper == SVN_INVALID_REVNUM)
+    {
+      upper = lower;
+    }
+
+  if (lower > upper)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+       _("First revision cannot be higher than second"));
+
+  return svn_error_trace(
+    svn_fs_build_rep_cache(fs, lower, upper,
+                           opt_state->quiet ? NULL : build_repcache_notify,
+                           NULL, check_cancel, NULL, pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_crashtest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -894,7 +1038,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1248,6 +1392,55 @@ get_dump_range(svn_revnum_t *lower,
   return SVN_NO_ERROR;
 }
 
+/* Number of revisions per range when dumping with --jobs but without
+   an explicit --split-size. */
+#define DEFAULT_DUMP_RANGE_SIZE 1000
+
+/* Baton for dump_stream_func(). */
+typedef struct dump_stream_baton_t
+{
+  /* If not NULL, write each range to a separate file, named after this
+     base name. */
+  const char *file;
+
+  /* Otherwise, write all ranges to this stream. */
+  svn_stream_t *out_stream;
+
+  /* Number of the next output file. */
+  int file_no;
+} dump_stream_baton_t;
+
+/* Implements svn_repos__dump_stream_func_t for subcommand_dump(). */
+static svn_error_t *
+dump_stream_func(svn_stream_t **stream,
+                 void *baton,
+                 svn_revnum_t start_rev,
+                 svn_revnum_t end_rev,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  dump_stream_baton_t *b = baton;
+  apr_file_t *file;
+
+  if (b->file == NULL)
+    {
+      /* All ranges go into the same stream, which we close ourselves. */
+      *stream = svn_stream_disown(b->out_stream, result_pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Zero-padded file numbers make the lexical order match the revision
+     order such that "cat FILE.*" restores the complete dump. */
+  SVN_ERR(svn_io_file_open(&file,
+                           apr_psprintf(scratch_pool, "%s.%06d",
+                                        b->file, b->file_no++),
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                           | APR_BUFFERED, APR_OS_DEFAULT, result_pool));
+  *stream = svn_stream_from_aprfile2(file, FALSE, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1264,6 +1457,51 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
   SVN_ERR(get_dump_range(&lower, &upper, repos, opt_state, pool));
 
+  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stderr, pool);
+
+  /* Dump in ranges if requested.  With -F and --split-size, each range
+     gets its own output file. */
+  if (opt_state->jobs > 1 || opt_state->split_size > 0)
+    {
+      dump_stream_baton_t stream_baton = { 0 };
+      svn_revnum_t range_size = opt_state->split_size > 0
+                              ? opt_state->split_size
+                              : DEFAULT_DUMP_RANGE_SIZE;
+
+      if (opt_state->file && opt_state->split_size > 0)
+        stream_baton.file = opt_state->file;
+      else if (opt_state->file)
+        {
+          apr_file_t *file;
+
+          /* Overwrite existing files, same as with > redirection. */
+          SVN_ERR(svn_io_file_open(&file, opt_state->file,
+                                   APR_WRITE | APR_CREATE | APR_TRUNCATE
+                                   | APR_BUFFERED, APR_OS_DEFAULT, pool));
+          stream_baton.out_stream = svn_stream_from_aprfile2(file, FALSE,
+                                                             pool);
+        }
+      else
+        SVN_ERR(svn_stream_for_stdout(&stream_baton.out_stream, pool));
+
+      SVN_ERR(svn_repos__dump_fs_ranges(repos, dump_stream_func,
+                                        &stream_baton, lower, upper,
+                                        range_size, opt_state->jobs,
+                                        opt_state->incremental,
+                                        opt_state->use_deltas, TRUE, TRUE,
+                                        !opt_state->quiet
+                                          ? repos_notify_handler : NULL,
+                                        feedback_stream, check_cancel, NULL,
+                                        pool));
+
+      if (stream_baton.out_stream)
+        SVN_ERR(svn_stream_close(stream_baton.out_stream));
+
+      return SVN_NO_ERROR;
+    }
+
   /* Open the file or STDOUT, depending on whether -F was specified. */
   if (opt_state->file)
     {
@@ -1278,10 +1516,6 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   else
     SVN_ERR(svn_stream_for_stdout(&out_stream, pool));
 
-  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
-  if (! opt_state->quiet)
-    feedback_stream = recode_stream_create(stderr, pool);
-
   SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
                              TRUE, TRUE,
@@ -1513,6 +1747,7 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t lower, upper;
   svn_stream_t *in_stream;
   svn_stream_t *feedback_stream = NULL;
+  apr_hash_t *fs_config = apr_hash_make(pool);
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
@@ -1521,7 +1756,12 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
      support a limited set of revision kinds: number and unspecified. */
   SVN_ERR(get_load_range(&lower, &upper, opt_state));
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  /* Loading commits many revisions in a row, which benefits from
+     updating the rep-cache for many revisions at once. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_REP_CACHE_BATCH_REVS,
+                APR_STRINGIFY(LOAD_REP_CACHE_BATCH_REVS));
+  SVN_ERR(open_repos_with_config(&repos, opt_state->repository_path,
+                                 opt_state, fs_config, pool));
 
   /* Open the file or STDIN, depending on whether -F was specified. */
   if (opt_state->file)
@@ -1534,14 +1774,30 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs5(repos, in_stream, lower, upper,
-                           opt_state->uuid_action, opt_state->parent_dir,
-                           opt_state->use_pre_commit_hook,
-                           opt_state->use_post_commit_hook,
-                           !opt_state->bypass_prop_validation,
-                           opt_state->ignore_dates,
-                           opt_state->quiet ? NULL : repos_notify_handler,
-                           feedback_stream, check_cancel, NULL, pool);
+  if (opt_state->sync_interval > 0 || opt_state->checkpoint_file)
+    err = svn_repos__load_fs_bulk(repos, in_stream, lower, upper,
+                                  opt_state->uuid_action,
+                                  opt_state->parent_dir,
+                                  opt_state->use_pre_commit_hook,
+                                  opt_state->use_post_commit_hook,
+                                  !opt_state->bypass_prop_validation,
+                                  opt_state->ignore_dates,
+                                  opt_state->sync_interval > 0
+                                    ? opt_state->sync_interval
+                                    : DEFAULT_LOAD_SYNC_INTERVAL,
+                                  opt_state->checkpoint_file,
+                                  opt_state->quiet ? NULL
+                                                   : repos_notify_handler,
+                                  feedback_stream, check_cancel, NULL, pool);
+  else
+    err = svn_repos_load_fs5(repos, in_stream, lower, upper,
+                             opt_state->uuid_action, opt_state->parent_dir,
+                             opt_state->use_pre_commit_hook,
+                             opt_state->use_post_commit_hook,
+                             !opt_state->bypass_prop_validation,
+                             opt_state->ignore_dates,
+                             opt_state->quiet ? NULL : repos_notify_handler,
+                             feedback_stream, check_cancel, NULL, pool);
   if (err && err->apr_err == SVN_ERR_BAD_PROPERTY_VALUE)
     return svn_error_quick_wrap(err,
                                 _("Invalid property value found in "
@@ -1659,18 +1915,25 @@ subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_error_t *err;
   struct svnadmin_opt_state *opt_state = baton;
   svn_stream_t *feedback_stream = NULL;
+  apr_hash_t *fs_config = apr_hash_make(pool);
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
 
   SVN_ERR(svn_stream_for_stdout(&feedback_stream, pool));
 
+  if (opt_state->jobs > 1)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_RECOVER_JOBS,
+                             apr_itoa(pool, opt_state->jobs));
+  if (opt_state->quick_verify)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_QUICK_RECOVER, "1");
+
   /* Restore default signal handlers until after we have acquired the
    * exclusive lock so that the user interrupt before we actually
    * touch the repository. */
   svn_cmdline__disable_cancellation_handler();
 
-  err = svn_repos_recover4(opt_state->repository_path, TRUE,
+  err = svn_repos_recover5(opt_state->repository_path, fs_config, TRUE,
                            repos_notify_handler, feedback_stream,
                            check_cancel, NULL, pool);
   if (err)
@@ -1688,7 +1951,8 @@ subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  _("Waiting on repository lock; perhaps"
                                    " another process has it open?\n")));
       SVN_ERR(svn_cmdline_fflush(stdout));
-      SVN_ERR(svn_repos_recover4(opt_state->repository_path, FALSE,
+      SVN_ERR(svn_repos_recover5(opt_state->repository_path, fs_config,
+                                 FALSE,
                                  repos_notify_handler, feedback_stream,
                                  check_cancel, NULL, pool));
     }
@@ -2050,9 +2314,10 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->jobs,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -2834,6 +3099,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__quick_verify:
+        opt_state.quick_verify = TRUE;
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -2884,6 +3152,32 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__no_flush_to_disk:
         opt_state.no_flush_to_disk = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
+      case svnadmin__split_size:
+        SVN_ERR(svn_cstring_atoi(&opt_state.split_size, opt_arg));
+        if (opt_state.split_size < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid split size '%s'"),
+                                   opt_arg);
+        break;
+      case svnadmin__sync_interval:
+        SVN_ERR(svn_cstring_atoi(&opt_state.sync_interval, opt_arg));
+        if (opt_state.sync_interval < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid sync interval '%s'"),
+                                   opt_arg);
+        break;
+      case svnadmin__checkpoint_file:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.checkpoint_file =
+            apr_pstrdup(pool, svn_dirent_canonicalize(utf8_opt_arg, pool));
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
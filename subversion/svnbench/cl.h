@@ -96,6 +96,9 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t trust_server_cert_not_yet_valid;
   svn_boolean_t trust_server_cert_other_failure;
   apr_array_header_t* search_patterns; /* pattern arguments for --search */
+  int sessions;                  /* number of concurrent sessions */
+  int requests;                  /* number of commands per session */
+  const char *mix;               /* commands to run and their weights */
 } svn_cl__opt_state_t;
 
 
@@ -113,7 +116,8 @@ svn_opt_subcommand_t
   svn_cl__null_export,
   svn_cl__null_list,
   svn_cl__null_log,
-  svn_cl__null_info;
+  svn_cl__null_info,
+  svn_cl__null_load;
 
 
 /* See definition in main.c for documentation. */
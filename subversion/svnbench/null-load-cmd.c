@@ -0,0 +1,777 @@
+/*
+ * null-load-cmd.c -- Put concurrent load on a repository server
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_thread_proc.h>
+
+#include "svn_client.h"
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_sorts.h"
+#include "svn_wc.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+
+
+/*** Code. ***/
+
+/* One entry of a recorded working copy report, i.e. the parameters of
+ * a single svn_ra_reporter3_t call. */
+typedef struct report_entry_t
+{
+  /* Which reporter function to call. */
+  enum { report_set_path, report_delete_path, report_link_path } kind;
+
+  /* The function's parameters.  Unused ones are 0 / NULL. */
+  const char *path;
+  const char *url;
+  svn_revnum_t revision;
+  svn_depth_t depth;
+  svn_boolean_t start_empty;
+  const char *lock_token;
+} report_entry_t;
+
+/* Settings shared by all sessions.  They don't change while the sessions
+ * are running. */
+typedef struct load_baton_t
+{
+  /* Revision to run all commands against. */
+  svn_revnum_t revision;
+
+  /* Depth to use for checkouts. */
+  svn_depth_t depth;
+
+  /* Maximum number of revisions to get from null-log. */
+  int limit;
+
+  /* Number of commands to run per session. */
+  int requests;
+
+  /* Relative frequency of each command in load_commands[] and their sum. */
+  int *weights;
+  int total_weight;
+
+  /* Recorded working copy report (array of report_entry_t) for updates.
+   * NULL, if we have not been given a working copy. */
+  apr_array_header_t *report;
+
+  /* Set if any session failed.  All others will stop as well then. */
+  volatile svn_atomic_t failed;
+} load_baton_t;
+
+/* The state of a single session. */
+typedef struct load_session_t
+{
+  /* The shared settings. */
+  load_baton_t *lb;
+
+  /* The session and the pool it lives in.  The latter has its own
+   * allocator, so sessions may run on different threads. */
+  svn_ra_session_t *ra_session;
+  apr_pool_t *pool;
+
+  /* Seed for choosing the commands to run. */
+  apr_uint32_t seed;
+
+  /* Latest total number of bytes reported by the RA layer. */
+  apr_off_t progress;
+
+  /* Per command in load_commands[]: the latencies (apr_interval_time_t)
+   * of all runs and the bytes transferred by them. */
+  apr_array_header_t **latencies;
+  apr_off_t *bytes;
+
+  /* The error that stopped this session or SVN_NO_ERROR. */
+  svn_error_t *err;
+} load_session_t;
+
+/* Implements svn_ra_progress_notify_func_t. */
+static void
+load_progress_func(apr_off_t progress,
+                   apr_off_t total,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  load_session_t *session = baton;
+  session->progress = progress;
+}
+
+/* Implements svn_log_entry_receiver_t, ignoring all log entries. */
+static svn_error_t *
+null_log_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Get the node info of the session root, like null-info does. */
+static svn_error_t *
+load_info(load_session_t *session,
+          apr_pool_t *pool)
+{
+  svn_dirent_t *dirent;
+
+  SVN_ERR(svn_ra_stat(session->ra_session, "", session->lb->revision,
+                      &dirent, pool));
+  if (! dirent)
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("Session root non-existent in revision %ld"),
+                             session->lb->revision);
+
+  return SVN_NO_ERROR;
+}
+
+/* List the session root directory, like null-list does. */
+static svn_error_t *
+load_list(load_session_t *session,
+          apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+
+  SVN_ERR(svn_ra_get_dir2(session->ra_session, &dirents, NULL, NULL, "",
+                          session->lb->revision, SVN_DIRENT_ALL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the latest log entries of the session root, like null-log does. */
+static svn_error_t *
+load_log(load_session_t *session,
+         apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  SVN_ERR(svn_ra_get_log2(session->ra_session, paths,
+                          session->lb->revision, 0, session->lb->limit,
+                          TRUE, FALSE, FALSE, NULL,
+                          null_log_receiver, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Check out the session root into a null editor, like null-export. */
+static svn_error_t *
+load_checkout(load_session_t *session,
+              apr_pool_t *pool)
+{
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_ra_do_update3(session->ra_session, &reporter, &report_baton,
+                            session->lb->revision, "", session->lb->depth,
+                            FALSE, FALSE, svn_delta_default_editor(pool),
+                            NULL, pool, pool));
+  SVN_ERR(reporter->set_path(report_baton, "", session->lb->revision,
+                             svn_depth_infinity, TRUE, NULL, pool));
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Update the recorded working copy state into a null editor. */
+static svn_error_t *
+load_update(load_session_t *session,
+            apr_pool_t *pool)
+{
+  const apr_array_header_t *report = session->lb->report;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  int i;
+
+  SVN_ERR(svn_ra_do_update3(session->ra_session, &reporter, &report_baton,
+                            session->lb->revision, "", svn_depth_unknown,
+                            FALSE, FALSE, svn_delta_default_editor(pool),
+                            NULL, pool, pool));
+
+  for (i = 0; i < report->nelts; ++i)
+    {
+      const report_entry_t *entry = &APR_ARRAY_IDX(report, i,
+                                                   report_entry_t);
+      svn_error_t *err;
+
+      switch (entry->kind)
+        {
+          case report_set_path:
+            err = reporter->set_path(report_baton, entry->path,
+                                     entry->revision, entry->depth,
+                                     entry->start_empty, entry->lock_token,
+                                     pool);
+            break;
+
+          case report_delete_path:
+            err = reporter->delete_path(report_baton, entry->path, pool);
+            break;
+
+          default:
+            err = reporter->link_path(report_baton, entry->path, entry->url,
+                                      entry->revision, entry->depth,
+                                      entry->start_empty, entry->lock_token,
+                                      pool);
+            break;
+        }
+
+      if (err)
+        return svn_error_compose_create(
+                 err, reporter->abort_report(report_baton, pool));
+    }
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* The commands that we can run under load.  Their index is used in the
+ * per-command arrays. */
+static const struct
+{
+  const char *name;
+  svn_error_t *(*func)(load_session_t *session, apr_pool_t *pool);
+} load_commands[] =
+{
+  { "info", load_info },
+  { "list", load_list },
+  { "log", load_log },
+  { "checkout", load_checkout },
+  { "update", load_update }
+};
+
+/* Number of entries in load_commands[]. */
+#define COMMAND_COUNT \
+  ((int)(sizeof(load_commands) / sizeof(load_commands[0])))
+
+/* Return the index of a randomly chosen command in load_commands[],
+ * following the weights given in LB.  Use and update *SEED. */
+static int
+choose_command(const load_baton_t *lb,
+               apr_uint32_t *seed)
+{
+  int value;
+  int i;
+
+  /* A simple LCG is good enough to mix the commands. */
+  *seed = *seed * 1103515245 + 12345;
+  value = (int)((*seed >> 8) % lb->total_weight);
+
+  for (i = 0; value >= lb->weights[i]; ++i)
+    value -= lb->weights[i];
+
+  return i;
+}
+
+/* Run the commands of SESSION and record their latencies. */
+static svn_error_t *
+run_session(load_session_t *session)
+{
+  load_baton_t *lb = session->lb;
+  apr_pool_t *iterpool = svn_pool_create(session->pool);
+  int i;
+
+  for (i = 0; i < lb->requests; ++i)
+    {
+      int command = choose_command(lb, &session->seed);
+      apr_off_t progress = session->progress;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      if (svn_atomic_read(&lb->failed))
+        break;
+
+      SVN_ERR(svn_cl__check_cancel(NULL));
+
+      start = apr_time_now();
+      SVN_ERR(load_commands[command].func(session, iterpool));
+      APR_ARRAY_PUSH(session->latencies[command], apr_interval_time_t)
+        = apr_time_now() - start;
+
+      /* The RA layer reports the total for the session, which may get
+       * reset when it has to reconnect. */
+      session->bytes[command] += session->progress >= progress
+                               ? session->progress - progress
+                               : session->progress;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Thread function running the load_session_t DATA. */
+static void * APR_THREAD_FUNC
+session_thread(apr_thread_t *thread,
+               void *data)
+{
+  load_session_t *session = data;
+
+  session->err = run_session(session);
+  if (session->err)
+    svn_atomic_set(&session->lb->failed, TRUE);
+
+  return NULL;
+}
+#endif
+
+/* Implements svn_ra_reporter3_t.set_path, recording the call in
+ * the apr_array_header_t of report_entry_t REPORT_BATON. */
+static svn_error_t *
+record_set_path(void *report_baton,
+                const char *path,
+                svn_revnum_t revision,
+                svn_depth_t depth,
+                svn_boolean_t start_empty,
+                const char *lock_token,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *report = report_baton;
+  report_entry_t *entry = apr_array_push(report);
+
+  entry->kind = report_set_path;
+  entry->path = apr_pstrdup(report->pool, path);
+  entry->revision = revision;
+  entry->depth = depth;
+  entry->start_empty = start_empty;
+  entry->lock_token = apr_pstrdup(report->pool, lock_token);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_reporter3_t.delete_path, recording the call in
+ * the apr_array_header_t of report_entry_t REPORT_BATON. */
+static svn_error_t *
+record_delete_path(void *report_baton,
+                   const char *path,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *report = report_baton;
+  report_entry_t *entry = apr_array_push(report);
+
+  entry->kind = report_delete_path;
+  entry->path = apr_pstrdup(report->pool, path);
+  entry->revision = SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_reporter3_t.link_path, recording the call in
+ * the apr_array_header_t of report_entry_t REPORT_BATON. */
+static svn_error_t *
+record_link_path(void *report_baton,
+                 const char *path,
+                 const char *url,
+                 svn_revnum_t revision,
+                 svn_depth_t depth,
+                 svn_boolean_t start_empty,
+                 const char *lock_token,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *report = report_baton;
+  report_entry_t *entry = apr_array_push(report);
+
+  entry->kind = report_link_path;
+  entry->path = apr_pstrdup(report->pool, path);
+  entry->url = apr_pstrdup(report->pool, url);
+  entry->revision = revision;
+  entry->depth = depth;
+  entry->start_empty = start_empty;
+  entry->lock_token = apr_pstrdup(report->pool, lock_token);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_reporter3_t.finish_report and .abort_report. */
+static svn_error_t *
+record_finish_report(void *report_baton,
+                     apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Set *REPORT to the report that an update of the working copy at
+ * LOCAL_ABSPATH would send, allocated in RESULT_POOL. */
+static svn_error_t *
+record_report(apr_array_header_t **report,
+              const char *local_abspath,
+              svn_client_ctx_t *ctx,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  static const svn_ra_reporter3_t recorder =
+    {
+      record_set_path,
+      record_delete_path,
+      record_link_path,
+      record_finish_report,
+      record_finish_report
+    };
+
+  *report = apr_array_make(result_pool, 16, sizeof(report_entry_t));
+  SVN_ERR(svn_wc_crawl_revisions5(ctx->wc_ctx, local_abspath,
+                                  &recorder, *report,
+                                  FALSE, svn_depth_infinity, TRUE, FALSE,
+                                  FALSE, ctx->cancel_func, ctx->cancel_baton,
+                                  NULL, NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the --mix argument MIX into LB->WEIGHTS and LB->TOTAL_WEIGHT.
+ * MIX is a comma-separated list of COMMAND[=WEIGHT].  Allocate the
+ * weights in RESULT_POOL. */
+static svn_error_t *
+parse_mix(load_baton_t *lb,
+          const char *mix,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *items = svn_cstring_split(mix, ",", TRUE,
+                                                scratch_pool);
+  int i;
+
+  lb->weights = apr_pcalloc(result_pool, COMMAND_COUNT * sizeof(int));
+  lb->total_weight = 0;
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      char *name = APR_ARRAY_IDX(items, i, char *);
+      char *weight = strchr(name, '=');
+      int value = 1;
+      int k;
+
+      if (weight)
+        {
+          *weight = '\0';
+          SVN_ERR(svn_cstring_atoi(&value, weight + 1));
+          if (value < 0)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Negative weight for '%s' in --mix"),
+                                     name);
+        }
+
+      for (k = 0; k < COMMAND_COUNT; ++k)
+        if (strcmp(name, load_commands[k].name) == 0)
+          break;
+
+      if (k == COMMAND_COUNT)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Unknown command '%s' in --mix"), name);
+
+      lb->weights[k] += value;
+      lb->total_weight += value;
+    }
+
+  if (lb->total_weight == 0)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("No command selected by --mix"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the RA session for SESSION to URL.  Each session gets its own
+ * authentication baton, so they don't share any state with each other. */
+static svn_error_t *
+open_session(load_session_t *session,
+             const char *url,
+             svn_cl__opt_state_t *opt_state,
+             svn_client_ctx_t *ctx)
+{
+  svn_ra_callbacks2_t *callbacks;
+  svn_config_t *cfg_config = svn_hash_gets(ctx->config,
+                                           SVN_CONFIG_CATEGORY_CONFIG);
+
+  SVN_ERR(svn_ra_create_callbacks(&callbacks, session->pool));
+  SVN_ERR(svn_cmdline_create_auth_baton2(
+            &callbacks->auth_baton,
+            opt_state->non_interactive,
+            opt_state->auth_username,
+            opt_state->auth_password,
+            opt_state->config_dir,
+            opt_state->no_auth_cache,
+            opt_state->trust_server_cert_unknown_ca,
+            opt_state->trust_server_cert_cn_mismatch,
+            opt_state->trust_server_cert_expired,
+            opt_state->trust_server_cert_not_yet_valid,
+            opt_state->trust_server_cert_other_failure,
+            cfg_config,
+            ctx->cancel_func,
+            ctx->cancel_baton,
+            session->pool));
+
+  callbacks->progress_func = load_progress_func;
+  callbacks->progress_baton = session;
+  callbacks->cancel_func = ctx->cancel_func;
+  callbacks->check_tunnel_func = ctx->check_tunnel_func;
+  callbacks->open_tunnel_func = ctx->open_tunnel_func;
+  callbacks->tunnel_baton = ctx->tunnel_baton;
+
+  SVN_ERR(svn_ra_open4(&session->ra_session, NULL, url, NULL, callbacks,
+                       ctx->cancel_baton, ctx->config, session->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* qsort-compatible comparison function for apr_interval_time_t. */
+static int
+compare_latencies(const void *lhs,
+                  const void *rhs)
+{
+  apr_interval_time_t lhs_time = *(const apr_interval_time_t *)lhs;
+  apr_interval_time_t rhs_time = *(const apr_interval_time_t *)rhs;
+
+  return lhs_time < rhs_time ? -1 : (lhs_time > rhs_time ? 1 : 0);
+}
+
+/* Return the RANK-th percentile of the sorted LATENCIES in milliseconds. */
+static double
+percentile(const apr_array_header_t *latencies,
+           int rank)
+{
+  int index = (int)(((apr_int64_t)latencies->nelts * rank + 99) / 100);
+  if (index > 0)
+    --index;
+
+  return APR_ARRAY_IDX(latencies, index, apr_interval_time_t) / 1000.0;
+}
+
+/* Print the statistics of all SESSIONS, which ran for TIME_TAKEN. */
+static svn_error_t *
+print_statistics(load_session_t *sessions,
+                 int session_count,
+                 apr_interval_time_t time_taken,
+                 apr_pool_t *pool)
+{
+  double seconds = MAX(time_taken, 1) / 1.0e6;
+  int total_count = 0;
+  apr_off_t total_bytes = 0;
+  int i, k;
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             _("%-10s %8s %10s %10s %10s %10s %15s\n"),
+                             _("Command"), _("Count"), _("Ops/s"),
+                             _("p50 ms"), _("p95 ms"), _("p99 ms"),
+                             _("Bytes")));
+
+  for (k = 0; k < COMMAND_COUNT; ++k)
+    {
+      apr_array_header_t *latencies
+        = apr_array_make(pool, 0, sizeof(apr_interval_time_t));
+      apr_off_t bytes = 0;
+
+      for (i = 0; i < session_count; ++i)
+        {
+          apr_array_cat(latencies, sessions[i].latencies[k]);
+          bytes += sessions[i].bytes[k];
+        }
+
+      if (latencies->nelts == 0)
+        continue;
+
+      qsort(latencies->elts, latencies->nelts, latencies->elt_size,
+            compare_latencies);
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 "%-10s %8d %10.2f %10.3f %10.3f %10.3f %15s\n",
+                                 load_commands[k].name, latencies->nelts,
+                                 latencies->nelts / seconds,
+                                 percentile(latencies, 50),
+                                 percentile(latencies, 95),
+                                 percentile(latencies, 99),
+                                 svn__i64toa_sep(bytes, ',', pool)));
+
+      total_count += latencies->nelts;
+      total_bytes += bytes;
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             "%-10s %8d %10.2f %10s %10s %10s %15s\n",
+                             _("Total"), total_count, total_count / seconds,
+                             "", "", "",
+                             svn__i64toa_sep(total_bytes, ',', pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_load(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *target;
+  const char *url;
+  load_baton_t *lb = apr_pcalloc(pool, sizeof(*lb));
+  load_session_t *sessions;
+  int session_count = opt_state->sessions > 0 ? opt_state->sessions : 1;
+  apr_time_t start_time;
+  apr_hash_index_t *hi;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, k;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+  if (targets->nelts != 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL, NULL);
+
+  target = APR_ARRAY_IDX(targets, 0, const char *);
+
+  lb->depth = opt_state->depth == svn_depth_unknown
+            ? svn_depth_infinity
+            : opt_state->depth;
+  lb->limit = opt_state->limit > 0 ? opt_state->limit : 100;
+  lb->requests = opt_state->requests > 0 ? opt_state->requests : 100;
+  SVN_ERR(parse_mix(lb, opt_state->mix ? opt_state->mix : "info,list,log",
+                    pool, pool));
+
+  /* Updates run against the state of a local working copy. */
+  if (svn_path_is_url(target))
+    {
+      url = target;
+    }
+  else
+    {
+      const char *local_abspath;
+
+      SVN_ERR(svn_dirent_get_absolute(&local_abspath, target, pool));
+      SVN_ERR(svn_client_url_from_path2(&url, local_abspath, ctx,
+                                        pool, pool));
+      SVN_ERR(record_report(&lb->report, local_abspath, ctx, pool, pool));
+    }
+
+  for (k = 0; k < COMMAND_COUNT; ++k)
+    if (load_commands[k].func == load_update && lb->weights[k] && !lb->report)
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                              _("Running 'update' requires a working copy "
+                                "target"));
+
+  /* Expand all values now, so the sessions can share the config. */
+  for (hi = apr_hash_first(pool, ctx->config); hi; hi = apr_hash_next(hi))
+    svn_config__set_read_only(apr_hash_this_val(hi), pool);
+
+  /* Open all sessions up-front.  Authentication may require prompting. */
+  sessions = apr_pcalloc(pool, session_count * sizeof(*sessions));
+  for (i = 0; i < session_count; ++i)
+    {
+      load_session_t *session = &sessions[i];
+
+      session->lb = lb;
+      session->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      session->seed = (apr_uint32_t)i;
+      session->latencies = apr_palloc(pool, COMMAND_COUNT
+                                            * sizeof(*session->latencies));
+      session->bytes = apr_pcalloc(pool, COMMAND_COUNT
+                                         * sizeof(*session->bytes));
+      for (k = 0; k < COMMAND_COUNT; ++k)
+        session->latencies[k] = apr_array_make(pool, 0,
+                                               sizeof(apr_interval_time_t));
+
+      err = open_session(session, url, opt_state, ctx);
+      if (err)
+        {
+          session_count = i + 1;
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      /* Run all commands against the same revision. */
+      if (opt_state->start_revision.kind == svn_opt_revision_number)
+        lb->revision = opt_state->start_revision.value.number;
+      else
+        err = svn_ra_get_latest_revnum(sessions[0].ra_session,
+                                       &lb->revision, pool);
+    }
+
+  start_time = apr_time_now();
+  if (!err)
+    {
+#if APR_HAS_THREADS
+      apr_thread_t **threads = apr_pcalloc(pool, session_count
+                                                 * sizeof(*threads));
+      apr_threadattr_t *attr;
+      apr_status_t status;
+
+      status = apr_threadattr_create(&attr, pool);
+      for (i = 0; i < session_count && !status; ++i)
+        status = apr_thread_create(&threads[i], attr, session_thread,
+                                   &sessions[i], pool);
+
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          svn_atomic_set(&lb->failed, TRUE);
+        }
+
+      for (i = 0; i < session_count && threads[i]; ++i)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, threads[i]);
+        }
+#else
+      for (i = 0; i < session_count; ++i)
+        {
+          sessions[i].err = run_session(&sessions[i]);
+          if (sessions[i].err)
+            break;
+        }
+#endif
+    }
+
+  /* Report the first error only. */
+  for (i = 0; i < session_count; ++i)
+    if (!err && sessions[i].err)
+      err = sessions[i].err;
+    else
+      svn_error_clear(sessions[i].err);
+
+  if (!err)
+    err = print_statistics(sessions, session_count,
+                           apr_time_now() - start_time, pool);
+
+  for (i = 0; i < session_count; ++i)
+    svn_pool_destroy(sessions[i].pool);
+
+  return svn_error_trace(err);
+}
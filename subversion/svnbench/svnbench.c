@@ -69,7 +69,10 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_sessions,
+  opt_requests,
+  opt_mix
 } svn_cl__longopt_t;
 
 
@@ -168,6 +171,16 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"sessions",      opt_sessions, 1,
+                    N_("run ARG sessions concurrently")},
+  {"requests",      opt_requests, 1,
+                    N_("run ARG commands per session")},
+  {"mix",           opt_mix, 1,
+                    N_("comma-separated list of COMMAND[=WEIGHT]\n"
+                       "                             "
+                       "selecting the commands to run and their\n"
+                       "                             "
+                       "relative frequency")},
 
   /* Long-opt Aliases
    *
@@ -306,6 +319,29 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
     {'r', 'R', opt_depth, opt_targets, opt_changelist}
   },
 
+  { "null-load", svn_cl__null_load, {0}, N_
+    ("Run a mix of commands in concurrent sessions and report latencies.\n"
+     "usage: null-load [-r REV] TARGET\n"
+     "\n"
+     "  Open --sessions sessions (default: 1) to the repository URL of\n"
+     "  TARGET and run --requests randomly chosen commands in each of them.\n"
+     "  Finally, print the throughput, the 50th, 95th and 99th percentile of\n"
+     "  the latency and the bytes transferred per command.\n"
+     "\n"
+     "  All commands run against REV (default: HEAD) and fetch their data\n"
+     "  without storing it anywhere.  Available commands are:\n"
+     "\n"
+     "    info      Get the node info of TARGET, like null-info.\n"
+     "    list      List the directory TARGET, like null-list.\n"
+     "    log       Fetch the latest log entries (see --limit), like null-log.\n"
+     "    checkout  Fetch the whole tree (see --depth), like null-export.\n"
+     "    update    Update the working copy TARGET.  Its state is recorded\n"
+     "              once and then replayed for every update.\n"
+     "\n"
+     "  The default for --mix is 'info,list,log'.  An example that runs\n"
+     "  4 info for every log and checkout is 'info=4,log,checkout'.\n"),
+    {'r', 'l', opt_depth, opt_sessions, opt_requests, opt_mix} },
+
   { NULL, NULL, {0}, NULL, {0} }
 };
 
@@ -682,6 +718,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case 'g':
         opt_state.use_merge_history = TRUE;
         break;
+      case opt_sessions:
+        SVN_ERR(svn_cstring_atoi(&opt_state.sessions, opt_arg));
+        if (opt_state.sessions <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --sessions must be "
+                                    "positive"));
+        break;
+      case opt_requests:
+        SVN_ERR(svn_cstring_atoi(&opt_state.requests, opt_arg));
+        if (opt_state.requests <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --requests must be "
+                                    "positive"));
+        break;
+      case opt_mix:
+        SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.mix, opt_arg, pool));
+        break;
       case opt_search:
         SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
         SVN_ERR(svn_utf__xfrm(&utf8_opt_arg, utf8_opt_arg,
@@ -105,50 +105,6 @@ write_propdel_to_stringbuf(svn_stringbuf_t **strbuf,
 }
 
 
-/* Compare the node-path PATH with the (const char *) prefixes in PFXLIST.
- * Return TRUE if any prefix is a prefix of PATH (matching whole path
- * components); FALSE otherwise.
- * PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static svn_boolean_t
-ary_prefix_match(const apr_array_header_t *pfxlist, const char *path)
-{
-  int i;
-  size_t path_len = strlen(path);
-
-  for (i = 0; i < pfxlist->nelts; i++)
-    {
-      const char *pfx = APR_ARRAY_IDX(pfxlist, i, const char *);
-      size_t pfx_len = strlen(pfx);
-
-      if (path_len < pfx_len)
-        continue;
-      if (strncmp(path, pfx, pfx_len) == 0
-          && (pfx_len == 1 || path[pfx_len] == '\0' || path[pfx_len] == '/'))
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
-
-/* Check whether we need to skip this PATH based on its presence in
-   the PREFIXES list, and the DO_EXCLUDE option.
-   PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static APR_INLINE svn_boolean_t
-skip_path(const char *path, const apr_array_header_t *prefixes,
-          svn_boolean_t do_exclude, svn_boolean_t glob)
-{
-  const svn_boolean_t matches =
-    (glob
-     ? svn_cstring_match_glob_list(path, prefixes)
-     : ary_prefix_match(prefixes, path));
-
-  /* NXOR */
-  return (matches ? do_exclude : !do_exclude);
-}
-
-
-
 /* Note: the input stream parser calls us with events.
    Output of the filtered dump occurs for the most part streamily with the
    event callbacks, to avoid caching large quantities of data in memory.
@@ -184,6 +140,11 @@ struct parse_baton_t
   svn_boolean_t preserve_revprops;
   svn_boolean_t skip_missing_merge_sources;
   svn_boolean_t allow_deltas;
+
+  /* The prefixes to match paths against, as set of (const char *) keys.
+     With GLOB, these are only the patterns without any wildcards while
+     PREFIXES holds the remaining ones.  Without GLOB, PREFIXES is empty. */
+  apr_hash_t *prefix_set;
   apr_array_header_t *prefixes;
 
   /* Input and output streams. */
@@ -200,6 +161,56 @@ struct parse_baton_t
   svn_revnum_t oldest_original_rev;
 };
 
+/* Return TRUE if PATH or any of its parents is a key in the set of
+ * prefixes PFXSET, i.e. if any prefix is a prefix of PATH matching whole
+ * path components; FALSE otherwise.  A prefix of "/" matches all paths.
+ * PATH starts with a '/', as do the (const char *) keys in PFXSET.
+ *
+ * This takes one hash lookup per path component of PATH, independent of
+ * the number of prefixes. */
+static svn_boolean_t
+prefix_set_match(apr_hash_t *pfxset, const char *path)
+{
+  apr_ssize_t len = strlen(path);
+
+  if (apr_hash_get(pfxset, "/", 1))
+    return TRUE;
+
+  while (len > 0)
+    {
+      if (apr_hash_get(pfxset, path, len))
+        return TRUE;
+
+      /* Strip the last path component. */
+      while (--len > 0 && path[len] != '/')
+        ;
+    }
+
+  return FALSE;
+}
+
+
+/* Check whether we need to skip this PATH based on its presence in
+   the prefixes of PB, and the PB->DO_EXCLUDE option.
+   PATH starts with a '/', as do all prefixes. */
+static APR_INLINE svn_boolean_t
+skip_path(const char *path, const struct parse_baton_t *pb)
+{
+  svn_boolean_t matches;
+
+  /* Patterns without wildcards can only match PATH literally. */
+  if (pb->glob)
+    matches = (svn_hash_gets(pb->prefix_set, path) != NULL
+               || (pb->prefixes->nelts
+                   && svn_cstring_match_glob_list(path, pb->prefixes)));
+  else
+    matches = prefix_set_match(pb->prefix_set, path);
+
+  /* NXOR */
+  return (matches ? pb->do_exclude : !pb->do_exclude);
+}
+
+
 struct revision_baton_t
 {
   /* Reference to the global parse baton. */
@@ -479,8 +490,7 @@ new_node_record(void **node_baton,
   if (copyfrom_path && copyfrom_path[0] != '/')
     copyfrom_path = apr_pstrcat(pool, "/", copyfrom_path, SVN_VA_NULL);
 
-  nb->do_skip = skip_path(node_path, pb->prefixes,
-                          pb->do_exclude, pb->glob);
+  nb->do_skip = skip_path(node_path, pb);
 
   /* If we're skipping the node, take note of path, discarding the
      rest.  */
@@ -501,7 +511,7 @@ new_node_record(void **node_baton,
 
       /* Test if this node was copied from dropped source. */
       if (copyfrom_path &&
-          skip_path(copyfrom_path, pb->prefixes, pb->do_exclude, pb->glob))
+          skip_path(copyfrom_path, pb))
         {
           /* This node was copied from a dropped source.
              We have a problem, since we did not want to drop this node too.
@@ -672,7 +682,7 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
       struct parse_baton_t *pb = rb->pb;
 
       /* Determine whether the merge_source is a part of the prefix. */
-      if (skip_path(merge_source, pb->prefixes, pb->do_exclude, pb->glob))
+      if (skip_path(merge_source, pb))
         {
           if (pb->skip_missing_merge_sources)
             continue;
@@ -1025,6 +1035,31 @@ struct svndumpfilter_opt_state
 };
 
 
+/* Set *IN to a stream reading from STDIN, allocated in POOL.  If STDIN
+   has been redirected from a regular file, the stream supports seeking,
+   which allows the parser to skip the contents of dropped nodes without
+   reading them. */
+static svn_error_t *
+open_input_stream(svn_stream_t **in,
+                  apr_pool_t *pool)
+{
+  apr_file_t *stdin_file;
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
+
+  apr_err = apr_file_open_flags_stdin(&stdin_file, APR_BUFFERED, pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't open stdin"));
+
+  if (apr_file_info_get(&finfo, APR_FINFO_TYPE, stdin_file) == APR_SUCCESS
+      && finfo.filetype == APR_REG)
+    *in = svn_stream_from_aprfile2(stdin_file, TRUE, pool);
+  else
+    SVN_ERR(svn_stream_for_stdin2(in, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 parse_baton_initialize(struct parse_baton_t **pb,
                        struct svndumpfilter_opt_state *opt_state,
@@ -1032,9 +1067,10 @@ parse_baton_initialize(struct parse_baton_t **pb,
                        apr_pool_t *pool)
 {
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+  int i;
 
   /* Read the stream from STDIN.  Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
+  SVN_ERR(open_input_stream(&baton->in_stream, pool));
 
   /* Have the parser dump results to STDOUT. Users can redirect a file. */
   SVN_ERR(svn_stream_for_stdout(&baton->out_stream, pool));
@@ -1052,7 +1088,18 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->preserve_revprops = opt_state->preserve_revprops;
   baton->quiet = opt_state->quiet;
   baton->glob = opt_state->glob;
-  baton->prefixes = opt_state->prefixes;
+  baton->prefix_set = apr_hash_make(pool);
+  baton->prefixes = apr_array_make(pool, 0, sizeof(const char *));
+  for (i = 0; i < opt_state->prefixes->nelts; i++)
+    {
+      const char *prefix = APR_ARRAY_IDX(opt_state->prefixes, i,
+                                         const char *);
+
+      if (baton->glob && strpbrk(prefix, "*?[\\"))
+        APR_ARRAY_PUSH(baton->prefixes, const char *) = prefix;
+      else
+        svn_hash_sets(baton->prefix_set, prefix, prefix);
+    }
   baton->skip_missing_merge_sources = opt_state->skip_missing_merge_sources;
   baton->rev_drop_count = 0; /* used to shift revnums while filtering */
   baton->dropped_nodes = apr_hash_make(pool);
@@ -23,6 +23,7 @@
 #include <assert.h>
 
 #include "svn_fs.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
@@ -502,9 +503,14 @@ subcommand__stats(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svnfsfs__opt_state *opt_state = baton;
   svn_fs_fs__stats_t *stats;
   svn_fs_t *fs;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  if (opt_state->jobs > 1)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_STATS_JOBS,
+                  apr_itoa(pool, opt_state->jobs));
 
   printf("Reading revisions\n");
-  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, fs_config, pool));
   SVN_ERR(svn_fs_fs__get_stats(&stats, fs, print_progress, NULL,
                                check_cancel, NULL, pool, pool));
 
@@ -76,7 +76,8 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs
   };
 
 /* Option codes and descriptions.
@@ -104,6 +105,11 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("process up to ARG rev / pack files\n"
+        "                             concurrently (each job needs its own share\n"
+        "                             of memory and I/O bandwidth)")},
+
     {NULL}
   };
 
@@ -155,7 +161,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"stats", subcommand__stats, {0}, N_
    ("usage: svnfsfs stats REPOS_PATH\n\n"
     "Write object size statistics to console.\n"),
-   {'M'} },
+   {'M', svnfsfs__jobs} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -164,6 +170,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
 svn_error_t *
 open_fs(svn_fs_t **fs,
         const char *path,
+        apr_hash_t *fs_config,
         apr_pool_t *pool)
 {
   const char *fs_type;
@@ -177,7 +184,7 @@ open_fs(svn_fs_t **fs,
                              fs_type);
 
   /* Now open it. */
-  SVN_ERR(svn_fs_open2(fs, path, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(fs, path, fs_config, pool, pool));
   svn_fs_set_warning_func(*fs, warning_func, NULL);
 
   return SVN_NO_ERROR;
@@ -308,6 +315,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.memory_cache_size = 0x100000 * sz_val;
         }
         break;
+      case svnfsfs__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
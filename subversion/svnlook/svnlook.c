@@ -200,7 +200,11 @@ static const apr_getopt_option_t options_table[] =
       "                             "
       "  -U ARG, --context ARG: Show ARG lines of context\n"
       "                             "
-      "  -p, --show-c-function: Show C function name")},
+      "  -p, --show-c-function: Show C function name\n"
+      "                             "
+      "  --histogram: Use the faster, non-minimal\n"
+      "                             "
+      "    histogram diff algorithm")},
 
   {"quiet",             'q', 0,
    N_("no progress (only errors) to stderr")},
@@ -483,146 +487,302 @@ generate_delta_tree(svn_repos_node_t **tree,
 
 
 
-/*** Tree Printing Routines ***/
+/*** Changed Paths Routines ***/
 
-/* Recursively print only directory nodes that either a) have property
-   mods, or b) contains files that have changed, or c) has added or deleted
-   children.  NODE is the root node of the tree delta, so every node in it
-   is either changed or is a directory with a changed node somewhere in the
-   subtree below it.
- */
-static svn_error_t *
-print_dirs_changed_tree(svn_repos_node_t *node,
-                        const char *path /* UTF-8! */,
-                        apr_pool_t *pool)
+/* A changed path as reported by svn_fs_paths_changed3(), reduced to what
+   'svnlook changed' and 'svnlook dirs-changed' need.  Unlike the delta
+   tree, a list of these can be built straight from the changes recorded
+   in the filesystem, i.e. without replaying the revision. */
+typedef struct changed_path_t
 {
-  svn_repos_node_t *tmp_node;
-  svn_boolean_t print_me = FALSE;
-  const char *full_path;
-  apr_pool_t *iterpool;
+  /* Relpath of the changed node. */
+  const char *path;
+
+  svn_fs_path_change_kind_t change_kind;
+  svn_node_kind_t node_kind;
+  svn_boolean_t text_mod;
+  svn_boolean_t prop_mod;
+
+  /* For replacements, the kind of the node that got replaced. */
+  svn_node_kind_t replaced_kind;
+
+  /* Copy source of added nodes if that has been requested.  PATH is NULL
+     for plain additions. */
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+} changed_path_t;
+
+/* Implements the comparison function for svn_sort__array() on arrays of
+   changed_path_t *, establishing the depth-first order in which the delta
+   tree used to get printed. */
+static int
+compare_changed_paths(const void *a,
+                      const void *b)
+{
+  const changed_path_t *lhs = *(const changed_path_t * const *)a;
+  const changed_path_t *rhs = *(const changed_path_t * const *)b;
 
-  SVN_ERR(check_cancel(NULL));
+  return svn_path_compare_paths(lhs->path, rhs->path);
+}
 
-  if (! node)
-    return SVN_NO_ERROR;
+/* Set *KIND to the kind of the node at FSPATH that got deleted in ROOT.
+   BASE_ROOT is the root that ROOT is based on.  If the deleted node lived
+   within a copy made in ROOT, look for it at the copy source. */
+static svn_error_t *
+get_deleted_node_kind(svn_node_kind_t *kind,
+                      svn_fs_root_t *root,
+                      svn_fs_root_t *base_root,
+                      const char *fspath,
+                      apr_pool_t *pool)
+{
+  svn_fs_root_t *copy_root;
+  const char *copy_path;
 
-  /* Not a directory?  We're not interested. */
-  if (node->kind != svn_node_dir)
+  SVN_ERR(svn_fs_check_path(kind, base_root, fspath, pool));
+  if (*kind != svn_node_none)
     return SVN_NO_ERROR;
 
-  /* Got prop mods?  Excellent. */
-  if (node->prop_mod)
-    print_me = TRUE;
-
-  /* Fly through the list of children, checking for modified files. */
-  tmp_node = node->child;
-  while (tmp_node && (! print_me))
+  SVN_ERR(svn_fs_closest_copy(&copy_root, &copy_path, root,
+                              svn_fspath__dirname(fspath, pool), pool));
+  if (copy_root)
     {
-      if ((tmp_node->kind == svn_node_file)
-           || (tmp_node->action == 'A')
-           || (tmp_node->action == 'D'))
-        {
-          print_me = TRUE;
-        }
-      tmp_node = tmp_node->sibling;
+      const char *copyfrom_path;
+      svn_revnum_t copyfrom_rev;
+      svn_fs_root_t *copyfrom_root;
+
+      SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                 copy_root, copy_path, pool));
+      SVN_ERR(svn_fs_revision_root(&copyfrom_root, svn_fs_root_fs(root),
+                                   copyfrom_rev, pool));
+      SVN_ERR(svn_fs_check_path(kind, copyfrom_root,
+                                svn_fspath__join(copyfrom_path,
+                                                 svn_fspath__skip_ancestor(
+                                                   copy_path, fspath),
+                                                 pool),
+                                pool));
     }
 
-  /* Print the node if it qualifies. */
-  if (print_me)
-    {
-      SVN_ERR(svn_cmdline_printf(pool, "%s/\n", path));
-    }
+  if (*kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("'%s' not found in filesystem"), fspath);
 
-  /* Return here if the node has no children. */
-  tmp_node = node->child;
-  if (! tmp_node)
-    return SVN_NO_ERROR;
+  return SVN_NO_ERROR;
+}
 
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (tmp_node)
+/* Set *CHANGES to the list of changed_path_t * for all changes in ROOT,
+   sorted by path.  BASE_REV is the revision that ROOT is based on.  If
+   COPY_INFO is set, fill in the copy source of added nodes.
+
+   Read the changes one at a time from the filesystem, so the memory
+   used is only that of the resulting list.
+
+   Allocate *CHANGES in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_changed_paths(apr_array_header_t **changes,
+                  svn_fs_root_t *root,
+                  svn_revnum_t base_rev,
+                  svn_boolean_t copy_info,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_fs_root_t *base_root;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_revision_root(&base_root, svn_fs_root_fs(root), base_rev,
+                               scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                scratch_pool));
+
+  *changes = apr_array_make(result_pool, 16, sizeof(changed_path_t *));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
     {
+      changed_path_t *changed = apr_pcalloc(result_pool, sizeof(*changed));
+
       svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, tmp_node->name, iterpool);
-      SVN_ERR(print_dirs_changed_tree(tmp_node, full_path, iterpool));
-      tmp_node = tmp_node->sibling;
+      SVN_ERR(check_cancel(NULL));
+
+      changed->path = apr_pstrmemdup(result_pool,
+                                     change->path.data + 1,
+                                     change->path.len - 1);
+      changed->change_kind = change->change_kind;
+      changed->node_kind = change->node_kind;
+      changed->text_mod = change->text_mod;
+      changed->prop_mod = change->prop_mod;
+      changed->copyfrom_rev = SVN_INVALID_REVNUM;
+
+      /* Treat moves like the copies they also are. */
+      if (changed->change_kind == svn_fs_path_change_move)
+        changed->change_kind = svn_fs_path_change_add;
+      else if (changed->change_kind == svn_fs_path_change_movereplace)
+        changed->change_kind = svn_fs_path_change_replace;
+
+      /* Older repository formats don't record the node kind. */
+      if (changed->node_kind == svn_node_unknown)
+        {
+          if (changed->change_kind == svn_fs_path_change_delete)
+            SVN_ERR(get_deleted_node_kind(&changed->node_kind, root,
+                                          base_root, change->path.data,
+                                          iterpool));
+          else
+            SVN_ERR(svn_fs_check_path(&changed->node_kind, root,
+                                      change->path.data, iterpool));
+        }
+
+      if (changed->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(get_deleted_node_kind(&changed->replaced_kind, root,
+                                      base_root, change->path.data,
+                                      iterpool));
+
+      if (copy_info
+          && (changed->change_kind == svn_fs_path_change_add
+              || changed->change_kind == svn_fs_path_change_replace))
+        {
+          const char *copyfrom_path = change->copyfrom_path;
+          svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+
+          if (!change->copyfrom_known)
+            SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                       root, change->path.data, iterpool));
+
+          if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
+            {
+              changed->copyfrom_path = apr_pstrdup(result_pool,
+                                                   copyfrom_path);
+              changed->copyfrom_rev = copyfrom_rev;
+            }
+        }
+
+      APR_ARRAY_PUSH(*changes, changed_path_t *) = changed;
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
     }
+
   svn_pool_destroy(iterpool);
+  svn_sort__array(*changes, compare_changed_paths);
 
   return SVN_NO_ERROR;
 }
 
-
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* Print only directories that either a) have property mods, or b) contain
+   files that have changed, or c) have added or deleted children.  CHANGES
+   is a sorted list of changed_path_t *, as returned by
+   get_changed_paths().
+ */
 static svn_error_t *
-print_changed_tree(svn_repos_node_t *node,
-                   const char *path /* UTF-8! */,
-                   svn_boolean_t copy_info,
+print_dirs_changed(const apr_array_header_t *changes,
                    apr_pool_t *pool)
 {
-  const char *full_path;
-  char status[4] = "_  ";
-  svn_boolean_t print_me = TRUE;
-  apr_pool_t *iterpool;
-
-  SVN_ERR(check_cancel(NULL));
-
-  if (! node)
-    return SVN_NO_ERROR;
+  apr_hash_t *dirs = apr_hash_make(pool);
+  apr_array_header_t *sorted_dirs;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
 
-  /* Print the node. */
-  if (node->action == 'A')
-    {
-      status[0] = 'A';
-      if (copy_info && node->copyfrom_path)
-        status[2] = '+';
-    }
-  else if (node->action == 'D')
-    status[0] = 'D';
-  else if (node->action == 'R')
+  for (i = 0; i < changes->nelts; i++)
     {
-      if ((! node->text_mod) && (! node->prop_mod))
-        print_me = FALSE;
-      if (node->text_mod)
-        status[0] = 'U';
-      if (node->prop_mod)
-        status[1] = 'U';
+      const changed_path_t *changed
+        = APR_ARRAY_IDX(changes, i, const changed_path_t *);
+
+      if (changed->node_kind == svn_node_dir
+          && changed->change_kind != svn_fs_path_change_delete
+          && changed->prop_mod)
+        svn_hash_sets(dirs, changed->path, changed->path);
+
+      /* Each change is either a file or the addition or deletion of a
+         directory, so its parent qualifies.  The root has no parent. */
+      if (changed->node_kind == svn_node_file
+          || changed->change_kind != svn_fs_path_change_modify)
+        {
+          if (*changed->path)
+            {
+              const char *parent = svn_relpath_dirname(changed->path, pool);
+              svn_hash_sets(dirs, parent, parent);
+            }
+        }
     }
-  else
-    print_me = FALSE;
 
-  /* Print this node unless told to skip it. */
-  if (print_me)
+  sorted_dirs = svn_sort__hash(dirs, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted_dirs->nelts; i++)
     {
-      SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
-                                 status,
-                                 path,
-                                 node->kind == svn_node_dir ? "/" : ""));
-      if (copy_info && node->copyfrom_path)
-        /* Remove the leading slash from the copyfrom path for consistency
-           with the rest of the output. */
-        SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
-                                   (node->copyfrom_path[0] == '/'
-                                    ? node->copyfrom_path + 1
-                                    : node->copyfrom_path),
-                                   (node->kind == svn_node_dir ? "/" : ""),
-                                   node->copyfrom_rev));
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_dirs, i,
+                                              svn_sort__item_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+      SVN_ERR(svn_cmdline_printf(iterpool, "%s/\n",
+                                 (const char *)item->key));
     }
+  svn_pool_destroy(iterpool);
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
+  return SVN_NO_ERROR;
+}
 
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (node)
+
+/* Print all changed paths in CHANGES, a sorted list of changed_path_t *
+   as returned by get_changed_paths(), in a format compatible with
+   'svn update'.  Skip directories affected only by "bubble-up".  Include
+   the copy sources if COPY_INFO is set.
+ */
+static svn_error_t *
+print_changed(const apr_array_header_t *changes,
+              svn_boolean_t copy_info,
+              apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < changes->nelts; i++)
     {
+      const changed_path_t *changed
+        = APR_ARRAY_IDX(changes, i, const changed_path_t *);
+      const char *dir_suffix = changed->node_kind == svn_node_dir ? "/" : "";
+      char status[4] = "_  ";
+
       svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, node->name, iterpool);
-      SVN_ERR(print_changed_tree(node, full_path, copy_info, iterpool));
-      node = node->sibling;
+      SVN_ERR(check_cancel(NULL));
+
+      if (changed->change_kind == svn_fs_path_change_delete)
+        {
+          SVN_ERR(svn_cmdline_printf(iterpool, "D   %s%s\n",
+                                     changed->path, dir_suffix));
+          continue;
+        }
+
+      /* A replacement shows as a deletion followed by an addition. */
+      if (changed->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(svn_cmdline_printf(iterpool, "D   %s%s\n",
+                                   changed->path,
+                                   changed->replaced_kind == svn_node_dir
+                                     ? "/" : ""));
+
+      if (changed->change_kind == svn_fs_path_change_modify)
+        {
+          if ((! changed->text_mod) && (! changed->prop_mod))
+            continue;
+          if (changed->text_mod)
+            status[0] = 'U';
+          if (changed->prop_mod)
+            status[1] = 'U';
+        }
+      else
+        {
+          status[0] = 'A';
+          if (changed->copyfrom_path)
+            status[2] = '+';
+        }
+
+      SVN_ERR(svn_cmdline_printf(iterpool, "%s %s%s\n",
+                                 status, changed->path, dir_suffix));
+      if (changed->copyfrom_path)
+        /* Remove the leading slash from the copyfrom path for consistency
+           with the rest of the output. */
+        SVN_ERR(svn_cmdline_printf(iterpool, "    (from %s%s:r%ld)\n",
+                                   (changed->copyfrom_path[0] == '/'
+                                    ? changed->copyfrom_path + 1
+                                    : changed->copyfrom_path),
+                                   dir_suffix, changed->copyfrom_rev));
     }
   svn_pool_destroy(iterpool);
 
@@ -630,6 +790,8 @@ print_changed_tree(svn_repos_node_t *node,
 }
 
 
+/*** Tree Printing Routines ***/
+
 static svn_error_t *
 dump_contents(svn_stream_t *stream,
               svn_fs_root_t *root,
@@ -1372,16 +1534,15 @@ do_dirs_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
   svn_fs_root_t *root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  apr_array_header_t *changes;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_dirs_changed_tree(tree, "", pool));
+  SVN_ERR(get_changed_paths(&changes, root, base_rev_id, FALSE, pool, pool));
+  SVN_ERR(print_dirs_changed(changes, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1470,16 +1631,16 @@ do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
   svn_fs_root_t *root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  apr_array_header_t *changes;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_changed_tree(tree, "", c->copy_info, pool));
+  SVN_ERR(get_changed_paths(&changes, root, base_rev_id, c->copy_info,
+                            pool, pool));
+  SVN_ERR(print_changed(changes, c->copy_info, pool));
 
   return SVN_NO_ERROR;
 }
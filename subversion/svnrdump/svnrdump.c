@@ -31,6 +31,7 @@
 #include "svn_ra.h"
 #include "svn_repos.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 #include "svn_utf.h"
 #include "svn_private_config.h"
 #include "svn_string.h"
@@ -41,6 +42,8 @@
 #include "private/svn_repos_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 
 
@@ -66,6 +69,7 @@ enum svn_svnrdump__longopt_t
     opt_incremental,
     opt_trust_server_cert,
     opt_trust_server_cert_failures,
+    opt_jobs,
     opt_version
   };
 
@@ -85,8 +89,11 @@ static const svn_opt_subcommand_desc2_t svnrdump__cmd_table[] =
     N_("usage: svnrdump dump URL [-r LOWER[:UPPER]]\n\n"
        "Dump revisions LOWER to UPPER of repository at remote URL to stdout\n"
        "in a 'dumpfile' portable format.  If only LOWER is given, dump that\n"
-       "one revision.\n"),
-    { 'r', 'q', opt_incremental, SVN_SVNRDUMP__BASE_OPTIONS } },
+       "one revision.\n"
+       "\n"
+       "If --jobs is given, ranges of revisions will be fetched concurrently,\n"
+       "each over its own connection, and buffered in temporary files.\n"),
+    { 'r', 'q', opt_incremental, opt_jobs, SVN_SVNRDUMP__BASE_OPTIONS } },
   { "load", load_cmd, { 0 },
     N_("usage: svnrdump load URL\n\n"
        "Load a 'dumpfile' given on stdin to a repository at remote URL.\n"),
@@ -106,6 +113,8 @@ static const apr_getopt_option_t svnrdump__options[] =
                       N_("no progress (only errors) to stderr")},
     {"incremental",   opt_incremental, 0,
                       N_("dump incrementally")},
+    {"jobs",          opt_jobs, 1,
+                      N_("fetch up to ARG revision ranges concurrently")},
     {"skip-revprop",  opt_skip_revprop, 1,
                       N_("skip revision property ARG (e.g., \"svn:author\")")},
     {"config-dir",    opt_config_dir, 1,
@@ -167,6 +176,10 @@ struct replay_baton {
 
   /* Whether to be quiet. */
   svn_boolean_t quiet;
+
+  /* Cancellation callback for the dump editor. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
 };
 
 /* Option set */
@@ -180,6 +193,7 @@ typedef struct opt_baton_t {
   svn_opt_revision_t end_revision;
   svn_boolean_t quiet;
   svn_boolean_t incremental;
+  int jobs;
   apr_hash_t *skip_revprops;
 } opt_baton_t;
 
@@ -206,7 +220,8 @@ replay_revstart(svn_revnum_t revision,
 
   SVN_ERR(svn_rdump__get_dump_editor(editor, edit_baton, revision,
                                      rb->stdout_stream, rb->extra_ra_session,
-                                     NULL, check_cancel, NULL, pool));
+                                     NULL, rb->cancel_func, rb->cancel_baton,
+                                     pool));
 
   return SVN_NO_ERROR;
 }
@@ -256,7 +271,8 @@ replay_revstart_v2(svn_revnum_t revision,
   SVN_ERR(svn_rdump__get_dump_editor_v2(editor, revision,
                                         rb->stdout_stream,
                                         rb->extra_ra_session,
-                                        NULL, check_cancel, NULL, pool, pool));
+                                        NULL, rb->cancel_func,
+                                        rb->cancel_baton, pool, pool));
 
   return SVN_NO_ERROR;
 }
@@ -450,11 +466,266 @@ dump_initial_full_revision(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+#ifndef USE_EV2_IMPL
+
+/* Maximum number of revisions per range when dumping with --jobs. */
+#define DUMP_RANGE_SIZE 1000
+
+/* The RA sessions needed to dump a range of revisions. */
+typedef struct session_pair_t
+{
+  /* Opened at the URL being dumped. */
+  svn_ra_session_t *session;
+
+  /* Opened at the repository root. */
+  svn_ra_session_t *extra_ra_session;
+} session_pair_t;
+
+/* Session pairs for dumping ranges concurrently.  Each pair is used by
+ * one range at a time. */
+typedef struct dump_sessions_t
+{
+  svn_mutex__t *mutex;
+
+  /* The session_pair_t * not currently in use. */
+  apr_array_header_t *idle;
+} dump_sessions_t;
+
+/* Baton for dump_range(). */
+typedef struct range_baton_t
+{
+  dump_sessions_t *sessions;
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+} range_baton_t;
+
+/* A range of revisions dumped into a temporary file. */
+typedef struct dumped_range_t
+{
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+  const char *path;
+} dumped_range_t;
+
+/* Baton for write_range(). */
+typedef struct write_baton_t
+{
+  svn_stream_t *stdout_stream;
+  svn_boolean_t quiet;
+} write_baton_t;
+
+/* Pool cleanup function destroying the pool in DATA. */
+static apr_status_t
+destroy_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Take an idle session pair from SESSIONS and return it in *PAIR. */
+static svn_error_t *
+take_sessions(session_pair_t **pair,
+              dump_sessions_t *sessions)
+{
+  session_pair_t *idle = NULL;
+
+  SVN_ERR(svn_mutex__lock(sessions->mutex));
+  if (sessions->idle->nelts > 0)
+    idle = APR_ARRAY_IDX(sessions->idle, --sessions->idle->nelts,
+                         session_pair_t *);
+  SVN_ERR(svn_mutex__unlock(sessions->mutex, SVN_NO_ERROR));
+
+  /* There is one pair per thread that may be dumping. */
+  SVN_ERR_ASSERT(idle != NULL);
+
+  *pair = idle;
+  return SVN_NO_ERROR;
+}
+
+/* Return PAIR to the idle ones in SESSIONS and return ERR. */
+static svn_error_t *
+release_sessions(dump_sessions_t *sessions,
+                 session_pair_t *pair,
+                 svn_error_t *err)
+{
+  svn_error_t *lock_err = svn_mutex__lock(sessions->mutex);
+  if (lock_err)
+    return svn_error_compose_create(err, lock_err);
+
+  APR_ARRAY_PUSH(sessions->idle, session_pair_t *) = pair;
+
+  return svn_error_trace(svn_mutex__unlock(sessions->mutex, err));
+}
+
+/* Implements svn_task__process_func_t.  Dump the revisions given by the
+ * range_baton_t in BATON into a temporary file, which will be deleted
+ * when RESULT_POOL gets cleaned up, and return a dumped_range_t for it.
+ * This may run in any thread. */
+static svn_error_t *
+dump_range(void **result,
+           void *baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  range_baton_t *range = baton;
+  dumped_range_t *dumped = apr_pcalloc(result_pool, sizeof(*dumped));
+  struct replay_baton *replay_baton;
+  session_pair_t *pair;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  dumped->start_revision = range->start_revision;
+  dumped->end_revision = range->end_revision;
+  SVN_ERR(svn_stream_open_unique(&stream, &dumped->path, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+
+  /* Progress gets reported when the range has been written to stdout. */
+  replay_baton = apr_pcalloc(scratch_pool, sizeof(*replay_baton));
+  replay_baton->stdout_stream = stream;
+  replay_baton->quiet = TRUE;
+  replay_baton->cancel_func = cancel_func;
+  replay_baton->cancel_baton = cancel_baton;
+
+  SVN_ERR(take_sessions(&pair, range->sessions));
+  replay_baton->extra_ra_session = pair->extra_ra_session;
+  err = svn_ra_replay_range(pair->session, range->start_revision,
+                            range->end_revision, 0, TRUE, replay_revstart,
+                            replay_revend, replay_baton, scratch_pool);
+  SVN_ERR(release_sessions(range->sessions, pair, err));
+
+  SVN_ERR(svn_stream_close(stream));
+
+  *result = dumped;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Append the dumped_range_t in
+ * RESULT to the output stream in the write_baton_t in BATON. */
+static svn_error_t *
+write_range(void *result,
+            void *baton,
+            apr_pool_t *scratch_pool)
+{
+  dumped_range_t *dumped = result;
+  write_baton_t *wb = baton;
+  svn_stream_t *stream;
+  svn_revnum_t revision;
+
+  SVN_ERR(svn_stream_open_readonly(&stream, dumped->path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_copy3(stream,
+                           svn_stream_disown(wb->stdout_stream, scratch_pool),
+                           check_cancel, NULL, scratch_pool));
+
+  if (! wb->quiet)
+    for (revision = dumped->start_revision;
+         revision <= dumped->end_revision;
+         revision++)
+      SVN_ERR(svn_cmdline_fprintf(stderr, scratch_pool,
+                                  "* Dumped revision %lu.\n", revision));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_replay_range() with the replay callbacks and REPLAY_BATON,
+ * dump revisions START_REVISION thru END_REVISION using SESSION and
+ * EXTRA_RA_SESSION.  But split them into ranges and replay up to JOBS
+ * of those concurrently, each over its own pair of sessions.  Buffer
+ * the ranges in temporary files until they can be written out in
+ * order; the number of those files is limited.
+ *
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+replay_ranges(svn_ra_session_t *session,
+              svn_ra_session_t *extra_ra_session,
+              struct replay_baton *replay_baton,
+              svn_revnum_t start_revision,
+              svn_revnum_t end_revision,
+              int jobs,
+              apr_pool_t *pool)
+{
+  dump_sessions_t *sessions = apr_pcalloc(pool, sizeof(*sessions));
+  write_baton_t *wb = apr_pcalloc(pool, sizeof(*wb));
+  svn_revnum_t range_size;
+  svn_revnum_t revision;
+  svn_task__set_t *set;
+  apr_pool_t *set_pool;
+  int i;
+
+  /* Make sure all jobs get something to do, even for short ranges. */
+  range_size = (end_revision - start_revision + 1 + jobs - 1) / jobs;
+  range_size = MIN(range_size, DUMP_RANGE_SIZE);
+
+  SVN_ERR(svn_mutex__init(&sessions->mutex, TRUE, pool));
+
+  /* While waiting for results, this thread helps with the dumping.
+   * Hence the extra pair of sessions.
+   *
+   * The sessions may be used by any thread, so they must not share a
+   * (non thread-safe) allocator with POOL. */
+  sessions->idle = apr_array_make(pool, jobs + 1, sizeof(session_pair_t *));
+  for (i = 0; i <= jobs; i++)
+    {
+      apr_pool_t *session_pool = svn_pool_create(NULL);
+      session_pair_t *pair = apr_pcalloc(session_pool, sizeof(*pair));
+      svn_revnum_t youngest;
+
+      apr_pool_cleanup_register(pool, session_pool, destroy_pool,
+                                apr_pool_cleanup_null);
+      SVN_ERR(svn_ra__dup_session(&pair->session, session, NULL,
+                                  session_pool, pool));
+      SVN_ERR(svn_ra__dup_session(&pair->extra_ra_session, extra_ra_session,
+                                  NULL, session_pool, pool));
+
+      /* Make sure that any authentication happens here.  The sessions
+       * share the auth baton, which must not be used concurrently. */
+      SVN_ERR(svn_ra_get_latest_revnum(pair->session, &youngest, pool));
+      SVN_ERR(svn_ra_get_latest_revnum(pair->extra_ra_session, &youngest,
+                                       pool));
+
+      APR_ARRAY_PUSH(sessions->idle, session_pair_t *) = pair;
+    }
+
+  wb->stdout_stream = replay_baton->stdout_stream;
+  wb->quiet = replay_baton->quiet;
+
+  /* Sub-pools get destroyed before the cleanups above run.  So, upon
+   * error, the task set will be done with all sessions before they go. */
+  set_pool = svn_pool_create(pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, write_range, wb,
+                               check_cancel, NULL, set_pool));
+
+  for (revision = start_revision;
+       revision <= end_revision;
+       revision += range_size)
+    {
+      range_baton_t *range = apr_palloc(pool, sizeof(*range));
+
+      range->sessions = sessions;
+      range->start_revision = revision;
+      range->end_revision = MIN(revision + range_size - 1, end_revision);
+
+      SVN_ERR(svn_task__add(set, dump_range, range));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 /* Replay revisions START_REVISION thru END_REVISION (inclusive) of
  * the repository URL at which SESSION is rooted, using callbacks
  * which generate Subversion repository dumpstreams describing the
  * changes made in those revisions.  If QUIET is set, don't generate
- * progress messages.
+ * progress messages.  With JOBS > 1, replay up to that many ranges of
+ * revisions concurrently.
  */
 static svn_error_t *
 replay_revisions(svn_ra_session_t *session,
@@ -463,6 +734,7 @@ replay_revisions(svn_ra_session_t *session,
                  svn_revnum_t end_revision,
                  svn_boolean_t quiet,
                  svn_boolean_t incremental,
+                 int jobs,
                  apr_pool_t *pool)
 {
   struct replay_baton *replay_baton;
@@ -475,6 +747,7 @@ replay_revisions(svn_ra_session_t *session,
   replay_baton->stdout_stream = stdout_stream;
   replay_baton->extra_ra_session = extra_ra_session;
   replay_baton->quiet = quiet;
+  replay_baton->cancel_func = check_cancel;
 
   /* Write the magic header and UUID */
   SVN_ERR(svn_stream_printf(stdout_stream, pool,
@@ -515,9 +788,15 @@ replay_revisions(svn_ra_session_t *session,
   if (start_revision <= end_revision)
     {
 #ifndef USE_EV2_IMPL
-      SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
-                                  0, TRUE, replay_revstart, replay_revend,
-                                  replay_baton, pool));
+      /* Concurrent replays need worker threads. */
+      if (jobs > 1 && end_revision > start_revision
+          && svn_task__get_thread_limit() > 0)
+        SVN_ERR(replay_ranges(session, extra_ra_session, replay_baton,
+                              start_revision, end_revision, jobs, pool));
+      else
+        SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
+                                    0, TRUE, replay_revstart, replay_revend,
+                                    replay_baton, pool));
 #else
       SVN_ERR(svn_ra__replay_range_ev2(session, start_revision, end_revision,
                                        0, TRUE, replay_revstart_v2,
@@ -616,7 +895,8 @@ dump_cmd(apr_getopt_t *os,
   return replay_revisions(opt_baton->session, extra_ra_session,
                           opt_baton->start_revision.value.number,
                           opt_baton->end_revision.value.number,
-                          opt_baton->quiet, opt_baton->incremental, pool);
+                          opt_baton->quiet, opt_baton->incremental,
+                          opt_baton->jobs, pool);
 }
 
 /* Handle the "load" subcommand.  Implements `svn_opt_subcommand_t'.  */
@@ -862,6 +1142,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case opt_incremental:
           opt_baton->incremental = TRUE;
           break;
+        case opt_jobs:
+          SVN_ERR(svn_cstring_atoi(&opt_baton->jobs, opt_arg));
+          if (opt_baton->jobs < 1)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid number of jobs '%s'"),
+                                     opt_arg);
+          break;
         case opt_skip_revprop:
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
           svn_hash_sets(opt_baton->skip_revprops, opt_arg, opt_arg);
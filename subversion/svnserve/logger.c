@@ -33,6 +33,11 @@
 
 #include "private/svn_mutex.h"
 
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+#endif
+
 #include "svn_private_config.h"
 #include "logger.h"
 
@@ -50,6 +55,32 @@ struct logger_t
 
   /* private pool used for temporary allocations */
   apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  /* Ring buffer of BUFFER_SIZE bytes holding USED bytes of log data,
+     starting at offset START, that the flusher thread has yet to write
+     to STREAM.  BUFFER is NULL while writing synchronously. */
+  char *buffer;
+  apr_size_t buffer_size;
+  apr_size_t start;
+  apr_size_t used;
+
+  /* Drop log data instead of waiting for the flusher if BUFFER is full.
+     DROPPED counts the lines dropped but not reported yet. */
+  svn_boolean_t drop;
+  apr_uint64_t dropped;
+
+  /* Signaled whenever data has been added resp. flushed. */
+  apr_thread_cond_t *data_added;
+  apr_thread_cond_t *data_flushed;
+
+  /* Tells the flusher to write the remaining data and terminate. */
+  svn_boolean_t shutdown;
+
+  /* The flusher and the root pool it has been allocated in. */
+  apr_thread_t *flusher;
+  apr_pool_t *flusher_pool;
+#endif
 };
 
 svn_error_t *
@@ -88,6 +119,216 @@ logger__create(logger_t **logger,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Thread body: Write the buffered data of the logger_t in DATA to its
+   stream until told to shut down. */
+static void * APR_THREAD_FUNC
+flush_thread(apr_thread_t *tid,
+             void *data)
+{
+  logger_t *logger = data;
+  apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+
+  /* If locking fails, writers may block forever.  There is no way to
+     tell them what the problem was. */
+  if (apr_thread_mutex_lock(mutex))
+    {
+      apr_thread_exit(tid, APR_SUCCESS);
+      return NULL;
+    }
+
+  while (TRUE)
+    {
+      apr_size_t len;
+      apr_uint64_t dropped;
+
+      while (!logger->used && !logger->dropped && !logger->shutdown)
+        apr_thread_cond_wait(logger->data_added, mutex);
+
+      if (!logger->used && !logger->dropped)
+        break;
+
+      /* Writers only ever touch the free part of the ring buffer, so we
+         may write the contiguous chunk at its start without the lock. */
+      len = logger->buffer_size - logger->start;
+      if (len > logger->used)
+        len = logger->used;
+      dropped = logger->dropped;
+      logger->dropped = 0;
+
+      apr_thread_mutex_unlock(mutex);
+
+      if (len)
+        {
+          apr_size_t written = len;
+          svn_error_clear(svn_stream_write(logger->stream,
+                                           logger->buffer + logger->start,
+                                           &written));
+        }
+
+      if (dropped)
+        {
+          char note[64];
+          apr_size_t note_len
+            = apr_snprintf(note, sizeof(note),
+                           "%" APR_PID_T_FMT " %" APR_UINT64_T_FMT
+                           " log lines dropped" APR_EOL_STR,
+                           getpid(), dropped);
+          svn_error_clear(svn_stream_write(logger->stream, note, &note_len));
+        }
+
+      if (apr_thread_mutex_lock(mutex))
+        {
+          apr_thread_exit(tid, APR_SUCCESS);
+          return NULL;
+        }
+
+      logger->start = (logger->start + len) % logger->buffer_size;
+      logger->used -= len;
+      apr_thread_cond_broadcast(logger->data_flushed);
+    }
+
+  apr_thread_mutex_unlock(mutex);
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Pool cleanup function for the logger_t in DATA.  Waits for the flusher
+   to write all buffered data and terminates it. */
+static apr_status_t
+flusher_cleanup(void *data)
+{
+  logger_t *logger = data;
+  apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+  apr_status_t ignored;
+
+  if (apr_thread_mutex_lock(mutex) == APR_SUCCESS)
+    {
+      logger->shutdown = TRUE;
+      apr_thread_cond_signal(logger->data_added);
+      apr_thread_mutex_unlock(mutex);
+    }
+
+  apr_thread_join(&ignored, logger->flusher);
+  svn_pool_destroy(logger->flusher_pool);
+
+  /* Anything written from now on goes directly to the stream. */
+  logger->buffer = NULL;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+logger__start_flusher(logger_t *logger,
+                      apr_size_t buffer_size,
+                      svn_boolean_t drop,
+                      apr_pool_t *pool)
+{
+  /* Objects used from multiple threads must live in a thread-safe pool.
+     The root pools give us exactly that. */
+  apr_pool_t *flusher_pool = svn_pool_create(NULL);
+  apr_status_t status;
+
+  status = apr_thread_cond_create(&logger->data_added, flusher_pool);
+  if (!status)
+    status = apr_thread_cond_create(&logger->data_flushed, flusher_pool);
+  if (status)
+    {
+      svn_pool_destroy(flusher_pool);
+      return svn_error_wrap_apr(status,
+                                _("Can't create condition variable"));
+    }
+
+  logger->buffer = apr_palloc(flusher_pool, buffer_size);
+  logger->buffer_size = buffer_size;
+  logger->start = 0;
+  logger->used = 0;
+  logger->drop = drop;
+  logger->dropped = 0;
+  logger->shutdown = FALSE;
+  logger->flusher_pool = flusher_pool;
+
+  status = apr_thread_create(&logger->flusher, NULL, flush_thread, logger,
+                             flusher_pool);
+  if (status)
+    {
+      logger->buffer = NULL;
+      svn_pool_destroy(flusher_pool);
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  apr_pool_cleanup_register(pool, logger, flusher_cleanup,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append LEN bytes from DATA to the ring buffer of LOGGER.  The caller
+   must hold the LOGGER's mutex. */
+static svn_error_t *
+buffer_locked(logger_t *logger,
+              const char *data,
+              apr_size_t len)
+{
+  apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+
+  if (logger->drop && len > logger->buffer_size - logger->used)
+    {
+      logger->dropped++;
+      apr_thread_cond_signal(logger->data_added);
+      return SVN_NO_ERROR;
+    }
+
+  /* Lines longer than the whole buffer get added in pieces. */
+  while (len)
+    {
+      apr_size_t end, chunk;
+
+      while (logger->used == logger->buffer_size)
+        {
+          apr_status_t status = apr_thread_cond_wait(logger->data_flushed,
+                                                     mutex);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't wait on condition variable"));
+        }
+
+      end = (logger->start + logger->used) % logger->buffer_size;
+      chunk = logger->buffer_size - logger->used;
+      if (chunk > logger->buffer_size - end)
+        chunk = logger->buffer_size - end;
+      if (chunk > len)
+        chunk = len;
+
+      memcpy(logger->buffer + end, data, chunk);
+      logger->used += chunk;
+      data += chunk;
+      len -= chunk;
+
+      apr_thread_cond_signal(logger->data_added);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+/* Write LEN bytes from DATA to LOGGER, either directly or through the
+   flusher's buffer.  The caller must hold the LOGGER's mutex. */
+static svn_error_t *
+write_locked(logger_t *logger,
+             const char *data,
+             apr_size_t len)
+{
+#if APR_HAS_THREADS
+  if (logger->buffer)
+    return svn_error_trace(buffer_locked(logger, data, len));
+#endif
+
+  return svn_error_trace(svn_stream_write(logger->stream, data, &len));
+}
+
 void
 logger__log_error(logger_t *logger,
                   svn_error_t *err,
@@ -138,7 +379,7 @@ logger__log_error(logger_t *logger,
           memcpy(errstr + len, APR_EOL_STR, sizeof(APR_EOL_STR));
           len += sizeof(APR_EOL_STR) -1;  /* add NL, ex terminating NUL */
 
-          svn_error_clear(svn_stream_write(logger->stream, errstr, &len));
+          svn_error_clear(write_locked(logger, errstr, len));
 
           continuation = "-";
           err = err->child;
@@ -155,7 +396,6 @@ logger__write(logger_t *logger,
               const char *errstr,
               apr_size_t len)
 {
-  SVN_MUTEX__WITH_LOCK(logger->mutex,
-                       svn_stream_write(logger->stream, errstr, &len));
+  SVN_MUTEX__WITH_LOCK(logger->mutex, write_locked(logger, errstr, len));
   return SVN_NO_ERROR;
 }
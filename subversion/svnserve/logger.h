@@ -54,6 +54,24 @@ logger__create(logger_t **logger,
                const char *filename,
                apr_pool_t *pool);
 
+#if APR_HAS_THREADS
+/* Make LOGGER hand all further log data to a background thread that
+ * writes it to the log file, such that writers merely copy it into a
+ * ring buffer of BUFFER_SIZE bytes.  If the buffer is full, writers wait
+ * for the thread to catch up, unless DROP is set, in which case the data
+ * gets dropped and a note about it written to the log file later.
+ * The thread writes all remaining data and terminates when POOL gets
+ * cleared or destroyed.
+ *
+ * Call this only after the process has been daemonized.
+ */
+svn_error_t *
+logger__start_flusher(logger_t *logger,
+                      apr_size_t buffer_size,
+                      svn_boolean_t drop,
+                      apr_pool_t *pool);
+#endif
+
 /* Write the first LEN bytes from ERRSTR to the log file managed by LOGGER.
  */
 svn_error_t *
@@ -0,0 +1,550 @@
+/*
+ * metrics.c : Counters and histograms exported by svnserve
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "metrics.h"
+
+/* Upper bounds of the command latency histogram buckets.  The implicit
+ * last bucket is "+Inf". */
+static const struct
+{
+  apr_interval_time_t bound;
+  const char *label;
+} latency_buckets[] =
+{
+  {     1000, "0.001" },
+  {     5000, "0.005" },
+  {    10000, "0.01" },
+  {    50000, "0.05" },
+  {   100000, "0.1" },
+  {   500000, "0.5" },
+  {  1000000, "1" },
+  {  5000000, "5" },
+  { 10000000, "10" },
+  { 60000000, "60" }
+};
+
+#define BUCKET_COUNT (sizeof(latency_buckets) / sizeof(latency_buckets[0]))
+
+/* Everything we know about one type of command. */
+typedef struct command_metrics_t
+{
+  /* Number of executions per latency bucket; not cumulative.  The last
+     element counts those that exceeded all bounds. */
+  apr_uint64_t buckets[BUCKET_COUNT + 1];
+
+  /* Number of executions and their total duration. */
+  apr_uint64_t count;
+  apr_interval_time_t duration;
+
+  /* Bytes received from and sent to the clients. */
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+} command_metrics_t;
+
+struct metrics_t
+{
+  /* serializes all access to COMMANDS and POOL */
+  svn_mutex__t *mutex;
+
+  /* const char * command name -> command_metrics_t * */
+  apr_hash_t *commands;
+
+  /* Number of connections ever opened and of those still open. */
+  volatile svn_atomic_t connections;
+  volatile svn_atomic_t active_connections;
+
+#if APR_HAS_THREADS
+  /* The thread pool serving the connections; may be NULL. */
+  apr_thread_pool_t *threads;
+#endif
+
+  /* private root pool for entries added to COMMANDS */
+  apr_pool_t *pool;
+};
+
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                apr_pool_t *pool)
+{
+  metrics_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  /* Entries are added from whichever thread executes the command, so
+     keep them out of POOL. */
+  result->pool = svn_pool_create(NULL);
+  result->commands = svn_hash__make(result->pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+  *metrics = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function decrementing the number of active connections
+ * in the metrics_t BATON. */
+static apr_status_t
+connection_closed(void *baton)
+{
+  metrics_t *metrics = baton;
+  svn_atomic_dec(&metrics->active_connections);
+
+  return APR_SUCCESS;
+}
+
+void
+metrics__connection_opened(metrics_t *metrics,
+                           apr_pool_t *connection_pool)
+{
+  if (metrics == NULL)
+    return;
+
+  svn_atomic_inc(&metrics->connections);
+  svn_atomic_inc(&metrics->active_connections);
+  apr_pool_cleanup_register(connection_pool, metrics, connection_closed,
+                            apr_pool_cleanup_null);
+}
+
+/* Add STATS to the respective entry in METRICS.
+ *
+ * Requires external serialization on METRICS.
+ */
+static svn_error_t *
+record_command(metrics_t *metrics,
+               const svn_ra_svn__command_stats_t *stats)
+{
+  command_metrics_t *command = svn_hash_gets(metrics->commands,
+                                             stats->cmdname);
+  apr_size_t i;
+
+  if (command == NULL)
+    {
+      command = apr_pcalloc(metrics->pool, sizeof(*command));
+      svn_hash_sets(metrics->commands,
+                    apr_pstrdup(metrics->pool, stats->cmdname), command);
+    }
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    if (stats->duration <= latency_buckets[i].bound)
+      break;
+
+  command->buckets[i]++;
+  command->count++;
+  command->duration += stats->duration;
+  command->bytes_in += stats->bytes_in;
+  command->bytes_out += stats->bytes_out;
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around record_command. */
+static svn_error_t *
+command_done(metrics_t *metrics,
+             const svn_ra_svn__command_stats_t *stats)
+{
+  SVN_MUTEX__WITH_LOCK(metrics->mutex, record_command(metrics, stats));
+
+  return SVN_NO_ERROR;
+}
+
+void
+metrics__command_done(metrics_t *metrics,
+                      const svn_ra_svn__command_stats_t *stats)
+{
+  if (metrics == NULL || stats->cmdname == NULL)
+    return;
+
+  /* Metrics are not worth failing a client request for. */
+  svn_error_clear(command_done(metrics, stats));
+}
+
+#if APR_HAS_THREADS
+
+void
+metrics__set_thread_pool(metrics_t *metrics,
+                         apr_thread_pool_t *threads)
+{
+  metrics->threads = threads;
+}
+
+/* Append the HELP and TYPE lines for metric NAME to BUFFER. */
+static void
+append_header(svn_stringbuf_t *buffer,
+              const char *name,
+              const char *type,
+              const char *help,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(pool, "# HELP %s %s\n# TYPE %s %s\n",
+                                        name, help, name, type));
+}
+
+/* Append a sample line for metric NAME with LABELS (may be NULL) and
+ * VALUE to BUFFER. */
+static void
+append_value(svn_stringbuf_t *buffer,
+             const char *name,
+             const char *labels,
+             apr_uint64_t value,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(pool,
+                                        "%s%s%s%s %" APR_UINT64_T_FMT "\n",
+                                        name,
+                                        labels ? "{" : "",
+                                        labels ? labels : "",
+                                        labels ? "}" : "",
+                                        value));
+}
+
+/* Append the per-command metrics from METRICS to BUFFER.
+ *
+ * Requires external serialization on METRICS.
+ */
+static svn_error_t *
+append_commands(svn_stringbuf_t *buffer,
+                metrics_t *metrics,
+                apr_pool_t *pool)
+{
+  static const char duration_name[] = "svnserve_command_duration_seconds";
+  static const char in_name[] = "svnserve_command_received_bytes_total";
+  static const char out_name[] = "svnserve_command_sent_bytes_total";
+
+  apr_array_header_t *sorted
+    = svn_sort__hash(metrics->commands, svn_sort_compare_items_lexically,
+                     pool);
+  int i;
+
+  append_header(buffer, duration_name, "histogram",
+                "Time spent executing client commands.", pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const command_metrics_t *command = item->value;
+      const char *label = apr_psprintf(pool, "command=\"%s\"",
+                                       (const char *)item->key);
+      apr_uint64_t cumulative = 0;
+      apr_size_t k;
+
+      for (k = 0; k < BUCKET_COUNT; ++k)
+        {
+          cumulative += command->buckets[k];
+          svn_stringbuf_appendcstr(buffer,
+                                   apr_psprintf(pool,
+                                                "%s_bucket{%s,le=\"%s\"} %"
+                                                APR_UINT64_T_FMT "\n",
+                                                duration_name, label,
+                                                latency_buckets[k].label,
+                                                cumulative));
+        }
+
+      svn_stringbuf_appendcstr(buffer,
+                               apr_psprintf(pool,
+                                            "%s_bucket{%s,le=\"+Inf\"} %"
+                                            APR_UINT64_T_FMT "\n"
+                                            "%s_sum{%s} %" APR_INT64_T_FMT
+                                            ".%06" APR_INT64_T_FMT "\n",
+                                            duration_name, label,
+                                            command->count,
+                                            duration_name, label,
+                                            (apr_int64_t)command->duration
+                                              / APR_USEC_PER_SEC,
+                                            (apr_int64_t)command->duration
+                                              % APR_USEC_PER_SEC));
+      append_value(buffer,
+                   apr_pstrcat(pool, duration_name, "_count", SVN_VA_NULL),
+                   label, command->count, pool);
+    }
+
+  append_header(buffer, in_name, "counter",
+                "Bytes received while handling client commands.", pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const command_metrics_t *command = item->value;
+      append_value(buffer, in_name,
+                   apr_psprintf(pool, "command=\"%s\"",
+                                (const char *)item->key),
+                   command->bytes_in, pool);
+    }
+
+  append_header(buffer, out_name, "counter",
+                "Bytes sent while handling client commands.", pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const command_metrics_t *command = item->value;
+      append_value(buffer, out_name,
+                   apr_psprintf(pool, "command=\"%s\"",
+                                (const char *)item->key),
+                   command->bytes_out, pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the state of the thread pool in METRICS to BUFFER. */
+static void
+append_threads(svn_stringbuf_t *buffer,
+               metrics_t *metrics,
+               apr_pool_t *pool)
+{
+  apr_thread_pool_t *threads = metrics->threads;
+  if (threads == NULL)
+    return;
+
+  append_header(buffer, "svnserve_threads_max", "gauge",
+                "Maximum number of threads serving connections.", pool);
+  append_value(buffer, "svnserve_threads_max", NULL,
+               apr_thread_pool_thread_max_get(threads), pool);
+  append_header(buffer, "svnserve_threads", "gauge",
+                "Number of threads serving connections.", pool);
+  append_value(buffer, "svnserve_threads", NULL,
+               apr_thread_pool_threads_count(threads), pool);
+  append_header(buffer, "svnserve_threads_busy", "gauge",
+                "Number of threads currently serving a connection.", pool);
+  append_value(buffer, "svnserve_threads_busy", NULL,
+               apr_thread_pool_busy_count(threads), pool);
+  append_header(buffer, "svnserve_tasks_queued", "gauge",
+                "Number of connections waiting for a thread.", pool);
+  append_value(buffer, "svnserve_tasks_queued", NULL,
+               apr_thread_pool_tasks_count(threads), pool);
+}
+
+/* Append the statistics of the global membuffer cache to BUFFER. */
+static void
+append_cache(svn_stringbuf_t *buffer,
+             apr_pool_t *pool)
+{
+  svn_cache__info_t *info;
+
+  /* There is no cache to report on if it has been disabled. */
+  if (svn_cache__get_global_membuffer_cache() == NULL)
+    return;
+
+  info = svn_cache__membuffer_get_global_info(pool);
+
+  append_header(buffer, "svnserve_cache_gets_total", "counter",
+                "Lookups in the in-memory cache.", pool);
+  append_value(buffer, "svnserve_cache_gets_total", NULL, info->gets, pool);
+  append_header(buffer, "svnserve_cache_hits_total", "counter",
+                "Lookups in the in-memory cache that found data.", pool);
+  append_value(buffer, "svnserve_cache_hits_total", NULL, info->hits, pool);
+  append_header(buffer, "svnserve_cache_sets_total", "counter",
+                "Items added to the in-memory cache.", pool);
+  append_value(buffer, "svnserve_cache_sets_total", NULL, info->sets, pool);
+  append_header(buffer, "svnserve_cache_hit_ratio", "gauge",
+                "Share of in-memory cache lookups that found data.", pool);
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(pool, "svnserve_cache_hit_ratio %f\n",
+                                        info->gets
+                                          ? (double)info->hits / info->gets
+                                          : 0.0));
+  append_header(buffer, "svnserve_cache_used_bytes", "gauge",
+                "Size of the data in the in-memory cache.", pool);
+  append_value(buffer, "svnserve_cache_used_bytes", NULL, info->used_size,
+               pool);
+  append_header(buffer, "svnserve_cache_size_bytes", "gauge",
+                "Total size of the in-memory cache.", pool);
+  append_value(buffer, "svnserve_cache_size_bytes", NULL, info->total_size,
+               pool);
+  append_header(buffer, "svnserve_cache_entries", "gauge",
+                "Number of items in the in-memory cache.", pool);
+  append_value(buffer, "svnserve_cache_entries", NULL, info->used_entries,
+               pool);
+}
+
+/* Return the contents of METRICS in the Prometheus text exposition
+ * format in *BUFFER, allocated in POOL. */
+static svn_error_t *
+render_metrics(svn_stringbuf_t **buffer,
+               metrics_t *metrics,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(4096, pool);
+
+  SVN_MUTEX__WITH_LOCK(metrics->mutex,
+                       append_commands(result, metrics, pool));
+
+  append_header(result, "svnserve_connections_total", "counter",
+                "Client connections opened.", pool);
+  append_value(result, "svnserve_connections_total", NULL,
+               svn_atomic_read(&metrics->connections), pool);
+  append_header(result, "svnserve_connections_active", "gauge",
+                "Client connections currently open.", pool);
+  append_value(result, "svnserve_connections_active", NULL,
+               svn_atomic_read(&metrics->active_connections), pool);
+
+  append_threads(result, metrics, pool);
+  append_cache(result, pool);
+
+  *buffer = result;
+  return SVN_NO_ERROR;
+}
+
+/* Send all LEN bytes of DATA over SOCK. */
+static svn_error_t *
+send_all(apr_socket_t *sock,
+         const char *data,
+         apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t written = len;
+      apr_status_t status = apr_socket_send(sock, data, &written);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      data += written;
+      len -= written;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the HTTP request from CLIENT and answer it with METRICS.  Use
+ * POOL for allocations. */
+static svn_error_t *
+answer_request(metrics_t *metrics,
+               apr_socket_t *client,
+               apr_pool_t *pool)
+{
+  char request[4096];
+  apr_size_t request_len = 0;
+  svn_stringbuf_t *body;
+  const char *header;
+
+  /* Don't let stalled scrapers block the listener forever. */
+  apr_socket_timeout_set(client, apr_time_from_sec(10));
+
+  /* Every path gets the same answer, so we only need to wait for the
+     end of the request header.  Not reading it would reset the
+     connection when we close it. */
+  while (request_len < sizeof(request) - 1)
+    {
+      apr_size_t len = sizeof(request) - 1 - request_len;
+      apr_status_t status = apr_socket_recv(client, request + request_len,
+                                            &len);
+      request_len += len;
+      request[request_len] = '\0';
+      if (status || strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+        break;
+    }
+
+  SVN_ERR(render_metrics(&body, metrics, pool));
+  header = apr_psprintf(pool,
+                        "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: %" APR_SIZE_T_FMT "\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        body->len);
+
+  SVN_ERR(send_all(client, header, strlen(header)));
+  return svn_error_trace(send_all(client, body->data, body->len));
+}
+
+/* Baton for the listener thread. */
+typedef struct listener_baton_t
+{
+  metrics_t *metrics;
+  apr_socket_t *sock;
+} listener_baton_t;
+
+/* Thread function serving the requests for the listener_baton_t DATA
+ * one at a time. */
+static void * APR_THREAD_FUNC
+serve_metrics(apr_thread_t *tid, void *data)
+{
+  listener_baton_t *baton = data;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  while (1)
+    {
+      apr_socket_t *client;
+      apr_status_t status;
+
+      svn_pool_clear(iterpool);
+      status = apr_socket_accept(&client, baton->sock, iterpool);
+      if (status)
+        {
+          if (APR_STATUS_IS_EINTR(status)
+              || APR_STATUS_IS_ECONNABORTED(status)
+              || APR_STATUS_IS_ECONNRESET(status))
+            continue;
+
+          break;
+        }
+
+      svn_error_clear(answer_request(baton->metrics, client, iterpool));
+      apr_socket_close(client);
+    }
+
+  svn_pool_destroy(iterpool);
+  return NULL;
+}
+
+svn_error_t *
+metrics__start_listener(metrics_t *metrics,
+                        apr_socket_t *sock,
+                        apr_pool_t *pool)
+{
+  listener_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+  apr_threadattr_t *attr;
+  apr_thread_t *tid;
+  apr_status_t status;
+
+  baton->metrics = metrics;
+  baton->sock = sock;
+
+  status = apr_threadattr_create(&attr, pool);
+  if (!status)
+    status = apr_threadattr_detach_set(attr, 1);
+  if (!status)
+    status = apr_thread_create(&tid, attr, serve_metrics, baton, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * metrics.h : Public definitions for the svnserve metrics listener
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <apr_network_io.h>
+#include <apr_thread_pool.h>
+
+#include "private/svn_ra_svn_private.h"
+
+#include "server.h"
+
+
+
+/* Opaque collection of server-wide counters and histograms.  It may be
+ * updated and read from multiple threads within the same process.
+ *
+ * All functions updating the metrics are no-ops for a NULL METRICS.
+ */
+typedef struct metrics_t metrics_t;
+
+/* In POOL, create an empty metrics collection and return it in *METRICS.
+ */
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                apr_pool_t *pool);
+
+/* Record in METRICS that a client connection has been opened.  It
+ * counts as active until CONNECTION_POOL gets cleaned up.
+ */
+void
+metrics__connection_opened(metrics_t *metrics,
+                           apr_pool_t *connection_pool);
+
+/* Record the command described by STATS in METRICS.  Does nothing if
+ * no command has been executed.
+ */
+void
+metrics__command_done(metrics_t *metrics,
+                      const svn_ra_svn__command_stats_t *stats);
+
+#if APR_HAS_THREADS
+
+/* Make METRICS report the utilization of THREADS, the thread pool
+ * serving the client connections.
+ */
+void
+metrics__set_thread_pool(metrics_t *metrics,
+                         apr_thread_pool_t *threads);
+
+/* Start a thread that accepts HTTP requests on the listening socket
+ * SOCK and answers each with the current contents of METRICS in the
+ * Prometheus text exposition format.  POOL must live as long as the
+ * server.
+ */
+svn_error_t *
+metrics__start_listener(metrics_t *metrics,
+                        apr_socket_t *sock,
+                        apr_pool_t *pool);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* METRICS_H */
@@ -55,6 +55,9 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -62,6 +65,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
 
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
@@ -416,6 +420,31 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* Return the user name to use for authz purposes for the client
+   described in B.  That is the authenticated user name with any
+   username case normalization applied or NULL for anonymous access. */
+static const char *get_authz_user(server_baton_t *b)
+{
+  repository_t *repository = b->repository;
+  client_info_t *client_info = b->client_info;
+
+  /* If we have a username, and we've not yet used it + any username
+     case normalization that might be requested to determine "the
+     username we used for authz purposes", do so now. */
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+
+  return client_info->authz_user;
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -427,7 +456,6 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
-  client_info_t *client_info = b->client_info;
 
   /* If authz cannot be performed, grant access.  This is NOT the same
      as the default policy when authz is performed on a path with no
@@ -448,23 +476,9 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path && *path != '/')
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
-
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
-                                       path, client_info->authz_user,
+                                       path, get_authz_user(b),
                                        required, allowed, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
@@ -472,6 +486,38 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   return SVN_NO_ERROR;
 }
 
+/* Like authz_check_access but check all PATHS (const char *, all
+   absolute) at once and set the respective elements in ALLOWED.
+   Use POOL for temporary allocations only. */
+static svn_error_t *authz_check_access_many(svn_boolean_t *allowed,
+                                            const apr_array_header_t *paths,
+                                            svn_repos_authz_access_t required,
+                                            server_baton_t *b,
+                                            apr_pool_t *pool)
+{
+  repository_t *repository = b->repository;
+  int i;
+
+  if (!repository->authzdb)
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_repos_authz_check_access_many(repository->authzdb,
+                                            repository->authz_repos_name,
+                                            paths, get_authz_user(b),
+                                            required, allowed, pool));
+  for (i = 0; i < paths->nelts; ++i)
+    if (!allowed[i])
+      SVN_ERR(log_authz_denied(APR_ARRAY_IDX(paths, i, const char *),
+                               required, b, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Set *ALLOWED to TRUE if PATH is readable by the user described in
  * BATON.  Use POOL for temporary allocations only.  ROOT is not used.
  * Implements the svn_repos_authz_func_t interface.
@@ -773,6 +819,40 @@ static svn_boolean_t lookup_access(apr_pool_t *pool,
   return FALSE;
 }
 
+/* Like lookup_access but check all PATHS (const char *) at once and set
+ * the respective elements in ALLOWED.  No username is required.
+ *
+ * Use POOL for temporary allocations only.
+ */
+static void lookup_access_many(apr_pool_t *pool,
+                               server_baton_t *baton,
+                               svn_repos_authz_access_t required,
+                               const apr_array_header_t *paths,
+                               svn_boolean_t *allowed)
+{
+  enum access_type req = (required & svn_authz_write) ?
+    WRITE_ACCESS : READ_ACCESS;
+  svn_boolean_t blanket_access = current_access(baton) >= req;
+  svn_error_t *err;
+  int i;
+
+  /* Get authz's opinion on the access. */
+  err = authz_check_access_many(allowed, paths, required, baton, pool);
+
+  /* If an error made lookup fail, deny access. */
+  if (err)
+    {
+      log_error(err, baton);
+      svn_error_clear(err);
+      blanket_access = FALSE;
+    }
+
+  /* Access must also be granted blanket-wise. */
+  if (!blanket_access)
+    for (i = 0; i < paths->nelts; ++i)
+      allowed[i] = FALSE;
+}
+
 /* Check that the client has the REQUIRED access by consulting the
  * authentication and authorization states stored in BATON.  If the
  * client does not have the required access credentials, attempt to
@@ -854,7 +934,7 @@ static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                   &depth_word));
   if (depth_word)
     depth = svn_depth_from_word(depth_word);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
   if (b->from_rev && strcmp(path, "") == 0)
     *b->from_rev = rev;
   if (!b->err)
@@ -873,7 +953,7 @@ static svn_error_t *delete_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   const char *path;
 
   SVN_ERR(svn_ra_svn__parse_tuple(params, "c", &path));
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
   if (!b->err)
     b->err = svn_repos_delete_path(b->report_baton, path, pool);
   return SVN_NO_ERROR;
@@ -895,7 +975,7 @@ static svn_error_t *link_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
   /* ### WHAT?!  The link path is an absolute URL?!  Didn't see that
      coming...   -- cmpilato  */
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__ensure_canonical(path, pool);
   url = svn_uri_canonicalize(url, pool);
   if (depth_word)
     depth = svn_depth_from_word(depth_word);
@@ -988,6 +1068,7 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       authz_check_access_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  svn_repos__report_set_delta_jobs(report_baton, b->update_jobs, 0);
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -1551,6 +1632,50 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Send the CONTENTS of a file over CONN as a series of strings,
+ * terminated by an empty string, and close the stream.  If reading
+ * CONTENTS fails, terminate the series early and return the read error
+ * as a command error.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+write_file_contents(svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool,
+                    svn_stream_t *contents)
+{
+  svn_string_t write_str;
+  char buf[4096];
+  apr_size_t len;
+  svn_error_t *err, *write_err;
+
+  while (1)
+    {
+      len = sizeof(buf);
+      err = svn_stream_read_full(contents, buf, &len);
+      if (err)
+        break;
+      if (len > 0)
+        {
+          write_str.data = buf;
+          write_str.len = len;
+          SVN_ERR(svn_ra_svn__write_string(conn, pool, &write_str));
+        }
+      if (len < sizeof(buf))
+        {
+          err = svn_stream_close(contents);
+          break;
+        }
+    }
+  write_err = svn_ra_svn__write_cstring(conn, pool, "");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1564,13 +1689,9 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_stream_t *contents;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
-  svn_string_t write_str;
-  char buf[4096];
-  apr_size_t len;
   svn_boolean_t want_props, want_contents;
   apr_uint64_t wants_inherited_props;
   svn_checksum_t *checksum;
-  svn_error_t *err, *write_err;
   int i;
   authz_baton_t ab;
 
@@ -1646,32 +1767,7 @@ get_file(svn_ra_svn_conn_t *conn,
   /* Now send the file's contents. */
   if (want_contents)
     {
-      err = SVN_NO_ERROR;
-      while (1)
-        {
-          len = sizeof(buf);
-          err = svn_stream_read_full(contents, buf, &len);
-          if (err)
-            break;
-          if (len > 0)
-            {
-              write_str.data = buf;
-              write_str.len = len;
-              SVN_ERR(svn_ra_svn__write_string(conn, pool, &write_str));
-            }
-          if (len < sizeof(buf))
-            {
-              err = svn_stream_close(contents);
-              break;
-            }
-        }
-      write_err = svn_ra_svn__write_cstring(conn, pool, "");
-      if (write_err)
-        {
-          svn_error_clear(err);
-          return write_err;
-        }
-      SVN_CMD_ERR(err);
+      SVN_ERR(write_file_contents(conn, pool, contents));
       SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
     }
 
@@ -1736,6 +1832,120 @@ parse_dirent_fields(apr_uint32_t *dirent_fields_p,
   return SVN_NO_ERROR;
 }
 
+/* Send the ENTRIES of directory FULL_PATH in ROOT over CONN as a series
+ * of dirent tuples, filling in the fields selected by DIRENT_FIELDS.
+ * Entries that the client may not read are skipped.  B is the server
+ * baton.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+write_dir_entries(svn_ra_svn_conn_t *conn,
+                  apr_pool_t *pool,
+                  server_baton_t *b,
+                  svn_fs_root_t *root,
+                  const char *full_path,
+                  apr_hash_t *entries,
+                  apr_uint32_t dirent_fields)
+{
+  apr_pool_t *subpool;
+  int i;
+
+  /* Use epoch for a placeholder for a missing date.  */
+  const char *missing_date = svn_time_to_cstring(0, pool);
+
+  /* Check the read access to all entries in one go. */
+  apr_array_header_t *sorted_entries
+    = svn_sort__hash(entries, svn_sort_compare_items_lexically, pool);
+  apr_array_header_t *paths
+    = apr_array_make(pool, sorted_entries->nelts, sizeof(const char *));
+  svn_boolean_t *allowed
+    = apr_palloc(pool, sorted_entries->nelts * sizeof(*allowed));
+
+  for (i = 0; i < sorted_entries->nelts; ++i)
+    {
+      const char *name
+        = APR_ARRAY_IDX(sorted_entries, i, svn_sort__item_t).key;
+      APR_ARRAY_PUSH(paths, const char *)
+        = svn_fspath__join(full_path, name, pool);
+    }
+
+  lookup_access_many(pool, b, svn_authz_read, paths, allowed);
+
+  /* Transform the hash table's FS entries into dirents.  This probably
+   * belongs in libsvn_repos. */
+  subpool = svn_pool_create(pool);
+  for (i = 0; i < sorted_entries->nelts; ++i)
+    {
+      svn_sort__item_t *item
+        = &APR_ARRAY_IDX(sorted_entries, i, svn_sort__item_t);
+      const char *name = item->key;
+      svn_fs_dirent_t *fsent = item->value;
+      const char *file_path = APR_ARRAY_IDX(paths, i, const char *);
+
+      /* The fields in the entry tuple.  */
+      svn_node_kind_t entry_kind = svn_node_none;
+      svn_filesize_t entry_size = 0;
+      svn_boolean_t has_props = FALSE;
+      /* If 'created rev' was not requested, send 0.  We can't use
+       * SVN_INVALID_REVNUM as the tuple field is not optional.
+       * See the email thread on dev@, 2012-03-28, subject
+       * "buildbot failure in ASF Buildbot on svn-slik-w2k3-x64-ra",
+       * <http://svn.haxx.se/dev/archive-2012-03/0655.shtml>. */
+      svn_revnum_t created_rev = 0;
+      const char *cdate = NULL;
+      const char *last_author = NULL;
+
+      svn_pool_clear(subpool);
+
+      if (! allowed[i])
+        continue;
+
+      if (dirent_fields & SVN_DIRENT_KIND)
+          entry_kind = fsent->kind;
+
+      if (dirent_fields & SVN_DIRENT_SIZE)
+          if (fsent->kind != svn_node_dir)
+            SVN_CMD_ERR(svn_fs_file_length(&entry_size, root, file_path,
+                                           subpool));
+
+      if (dirent_fields & SVN_DIRENT_HAS_PROPS)
+        {
+          /* has_props */
+          SVN_CMD_ERR(svn_fs_node_has_props(&has_props, root, file_path,
+                                           subpool));
+        }
+
+      if ((dirent_fields & SVN_DIRENT_LAST_AUTHOR)
+          || (dirent_fields & SVN_DIRENT_TIME)
+          || (dirent_fields & SVN_DIRENT_CREATED_REV))
+        {
+          /* created_rev, last_author, time */
+          SVN_CMD_ERR(svn_repos_get_committed_info(&created_rev,
+                                                   &cdate,
+                                                   &last_author,
+                                                   root,
+                                                   file_path,
+                                                   subpool));
+        }
+
+      /* The client does not properly handle a missing CDATE. For
+         interoperability purposes, we must fill in some junk.
+
+         See libsvn_ra_svn/client.c:ra_svn_get_dir()  */
+      if (cdate == NULL)
+        cdate = missing_date;
+
+      /* Send the entry. */
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "cwnbr(?c)(?c)", name,
+                                      svn_node_kind_to_word(entry_kind),
+                                      (apr_uint64_t) entry_size,
+                                      has_props, created_rev,
+                                      cdate, last_author));
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_dir(svn_ra_svn_conn_t *conn,
         apr_pool_t *pool,
@@ -1747,9 +1957,7 @@ get_dir(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   apr_hash_t *entries, *props = NULL;
   apr_array_header_t *inherited_props;
-  apr_hash_index_t *hi;
   svn_fs_root_t *root;
-  apr_pool_t *subpool;
   svn_boolean_t want_props, want_contents;
   apr_uint64_t wants_inherited_props;
   apr_uint32_t dirent_fields;
@@ -1808,82 +2016,8 @@ get_dir(svn_ra_svn_conn_t *conn,
 
   /* Fetch the directory entries if requested and send them immediately. */
   if (want_contents)
-    {
-      /* Use epoch for a placeholder for a missing date.  */
-      const char *missing_date = svn_time_to_cstring(0, pool);
-
-      /* Transform the hash table's FS entries into dirents.  This probably
-       * belongs in libsvn_repos. */
-      subpool = svn_pool_create(pool);
-      for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
-        {
-          const char *name = apr_hash_this_key(hi);
-          svn_fs_dirent_t *fsent = apr_hash_this_val(hi);
-          const char *file_path;
-
-          /* The fields in the entry tuple.  */
-          svn_node_kind_t entry_kind = svn_node_none;
-          svn_filesize_t entry_size = 0;
-          svn_boolean_t has_props = FALSE;
-          /* If 'created rev' was not requested, send 0.  We can't use
-           * SVN_INVALID_REVNUM as the tuple field is not optional.
-           * See the email thread on dev@, 2012-03-28, subject
-           * "buildbot failure in ASF Buildbot on svn-slik-w2k3-x64-ra",
-           * <http://svn.haxx.se/dev/archive-2012-03/0655.shtml>. */
-          svn_revnum_t created_rev = 0;
-          const char *cdate = NULL;
-          const char *last_author = NULL;
-
-          svn_pool_clear(subpool);
-
-          file_path = svn_fspath__join(full_path, name, subpool);
-          if (! lookup_access(subpool, b, svn_authz_read, file_path, FALSE))
-            continue;
-
-          if (dirent_fields & SVN_DIRENT_KIND)
-              entry_kind = fsent->kind;
-
-          if (dirent_fields & SVN_DIRENT_SIZE)
-              if (fsent->kind != svn_node_dir)
-                SVN_CMD_ERR(svn_fs_file_length(&entry_size, root, file_path,
-                                               subpool));
-
-          if (dirent_fields & SVN_DIRENT_HAS_PROPS)
-            {
-              /* has_props */
-              SVN_CMD_ERR(svn_fs_node_has_props(&has_props, root, file_path,
-                                               subpool));
-            }
-
-          if ((dirent_fields & SVN_DIRENT_LAST_AUTHOR)
-              || (dirent_fields & SVN_DIRENT_TIME)
-              || (dirent_fields & SVN_DIRENT_CREATED_REV))
-            {
-              /* created_rev, last_author, time */
-              SVN_CMD_ERR(svn_repos_get_committed_info(&created_rev,
-                                                       &cdate,
-                                                       &last_author,
-                                                       root,
-                                                       file_path,
-                                                       subpool));
-            }
-
-          /* The client does not properly handle a missing CDATE. For
-             interoperability purposes, we must fill in some junk.
-
-             See libsvn_ra_svn/client.c:ra_svn_get_dir()  */
-          if (cdate == NULL)
-            cdate = missing_date;
-
-          /* Send the entry. */
-          SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "cwnbr(?c)(?c)", name,
-                                          svn_node_kind_to_word(entry_kind),
-                                          (apr_uint64_t) entry_size,
-                                          has_props, created_rev,
-                                          cdate, last_author));
-        }
-      svn_pool_destroy(subpool);
-    }
+    SVN_ERR(write_dir_entries(conn, pool, b, root, full_path, entries,
+                              dirent_fields));
 
   if (wants_inherited_props)
     {
@@ -1921,15 +2055,17 @@ update(svn_ra_svn_conn_t *conn,
   svn_boolean_t recurse;
   svn_tristate_t send_copyfrom_args; /* Optional; default FALSE */
   svn_tristate_t ignore_ancestry; /* Optional; default FALSE */
+  svn_tristate_t text_deltas; /* Optional; default TRUE */
   /* Default to unknown.  Old clients won't send depth, but we'll
      handle that by converting recurse if necessary. */
   svn_depth_t depth = svn_depth_unknown;
   svn_boolean_t is_checkout;
 
   /* Parse the arguments. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?3", &rev, &target,
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?33", &rev, &target,
                                   &recurse, &depth_word,
-                                  &send_copyfrom_args, &ignore_ancestry));
+                                  &send_copyfrom_args, &ignore_ancestry,
+                                  &text_deltas));
   target = svn_relpath_canonicalize(target, pool);
 
   if (depth_word)
@@ -1945,7 +2081,8 @@ update(svn_ra_svn_conn_t *conn,
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
 
   SVN_ERR(accept_report(&is_checkout, NULL,
-                        conn, pool, b, rev, target, NULL, TRUE,
+                        conn, pool, b, rev, target, NULL,
+                        (text_deltas != svn_tristate_false),
                         depth,
                         (send_copyfrom_args == svn_tristate_true),
                         (ignore_ancestry == svn_tristate_true)));
@@ -3447,81 +3584,436 @@ replay(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *
-replay_range(svn_ra_svn_conn_t *conn,
-             apr_pool_t *pool,
-             svn_ra_svn__list_t *params,
-             void *baton)
+/* Upper limit for the protocol data that the replay prefetch tasks of
+   a single replay-range request may buffer in total. */
+#define REPLAY_PREFETCH_BUFFER_SIZE (64 * 1024 * 1024)
+
+/* Repository objects to be used by a single task at a time. */
+typedef struct task_repos_t
 {
-  svn_revnum_t start_rev, end_rev, rev, low_water_mark;
+  svn_repos_t *repos;
+  svn_authz_t *authzdb;
+} task_repos_t;
+
+/* Shared state of all tasks prefetching a single replay-range. */
+typedef struct replay_prefetch_t
+{
+  /* The session that we replay for.  Read-only for the tasks. */
+  server_baton_t *server;
+  svn_ra_svn_conn_t *conn;
+
+  /* Parameters passed through to svn_repos_replay2(). */
+  svn_revnum_t low_water_mark;
   svn_boolean_t send_deltas;
-  server_baton_t *b = baton;
-  apr_pool_t *iterpool;
+
+  /* Limit for the buffered data of a single revision. */
+  apr_uint64_t max_rev_size;
+
+  /* Repository instances not currently in use (task_repos_t *) and the
+     root pools that they live in (apr_pool_t *).  Instances get opened
+     on demand, so there are never more of them than tasks running at
+     the same time. */
+  apr_array_header_t *idle_repos;
+  apr_array_header_t *repos_pools;
+
+  /* Serializes opening instances and access to IDLE_REPOS and
+     REPOS_POOLS. */
+  svn_mutex__t *mutex;
+} replay_prefetch_t;
+
+/* A revision being replayed ahead of the client. */
+typedef struct replay_task_t
+{
+  /* The prefetcher that this task belongs to. */
+  replay_prefetch_t *prefetch;
+
+  /* Revision to replay. */
+  svn_revnum_t rev;
+} replay_task_t;
+
+/* Result of a replay_task_t. */
+typedef struct replay_result_t
+{
+  /* Revision that has been replayed. */
+  svn_revnum_t rev;
+
+  /* The revprops, the editor drive and the finish-replay command for REV
+     exactly as they will be sent to the client.  NULL if REV could not
+     be prepared and must be replayed by the main thread. */
+  svn_stringbuf_t *data;
+} replay_result_t;
+
+/* Replay TASK's revision into the buffer DATA, using the repository
+   objects in TASK_REPOS instead of those of the session.  Use POOL for
+   all allocations. */
+static svn_error_t *
+prefetch_revision(svn_stringbuf_t *data,
+                  const replay_task_t *task,
+                  task_repos_t *task_repos,
+                  apr_pool_t *pool)
+{
+  replay_prefetch_t *prefetch = task->prefetch;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_fs_root_t *root;
+  apr_hash_t *props;
+  svn_ra_svn_conn_t *conn;
+  server_baton_t *b;
   authz_baton_t ab;
 
+  /* Same session state but with private, thread-local FS and authz
+     objects. */
+  b = apr_pmemdup(pool, prefetch->server, sizeof(*b));
+  b->repository = apr_pmemdup(pool, b->repository, sizeof(*b->repository));
+  b->repository->repos = task_repos->repos;
+  b->repository->fs = svn_repos_fs(task_repos->repos);
+  b->repository->authzdb = task_repos->authzdb;
+  b->pool = pool;
+
+  conn = svn_ra_svn__create_buffer_conn(prefetch->conn, data,
+                                        prefetch->max_rev_size, pool);
   ab.server = b;
   ab.conn = conn;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "rrrb", &start_rev,
-                                 &end_rev, &low_water_mark,
-                                 &send_deltas));
-
-  SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(svn_repos_fs_revision_proplist(&props, b->repository->repos,
+                                         task->rev,
+                                         authz_check_access_cb_func(b), &ab,
+                                         pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(!", "revprops"));
+  SVN_ERR(svn_ra_svn__write_proplist(conn, pool, props));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)"));
 
-  iterpool = svn_pool_create(pool);
-  for (rev = start_rev; rev <= end_rev; rev++)
-    {
-      apr_hash_t *props;
+  svn_ra_svn_get_editor(&editor, &edit_baton, conn, pool, NULL, NULL);
+  SVN_ERR(svn_fs_revision_root(&root, b->repository->fs, task->rev, pool));
+  SVN_ERR(svn_repos_replay2(root, b->repository->fs_path->data,
+                            prefetch->low_water_mark, prefetch->send_deltas,
+                            editor, edit_baton,
+                            authz_check_access_cb_func(b), &ab, pool));
+  SVN_ERR(svn_ra_svn__write_cmd_finish_replay(conn, pool));
+
+  return svn_error_trace(svn_ra_svn__flush(conn, pool));
+}
 
-      svn_pool_clear(iterpool);
+/* Take an idle instance from PREFETCH and return it in *TASK_REPOS, or
+   set *TASK_REPOS to NULL if there is none. */
+static svn_error_t *
+pop_idle_repos(task_repos_t **task_repos,
+               replay_prefetch_t *prefetch)
+{
+  *task_repos = prefetch->idle_repos->nelts
+              ? *(task_repos_t **)apr_array_pop(prefetch->idle_repos)
+              : NULL;
 
-      SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
-                                                 b->repository->repos, rev,
-                                                 authz_check_access_cb_func(b),
-                                                 &ab,
-                                                 iterpool));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
-      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
+  return SVN_NO_ERROR;
+}
 
-      SVN_ERR(replay_one_revision(conn, b, rev, low_water_mark,
-                                  send_deltas, iterpool));
+/* Open a new instance for PREFETCH in *TASK_REPOS.  Neither the
+   repository nor the authz objects are thread-safe.  The instances still
+   share caches etc. with the session because we pass the same FS
+   config. */
+static svn_error_t *
+open_task_repos(task_repos_t **task_repos,
+                replay_prefetch_t *prefetch)
+{
+  repository_t *repository = prefetch->server->repository;
+  apr_pool_t *repos_pool = svn_pool_create(NULL);
+
+  APR_ARRAY_PUSH(prefetch->repos_pools, apr_pool_t *) = repos_pool;
+  *task_repos = apr_pcalloc(repos_pool, sizeof(**task_repos));
+  SVN_ERR(svn_repos_open3(&(*task_repos)->repos, repository->repos_root,
+                          svn_fs_config(repository->fs, repos_pool),
+                          repos_pool, repos_pool));
+  if (repository->authzdb)
+    (*task_repos)->authzdb = svn_repos__authz_share(repository->authzdb,
+                                                    repos_pool);
 
-    }
-  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
 
-  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+/* Take an instance from PREFETCH and return it in *TASK_REPOS.  Open a
+   new one if all are in use. */
+static svn_error_t *
+acquire_task_repos(task_repos_t **task_repos,
+                   replay_prefetch_t *prefetch)
+{
+  SVN_MUTEX__WITH_LOCK(prefetch->mutex,
+                       pop_idle_repos(task_repos, prefetch));
+  if (*task_repos == NULL)
+    SVN_MUTEX__WITH_LOCK(prefetch->mutex,
+                         open_task_repos(task_repos, prefetch));
 
   return SVN_NO_ERROR;
 }
 
+/* Put TASK_REPOS back on the stack of idle instances in PREFETCH. */
 static svn_error_t *
-get_deleted_rev(svn_ra_svn_conn_t *conn,
-                apr_pool_t *pool,
-                svn_ra_svn__list_t *params,
-                void *baton)
+push_idle_repos(replay_prefetch_t *prefetch,
+                task_repos_t *task_repos)
 {
-  server_baton_t *b = baton;
-  const char *path, *full_path;
-  svn_revnum_t peg_revision;
-  svn_revnum_t end_revision;
-  svn_revnum_t revision_deleted;
+  APR_ARRAY_PUSH(prefetch->idle_repos, task_repos_t *) = task_repos;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "crr",
-                                 &path, &peg_revision, &end_revision));
-  full_path = svn_fspath__join(b->repository->fs_path->data,
-                               svn_relpath_canonicalize(path, pool), pool);
-  SVN_ERR(log_command(b, conn, pool, "get-deleted-rev"));
-  SVN_ERR(trivial_auth_request(conn, pool, b));
-  SVN_ERR(svn_repos_deleted_rev(b->repository->fs, full_path, peg_revision,
-                                end_revision, &revision_deleted, pool));
-  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "r", revision_deleted));
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_task__process_func_t.  Prefetch the revision given by
+   the replay_task_t in PROCESS_BATON and return a replay_result_t in
+   *RESULT.  Revisions that fail here, e.g. because they exceed the
+   buffer limit, get replayed again by the main thread.  That one also
+   takes care of reporting any errors to the client.  Only failures to
+   provide a repository instance fail the task. */
 static svn_error_t *
-get_inherited_props(svn_ra_svn_conn_t *conn,
-                    apr_pool_t *pool,
+replay_task(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const replay_task_t *task = process_baton;
+  replay_prefetch_t *prefetch = task->prefetch;
+  replay_result_t *replay_result = apr_pcalloc(result_pool,
+                                               sizeof(*replay_result));
+  task_repos_t *task_repos;
+  apr_pool_t *replay_pool;
+  svn_error_t *err;
+
+  replay_result->rev = task->rev;
+  replay_result->data = svn_stringbuf_create_empty(result_pool);
+
+  SVN_ERR(acquire_task_repos(&task_repos, prefetch));
+
+  /* Everything referencing TASK_REPOS must be gone before the next task
+     may use it. */
+  replay_pool = svn_pool_create(scratch_pool);
+  err = prefetch_revision(replay_result->data, task, task_repos,
+                          replay_pool);
+  svn_pool_destroy(replay_pool);
+
+  SVN_MUTEX__WITH_LOCK(prefetch->mutex,
+                       push_idle_repos(prefetch, task_repos));
+
+  if (err)
+    {
+      svn_error_clear(err);
+      replay_result->data = NULL;
+    }
+
+  *result = replay_result;
+  return SVN_NO_ERROR;
+}
+
+/* Baton for send_replay_result(). */
+typedef struct replay_output_baton_t
+{
+  svn_ra_svn_conn_t *conn;
+  server_baton_t *server;
+  replay_prefetch_t *prefetch;
+} replay_output_baton_t;
+
+/* Implements svn_task__output_func_t.  Send the replay_result_t in RESULT
+   to the client as described by the replay_output_baton_t OUTPUT_BATON.
+   If the revision could not be prepared, replay it directly. */
+static svn_error_t *
+send_replay_result(void *result,
+                   void *output_baton,
+                   apr_pool_t *scratch_pool)
+{
+  replay_result_t *replay_result = result;
+  replay_output_baton_t *baton = output_baton;
+  svn_ra_svn_conn_t *conn = baton->conn;
+  server_baton_t *b = baton->server;
+  svn_revnum_t rev = replay_result->rev;
+  apr_hash_t *props;
+  authz_baton_t ab;
+
+  if (replay_result->data)
+    {
+      SVN_ERR(log_command(b, conn, scratch_pool,
+                          svn_log__replay(b->repository->fs_path->data,
+                                          rev, scratch_pool)));
+      return svn_error_trace(svn_ra_svn__write_buffer(conn, scratch_pool,
+                                                      replay_result->data));
+    }
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props, b->repository->repos,
+                                             rev,
+                                             authz_check_access_cb_func(b),
+                                             &ab, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(!", "revprops"));
+  SVN_ERR(svn_ra_svn__write_proplist(conn, scratch_pool, props));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)"));
+
+  return svn_error_trace(replay_one_revision(conn, b, rev,
+                                             baton->prefetch->low_water_mark,
+                                             baton->prefetch->send_deltas,
+                                             scratch_pool));
+}
+
+/* Pool cleanup function destroying the repository instances of the
+   replay_prefetch_t in DATA. */
+static apr_status_t
+cleanup_task_repos(void *data)
+{
+  replay_prefetch_t *prefetch = data;
+  int i;
+
+  for (i = 0; i < prefetch->repos_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(prefetch->repos_pools, i, apr_pool_t *));
+
+  return APR_SUCCESS;
+}
+
+/* Like the loop in replay_range() but prepare up to JOBS of the revisions
+   START_REV to END_REV ahead of the client on CONN in session B.
+   LOW_WATER_MARK and SEND_DELTAS are being passed through to
+   svn_repos_replay2().  Revisions that could not be prepared get
+   replayed directly.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+replay_range_prefetched(svn_ra_svn_conn_t *conn,
+                        server_baton_t *b,
+                        int jobs,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        svn_revnum_t low_water_mark,
+                        svn_boolean_t send_deltas,
+                        apr_pool_t *scratch_pool)
+{
+  replay_prefetch_t *prefetch = apr_pcalloc(scratch_pool,
+                                            sizeof(*prefetch));
+  replay_output_baton_t baton;
+  apr_pool_t *set_pool;
+  svn_task__set_t *set;
+  svn_revnum_t rev;
+
+  /* Make sure the tasks will find the authz user name already set
+     because they must not modify the shared session data. */
+  get_authz_user(b);
+
+  prefetch->server = b;
+  prefetch->conn = conn;
+  prefetch->low_water_mark = low_water_mark;
+  prefetch->send_deltas = send_deltas;
+  prefetch->max_rev_size = REPLAY_PREFETCH_BUFFER_SIZE / jobs;
+  prefetch->idle_repos = apr_array_make(scratch_pool, 0,
+                                        sizeof(task_repos_t *));
+  prefetch->repos_pools = apr_array_make(scratch_pool, 0,
+                                         sizeof(apr_pool_t *));
+  SVN_ERR(svn_mutex__init(&prefetch->mutex, TRUE, scratch_pool));
+  apr_pool_cleanup_register(scratch_pool, prefetch, cleanup_task_repos,
+                            apr_pool_cleanup_null);
+
+  baton.conn = conn;
+  baton.server = b;
+  baton.prefetch = prefetch;
+
+  /* Sub-pools get destroyed before the cleanups of their parent run, so
+     the task set will be gone before the repository instances. */
+  set_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__set_create(&set, jobs, send_replay_result, &baton,
+                               NULL, NULL, set_pool));
+
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      replay_task_t *task = apr_pcalloc(scratch_pool, sizeof(*task));
+
+      task->prefetch = prefetch;
+      task->rev = rev;
+      SVN_ERR(svn_task__add(set, replay_task, task));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+replay_range(svn_ra_svn_conn_t *conn,
+             apr_pool_t *pool,
+             svn_ra_svn__list_t *params,
+             void *baton)
+{
+  svn_revnum_t start_rev, end_rev, rev, low_water_mark;
+  svn_boolean_t send_deltas;
+  server_baton_t *b = baton;
+  apr_pool_t *iterpool;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "rrrb", &start_rev,
+                                 &end_rev, &low_water_mark,
+                                 &send_deltas));
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+
+  if (b->replay_prefetch > 0 && start_rev < end_rev)
+    {
+      SVN_ERR(replay_range_prefetched(conn, b, b->replay_prefetch,
+                                      start_rev, end_rev, low_water_mark,
+                                      send_deltas, pool));
+
+      return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+
+  iterpool = svn_pool_create(pool);
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
+                                                 b->repository->repos, rev,
+                                                 authz_check_access_cb_func(b),
+                                                 &ab,
+                                                 iterpool));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
+      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
+
+      SVN_ERR(replay_one_revision(conn, b, rev, low_water_mark,
+                                  send_deltas, iterpool));
+
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_deleted_rev(svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool,
+                svn_ra_svn__list_t *params,
+                void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path;
+  svn_revnum_t peg_revision;
+  svn_revnum_t end_revision;
+  svn_revnum_t revision_deleted;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "crr",
+                                 &path, &peg_revision, &end_revision));
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               svn_relpath_canonicalize(path, pool), pool);
+  SVN_ERR(log_command(b, conn, pool, "get-deleted-rev"));
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(svn_repos_deleted_rev(b->repository->fs, full_path, peg_revision,
+                                end_revision, &revision_deleted, pool));
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "r", revision_deleted));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_inherited_props(svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool,
                     svn_ra_svn__list_t *params,
                     void *baton)
 {
@@ -3677,9 +4169,9 @@ list(svn_ra_svn_conn_t *conn,
 
   /* Fetch the directory entries if requested and send them immediately. */
   path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
-  err = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                       authz_check_access_cb_func(b), &ab, list_receiver,
-                       &rb, NULL, NULL, pool);
+  err = svn_repos__list(root, full_path, patterns, depth, path_info_only,
+                        authz_check_access_cb_func(b), &ab, list_receiver,
+                        &rb, NULL, NULL, b->list_jobs, TRUE, pool);
 
 
   /* Finish response. */
@@ -3694,6 +4186,347 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* Implements svn_repos_annotate_receiver_t, sending REVISION and LINE
+ * to the client.  BATON must be a svn_ra_svn_conn_t. */
+static svn_error_t *
+annotate_receiver(void *baton,
+                  apr_int64_t line_no,
+                  svn_revnum_t revision,
+                  const svn_string_t *line,
+                  apr_pool_t *scratch_pool)
+{
+  svn_ra_svn_conn_t *conn = baton;
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, scratch_pool, "rs",
+                                                 revision, line));
+}
+
+static svn_error_t *
+get_file_annotation(svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool,
+                    svn_ra_svn__list_t *params,
+                    void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path;
+  svn_revnum_t rev;
+  svn_error_t *err, *write_err;
+
+  authz_baton_t ab;
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Read the command parameters. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)", &path, &rev));
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               svn_relpath_canonicalize(path, pool), pool);
+
+  /* Check authorizations */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           full_path, FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_file_annotation(full_path, rev, pool)));
+
+  /* Annotate the file and send the lines immediately. */
+  err = svn_repos_get_file_annotation(b->repository->repos, full_path, rev,
+                                      authz_check_access_cb_func(b), &ab,
+                                      annotate_receiver, conn, NULL, NULL,
+                                      pool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
+/* Set *FULL_PATHS to the repository paths of the client-side relpaths
+ * in PATH_LIST and make sure the client may read all of them.  Like
+ * must_have_access(), this may send an auth request over CONN, but only
+ * one for all paths.  B is the server baton.  Allocate *FULL_PATHS in
+ * POOL.
+ */
+static svn_error_t *
+read_paths_many(apr_array_header_t **full_paths,
+                svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool,
+                server_baton_t *b,
+                svn_ra_svn__list_t *path_list)
+{
+  apr_array_header_t *result;
+  svn_boolean_t *allowed;
+  int i;
+
+  result = apr_array_make(pool, path_list->nelts, sizeof(const char *));
+  for (i = 0; i < path_list->nelts; i++)
+    {
+      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(path_list, i);
+      const char *full_path;
+
+      if (item->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Path is not a string"));
+      full_path = svn_relpath_canonicalize(item->u.string.data, pool);
+      full_path = svn_fspath__join(b->repository->fs_path->data, full_path,
+                                   pool);
+      APR_ARRAY_PUSH(result, const char *) = full_path;
+    }
+
+  /* We may send only one auth request, so let the first path that the
+     client may not read yet trigger it. */
+  allowed = apr_palloc(pool, result->nelts * sizeof(*allowed));
+  lookup_access_many(pool, b, svn_authz_read, result, allowed);
+  for (i = 0; i < result->nelts; i++)
+    if (! allowed[i])
+      break;
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           i < result->nelts
+                             ? APR_ARRAY_IDX(result, i, const char *)
+                             : NULL,
+                           FALSE));
+
+  /* The authentication may not have granted access to all paths. */
+  if (i < result->nelts)
+    {
+      lookup_access_many(pool, b, svn_authz_read, result, allowed);
+      for (i = 0; i < result->nelts; i++)
+        if (! allowed[i])
+          return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                                  error_create_and_log(
+                                    SVN_ERR_RA_NOT_AUTHORIZED,
+                                    NULL, NULL, b),
+                                  NULL);
+    }
+
+  *full_paths = result;
+  return SVN_NO_ERROR;
+}
+
+/* Send the get-files-batch entry for PATH, i.e. FULL_PATH in ROOT at
+ * revision REV, over CONN.  If WANT_PROPS is set, include the node's
+ * properties.  If WANT_CONTENTS is set, include the entries of a
+ * directory, with the fields selected by DIRENT_FIELDS, or follow the
+ * entry with the contents of a file.  B and AB are the server and authz
+ * batons, respectively.
+ *
+ * Failures to read the repository are returned as command errors.  Use
+ * POOL for temporary allocations.
+ */
+static svn_error_t *
+write_batch_entry(svn_ra_svn_conn_t *conn,
+                  apr_pool_t *pool,
+                  server_baton_t *b,
+                  authz_baton_t *ab,
+                  svn_fs_root_t *root,
+                  svn_revnum_t rev,
+                  const char *path,
+                  const char *full_path,
+                  svn_boolean_t want_props,
+                  svn_boolean_t want_contents,
+                  apr_uint32_t dirent_fields)
+{
+  svn_node_kind_t kind;
+  apr_hash_t *props = NULL;
+  apr_hash_t *entries = NULL;
+  svn_stream_t *contents = NULL;
+  const char *hex_digest = NULL;
+
+  /* Gather everything that may fail before starting the entry. */
+  SVN_CMD_ERR(svn_fs_check_path(&kind, root, full_path, pool));
+  if (kind == svn_node_file)
+    {
+      svn_checksum_t *checksum;
+
+      SVN_CMD_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root,
+                                       full_path, TRUE, pool));
+      hex_digest = svn_checksum_to_cstring_display(checksum, pool);
+      if (want_contents)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
+  else if (kind == svn_node_dir && want_contents)
+    {
+      SVN_CMD_ERR(svn_fs_dir_entries(&entries, root, full_path, pool));
+    }
+
+  if (want_props && kind != svn_node_none)
+    SVN_CMD_ERR(get_props(&props, NULL, ab, root, full_path, pool));
+
+  /* Send the entry ... */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "(cwr(!", path,
+                                  svn_node_kind_to_word(kind), rev));
+  SVN_ERR(svn_ra_svn__write_proplist(conn, pool, props));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)(?c)(!", hex_digest));
+  if (entries)
+    SVN_ERR(write_dir_entries(conn, pool, b, root, full_path, entries,
+                              dirent_fields));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+
+  /* ... followed by the file contents, if requested. */
+  if (contents)
+    SVN_ERR(write_file_contents(conn, pool, contents));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files_batch(svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool,
+                svn_ra_svn__list_t *params,
+                void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *path_list, *dirent_fields_list;
+  apr_array_header_t *full_paths;
+  svn_revnum_t rev;
+  svn_boolean_t want_props, want_contents;
+  apr_uint32_t dirent_fields;
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  int i;
+
+  authz_baton_t ab;
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Read the command parameters. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "l(?r)bbl", &path_list, &rev,
+                                  &want_props, &want_contents,
+                                  &dirent_fields_list));
+  SVN_ERR(parse_dirent_fields(&dirent_fields, dirent_fields_list));
+
+  SVN_ERR(read_paths_many(&full_paths, conn, pool, b, path_list));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_files_batch(full_paths, rev,
+                                               want_contents, want_props,
+                                               pool)));
+
+  SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
+
+  /* Stream the entries in request order.  The client reads them while
+     we are still sending, so the connection's send window is all the
+     flow control we need. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *path = SVN_RA_SVN__LIST_ITEM(path_list, i).u.string.data;
+
+      svn_pool_clear(iterpool);
+      err = write_batch_entry(conn, iterpool, b, &ab, root, rev, path,
+                              APR_ARRAY_IDX(full_paths, i, const char *),
+                              want_props, want_contents, dirent_fields);
+      if (err)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Connection errors cannot be reported to the client. */
+  if (err && err->apr_err != SVN_ERR_RA_SVN_CMD_ERR)
+    return svn_error_trace(err);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  if (err)
+    return err;
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
+static svn_error_t *
+stat_many(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *path_list;
+  apr_array_header_t *full_paths;
+  svn_revnum_t rev;
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  int i;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "l(?r)", &path_list, &rev));
+  SVN_ERR(read_paths_many(&full_paths, conn, pool, b, path_list));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__stat_many(full_paths, rev, pool)));
+
+  SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
+
+  /* Send one "(?l)" entry per path, in request order, just like the
+     response to the stat command. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *path = SVN_RA_SVN__LIST_ITEM(path_list, i).u.string.data;
+      const char *cdate;
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      err = svn_repos_stat(&dirent, root,
+                           APR_ARRAY_IDX(full_paths, i, const char *),
+                           iterpool);
+      if (err)
+        {
+          err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
+          break;
+        }
+
+      if (dirent == NULL)
+        {
+          SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "c()", path));
+          continue;
+        }
+
+      cdate = (dirent->time == (time_t) -1) ? NULL
+        : svn_time_to_cstring(dirent->time, iterpool);
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "c((wnbr(?c)(?c)))",
+                                      path,
+                                      svn_node_kind_to_word(dirent->kind),
+                                      (apr_uint64_t) dirent->size,
+                                      dirent->has_props,
+                                      dirent->created_rev,
+                                      cdate, dirent->last_author));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  if (err)
+    return err;
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3727,6 +4560,9 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "get-file-annotation", get_file_annotation },
+  { "get-files-batch", get_files_batch },
+  { "stat-many",       stat_many },
   { NULL }
 };
 
@@ -3782,12 +4618,316 @@ repos_path_valid(const char *path)
   return TRUE;
 }
 
+/* An open repository that can be handed from one connection to the
+ * next.  It lives in its own root POOL such that it survives the
+ * connection that opened it. */
+typedef struct cached_repos_t
+{
+  /* The cache that this handle will be returned to. */
+  struct repos_cache_t *cache;
+
+  /* Repository root directory; the key in CACHE->IDLE. */
+  const char *repos_root;
+
+  /* Checksum over the repository configuration at the time REPOS was
+     opened.  See repos_config_checksum(). */
+  svn_checksum_t *checksum;
+
+  /* The open repository. */
+  svn_repos_t *repos;
+
+  /* Next idle handle for the same REPOS_ROOT.  Only used while idle. */
+  struct cached_repos_t *next;
+
+  /* Private root pool.  Destroying it closes the repository. */
+  apr_pool_t *pool;
+} cached_repos_t;
+
+/* Idle repository handles, shared by all connections of this process.
+ * Every handle is used by at most one connection at a time since
+ * neither svn_repos_t nor svn_fs_t may be accessed concurrently. */
+struct repos_cache_t
+{
+  /* Serializes all access to the members below. */
+  svn_mutex__t *mutex;
+
+  /* const char * repos root -> cached_repos_t * chain of idle handles. */
+  apr_hash_t *idle;
+
+  /* Total number of handles in IDLE and the limit for it. */
+  int idle_count;
+  int max_idle;
+
+  apr_pool_t *pool;
+};
+
+/* Files below the repository root that determine how an open
+ * repository behaves.  Any change to them invalidates cached handles. */
+static const char * const repos_config_files[] =
+{
+  "format",
+  "db/format",
+  "db/uuid",
+  "db/fsfs.conf",
+  "conf/svnserve.conf",
+  NULL
+};
+
+/* Set *CHECKSUM to the MD5 checksum over the contents of the
+ * repos_config_files below REPOS_ROOT.  Missing files are not an error.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+repos_config_checksum(svn_checksum_t **checksum,
+                      const char *repos_root,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(svn_checksum_md5,
+                                                    scratch_pool);
+  int i;
+
+  for (i = 0; repos_config_files[i]; ++i)
+    {
+      svn_stringbuf_t *contents;
+      const char *path = svn_dirent_join(repos_root, repos_config_files[i],
+                                         scratch_pool);
+      svn_error_t *err = svn_stringbuf_from_file2(&contents, path,
+                                                  scratch_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      /* Include the name such that moving content between files counts
+         as a change. */
+      SVN_ERR(svn_checksum_update(ctx, repos_config_files[i],
+                                  strlen(repos_config_files[i]) + 1));
+      SVN_ERR(svn_checksum_update(ctx, contents->data, contents->len));
+    }
+
+  return svn_error_trace(svn_checksum_final(checksum, ctx, result_pool));
+}
+
+/* Pool cleanup function closing all idle handles in the repos_cache_t
+ * BATON. */
+static apr_status_t
+repos_cache_cleanup(void *baton)
+{
+  struct repos_cache_t *cache = baton;
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(cache->pool, cache->idle);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      cached_repos_t *handle = apr_hash_this_val(hi);
+      while (handle)
+        {
+          cached_repos_t *next = handle->next;
+          svn_pool_destroy(handle->pool);
+          handle = next;
+        }
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+repos_cache_create(struct repos_cache_t **cache,
+                   int max_idle,
+                   svn_boolean_t thread_safe,
+                   apr_pool_t *pool)
+{
+  struct repos_cache_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  result->idle = svn_hash__make(pool);
+  result->max_idle = max_idle;
+  result->pool = pool;
+  apr_pool_cleanup_register(pool, result, repos_cache_cleanup,
+                            apr_pool_cleanup_null);
+
+  *cache = result;
+  return SVN_NO_ERROR;
+}
+
+/* Remove an idle handle for REPOS_ROOT whose configuration CHECKSUM
+ * matches from CACHE and return it in *HANDLE.  Set *HANDLE to NULL if
+ * there is none.  Close all idle handles for REPOS_ROOT that have been
+ * opened with a different configuration.
+ *
+ * Requires external serialization on CACHE.
+ */
+static svn_error_t *
+take_idle_handle(cached_repos_t **handle,
+                 struct repos_cache_t *cache,
+                 const char *repos_root,
+                 const svn_checksum_t *checksum)
+{
+  cached_repos_t *chain = svn_hash_gets(cache->idle, repos_root);
+  cached_repos_t *kept = NULL;
+
+  /* The hash key lives in the pool of the chain's head, so unlink the
+     chain before closing any of its handles. */
+  svn_hash_sets(cache->idle, repos_root, NULL);
+
+  *handle = NULL;
+  while (chain)
+    {
+      cached_repos_t *next = chain->next;
+
+      if (!svn_checksum_match(chain->checksum, checksum))
+        {
+          --cache->idle_count;
+          svn_pool_destroy(chain->pool);
+        }
+      else if (*handle == NULL)
+        {
+          --cache->idle_count;
+          chain->next = NULL;
+          *handle = chain;
+        }
+      else
+        {
+          chain->next = kept;
+          kept = chain;
+        }
+
+      chain = next;
+    }
+
+  if (kept)
+    svn_hash_sets(cache->idle, kept->repos_root, kept);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add HANDLE to its cache's idle handles unless the cache is full.
+ * Set *ADDED accordingly.
+ *
+ * Requires external serialization on HANDLE->CACHE.
+ */
+static svn_error_t *
+add_idle_handle(svn_boolean_t *added,
+                cached_repos_t *handle)
+{
+  struct repos_cache_t *cache = handle->cache;
+
+  *added = cache->idle_count < cache->max_idle;
+  if (*added)
+    {
+      handle->next = svn_hash_gets(cache->idle, handle->repos_root);
+      svn_hash_sets(cache->idle, handle->repos_root, handle);
+      ++cache->idle_count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_warning_callback_t for idle handles.  There is no
+ * connection left to report to. */
+static void
+ignore_fs_warning(void *baton, svn_error_t *err)
+{
+}
+
+/* Detach HANDLE from the connection that used it and return it to its
+ * cache.  Set *ADDED to FALSE if the cache did not take it. */
+static svn_error_t *
+return_handle(svn_boolean_t *added,
+              cached_repos_t *handle)
+{
+  svn_fs_t *fs = svn_repos_fs(handle->repos);
+
+  *added = FALSE;
+
+  /* Forget everything that points into the connection's pools. */
+  SVN_ERR(svn_repos_remember_client_capabilities(handle->repos, NULL));
+  SVN_ERR(svn_fs_set_access(fs, NULL));
+  svn_fs_set_warning_func(fs, ignore_fs_warning, NULL);
+
+  SVN_MUTEX__WITH_LOCK(handle->cache->mutex, add_idle_handle(added, handle));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function returning the cached_repos_t BATON to its cache
+ * when the connection that used it goes away. */
+static apr_status_t
+release_handle(void *baton)
+{
+  cached_repos_t *handle = baton;
+  svn_boolean_t added;
+  svn_error_t *err = return_handle(&added, handle);
+
+  svn_error_clear(err);
+  if (err || !added)
+    svn_pool_destroy(handle->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *REPOS to an open repository at REPOS_ROOT for exclusive use until
+ * RESULT_POOL gets cleaned up.  Take it from CACHE if possible, otherwise
+ * open it with FS_CONFIG.  Set *REUSED to TRUE in the former case.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+acquire_repos(svn_repos_t **repos,
+              svn_boolean_t *reused,
+              struct repos_cache_t *cache,
+              const char *repos_root,
+              apr_hash_t *fs_config,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *checksum;
+  cached_repos_t *handle;
+
+  SVN_ERR(repos_config_checksum(&checksum, repos_root, scratch_pool,
+                                scratch_pool));
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       take_idle_handle(&handle, cache, repos_root,
+                                        checksum));
+
+  *reused = handle != NULL;
+  if (!handle)
+    {
+      apr_pool_t *handle_pool = svn_pool_create(NULL);
+      svn_error_t *err;
+
+      handle = apr_pcalloc(handle_pool, sizeof(*handle));
+      handle->cache = cache;
+      handle->repos_root = apr_pstrdup(handle_pool, repos_root);
+      handle->checksum = svn_checksum_dup(checksum, handle_pool);
+      handle->pool = handle_pool;
+
+      err = svn_repos_open3(&handle->repos, repos_root, fs_config,
+                            handle_pool, scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(handle_pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  apr_pool_cleanup_register(result_pool, handle, release_handle,
+                            apr_pool_cleanup_null);
+  *repos = handle->repos;
+
+  return SVN_NO_ERROR;
+}
+
 /* Look for the repository given by URL, using ROOT as the virtual
  * repository root.  If we find one, fill in the repos, fs, repos_url,
  * and fs_path fields of REPOSITORY.  VHOST and READ_ONLY flags are the
  * same as in the server baton.
  *
- * CONFIG_POOL shall be used to load config objects.
+ * CONFIG_POOL shall be used to load config objects.  If REPOS_CACHE is
+ * not NULL, take the repository from there and return it when
+ * RESULT_POOL gets cleaned up.
  *
  * Use SCRATCH_POOL for temporary allocations.
  *
@@ -3800,6 +4940,7 @@ find_repos(const char *url,
            svn_config_t *cfg,
            repository_t *repository,
            svn_repos__config_pool_t *config_pool,
+           struct repos_cache_t *repos_cache,
            apr_hash_t *fs_config,
            apr_pool_t *result_pool,
            apr_pool_t *scratch_pool)
@@ -3807,6 +4948,7 @@ find_repos(const char *url,
   const char *path, *full_path, *fs_path, *hooks_env;
   svn_stringbuf_t *url_buf;
   svn_boolean_t sasl_requested;
+  svn_boolean_t reused = FALSE;
 
   /* Skip past the scheme and authority part. */
   path = skip_scheme_part(url);
@@ -3840,8 +4982,13 @@ find_repos(const char *url,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
-                          fs_config, result_pool, scratch_pool));
+  if (repos_cache)
+    SVN_ERR(acquire_repos(&repository->repos, &reused, repos_cache,
+                          repository->repos_root, fs_config,
+                          result_pool, scratch_pool));
+  else
+    SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
+                            fs_config, result_pool, scratch_pool));
   SVN_ERR(svn_repos_remember_client_capabilities(repository->repos,
                                                  repository->capabilities));
   repository->fs = svn_repos_fs(repository->repos);
@@ -3929,7 +5076,11 @@ find_repos(const char *url,
   if (hooks_env)
     hooks_env = svn_dirent_internal_style(hooks_env, scratch_pool);
 
-  SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env, scratch_pool));
+  /* A reused handle got its hooks environment when it was opened and
+     the configuration has not changed since. */
+  if (!reused)
+    SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env,
+                                   scratch_pool));
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
   return SVN_NO_ERROR;
@@ -4129,6 +5280,9 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->update_jobs = params->update_jobs;
+  b->replay_prefetch = params->replay_prefetch;
+  b->list_jobs = params->list_jobs;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
@@ -4137,7 +5291,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4151,11 +5305,19 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_FILE_ANNOTATION,
+                                           SVN_RA_SVN_CAP_GET_FILES_BATCH,
+                                           SVN_RA_SVN_CAP_STAT_MANY,
+                                           SVN_RA_SVN_CAP_UPDATE_TEXT_DELTAS,
+                                           SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4,
+                                           svn__zstd_available()
+                                             ? SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD
+                                             : NULL
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4167,7 +5329,11 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_FILE_ANNOTATION,
+                                           SVN_RA_SVN_CAP_GET_FILES_BATCH,
+                                           SVN_RA_SVN_CAP_STAT_MANY,
+                                           SVN_RA_SVN_CAP_UPDATE_TEXT_DELTAS
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4183,6 +5349,23 @@ construct_server_baton(server_baton_t **baton,
   client_url = svn_uri_canonicalize(client_url, conn_pool);
   SVN_ERR(svn_ra_svn__set_capabilities(conn, caplist));
 
+  /* Both sides compress everything after the client's response if the
+     client picked one of the methods that we offered. */
+  if (params->compression_level > 0)
+    {
+      if (svn__zstd_available()
+          && svn_ra_svn_has_capability(conn,
+                                       SVN_RA_SVN_CAP_COMPRESSED_STREAM_ZSTD))
+        SVN_ERR(svn_ra_svn__enable_compression(conn,
+                                               svn_ra_svn__compression_zstd,
+                                               scratch_pool));
+      else if (svn_ra_svn_has_capability(conn,
+                                         SVN_RA_SVN_CAP_COMPRESSED_STREAM_LZ4))
+        SVN_ERR(svn_ra_svn__enable_compression(conn,
+                                               svn_ra_svn__compression_lz4,
+                                               scratch_pool));
+    }
+
   /* All released versions of Subversion support edit-pipeline,
    * so we do not accept connections from clients that do not. */
   if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
@@ -4225,6 +5408,7 @@ construct_server_baton(server_baton_t **baton,
   err = handle_config_error(find_repos(client_url, params->root, b->vhost,
                                        b->read_only, params->cfg,
                                        b->repository, params->config_pool,
+                                       params->repos_cache,
                                        params->fs_config,
                                        conn_pool, scratch_pool),
                             b);
@@ -4328,6 +5512,7 @@ serve_interruptable(svn_boolean_t *terminate_p,
   svn_boolean_t terminate = FALSE;
   svn_error_t *err = NULL;
   const svn_ra_svn__cmd_entry_t *command;
+  svn_ra_svn__command_stats_t stats;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* Prepare command parser. */
@@ -4363,6 +5548,8 @@ serve_interruptable(svn_boolean_t *terminate_p,
                                   connection->params->max_request_size,
                                   connection->params->max_response_size,
                                   connection->pool);
+      metrics__connection_opened(connection->params->metrics,
+                                 connection->pool);
 
       /* Construct server baton and open the repository for the first time. */
       err = construct_server_baton(&connection->baton, connection->conn,
@@ -4387,10 +5574,13 @@ serve_interruptable(svn_boolean_t *terminate_p,
           err = svn_ra_svn__has_command(&has_command, &terminate,
                                         connection->conn, iterpool);
           if (!err && has_command)
-            err = svn_ra_svn__handle_command(&terminate, cmd_hash,
-                                             connection->baton,
-                                             connection->conn,
-                                             FALSE, iterpool);
+            {
+              err = svn_ra_svn__handle_command(&terminate, cmd_hash,
+                                               connection->baton,
+                                               connection->conn,
+                                               FALSE, &stats, iterpool);
+              metrics__command_done(connection->params->metrics, &stats);
+            }
 
           break;
         }
@@ -4404,7 +5594,8 @@ serve_interruptable(svn_boolean_t *terminate_p,
           err = svn_ra_svn__handle_command(&terminate, cmd_hash,
                                            connection->baton,
                                            connection->conn,
-                                           FALSE, iterpool);
+                                           FALSE, &stats, iterpool);
+          metrics__command_done(connection->params->metrics, &stats);
         }
     }
 
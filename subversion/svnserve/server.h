@@ -27,6 +27,7 @@
 #define SERVER_H
 
 #include <apr_network_io.h>
+#include <apr_poll.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -90,6 +91,9 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  int update_jobs;         /* Threads computing deltas for updates. */
+  int replay_prefetch;     /* Revisions replayed ahead during replay-range. */
+  int list_jobs;           /* Threads walking the tree for recursive lists. */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -159,6 +163,27 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Number of worker threads computing the text deltas of a single
+     update report.  1 disables concurrent processing. */
+  int update_jobs;
+
+  /* Number of revisions that replay-range prepares ahead of the one
+     currently being sent, each on its own worker thread.  0 disables
+     prefetching. */
+  int replay_prefetch;
+
+  /* Number of worker threads walking the tree of a single recursive
+     list request.  1 disables concurrent processing. */
+  int list_jobs;
+
+  /* Idle open repository handles that later connections may pick up
+     instead of opening the repository again.  NULL disables reuse. */
+  struct repos_cache_t *repos_cache;
+
+  /* Counters and histograms exported by the metrics listener; possibly
+     NULL. */
+  struct metrics_t *metrics;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -192,6 +217,10 @@ typedef struct connection_t
      released.  */
   svn_atomic_t ref_count;
 
+  /* Registration of USOCK in the set of idle connections while waiting
+     for the next command.  Only used in event-driven mode. */
+  apr_pollfd_t pollfd;
+
 } connection_t;
 
 /* Return a client_info_t structure allocated in POOL and initialize it
@@ -221,6 +250,15 @@ serve_interruptable(svn_boolean_t *terminate_p,
                     svn_boolean_t (* is_busy)(connection_t *),
                     apr_pool_t *pool);
 
+/* Create an empty repository handle cache in POOL that keeps up to
+   MAX_IDLE unused handles and return it in *CACHE.  If THREAD_SAFE is
+   set, the cache may be used from multiple threads. */
+svn_error_t *
+repos_cache_create(struct repos_cache_t **cache,
+                   int max_idle,
+                   svn_boolean_t thread_safe,
+                   apr_pool_t *pool);
+
 /* Initialize the Cyrus SASL library. POOL is used for allocations. */
 svn_error_t *cyrus_init(apr_pool_t *pool);
 
@@ -55,8 +55,11 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
@@ -70,13 +73,16 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
-  connection_mode_single  /* One connection at a time in this process */
+  connection_mode_single, /* One connection at a time in this process */
+  connection_mode_event   /* Serve commands from a thread pool and park
+                             idle connections without a thread */
 };
 
 /* The mode in which to run svnserve */
@@ -145,6 +151,12 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of idle connections that become readable and get handed
+ * to the worker threads in one go in event-driven mode.  This does not
+ * limit the number of idle connections.
+ */
+#define IDLE_POLL_BATCH_SIZE 1024
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -164,6 +176,11 @@ enum run_mode {
  */
 #define MAX_REQUEST_SIZE 16
 
+/* Upper limit for the --update-jobs option.  Each job holds its own
+ * FS instance and delta buffer for the duration of a report.
+ */
+#define MAX_UPDATE_JOBS 64
+
 #ifdef WIN32
 static apr_os_sock_t winservice_svnserve_accept_socket = INVALID_SOCKET;
 
@@ -222,6 +239,19 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_CACHE_LOCK_STRIPES 277
+#define SVNSERVE_OPT_CACHE_SHARED    278
+#define SVNSERVE_OPT_UPDATE_JOBS     279
+#define SVNSERVE_OPT_REPLAY_PREFETCH 280
+#define SVNSERVE_OPT_LIST_JOBS       281
+#define SVNSERVE_OPT_EVENT_DRIVEN    282
+#define SVNSERVE_OPT_REPOS_CACHE     283
+#define SVNSERVE_OPT_METRICS_PORT    284
+#define SVNSERVE_OPT_LOG_BUFFER      285
+#define SVNSERVE_OPT_LOG_DROP        286
+#define SVNSERVE_OPT_TRACE_FILE      287
+#define SVNSERVE_OPT_CACHE_WARMUP    288
+#define SVNSERVE_OPT_CACHE_WARMUP_ON_COMMIT 289
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +355,49 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-warmup", SVNSERVE_OPT_CACHE_WARMUP, 1,
+     N_("enable or disable recording the most frequently\n"
+        "                             "
+        "read nodes and preloading them into the caches\n"
+        "                             "
+        "in the background when a repository is opened.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"cache-warmup-on-commit", SVNSERVE_OPT_CACHE_WARMUP_ON_COMMIT, 1,
+     N_("enable or disable preloading the top-level\n"
+        "                             "
+        "directories of each new revision into the caches\n"
+        "                             "
+        "in the background.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"cache-lock-stripes", SVNSERVE_OPT_CACHE_LOCK_STRIPES, 1,
+     N_("number of read locks per in-memory cache segment.\n"
+        "                             "
+        "Higher values reduce lock contention between\n"
+        "                             "
+        "concurrent readers on many-core machines.\n"
+        "                             "
+        "Default is 1."
+        ONLY_AVAILABLE_WITH_THEADS)},
+#if APR_HAS_FORK
+    {"memory-cache-shared", SVNSERVE_OPT_CACHE_SHARED, 1,
+     N_("share the in-memory cache between all server\n"
+        "                             "
+        "processes such that forked children start with a\n"
+        "                             "
+        "warm cache.  ARG may be 'yes', 'no' or the name of\n"
+        "                             "
+        "a shared memory file to use.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[used only when forking a process per connection]")},
+#endif
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -341,6 +414,16 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is no.\n"
         "                             "
         "[used for FSFS repositories in 1.9 format only]")},
+    {"repos-cache-size", SVNSERVE_OPT_REPOS_CACHE, 1,
+     N_("Keep up to ARG idle repository handles open such\n"
+        "                             "
+        "that new connections can skip opening the\n"
+        "                             "
+        "repository again.\n"
+        "                             "
+        "Default is 0 (no handles are kept).\n"
+        "                             "
+        "[not used when forking a process per connection]")},
 #ifdef CONNECTION_HAVE_THREAD_OPTION
     /* ### Making the assumption here that WIN32 never has fork and so
      * ### this option never exists when --service exists. */
@@ -362,6 +445,53 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"update-jobs",      SVNSERVE_OPT_UPDATE_JOBS, 1,
+     N_("Number of threads computing file deltas for a\n"
+        "                             "
+        "single update or checkout request, 1 to "
+        APR_STRINGIFY(MAX_UPDATE_JOBS) ".\n"
+        "                             "
+        "Default is 1 (no concurrent delta computation).")},
+    {"replay-prefetch",  SVNSERVE_OPT_REPLAY_PREFETCH, 1,
+     N_("Number of revisions to replay ahead of the client\n"
+        "                             "
+        "on worker threads during svnsync.\n"
+        "                             "
+        "Default is 0 (no prefetching).")},
+    {"list-jobs",        SVNSERVE_OPT_LIST_JOBS, 1,
+     N_("Number of threads walking the tree for a single\n"
+        "                             "
+        "recursive list request.\n"
+        "                             "
+        "Default is 1 (no concurrent tree walk).")},
+    {"event-driven",     SVNSERVE_OPT_EVENT_DRIVEN, 0,
+     N_("serve commands from the thread pool but let idle\n"
+        "                             "
+        "connections wait without occupying a thread\n"
+        "                             "
+        "(useful for many mostly idle connections)\n"
+        "                             "
+        "[mode: daemon]")},
+    {"metrics-port",     SVNSERVE_OPT_METRICS_PORT, 1,
+     N_("serve command counts, latencies and cache\n"
+        "                             "
+        "statistics for Prometheus over HTTP on port ARG\n"
+        "                             "
+        "of the listen host\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"log-buffer-size",  SVNSERVE_OPT_LOG_BUFFER, 1,
+     N_("let a background thread write the log file and\n"
+        "                             "
+        "buffer up to ARG kB of log data for it.\n"
+        "                             "
+        "Default is 0 (write synchronously).\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"log-drop",         SVNSERVE_OPT_LOG_DROP, 0,
+     N_("drop log lines instead of waiting when the log\n"
+        "                             "
+        "buffer is full")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -396,6 +526,10 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"trace-file",       SVNSERVE_OPT_TRACE_FILE, 1,
+     N_("append timing spans of all requests to file ARG\n"
+        "                             "
+        "in Trace Event JSON format")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -656,6 +790,162 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   return NULL;
 }
 
+/* The set of idle connections in event-driven mode, i.e. those waiting
+   for their next command without a thread serving them. */
+static apr_pollset_t *idle_connections;
+
+/* Callback for serve_interruptable in event-driven mode: Always serve
+   at most the one command currently waiting. */
+static svn_boolean_t
+serve_one_command(connection_t *connection)
+{
+  return TRUE;
+}
+
+/* Add CONNECTION to IDLE_CONNECTIONS until its next command comes in. */
+static apr_status_t
+park_connection(connection_t *connection)
+{
+  connection->pollfd.p = connection->pool;
+  connection->pollfd.desc_type = APR_POLL_SOCKET;
+  connection->pollfd.reqevents = APR_POLLIN;
+  connection->pollfd.desc.s = connection->usock;
+  connection->pollfd.client_data = connection;
+
+  return apr_pollset_add(idle_connections, &connection->pollfd);
+}
+
+/* Serve the commands already waiting on the connection given by DATA.
+   Then park the connection in IDLE_CONNECTIONS, unless it got closed. */
+static void * APR_THREAD_FUNC serve_event(apr_thread_t *tid, void *data)
+{
+  svn_boolean_t done;
+  svn_boolean_t has_command = FALSE;
+  connection_t *connection = data;
+  svn_error_t *err;
+
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+
+  /* process the actual request and log errors */
+  err = serve_interruptable(&done, connection, serve_one_command, pool);
+  if (!err && !done)
+    err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                  pool);
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        pool));
+      svn_error_clear(err);
+      done = TRUE;
+    }
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  /* Close, continue or park the connection.  Pipelined commands don't
+     make the socket readable again, so serve them right away. */
+  if (done)
+    close_connection(connection);
+  else if (has_command)
+    apr_thread_pool_push(threads, serve_event, connection, 0, NULL);
+  else if (park_connection(connection))
+    close_connection(connection);
+
+  return NULL;
+}
+
+/* Wait for commands to arrive on IDLE_CONNECTIONS and hand the respective
+   connections over to THREADS.  This runs for the lifetime of the
+   process. */
+static void * APR_THREAD_FUNC dispatch_idle(apr_thread_t *tid, void *data)
+{
+  while (TRUE)
+    {
+      apr_int32_t count, i;
+      const apr_pollfd_t *ready;
+
+      /* Interrupted waits simply get retried. */
+      if (apr_pollset_poll(idle_connections, -1, &count, &ready))
+        continue;
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = ready[i].client_data;
+
+          /* Don't report the connection again while a thread serves it. */
+          apr_pollset_remove(idle_connections, &connection->pollfd);
+          apr_thread_pool_push(threads, serve_event, connection, 0, NULL);
+        }
+    }
+
+  return NULL;
+}
+
+/* Create IDLE_CONNECTIONS and start the thread dispatching them.  POOL
+   must live as long as the server. */
+static svn_error_t *
+start_idle_dispatcher(apr_pool_t *pool)
+{
+  apr_threadattr_t *attr;
+  apr_thread_t *tid;
+  apr_status_t status;
+
+  /* Worker threads park connections while the dispatcher waits, which
+     the epoll, kqueue and event port implementations support. */
+  status = apr_pollset_create(&idle_connections, IDLE_POLL_BATCH_SIZE,
+                              pool, APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create pollset for idle "
+                                "connections"));
+
+  status = apr_threadattr_create(&attr, pool);
+  if (!status)
+    status = apr_threadattr_detach_set(attr, 1);
+  if (!status)
+    status = apr_thread_create(&tid, attr, dispatch_idle, NULL, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a socket in *SOCK that listens on HOST:PORT for requests to the
+   metrics listener.  FAMILY and FLAGS are as for apr_sockaddr_info_get.
+   Allocate the socket in POOL. */
+static svn_error_t *
+create_metrics_socket(apr_socket_t **sock,
+                      const char *host,
+                      int family,
+                      apr_int32_t flags,
+                      apr_uint16_t port,
+                      apr_pool_t *pool)
+{
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+
+  status = apr_sockaddr_info_get(&sa, host, family, port, flags, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get address info"));
+
+#ifdef MAX_SECS_TO_LINGER
+  /* ### old APR interface */
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, pool);
+#else
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+#endif
+  if (!status)
+    status = apr_socket_opt_set(*sock, APR_SO_REUSEADDR, 1);
+  if (!status)
+    status = apr_socket_bind(*sock, sa);
+  if (!status)
+    status = apr_socket_listen(*sock, ACCEPT_BACKLOG);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't listen on metrics socket"));
+
+  return SVN_NO_ERROR;
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -724,7 +1014,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_nodeprops = TRUE;
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
+  svn_boolean_t cache_warmup = FALSE;
+  svn_boolean_t cache_warmup_on_commit = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  int repos_cache_size = 0;
+  apr_uint16_t metrics_port = 0;
+  apr_size_t log_buffer_size = 0;
+  svn_boolean_t log_drop = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -739,9 +1035,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *trace_filename = NULL;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  apr_size_t cache_lock_stripes = 1;
+  svn_boolean_t cache_shared = FALSE;
+  const char *cache_shm_name = NULL;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -774,6 +1074,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.update_jobs = 1;
+  params.replay_prefetch = 0;
+  params.list_jobs = 1;
+  params.repos_cache = NULL;
+  params.metrics = NULL;
 
   while (1)
     {
@@ -925,10 +1230,43 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_WARMUP:
+          cache_warmup = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
+        case SVNSERVE_OPT_CACHE_WARMUP_ON_COMMIT:
+          cache_warmup_on_commit
+            = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
+        case SVNSERVE_OPT_CACHE_LOCK_STRIPES:
+          cache_lock_stripes = (apr_size_t)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_CACHE_SHARED:
+          {
+            svn_tristate_t value = svn_tristate__from_word(arg);
+            if (value == svn_tristate_unknown)
+              {
+                /* Anything but yes / no is the name of the region. */
+                cache_shm_name = arg;
+                cache_shared = TRUE;
+              }
+            else
+              {
+                cache_shared = value == svn_tristate_true;
+              }
+          }
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_REPOS_CACHE:
+          repos_cache_size = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -962,6 +1300,52 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_UPDATE_JOBS:
+          {
+            apr_uint64_t val;
+
+            err = svn_cstring_strtoui64(&val, arg, 1, MAX_UPDATE_JOBS, 10);
+            if (err)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                       _("Invalid number of update jobs "
+                                         "'%s'"), arg);
+            params.update_jobs = (int)val;
+          }
+          break;
+
+        case SVNSERVE_OPT_REPLAY_PREFETCH:
+          params.replay_prefetch = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_LIST_JOBS:
+          params.list_jobs = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_EVENT_DRIVEN:
+          handling_mode = connection_mode_event;
+          handling_opt_count++;
+          break;
+
+        case SVNSERVE_OPT_METRICS_PORT:
+          {
+            apr_uint64_t val;
+
+            err = svn_cstring_strtoui64(&val, arg, 1, APR_UINT16_MAX, 10);
+            if (err)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                       _("Invalid port '%s'"), arg);
+            metrics_port = (apr_uint16_t)val;
+          }
+          break;
+
+        case SVNSERVE_OPT_LOG_BUFFER:
+          log_buffer_size = 0x400 * (apr_size_t)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_LOG_DROP:
+          log_drop = TRUE;
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1379,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_TRACE_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&trace_filename, arg, pool));
+          trace_filename = svn_dirent_internal_style(trace_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&trace_filename, trace_filename,
+                                          pool));
+          break;
+
         }
     }
 
@@ -1029,7 +1420,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   if (handling_opt_count > 1)
     {
       svn_error_clear(svn_cmdline_fputs(
-                      _("You may only specify one of -T or --single-thread\n"),
+                      _("You may only specify one of -T, --single-thread "
+                        "or --event-driven\n"),
                       stderr, pool));
       usage(argv[0], pool);
       *exit_code = EXIT_FAILURE;
@@ -1037,7 +1429,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
   /* construct object pools */
-  is_multi_threaded = handling_mode == connection_mode_thread;
+  is_multi_threaded = handling_mode == connection_mode_thread
+                   || handling_mode == connection_mode_event;
   params.fs_config = apr_hash_make(pool);
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1047,6 +1440,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                 cache_nodeprops ? "1" :"0");
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS,
                 cache_revprops ? "2" :"0");
+  svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP,
+                cache_warmup ? "1" :"0");
+  svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT,
+                cache_warmup_on_commit ? "1" :"0");
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
                 use_block_read ? "1" :"0");
 
@@ -1054,6 +1451,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                         is_multi_threaded,
                                         pool));
 
+  /* Forked children serve a single connection each, so they would
+   * never get to reuse a cached repository handle. */
+  if (repos_cache_size > 0 && handling_mode != connection_mode_fork)
+    SVN_ERR(repos_cache_create(&params.repos_cache, repos_cache_size,
+                               is_multi_threaded, pool));
+
   /* If a configuration file is specified, load it and any referenced
    * password and authorization files. */
   if (config_filename)
@@ -1073,12 +1476,42 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else if (run_mode == run_mode_listen_once)
     SVN_ERR(logger__create_for_stderr(&params.logger, pool));
 
+  if (trace_filename)
+    SVN_ERR(svn_trace__init(trace_filename, pool));
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  /* Forked children would count their commands in their own copy of
+   * the metrics, invisible to the listener. */
+  if (metrics_port
+      && (run_mode == run_mode_inetd || run_mode == run_mode_tunnel
+          || (handling_mode == connection_mode_fork
+              && run_mode != run_mode_listen_once)))
+    {
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+               _("Option --metrics-port is not valid in inetd or tunnel "
+                 "mode or when forking a process per connection"));
+    }
+
+  if (metrics_port)
+    SVN_ERR(metrics__create(&params.metrics, pool));
+
+  /* Forked children would buffer into their own copy of the log buffer
+   * without any thread to flush it. */
+  if (log_buffer_size
+      && (run_mode == run_mode_inetd || run_mode == run_mode_tunnel
+          || (handling_mode == connection_mode_fork
+              && run_mode != run_mode_listen_once)))
+    {
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+               _("Option --log-buffer-size is not valid in inetd or tunnel "
+                 "mode or when forking a process per connection"));
+    }
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1280,10 +1713,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       settings.cache_size = params.memory_cache_size;
 
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (is_multi_threaded)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
+        svn_cache__config_set_lock_stripes(cache_lock_stripes);
 #else
         /* No requests will be processed at all
          * (see "switch (handling_mode)" code further down).
@@ -1294,13 +1728,27 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
       }
 
+    /* Children forked per connection may share one cache that outlives
+     * them.  It must be created before the first child gets forked. */
+    if (handling_mode == connection_mode_fork)
+      svn_cache__config_set_shared(cache_shared, cache_shm_name);
+
     svn_cache_config_set(&settings);
+
+    if (svn_cache__config_get_shared())
+      svn_cache__get_global_membuffer_cache();
   }
 
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
-  if (handling_mode == connection_mode_thread)
+  /* Processes that serve a single connection may exit before queued
+     post-commit hooks complete in the background. */
+  if (is_multi_threaded
+      && (run_mode == run_mode_daemon || run_mode == run_mode_service))
+    SVN_ERR(svn_repos__hook_queue_start(pool));
+
+  if (is_multi_threaded)
     {
       /* create the thread pool with a valid range of threads */
       if (max_thread_count < 1)
@@ -1323,11 +1771,29 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      if (handling_mode == connection_mode_event)
+        SVN_ERR(start_idle_dispatcher(pool));
     }
   else
     {
       threads = NULL;
     }
+
+  if (params.metrics)
+    {
+      apr_socket_t *metrics_sock;
+
+      SVN_ERR(create_metrics_socket(&metrics_sock, host, family,
+                                    sockaddr_info_flags, metrics_port,
+                                    pool));
+      metrics__set_thread_pool(params.metrics, threads);
+      SVN_ERR(metrics__start_listener(params.metrics, metrics_sock, pool));
+    }
+
+  if (log_buffer_size && params.logger)
+    SVN_ERR(logger__start_flusher(params.logger, log_buffer_size, log_drop,
+                                  pool));
 #endif
 
   while (1)
@@ -1382,6 +1848,19 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
           break;
 
+        case connection_mode_event:
+#if APR_HAS_THREADS
+          attach_connection(connection);
+
+          status = apr_thread_pool_push(threads, serve_event, connection,
+                                        0, NULL);
+          if (status)
+            {
+              return svn_error_wrap_apr(status, _("Can't push task"));
+            }
+#endif
+          break;
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           /* serve_socket() logs any error it returns, so ignore it. */
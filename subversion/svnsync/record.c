@@ -0,0 +1,593 @@
+/*
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_subr_private.h"
+
+#include "sync.h"
+
+#include "svn_private_config.h"
+
+
+/* Text deltas get kept in memory up to this size per revision.  Beyond
+ * that, they are spilled to a temporary file. */
+#define RECORDING_MEMORY_SIZE (1024 * 1024)
+
+/* The editor calls that we record. */
+typedef enum op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+/* A single recorded editor call.  Directory and file batons are
+ * represented by numbers, with 0 being the root directory. */
+typedef struct recorded_op_t
+{
+  op_kind_t kind;
+
+  /* The baton the call operates on or, for calls that create a new
+   * baton, the number of the new one. */
+  int node;
+
+  /* The parent directory baton for calls that take one. */
+  int parent;
+
+  const char *path;
+  const char *copyfrom_path;
+
+  /* Target, base or copy-from revision, depending on KIND. */
+  svn_revnum_t revision;
+
+  /* Property changes. */
+  const char *name;
+  const svn_string_t *value;
+
+  /* Base checksum for apply_textdelta and text checksum for close_file. */
+  const char *checksum;
+
+  /* Number of svndiff bytes in the recording's spill buffer that belong
+   * to an apply_textdelta call. */
+  svn_filesize_t delta_len;
+
+  struct recorded_op_t *next;
+} recorded_op_t;
+
+struct svnsync_recording_t
+{
+  apr_pool_t *pool;
+
+  /* The calls in the order they have been made. */
+  recorded_op_t *first;
+  recorded_op_t *last;
+
+  /* Number of batons handed out so far. */
+  int nodes;
+
+  /* The svndiff data of all text deltas, in call order. */
+  svn_spillbuf_t *deltas;
+  svn_stream_t *deltas_stream;
+};
+
+/* Directory and file baton of the recording editor. */
+typedef struct node_baton_t
+{
+  svnsync_recording_t *recording;
+  int node;
+} node_baton_t;
+
+/* Baton for the text delta window handler. */
+typedef struct delta_baton_t
+{
+  recorded_op_t *op;
+  svn_spillbuf_t *deltas;
+  svn_filesize_t start;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+} delta_baton_t;
+
+/* Append a new call of KIND on NODE to RECORDING and return it. */
+static recorded_op_t *
+add_op(svnsync_recording_t *recording,
+       op_kind_t kind,
+       int node)
+{
+  recorded_op_t *op = apr_pcalloc(recording->pool, sizeof(*op));
+
+  op->kind = kind;
+  op->node = node;
+  op->revision = SVN_INVALID_REVNUM;
+
+  if (recording->last)
+    recording->last->next = op;
+  else
+    recording->first = op;
+  recording->last = op;
+
+  return op;
+}
+
+/* Return a new baton for RECORDING. */
+static node_baton_t *
+make_node_baton(svnsync_recording_t *recording)
+{
+  node_baton_t *nb = apr_palloc(recording->pool, sizeof(*nb));
+
+  nb->recording = recording;
+  nb->node = recording->nodes++;
+
+  return nb;
+}
+
+/* Return a copy of the optional VALUE in POOL. */
+static const svn_string_t *
+dup_value(const svn_string_t *value,
+          apr_pool_t *pool)
+{
+  return value ? svn_string_dup(value, pool) : NULL;
+}
+
+/*** Editor callbacks ***/
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  svnsync_recording_t *recording = edit_baton;
+  recorded_op_t *op = add_op(recording, op_set_target_revision, 0);
+
+  op->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  svnsync_recording_t *recording = edit_baton;
+  node_baton_t *nb = make_node_baton(recording);
+  recorded_op_t *op = add_op(recording, op_open_root, nb->node);
+
+  op->revision = base_revision;
+  *root_baton = nb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t base_revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  svnsync_recording_t *recording = pb->recording;
+  recorded_op_t *op = add_op(recording, op_delete_entry, pb->node);
+
+  op->path = apr_pstrdup(recording->pool, path);
+  op->revision = base_revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the addition or opening of the node PATH in the directory
+ * PARENT_BATON as call KIND and return the new baton in *CHILD_BATON. */
+static svn_error_t *
+add_or_open(op_kind_t kind,
+            const char *path,
+            void *parent_baton,
+            const char *copyfrom_path,
+            svn_revnum_t revision,
+            void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  svnsync_recording_t *recording = pb->recording;
+  node_baton_t *nb = make_node_baton(recording);
+  recorded_op_t *op = add_op(recording, kind, nb->node);
+
+  op->parent = pb->node;
+  op->path = apr_pstrdup(recording->pool, path);
+  op->copyfrom_path = copyfrom_path
+                    ? apr_pstrdup(recording->pool, copyfrom_path)
+                    : NULL;
+  op->revision = revision;
+  *child_baton = nb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_rev,
+              apr_pool_t *pool,
+              void **child_baton)
+{
+  return add_or_open(op_add_directory, path, parent_baton, copyfrom_path,
+                     copyfrom_rev, child_baton);
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  return add_or_open(op_open_directory, path, parent_baton, NULL,
+                     base_revision, child_baton);
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_rev,
+         apr_pool_t *pool,
+         void **file_baton)
+{
+  return add_or_open(op_add_file, path, parent_baton, copyfrom_path,
+                     copyfrom_rev, file_baton);
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **file_baton)
+{
+  return add_or_open(op_open_file, path, parent_baton, NULL,
+                     base_revision, file_baton);
+}
+
+/* Record the change of property NAME to VALUE on the node in BATON. */
+static svn_error_t *
+change_prop(op_kind_t kind,
+            void *baton,
+            const char *name,
+            const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  svnsync_recording_t *recording = nb->recording;
+  recorded_op_t *op = add_op(recording, kind, nb->node);
+
+  op->name = apr_pstrdup(recording->pool, name);
+  op->value = dup_value(value, recording->pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  return change_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  return change_prop(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *pool)
+{
+  node_baton_t *nb = dir_baton;
+
+  add_op(nb->recording, op_close_directory, nb->node);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->recording, op_absent_directory, pb->node);
+
+  op->path = apr_pstrdup(pb->recording->pool, path);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->recording, op_absent_file, pb->node);
+
+  op->path = apr_pstrdup(pb->recording->pool, path);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t.  Forward WINDOW to the svndiff
+ * encoder and, at the end of the delta, note the number of bytes it
+ * produced. */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  delta_baton_t *db = baton;
+
+  SVN_ERR(db->handler(window, db->handler_baton));
+  if (window == NULL)
+    db->op->delta_len = svn_spillbuf__get_size(db->deltas) - db->start;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  node_baton_t *nb = file_baton;
+  svnsync_recording_t *recording = nb->recording;
+  recorded_op_t *op = add_op(recording, op_apply_textdelta, nb->node);
+  delta_baton_t *db = apr_palloc(pool, sizeof(*db));
+
+  op->checksum = base_checksum
+               ? apr_pstrdup(recording->pool, base_checksum)
+               : NULL;
+
+  db->op = op;
+  db->deltas = recording->deltas;
+  db->start = svn_spillbuf__get_size(recording->deltas);
+
+  /* svndiff0 is cheap to produce and to parse again; we only need to
+   * buffer the delta until it gets committed. */
+  svn_txdelta_to_svndiff3(&db->handler, &db->handler_baton,
+                          svn_stream_disown(recording->deltas_stream, pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  *handler = record_window;
+  *handler_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  node_baton_t *nb = file_baton;
+  recorded_op_t *op = add_op(nb->recording, op_close_file, nb->node);
+
+  op->checksum = text_checksum
+               ? apr_pstrdup(nb->recording->pool, text_checksum)
+               : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* The edit gets closed by whoever replays the recording. */
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svnsync_get_record_editor(const svn_delta_editor_t **editor,
+                          void **edit_baton,
+                          svnsync_recording_t **recording,
+                          apr_pool_t *result_pool)
+{
+  svn_delta_editor_t *record_editor = svn_delta_default_editor(result_pool);
+  svnsync_recording_t *new_recording = apr_pcalloc(result_pool,
+                                                   sizeof(*new_recording));
+
+  record_editor->set_target_revision = set_target_revision;
+  record_editor->open_root = open_root;
+  record_editor->delete_entry = delete_entry;
+  record_editor->add_directory = add_directory;
+  record_editor->open_directory = open_directory;
+  record_editor->change_dir_prop = change_dir_prop;
+  record_editor->close_directory = close_directory;
+  record_editor->absent_directory = absent_directory;
+  record_editor->add_file = add_file;
+  record_editor->open_file = open_file;
+  record_editor->apply_textdelta = apply_textdelta;
+  record_editor->change_file_prop = change_file_prop;
+  record_editor->close_file = close_file;
+  record_editor->absent_file = absent_file;
+  record_editor->close_edit = close_edit;
+
+  new_recording->pool = result_pool;
+  new_recording->deltas = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                               RECORDING_MEMORY_SIZE,
+                                               result_pool);
+  new_recording->deltas_stream
+    = svn_stream__from_spillbuf(new_recording->deltas, result_pool);
+
+  *editor = record_editor;
+  *edit_baton = new_recording;
+  *recording = new_recording;
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the next LEN bytes of svndiff data in RECORDING to the delta
+ * window HANDLER with HANDLER_BATON.  BUFFER provides
+ * SVN__STREAM_CHUNK_SIZE bytes of scratch space. */
+static svn_error_t *
+replay_delta(svnsync_recording_t *recording,
+             svn_filesize_t len,
+             svn_txdelta_window_handler_t handler,
+             void *handler_baton,
+             char *buffer,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *parser = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                   TRUE, scratch_pool);
+
+  while (len > 0)
+    {
+      apr_size_t chunk = (apr_size_t)MIN(len, SVN__STREAM_CHUNK_SIZE);
+      apr_size_t read = chunk;
+
+      SVN_ERR(svn_stream_read_full(recording->deltas_stream, buffer, &read));
+      if (read != chunk)
+        return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                _("Recorded text delta is truncated"));
+
+      SVN_ERR(svn_stream_write(parser, buffer, &read));
+      len -= read;
+    }
+
+  return svn_error_trace(svn_stream_close(parser));
+}
+
+svn_error_t *
+svnsync_replay_recording(svnsync_recording_t *recording,
+                         const svn_delta_editor_t *editor,
+                         void *edit_baton,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  void **batons = apr_pcalloc(scratch_pool,
+                              MAX(recording->nodes, 1) * sizeof(*batons));
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  recorded_op_t *op;
+
+  /* Directory and file batons must remain valid until they get closed,
+   * so we allocate them in SCRATCH_POOL. */
+  for (op = recording->first; op; op = op->next)
+    {
+      void *parent = batons[op->parent];
+      void *node = batons[op->node];
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+
+      svn_pool_clear(iterpool);
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, scratch_pool,
+                                      &batons[op->node]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, node,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, parent, op->copyfrom_path,
+                                          op->revision, scratch_pool,
+                                          &batons[op->node]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, parent, op->revision,
+                                           scratch_pool, &batons[op->node]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(node, op->name, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(node, iterpool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, node, iterpool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->path, parent, op->copyfrom_path,
+                                     op->revision, scratch_pool,
+                                     &batons[op->node]));
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->path, parent, op->revision,
+                                      scratch_pool, &batons[op->node]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(node, op->checksum, scratch_pool,
+                                            &handler, &handler_baton));
+            SVN_ERR(replay_delta(recording, op->delta_len, handler,
+                                 handler_baton, buffer, iterpool));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(node, op->name, op->value,
+                                             iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(node, op->checksum, iterpool));
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, node, iterpool));
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
@@ -30,6 +30,7 @@
 #include "svn_auth.h"
 #include "svn_opt.h"
 #include "svn_ra.h"
+#include "svn_sorts.h"
 #include "svn_utf.h"
 #include "svn_subst.h"
 #include "svn_string.h"
@@ -38,6 +39,8 @@
 #include "private/svn_opt_private.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 #include "sync.h"
 
@@ -71,9 +74,13 @@ enum svnsync__opt {
   svnsync_opt_trust_server_cert_failures_dst,
   svnsync_opt_allow_non_empty,
   svnsync_opt_skip_unchanged,
-  svnsync_opt_steal_lock
+  svnsync_opt_steal_lock,
+  svnsync_opt_fetch_ahead
 };
 
+/* Default for --fetch-ahead. */
+#define SVNSYNC_DEFAULT_FETCH_AHEAD 2
+
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
                              svnsync_opt_force_interactive, \
                              svnsync_opt_no_auth_cache, \
@@ -129,7 +136,8 @@ static const svn_opt_subcommand_desc2_t svnsync_cmd_table[] =
          "if untrusted users/administrators may have write access to the\n"
          "DEST_URL repository.\n"),
       { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
-        svnsync_opt_disable_locking, svnsync_opt_steal_lock, 'M' } },
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_fetch_ahead, 'M' } },
     { "copy-revprops", copy_revprops_cmd, { 0 },
       N_("usage:\n"
          "\n"
@@ -274,6 +282,14 @@ static const apr_getopt_option_t svnsync_options[] =
                           "and is not being concurrently accessed by another\n"
                           "                             "
                           "svnsync instance.")},
+    {"fetch-ahead",    svnsync_opt_fetch_ahead, 1,
+                       N_("fetch up to ARG further revisions from the\n"
+                          "                             "
+                          "source, each over its own connection, while\n"
+                          "                             "
+                          "committing the current one (default: 2).\n"
+                          "                             "
+                          "0 transfers one revision at a time.")},
     {"memory-cache-size", 'M', 1,
                        N_("size of the extra in-memory cache in MB used to\n"
                           "                             "
@@ -311,6 +327,7 @@ typedef struct opt_baton_t {
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
   svn_boolean_t skip_unchanged;
+  int fetch_ahead;
   svn_boolean_t version;
   svn_boolean_t help;
   svn_opt_revision_t start_rev;
@@ -420,6 +437,7 @@ typedef struct subcommand_baton_t {
 
   /* synchronize only */
   svn_revnum_t committed_rev;
+  int fetch_ahead;
 
   /* copy-revprops only */
   svn_revnum_t start_rev;
@@ -688,6 +706,9 @@ log_properties_normalized(int normalized_rev_props_count,
  * If QUIET is FALSE, then log_properties_copied() is called to log that
  * properties were copied for revision REV.
  *
+ * If SOURCE_PROPS is not NULL, it contains the revision properties of
+ * REV in the source repository and FROM_SESSION will not be used.
+ *
  * Make sure the values of svn:* revision properties use only LF (\n)
  * line ending style, correcting their values as necessary. The number
  * of properties that were normalized is returned in *NORMALIZED_COUNT.
@@ -696,6 +717,7 @@ static svn_error_t *
 copy_revprops(svn_ra_session_t *from_session,
               svn_ra_session_t *to_session,
               svn_revnum_t rev,
+              apr_hash_t *source_props,
               svn_boolean_t sync,
               svn_boolean_t skip_unchanged,
               svn_boolean_t quiet,
@@ -715,7 +737,10 @@ copy_revprops(svn_ra_session_t *from_session,
     existing_props = NULL;
 
   /* Get the list of revision properties on REV of SOURCE. */
-  SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
+  if (source_props)
+    rev_props = source_props;
+  else
+    SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
 
   /* If necessary, normalize encoding and line ending style and return the count
      of EOL-normalized properties in int *NORMALIZED_COUNT. */
@@ -762,6 +787,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->quiet = opt_baton->quiet;
   b->skip_unchanged = opt_baton->skip_unchanged;
   b->allow_non_empty = opt_baton->allow_non_empty;
+  b->fetch_ahead = opt_baton->fetch_ahead;
   b->to_url = to_url;
   b->source_prop_encoding = opt_baton->source_prop_encoding;
   b->from_url = from_url;
@@ -870,7 +896,7 @@ do_initialize(svn_ra_session_t *to_session,
      LATEST is not 0, this really serves merely aesthetic and
      informational purposes, keeping the output of this command
      consistent while allowing folks to see what the latest revision is.  */
-  SVN_ERR(copy_revprops(from_session, to_session, latest, FALSE, FALSE,
+  SVN_ERR(copy_revprops(from_session, to_session, latest, NULL, FALSE, FALSE,
                         baton->quiet, baton->source_prop_encoding,
                         &normalized_rev_props_count, pool));
 
@@ -1419,6 +1445,221 @@ replay_rev_finished(svn_revnum_t revision,
   return SVN_NO_ERROR;
 }
 
+/* Number of revisions to queue for fetching before waiting for all of
+ * them to be committed and releasing their batons. */
+#define FETCH_BATCH_SIZE 1000
+
+/* Source sessions for fetching revisions ahead of their commit.  Each
+ * session is used by one fetch at a time. */
+typedef struct fetch_sessions_t
+{
+  svn_mutex__t *mutex;
+
+  /* The svn_ra_session_t * not currently in use. */
+  apr_array_header_t *idle;
+} fetch_sessions_t;
+
+/* Baton for fetch_rev(). */
+typedef struct fetch_baton_t
+{
+  fetch_sessions_t *sessions;
+  svn_revnum_t revision;
+} fetch_baton_t;
+
+/* A revision that has been fetched from the source but not committed. */
+typedef struct fetched_rev_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+  svnsync_recording_t *recording;
+} fetched_rev_t;
+
+/* Pool cleanup function destroying the pool in DATA. */
+static apr_status_t
+destroy_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Take an idle session from SESSIONS and return it in *SESSION. */
+static svn_error_t *
+take_session(svn_ra_session_t **session,
+             fetch_sessions_t *sessions)
+{
+  svn_ra_session_t *idle = NULL;
+
+  SVN_ERR(svn_mutex__lock(sessions->mutex));
+  if (sessions->idle->nelts > 0)
+    idle = APR_ARRAY_IDX(sessions->idle, --sessions->idle->nelts,
+                         svn_ra_session_t *);
+  SVN_ERR(svn_mutex__unlock(sessions->mutex, SVN_NO_ERROR));
+
+  /* There is one session per thread that may be fetching. */
+  SVN_ERR_ASSERT(idle != NULL);
+
+  *session = idle;
+  return SVN_NO_ERROR;
+}
+
+/* Return SESSION to the idle ones in SESSIONS and return ERR. */
+static svn_error_t *
+release_session(fetch_sessions_t *sessions,
+                svn_ra_session_t *session,
+                svn_error_t *err)
+{
+  svn_error_t *lock_err = svn_mutex__lock(sessions->mutex);
+  if (lock_err)
+    return svn_error_compose_create(err, lock_err);
+
+  APR_ARRAY_PUSH(sessions->idle, svn_ra_session_t *) = session;
+
+  return svn_error_trace(svn_mutex__unlock(sessions->mutex, err));
+}
+
+/* Implements svn_task__process_func_t.  Fetch the revision properties
+ * and changes of the revision given by the fetch_baton_t in BATON and
+ * return them in a fetched_rev_t.  This may run in any thread. */
+static svn_error_t *
+fetch_rev(void **result,
+          void *baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  fetch_baton_t *fb = baton;
+  fetched_rev_t *fetched = apr_pcalloc(result_pool, sizeof(*fetched));
+  const svn_delta_editor_t *record_editor, *cancel_editor;
+  void *record_baton, *cancel_edit_baton;
+  svn_ra_session_t *session;
+  svn_error_t *err;
+
+  fetched->revision = fb->revision;
+  SVN_ERR(svnsync_get_record_editor(&record_editor, &record_baton,
+                                    &fetched->recording, result_pool));
+  SVN_ERR(svn_delta_get_cancellation_editor(cancel_func, cancel_baton,
+                                            record_editor, record_baton,
+                                            &cancel_editor,
+                                            &cancel_edit_baton,
+                                            scratch_pool));
+
+  SVN_ERR(take_session(&session, fb->sessions));
+  err = svn_ra_rev_proplist(session, fb->revision, &fetched->rev_props,
+                            result_pool);
+  if (!err)
+    err = svn_ra_replay(session, fb->revision, 0, TRUE,
+                        cancel_editor, cancel_edit_baton, scratch_pool);
+  SVN_ERR(release_session(fb->sessions, session, err));
+
+  *result = fetched;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Commit the fetched_rev_t in RESULT
+ * using the replay_baton_t in BATON, just like svn_ra_replay_range()
+ * would have, using replay_rev_started() and replay_rev_finished(). */
+static svn_error_t *
+commit_fetched_rev(void *result,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  fetched_rev_t *fetched = result;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  SVN_ERR(replay_rev_started(fetched->revision, baton, &editor, &edit_baton,
+                             fetched->rev_props, scratch_pool));
+  SVN_ERR(svnsync_replay_recording(fetched->recording, editor, edit_baton,
+                                   scratch_pool));
+  SVN_ERR(replay_rev_finished(fetched->revision, baton, editor, edit_baton,
+                              fetched->rev_props, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy START_REVISION through END_REVISION like svn_ra_replay_range()
+ * does with RB, but fetch up to FETCH_AHEAD revisions from the source
+ * while committing the current one.  Each fetch uses its own session,
+ * so the round-trips to the source and to the destination overlap.
+ * The commits and all revprop changes on the destination still happen
+ * strictly in order, on the current thread.
+ *
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+replay_fetched_ahead(replay_baton_t *rb,
+                     svn_revnum_t start_revision,
+                     svn_revnum_t end_revision,
+                     int fetch_ahead,
+                     apr_pool_t *pool)
+{
+  fetch_sessions_t *sessions = apr_pcalloc(pool, sizeof(*sessions));
+  apr_pool_t *set_pool;
+  apr_pool_t *batch_pool;
+  svn_task__set_t *set;
+  svn_revnum_t revision;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&sessions->mutex, TRUE, pool));
+
+  /* While waiting for results, this thread helps with the fetching.
+   * Hence the extra session.
+   *
+   * The sessions may be used by any thread, so they must not share a
+   * (non thread-safe) allocator with POOL. */
+  sessions->idle = apr_array_make(pool, fetch_ahead + 1,
+                                  sizeof(svn_ra_session_t *));
+  for (i = 0; i <= fetch_ahead; i++)
+    {
+      apr_pool_t *session_pool = svn_pool_create(NULL);
+      svn_ra_session_t *session;
+      svn_revnum_t youngest;
+
+      apr_pool_cleanup_register(pool, session_pool, destroy_pool,
+                                apr_pool_cleanup_null);
+      SVN_ERR(svn_ra__dup_session(&session, rb->from_session, NULL,
+                                  session_pool, pool));
+
+      /* Make sure that any authentication happens here.  The sessions
+       * share the auth baton, which must not be used concurrently. */
+      SVN_ERR(svn_ra_get_latest_revnum(session, &youngest, pool));
+
+      APR_ARRAY_PUSH(sessions->idle, svn_ra_session_t *) = session;
+    }
+
+  /* Sub-pools get destroyed before the cleanups above run, the youngest
+   * first.  So, upon error, the task set will be done with all sessions
+   * and fetch batons before they go. */
+  batch_pool = svn_pool_create(pool);
+  set_pool = svn_pool_create(pool);
+  SVN_ERR(svn_task__set_create(&set, fetch_ahead, commit_fetched_rev, rb,
+                               check_cancel, NULL, set_pool));
+
+  for (revision = start_revision; revision <= end_revision; revision++)
+    {
+      fetch_baton_t *fb;
+
+      if ((revision - start_revision) % FETCH_BATCH_SIZE == 0)
+        {
+          SVN_ERR(svn_task__set_finish(set));
+          svn_pool_clear(batch_pool);
+        }
+
+      fb = apr_palloc(batch_pool, sizeof(*fb));
+      fb->sessions = sessions;
+      fb->revision = revision;
+
+      SVN_ERR(svn_task__add(set, fetch_rev, fb));
+    }
+
+  SVN_ERR(svn_task__set_finish(set));
+  svn_pool_destroy(set_pool);
+  svn_pool_destroy(batch_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Synchronize the repository associated with RA session TO_SESSION,
  * using information found in BATON.
  *
@@ -1488,7 +1729,8 @@ do_synchronize(svn_ra_session_t *to_session,
         {
           if (copying > last_merged)
             {
-              SVN_ERR(copy_revprops(from_session, to_session, to_latest, TRUE,
+              SVN_ERR(copy_revprops(from_session, to_session, to_latest,
+                                    NULL, TRUE,
                                     baton->skip_unchanged, baton->quiet,
                                     baton->source_prop_encoding,
                                     &normalized_rev_props_count, pool));
@@ -1551,9 +1793,16 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  /* Fetching ahead needs worker threads.  With a single revision to
+   * copy, there is nothing to fetch ahead. */
+  if (baton->fetch_ahead > 0 && end_revision > start_revision
+      && svn_task__get_thread_limit() > 0)
+    SVN_ERR(replay_fetched_ahead(rb, start_revision, end_revision,
+                                 baton->fetch_ahead, pool));
+  else
+    SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
+                                0, TRUE, replay_rev_started,
+                                replay_rev_finished, rb, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -1616,6 +1865,77 @@ synchronize_cmd(apr_getopt_t *os, void *b, apr_pool_t *pool)
 
 /*** `svnsync copy-revprops' ***/
 
+/* Number of revisions whose revision properties copy-revprops requests
+ * from the source at once. */
+#define REVPROPS_BATCH_SIZE 1000
+
+/* Revision properties of a range of source revisions. */
+typedef struct revprops_batch_t
+{
+  svn_revnum_t oldest;
+  svn_revnum_t youngest;
+
+  /* The properties of revision OLDEST + N at index N or NULL if they
+   * have not been received. */
+  apr_hash_t **props;
+
+  apr_pool_t *pool;
+} revprops_batch_t;
+
+/* Implements svn_log_entry_receiver_t for the revprops_batch_t in BATON. */
+static svn_error_t *
+batch_revprops_receiver(void *baton,
+                        svn_log_entry_t *log_entry,
+                        apr_pool_t *pool)
+{
+  revprops_batch_t *batch = baton;
+
+  if (log_entry->revision >= batch->oldest
+      && log_entry->revision <= batch->youngest)
+    batch->props[log_entry->revision - batch->oldest]
+      = log_entry->revprops
+      ? svn_prop_hash_dup(log_entry->revprops, batch->pool)
+      : apr_hash_make(batch->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the revision properties of revisions START through END from the
+ * repository of FROM_SESSION, which must be opened at the repository
+ * root, with a single request.  Return them in *BATCH, allocated in
+ * RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+fetch_revprops_batch(revprops_batch_t **batch,
+                     svn_ra_session_t *from_session,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  revprops_batch_t *new_batch = apr_pcalloc(result_pool, sizeof(*new_batch));
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+
+  new_batch->oldest = MIN(start, end);
+  new_batch->youngest = MAX(start, end);
+  new_batch->props = apr_pcalloc(result_pool,
+                                 (new_batch->youngest - new_batch->oldest + 1)
+                                   * sizeof(*new_batch->props));
+  new_batch->pool = result_pool;
+
+  /* The log of the repository root covers every revision and, without a
+   * list of REVPROPS to return, contains all revision properties. */
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  SVN_ERR(svn_ra_get_log2(from_session, paths, start, end, 0,
+                          FALSE, FALSE, FALSE, NULL,
+                          batch_revprops_receiver, new_batch,
+                          scratch_pool));
+
+  *batch = new_batch;
+  return SVN_NO_ERROR;
+}
+
 /* Copy revision properties to the repository associated with RA
  * session TO_SESSION, using information found in BATON.
  *
@@ -1631,6 +1951,10 @@ do_copy_revprops(svn_ra_session_t *to_session,
   svn_revnum_t i;
   svn_revnum_t step = 1;
   int normalized_rev_props_count = 0;
+  const char *session_url, *repos_root;
+  svn_boolean_t batched;
+  revprops_batch_t *batch = NULL;
+  apr_pool_t *batch_pool = svn_pool_create(pool);
 
   SVN_ERR(open_source_session(&from_session, &last_merged_rev,
                               baton->from_url, to_session,
@@ -1655,19 +1979,51 @@ do_copy_revprops(svn_ra_session_t *to_session,
        _("Cannot copy revprops for a revision (%ld) that has not "
          "been synchronized yet"), baton->end_rev);
 
+  /* Rather than asking for the revprops of each revision separately,
+     get them for many revisions at once from the log.  That is only
+     complete when we mirror the whole source repository. */
+  SVN_ERR(svn_ra_get_session_url(from_session, &session_url, pool));
+  SVN_ERR(svn_ra_get_repos_root2(from_session, &repos_root, pool));
+  batched = (strcmp(session_url, repos_root) == 0);
+
   /* Now, copy all the requested revisions, in the requested order. */
   step = (baton->start_rev > baton->end_rev) ? -1 : 1;
   for (i = baton->start_rev; i != baton->end_rev + step; i = i + step)
     {
       int normalized_count;
+      apr_hash_t *source_props = NULL;
+
       SVN_ERR(check_cancel(NULL));
-      SVN_ERR(copy_revprops(from_session, to_session, i, TRUE,
+
+      if (batched)
+        {
+          if (!batch || i < batch->oldest || i > batch->youngest)
+            {
+              svn_revnum_t last = i + step * (REVPROPS_BATCH_SIZE - 1);
+
+              if (step > 0)
+                last = MIN(last, baton->end_rev);
+              else
+                last = MAX(last, baton->end_rev);
+
+              svn_pool_clear(batch_pool);
+              SVN_ERR(fetch_revprops_batch(&batch, from_session, i, last,
+                                           batch_pool, pool));
+            }
+
+          /* Revisions missing from the log get fetched individually. */
+          source_props = batch->props[i - batch->oldest];
+        }
+
+      SVN_ERR(copy_revprops(from_session, to_session, i, source_props, TRUE,
                             baton->skip_unchanged, baton->quiet,
                             baton->source_prop_encoding, &normalized_count,
                             pool));
       normalized_rev_props_count += normalized_count;
     }
 
+  svn_pool_destroy(batch_pool);
+
   /* Notify about normalized props, if any. */
   SVN_ERR(log_properties_normalized(normalized_rev_props_count, 0, pool));
 
@@ -1983,6 +2339,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   memset(&opt_baton, 0, sizeof(opt_baton));
   opt_baton.start_rev.kind = svn_opt_revision_unspecified;
   opt_baton.end_rev.kind = svn_opt_revision_unspecified;
+  opt_baton.fetch_ahead = SVNSYNC_DEFAULT_FETCH_AHEAD;
 
   received_opts = apr_array_make(pool, SVN_OPT_MAX_OPTIONS, sizeof(int));
 
@@ -2155,6 +2512,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               }
             break;
 
+          case svnsync_opt_fetch_ahead:
+            SVN_ERR(svn_cstring_atoi(&opt_baton.fetch_ahead, opt_arg));
+            if (opt_baton.fetch_ahead < 0)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                       _("Invalid number of revisions to "
+                                         "fetch ahead '%s'"), opt_arg);
+            break;
+
           case 'M':
             if (!config_options)
               config_options =
@@ -78,6 +78,34 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
                         apr_pool_t *pool);
 
 
+/* A recorded editor drive for a single revision. */
+typedef struct svnsync_recording_t svnsync_recording_t;
+
+/* Set *EDITOR and *EDIT_BATON to an editor that records all calls made
+ * to it in *RECORDING, for svnsync_replay_recording() to send them on to
+ * another editor later.  close_edit and abort_edit are not recorded.
+ *
+ * Text deltas beyond a certain size get buffered in a temporary file.
+ * Allocate everything in RESULT_POOL.  The recording is only valid as
+ * long as that pool.
+ */
+svn_error_t *
+svnsync_get_record_editor(const svn_delta_editor_t **editor,
+                          void **edit_baton,
+                          svnsync_recording_t **recording,
+                          apr_pool_t *result_pool);
+
+/* Make the calls recorded in RECORDING to EDITOR and EDIT_BATON, except
+ * for close_edit.  A recording can only be replayed once.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svnsync_replay_recording(svnsync_recording_t *recording,
+                         const svn_delta_editor_t *editor,
+                         void *edit_baton,
+                         apr_pool_t *scratch_pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
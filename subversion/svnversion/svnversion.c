@@ -20,8 +20,11 @@
  */
 
 #include "svn_cmdline.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_string.h"
 #include "svn_wc.h"
 #include "svn_utf.h"
 #include "svn_opt.h"
@@ -33,6 +36,7 @@
 #include "svn_private_config.h"
 
 #define SVNVERSION_OPT_VERSION SVN_OPT_FIRST_LONGOPT_ID
+#define SVNVERSION_OPT_CONFIG_DIR (SVN_OPT_FIRST_LONGOPT_ID + 1)
 
 
 static svn_error_t *
@@ -87,6 +91,10 @@ help(const apr_getopt_option_t *options, apr_pool_t *pool)
         "\n"
         "  If invoked without arguments WC_PATH will be the current directory.\n"
         "\n"
+        "  Detecting local modifications reads all directories of the\n"
+        "  working copy unless a watcher keeps a journal of its changes.\n"
+        "  Use --jobs to compare that many files concurrently.\n"
+        "\n"
         "Valid options:\n")));
   while (options->description)
     {
@@ -135,6 +143,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_wc_context_t *wc_ctx;
   svn_boolean_t quiet = FALSE;
   svn_boolean_t is_version = FALSE;
+  const char *config_dir = NULL;
+  const char *jobs = NULL;
+  apr_hash_t *cfg_hash;
+  svn_config_t *cfg = NULL;
   const apr_getopt_option_t options[] =
     {
       {"no-newline", 'n', 0, N_("do not output the trailing newline")},
@@ -144,6 +156,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
        N_("show program version information")},
       {"quiet",         'q', 0,
        N_("no progress (only errors) to stderr")},
+      {"jobs",          'j', 1,
+       N_("check files for modifications using ARG threads")},
+      {"config-dir", SVNVERSION_OPT_CONFIG_DIR, 1,
+       N_("read user configuration files from directory ARG")},
       {0,             0,  0,  0}
     };
 
@@ -186,6 +202,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case 'q':
           quiet = TRUE;
           break;
+        case 'j':
+          {
+            int n;
+
+            SVN_ERR(svn_cstring_atoi(&n, arg));
+            if (n < 1)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                       _("Invalid number of jobs '%s'"),
+                                       arg);
+            jobs = arg;
+          }
+          break;
+        case SVNVERSION_OPT_CONFIG_DIR:
+          SVN_ERR(svn_utf_cstring_to_utf8(&config_dir, arg, pool));
+          config_dir = svn_dirent_internal_style(config_dir, pool);
+          break;
         case 'h':
           help(options, pool);
           return SVN_NO_ERROR;
@@ -217,7 +249,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
   SVN_ERR(svn_opt__arg_canonicalize_path(&wc_path, wc_path, pool));
   SVN_ERR(svn_dirent_get_absolute(&local_abspath, wc_path, pool));
-  SVN_ERR(svn_wc_context_create(&wc_ctx, NULL, pool, pool));
+
+  /* Unlike svn, only consult the user's configuration when asked to. */
+  if (config_dir)
+    {
+      SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+      cfg = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+    }
+  if (jobs)
+    {
+      if (!cfg)
+        SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+      svn_config_set(cfg, SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_STATUS_JOBS, jobs);
+    }
+
+  SVN_ERR(svn_wc_context_create(&wc_ctx, cfg, pool, pool));
 
   if (os->ind+1 < argc)
     SVN_ERR(svn_utf_cstring_to_utf8(&trail_url, os->argv[os->ind+1], pool));
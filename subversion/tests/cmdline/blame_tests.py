@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import os, sys, re
+import os, sys, re, random
 
 # Our testing module
 import svntest
@@ -1058,6 +1058,50 @@ def blame_reverse_no_change(sbox):
   svntest.actions.run_and_verify_svn(expected_output, [],
                                      'blame', '-r5:3', sbox.ospath('iota'))
 
+def blame_many_changes(sbox):
+  "blame a file after many scattered changes"
+
+  sbox.build()
+  path = sbox.ospath('many')
+
+  # Model the file as a list of (revision, text) and apply pseudo-random
+  # insertions and deletions to it.  All lines are unique, so the diffs
+  # between revisions are unambiguous.
+  rand = random.Random(4711)
+  lines = [(2, 'r2 line %d' % i) for i in range(40)]
+  svntest.main.file_write(path, ''.join(t + '\n' for r, t in lines))
+  sbox.simple_add('many')
+  sbox.simple_commit(message='r2')
+
+  for rev in range(3, 23):
+    old_lines = list(lines)
+    for change in range(rand.randint(1, 4)):
+      start = rand.randint(0, len(lines))
+      if lines and rand.random() < 0.5:
+        # Deletions tend to make chunks of the same revision meet.
+        del lines[start:start + rand.randint(1, 5)]
+      else:
+        lines[start:start] = [(rev, 'r%d change %d line %d'
+                                    % (rev, change, i))
+                              for i in range(rand.randint(1, 5))]
+
+    # Don't leave the end of the file alone either.
+    if rev % 5 == 0:
+      lines.append((rev, 'r%d tail' % rev))
+    elif rev % 7 == 0 and lines:
+      lines.pop()
+
+    # Every revision must change the file.
+    if lines == old_lines:
+      lines.insert(0, (rev, 'r%d head' % rev))
+
+    svntest.main.file_write(path, ''.join(t + '\n' for r, t in lines))
+    sbox.simple_commit(message='r%d' % rev)
+
+  expected_output = ['%6d %10s %s\n' % (r, 'jrandom', t) for r, t in lines]
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'blame', path)
+
 
 ########################################################################
 # Run the tests
@@ -1084,6 +1128,7 @@ test_list = [ None,
               blame_eol_handling,
               blame_youngest_to_oldest,
               blame_reverse_no_change,
+              blame_many_changes,
              ]
 
 if __name__ == '__main__':
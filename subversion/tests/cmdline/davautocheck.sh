@@ -320,6 +320,14 @@ if [ ${USE_SSL:+set} ]; then
     LOAD_MOD_SSL=$(get_loadmodule_config mod_ssl) \
       || fail "SSL module not found"
 fi
+# needed for SVNMasterURI; the mirror tests get skipped without them
+LOAD_MOD_PROXY=$(get_loadmodule_config mod_proxy) \
+  && LOAD_MOD_PROXY_HTTP=$(get_loadmodule_config mod_proxy_http) \
+  || {
+say "Proxy modules not found. Mirror tests will be skipped."
+LOAD_MOD_PROXY=
+LOAD_MOD_PROXY_HTTP=
+}
 
 # Stop any previous instances, os we can re-use the port.
 if [ -x $STOPSCRIPT ]; then $STOPSCRIPT ; sleep 1; fi
@@ -440,6 +448,8 @@ $LOAD_MOD_MIME
 $LOAD_MOD_ALIAS
 $LOAD_MOD_UNIXD
 $LOAD_MOD_DAV
+$LOAD_MOD_PROXY
+$LOAD_MOD_PROXY_HTTP
 LoadModule          dav_svn_module "$MOD_DAV_SVN"
 $LOAD_MOD_AUTH
 $LOAD_MOD_AUTHN_CORE
@@ -543,6 +553,21 @@ CustomLog           "$HTTPD_ROOT/ops" "%t %u %{SVN-REPOS-NAME}e %{SVN-ACTION}e"
   ${SVN_PATH_AUTHZ_LINE}
   DontDoThatConfigFile "$HTTPD_DONTDOTHAT"
 </Location>
+<IfModule mod_proxy_http.c>
+<Location /mirror-test-work/repositories>
+  DAV               svn
+  SVNParentPath     "$ABS_BUILDDIR/subversion/tests/cmdline/svn-test-work/repositories"
+  SVNMasterURI      "$BASE_URL/svn-test-work/repositories"
+  SVNMirrorWaitTimeout 2000
+  AuthzSVNAccessFile "$ABS_BUILDDIR/subversion/tests/cmdline/svn-test-work/authz"
+  AuthType          Basic
+  AuthName          "Subversion Repository"
+  AuthUserFile      $HTTPD_USERS
+  Require           valid-user
+  SVNAdvertiseV2Protocol ${ADVERTISE_V2_PROTOCOL}
+  ${SVN_PATH_AUTHZ_LINE}
+</Location>
+</IfModule>
 <Location /svn-test-work/local_tmp/repos>
   DAV               svn
   SVNPath           "$ABS_BUILDDIR/subversion/tests/cmdline/svn-test-work/local_tmp/repos"
@@ -2780,6 +2780,71 @@ def log_on_deleted_deep(sbox):
                                      '-q', '-c', '1-2')
 
 
+def log_cache_validation(sbox):
+  "log -v with the log cache after history changes"
+
+  sbox.build(create_wc=False)
+  svntest.actions.enable_revprop_changes(sbox.repo_dir)
+  uuid = 'a0e4c7d2-5f0b-4b8e-9c52-7d1f3a6b0e11'
+  svntest.main.run_svnadmin('setuuid', sbox.repo_dir, uuid)
+
+  config_dir = sbox.create_config_dir(config_contents="""
+[auth]
+password-stores =
+
+[miscellany]
+interactive-conflicts = false
+log-cache = yes
+""")
+
+  def log_verbose():
+    # The first call may fill the cache, the second one must use it.
+    outputs = []
+    for i in range(2):
+      exit_code, output, errput = svntest.actions.run_and_verify_svn(
+        None, [], 'log', '-v', '--config-dir', config_dir, sbox.repo_url)
+      outputs.append(output)
+    if outputs[0] != outputs[1]:
+      raise svntest.Failure("Log from the cache differs")
+    return ''.join(outputs[1])
+
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r2',
+                                         'mkdir', 'first')
+  log = log_verbose()
+  if '   A /first\n' not in log or '   A /iota\n' not in log:
+    raise svntest.Failure("Changed paths missing from the log")
+  if not os.path.isdir(os.path.join(config_dir, 'log-cache', uuid)):
+    raise svntest.Failure("The log cache has not been filled")
+
+  # Revision properties are not served from the cache.
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'propset', '--revprop', '-r2',
+                                     'svn:log', 'changed message',
+                                     '--config-dir', config_dir,
+                                     sbox.repo_url)
+  log = log_verbose()
+  if 'changed message\n' not in log:
+    raise svntest.Failure("Changed log message missing from the log")
+
+  # Replace the repository by another history with the same UUID, as
+  # loading a different dump file would.
+  svntest.main.safe_rmtree(sbox.repo_dir, 1)
+  svntest.main.create_repos(sbox.repo_dir)
+  svntest.main.run_svnadmin('setuuid', sbox.repo_dir, uuid)
+  for name in ['second', 'third']:
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', name,
+                                           'mkdir', name)
+  log = log_verbose()
+  if '   A /second\n' not in log or '   A /third\n' not in log:
+    raise svntest.Failure("Changed paths of the new history missing")
+  if '/first' in log or '/iota' in log:
+    raise svntest.Failure("Stale changed paths served from the cache")
+
+
 ########################################################################
 # Run the tests
 
@@ -2830,6 +2895,7 @@ test_list = [ None,
               merge_sensitive_log_xml_reverse_merges,
               log_revision_move_copy,
               log_on_deleted_deep,
+              log_cache_validation,
              ]
 
 if __name__ == '__main__':
@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import os, logging, base64, functools
+import os, logging, base64, functools, threading, time
 
 try:
   # Python <3.0
@@ -133,6 +133,27 @@ def verify_xml_response(expected_xml, actual_xml):
                           % (ET.tostring(expected_elem),
                              ET.tostring(actual_elem)))
 
+def mirror_url_and_headers(sbox):
+  """Return the URL of the mirror of SBOX's repository that davautocheck.sh
+     sets up next to the regular location, and the headers to access it.
+     Skip the test if httpd has been configured without the mirror."""
+
+  mirror_url = sbox.repo_url.replace('/svn-test-work/', '/mirror-test-work/')
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(mirror_url)
+  h.request('GET', mirror_url + '/iota', None, headers)
+  r = h.getresponse()
+  r.read()
+  if r.status == httplib.NOT_FOUND:
+    raise svntest.Skip('No mirror location configured')
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+
+  return mirror_url, headers
+
 ######################################################################
 # Tests
 
@@ -206,7 +227,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -218,7 +239,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -230,7 +251,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -640,6 +661,65 @@ def propfind_propname(sbox):
   actual_response = r.read()
   verify_xml_response(expected_response, actual_response)
 
+@SkipUnless(svntest.main.is_ra_type_dav)
+def mirror_wait_timeout(sbox):
+  "mirror gives up waiting for a missing revision"
+
+  sbox.build(create_wc=False)
+  mirror_url, headers = mirror_url_and_headers(sbox)
+
+  # Nothing is going to deliver r2.  Expect the mirror to give up after
+  # the SVNMirrorWaitTimeout set by davautocheck.sh and to tell us how
+  # far it got.
+  h = svntest.main.create_http_connection(mirror_url)
+  start = time.time()
+  h.request('GET', mirror_url + '/!svn/rvr/2/iota', None, headers)
+  r = h.getresponse()
+  r.read()
+  elapsed = time.time() - start
+
+  if r.status != httplib.SERVICE_UNAVAILABLE:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'Retry-After', '1',
+                                           r.getheader('Retry-After'))
+  svntest.verify.compare_and_display_lines(None, 'SVN-Mirror-Youngest-Rev',
+                                           '1',
+                                           r.getheader('SVN-Mirror-Youngest-Rev'))
+  if elapsed < 1.5:
+    raise svntest.Failure('Mirror gave up after %.1fs already' % elapsed)
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+def mirror_wait_success(sbox):
+  "mirror holds requests until the revision arrives"
+
+  sbox.build(create_wc=False)
+  mirror_url, headers = mirror_url_and_headers(sbox)
+
+  # Play svnsync: commit r2 directly to the repository while the mirror
+  # is waiting for it.
+  def deliver_r2():
+    svntest.main.run_svnmucc('-U', sbox.file_protocol_repo_url(),
+                             '-m', 'r2', 'mkdir', 'X')
+  timer = threading.Timer(0.5, deliver_r2)
+
+  h = svntest.main.create_http_connection(mirror_url)
+  timer.start()
+  try:
+    h.request('GET', mirror_url + '/!svn/rvr/2/iota', None, headers)
+    r = h.getresponse()
+    body = r.read()
+  finally:
+    timer.join()
+
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'iota',
+                                           "This is the file 'iota'.\n",
+                                           body.decode())
+  svntest.verify.compare_and_display_lines(None, 'SVN-Mirror-Youngest-Rev',
+                                           '2',
+                                           r.getheader('SVN-Mirror-Youngest-Rev'))
+
 ########################################################################
 # Run the tests
 
@@ -652,6 +732,8 @@ test_list = [ None,
               propfind_404,
               propfind_allprop,
               propfind_propname,
+              mirror_wait_timeout,
+              mirror_wait_success,
              ]
 serial_only = True
 
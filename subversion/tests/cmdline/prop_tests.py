@@ -2829,6 +2829,49 @@ def prop_conflict_root(sbox):
                                         expected_status,
                                         extra_files=extra_files)
 
+def persistent_prop_cache(sbox):
+  "propget with a persistent property cache"
+
+  sbox.build(create_wc=False)
+  iota_url = sbox.repo_url + '/iota'
+  svntest.actions.enable_revprop_changes(sbox.repo_dir)
+
+  # Only ra_serf uses the cache; other RA layers must ignore the option.
+  config_dir = sbox.create_config_dir(server_contents="""
+[global]
+http-property-cache-size = 1
+""")
+
+  def verify_propget(expected, *args):
+    # The first call may fill the cache, the second one may use it.
+    for i in range(2):
+      svntest.actions.run_and_verify_svn(expected, [],
+                                         'propget', '--config-dir',
+                                         config_dir, *args)
+
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'propset', '--config-dir', config_dir,
+                                     '-m', 'log 2', 'p', 'v1', iota_url)
+  verify_propget(['v1\n'], 'p', iota_url + '@2')
+  verify_propget(['log 2\n'], '--revprop', '-r2', 'svn:log',
+                 sbox.repo_url)
+
+  # A new revision must not be hidden by the cache of the old one.
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'propset', '--config-dir', config_dir,
+                                     '-m', 'log 3', 'p', 'v2', iota_url)
+  verify_propget(['v2\n'], 'p', iota_url)
+  verify_propget(['v1\n'], 'p', iota_url + '@2')
+  verify_propget(['v2\n'], 'p', iota_url + '@3')
+
+  # Revision properties may change at any time.
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'propset', '--config-dir', config_dir,
+                                     '--revprop', '-r2', 'svn:log',
+                                     'changed', sbox.repo_url)
+  verify_propget(['changed\n'], '--revprop', '-r2', 'svn:log',
+                 sbox.repo_url)
+
 ########################################################################
 # Run the tests
 
@@ -2880,6 +2923,7 @@ test_list = [ None,
               iprops_list_abspath,
               wc_propop_on_url,
               prop_conflict_root,
+              persistent_prop_cache,
              ]
 
 if __name__ == '__main__':
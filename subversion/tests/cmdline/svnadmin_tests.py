@@ -3436,6 +3436,56 @@ def load_from_file(sbox):
                                      'update', sbox.wc_dir)
   svntest.actions.verify_disk(sbox.wc_dir, expected_tree, check_props=True)
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def build_repcache(sbox):
+  "svnadmin build-repcache"
+
+  sbox.build()
+  sbox.simple_append('iota', 'more text\n')
+  sbox.simple_propset('prop', 'value', 'A/mu')
+  sbox.simple_commit()
+
+  rep_cache_path = os.path.join(sbox.repo_dir, 'db', 'rep-cache.db')
+  if not os.path.exists(rep_cache_path):
+    raise svntest.Skip('repository does not have a rep-cache')
+
+  def rep_cache_rows():
+    db = svntest.sqlite3.connect(rep_cache_path)
+    rows = sorted(db.execute('select * from rep_cache').fetchall())
+    db.close()
+    return rows
+
+  expected_rows = rep_cache_rows()
+  if not expected_rows:
+    raise svntest.Failure('rep-cache is empty after commits')
+
+  # Drop all entries and rebuild them, first without and then with jobs.
+  for args in [[], ['--jobs', '2']]:
+    db = svntest.sqlite3.connect(rep_cache_path)
+    db.execute('delete from rep_cache')
+    db.commit()
+    db.close()
+
+    svntest.actions.run_and_verify_svnadmin(
+      ['* Processed revision 0.\n',
+       '* Processed revision 1.\n',
+       '* Processed revision 2.\n'],
+      [], 'build-repcache', sbox.repo_dir, *args)
+
+    if rep_cache_rows() != expected_rows:
+      raise svntest.Failure('rep-cache differs after rebuilding it')
+
+  # A single revision adds only the entries of that revision.
+  db = svntest.sqlite3.connect(rep_cache_path)
+  db.execute('delete from rep_cache')
+  db.commit()
+  db.close()
+
+  svntest.actions.run_and_verify_svnadmin(
+    [], [], 'build-repcache', '-q', '-r2', sbox.repo_dir)
+  if rep_cache_rows() != [row for row in expected_rows if row[1] == 2]:
+    raise svntest.Failure('unexpected rep-cache entries for r2')
+
 ########################################################################
 # Run the tests
 
@@ -3500,7 +3550,8 @@ test_list = [ None,
               dump_no_op_prop_change,
               load_no_flush_to_disk,
               dump_to_file,
-              load_from_file
+              load_from_file,
+              build_repcache
              ]
 
 if __name__ == '__main__':
@@ -26,6 +26,7 @@
 
 # General modules
 import os
+import subprocess
 import sys
 import tempfile
 
@@ -762,6 +763,42 @@ def drop_all_empty_revisions(sbox):
       None, filtered_err, None, expected_err)
 
 
+def filter_seekable_input(sbox):
+  "filter a dump file redirected to stdin"
+
+  sbox.build(empty=True)
+
+  dumpfile_location = os.path.join(os.path.dirname(sys.argv[0]),
+                                   'svndumpfilter_tests_data',
+                                   'greek_tree.dump')
+  dumpfile = svntest.actions.load_dumpfile(dumpfile_location)
+
+  # Mix literal prefixes and patterns; the contents of the excluded files
+  # get skipped instead of being read when stdin is a regular file.
+  args = ['exclude', '--quiet', '--pattern',
+          '/A/B/E', '/A/B/E/alpha', '/A/B/E/beta', '/A/D/[GH]*']
+  piped_output, piped_err = filter_and_return_output(dumpfile, 0, *args)
+
+  dump_in = open(dumpfile_location, 'rb')
+  try:
+    process = subprocess.Popen([svntest.main.svndumpfilter_binary] + args,
+                               stdin=dump_in, stdout=subprocess.PIPE,
+                               stderr=subprocess.PIPE)
+    stdout, stderr = process.communicate()
+  finally:
+    dump_in.close()
+
+  if process.returncode or stderr:
+    raise svntest.Failure("svndumpfilter failed: %s" % stderr)
+  output = stdout.splitlines(True)
+
+  svntest.verify.compare_and_display_lines(
+    "Filtering a file gave different results than filtering a pipe",
+    'DUMP', piped_output, output)
+
+  _simple_dumpfilter_test(sbox, dumpfile, *args[:1] + args[2:])
+
+
 ########################################################################
 # Run the tests
 
@@ -778,6 +815,7 @@ test_list = [ None,
               accepts_deltas,
               dumpfilter_targets_expect_leading_slash_prefixes,
               drop_all_empty_revisions,
+              filter_seekable_input,
               ]
 
 if __name__ == '__main__':
@@ -718,6 +718,32 @@ def property_delete(sbox):
   svntest.actions.run_and_verify_svnlook(["_U  A/mu\n"], [],
                                          'changed', repo_dir)
 
+def changed_replacements(sbox):
+  "changed and dirs-changed with replacements"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  sbox.simple_rm('iota')
+  sbox.simple_mkdir('iota')
+  sbox.simple_copy('A/B', 'A/B2')
+  sbox.simple_rm('A/D/G/pi')
+  sbox.simple_commit()
+
+  svntest.actions.run_and_verify_svnlook(["A   A/B2/\n",
+                                          "D   A/D/G/pi\n",
+                                          "D   iota\n",
+                                          "A   iota/\n"], [],
+                                         'changed', repo_dir)
+  svntest.actions.run_and_verify_svnlook(["A + A/B2/\n",
+                                          "    (from A/B/:r1)\n",
+                                          "D   A/D/G/pi\n",
+                                          "D   iota\n",
+                                          "A   iota/\n"], [],
+                                         'changed', '--copy-info', repo_dir)
+  svntest.actions.run_and_verify_svnlook(["/\n", "A/\n", "A/D/G/\n"], [],
+                                         'dirs-changed', repo_dir)
+
 
 ########################################################################
 # Run the tests
@@ -738,6 +764,7 @@ test_list = [ None,
               test_filesize,
               test_txn_flag,
               property_delete,
+              changed_replacements,
              ]
 
 if __name__ == '__main__':
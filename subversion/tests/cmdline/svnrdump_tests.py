@@ -762,6 +762,17 @@ def only_trunk_A_range_dump(sbox):
                 expected_dumpfile_name="trunk-A-range.expected.dump",
                 extra_options=['-r2:HEAD'])
 
+def jobs_dump(sbox):
+  "dump: concurrently using --jobs"
+  run_dump_test(sbox, "mergeinfo_included_full.dump",
+                extra_options=['--jobs', '3'])
+
+def jobs_range_dump(sbox):
+  "dump: concurrently using --jobs and -rX:Y"
+  run_dump_test(sbox, "trunk-only.dump",
+                expected_dumpfile_name="root-range.expected.dump",
+                extra_options=['--jobs', '2', '-r2:HEAD'])
+
 
 #----------------------------------------------------------------------
 
@@ -1043,6 +1054,8 @@ test_list = [ None,
               load_non_deltas_replace_copy_with_props,
               dump_replace_with_copy,
               load_non_deltas_with_props,
+              jobs_dump,
+              jobs_range_dump,
              ]
 
 if __name__ == '__main__':
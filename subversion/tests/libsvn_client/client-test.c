@@ -725,6 +725,97 @@ test_youngest_common_ancestor(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Return the location SEGMENTS as a string like "1-1:iota 2-2:A/iota". */
+static const char *
+segments_to_string(const apr_array_header_t *segments,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < segments->nelts; i++)
+    {
+      const svn_location_segment_t *segment
+        = APR_ARRAY_IDX(segments, i, const svn_location_segment_t *);
+
+      svn_stringbuf_appendcstr(buf,
+                               apr_psprintf(pool, "%s%ld-%ld:%s",
+                                            i ? " " : "",
+                                            segment->range_start,
+                                            segment->range_end,
+                                            segment->path ? segment->path
+                                                          : "(gap)"));
+    }
+
+  return buf->data;
+}
+
+static svn_error_t *
+test_cached_location_segments(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  const char *repos_url, *iota_url, *a_iota_url;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session;
+  svn_opt_revision_t head_rev = { svn_opt_revision_head, { 0 } };
+  svn_client_copy_source_t source;
+  apr_array_header_t *sources, *segments;
+  apr_pool_t *cache_pool = svn_pool_create(pool);
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-cached-location-segments",
+                             opts, pool));
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+
+  /* Copy iota to A/iota in r2. */
+  iota_url = svn_path_url_add_component2(repos_url, "iota", pool);
+  a_iota_url = svn_path_url_add_component2(repos_url, "A/iota", pool);
+  sources = apr_array_make(pool, 1, sizeof(svn_client_copy_source_t *));
+  source.path = iota_url;
+  source.peg_revision = &head_rev;
+  source.revision = &head_rev;
+  APR_ARRAY_PUSH(sources, svn_client_copy_source_t *) = &source;
+  SVN_ERR(svn_client_copy6(sources, a_iota_url, FALSE /* copy_as_child */,
+                           FALSE /* make_parents */,
+                           FALSE /* ignore_externals */,
+                           NULL, NULL, NULL, ctx, pool));
+
+  SVN_ERR(svn_client_open_ra_session2(&session, repos_url, NULL, ctx,
+                                      pool, pool));
+
+  svn_client__cache_location_segments(ctx, cache_pool);
+
+  /* Fetch the full history of A/iota. */
+  SVN_ERR(svn_client__repos_location_segments(&segments, session, a_iota_url,
+                                              2, SVN_INVALID_REVNUM,
+                                              SVN_INVALID_REVNUM, ctx, pool));
+  SVN_TEST_STRING_ASSERT(segments_to_string(segments, pool),
+                         "1-1:iota 2-2:A/iota");
+  SVN_TEST_ASSERT(svn_hash_gets(svn_client__get_private_ctx(ctx)
+                                  ->location_segments, iota_url));
+
+  /* Parts of it, including that of iota@1, come from the cache. */
+  SVN_ERR(svn_client__repos_location_segments(&segments, session, a_iota_url,
+                                              2, 2, 2, ctx, pool));
+  SVN_TEST_STRING_ASSERT(segments_to_string(segments, pool), "2-2:A/iota");
+  SVN_ERR(svn_client__repos_location_segments(&segments, session, iota_url,
+                                              1, SVN_INVALID_REVNUM,
+                                              SVN_INVALID_REVNUM, ctx, pool));
+  SVN_TEST_STRING_ASSERT(segments_to_string(segments, pool), "1-1:iota");
+
+  /* The cached history does not cover iota@2, so that gets fetched. */
+  SVN_ERR(svn_client__repos_location_segments(&segments, session, iota_url,
+                                              2, SVN_INVALID_REVNUM,
+                                              SVN_INVALID_REVNUM, ctx, pool));
+  SVN_TEST_STRING_ASSERT(segments_to_string(segments, pool), "1-2:iota");
+
+  /* Clearing the pool ends caching. */
+  svn_pool_destroy(cache_pool);
+  SVN_TEST_ASSERT(svn_client__get_private_ctx(ctx)->location_segments
+                  == NULL);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_foreign_repos_copy(const svn_test_opts_t *opts,
                         apr_pool_t *pool)
@@ -830,6 +921,182 @@ test_suggest_mergesources(const svn_test_opts_t *opts,
 }
 
 
+/* Number of files in the text merge test.  Exceeds the number of text
+   merges that the merge code queues at a time. */
+#define TEXT_MERGE_FILES 100
+
+/* Return the text of file number I of the text merge test, with its first
+   and its last line replaced by FIRST and LAST, if not NULL. */
+static const char *
+text_merge_contents(int i,
+                    const char *first,
+                    const char *last,
+                    apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s\nline 2 of %d\nline 3\nline 4\n%s\n",
+                      first ? first : "line 1", i, last ? last : "line 5");
+}
+
+/* Notification baton of the text merge test. */
+typedef struct text_merge_notify_baton_t
+{
+  /* Number of update notifications per content state. */
+  int changed;
+  int merged;
+  int conflicted;
+
+  /* Maps the notified paths to themselves. */
+  apr_hash_t *paths;
+} text_merge_notify_baton_t;
+
+/* Implements svn_wc_notify_func2_t for the text merge test. */
+static void
+text_merge_notify(void *baton,
+                  const svn_wc_notify_t *notify,
+                  apr_pool_t *pool)
+{
+  text_merge_notify_baton_t *nb = baton;
+  const char *path;
+
+  if (notify->action != svn_wc_notify_update_update
+      || notify->kind != svn_node_file)
+    return;
+
+  if (notify->content_state == svn_wc_notify_state_changed)
+    nb->changed++;
+  else if (notify->content_state == svn_wc_notify_state_merged)
+    nb->merged++;
+  else if (notify->content_state == svn_wc_notify_state_conflicted)
+    nb->conflicted++;
+
+  path = apr_pstrdup(apr_hash_pool_get(nb->paths), notify->path);
+  svn_hash_sets(nb->paths, path, path);
+}
+
+static svn_error_t *
+test_merge_many_texts(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *trunk_url;
+  const char *wc_path;
+  svn_client_ctx_t *ctx;
+  svn_client__mtcc_t *mtcc;
+  svn_opt_revision_t head_rev;
+  text_merge_notify_baton_t nb = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int expected_merged = 0;
+  int i;
+
+  SVN_ERR(create_greek_repos(&repos_url, "merge-many-texts", opts, pool));
+  trunk_url = svn_path_url_add_component2(repos_url, "trunk", pool);
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+
+  /* r2: the trunk, r3: the branch, r4: an edit of every trunk file. */
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, -1, ctx, pool, pool));
+  SVN_ERR(svn_client__mtcc_add_mkdir("trunk", mtcc, pool));
+  for (i = 0; i < TEXT_MERGE_FILES; i++)
+    SVN_ERR(svn_client__mtcc_add_add_file(
+              apr_psprintf(pool, "trunk/f-%03d", i),
+              svn_stream_from_string(
+                svn_string_create(text_merge_contents(i, NULL, NULL, pool),
+                                  pool),
+                pool),
+              NULL, mtcc, pool));
+  SVN_ERR(svn_client__mtcc_commit(NULL, NULL, NULL, mtcc, pool));
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, -1, ctx, pool, pool));
+  SVN_ERR(svn_client__mtcc_add_copy("trunk", 2, "branch", mtcc, pool));
+  SVN_ERR(svn_client__mtcc_commit(NULL, NULL, NULL, mtcc, pool));
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, -1, ctx, pool, pool));
+  for (i = 0; i < TEXT_MERGE_FILES; i++)
+    SVN_ERR(svn_client__mtcc_add_update_file(
+              apr_psprintf(pool, "trunk/f-%03d", i),
+              svn_stream_from_string(
+                svn_string_create(text_merge_contents(i, "trunk 1", NULL,
+                                                      pool),
+                                  pool),
+                pool),
+              NULL, NULL, NULL, mtcc, pool));
+  SVN_ERR(svn_client__mtcc_commit(NULL, NULL, NULL, mtcc, pool));
+
+  wc_path = svn_test_data_path("merge-many-texts-wc", pool);
+  svn_test_add_dir_cleanup(wc_path);
+  SVN_ERR(svn_io_remove_dir2(wc_path, TRUE, NULL, NULL, pool));
+
+  head_rev.kind = svn_opt_revision_head;
+  SVN_ERR(svn_client_checkout3(NULL,
+                               svn_path_url_add_component2(repos_url,
+                                                           "branch", pool),
+                               wc_path, &head_rev, &head_rev,
+                               svn_depth_infinity, FALSE, FALSE, ctx, pool));
+
+  /* Every 10th file gets a conflicting local edit.  Of the others, every
+     3rd one gets a local edit that merges cleanly. */
+  for (i = 0; i < TEXT_MERGE_FILES; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = svn_dirent_join(wc_path, apr_psprintf(iterpool, "f-%03d", i),
+                             iterpool);
+
+      if (i % 10 == 0)
+        SVN_ERR(svn_io_file_create(path,
+                                   text_merge_contents(i, "branch 1", NULL,
+                                                       iterpool),
+                                   iterpool));
+      else if (i % 3 == 0)
+        {
+          SVN_ERR(svn_io_file_create(path,
+                                     text_merge_contents(i, NULL, "branch 5",
+                                                         iterpool),
+                                     iterpool));
+          expected_merged++;
+        }
+    }
+
+  nb.paths = apr_hash_make(pool);
+  ctx->notify_func2 = text_merge_notify;
+  ctx->notify_baton2 = &nb;
+
+  SVN_ERR(svn_client_merge_peg5(trunk_url, NULL, &head_rev, wc_path,
+                                svn_depth_infinity,
+                                FALSE, FALSE, FALSE, FALSE, FALSE, FALSE,
+                                NULL, ctx, pool));
+
+  /* Each file has been merged and notified exactly once. */
+  SVN_TEST_INT_ASSERT(apr_hash_count(nb.paths), TEXT_MERGE_FILES);
+  SVN_TEST_INT_ASSERT(nb.conflicted, TEXT_MERGE_FILES / 10);
+  SVN_TEST_INT_ASSERT(nb.merged, expected_merged);
+  SVN_TEST_INT_ASSERT(nb.changed,
+                      TEXT_MERGE_FILES - nb.conflicted - expected_merged);
+
+  for (i = 0; i < TEXT_MERGE_FILES; i++)
+    {
+      const char *path;
+      svn_stringbuf_t *contents;
+
+      if (i % 10 == 0)
+        continue;
+
+      svn_pool_clear(iterpool);
+      path = svn_dirent_join(wc_path, apr_psprintf(iterpool, "f-%03d", i),
+                             iterpool);
+      SVN_ERR(svn_stringbuf_from_file2(&contents, path, iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             text_merge_contents(i, "trunk 1",
+                                                 i % 3 == 0 ? "branch 5"
+                                                            : NULL,
+                                                 iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
 static char
 status_to_char(enum svn_wc_status_kind status)
 {
@@ -1428,8 +1695,12 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_OPTS_PASS(test_16k_add, "test adding 16k files"),
 #endif
     SVN_TEST_OPTS_PASS(test_youngest_common_ancestor, "test youngest_common_ancestor"),
+    SVN_TEST_OPTS_PASS(test_cached_location_segments,
+                       "test caching of location segments"),
     SVN_TEST_OPTS_PASS(test_suggest_mergesources,
                        "test svn_client_suggest_merge_sources"),
+    SVN_TEST_OPTS_PASS(test_merge_many_texts,
+                       "merge text changes into many files"),
     SVN_TEST_OPTS_PASS(test_remote_only_status,
                        "test svn_client_status6 with ignore_local_mods"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals,
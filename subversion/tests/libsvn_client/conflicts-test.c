@@ -26,9 +26,11 @@
 #define SVN_DEPRECATED
 
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_props.h"
+#include "svn_repos.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -5161,6 +5163,164 @@ test_merge_incoming_move_dir_across_branches(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Create a client context for the sandbox B in *CTX which keeps the
+ * conflict log cache in the configuration area CONFIG_DIR. */
+static svn_error_t *
+create_ctx_with_conflict_log_cache(svn_client_ctx_t **ctx,
+                                   svn_test__sandbox_t *b,
+                                   const char *config_dir,
+                                   apr_pool_t *pool)
+{
+  svn_config_t *cfg;
+
+  SVN_ERR(svn_test__create_client_ctx(ctx, b, pool));
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set_bool(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                      SVN_CONFIG_OPTION_CONFLICT_LOG_CACHE, TRUE);
+  (*ctx)->config = apr_hash_make(pool);
+  svn_hash_sets((*ctx)->config, SVN_CONFIG_CATEGORY_CONFIG, cfg);
+  svn_auth_set_parameter((*ctx)->auth_baton, SVN_AUTH_PARAM_CONFIG_DIR,
+                         config_dir);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DESCRIPTION to the incoming change of the tree conflict prepared by
+ * create_wc_with_incoming_delete_file_merge_conflict() in B.  Use a new
+ * client context, so that only the on-disk cache in CONFIG_DIR is shared
+ * with earlier calls. */
+static svn_error_t *
+describe_incoming_delete(const char **description,
+                         svn_test__sandbox_t *b,
+                         const char *config_dir,
+                         apr_pool_t *pool)
+{
+  svn_client_ctx_t *ctx;
+  svn_client_conflict_t *conflict;
+  const char *deleted_path;
+  const char *local_description;
+
+  SVN_ERR(create_ctx_with_conflict_log_cache(&ctx, b, config_dir, pool));
+  deleted_path = svn_relpath_join(branch_path, deleted_file_name, pool);
+  SVN_ERR(svn_client_conflict_get(&conflict, sbox_wc_path(b, deleted_path),
+                                  ctx, pool, pool));
+  SVN_ERR(svn_client_conflict_tree_get_details(conflict, ctx, pool));
+  SVN_ERR(svn_client_conflict_tree_get_description(description,
+                                                   &local_description,
+                                                   conflict, ctx,
+                                                   pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revision property NAME of every revision in the repository of B
+ * to VALUE, bypassing the hooks. */
+static svn_error_t *
+set_revprop_of_all_revisions(svn_test__sandbox_t *b,
+                             const char *name,
+                             const char *value,
+                             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t youngest;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_repos_open3(&repos, b->repos_dir, NULL, pool, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  for (rev = 1; rev <= youngest; rev++)
+    SVN_ERR(svn_fs_change_rev_prop2(fs, rev, name, NULL,
+                                    svn_string_create(value, pool), pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *COUNT to the number of files in the conflict log cache in
+ * CONFIG_DIR which contain TEXT. */
+static svn_error_t *
+count_cached_logs_containing(int *count,
+                             const char *config_dir,
+                             const char *text,
+                             apr_pool_t *pool)
+{
+  const char *cache_dir = svn_dirent_join(config_dir, "conflict-logs", pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  *count = 0;
+  SVN_ERR(svn_io_get_dirents3(&dirents, cache_dir, TRUE, pool, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                       svn_dirent_join(cache_dir,
+                                                       apr_hash_this_key(hi),
+                                                       pool),
+                                       pool));
+      if (strstr(contents->data, text))
+        (*count)++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that logs cached on disk for describing tree conflicts pick up
+ * changed authors and get replaced when the repository history changes. */
+static svn_error_t *
+test_merge_incoming_delete_cached_log(const svn_test_opts_t *opts,
+                                      apr_pool_t *pool)
+{
+  svn_test__sandbox_t *b = apr_palloc(pool, sizeof(*b));
+  const char *new_date = "2001-02-03T04:05:06.000000Z";
+  const char *config_dir;
+  const char *description;
+  svn_repos_t *repos;
+  svn_string_t *old_date;
+  int count;
+
+  SVN_ERR(svn_test__sandbox_create(b, "merge_incoming_delete_cached_log",
+                                   opts, pool));
+  SVN_ERR(create_wc_with_incoming_delete_file_merge_conflict(b, TRUE, FALSE));
+  SVN_ERR(svn_test_make_sandbox_dir(&config_dir,
+                                    "merge_incoming_delete_cached_log_cfg",
+                                    pool));
+
+  /* Fill the on-disk cache. */
+  SVN_ERR(describe_incoming_delete(&description, b, config_dir, pool));
+  SVN_TEST_ASSERT(strstr(description, "jrandom"));
+
+  SVN_ERR(svn_repos_open3(&repos, b->repos_dir, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_prop2(&old_date, svn_repos_fs(repos), 3,
+                                SVN_PROP_REVISION_DATE, TRUE, pool, pool));
+  SVN_ERR(count_cached_logs_containing(&count, config_dir, old_date->data,
+                                       pool));
+  SVN_TEST_ASSERT(count > 0);
+
+  /* A changed author shows although the log is read from disk. */
+  SVN_ERR(set_revprop_of_all_revisions(b, SVN_PROP_REVISION_AUTHOR,
+                                       "someone-else", pool));
+  SVN_ERR(describe_incoming_delete(&description, b, config_dir, pool));
+  SVN_TEST_ASSERT(strstr(description, "someone-else"));
+  SVN_TEST_ASSERT(!strstr(description, "jrandom"));
+
+  /* Different commit times, as after loading another history into a
+   * repository with the same UUID, replace the cached logs. */
+  SVN_ERR(set_revprop_of_all_revisions(b, SVN_PROP_REVISION_DATE, new_date,
+                                       pool));
+  SVN_ERR(describe_incoming_delete(&description, b, config_dir, pool));
+  SVN_TEST_ASSERT(strstr(description, "someone-else"));
+  SVN_ERR(count_cached_logs_containing(&count, config_dir, old_date->data,
+                                       pool));
+  SVN_TEST_INT_ASSERT(count, 0);
+  SVN_ERR(count_cached_logs_containing(&count, config_dir, new_date, pool));
+  SVN_TEST_ASSERT(count > 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -5251,6 +5411,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                         "cherry-pick edit from moved file"),
     SVN_TEST_OPTS_PASS(test_merge_incoming_move_dir_across_branches,
                         "merge incoming dir move across branches"),
+    SVN_TEST_OPTS_PASS(test_merge_incoming_delete_cached_log,
+                       "validate the on-disk conflict log cache"),
     SVN_TEST_NULL
   };
 
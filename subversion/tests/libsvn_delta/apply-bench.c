@@ -0,0 +1,220 @@
+/* apply-bench.c -- measure the throughput of applying txdelta windows
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <apr_general.h>
+#include <apr_md5.h>
+#include <apr_time.h>
+
+#include "../svn_test.h"
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "private/svn_string_private.h"
+
+
+/* Fill BUF with LEN bytes of pseudo-random, word-like data. */
+static void
+fill_source(char *buf, apr_size_t len)
+{
+  static const char alphabet[] = "etaoinshrdlu cmfwyp\n";
+  apr_uint32_t seed = 12345;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      buf[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+}
+
+/* Return a copy of SOURCE with small modifications every STRIDE bytes,
+ * allocated in POOL. */
+static svn_string_t *
+make_target(const svn_string_t *source, apr_size_t stride, apr_pool_t *pool)
+{
+  svn_stringbuf_t *target = svn_stringbuf_create_ensure(source->len, pool);
+  apr_size_t pos;
+
+  for (pos = 0; pos < source->len; pos += stride)
+    {
+      apr_size_t chunk = source->len - pos;
+
+      if (chunk > stride)
+        chunk = stride;
+
+      svn_stringbuf_appendbytes(target, source->data + pos, chunk);
+      if (chunk > 8)
+        {
+          memcpy(target->data + target->len - 4, "XYZW", 4);
+          svn_stringbuf_appendcstr(target, "inserted");
+        }
+    }
+
+  return svn_stringbuf__morph_into_string(target);
+}
+
+/* Return the delta windows that turn SOURCE into TARGET as an array of
+ * svn_txdelta_window_t *, allocated in POOL. */
+static svn_error_t *
+make_windows(apr_array_header_t **windows,
+             const svn_string_t *source,
+             const svn_string_t *target,
+             apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  *windows = apr_array_make(pool, 16, sizeof(window));
+  svn_txdelta2(&delta_stream,
+               svn_stream_from_string(source, pool),
+               svn_stream_from_string(target, pool),
+               FALSE, pool);
+
+  while (TRUE)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+      if (window == NULL)
+        break;
+
+      APR_ARRAY_PUSH(*windows, svn_txdelta_window_t *)
+        = svn_txdelta_window_dup(window, pool);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Apply WINDOWS to SOURCE ITERATIONS times, discard the result and print
+ * the throughput in terms of TARGET_LEN bytes per iteration under NAME. */
+static svn_error_t *
+run_apply(const char *name,
+          const apr_array_header_t *windows,
+          const svn_string_t *source,
+          apr_size_t target_len,
+          int iterations,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start, duration;
+  double seconds, megabytes;
+  int i, k;
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      unsigned char digest[APR_MD5_DIGESTSIZE];
+
+      svn_pool_clear(iterpool);
+      svn_txdelta_apply(svn_stream_from_string(source, iterpool),
+                        svn_stream_empty(iterpool), digest, NULL, iterpool,
+                        &handler, &handler_baton);
+
+      for (k = 0; k < windows->nelts; ++k)
+        SVN_ERR(handler(APR_ARRAY_IDX(windows, k, svn_txdelta_window_t *),
+                        handler_baton));
+      SVN_ERR(handler(NULL, handler_baton));
+    }
+  duration = apr_time_now() - start;
+
+  seconds = (double)duration / APR_USEC_PER_SEC;
+  megabytes = (double)target_len * iterations / (1024 * 1024);
+  printf("%-10s %d x %.1f MB in %.3f s: %.1f MB/s\n",
+         name, iterations, (double)target_len / (1024 * 1024), seconds,
+         seconds > 0 ? megabytes / seconds : 0.0);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Measure all types of windows for SIZE MB of data. */
+static svn_error_t *
+run_all(apr_size_t size,
+        int iterations,
+        apr_pool_t *pool)
+{
+  svn_stringbuf_t *buffer;
+  svn_string_t *source;
+  svn_string_t *target;
+  svn_string_t *empty = svn_string_create_empty(pool);
+  apr_array_header_t *windows;
+
+  buffer = svn_stringbuf_create_ensure(size * 1024 * 1024, pool);
+  buffer->len = size * 1024 * 1024;
+  fill_source(buffer->data, buffer->len);
+  buffer->data[buffer->len] = '\0';
+  source = svn_stringbuf__morph_into_string(buffer);
+
+  /* Added file: windows consist of new data only. */
+  SVN_ERR(make_windows(&windows, empty, source, pool));
+  SVN_ERR(run_apply("new data", windows, empty, source->len, iterations,
+                    pool));
+
+  /* Unchanged file: each window is a single source copy. */
+  SVN_ERR(make_windows(&windows, source, source, pool));
+  SVN_ERR(run_apply("copy", windows, source, source->len, iterations, pool));
+
+  /* Modified file: a mix of all instruction types. */
+  target = make_target(source, 1024, pool);
+  SVN_ERR(make_windows(&windows, source, target, pool));
+  SVN_ERR(run_apply("mixed", windows, source, target->len, iterations,
+                    pool));
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, char **argv)
+{
+  svn_error_t *err;
+  apr_pool_t *pool;
+  apr_size_t size = 16;
+  int iterations = 10;
+
+  if (argc > 3)
+    {
+      printf("usage: %s [size in MB] [iterations]\n", argv[0]);
+      exit(0);
+    }
+
+  if (argc > 1)
+    size = (apr_size_t)atoi(argv[1]);
+  if (argc > 2)
+    iterations = atoi(argv[2]);
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  err = run_all(size, iterations, pool);
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "apply-bench: ");
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
@@ -36,6 +36,7 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "private/svn_subr_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -330,7 +331,8 @@ do_random_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              i % (svn__zstd_available() ? 4 : 3),
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text delta.  */
@@ -426,7 +428,8 @@ do_random_combine_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              i % (svn__zstd_available() ? 4 : 3),
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text deltas.  */
@@ -605,6 +608,129 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Compute the svndiff of SOURCE and TARGET with the given SVNDIFF_VERSION
+   and COMPRESSION_LEVEL using up to MAX_THREADS and return it in *DIFF.
+   Rewind both files afterwards.  Allocate *DIFF in POOL. */
+static svn_error_t *
+encode_svndiff(svn_stringbuf_t **diff,
+               apr_file_t *source,
+               apr_file_t *target,
+               int svndiff_version,
+               int compression_level,
+               int max_threads,
+               apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *diff = svn_stringbuf_create_empty(pool);
+  svn_txdelta2(&txstream,
+               svn_stream_from_aprfile2(source, TRUE, pool),
+               svn_stream_from_aprfile2(target, TRUE, pool),
+               FALSE, pool);
+  svn_txdelta_to_svndiff_parallel(&handler, &handler_baton,
+                                  svn_stream_from_stringbuf(*diff, pool),
+                                  svndiff_version, compression_level,
+                                  max_threads, pool);
+  SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton, pool));
+
+  rewind_file(source);
+  rewind_file(target);
+
+  return SVN_NO_ERROR;
+}
+
+/* (Note: *LAST_SEED is an output parameter.) */
+static svn_error_t *
+do_parallel_svndiff_test(apr_pool_t *pool,
+                         apr_uint32_t *last_seed)
+{
+  apr_uint32_t seed;
+  apr_uint32_t maxlen;
+  apr_size_t bytes_range;
+  int i;
+  int iterations;
+  int dump_files;
+  int print_windows;
+  const char *random_bytes;
+  apr_pool_t *iterpool;
+
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  /* Use files large enough to span multiple delta windows. */
+  maxlen *= 10;
+  iterations = iterations / 6 + 1;
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < iterations; i++)
+    {
+      apr_uint32_t subseed_base;
+      apr_file_t *source;
+      apr_file_t *target;
+      apr_file_t *new_target;
+      svn_stringbuf_t *serial_diff;
+      svn_stringbuf_t *parallel_diff;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *push_stream;
+      int version = i % 2 + 1;
+
+      svn_pool_clear(iterpool);
+
+      *last_seed = seed;
+      subseed_base = svn_test_rand(&seed);
+      source = generate_random_file(maxlen, subseed_base, &seed,
+                                    random_bytes, bytes_range,
+                                    dump_files, iterpool);
+      target = generate_random_file(maxlen, subseed_base, &seed,
+                                    random_bytes, bytes_range,
+                                    dump_files, iterpool);
+      new_target = open_tempfile(NULL, iterpool);
+
+      /* The threaded encoder must produce exactly the same output. */
+      SVN_ERR(encode_svndiff(&serial_diff, source, target, version,
+                             i % 10, 1, iterpool));
+      SVN_ERR(encode_svndiff(&parallel_diff, source, target, version,
+                             i % 10, 1 + i % 4 * 2, iterpool));
+      if (!svn_stringbuf_compare(serial_diff, parallel_diff))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "parallel svndiff%d output differs",
+                                 version);
+
+      /* And it must decode to the target. */
+      svn_txdelta_apply(svn_stream_from_aprfile2(source, TRUE, iterpool),
+                        svn_stream_from_aprfile2(new_target, TRUE, iterpool),
+                        NULL, NULL, iterpool, &handler, &handler_baton);
+      push_stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                              iterpool);
+      SVN_ERR(svn_stream_write(push_stream, parallel_diff->data,
+                               &parallel_diff->len));
+      SVN_ERR(svn_stream_close(push_stream));
+
+      SVN_ERR(compare_files(target, new_target, dump_files));
+
+      apr_file_close(source);
+      apr_file_close(target);
+      apr_file_close(new_target);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+parallel_svndiff_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err = do_parallel_svndiff_test(pool, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +751,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_PASS2(parallel_svndiff_test,
+                   "multi-threaded svndiff encoding test"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
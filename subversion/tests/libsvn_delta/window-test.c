@@ -28,7 +28,9 @@
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_delta.h"
+#include "svn_pools.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_subr_private.h"
 
 static svn_error_t *
@@ -96,6 +98,96 @@ stream_window_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Fill BUF with LEN pseudo-random bytes, starting with SEED. */
+static void
+fill_random(char *buf, apr_size_t len, apr_uint32_t seed)
+{
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      buf[i] = (char)(seed >> 16);
+    }
+}
+
+static svn_error_t *
+cdc_window_test(apr_pool_t *pool)
+{
+  enum { SOURCE_LEN = 1000000, INSERT_LEN = 250000 };
+  char *source = apr_palloc(pool, SOURCE_LEN);
+  svn_stringbuf_t *target;
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_string_t source_str;
+  svn_checksum_t *expected;
+  svn_checksum_t *actual;
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *parser;
+  apr_size_t new_data_len = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Insert a large block of new data and remove another one. */
+  fill_random(source, SOURCE_LEN, 0);
+  target = svn_stringbuf_ncreate(source, 300000, pool);
+  svn_stringbuf_ensure(target, SOURCE_LEN + INSERT_LEN);
+  fill_random(target->data + target->len, INSERT_LEN, 42);
+  target->len += INSERT_LEN;
+  svn_stringbuf_appendbytes(target, source + 300000, 300000);
+  svn_stringbuf_appendbytes(target, source + 700000, SOURCE_LEN - 700000);
+
+  source_str.data = source;
+  source_str.len = SOURCE_LEN;
+
+  svn_txdelta__cdc(&txstream, svn_stream_from_string(&source_str, pool),
+                   svn_stream_from_stringbuf(target, pool), TRUE, pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(svndiff, pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  while (1)
+    {
+      svn_txdelta_window_t *window;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, txstream, iterpool));
+      SVN_ERR(handler(window, handler_baton));
+      if (window == NULL)
+        break;
+
+      new_data_len += window->new_data->len;
+    }
+
+  SVN_ERR(svn_checksum(&expected, svn_checksum_md5, target->data,
+                       target->len, pool));
+  actual = svn_checksum__from_digest_md5(svn_txdelta_md5_digest(txstream),
+                                         pool);
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  /* Everything but the inserted data and the chunks around the edits
+     should have been found in the source. */
+  if (new_data_len > INSERT_LEN + 50000)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Delta contains %" APR_SIZE_T_FMT
+                             " bytes of new data", new_data_len);
+
+  /* Readers must accept the windows and reproduce the target. */
+  svn_txdelta_apply(svn_stream_from_string(&source_str, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  parser = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+  SVN_ERR(svn_stream_write(parser, svndiff->data, &svndiff->len));
+  SVN_ERR(svn_stream_close(parser));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -107,6 +199,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_PASS2(cdc_window_test,
+                   "content-defined chunking delta"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,159 @@
+/* xdelta-bench.c -- measure the throughput of the xdelta match finder
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "../svn_test.h"
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "private/svn_string_private.h"
+
+
+/* Fill BUF with LEN bytes of pseudo-random, word-like data. */
+static void
+fill_source(char *buf, apr_size_t len)
+{
+  static const char alphabet[] = "etaoinshrdlu cmfwyp\n";
+  apr_uint32_t seed = 12345;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      buf[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+}
+
+/* Return a copy of SOURCE with small modifications every STRIDE bytes,
+ * allocated in POOL.  The result is similar enough to SOURCE for the
+ * delta to mainly consist of long copy instructions. */
+static svn_string_t *
+make_target(const svn_string_t *source, apr_size_t stride, apr_pool_t *pool)
+{
+  svn_stringbuf_t *target = svn_stringbuf_create_ensure(source->len, pool);
+  apr_size_t pos;
+
+  for (pos = 0; pos < source->len; pos += stride)
+    {
+      apr_size_t chunk = source->len - pos;
+
+      if (chunk > stride)
+        chunk = stride;
+
+      svn_stringbuf_appendbytes(target, source->data + pos, chunk);
+      if (chunk > 8)
+        {
+          /* Replace a few bytes and insert a few more. */
+          memcpy(target->data + target->len - 4, "XYZW", 4);
+          svn_stringbuf_appendcstr(target, "inserted");
+        }
+    }
+
+  return svn_stringbuf__morph_into_string(target);
+}
+
+/* Run the delta algorithm on SOURCE and TARGET and discard the windows. */
+static svn_error_t *
+run_delta(const svn_string_t *source,
+          const svn_string_t *target,
+          apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  svn_txdelta2(&delta_stream,
+               svn_stream_from_string(source, pool),
+               svn_stream_from_string(target, pool),
+               FALSE, pool);
+
+  do
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, char **argv)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *pool;
+  svn_stringbuf_t *buffer;
+  svn_string_t *source;
+  svn_string_t *target;
+  apr_size_t size = 16;
+  int iterations = 10;
+  apr_time_t start, duration;
+  double seconds;
+  int i;
+
+  if (argc > 3)
+    {
+      printf("usage: %s [size in MB] [iterations]\n", argv[0]);
+      exit(0);
+    }
+
+  if (argc > 1)
+    size = (apr_size_t)atoi(argv[1]);
+  if (argc > 2)
+    iterations = atoi(argv[2]);
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  buffer = svn_stringbuf_create_ensure(size * 1024 * 1024, pool);
+  buffer->len = size * 1024 * 1024;
+  fill_source(buffer->data, buffer->len);
+  buffer->data[buffer->len] = '\0';
+  source = svn_stringbuf__morph_into_string(buffer);
+
+  /* A single change per kB: mostly long matches that exercise the
+   * match length extension. */
+  target = make_target(source, 1024, pool);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations && !err; ++i)
+    err = run_delta(source, target, pool);
+  duration = apr_time_now() - start;
+
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "xdelta-bench: ");
+
+  seconds = (double)duration / APR_USEC_PER_SEC;
+  printf("%d x %" APR_SIZE_T_FMT " MB in %.3f s: %.1f MB/s\n",
+         iterations, size, seconds,
+         seconds > 0 ? (double)size * iterations / seconds : 0.0);
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
@@ -2325,6 +2325,71 @@ random_three_way_merge(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Like random_three_way_merge, but with much larger files. */
+static svn_error_t *
+large_three_way_merge(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  const char *base_filename1 = "large-original";
+  const char *base_filename2 = "large-modified1";
+  const char *base_filename3 = "large-modified2";
+  const char *base_filename4 = "large-combined";
+
+  const char *filename1 = svn_test_data_path(base_filename1, pool);
+  const char *filename2 = svn_test_data_path(base_filename2, pool);
+  const char *filename3 = svn_test_data_path(base_filename3, pool);
+  const char *filename4 = svn_test_data_path(base_filename4, pool);
+
+  seed_val();
+
+  for (i = 0; i < 2; ++i)
+    {
+      svn_stringbuf_t *original, *modified1, *modified2, *combined;
+      int num_lines = 15000, num_src = 20, num_dst = 20;
+      svn_boolean_t *lines = apr_pcalloc(subpool, sizeof(*lines) * num_lines);
+      struct random_mod *src_lines = apr_palloc(subpool,
+                                                sizeof(*src_lines) * num_src);
+      struct random_mod *dst_lines = apr_palloc(subpool,
+                                                sizeof(*dst_lines) * num_dst);
+      struct random_mod *mrg_lines = apr_palloc(subpool,
+                                                (sizeof(*mrg_lines)
+                                                 * (num_src + num_dst)));
+
+      select_lines(src_lines, num_src, lines, num_lines);
+      select_lines(dst_lines, num_dst, lines, num_lines);
+      memcpy(mrg_lines, src_lines, sizeof(*mrg_lines) * num_src);
+      memcpy(mrg_lines + num_src, dst_lines, sizeof(*mrg_lines) * num_dst);
+
+      SVN_ERR(make_random_merge_file(filename1, num_lines, NULL, 0, subpool));
+      SVN_ERR(make_random_merge_file(filename2, num_lines, src_lines, num_src,
+                                     subpool));
+      SVN_ERR(make_random_merge_file(filename3, num_lines, dst_lines, num_dst,
+                                     subpool));
+      SVN_ERR(make_random_merge_file(filename4, num_lines, mrg_lines,
+                                     num_src + num_dst, subpool));
+
+      SVN_ERR(svn_stringbuf_from_file2(&original, filename1, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&modified1, filename2, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&modified2, filename3, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&combined, filename4, subpool));
+
+      SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename3,
+                              original->data, modified1->data,
+                              modified2->data, combined->data, NULL,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+
+      SVN_ERR(svn_io_remove_file2(filename4, TRUE, subpool));
+
+      svn_pool_clear(subpool);
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This is similar to random_three_way_merge above, except this time half
    of the original-to-modified1 changes are already present in modified2
    (or, equivalently, half the original-to-modified2 changes are already
@@ -3065,6 +3130,154 @@ three_way_double_add(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Check that histogram diff can be selected and produces diffs that
+   correctly reproduce the modified file, including for files with only a
+   few distinct lines, where it has to fall back to other strategies. */
+static svn_error_t *
+test_histogram_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+
+  const char *base_filename1 = "histogram1";
+  const char *base_filename2 = "histogram2";
+
+  const char *filename1 = svn_test_data_path(base_filename1, pool);
+  const char *filename2 = svn_test_data_path(base_filename2, pool);
+
+  APR_ARRAY_PUSH(args, const char *) = "--histogram";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_file_algorithm_histogram);
+
+  SVN_ERR(two_way_diff("histogram3", "histogram4",
+                       "Aa\n"
+                       "Bb\n"
+                       "Cc\n",
+
+                       "Aa\n"
+                       "Xx\n"
+                       "Cc\n",
+
+                       "--- histogram3" NL
+                       "+++ histogram4" NL
+                       "@@ -1,3 +1,3 @@" NL
+                       " Aa\n"
+                       "-Bb\n"
+                       "+Xx\n"
+                       " Cc\n",
+                       diff_opts, pool));
+
+  seed_val();
+
+  for (i = 0; i < 6; ++i)
+    {
+      /* Alternate between mostly distinct lines and files made of only
+         a handful of different lines. */
+      int var_lines = (i % 2) ? 3 : 500;
+      int num_lines = (i % 2) ? 5000 : 1000;
+      svn_stringbuf_t *contents1, *contents2;
+
+      SVN_ERR(make_random_file(filename1,
+                               num_lines, num_lines + 100, var_lines, 10,
+                               i % 3, subpool));
+      SVN_ERR(make_random_file(filename2,
+                               num_lines, num_lines + 100, var_lines, 10,
+                               i % 2, subpool));
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents1, filename1, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&contents2, filename2, subpool));
+
+      SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename1,
+                              contents1->data, contents2->data,
+                              contents1->data, contents2->data, diff_opts,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      SVN_ERR(three_way_merge(base_filename2, base_filename1, base_filename2,
+                              contents2->data, contents1->data,
+                              contents2->data, contents1->data, diff_opts,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      svn_pool_clear(subpool);
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that a diff with a memory limit, which processes the files in
+   windows of about a thousand lines, still finds changes that are far
+   apart and that lie on window boundaries. */
+static svn_error_t *
+test_windowed_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create("--- windowed1" NL
+                                                   "+++ windowed2" NL,
+                                                   pool);
+  static const int changed[] = { 10, 1024, 2048, 2049, 5000, 9990 };
+  const int num_changed = sizeof(changed) / sizeof(changed[0]);
+  int i, j;
+
+  /* Use the smallest possible windows. */
+  diff_opts->memory_limit = 1;
+
+  for (i = 1; i <= 10000; i++)
+    {
+      for (j = 0; j < num_changed; j++)
+        if (changed[j] == i)
+          break;
+
+      svn_stringbuf_appendcstr(original,
+                               apr_psprintf(pool, "line %d\n", i));
+      svn_stringbuf_appendcstr(modified,
+                               apr_psprintf(pool, j < num_changed
+                                                    ? "changed %d\n"
+                                                    : "line %d\n", i));
+    }
+
+  for (j = 0; j < num_changed; j++)
+    {
+      int first = changed[j];
+      int last = changed[j];
+
+      /* Adjacent changes share a hunk. */
+      while (j + 1 < num_changed && changed[j + 1] == last + 1)
+        last = changed[++j];
+
+      svn_stringbuf_appendcstr(expected,
+                               apr_psprintf(pool, "@@ -%d,%d +%d,%d @@" NL,
+                                            first - 3, last - first + 7,
+                                            first - 3, last - first + 7));
+      for (i = first - 3; i < first; i++)
+        svn_stringbuf_appendcstr(expected,
+                                 apr_psprintf(pool, " line %d\n", i));
+      for (i = first; i <= last; i++)
+        svn_stringbuf_appendcstr(expected,
+                                 apr_psprintf(pool, "-line %d\n", i));
+      for (i = first; i <= last; i++)
+        svn_stringbuf_appendcstr(expected,
+                                 apr_psprintf(pool, "+changed %d\n", i));
+      for (i = last + 1; i <= last + 3; i++)
+        svn_stringbuf_appendcstr(expected,
+                                 apr_psprintf(pool, " line %d\n", i));
+    }
+
+  SVN_ERR(two_way_diff("windowed1", "windowed2",
+                       original->data, modified->data, expected->data,
+                       diff_opts, pool));
+
+  /* Identical files must not produce any hunks. */
+  SVN_ERR(two_way_diff("windowed1", "windowed2",
+                       original->data, original->data, "",
+                       diff_opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -3109,6 +3322,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "2-way issue #3362 test v2"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
+    SVN_TEST_PASS2(test_histogram_diff,
+                   "histogram diff"),
+    SVN_TEST_PASS2(test_windowed_diff,
+                   "diff with a memory limit"),
+    SVN_TEST_PASS2(large_three_way_merge,
+                   "3-way merge of large files"),
     SVN_TEST_NULL
   };
 
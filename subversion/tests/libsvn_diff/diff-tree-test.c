@@ -0,0 +1,326 @@
+/*
+ * Regression tests for the diff tree processors
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "../svn_test.h"
+
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_diff_tree.h"
+
+/* Number of files to report per drive.  Exceeds the pipeline's queue. */
+#define FILE_COUNT 200
+
+/* Baton of the recording processor. */
+typedef struct recorder_t
+{
+  /* One line per call received. */
+  svn_stringbuf_t *log;
+
+  /* Directory whose children get skipped. */
+  const char *skip_children_of;
+
+  /* File for which file_changed() fails. */
+  const char *fail_on;
+} recorder_t;
+
+static svn_error_t *
+record_dir_opened(void **new_dir_baton,
+                  svn_boolean_t *skip,
+                  svn_boolean_t *skip_children,
+                  const char *relpath,
+                  const svn_diff_source_t *left_source,
+                  const svn_diff_source_t *right_source,
+                  const svn_diff_source_t *copyfrom_source,
+                  void *parent_dir_baton,
+                  const svn_diff_tree_processor_t *processor,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  recorder_t *r = processor->baton;
+
+  svn_stringbuf_appendcstr(r->log, apr_psprintf(scratch_pool,
+                                                "dir_opened %s\n", relpath));
+  *skip_children = (r->skip_children_of
+                    && !strcmp(relpath, r->skip_children_of));
+  *new_dir_baton = apr_pstrdup(result_pool, relpath);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_dir_closed(const char *relpath,
+                  const svn_diff_source_t *left_source,
+                  const svn_diff_source_t *right_source,
+                  void *dir_baton,
+                  const svn_diff_tree_processor_t *processor,
+                  apr_pool_t *scratch_pool)
+{
+  recorder_t *r = processor->baton;
+
+  SVN_TEST_STRING_ASSERT(dir_baton, relpath);
+  svn_stringbuf_appendcstr(r->log, apr_psprintf(scratch_pool,
+                                                "dir_closed %s\n", relpath));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_file_opened(void **new_file_baton,
+                   svn_boolean_t *skip,
+                   const char *relpath,
+                   const svn_diff_source_t *left_source,
+                   const svn_diff_source_t *right_source,
+                   const svn_diff_source_t *copyfrom_source,
+                   void *dir_baton,
+                   const svn_diff_tree_processor_t *processor,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  recorder_t *r = processor->baton;
+
+  svn_stringbuf_appendcstr(r->log, apr_psprintf(scratch_pool,
+                                                "file_opened %s\n", relpath));
+  *new_file_baton = apr_pstrdup(result_pool, relpath);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_file_changed(const char *relpath,
+                    const svn_diff_source_t *left_source,
+                    const svn_diff_source_t *right_source,
+                    const char *left_file,
+                    const char *right_file,
+                    /*const*/ apr_hash_t *left_props,
+                    /*const*/ apr_hash_t *right_props,
+                    svn_boolean_t file_modified,
+                    const apr_array_header_t *prop_changes,
+                    void *file_baton,
+                    const svn_diff_tree_processor_t *processor,
+                    apr_pool_t *scratch_pool)
+{
+  recorder_t *r = processor->baton;
+  svn_stringbuf_t *contents;
+
+  SVN_TEST_STRING_ASSERT(file_baton, relpath);
+  if (r->fail_on && !strcmp(relpath, r->fail_on))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  /* The driver has removed its file already. */
+  SVN_ERR(svn_stringbuf_from_file2(&contents, right_file, scratch_pool));
+  svn_stringbuf_appendcstr(r->log, apr_psprintf(scratch_pool,
+                                                "file_changed %s: %s\n",
+                                                relpath, contents->data));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a tree processor recording its calls in a new recorder_t,
+ * returned in *RECORDER.  Allocate everything in POOL. */
+static svn_diff_tree_processor_t *
+create_recorder(recorder_t **recorder,
+                apr_pool_t *pool)
+{
+  recorder_t *r = apr_pcalloc(pool, sizeof(*r));
+  svn_diff_tree_processor_t *processor
+    = svn_diff__tree_processor_create(r, pool);
+
+  r->log = svn_stringbuf_create_empty(pool);
+
+  processor->dir_opened = record_dir_opened;
+  processor->dir_closed = record_dir_closed;
+  processor->file_opened = record_file_opened;
+  processor->file_changed = record_file_changed;
+
+  *recorder = r;
+  return processor;
+}
+
+/* Report the directory RELPATH, containing FILE_COUNT changed files, to
+ * PROCESSOR as a child of PARENT_BATON.  Create the files in SANDBOX and
+ * remove them as soon as they have been reported.  SKIPPED tells whether
+ * PROCESSOR is expected to skip the children.  Append the calls that a
+ * recording processor should see to EXPECTED.  Stop at the first error
+ * and return it. */
+static svn_error_t *
+drive_dir(const svn_diff_tree_processor_t *processor,
+          const char *relpath,
+          void *parent_baton,
+          svn_boolean_t skipped,
+          const char *sandbox,
+          svn_stringbuf_t *expected,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  void *dir_baton;
+  svn_boolean_t skip, skip_children;
+  int i;
+
+  SVN_ERR(processor->dir_opened(&dir_baton, &skip, &skip_children, relpath,
+                                NULL, NULL, NULL, parent_baton, processor,
+                                pool, iterpool));
+  SVN_TEST_ASSERT(!skip);
+  svn_stringbuf_appendcstr(expected, apr_psprintf(pool, "dir_opened %s\n",
+                                                  relpath));
+
+  for (i = 0; i < FILE_COUNT && !skip_children; i++)
+    {
+      const char *file_relpath;
+      const char *text;
+      const char *right_file;
+      void *file_baton;
+
+      svn_pool_clear(iterpool);
+      file_relpath = apr_psprintf(iterpool, "%s/f-%d", relpath, i);
+      text = apr_psprintf(iterpool, "text %d", i);
+
+      SVN_ERR(processor->file_opened(&file_baton, &skip, file_relpath,
+                                     NULL, NULL, NULL, dir_baton, processor,
+                                     iterpool, iterpool));
+      SVN_TEST_ASSERT(!skip);
+
+      SVN_ERR(svn_io_write_unique(&right_file, sandbox, text, strlen(text),
+                                  svn_io_file_del_none, iterpool));
+      SVN_ERR(processor->file_changed(file_relpath, NULL, NULL, NULL,
+                                      right_file, NULL, NULL, TRUE, NULL,
+                                      file_baton, processor, iterpool));
+      SVN_ERR(svn_io_remove_file2(right_file, FALSE, iterpool));
+
+      svn_stringbuf_appendcstr(expected,
+                               apr_psprintf(pool, "file_opened %s\n"
+                                                  "file_changed %s: %s\n",
+                                            file_relpath, file_relpath,
+                                            text));
+    }
+
+  SVN_TEST_ASSERT(skip_children == skipped);
+
+  SVN_ERR(processor->dir_closed(relpath, NULL, NULL, dir_baton, processor,
+                                iterpool));
+  svn_stringbuf_appendcstr(expected, apr_psprintf(pool, "dir_closed %s\n",
+                                                  relpath));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_pipeline_order_and_skip(apr_pool_t *pool)
+{
+  recorder_t *r;
+  const svn_diff_tree_processor_t *processor
+    = svn_diff__tree_processor_pipeline_create(create_recorder(&r, pool),
+                                               pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  const char *sandbox;
+  void *root_baton;
+  svn_boolean_t skip, skip_children;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "diff-tree-pipeline", pool));
+  r->skip_children_of = "skipped";
+
+  SVN_ERR(processor->dir_opened(&root_baton, &skip, &skip_children, "",
+                                NULL, NULL, NULL, NULL, processor,
+                                pool, pool));
+  SVN_TEST_ASSERT(!skip && !skip_children);
+  svn_stringbuf_appendcstr(expected, "dir_opened \n");
+
+  SVN_ERR(drive_dir(processor, "A", root_baton, FALSE, sandbox, expected,
+                    pool));
+  SVN_ERR(drive_dir(processor, "skipped", root_baton, TRUE, sandbox,
+                    expected, pool));
+  SVN_ERR(drive_dir(processor, "B", root_baton, FALSE, sandbox, expected,
+                    pool));
+
+  /* Closing the root waits for the wrapped processor to catch up. */
+  SVN_ERR(processor->dir_closed("", NULL, NULL, root_baton, processor,
+                                pool));
+  svn_stringbuf_appendcstr(expected, "dir_closed \n");
+
+  SVN_TEST_STRING_ASSERT(r->log->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_pipeline_error(apr_pool_t *pool)
+{
+  apr_pool_t *pipeline_pool = svn_pool_create(pool);
+  recorder_t *r;
+  const svn_diff_tree_processor_t *processor
+    = svn_diff__tree_processor_pipeline_create(create_recorder(&r, pool),
+                                               pipeline_pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  const char *sandbox;
+  void *root_baton;
+  svn_boolean_t skip, skip_children;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "diff-tree-pipeline-error",
+                                    pool));
+  r->fail_on = "A/f-10";
+
+  SVN_ERR(processor->dir_opened(&root_baton, &skip, &skip_children, "",
+                                NULL, NULL, NULL, NULL, processor,
+                                pool, pool));
+
+  /* The error may be returned by any later call but at the latest when
+     the root gets closed. */
+  err = drive_dir(processor, "A", root_baton, FALSE, sandbox, expected,
+                  pool);
+  if (!err)
+    err = processor->dir_closed("", NULL, NULL, root_baton, processor,
+                                pool);
+
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_CANCELLED);
+
+  /* Nothing gets forwarded after the failure. */
+  SVN_TEST_ASSERT(strstr(r->log->data, "file_opened A/f-10\n"));
+  SVN_TEST_ASSERT(!strstr(r->log->data, "A/f-11"));
+  SVN_TEST_ASSERT(!strstr(r->log->data, "dir_closed"));
+
+  /* Stops the worker and releases the outstanding events. */
+  svn_pool_destroy(pipeline_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_pipeline_order_and_skip,
+                   "pipeline processor order and skipping"),
+    SVN_TEST_PASS2(test_pipeline_error,
+                   "pipeline processor error handling"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
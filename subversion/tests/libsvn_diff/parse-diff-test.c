@@ -1104,6 +1104,87 @@ test_parse_unidiff_with_mergeinfo(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Number of hunks in the patch parsed by test_parse_large_patch(). */
+#define HUNK_COUNT 1000
+
+/* Parse a patch large enough to be mapped into memory, with lines
+ * alternating between LF and CRLF, and make sure that the hunks can't
+ * be read anymore once the patch file has been closed. */
+static svn_error_t *
+test_parse_large_patch(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *diff = svn_stringbuf_create(
+                            "Index: big"                              NL
+                            "===================================="   NL
+                            "--- big\t(revision 1)"                   NL
+                            "+++ big\t(working copy)"                 NL,
+                            pool);
+  svn_patch_file_t *patch_file;
+  svn_patch_t *patch;
+  svn_diff_hunk_t *hunk;
+  svn_stringbuf_t *line;
+  const char *eol;
+  svn_boolean_t eof;
+  int i;
+
+  for (i = 0; i < HUNK_COUNT; i++)
+    {
+      const char *line_eol = (i % 2) ? "\r\n" : "\n";
+
+      svn_stringbuf_appendcstr(diff,
+                               apr_psprintf(pool,
+                                            "@@ -%d,1 +%d,1 @@\n"
+                                            "-old %d%s"
+                                            "+new %d%s",
+                                            2 * i + 1, 2 * i + 1,
+                                            i, line_eol, i, line_eol));
+    }
+
+  SVN_ERR(create_patch_file(&patch_file, diff->data, pool));
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file,
+                                    FALSE, /* reverse */
+                                    FALSE, /* ignore_whitespace */
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch);
+  SVN_TEST_STRING_ASSERT(patch->old_filename, "big");
+  SVN_TEST_INT_ASSERT(patch->hunks->nelts, HUNK_COUNT);
+
+  for (i = 0; i < HUNK_COUNT; i++)
+    {
+      const char *expected_eol = (i % 2) ? "\r\n" : "\n";
+
+      svn_pool_clear(iterpool);
+      hunk = APR_ARRAY_IDX(patch->hunks, i, svn_diff_hunk_t *);
+      SVN_TEST_INT_ASSERT(svn_diff_hunk_get_original_start(hunk), 2 * i + 1);
+
+      SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "old %d", i));
+      SVN_TEST_STRING_ASSERT(eol, expected_eol);
+
+      SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "new %d", i));
+      SVN_TEST_STRING_ASSERT(eol, expected_eol);
+    }
+
+  SVN_ERR(svn_diff_close_patch_file(patch_file, pool));
+
+  /* The hunks outlive the patch file but must not read from it. */
+  hunk = APR_ARRAY_IDX(patch->hunks, 0, svn_diff_hunk_t *);
+  svn_diff_hunk_reset_original_text(hunk);
+  SVN_TEST_ASSERT_ERROR(svn_diff_hunk_readline_original_text(hunk, &line,
+                                                             &eol, &eof,
+                                                             pool, pool),
+                        SVN_ERR_INCORRECT_PARAMS);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1132,6 +1213,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing unidiffs lacking trailing eol"),
     SVN_TEST_PASS2(test_parse_unidiff_with_mergeinfo,
                    "test parsing unidiffs with mergeinfo"),
+    SVN_TEST_PASS2(test_parse_large_patch,
+                   "test parsing large patches from memory"),
     SVN_TEST_NULL
   };
 
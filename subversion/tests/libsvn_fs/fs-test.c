@@ -7077,6 +7077,37 @@ verify_added_files_list(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Check that seeking to PATH in REVISION of FS reports exactly the
+ * EXPECTED_COUNT changes at or below PATH. */
+static svn_error_t *
+verify_changes_below(svn_fs_t *fs,
+                     svn_revnum_t revision,
+                     const char *path,
+                     int expected_count,
+                     apr_pool_t *scratch_pool)
+{
+  int count = 0;
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_path_change_seek(iterator, path, scratch_pool));
+
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      SVN_TEST_ASSERT(svn_fspath__skip_ancestor(path, change->path.data));
+      ++count;
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_ASSERT(count == expected_count);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_large_changed_paths_list(const svn_test_opts_t *opts,
                               apr_pool_t *pool)
@@ -7112,6 +7143,14 @@ test_large_changed_paths_list(const svn_test_opts_t *opts,
   SVN_ERR(verify_added_files_list(fs, rev, iterpool));
   svn_pool_clear(iterpool);
   SVN_ERR(verify_added_files_list(fs, rev, iterpool));
+
+  /* Restrict the list to a single path, both at the start and past the
+   * first block of the list, and to the whole tree. */
+  svn_pool_clear(iterpool);
+  SVN_ERR(verify_changes_below(fs, rev, "/file-1", 1, iterpool));
+  SVN_ERR(verify_changes_below(fs, rev, "/file-999", 1, iterpool));
+  SVN_ERR(verify_changes_below(fs, rev, "/file-9999", 0, iterpool));
+  SVN_ERR(verify_changes_below(fs, rev, "/", CHANGES_COUNT, iterpool));
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -7299,9 +7338,9 @@ test_rep_sharing_strict_content_check(const svn_test_opts_t *opts,
   svn_pool_clear(subpool);
 
   /* Doctor the first repo such that it uses the wrong rep-cache. */
-  SVN_ERR(svn_io_copy_file(svn_relpath_join(fs_path2, "rep-cache.db", pool),
-                           svn_relpath_join(fs_path, "rep-cache.db", pool),
-                           FALSE, pool));
+  SVN_ERR(svn_io_copy_file2(svn_relpath_join(fs_path2, "rep-cache.db", pool),
+                            svn_relpath_join(fs_path, "rep-cache.db", pool),
+                            0, NULL, pool));
 
   /* Changing the file contents such that rep-sharing would kick in if
      the file contents was not properly compared. */
@@ -7369,6 +7408,116 @@ closest_copy_test_svn_4677(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+delete_folds_sub_path_changes(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t head_rev = 0;
+  apr_hash_t *changes;
+  svn_fs_path_change2_t *change;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-delete-folds-sub-paths",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, head_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(test_commit_txn(&head_rev, txn, NULL, pool));
+
+  /* Change a few nodes at various depths, then delete their parent. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, head_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/D/G/rho", "new rho", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/D/gamma", "new gamma",
+                                      pool));
+  SVN_ERR(svn_fs_make_file(root, "A/D/H/new", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/B/lambda", "new lambda",
+                                      pool));
+  SVN_ERR(svn_fs_delete(root, "A/D", pool));
+
+  /* Only the changes outside the deleted sub-tree remain. */
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 2);
+  change = svn_hash_gets(changes, "/A/D");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_delete);
+  change = svn_hash_gets(changes, "/A/B/lambda");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_modify);
+
+  /* Changes below the replacement are independent of the old ones. */
+  SVN_ERR(svn_fs_make_dir(root, "A/D", pool));
+  SVN_ERR(svn_fs_make_dir(root, "A/D/G", pool));
+  SVN_ERR(svn_fs_make_file(root, "A/D/G/rho", pool));
+
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 4);
+  change = svn_hash_gets(changes, "/A/D");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_replace);
+  change = svn_hash_gets(changes, "/A/D/G");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_add);
+  change = svn_hash_gets(changes, "/A/D/G/rho");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_add);
+
+  /* Deleting the grand-parent removes them all again. */
+  SVN_ERR(svn_fs_delete(root, "A", pool));
+
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 1);
+  change = svn_hash_gets(changes, "/A");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_delete);
+
+  SVN_ERR(test_commit_txn(&head_rev, txn, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+shared_fs_views(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs, *view1, *view2;
+  svn_fs_shared_t *shared;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t head_rev = 0;
+  svn_stringbuf_t *contents;
+  const char *uuid, *view_uuid;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-shared-fs-views",
+                              opts, pool));
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+
+  SVN_ERR(svn_fs_open_shared(&shared, svn_fs_path(fs, pool), NULL,
+                             pool, pool));
+  SVN_ERR(svn_fs_open_view(&view1, shared, pool, pool));
+  SVN_ERR(svn_fs_open_view(&view2, shared, pool, pool));
+
+  SVN_ERR(svn_fs_get_uuid(view1, &view_uuid, pool));
+  SVN_TEST_STRING_ASSERT(view_uuid, uuid);
+
+  /* Commit through one view ... */
+  SVN_ERR(svn_fs_begin_txn(&txn, view1, head_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(test_commit_txn(&head_rev, txn, NULL, pool));
+
+  /* ... and see the result through the other. */
+  SVN_ERR(svn_fs_youngest_rev(&head_rev, view2, pool));
+  SVN_TEST_INT_ASSERT(head_rev, 1);
+  SVN_ERR(svn_fs_revision_root(&root, view2, head_rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'iota'.\n");
+
+  /* Views opened later see the new revision as well. */
+  SVN_ERR(svn_fs_open_view(&view1, shared, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&head_rev, view1, pool));
+  SVN_TEST_INT_ASSERT(head_rev, 1);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7513,6 +7662,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test rep-sharing on content rather than SHA1"),
     SVN_TEST_OPTS_PASS(closest_copy_test_svn_4677,
                        "test issue SVN-4677 regression"),
+    SVN_TEST_OPTS_PASS(delete_folds_sub_path_changes,
+                       "deletion removes changes below it"),
+    SVN_TEST_OPTS_PASS(shared_fs_views,
+                       "test views of a shared filesystem"),
     SVN_TEST_NULL
   };
 
@@ -28,15 +28,24 @@
 #include "../../libsvn_fs/fs-loader.h"
 #include "../../libsvn_fs_fs/fs.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/index.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/rev_file.h"
+#include "../../libsvn_fs_fs/transaction.h"
 #include "../../libsvn_fs_fs/util.h"
 
+#include "svn_cache_config.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_fs.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
 #include "../svn_test_fs.h"
 
@@ -190,7 +199,7 @@ create_packed_filesystem(const char *dir,
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, NULL, pack_notify, &pnb, NULL, NULL, pool);
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -225,7 +234,7 @@ prepare_revprop_repo(svn_fs_t **fs,
   svn_pool_destroy(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, NULL, NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -651,7 +660,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
   /* Create a packed FS for which every revision will live in a pack
      digest file, and then recover it. */
   SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
-  SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
 
   /* Add another revision, re-pack, re-recover. */
   subpool = svn_pool_create(pool);
@@ -662,8 +671,8 @@ recover_fully_packed(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, subpool));
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
   svn_pool_destroy(subpool);
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
-  SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
 
   /* Now, delete the youngest revprop file, and recover again.  This
      time we want to see an error! */
@@ -674,7 +683,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
                                                 after_rev),
                                    SVN_VA_NULL),
               FALSE, pool));
-  err = svn_fs_recover(REPO_NAME, NULL, NULL, pool);
+  err = svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool);
   if (! err)
     return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
                             "Expected SVN_ERR_FS_CORRUPT error; got none");
@@ -1001,7 +1010,7 @@ upgrade_txns_to_log_addressing(const svn_test_opts_t *opts,
   /* Pack repo to verify that old and new shard get packed according to
      their respective addressing mode */
 
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, NULL, NULL, NULL, NULL, NULL, pool));
 
   /* verify that our changes got in */
 
@@ -1887,6 +1896,2386 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-read_mmapped_fs"
+#define SHARD_SIZE 5
+#define MAX_REV 7
+static svn_error_t *
+read_mmapped_fs(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev, i;
+  svn_stringbuf_t *big_text, *rstring;
+  svn_stream_t *rstream;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_hash_t *fs_config;
+
+  /* Some packed and some non-packed revisions. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Add a file spanning multiple txdelta windows and deltify it. */
+  big_text = svn_stringbuf_create("Some text\n", pool);
+  while (big_text->len <= 3 * 102400)
+    svn_stringbuf_appendstr(big_text, big_text);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, MAX_REV, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "big", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "big", big_text->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  svn_stringbuf_insert(big_text, 1000, "Modified\n", 9);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "big", big_text->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Use a new FS instance with disjoint caches and mmap enabled. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->enable_mmap = TRUE;
+
+  /* The files should actually be mapped, if the platform supports it. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+#if APR_HAS_MMAP && APR_SIZEOF_VOIDP >= 8
+  SVN_TEST_ASSERT(rev_file->mapped_data != NULL);
+  SVN_TEST_ASSERT(svn_fs_fs__rev_file_mapped_data(rev_file,
+                                                  rev_file->mapped_size,
+                                                  1) == NULL);
+#endif
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Read the data back. */
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      const char *expected = i == 1 ? "This is the file 'iota'.\n"
+                                    : get_rev_contents(i, pool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+      SVN_TEST_STRING_ASSERT(rstring->data, expected);
+    }
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_file_contents(&rstream, root, "big", pool));
+  SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(rstring, big_text));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-batch_read_rev_file"
+static svn_error_t *
+batch_read_rev_file(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_array_header_t *requests;
+  apr_size_t i;
+  apr_uint32_t seed = 0;
+  int pass;
+
+  /* (offset, size) pairs: unordered, overlapping, adjacent and far apart. */
+  static const apr_off_t ranges[][2] = {
+    { 100, 50 }, { 0, 10 }, { 120, 100 }, { 10, 5 }, { 0, 0 },
+    { 9000, 1000 }, { 5000, 16 }, { 130, 10 }
+  };
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Create a rev file large enough to cover all RANGES. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_make_file(root, "big", pool));
+  /* Pseudo-random data won't compress. */
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 20000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+  SVN_ERR(svn_test__set_file_contents(root, "big", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_fs_fs__path_rev_absolute(fs, rev,
+                                                                pool),
+                                   pool));
+  SVN_TEST_ASSERT(contents->len >= 10000);
+
+  /* Once with standard file access and once with mmap, if available. */
+  ffd = fs->fsap_data;
+  for (pass = 0; pass < 2; ++pass)
+    {
+      svn_fs_fs__revision_file_t *rev_file;
+
+      ffd->enable_mmap = pass == 1;
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool,
+                                               pool));
+
+      requests = apr_array_make(pool, 8, sizeof(svn_fs_fs__read_request_t));
+      for (i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i)
+        {
+          svn_fs_fs__read_request_t *request = apr_array_push(requests);
+          request->offset = ranges[i][0];
+          request->size = (apr_size_t)ranges[i][1];
+          request->data = NULL;
+        }
+
+      SVN_ERR(svn_fs_fs__rev_file_read_many(rev_file, requests, pool, pool));
+
+      for (i = 0; i < requests->nelts; ++i)
+        {
+          svn_fs_fs__read_request_t *request
+            = &APR_ARRAY_IDX(requests, i, svn_fs_fs__read_request_t);
+
+          SVN_TEST_ASSERT(request->data != NULL);
+          SVN_TEST_ASSERT(memcmp(request->data,
+                                 contents->data + request->offset,
+                                 request->size) == 0);
+        }
+
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-packed_l2p_bulk_lookup"
+#define SHARD_SIZE 5
+#define MAX_REV 7
+static svn_error_t *
+packed_l2p_bulk_lookup(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd, *ffd2;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *max_ids;
+  apr_array_header_t *items;
+  apr_off_t *offsets;
+  svn_fs_fs__id_part_t bad_item;
+  apr_off_t bad_offset;
+  svn_revnum_t rev;
+  svn_revnum_t first_rev = 0;
+  int i, total;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* List all items of the first, packed shard. */
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, 0, SHARD_SIZE,
+                                     pool, pool));
+  items = apr_array_make(pool, 16, sizeof(svn_fs_fs__id_part_t));
+  for (rev = 0; rev < SHARD_SIZE; ++rev)
+    {
+      apr_uint64_t max_id = APR_ARRAY_IDX(max_ids, rev, apr_uint64_t);
+      apr_uint64_t k;
+
+      for (k = 0; k < max_id; ++k)
+        {
+          svn_fs_fs__id_part_t *item = apr_array_push(items);
+          item->revision = rev;
+          item->number = k;
+        }
+    }
+
+  /* Resolve them all at once. */
+  total = items->nelts;
+  offsets = apr_pcalloc(pool, total * sizeof(*offsets));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 0, pool, pool));
+  SVN_ERR(svn_fs_fs__item_offsets(offsets, fs, rev_file,
+                                  (const svn_fs_fs__id_part_t *)items->elts,
+                                  total, pool));
+
+  /* The in-process index must be active now. */
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->packed_l2p);
+  SVN_TEST_ASSERT(apr_hash_get(ffd->packed_l2p, &first_rev,
+                               sizeof(first_rev)));
+
+  /* Each used item must be found at its offset in the P2L index. */
+  for (i = 0; i < total; ++i)
+    {
+      const svn_fs_fs__id_part_t *item
+        = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+      svn_fs_fs__p2l_entry_t *entry;
+
+      if (offsets[i] < 0)
+        continue;
+
+      SVN_ERR(svn_fs_fs__p2l_entry_lookup(&entry, fs, rev_file,
+                                          item->revision, offsets[i],
+                                          pool, pool));
+      SVN_TEST_ASSERT(entry != NULL);
+      SVN_TEST_ASSERT(entry->item.revision == item->revision);
+      SVN_TEST_ASSERT(entry->item.number == item->number);
+    }
+
+  /* Item indexes beyond the end of a revision must be rejected. */
+  bad_item.revision = 1;
+  bad_item.number = APR_ARRAY_IDX(max_ids, 1, apr_uint64_t);
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__item_offsets(&bad_offset, fs, rev_file,
+                                                &bad_item, 1, pool),
+                        SVN_ERR_FS_INDEX_OVERFLOW);
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* A second FS instance in the same process shares the index. */
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs2, 0, pool, pool));
+  SVN_ERR(svn_fs_fs__item_offsets(offsets, fs2, rev_file,
+                                  (const svn_fs_fs__id_part_t *)items->elts,
+                                  1, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  ffd2 = fs2->fsap_data;
+  SVN_TEST_ASSERT(ffd2->packed_l2p);
+  SVN_TEST_ASSERT(   apr_hash_get(ffd2->packed_l2p, &first_rev,
+                                  sizeof(first_rev))
+                  == apr_hash_get(ffd->packed_l2p, &first_rev,
+                                  sizeof(first_rev)));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-parallel_pack"
+#define SHARD_SIZE 4
+#define MAX_REV 29
+static svn_error_t *
+parallel_pack(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  struct pack_notify_baton pnb;
+  apr_hash_t *fs_config;
+  svn_revnum_t i;
+  apr_int64_t shard;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Use fewer jobs than there are shards such that task slots get
+     reused.  The notifications must still arrive in shard order. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_JOBS, "3");
+
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack2(REPO_NAME, fs_config, pack_notify, &pnb, NULL, NULL,
+                       pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+  SVN_TEST_ASSERT(pnb.expected_action == svn_fs_pack_notify_start);
+
+  /* All complete shards have been replaced by pack files. */
+  for (shard = 0; shard < (MAX_REV + 1) / SHARD_SIZE; ++shard)
+    {
+      svn_node_kind_t kind;
+      const char *path;
+
+      path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                  apr_psprintf(pool,
+                                               "%" APR_INT64_T_FMT ".pack",
+                                               shard),
+                                  "pack", SVN_VA_NULL);
+      SVN_ERR(svn_io_check_path(path, &kind, pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+
+      path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                  apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                               shard),
+                                  SVN_VA_NULL);
+      SVN_ERR(svn_io_check_path(path, &kind, pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+    }
+
+  /* The contents must be the same as before. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *contents;
+      const char *expected = i == 1 ? "This is the file 'iota'.\n"
+                                    : get_rev_contents(i, pool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_test__get_file_contents(rev_root, "iota", &contents,
+                                          pool));
+      SVN_TEST_STRING_ASSERT(contents->data, expected);
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+/* Baton for hotcopy_notify(). */
+struct hotcopy_notify_baton
+{
+  /* The lowest revision that may be reported next. */
+  svn_revnum_t next_rev;
+
+  /* Set if revisions have been reported out of order. */
+  svn_boolean_t out_of_order;
+};
+
+/* Implements svn_fs_hotcopy_notify_t.  Check that the revision ranges
+   get reported in ascending order. */
+static void
+hotcopy_notify(void *baton,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision,
+               apr_pool_t *scratch_pool)
+{
+  struct hotcopy_notify_baton *hnb = baton;
+
+  if (start_revision < hnb->next_rev || end_revision < start_revision)
+    hnb->out_of_order = TRUE;
+
+  hnb->next_rev = end_revision + 1;
+}
+
+#define REPO_NAME "test-repo-parallel_hotcopy"
+#define SHARD_SIZE 4
+#define MAX_REV 21
+static svn_error_t *
+parallel_hotcopy(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *dst_name = REPO_NAME "-copy";
+  const char *hotcopy_config = "\n[hotcopy]\njobs = 3\n";
+  struct hotcopy_notify_baton hnb;
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_revnum_t youngest, i;
+
+  /* Some packed and some non-packed revisions. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Enable concurrent copying in the hotcopy source. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, hotcopy_config,
+                                 strlen(hotcopy_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* A full hotcopy must report all revisions without gaps. */
+  SVN_ERR(svn_io_remove_dir2(dst_name, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(dst_name);
+
+  hnb.next_rev = 0;
+  hnb.out_of_order = FALSE;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_name, FALSE, FALSE,
+                          hotcopy_notify, &hnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(!hnb.out_of_order);
+  SVN_TEST_ASSERT(hnb.next_rev == MAX_REV + 1);
+
+  /* Add more revisions such that another shard gets packed and
+     hotcopy them incrementally. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (youngest = MAX_REV; youngest < MAX_REV + SHARD_SIZE + 2; )
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(youngest + 1,
+                                                           pool),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest, txn, pool));
+    }
+
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+
+  hnb.next_rev = 0;
+  hnb.out_of_order = FALSE;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_name, FALSE, TRUE,
+                          hotcopy_notify, &hnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(!hnb.out_of_order);
+  SVN_TEST_ASSERT(hnb.next_rev == youngest + 1);
+
+  /* The copy must be complete and consistent. */
+  SVN_ERR(svn_fs_open2(&fs, dst_name, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&i, fs, pool));
+  SVN_TEST_ASSERT(i == youngest);
+
+  for (i = 1; i <= youngest; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *contents;
+      const char *expected = i == 1 ? "This is the file 'iota'.\n"
+                                    : get_rev_contents(i, pool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_test__get_file_contents(rev_root, "iota", &contents,
+                                          pool));
+      SVN_TEST_STRING_ASSERT(contents->data, expected);
+    }
+
+  SVN_ERR(svn_fs_verify(dst_name, NULL, 0, youngest, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+#define REPO_NAME "test-repo-group_commit"
+#define MAX_REV 12
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  const char *group_commit_config = "\n[io]\ngroup-commit = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_t *fs_handles[2];
+  svn_revnum_t youngest = 0;
+  svn_revnum_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Enable group commits. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, group_commit_config,
+                                 strlen(group_commit_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Commit alternately through two handles sharing the same process-wide
+     group commit state. */
+  SVN_ERR(svn_fs_open2(&fs_handles[0], REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs_handles[1], REPO_NAME, NULL, pool, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs_handles[0]->fsap_data)->group_commit);
+
+  while (youngest < MAX_REV)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+      svn_revnum_t new_rev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs_handles[youngest % 2], youngest,
+                               iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (youngest == 0)
+        SVN_ERR(svn_fs_make_file(root, "iota", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(youngest + 1,
+                                                           iterpool),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, iterpool));
+      SVN_TEST_ASSERT(new_rev == youngest + 1);
+      youngest = new_rev;
+    }
+
+  /* A fresh instance must see all commits. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&i, fs, pool));
+  SVN_TEST_ASSERT(i == MAX_REV);
+
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_test__get_file_contents(rev_root, "iota", &contents,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+
+#define REPO_NAME "test-repo-group_commit_concurrent"
+#define COMMITTERS 4
+#define COMMITS_PER_COMMITTER 8
+
+/* Implements svn_task__process_func_t.  Open a new instance of the
+   repository REPO_NAME and commit COMMITS_PER_COMMITTER revisions to the
+   file whose name is given by PROCESS_BATON. */
+static svn_error_t *
+commit_concurrently(void **result,
+                    void *process_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *name = process_baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_t *fs;
+  int i;
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, scratch_pool, scratch_pool));
+  for (i = 1; i <= COMMITS_PER_COMMITTER; i++)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+      svn_revnum_t youngest;
+      svn_revnum_t new_rev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_youngest_rev(&youngest, fs, iterpool));
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 1)
+        SVN_ERR(svn_fs_make_file(root, name, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, name,
+                                          get_rev_contents(i, iterpool),
+                                          iterpool));
+
+      /* Each committer modifies its own file only, so the commit merges
+         cleanly with all revisions committed since YOUNGEST. */
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(new_rev));
+    }
+
+  svn_pool_destroy(iterpool);
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+group_commit_concurrent(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  const char *group_commit_config = "\n[io]\ngroup-commit = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  svn_task__set_t *set;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (svn_task__get_thread_limit() == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "concurrent commits need worker threads");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Enable group commits. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, group_commit_config,
+                                 strlen(group_commit_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Let several committers share the group commit state. */
+  SVN_ERR(svn_task__set_create(&set, COMMITTERS, NULL, NULL, NULL, NULL,
+                               pool));
+  for (i = 0; i < COMMITTERS; i++)
+    SVN_ERR(svn_task__add(set, commit_concurrently,
+                          apr_psprintf(pool, "file-%d", i)));
+  SVN_ERR(svn_task__set_finish(set));
+
+  /* A fresh instance must see all commits, and all of them must have
+     been flushed before their committers returned. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs->fsap_data)->group_commit);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_INT_ASSERT(youngest, COMMITTERS * COMMITS_PER_COMMITTER);
+  SVN_TEST_INT_ASSERT(
+    ((fs_fs_data_t *)fs->fsap_data)->shared->group_commit_synced, youngest);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest, pool));
+  for (i = 0; i < COMMITTERS; i++)
+    {
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(svn_test__get_file_contents(root,
+                                          apr_psprintf(pool, "file-%d", i),
+                                          &contents, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             get_rev_contents(COMMITS_PER_COMMITTER, pool));
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, youngest, NULL, NULL, NULL,
+                        NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef COMMITTERS
+#undef COMMITS_PER_COMMITTER
+
+#define REPO_NAME "test-repo-rep_cache_filter"
+static svn_error_t *
+rep_cache_filter(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_checksum_t *checksum;
+  representation_t *rep;
+  fs_fs_data_t *ffd;
+  const char *old_contents = "some old content\n";
+  const char *new_contents = "some new content\n";
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support rep-sharing");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", old_contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* A fresh instance has to build the filter from the database. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->rep_sharing_allowed);
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, old_contents,
+                       strlen(old_contents), pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 1);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, new_contents,
+                       strlen(new_contents), pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  /* Entries added through any instance must be found afterwards. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "bar", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "bar", new_contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 2);
+
+  /* Removing entries must not leave stale data in the filter.  Re-adding
+     them may reuse the same ROWIDs. */
+  SVN_ERR(svn_fs_fs__del_rep_reference(fs, 1, pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, old_contents,
+                       strlen(old_contents), pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 1);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-batched_rep_cache_updates"
+static svn_error_t *
+batched_rep_cache_updates(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs, *reader;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *fs_pool = svn_pool_create(pool);
+  svn_revnum_t rev = 0;
+  representation_t *rep;
+  apr_array_header_t *reps;
+  svn_checksum_t *checksum;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support rep-sharing");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_REP_CACHE_BATCH_REVS, "3");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, fs_pool, fs_pool));
+  SVN_ERR(svn_fs_open2(&reader, REPO_NAME, NULL, pool, pool));
+
+  /* Commit 4 revisions with new contents each. */
+  for (i = 1; i <= 4; ++i)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+      const char *path = apr_psprintf(pool, "file-%d", i);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_fs_make_file(root, path, pool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          get_rev_contents(i, pool),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+      /* Recent entries are visible to the committing instance, only. */
+      SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1,
+                           get_rev_contents(i, pool),
+                           strlen(get_rev_contents(i, pool)), pool));
+      SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+      SVN_TEST_ASSERT(rep && rep->revision == i);
+
+      SVN_ERR(svn_fs_fs__get_rep_reference(&rep, reader, checksum, pool));
+      SVN_TEST_ASSERT(i == 3 ? rep != NULL : rep == NULL);
+    }
+
+  /* Closing the FS writes the remaining entries. */
+  svn_pool_destroy(fs_pool);
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, reader, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 4);
+
+  /* Storing existing entries again is fine, both row by row and in full
+     batches. */
+  reps = apr_array_make(pool, 8, sizeof(representation_t *));
+  APR_ARRAY_PUSH(reps, representation_t *) = rep;
+  SVN_ERR(svn_fs_fs__set_rep_references(reader, reps, pool));
+  for (i = 1; i < 8; ++i)
+    APR_ARRAY_PUSH(reps, representation_t *) = rep;
+  SVN_ERR(svn_fs_fs__set_rep_references(reader, reps, pool));
+
+  /* Different values for an existing key indicate corruption. */
+  rep = svn_fs_fs__rep_copy(rep, pool);
+  rep->item_index++;
+  APR_ARRAY_IDX(reps, 7, representation_t *) = rep;
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__set_rep_references(reader, reps, pool),
+                        SVN_ERR_FS_CORRUPT);
+
+  apr_array_clear(reps);
+  APR_ARRAY_PUSH(reps, representation_t *) = rep;
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__set_rep_references(reader, reps, pool),
+                        SVN_ERR_FS_CORRUPT);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* Implements svn_fs_get_locks_callback_t.  Count the locks in the
+   int * BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  int *count = baton;
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *COUNT to the number of locks in FS at PATH to DEPTH. */
+static svn_error_t *
+get_lock_count(int *count,
+               svn_fs_t *fs,
+               const char *path,
+               svn_depth_t depth,
+               apr_pool_t *pool)
+{
+  *count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, path, depth, count_locks, count, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-lock_database"
+static svn_error_t *
+lock_database(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  static const char *const new_paths[] = { "/A/B/lambda", "/A/D/gamma",
+                                           "/A/D/G/pi" };
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_access_t *access;
+  svn_lock_t *mu_lock, *iota_lock, *lock;
+  svn_revnum_t rev;
+  apr_hash_t *targets;
+  svn_node_kind_t kind;
+  svn_test_opts_t temp_opts;
+  int count, i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support lock databases");
+
+  /* Start with a format that still uses the lock digest tree. */
+  temp_opts = *opts;
+  temp_opts.server_minor_version = 9;
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, &temp_opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Create some locks in the digest tree. */
+  SVN_ERR(svn_fs_create_access(&access, "user", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_lock(&mu_lock, fs, "/A/mu", NULL, "comment", FALSE, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+  SVN_ERR(svn_fs_lock(&iota_lock, fs, "/iota", NULL, NULL, FALSE,
+                      apr_time_now() + apr_time_from_sec(3600),
+                      SVN_INVALID_REVNUM, FALSE, pool));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCKS_DB, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The upgrade moves all locks into the database. */
+  SVN_ERR(svn_fs_upgrade2(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCKS_DB, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCKS_DIR, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  targets = apr_hash_make(pool);
+  for (i = 0; i < sizeof(new_paths) / sizeof(new_paths[0]); ++i)
+    svn_hash_sets(targets, new_paths[i],
+                  svn_fs_lock_target_create(NULL, rev, pool));
+  SVN_ERR(svn_fs_lock_many(fs, targets, NULL, FALSE, 0, FALSE,
+                           NULL, NULL, pool, pool));
+
+  /* The old locks have been carried over. */
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/mu", pool));
+  SVN_TEST_ASSERT(lock);
+  SVN_TEST_STRING_ASSERT(lock->token, mu_lock->token);
+  SVN_TEST_STRING_ASSERT(lock->comment, "comment");
+  SVN_TEST_ASSERT(lock->expiration_date == 0);
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/iota", pool));
+  SVN_TEST_ASSERT(lock);
+  SVN_TEST_STRING_ASSERT(lock->token, iota_lock->token);
+  SVN_TEST_ASSERT(lock->comment == NULL);
+  SVN_TEST_ASSERT(lock->expiration_date == iota_lock->expiration_date);
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/B/E/beta", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  /* Range queries. */
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 5);
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_files, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D", svn_depth_immediates, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D/gamma", svn_depth_empty, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(get_lock_count(&count, fs, "/A/B/E", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 0);
+
+  /* Paths sharing a name prefix are not descendants. */
+  SVN_ERR(get_lock_count(&count, fs, "/A/D/G/p", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 0);
+
+  /* Locks are being enforced. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, rev, SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_delete(root, "/A/D", pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* Remove several locks at once. */
+  targets = apr_hash_make(pool);
+  svn_hash_sets(targets, "/A/mu", mu_lock->token);
+  svn_hash_sets(targets, "/A/D/G/pi", "");
+  SVN_ERR(svn_fs_unlock_many(fs, targets, TRUE, NULL, NULL, pool, pool));
+
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 3);
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/mu", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* Baton for check_revprops_receiver(). */
+typedef struct revprops_receiver_baton_t
+{
+  /* The revision we expect to be reported next. */
+  svn_revnum_t next_rev;
+
+  /* Either 1 or -1. */
+  int step;
+} revprops_receiver_baton_t;
+
+/* Implements svn_fs_revision_proplist_receiver_t.  Verify that REVISION
+ * is the one expected by BATON, a revprops_receiver_baton_t, and that it
+ * has the log message set by revprop_ranges(). */
+static svn_error_t *
+check_revprops_receiver(void *baton,
+                        svn_revnum_t revision,
+                        apr_hash_t *proplist,
+                        apr_pool_t *scratch_pool)
+{
+  revprops_receiver_baton_t *b = baton;
+  svn_string_t *log = svn_hash_gets(proplist, SVN_PROP_REVISION_LOG);
+  svn_string_t *expected = revision == 5 ? huge_log(5, scratch_pool)
+                                         : default_log(revision,
+                                                       scratch_pool);
+
+  SVN_TEST_ASSERT(revision == b->next_rev);
+  SVN_TEST_ASSERT(log);
+  SVN_TEST_STRING_ASSERT(log->data, expected->data);
+  b->next_rev += b->step;
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that svn_fs_revision_proplist_range() in FS reports all revisions
+ * from START to END correctly, with or without REFRESH. */
+static svn_error_t *
+check_revprop_range(svn_fs_t *fs,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    svn_boolean_t refresh,
+                    apr_pool_t *pool)
+{
+  revprops_receiver_baton_t baton;
+
+  baton.next_rev = start;
+  baton.step = start <= end ? 1 : -1;
+  SVN_ERR(svn_fs_revision_proplist_range(fs, start, end, refresh,
+                                         check_revprops_receiver, &baton,
+                                         pool));
+  SVN_TEST_ASSERT(baton.next_rev == end + baton.step);
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-revprop_ranges"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+revprop_ranges(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+
+  /* Packed revprops in several pack files plus a non-packed shard. */
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  for (rev = 0; rev <= MAX_REV + 1; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop(fs, rev, SVN_PROP_REVISION_LOG,
+                                   default_log(rev, pool),
+                                   pool));
+  SVN_ERR(svn_fs_change_rev_prop(fs, 5, SVN_PROP_REVISION_LOG,
+                                 huge_log(5, pool),
+                                 pool));
+
+  /* Full and partial ranges in both directions, through a fresh
+   * instance and through one with populated caches. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(check_revprop_range(fs, 0, MAX_REV + 1, FALSE, pool));
+  SVN_ERR(check_revprop_range(fs, MAX_REV + 1, 0, FALSE, pool));
+  SVN_ERR(check_revprop_range(fs, 6, 2, TRUE, pool));
+  SVN_ERR(check_revprop_range(fs, 3, 9, FALSE, pool));
+  SVN_ERR(check_revprop_range(fs, 7, 7, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-subtree-changed"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+/* Assert that svn_fs_subtree_changed() reports EXPECTED for PATH in FS
+   for the revisions from START to END.  Use POOL for allocations. */
+static svn_error_t *
+check_subtree_changed(svn_fs_t *fs,
+                      const char *path,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      svn_boolean_t expected,
+                      apr_pool_t *pool)
+{
+  svn_boolean_t changed;
+
+  SVN_ERR(svn_fs_subtree_changed(&changed, fs, path, start, end, pool));
+  if (changed != expected)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Expected '%s' to be%s changed in r%ld:%ld",
+                             path, expected ? "" : " not", start, end);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+subtree_changed(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const char *conflict;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  const char *index_path;
+
+  /* r1 adds the Greek tree, r2 to r10 only modify 'iota'.  The first two
+     shards will be packed. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  index_path = svn_dirent_join_many(pool, REPO_NAME, "revs", "0.pack",
+                                    "changes", SVN_VA_NULL);
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* r11 modifies a file deep inside the tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, MAX_REV, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "new pi\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == MAX_REV + 1);
+
+  /* Packed and non-packed ranges, in both directions. */
+  SVN_ERR(check_subtree_changed(fs, "/A", 1, 3, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A", 2, MAX_REV, FALSE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A", MAX_REV, 2, FALSE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A", 2, rev, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "A/B", 2, rev, FALSE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A/D/G/pi", rev, 2, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/iota", 5, 6, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/", 2, 3, TRUE, pool));
+
+  /* Changes to a parent affect the whole sub-tree. */
+  SVN_ERR(check_subtree_changed(fs, "/A/B/E/alpha", 1, 1, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A/B/E/alpha", 2, rev, FALSE, pool));
+
+  /* Paths need not exist. */
+  SVN_ERR(check_subtree_changed(fs, "/no/such/path", 2, rev, FALSE, pool));
+
+  /* Without its index, a shard must be assumed to contain changes. */
+  index_path = svn_dirent_join_many(pool, REPO_NAME, "revs", "1.pack",
+                                    "changes", SVN_VA_NULL);
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A", 4, 7, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "/A", 2, 3, FALSE, pool));
+
+  /* More than a shard's worth of unpacked revisions won't be scanned. */
+  while (rev < MAX_REV + 1 + SHARD_SIZE)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          get_rev_contents(rev + 1, pool),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+    }
+
+  SVN_ERR(check_subtree_changed(fs, "A/B", 8, rev, TRUE, pool));
+  SVN_ERR(check_subtree_changed(fs, "A/B", rev - SHARD_SIZE + 1, rev, FALSE,
+                                pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-closest-copy-cache"
+
+/* Check that svn_fs_closest_copy() for PATH in REV of FS returns
+   EXPECTED_PATH in EXPECTED_REV or no copy, if EXPECTED_PATH is NULL.
+   Use POOL for allocations. */
+static svn_error_t *
+check_closest_copy(svn_fs_t *fs,
+                   svn_revnum_t rev,
+                   const char *path,
+                   svn_revnum_t expected_rev,
+                   const char *expected_path,
+                   apr_pool_t *pool)
+{
+  svn_fs_root_t *root, *copy_root;
+  const char *copy_path;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_closest_copy(&copy_root, &copy_path, root, path, pool));
+  if (expected_path)
+    {
+      SVN_TEST_ASSERT(copy_root);
+      SVN_TEST_ASSERT(svn_fs_revision_root_revision(copy_root)
+                      == expected_rev);
+      SVN_TEST_STRING_ASSERT(copy_path, expected_path);
+    }
+  else
+    {
+      SVN_TEST_ASSERT(copy_root == NULL);
+      SVN_TEST_ASSERT(copy_path == NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+closest_copy_caching(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  const char *conflict;
+  svn_revnum_t rev;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: the Greek tree, r2: copy A to B, r3: modify B/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "B", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "B/mu", "new mu\n", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+
+  /* Repeated queries must give the same results, whether they get
+     served from the cache or not. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(check_closest_copy(fs, 3, "/B/mu", 2, "/B", pool));
+      SVN_ERR(check_closest_copy(fs, 3, "B", 2, "/B", pool));
+      SVN_ERR(check_closest_copy(fs, 3, "/A/mu", 0, NULL, pool));
+      SVN_ERR(check_closest_copy(fs, 1, "/A/mu", 0, NULL, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-optimistic_commit"
+static svn_error_t *
+optimistic_commit(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *optimistic_config = "\n[io]\noptimistic-commit = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn, *txn2;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  const char *conflict;
+  svn_stringbuf_t *contents;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Enable optimistic commits. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, optimistic_config,
+                                 strlen(optimistic_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs->fsap_data)->optimistic_commit);
+
+  /* r1: Greek tree plus some properties. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/B", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* Two txns based on r1.  The second one will only be committed after
+     the first one, i.e. it needs to be merged and prepared again. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "iota", "new iota\n", pool));
+  SVN_ERR(svn_fs_copy(root, "A/D", root, "A/D2", pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn2, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn2, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/mu", "new mu\n", pool));
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn2, pool));
+  SVN_TEST_ASSERT(rev == 3);
+
+  /* Everything has arrived. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 3, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new iota\n");
+  SVN_ERR(svn_test__get_file_contents(root, "A/mu", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new mu\n");
+  SVN_ERR(svn_test__get_file_contents(root, "A/D2/gamma", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'gamma'.\n");
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* Set *SIZE to the size of the file at PATH or to -1 if it does not
+   exist.  Use POOL for temporary allocations. */
+static svn_error_t *
+get_file_size(apr_off_t *size,
+              const char *path,
+              apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err = svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool);
+
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *size = -1;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(err);
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set SIZES to the sizes of the proto-rev file and of the two proto-index
+   files of TXN in FS, as returned by get_file_size().  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+get_proto_file_sizes(apr_off_t sizes[3],
+                     svn_fs_t *fs,
+                     svn_fs_txn_t *txn,
+                     apr_pool_t *pool)
+{
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(txn);
+
+  SVN_ERR(get_file_size(&sizes[0],
+                        svn_fs_fs__path_txn_proto_rev(fs, txn_id, pool),
+                        pool));
+  SVN_ERR(get_file_size(&sizes[1],
+                        svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool),
+                        pool));
+  SVN_ERR(get_file_size(&sizes[2],
+                        svn_fs_fs__path_p2l_proto_index(fs, txn_id, pool),
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-optimistic_commit_rollback"
+static svn_error_t *
+optimistic_commit_rollback(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  const char *optimistic_config = "\n[io]\noptimistic-commit = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_access_t *access;
+  svn_lock_t *lock;
+  svn_revnum_t rev;
+  const char *conflict;
+  svn_stringbuf_t *contents;
+  apr_off_t sizes_before[3], sizes_after[3];
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Enable optimistic commits. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, optimistic_config,
+                                 strlen(optimistic_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  if (((fs_fs_data_t *)fs->fsap_data)->format
+        < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "old formats don't prepare commits early");
+
+  /* r1: Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* Someone else locks iota. */
+  SVN_ERR(svn_fs_create_access(&access, "someone-else", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, "", FALSE, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+
+  /* We modify it anyway.  Without SVN_FS_TXN_CHECK_LOCKS, the lock
+     will only be noticed by the commit, i.e. after the final revision
+     has already been prepared. */
+  SVN_ERR(svn_fs_create_access(&access, "jrandom", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "iota", "new iota\n", pool));
+  SVN_ERR(svn_fs_make_file(root, "A/new", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/new", "new file\n", pool));
+
+  SVN_ERR(get_proto_file_sizes(sizes_before, fs, txn, pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(&conflict, &rev, txn, pool),
+                        SVN_ERR_FS_LOCK_OWNER_MISMATCH);
+
+  /* The failed commit must have left the txn as it was. */
+  SVN_ERR(get_proto_file_sizes(sizes_after, fs, txn, pool));
+  SVN_TEST_INT_ASSERT(sizes_after[0], sizes_before[0]);
+  SVN_TEST_INT_ASSERT(sizes_after[1], sizes_before[1]);
+  SVN_TEST_INT_ASSERT(sizes_after[2], sizes_before[2]);
+
+  /* Once the lock is gone, the same txn can be committed.  This fails if
+     the proto-rev file is still locked or contains leftovers from the
+     first attempt. */
+  SVN_ERR(svn_fs_unlock(fs, "/iota", NULL, TRUE, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  /* Check the result, also with fresh caches. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new iota\n");
+  SVN_ERR(svn_test__get_file_contents(root, "A/new", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new file\n");
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+/* Baton for stats_progress(). */
+struct stats_progress_baton
+{
+  /* The lowest revision that may be reported next. */
+  svn_revnum_t next_rev;
+
+  /* Set if revisions have been reported out of order. */
+  svn_boolean_t out_of_order;
+};
+
+/* Implements svn_fs_progress_notify_func_t.  Check that the revisions
+   get reported in ascending order. */
+static void
+stats_progress(svn_revnum_t revision,
+               void *baton,
+               apr_pool_t *pool)
+{
+  struct stats_progress_baton *spb = baton;
+
+  if (revision < spb->next_rev)
+    spb->out_of_order = TRUE;
+
+  spb->next_rev = revision + 1;
+}
+
+/* Return an error if the histograms LHS and RHS differ. */
+static svn_error_t *
+compare_histograms(const svn_fs_fs__histogram_t *lhs,
+                   const svn_fs_fs__histogram_t *rhs)
+{
+  SVN_TEST_ASSERT(memcmp(lhs, rhs, sizeof(*lhs)) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-parallel_stats"
+#define SHARD_SIZE 4
+#define MAX_REV 21
+static svn_error_t *
+parallel_stats(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs, *parallel_fs;
+  apr_hash_t *fs_config;
+  svn_fs_fs__stats_t *stats, *parallel_stats;
+  struct stats_progress_baton spb;
+  apr_size_t i;
+
+  /* Some packed and some non-packed revisions. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, NULL, NULL, NULL, NULL,
+                               pool, pool));
+
+  /* Use fewer jobs than there are rev / pack files such that task slots
+     get reused. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_STATS_JOBS, "2");
+  SVN_ERR(svn_fs_open2(&parallel_fs, REPO_NAME, fs_config, pool, pool));
+
+  spb.next_rev = 0;
+  spb.out_of_order = FALSE;
+  SVN_ERR(svn_fs_fs__get_stats(&parallel_stats, parallel_fs,
+                               stats_progress, &spb, NULL, NULL,
+                               pool, pool));
+  SVN_TEST_ASSERT(!spb.out_of_order);
+
+  /* The results must not depend on the number of jobs. */
+  SVN_TEST_ASSERT(stats->revision_count == MAX_REV + 1);
+  SVN_TEST_ASSERT(parallel_stats->revision_count == stats->revision_count);
+  SVN_TEST_ASSERT(parallel_stats->change_count == stats->change_count);
+  SVN_TEST_ASSERT(parallel_stats->change_len == stats->change_len);
+  SVN_TEST_ASSERT(parallel_stats->total_size == stats->total_size);
+
+  SVN_TEST_ASSERT(memcmp(&parallel_stats->total_rep_stats,
+                         &stats->total_rep_stats,
+                         sizeof(stats->total_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&parallel_stats->file_rep_stats,
+                         &stats->file_rep_stats,
+                         sizeof(stats->file_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&parallel_stats->dir_rep_stats,
+                         &stats->dir_rep_stats,
+                         sizeof(stats->dir_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&parallel_stats->total_node_stats,
+                         &stats->total_node_stats,
+                         sizeof(stats->total_node_stats)) == 0);
+
+  SVN_ERR(compare_histograms(&parallel_stats->rep_size_histogram,
+                             &stats->rep_size_histogram));
+  SVN_ERR(compare_histograms(&parallel_stats->node_size_histogram,
+                             &stats->node_size_histogram));
+  SVN_ERR(compare_histograms(&parallel_stats->added_rep_size_histogram,
+                             &stats->added_rep_size_histogram));
+  SVN_ERR(compare_histograms(&parallel_stats->file_histogram,
+                             &stats->file_histogram));
+  SVN_ERR(compare_histograms(&parallel_stats->dir_histogram,
+                             &stats->dir_histogram));
+
+  SVN_TEST_ASSERT(parallel_stats->largest_changes->min_size
+                  == stats->largest_changes->min_size);
+  for (i = 0; i < stats->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *lhs
+        = parallel_stats->largest_changes->changes[i];
+      svn_fs_fs__large_change_info_t *rhs
+        = stats->largest_changes->changes[i];
+
+      SVN_TEST_ASSERT(lhs->size == rhs->size);
+      SVN_TEST_ASSERT(lhs->revision == rhs->revision);
+      SVN_TEST_STRING_ASSERT(lhs->path->data, rhs->path->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+/* Set *OFFSET to the location of the noderev for PATH in ROOT within the
+   rev / pack file of FS.  Use POOL for allocations. */
+static svn_error_t *
+get_noderev_offset(apr_off_t *offset,
+                   svn_fs_t *fs,
+                   svn_fs_root_t *root,
+                   const char *path,
+                   apr_pool_t *pool)
+{
+  const svn_fs_id_t *id;
+  const svn_fs_fs__id_part_t *rev_item;
+  svn_fs_fs__revision_file_t *rev_file;
+
+  SVN_ERR(svn_fs_node_id(&id, root, path, pool));
+  rev_item = svn_fs_fs__id_rev_item(id);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev_item->revision,
+                                           pool, pool));
+  SVN_ERR(svn_fs_fs__item_offset(offset, fs, rev_file, rev_item->revision,
+                                 NULL, rev_item->number, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-pack_access_hints"
+#define SHARD_SIZE 4
+#define MAX_REV 5
+static svn_error_t *
+pack_access_hints(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *pack_config = "\n[pack]\naccess-hints = pack-hints.txt\n";
+  const char *hints = "# hot paths\n"
+                      "3 /A/D/G\n"
+                      "\n"
+                      "/A/C\n"
+                      "10\t/A/D/H/\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  apr_off_t lambda_offset, omega_offset, rho_offset;
+  svn_revnum_t youngest;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Tell pack that H is the hottest directory, followed by G. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, pack_config, strlen(pack_config),
+                                 NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, "pack-hints.txt",
+                                             pool),
+                             hints, pool));
+
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+
+  /* Without hints, the nodes would be in path order.  Now, the nodes
+     below the hot paths come first, hottest first. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(get_noderev_offset(&lambda_offset, fs, root, "A/B/lambda", pool));
+  SVN_ERR(get_noderev_offset(&omega_offset, fs, root, "A/D/H/omega", pool));
+  SVN_ERR(get_noderev_offset(&rho_offset, fs, root, "A/D/G/rho", pool));
+
+  SVN_TEST_ASSERT(omega_offset < rho_offset);
+  SVN_TEST_ASSERT(rho_offset < lambda_offset);
+
+  /* Malformed hints make pack fail. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, "pack-hints.txt",
+                                             pool),
+                             "10 A/D/H\n", pool));
+  for (youngest = MAX_REV; youngest < 2 * SHARD_SIZE; )
+    {
+      svn_fs_txn_t *txn;
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(youngest + 1,
+                                                           pool),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest, txn, pool));
+    }
+
+  SVN_TEST_ASSERT_ERROR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL,
+                                     NULL, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-prefetch_dir_entries"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+prefetch_dir_entries(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  const char *io_config = "\n[io]\nprefetch-dir-entries = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_revnum_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, io_config, strlen(io_config),
+                                 NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Walk the tree in packed and non-packed revisions.  The read-ahead
+     must neither fail nor change what we read. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      apr_hash_t *entries;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      const char *expected;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+
+      SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "", iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(entries) == 2);
+      SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "A/D", iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(entries) == 3);
+      SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "A/D/G", iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(entries) == 3);
+
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      expected = i == 1 ? "This is the file 'iota'.\n"
+                        : get_rev_contents(i, iterpool);
+      SVN_TEST_STRING_ASSERT(rstring->data, expected);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-pooled_pack_file_handles"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+pooled_pack_file_handles(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  svn_fs_fs__revision_file_t *rev_file, *rev_file2;
+  apr_file_t *file;
+  svn_revnum_t i;
+  apr_pool_t *subpool;
+
+  /* Pack file handles are not being pooled on Windows. */
+#ifdef WIN32
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+#endif
+  if (svn_cache_config_get()->file_handle_count == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  subpool = svn_pool_create(pool);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  /* Closed pack files get re-used, even across FS instances. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  file = rev_file->file;
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs2, 2, pool, pool));
+  SVN_TEST_ASSERT(rev_file->file == file);
+
+  /* Files in use are not being shared. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file2, fs, 3, subpool,
+                                           pool));
+  SVN_TEST_ASSERT(rev_file2->file != rev_file->file);
+
+  /* Handles released by pool cleanup are just as good. */
+  file = rev_file2->file;
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file2, fs, 3, subpool,
+                                           pool));
+  SVN_TEST_ASSERT(rev_file2->file == file);
+
+  /* Re-used handles must behave like freshly opened ones. */
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file2));
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, i % 2 ? fs : fs2, i, subpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", subpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, subpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, subpool));
+    }
+
+  /* Non-packed revisions don't use the pool. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV, pool,
+                                           pool));
+  SVN_TEST_ASSERT(rev_file->pooled_handle == NULL);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-watch_current"
+#define SHARD_SIZE 4
+#define MAX_REV 5
+static svn_error_t *
+watch_current(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  const char *io_config = "\n[io]\nwatch-current = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs, *fs2;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest, new_rev;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, io_config, strlen(io_config),
+                                 NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == MAX_REV);
+
+  /* Repeated lookups without modification. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == MAX_REV);
+
+  /* Commits through other instances must become visible immediately. */
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  for (new_rev = MAX_REV; new_rev < MAX_REV + 3; )
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs2, new_rev, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(new_rev + 1,
+                                                           pool),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, pool));
+
+      SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+      SVN_TEST_ASSERT(youngest == new_rev);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-reserved_txn_numbers"
+#define SHARD_SIZE 4
+#define MAX_REV 1
+static svn_error_t *
+reserved_txn_numbers(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  svn_fs_txn_t *txn;
+  svn_stringbuf_t *before, *after;
+  apr_hash_t *names = apr_hash_make(pool);
+  const char *path;
+  int i;
+  int updates = 0;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  if (((fs_fs_data_t *)fs->fsap_data)->format
+        < SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  /* 32 txns from multiple FS instances require only two updates of
+     txn-current, no matter how many reserved numbers were left. */
+  path = svn_dirent_join_many(pool, REPO_NAME, "db", PATH_TXN_CURRENT,
+                              SVN_VA_NULL);
+  SVN_ERR(svn_stringbuf_from_file2(&before, path, pool));
+  for (i = 0; i < 32; ++i)
+    {
+      const char *name;
+      SVN_ERR(svn_fs_begin_txn(&txn, i % 2 ? fs : fs2, MAX_REV, pool));
+      SVN_ERR(svn_fs_txn_name(&name, txn, pool));
+      SVN_TEST_ASSERT(svn_hash_gets(names, name) == NULL);
+      svn_hash_sets(names, name, name);
+
+      SVN_ERR(svn_stringbuf_from_file2(&after, path, pool));
+      if (!svn_stringbuf_compare(before, after))
+        ++updates;
+      before = after;
+    }
+
+  SVN_TEST_INT_ASSERT(updates, 2);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+
+/* ------------------------------------------------------------------------ */
+
+/* Implements svn_fs_mergeinfo_receiver_t, collecting the paths in the
+   apr_hash_t BATON. */
+static svn_error_t *
+collect_mergeinfo_paths(const char *path,
+                        svn_mergeinfo_t mergeinfo,
+                        void *baton,
+                        apr_pool_t *scratch_pool)
+{
+  apr_hash_t *paths = baton;
+  const char *key = apr_pstrdup(apr_hash_pool_get(paths), path);
+
+  svn_hash_sets(paths, key, key);
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the descendants of PATH in REV of FS which have mergeinfo
+   are exactly those in the space separated list EXPECTED. */
+static svn_error_t *
+verify_descendant_mergeinfo(svn_fs_t *fs,
+                            svn_revnum_t rev,
+                            const char *path,
+                            const char *expected,
+                            apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_array_header_t *sorted;
+  apr_hash_t *found = apr_hash_make(pool);
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  int i;
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_get_mergeinfo3(root, paths, svn_mergeinfo_explicit, TRUE,
+                                FALSE, collect_mergeinfo_paths, found,
+                                pool));
+
+  /* PATH itself is not a descendant. */
+  svn_hash_sets(found, path, NULL);
+
+  sorted = svn_sort__hash(found, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      if (i)
+        svn_stringbuf_appendbyte(actual, ' ');
+      svn_stringbuf_appendcstr(actual,
+                               APR_ARRAY_IDX(sorted, i, svn_sort__item_t).key);
+    }
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-mergeinfo_index"
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  const char *index_config = "\n[mergeinfo]\nenable-mergeinfo-index = true\n";
+  svn_string_t *mergeinfo = svn_string_create("/trunk:1", pool);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  svn_node_kind_t kind;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  if (! svn_fs_fs__fs_supports_mergeinfo(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this FSFS format does not track mergeinfo");
+
+  /* r1: Greek tree with mergeinfo on /A/B, before the index exists. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/A/B", SVN_PROP_MERGEINFO,
+                                  mergeinfo, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Enable the index.  The next commit will create it. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, index_config,
+                                 strlen(index_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r2: Add mergeinfo to /A/D/G and /iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/A/D/G", SVN_PROP_MERGEINFO,
+                                  mergeinfo, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/iota", SVN_PROP_MERGEINFO,
+                                  mergeinfo, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME,
+                                            PATH_MERGEINFO_INDEX_DB, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* r3: Copy /A, bringing along its subtree mergeinfo, and delete a
+         node with mergeinfo. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/A", root, "/A2", pool));
+  SVN_ERR(svn_fs_delete(root, "/A/D/G", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: Remove and modify mergeinfo, and replace a directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/A/B", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/iota", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/trunk:1-2", pool),
+                                  pool));
+  SVN_ERR(svn_fs_delete(root, "/A2/D", pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/A2/B", root, "/A2/D", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r1 predates the index and gets crawled. */
+  SVN_ERR(verify_descendant_mergeinfo(fs, 1, "/", "/A/B", pool));
+
+  /* All later revisions are covered by the index. */
+  SVN_ERR(verify_descendant_mergeinfo(fs, 2, "/",
+                                      "/A/B /A/D/G /iota", pool));
+  SVN_ERR(verify_descendant_mergeinfo(fs, 2, "/A/D", "/A/D/G", pool));
+  SVN_ERR(verify_descendant_mergeinfo(fs, 3, "/",
+                                      "/A/B /A2/B /A2/D/G /iota", pool));
+  SVN_ERR(verify_descendant_mergeinfo(fs, 4, "/",
+                                      "/A2/B /A2/D /iota", pool));
+  SVN_ERR(verify_descendant_mergeinfo(fs, 4, "/A2", "/A2/B /A2/D", pool));
+  SVN_ERR(verify_descendant_mergeinfo(fs, 4, "/A", "", pool));
+
+  /* Paths sharing a name prefix are not descendants. */
+  SVN_ERR(verify_descendant_mergeinfo(fs, 3, "/A", "/A/B", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop_overlay"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+revprop_overlay(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  const char *overlay_config
+    = "\n[packed-revprops]\nrevprop-overlay-size = 1\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  const char *overlay_path = svn_dirent_join_many(pool, REPO_NAME,
+                                                  PATH_REVPROPS_DIR,
+                                                  "1.pack",
+                                                  PATH_REVPROPS_OVERLAY,
+                                                  SVN_VA_NULL);
+
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, overlay_config,
+                                 strlen(overlay_config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Small changes get collected in the overlay. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (rev = 0; rev <= MAX_REV + 1; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop(fs, rev, SVN_PROP_REVISION_LOG,
+                                   default_log(rev, pool),
+                                   pool));
+
+  SVN_ERR(svn_io_check_path(overlay_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Large ones overflow it and trigger merging it into the packs. */
+  SVN_ERR(svn_fs_change_rev_prop(fs, 5, SVN_PROP_REVISION_LOG,
+                                 huge_log(5, pool),
+                                 pool));
+
+  SVN_ERR(svn_io_check_path(overlay_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(check_revprop_range(fs, 0, MAX_REV + 1, FALSE, pool));
+
+  /* Changes pending in an overlay must be visible to readers. */
+  SVN_ERR(svn_fs_change_rev_prop(fs, 6, SVN_PROP_REVISION_LOG,
+                                 svn_string_create("changed", pool),
+                                 pool));
+  SVN_ERR(svn_fs_change_rev_prop(fs, 6, SVN_PROP_REVISION_LOG,
+                                 default_log(6, pool),
+                                 pool));
+  SVN_ERR(svn_io_check_path(overlay_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(check_revprop_range(fs, MAX_REV + 1, 0, FALSE, pool));
+  SVN_ERR(check_revprop_range(fs, 3, 9, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+/* Set *REV, *NEXT_NODE_ID and *NEXT_COPY_ID to the contents of the
+   'current' file of the FSFS repository at REPO_PATH. */
+static svn_error_t *
+read_current_file(svn_revnum_t *rev,
+                  apr_uint64_t *next_node_id,
+                  apr_uint64_t *next_copy_id,
+                  const char *repo_path,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_open2(&fs, repo_path, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__read_current(rev, next_node_id, next_copy_id, fs,
+                                  pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the 'current' file of the FSFS repository at REPO_PATH with
+   one naming REV, NEXT_NODE_ID and NEXT_COPY_ID. */
+static svn_error_t *
+write_current_file(const char *repo_path,
+                   svn_revnum_t rev,
+                   apr_uint64_t next_node_id,
+                   apr_uint64_t next_copy_id,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_open2(&fs, repo_path, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__write_current(fs, rev, next_node_id, next_copy_id,
+                                   pool));
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-parallel_recover"
+#define MAX_REV 150
+static svn_error_t *
+parallel_recover(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_test_opts_t temp_opts;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *rev_root;
+  const char *conflict;
+  svn_revnum_t rev;
+  svn_revnum_t expected_rev, actual_rev;
+  apr_uint64_t expected_node_id, actual_node_id;
+  apr_uint64_t expected_copy_id, actual_copy_id;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Only formats with global ID counters need to scan for them. */
+  temp_opts = *opts;
+  temp_opts.server_minor_version = 4;
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, &temp_opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+
+  /* Let both ID counters grow over many revisions. */
+  iterpool = svn_pool_create(pool);
+  while (rev < MAX_REV)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      if (rev % 10 == 0)
+        {
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, iterpool));
+          SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root,
+                              apr_psprintf(iterpool, "D%ld", rev),
+                              iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_fs_make_file(txn_root,
+                                   apr_psprintf(iterpool, "A/B/f%ld", rev),
+                                   iterpool));
+        }
+      SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* The sequential scan gives us the reference values. */
+  SVN_ERR(write_current_file(REPO_NAME, 1, 1, 1, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
+  SVN_ERR(read_current_file(&expected_rev, &expected_node_id,
+                            &expected_copy_id, REPO_NAME, pool));
+  SVN_TEST_ASSERT(expected_rev == MAX_REV);
+
+  /* Scanning concurrently must find the same maxima. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_RECOVER_JOBS, "3");
+
+  SVN_ERR(write_current_file(REPO_NAME, 1, 1, 1, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, fs_config, NULL, NULL, pool));
+  SVN_ERR(read_current_file(&actual_rev, &actual_node_id, &actual_copy_id,
+                            REPO_NAME, pool));
+  SVN_TEST_ASSERT(actual_rev == expected_rev);
+  SVN_TEST_ASSERT(actual_node_id == expected_node_id);
+  SVN_TEST_ASSERT(actual_copy_id == expected_copy_id);
+
+  /* In quick mode, the counters in 'current' are being trusted for the
+     revisions up to the one it names. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_QUICK_RECOVER, "1");
+
+  SVN_ERR(write_current_file(REPO_NAME, MAX_REV - 5, expected_node_id,
+                             expected_copy_id, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, fs_config, NULL, NULL, pool));
+  SVN_ERR(read_current_file(&actual_rev, &actual_node_id, &actual_copy_id,
+                            REPO_NAME, pool));
+  SVN_TEST_ASSERT(actual_rev == expected_rev);
+  SVN_TEST_ASSERT(actual_node_id == expected_node_id);
+  SVN_TEST_ASSERT(actual_copy_id == expected_copy_id);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-quick_recover"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+quick_recover(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config;
+  svn_stringbuf_t *contents;
+  const char *rev_path;
+  svn_revnum_t rev;
+  apr_uint64_t next_node_id, next_copy_id;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_QUICK_RECOVER, "1");
+
+  /* A healthy repository passes the quick checks. */
+  SVN_ERR(write_current_file(REPO_NAME, MAX_REV - 2, 0, 0, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, fs_config, NULL, NULL, pool));
+  SVN_ERR(read_current_file(&rev, &next_node_id, &next_copy_id, REPO_NAME,
+                            pool));
+  SVN_TEST_ASSERT(rev == MAX_REV);
+
+  /* Cut the youngest revision file short, as a crash might do. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  rev_path = svn_fs_fs__path_rev_absolute(fs, MAX_REV, pool);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, rev_path, pool));
+  svn_stringbuf_chop(contents, contents->len / 2);
+  svn_stringbuf_appendcstr(contents, "garbage");
+  SVN_ERR(svn_io_remove_file2(rev_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(rev_path, contents->data, pool));
+
+  /* Quick recovery must reject it and leave 'current' alone. */
+  SVN_ERR(write_current_file(REPO_NAME, MAX_REV - 2, 0, 0, pool));
+  SVN_TEST_ASSERT_ANY_ERROR(svn_fs_recover2(REPO_NAME, fs_config,
+                                            NULL, NULL, pool));
+
+  SVN_ERR(read_current_file(&rev, &next_node_id, &next_copy_id, REPO_NAME,
+                            pool));
+  SVN_TEST_ASSERT(rev == MAX_REV - 2);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
 
 
 /* The test table.  */
@@ -1942,6 +4331,56 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(read_mmapped_fs,
+                       "read from memory-mapped rev / pack files"),
+    SVN_TEST_OPTS_PASS(batch_read_rev_file,
+                       "batch reads from rev / pack files"),
+    SVN_TEST_OPTS_PASS(packed_l2p_bulk_lookup,
+                       "bulk L2P lookups in packed shards"),
+    SVN_TEST_OPTS_PASS(parallel_pack,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(parallel_hotcopy,
+                       "hotcopy multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(group_commit,
+                       "commit with group commits enabled"),
+    SVN_TEST_OPTS_PASS(group_commit_concurrent,
+                       "concurrent commits with group commits enabled"),
+    SVN_TEST_OPTS_PASS(rep_cache_filter,
+                       "rep-cache lookups through the filter"),
+    SVN_TEST_OPTS_PASS(batched_rep_cache_updates,
+                       "rep-cache updates for multiple revisions"),
+    SVN_TEST_OPTS_PASS(lock_database,
+                       "locks in a lock database"),
+    SVN_TEST_OPTS_PASS(revprop_ranges,
+                       "read revprops for revision ranges"),
+    SVN_TEST_OPTS_PASS(subtree_changed,
+                       "changed-paths index of packed shards"),
+    SVN_TEST_OPTS_PASS(closest_copy_caching,
+                       "cache closest copy information"),
+    SVN_TEST_OPTS_PASS(optimistic_commit,
+                       "commit with optimistic commits enabled"),
+    SVN_TEST_OPTS_PASS(optimistic_commit_rollback,
+                       "roll back a failed optimistic commit"),
+    SVN_TEST_OPTS_PASS(parallel_stats,
+                       "gather repository statistics concurrently"),
+    SVN_TEST_OPTS_PASS(pack_access_hints,
+                       "place hot paths first when packing"),
+    SVN_TEST_OPTS_PASS(prefetch_dir_entries,
+                       "read-ahead for directory entries"),
+    SVN_TEST_OPTS_PASS(pooled_pack_file_handles,
+                       "re-use pack file handles"),
+    SVN_TEST_OPTS_PASS(watch_current,
+                       "track youngest rev via change notifications"),
+    SVN_TEST_OPTS_PASS(reserved_txn_numbers,
+                       "reserve txn numbers in batches"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "query descendant mergeinfo via the index"),
+    SVN_TEST_OPTS_PASS(revprop_overlay,
+                       "collect packed revprop changes in an overlay"),
+    SVN_TEST_OPTS_PASS(parallel_recover,
+                       "recover ID counters concurrently"),
+    SVN_TEST_OPTS_PASS(quick_recover,
+                       "quick verification during recovery"),
     SVN_TEST_NULL
   };
 
@@ -25,16 +25,25 @@
 
 #include "../svn_test.h"
 
+#include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
 
 #include "private/svn_string_private.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_fspath.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
+#include "../../libsvn_fs_fs/id.h"
 #include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/temp_serializer.h"
+#include "../../libsvn_fs_fs/warmup.h"
 
 #include "../svn_test_fs.h"
 
@@ -405,14 +414,14 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
 
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, alt_entries, pool));
-  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE,
-                                             NULL, NULL, NULL, NULL, NULL,
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE,
+                                             1, NULL, NULL, NULL, NULL, NULL,
                                              NULL, pool),
                         SVN_ERR_FS_INDEX_CORRUPTION);
 
   /* Restore the original index. */
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, entries, pool));
-  SVN_ERR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE, NULL, NULL,
+  SVN_ERR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE, 1, NULL, NULL,
                                NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
@@ -420,6 +429,307 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-io-stats-test"
+
+static svn_error_t *
+io_stats(const svn_test_opts_t *opts,
+         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+  svn_stringbuf_t *text;
+  svn_stringbuf_t *trace = svn_stringbuf_create_empty(pool);
+  svn_fs__io_stats_t *stats;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+
+  /* Open the repository again with cold caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, svn_fs_path(svn_repos_fs(repos), pool),
+                       fs_config, pool, pool));
+
+  /* Nothing gets counted until enabled. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs__get_io_stats(&stats, fs, FALSE, pool, pool));
+  SVN_TEST_ASSERT(stats->items_read == 0);
+  SVN_TEST_ASSERT(stats->bytes_read == 0);
+
+  SVN_ERR(svn_fs__set_io_stats(fs, TRUE,
+                               svn_stream_from_stringbuf(trace, pool),
+                               pool));
+
+  /* Reading a file must be accounted for. */
+  SVN_ERR(svn_fs_file_contents(&contents, root, "A/B/E/alpha", pool));
+  SVN_ERR(svn_stringbuf_from_stream(&text, contents, 0, pool));
+  SVN_TEST_STRING_ASSERT(text->data, "This is the file 'alpha'.\n");
+
+  SVN_ERR(svn_fs__get_io_stats(&stats, fs, TRUE, pool, pool));
+  SVN_TEST_ASSERT(stats->items_read > 0);
+  SVN_TEST_ASSERT(stats->bytes_read > 0);
+  SVN_TEST_ASSERT(stats->files_opened > 0);
+  SVN_TEST_ASSERT(stats->reps_reconstructed >= 1);
+  SVN_TEST_ASSERT(stats->delta_chain_length >= 1);
+  SVN_TEST_ASSERT(stats->max_delta_chain_length >= 1);
+  SVN_TEST_ASSERT(stats->cache_gets > 0);
+  SVN_TEST_ASSERT(stats->cache_hits <= stats->cache_gets);
+
+  /* The trace uses the strace syntax that fsfs-access-map expects. */
+  SVN_TEST_ASSERT(strstr(trace->data, "open(\"") != NULL);
+  SVN_TEST_ASSERT(strstr(trace->data, ", SEEK_SET) = ") != NULL);
+  SVN_TEST_ASSERT(strstr(trace->data, "read(") != NULL);
+
+  /* Counters restart after a reset. */
+  SVN_ERR(svn_fs__get_io_stats(&stats, fs, FALSE, pool, pool));
+  SVN_TEST_ASSERT(stats->items_read == 0);
+  SVN_TEST_ASSERT(stats->bytes_read == 0);
+  SVN_TEST_ASSERT(stats->reps_reconstructed == 0);
+
+  SVN_ERR(svn_fs__set_io_stats(fs, FALSE, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-build-rep-cache-test"
+
+static svn_error_t *
+build_rep_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  svn_checksum_t *checksum;
+  representation_t *rep;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support rep-sharing");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1,
+                       "This is the file 'iota'.\n",
+                       strlen("This is the file 'iota'.\n"), pool));
+
+  /* Drop all entries, as if the rep-cache had been lost. */
+  SVN_ERR(svn_fs_fs__del_rep_reference(fs, 0, pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  /* Rebuilding the cache brings them back. */
+  SVN_ERR(svn_fs_fs__build_rep_cache(fs, 0, rev, NULL, NULL, NULL, NULL,
+                                     pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep != NULL);
+  SVN_TEST_ASSERT(rep->revision == rev);
+
+  /* Doing it again is harmless. */
+  SVN_ERR(svn_fs_fs__build_rep_cache(fs, rev, rev, NULL, NULL, NULL, NULL,
+                                     pool));
+
+  /* Revisions beyond HEAD are rejected. */
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__build_rep_cache(fs, 0, rev + 1, NULL,
+                                                   NULL, NULL, NULL, pool),
+                        SVN_ERR_FS_NO_SUCH_REVISION);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+extract_property(apr_pool_t *pool)
+{
+  apr_hash_t *props = apr_hash_make(pool);
+  apr_hash_t *copy;
+  void *data;
+  apr_size_t data_len;
+  void *value;
+
+  svn_hash_sets(props, "a", svn_string_create("1", pool));
+  svn_hash_sets(props, "ab", svn_string_create("", pool));
+  svn_hash_sets(props, SVN_PROP_MERGEINFO,
+                svn_string_create("/trunk:1-5\n", pool));
+
+  SVN_ERR(svn_fs_fs__serialize_properties(&data, &data_len, props, pool));
+
+  /* Look up individual entries without deserializing the whole hash. */
+  SVN_ERR(svn_fs_fs__extract_property(&value, data, data_len,
+                                      (void *)"a", pool));
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)value)->data, "1");
+  SVN_ERR(svn_fs_fs__extract_property(&value, data, data_len,
+                                      (void *)"ab", pool));
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)value)->data, "");
+  SVN_ERR(svn_fs_fs__extract_property(&value, data, data_len,
+                                      (void *)SVN_PROP_MERGEINFO, pool));
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)value)->data, "/trunk:1-5\n");
+  SVN_ERR(svn_fs_fs__extract_property(&value, data, data_len,
+                                      (void *)"b", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* The full deserialization must still produce the original hash. */
+  SVN_ERR(svn_fs_fs__deserialize_properties((void **)&copy, data, data_len,
+                                            pool));
+  SVN_TEST_ASSERT(apr_hash_count(copy) == 3);
+  SVN_TEST_STRING_ASSERT(svn_prop_get_value(copy, "a"), "1");
+  SVN_TEST_STRING_ASSERT(svn_prop_get_value(copy, "ab"), "");
+  SVN_TEST_STRING_ASSERT(svn_prop_get_value(copy, SVN_PROP_MERGEINFO),
+                         "/trunk:1-5\n");
+
+  return SVN_NO_ERROR;
+}
+
+
+#define REPO_NAME "test-repo-cache-warmup"
+
+/* Read the node revisions of all nodes below the directory PATH in ROOT. */
+static svn_error_t *
+read_tree(svn_fs_root_t *root,
+          const char *path,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, pool));
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      const char *child_path = svn_fspath__join(path, dirent->name, pool);
+      svn_filesize_t length;
+
+      svn_pool_clear(iterpool);
+      if (dirent->kind == svn_node_dir)
+        SVN_ERR(read_tree(root, child_path, iterpool));
+      else
+        SVN_ERR(svn_fs_file_length(&length, root, child_path, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+cache_warmup(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  const char *copy_name = REPO_NAME "-copy";
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_fs_t *fs;
+  svn_fs_t *copy_fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  const svn_fs_id_t *root_id;
+  const svn_fs_fs__id_part_t *rev_item;
+  svn_stringbuf_t *contents;
+  const char *warmup_path;
+  const char *root_line;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (svn_task__get_thread_limit() == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "the cache warm-up needs worker threads");
+
+  /* The warm-up starts when a repository gets opened. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  /* Commit, let the warm-up preload the new revision and read it. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_fs__warmup_wait(fs));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(read_tree(root, "/", pool));
+  SVN_ERR(svn_fs_node_id(&root_id, root, "/", pool));
+  rev_item = svn_fs_fs__id_rev_item(root_id);
+
+  /* The nodes read are listed in the warm-up file. */
+  SVN_ERR(svn_fs_fs__warmup_save(fs, pool));
+  warmup_path = svn_dirent_join(REPO_NAME, PATH_CACHE_WARMUP, pool);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, warmup_path, pool));
+  SVN_TEST_ASSERT(!strncmp(contents->data, "fsfs-cache-warmup 1\n",
+                           strlen("fsfs-cache-warmup 1\n")));
+  root_line = apr_psprintf(pool, "\nd %ld %" APR_UINT64_T_FMT "\n",
+                           rev_item->revision, rev_item->number);
+  SVN_TEST_ASSERT(strstr(contents->data, root_line));
+
+  /* Copy the repository with a new UUID, so it gets its own warm-up and
+     caches, and add entries that can't be preloaded. */
+  SVN_ERR(svn_io_remove_dir2(copy_name, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_copy_dir_recursively(REPO_NAME, "", copy_name, FALSE,
+                                      NULL, NULL, pool));
+  svn_test_add_dir_cleanup(copy_name);
+  SVN_ERR(svn_fs_open2(&copy_fs, copy_name, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_uuid(copy_fs, NULL, pool));
+
+  svn_stringbuf_appendcstr(contents, "garbage\nd 999 1\nf 1 999999\n");
+  SVN_ERR(svn_io_write_atomic2(svn_dirent_join(copy_name, PATH_CACHE_WARMUP,
+                                               pool),
+                               contents->data, contents->len, NULL, FALSE,
+                               pool));
+
+  /* Opening the copy preloads the listed nodes into its caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_WARMUP_ON_COMMIT, NULL);
+  SVN_ERR(svn_fs_open2(&copy_fs, copy_name, fs_config, pool, pool));
+  SVN_ERR(svn_fs_fs__warmup_wait(copy_fs));
+
+  /* Only a cache shared across instances can show that. */
+  if (svn_cache__get_global_membuffer_cache())
+    {
+      fs_fs_data_t *ffd = copy_fs->fsap_data;
+      pair_cache_key_t key;
+      svn_boolean_t found;
+
+      key.revision = rev_item->revision;
+      key.second = rev_item->number;
+      SVN_ERR(svn_cache__has_key(&found, ffd->node_revision_cache, &key,
+                                 pool));
+      SVN_TEST_ASSERT(found);
+    }
+
+  /* The copy remains fully functional. */
+  SVN_ERR(svn_fs_revision_root(&root, copy_fs, rev, pool));
+  SVN_ERR(read_tree(root, "/", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 
 
 /* The test table.  */
@@ -435,6 +745,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
                        "load the P2L index"),
+    SVN_TEST_OPTS_PASS(io_stats,
+                       "collect I/O statistics"),
+    SVN_TEST_OPTS_PASS(build_rep_cache,
+                       "rebuild the rep-cache"),
+    SVN_TEST_PASS2(extract_property,
+                   "read single properties from the cache format"),
+    SVN_TEST_OPTS_PASS(cache_warmup,
+                       "preload caches from the warm-up file"),
     SVN_TEST_NULL
   };
 
@@ -28,6 +28,8 @@
 #include "../../libsvn_fs_x/batch_fsync.h"
 #include "../../libsvn_fs_x/fs.h"
 #include "../../libsvn_fs_x/reps.h"
+#include "../../libsvn_fs_x/temp_serializer.h"
+#include "../../libsvn_fs/fs-loader.h"
 
 #include "svn_pools.h"
 #include "svn_props.h"
@@ -192,7 +194,7 @@ create_packed_filesystem(const char *dir,
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, NULL, pack_notify, &pnb, NULL, NULL, pool);
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -227,7 +229,7 @@ prepare_revprop_repo(svn_fs_t **fs,
   svn_pool_destroy(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, NULL, NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -641,7 +643,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
   /* Create a packed FS for which every revision will live in a pack
      digest file, and then recover it. */
   SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
-  SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
 
   /* Add another revision, re-pack, re-recover. */
   subpool = svn_pool_create(pool);
@@ -652,8 +654,8 @@ recover_fully_packed(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, subpool));
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
   svn_pool_destroy(subpool);
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
-  SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
 
   /* Now, delete the youngest revprop file, and recover again.  This
      time we want to see an error! */
@@ -664,7 +666,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
                                                 after_rev),
                                    SVN_VA_NULL),
               FALSE, pool));
-  err = svn_fs_recover(REPO_NAME, NULL, NULL, pool);
+  err = svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool);
   if (! err)
     return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
                             "Expected SVN_ERR_FS_CORRUPT error; got none");
@@ -778,6 +780,8 @@ test_reps(const svn_test_opts_t *opts,
   svn_stringbuf_t *serialized;
   svn_stream_t *stream;
   svn_stringbuf_t *contents = svn_stringbuf_create_ensure(10000, pool);
+  const svn_fs_x__reps_builder_info_t *info;
+  apr_size_t input_len = 0;
   int i;
 
   for (i = 0; i < 10000; ++i)
@@ -803,8 +807,16 @@ test_reps(const svn_test_opts_t *opts,
       string.len = i;
 
       SVN_ERR(svn_fs_x__reps_add(&idx, builder, &string));
+      input_len += i;
     }
 
+  /* All strings are prefixes of the first one. */
+  info = svn_fs_x__reps_builder_info(builder);
+  SVN_TEST_ASSERT(info->rep_count == 10000 - 10);
+  SVN_TEST_ASSERT(info->input_len == input_len);
+  SVN_TEST_ASSERT(info->matched_len + info->new_text_len == input_len);
+  SVN_TEST_ASSERT(info->new_text_len <= contents->len);
+
   serialized = svn_stringbuf_create_empty(pool);
   stream = svn_stream_from_stringbuf(serialized, pool);
   SVN_ERR(svn_fs_x__write_reps_container(stream, builder, pool));
@@ -813,6 +825,18 @@ test_reps(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_x__read_reps_container(&container, stream, pool, pool));
   SVN_ERR(svn_stream_close(stream));
 
+  /* Spot-check the contents. */
+  for (i = 0; i < 10000 - 10; i += 997)
+    {
+      svn_fs_x__rep_extractor_t *extractor;
+      svn_stringbuf_t *text;
+
+      SVN_ERR(svn_fs_x__reps_get(&extractor, fs, container, i, pool));
+      SVN_ERR(svn_fs_x__extractor_drive(&text, extractor, 0, 0, pool, pool));
+      SVN_TEST_ASSERT(text->len == 10000 - i);
+      SVN_TEST_ASSERT(memcmp(text->data, contents->data, text->len) == 0);
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -929,6 +953,70 @@ test_batch_fsync(const svn_test_opts_t *opts,
 }
 #undef REPO_NAME
 /* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-shared-dag-cache"
+static svn_error_t *
+shared_dag_cache(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *root2;
+  svn_revnum_t rev;
+  const char *conflict;
+  const svn_fs_id_t *id, *id2;
+  svn_fs_x__data_t *ffd2;
+  svn_fs_x__id_t *cached_id;
+  svn_boolean_t found;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsx") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSX repositories only");
+
+  if (svn_cache__get_global_membuffer_cache() == NULL)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "test requires the membuffer cache");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* Two independent FS instances. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ffd2 = fs2->fsap_data;
+
+  /* Nothing resolved yet. */
+  SVN_ERR(svn_cache__get((void **)&cached_id, &found,
+                         ffd2->rev_node_id_cache,
+                         svn_fs_x__combine_number_and_string(1, "A/D/G/pi",
+                                                             pool),
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Resolving a path in one instance makes it available to the other. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, "/A/D/G/pi", pool));
+
+  SVN_ERR(svn_cache__get((void **)&cached_id, &found,
+                         ffd2->rev_node_id_cache,
+                         svn_fs_x__combine_number_and_string(1, "A/D/G/pi",
+                                                             pool),
+                         pool));
+  SVN_TEST_ASSERT(found);
+
+  /* And it will resolve to the same node. */
+  SVN_ERR(svn_fs_revision_root(&root2, fs2, 1, pool));
+  SVN_ERR(svn_fs_node_id(&id2, root2, "/A/D/G/pi", pool));
+  SVN_TEST_ASSERT(svn_fs_compare_ids(id, id2) == 0);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+/* ------------------------------------------------------------------------ */
 
 /* The test table.  */
 
@@ -963,6 +1051,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test packing with shard size = 1"),
     SVN_TEST_OPTS_PASS(test_batch_fsync,
                        "test batch fsync"),
+    SVN_TEST_OPTS_PASS(shared_dag_cache,
+                       "share resolved paths between FSX instances"),
     SVN_TEST_NULL
   };
 
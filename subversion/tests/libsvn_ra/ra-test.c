@@ -36,6 +36,13 @@
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_config.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -143,6 +150,13 @@ typedef struct tunnel_baton_t
   int magic; /* TUNNEL_MAGIC */
   int open_count;
   svn_boolean_t last_check;
+
+  /* Argument to svnserve's --compression option or NULL for the
+     default. */
+  const char *compression;
+
+  /* If not NULL, all data received from svnserve gets appended here. */
+  svn_stringbuf_t *received;
 } tunnel_baton_t;
 
 #define TUNNEL_MAGIC 0xF00DF00F
@@ -172,6 +186,80 @@ check_tunnel(void *tunnel_baton, const char *tunnel_name)
 static void
 close_tunnel(void *tunnel_context, void *tunnel_baton);
 
+/* Baton of a stream that records all data read from another stream. */
+typedef struct recording_baton_t
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *received;
+} recording_baton_t;
+
+/* Implements svn_read_fn_t for recording_baton_t. */
+static svn_error_t *
+recording_read(void *baton,
+               char *buffer,
+               apr_size_t *len)
+{
+  recording_baton_t *rb = baton;
+
+  SVN_ERR(svn_stream_read2(rb->stream, buffer, len));
+  svn_stringbuf_appendbytes(rb->received, buffer, *len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t for recording_baton_t. */
+static svn_error_t *
+recording_read_full(void *baton,
+                    char *buffer,
+                    apr_size_t *len)
+{
+  recording_baton_t *rb = baton;
+
+  SVN_ERR(svn_stream_read_full(rb->stream, buffer, len));
+  svn_stringbuf_appendbytes(rb->received, buffer, *len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_data_available_fn_t for recording_baton_t. */
+static svn_error_t *
+recording_data_available(void *baton,
+                         svn_boolean_t *data_available)
+{
+  recording_baton_t *rb = baton;
+
+  return svn_error_trace(svn_stream_data_available(rb->stream,
+                                                   data_available));
+}
+
+/* Implements svn_close_fn_t for recording_baton_t. */
+static svn_error_t *
+recording_close(void *baton)
+{
+  recording_baton_t *rb = baton;
+
+  return svn_error_trace(svn_stream_close(rb->stream));
+}
+
+/* Return a stream that reads from STREAM and appends all data read to
+   RECEIVED.  Allocate it in POOL. */
+static svn_stream_t *
+recording_stream(svn_stream_t *stream,
+                 svn_stringbuf_t *received,
+                 apr_pool_t *pool)
+{
+  recording_baton_t *rb = apr_pcalloc(pool, sizeof(*rb));
+  svn_stream_t *result = svn_stream_create(rb, pool);
+
+  rb->stream = stream;
+  rb->received = received;
+  svn_stream_set_read2(result, recording_read, recording_read_full);
+  svn_stream_set_data_available(result, recording_data_available);
+  svn_stream_set_close(result, recording_close);
+
+  return result;
+}
+
 static svn_error_t *
 open_tunnel(svn_stream_t **request, svn_stream_t **response,
             svn_ra_close_tunnel_func_t *close_func, void **close_baton,
@@ -185,13 +273,19 @@ open_tunnel(svn_stream_t **request, svn_stream_t **response,
   apr_proc_t *proc;
   apr_procattr_t *attr;
   apr_status_t status;
-  const char *args[] = { "svnserve", "-t", "-r", ".", NULL };
+  const char *args[] = { "svnserve", "-t", "-r", ".", NULL, NULL, NULL };
   const char *svnserve;
   tunnel_baton_t *b = tunnel_baton;
   close_baton_t *cb;
 
   SVN_TEST_ASSERT(b->magic == TUNNEL_MAGIC);
 
+  if (b->compression)
+    {
+      args[4] = "--compression";
+      args[5] = b->compression;
+    }
+
   SVN_ERR(svn_dirent_get_absolute(&svnserve, "../../svnserve/svnserve", pool));
 #ifdef WIN32
   svnserve = apr_pstrcat(pool, svnserve, ".exe", SVN_VA_NULL);
@@ -229,6 +323,8 @@ open_tunnel(svn_stream_t **request, svn_stream_t **response,
 
   *request = svn_stream_from_aprfile2(proc->in, FALSE, pool);
   *response = svn_stream_from_aprfile2(proc->out, FALSE, pool);
+  if (b->received)
+    *response = recording_stream(*response, b->received, pool);
   *close_func = close_tunnel;
   *close_baton = cb;
   ++b->open_count;
@@ -630,6 +726,135 @@ get_dir_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Baton for batch_receiver(). */
+typedef struct batch_baton_t
+{
+  /* Text describing the received entries, one line per entry. */
+  svn_stringbuf_t *log;
+
+  /* Collects the file contents. */
+  svn_stringbuf_t *contents;
+} batch_baton_t;
+
+/* Implements svn_ra_fetch_receiver_t for get_files_batch_test(). */
+static svn_error_t *
+batch_receiver(void *baton,
+               const char *path,
+               svn_revnum_t revision,
+               svn_node_kind_t kind,
+               apr_hash_t *props,
+               apr_hash_t *dirents,
+               svn_stream_t **contents,
+               apr_pool_t *scratch_pool)
+{
+  batch_baton_t *b = baton;
+
+  SVN_TEST_INT_ASSERT(revision, 1);
+  SVN_TEST_ASSERT((props != NULL) == (kind != svn_node_none));
+  SVN_TEST_ASSERT((dirents != NULL) == (kind == svn_node_dir));
+  SVN_TEST_ASSERT((contents != NULL) == (kind == svn_node_file));
+
+  svn_stringbuf_appendcstr(b->log,
+                           apr_psprintf(scratch_pool, "%s %s %u\n", path,
+                                        svn_node_kind_to_word(kind),
+                                        dirents ? apr_hash_count(dirents)
+                                                : 0));
+  if (contents)
+    *contents = svn_stream_from_stringbuf(b->contents, b->contents->pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files_batch_test(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  batch_baton_t b;
+
+  SVN_ERR(make_and_open_repos(&session, "test-get-files-batch", opts, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "A/B";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/f";
+  APR_ARRAY_PUSH(paths, const char *) = "non/existing/relpath";
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  b.log = svn_stringbuf_create_empty(pool);
+  b.contents = svn_stringbuf_create_empty(pool);
+
+  /* All entries get reported in request order, missing ones included. */
+  SVN_ERR(svn_ra_get_files_batch(session, paths, SVN_INVALID_REVNUM,
+                                 TRUE, TRUE, SVN_DIRENT_KIND,
+                                 batch_receiver, &b, pool));
+  SVN_TEST_STRING_ASSERT(b.log->data,
+                         "A/B dir 2\n"
+                         "A/B/f file 0\n"
+                         "non/existing/relpath none 0\n"
+                         " dir 1\n");
+  SVN_TEST_STRING_ASSERT(b.contents->data, "");
+
+  /* An empty batch is fine as well. */
+  svn_stringbuf_setempty(b.log);
+  apr_array_clear(paths);
+  SVN_ERR(svn_ra_get_files_batch(session, paths, 1, FALSE, FALSE, 0,
+                                 batch_receiver, &b, pool));
+  SVN_TEST_STRING_ASSERT(b.log->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+stat_many_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(make_and_open_repos(&session, "test-stat-many", opts, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "A/B";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/f";
+  APR_ARRAY_PUSH(paths, const char *) = "non/existing/relpath";
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  /* Missing paths are left out. */
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, SVN_INVALID_REVNUM,
+                           pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 3);
+  SVN_TEST_ASSERT(!svn_hash_gets(dirents, "non/existing/relpath"));
+
+  dirent = svn_hash_gets(dirents, "A/B");
+  SVN_TEST_ASSERT(dirent != NULL);
+  SVN_TEST_ASSERT(dirent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 1);
+
+  dirent = svn_hash_gets(dirents, "A/B/f");
+  SVN_TEST_ASSERT(dirent != NULL);
+  SVN_TEST_ASSERT(dirent->kind == svn_node_file);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 1);
+
+  dirent = svn_hash_gets(dirents, "");
+  SVN_TEST_ASSERT(dirent != NULL);
+  SVN_TEST_ASSERT(dirent->kind == svn_node_dir);
+
+  /* Nothing exists in r0 but the root. */
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, 0, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 1);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "") != NULL);
+
+  /* An empty request is fine as well. */
+  apr_array_clear(paths);
+  SVN_ERR(svn_ra_stat_many(session, &dirents, paths, 1, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_commit_callback2_t for commit_callback_failure() */
 static svn_error_t *
 commit_callback_with_failure(const svn_commit_info_t *info,
@@ -1586,6 +1811,395 @@ tunnel_run_checkout(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Baton for the checkout_editor_t callbacks. */
+typedef struct checkout_baton_t
+{
+  /* Maps paths to the svn_stringbuf_t contents of the files received. */
+  apr_hash_t *contents;
+
+  /* Tunnels of the session doing the checkout. */
+  tunnel_baton_t *tb;
+
+  /* Maximum number of tunnels open while receiving file contents. */
+  int max_open_count;
+
+  svn_boolean_t closed;
+  apr_pool_t *pool;
+} checkout_baton_t;
+
+/* Implements svn_delta_editor_t.open_root for checkout_baton_t. */
+static svn_error_t *
+checkout_open_root(void *edit_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *dir_pool,
+                   void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.add_directory for checkout_baton_t. */
+static svn_error_t *
+checkout_add_directory(const char *path,
+                       void *parent_baton,
+                       const char *copyfrom_path,
+                       svn_revnum_t copyfrom_revision,
+                       apr_pool_t *dir_pool,
+                       void **child_baton)
+{
+  *child_baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.add_file for checkout_baton_t. */
+static svn_error_t *
+checkout_add_file(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *file_pool,
+                  void **file_baton)
+{
+  checkout_baton_t *cb = parent_baton;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(cb->pool);
+
+  SVN_TEST_ASSERT(!svn_hash_gets(cb->contents, path));
+  svn_hash_sets(cb->contents, apr_pstrdup(cb->pool, path), contents);
+
+  /* The extra connections stay open until the edit has been completed. */
+  cb->max_open_count = MAX(cb->max_open_count, cb->tb->open_count);
+
+  *file_baton = contents;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.apply_textdelta for checkout_baton_t. */
+static svn_error_t *
+checkout_apply_textdelta(void *file_baton,
+                         const char *base_checksum,
+                         apr_pool_t *pool,
+                         svn_txdelta_window_handler_t *handler,
+                         void **handler_baton)
+{
+  svn_stringbuf_t *contents = file_baton;
+
+  svn_txdelta_apply(svn_stream_empty(pool),
+                    svn_stream_from_stringbuf(contents, pool),
+                    NULL, NULL, pool, handler, handler_baton);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.close_edit for checkout_baton_t. */
+static svn_error_t *
+checkout_close_edit(void *edit_baton,
+                    apr_pool_t *pool)
+{
+  checkout_baton_t *cb = edit_baton;
+
+  cb->closed = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.close_file for checkout_baton_t. */
+static svn_error_t *
+checkout_close_file(void *file_baton,
+                    const char *text_checksum,
+                    apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Test a checkout of many files over several ra_svn connections. */
+static svn_error_t *
+tunnel_parallel_checkout(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  checkout_baton_t *cb = apr_pcalloc(pool, sizeof(*cb));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char tunnel_repos_name[] = "test-parallel-checkout";
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  svn_config_t *servers;
+  apr_hash_t *config = apr_hash_make(pool);
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  apr_hash_t *expected = apr_hash_make(pool);
+  svn_stringbuf_t *big = svn_stringbuf_create_empty(pool);
+  apr_hash_index_t *hi;
+  int i;
+
+  /* More files than the fetching editor keeps in flight, one of them
+     too large to be buffered in memory. */
+  SVN_ERR(svn_test__create_repos(&repos, tunnel_repos_name, opts,
+                                 scratch_pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), 0, 0, scratch_pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, scratch_pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", scratch_pool));
+  for (i = 0; i < 50; ++i)
+    {
+      const char *path = apr_psprintf(pool, "A/file-%d", i);
+      const char *text = apr_psprintf(pool, "This is file %d.\n", i);
+
+      SVN_ERR(svn_fs_make_file(txn_root, path, scratch_pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, path, text,
+                                          scratch_pool));
+      svn_hash_sets(expected, path, text);
+    }
+
+  while (big->len < 1024 * 1024)
+    svn_stringbuf_appendcstr(big, apr_psprintf(pool, "line %d\n",
+                                               (int)big->len));
+  SVN_ERR(svn_fs_make_file(txn_root, "big", scratch_pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "big", big->data,
+                                      scratch_pool));
+  svn_hash_sets(expected, "big", big->data);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, scratch_pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+     (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  /* Fetch the contents over 3 extra connections. */
+  SVN_ERR(svn_config_create2(&servers, FALSE, FALSE, pool));
+  svn_config_set(servers, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS, "4");
+  svn_hash_sets(config, SVN_CONFIG_CATEGORY_SERVERS, servers);
+
+  b->magic = TUNNEL_MAGIC;
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, config,
+                       scratch_pool));
+
+  cb->contents = apr_hash_make(pool);
+  cb->tb = b;
+  cb->pool = pool;
+  editor->open_root = checkout_open_root;
+  editor->add_directory = checkout_add_directory;
+  editor->add_file = checkout_add_file;
+  editor->apply_textdelta = checkout_apply_textdelta;
+  editor->close_file = checkout_close_file;
+  editor->close_edit = checkout_close_edit;
+
+  SVN_ERR(svn_ra_do_update3(session, &reporter, &report_baton,
+                            youngest_rev, "", svn_depth_infinity,
+                            FALSE, FALSE, editor, cb,
+                            scratch_pool, scratch_pool));
+  SVN_ERR(reporter->set_path(report_baton, "", 0, svn_depth_infinity, TRUE,
+                             NULL, scratch_pool));
+  SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+
+  SVN_TEST_ASSERT(cb->closed);
+  SVN_TEST_INT_ASSERT(cb->max_open_count,
+                      svn_task__get_thread_limit() > 0 ? 4 : 1);
+  SVN_TEST_INT_ASSERT(apr_hash_count(cb->contents),
+                      apr_hash_count(expected));
+  for (hi = apr_hash_first(pool, expected); hi; hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_t *contents = svn_hash_gets(cb->contents,
+                                                apr_hash_this_key(hi));
+
+      SVN_TEST_ASSERT(contents);
+      SVN_TEST_STRING_ASSERT(contents->data, apr_hash_this_val(hi));
+    }
+
+  /* The extra connections are gone once the edit has been completed. */
+  svn_pool_destroy(scratch_pool);
+  SVN_TEST_ASSERT(b->open_count == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a highly compressible text of at least 64kB. */
+static const char *
+compressible_text(apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(pool);
+
+  while (text->len < 64 * 1024)
+    svn_stringbuf_appendcstr(text, "All work and no play makes Jack "
+                                   "a dull boy.\n");
+
+  return text->data;
+}
+
+/* Send a few tuples through a connection compressed with METHOD and
+   read them back from the wire data, on a second connection. */
+static svn_error_t *
+check_compressed_round_trip(svn_ra_svn__compression_t method,
+                            apr_pool_t *pool)
+{
+  const char *text = compressible_text(pool);
+  svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *conn;
+  const char *word;
+  const char *cstr;
+  apr_uint64_t number;
+  int i;
+
+  /* The switch happens after some uncompressed data. */
+  conn = svn_ra_svn_create_conn5(NULL, svn_stream_empty(pool),
+                                 svn_stream_from_stringbuf(wire, pool),
+                                 SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                 0, 0, 0, 0, pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w", "plain"));
+  SVN_ERR(svn_ra_svn__enable_compression(conn, method, pool));
+
+  /* Each flush sends a frame of its own. */
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "cn", text,
+                                      (apr_uint64_t)i));
+      SVN_ERR(svn_ra_svn__flush(conn, pool));
+    }
+
+  SVN_TEST_ASSERT(wire->len < strlen(text));
+
+  /* Reading the uncompressed part already buffers compressed data. */
+  conn = svn_ra_svn_create_conn5(NULL,
+                                 svn_stream_from_stringbuf(wire, pool),
+                                 svn_stream_empty(pool),
+                                 SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                 0, 0, 0, 0, pool);
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "w", &word));
+  SVN_TEST_STRING_ASSERT(word, "plain");
+  SVN_ERR(svn_ra_svn__enable_compression(conn, method, pool));
+
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "cn", &cstr, &number));
+      SVN_TEST_STRING_ASSERT(cstr, text);
+      SVN_TEST_INT_ASSERT(number, i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test svn_ra_svn__enable_compression() on both ends of a connection. */
+static svn_error_t *
+compressed_stream_round_trip(apr_pool_t *pool)
+{
+  SVN_ERR(check_compressed_round_trip(svn_ra_svn__compression_lz4, pool));
+  if (svn__zstd_available())
+    SVN_ERR(check_compressed_round_trip(svn_ra_svn__compression_zstd,
+                                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch a large log message over svn+test with svnserve's compression
+   option set to COMPRESSION.  Set *RECEIVED to the number of bytes
+   received from svnserve. */
+static svn_error_t *
+fetch_log_message(apr_size_t *received,
+                  const char *repos_name,
+                  const char *compression,
+                  const char *expected,
+                  apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  svn_string_t *message;
+
+  b->magic = TUNNEL_MAGIC;
+  b->compression = compression;
+  b->received = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL,
+                       apr_pstrcat(pool, "svn+test://localhost/",
+                                   repos_name, SVN_VA_NULL),
+                       NULL, cbtable, NULL, NULL, session_pool));
+  SVN_ERR(svn_ra_rev_prop(session, 1, SVN_PROP_REVISION_LOG, &message,
+                          session_pool));
+  SVN_TEST_STRING_ASSERT(message->data, expected);
+
+  svn_pool_destroy(session_pool);
+  SVN_TEST_ASSERT(b->open_count == 0);
+
+  *received = b->received->len;
+  return SVN_NO_ERROR;
+}
+
+/* Test that the client and svnserve agree on compressing the stream. */
+static svn_error_t *
+tunnel_compressed_stream(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  const char tunnel_repos_name[] = "test-compressed-stream";
+  const char *text = compressible_text(pool);
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  apr_size_t received;
+
+  SVN_ERR(svn_test__create_repos(&repos, tunnel_repos_name, opts,
+                                 scratch_pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), 0, 0, scratch_pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, scratch_pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", scratch_pool));
+  SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                 svn_string_create(text, scratch_pool),
+                                 scratch_pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, scratch_pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+     (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_destroy(scratch_pool);
+
+  /* By default, the server offers compression and the client uses it. */
+  SVN_ERR(fetch_log_message(&received, tunnel_repos_name, NULL, text,
+                            pool));
+  SVN_TEST_ASSERT(received < strlen(text));
+
+  /* Without compression, the text goes over the wire as is. */
+  SVN_ERR(fetch_log_message(&received, tunnel_repos_name, "0", text,
+                            pool));
+  SVN_TEST_ASSERT(received > strlen(text));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_log_entry_receiver_t for commit_empty_last_change */
 static svn_error_t *
 AA_receiver(void *baton,
@@ -1700,6 +2314,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "lock multiple paths"),
     SVN_TEST_OPTS_PASS(get_dir_test,
                        "test ra_get_dir2"),
+    SVN_TEST_OPTS_PASS(get_files_batch_test,
+                       "test ra_get_files_batch"),
+    SVN_TEST_OPTS_PASS(stat_many_test,
+                       "test ra_stat_many"),
     SVN_TEST_OPTS_PASS(commit_callback_failure,
                        "commit callback failure"),
     SVN_TEST_OPTS_PASS(base_revision_above_youngest,
@@ -1714,6 +2332,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check list has_props performance"),
     SVN_TEST_OPTS_PASS(tunnel_run_checkout,
                        "verify checkout over a tunnel"),
+    SVN_TEST_OPTS_PASS(tunnel_parallel_checkout,
+                       "checkout over several ra_svn connections"),
+    SVN_TEST_PASS2(compressed_stream_round_trip,
+                   "send data through a compressed ra_svn stream"),
+    SVN_TEST_OPTS_PASS(tunnel_compressed_stream,
+                       "negotiate ra_svn stream compression"),
     SVN_TEST_OPTS_PASS(commit_empty_last_change,
                        "check how last change applies to empty commit"),
     SVN_TEST_NULL
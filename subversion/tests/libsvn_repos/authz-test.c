@@ -25,6 +25,8 @@
 #include "svn_pools.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "../../libsvn_repos/authz.h"
@@ -444,6 +446,153 @@ test_global_rights(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_snapshot(apr_pool_t *pool)
+{
+  const char *contents =
+    "[groups]"                                                           NL
+    "team = userA, userB"                                                NL
+    ""                                                                   NL
+    "[/]"                                                                NL
+    "* = r"                                                              NL
+    ""                                                                   NL
+    "[/secret]"                                                          NL
+    "* ="                                                                NL
+    "@team = rw"                                                         NL
+    ""                                                                   NL
+    "[/projects/*/trunk]"                                                NL
+    "$authenticated = rw"                                                NL
+    ""                                                                   NL
+    "[/projects/**/*.key]"                                               NL
+    "~userB ="                                                           NL
+    ""                                                                   NL
+    "[greek:/A]"                                                         NL
+    "userB = rw"                                                         NL
+    "$anonymous ="                                                       NL;
+
+  const char *repositories[] = { "greek", "other", NULL };
+  const char *users[] = { "userA", "userB", "userC", NULL };
+  const char *paths[] = { "/", "/A", "/A/B", "/secret", "/secret/x",
+                          "/projects/p/trunk", "/projects/p/trunk/a.key",
+                          "/projects/p/branches", NULL };
+  const svn_repos_authz_access_t requests[] = {
+      svn_authz_read, svn_authz_write, svn_authz_read | svn_authz_recursive,
+      svn_authz_write | svn_authz_recursive };
+
+  const char *sandbox, *authz_path;
+  svn_authz_t *plain, *compiled;
+  int r, u, p, k;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "authz-snapshot", pool));
+  authz_path = svn_dirent_join(sandbox, "authz", pool);
+  SVN_ERR(svn_io_file_create(authz_path, contents, pool));
+
+  /* Without a snapshot, the rules get filtered on demand. */
+  SVN_ERR(svn_repos_authz_read3(&plain, authz_path, NULL, TRUE, NULL,
+                                pool, pool));
+  SVN_TEST_ASSERT(plain->full->snapshot == NULL);
+
+  SVN_ERR(svn_repos__authz_write_snapshot(
+            plain,
+            apr_pstrcat(pool, authz_path, SVN_REPOS__AUTHZ_SNAPSHOT_SUFFIX,
+                        SVN_VA_NULL),
+            pool));
+
+  SVN_ERR(svn_repos_authz_read3(&compiled, authz_path, NULL, TRUE, NULL,
+                                pool, pool));
+  SVN_TEST_ASSERT(compiled->full->snapshot != NULL);
+
+  /* Both must grant the same access, including to users and repositories
+   * not mentioned in the rules. */
+  for (r = 0; repositories[r]; ++r)
+    for (u = -1; users[u + 1]; ++u)
+      for (p = 0; paths[p]; ++p)
+        for (k = 0; k < (int)(sizeof(requests) / sizeof(requests[0])); ++k)
+          {
+            const char *user = u < 0 ? NULL : users[u];
+            svn_boolean_t expected, actual;
+
+            SVN_ERR(svn_repos_authz_check_access(plain, repositories[r],
+                                                 paths[p], user, requests[k],
+                                                 &expected, pool));
+            SVN_ERR(svn_repos_authz_check_access(compiled, repositories[r],
+                                                 paths[p], user, requests[k],
+                                                 &actual, pool));
+            SVN_TEST_ASSERT(expected == actual);
+          }
+
+  /* Modified rules invalidate the snapshot. */
+  SVN_ERR(svn_io_file_create(authz_path,
+                             apr_pstrcat(pool, contents,
+                                         "[/new]" NL "* = rw" NL,
+                                         SVN_VA_NULL),
+                             pool));
+  SVN_ERR(svn_repos_authz_read3(&compiled, authz_path, NULL, TRUE, NULL,
+                                pool, pool));
+  SVN_TEST_ASSERT(compiled->full->snapshot == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_authz_check_many(apr_pool_t *pool)
+{
+  const char *contents =
+    "[/]"                                                                NL
+    "* = r"                                                              NL
+    ""                                                                   NL
+    "[/trunk/secret]"                                                    NL
+    "* ="                                                                NL
+    "userA = rw"                                                         NL
+    ""                                                                   NL
+    "[/trunk/*.c]"                                                       NL
+    "userB = rw"                                                         NL;
+
+  const char *path_list[] = { "/trunk", "/trunk/a.c", "/trunk/a.h",
+                              "/trunk/secret", "/trunk/secret/x",
+                              "/trunk/secret/y", "/trunk/z", "/branches",
+                              "/branches/b/a.c", NULL };
+  const char *users[] = { "userA", "userB", "userC", NULL };
+  const svn_repos_authz_access_t requests[] = {
+      svn_authz_read, svn_authz_write, svn_authz_read | svn_authz_recursive };
+
+  svn_stringbuf_t *buffer = svn_stringbuf_create(contents, pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(buffer, pool);
+  apr_array_header_t *paths = apr_array_make(pool, 10, sizeof(const char *));
+  svn_boolean_t granted[10];
+  svn_authz_t *authz;
+  int i, u, k;
+
+  SVN_ERR(svn_repos_authz_parse(&authz, stream, NULL, pool));
+
+  for (i = 0; path_list[i]; ++i)
+    APR_ARRAY_PUSH(paths, const char *) = path_list[i];
+  APR_ARRAY_PUSH(paths, const char *) = NULL;
+
+  /* The batch results must match individual lookups. */
+  for (u = -1; users[u + 1]; ++u)
+    for (k = 0; k < (int)(sizeof(requests) / sizeof(requests[0])); ++k)
+      {
+        const char *user = u < 0 ? NULL : users[u];
+
+        SVN_ERR(svn_repos_authz_check_access_many(authz, "repo", paths, user,
+                                                  requests[k], granted,
+                                                  pool));
+        for (i = 0; i < paths->nelts; ++i)
+          {
+            svn_boolean_t expected;
+            SVN_ERR(svn_repos_authz_check_access(authz, "repo",
+                                                 APR_ARRAY_IDX(paths, i,
+                                                               const char *),
+                                                 user, requests[k],
+                                                 &expected, pool));
+            SVN_TEST_ASSERT(granted[i] == expected);
+          }
+      }
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -453,6 +602,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_authz__parse"),
     SVN_TEST_PASS2(test_global_rights,
                    "test svn_authz__get_global_rights"),
+    SVN_TEST_PASS2(test_authz_snapshot,
+                   "test pre-compiled authz snapshots"),
+    SVN_TEST_PASS2(test_authz_check_many,
+                   "test svn_repos_authz_check_access_many"),
     SVN_TEST_NULL
   };
 
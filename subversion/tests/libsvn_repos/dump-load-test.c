@@ -28,6 +28,7 @@
 #include "svn_error.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
+#include "svn_dirent_uri.h"
 #include "private/svn_repos_private.h"
 
 #include "../svn_test.h"
@@ -272,6 +273,167 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos__dump_stream_func_t.  Append a new stringbuf to
+   the array of stringbufs in BATON and return a stream writing to it. */
+static svn_error_t *
+collect_dump_range(svn_stream_t **stream,
+                   void *baton,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *ranges = baton;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(ranges->pool);
+
+  APR_ARRAY_PUSH(ranges, svn_stringbuf_t *) = buf;
+  *stream = svn_stream_from_stringbuf(buf, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Dumping revision ranges into separate streams must produce the same
+   data as a plain dump, once the ranges get concatenated. */
+static svn_error_t *
+test_dump_ranges(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  int jobs, i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-ranges",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  for (i = 0; i < 5; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(pool, "iota %d\n", i),
+                                          pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "A", "prop",
+                                      svn_string_createf(pool, "%d", i),
+                                      pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  SVN_ERR(svn_repos_dump_fs4(repos,
+                             svn_stream_from_stringbuf(expected, pool),
+                             2, youngest_rev, FALSE, FALSE, TRUE, TRUE,
+                             NULL, NULL, NULL, NULL, pool));
+
+  for (jobs = 1; jobs <= 3; ++jobs)
+    {
+      apr_array_header_t *ranges
+        = apr_array_make(pool, 4, sizeof(svn_stringbuf_t *));
+      svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn_repos__dump_fs_ranges(repos, collect_dump_range, ranges,
+                                        2, youngest_rev, 2, jobs,
+                                        FALSE, FALSE, TRUE, TRUE,
+                                        NULL, NULL, NULL, NULL, pool));
+
+      /* r2..r6 in ranges of 2 revisions. */
+      SVN_TEST_ASSERT(ranges->nelts == 3);
+      for (i = 0; i < ranges->nelts; ++i)
+        svn_stringbuf_appendstr(actual,
+                                APR_ARRAY_IDX(ranges, i, svn_stringbuf_t *));
+
+      SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Bulk loads must load everything, record their progress in the
+   checkpoint file and resume from there. */
+static svn_error_t *
+test_load_bulk(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *checkpoint;
+  const char *checkpoint_path;
+  int i;
+
+  /* Produce a dump file with a couple of revisions. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-bulk-1",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  for (i = 0; i < 4; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(pool, "iota %d\n", i),
+                                          pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  SVN_ERR(svn_repos_dump_fs4(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE,
+                             NULL, NULL, NULL, NULL, pool));
+
+  /* Load it in batches of 2 revisions. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-bulk-2",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+  checkpoint_path = svn_dirent_join(svn_repos_path(repos, pool),
+                                    "load-checkpoint", pool);
+
+  SVN_ERR(svn_repos__load_fs_bulk(repos,
+                                  svn_stream_from_stringbuf(dump_data, pool),
+                                  SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                  svn_repos_load_uuid_default, NULL,
+                                  FALSE, FALSE, TRUE, FALSE, 2,
+                                  checkpoint_path, NULL, NULL, NULL, NULL,
+                                  pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
+  SVN_TEST_ASSERT(youngest_rev == 5);
+
+  SVN_ERR(svn_stringbuf_from_file2(&checkpoint, checkpoint_path, pool));
+  SVN_TEST_STRING_ASSERT(checkpoint->data, "5 5\n");
+
+  /* Resuming skips everything that has been loaded already. */
+  SVN_ERR(svn_repos__load_fs_bulk(repos,
+                                  svn_stream_from_stringbuf(dump_data, pool),
+                                  SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                  svn_repos_load_uuid_default, NULL,
+                                  FALSE, FALSE, TRUE, FALSE, 2,
+                                  checkpoint_path, NULL, NULL, NULL, NULL,
+                                  pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
+  SVN_TEST_ASSERT(youngest_rev == 5);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -283,6 +445,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_dump_ranges,
+                       "test dumping revision ranges concurrently"),
+    SVN_TEST_OPTS_PASS(test_load_bulk,
+                       "test bulk loading with checkpoints"),
     SVN_TEST_NULL
   };
 
@@ -38,12 +38,17 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_time.h"
 #include "svn_version.h"
+#include "svn_mergeinfo.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_task.h"
 
 /* be able to look into svn_config_t */
 #include "../../libsvn_subr/config_impl.h"
+#include "../../libsvn_repos/repos.h"
 
 #include "../svn_test_fs.h"
 
@@ -3275,6 +3280,96 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 
 
 
+/* Test that the reporter computing text deltas concurrently drives the
+   editor like the sequential one does. */
+static svn_error_t *
+reporter_delta_jobs(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  svn_stringbuf_t *large;
+  static const char *const files[] = {
+    "iota", "A/mu", "A/B/lambda", "A/B/E/alpha", "A/B/E/beta",
+    "A/D/gamma", "A/D/G/pi", "A/D/G/rho", "A/D/G/tau",
+    "A/D/H/chi", "A/D/H/psi", "A/D/H/omega", "A/D/H/new", NULL
+  };
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-delta-jobs",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* r2: change every file and add one.  Make one of them large enough to
+     exceed its share of the delta buffer below. */
+  large = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 20000; i++)
+    svn_stringbuf_appendcstr(large,
+                             apr_psprintf(subpool, "line %d\n", i));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/D/H/new", subpool));
+  for (i = 0; files[i]; i++)
+    SVN_ERR(svn_test__set_file_contents(
+              txn_root, files[i],
+              strcmp(files[i], "A/D/G/rho") == 0
+                ? large->data
+                : apr_psprintf(subpool, "Changed file '%s'.\n", files[i]),
+              subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Update from r1 to r2 with multiple jobs and a small buffer.  Record
+     the editor commands in a temporary txn. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos, "/",
+                                  "", NULL, TRUE, svn_depth_infinity, FALSE,
+                                  FALSE, editor, edit_baton, NULL, NULL, 0,
+                                  subpool));
+  svn_repos__report_set_delta_jobs(report_baton, 4, 64 * 1024);
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 1, svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+  /* The txn must now match r2. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  for (i = 0; files[i]; i++)
+    {
+      svn_stringbuf_t *expected, *actual;
+
+      SVN_ERR(svn_test__get_file_contents(rev_root, files[i], &expected,
+                                          subpool));
+      SVN_ERR(svn_test__get_file_contents(txn_root, files[i], &actual,
+                                          subpool));
+      SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+    }
+
+  svn_error_clear(svn_fs_abort_txn(txn, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
  * behaviour.
@@ -4070,6 +4165,69 @@ test_config_pool(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Write CONTENTS to the file at PATH and make it look old enough for its
+ * timestamp to be trusted. */
+static svn_error_t *
+write_old_config(const char *path,
+                 const char *contents,
+                 apr_pool_t *pool)
+{
+  SVN_ERR(svn_io_write_atomic2(path, contents, strlen(contents), NULL,
+                               FALSE, pool));
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          - apr_time_from_sec(3600),
+                                        path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_config_pool_file_changes(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  svn_repos__config_pool_t *config_pool;
+  svn_config_t *cfg;
+  const char *value;
+  apr_hash_t *sections;
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  const char *wrk_dir = svn_test_data_path("config_pool_changes", pool);
+  const char *path = svn_dirent_join(wrk_dir, "changes.cfg", pool);
+
+  SVN_ERR(svn_io_make_dir_recursively(wrk_dir, pool));
+  SVN_ERR(svn_repos__config_pool_create(&config_pool, TRUE, pool));
+  SVN_ERR(write_old_config(path, "[section]\nkey = 1\n", pool));
+
+  /* Repeated reads of an unchanged file must give the same config. */
+  sections = NULL;
+  for (i = 0; i < 3; ++i)
+    {
+      SVN_ERR(svn_repos__config_pool_get(&cfg, config_pool, path, TRUE,
+                                         NULL, subpool));
+      svn_config_get(cfg, &value, "section", "key", NULL);
+      SVN_TEST_STRING_ASSERT(value, "1");
+
+      if (sections == NULL)
+        sections = cfg->sections;
+      else
+        SVN_TEST_ASSERT(cfg->sections == sections);
+
+      svn_pool_clear(subpool);
+    }
+
+  /* Replacing the file with an old one of the same size must still be
+   * detected. */
+  SVN_ERR(write_old_config(path, "[section]\nkey = 2\n", pool));
+  SVN_ERR(svn_repos__config_pool_get(&cfg, config_pool, path, TRUE,
+                                     NULL, subpool));
+  svn_config_get(cfg, &value, "section", "key", NULL);
+  SVN_TEST_STRING_ASSERT(value, "2");
+  SVN_TEST_ASSERT(cfg->sections != sections);
+  svn_pool_clear(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *
 test_repos_fs_type(const svn_test_opts_t *opts,
@@ -4466,6 +4624,1187 @@ test_list(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_dirent_receiver_t.  Append a copy of PATH to the
+   apr_array_header_t BATON. */
+static svn_error_t *
+list_collect_callback(const char *path,
+                      svn_dirent_t *dirent,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *paths = baton;
+  APR_ARRAY_PUSH(paths, const char *) = apr_pstrdup(paths->pool, path);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t.  Deny access to /A/D/G. */
+static svn_error_t *
+list_authz_callback(svn_boolean_t *allowed,
+                    svn_fs_root_t *root,
+                    const char *path,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  *allowed = strcmp(path, "/A/D/G") != 0;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_list_parallel(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  apr_array_header_t *expected, *actual, *patterns;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list-parallel", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  patterns = apr_array_make(pool, 2, sizeof(const char *));
+  APR_ARRAY_PUSH(patterns, const char *) = "*a*";
+  APR_ARRAY_PUSH(patterns, const char *) = "mu";
+
+  /* The ordered concurrent listing must match the sequential one. */
+  expected = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos_list(rev_root, "/", patterns, svn_depth_infinity,
+                         FALSE, list_authz_callback, NULL,
+                         list_collect_callback, expected, NULL, NULL,
+                         pool));
+  SVN_TEST_ASSERT(expected->nelts > 0);
+
+  actual = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos__list(rev_root, "/", patterns, svn_depth_infinity,
+                          FALSE, list_authz_callback, NULL,
+                          list_collect_callback, actual, NULL, NULL,
+                          4, TRUE, pool));
+  SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+  for (i = 0; i < expected->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  /* The unordered one must report the same entries. */
+  actual = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos__list(rev_root, "/", patterns, svn_depth_infinity,
+                          FALSE, list_authz_callback, NULL,
+                          list_collect_callback, actual, NULL, NULL,
+                          4, FALSE, pool));
+  SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+  svn_sort__array(actual, svn_sort_compare_paths);
+  svn_sort__array(expected, svn_sort_compare_paths);
+  for (i = 0; i < expected->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for verify_notify. */
+typedef struct verify_notify_baton_t
+{
+  /* Next revision for which we expect a svn_repos_notify_verify_rev_end. */
+  svn_revnum_t expected_rev;
+
+  /* Set once we received svn_repos_notify_verify_end. */
+  svn_boolean_t done;
+} verify_notify_baton_t;
+
+/* Implements svn_repos_notify_func_t.  Check that revision notifications
+   arrive in order. */
+static void
+verify_notify(void *baton,
+              const svn_repos_notify_t *notify,
+              apr_pool_t *scratch_pool)
+{
+  verify_notify_baton_t *vnb = baton;
+
+  if (notify->action == svn_repos_notify_verify_rev_end)
+    {
+      /* Making the test fail is all we can do from here. */
+      if (notify->revision != vnb->expected_rev)
+        vnb->expected_rev = SVN_INVALID_REVNUM;
+      else
+        vnb->expected_rev++;
+    }
+  else if (notify->action == svn_repos_notify_verify_end)
+    {
+      vnb->done = TRUE;
+    }
+}
+
+static svn_error_t *
+test_verify_parallel(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  verify_notify_baton_t vnb;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-verify-parallel", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2 .. r20: modify iota. */
+  for (i = 2; i <= 20; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota in r%d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Verify with fewer jobs than revisions.  Notifications must arrive
+     in revision order. */
+  vnb.expected_rev = 0;
+  vnb.done = FALSE;
+  SVN_ERR(svn_repos_verify_fs4(repos, 0, youngest_rev, FALSE, FALSE, 3,
+                               verify_notify, &vnb, NULL, NULL, NULL, NULL,
+                               pool));
+  SVN_TEST_ASSERT(vnb.expected_rev == youngest_rev + 1);
+  SVN_TEST_ASSERT(vnb.done);
+
+  /* A sub-range, verified with more jobs than there are revisions. */
+  vnb.expected_rev = 5;
+  vnb.done = FALSE;
+  SVN_ERR(svn_repos_verify_fs4(repos, 5, 7, FALSE, FALSE, 8,
+                               verify_notify, &vnb, NULL, NULL, NULL, NULL,
+                               pool));
+  SVN_TEST_ASSERT(vnb.expected_rev == 8);
+  SVN_TEST_ASSERT(vnb.done);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_annotate_receiver_t.  Append REVISION to BATON,
+   an array of svn_revnum_t. */
+static svn_error_t *
+annotate_receiver(void *baton,
+                  apr_int64_t line_no,
+                  svn_revnum_t revision,
+                  const svn_string_t *line,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = baton;
+
+  SVN_TEST_ASSERT(line_no == revs->nelts);
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Annotate PATH in REVISION of REPOS, hiding the path DENY unless it is
+   NULL, and compare the line revisions with the COUNT elements of
+   EXPECTED. */
+static svn_error_t *
+verify_annotation_authz(svn_repos_t *repos,
+                        const char *path,
+                        svn_revnum_t revision,
+                        const char *deny,
+                        const svn_revnum_t *expected,
+                        int count,
+                        apr_pool_t *pool)
+{
+  apr_array_header_t *revs = apr_array_make(pool, count,
+                                            sizeof(svn_revnum_t));
+  struct authz_read_baton_t arb;
+  int i;
+
+  arb.paths = apr_hash_make(pool);
+  arb.pool = pool;
+  arb.deny = deny;
+  SVN_ERR(svn_repos_get_file_annotation(repos, path, revision,
+                                        deny ? authz_read_func : NULL,
+                                        &arb, annotate_receiver, revs,
+                                        NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(revs->nelts, count);
+  for (i = 0; i < count; i++)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), expected[i]);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like verify_annotation_authz() but without any path being hidden. */
+static svn_error_t *
+verify_annotation(svn_repos_t *repos,
+                  const char *path,
+                  svn_revnum_t revision,
+                  const svn_revnum_t *expected,
+                  int count,
+                  apr_pool_t *pool)
+{
+  return svn_error_trace(verify_annotation_authz(repos, path, revision,
+                                                 NULL, expected, count,
+                                                 pool));
+}
+
+static svn_error_t *
+test_get_file_annotation(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  static const svn_revnum_t iota_r3[] = { 2, 3, 2, 3 };
+  static const svn_revnum_t iota2_r5[] = { 5, 2, 3, 2, 3 };
+  static const svn_revnum_t iota2_r5_authz[] = { 5, 5, 5, 5, 5 };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-file-annotation",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: replace the contents of iota */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "line 1\nline 2\nline 3\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: modify one line and append another */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "line 1\nchanged 2\nline 3\nline 4\n",
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: property change only */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: copy and prepend a line */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "iota", txn_root, "iota2", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota2",
+                                      "line 0\nline 1\nchanged 2\n"
+                                      "line 3\nline 4\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Annotate the older location first, so the second call may start from
+     cached results, then repeat both. */
+  SVN_ERR(verify_annotation(repos, "/iota", 3, iota_r3,
+                            sizeof(iota_r3) / sizeof(iota_r3[0]), pool));
+  SVN_ERR(verify_annotation(repos, "/iota2", youngest_rev, iota2_r5,
+                            sizeof(iota2_r5) / sizeof(iota2_r5[0]), pool));
+  SVN_ERR(verify_annotation(repos, "/iota2", youngest_rev, iota2_r5,
+                            sizeof(iota2_r5) / sizeof(iota2_r5[0]), pool));
+  SVN_ERR(verify_annotation(repos, "/iota", 4, iota_r3,
+                            sizeof(iota_r3) / sizeof(iota_r3[0]), pool));
+
+  /* Without access to the copy source, all lines appear to have been
+     added by the copy.  Neither must the cached results leak into this
+     nor must this result end up in the cache. */
+  SVN_ERR(verify_annotation_authz(repos, "/iota2", youngest_rev, "/iota",
+                                  iota2_r5_authz,
+                                  sizeof(iota2_r5_authz)
+                                    / sizeof(iota2_r5_authz[0]),
+                                  pool));
+  SVN_ERR(verify_annotation(repos, "/iota2", youngest_rev, iota2_r5,
+                            sizeof(iota2_r5) / sizeof(iota2_r5[0]), pool));
+
+  /* Directories cannot be annotated. */
+  SVN_TEST_ASSERT_ERROR(verify_annotation(repos, "/A", youngest_rev,
+                                          NULL, 0, pool),
+                        SVN_ERR_FS_NOT_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the svn:date of revision REV in REPOS to DATE through the repos
+   layer, i.e. the way that keeps the revision date index up to date. */
+static svn_error_t *
+set_rev_date(svn_repos_t *repos,
+             svn_revnum_t rev,
+             const char *date,
+             apr_pool_t *pool)
+{
+  return svn_repos_fs_change_rev_prop4(repos, rev, NULL, SVN_PROP_REVISION_DATE,
+                                       NULL, svn_string_create(date, pool),
+                                       FALSE, FALSE, NULL, NULL, pool);
+}
+
+/* Check that svn_repos_dated_revision returns EXPECTED for DATE. */
+static svn_error_t *
+verify_dated_revision(svn_repos_t *repos,
+                      const char *date,
+                      svn_revnum_t expected,
+                      apr_pool_t *pool)
+{
+  apr_time_t tm;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_time_from_cstring(&tm, date, pool));
+  SVN_ERR(svn_repos_dated_revision(&rev, repos, tm, pool));
+  SVN_TEST_INT_ASSERT(rev, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dated_revision_index(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dated-revision-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1 .. r4, each adding a directory. */
+  for (i = 1; i <= 4; i++)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_fs_make_dir(txn_root, apr_psprintf(pool, "/A%d", i),
+                              pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  SVN_ERR(set_rev_date(repos, 0, "2009-01-01T00:00:00.000000Z", pool));
+  SVN_ERR(set_rev_date(repos, 1, "2010-01-01T00:00:00.000000Z", pool));
+  SVN_ERR(set_rev_date(repos, 2, "2011-01-01T00:00:00.000000Z", pool));
+  SVN_ERR(set_rev_date(repos, 3, "2012-01-01T00:00:00.000000Z", pool));
+  SVN_ERR(set_rev_date(repos, 4, "2013-01-01T00:00:00.000000Z", pool));
+
+  /* The first lookup builds the index, the second one uses it. */
+  for (i = 0; i < 2; i++)
+    {
+      SVN_ERR(verify_dated_revision(repos, "2008-01-01T00:00:00.000000Z",
+                                    0, pool));
+      SVN_ERR(verify_dated_revision(repos, "2011-01-01T00:00:00.000000Z",
+                                    2, pool));
+      SVN_ERR(verify_dated_revision(repos, "2011-06-01T00:00:00.000000Z",
+                                    2, pool));
+      SVN_ERR(verify_dated_revision(repos, "2020-01-01T00:00:00.000000Z",
+                                    4, pool));
+    }
+
+  /* Changes made through the repos layer update the index. */
+  SVN_ERR(set_rev_date(repos, 2, "2010-06-01T00:00:00.000000Z", pool));
+  SVN_ERR(verify_dated_revision(repos, "2011-06-01T00:00:00.000000Z",
+                                2, pool));
+  SVN_ERR(verify_dated_revision(repos, "2010-07-01T00:00:00.000000Z",
+                                2, pool));
+
+  /* Changes made behind the repos layer's back leave the index stale.
+     The result must still be correct. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs, 3, SVN_PROP_REVISION_DATE, NULL,
+                                  svn_string_create(
+                                    "2011-03-01T00:00:00.000000Z", pool),
+                                  pool));
+  SVN_ERR(verify_dated_revision(repos, "2011-06-01T00:00:00.000000Z",
+                                3, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit a revision to REPOS that adds the directory PATH. */
+static svn_error_t *
+commit_mkdir(svn_repos_t *repos,
+             const char *path,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_revnum_t youngest_rev;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, path, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOG to the lines that the hooks of test_async_post_commit() and
+   test_hook_plugin() recorded in REPOS. */
+static svn_error_t *
+read_hook_log(svn_stringbuf_t **log,
+              svn_repos_t *repos,
+              apr_pool_t *pool)
+{
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(log, svn_dirent_join(svn_repos_path(repos,
+                                                                     pool),
+                                                      "hook-log", pool),
+                                 pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *log = svn_stringbuf_create_empty(pool);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Set *KIND to the kind of the hook queue entry NAME in REPOS. */
+static svn_error_t *
+check_hook_queue_entry(svn_node_kind_t *kind,
+                       svn_repos_t *repos,
+                       const char *name,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_io_check_path(svn_dirent_join_many(pool,
+                                                  svn_repos_db_env(repos,
+                                                                   pool),
+                                                  "hook-queue", name,
+                                                  SVN_VA_NULL),
+                             kind, pool));
+}
+
+static svn_error_t *
+test_async_post_commit(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+#ifdef WIN32
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "test uses a shell script hook");
+#else
+  svn_repos_t *repos;
+  svn_stringbuf_t *log;
+  svn_node_kind_t kind;
+  const char *hook;
+  apr_time_t deadline;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-async-post-commit",
+                                 opts, pool));
+
+  SVN_ERR(svn_io_file_create(svn_dirent_join(svn_repos_conf_dir(repos, pool),
+                                             "hooks-env", pool),
+                             "[post-commit]" APR_EOL_STR
+                             SVN_REPOS_HOOK_ASYNC_OPTION " = yes"
+                             APR_EOL_STR,
+                             pool));
+  SVN_ERR(svn_repos_hooks_setenv(repos, NULL, pool));
+
+  /* Record all revisions but r2, whose hook always fails. */
+  hook = svn_repos_post_commit_hook(repos, pool);
+  SVN_ERR(svn_io_file_create(hook,
+                             "#!/bin/sh" APR_EOL_STR
+                             "test \"$2\" = 2 && exit 1" APR_EOL_STR
+                             "echo \"$2\" >> \"$1/hook-log\"" APR_EOL_STR,
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  /* Without a background queue, commits run the queued hooks before they
+     return. */
+  SVN_ERR(commit_mkdir(repos, "/A", pool));
+  SVN_ERR(read_hook_log(&log, repos, pool));
+  SVN_TEST_STRING_ASSERT(log->data, "1\n");
+  SVN_ERR(check_hook_queue_entry(&kind, repos, "post-commit-1", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* A hook that keeps failing is given up on and does not block the
+     following ones. */
+  SVN_ERR(commit_mkdir(repos, "/B", pool));
+  SVN_ERR(check_hook_queue_entry(&kind, repos, "post-commit-2", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(check_hook_queue_entry(&kind, repos, "post-commit-2.failed",
+                                 pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(commit_mkdir(repos, "/C", pool));
+  SVN_ERR(read_hook_log(&log, repos, pool));
+  SVN_TEST_STRING_ASSERT(log->data, "1\n3\n");
+
+  /* With the background queue, the hooks still run in revision order. */
+  SVN_ERR(svn_repos__hook_queue_start(pool));
+  SVN_ERR(commit_mkdir(repos, "/D", pool));
+  SVN_ERR(commit_mkdir(repos, "/E", pool));
+
+  deadline = apr_time_now() + apr_time_from_sec(60);
+  do
+    {
+      SVN_ERR(read_hook_log(&log, repos, pool));
+      SVN_ERR(check_hook_queue_entry(&kind, repos, "post-commit-5", pool));
+      if (kind == svn_node_none && strcmp(log->data, "1\n3\n4\n5\n") == 0)
+        break;
+
+      apr_sleep(apr_time_from_msec(10));
+    }
+  while (apr_time_now() < deadline);
+
+  SVN_TEST_STRING_ASSERT(log->data, "1\n3\n4\n5\n");
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Append LINE to the hook log of REPOS, as read by read_hook_log(). */
+static svn_error_t *
+append_hook_log(svn_repos_t *repos,
+                const char *line,
+                apr_pool_t *pool)
+{
+  apr_file_t *file;
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(svn_repos_path(repos, pool),
+                                           "hook-log", pool),
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, line, strlen(line), NULL, pool));
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+/* Implements the start_commit hook of svn_repos_hook_plugin_t. */
+static svn_error_t *
+plugin_start_commit(svn_repos_t *repos,
+                    const char *user,
+                    const apr_array_header_t *capabilities,
+                    const char *txn_name,
+                    void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(append_hook_log(repos,
+                                         apr_psprintf(scratch_pool,
+                                                      "start-commit %s\n",
+                                                      user),
+                                         scratch_pool));
+}
+
+/* Implements the pre_commit hook of svn_repos_hook_plugin_t.
+   Reject transactions that contain "/fail". */
+static svn_error_t *
+plugin_pre_commit(svn_repos_t *repos,
+                  svn_fs_txn_t *txn,
+                  apr_hash_t *lock_tokens,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+
+  SVN_ERR(append_hook_log(repos, "pre-commit\n", scratch_pool));
+
+  SVN_ERR(svn_fs_txn_root(&root, txn, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/fail", scratch_pool));
+  if (kind != svn_node_none)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL, "rejected");
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements the post_commit hook of svn_repos_hook_plugin_t. */
+static svn_error_t *
+plugin_post_commit(svn_repos_t *repos,
+                   svn_revnum_t rev,
+                   const char *txn_name,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(append_hook_log(repos,
+                                         apr_psprintf(scratch_pool,
+                                                      "post-commit %ld\n",
+                                                      rev),
+                                         scratch_pool));
+}
+
+/* Commit a revision by "jrandom" that adds the directory PATH to REPOS,
+   running all hooks. */
+static svn_error_t *
+commit_mkdir_with_hooks(svn_repos_t *repos,
+                        const char *path,
+                        apr_pool_t *pool)
+{
+  apr_hash_t *revprops = apr_hash_make(pool);
+  svn_revnum_t youngest_rev;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_error_t *err;
+
+  svn_hash_sets(revprops, SVN_PROP_REVISION_AUTHOR,
+                svn_string_create("jrandom", pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit3(&txn, repos, youngest_rev,
+                                             revprops, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, path, pool));
+
+  err = svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool);
+  if (err)
+    return svn_error_compose_create(err, svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the hooks-env of REPOS to use the hook plugin LIBPATH. */
+static svn_error_t *
+set_hook_plugin(svn_repos_t *repos,
+                const char *libpath,
+                apr_pool_t *pool)
+{
+  const char *path = svn_dirent_join(svn_repos_conf_dir(repos, pool),
+                                     "hooks-env", pool);
+
+  SVN_ERR(svn_io_remove_file2(path, TRUE, pool));
+  SVN_ERR(svn_io_file_create(path,
+                             apr_psprintf(pool,
+                                          "[default]" APR_EOL_STR
+                                          SVN_REPOS_HOOK_PLUGIN_OPTION
+                                          " = %s" APR_EOL_STR,
+                                          libpath),
+                             pool));
+
+  return svn_error_trace(svn_repos_hooks_setenv(repos, NULL, pool));
+}
+
+static svn_error_t *
+test_hook_plugin(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+#ifdef WIN32
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "test uses a shell script hook");
+#else
+  svn_repos_t *repos;
+  svn_repos_hook_plugin_t plugin = { 0 };
+  const char *libpath;
+  const char *hook;
+  svn_stringbuf_t *log;
+  svn_revnum_t youngest_rev;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-hook-plugin",
+                                 opts, pool));
+
+  /* Provide the plugin for a library next to the hook scripts. */
+  plugin.start_commit = plugin_start_commit;
+  plugin.pre_commit = plugin_pre_commit;
+  plugin.post_commit = plugin_post_commit;
+  SVN_ERR(svn_dirent_get_absolute(&libpath,
+                                  svn_dirent_join(svn_repos_hook_dir(repos,
+                                                                     pool),
+                                                  "test-plugin", pool),
+                                  pool));
+  SVN_ERR(svn_repos__hook_plugin_register(libpath, &plugin, pool));
+  SVN_ERR(set_hook_plugin(repos, "test-plugin", pool));
+
+  hook = svn_repos_pre_commit_hook(repos, pool);
+  SVN_ERR(svn_io_file_create(hook,
+                             "#!/bin/sh" APR_EOL_STR
+                             "echo pre-commit-script >> \"$1/hook-log\""
+                             APR_EOL_STR,
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  /* The plugin hooks run before the script of the same name. */
+  SVN_ERR(commit_mkdir_with_hooks(repos, "/A", pool));
+  SVN_ERR(read_hook_log(&log, repos, pool));
+  SVN_TEST_STRING_ASSERT(log->data,
+                         "start-commit jrandom\n"
+                         "pre-commit\n"
+                         "pre-commit-script\n"
+                         "post-commit 1\n");
+
+  /* A failing plugin rejects the commit like a failing script, and the
+     script does not run anymore. */
+  SVN_TEST_ASSERT_ERROR(commit_mkdir_with_hooks(repos, "/fail", pool),
+                        SVN_ERR_REPOS_HOOK_FAILURE);
+  SVN_ERR(read_hook_log(&log, repos, pool));
+  SVN_TEST_STRING_ASSERT(log->data,
+                         "start-commit jrandom\n"
+                         "pre-commit\n"
+                         "pre-commit-script\n"
+                         "post-commit 1\n"
+                         "start-commit jrandom\n"
+                         "pre-commit\n");
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 1);
+
+  /* A library that cannot be loaded blocks all commits. */
+  SVN_ERR(set_hook_plugin(repos, "no-such-plugin", pool));
+  SVN_TEST_ASSERT_ANY_ERROR(commit_mkdir_with_hooks(repos, "/B", pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 1);
+
+  /* Without a plugin, only the script runs. */
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(svn_repos_path(repos, pool),
+                                              "hook-log", pool),
+                              FALSE, pool));
+  SVN_ERR(set_hook_plugin(repos, "", pool));
+  SVN_ERR(commit_mkdir_with_hooks(repos, "/B", pool));
+  SVN_ERR(read_hook_log(&log, repos, pool));
+  SVN_TEST_STRING_ASSERT(log->data, "pre-commit-script\n");
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Implements svn_repos_log_entry_receiver_t.  Append the revision of
+   LOG_ENTRY to BATON, an array of svn_revnum_t. */
+static svn_error_t *
+log_revision_receiver(void *baton,
+                      svn_repos_log_entry_t *log_entry,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = baton;
+
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = log_entry->revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run a log on PATHS in REPOS from HEAD down to r0 with up to LIMIT
+   entries, hiding the path DENY unless it is NULL.  Compare the
+   revisions reported with EXPECTED. */
+static svn_error_t *
+verify_multi_path_log(svn_repos_t *repos,
+                      const apr_array_header_t *paths,
+                      int limit,
+                      const char *deny,
+                      const apr_array_header_t *expected,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *revs = apr_array_make(pool, expected->nelts,
+                                            sizeof(svn_revnum_t));
+  struct authz_read_baton_t arb;
+  int i;
+
+  arb.paths = apr_hash_make(pool);
+  arb.pool = pool;
+  arb.deny = deny;
+  SVN_ERR(svn_repos_get_logs5(repos, paths, SVN_INVALID_REVNUM, 0, limit,
+                              FALSE, FALSE, NULL,
+                              deny ? authz_read_func : NULL, &arb,
+                              NULL, NULL, log_revision_receiver, revs,
+                              pool));
+
+  SVN_TEST_INT_ASSERT(revs->nelts, expected->nelts);
+  for (i = 0; i < expected->nelts; i++)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t),
+                        APR_ARRAY_IDX(expected, i, svn_revnum_t));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_logs_multi_path(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_array_header_t *paths = apr_array_make(pool, 5, sizeof(const char *));
+  apr_array_header_t *expected = apr_array_make(pool, 80,
+                                                sizeof(svn_revnum_t));
+  apr_array_header_t *expected_authz = apr_array_make(pool, 80,
+                                                      sizeof(svn_revnum_t));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+  int i;
+
+  /* Enough paths to have their histories fetched concurrently. */
+  APR_ARRAY_PUSH(paths, const char *) = "/iota";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/mu";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/B/lambda";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D/gamma";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/pi2";
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-multi-path",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: Tweak iota and A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "r2", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: Tweak A/D/G/pi, which is only part of A/pi2's history. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "r3", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: Copy A/D/G/pi to A/pi2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D/G/pi", txn_root, "A/pi2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: Tweak A/B/lambda and A/D/gamma. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/lambda", "r5", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/gamma", "r5", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r6 .. r75: Tweak A/pi2 more often than fits into a single history
+     batch. */
+  for (i = 0; i < 70; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/pi2",
+                                          apr_psprintf(iterpool, "%d", i),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Without authz, every revision touches one of the PATHS.  With
+     A/D/G/pi being hidden, A/pi2's history ends at the copy. */
+  for (rev = youngest_rev; rev > 0; rev--)
+    {
+      APR_ARRAY_PUSH(expected, svn_revnum_t) = rev;
+      if (rev != 3)
+        APR_ARRAY_PUSH(expected_authz, svn_revnum_t) = rev;
+    }
+
+  SVN_ERR(verify_multi_path_log(repos, paths, 0, NULL, expected, pool));
+  SVN_ERR(verify_multi_path_log(repos, paths, 0, "/A/D/G/pi",
+                                expected_authz, pool));
+
+  /* Stop while histories are still being fetched. */
+  expected->nelts = 3;
+  SVN_ERR(verify_multi_path_log(repos, paths, 3, NULL, expected, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a mergeinfo catalog mapping "/A" to MERGEINFO. */
+static svn_error_t *
+make_catalog(svn_mergeinfo_catalog_t *catalog,
+             const char *mergeinfo,
+             apr_pool_t *pool)
+{
+  svn_mergeinfo_t parsed;
+
+  SVN_ERR(svn_mergeinfo_parse(&parsed, mergeinfo, pool));
+  *catalog = svn_hash__make(pool);
+  svn_hash_sets(*catalog, "/A", parsed);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that CACHE has recorded ADDED as the mergeinfo added to "/A" in
+   REV, or nothing at all if ADDED is NULL. */
+static svn_error_t *
+verify_cached_mergeinfo(svn_repos__mergeinfo_cache_t *cache,
+                        svn_revnum_t rev,
+                        const char *added,
+                        apr_pool_t *pool)
+{
+  svn_mergeinfo_catalog_t deleted_catalog, added_catalog;
+  svn_string_t *mergeinfo;
+
+  SVN_ERR(svn_repos__mergeinfo_cache_get(&deleted_catalog, &added_catalog,
+                                         cache, rev, pool, pool));
+  if (!added)
+    {
+      SVN_TEST_ASSERT(!deleted_catalog && !added_catalog);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_TEST_ASSERT(deleted_catalog && added_catalog);
+  SVN_TEST_INT_ASSERT(apr_hash_count(deleted_catalog), 0);
+  SVN_TEST_INT_ASSERT(apr_hash_count(added_catalog), 1);
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo,
+                                  svn_hash_gets(added_catalog, "/A"),
+                                  pool));
+  SVN_TEST_STRING_ASSERT(mergeinfo->data, added);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record "/B:REV" as the mergeinfo added in REV to CACHE. */
+static svn_error_t *
+set_cached_mergeinfo(svn_repos__mergeinfo_cache_t *cache,
+                     svn_revnum_t rev,
+                     apr_pool_t *pool)
+{
+  svn_mergeinfo_catalog_t added;
+
+  SVN_ERR(make_catalog(&added, apr_psprintf(pool, "/B:%ld", rev), pool));
+  SVN_ERR(svn_repos__mergeinfo_cache_set(cache, rev, svn_hash__make(pool),
+                                         added, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_mergeinfo_cache_invalidation(const svn_test_opts_t *opts,
+                                  apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_repos__mergeinfo_cache_t *cache;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-mergeinfo-cache",
+                                 opts, pool));
+  SVN_ERR(commit_mkdir(repos, "A", pool));
+  SVN_ERR(commit_mkdir(repos, "B", pool));
+
+  SVN_ERR(svn_repos__mergeinfo_cache_open(&cache, repos, pool, pool));
+  SVN_TEST_ASSERT(cache);
+  SVN_ERR(verify_cached_mergeinfo(cache, 1, NULL, pool));
+
+  SVN_ERR(set_cached_mergeinfo(cache, 1, pool));
+  SVN_ERR(set_cached_mergeinfo(cache, 2, pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, 1, "/B:1", pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, 2, "/B:2", pool));
+
+  /* A new date means the revision may have been replaced, e.g. by
+     loading a different dump into a restored backup.  Ignore the old
+     entry, no matter whether it was changed through the repos layer or
+     behind its back. */
+  SVN_ERR(set_rev_date(repos, 1, "2010-01-01T00:00:00.000000Z", pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, 1, NULL, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), 2,
+                                  SVN_PROP_REVISION_DATE, NULL,
+                                  svn_string_create(
+                                    "2011-01-01T00:00:00.000000Z", pool),
+                                  pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, 2, NULL, pool));
+
+  /* Recording the revision again makes it valid again. */
+  SVN_ERR(set_cached_mergeinfo(cache, 1, pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, 1, "/B:1", pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton of mergeinfo_cache_task(). */
+typedef struct mergeinfo_cache_task_t
+{
+  /* Path of the repository to open. */
+  const char *repos_path;
+
+  /* Revision to record and read back. */
+  svn_revnum_t rev;
+} mergeinfo_cache_task_t;
+
+/* Implements svn_task__process_func_t.  Open the mergeinfo cache of the
+   repository given by the mergeinfo_cache_task_t in PROCESS_BATON,
+   record its revision and read it back. */
+static svn_error_t *
+mergeinfo_cache_task(void **result,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  mergeinfo_cache_task_t *task = process_baton;
+  svn_repos_t *repos;
+  svn_repos__mergeinfo_cache_t *cache;
+
+  SVN_ERR(svn_repos_open3(&repos, task->repos_path, NULL, scratch_pool,
+                          scratch_pool));
+  SVN_ERR(svn_repos__mergeinfo_cache_open(&cache, repos, scratch_pool,
+                                          scratch_pool));
+  SVN_TEST_ASSERT(cache);
+
+  SVN_ERR(set_cached_mergeinfo(cache, task->rev, scratch_pool));
+  SVN_ERR(verify_cached_mergeinfo(cache, task->rev,
+                                  apr_psprintf(scratch_pool, "/B:%ld",
+                                               task->rev),
+                                  scratch_pool));
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+#define MERGEINFO_CACHE_WRITERS 8
+
+static svn_error_t *
+test_mergeinfo_cache_concurrent(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  const char *repos_path = "test-repo-mergeinfo-cache-concurrent";
+  svn_repos_t *repos;
+  svn_repos__mergeinfo_cache_t *cache;
+  svn_task__set_t *set;
+  svn_revnum_t rev;
+
+  if (svn_task__get_thread_limit() == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "concurrent writers need worker threads");
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_path, opts, pool));
+  for (rev = 1; rev <= MERGEINFO_CACHE_WRITERS; rev++)
+    SVN_ERR(commit_mkdir(repos, apr_psprintf(pool, "A%ld", rev), pool));
+
+  /* Create the database before the writers race for it. */
+  SVN_ERR(svn_repos__mergeinfo_cache_open(&cache, repos, pool, pool));
+  SVN_TEST_ASSERT(cache);
+
+  /* Each writer uses its own connection to the database. */
+  SVN_ERR(svn_task__set_create(&set, MERGEINFO_CACHE_WRITERS, NULL, NULL,
+                               NULL, NULL, pool));
+  for (rev = 1; rev <= MERGEINFO_CACHE_WRITERS; rev++)
+    {
+      mergeinfo_cache_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      task->repos_path = repos_path;
+      task->rev = rev;
+      SVN_ERR(svn_task__add(set, mergeinfo_cache_task, task));
+    }
+  SVN_ERR(svn_task__set_finish(set));
+
+  /* All records must be visible through the older connection, too. */
+  for (rev = 1; rev <= MERGEINFO_CACHE_WRITERS; rev++)
+    SVN_ERR(verify_cached_mergeinfo(cache, rev,
+                                    apr_psprintf(pool, "/B:%ld", rev),
+                                    pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef MERGEINFO_CACHE_WRITERS
+
+static svn_error_t *
+test_mergeinfo_cache_corrupt(const svn_test_opts_t *opts,
+                             apr_pool_t *pool)
+{
+  const char *garbage = "This is not an SQLite database.\n";
+  svn_repos_t *repos;
+  svn_repos__mergeinfo_cache_t *cache;
+  const char *db_path;
+  apr_array_header_t *paths;
+  apr_array_header_t *revs;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-mergeinfo-cache-corrupt",
+                                 opts, pool));
+  SVN_ERR(commit_mkdir(repos, "A", pool));
+
+  db_path = svn_dirent_join(svn_repos_db_env(repos, pool),
+                            SVN_REPOS__MERGEINFO_CACHE_DB, pool);
+  SVN_ERR(svn_io_write_atomic2(db_path, garbage, strlen(garbage), NULL,
+                               FALSE, pool));
+
+  /* A broken database just means that there is no cache. */
+  SVN_ERR(svn_repos__mergeinfo_cache_open(&cache, repos, pool, pool));
+  SVN_TEST_ASSERT(!cache);
+
+  /* Merge-tracking logs work without it. */
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/";
+  revs = apr_array_make(pool, 1, sizeof(svn_revnum_t));
+  SVN_ERR(svn_repos_get_logs5(repos, paths, 1, 1, 0, FALSE, TRUE, NULL,
+                              NULL, NULL, NULL, NULL,
+                              log_revision_receiver, revs, pool));
+  SVN_TEST_INT_ASSERT(revs->nelts, 1);
+  SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, 0, svn_revnum_t), 1);
+
+  /* The database file is left alone. */
+  SVN_ERR(svn_stringbuf_from_file2(&contents, db_path, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, garbage);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_fs_pool(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_repos__fs_pool_t *fs_pool;
+  svn_fs_t *fs1, *fs2, *fs3;
+  svn_revnum_t youngest;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-fs-pool", opts, pool));
+  SVN_ERR(commit_mkdir(repos, "A", pool));
+
+  SVN_ERR(svn_repos__fs_pool_create(&fs_pool, svn_repos_fs(repos),
+                                    subpool));
+
+  /* Instances in use are never handed out twice. */
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs1, fs_pool));
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs2, fs_pool));
+  SVN_TEST_ASSERT(fs1 != fs2);
+  SVN_TEST_ASSERT(fs1 != svn_repos_fs(repos));
+
+  /* They are separate instances of the same repository. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs2, pool));
+  SVN_TEST_INT_ASSERT(youngest, 1);
+  SVN_TEST_STRING_ASSERT(svn_fs_path(fs2, pool),
+                         svn_fs_path(svn_repos_fs(repos), pool));
+
+  /* Released instances get reused. */
+  SVN_ERR(svn_repos__fs_pool_release(fs_pool, fs1));
+  SVN_ERR(svn_repos__fs_pool_acquire(&fs3, fs_pool));
+  SVN_TEST_ASSERT(fs3 == fs1);
+
+  SVN_ERR(svn_repos__fs_pool_release(fs_pool, fs2));
+  SVN_ERR(svn_repos__fs_pool_release(fs_pool, fs3));
+
+  /* This closes the instances. */
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4501,6 +5840,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_delta_jobs,
+                       "test reporter computing deltas concurrently"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
@@ -4517,6 +5858,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_info_*"),
     SVN_TEST_OPTS_PASS(test_config_pool,
                        "test svn_repos__config_pool_*"),
+    SVN_TEST_OPTS_PASS(test_config_pool_file_changes,
+                       "test config pool with modified files"),
     SVN_TEST_OPTS_PASS(test_repos_fs_type,
                        "test test_repos_fs_type"),
     SVN_TEST_OPTS_PASS(deprecated_access_context_api,
@@ -4537,6 +5880,28 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_list_parallel,
+                       "test svn_repos__list with multiple jobs"),
+    SVN_TEST_OPTS_PASS(test_verify_parallel,
+                       "test svn_repos_verify_fs4 with multiple jobs"),
+    SVN_TEST_OPTS_PASS(test_get_file_annotation,
+                       "test svn_repos_get_file_annotation"),
+    SVN_TEST_OPTS_PASS(test_dated_revision_index,
+                       "test svn_repos_dated_revision with a date index"),
+    SVN_TEST_OPTS_PASS(test_async_post_commit,
+                       "test queued post-commit hooks"),
+    SVN_TEST_OPTS_PASS(test_hook_plugin,
+                       "test in-process hook plugins"),
+    SVN_TEST_OPTS_PASS(test_get_logs_multi_path,
+                       "test svn_repos_get_logs5 with many paths"),
+    SVN_TEST_OPTS_PASS(test_mergeinfo_cache_invalidation,
+                       "test mergeinfo cache invalidation"),
+    SVN_TEST_OPTS_PASS(test_mergeinfo_cache_concurrent,
+                       "test concurrent mergeinfo cache writers"),
+    SVN_TEST_OPTS_PASS(test_mergeinfo_cache_corrupt,
+                       "test a corrupt mergeinfo cache database"),
+    SVN_TEST_OPTS_PASS(test_fs_pool,
+                       "test the FS instance pool for tasks"),
     SVN_TEST_NULL
   };
 
@@ -27,6 +27,7 @@
 #include <apr_lib.h>
 #include <apr_time.h>
 
+#include "svn_io.h"
 #include "svn_pools.h"
 
 #include "private/svn_cache.h"
@@ -175,6 +176,70 @@ test_inprocess_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, TRUE, pool);
 }
 
+static svn_error_t *
+test_sharded_cache_basic(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+
+  /* Create a cache with just one entry. */
+  SVN_ERR(svn_cache__create_sharded(&cache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    0, 1, 0,
+                                    TRUE,
+                                    "",
+                                    pool));
+
+  return basic_cache_test(cache, TRUE, pool);
+}
+
+static svn_error_t *
+test_sharded_cache_limits(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_cache__info_t info;
+  svn_revnum_t rev = 42, *answer;
+  svn_boolean_t found;
+  int i;
+
+  /* A single shard with room for 8 revnums. */
+  SVN_ERR(svn_cache__create_sharded(&cache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    1, 0, 8 * sizeof(svn_revnum_t),
+                                    FALSE,
+                                    "limits",
+                                    pool));
+
+  for (i = 0; i < 20; ++i)
+    SVN_ERR(svn_cache__set(cache, apr_psprintf(pool, "%d", i), &rev, pool));
+
+  /* Only the 8 most recently added entries may remain. */
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "19", pool));
+  if (! found || *answer != 42)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "most recent entry has been evicted");
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "0", pool));
+  if (found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "least recent entry has not been evicted");
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  if (info.used_entries != 8 || info.l2_evictions != 12)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "expected 8 entries and 12 evictions, "
+                             "found %" APR_UINT64_T_FMT " and %"
+                             APR_UINT64_T_FMT,
+                             info.used_entries, info.l2_evictions);
+  if (info.total_size < 8 * sizeof(svn_revnum_t))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "size limit not reported");
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_memcache_basic(const svn_test_opts_t *opts,
                     apr_pool_t *pool)
@@ -194,6 +259,7 @@ test_memcache_basic(const svn_test_opts_t *opts,
   /* Create a memcache-based cache. */
   SVN_ERR(svn_cache__create_memcache(&cache,
                                     memcache,
+                                    NULL,
                                     serialize_revnum,
                                     deserialize_revnum,
                                     APR_HASH_KEY_STRING,
@@ -209,7 +275,7 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   svn_cache__t *cache;
   svn_membuffer_t *membuffer;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -220,6 +286,7 @@ test_membuffer_cache_basic(apr_pool_t *pool)
                                             APR_HASH_KEY_STRING,
                                             "cache:",
                                             SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
                                             FALSE,
                                             FALSE,
                                             pool, pool));
@@ -227,6 +294,50 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_membuffer_cache_lock_stripes(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_revnum_t twenty = 20;
+  svn_boolean_t found;
+  void *val;
+
+  /* Use multiple read locks per segment and non-blocking writes. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 8,
+                                            TRUE, FALSE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* Writers must acquire and release all stripes. */
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__get(&val, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found && *(svn_revnum_t *)val == 20);
+
+  SVN_ERR(svn_cache__membuffer_clear(membuffer));
+  SVN_ERR(svn_cache__get(&val, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* The cache must still be writable after the clearing. */
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__get(&val, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found && *(svn_revnum_t *)val == 20);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 raise_error_deserialize_func(void **out,
@@ -267,7 +378,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
   svn_boolean_t found;
   void *val;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -278,6 +389,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
                                             APR_HASH_KEY_STRING,
                                             "cache:",
                                             SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
                                             FALSE,
                                             FALSE,
                                             pool, pool));
@@ -299,7 +411,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
     APR_EGENERAL);
 
   /* Create a new cache. */
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
@@ -308,6 +420,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
                                             APR_HASH_KEY_STRING,
                                             "cache:",
                                             SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
                                             FALSE,
                                             FALSE,
                                             pool, pool));
@@ -356,6 +469,7 @@ test_memcache_long_key(const svn_test_opts_t *opts,
   /* Create a memcache-based cache. */
   SVN_ERR(svn_cache__create_memcache(&cache,
                                     memcache,
+                                    NULL,
                                     serialize_revnum,
                                     deserialize_revnum,
                                     APR_HASH_KEY_STRING,
@@ -386,7 +500,7 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
   svn_revnum_t valueB = 67890;
 
   /* Create a simple cache for strings, keyed by strings. */
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
@@ -395,6 +509,7 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
                                             APR_HASH_KEY_STRING,
                                             "cache:",
                                             SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
                                             FALSE,
                                             FALSE,
                                             pool, pool));
@@ -504,14 +619,15 @@ test_membuffer_unaligned_string_keys(apr_pool_t *pool)
   const char *unaligned_key = apr_pstrdup(pool, "_fifty") + 1;
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
             &cache, membuffer, serialize_revnum, deserialize_revnum,
             APR_HASH_KEY_STRING, unaligned_prefix,
-            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            svn_cache__admission_default, FALSE, FALSE,
             pool, pool));
 
   SVN_ERR(svn_cache__set(cache, unaligned_key, &fifty, pool));
@@ -554,7 +670,7 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   const char *unaligned_key = apr_pstrdup(pool, "_12345678") + 1;
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -562,7 +678,8 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
             &cache, membuffer, serialize_revnum, deserialize_revnum,
             8 /* klen*/,
             unaligned_prefix,
-            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            svn_cache__admission_default, FALSE, FALSE,
             pool, pool));
 
   SVN_ERR(svn_cache__set(cache, unaligned_key, &fifty, pool));
@@ -590,6 +707,406 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write COUNT distinct items of ITEM_SIZE bytes each to CACHE without
+ * reading them back.  Use POOL for temporaries.
+ */
+static svn_error_t *
+scan_through_cache(svn_cache__t *cache,
+                   int count,
+                   apr_size_t item_size,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *item = svn_stringbuf_create_ensure(item_size, pool);
+  int i;
+
+  memset(item->data, 'x', item_size);
+  item->len = item_size;
+  item->data[item_size] = '\0';
+
+  for (i = 0; i < count; ++i)
+    {
+      const char *key;
+
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "scan %d", i);
+      SVN_ERR(svn_cache__set(cache, key, item, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_scan_resistance(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_cache__info_t info;
+  svn_stringbuf_t *hot = svn_stringbuf_create("hot item", pool);
+  svn_stringbuf_t *value;
+  svn_boolean_t found;
+
+  /* A scan through a default cache promotes items to L2. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024,
+                                            256 * 1024, 1, 1,
+                                            FALSE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(scan_through_cache(cache, 1000, 1000, pool));
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.promotions > 0);
+  SVN_TEST_ASSERT(info.rejections == 0);
+
+  /* With the scan-resistant policy, items written only once do not get
+   * into L2 while items written repeatedly do and survive the scan. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024,
+                                            256 * 1024, 1, 1,
+                                            FALSE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_scan_resistant,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__set(cache, "hot", hot, pool));
+  SVN_ERR(svn_cache__set(cache, "hot", hot, pool));
+  SVN_ERR(scan_through_cache(cache, 1000, 1000, pool));
+
+  /* Collisions in the frequency sketch may let a few scanned items slip
+   * through but the vast majority must be rejected. */
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.promotions >= 1);
+  SVN_TEST_ASSERT(info.promotions * 4 < info.rejections);
+
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, "hot", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value->data, hot->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_error_t *err;
+
+  /* Anonymous shared memory is good enough for a single process. */
+  err = svn_cache__membuffer_cache_create_shared(&membuffer, 64*1024,
+                                                 0, 1, NULL, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory caches not supported");
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return basic_cache_test(cache, FALSE, pool);
+}
+
+/* Store and look up a batch of revnums in CACHE using the multi-key API.
+ * The keys must be C strings. */
+static svn_error_t *
+batch_cache_test(svn_cache__t *cache,
+                 apr_pool_t *pool)
+{
+  enum { COUNT = 100, STORED = 64, NO_KEY = 10 };
+  const void *keys[COUNT];
+  void *values[COUNT];
+  svn_boolean_t found[COUNT];
+  svn_revnum_t revs[COUNT];
+  int i;
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      revs[i] = i;
+      values[i] = &revs[i];
+      keys[i] = i == NO_KEY ? NULL : apr_psprintf(pool, "key-%d", i);
+    }
+
+  /* Store the first items only.  NULL keys must be ignored. */
+  SVN_ERR(svn_cache__set_many(cache, keys, values, STORED, pool));
+
+  /* Look them all up. */
+  SVN_ERR(svn_cache__get_many(values, found, cache, keys, COUNT,
+                              pool, pool));
+
+  for (i = 0; i < COUNT; ++i)
+    if (i < STORED && i != NO_KEY)
+      {
+        if (!found[i])
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "item %d not found", i);
+        if (*(svn_revnum_t *)values[i] != i)
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "wrong value for item %d: %ld", i,
+                                   *(svn_revnum_t *)values[i]);
+      }
+    else if (found[i] || values[i])
+      {
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "unexpected item %d found", i);
+      }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_memcache_many(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_cache__t *near_cache;
+  svn_membuffer_t *membuffer;
+  svn_memcache_t *memcache = NULL;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_many-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  SVN_ERR(create_memcache(&memcache, opts, pool, pool));
+  if (! memcache)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  /* Batch access through memcached alone. */
+  SVN_ERR(svn_cache__create_memcache(&cache,
+                                    memcache,
+                                    NULL,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    prefix,
+                                    pool));
+  SVN_ERR(batch_cache_test(cache, pool));
+
+  /* Same with a near cache that does not know any of the items yet. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 0, 1, 1,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&near_cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            prefix,
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(svn_cache__create_memcache(&cache,
+                                    memcache,
+                                    near_cache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    prefix,
+                                    pool));
+
+  return batch_cache_test(cache, pool);
+}
+
+static svn_error_t *
+test_memcache_async_writes(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  apr_pool_t *writer_pool = svn_pool_create(pool);
+  svn_config_t *config;
+  svn_cache__t *cache;
+  svn_memcache_t *memcache;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_async-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+  svn_revnum_t *answer;
+  svn_boolean_t found;
+  int i;
+
+  if (! opts->memcached_server)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CACHE_CONFIG_CATEGORY_MEMCACHED_SERVERS,
+                 "key" /* some value; ignored*/,
+                 opts->memcached_server);
+  svn_config_set_bool(config, SVN_CACHE_CONFIG_CATEGORY_MEMCACHED,
+                      SVN_CACHE_CONFIG_OPTION_ASYNC_WRITES, TRUE);
+
+  SVN_ERR(svn_cache__make_memcache_from_config(&memcache, config,
+                                               writer_pool, pool));
+  SVN_ERR(svn_cache__create_memcache(&cache, memcache, NULL,
+                                    serialize_revnum, deserialize_revnum,
+                                    APR_HASH_KEY_STRING, prefix,
+                                    writer_pool));
+
+  /* Few enough writes to fit into the queue. */
+  for (i = 0; i < 100; ++i)
+    {
+      svn_revnum_t rev = i;
+      SVN_ERR(svn_cache__set(cache, apr_psprintf(pool, "%d", i), &rev,
+                             pool));
+    }
+
+  /* Destroying the server set flushes all queued writes. */
+  svn_pool_destroy(writer_pool);
+
+  /* Read them back synchronously. */
+  SVN_ERR(create_memcache(&memcache, opts, pool, pool));
+  SVN_ERR(svn_cache__create_memcache(&cache, memcache, NULL,
+                                    serialize_revnum, deserialize_revnum,
+                                    APR_HASH_KEY_STRING, prefix, pool));
+  for (i = 0; i < 100; ++i)
+    {
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache,
+                             apr_psprintf(pool, "%d", i), pool));
+      if (! found || *answer != i)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "asynchronous write %d got lost", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_inprocess_cache_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+
+  SVN_ERR(svn_cache__create_inprocess(&cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      16, 8, TRUE, "", pool));
+
+  return batch_cache_test(cache, pool);
+}
+
+static svn_error_t *
+test_sharded_cache_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+
+  SVN_ERR(svn_cache__create_sharded(&cache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    4, 1000, 0, TRUE, "", pool));
+
+  return batch_cache_test(cache, pool);
+}
+
+static svn_error_t *
+test_membuffer_cache_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  /* Use multiple segments such that keys get spread over them. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 0, 4, 1,
+                                            TRUE, TRUE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  return batch_cache_test(cache, pool);
+}
+
+/* Create a persistent cache in *CACHE_P for revnums with string keys,
+ * backed by the store file at PATH valid for TAG and GENERATION.
+ * Allocate it in POOL. */
+static svn_error_t *
+create_persistent_cache(svn_cache__t **cache_p,
+                        const char *path,
+                        const char *tag,
+                        apr_uint64_t generation,
+                        apr_pool_t *pool)
+{
+  svn_cache__t *memory_cache;
+  svn_cache__persistent_t *store;
+
+  SVN_ERR(svn_cache__create_inprocess(&memory_cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      16, 8, FALSE, "", pool));
+  SVN_ERR(svn_cache__get_persistent_store(&store, path, tag, generation,
+                                          0x10000, pool));
+
+  return svn_cache__create_persistent(cache_p, memory_cache, store,
+                                      serialize_revnum, deserialize_revnum,
+                                      APR_HASH_KEY_STRING, "cache:", pool);
+}
+
+static svn_error_t *
+test_persistent_cache(apr_pool_t *pool)
+{
+  const char *path = svn_test_data_path("cache-test-persistent", pool);
+  svn_cache__t *cache;
+  svn_revnum_t thirty = 30, *answer;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_io_remove_file2(path, TRUE, pool));
+
+  SVN_ERR(create_persistent_cache(&cache, path, "tag1", 10, pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* A fresh in-memory cache will be filled from disk.  Later generations
+   * keep the data. */
+  SVN_ERR(create_persistent_cache(&cache, path, "tag1", 12, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  if (! found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "item not found in persistent cache");
+  if (*answer != 30)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "expected 30 but found '%ld'", *answer);
+
+  /* Going back to an earlier generation invalidates the whole file. */
+  SVN_ERR(create_persistent_cache(&cache, path, "tag1", 11, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  if (found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "item of a later generation found in "
+                            "persistent cache");
+
+  /* So does a different tag. */
+  SVN_ERR(create_persistent_cache(&cache, path, "tag1", 11, pool));
+  SVN_ERR(svn_cache__set(cache, "thirty", &thirty, pool));
+  SVN_ERR(create_persistent_cache(&cache, path, "tag2", 11, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  if (found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "stale item found in persistent cache");
+
+  return svn_io_remove_file2(path, TRUE, pool);
+}
+
 
 /* The test table.  */
 
@@ -616,6 +1133,28 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_cache_lock_stripes,
+                   "test membuffer cache with multiple lock stripes"),
+    SVN_TEST_PASS2(test_membuffer_cache_scan_resistance,
+                   "test scan-resistant membuffer cache admission"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared,
+                   "test shared memory membuffer cache"),
+    SVN_TEST_PASS2(test_inprocess_cache_many,
+                   "test inprocess cache multi-key access"),
+    SVN_TEST_PASS2(test_membuffer_cache_many,
+                   "test membuffer cache multi-key access"),
+    SVN_TEST_PASS2(test_persistent_cache,
+                   "test persistent cache tier"),
+    SVN_TEST_OPTS_PASS(test_memcache_many,
+                       "test memcache multi-key access"),
+    SVN_TEST_OPTS_PASS(test_memcache_async_writes,
+                       "test memcache asynchronous writes"),
+    SVN_TEST_PASS2(test_sharded_cache_basic,
+                   "basic sharded svn_cache test"),
+    SVN_TEST_PASS2(test_sharded_cache_limits,
+                   "test sharded cache eviction and limits"),
+    SVN_TEST_PASS2(test_sharded_cache_many,
+                   "test sharded cache multi-key access"),
     SVN_TEST_NULL
   };
 
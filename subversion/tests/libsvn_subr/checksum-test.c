@@ -26,7 +26,11 @@
 #include <zlib.h>
 
 #include "svn_error.h"
+#include "svn_hash.h"
 #include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +368,373 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Fill a new buffer of LEN bytes with arbitrary but reproducible data.
+ * Allocate it in POOL. */
+static unsigned char *
+make_test_data(apr_size_t len,
+               apr_pool_t *pool)
+{
+  unsigned char *data = apr_palloc(pool, len);
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    data[i] = (unsigned char)(i * 7 + (i >> 8));
+
+  return data;
+}
+
+static svn_error_t *
+test_sha1_vectors(apr_pool_t *pool)
+{
+  /* The FIPS 180 test vectors. */
+  static const char *const expected[] = {
+    "a9993e364706816aba3e25717850c26c9cd0d89d",
+    "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+    "34aa973cd4c4daa4f61eeb2bdbad27316534016f"
+  };
+  const char *abc = "abc";
+  const char *abcdb = "abcdbcdecdefdefgefghfghighijhij"
+                      "kijkljklmklmnlmnomnopnopq";
+  char *million_a = apr_palloc(pool, 1000000);
+  svn_checksum_t *checksum;
+
+  memset(million_a, 'a', 1000000);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, abc, strlen(abc),
+                       pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                         expected[0]);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, abcdb, strlen(abcdb),
+                       pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                         expected[1]);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, million_a, 1000000,
+                       pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                         expected[2]);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksum_ctx_split(apr_pool_t *pool)
+{
+  /* Cover all partial block sizes and a few multi-block updates. */
+  apr_size_t max_len = 300;
+  unsigned char *data = make_test_data(max_len, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t len;
+
+  for (len = 0; len <= max_len; ++len)
+    {
+      svn_checksum_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      for (kind = svn_checksum_md5; kind <= svn_checksum_sha1; ++kind)
+        {
+          svn_checksum_t *expected;
+          svn_checksum_t *actual;
+          svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(kind, iterpool);
+          apr_size_t pos = 0;
+          apr_size_t step = 1;
+
+          SVN_ERR(svn_checksum(&expected, kind, data, len, iterpool));
+
+          /* Feed the data in growing, odd-sized chunks. */
+          while (pos < len)
+            {
+              apr_size_t chunk = MIN(step, len - pos);
+              SVN_ERR(svn_checksum_update(ctx, data + pos, chunk));
+              pos += chunk;
+              step = step * 2 + 1;
+            }
+
+          SVN_ERR(svn_checksum_final(&actual, ctx, iterpool));
+          SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_md5_sha1_ctx(apr_pool_t *pool)
+{
+  static const apr_size_t lengths[] = { 0, 1, 63, 64, 65, 4095, 4096, 4097,
+                                        100000 };
+  unsigned char *data = make_test_data(100000, pool);
+  svn_checksum__md5_sha1_ctx_t *ctx = svn_checksum__md5_sha1_ctx_create(pool);
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+      svn_checksum_t *expected_md5, *expected_sha1;
+      svn_checksum_t *md5, *sha1;
+
+      SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5, data,
+                           lengths[i], pool));
+      SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1, data,
+                           lengths[i], pool));
+
+      /* Also split the data into two updates. */
+      svn_checksum__md5_sha1_ctx_reset(ctx);
+      svn_checksum__md5_sha1_update(ctx, data, lengths[i] / 3);
+      svn_checksum__md5_sha1_update(ctx, data + lengths[i] / 3,
+                                    lengths[i] - lengths[i] / 3);
+      svn_checksum__md5_sha1_final(&md5, &sha1, ctx, pool);
+
+      SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5));
+      SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_md5_sha1_stream(apr_pool_t *pool)
+{
+  const svn_string_t *str = svn_string_create("abcde", pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *expected_md5, *expected_sha1;
+  svn_checksum_t *md5, *sha1;
+  svn_stream_t *stream;
+  apr_size_t len = str->len;
+
+  stream = svn_checksum__wrap_write_stream_md5_sha1(
+             &md5, &sha1, svn_stream_from_stringbuf(buf, pool), pool);
+  SVN_ERR(svn_stream_write(stream, str->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_STRING_ASSERT(buf->data, str->data);
+
+  SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5,
+                       str->data, str->len, pool));
+  SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1,
+                       str->data, str->len, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1));
+
+  return SVN_NO_ERROR;
+}
+
+/* Size of the buffer being checksummed in checksum_throughput(). */
+#define THROUGHPUT_DATA_SIZE (64 * 1024 * 1024)
+
+/* Chunk size used by svn_stream_copy3() and friends. */
+#define THROUGHPUT_CHUNK_SIZE (16 * 1024)
+
+/* Return the number of MB/s for processing THROUGHPUT_DATA_SIZE bytes
+ * between START and now. */
+static double
+throughput(apr_time_t start)
+{
+  apr_time_t duration = MAX(apr_time_now() - start, 1);
+  return (double)THROUGHPUT_DATA_SIZE / duration * APR_USEC_PER_SEC
+       / (1024 * 1024);
+}
+
+static svn_error_t *
+checksum_throughput(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  unsigned char *data = make_test_data(THROUGHPUT_DATA_SIZE, pool);
+  svn_checksum_ctx_t *md5_ctx = svn_checksum_ctx_create(svn_checksum_md5,
+                                                        pool);
+  svn_checksum_ctx_t *sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1,
+                                                         pool);
+  svn_checksum__md5_sha1_ctx_t *ctx = svn_checksum__md5_sha1_ctx_create(pool);
+  svn_checksum_t *md5, *sha1, *fused_md5, *fused_sha1;
+  double md5_speed, sha1_speed, separate_speed, fused_speed;
+  apr_time_t start;
+  apr_size_t i;
+
+  /* Like in a checksummed stream, process the data chunk by chunk. */
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    SVN_ERR(svn_checksum_update(md5_ctx, data + i, THROUGHPUT_CHUNK_SIZE));
+  SVN_ERR(svn_checksum_final(&md5, md5_ctx, pool));
+  md5_speed = throughput(start);
+
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    SVN_ERR(svn_checksum_update(sha1_ctx, data + i, THROUGHPUT_CHUNK_SIZE));
+  SVN_ERR(svn_checksum_final(&sha1, sha1_ctx, pool));
+  sha1_speed = throughput(start);
+
+  SVN_ERR(svn_checksum_ctx_reset(md5_ctx));
+  SVN_ERR(svn_checksum_ctx_reset(sha1_ctx));
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    {
+      SVN_ERR(svn_checksum_update(md5_ctx, data + i, THROUGHPUT_CHUNK_SIZE));
+      SVN_ERR(svn_checksum_update(sha1_ctx, data + i,
+                                  THROUGHPUT_CHUNK_SIZE));
+    }
+  SVN_ERR(svn_checksum_final(&md5, md5_ctx, pool));
+  SVN_ERR(svn_checksum_final(&sha1, sha1_ctx, pool));
+  separate_speed = throughput(start);
+
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    svn_checksum__md5_sha1_update(ctx, data + i, THROUGHPUT_CHUNK_SIZE);
+  svn_checksum__md5_sha1_final(&fused_md5, &fused_sha1, ctx, pool);
+  fused_speed = throughput(start);
+
+  SVN_TEST_ASSERT(svn_checksum_match(md5, fused_md5));
+  SVN_TEST_ASSERT(svn_checksum_match(sha1, fused_sha1));
+
+  if (opts->verbose)
+    printf("MD5: %.0f MB/s, SHA-1: %.0f MB/s, "
+           "MD5 and SHA-1: %.0f MB/s, fused: %.0f MB/s\n",
+           md5_speed, sha1_speed, separate_speed, fused_speed);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_hash64(apr_pool_t *pool)
+{
+  apr_size_t max_len = 300;
+  unsigned char *data = make_test_data(max_len, pool);
+  apr_hash_t *seen = apr_hash_make(pool);
+  apr_size_t len;
+
+  for (len = 0; len <= max_len; ++len)
+    {
+      apr_uint64_t hash = svn__hash64(data, len, 0);
+      apr_uint64_t *key = apr_pmemdup(pool, &hash, sizeof(hash));
+      apr_size_t bit;
+
+      /* Deterministic and distinct for all prefixes of DATA. */
+      SVN_TEST_ASSERT(hash == svn__hash64(data, len, 0));
+      SVN_TEST_ASSERT(apr_hash_get(seen, key, sizeof(*key)) == NULL);
+      apr_hash_set(seen, key, sizeof(*key), key);
+
+      /* The seed matters. */
+      SVN_TEST_ASSERT(hash != svn__hash64(data, len, 1));
+
+      /* So does every single bit. */
+      for (bit = 0; bit < len * 8; bit += 5)
+        {
+          data[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+          SVN_TEST_ASSERT(hash != svn__hash64(data, len, 0));
+          data[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_hash_make_fast(apr_pool_t *pool)
+{
+  apr_hash_t *hash = svn_hash__make_fast(pool);
+  int i;
+
+  for (i = 0; i < 1000; ++i)
+    svn_hash_sets(hash, apr_psprintf(pool, "trunk/subversion/%d.c", i),
+                  apr_psprintf(pool, "%d", i));
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(hash), 1000);
+  for (i = 0; i < 1000; ++i)
+    SVN_TEST_STRING_ASSERT(svn_hash_gets(hash,
+                                         apr_psprintf(pool,
+                                                      "trunk/subversion/%d.c",
+                                                      i)),
+                           apr_psprintf(pool, "%d", i));
+
+  SVN_TEST_ASSERT(svn_hash_gets(hash, "trunk/subversion/1000.c") == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of keys to use in hash_throughput(). */
+#define THROUGHPUT_KEY_COUNT 200000
+
+/* Return the number of microseconds between START and now. */
+static double
+elapsed(apr_time_t start)
+{
+  return (double)MAX(apr_time_now() - start, 1);
+}
+
+/* Insert all COUNT KEYS into HASH and look them up again.
+ * Set *DURATION to the number of microseconds this took. */
+static svn_error_t *
+fill_and_query(double *duration,
+               apr_hash_t *hash,
+               const char **keys,
+               int count)
+{
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < count; ++i)
+    svn_hash_sets(hash, keys[i], keys[i]);
+  for (i = 0; i < count; ++i)
+    SVN_TEST_ASSERT(svn_hash_gets(hash, keys[i]) == keys[i]);
+
+  *duration = elapsed(start);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+hash_throughput(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  unsigned char *data = make_test_data(THROUGHPUT_DATA_SIZE, pool);
+  const char **keys = apr_palloc(pool, THROUGHPUT_KEY_COUNT * sizeof(*keys));
+  apr_uint64_t sum = 0;
+  apr_uint64_t hash64_sum = 0;
+  apr_uint64_t fnv1a_sum = 0;
+  double hash64_speed, fnv1a_speed, compatible_time, fast_time;
+  apr_time_t start;
+  apr_size_t i;
+
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    hash64_sum += svn__hash64(data + i, THROUGHPUT_CHUNK_SIZE, 0);
+  hash64_speed = throughput(start);
+
+  start = apr_time_now();
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    fnv1a_sum += svn__fnv1a_32x4(data + i, THROUGHPUT_CHUNK_SIZE);
+  fnv1a_speed = throughput(start);
+
+  /* The timings depend on the machine and its clock.  Only the digests
+   * themselves are checked: hashing the same data again must reproduce
+   * them. */
+  for (i = 0; i < THROUGHPUT_DATA_SIZE; i += THROUGHPUT_CHUNK_SIZE)
+    {
+      sum += svn__hash64(data + i, THROUGHPUT_CHUNK_SIZE, 0);
+      sum += svn__fnv1a_32x4(data + i, THROUGHPUT_CHUNK_SIZE);
+    }
+  SVN_TEST_ASSERT(sum == hash64_sum + fnv1a_sum);
+
+  /* Typical repository paths as hash keys. */
+  for (i = 0; i < THROUGHPUT_KEY_COUNT; ++i)
+    keys[i] = apr_psprintf(pool, "/trunk/subversion/libsvn_%d/file-%d.c",
+                           (int)(i % 97), (int)i);
+
+  SVN_ERR(fill_and_query(&compatible_time, svn_hash__make(pool), keys,
+                         THROUGHPUT_KEY_COUNT));
+  SVN_ERR(fill_and_query(&fast_time, svn_hash__make_fast(pool), keys,
+                         THROUGHPUT_KEY_COUNT));
+
+  if (opts->verbose)
+    printf("svn__hash64: %.0f MB/s, svn__fnv1a_32x4: %.0f MB/s\n"
+           "%d paths in svn_hash__make: %.0f ms, "
+           "svn_hash__make_fast: %.0f ms (%x)\n",
+           hash64_speed, fnv1a_speed, THROUGHPUT_KEY_COUNT,
+           compatible_time / 1000, fast_time / 1000, (unsigned)sum);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +760,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_sha1_vectors,
+                   "SHA-1 test vectors"),
+    SVN_TEST_PASS2(test_checksum_ctx_split,
+                   "checksum updates of any size"),
+    SVN_TEST_PASS2(test_md5_sha1_ctx,
+                   "single-pass MD5 and SHA-1"),
+    SVN_TEST_PASS2(test_md5_sha1_stream,
+                   "single-pass MD5 and SHA-1 stream"),
+    SVN_TEST_OPTS_PASS(checksum_throughput,
+                       "checksum throughput"),
+    SVN_TEST_PASS2(test_hash64,
+                   "64 bit hash function"),
+    SVN_TEST_PASS2(test_hash_make_fast,
+                   "hash table using the 64 bit hash"),
+    SVN_TEST_OPTS_PASS(hash_throughput,
+                       "hash function throughput"),
     SVN_TEST_NULL
   };
 
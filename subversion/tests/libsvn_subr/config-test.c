@@ -458,6 +458,56 @@ test_serialization(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_parse_buffer(apr_pool_t *pool)
+{
+  svn_config_t *cfg;
+  svn_config__constructor_t *constructor;
+  const char *val;
+
+  /* BOM, CRLF line endings, a comment, a continuation line and trailing
+     data that is not part of the buffer. */
+  const char data[] = "\xEF\xBB\xBF[s1]\r\n"
+                      "# comment\r\n"
+                      "foo = bar\r\n"
+                      "  baz\r\n"
+                      "\n"
+                      "[s2]\n"
+                      "a=1\n"
+                      "b=2[s3]\nc=3\n";
+  apr_size_t len = strlen(data) - strlen("[s3]\nc=3\n");
+
+  constructor = svn_config__constructor_create(
+                    NULL, NULL, svn_config__default_add_value_fn, pool);
+
+  SVN_ERR(svn_config_create2(&cfg, TRUE, TRUE, pool));
+  SVN_ERR(svn_config__parse_buffer(data, len, constructor, cfg, pool));
+
+  svn_config_get(cfg, &val, "s1", "foo", NULL);
+  SVN_TEST_STRING_ASSERT(val, "bar baz");
+  svn_config_get(cfg, &val, "s2", "a", NULL);
+  SVN_TEST_STRING_ASSERT(val, "1");
+  svn_config_get(cfg, &val, "s2", "b", NULL);
+  SVN_TEST_STRING_ASSERT(val, "2");
+  SVN_TEST_ASSERT(! svn_config_has_section(cfg, "s3"));
+
+  /* Empty input. */
+  SVN_ERR(svn_config_create2(&cfg, TRUE, TRUE, pool));
+  SVN_ERR(svn_config__parse_buffer(data, 0, constructor, cfg, pool));
+  SVN_TEST_ASSERT(! svn_config_has_section(cfg, "s1"));
+
+  /* Errors must be reported just like for streams. */
+  SVN_ERR(svn_config_create2(&cfg, TRUE, TRUE, pool));
+  SVN_TEST_ASSERT_ERROR(svn_config__parse_buffer("\xEF\xBB", 2,
+                                                 constructor, cfg, pool),
+                        SVN_ERR_MALFORMED_FILE);
+  SVN_TEST_ASSERT_ERROR(svn_config__parse_buffer("foo=bar\n", 8,
+                                                 constructor, cfg, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -494,6 +544,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing config file with invalid BOM"),
     SVN_TEST_PASS2(test_serialization,
                    "test writing a config"),
+    SVN_TEST_PASS2(test_parse_buffer,
+                   "test parsing config data in memory"),
     SVN_TEST_NULL
   };
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <apr_general.h>
+#include <apr_time.h>
 
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
@@ -208,6 +209,7 @@ test_dirent_join(apr_pool_t *pool)
 {
   int i;
   char *result;
+  svn_stringbuf_t *buf;
 
   static const char * const joins[][3] = {
     { "abc", "def", "abc/def" },
@@ -276,6 +278,14 @@ test_dirent_join(apr_pool_t *pool)
                                  "svn_dirent_join_many(\"%s\", \"%s\") returned "
                                  "\"%s\". expected \"%s\"",
                                  base, comp, result, expect);
+
+      buf = svn_stringbuf_create(base, pool);
+      svn_dirent__join_append(buf, comp);
+      if (strcmp(buf->data, expect))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_dirent__join_append(\"%s\", \"%s\") "
+                                 "returned \"%s\". expected \"%s\"",
+                                 base, comp, buf->data, expect);
     }
 
 #define TEST_MANY(args, expect) \
@@ -364,6 +374,7 @@ test_relpath_join(apr_pool_t *pool)
 {
   int i;
   char *result;
+  svn_stringbuf_t *buf;
 
   static const char * const joins[][3] = {
     { "abc", "def", "abc/def" },
@@ -387,6 +398,14 @@ test_relpath_join(apr_pool_t *pool)
                                  "\"%s\". expected \"%s\"",
                                  base, comp, result, expect);
 
+      buf = svn_stringbuf_create(base, pool);
+      svn_relpath__join_append(buf, comp);
+      if (strcmp(buf->data, expect))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__join_append(\"%s\", \"%s\") "
+                                 "returned \"%s\". expected \"%s\"",
+                                 base, comp, buf->data, expect);
+
       /*result = svn_relpath_join_many(pool, base, comp, NULL);
       if (strcmp(result, expect))
         return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
@@ -717,6 +736,14 @@ test_dirent_canonicalize(apr_pool_t *pool)
                                  "svn_dirent_canonicalize(\"%s\") returned "
                                  "\"%s\" expected \"%s\"",
                                  t->path, canonical, t->result);
+
+      canonical = svn_dirent__ensure_canonical(t->path, pool);
+      if (strcmp(canonical, t->result)
+          || ((canonical == t->path) != (strcmp(t->path, t->result) == 0)))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_dirent__ensure_canonical(\"%s\") returned "
+                                 "\"%s\" expected \"%s\"",
+                                 t->path, canonical, t->result);
     }
 
   return SVN_NO_ERROR;
@@ -798,6 +825,14 @@ test_relpath_canonicalize(apr_pool_t *pool)
                                  "svn_relpath_canonicalize(\"%s\") returned "
                                  "\"%s\" expected \"%s\"",
                                  t->path, canonical, t->result);
+
+      canonical = svn_relpath__ensure_canonical(t->path, pool);
+      if (strcmp(canonical, t->result)
+          || ((canonical == t->path) != (strcmp(t->path, t->result) == 0)))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__ensure_canonical(\"%s\") returned "
+                                 "\"%s\" expected \"%s\"",
+                                 t->path, canonical, t->result);
     }
 
   return SVN_NO_ERROR;
@@ -2915,6 +2950,79 @@ test_rule3(apr_pool_t *pool)
   return run_cert_match_dns_tests(rule3_tests, pool);
 }
 
+/* Number of paths to use in canonicalize_join_speed(). */
+#define SPEED_PATH_COUNT 100000
+
+static svn_error_t *
+canonicalize_join_speed(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  const char **relpaths = apr_palloc(pool,
+                                     SPEED_PATH_COUNT * sizeof(*relpaths));
+  const char **names = apr_palloc(pool, SPEED_PATH_COUNT * sizeof(*names));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  apr_time_t canonicalize_time, ensure_time, join_time, append_time;
+  apr_time_t start;
+  int i;
+
+  /* A working copy like set of paths, which are canonical as usual. */
+  for (i = 0; i < SPEED_PATH_COUNT; ++i)
+    {
+      names[i] = apr_psprintf(pool, "file-%d.c", i);
+      relpaths[i] = apr_psprintf(pool, "trunk/subversion/libsvn_%d/%s",
+                                 i % 97, names[i]);
+    }
+
+  start = apr_time_now();
+  for (i = 0; i < SPEED_PATH_COUNT; ++i)
+    {
+      if ((i & 0xff) == 0)
+        svn_pool_clear(iterpool);
+      SVN_TEST_ASSERT(svn_relpath_canonicalize(relpaths[i], iterpool));
+    }
+  canonicalize_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < SPEED_PATH_COUNT; ++i)
+    SVN_TEST_ASSERT(svn_relpath__ensure_canonical(relpaths[i], iterpool)
+                    == relpaths[i]);
+  ensure_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < SPEED_PATH_COUNT; ++i)
+    {
+      if ((i & 0xff) == 0)
+        svn_pool_clear(iterpool);
+      SVN_TEST_ASSERT(svn_relpath_join("trunk/subversion", names[i],
+                                       iterpool));
+    }
+  join_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < SPEED_PATH_COUNT; ++i)
+    {
+      svn_stringbuf_set(buf, "trunk/subversion");
+      svn_relpath__join_append(buf, names[i]);
+    }
+  append_time = apr_time_now() - start;
+  SVN_TEST_STRING_ASSERT(buf->data,
+                         svn_relpath_join("trunk/subversion",
+                                          names[SPEED_PATH_COUNT - 1],
+                                          pool));
+
+  svn_pool_destroy(iterpool);
+
+  if (opts->verbose)
+    printf("%d paths: svn_relpath_canonicalize: %d us, "
+           "svn_relpath__ensure_canonical: %d us\n"
+           "svn_relpath_join: %d us, svn_relpath__join_append: %d us\n",
+           SPEED_PATH_COUNT, (int)canonicalize_time, (int)ensure_time,
+           (int)join_time, (int)append_time);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -3019,6 +3127,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_cert__match_dns_identity"),
     SVN_TEST_XFAIL2(test_rule3,
                     "test match with RFC 6125 s. 6.4.3 Rule 3"),
+    SVN_TEST_OPTS_PASS(canonicalize_join_speed,
+                       "canonicalize and join speed"),
     SVN_TEST_NULL
   };
 
@@ -36,6 +36,8 @@
 #include "svn_error.h"
 #include "svn_hash.h"
 
+#include "private/svn_subr_private.h"
+
 
 /* Our own global variables */
 static apr_hash_t *proplist, *new_proplist;
@@ -230,6 +232,72 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+parse_hash_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(pool);
+  apr_hash_t *ht = apr_hash_make(pool);
+  svn_string_t *value;
+  char *data;
+  svn_error_t *err;
+
+  svn_hash_sets(ht, "key1", svn_string_create("value1", pool));
+  svn_hash_sets(ht, "key\n2", svn_string_create("", pool));
+  svn_hash_sets(ht, "", svn_string_create("K 3\nEND\n", pool));
+  svn_hash_sets(ht, "review", svn_string_create(review, pool));
+  SVN_ERR(svn_hash_write2(ht, svn_stream_from_stringbuf(serialized, pool),
+                          SVN_HASH_TERMINATOR, pool));
+
+  /* Parse with and without trailing data. */
+  svn_stringbuf_appendcstr(serialized, "trailing garbage");
+  data = apr_pstrdup(pool, serialized->data);
+  ht = apr_hash_make(pool);
+  SVN_ERR(svn_hash__parse(ht, data, serialized->len, SVN_HASH_TERMINATOR,
+                          pool));
+
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 4);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key1"), "value1");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key\n2"), "");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, ""), "K 3\nEND\n");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "review"), review);
+
+  /* The values point into DATA. */
+  value = svn_hash_gets(ht, "key1");
+  SVN_TEST_ASSERT(value->data > data
+                  && value->data < data + serialized->len);
+  SVN_TEST_ASSERT(value->len == 6);
+
+  /* No terminator.  Everything up to the end of the data is the hash. */
+  data = apr_pstrdup(pool, "K 1\na\nV 2\nbc\n");
+  ht = apr_hash_make(pool);
+  SVN_ERR(svn_hash__parse(ht, data, strlen(data), NULL, pool));
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 1);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "a"), "bc");
+
+  /* Malformed input. */
+  data = apr_pstrdup(pool, "K 1\na\nV 2\nbc\n");
+  err = svn_hash__parse(apr_hash_make(pool), data, strlen(data),
+                        SVN_HASH_TERMINATOR, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  data = apr_pstrdup(pool, "K 1\na\nV 5\nbc\nEND\n");
+  err = svn_hash__parse(apr_hash_make(pool), data, strlen(data),
+                        SVN_HASH_TERMINATOR, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  data = apr_pstrdup(pool, "K 1\na\nEND\n");
+  err = svn_hash__parse(apr_hash_make(pool), data, strlen(data),
+                        SVN_HASH_TERMINATOR, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  data = apr_pstrdup(pool, "K x\na\nV 1\nb\nEND\n");
+  err = svn_hash__parse(apr_hash_make(pool), data, strlen(data),
+                        SVN_HASH_TERMINATOR, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +320,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(parse_hash_test,
+                   "parse a hash from memory"),
     SVN_TEST_NULL
   };
 
@@ -28,6 +28,7 @@
 #include <apr.h>
 #include <apr_version.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_string.h"
 #include "svn_io.h"
@@ -1147,6 +1148,194 @@ test_apr_trunc_workaround(apr_pool_t *pool)
   return SVN_NO_ERROR;  
 }
 
+static svn_error_t *
+test_copy_file2(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *foo_path;
+  const char *bar_path;
+  svn_stringbuf_t *content;
+  svn_stringbuf_t *actual_content;
+  svn_boolean_t cloned;
+  apr_size_t i;
+
+  /* Create an empty directory. */
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_copy_file2", pool));
+
+  foo_path = svn_dirent_join(tmp_dir, "foo", pool);
+  bar_path = svn_dirent_join(tmp_dir, "bar", pool);
+
+  /* Use a source file that spans multiple copy buffers. */
+  content = svn_stringbuf_create_ensure(5 * SVN__STREAM_CHUNK_SIZE, pool);
+  for (i = 0; content->len < 5 * SVN__STREAM_CHUNK_SIZE; ++i)
+    svn_stringbuf_appendcstr(content, apr_psprintf(pool, "line %d\n",
+                                                   (int)i));
+  SVN_ERR(svn_io_file_create_bytes(foo_path, content->data, content->len,
+                                   pool));
+
+  /* Test 1: Plain copy to a new file. */
+  cloned = TRUE;
+  SVN_ERR(svn_io_copy_file2(foo_path, bar_path, 0, &cloned, pool));
+  SVN_TEST_ASSERT(!cloned);
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  /* Test 2: Copy over an existing, read-only file, possibly cloning it. */
+  SVN_ERR(svn_io_file_create(bar_path, "bar content", pool));
+  SVN_ERR(svn_io_set_file_read_only(foo_path, FALSE, pool));
+  SVN_ERR(svn_io_set_file_read_only(bar_path, FALSE, pool));
+
+  SVN_ERR(svn_io_copy_file2(foo_path, bar_path,
+                            SVN_IO_COPY_FILE_PERMS | SVN_IO_COPY_FILE_CLONE,
+                            &cloned, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  /* Test 3: Copy an empty file. */
+  SVN_ERR(svn_io_set_file_read_write(foo_path, FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(foo_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create_empty(foo_path, pool));
+
+  SVN_ERR(svn_io_copy_file2(foo_path, bar_path, SVN_IO_COPY_FILE_CLONE,
+                            NULL, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_STRING_ASSERT(actual_content->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_file_readline_chunks(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *tmp_file;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *buf;
+  apr_file_t *f;
+  const char *eol;
+  svn_boolean_t eof;
+  apr_off_t pos;
+  apr_off_t expected_pos = 0;
+  apr_size_t len;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_file_readline_chunks",
+                                    pool));
+  tmp_file = svn_dirent_join(tmp_dir, "foo", pool);
+
+  /* Lines of various lengths, such that the CR of a CRLF will be the
+     last byte of the first chunk read for at least one of them. */
+  for (len = 60; len < 140; ++len)
+    {
+      svn_stringbuf_appendfill(contents, (char)('a' + len % 26), len);
+      svn_stringbuf_appendcstr(contents, "\r\n");
+    }
+
+  svn_stringbuf_appendfill(contents, 'x', 1000);
+  svn_stringbuf_appendcstr(contents, "\n0123456789\n");
+  SVN_ERR(svn_io_file_create(tmp_file, contents->data, pool));
+
+  SVN_ERR(svn_io_file_open(&f, tmp_file, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  for (len = 60; len < 140; ++len)
+    {
+      SVN_ERR(svn_io_file_readline(f, &buf, &eol, &eof, APR_SIZE_MAX,
+                                   pool, pool));
+      SVN_TEST_INT_ASSERT(buf->len, len);
+      SVN_TEST_ASSERT(buf->data[len - 1] == (char)('a' + len % 26));
+      SVN_TEST_STRING_ASSERT(eol, "\r\n");
+      SVN_TEST_ASSERT(!eof);
+
+      expected_pos += len + 2;
+      SVN_ERR(svn_io_file_get_offset(&pos, f, pool));
+      SVN_TEST_INT_ASSERT(pos, expected_pos);
+    }
+
+  SVN_ERR(svn_io_file_readline(f, &buf, &eol, &eof, APR_SIZE_MAX,
+                               pool, pool));
+  SVN_TEST_INT_ASSERT(buf->len, 1000);
+  SVN_TEST_STRING_ASSERT(eol, "\n");
+  SVN_TEST_ASSERT(!eof);
+
+  /* Stop after MAX_LEN bytes. */
+  SVN_ERR(svn_io_file_readline(f, &buf, &eol, &eof, 4, pool, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, "0123");
+  SVN_TEST_STRING_ASSERT(eol, NULL);
+  SVN_TEST_ASSERT(eof);
+
+  SVN_ERR(svn_io_file_get_offset(&pos, f, pool));
+  SVN_TEST_INT_ASSERT(pos, expected_pos + 1001 + 4);
+
+  SVN_ERR(svn_io_file_readline(f, &buf, &eol, &eof, APR_SIZE_MAX,
+                               pool, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, "456789");
+  SVN_TEST_STRING_ASSERT(eol, "\n");
+  SVN_TEST_ASSERT(!eof);
+
+  SVN_ERR(svn_io_file_readline(f, &buf, &eol, &eof, APR_SIZE_MAX,
+                               pool, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, "");
+  SVN_TEST_STRING_ASSERT(eol, NULL);
+  SVN_TEST_ASSERT(eof);
+
+  SVN_ERR(svn_io_file_close(f, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_dirents(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  apr_hash_t *dirents;
+  svn_io_dirent2_t *dirent;
+  apr_finfo_t finfo;
+  const char *file_path;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_get_dirents", pool));
+  file_path = svn_dirent_join(tmp_dir, "file", pool);
+  SVN_ERR(svn_io_file_create(file_path, "0123456789", pool));
+  SVN_ERR(svn_io_dir_make(svn_dirent_join(tmp_dir, "dir", pool),
+                          APR_OS_DEFAULT, pool));
+
+  /* Types only. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, tmp_dir, TRUE, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+
+  dirent = svn_hash_gets(dirents, "file");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_ASSERT(!dirent->special);
+  SVN_TEST_ASSERT(dirent->filesize == SVN_INVALID_FILESIZE);
+
+  dirent = svn_hash_gets(dirents, "dir");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  /* With size and time stamp, which match those from svn_io_stat(). */
+  SVN_ERR(svn_io_get_dirents3(&dirents, tmp_dir, FALSE, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+
+  SVN_ERR(svn_io_stat(&finfo, file_path, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                      pool));
+  dirent = svn_hash_gets(dirents, "file");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_INT_ASSERT(dirent->filesize, 10);
+  SVN_TEST_ASSERT(dirent->mtime == finfo.mtime);
+
+  dirent = svn_hash_gets(dirents, "dir");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  /* Missing directories are reported as such. */
+  err = svn_io_get_dirents3(&dirents, svn_dirent_join(tmp_dir, "none", pool),
+                            TRUE, pool, pool);
+  SVN_TEST_ASSERT(err && APR_STATUS_IS_ENOENT(err->apr_err));
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 3;
@@ -1184,6 +1373,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_open_uniquely_named()"),
     SVN_TEST_PASS2(test_apr_trunc_workaround,
                    "test workaround for APR in svn_io_file_trunc"),
+    SVN_TEST_PASS2(test_copy_file2,
+                   "test svn_io_copy_file2"),
+    SVN_TEST_PASS2(test_file_readline_chunks,
+                   "test svn_io_file_readline with long lines"),
+    SVN_TEST_PASS2(test_get_dirents,
+                   "test svn_io_get_dirents3"),
     SVN_TEST_NULL
   };
 
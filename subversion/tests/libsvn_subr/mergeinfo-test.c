@@ -32,6 +32,7 @@
 #include "svn_pools.h"
 #include "svn_types.h"
 #include "svn_mergeinfo.h"
+#include "svn_sorts.h"
 #include "private/svn_mergeinfo_private.h"
 #include "../svn_test.h"
 
@@ -1857,6 +1858,306 @@ test_rangelist_loop(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return the canonical rangelist for the revision states in
+ * STATES[RANDOM_REV_ARRAY_LENGTH], where 0 means "not included",
+ * 1 non-inheritable and 2 inheritable.  Allocate it in POOL. */
+static svn_rangelist_t *
+rev_states_to_rangelist(const int *states,
+                        apr_pool_t *pool)
+{
+  svn_rangelist_t *rangelist = apr_array_make(pool, 1,
+                                              sizeof(svn_merge_range_t *));
+  svn_merge_range_t *range = NULL;
+  int i;
+
+  for (i = 1; i < RANDOM_REV_ARRAY_LENGTH; i++)
+    {
+      if (!states[i])
+        {
+          range = NULL;
+        }
+      else if (range && range->inheritable == (states[i] == 2))
+        {
+          range->end = i;
+        }
+      else
+        {
+          range = apr_pcalloc(pool, sizeof(*range));
+          range->start = i - 1;
+          range->end = i;
+          range->inheritable = (states[i] == 2);
+          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = range;
+        }
+    }
+
+  return rangelist;
+}
+
+/* Verify that the compact rangelist ACTUAL describes the same revisions
+ * as EXPECTED_STATES.  Use POOL for allocations. */
+static svn_error_t *
+verify_compact_states(const svn_rangelist__compact_t *actual,
+                      const int *expected_states,
+                      const char *func,
+                      apr_pool_t *pool)
+{
+  svn_string_t *actual_str, *expected_str;
+  int i;
+
+  SVN_ERR(svn_rangelist_to_string(&actual_str,
+                                  svn_rangelist__expand(actual, pool),
+                                  pool));
+  SVN_ERR(svn_rangelist_to_string(&expected_str,
+                                  rev_states_to_rangelist(expected_states,
+                                                          pool),
+                                  pool));
+  if (strcmp(actual_str->data, expected_str->data))
+    return fail(pool, "%s returned '%s' instead of '%s'", func,
+                actual_str->data, expected_str->data);
+
+  for (i = 1; i < RANDOM_REV_ARRAY_LENGTH; i++)
+    {
+      const svn_merge_range_t *range = svn_rangelist__compact_find(actual, i);
+
+      if (!range != !expected_states[i]
+          || (range && range->inheritable != (expected_states[i] == 2)))
+        return fail(pool, "svn_rangelist__compact_find failed for r%d in "
+                    "'%s'", i, actual_str->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_rangelist_compact(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool;
+
+  random_rev_array_seed = (apr_uint32_t) apr_time_now();
+
+  iterpool = svn_pool_create(pool);
+
+  for (i = 0; i < 50; i++)
+    {
+      int first_states[RANDOM_REV_ARRAY_LENGTH];
+      int second_states[RANDOM_REV_ARRAY_LENGTH];
+      int expected_states[RANDOM_REV_ARRAY_LENGTH];
+      svn_rangelist__compact_t *first, *second;
+      int consider_inheritance;
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+        {
+          first_states[j] = svn_test_rand(&random_rev_array_seed) % 3;
+          second_states[j] = svn_test_rand(&random_rev_array_seed) % 3;
+        }
+
+      first = svn_rangelist__compact(rev_states_to_rangelist(first_states,
+                                                             iterpool),
+                                     iterpool, iterpool);
+      second = svn_rangelist__compact(rev_states_to_rangelist(second_states,
+                                                              iterpool),
+                                      iterpool, iterpool);
+      SVN_ERR(verify_compact_states(first, first_states,
+                                    "svn_rangelist__compact", iterpool));
+
+      /* Union: inheritable wins. */
+      for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+        expected_states[j] = MAX(first_states[j], second_states[j]);
+      SVN_ERR(verify_compact_states(
+                svn_rangelist__compact_merge(first, second, iterpool),
+                expected_states, "svn_rangelist__compact_merge", iterpool));
+
+      for (consider_inheritance = 0;
+           consider_inheritance < 2;
+           consider_inheritance++)
+        {
+          /* Intersection: non-inheritable only if both are. */
+          for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+            expected_states[j]
+              = (!first_states[j] || !second_states[j]
+                 || (consider_inheritance
+                     && first_states[j] != second_states[j]))
+              ? 0
+              : MAX(first_states[j], second_states[j]);
+          SVN_ERR(verify_compact_states(
+                    svn_rangelist__compact_intersect(first, second,
+                                                     consider_inheritance,
+                                                     iterpool),
+                    expected_states, "svn_rangelist__compact_intersect",
+                    iterpool));
+
+          /* Removal of FIRST from SECOND. */
+          for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+            expected_states[j]
+              = (!first_states[j]
+                 || (consider_inheritance
+                     && first_states[j] != second_states[j]))
+              ? second_states[j]
+              : 0;
+          SVN_ERR(verify_compact_states(
+                    svn_rangelist__compact_remove(first, second,
+                                                  consider_inheritance,
+                                                  iterpool),
+                    expected_states, "svn_rangelist__compact_remove",
+                    iterpool));
+        }
+
+      /* Non-canonical input: all ranges of both lists, unsorted. */
+      {
+        svn_rangelist_t *both
+          = rev_states_to_rangelist(second_states, iterpool);
+
+        apr_array_cat(both, rev_states_to_rangelist(first_states, iterpool));
+        for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+          expected_states[j] = MAX(first_states[j], second_states[j]);
+        SVN_ERR(verify_compact_states(
+                  svn_rangelist__compact(both, iterpool, iterpool),
+                  expected_states, "svn_rangelist__compact", iterpool));
+      }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_mergeinfo_parser(apr_pool_t *pool)
+{
+  const char *inputs[] = {
+    "/trunk:1-10,12*,15-20\n/branches/a:3,5-7\nbranches/b:4-5",
+    "/trunk:5,6,7,9-11\n/branches/b:1-2,4*\n/branches/b:7",
+    "/branches/a:/x:9\n/trunk:22-23"
+  };
+  svn_mergeinfo__parser_t *parser = svn_mergeinfo__parser_create(pool);
+  const char *trunk_key = NULL;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      svn_mergeinfo_t expected, actual;
+      svn_string_t *expected_str, *actual_str;
+      apr_hash_index_t *hi;
+
+      SVN_ERR(svn_mergeinfo_parse(&expected, inputs[i], pool));
+      SVN_ERR(svn_mergeinfo__parser_parse(&actual, parser, inputs[i], pool));
+
+      SVN_ERR(svn_mergeinfo_to_string(&expected_str, expected, pool));
+      SVN_ERR(svn_mergeinfo_to_string(&actual_str, actual, pool));
+      SVN_TEST_STRING_ASSERT(actual_str->data, expected_str->data);
+
+      /* Merge source paths are interned. */
+      for (hi = apr_hash_first(pool, actual); hi; hi = apr_hash_next(hi))
+        {
+          const char *key = apr_hash_this_key(hi);
+
+          if (strcmp(key, "/trunk") == 0)
+            {
+              if (trunk_key)
+                SVN_TEST_ASSERT(key == trunk_key);
+              trunk_key = key;
+            }
+        }
+    }
+
+  {
+    svn_mergeinfo_t mergeinfo;
+
+    SVN_TEST_ASSERT_ERROR(svn_mergeinfo__parser_parse(&mergeinfo, parser,
+                                                      "/trunk:5-3", pool),
+                          SVN_ERR_MERGEINFO_PARSE_ERROR);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return mergeinfo with NUM_PATHS merge sources, each of which maps to
+ * NUM_RANGES ranges, as typically found on heavily merged branches. */
+static const char *
+make_mergeinfo_string(int num_paths,
+                      int num_ranges,
+                      apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i, k;
+
+  for (i = 0; i < num_paths; i++)
+    {
+      svn_revnum_t rev = 1000 + i;
+
+      svn_stringbuf_appendcstr(buf,
+                               apr_psprintf(pool,
+                                            "/branches/feature-%d/project:",
+                                            i));
+      for (k = 0; k < num_ranges; k++)
+        {
+          /* Alternate between single revisions, ranges and
+             non-inheritable ranges. */
+          if (k % 3 == 0)
+            svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%ld", rev));
+          else if (k % 3 == 1)
+            svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%ld-%ld",
+                                                       rev, rev + 5));
+          else
+            svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%ld*", rev));
+
+          svn_stringbuf_appendbyte(buf, k + 1 < num_ranges ? ',' : '\n');
+          rev += 10;
+        }
+    }
+
+  return buf->data;
+}
+
+static svn_error_t *
+test_mergeinfo_parse_performance(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *input = make_mergeinfo_string(100, 500, pool);
+  apr_time_t start, end;
+  int i;
+
+  start = apr_time_now();
+  for (i = 0; i < 200; i++)
+    {
+      svn_mergeinfo_t mergeinfo;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_mergeinfo_parse(&mergeinfo, input, iterpool));
+    }
+  end = apr_time_now();
+  printf("svn_mergeinfo_parse: %"APR_TIME_T_FMT" musecs\n", end - start);
+
+  /* A catalog of subtrees sharing the same merge sources. */
+  start = apr_time_now();
+  for (i = 0; i < 10; i++)
+    {
+      svn_mergeinfo__parser_t *parser;
+      int k;
+
+      svn_pool_clear(iterpool);
+      parser = svn_mergeinfo__parser_create(iterpool);
+      for (k = 0; k < 20; k++)
+        {
+          svn_mergeinfo_t mergeinfo;
+
+          SVN_ERR(svn_mergeinfo__parser_parse(&mergeinfo, parser, input,
+                                              iterpool));
+        }
+    }
+  end = apr_time_now();
+  printf("svn_mergeinfo__parser_parse: %"APR_TIME_T_FMT" musecs\n",
+         end - start);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1904,6 +2205,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "merge of rangelists with overlaps (issue 4686)"),
     SVN_TEST_XFAIL2(test_rangelist_loop,
                     "test rangelist edgecases via loop"),
+    SVN_TEST_PASS2(test_rangelist_compact,
+                   "test compact rangelist operations"),
+    SVN_TEST_PASS2(test_mergeinfo_parser,
+                   "test mergeinfo parser with path interning"),
+    SVN_TEST_SKIP2(test_mergeinfo_parse_performance, TRUE,
+                   "optional mergeinfo parser performance test"),
     SVN_TEST_NULL
   };
 
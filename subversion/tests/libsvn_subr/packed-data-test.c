@@ -133,6 +133,30 @@ test_uint_stream(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_small_uint_stream(apr_pool_t *pool)
+{
+  enum { COUNT = 1000 };
+  apr_uint64_t values[COUNT];
+  apr_size_t i;
+
+  /* Mostly single-byte values with the occasional larger one, so that
+     the decoder has to switch between block and single-value parsing at
+     varying offsets relative to its buffer boundaries. */
+  for (i = 0; i < COUNT; ++i)
+    if (i % 37 == 0)
+      values[i] = APR_UINT64_C(0x8000) + i;
+    else if (i % 101 == 0)
+      values[i] = APR_UINT64_MAX - i;
+    else
+      values[i] = i % 128;
+
+  SVN_ERR(verify_uint_stream(values, COUNT, FALSE, pool));
+  SVN_ERR(verify_uint_stream(values, COUNT, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Check that COUNT numbers from VALUES can be written as signed ints to a
  * packed data stream and can be read from that stream again.  Deltify
  * data in the stream if DIFF is set.  Use POOL for allocations.
@@ -564,6 +588,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty container"),
     SVN_TEST_PASS2(test_uint_stream,
                    "test a single uint stream"),
+    SVN_TEST_PASS2(test_small_uint_stream,
+                   "test a uint stream of mostly small values"),
     SVN_TEST_PASS2(test_int_stream,
                    "test a single int stream"),
     SVN_TEST_PASS2(test_byte_stream,
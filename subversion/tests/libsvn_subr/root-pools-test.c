@@ -82,6 +82,45 @@ test_root_pool(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_root_pool_info(apr_pool_t *pool)
+{
+  enum { POOL_COUNT = 300 };
+  svn_root_pools__t *pools;
+  svn_root_pools__info_t info;
+  apr_pool_t *acquired[POOL_COUNT];
+  int i;
+
+  SVN_ERR(svn_root_pools__create(&pools));
+
+  /* Released pools get recycled. */
+  acquired[0] = svn_root_pools__acquire_pool(pools);
+  svn_root_pools__release_pool(acquired[0], pools);
+  acquired[0] = svn_root_pools__acquire_pool(pools);
+  svn_root_pools__release_pool(acquired[0], pools);
+
+  SVN_ERR(svn_root_pools__get_info(&info, pools));
+  SVN_TEST_ASSERT(info.acquired == 2);
+  SVN_TEST_ASSERT(info.thread_cache_hits + info.shared_hits == 1);
+  SVN_TEST_ASSERT(info.thread_cached + info.shared == 1);
+  SVN_TEST_ASSERT(info.destroyed == 0);
+  SVN_TEST_ASSERT(info.retained_limit > 0);
+
+  /* The number of retained pools is limited. */
+  for (i = 0; i < POOL_COUNT; ++i)
+    acquired[i] = svn_root_pools__acquire_pool(pools);
+  for (i = 0; i < POOL_COUNT; ++i)
+    svn_root_pools__release_pool(acquired[i], pools);
+
+  SVN_ERR(svn_root_pools__get_info(&info, pools));
+  SVN_TEST_ASSERT(info.acquired == 2 + POOL_COUNT);
+  SVN_TEST_ASSERT(info.thread_cached + info.shared + info.destroyed
+                  == POOL_COUNT);
+  SVN_TEST_ASSERT(info.destroyed > 0);
+
+  return SVN_NO_ERROR;
+}
+
 #define APR_ERR(expr)                           \
   do {                                          \
     apr_status_t status = (expr);               \
@@ -128,6 +167,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_root_pool,
                    "test root pool recycling"),
+    SVN_TEST_PASS2(test_root_pool_info,
+                   "test root pool statistics and limits"),
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
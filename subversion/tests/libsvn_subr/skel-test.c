@@ -27,7 +27,9 @@
 
 #include <apr.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_props.h"
 #include "svn_string.h"
 #include "private/svn_skel.h"
 
@@ -883,6 +885,65 @@ unparse_list(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+
+/* Parse property lists directly from a buffer.  */
+
+static svn_error_t *
+parse_proplist_data(apr_pool_t *pool)
+{
+  apr_hash_t *props;
+  apr_array_header_t *iprops;
+  svn_prop_inherited_item_t *iprop;
+  svn_string_t *value;
+
+  /* "x" is directly followed by the implicit-length atom "bc". */
+  const char proplist[] = "(a 1 xbc 3 y z)";
+  const char iproplist[] = "(2 /p(a b)2 /q())";
+
+  SVN_ERR(svn_skel__parse_proplist_data(&props, proplist,
+                                        strlen(proplist), pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(props) == 2);
+  value = svn_hash_gets(props, "a");
+  SVN_TEST_ASSERT(value && value->len == 1);
+  SVN_TEST_STRING_ASSERT(value->data, "x");
+  value = svn_hash_gets(props, "bc");
+  SVN_TEST_ASSERT(value && value->len == 3);
+  SVN_TEST_STRING_ASSERT(value->data, "y z");
+
+  /* The input must not be modified. */
+  SVN_TEST_STRING_ASSERT(proplist, "(a 1 xbc 3 y z)");
+
+  SVN_ERR(svn_skel__parse_proplist_data(&props, "()", 2, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(props) == 0);
+
+  SVN_TEST_ASSERT_ERROR(svn_skel__parse_proplist_data(&props, "(a)", 3,
+                                                      pool, pool),
+                        SVN_ERR_FS_MALFORMED_SKEL);
+  SVN_TEST_ASSERT_ERROR(svn_skel__parse_proplist_data(&props, "(a b", 4,
+                                                      pool, pool),
+                        SVN_ERR_FS_MALFORMED_SKEL);
+
+  SVN_ERR(svn_skel__parse_iprops_data(&iprops, iproplist,
+                                      strlen(iproplist), pool, pool));
+  SVN_TEST_ASSERT(iprops->nelts == 2);
+  iprop = APR_ARRAY_IDX(iprops, 0, svn_prop_inherited_item_t *);
+  SVN_TEST_STRING_ASSERT(iprop->path_or_url, "/p");
+  SVN_TEST_ASSERT(apr_hash_count(iprop->prop_hash) == 1);
+  value = svn_hash_gets(iprop->prop_hash, "a");
+  SVN_TEST_ASSERT(value);
+  SVN_TEST_STRING_ASSERT(value->data, "b");
+  iprop = APR_ARRAY_IDX(iprops, 1, svn_prop_inherited_item_t *);
+  SVN_TEST_STRING_ASSERT(iprop->path_or_url, "/q");
+  SVN_TEST_ASSERT(apr_hash_count(iprop->prop_hash) == 0);
+
+  SVN_TEST_ASSERT_ERROR(svn_skel__parse_iprops_data(&iprops, "(2 /p)", 6,
+                                                    pool, pool),
+                        SVN_ERR_FS_MALFORMED_SKEL);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -903,6 +964,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "unparse implicit-length atoms"),
     SVN_TEST_PASS2(unparse_list,
                    "unparse lists"),
+    SVN_TEST_PASS2(parse_proplist_data,
+                   "parse proplists from buffers"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,274 @@
+/*
+ * sorts-test.c -- test the sorting functions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_time.h>
+
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_sorts.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
+
+#include "../svn_test.h"
+
+/* Number of paths to sort in sort_paths_throughput(). */
+#define THROUGHPUT_PATH_COUNT 1000000
+
+/* Return a random canonical relative path allocated in POOL.  Use and
+ * update *SEED for random numbers.  The paths share prefixes and contain
+ * bytes that sort before and after '/'. */
+static const char *
+random_path(apr_uint32_t *seed,
+            apr_pool_t *pool)
+{
+  static const char chars[] = "ab-.Z0\xc3";
+  svn_stringbuf_t *path = svn_stringbuf_create_empty(pool);
+  int segments = 1 + svn_test_rand(seed) % 4;
+  int i, k;
+
+  for (i = 0; i < segments; ++i)
+    {
+      int len = 1 + svn_test_rand(seed) % 3;
+
+      if (i > 0)
+        svn_stringbuf_appendbyte(path, '/');
+
+      for (k = 0; k < len; ++k)
+        svn_stringbuf_appendbyte(path, chars[svn_test_rand(seed)
+                                             % (sizeof(chars) - 1)]);
+
+      /* Avoid non-canonical "." segments. */
+      if (len == 1 && path->data[path->len - 1] == '.')
+        path->data[path->len - 1] = 'x';
+    }
+
+  return path->data;
+}
+
+/* Return an array of COUNT random paths allocated in POOL.  Use and
+ * update *SEED for random numbers. */
+static apr_array_header_t *
+random_paths(int count,
+             apr_uint32_t *seed,
+             apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, count,
+                                             sizeof(const char *));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    APR_ARRAY_PUSH(paths, const char *) = random_path(seed, pool);
+
+  return paths;
+}
+
+/* Verify that the path array SORTED has the same contents as the path
+ * array EXPECTED, which has been sorted by qsort(). */
+static svn_error_t *
+verify_sorted(const apr_array_header_t *sorted,
+              const apr_array_header_t *expected)
+{
+  int i;
+
+  SVN_TEST_ASSERT(sorted->nelts == expected->nelts);
+  for (i = 0; i < sorted->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(sorted, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort COUNT random paths with svn_sort__array() and compare the result
+ * with qsort().  Use and update *SEED for random numbers. */
+static svn_error_t *
+check_path_sort(int count,
+                apr_uint32_t *seed,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *paths = random_paths(count, seed, pool);
+  apr_array_header_t *expected = apr_array_copy(pool, paths);
+
+  qsort(expected->elts, expected->nelts, expected->elt_size,
+        svn_sort_compare_paths);
+  svn_sort__array(paths, svn_sort_compare_paths);
+
+  return svn_error_trace(verify_sorted(paths, expected));
+}
+
+static svn_error_t *
+test_sort_paths(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = (apr_uint32_t) apr_time_now();
+  int count;
+
+  for (count = 0; count < 300; ++count)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_path_sort(count, &seed, iterpool));
+    }
+
+  svn_pool_clear(iterpool);
+  SVN_ERR(check_path_sort(10000, &seed, iterpool));
+
+  /* Large enough to be sorted concurrently. */
+  svn_pool_clear(iterpool);
+  SVN_ERR(check_path_sort(100000, &seed, iterpool));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_sort__path_func_t for arrays of svn_sort__item_t. */
+static const char *
+item_key(const void *element)
+{
+  return ((const svn_sort__item_t *)element)->key;
+}
+
+static svn_error_t *
+test_sort_by_path(apr_pool_t *pool)
+{
+  apr_uint32_t seed = (apr_uint32_t) apr_time_now();
+  apr_array_header_t *paths = random_paths(1000, &seed, pool);
+  apr_array_header_t *items = apr_array_make(pool, paths->nelts,
+                                             sizeof(svn_sort__item_t));
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_array_header_t *sorted;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_sort__item_t *item = apr_array_push(items);
+      item->key = APR_ARRAY_IDX(paths, i, const char *);
+      item->klen = strlen(item->key);
+      item->value = &APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_hash_sets(hash, item->key, item->value);
+    }
+
+  /* Sorting by an embedded key must keep the values with their keys. */
+  svn_sort__array_by_path(items, item_key, pool);
+  for (i = 0; i < items->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(items, i, svn_sort__item_t);
+      SVN_TEST_ASSERT(*(const char **)item->value == item->key);
+
+      if (i > 0)
+        SVN_TEST_ASSERT(svn_path_compare_paths(
+                          APR_ARRAY_IDX(items, i - 1,
+                                        svn_sort__item_t).key,
+                          item->key) <= 0);
+    }
+
+  /* svn_sort__hash() must return the same order. */
+  sorted = svn_sort__hash(hash, svn_sort_compare_items_as_paths, pool);
+  SVN_TEST_ASSERT(sorted->nelts == apr_hash_count(hash));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      SVN_TEST_ASSERT(svn_hash_gets(hash, item->key) == item->value);
+
+      if (i > 0)
+        SVN_TEST_ASSERT(svn_path_compare_paths(
+                          APR_ARRAY_IDX(sorted, i - 1,
+                                        svn_sort__item_t).key,
+                          item->key) < 0);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sort_paths_throughput(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0;
+  apr_array_header_t *paths = apr_array_make(pool, THROUGHPUT_PATH_COUNT,
+                                             sizeof(const char *));
+  apr_array_header_t *copy;
+  apr_time_t start, qsort_time, serial_time, parallel_time;
+  int thread_limit = svn_task__get_thread_limit();
+  int i;
+
+  /* Paths as found in a typical large project. */
+  for (i = 0; i < THROUGHPUT_PATH_COUNT; ++i)
+    APR_ARRAY_PUSH(paths, const char *)
+      = apr_psprintf(pool, "trunk/project%d/src/module%d/file%d.c",
+                     (int)(svn_test_rand(&seed) % 50),
+                     (int)(svn_test_rand(&seed) % 300),
+                     (int)(svn_test_rand(&seed) % 100000));
+
+  copy = apr_array_copy(pool, paths);
+  start = apr_time_now();
+  qsort(copy->elts, copy->nelts, copy->elt_size, svn_sort_compare_paths);
+  qsort_time = apr_time_now() - start;
+
+  copy = apr_array_copy(pool, paths);
+  svn_task__set_thread_limit(1);
+  start = apr_time_now();
+  svn_sort__array(copy, svn_sort_compare_paths);
+  serial_time = apr_time_now() - start;
+
+  copy = apr_array_copy(pool, paths);
+  svn_task__set_thread_limit(thread_limit);
+  start = apr_time_now();
+  svn_sort__array(copy, svn_sort_compare_paths);
+  parallel_time = apr_time_now() - start;
+
+  for (i = 1; i < copy->nelts; ++i)
+    SVN_TEST_ASSERT(svn_path_compare_paths(
+                      APR_ARRAY_IDX(copy, i - 1, const char *),
+                      APR_ARRAY_IDX(copy, i, const char *)) <= 0);
+
+  if (opts->verbose)
+    printf("%d paths: qsort %" APR_TIME_T_FMT " ms, "
+           "radix %" APR_TIME_T_FMT " ms, "
+           "parallel radix %" APR_TIME_T_FMT " ms\n",
+           THROUGHPUT_PATH_COUNT, qsort_time / 1000, serial_time / 1000,
+           parallel_time / 1000);
+
+  return SVN_NO_ERROR;
+}
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_sort_paths,
+                   "sort path arrays"),
+    SVN_TEST_PASS2(test_sort_by_path,
+                   "sort arrays by embedded paths"),
+    SVN_TEST_OPTS_PASS(sort_paths_throughput,
+                       "path sorting throughput"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -253,6 +253,18 @@ test_spillbuf_file_spill_all(apr_pool_t *pool)
   return test_spillbuf__file(pool, altsize, buf);
 }
 
+static svn_error_t *
+test_spillbuf_file_mapped(apr_pool_t *pool)
+{
+  apr_size_t altsize = sizeof(basic_data) + 2;
+  svn_spillbuf_t *buf = svn_spillbuf__create(
+                          altsize /* blocksize */,
+                          2 * sizeof(basic_data) /* maxsize */,
+                          pool);
+  svn_spillbuf__set_read_mapped(buf, TRUE);
+  return test_spillbuf__file(pool, altsize, buf);
+}
+
 static svn_error_t *
 test_spillbuf__interleaving(apr_pool_t *pool, svn_spillbuf_t* buf)
 {
@@ -333,6 +345,56 @@ test_spillbuf_reader(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_spillbuf_reader_map(apr_pool_t *pool)
+{
+  svn_spillbuf_reader_t *sbr;
+  const char *data;
+  apr_size_t len;
+  apr_size_t amt;
+  char buf[10];
+  int i;
+
+  /* Everything fits into memory. */
+  sbr = svn_spillbuf__reader_create_extended(4 /* blocksize */,
+                                             100 /* maxsize */,
+                                             TRUE /* delete on close */,
+                                             TRUE /* spill all data */,
+                                             NULL, pool);
+  SVN_ERR(svn_spillbuf__reader_write(sbr, "abcdefghij", 10, pool));
+  SVN_ERR(svn_spillbuf__reader_map(&data, &len, sbr, pool, pool));
+  SVN_TEST_ASSERT(len == 10 && memcmp(data, "abcdefghij", 10) == 0);
+
+  /* Content spilled to disk.  This may be mapped into memory. */
+  sbr = svn_spillbuf__reader_create_extended(4 /* blocksize */,
+                                             10 /* maxsize */,
+                                             TRUE /* delete on close */,
+                                             TRUE /* spill all data */,
+                                             NULL, pool);
+  for (i = 0; i < 10; ++i)
+    SVN_ERR(svn_spillbuf__reader_write(sbr, "abcdefghij", 10, pool));
+  SVN_ERR(svn_spillbuf__reader_map(&data, &len, sbr, pool, pool));
+  SVN_TEST_ASSERT(len == 100);
+  for (i = 0; i < 10; ++i)
+    SVN_TEST_ASSERT(memcmp(data + 10 * i, "abcdefghij", 10) == 0);
+
+  /* Partially read content has to be copied. */
+  sbr = svn_spillbuf__reader_create_extended(4 /* blocksize */,
+                                             10 /* maxsize */,
+                                             TRUE /* delete on close */,
+                                             TRUE /* spill all data */,
+                                             NULL, pool);
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(svn_spillbuf__reader_write(sbr, "abcdefghij", 10, pool));
+  SVN_ERR(svn_spillbuf__reader_read(&amt, sbr, buf, 5, pool));
+  SVN_TEST_ASSERT(amt == 5 && memcmp(buf, "abcde", 5) == 0);
+  SVN_ERR(svn_spillbuf__reader_map(&data, &len, sbr, pool, pool));
+  SVN_TEST_ASSERT(len == 25);
+  SVN_TEST_ASSERT(memcmp(data, "fghijabcdefghijabcdefghij", 25) == 0);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_spillbuf_stream(apr_pool_t *pool)
 {
@@ -439,6 +501,16 @@ test_spillbuf_rwfile_spill_all(apr_pool_t *pool)
   return test_spillbuf__rwfile(pool, buf);
 }
 
+static svn_error_t *
+test_spillbuf_rwfile_mapped(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(4 /* blocksize */,
+                                             10 /* maxsize */,
+                                             pool);
+  svn_spillbuf__set_read_mapped(buf, TRUE);
+  return test_spillbuf__rwfile(pool, buf);
+}
+
 static svn_error_t *
 test_spillbuf__eof(apr_pool_t *pool, svn_spillbuf_t *buf)
 {
@@ -510,6 +582,16 @@ test_spillbuf_eof_spill_all(apr_pool_t *pool)
   return test_spillbuf__eof(pool, buf);
 }
 
+static svn_error_t *
+test_spillbuf_eof_mapped(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(4 /* blocksize */,
+                                             10 /* maxsize */,
+                                             pool);
+  svn_spillbuf__set_read_mapped(buf, TRUE);
+  return test_spillbuf__eof(pool, buf);
+}
+
 static svn_error_t *
 test_spillbuf__file_attrs(apr_pool_t *pool, svn_boolean_t spill_all,
                           svn_spillbuf_t *buf)
@@ -558,6 +640,17 @@ test_spillbuf_file_attrs_spill_all(apr_pool_t *pool)
   return test_spillbuf__file_attrs(pool, TRUE, buf);
 }
 
+static svn_error_t *
+test_spillbuf_adaptive_maxsize(apr_pool_t *pool)
+{
+  apr_size_t maxsize = svn_spillbuf__adaptive_maxsize(1000, 100000);
+
+  SVN_TEST_ASSERT(maxsize >= 1000 && maxsize <= 100000);
+  SVN_TEST_ASSERT(svn_spillbuf__adaptive_maxsize(1000, 1000) == 1000);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -579,6 +672,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_interleaving_spill_all,
                    "interleaving reads and writes (spill-all-data)"),
     SVN_TEST_PASS2(test_spillbuf_reader, "spill buffer reader test"),
+    SVN_TEST_PASS2(test_spillbuf_reader_map,
+                   "map spill buffer reader content"),
     SVN_TEST_PASS2(test_spillbuf_stream, "spill buffer stream test"),
     SVN_TEST_PASS2(test_spillbuf_rwfile, "read/write spill file"),
     SVN_TEST_PASS2(test_spillbuf_rwfile_spill_all,
@@ -589,6 +684,14 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_file_attrs, "check spill file properties"),
     SVN_TEST_PASS2(test_spillbuf_file_attrs_spill_all,
                    "check spill file properties (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_file_mapped,
+                   "spill buffer file test (mapped)"),
+    SVN_TEST_PASS2(test_spillbuf_rwfile_mapped,
+                   "read/write spill file (mapped)"),
+    SVN_TEST_PASS2(test_spillbuf_eof_mapped,
+                   "validate reaching EOF (mapped)"),
+    SVN_TEST_PASS2(test_spillbuf_adaptive_maxsize,
+                   "adaptive spill buffer memory limit"),
     SVN_TEST_NULL
   };
 
@@ -170,6 +170,82 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_wal(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb1;
+  svn_sqlite__db_t *sdb2;
+  svn_sqlite__stmt_t *stmt;
+  svn_sqlite__open_options_t options = { 0 };
+  const char *db_abspath;
+  const char *journal_mode;
+
+  static const char *const statements[] = {
+    "CREATE TABLE test (one TEXT NOT NULL PRIMARY KEY)",
+
+    "INSERT INTO test(one) VALUES ('foo')",
+
+    "SELECT one from test",
+
+    "PRAGMA journal_mode",
+
+    NULL
+  };
+
+  options.wal = TRUE;
+  options.mmap_size = 0x100000;
+  options.cache_size = 0x40000;
+  options.busy_timeout = 250;
+  options.busy_backoff = TRUE;
+
+  /* Create the database with default settings and re-open it twice
+     with all options set. */
+  SVN_ERR(open_db(&sdb1, &db_abspath, "wal", statements, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  SVN_ERR(svn_sqlite__open2(&sdb1, db_abspath, svn_sqlite__mode_readwrite,
+                            statements, &options, pool, pool));
+  SVN_ERR(svn_sqlite__open2(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
+                            statements, &options, pool, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb1, 3));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  journal_mode = svn_sqlite__column_text(stmt, 0, pool);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The test directory may be on a file system without WAL support. */
+  if (strcmp(journal_mode, "wal") == 0)
+    {
+      /* Unlike in test_sqlite_txn_commit_busy, an open read transaction
+         does not block the commit of a write transaction. */
+      SVN_ERR(svn_sqlite__begin_transaction(sdb1));
+      SVN_ERR(svn_sqlite__exec_statements(sdb1, 1 /* INSERT */));
+      SVN_ERR(svn_sqlite__begin_transaction(sdb2));
+      SVN_ERR(svn_sqlite__exec_statements(sdb2, 2 /* SELECT */));
+      SVN_ERR(svn_sqlite__finish_transaction(sdb1, SVN_NO_ERROR));
+      SVN_ERR(svn_sqlite__finish_transaction(sdb2, SVN_NO_ERROR));
+    }
+  else
+    {
+      SVN_TEST_STRING_ASSERT(journal_mode, "truncate");
+    }
+
+  SVN_ERR(svn_sqlite__close(sdb2));
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  /* Connections without the option switch the database back. */
+  SVN_ERR(svn_sqlite__open(&sdb1, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0, pool, pool));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb1, 3));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 0, pool), "truncate");
+  SVN_ERR(svn_sqlite__reset(stmt));
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +256,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_wal,
+                   "sqlite write-ahead logging and tuning options"),
     SVN_TEST_NULL
   };
 
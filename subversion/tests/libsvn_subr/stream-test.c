@@ -29,6 +29,7 @@
 #include <apr_general.h>
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -1000,6 +1001,161 @@ test_stream_readline_file_crlf(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Read all of STREAM through svn_stream__borrow(), asking for at most
+   LIMIT bytes at a time, and return the concatenated data in *RESULT. */
+static svn_error_t *
+borrow_all(svn_stringbuf_t **result,
+           svn_stream_t *stream,
+           apr_size_t limit,
+           apr_pool_t *pool)
+{
+  char buf[1000];
+
+  *result = svn_stringbuf_create_empty(pool);
+  while (1)
+    {
+      const char *data;
+      apr_size_t len = limit;
+
+      SVN_ERR(svn_stream__borrow(stream, &data, &len, buf, sizeof(buf)));
+      SVN_TEST_ASSERT(len <= limit);
+      svn_stringbuf_appendbytes(*result, data, len);
+      SVN_ERR(svn_stream__return(stream));
+
+      if (len == 0 || (data == buf && len < sizeof(buf)))
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stream_borrow(apr_pool_t *pool)
+{
+  /* Enough data for the file stream to map parts of it. */
+  const apr_size_t size = 300 * 1000 + 7;
+  svn_stringbuf_t *content = svn_stringbuf_create_ensure(size, pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result;
+  svn_spillbuf_t *spillbuf;
+  svn_stream_t *stream;
+  const char *path;
+  apr_size_t len;
+  apr_size_t i;
+
+  for (i = 0; i < size; ++i)
+    svn_stringbuf_appendbyte(content, (char)('a' + (i * 7 + i / 1000) % 26));
+
+  /* In-memory streams lend out their own buffers. */
+  stream = svn_stream_from_string(svn_string_create_from_buf(content, pool),
+                                  pool);
+  SVN_ERR(borrow_all(&result, stream, 12345, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  stream = svn_stream_from_stringbuf(content, pool);
+  SVN_ERR(borrow_all(&result, stream, APR_SIZE_MAX, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  /* Spill buffers lend out their blocks. */
+  spillbuf = svn_spillbuf__create(1000, 10000, pool);
+  SVN_ERR(svn_spillbuf__write(spillbuf, content->data, content->len, pool));
+  stream = svn_stream__from_spillbuf(spillbuf, pool);
+  SVN_ERR(borrow_all(&result, stream, 333, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  /* Files may get mapped.  Reading continues where borrowing ended. */
+  SVN_ERR(svn_io_write_unique(&path, NULL, content->data, content->len,
+                              svn_io_file_del_on_pool_cleanup, pool));
+  SVN_ERR(svn_stream_open_readonly(&stream, path, pool, pool));
+  SVN_ERR(borrow_all(&result, stream, 100000, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(svn_stream_open_readonly(&stream, path, pool, pool));
+  result = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_stream_copy3(svn_stream_disown(stream, pool),
+                           svn_stream_from_stringbuf(result, pool),
+                           NULL, NULL, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_stream_reset(stream));
+  SVN_ERR(svn_stream_copy3(stream, svn_stream_from_stringbuf(result, pool),
+                           NULL, NULL, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  /* Other streams get read into the caller's buffer. */
+  stream = svn_stream_compressed(svn_stream_from_stringbuf(compressed, pool),
+                                 pool);
+  len = content->len;
+  SVN_ERR(svn_stream_write(stream, content->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  stream = svn_stream_compressed(svn_stream_from_stringbuf(compressed, pool),
+                                 pool);
+  SVN_ERR(borrow_all(&result, stream, APR_SIZE_MAX, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, content));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_base64_block_sizes(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  apr_size_t len;
+  apr_size_t i;
+
+  /* Cover the vector code, the per-group code and their transitions,
+     with and without line breaks. */
+  for (len = 0; len < 300; ++len)
+    {
+      const svn_string_t *input;
+      const svn_string_t *encoded;
+      const svn_string_t *encoded_lines;
+      svn_stringbuf_t *joined;
+
+      svn_pool_clear(iterpool);
+      input = svn_string_ncreate(data->data, data->len, iterpool);
+
+      encoded = svn_base64_encode_string2(input, FALSE, iterpool);
+      SVN_TEST_ASSERT(encoded->len == (len + 2) / 3 * 4);
+      SVN_TEST_ASSERT(svn_string_compare(
+                        svn_base64_decode_string(encoded, iterpool),
+                        input));
+
+      /* Except for the new lines, the output must be the same. */
+      encoded_lines = svn_base64_encode_string2(input, TRUE, iterpool);
+      joined = svn_stringbuf_create_empty(iterpool);
+      for (i = 0; i < encoded_lines->len; ++i)
+        if (encoded_lines->data[i] != '\n')
+          svn_stringbuf_appendbyte(joined, encoded_lines->data[i]);
+        else
+          SVN_TEST_ASSERT(i % 77 == 76 || i + 1 == encoded_lines->len);
+
+      SVN_TEST_STRING_ASSERT(joined->data, encoded->data);
+      SVN_TEST_ASSERT(svn_string_compare(
+                        svn_base64_decode_string(encoded_lines, iterpool),
+                        input));
+
+      /* Append a byte that uses all bit positions over time. */
+      svn_stringbuf_appendbyte(data, (char)(len * 37 + (len >> 3)));
+    }
+
+  /* Line breaks at arbitrary positions and a 16 char block that only
+     contains the padding. */
+  SVN_TEST_STRING_ASSERT(svn_base64_decode_string(
+                           svn_string_create("TWFu\nTW\nFu TWFuTWFuTWFuTWFu"
+                                             "TWFuTWFuTWFuTWE=AAAAAAAAAAAA",
+                                             pool),
+                           pool)->data,
+                         "ManManManManManManManManManMa");
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1037,6 +1193,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
                    "test reading CRLF-terminated lines from file"),
+    SVN_TEST_PASS2(test_stream_borrow,
+                   "test borrowing stream buffers"),
+    SVN_TEST_PASS2(test_base64_block_sizes,
+                   "test base64 coding of various block sizes"),
     SVN_TEST_NULL
   };
 
@@ -872,6 +872,46 @@ test_string_matching(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_long_string_matching(apr_pool_t *pool)
+{
+  /* Long enough to span several vector chunks as well as a partial one. */
+  enum { BUFFER_SIZE = 203 };
+  char *a = apr_palloc(pool, BUFFER_SIZE);
+  char *b = apr_palloc(pool, BUFFER_SIZE);
+  apr_size_t offset, len, i;
+
+  for (i = 0; i < BUFFER_SIZE; ++i)
+    a[i] = (char)('a' + i % 23);
+
+  /* Try every mismatch position with every sub-string length as well as
+   * every start position within the buffers. */
+  for (offset = 0; offset < 19; ++offset)
+    for (len = 0; len + offset <= BUFFER_SIZE; ++len)
+      {
+        const char *sa = a + offset;
+        const char *sb = b + offset;
+
+        memcpy(b, a, BUFFER_SIZE);
+        SVN_TEST_ASSERT(svn_cstring__match_length(sa, sb, len) == len);
+        SVN_TEST_ASSERT(svn_cstring__reverse_match_length(sa + len, sb + len,
+                                                          len) == len);
+
+        for (i = 0; i < len; ++i)
+          {
+            b[offset + i] = '_';
+            SVN_TEST_ASSERT(svn_cstring__match_length(sa, sb, len) == i);
+            SVN_TEST_ASSERT(svn_cstring__reverse_match_length(sa + len,
+                                                              sb + len,
+                                                              len)
+                            == len - i - 1);
+            b[offset + i] = a[offset + i];
+          }
+      }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_cstring_skip_prefix(apr_pool_t *pool)
 {
@@ -1141,6 +1181,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test string similarity scores"),
     SVN_TEST_PASS2(test_string_matching,
                    "test string matching"),
+    SVN_TEST_PASS2(test_long_string_matching,
+                   "test string matching across long buffers"),
     SVN_TEST_PASS2(test_cstring_skip_prefix,
                    "test svn_cstring_skip_prefix()"),
     SVN_TEST_PASS2(test_stringbuf_replace_all,
@@ -0,0 +1,695 @@
+/* subr-bench.c -- measure the performance of hot libsvn_subr primitives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* All benchmarks run on fixed, generated corpora, so their results are
+ * comparable between builds.  Every result is printed as a single
+ * tab-separated line:
+ *
+ *   NAME  OPERATIONS  MICROSECONDS  OPS/S  MB/S
+ *
+ * Lines starting with '#' are comments.  That makes the output easy to
+ * collect per commit and to compare with the usual text tools.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <apr_general.h>
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "../svn_test.h"
+
+#include "svn_checksum.h"
+#include "svn_delta.h"
+#include "svn_diff.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_mergeinfo.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_cache.h"
+#include "private/svn_packed_data.h"
+#include "private/svn_string_private.h"
+
+
+/* Multiplier for the number of iterations of each benchmark. */
+static int scale = 1;
+
+/* Return the next pseudo-random number from *SEED. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/* Print the result of benchmark NAME that executed OPERATIONS operations
+ * on BYTES bytes of data in total and took DURATION.  BYTES may be 0. */
+static void
+print_result(const char *name,
+             apr_int64_t operations,
+             apr_int64_t bytes,
+             apr_interval_time_t duration)
+{
+  double seconds = (double)MAX(duration, 1) / APR_USEC_PER_SEC;
+
+  printf("%s\t%" APR_INT64_T_FMT "\t%" APR_INT64_T_FMT "\t%.1f\t%.1f\n",
+         name, operations, (apr_int64_t)duration, operations / seconds,
+         bytes / seconds / (1024 * 1024));
+  fflush(stdout);
+}
+
+/* Return a buffer of LEN bytes of pseudo-random, text-like data,
+ * allocated in POOL. */
+static svn_string_t *
+make_text(apr_size_t len,
+          apr_pool_t *pool)
+{
+  static const char alphabet[] = "etaoinshrdlu cmfwyp\n";
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(len, pool);
+  apr_uint32_t seed = 12345;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    buffer->data[i] = alphabet[next_random(&seed) % (sizeof(alphabet) - 1)];
+
+  buffer->data[len] = '\0';
+  buffer->len = len;
+
+  return svn_stringbuf__morph_into_string(buffer);
+}
+
+/* Return a copy of TEXT with a small modification every STRIDE bytes,
+ * allocated in POOL. */
+static svn_string_t *
+modify_text(const svn_string_t *text,
+            apr_size_t stride,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(text->len, pool);
+  apr_size_t pos;
+
+  for (pos = 0; pos < text->len; pos += stride)
+    {
+      apr_size_t chunk = MIN(text->len - pos, stride);
+
+      svn_stringbuf_appendbytes(result, text->data + pos, chunk);
+      if (chunk > 8)
+        {
+          memcpy(result->data + result->len - 4, "XYZ\n", 4);
+          svn_stringbuf_appendcstr(result, "inserted\n");
+        }
+    }
+
+  return svn_stringbuf__morph_into_string(result);
+}
+
+
+/*** Checksums. ***/
+
+static svn_error_t *
+bench_checksum(apr_pool_t *pool)
+{
+  static const struct
+  {
+    const char *name;
+    svn_checksum_kind_t kind;
+  } kinds[] =
+  {
+    { "checksum/md5", svn_checksum_md5 },
+    { "checksum/sha1", svn_checksum_sha1 },
+    { "checksum/fnv1a_32x4", svn_checksum_fnv1a_32x4 }
+  };
+
+  svn_string_t *data = make_text(16 * 1024 * 1024, pool);
+  int iterations = 4 * scale;
+  int i, k;
+
+  for (k = 0; k < (int)(sizeof(kinds) / sizeof(kinds[0])); ++k)
+    {
+      apr_time_t start = apr_time_now();
+      svn_checksum_t *checksum;
+
+      for (i = 0; i < iterations; ++i)
+        SVN_ERR(svn_checksum(&checksum, kinds[k].kind, data->data, data->len,
+                             pool));
+
+      print_result(kinds[k].name, iterations,
+                   (apr_int64_t)data->len * iterations,
+                   apr_time_now() - start);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Delta computation. ***/
+
+static svn_error_t *
+bench_txdelta(apr_pool_t *pool)
+{
+  svn_string_t *source = make_text(4 * 1024 * 1024, pool);
+  svn_string_t *target = modify_text(source, 1024, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int iterations = 4 * scale;
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_txdelta_stream_t *delta_stream;
+      svn_txdelta_window_t *window;
+
+      svn_pool_clear(iterpool);
+      svn_txdelta2(&delta_stream,
+                   svn_stream_from_string(source, iterpool),
+                   svn_stream_from_string(target, iterpool),
+                   FALSE, iterpool);
+
+      do
+        SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+      while (window);
+    }
+
+  print_result("txdelta/xdelta", iterations,
+               (apr_int64_t)target->len * iterations,
+               apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Packed data. ***/
+
+static svn_error_t *
+bench_packed_data(apr_pool_t *pool)
+{
+  enum { INT_COUNT = 1000000, STRING_COUNT = 100000 };
+
+  svn_packed__data_root_t *root = svn_packed__data_create_root(pool);
+  svn_packed__int_stream_t *ints = svn_packed__create_int_stream(root, TRUE,
+                                                                 FALSE);
+  svn_packed__byte_stream_t *bytes = svn_packed__create_bytes_stream(root);
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 0;
+  apr_uint64_t value = 0;
+  int iterations = 4 * scale;
+  apr_time_t start;
+  int i, k;
+
+  /* Mostly increasing numbers, like offsets and revisions. */
+  for (i = 0; i < INT_COUNT; ++i)
+    {
+      value += next_random(&seed) % 1000;
+      svn_packed__add_uint(ints, value);
+    }
+
+  for (i = 0; i < STRING_COUNT; ++i)
+    {
+      const char *name = apr_psprintf(iterpool, "trunk/dir%d/file%u.c",
+                                      i % 100, next_random(&seed) % 10000);
+      svn_packed__add_bytes(bytes, name, strlen(name));
+    }
+
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(serialized, pool),
+                                 root, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_packed__data_root_t *read_root;
+      svn_packed__int_stream_t *read_ints;
+      svn_packed__byte_stream_t *read_bytes;
+      svn_string_t *data;
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+      data = svn_string_ncreate(serialized->data, serialized->len, iterpool);
+      SVN_ERR(svn_packed__data_read(&read_root,
+                                    svn_stream_from_string(data, iterpool),
+                                    iterpool, iterpool));
+
+      read_ints = svn_packed__first_int_stream(read_root);
+      for (k = 0; k < INT_COUNT; ++k)
+        svn_packed__get_uint(read_ints);
+
+      read_bytes = svn_packed__first_byte_stream(read_root);
+      for (k = 0; k < STRING_COUNT; ++k)
+        svn_packed__get_bytes(read_bytes, &len);
+    }
+
+  print_result("packed_data/read", iterations,
+               (apr_int64_t)serialized->len * iterations,
+               apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Path canonicalization. ***/
+
+static svn_error_t *
+bench_canonicalize(apr_pool_t *pool)
+{
+  enum { PATH_COUNT = 10000 };
+
+  const char **dirents = apr_palloc(pool, PATH_COUNT * sizeof(*dirents));
+  const char **relpaths = apr_palloc(pool, PATH_COUNT * sizeof(*relpaths));
+  const char **uris = apr_palloc(pool, PATH_COUNT * sizeof(*uris));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 0;
+  int iterations = 20 * scale;
+  apr_time_t start;
+  int i, k;
+
+  /* Half of the paths are canonical already, which is the common case. */
+  for (i = 0; i < PATH_COUNT; ++i)
+    {
+      int a = next_random(&seed) % 100;
+      int b = next_random(&seed) % 1000;
+      svn_boolean_t canonical = i % 2;
+
+      dirents[i] = apr_psprintf(pool, canonical ? "/home/user/wc/dir%d/f%d.c"
+                                                : "/home//user/./wc/dir%d/"
+                                                  "f%d.c/",
+                                a, b);
+      relpaths[i] = apr_psprintf(pool, canonical ? "trunk/dir%d/f%d.c"
+                                                 : "trunk/./dir%d//f%d.c/",
+                                 a, b);
+      uris[i] = apr_psprintf(pool, canonical
+                                   ? "https://svn.example.com/repos/dir%d/f%d"
+                                   : "HTTPS://svn.Example.com:443/repos//"
+                                     "dir%d/f%%7e%d/",
+                             a, b);
+    }
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      for (k = 0; k < PATH_COUNT; ++k)
+        svn_dirent_canonicalize(dirents[k], iterpool);
+    }
+  print_result("canonicalize/dirent", (apr_int64_t)iterations * PATH_COUNT,
+               0, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      for (k = 0; k < PATH_COUNT; ++k)
+        svn_relpath_canonicalize(relpaths[k], iterpool);
+    }
+  print_result("canonicalize/relpath", (apr_int64_t)iterations * PATH_COUNT,
+               0, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      for (k = 0; k < PATH_COUNT; ++k)
+        svn_uri_canonicalize(uris[k], iterpool);
+    }
+  print_result("canonicalize/uri", (apr_int64_t)iterations * PATH_COUNT,
+               0, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Mergeinfo. ***/
+
+/* Return the string representation of mergeinfo for PATH_COUNT branches
+ * with RANGE_COUNT revision ranges each.  Use SEED for the ranges and
+ * allocate the result in POOL. */
+static const char *
+make_mergeinfo(int path_count,
+               int range_count,
+               apr_uint32_t seed,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  int i, k;
+
+  for (i = 0; i < path_count; ++i)
+    {
+      svn_revnum_t rev = 0;
+
+      svn_stringbuf_appendcstr(result,
+                               apr_psprintf(pool, "/branches/b%d:", i));
+      for (k = 0; k < range_count; ++k)
+        {
+          svn_revnum_t start = rev + 1 + next_random(&seed) % 20;
+          svn_revnum_t end = start + next_random(&seed) % 5;
+
+          svn_stringbuf_appendcstr(result,
+                                   apr_psprintf(pool, "%s%ld-%ld%s",
+                                                k ? "," : "", start, end,
+                                                k % 7 == 3 ? "*" : ""));
+          rev = end + 1;
+        }
+
+      svn_stringbuf_appendbyte(result, '\n');
+    }
+
+  return result->data;
+}
+
+static svn_error_t *
+bench_mergeinfo(apr_pool_t *pool)
+{
+  const char *text1 = make_mergeinfo(200, 50, 1, pool);
+  const char *text2 = make_mergeinfo(200, 50, 2, pool);
+  svn_mergeinfo_t mergeinfo1, mergeinfo2;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int iterations = 20 * scale;
+  apr_time_t start;
+  int i;
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_mergeinfo_parse(&mergeinfo1, text1, iterpool));
+    }
+  print_result("mergeinfo/parse", iterations,
+               (apr_int64_t)strlen(text1) * iterations,
+               apr_time_now() - start);
+
+  SVN_ERR(svn_mergeinfo_parse(&mergeinfo1, text1, pool));
+  SVN_ERR(svn_mergeinfo_parse(&mergeinfo2, text2, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_mergeinfo_t target;
+
+      svn_pool_clear(iterpool);
+      target = svn_mergeinfo_dup(mergeinfo1, iterpool);
+      SVN_ERR(svn_mergeinfo_merge2(target, mergeinfo2, iterpool, iterpool));
+    }
+  print_result("mergeinfo/merge", iterations, 0, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Text diff. ***/
+
+static svn_error_t *
+bench_diff(apr_pool_t *pool)
+{
+  svn_string_t *original = make_text(1024 * 1024, pool);
+  svn_string_t *modified = modify_text(original, 2048, pool);
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int iterations = 4 * scale;
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_diff_t *diff;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_diff_mem_string_diff(&diff, original, modified, options,
+                                       iterpool));
+    }
+
+  print_result("diff/mem_string", iterations,
+               (apr_int64_t)original->len * iterations,
+               apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Membuffer cache. ***/
+
+/* Size of the values we put into the cache. */
+#define CACHE_VALUE_SIZE 64
+
+/* Number of distinct keys used in the cache benchmark. */
+#define CACHE_KEY_COUNT 10000
+
+/* Implements svn_cache__serialize_func_t for CACHE_VALUE_SIZE blobs. */
+static svn_error_t *
+serialize_blob(void **data,
+               apr_size_t *data_len,
+               void *in,
+               apr_pool_t *pool)
+{
+  *data_len = CACHE_VALUE_SIZE;
+  *data = apr_pmemdup(pool, in, CACHE_VALUE_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for CACHE_VALUE_SIZE blobs. */
+static svn_error_t *
+deserialize_blob(void **out,
+                 void *data,
+                 apr_size_t data_len,
+                 apr_pool_t *pool)
+{
+  *out = apr_pmemdup(pool, data, data_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Per-thread parameters and result of cache_worker(). */
+typedef struct cache_baton_t
+{
+  svn_cache__t *cache;
+  const char **keys;
+  int operations;
+  apr_uint32_t seed;
+  svn_error_t *err;
+} cache_baton_t;
+
+/* Run the cache_baton_t *BATON's operations with 90% reads and 10%
+ * writes on random keys. */
+static svn_error_t *
+run_cache_operations(cache_baton_t *baton)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  char value[CACHE_VALUE_SIZE] = { 0 };
+  int i;
+
+  for (i = 0; i < baton->operations; ++i)
+    {
+      apr_uint32_t random = next_random(&baton->seed);
+      const char *key = baton->keys[random % CACHE_KEY_COUNT];
+
+      if (i % 64 == 0)
+        svn_pool_clear(pool);
+
+      if (random % 10 == 0)
+        {
+          SVN_ERR(svn_cache__set(baton->cache, key, value, pool));
+        }
+      else
+        {
+          void *result;
+          svn_boolean_t found;
+
+          SVN_ERR(svn_cache__get(&result, &found, baton->cache, key, pool));
+        }
+    }
+
+  svn_pool_destroy(pool);
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Thread function calling run_cache_operations() on DATA. */
+static void * APR_THREAD_FUNC
+cache_worker(apr_thread_t *thread,
+             void *data)
+{
+  cache_baton_t *baton = data;
+  baton->err = run_cache_operations(baton);
+
+  return NULL;
+}
+#endif
+
+static svn_error_t *
+bench_membuffer_cache(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  const char **keys = apr_palloc(pool, CACHE_KEY_COUNT * sizeof(*keys));
+  int operations = 400000 * scale;
+  int thread_count;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 16 * 1024 * 1024,
+                                            1024 * 1024, 0, 8, TRUE, TRUE,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_blob, deserialize_blob,
+                                            APR_HASH_KEY_STRING, "bench:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            svn_cache__admission_default,
+                                            TRUE, FALSE, pool, pool));
+
+  for (i = 0; i < CACHE_KEY_COUNT; ++i)
+    keys[i] = apr_psprintf(pool, "key-%d", i);
+
+  /* The same total number of operations, spread over more and more
+   * threads. */
+  for (thread_count = 1; thread_count <= 8; thread_count *= 2)
+    {
+      cache_baton_t *batons = apr_pcalloc(pool,
+                                          thread_count * sizeof(*batons));
+      apr_time_t start;
+      const char *name;
+
+      for (i = 0; i < thread_count; ++i)
+        {
+          batons[i].cache = cache;
+          batons[i].keys = keys;
+          batons[i].operations = operations / thread_count;
+          batons[i].seed = i;
+        }
+
+      start = apr_time_now();
+
+#if APR_HAS_THREADS
+      {
+        apr_thread_t **threads = apr_pcalloc(pool, thread_count
+                                                   * sizeof(*threads));
+        apr_threadattr_t *attr;
+        apr_status_t status;
+
+        status = apr_threadattr_create(&attr, pool);
+        for (i = 0; i < thread_count && !status; ++i)
+          status = apr_thread_create(&threads[i], attr, cache_worker,
+                                     &batons[i], pool);
+
+        for (i = 0; i < thread_count && threads[i]; ++i)
+          {
+            apr_status_t retval;
+            apr_thread_join(&retval, threads[i]);
+          }
+
+        if (status)
+          return svn_error_wrap_apr(status, "Can't create thread");
+      }
+#else
+      for (i = 0; i < thread_count; ++i)
+        batons[i].err = run_cache_operations(&batons[i]);
+#endif
+
+      for (i = 0; i < thread_count; ++i)
+        SVN_ERR(batons[i].err);
+
+      name = apr_psprintf(pool, "membuffer_cache/%d-threads", thread_count);
+      print_result(name, (apr_int64_t)batons[0].operations * thread_count, 0,
+                   apr_time_now() - start);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Main. ***/
+
+static const struct
+{
+  const char *name;
+  svn_error_t *(*func)(apr_pool_t *pool);
+} benchmarks[] =
+{
+  { "checksum", bench_checksum },
+  { "txdelta", bench_txdelta },
+  { "packed_data", bench_packed_data },
+  { "canonicalize", bench_canonicalize },
+  { "mergeinfo", bench_mergeinfo },
+  { "diff", bench_diff },
+  { "membuffer_cache", bench_membuffer_cache }
+};
+
+/* Number of entries in benchmarks[]. */
+#define BENCHMARK_COUNT ((int)(sizeof(benchmarks) / sizeof(benchmarks[0])))
+
+int
+main(int argc, char **argv)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *pool;
+  int first_filter = 1;
+  int i, k;
+
+  if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")))
+    {
+      printf("usage: %s [-s SCALE] [BENCHMARK...]\n\n"
+             "Run all benchmarks or only those given.  SCALE multiplies the\n"
+             "number of iterations (default: 1).  Available benchmarks:\n",
+             argv[0]);
+      for (k = 0; k < BENCHMARK_COUNT; ++k)
+        printf("  %s\n", benchmarks[k].name);
+      exit(0);
+    }
+
+  if (argc > 2 && !strcmp(argv[1], "-s"))
+    {
+      scale = MAX(atoi(argv[2]), 1);
+      first_filter = 3;
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+
+  printf("# name\toperations\tusec\tops/s\tMB/s\n");
+  for (k = 0; k < BENCHMARK_COUNT && !err; ++k)
+    {
+      svn_boolean_t selected = first_filter >= argc;
+      apr_pool_t *iterpool;
+
+      for (i = first_filter; i < argc; ++i)
+        if (!strcmp(argv[i], benchmarks[k].name))
+          selected = TRUE;
+
+      if (!selected)
+        continue;
+
+      iterpool = svn_pool_create(pool);
+      err = benchmarks[k].func(iterpool);
+      svn_pool_destroy(iterpool);
+    }
+
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "subr-bench: ");
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+  exit(0);
+}
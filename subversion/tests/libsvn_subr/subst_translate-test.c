@@ -31,6 +31,7 @@
 #include "svn_string.h"
 #include "svn_subst.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
 
 #define ARRAY_LEN(ary) ((sizeof (ary)) / (sizeof ((ary)[0])))
 
@@ -500,6 +501,103 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Translate SRC to EOL_STR, expanding KEYWORDS if not NULL, by writing it
+   to a translating stream in pieces of at most CHUNK_SIZE bytes.  Return
+   the result in *RESULT. */
+static svn_error_t *
+translate_in_chunks(const char **result,
+                    const char *src,
+                    const char *eol_str,
+                    apr_hash_t *keywords,
+                    apr_size_t chunk_size,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *dst_stringbuf = svn_stringbuf_create_empty(pool);
+  svn_stream_t *dst_stream = svn_stream_from_stringbuf(dst_stringbuf, pool);
+  apr_size_t remaining = strlen(src);
+
+  dst_stream = svn_subst_stream_translated(dst_stream, eol_str, TRUE,
+                                           keywords, TRUE, pool);
+  while (remaining)
+    {
+      apr_size_t len = remaining < chunk_size ? remaining : chunk_size;
+
+      SVN_ERR(svn_stream_write(dst_stream, src, &len));
+      src += len;
+      remaining -= len;
+    }
+  SVN_ERR(svn_stream_close(dst_stream));
+
+  *result = dst_stringbuf->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svn_subst_translate_chunked(apr_pool_t *pool)
+{
+  static const char *const eol_strs[] = { "\n", "\r", "\r\n" };
+  static const char *const sources[] =
+    {
+      "a plain line that is longer than any vector register\n"
+      "another one\nand no trailing newline",
+      "a line ending in CRLF, longer than sixteen bytes\r\n"
+      "an old Mac line\rmixed\n\r\n\r\rend",
+      "some text before the keyword $Rev$ and after it\n"
+      "0123456789abcdef0123456789abcdef $Rev: 17 $\r\n$Rev$",
+    };
+  apr_hash_t *keywords = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, j;
+  apr_size_t chunk_size;
+
+  svn_hash_sets(keywords, SVN_KEYWORD_REVISION_SHORT,
+                svn_string_create("42", pool));
+
+  for (i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+    for (j = 0; j < sizeof(eol_strs) / sizeof(eol_strs[0]); j++)
+      {
+        const char *expected_plain, *expected_kw;
+
+        svn_pool_clear(iterpool);
+        SVN_ERR(svn_subst_translate_cstring2(sources[i], &expected_plain,
+                                             eol_strs[j], TRUE, NULL, TRUE,
+                                             iterpool));
+        SVN_ERR(svn_subst_translate_cstring2(sources[i], &expected_kw,
+                                             eol_strs[j], TRUE, keywords,
+                                             TRUE, iterpool));
+
+        for (chunk_size = 1; chunk_size <= 40; chunk_size++)
+          {
+            const char *result;
+
+            SVN_ERR(translate_in_chunks(&result, sources[i], eol_strs[j],
+                                        NULL, chunk_size, iterpool));
+            SVN_TEST_STRING_ASSERT(result, expected_plain);
+
+            SVN_ERR(translate_in_chunks(&result, sources[i], eol_strs[j],
+                                        keywords, chunk_size, iterpool));
+            SVN_TEST_STRING_ASSERT(result, expected_kw);
+          }
+      }
+
+  /* A CRLF split between two writes must not be passed through as is. */
+  {
+    svn_stringbuf_t *dst_stringbuf = svn_stringbuf_create_empty(pool);
+    svn_stream_t *dst_stream = svn_stream_from_stringbuf(dst_stringbuf,
+                                                         pool);
+
+    dst_stream = svn_subst_stream_translated(dst_stream, "\r", TRUE,
+                                             NULL, TRUE, pool);
+    SVN_ERR(svn_stream_puts(dst_stream, "a\r"));
+    SVN_ERR(svn_stream_puts(dst_stream, "\nb"));
+    SVN_ERR(svn_stream_close(dst_stream));
+    SVN_TEST_STRING_ASSERT(dst_stringbuf->data, "a\rb");
+  }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +617,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_translate_chunked,
+                   "test translating streams written in pieces"),
     SVN_TEST_NULL
   };
 
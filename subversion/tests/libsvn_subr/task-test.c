@@ -0,0 +1,199 @@
+/*
+ * task-test.c -- test the svn_task__* API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "private/svn_task.h"
+
+#include "../svn_test.h"
+
+/* Number of tasks to run in each test. */
+#define TASK_COUNT 500
+
+/* Implements svn_task__process_func_t.  Return the square of the number
+ * given as PROCESS_BATON. */
+static svn_error_t *
+square(void **result,
+       void *process_baton,
+       svn_cancel_func_t cancel_func,
+       void *cancel_baton,
+       apr_pool_t *result_pool,
+       apr_pool_t *scratch_pool)
+{
+  int value = (int)(apr_uintptr_t)process_baton;
+  int *square_value = apr_palloc(result_pool, sizeof(*square_value));
+
+  SVN_ERR(cancel_func(cancel_baton));
+  *square_value = value * value;
+  *result = square_value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Fail for the number given as
+ * PROCESS_BATON being 100. */
+static svn_error_t *
+fail_at_100(void **result,
+            void *process_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  if ((apr_uintptr_t)process_baton == 100)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL, "task failed");
+
+  return svn_error_trace(square(result, process_baton, cancel_func,
+                                cancel_baton, result_pool, scratch_pool));
+}
+
+/* Implements svn_task__output_func_t.  OUTPUT_BATON is an int counting
+ * the results received so far.  Verify that RESULT is the square of it. */
+static svn_error_t *
+check_square(void *result,
+             void *output_baton,
+             apr_pool_t *scratch_pool)
+{
+  int *count = output_baton;
+
+  SVN_TEST_ASSERT(*(int *)result == *count * *count);
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Run a nested task set and return
+ * the number of results it delivered. */
+static svn_error_t *
+run_nested_set(void **result,
+               void *process_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_task__set_t *set;
+  int *count = apr_pcalloc(result_pool, sizeof(*count));
+  apr_uintptr_t i;
+
+  SVN_ERR(svn_task__set_create(&set, 0, check_square, count,
+                               cancel_func, cancel_baton, scratch_pool));
+  for (i = 0; i < 20; ++i)
+    SVN_ERR(svn_task__add(set, square, (void *)i));
+  SVN_ERR(svn_task__set_finish(set));
+
+  *result = count;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Add the int in RESULT to the int
+ * in OUTPUT_BATON. */
+static svn_error_t *
+sum_up(void *result,
+       void *output_baton,
+       apr_pool_t *scratch_pool)
+{
+  *(int *)output_baton += *(int *)result;
+  return SVN_NO_ERROR;
+}
+
+/* Run the basic checks with the current thread limit. */
+static svn_error_t *
+run_task_sets(apr_pool_t *pool)
+{
+  svn_task__set_t *set;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int count = 0;
+  apr_uintptr_t i;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Results arrive in order. */
+  SVN_ERR(svn_task__set_create(&set, 0, check_square, &count, NULL, NULL,
+                               iterpool));
+  for (i = 0; i < TASK_COUNT; ++i)
+    SVN_ERR(svn_task__add(set, square, (void *)i));
+  SVN_ERR(svn_task__set_finish(set));
+  SVN_TEST_ASSERT(count == TASK_COUNT);
+  svn_pool_clear(iterpool);
+
+  /* Nested task sets don't block each other. */
+  count = 0;
+  SVN_ERR(svn_task__set_create(&set, 0, sum_up, &count, NULL, NULL,
+                               iterpool));
+  for (i = 0; i < 50; ++i)
+    SVN_ERR(svn_task__add(set, run_nested_set, NULL));
+  SVN_ERR(svn_task__set_finish(set));
+  SVN_TEST_ASSERT(count == 50 * 20);
+  svn_pool_clear(iterpool);
+
+  /* Errors get reported. */
+  SVN_ERR(svn_task__set_create(&set, 2, NULL, NULL, NULL, NULL, iterpool));
+  for (i = 0; i < TASK_COUNT && !err; ++i)
+    err = svn_task__add(set, fail_at_100, (void *)i);
+  if (!err)
+    err = svn_task__set_finish(set);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_TEST_FAILED);
+  svn_pool_clear(iterpool);
+
+  /* Sets may be destroyed with tasks outstanding. */
+  SVN_ERR(svn_task__set_create(&set, 0, NULL, NULL, NULL, NULL, iterpool));
+  for (i = 0; i < 10; ++i)
+    SVN_ERR(svn_task__add(set, square, (void *)i));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_task_set(apr_pool_t *pool)
+{
+  return svn_error_trace(run_task_sets(pool));
+}
+
+static svn_error_t *
+test_task_set_no_threads(apr_pool_t *pool)
+{
+  int limit = svn_task__get_thread_limit();
+  svn_error_t *err;
+
+  svn_task__set_thread_limit(0);
+  err = run_task_sets(pool);
+  svn_task__set_thread_limit(limit);
+
+  return svn_error_trace(err);
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_task_set,
+                   "test task sets"),
+    SVN_TEST_PASS2(test_task_set_no_threads,
+                   "test task sets without worker threads"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
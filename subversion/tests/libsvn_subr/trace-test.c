@@ -0,0 +1,112 @@
+/*
+ * trace-test.c -- test the svn_trace__* API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "private/svn_trace.h"
+
+#include "../svn_test.h"
+
+/* Stand-in for a traced operation that fails with ERROR_CODE. */
+static svn_error_t *
+failing_operation(apr_status_t error_code)
+{
+  return svn_error_create(error_code, NULL, NULL);
+}
+
+static svn_error_t *
+test_trace_spans(apr_pool_t *pool)
+{
+#ifdef SVN_DISABLE_TRACING
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "tracing has been disabled at compile time");
+#else
+  apr_pool_t *trace_pool = svn_pool_create(pool);
+  const char *tmp_dir, *path;
+  svn_stringbuf_t *contents;
+  svn_trace__span_t *outer, *inner;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "trace-test", pool));
+  path = svn_dirent_join(tmp_dir, "trace.json", pool);
+
+  SVN_TEST_ASSERT(!svn_trace__enabled());
+  SVN_TEST_ASSERT(svn_trace__begin("ignored") == NULL);
+
+  SVN_ERR(svn_trace__init(path, trace_pool));
+  SVN_TEST_ASSERT(svn_trace__enabled());
+
+  /* Nested spans with attributes that need escaping. */
+  outer = svn_trace__begin("outer");
+  SVN_TEST_ASSERT(outer != NULL);
+  svn_trace__attr(outer, "path", "a\"b\\c");
+  svn_trace__attr_int(outer, "revision", 42);
+
+  inner = svn_trace__begin("inner");
+  err = svn_trace__end(inner, failing_operation(SVN_ERR_FS_NOT_FOUND));
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_FS_NOT_FOUND);
+  SVN_ERR(svn_trace__end(outer, SVN_NO_ERROR));
+
+  /* Tracing ends with its pool. */
+  svn_pool_destroy(trace_pool);
+  SVN_TEST_ASSERT(!svn_trace__enabled());
+  SVN_TEST_ASSERT(svn_trace__begin("ignored") == NULL);
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  SVN_TEST_ASSERT(strncmp(contents->data, "[\n", 2) == 0);
+  SVN_TEST_ASSERT(strstr(contents->data, "\"name\":\"inner\",\"ph\":\"X\""));
+  SVN_TEST_ASSERT(strstr(contents->data, "\"name\":\"outer\",\"ph\":\"X\""));
+  SVN_TEST_ASSERT(strstr(contents->data,
+                         apr_psprintf(pool, "\"args\":{\"error\":%d}",
+                                      SVN_ERR_FS_NOT_FOUND)));
+  SVN_TEST_ASSERT(strstr(contents->data,
+                         "\"args\":{\"path\":\"a\\\"b\\\\c\","
+                         "\"revision\":42}"));
+  SVN_TEST_ASSERT(!strstr(contents->data, "ignored"));
+
+  /* The inner span has been finished first. */
+  SVN_TEST_ASSERT(strstr(contents->data, "\"inner\"")
+                  < strstr(contents->data, "\"outer\""));
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_trace_spans,
+                   "test nested trace spans"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
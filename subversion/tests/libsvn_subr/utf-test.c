@@ -24,6 +24,8 @@
 #include "../svn_test.h"
 #include "svn_utf.h"
 #include "svn_pools.h"
+#include "svn_ctype.h"
+#include "svn_sorts.h"
 
 #include "private/svn_string_private.h"
 #include "private/svn_utf_private.h"
@@ -215,6 +217,76 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare the vectorized ASCII scans in svn_utf__is_valid and
+   svn_utf__is_plain_ascii against byte-wise implementations. */
+static svn_error_t *
+utf_validate_mostly_ascii(apr_pool_t *pool)
+{
+  /* Multi-byte chars and a few invalid sequences to sprinkle in. */
+  static const char *const specials[] = {
+    "\xc3\xa4", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xc3", "\xed\xa0\x80",
+    "\x80", "\x01", "\x7f", "\t", "\r\n"
+  };
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 100000; ++i)
+    {
+      char str[100];
+      apr_size_t len = range_rand(0, sizeof(str) - 5);
+      apr_size_t j;
+      svn_boolean_t plain = TRUE;
+
+      for (j = 0; j < len; ++j)
+        str[j] = (char)range_rand(' ', '~');
+
+      /* Overwrite a random position with a special sequence. */
+      if (len > 0 && range_rand(0, 1))
+        {
+          const char *special
+            = specials[range_rand(0, sizeof(specials) / sizeof(specials[0])
+                                     - 1)];
+          apr_size_t pos = range_rand(0, (apr_uint32_t)len - 1);
+
+          memcpy(str + pos, special, strlen(special));
+          len = MAX(len, pos + strlen(special));
+        }
+
+      for (j = 0; j < len; ++j)
+        if (!svn_ctype_isascii(str[j])
+            || (svn_ctype_iscntrl(str[j]) && !svn_ctype_isspace(str[j])))
+          plain = FALSE;
+
+      SVN_TEST_ASSERT(svn_utf__is_plain_ascii(str, len) == plain);
+      SVN_TEST_ASSERT(svn_utf__is_valid(str, len)
+                      == (svn_utf__last_valid2(str, len) == str + len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that plain ASCII round-trips through the native encoding. */
+static svn_error_t *
+test_utf_cstring_ascii(apr_pool_t *pool)
+{
+  const char *ascii = "trunk/sub dir/file-1.c\t";
+  const char *dest;
+
+  SVN_ERR(svn_utf_cstring_to_utf8(&dest, ascii, pool));
+  SVN_TEST_STRING_ASSERT(dest, ascii);
+  SVN_TEST_ASSERT(dest != ascii);
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&dest, ascii, pool));
+  SVN_TEST_STRING_ASSERT(dest, ascii);
+  SVN_TEST_ASSERT(dest != ascii);
+
+  /* Invalid UTF-8 must still be rejected. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn_utf_cstring_from_utf8(&dest, "a\xc3", pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -407,6 +479,15 @@ test_utf_collated_compare(apr_pool_t *pool)
     {mixup,   '<', lowcase,   "mixup",   "lowcase"},
     {lowcase, '>', mixup,     "lowcase",  "mixup"},
 
+    /* Common prefix */
+    {"dir/a",               '<', "dir/b",              "ascii a", "ascii b"},
+    {"dir/ab",              '>', "dir/a",              "ascii",   "shorter"},
+    {"dir/e\xcc\x81",       '=', "dir/\xc3\xa9",       "nfd",     "nfc"},
+    {"dir/e",               '<', "dir/e\xcc\x81",      "base",    "marked"},
+    {"dir/eb",              '<', "dir/e\xcc\x81",      "ascii",   "marked"},
+    {"dir/\xc3\xa9" "a",   '>', "dir/e\xcc\x81",      "longer",  "nfd"},
+    {"dir/s\xcc\x87\xcc\xa3", '=', "dir/s\xcc\xa3\xcc\x87", "mixup",   "nfd"},
+
     {NULL, 0, NULL, NULL, NULL}
   };
 
@@ -991,6 +1072,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate_mostly_ascii,
+                   "test is_valid/is_plain_ascii on mostly ASCII"),
+    SVN_TEST_PASS2(test_utf_cstring_ascii,
+                   "test plain ASCII cstring conversions"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
@@ -39,6 +39,7 @@
 #include "svn_repos.h"
 #include "svn_wc.h"
 #include "svn_client.h"
+#include "svn_config.h"
 
 #include "utils.h"
 
@@ -170,6 +171,107 @@ pristine_write_read(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Write, read and remove a compressed pristine text that spans several
+ * compression blocks. */
+static svn_error_t *
+pristine_write_read_compressed(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  svn_config_t *config;
+
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *data_sha1, *data_md5;
+  const char *pristine_abspath;
+  const char *expanded_abspath;
+  svn_node_kind_t kind;
+  apr_size_t sz;
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_write_read_compressed", opts, pool));
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_COMPRESS_PRISTINES, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  for (i = 0; i < 20000; i++)
+    svn_stringbuf_appendcstr(data, apr_psprintf(pool, "line %d\n", i % 7));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  sz = data->len;
+  SVN_ERR(svn_stream_write(pristine_stream, data->data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                      data_sha1, data_md5, pool));
+
+  /* Only the compressed form is on disk. */
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath, wc_abspath,
+                                              data_sha1, pool, pool));
+  SVN_ERR(svn_io_check_path(pristine_abspath, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Read the pristine text back and verify its size and content. */
+  {
+    svn_stream_t *data_read_back;
+    svn_filesize_t size;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, &size, db, wc_abspath,
+                                     data_sha1, pool, pool));
+    SVN_TEST_ASSERT(size == data->len);
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                      svn_stream_from_stringbuf(data, pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* Asking for the path expands the text into a temporary file, once. */
+  {
+    const char *path;
+    svn_stringbuf_t *contents;
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&expanded_abspath, db, wc_abspath,
+                                         data_sha1, pool, pool));
+    SVN_TEST_ASSERT(strcmp(expanded_abspath, pristine_abspath) != 0);
+    SVN_ERR(svn_stringbuf_from_file2(&contents, expanded_abspath, pool));
+    SVN_TEST_ASSERT(svn_stringbuf_compare(contents, data));
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&path, db, wc_abspath, data_sha1,
+                                         pool, pool));
+    SVN_TEST_STRING_ASSERT(path, expanded_abspath);
+    SVN_ERR(svn_io_check_path(pristine_abspath, &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+
+  /* Removing the text removes both forms. */
+  {
+    svn_boolean_t present;
+
+    SVN_ERR(svn_wc__db_pristine_remove(db, wc_abspath, data_sha1, pool));
+    SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(! present);
+    SVN_ERR(svn_io_check_path(pristine_abspath, &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+
+  /* Closing the DB removes the expanded copy. */
+  SVN_ERR(svn_wc__db_close(db));
+  SVN_ERR(svn_io_check_path(expanded_abspath, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
 /* Test deleting a pristine text while it is open for reading. */
 static svn_error_t *
 pristine_delete_while_open(const svn_test_opts_t *opts,
@@ -318,6 +420,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_write_read_compressed,
+                       "pristine_write_read_compressed"),
     SVN_TEST_NULL
   };
 
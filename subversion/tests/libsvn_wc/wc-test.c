@@ -24,6 +24,8 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 #include <apr_md5.h>
+#include <apr_mmap.h>
+#include <apr_strings.h>
 
 #define SVN_DEPRECATED
 
@@ -41,7 +43,11 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_atomic.h"
+#include "private/svn_task.h"
 #include "../../libsvn_wc/wc.h"
+#include "../../libsvn_wc/adm_files.h"
+#include "../../libsvn_wc/journal.h"
 #include "../../libsvn_wc/wc_db.h"
 #define SVN_WC__I_AM_WC_DB
 #include "../../libsvn_wc/wc_db_private.h"
@@ -323,7 +329,8 @@ test_legacy_commit1(const svn_test_opts_t *opts, apr_pool_t *pool)
 
 
   SVN_ERR(svn_io_remove_file2(lambda, FALSE, pool));
-  SVN_ERR(svn_io_copy_file(sbox_wc_path(&b, "iota"), lambda, FALSE, pool));
+  SVN_ERR(svn_io_copy_file2(sbox_wc_path(&b, "iota"), lambda, 0, NULL,
+                            pool));
   SVN_ERR(svn_wc_adm_open3(&adm_access, NULL, b.wc_abspath, TRUE, -1,
                            NULL, NULL, pool));
 
@@ -386,7 +393,8 @@ test_legacy_commit2(const svn_test_opts_t *opts, apr_pool_t *pool)
   lambda = sbox_wc_path(&b, "A_copied/B/lambda");
 
   SVN_ERR(svn_io_remove_file2(lambda, FALSE, pool));
-  SVN_ERR(svn_io_copy_file(sbox_wc_path(&b, "iota"), lambda, FALSE, pool));
+  SVN_ERR(svn_io_copy_file2(sbox_wc_path(&b, "iota"), lambda, 0, NULL,
+                            pool));
 
   SVN_ERR(svn_wc_adm_open3(&adm_access, NULL, b.wc_abspath, TRUE, -1,
                            NULL, NULL, pool));
@@ -493,6 +501,408 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_clear_racy_fileinfo(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const char *iota_path, *mu_path;
+  apr_time_t recent_time = apr_time_now();
+  apr_time_t old_time = recent_time - apr_time_from_sec(10);
+  apr_time_t recorded_time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "clear_racy_fileinfo", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  iota_path = sbox_wc_path(&b, "iota");
+  mu_path = sbox_wc_path(&b, "A/mu");
+
+  /* A timestamp recorded within the last granule is racy, an older one
+     is not. */
+  SVN_ERR(svn_wc__db_global_record_fileinfo(b.wc_ctx->db, iota_path,
+                                            25, recent_time, pool));
+  SVN_ERR(svn_wc__db_global_record_fileinfo(b.wc_ctx->db, mu_path,
+                                            23, old_time, pool));
+
+  SVN_ERR(svn_wc__db_clear_racy_fileinfo(b.wc_ctx->db, pool));
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &recorded_time,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, b.wc_ctx->db, iota_path, pool, pool));
+  SVN_TEST_ASSERT(recorded_time == 0);
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &recorded_time,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, b.wc_ctx->db, mu_path, pool, pool));
+  SVN_TEST_ASSERT(recorded_time == old_time);
+
+  return SVN_NO_ERROR;
+}
+
+/* A change journal watcher that runs concurrently with a test. */
+typedef struct journal_watcher_t
+{
+  svn_task__set_t *set;
+  const char *wcroot_abspath;
+  volatile svn_atomic_t stop;
+} journal_watcher_t;
+
+/* Implements svn_cancel_func_t for journal_watcher_t. */
+static svn_error_t *
+journal_watcher_cancel(void *baton)
+{
+  journal_watcher_t *watcher = baton;
+
+  if (svn_atomic_read(&watcher->stop))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t for journal_watcher_t. */
+static svn_error_t *
+journal_watcher_task(void **result,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  journal_watcher_t *watcher = process_baton;
+
+  *result = NULL;
+  return svn_error_trace(svn_wc__journal_watch(watcher->wcroot_abspath,
+                                               cancel_func, cancel_baton,
+                                               scratch_pool));
+}
+
+/* Stop WATCHER and return its error, unless it simply got stopped. */
+static svn_error_t *
+stop_journal_watcher(journal_watcher_t *watcher)
+{
+  svn_error_t *err;
+
+  svn_atomic_set(&watcher->stop, TRUE);
+  err = svn_task__set_finish(watcher->set);
+  if (err && svn_error_find_cause(err, SVN_ERR_CANCELLED))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Start watching the working copy of B in *WATCHER and wait until readers
+   may use the journal.  Skip the test if that is not supported. */
+static svn_error_t *
+start_journal_watcher(journal_watcher_t **watcher,
+                      svn_test__sandbox_t *b,
+                      apr_pool_t *pool)
+{
+  journal_watcher_t *result = apr_pcalloc(pool, sizeof(*result));
+  const char *barrier_abspath
+    = svn_wc__adm_child(b->wc_abspath, SVN_WC__ADM_JOURNAL_BARRIER, pool);
+  apr_time_t deadline = apr_time_now() + apr_time_from_sec(30);
+  svn_error_t *err;
+
+  if (svn_task__get_thread_limit() == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "the watcher needs a worker thread");
+
+  result->wcroot_abspath = b->wc_abspath;
+  SVN_ERR(svn_task__set_create(&result->set, 1, NULL, NULL,
+                               journal_watcher_cancel, result, pool));
+  SVN_ERR(svn_task__add(result->set, journal_watcher_task, result));
+
+  /* The watcher creates the barrier directory last. */
+  do
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(barrier_abspath, &kind, pool));
+      if (kind == svn_node_dir)
+        {
+          *watcher = result;
+          return SVN_NO_ERROR;
+        }
+
+      apr_sleep(apr_time_from_msec(1));
+    }
+  while (apr_time_now() < deadline);
+
+  err = stop_journal_watcher(result);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err,
+                            "working copies can't be watched here");
+  SVN_ERR(err);
+
+  return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                          "the watcher didn't start");
+}
+
+/* Set *CONTENTS to the journal of the working copy of B. */
+static svn_error_t *
+read_journal(svn_stringbuf_t **contents,
+             svn_test__sandbox_t *b,
+             apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_stringbuf_from_file2(contents,
+                                    svn_wc__adm_child(b->wc_abspath,
+                                                      SVN_WC__ADM_JOURNAL,
+                                                      pool),
+                                    pool));
+}
+
+/* Baton for collect_node_status(). */
+typedef struct status_collector_t
+{
+  /* The working copy being walked. */
+  const char *wcroot_abspath;
+
+  /* WC relpath -> enum svn_wc_status_kind *, allocated in its pool. */
+  apr_hash_t *statuses;
+} status_collector_t;
+
+/* Implements svn_wc_status_func4_t for status_collector_t. */
+static svn_error_t *
+collect_node_status(void *baton,
+                    const char *local_abspath,
+                    const svn_wc_status3_t *status,
+                    apr_pool_t *scratch_pool)
+{
+  status_collector_t *collector = baton;
+  apr_pool_t *pool = apr_hash_pool_get(collector->statuses);
+  const char *relpath = svn_dirent_skip_ancestor(collector->wcroot_abspath,
+                                                 local_abspath);
+
+  svn_hash_sets(collector->statuses, apr_pstrdup(pool, relpath),
+                apr_pmemdup(pool, &status->node_status,
+                            sizeof(status->node_status)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Walk the status of PATH in the working copy of B using its journal and
+   return the node status of every interesting node in *STATUSES, mapping
+   WC relpaths to enum svn_wc_status_kind. */
+static svn_error_t *
+journaled_status(apr_hash_t **statuses,
+                 svn_test__sandbox_t *b,
+                 const char *path,
+                 apr_pool_t *pool)
+{
+  status_collector_t collector;
+
+  collector.wcroot_abspath = b->wc_abspath;
+  collector.statuses = apr_hash_make(pool);
+  SVN_ERR(svn_wc__walk_status_journaled(b->wc_ctx, sbox_wc_path(b, path),
+                                        svn_depth_infinity, FALSE, FALSE,
+                                        NULL, collect_node_status, &collector,
+                                        NULL, NULL, pool));
+  *statuses = collector.statuses;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the node status of RELPATH in STATUSES, as returned by
+   journaled_status(). */
+static enum svn_wc_status_kind
+node_status(apr_hash_t *statuses,
+            const char *relpath)
+{
+  enum svn_wc_status_kind *status = svn_hash_gets(statuses, relpath);
+
+  return status ? *status : svn_wc_status_none;
+}
+
+static svn_error_t *
+test_journal_priming(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  journal_watcher_t *watcher;
+  svn_stringbuf_t *journal;
+  apr_hash_t *statuses;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "journal_priming", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_file_write(&b, "A/unversioned", "unversioned\n"));
+
+  SVN_ERR(start_journal_watcher(&watcher, &b, pool));
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "prime\n");
+
+  /* Walks below the root can't prime the journal. */
+  SVN_ERR(journaled_status(&statuses, &b, "A", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/unversioned")
+                  == svn_wc_status_unversioned);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "prime\n");
+
+  /* A full walk records the directories that differ from wc.db. */
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/unversioned")
+                  == svn_wc_status_unversioned);
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 1);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "clean\nD A\n");
+
+  /* The primed journal still finds everything. */
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/unversioned")
+                  == svn_wc_status_unversioned);
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 1);
+
+  SVN_ERR(stop_journal_watcher(watcher));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_journal_clean(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  journal_watcher_t *watcher;
+  svn_stringbuf_t *journal;
+  apr_hash_t *statuses;
+  const char *mu_path;
+  apr_time_t old_time = apr_time_now() - apr_time_from_sec(10);
+  apr_finfo_t finfo;
+#if APR_HAS_MMAP
+  apr_file_t *file;
+  apr_mmap_t *mmap;
+#endif
+
+  SVN_ERR(svn_test__sandbox_create(&b, "journal_clean", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Make sure that any later write changes the timestamp of A/mu. */
+  mu_path = sbox_wc_path(&b, "A/mu");
+  SVN_ERR(svn_io_set_file_affected_time(old_time, mu_path, pool));
+  SVN_ERR(svn_io_stat(&finfo, mu_path, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                      pool));
+  SVN_ERR(svn_wc__db_global_record_fileinfo(b.wc_ctx->db, mu_path,
+                                            finfo.size, finfo.mtime, pool));
+
+#if APR_HAS_MMAP
+  /* Map A/mu for writing.  Closing the file is the last event that this
+     produces; later writes through the mapping come without any. */
+  SVN_ERR(svn_io_file_open(&file, mu_path, APR_READ | APR_WRITE,
+                           APR_OS_DEFAULT, pool));
+  SVN_TEST_ASSERT(apr_mmap_create(&mmap, file, 0, (apr_size_t)finfo.size,
+                                  APR_MMAP_READ | APR_MMAP_WRITE, pool)
+                  == APR_SUCCESS);
+  SVN_ERR(svn_io_file_close(file, pool));
+#endif
+
+  SVN_ERR(start_journal_watcher(&watcher, &b, pool));
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 0);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "clean\n");
+
+  /* A change made right before the walk must be seen by it. */
+  SVN_ERR(sbox_file_write(&b, "A/B/new", "new\n"));
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/B/new")
+                  == svn_wc_status_unversioned);
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 1);
+
+#if APR_HAS_MMAP
+  /* The journal can't tell that A/mu changed; the walk still must. */
+  ((char *)mmap->mm)[0] = 'X';
+  SVN_TEST_ASSERT(apr_mmap_delete(mmap) == APR_SUCCESS);
+
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/mu") == svn_wc_status_modified);
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 2);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "clean\nD A/B\n");
+#endif
+
+  SVN_ERR(stop_journal_watcher(watcher));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_journal_restart(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  journal_watcher_t *watcher;
+  svn_stringbuf_t *journal;
+  apr_hash_t *statuses;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "journal_restart", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(start_journal_watcher(&watcher, &b, pool));
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "clean\n");
+
+  /* Cleanup makes the watcher start over, just like after an overflow of
+     its event queue.  Nothing recorded before may be trusted anymore. */
+  SVN_ERR(svn_wc_cleanup4(b.wc_ctx, b.wc_abspath, FALSE, FALSE, FALSE,
+                          FALSE, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_STRING_ASSERT(journal->data, "prime\n");
+
+  SVN_ERR(sbox_file_write(&b, "A/C/new", "new\n"));
+  SVN_ERR(journaled_status(&statuses, &b, "A", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/C/new")
+                  == svn_wc_status_unversioned);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_ASSERT(strncmp(journal->data, "prime\n", 6) == 0);
+
+  SVN_ERR(journaled_status(&statuses, &b, "", pool));
+  SVN_TEST_ASSERT(node_status(statuses, "A/C/new")
+                  == svn_wc_status_unversioned);
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 1);
+  SVN_ERR(read_journal(&journal, &b, pool));
+  SVN_TEST_ASSERT(strncmp(journal->data, "clean\n", 6) == 0);
+
+  SVN_ERR(stop_journal_watcher(watcher));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sqlite_wal_default(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stream_t *stream;
+  const char *db_abspath;
+  char header[20];
+  apr_size_t len = sizeof(header);
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "sqlite_wal_default", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Bytes 18 and 19 of an SQLite database are 2 in WAL mode and 1 with
+     a rollback journal.  Working copies must not switch to WAL mode
+     unless the user explicitly asked for it. */
+  db_abspath = svn_wc__adm_child(b.wc_abspath, "wc.db", pool);
+  SVN_ERR(svn_stream_open_readonly(&stream, db_abspath, pool, pool));
+  SVN_ERR(svn_stream_read_full(stream, header, &len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_INT_ASSERT(len, sizeof(header));
+  SVN_TEST_INT_ASSERT(header[18], 1);
+  SVN_TEST_INT_ASSERT(header[19], 1);
+
+  SVN_ERR(svn_io_check_path(apr_pstrcat(pool, db_abspath, "-wal",
+                                        SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +925,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_clear_racy_fileinfo,
+                       "test clearing racy recorded timestamps"),
+    SVN_TEST_OPTS_PASS(test_journal_priming,
+                       "test priming the change journal"),
+    SVN_TEST_OPTS_PASS(test_journal_clean,
+                       "test status walks using a clean journal"),
+    SVN_TEST_OPTS_PASS(test_journal_restart,
+                       "test status walks after the journal restarted"),
+    SVN_TEST_OPTS_PASS(test_sqlite_wal_default,
+                       "working copies don't default to sqlite wal"),
     SVN_TEST_NULL
   };
 
@@ -149,21 +149,19 @@ maybe_install_fs_conf(svn_fs_t *fs,
   if (strcmp(opts->fs_type, "fsfs") == 0)
     {
       *must_reopen = TRUE;
-      return svn_io_copy_file(opts->config_file,
-                              svn_path_join(svn_fs_path(fs, pool),
-                                            "fsfs.conf", pool),
-                              FALSE /* copy_perms */,
-                              pool);
+      return svn_io_copy_file2(opts->config_file,
+                               svn_path_join(svn_fs_path(fs, pool),
+                                             "fsfs.conf", pool),
+                               0, NULL, pool);
     }
 
   if (strcmp(opts->fs_type, "fsx") == 0)
     {
       *must_reopen = TRUE;
-      return svn_io_copy_file(opts->config_file,
-                              svn_path_join(svn_fs_path(fs, pool),
-                                            "fsx.conf", pool),
-                              FALSE /* copy_perms */,
-                              pool);
+      return svn_io_copy_file2(opts->config_file,
+                               svn_path_join(svn_fs_path(fs, pool),
+                                             "fsx.conf", pool),
+                               0, NULL, pool);
     }
 
   return SVN_NO_ERROR;
@@ -0,0 +1,238 @@
+/* svnwatch
+ *
+ * Watch a working copy for changes on disk, so that 'svn status' needs
+ * to list only the directories that changed.
+ *
+ * To compile this, go to the root of the Subversion source tree and
+ * call `make svnwatch'. You will find the executable file next to this
+ * source file.
+ *
+ * If you want to "install" svnwatch, you may call `make install-tools'
+ * in the Subversion source tree root.
+ * (Note: This also installs any other installable tools.)
+ *
+ * svnwatch cannot be compiled separate from a Subversion source tree.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+#include "svn_wc.h"
+#include "svn_utf.h"
+#include "svn_path.h"
+#include "svn_dirent_uri.h"
+#include "svn_opt.h"
+#include "svn_version.h"
+
+#include "private/svn_wc_private.h"
+#include "private/svn_cmdline_private.h"
+
+#include "svn_private_config.h"
+
+#define OPT_VERSION SVN_OPT_FIRST_LONGOPT_ID
+
+static svn_error_t *
+version(apr_pool_t *pool)
+{
+  return svn_opt_print_help4(NULL, "svnwatch", TRUE, FALSE, FALSE,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool);
+}
+
+static void
+usage(apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf
+                  (stderr, pool,
+                   _("Type 'svnwatch --help' for usage.\n")));
+}
+
+static void
+help(const apr_getopt_option_t *options, apr_pool_t *pool)
+{
+  svn_error_clear
+    (svn_cmdline_fprintf
+     (stdout, pool,
+      _("usage: svnwatch [OPTIONS] [WC_PATH]\n"
+        "\n"
+        "  Watch the working copy containing WC_PATH (default: '.') for\n"
+        "  changes until interrupted.  While svnwatch runs, 'svn status'\n"
+        "  only lists the directories that changed on disk.\n"
+        "\n"
+        "  The first 'svn status' run on the whole working copy after\n"
+        "  svnwatch started reads everything once.  The same happens after\n"
+        "  svnwatch missed events, e.g. because too much changed at once,\n"
+        "  and after 'svn cleanup'.\n"
+        "\n"
+        "Valid options:\n")));
+  while (options->description)
+    {
+      const char *optstr;
+      svn_opt_format_option(&optstr, options, TRUE, pool);
+      svn_error_clear(svn_cmdline_fprintf(stdout, pool, "  %s\n", optstr));
+      ++options;
+    }
+}
+
+
+/* Version compatibility check */
+static svn_error_t *
+check_lib_versions(void)
+{
+  static const svn_version_checklist_t checklist[] =
+    {
+      { "svn_subr",   svn_subr_version },
+      { "svn_wc",     svn_wc_version },
+      { NULL, NULL }
+    };
+  SVN_VERSION_DEFINE(my_version);
+
+  return svn_ver_check_list2(&my_version, checklist, svn_ver_equal);
+}
+
+/*
+ * On success, leave *EXIT_CODE untouched and return SVN_NO_ERROR. On error,
+ * either return an error to be displayed, or set *EXIT_CODE to non-zero and
+ * return SVN_NO_ERROR.
+ */
+static svn_error_t *
+sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
+{
+  apr_getopt_t *os;
+  const apr_getopt_option_t options[] =
+    {
+      {"help", 'h', 0, N_("display this help")},
+      {"version", OPT_VERSION, 0,
+       N_("show program version information")},
+      {0,             0,  0,  0}
+    };
+  const char *path = "";
+  const char *local_abspath;
+  svn_wc_context_t *wc_ctx;
+  svn_cancel_func_t cancel_func;
+  svn_error_t *err;
+
+  /* Check library versions */
+  SVN_ERR(check_lib_versions());
+
+#if defined(WIN32) || defined(__CYGWIN__)
+  /* Set the working copy administrative directory name. */
+  if (getenv("SVN_ASP_DOT_NET_HACK"))
+    {
+      SVN_ERR(svn_wc_set_adm_dir("_svn", pool));
+    }
+#endif
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+
+  os->interleave = 1;
+  while (1)
+    {
+      int opt;
+      const char *arg;
+      apr_status_t status = apr_getopt_long(os, options, &opt, &arg);
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        {
+          usage(pool);
+          *exit_code = EXIT_FAILURE;
+          return SVN_NO_ERROR;
+        }
+
+      switch (opt)
+        {
+        case 'h':
+          help(options, pool);
+          return SVN_NO_ERROR;
+        case OPT_VERSION:
+          SVN_ERR(version(pool));
+          return SVN_NO_ERROR;
+        default:
+          usage(pool);
+          *exit_code = EXIT_FAILURE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (os->ind < argc)
+    SVN_ERR(svn_utf_cstring_to_utf8(&path, os->argv[os->ind++], pool));
+
+  if (os->ind < argc)
+    {
+      usage(pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath,
+                                  svn_dirent_internal_style(path, pool),
+                                  pool));
+  SVN_ERR(svn_wc_context_create(&wc_ctx, NULL, pool, pool));
+
+  cancel_func = svn_cmdline__setup_cancellation_handler();
+
+  err = svn_wc__watch_changes(wc_ctx, local_abspath, cancel_func, NULL,
+                              pool);
+
+  /* Being interrupted is how we normally stop. */
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+    }
+
+  return svn_error_compose_create(err, svn_wc_context_destroy(wc_ctx));
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  /* Initialize the app. */
+  if (svn_cmdline_init("svnwatch", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  /* Create our top-level pool.  Use a separate mutexless allocator,
+   * given this application is single threaded.
+   */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+
+  /* Flush stdout and report if it fails. It would be flushed on exit anyway
+     but this makes sure that output is not silently lost if it fails. */
+  err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
+
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "svnwatch: ");
+    }
+
+  svn_pool_destroy(pool);
+
+  svn_cmdline__cancellation_exit();
+
+  return exit_code;
+}
@@ -0,0 +1,612 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Usage: make_fixture.py [options] OUTPUT_DIR
+
+Write a synthetic repository of production shape as a dump file to
+OUTPUT_DIR/fixture.dump.  The history is fully determined by the profile
+and the seed, so the same options always produce the same dump.  It has:
+
+  - trunk/src: a tree of text files receiving small edits,
+  - branches/*: branches of trunk and of other branches that receive
+    their own edits and get merged back into their parent, recording
+    svn:mergeinfo, and deleted afterwards; merges happen more often than
+    branching but keep --min-branches branches alive,
+  - tags/*: plain copies of trunk,
+  - trunk/bigdir: one huge directory, filled in batches and then
+    receiving occasional single-file changes,
+  - trunk/assets: large binary files with occasional partial changes,
+  - trunk/hot.txt: a file changed in every revision, which gives the
+    longest possible delta chains.
+
+OUTPUT_DIR/fixture.json describes the fixture for run_fixture_bench.py,
+e.g. which file to blame and which branch to merge.
+
+Profiles (revisions / source files / bigdir entries / binaries):
+
+  small       1,000 /    200 /   1,000 / 2 x  1 MB
+  medium    100,000 /  2,000 /  20,000 / 4 x 16 MB
+  large   1,000,000 / 10,000 / 100,000 / 4 x 32 MB
+  huge    3,000,000 / 20,000 / 250,000 / 8 x 32 MB
+
+All profile values can be overridden by the respective options.
+
+Example:
+  make_fixture.py --profile=medium --seed=1 /data/fixtures/medium-1
+  svnadmin create /tmp/repos
+  svnadmin load -q /tmp/repos < /data/fixtures/medium-1/fixture.dump
+"""
+
+import binascii
+import difflib
+import json
+import optparse
+import os
+import random
+import sys
+import time
+
+PROFILES = {
+  'small':  dict(revisions=1000, files=200, bigdir=1000,
+                 binaries=2, binary_size=1 << 20),
+  'medium': dict(revisions=100000, files=2000, bigdir=20000,
+                 binaries=4, binary_size=16 << 20),
+  'large':  dict(revisions=1000000, files=10000, bigdir=100000,
+                 binaries=4, binary_size=32 << 20),
+  'huge':   dict(revisions=3000000, files=20000, bigdir=250000,
+                 binaries=8, binary_size=32 << 20),
+}
+
+# Files per directory in trunk/src.
+FILES_PER_DIR = 50
+
+# Maximum svndiff window size accepted by the loader.
+WINDOW_SIZE = 100 * 1024
+
+# Number of entries added to trunk/bigdir per revision until it is full.
+BIGDIR_BATCH = 1000
+
+AUTHORS = ['alice', 'bob', 'carol', 'dave', 'erin', 'frank', 'grace',
+           'heidi', 'ivan', 'judy', 'mallory', 'oscar', 'peggy', 'trent']
+
+WORDS = ['static', 'const', 'return', 'apr_pool_t', 'svn_error_t',
+         'if', 'else', 'while', 'for', 'int', 'char', 'void', 'NULL',
+         'SVN_ERR', 'baton', 'result', 'scratch_pool', 'path', 'revision',
+         'svn_stringbuf_t', 'TRUE', 'FALSE', 'len', 'data', 'entry']
+
+# Dates start here and span this many seconds over all revisions.
+START_DATE = 1104537600   # 2005-01-01
+DATE_SPAN = 10 * 365 * 86400
+
+
+def props_to_bytes(props):
+  """Return the dump file representation of the dict PROPS."""
+  parts = []
+  for name in sorted(props):
+    value = props[name]
+    parts.append(b'K %d\n%s\nV %d\n%s\n'
+                 % (len(name), name, len(value), value))
+  parts.append(b'PROPS-END\n')
+  return b''.join(parts)
+
+
+def format_range(revision_range):
+  """Return REVISION_RANGE as used in svn:mergeinfo."""
+  start, end = revision_range
+  if start == end:
+    return '%d' % start
+  return '%d-%d' % (start, end)
+
+
+def encode_int(value):
+  """Return VALUE in the variable-length integer encoding of svndiff."""
+  result = [value & 0x7f]
+  value >>= 7
+  while value:
+    result.append(0x80 | (value & 0x7f))
+    value >>= 7
+  return bytes(bytearray(reversed(result)))
+
+
+def encode_instruction(opcode, length, offset=None):
+  """Return an svndiff instruction.  OPCODE is 0 for copies from the
+  source and 2 for new data."""
+  if length < 64:
+    result = bytes(bytearray([(opcode << 6) | length]))
+  else:
+    result = bytes(bytearray([opcode << 6])) + encode_int(length)
+  if offset is not None:
+    result += encode_int(offset)
+  return result
+
+
+def common_prefix_len(a, b):
+  """Return the length of the common prefix of the byte strings A and B."""
+  low, high = 0, min(len(a), len(b))
+  while low < high:
+    middle = (low + high + 1) // 2
+    if a[:middle] == b[:middle]:
+      low = middle
+    else:
+      high = middle - 1
+  return low
+
+
+def affix_pieces(source, target, prefix=None, suffix=None):
+  """Return the pieces of a delta from SOURCE to TARGET that copies their
+  longest common PREFIX and SUFFIX and inserts the rest of TARGET.  Each
+  piece is a tuple (SOURCE_OFFSET, TARGET_OFFSET, LENGTH) where
+  SOURCE_OFFSET is None for new data."""
+  if prefix is None:
+    prefix = common_prefix_len(source, target)
+  if suffix is None:
+    suffix = common_prefix_len(source[prefix:][::-1], target[prefix:][::-1])
+
+  return [(0, 0, prefix),
+          (None, prefix, len(target) - prefix - suffix),
+          (len(source) - suffix, len(target) - suffix, suffix)]
+
+
+def line_pieces(old_lines, new_lines):
+  """Like affix_pieces() but for a line-based diff between the texts
+  made of OLD_LINES and NEW_LINES, which may differ in many places."""
+  def offsets(lines):
+    result = [0]
+    for line in lines:
+      result.append(result[-1] + len(line.encode('utf-8')) + 1)
+    return result
+
+  old_offsets = offsets(old_lines)
+  new_offsets = offsets(new_lines)
+  matcher = difflib.SequenceMatcher(None, old_lines, new_lines,
+                                    autojunk=False)
+  pieces = []
+  for tag, i1, i2, j1, j2 in matcher.get_opcodes():
+    length = new_offsets[j2] - new_offsets[j1]
+    if tag == 'equal':
+      pieces.append((old_offsets[i1], new_offsets[j1], length))
+    else:
+      pieces.append((None, new_offsets[j1], length))
+  return pieces
+
+
+def svndiff(target, pieces):
+  """Return an svndiff0 delta that produces TARGET from PIECES, as
+  returned by affix_pieces().  Every window holds exactly one
+  instruction and stays below the maximum window size."""
+  windows = [b'SVN\0']
+  view_offset, view_len = 0, 0
+  for source_offset, target_offset, length in pieces:
+    for start in range(0, length, WINDOW_SIZE):
+      chunk = min(WINDOW_SIZE, length - start)
+      if source_offset is None:
+        # Keep the previous source view; views must not slide backwards.
+        data = target[target_offset + start:target_offset + start + chunk]
+        instruction = encode_instruction(2, chunk)
+      else:
+        view_offset, view_len = source_offset + start, chunk
+        data = b''
+        instruction = encode_instruction(0, chunk, 0)
+      windows.append(encode_int(view_offset) + encode_int(view_len)
+                     + encode_int(chunk) + encode_int(len(instruction))
+                     + encode_int(len(data)) + instruction + data)
+
+  return b''.join(windows)
+
+
+class DumpWriter(object):
+  """Write a dump stream of format version 3 to a binary file object."""
+
+  def __init__(self, out, uuid):
+    self.out = out
+    out.write(b'SVN-fs-dump-format-version: 3\n\n')
+    out.write(b'UUID: %s\n\n' % uuid)
+
+  def revision(self, revnum, props):
+    content = props_to_bytes(props)
+    self.out.write(b'Revision-number: %d\n'
+                   b'Prop-content-length: %d\n'
+                   b'Content-length: %d\n\n'
+                   % (revnum, len(content), len(content)))
+    self.out.write(content)
+    self.out.write(b'\n')
+
+  def node(self, path, action, kind=None, props=None, text=None,
+           copyfrom=None, delta=False):
+    headers = [b'Node-path: %s\n' % path.encode('utf-8')]
+    if kind:
+      headers.append(b'Node-kind: %s\n' % kind)
+    headers.append(b'Node-action: %s\n' % action)
+    if copyfrom:
+      headers.append(b'Node-copyfrom-rev: %d\n' % copyfrom[1])
+      headers.append(b'Node-copyfrom-path: %s\n'
+                     % copyfrom[0].encode('utf-8'))
+
+    prop_content = b''
+    if props is not None:
+      prop_content = props_to_bytes(props)
+      headers.append(b'Prop-content-length: %d\n' % len(prop_content))
+    if delta:
+      headers.append(b'Text-delta: true\n')
+    if text is not None:
+      headers.append(b'Text-content-length: %d\n' % len(text))
+    if props is not None or text is not None:
+      headers.append(b'Content-length: %d\n'
+                     % (len(prop_content) + len(text or b'')))
+
+    self.out.write(b''.join(headers))
+    self.out.write(b'\n')
+    self.out.write(prop_content)
+    if text is not None:
+      self.out.write(text)
+    self.out.write(b'\n\n')
+
+
+class Line(object):
+  """A line of development: trunk or a branch."""
+
+  def __init__(self, path, parent, created, files, mergeinfo):
+    self.path = path
+    self.parent = parent
+    self.created = created
+    self.children = 0
+    self.last_change = created
+    # Maps paths relative to PATH/src to tuples of lines.
+    self.files = files
+    self.changed = set()
+    # Maps merge source paths to lists of (start, end) revision ranges.
+    self.mergeinfo = mergeinfo
+
+
+class Generator(object):
+
+  def __init__(self, options, writer):
+    self.options = options
+    self.writer = writer
+    self.rng = random.Random(options.seed)
+    self.date = START_DATE
+    self.revnum = 0
+    self.branch_count = 0
+    self.tag_count = 0
+    self.trunk = None
+    self.branches = []
+    self.bigdir_size = 0
+    self.binaries = []
+    self.hot = None
+    self.edits = {}
+
+  def words(self, count):
+    return ' '.join(self.rng.choice(WORDS) for i in range(count))
+
+  def text_line(self):
+    return '  %s;' % self.words(self.rng.randint(2, 10))
+
+  def binary(self, size):
+    # Fast on both Python 2 and 3: one big random number as hex.
+    return bytearray(binascii.unhexlify(b'%0*x'
+                                        % (2 * size,
+                                           self.rng.getrandbits(8 * size))))
+
+  def begin_revision(self, log):
+    self.revnum += 1
+    step = max(2, 2 * DATE_SPAN // self.options.revisions)
+    self.date += self.rng.randint(1, step)
+    date = time.strftime('%Y-%m-%dT%H:%M:%S.000000Z',
+                         time.gmtime(self.date))
+    self.writer.revision(self.revnum,
+                         { b'svn:author': self.rng.choice(AUTHORS).encode(),
+                           b'svn:date': date.encode(),
+                           b'svn:log': log.encode('utf-8') })
+
+  def write_file(self, path, lines, old_lines=None, many_changes=False):
+    """Add the file PATH with LINES or, if OLD_LINES is given, change its
+    contents from OLD_LINES to LINES.  Set MANY_CHANGES if the change is
+    not a single hunk."""
+    text = ('\n'.join(lines) + '\n').encode('utf-8')
+    if old_lines is None:
+      self.writer.node(path, b'add', b'file', props={}, text=text)
+    else:
+      if many_changes:
+        pieces = line_pieces(old_lines, lines)
+      else:
+        pieces = affix_pieces(('\n'.join(old_lines) + '\n').encode('utf-8'),
+                              text)
+      self.writer.node(path, b'change', b'file',
+                       text=svndiff(text, pieces), delta=True)
+
+  def edit_lines(self, lines):
+    """Return a copy of LINES with a few lines close to each other
+    changed, added or removed."""
+    lines = list(lines)
+    anchor = self.rng.randrange(len(lines))
+    for i in range(self.rng.randint(1, 4)):
+      choice = self.rng.random()
+      index = min(len(lines) - 1, anchor + self.rng.randint(0, 8))
+      if choice < 0.7:
+        lines[index] = self.text_line()
+      elif choice < 0.85 or len(lines) < 10:
+        lines.insert(index, self.text_line())
+      else:
+        del lines[index]
+    return tuple(lines)
+
+  def initial_revision(self):
+    options = self.options
+    self.begin_revision('Initial import.')
+    w = self.writer
+    for path in ('trunk', 'branches', 'tags', 'trunk/src', 'trunk/bigdir',
+                 'trunk/assets'):
+      w.node(path, b'add', b'dir', props={})
+
+    files = {}
+    for i in range(options.files):
+      relpath = 'd%04d/f%05d.c' % (i // FILES_PER_DIR, i)
+      if i % FILES_PER_DIR == 0:
+        w.node('trunk/src/' + relpath.split('/')[0], b'add', b'dir',
+               props={})
+      lines = tuple(self.text_line()
+                    for j in range(self.rng.randint(20, 400)))
+      files[relpath] = lines
+      self.write_file('trunk/src/' + relpath, lines)
+    self.trunk = Line('trunk', None, self.revnum, files, {})
+
+    self.hot = tuple(self.text_line() for j in range(100))
+    self.write_file('trunk/hot.txt', self.hot)
+
+    for i in range(options.binaries):
+      data = self.binary(options.binary_size)
+      self.binaries.append(data)
+      w.node('trunk/assets/blob%02d.bin' % i, b'add', b'file',
+             props={ b'svn:mime-type': b'application/octet-stream' },
+             text=bytes(data))
+
+  def create_branch(self):
+    # Every fourth branch comes off a branch that existed before.
+    parents = [b for b in self.branches if b.created < self.revnum]
+    parent = self.trunk
+    if parents and self.rng.random() < 0.25:
+      parent = self.rng.choice(parents)
+
+    self.branch_count += 1
+    path = 'branches/b%06d' % self.branch_count
+    self.writer.node(path, b'add', b'dir',
+                     copyfrom=(parent.path, self.revnum - 1))
+    parent.children += 1
+    self.branches.append(Line(path, parent, self.revnum,
+                              dict(parent.files),
+                              dict((k, list(v))
+                                   for k, v in parent.mergeinfo.items())))
+
+  def edit_files(self, line):
+    for i in range(self.rng.randint(1, 4)):
+      relpath = self.rng.choice(self.file_names)
+      old_lines = line.files[relpath]
+      line.files[relpath] = self.edit_lines(old_lines)
+      line.changed.add(relpath)
+      line.last_change = self.revnum
+      self.write_file('%s/src/%s' % (line.path, relpath),
+                      line.files[relpath], old_lines)
+      if line is self.trunk:
+        self.edits[relpath] = self.edits.get(relpath, 0) + 1
+
+  def merge_branch(self):
+    """Merge the oldest branch without children into its parent, record
+    the merge in the parent's svn:mergeinfo and delete the branch.  Keep
+    at least --min-branches branches alive."""
+    if len(self.branches) <= self.options.min_branches:
+      return
+
+    for branch in self.branches:
+      if not branch.children and branch.created < self.revnum:
+        break
+    else:
+      return
+
+    parent = branch.parent
+    for relpath in sorted(branch.changed):
+      old_lines = parent.files[relpath]
+      if old_lines == branch.files[relpath]:
+        continue
+      parent.files[relpath] = branch.files[relpath]
+      parent.changed.add(relpath)
+      self.write_file('%s/src/%s' % (parent.path, relpath),
+                      parent.files[relpath], old_lines, many_changes=True)
+      if parent is self.trunk:
+        self.edits[relpath] = self.edits.get(relpath, 0) + 1
+
+    # The parent also inherits whatever has been merged into the branch.
+    for source, ranges in branch.mergeinfo.items():
+      if source not in parent.mergeinfo:
+        parent.mergeinfo[source] = list(ranges)
+    if branch.last_change > branch.created:
+      parent.mergeinfo.setdefault('/' + branch.path, []).append(
+        (branch.created + 1, branch.last_change))
+    parent.last_change = self.revnum
+
+    mergeinfo = '\n'.join('%s:%s' % (source, ','.join(format_range(r)
+                                                      for r in ranges))
+                          for source, ranges
+                          in sorted(parent.mergeinfo.items()))
+    self.writer.node(parent.path, b'change', b'dir',
+                     props={ b'svn:mergeinfo': mergeinfo.encode('utf-8') })
+    self.writer.node(branch.path, b'delete')
+
+    self.branches.remove(branch)
+    parent.children -= 1
+
+  def revision(self):
+    options = self.options
+    rng = self.rng
+    rev = self.revnum + 1
+
+    if options.branch_every and rev % options.branch_every == 0:
+      self.begin_revision('Create a branch.')
+      self.create_branch()
+    elif options.merge_every and rev % options.merge_every == 0:
+      self.begin_revision('Merge a branch.')
+      self.merge_branch()
+    elif options.tag_every and rev % options.tag_every == 0:
+      self.begin_revision('Tag trunk.')
+      self.tag_count += 1
+      self.writer.node('tags/t%06d' % self.tag_count, b'add', b'dir',
+                       copyfrom=('trunk', self.revnum - 1))
+    elif self.bigdir_size < options.bigdir:
+      self.begin_revision('Populate bigdir.')
+      count = min(BIGDIR_BATCH, options.bigdir - self.bigdir_size)
+      for i in range(self.bigdir_size, self.bigdir_size + count):
+        self.writer.node('trunk/bigdir/e%07d.txt' % i, b'add', b'file',
+                         props={}, text=('%s\n' % self.words(8)).encode())
+      self.bigdir_size += count
+    else:
+      self.begin_revision(self.words(rng.randint(3, 20)))
+      if self.branches and rng.random() < 0.4:
+        self.edit_files(rng.choice(self.branches))
+      else:
+        self.edit_files(self.trunk)
+
+      if self.bigdir_size and rng.random() < 0.05:
+        self.writer.node('trunk/bigdir/e%07d.txt'
+                           % rng.randrange(self.bigdir_size),
+                         b'change', b'file',
+                         text=('%s\n' % self.words(8)).encode())
+
+      if (self.binaries and options.binary_every
+          and rev % options.binary_every == 0):
+        index = rng.randrange(len(self.binaries))
+        data = self.binaries[index]
+        size = min(4096, len(data))
+        offset = rng.randrange(len(data) - size + 1)
+        data[offset:offset + size] = self.binary(size)
+
+        # Only the lengths of the source matter if the common prefix and
+        # suffix are known.
+        self.writer.node('trunk/assets/blob%02d.bin' % index, b'change',
+                         b'file', delta=True,
+                         text=svndiff(data,
+                                      affix_pieces(data, data, offset,
+                                                   len(data) - offset
+                                                   - size)))
+
+    # Change the hot file in every revision, whatever else happens.
+    old_lines = self.hot
+    self.hot = self.edit_lines(old_lines)
+    self.write_file('trunk/hot.txt', self.hot, old_lines)
+
+  def run(self):
+    self.writer.revision(0, { b'svn:date':
+                                time.strftime('%Y-%m-%dT%H:%M:%S.000000Z',
+                                              time.gmtime(START_DATE))
+                                  .encode() })
+    self.initial_revision()
+    self.file_names = sorted(self.trunk.files)
+
+    while self.revnum < self.options.revisions:
+      self.revision()
+      if self.options.verbose and self.revnum % 10000 == 0:
+        sys.stderr.write('r%d\n' % self.revnum)
+
+  def description(self):
+    """Return a dict describing the generated repository."""
+    most_edited = max(sorted(self.edits),
+                      key=lambda relpath: self.edits[relpath])
+    trunk_branches = [b.path for b in self.branches
+                      if b.parent is self.trunk
+                      and b.last_change > b.created]
+    return {
+      'profile': self.options.profile,
+      'seed': self.options.seed,
+      'head': self.revnum,
+      'files': self.options.files,
+      'bigdir': self.bigdir_size,
+      'binaries': len(self.binaries),
+      'binary_size': self.options.binary_size,
+      'branches': self.branch_count,
+      'tags': self.tag_count,
+      'blame_path': 'trunk/src/' + most_edited,
+      'merge_branch': trunk_branches[0] if trunk_branches else None,
+      'hot_path': 'trunk/hot.txt',
+      'bigdir_path': 'trunk/bigdir',
+    }
+
+
+if __name__ == '__main__':
+  parser = optparse.OptionParser(usage=__doc__)
+  parser.add_option('-p', '--profile', action='store', dest='profile',
+                    default='small', help='One of %s'
+                    % ', '.join(sorted(PROFILES)))
+  parser.add_option('-s', '--seed', action='store', type='int', dest='seed',
+                    default=0, help='Seed for the random history')
+  parser.add_option('-r', '--revisions', action='store', type='int',
+                    dest='revisions', help='Number of revisions')
+  parser.add_option('-f', '--files', action='store', type='int',
+                    dest='files', help='Number of files in trunk/src')
+  parser.add_option('--bigdir', action='store', type='int', dest='bigdir',
+                    help='Number of entries in trunk/bigdir')
+  parser.add_option('--binaries', action='store', type='int',
+                    dest='binaries', help='Number of binary files')
+  parser.add_option('--binary-size', action='store', type='int',
+                    dest='binary_size', help='Size of each binary in bytes')
+  parser.add_option('--branch-every', action='store', type='int',
+                    dest='branch_every', default=50,
+                    help='Create a branch every N revisions')
+  parser.add_option('--merge-every', action='store', type='int',
+                    dest='merge_every', default=41,
+                    help='Merge a branch every N revisions')
+  parser.add_option('--min-branches', action='store', type='int',
+                    dest='min_branches', default=10,
+                    help='Number of branches to keep alive')
+  parser.add_option('--tag-every', action='store', type='int',
+                    dest='tag_every', default=997,
+                    help='Tag trunk every N revisions')
+  parser.add_option('--binary-every', action='store', type='int',
+                    dest='binary_every', default=101,
+                    help='Change a binary every N revisions')
+  parser.add_option('-v', '--verbose', action='store_true', dest='verbose',
+                    help='Report progress on stderr')
+
+  options, args = parser.parse_args()
+  if len(args) != 1 or options.profile not in PROFILES:
+    parser.print_help()
+    sys.exit(1)
+
+  for name, value in PROFILES[options.profile].items():
+    if getattr(options, name) is None:
+      setattr(options, name, value)
+  if options.revisions < 2 or options.files < 1:
+    parser.print_help()
+    sys.exit(1)
+
+  output_dir = args[0]
+  if not os.path.isdir(output_dir):
+    os.makedirs(output_dir)
+
+  # The UUID depends on the seed as well, so that identical options give
+  # identical dump files.
+  uuid = '%08x-0000-4000-8000-%012x' % (options.seed & 0xffffffff,
+                                        options.revisions)
+  dump = open(os.path.join(output_dir, 'fixture.dump'), 'wb')
+  generator = Generator(options, DumpWriter(dump, uuid.encode()))
+  generator.run()
+  dump.close()
+
+  description = open(os.path.join(output_dir, 'fixture.json'), 'w')
+  json.dump(generator.description(), description, indent=2,
+            sort_keys=True)
+  description.write('\n')
+  description.close()
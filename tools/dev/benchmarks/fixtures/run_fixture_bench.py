@@ -0,0 +1,299 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Usage: run_fixture_bench.py run [options] LABEL FIXTURE_DIR [N]
+       run_fixture_bench.py list [options]
+       run_fixture_bench.py compare [options] LABEL LABEL [LABEL...]
+
+Run the standard benchmarks against a repository created by make_fixture.py
+and keep the timings in an sqlite database (-f, default 'fixtures.db') for
+comparisons across Subversion versions.
+
+RUN BENCHMARKS
+
+  run_fixture_bench.py run LABEL FIXTURE_DIR [N]
+
+LABEL names the Subversion build under test, e.g. "1.10.x@1812345".  Use
+--svn-bin-dir to select its binaries.  The run is repeated N times, default
+once.  Each run performs and times, in this order:
+
+  load      svnadmin load of FIXTURE_DIR/fixture.dump into a new repository
+  pack      svnadmin pack
+  verify    svnadmin verify of the last --verify-revisions revisions
+  checkout  svn checkout of trunk
+  update    svn update of that working copy from HEAD-100 to HEAD
+  log       svn log -v -l 1000 on trunk
+  log-g     svn log -g -l 100 on trunk
+  blame     svn blame of the most often changed file on trunk
+  merge     svn merge of an active branch into the trunk working copy
+
+The client commands access the repository through file:// URLs, so the
+timings do not include any network overhead.  Commands that fail are
+reported and not recorded.
+
+LIST WHAT IS ON RECORD
+
+  run_fixture_bench.py list
+
+COMPARE TIMINGS
+
+  run_fixture_bench.py compare LABEL LABEL [LABEL...]
+
+Show the average timings of each command for all labels, relative to the
+first one.  Use --fixture to compare only runs against a given fixture,
+identified by its profile and seed, e.g. "medium-1".
+
+Example:
+  make_fixture.py --profile=medium --seed=1 /data/fixtures/medium-1
+  run_fixture_bench.py run -b ~/svn-1.9/bin 1.9.7 /data/fixtures/medium-1 3
+  run_fixture_bench.py run -b ~/svn-trunk/bin trunk /data/fixtures/medium-1 3
+  run_fixture_bench.py compare 1.9.7 trunk
+"""
+
+import json
+import optparse
+import os
+import shutil
+import sqlite3
+import subprocess
+import sys
+import tempfile
+import time
+
+COMMANDS = ('load', 'pack', 'verify', 'checkout', 'update', 'log', 'log-g',
+            'blame', 'merge')
+
+
+class TimingsDb(object):
+  def __init__(self, db_path):
+    self.conn = sqlite3.connect(db_path)
+    self.conn.executescript('''
+        CREATE TABLE IF NOT EXISTS run (
+          run_id INTEGER PRIMARY KEY AUTOINCREMENT,
+          label TEXT NOT NULL,
+          fixture TEXT NOT NULL,
+          head INTEGER,
+          started TEXT
+        );
+
+        CREATE TABLE IF NOT EXISTS timings (
+          run_id INTEGER NOT NULL REFERENCES run(run_id),
+          command TEXT NOT NULL,
+          timing REAL
+        );''')
+
+  def add_run(self, label, fixture, head):
+    c = self.conn.cursor()
+    c.execute('INSERT INTO run (label, fixture, head, started) '
+              'VALUES (?, ?, ?, ?)',
+              (label, fixture, head, time.strftime('%Y-%m-%d %H:%M:%S')))
+    self.conn.commit()
+    return c.lastrowid
+
+  def add_timing(self, run_id, command, seconds):
+    self.conn.execute('INSERT INTO timings (run_id, command, timing) '
+                      'VALUES (?, ?, ?)', (run_id, command, seconds))
+    self.conn.commit()
+
+  def list_runs(self):
+    return self.conn.execute('''
+        SELECT label, fixture, head, COUNT(*), MAX(started) FROM run
+        GROUP BY label, fixture, head
+        ORDER BY fixture, MAX(started)''').fetchall()
+
+  def averages(self, label, fixture=None):
+    """Return a dict mapping command names to (average, count)."""
+    query = '''
+        SELECT command, AVG(timing), COUNT(timing)
+        FROM timings JOIN run USING (run_id)
+        WHERE label = ?'''
+    args = [label]
+    if fixture:
+      query += ' AND fixture = ?'
+      args.append(fixture)
+    query += ' GROUP BY command'
+    return dict((command, (average, count))
+                for command, average, count
+                in self.conn.execute(query, args))
+
+
+class BenchmarkRun(object):
+  """One run of all benchmarks for a fixture."""
+
+  def __init__(self, options, fixture_dir, description, work_dir):
+    self.options = options
+    self.fixture_dir = fixture_dir
+    self.description = description
+    self.repos = os.path.join(work_dir, 'repos')
+    self.wc = os.path.join(work_dir, 'wc')
+    self.url = 'file://' + ('' if self.repos.startswith('/') else '/') \
+               + self.repos.replace(os.sep, '/')
+
+  def command(self, name, args, stdin=None):
+    """Run the executable NAME with ARGS and return True on success."""
+    args = [os.path.join(self.options.svn_bin_dir, name)] + args
+    if self.options.verbose:
+      print('CMD: %s' % ' '.join(args))
+
+    devnull = open(os.devnull, 'w')
+    process = subprocess.Popen(args, stdin=stdin, stdout=devnull,
+                               stderr=subprocess.PIPE,
+                               universal_newlines=True)
+    stderr = process.communicate()[1]
+    devnull.close()
+
+    if process.returncode:
+      sys.stderr.write('%s failed: %s\n' % (' '.join(args), stderr.strip()))
+      return False
+    return True
+
+  def timed(self, command, name, args, stdin=None):
+    """Like command() but return the seconds taken or None on failure."""
+    start = time.time()
+    if not self.command(name, args, stdin):
+      return None
+    seconds = time.time() - start
+    print('%-10s %10.3f' % (command, seconds))
+    return seconds
+
+  def run(self):
+    """Run all benchmarks and yield (COMMAND, SECONDS) pairs."""
+    head = self.description['head']
+    trunk = self.url + '/trunk'
+
+    if not self.command('svnadmin', ['create', self.repos]):
+      return
+    dump = open(os.path.join(self.fixture_dir, 'fixture.dump'), 'rb')
+    yield 'load', self.timed('load', 'svnadmin',
+                             ['load', '-q', self.repos], stdin=dump)
+    dump.close()
+
+    yield 'pack', self.timed('pack', 'svnadmin', ['pack', '-q', self.repos])
+
+    first = 0
+    if self.options.verify_revisions:
+      first = max(0, head - self.options.verify_revisions + 1)
+    yield 'verify', self.timed('verify', 'svnadmin',
+                               ['verify', '-q', '-r', '%d:%d' % (first, head),
+                                self.repos])
+
+    yield 'checkout', self.timed('checkout', 'svn',
+                                 ['checkout', '-q', trunk, self.wc])
+
+    if self.command('svn', ['update', '-q', '-r', str(max(1, head - 100)),
+                            self.wc]):
+      yield 'update', self.timed('update', 'svn', ['update', '-q', self.wc])
+
+    yield 'log', self.timed('log', 'svn', ['log', '-v', '-l', '1000', trunk])
+    yield 'log-g', self.timed('log-g', 'svn',
+                              ['log', '-g', '-l', '100', trunk])
+
+    yield 'blame', self.timed('blame', 'svn',
+                              ['blame', self.url + '/'
+                                        + self.description['blame_path']])
+
+    if self.description.get('merge_branch'):
+      yield 'merge', self.timed('merge', 'svn',
+                                ['merge', '--non-interactive',
+                                 '--accept', 'postpone',
+                                 self.url + '/'
+                                 + self.description['merge_branch'],
+                                 self.wc])
+
+
+def run_benchmarks(db, options, label, fixture_dir, count):
+  description = json.load(open(os.path.join(fixture_dir, 'fixture.json')))
+  fixture = '%s-%s' % (description['profile'], description['seed'])
+
+  for i in range(count):
+    print('Run %d of %d: %s on %s (r%d)'
+          % (i + 1, count, label, fixture, description['head']))
+    work_dir = tempfile.mkdtemp(prefix='fixture-bench-',
+                                dir=options.work_dir)
+    try:
+      run_id = db.add_run(label, fixture, description['head'])
+      benchmark = BenchmarkRun(options, fixture_dir, description, work_dir)
+      for command, seconds in benchmark.run():
+        if seconds is not None:
+          db.add_timing(run_id, command, seconds)
+    finally:
+      shutil.rmtree(work_dir, ignore_errors=True)
+
+
+def list_runs(db):
+  print('%-20s %-15s %10s %5s  %s'
+        % ('Label', 'Fixture', 'HEAD', 'Runs', 'Last run'))
+  for label, fixture, head, count, started in db.list_runs():
+    print('%-20s %-15s %10d %5d  %s' % (label, fixture, head, count, started))
+
+
+def compare(db, options, labels):
+  averages = [db.averages(label, options.fixture) for label in labels]
+  print('%-10s' % 'Command'
+        + ''.join(' %20s' % label[:20] for label in labels))
+  for command in COMMANDS:
+    reference = averages[0].get(command)
+    line = '%-10s' % command
+    for timings in averages:
+      if command not in timings:
+        line += ' %20s' % '-'
+      elif timings is averages[0] or not reference or not reference[0]:
+        line += ' %20.3f' % timings[command][0]
+      else:
+        line += ' %11.3f (%5.0f%%)' % (timings[command][0],
+                                       100.0 * timings[command][0]
+                                       / reference[0])
+    print(line)
+
+
+if __name__ == '__main__':
+  parser = optparse.OptionParser(usage=__doc__)
+  parser.add_option('-f', '--db-path', action='store', dest='db_path',
+                    default='fixtures.db',
+                    help='Store the timings in this sqlite database')
+  parser.add_option('-b', '--svn-bin-dir', action='store', dest='svn_bin_dir',
+                    default='',
+                    help='Specify directory to find svn and svnadmin in')
+  parser.add_option('-w', '--work-dir', action='store', dest='work_dir',
+                    default=None,
+                    help='Create repositories and working copies here')
+  parser.add_option('--verify-revisions', action='store', type='int',
+                    dest='verify_revisions', default=1000,
+                    help='Verify only this many revisions; 0 means all')
+  parser.add_option('--fixture', action='store', dest='fixture',
+                    help='Compare only runs against this fixture')
+  parser.add_option('-v', '--verbose', action='store_true', dest='verbose',
+                    help='Print each command before running it')
+
+  options, args = parser.parse_args()
+  if not args:
+    parser.print_help()
+    sys.exit(1)
+
+  db = TimingsDb(options.db_path)
+  if args[0] == 'run' and len(args) in (3, 4):
+    run_benchmarks(db, options, args[1], args[2],
+                   int(args[3]) if len(args) == 4 else 1)
+  elif args[0] == 'list' and len(args) == 1:
+    list_runs(db)
+  elif args[0] == 'compare' and len(args) >= 3:
+    compare(db, options, args[1:])
+  else:
+    parser.print_help()
+    sys.exit(1)
@@ -0,0 +1,388 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Usage: replay_server_log.py [options] ROOT_URL LOGFILE...
+
+Replay the read operations recorded in Subversion server operational logs
+against the repository at ROOT_URL and report their latencies.  This allows
+tuning server caches and thread counts against real traffic.
+
+Two log formats are supported:
+
+  svnserve --log-file:
+    <PID> <TIMESTAMP> <HOST> <USER> <REPOS> <SVN-ACTION>
+
+  mod_dav_svn, with a CustomLog format of "%t %u %{SVN-ACTION}e" or
+  "%t %u %{SVN-REPOS-NAME}e %{SVN-ACTION}e":
+    [<TIMESTAMP>] <USER> [<REPOS>] <SVN-ACTION>
+
+The SVN-ACTION strings are parsed by tools/server-side/svn_server_log_parse.py,
+which requires the Subversion Python bindings.  Every action is replayed
+with the matching svnbench command, which fetches the same data as the
+original client but does not store it:
+
+  checkout-or-export, update, switch   ->  svnbench null-export
+  log                                  ->  svnbench null-log
+  get-file-revs (blame)                ->  svnbench null-blame
+  get-dir (ls)                         ->  svnbench null-list
+  stat, check-path                     ->  svnbench null-info
+
+Since the working copy state of the original clients is unknown, updates
+and switches are replayed as exports of their target revision.  All other
+actions are counted but skipped.
+
+Operations start at their original times relative to the first one, divided
+by --speed.  With --speed=0, they start as soon as a worker becomes
+available.  The latency reported per operation is the "seconds taken" as
+measured by svnbench itself, i.e. without process startup.  Hence, svnbench
+must not be run with --quiet.
+
+Example:
+  replay_server_log.py --speed=10 --workers=32 \\
+      svn://localhost/repos /var/log/svnserve.log
+"""
+
+import datetime
+import optparse
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+
+try:
+  # Python >=3.0
+  import queue
+  from urllib.parse import quote as urllib_parse_quote
+except ImportError:
+  # Python <3.0
+  import Queue as queue
+  from urllib import quote as urllib_parse_quote
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', '..', 'server-side'))
+import svn.core
+import svn_server_log_parse
+
+# <PID> <TIMESTAMP> <HOST> <USER> <REPOS> <SVN-ACTION>
+RE_SVNSERVE_LINE = re.compile(r'^\d+ (\d{4}-\d\d-\d\dT\d\d:\d\d:\d\d)\S* '
+                              r'\S+ \S+ \S+ (.*)$')
+
+# [<TIMESTAMP>] <USER> [<REPOS>] <SVN-ACTION>
+RE_HTTPD_LINE = re.compile(r'^\[(\d+/\w+/\d+:\d\d:\d\d:\d\d)[^\]]*\] '
+                           r'\S+ (.*)$')
+
+PERCENTILES = (50, 95, 99)
+
+
+class Operation(object):
+  """A single svnbench invocation to replay at a given time."""
+  def __init__(self, name, args):
+    self.name = name
+    self.args = args
+    self.time = None
+
+
+class ActionParser(svn_server_log_parse.Parser):
+  """Translate SVN-ACTION strings into Operations.  After each call to
+  parse(), self.operation is the Operation to run or None."""
+
+  def __init__(self, root_url):
+    self.root_url = root_url.rstrip('/')
+    self.operation = None
+    self.skipped = {}
+
+  def __getattr__(self, name):
+    # Count the actions that we don't replay.
+    if name.startswith('handle_'):
+      action = name[len('handle_'):]
+      def skip(*args):
+        self.skipped[action] = self.skipped.get(action, 0) + 1
+      return skip
+    raise AttributeError(name)
+
+  def url(self, path):
+    return self.root_url + urllib_parse_quote(path)
+
+  def depth_args(self, depth):
+    if depth == svn.core.svn_depth_unknown:
+      return []
+    return ['--depth', svn.core.svn_depth_to_word(depth)]
+
+  def export(self, name, path, revision, depth):
+    self.operation = Operation(name, ['null-export', '-r', str(revision)]
+                                     + self.depth_args(depth)
+                                     + [self.url(path)])
+
+  def handle_unknown(self, line):
+    return None
+
+  def handle_checkout_or_export(self, path, revision, depth):
+    self.export('checkout', path, revision, depth)
+
+  def handle_update(self, path, revision, depth, send_copyfrom_args):
+    self.export('update', path, revision, depth)
+
+  def handle_switch(self, from_path, to_path, to_rev, depth):
+    self.export('switch', to_path, to_rev, depth)
+
+  def handle_log(self, paths, left, right, limit, discover_changed_paths,
+                 strict, include_merged_revisions, revprops):
+    args = ['null-log', '-r', '%s:%s' % (self.revision(left),
+                                          self.revision(right))]
+    if limit:
+      args += ['--limit', str(limit)]
+    if discover_changed_paths:
+      args.append('-v')
+    if strict:
+      args.append('--stop-on-copy')
+    if include_merged_revisions:
+      args.append('-g')
+    if len(paths) > 1:
+      args.append(self.root_url)
+      args += [path.lstrip('/') for path in paths]
+    else:
+      args.append(self.url(paths[0] if paths else '/'))
+    self.operation = Operation('log', args)
+
+  def handle_get_file_revs(self, path, left, right, include_merged_revisions):
+    args = ['null-blame', '-r', '%s:%s' % (self.revision(left),
+                                           self.revision(right))]
+    if include_merged_revisions:
+      args.append('-g')
+    self.operation = Operation('blame', args + [self.url(path)])
+
+  def handle_get_dir(self, path, revision, text, props):
+    self.operation = Operation('list', ['null-list', '-r', str(revision),
+                                        self.url(path)])
+
+  def handle_stat(self, path, revision):
+    self.operation = Operation('info', ['null-info', '-r', str(revision),
+                                        self.url(path)])
+
+  handle_check_path = handle_stat
+
+  def revision(self, revnum):
+    if revnum < 0:
+      return 'HEAD'
+    return str(revnum)
+
+
+def parse_timestamp(value, format):
+  return datetime.datetime(*time.strptime(value, format)[:6])
+
+
+def read_operations(root_url, log_files):
+  """Return the list of Operations found in LOG_FILES in chronological
+  order and a dict of the number of skipped actions by name."""
+  parser = ActionParser(root_url)
+  operations = []
+
+  for log_file in log_files:
+    for line in open(log_file):
+      line = line.rstrip('\r\n')
+
+      m = RE_SVNSERVE_LINE.match(line)
+      if m:
+        timestamp = parse_timestamp(m.group(1), '%Y-%m-%dT%H:%M:%S')
+        candidates = [m.group(2)]
+      else:
+        m = RE_HTTPD_LINE.match(line)
+        if not m:
+          continue
+        timestamp = parse_timestamp(m.group(1), '%d/%b/%Y:%H:%M:%S')
+
+        # The action may or may not be preceded by the repository name.
+        candidates = [m.group(2)]
+        if ' ' in m.group(2):
+          candidates.append(m.group(2).split(' ', 1)[1])
+
+      for action in candidates:
+        parser.operation = None
+        try:
+          if parser.parse(action) is None:
+            continue
+        except svn_server_log_parse.Error:
+          continue
+
+        if parser.operation:
+          parser.operation.time = timestamp
+          operations.append(parser.operation)
+        break
+
+  # Python's sort is stable, so operations within the same second keep
+  # their original order.
+  operations.sort(key=lambda op: op.time)
+  return operations, parser.skipped
+
+
+class Results(object):
+  """Latencies and errors per operation name, collected by all workers."""
+  def __init__(self):
+    self.lock = threading.Lock()
+    self.latencies = {}
+    self.errors = {}
+    self.max_lag = 0.0
+
+  def add(self, name, latency, lag):
+    self.lock.acquire()
+    try:
+      self.latencies.setdefault(name, []).append(latency)
+      self.max_lag = max(self.max_lag, lag)
+    finally:
+      self.lock.release()
+
+  def add_error(self, name, message):
+    self.lock.acquire()
+    try:
+      self.errors[name] = self.errors.get(name, 0) + 1
+    finally:
+      self.lock.release()
+    sys.stderr.write('%s failed: %s\n' % (name, message.strip()))
+
+
+RE_SECONDS_TAKEN = re.compile(r'^\s*([0-9.]+) seconds taken', re.MULTILINE)
+
+def run_operation(svnbench, options, operation, lag, results):
+  args = [svnbench] + operation.args
+  if options.svnbench_options:
+    args += options.svnbench_options.split()
+  if options.verbose:
+    sys.stdout.write('%s\n' % ' '.join(args))
+
+  process = subprocess.Popen(args, stdout=subprocess.PIPE,
+                             stderr=subprocess.PIPE,
+                             universal_newlines=True)
+  stdout, stderr = process.communicate()
+
+  m = RE_SECONDS_TAKEN.search(stdout)
+  if process.returncode or not m:
+    results.add_error(operation.name, stderr)
+  else:
+    results.add(operation.name, float(m.group(1)), lag)
+
+
+def worker(svnbench, options, pending, results):
+  while True:
+    item = pending.get()
+    if item is None:
+      break
+    operation, scheduled = item
+    lag = max(0.0, time.time() - scheduled) if scheduled else 0.0
+    run_operation(svnbench, options, operation, lag, results)
+
+
+def replay(svnbench, options, operations):
+  """Run OPERATIONS and return the Results and the time taken."""
+  results = Results()
+  pending = queue.Queue(options.workers)
+  threads = []
+  for i in range(options.workers):
+    thread = threading.Thread(target=worker,
+                              args=(svnbench, options, pending, results))
+    thread.start()
+    threads.append(thread)
+
+  start = time.time()
+  first = operations[0].time if operations else None
+  for operation in operations:
+    scheduled = None
+    if options.speed > 0:
+      offset = (operation.time - first).days * 86400 \
+               + (operation.time - first).seconds
+      scheduled = start + offset / options.speed
+      delay = scheduled - time.time()
+      if delay > 0:
+        time.sleep(delay)
+    pending.put((operation, scheduled))
+
+  for thread in threads:
+    pending.put(None)
+  for thread in threads:
+    thread.join()
+
+  return results, time.time() - start
+
+
+def percentile(sorted_values, rank):
+  index = max(0, (len(sorted_values) * rank + 99) // 100 - 1)
+  return sorted_values[index]
+
+
+def print_results(results, skipped, time_taken):
+  names = sorted(set(results.latencies) | set(results.errors))
+  print('%-10s %8s %8s %10s %10s %10s %10s'
+        % ('Operation', 'Count', 'Errors', 'Ops/s', 'p50 ms', 'p95 ms',
+           'p99 ms'))
+  for name in names:
+    latencies = sorted(results.latencies.get(name, []))
+    line = '%-10s %8d %8d %10.2f' % (name, len(latencies),
+                                     results.errors.get(name, 0),
+                                     len(latencies) / max(time_taken, 1e-6))
+    if latencies:
+      line += ''.join(' %10.3f' % (percentile(latencies, rank) * 1000)
+                      for rank in PERCENTILES)
+    print(line)
+
+  print('')
+  print('%.3f seconds taken, dispatch fell behind schedule by up to '
+        '%.3f seconds' % (time_taken, results.max_lag))
+  if skipped:
+    print('Skipped actions: %s'
+          % ', '.join('%s=%d' % (name, skipped[name])
+                      for name in sorted(skipped)))
+
+
+if __name__ == '__main__':
+  parser = optparse.OptionParser(usage=__doc__)
+  parser.add_option('-v', '--verbose', action='store_true', dest='verbose',
+                    help='Print each command before running it')
+  parser.add_option('-b', '--svn-bin-dir', action='store', dest='svn_bin_dir',
+                    default='',
+                    help='Specify directory to find svnbench in')
+  parser.add_option('-s', '--speed', action='store', type='float',
+                    dest='speed', default=1.0,
+                    help='Replay this many times faster than recorded; '
+                         '0 means as fast as possible')
+  parser.add_option('-w', '--workers', action='store', type='int',
+                    dest='workers', default=16,
+                    help='Maximum number of concurrent operations')
+  parser.add_option('-n', '--limit', action='store', type='int',
+                    dest='limit', default=0,
+                    help='Replay only the first LIMIT operations')
+  parser.add_option('-o', '--svnbench-options', action='store',
+                    dest='svnbench_options', default='',
+                    help='Additional options to pass to svnbench, '
+                         'e.g. "--non-interactive --username=USER"')
+
+  options, args = parser.parse_args()
+  if len(args) < 2 or options.workers < 1 or options.speed < 0:
+    parser.print_help()
+    sys.exit(1)
+
+  root_url, log_files = args[0], args[1:]
+  svnbench = os.path.join(options.svn_bin_dir, 'svnbench')
+
+  operations, skipped = read_operations(root_url, log_files)
+  if options.limit:
+    operations = operations[:options.limit]
+
+  results, time_taken = replay(svnbench, options, operations)
+  print_results(results, skipped, time_taken)
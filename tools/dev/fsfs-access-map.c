@@ -743,7 +743,9 @@ print_usage(void)
   printf("1 and 2 hits, yellow to read-ish colors for up to 20, shares of\n");
   printf("for up to 100 and black for > 200 hits.\n\n");
   printf("A typical strace invocation looks like this:\n");
-  printf("strace -e trace=open,close,read,lseek -o strace.txt svn log ...\n");
+  printf("strace -e trace=open,close,read,lseek -o strace.txt svn log ...\n\n");
+  printf("The trace written by FSFS itself when given a trace stream in\n");
+  printf("svn_fs__set_io_stats() uses the same format.\n");
 }
 
 /* linear control flow */
@@ -31,6 +31,7 @@
 
 #include "private/svn_fspath.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_repos_private.h"
 
 
 /*** Option Processing. ***/
@@ -105,7 +106,8 @@ struct svnauthz_opt_state
 static svn_opt_subcommand_t
   subcommand_help,
   subcommand_validate,
-  subcommand_accessof;
+  subcommand_accessof,
+  subcommand_compile;
 
 /* Array of available subcommands.
  * The entire list must be terminated with an entry of nulls.
@@ -162,6 +164,23 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     ),
    {'t', svnauthz__username, svnauthz__path, svnauthz__repos, svnauthz__is,
     svnauthz__groups_file, 'R'} },
+  {"compile", subcommand_compile, {0} /* no aliases */,
+   ("Pre-compiles the rules of an authz file for all users.\n"
+    "usage: svnauthz compile TARGET\n"
+    "\n"
+    "  Writes the rules of the authz file at TARGET, filtered for each user\n"
+    "  mentioned in it, for anonymous and for all other authenticated users,\n"
+    "  to TARGET.snapshot.  Servers reading TARGET will use that snapshot\n"
+    "  instead of filtering the rules themselves, for as long as the contents\n"
+    "  of TARGET and the groups file match the ones the snapshot was made from.\n"
+    "  TARGET must be a path to a local file.\n"
+    "\n"
+    "Returns:\n"
+    "    0   when the snapshot has been written.\n"
+    "    1   when syntax is invalid.\n"
+    "    2   operational error\n"
+    ),
+   {svnauthz__groups_file} },
   { NULL, NULL, {0}, NULL, {0} }
 };
 
@@ -373,6 +392,26 @@ subcommand_accessof(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return err;
 }
 
+static svn_error_t *
+subcommand_compile(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnauthz_opt_state *opt_state = baton;
+  svn_authz_t *authz;
+
+  if (svn_path_is_url(opt_state->authz_file))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             ("'%s' is a URL when it should be a "
+                              "local path"), opt_state->authz_file);
+
+  SVN_ERR(get_authz(&authz, opt_state, pool));
+
+  return svn_repos__authz_write_snapshot(
+           authz,
+           apr_pstrcat(pool, opt_state->authz_file,
+                       SVN_REPOS__AUTHZ_SNAPSHOT_SUFFIX, SVN_VA_NULL),
+           pool);
+}
+
 
 
 /*** Main. ***/